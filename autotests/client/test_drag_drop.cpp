@@ -23,6 +23,9 @@
 #include "../../src/server/datadevicemanager_interface.h"
 #include "../../src/server/datasource_interface.h"
 #include "../../src/server/seat_interface.h"
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 class TestDragAndDrop : public QObject
 {
@@ -36,6 +39,8 @@ private Q_SLOTS:
     void testTouchDragAndDrop();
     void testDragAndDropWithCancelByDestroyDataSource();
     void testPointerEventsIgnored();
+    void testDragPrefetch();
+    void testDragMotionThrottling();
 
 private:
     KWayland::Client::Surface *createSurface();
@@ -558,5 +563,133 @@ void TestDragAndDrop::testPointerEventsIgnored()
     QVERIFY(pointerLeftSpy.isEmpty());
 }
 
+void TestDragAndDrop::testDragPrefetch()
+{
+    // this test verifies that the receive requests of a drag are served from the data read at its start
+    using namespace KWaylandServer;
+    using namespace KWayland::Client;
+    m_seatInterface->setDragPrefetchMimeTypes({QStringLiteral("text/plain")});
+    QCOMPARE(m_seatInterface->dragPrefetchMimeTypes(), QStringList{QStringLiteral("text/plain")});
+    QCOMPARE(m_seatInterface->dragPrefetchSizeLimit(), 64 * 1024);
+
+    QScopedPointer<Surface> s(createSurface());
+    auto serverSurface = getServerSurface();
+    QVERIFY(serverSurface);
+
+    QSignalSpy buttonPressSpy(m_pointer, &Pointer::buttonStateChanged);
+    QVERIFY(buttonPressSpy.isValid());
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    m_seatInterface->setTimestamp(2);
+    m_seatInterface->pointerButtonPressed(1);
+    QVERIFY(buttonPressSpy.wait());
+
+    // the dragging client is asked for the data once
+    QSignalSpy sendDataRequestedSpy(m_dataSource, &DataSource::sendDataRequested);
+    QVERIFY(sendDataRequestedSpy.isValid());
+    connect(m_dataSource, &DataSource::sendDataRequested, this, [](const QString &mimeType, qint32 fd) {
+        QCOMPARE(mimeType, QStringLiteral("text/plain"));
+        const QByteArray data = QByteArrayLiteral("file:///tmp/prefetched");
+        QCOMPARE(write(fd, data.constData(), data.size()), ssize_t(data.size()));
+        close(fd);
+    });
+    QSignalSpy dragEnteredSpy(m_dataDevice, &DataDevice::dragEntered);
+    QVERIFY(dragEnteredSpy.isValid());
+    m_dataSource->setDragAndDropActions(DataDeviceManager::DnDAction::Copy);
+    m_dataDevice->startDrag(buttonPressSpy.first().first().value<quint32>(), m_dataSource, s.data());
+    QVERIFY(dragEnteredSpy.wait());
+    QVERIFY(sendDataRequestedSpy.wait());
+    QCOMPARE(sendDataRequestedSpy.count(), 1);
+    auto offer = m_dataDevice->dragOffer();
+    QVERIFY(offer);
+
+    // every hover time receive gets the data from the server
+    for (int i = 0; i < 3; ++i) {
+        int pipeFds[2];
+        QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+        offer->receive(QStringLiteral("text/plain"), pipeFds[1]);
+        close(pipeFds[1]);
+        m_connection->flush();
+
+        QByteArray received;
+        auto readPipe = [&]() {
+            char buffer[64];
+            ssize_t count;
+            while ((count = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+                received.append(buffer, count);
+            }
+            return count == 0;
+        };
+        QTRY_VERIFY(readPipe());
+        close(pipeFds[0]);
+        QCOMPARE(received, QByteArrayLiteral("file:///tmp/prefetched"));
+    }
+    QCOMPARE(sendDataRequestedSpy.count(), 1);
+
+    QSignalSpy serverDragEndedSpy(m_seatInterface, &SeatInterface::dragEnded);
+    QVERIFY(serverDragEndedSpy.isValid());
+    m_seatInterface->setTimestamp(3);
+    m_seatInterface->pointerButtonReleased(1);
+    QTRY_COMPARE(serverDragEndedSpy.count(), 1);
+}
+
+void TestDragAndDrop::testDragMotionThrottling()
+{
+    // this test verifies that drag motions are merged within a refresh cycle and the final one precedes the drop
+    using namespace KWaylandServer;
+    using namespace KWayland::Client;
+    QVERIFY(!m_seatInterface->isDragMotionThrottlingEnabled());
+    m_seatInterface->setDragMotionThrottlingEnabled(true);
+    QVERIFY(m_seatInterface->isDragMotionThrottlingEnabled());
+
+    QScopedPointer<Surface> s(createSurface());
+    auto serverSurface = getServerSurface();
+    QVERIFY(serverSurface);
+
+    QSignalSpy buttonPressSpy(m_pointer, &Pointer::buttonStateChanged);
+    QVERIFY(buttonPressSpy.isValid());
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    m_seatInterface->setTimestamp(2);
+    m_seatInterface->pointerButtonPressed(1);
+    QVERIFY(buttonPressSpy.wait());
+
+    QSignalSpy dragEnteredSpy(m_dataDevice, &DataDevice::dragEntered);
+    QVERIFY(dragEnteredSpy.isValid());
+    QSignalSpy dragMotionSpy(m_dataDevice, &DataDevice::dragMotion);
+    QVERIFY(dragMotionSpy.isValid());
+    m_dataSource->setDragAndDropActions(DataDeviceManager::DnDAction::Copy);
+    m_dataDevice->startDrag(buttonPressSpy.first().first().value<quint32>(), m_dataSource, s.data());
+    QVERIFY(dragEnteredSpy.wait());
+    auto offer = m_dataDevice->dragOffer();
+    QVERIFY(offer);
+    offer->accept(QStringLiteral("text/plain"), dragEnteredSpy.last().at(0).toUInt());
+    offer->setDragAndDropActions(DataDeviceManager::DnDAction::Copy, DataDeviceManager::DnDAction::Copy);
+    m_connection->flush();
+
+    // the first motion goes out right away, the following ones are merged
+    const quint64 motionCount = m_seatInterface->dragMotionEventCount();
+    for (int i = 1; i <= 6; ++i) {
+        m_seatInterface->setTimestamp(2 + i);
+        m_seatInterface->setPointerPos(QPointF(i, i));
+    }
+    QCOMPARE(m_seatInterface->dragMotionEventCount(), motionCount + 1);
+    QCOMPARE(m_seatInterface->coalescedDragMotionEventCount(), quint64(4));
+    QTRY_COMPARE(dragMotionSpy.count(), 2);
+    QCOMPARE(dragMotionSpy.first().first().toPointF(), QPointF(1, 1));
+    QCOMPARE(dragMotionSpy.last().first().toPointF(), QPointF(6, 6));
+    QCOMPARE(dragMotionSpy.last().last().toUInt(), 8u);
+    QCOMPARE(m_seatInterface->dragMotionEventCount(), motionCount + 2);
+
+    // a held back motion is sent before the drop
+    QSignalSpy droppedSpy(m_dataDevice, &DataDevice::dropped);
+    QVERIFY(droppedSpy.isValid());
+    m_seatInterface->setTimestamp(10);
+    m_seatInterface->setPointerPos(QPointF(20, 20));
+    m_seatInterface->setPointerPos(QPointF(21, 21));
+    m_seatInterface->setTimestamp(11);
+    m_seatInterface->pointerButtonReleased(1);
+    QVERIFY(droppedSpy.wait());
+    QCOMPARE(dragMotionSpy.last().first().toPointF(), QPointF(21, 21));
+}
+
 QTEST_GUILESS_MAIN(TestDragAndDrop)
 #include "test_drag_drop.moc"
@@ -40,6 +40,8 @@ private Q_SLOTS:
     void testTouch();
     void testKeyboardKeyLinux_data();
     void testKeyboardKeyLinux();
+    void testBatched();
+    void testTouchIdsPerDevice();
 
 private:
     Display *m_display = nullptr;
@@ -464,5 +466,100 @@ void FakeInputTest::testKeyboardKeyLinux()
     QTEST(releasedSpy.last().first().value<quint32>(), "linuxKey");
 }
 
+void FakeInputTest::testBatched()
+{
+    // this test verifies that a batched device delivers its events at once, in order
+    qRegisterMetaType<QVector<FakeInputEvent>>();
+    QSignalSpy eventsSpy(m_device, &FakeInputDevice::eventsRequested);
+    QVERIFY(eventsSpy.isValid());
+    QSignalSpy motionSpy(m_device, &FakeInputDevice::pointerMotionRequested);
+    QVERIFY(motionSpy.isValid());
+    QSignalSpy touchFrameSpy(m_device, &FakeInputDevice::touchFrameRequested);
+    QVERIFY(touchFrameSpy.isValid());
+
+    m_device->setAuthentication(true);
+    m_device->setBatched(true);
+    QVERIFY(m_device->isBatched());
+    m_fakeInput->requestPointerMove(QSizeF(1, 2));
+    m_fakeInput->requestPointerButtonPress(quint32(BTN_LEFT));
+    m_fakeInput->requestTouchDown(0, QPointF(3, 4));
+    m_fakeInput->requestTouchFrame();
+    m_fakeInput->requestKeyboardKeyPress(quint32(KEY_A));
+    m_fakeInput->requestPointerMove(QSizeF(5, 6));
+
+    QVector<FakeInputEvent> events;
+    while (events.count() < 6) {
+        QVERIFY(eventsSpy.wait());
+        for (const QList<QVariant> &arguments : qAsConst(eventsSpy)) {
+            events << arguments.first().value<QVector<FakeInputEvent>>();
+        }
+        eventsSpy.clear();
+    }
+    QCOMPARE(events.count(), 6);
+    QCOMPARE(events[0].type, FakeInputEvent::Type::PointerMotion);
+    QCOMPARE(events[0].delta, QSizeF(1, 2));
+    QCOMPARE(events[1].type, FakeInputEvent::Type::PointerButtonPress);
+    QCOMPARE(events[1].code, quint32(BTN_LEFT));
+    QCOMPARE(events[2].type, FakeInputEvent::Type::TouchDown);
+    QCOMPARE(events[2].code, quint32(0));
+    QCOMPARE(events[2].position, QPointF(3, 4));
+    QCOMPARE(events[3].type, FakeInputEvent::Type::TouchFrame);
+    QCOMPARE(events[4].type, FakeInputEvent::Type::KeyboardKeyPress);
+    QCOMPARE(events[4].code, quint32(KEY_A));
+    QCOMPARE(events[5].type, FakeInputEvent::Type::PointerMotion);
+    QCOMPARE(events[5].delta, QSizeF(5, 6));
+    // none of the events is delivered on its own
+    QVERIFY(motionSpy.isEmpty());
+    QVERIFY(touchFrameSpy.isEmpty());
+
+    // without batching the events are delivered one by one again
+    m_device->setBatched(false);
+    m_fakeInput->requestPointerMove(QSizeF(7, 8));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.last().first().toSizeF(), QSizeF(7, 8));
+    QVERIFY(eventsSpy.isEmpty());
+}
+
+void FakeInputTest::testTouchIdsPerDevice()
+{
+    // this test verifies that the touch points of one device don't affect another one
+    QSignalSpy deviceCreatedSpy(m_fakeInputInterface, &FakeInputInterface::deviceCreated);
+    Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection);
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QScopedPointer<FakeInput> otherFakeInput(registry.createFakeInput(registry.interface(Registry::Interface::FakeInput).name,
+                                                                      registry.interface(Registry::Interface::FakeInput).version));
+    QVERIFY(deviceCreatedSpy.wait());
+    // the device is a child of the global and goes away with it
+    QPointer<FakeInputDevice> otherDevice = deviceCreatedSpy.first().first().value<FakeInputDevice*>();
+    QVERIFY(otherDevice);
+
+    m_device->setAuthentication(true);
+    otherDevice->setAuthentication(true);
+    QSignalSpy touchDownSpy(m_device, &FakeInputDevice::touchDownRequested);
+    QSignalSpy otherTouchDownSpy(otherDevice, &FakeInputDevice::touchDownRequested);
+    QSignalSpy otherTouchUpSpy(otherDevice, &FakeInputDevice::touchUpRequested);
+
+    m_fakeInput->requestTouchDown(0, QPointF(1, 2));
+    QVERIFY(touchDownSpy.wait());
+
+    // the same id is free on the other device
+    otherFakeInput->requestTouchDown(0, QPointF(3, 4));
+    QVERIFY(otherTouchDownSpy.wait());
+    QCOMPARE(otherTouchDownSpy.last().at(1).toPointF(), QPointF(3, 4));
+
+    // and releasing it there does not release it on the first device
+    otherFakeInput->requestTouchUp(0);
+    QVERIFY(otherTouchUpSpy.wait());
+    m_fakeInput->requestTouchDown(0, QPointF(5, 6));
+    QVERIFY(!touchDownSpy.wait(100));
+    QCOMPARE(touchDownSpy.count(), 1);
+
+    otherFakeInput.reset();
+}
+
 QTEST_GUILESS_MAIN(FakeInputTest)
 #include "test_fake_input.moc"
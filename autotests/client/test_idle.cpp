@@ -31,6 +31,7 @@ private Q_SLOTS:
     void testServerSimulateUserActivity();
     void testIdleInhibit();
     void testIdleInhibitBlocksTimeout();
+    void testMultipleTimeouts();
 
 private:
     Display *m_display = nullptr;
@@ -272,5 +273,55 @@ void IdleTest::testIdleInhibitBlocksTimeout()
     m_display->dispatchEvents();
 }
 
+void IdleTest::testMultipleTimeouts()
+{
+    // this test verifies that timeouts with different intervals on the same seat fire
+    // independently of each other and are only resumed when they are idle
+    QScopedPointer<IdleTimeout> shortTimeout(m_idle->getTimeout(1000, m_seat));
+    QVERIFY(shortTimeout->isValid());
+    QScopedPointer<IdleTimeout> longTimeout(m_idle->getTimeout(2000, m_seat));
+    QVERIFY(longTimeout->isValid());
+    QSignalSpy shortIdleSpy(shortTimeout.data(), &IdleTimeout::idle);
+    QVERIFY(shortIdleSpy.isValid());
+    QSignalSpy shortResumedSpy(shortTimeout.data(), &IdleTimeout::resumeFromIdle);
+    QVERIFY(shortResumedSpy.isValid());
+    QSignalSpy longIdleSpy(longTimeout.data(), &IdleTimeout::idle);
+    QVERIFY(longIdleSpy.isValid());
+    QSignalSpy longResumedSpy(longTimeout.data(), &IdleTimeout::resumeFromIdle);
+    QVERIFY(longResumedSpy.isValid());
+    m_connection->flush();
+
+    // the short timeout fires first
+    QVERIFY(shortIdleSpy.wait());
+    QVERIFY(longIdleSpy.isEmpty());
+
+    // input resumes the idle timeout, the other one just starts over
+    m_seatInterface->setTimestamp(1);
+    QVERIFY(shortResumedSpy.wait());
+    QVERIFY(longResumedSpy.isEmpty());
+
+    // lots of input only counts as one activity
+    for (int i = 2; i < 1000; ++i) {
+        m_seatInterface->setTimestamp(i);
+    }
+
+    QVERIFY(shortIdleSpy.wait());
+    QCOMPARE(shortIdleSpy.count(), 2);
+    QVERIFY(longIdleSpy.isEmpty());
+    QVERIFY(longIdleSpy.wait());
+    QCOMPARE(shortResumedSpy.count(), 1);
+    QVERIFY(longResumedSpy.isEmpty());
+
+    // both are resumed by the next input
+    m_seatInterface->setTimestamp(1000);
+    QVERIFY(longResumedSpy.wait());
+    QTRY_COMPARE(shortResumedSpy.count(), 2);
+
+    shortTimeout.reset();
+    longTimeout.reset();
+    m_connection->flush();
+    m_display->dispatchEvents();
+}
+
 QTEST_GUILESS_MAIN(IdleTest)
 #include "test_idle.moc"
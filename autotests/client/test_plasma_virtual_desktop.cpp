@@ -5,6 +5,7 @@
 */
 // Qt
 #include <QtTest>
+#include <QUuid>
 // KWin
 #include "KWayland/Client/compositor.h"
 #include "KWayland/Client/connection_thread.h"
@@ -39,6 +40,7 @@ private Q_SLOTS:
 
     void testEnterLeaveDesktop();
     void testAllDesktops();
+    void testBatchedSwitch();
     void testCreateRequested();
     void testRemoveRequested();
 
@@ -472,6 +474,50 @@ void TestVirtualDesktop::testAllDesktops()
     QVERIFY(!m_window->isOnAllDesktops());
 }
 
+void TestVirtualDesktop::testBatchedSwitch()
+{
+    testCreate();
+    QSignalSpy virtualDesktopEnteredSpy(m_window, &KWayland::Client::PlasmaWindow::plasmaVirtualDesktopEntered);
+    QSignalSpy virtualDesktopLeftSpy(m_window, &KWayland::Client::PlasmaWindow::plasmaVirtualDesktopLeft);
+
+    m_windowInterface->addPlasmaVirtualDesktop(QStringLiteral("0-1"));
+    QVERIFY(virtualDesktopEnteredSpy.wait());
+    virtualDesktopEnteredSpy.clear();
+
+    // within a batch only the difference is sent, the detour over 0-3 is not
+    m_windowManagementInterface->beginUpdate();
+    m_windowInterface->removePlasmaVirtualDesktop(QStringLiteral("0-1"));
+    m_windowInterface->addPlasmaVirtualDesktop(QStringLiteral("0-3"));
+    m_windowInterface->removePlasmaVirtualDesktop(QStringLiteral("0-3"));
+    m_windowInterface->addPlasmaVirtualDesktop(QStringLiteral("0-2"));
+    QCOMPARE(m_windowInterface->plasmaVirtualDesktops(), QStringList{QStringLiteral("0-2")});
+    m_windowManagementInterface->commitUpdate();
+
+    QVERIFY(virtualDesktopEnteredSpy.wait());
+    QCOMPARE(virtualDesktopLeftSpy.count(), 1);
+    QCOMPARE(virtualDesktopLeftSpy.first().at(0).toString(), QStringLiteral("0-1"));
+    QCOMPARE(virtualDesktopEnteredSpy.count(), 1);
+    QCOMPARE(virtualDesktopEnteredSpy.first().at(0).toString(), QStringLiteral("0-2"));
+    QCOMPARE(m_window->plasmaVirtualDesktops(), QStringList{QStringLiteral("0-2")});
+
+    // windows created during the batch are part of it
+    m_windowManagementInterface->beginUpdate();
+    m_windowInterface->addPlasmaVirtualDesktop(QStringLiteral("0-1"));
+    m_windowInterface->removePlasmaVirtualDesktop(QStringLiteral("0-1"));
+    QScopedPointer<KWaylandServer::PlasmaWindowInterface> window(m_windowManagementInterface->createWindow(this, QUuid::createUuid()));
+    window->addPlasmaVirtualDesktop(QStringLiteral("0-1"));
+    window->removePlasmaVirtualDesktop(QStringLiteral("0-1"));
+    window->addPlasmaVirtualDesktop(QStringLiteral("0-3"));
+    m_windowManagementInterface->commitUpdate();
+    QCOMPARE(window->plasmaVirtualDesktops(), QStringList{QStringLiteral("0-3")});
+
+    m_windowInterface->addPlasmaVirtualDesktop(QStringLiteral("0-3"));
+    QVERIFY(virtualDesktopEnteredSpy.wait());
+    QCOMPARE(virtualDesktopEnteredSpy.count(), 2);
+    QCOMPARE(virtualDesktopEnteredSpy.last().at(0).toString(), QStringLiteral("0-3"));
+    QCOMPARE(virtualDesktopLeftSpy.count(), 1);
+}
+
 void TestVirtualDesktop::testCreateRequested()
 {
     //rebuild some desktops
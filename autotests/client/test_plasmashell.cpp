@@ -38,6 +38,7 @@ private Q_SLOTS:
     void testPanelBehavior();
     void testAutoHidePanel();
     void testPanelTakesFocus();
+    void testCommitAligned();
     void testDisconnect();
     void testWhileDestroying();
 
@@ -445,6 +446,63 @@ void TestPlasmaShell::testPanelTakesFocus()
     QCOMPARE(sps->panelTakesFocus(), false);
 }
 
+void TestPlasmaShell::testCommitAligned()
+{
+    // this test verifies that a commit aligned surface applies all its properties on commit
+    qRegisterMetaType<PlasmaShellSurfaceInterface::Properties>();
+    m_plasmaShellInterface->setCommitAligned(true);
+    QVERIFY(m_plasmaShellInterface->isCommitAligned());
+    QSignalSpy plasmaSurfaceCreatedSpy(m_plasmaShellInterface, &PlasmaShellInterface::surfaceCreated);
+    QVERIFY(plasmaSurfaceCreatedSpy.isValid());
+
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QScopedPointer<PlasmaShellSurface> ps(m_plasmaShell->createSurface(s.data()));
+    QVERIFY(plasmaSurfaceCreatedSpy.wait());
+    auto sps = plasmaSurfaceCreatedSpy.first().first().value<PlasmaShellSurfaceInterface*>();
+    QVERIFY(sps);
+
+    QSignalSpy propertiesChangedSpy(sps, &PlasmaShellSurfaceInterface::propertiesChanged);
+    QVERIFY(propertiesChangedSpy.isValid());
+    QSignalSpy roleChangedSpy(sps, &PlasmaShellSurfaceInterface::roleChanged);
+    QVERIFY(roleChangedSpy.isValid());
+    QSignalSpy positionChangedSpy(sps, &PlasmaShellSurfaceInterface::positionChanged);
+    QVERIFY(positionChangedSpy.isValid());
+
+    // reconfigure the panel, nothing is applied before the commit
+    ps->setRole(PlasmaShellSurface::Role::Panel);
+    ps->setPanelBehavior(PlasmaShellSurface::PanelBehavior::AutoHide);
+    ps->setPosition(QPoint(0, 1040));
+    ps->setPosition(QPoint(0, 1050));
+    ps->setSkipTaskbar(true);
+    QVERIFY(!propertiesChangedSpy.wait(100));
+    QCOMPARE(sps->role(), PlasmaShellSurfaceInterface::Role::Normal);
+    QVERIFY(!sps->isPositionSet());
+
+    // but a hide request already sees the requested behavior
+    QSignalSpy autoHideRequestedSpy(sps, &PlasmaShellSurfaceInterface::panelAutoHideHideRequested);
+    QVERIFY(autoHideRequestedSpy.isValid());
+    ps->requestHideAutoHidingPanel();
+    QVERIFY(autoHideRequestedSpy.wait());
+
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(propertiesChangedSpy.wait());
+    QCOMPARE(propertiesChangedSpy.count(), 1);
+    QCOMPARE(propertiesChangedSpy.first().first().value<PlasmaShellSurfaceInterface::Properties>(),
+             PlasmaShellSurfaceInterface::Property::Role | PlasmaShellSurfaceInterface::Property::PanelBehavior
+             | PlasmaShellSurfaceInterface::Property::Position | PlasmaShellSurfaceInterface::Property::SkipTaskbar);
+    QCOMPARE(sps->role(), PlasmaShellSurfaceInterface::Role::Panel);
+    QCOMPARE(sps->panelBehavior(), PlasmaShellSurfaceInterface::PanelBehavior::AutoHide);
+    QCOMPARE(sps->position(), QPoint(0, 1050));
+    QVERIFY(sps->skipTaskbar());
+    QCOMPARE(roleChangedSpy.count(), 0);
+    QCOMPARE(positionChangedSpy.count(), 0);
+
+    // a commit without changes doesn't announce anything
+    ps->setPosition(QPoint(0, 1050));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(!propertiesChangedSpy.wait(100));
+}
+
 void TestPlasmaShell::testDisconnect()
 {
     // this test verifies that a disconnect cleans up
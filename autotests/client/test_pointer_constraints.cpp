@@ -5,6 +5,7 @@
 */
 // Qt
 #include <QtTest>
+#include <QImage>
 // client
 #include "KWayland/Client/connection_thread.h"
 #include "KWayland/Client/compositor.h"
@@ -12,7 +13,9 @@
 #include "KWayland/Client/pointer.h"
 #include "KWayland/Client/pointerconstraints.h"
 #include "KWayland/Client/registry.h"
+#include "KWayland/Client/region.h"
 #include "KWayland/Client/seat.h"
+#include "KWayland/Client/shm_pool.h"
 #include "KWayland/Client/surface.h"
 // server
 #include "../../src/server/display.h"
@@ -40,6 +43,7 @@ private Q_SLOTS:
 
     void testConfinePointer_data();
     void testConfinePointer();
+    void testConfineRegion();
     void testAlreadyConstrained_data();
     void testAlreadyConstrained();
 
@@ -55,6 +59,7 @@ private:
     Seat *m_seat = nullptr;
     Pointer *m_pointer = nullptr;
     PointerConstraints *m_pointerConstraints = nullptr;
+    ShmPool *m_shm = nullptr;
 };
 
 static const QString s_socketName = QStringLiteral("kwayland-test-pointer_constraint-0");
@@ -109,6 +114,10 @@ void TestPointerConstraints::init()
     QVERIFY(m_pointerConstraints);
     QVERIFY(m_pointerConstraints->isValid());
 
+    m_shm = registry.createShmPool(registry.interface(Registry::Interface::Shm).name, registry.interface(Registry::Interface::Shm).version, this);
+    QVERIFY(m_shm);
+    QVERIFY(m_shm->isValid());
+
     m_seat = registry.createSeat(registry.interface(Registry::Interface::Seat).name, registry.interface(Registry::Interface::Seat).version, this);
     QVERIFY(m_seat);
     QVERIFY(m_seat->isValid());
@@ -128,6 +137,7 @@ void TestPointerConstraints::cleanup()
     }
     CLEANUP(m_compositor)
     CLEANUP(m_pointerConstraints)
+    CLEANUP(m_shm)
     CLEANUP(m_pointer)
     CLEANUP(m_seat)
     CLEANUP(m_queue)
@@ -358,6 +368,73 @@ void TestPointerConstraints::testConfinePointer()
     QCOMPARE(pointerConstraintsChangedSpy.count(), 2);
 }
 
+void TestPointerConstraints::testConfineRegion()
+{
+    // this test verifies the effective region of a confined pointer and confining positions into it
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surface->isValid());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    QSignalSpy pointerConstraintsChangedSpy(serverSurface, &SurfaceInterface::pointerConstraintsChanged);
+    QVERIFY(pointerConstraintsChangedSpy.isValid());
+    QRegion region(10, 10, 20, 20);
+    region += QRect(50, 10, 20, 20);
+    QScopedPointer<ConfinedPointer> confinedPointer(m_pointerConstraints->confinePointer(surface.data(), m_pointer,
+                                                                                         m_compositor->createRegion(region, m_compositor),
+                                                                                         PointerConstraints::LifeTime::Persistent));
+    QVERIFY(pointerConstraintsChangedSpy.wait());
+    auto serverConfinedPointer = serverSurface->confinedPointer();
+    QVERIFY(serverConfinedPointer);
+    // without a buffer the surface has no input region
+    QCOMPARE(serverConfinedPointer->effectiveRegion(), QRegion());
+    QCOMPARE(serverConfinedPointer->confine(QPointF(5, 5)), QPointF(5, 5));
+
+    // attach a buffer, the input region covers the whole surface
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(image.rect());
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverConfinedPointer->effectiveRegion(), region);
+
+    QVERIFY(serverConfinedPointer->contains(QPointF(15.5, 15.5)));
+    QVERIFY(serverConfinedPointer->contains(QPointF(69.5, 29.5)));
+    QVERIFY(!serverConfinedPointer->contains(QPointF(40, 15)));
+    QVERIFY(!serverConfinedPointer->contains(QPointF(70, 15)));
+
+    const qreal epsilon = 1.0 / 256;
+    QCOMPARE(serverConfinedPointer->confine(QPointF(15.5, 15.5)), QPointF(15.5, 15.5));
+    QCOMPARE(serverConfinedPointer->confine(QPointF(-5, 15)), QPointF(10, 15));
+    // the position gets moved into the closest rectangle
+    QCOMPARE(serverConfinedPointer->confine(QPointF(45, 15)), QPointF(50, 15));
+    QCOMPARE(serverConfinedPointer->confine(QPointF(35, 15)), QPointF(30 - epsilon, 15));
+    QCOMPARE(serverConfinedPointer->confine(QPointF(200, 200)), QPointF(70 - epsilon, 30 - epsilon));
+
+    // shrinking the input region of the surface shrinks the effective region
+    surface->setInputRegion(m_compositor->createRegion(QRegion(0, 0, 20, 100)).get());
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverConfinedPointer->effectiveRegion(), QRegion(10, 10, 10, 20));
+    QVERIFY(!serverConfinedPointer->contains(QPointF(25, 15)));
+    QCOMPARE(serverConfinedPointer->confine(QPointF(45, 15)), QPointF(20 - epsilon, 15));
+
+    // without a constraint region the input region is used
+    QSignalSpy regionChangedSpy(serverConfinedPointer, &ConfinedPointerV1Interface::regionChanged);
+    QVERIFY(regionChangedSpy.isValid());
+    confinedPointer->setRegion(nullptr);
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(regionChangedSpy.wait());
+    QCOMPARE(serverConfinedPointer->effectiveRegion(), QRegion(0, 0, 20, 100));
+    QCOMPARE(serverConfinedPointer->confine(QPointF(45, 150)), QPointF(20 - epsilon, 100 - epsilon));
+}
+
 enum class Constraint {
     Lock,
     Confine
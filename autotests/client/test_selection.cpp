@@ -10,6 +10,7 @@
 #include "KWayland/Client/compositor.h"
 #include "KWayland/Client/datadevice.h"
 #include "KWayland/Client/datadevicemanager.h"
+#include "KWayland/Client/dataoffer.h"
 #include "KWayland/Client/datasource.h"
 #include "KWayland/Client/event_queue.h"
 #include "KWayland/Client/keyboard.h"
@@ -19,8 +20,12 @@
 // server
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/datadevicemanager_interface.h"
+#include "../../src/server/datatransfermonitor.h"
 #include "../../src/server/display.h"
 #include "../../src/server/seat_interface.h"
+// system
+#include <fcntl.h>
+#include <unistd.h>
 
 using namespace KWayland::Client;
 using namespace KWaylandServer;
@@ -33,6 +38,11 @@ private Q_SLOTS:
     void init();
     void cleanup();
     void testClearOnEnter();
+    void testPersistentSelection();
+    void testCoalescedSelection();
+    void testTransferMonitor();
+    void testSelectionDeduplication();
+    void testFocusWithinClient();
 
 private:
     Display *m_display = nullptr;
@@ -253,5 +263,358 @@ void SelectionTest::testClearOnEnter()
     QVERIFY(selectionClearedClient1Spy.wait());
 }
 
+void SelectionTest::testPersistentSelection()
+{
+    // this test verifies that the server keeps the selection once its client destroyed it
+    m_seatInterface->setPersistentSelectionMimeTypes({QStringLiteral("text/*")});
+    QCOMPARE(m_seatInterface->persistentSelectionMimeTypes(), QStringList{QStringLiteral("text/*")});
+
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+
+    // the cache reads the text right away, the image is left to the client
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    dataSource->offer(QStringLiteral("text/plain"));
+    dataSource->offer(QStringLiteral("image/png"));
+    QSignalSpy sendDataRequestedSpy(dataSource.data(), &DataSource::sendDataRequested);
+    QVERIFY(sendDataRequestedSpy.isValid());
+    connect(dataSource.data(), &DataSource::sendDataRequested, this, [](const QString &mimeType, qint32 fd) {
+        QCOMPARE(mimeType, QStringLiteral("text/plain"));
+        const QByteArray data = QByteArrayLiteral("persistent text");
+        QCOMPARE(write(fd, data.constData(), data.size()), ssize_t(data.size()));
+        close(fd);
+    });
+    QSignalSpy selectionChangedSpy(m_seatInterface, &SeatInterface::selectionChanged);
+    QVERIFY(selectionChangedSpy.isValid());
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+    QVERIFY(selectionChangedSpy.wait());
+    QVERIFY(sendDataRequestedSpy.wait());
+    QCOMPARE(sendDataRequestedSpy.count(), 1);
+
+    // the client goes away, the selection stays
+    dataSource.reset();
+    QVERIFY(selectionChangedSpy.wait());
+    AbstractDataSource *cache = m_seatInterface->selection();
+    QVERIFY(cache);
+    QCOMPARE(cache->mimeTypes(), QStringList{QStringLiteral("text/plain")});
+
+    // another client gets the text from the server
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    auto offer = selectionOfferedClient2Spy.last().first().value<DataOffer*>();
+    QVERIFY(offer);
+    QCOMPARE(offer->offeredMimeTypes().count(), 1);
+
+    int pipeFds[2];
+    QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+    offer->receive(QStringLiteral("text/plain"), pipeFds[1]);
+    close(pipeFds[1]);
+    m_client2.connection->flush();
+
+    QByteArray received;
+    bool complete = false;
+    auto readPipe = [&]() {
+        char buffer[64];
+        ssize_t count;
+        while ((count = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+            received.append(buffer, count);
+        }
+        complete = count == 0;
+        return complete;
+    };
+    QTRY_VERIFY(readPipe());
+    close(pipeFds[0]);
+    QCOMPARE(received, QByteArrayLiteral("persistent text"));
+
+    // a new selection replaces the copy
+    m_client2.dataDevice->clearSelection(0);
+    QVERIFY(selectionChangedSpy.wait());
+    QVERIFY(!m_seatInterface->selection());
+}
+
+void SelectionTest::testCoalescedSelection()
+{
+    // this test verifies that rapid selection changes are only offered once, with the last selection
+    m_seatInterface->setSelectionCoalescingInterval(100);
+    QCOMPARE(m_seatInterface->selectionCoalescingInterval(), 100);
+
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+    const quint32 serial = keyboardEnteredClient1Spy.first().first().value<quint32>();
+
+    QSignalSpy selectionOfferedSpy(m_client1.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedSpy.isValid());
+    QSignalSpy selectionChangedSpy(m_seatInterface, &SeatInterface::selectionChanged);
+    QVERIFY(selectionChangedSpy.isValid());
+
+    QScopedPointer<DataSource> dataSource1(m_client1.ddm->createDataSource());
+    dataSource1->offer(QStringLiteral("text/plain"));
+    QSignalSpy cancelledSpy(dataSource1.data(), &DataSource::cancelled);
+    QVERIFY(cancelledSpy.isValid());
+    QScopedPointer<DataSource> dataSource2(m_client1.ddm->createDataSource());
+    dataSource2->offer(QStringLiteral("text/html"));
+    QScopedPointer<DataSource> dataSource3(m_client1.ddm->createDataSource());
+    dataSource3->offer(QStringLiteral("text/uri-list"));
+    m_client1.dataDevice->setSelection(serial, dataSource1.data());
+    m_client1.dataDevice->setSelection(serial, dataSource2.data());
+    m_client1.dataDevice->setSelection(serial, dataSource3.data());
+
+    // the replaced selections are cancelled right away
+    QVERIFY(cancelledSpy.wait());
+    QVERIFY(m_seatInterface->selection());
+    QCOMPARE(m_seatInterface->selection()->mimeTypes(), QStringList{QStringLiteral("text/uri-list")});
+
+    QVERIFY(selectionOfferedSpy.wait());
+    QCOMPARE(selectionChangedSpy.count(), 1);
+    auto offer = selectionOfferedSpy.first().first().value<DataOffer*>();
+    QVERIFY(offer);
+    QCOMPARE(offer->offeredMimeTypes().count(), 1);
+    QCOMPARE(offer->offeredMimeTypes().first().name(), QStringLiteral("text/uri-list"));
+    QVERIFY(!selectionOfferedSpy.wait(200));
+    QCOMPARE(selectionChangedSpy.count(), 1);
+
+    // without coalescing every change is announced right away
+    m_seatInterface->setSelectionCoalescingInterval(0);
+    m_client1.dataDevice->clearSelection(serial);
+    QVERIFY(selectionChangedSpy.wait());
+    QVERIFY(!m_seatInterface->selection());
+}
+
+void SelectionTest::testTransferMonitor()
+{
+    // this test verifies that the monitor counts the transfers and stops the ones above the size limit
+    DataTransferMonitor monitor(m_display);
+    monitor.setSizeLimit(QStringLiteral("text/*"), 50);
+    QCOMPARE(monitor.sizeLimit(QStringLiteral("text/plain")), quint64(50));
+    monitor.setSizeLimit(QStringLiteral("text/html"), 1000);
+    QCOMPARE(monitor.sizeLimit(QStringLiteral("text/html")), quint64(1000));
+    QCOMPARE(monitor.sizeLimit(QStringLiteral("image/png")), quint64(0));
+    QSignalSpy transferFinishedSpy(&monitor, &DataTransferMonitor::transferFinished);
+    QVERIFY(transferFinishedSpy.isValid());
+    QSignalSpy transferRefusedSpy(&monitor, &DataTransferMonitor::transferRefused);
+    QVERIFY(transferRefusedSpy.isValid());
+
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    dataSource->offer(QStringLiteral("text/plain"));
+    dataSource->offer(QStringLiteral("text/html"));
+    connect(dataSource.data(), &DataSource::sendDataRequested, this, [](const QString &mimeType, qint32 fd) {
+        const QByteArray data(mimeType == QLatin1String("text/html") ? 10 : 100, 'x');
+        QCOMPARE(write(fd, data.constData(), data.size()), ssize_t(data.size()));
+        close(fd);
+    });
+    QSignalSpy selectionChangedSpy(m_seatInterface, &SeatInterface::selectionChanged);
+    QVERIFY(selectionChangedSpy.isValid());
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.first().first().value<quint32>(), dataSource.data());
+    QVERIFY(selectionChangedSpy.wait());
+
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(surfaceCreatedSpy.last().first().value<SurfaceInterface*>());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    auto offer = selectionOfferedClient2Spy.last().first().value<DataOffer*>();
+    QVERIFY(offer);
+
+    auto receive = [&](const QString &mimeType) {
+        int pipeFds[2];
+        if (pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) != 0) {
+            return QByteArray();
+        }
+        offer->receive(mimeType, pipeFds[1]);
+        close(pipeFds[1]);
+        m_client2.connection->flush();
+
+        QByteArray received;
+        auto readPipe = [&]() {
+            char buffer[64];
+            ssize_t count;
+            while ((count = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+                received.append(buffer, count);
+            }
+            return count == 0;
+        };
+        QTest::qWaitFor(readPipe);
+        close(pipeFds[0]);
+        return received;
+    };
+
+    // the transfer within its limit gets through
+    QCOMPARE(receive(QStringLiteral("text/html")), QByteArray(10, 'x'));
+    QTRY_COMPARE(transferFinishedSpy.count(), 1);
+    QCOMPARE(transferFinishedSpy.last().at(1).toBool(), true);
+    const DataTransferProgress html = transferFinishedSpy.last().first().value<DataTransferProgress>();
+    QCOMPARE(html.mimeType, QStringLiteral("text/html"));
+    QCOMPARE(html.bytes, quint64(10));
+    QVERIFY(html.source);
+    QVERIFY(html.target);
+    QVERIFY(html.source != html.target);
+
+    // the one above it is refused
+    QVERIFY(receive(QStringLiteral("text/plain")).size() <= 50);
+    QTRY_COMPARE(transferFinishedSpy.count(), 2);
+    QCOMPARE(transferFinishedSpy.last().at(1).toBool(), false);
+    QCOMPARE(transferRefusedSpy.count(), 1);
+    QVERIFY(monitor.activeTransfers().isEmpty());
+
+    const DataTransferStatistics statistics = monitor.statistics(html.source, html.target);
+    QCOMPARE(statistics.transfers, quint64(2));
+    QCOMPARE(statistics.failedTransfers, quint64(1));
+    QCOMPARE(statistics.refusedTransfers, quint64(1));
+    QCOMPARE(statistics.stalledTransfers, quint64(0));
+    QCOMPARE(statistics.bytes, quint64(10));
+    QCOMPARE(monitor.statistics().count(), 1);
+    monitor.resetStatistics();
+    QVERIFY(monitor.statistics().isEmpty());
+}
+
+void SelectionTest::testSelectionDeduplication()
+{
+    // this test verifies that focus changes don't offer a selection again to a client which has it
+    m_seatInterface->setSelectionDeduplicationEnabled(true);
+    QVERIFY(m_seatInterface->isSelectionDeduplicationEnabled());
+
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy keyboardEnteredClient2Spy(m_client2.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient2Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface1 = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> s2(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface2 = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+
+    QSignalSpy selectionOfferedClient1Spy(m_client1.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient1Spy.isValid());
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+    QSignalSpy selectionClearedClient1Spy(m_client1.dataDevice, &DataDevice::selectionCleared);
+    QVERIFY(selectionClearedClient1Spy.isValid());
+
+    // the first focus still clears the selection
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+    QCOMPARE(selectionClearedClient1Spy.count(), 1);
+
+    QScopedPointer<DataSource> dataSource(m_client1.ddm->createDataSource());
+    dataSource->offer(QStringLiteral("text/plain"));
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.last().first().value<quint32>(), dataSource.data());
+    QVERIFY(selectionOfferedClient1Spy.wait());
+    QVERIFY(m_seatInterface->selection());
+    const quint64 generation = m_seatInterface->selection()->generation();
+
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface2);
+    QVERIFY(selectionOfferedClient2Spy.wait());
+
+    // moving the focus back and forth doesn't offer the selection again
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface2);
+    QVERIFY(keyboardEnteredClient2Spy.wait());
+    QCOMPARE(selectionOfferedClient1Spy.count(), 1);
+    QCOMPARE(selectionOfferedClient2Spy.count(), 1);
+    QCOMPARE(m_seatInterface->selection()->generation(), generation);
+
+    // a new selection is offered with a new generation
+    QScopedPointer<DataSource> dataSource2(m_client2.ddm->createDataSource());
+    dataSource2->offer(QStringLiteral("text/html"));
+    m_client2.dataDevice->setSelection(keyboardEnteredClient2Spy.last().first().value<quint32>(), dataSource2.data());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+    QVERIFY(m_seatInterface->selection()->generation() > generation);
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(selectionOfferedClient1Spy.wait());
+    QCOMPARE(selectionOfferedClient1Spy.count(), 2);
+}
+
+void SelectionTest::testFocusWithinClient()
+{
+    // this test verifies that moving the focus between surfaces of the same client doesn't offer the selection again
+    QVERIFY(!m_seatInterface->isSelectionDeduplicationEnabled());
+
+    QSignalSpy keyboardEnteredClient1Spy(m_client1.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient1Spy.isValid());
+    QSignalSpy keyboardEnteredClient2Spy(m_client2.keyboard, &Keyboard::entered);
+    QVERIFY(keyboardEnteredClient2Spy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface1 = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> s2(m_client1.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface2 = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> s3(m_client2.compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface3 = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+
+    QSignalSpy selectionOfferedClient1Spy(m_client1.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient1Spy.isValid());
+    QSignalSpy selectionClearedClient1Spy(m_client1.dataDevice, &DataDevice::selectionCleared);
+    QVERIFY(selectionClearedClient1Spy.isValid());
+    QSignalSpy selectionOfferedClient2Spy(m_client2.dataDevice, &DataDevice::selectionOffered);
+    QVERIFY(selectionOfferedClient2Spy.isValid());
+
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface3);
+    QVERIFY(keyboardEnteredClient2Spy.wait());
+    QScopedPointer<DataSource> dataSource(m_client2.ddm->createDataSource());
+    dataSource->offer(QStringLiteral("text/plain"));
+    m_client2.dataDevice->setSelection(keyboardEnteredClient2Spy.last().first().value<quint32>(), dataSource.data());
+    QVERIFY(selectionOfferedClient2Spy.wait());
+
+    // focusing the other client offers the selection
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(selectionOfferedClient1Spy.wait());
+    QCOMPARE(selectionOfferedClient1Spy.count(), 1);
+    QCOMPARE(m_seatInterface->focusedKeyboardSurface(), serverSurface1);
+
+    // moving between its surfaces only moves the keyboard focus
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface2);
+    QCOMPARE(m_seatInterface->focusedKeyboardSurface(), serverSurface2);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+    QCOMPARE(m_client1.keyboard->enteredSurface(), s2.data());
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface1);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+    QVERIFY(!selectionOfferedClient1Spy.wait(200));
+    QCOMPARE(selectionOfferedClient1Spy.count(), 1);
+    QVERIFY(selectionClearedClient1Spy.isEmpty());
+
+    // a new selection still reaches the focused surface's client
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface2);
+    QVERIFY(keyboardEnteredClient1Spy.wait());
+    QScopedPointer<DataSource> dataSource2(m_client1.ddm->createDataSource());
+    dataSource2->offer(QStringLiteral("text/html"));
+    m_client1.dataDevice->setSelection(keyboardEnteredClient1Spy.last().first().value<quint32>(), dataSource2.data());
+    QVERIFY(selectionOfferedClient1Spy.wait());
+    QCOMPARE(selectionOfferedClient1Spy.count(), 2);
+}
+
 QTEST_GUILESS_MAIN(SelectionTest)
 #include "test_selection.moc"
@@ -32,6 +32,7 @@ private Q_SLOTS:
     void testRequest();
 
     void testSurfaceDestroy();
+    void testSecondDecoration();
 
 private:
     KWaylandServer::Display *m_display = nullptr;
@@ -305,5 +306,41 @@ void TestServerSideDecoration::testSurfaceDestroy()
     QVERIFY(decorationDestroyedSpy.wait());
 }
 
+void TestServerSideDecoration::testSecondDecoration()
+{
+    // a second decoration of a surface must not hide the first one when it goes away
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QSignalSpy decorationCreated(m_serverSideDecorationManagerInterface, &ServerSideDecorationManagerInterface::decorationCreated);
+    QVERIFY(decorationCreated.isValid());
+
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    auto serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+
+    QScopedPointer<ServerSideDecoration> firstDecoration(m_serverSideDecorationManager->create(surface.data()));
+    QVERIFY(decorationCreated.wait());
+    auto firstServerDeco = decorationCreated.last().first().value<ServerSideDecorationInterface*>();
+    QScopedPointer<ServerSideDecoration> secondDecoration(m_serverSideDecorationManager->create(surface.data()));
+    QVERIFY(decorationCreated.wait());
+    auto secondServerDeco = decorationCreated.last().first().value<ServerSideDecorationInterface*>();
+    QVERIFY(firstServerDeco != secondServerDeco);
+    QCOMPARE(ServerSideDecorationInterface::get(serverSurface), firstServerDeco);
+
+    QSignalSpy firstDestroyedSpy(firstServerDeco, &QObject::destroyed);
+    QVERIFY(firstDestroyedSpy.isValid());
+    firstDecoration.reset();
+    QVERIFY(firstDestroyedSpy.wait());
+    QCOMPARE(ServerSideDecorationInterface::get(serverSurface), secondServerDeco);
+
+    QSignalSpy secondDestroyedSpy(secondServerDeco, &QObject::destroyed);
+    QVERIFY(secondDestroyedSpy.isValid());
+    secondDecoration.reset();
+    QVERIFY(secondDestroyedSpy.wait());
+    QVERIFY(!ServerSideDecorationInterface::get(serverSurface));
+}
+
 QTEST_GUILESS_MAIN(TestServerSideDecoration)
 #include "test_server_side_decoration.moc"
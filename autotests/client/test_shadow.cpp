@@ -32,6 +32,8 @@ private Q_SLOTS:
     void testCreateShadow();
     void testShadowElements();
     void testSurfaceDestroy();
+    void testChangedTiles();
+    void testAtlas();
 
 private:
     Display *m_display = nullptr;
@@ -287,5 +289,124 @@ void ShadowTest::testSurfaceDestroy()
     QCOMPARE(shadowDestroyedSpy.count(), 1);
 }
 
+void ShadowTest::testChangedTiles()
+{
+    // this test verifies that re-attaching identical tiles is not reported as a change
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QSignalSpy shadowChangedSpy(serverSurface, &SurfaceInterface::shadowChanged);
+    QVERIFY(shadowChangedSpy.isValid());
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    QImage topImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    topImage.fill(Qt::black);
+    QImage leftImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    leftImage.fill(Qt::blue);
+
+    QScopedPointer<Shadow> shadow(m_shadow->createShadow(surface.data()));
+    shadow->attachTop(m_shm->createBuffer(topImage));
+    shadow->attachLeft(m_shm->createBuffer(leftImage));
+    shadow->commit();
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(shadowChangedSpy.wait());
+    auto serverShadow = serverSurface->shadow();
+    QVERIFY(serverShadow);
+    QCOMPARE(serverShadow->changedTiles(), ShadowInterface::TopTile | ShadowInterface::LeftTile);
+    const uint contentHash = serverShadow->contentHash();
+
+    // attach new buffers with the same content
+    shadow->attachTop(m_shm->createBuffer(topImage));
+    shadow->attachLeft(m_shm->createBuffer(leftImage));
+    shadow->commit();
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverShadow->changedTiles(), ShadowInterface::Tiles());
+    QCOMPARE(serverShadow->contentHash(), contentHash);
+    QCOMPARE(serverShadow->top()->data(), topImage);
+
+    // now change one of them
+    leftImage.fill(Qt::red);
+    shadow->attachTop(m_shm->createBuffer(topImage));
+    shadow->attachLeft(m_shm->createBuffer(leftImage));
+    shadow->commit();
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverShadow->changedTiles(), ShadowInterface::LeftTile);
+    QVERIFY(serverShadow->contentHash() != contentHash);
+}
+
+void ShadowTest::testAtlas()
+{
+    // this test verifies that the tiles are packed into the atlas
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QSignalSpy shadowChangedSpy(serverSurface, &SurfaceInterface::shadowChanged);
+    QVERIFY(shadowChangedSpy.isValid());
+
+    QScopedPointer<Shadow> shadow(m_shadow->createShadow(surface.data()));
+    QImage topLeftImage(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    topLeftImage.fill(Qt::white);
+    shadow->attachTopLeft(m_shm->createBuffer(topLeftImage));
+    QImage topImage(QSize(11, 11), QImage::Format_ARGB32_Premultiplied);
+    topImage.fill(Qt::black);
+    shadow->attachTop(m_shm->createBuffer(topImage));
+    QImage topRightImage(QSize(12, 12), QImage::Format_ARGB32_Premultiplied);
+    topRightImage.fill(Qt::red);
+    shadow->attachTopRight(m_shm->createBuffer(topRightImage));
+    QImage rightImage(QSize(13, 13), QImage::Format_ARGB32_Premultiplied);
+    rightImage.fill(Qt::darkRed);
+    shadow->attachRight(m_shm->createBuffer(rightImage));
+    QImage bottomRightImage(QSize(14, 14), QImage::Format_ARGB32_Premultiplied);
+    bottomRightImage.fill(Qt::green);
+    shadow->attachBottomRight(m_shm->createBuffer(bottomRightImage));
+    QImage bottomImage(QSize(15, 15), QImage::Format_ARGB32_Premultiplied);
+    bottomImage.fill(Qt::darkGreen);
+    shadow->attachBottom(m_shm->createBuffer(bottomImage));
+    QImage bottomLeftImage(QSize(16, 16), QImage::Format_ARGB32_Premultiplied);
+    bottomLeftImage.fill(Qt::blue);
+    shadow->attachBottomLeft(m_shm->createBuffer(bottomLeftImage));
+    QImage leftImage(QSize(17, 17), QImage::Format_ARGB32_Premultiplied);
+    leftImage.fill(Qt::darkBlue);
+    shadow->attachLeft(m_shm->createBuffer(leftImage));
+    shadow->commit();
+    surface->commit(Surface::CommitFlag::None);
+
+    QVERIFY(shadowChangedSpy.wait());
+    auto serverShadow = serverSurface->shadow();
+    QVERIFY(serverShadow);
+
+    // columns are 17, 15 and 14 pixels wide, rows are 12, 17 and 16 pixels high
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::TopLeftTile), QRect(0, 0, 10, 10));
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::TopTile), QRect(17, 0, 11, 11));
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::TopRightTile), QRect(32, 0, 12, 12));
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::RightTile), QRect(32, 12, 13, 13));
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::BottomRightTile), QRect(32, 29, 14, 14));
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::BottomTile), QRect(17, 29, 15, 15));
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::BottomLeftTile), QRect(0, 29, 16, 16));
+    QCOMPARE(serverShadow->atlasRect(ShadowInterface::LeftTile), QRect(0, 12, 17, 17));
+
+    const QImage atlas = serverShadow->atlas();
+    QCOMPARE(atlas.size(), QSize(46, 45));
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::TopLeftTile)), topLeftImage);
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::TopTile)), topImage);
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::TopRightTile)), topRightImage);
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::RightTile)), rightImage);
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::BottomRightTile)), bottomRightImage);
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::BottomTile)), bottomImage);
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::BottomLeftTile)), bottomLeftImage);
+    QCOMPARE(atlas.copy(serverShadow->atlasRect(ShadowInterface::LeftTile)), leftImage);
+    // the center is left empty
+    QCOMPARE(atlas.pixelColor(20, 20), QColor(Qt::transparent));
+}
+
 QTEST_GUILESS_MAIN(ShadowTest)
 #include "test_shadow.moc"
@@ -17,6 +17,8 @@
 #include "../../src/server/display.h"
 #include "../../src/server/surface_interface.h"
 
+#include <wayland-server-protocol.h>
+
 class TestShmPool : public QObject
 {
     Q_OBJECT
@@ -34,6 +36,7 @@ private Q_SLOTS:
     void testCreateBufferFromData();
     void testReuseBuffer();
     void testDestroy();
+    void testShmFormats();
 
 private:
     KWaylandServer::Display *m_display;
@@ -228,5 +231,28 @@ void TestShmPool::testDestroy()
     m_shmPool->destroy();
 }
 
+void TestShmPool::testShmFormats()
+{
+    using namespace KWaylandServer;
+    Display display;
+    QCOMPARE(display.shmFormats(), (QVector<quint32>{WL_SHM_FORMAT_ARGB8888, WL_SHM_FORMAT_XRGB8888}));
+
+    // the mandatory formats, duplicates and formats which can't be converted are dropped
+    display.setShmFormats({WL_SHM_FORMAT_RGB565, WL_SHM_FORMAT_XRGB8888, WL_SHM_FORMAT_NV12,
+                           WL_SHM_FORMAT_XRGB2101010, WL_SHM_FORMAT_RGB565});
+    QCOMPARE(display.shmFormats(), (QVector<quint32>{WL_SHM_FORMAT_ARGB8888, WL_SHM_FORMAT_XRGB8888,
+                                                     WL_SHM_FORMAT_RGB565, WL_SHM_FORMAT_XRGB2101010}));
+
+    display.addSocketName(QStringLiteral("kwin-test-wayland-shm-formats-0"));
+    display.start();
+    QVERIFY(display.isRunning());
+    display.createShm();
+
+    // once the global exists the formats can't be changed anymore
+    display.setShmFormats({WL_SHM_FORMAT_ABGR8888});
+    QCOMPARE(display.shmFormats(), (QVector<quint32>{WL_SHM_FORMAT_ARGB8888, WL_SHM_FORMAT_XRGB8888,
+                                                     WL_SHM_FORMAT_RGB565, WL_SHM_FORMAT_XRGB2101010}));
+}
+
 QTEST_GUILESS_MAIN(TestShmPool)
 #include "test_shm_pool.moc"
@@ -165,6 +165,13 @@ void TestAppmenu::testCreateAndSet()
     QCOMPARE(appMenuInterface->address().serviceName, QString("net.somename"));
     QCOMPARE(appMenuInterface->address().objectPath, QString("/test/path"));
 
+    // setting the same address again doesn't emit
+    appmenu->setAddress("net.somename", "/test/path");
+    appmenu->setAddress("net.somename", "/test/otherpath");
+    QVERIFY(appMenuChangedSpy.wait());
+    QCOMPARE(appMenuChangedSpy.count(), 2);
+    QCOMPARE(appMenuInterface->address().objectPath, QString("/test/otherpath"));
+
     // and destroy
     QSignalSpy destroyedSpy(appMenuInterface, &QObject::destroyed);
     QVERIFY(destroyedSpy.isValid());
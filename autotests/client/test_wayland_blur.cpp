@@ -31,6 +31,7 @@ private Q_SLOTS:
 
     void testCreate();
     void testSurfaceDestroy();
+    void testSameRegion();
 
 private:
     KWaylandServer::Display *m_display;
@@ -193,5 +194,63 @@ void TestBlur::testSurfaceDestroy()
     QVERIFY(blurDestroyedSpy.wait());
 }
 
+void TestBlur::testSameRegion()
+{
+    // this test verifies that replacing the blur with an identical one is not reported
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &KWaylandServer::CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+
+    QScopedPointer<KWayland::Client::Surface> surface(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+
+    auto serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface*>();
+    QSignalSpy blurChanged(serverSurface, &KWaylandServer::SurfaceInterface::blurChanged);
+    QVERIFY(blurChanged.isValid());
+    QSignalSpy committedSpy(serverSurface, &KWaylandServer::SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+    qRegisterMetaType<KWaylandServer::SurfaceInterface::Effects>();
+    QSignalSpy effectsChangedSpy(serverSurface, &KWaylandServer::SurfaceInterface::effectsChanged);
+    QVERIFY(effectsChangedSpy.isValid());
+
+    QScopedPointer<KWayland::Client::Blur> blur(m_blurManager->createBlur(surface.data()));
+    blur->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 20), nullptr));
+    blur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+    QCOMPARE(blurChanged.count(), 1);
+
+    // a new blur object with the same region
+    QScopedPointer<KWayland::Client::Blur> sameBlur(m_blurManager->createBlur(surface.data()));
+    sameBlur->setRegion(m_compositor->createRegion(QRegion(0, 0, 10, 20), nullptr));
+    sameBlur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(blurChanged.count(), 1);
+    QCOMPARE(serverSurface->blur()->region(), QRegion(0, 0, 10, 20));
+
+    // a different region is reported
+    QScopedPointer<KWayland::Client::Blur> otherBlur(m_blurManager->createBlur(surface.data()));
+    otherBlur->setRegion(m_compositor->createRegion(QRegion(0, 0, 20, 20), nullptr));
+    otherBlur->commit();
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+    QCOMPARE(blurChanged.count(), 2);
+    QCOMPARE(serverSurface->blur()->region(), QRegion(0, 0, 20, 20));
+
+    // and so is unsetting the blur
+    m_blurManager->removeBlur(surface.data());
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(blurChanged.wait());
+    QCOMPARE(blurChanged.count(), 3);
+    QVERIFY(!serverSurface->blur());
+
+    // the combined signal follows the blur, the identical blur object isn't reported either
+    QCOMPARE(effectsChangedSpy.count(), 3);
+    for (const QList<QVariant> &arguments : qAsConst(effectsChangedSpy)) {
+        QCOMPARE(arguments.first().value<KWaylandServer::SurfaceInterface::Effects>(),
+                 KWaylandServer::SurfaceInterface::Effects(KWaylandServer::SurfaceInterface::Effect::Blur));
+    }
+}
+
 QTEST_GUILESS_MAIN(TestBlur)
 #include "test_wayland_blur.moc"
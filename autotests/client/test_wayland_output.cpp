@@ -29,6 +29,8 @@ private Q_SLOTS:
     void testRegistry();
     void testModeChanges();
     void testScaleChange();
+    void testBatchedUpdate();
+    void testOutputLayoutUpdate();
 
     void testSubPixel_data();
     void testSubPixel();
@@ -39,6 +41,8 @@ private Q_SLOTS:
     void testDpms_data();
     void testDpms();
 
+    void testDpmsMultipleResources();
+
     void testDpmsRequestMode_data();
     void testDpmsRequestMode();
 
@@ -340,6 +344,78 @@ void TestWaylandOutput::testScaleChange()
     QCOMPARE(output.scale(), 4);
 }
 
+void TestWaylandOutput::testBatchedUpdate()
+{
+    KWayland::Client::Registry registry;
+    QSignalSpy announced(&registry, SIGNAL(outputAnnounced(quint32,quint32)));
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    wl_display_flush(m_connection->display());
+    QVERIFY(announced.wait());
+
+    KWayland::Client::Output output;
+    QSignalSpy outputChanged(&output, SIGNAL(changed()));
+    QVERIFY(outputChanged.isValid());
+    output.setup(registry.bindOutput(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    wl_display_flush(m_connection->display());
+    QVERIFY(outputChanged.wait());
+
+    // nothing is sent until the update is committed
+    outputChanged.clear();
+    m_serverOutput->beginUpdate();
+    m_serverOutput->setGlobalPosition(QPoint(1920, 0));
+    m_serverOutput->setScale(2);
+    m_serverOutput->setTransform(KWaylandServer::OutputInterface::Transform::Rotated90);
+    m_serverOutput->beginUpdate();
+    m_serverOutput->setCurrentMode(QSize(1280, 1024), 90000);
+    m_serverOutput->commitUpdate();
+    QVERIFY(!outputChanged.wait(100));
+
+    // all changes arrive with a single done
+    m_serverOutput->commitUpdate();
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.globalPosition(), QPoint(1920, 0));
+    QCOMPARE(output.scale(), 2);
+    QCOMPARE(output.transform(), KWayland::Client::Output::Transform::Rotated90);
+    QCOMPARE(output.pixelSize(), QSize(1280, 1024));
+    QCOMPARE(output.refreshRate(), 90000);
+    QVERIFY(!outputChanged.wait(100));
+    QCOMPARE(outputChanged.count(), 1);
+}
+
+void TestWaylandOutput::testOutputLayoutUpdate()
+{
+    KWayland::Client::Registry registry;
+    QSignalSpy announced(&registry, SIGNAL(outputAnnounced(quint32,quint32)));
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    wl_display_flush(m_connection->display());
+    QVERIFY(announced.wait());
+
+    KWayland::Client::Output output;
+    QSignalSpy outputChanged(&output, SIGNAL(changed()));
+    QVERIFY(outputChanged.isValid());
+    output.setup(registry.bindOutput(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    wl_display_flush(m_connection->display());
+    QVERIFY(outputChanged.wait());
+
+    // the display wide update holds back the changes of all outputs
+    outputChanged.clear();
+    m_display->beginOutputLayoutUpdate();
+    m_serverOutput->setGlobalPosition(QPoint(0, 1080));
+    m_serverOutput->setScale(2);
+    QVERIFY(!outputChanged.wait(100));
+
+    m_display->commitOutputLayoutUpdate();
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.globalPosition(), QPoint(0, 1080));
+    QCOMPARE(output.scale(), 2);
+    QVERIFY(!outputChanged.wait(100));
+    QCOMPARE(outputChanged.count(), 1);
+}
+
 void TestWaylandOutput::testSubPixel_data()
 {
     using namespace KWayland::Client;
@@ -551,6 +627,57 @@ void TestWaylandOutput::testDpms()
     QCOMPARE(dpms->mode(), Dpms::Mode::Off);
 }
 
+void TestWaylandOutput::testDpmsMultipleResources()
+{
+    // this test verifies that all dpms objects of an output get the changes, also after one is gone
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    new DpmsManagerInterface(m_display);
+    m_serverOutput->setDpmsSupported(true);
+
+    KWayland::Client::Registry registry;
+    registry.setEventQueue(m_queue);
+    QSignalSpy announced(&registry, &Registry::interfacesAnnounced);
+    QVERIFY(announced.isValid());
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    m_connection->flush();
+    QVERIFY(announced.wait());
+
+    Output *output = registry.createOutput(registry.interface(Registry::Interface::Output).name, registry.interface(Registry::Interface::Output).version, &registry);
+    DpmsManager *dpmsManager = registry.createDpmsManager(registry.interface(Registry::Interface::Dpms).name, registry.interface(Registry::Interface::Dpms).version, &registry);
+    QVERIFY(dpmsManager->isValid());
+
+    Dpms *first = dpmsManager->getDpms(output, &registry);
+    Dpms *second = dpmsManager->getDpms(output, &registry);
+    QSignalSpy firstSupportedSpy(first, &Dpms::supportedChanged);
+    QVERIFY(firstSupportedSpy.isValid());
+    QSignalSpy secondSupportedSpy(second, &Dpms::supportedChanged);
+    QVERIFY(secondSupportedSpy.isValid());
+    m_connection->flush();
+    QVERIFY(secondSupportedSpy.wait());
+    QVERIFY(first->isSupported());
+    QVERIFY(second->isSupported());
+
+    QSignalSpy firstModeSpy(first, &Dpms::modeChanged);
+    QVERIFY(firstModeSpy.isValid());
+    QSignalSpy secondModeSpy(second, &Dpms::modeChanged);
+    QVERIFY(secondModeSpy.isValid());
+    m_serverOutput->setDpmsMode(OutputInterface::DpmsMode::Standby);
+    QVERIFY(secondModeSpy.wait());
+    QCOMPARE(firstModeSpy.count(), 1);
+    QCOMPARE(first->mode(), Dpms::Mode::Standby);
+    QCOMPARE(second->mode(), Dpms::Mode::Standby);
+
+    delete first;
+    m_connection->flush();
+    m_serverOutput->setDpmsMode(OutputInterface::DpmsMode::Off);
+    QVERIFY(secondModeSpy.wait());
+    QCOMPARE(second->mode(), Dpms::Mode::Off);
+}
+
 void TestWaylandOutput::testDpmsRequestMode_data()
 {
     using namespace KWayland::Client;
@@ -11,6 +11,7 @@
 #include "KWayland/Client/event_queue.h"
 #include "KWayland/Client/outputdevice.h"
 #include "KWayland/Client/registry.h"
+#include "../../src/server/clientconnection.h"
 #include "../../src/server/display.h"
 #include "../../src/server/outputdevice_interface.h"
 // Wayland
@@ -30,11 +31,14 @@ private Q_SLOTS:
 
     void testRegistry();
     void testModeChanges();
+    void testModeLookup();
 #if KWAYLANDSERVER_ENABLE_DEPRECATED_SINCE(5, 50)
     void testScaleChange_legacy();
 #endif
     void testScaleChange();
+    void testManufacturerChange();
     void testColorCurvesChange();
+    void testColorCurvesCoalescing();
 
     void testSubPixel_data();
     void testSubPixel();
@@ -241,6 +245,10 @@ void TestWaylandOutputDevice::testRegistry()
     QCOMPARE(output.uuid(), QByteArray("1337"));
     QCOMPARE(output.serialNumber(), m_serialNumber);
     QCOMPARE(output.eisaId(), m_eidaId);
+
+    QCOMPARE(m_display->connections().count(), 1);
+    ClientConnection *client = m_display->connections().first();
+    QCOMPARE(m_serverOutputDevice->clientResources(client).count(), 1);
 }
 
 void TestWaylandOutputDevice::testModeChanges()
@@ -340,6 +348,29 @@ void TestWaylandOutputDevice::testModeChanges()
     QCOMPARE(output.pixelSize(), QSize(1280, 1024));
 }
 
+void TestWaylandOutputDevice::testModeLookup()
+{
+    using namespace KWaylandServer;
+    QCOMPARE(m_serverOutputDevice->currentModeId(), 1);
+    QVERIFY(!m_serverOutputDevice->setCurrentMode(QSize(1280, 1024), 60000));
+    QCOMPARE(m_serverOutputDevice->currentModeId(), 1);
+    QVERIFY(m_serverOutputDevice->setCurrentMode(QSize(1280, 1024), 90000));
+    QCOMPARE(m_serverOutputDevice->currentModeId(), 2);
+    QCOMPARE(m_serverOutputDevice->pixelSize(), QSize(1280, 1024));
+    QCOMPARE(m_serverOutputDevice->refreshRate(), 90000);
+
+    // exactly one mode is current and one preferred
+    const auto modes = m_serverOutputDevice->modes();
+    QCOMPARE(int(std::count_if(modes.begin(), modes.end(), [](const OutputDeviceInterface::Mode &mode) {
+        return mode.flags.testFlag(OutputDeviceInterface::ModeFlag::Current);
+    })), 1);
+    QCOMPARE(int(std::count_if(modes.begin(), modes.end(), [](const OutputDeviceInterface::Mode &mode) {
+        return mode.flags.testFlag(OutputDeviceInterface::ModeFlag::Preferred);
+    })), 1);
+    QVERIFY(modes.at(2).flags.testFlag(OutputDeviceInterface::ModeFlag::Current));
+    QVERIFY(modes.at(0).flags.testFlag(OutputDeviceInterface::ModeFlag::Preferred));
+}
+
 #if KWAYLANDSERVER_ENABLE_DEPRECATED_SINCE(5, 50)
 void TestWaylandOutputDevice::testScaleChange_legacy()
 {
@@ -420,6 +451,39 @@ void TestWaylandOutputDevice::testScaleChange()
     QCOMPARE(wl_fixed_from_double(output.scaleF()), wl_fixed_from_double(4.9));
 }
 
+void TestWaylandOutputDevice::testManufacturerChange()
+{
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    QSignalSpy announced(&registry, &KWayland::Client::Registry::outputDeviceAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    wl_display_flush(m_connection->display());
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    KWayland::Client::OutputDevice output;
+    QSignalSpy outputChanged(&output, &KWayland::Client::OutputDevice::done);
+    QVERIFY(outputChanged.isValid());
+    output.setup(registry.bindOutputDevice(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    wl_display_flush(m_connection->display());
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.manufacturer(), QStringLiteral("org.kde.kwin"));
+
+    // the strings are sent as UTF-8
+    outputChanged.clear();
+    m_serverOutputDevice->setManufacturer(QStringLiteral("Ünïcödé Displäys"));
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.manufacturer(), QStringLiteral("Ünïcödé Displäys"));
+
+    outputChanged.clear();
+    m_serverOutputDevice->setModel(QStringLiteral("Modèle ✓"));
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.model(), QStringLiteral("Modèle ✓"));
+}
+
 void TestWaylandOutputDevice::testColorCurvesChange()
 {
     KWayland::Client::Registry registry;
@@ -467,6 +531,65 @@ void TestWaylandOutputDevice::testColorCurvesChange()
     QCOMPARE(output.colorCurves().blue, cc.blue);
 }
 
+void TestWaylandOutputDevice::testColorCurvesCoalescing()
+{
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QVERIFY(interfacesAnnouncedSpy.isValid());
+    QSignalSpy announced(&registry, &KWayland::Client::Registry::outputDeviceAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    wl_display_flush(m_connection->display());
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    KWayland::Client::OutputDevice output;
+    QSignalSpy outputChanged(&output, &KWayland::Client::OutputDevice::done);
+    QVERIFY(outputChanged.isValid());
+    output.setup(registry.bindOutputDevice(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    wl_display_flush(m_connection->display());
+    QVERIFY(outputChanged.wait());
+
+    QCOMPARE(m_serverOutputDevice->colorCurvesUpdateInterval(), 0);
+    m_serverOutputDevice->setColorCurvesUpdateInterval(200);
+    QCOMPARE(m_serverOutputDevice->colorCurvesUpdateInterval(), 200);
+    QSignalSpy serverChanged(m_serverOutputDevice, &KWaylandServer::OutputDeviceInterface::colorCurvesChanged);
+    QVERIFY(serverChanged.isValid());
+
+    // the first change is sent right away and opens the window
+    outputChanged.clear();
+    KWaylandServer::OutputDeviceInterface::ColorCurves cc;
+    cc.red = QVector<quint16>(256, 1);
+    cc.green = QVector<quint16>(256, 1);
+    cc.blue = QVector<quint16>(256, 1);
+    m_serverOutputDevice->setColorCurves(cc);
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(output.colorCurves().red, cc.red);
+
+    // the changes within the window only send the latest color curves
+    outputChanged.clear();
+    for (quint16 i = 2; i < 10; ++i) {
+        cc.red = QVector<quint16>(256, i);
+        m_serverOutputDevice->setColorCurves(cc);
+    }
+    QCOMPARE(serverChanged.count(), 9);
+    QCOMPARE(m_serverOutputDevice->colorCurves().red, cc.red);
+    QVERIFY(outputChanged.wait());
+    QCOMPARE(outputChanged.count(), 1);
+    QCOMPARE(output.colorCurves().red, cc.red);
+    QVERIFY(!outputChanged.wait(300));
+
+    // disabling the limit sends a coalesced change right away
+    cc.red = QVector<quint16>(256, 10);
+    m_serverOutputDevice->setColorCurves(cc);
+    cc.red = QVector<quint16>(256, 11);
+    m_serverOutputDevice->setColorCurves(cc);
+    m_serverOutputDevice->setColorCurvesUpdateInterval(0);
+    QCOMPARE(m_serverOutputDevice->colorCurvesUpdateInterval(), 0);
+    QTRY_COMPARE_WITH_TIMEOUT(output.colorCurves().red, cc.red, 100);
+}
+
 void TestWaylandOutputDevice::testSubPixel_data()
 {
     using namespace KWayland::Client;
@@ -39,6 +39,7 @@ private Q_SLOTS:
     void testBasicMemoryManagement();
     void testMultipleSettings();
     void testConfigFailed();
+    void testNoopConfig();
     void testApplied();
     void testFailed();
 
@@ -46,6 +47,8 @@ private Q_SLOTS:
     void testScale();
 
     void testRemoval();
+    void testQueuedConfigurations();
+    void testConfigurationTest();
 
 private:
     void createOutputDevices();
@@ -429,6 +432,53 @@ void TestWaylandOutputManagement::testMultipleSettings()
 
 }
 
+void TestWaylandOutputManagement::testNoopConfig()
+{
+    createConfig();
+    auto config = m_outputConfiguration;
+    QVERIFY(config->isValid());
+    KWayland::Client::OutputDevice *output = m_clientOutputs.first();
+
+    KWaylandServer::OutputConfigurationInterface *configurationInterface = nullptr;
+    connect(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested, this, [&configurationInterface](KWaylandServer::OutputConfigurationInterface *c) {
+        configurationInterface = c;
+    });
+    QSignalSpy serverApplySpy(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested);
+    QVERIFY(serverApplySpy.isValid());
+
+    // setting the current state changes nothing
+    config->setMode(output, 1);
+    config->setPosition(output, QPoint(0, 1920));
+    config->apply();
+    QVERIFY(serverApplySpy.wait(200));
+    QVERIFY(configurationInterface);
+    QCOMPARE(configurationInterface->changes().count(), 1);
+    OutputChangeSet *changeSet = configurationInterface->changes().value(m_serverOutputs.first());
+    QVERIFY(changeSet);
+    QVERIFY(changeSet->isNoop());
+    QCOMPARE(changeSet->changes(), OutputChangeSet::Changes());
+    QVERIFY(configurationInterface->isNoop());
+    QVERIFY(configurationInterface->effectiveChanges().isEmpty());
+
+    // only the properties set by the client are reported
+    config->setPosition(output, QPoint(13, 37));
+    config->apply();
+    QVERIFY(serverApplySpy.wait(200));
+    QCOMPARE(changeSet->changes(), OutputChangeSet::Changes(OutputChangeSet::Change::Position));
+    QVERIFY(changeSet->positionChanged());
+    QVERIFY(!changeSet->modeChanged());
+    QVERIFY(!changeSet->colorCurvesChanged());
+    QVERIFY(!changeSet->isNoop());
+    QVERIFY(!configurationInterface->isNoop());
+    QCOMPARE(configurationInterface->effectiveChanges().count(), 1);
+    QCOMPARE(configurationInterface->effectiveChanges().value(m_serverOutputs.first()), changeSet);
+
+    // the change set follows the state of the outputdevice
+    m_serverOutputs.first()->setGlobalPosition(QPoint(13, 37));
+    QVERIFY(changeSet->isNoop());
+    QVERIFY(configurationInterface->isNoop());
+}
+
 void TestWaylandOutputManagement::testConfigFailed()
 {
     createConfig();
@@ -527,5 +577,96 @@ void TestWaylandOutputManagement::testScale()
 }
 
 
+void TestWaylandOutputManagement::testQueuedConfigurations()
+{
+    QVERIFY(!m_outputManagementInterface->isConfigurationQueueingEnabled());
+    m_outputManagementInterface->setConfigurationQueueingEnabled(true);
+    QVERIFY(m_outputManagementInterface->isConfigurationQueueingEnabled());
+    KWayland::Client::OutputDevice *output = m_clientOutputs.first();
+
+    QSignalSpy requestedSpy(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested);
+    QVERIFY(requestedSpy.isValid());
+    QSignalSpy supersededSpy(m_outputManagementInterface, &OutputManagementInterface::configurationSuperseded);
+    QVERIFY(supersededSpy.isValid());
+
+    // e.g. a settings UI following a scale slider
+    QVector<OutputConfiguration *> configs;
+    for (int i = 0; i < 3; ++i) {
+        OutputConfiguration *config = m_outputManagement->createConfiguration();
+        QVERIFY(config->isValid());
+        config->setScaleF(output, 1.25 + i * 0.25);
+        configs << config;
+    }
+    QSignalSpy firstAppliedSpy(configs[0], &OutputConfiguration::applied);
+    QSignalSpy secondFailedSpy(configs[1], &OutputConfiguration::failed);
+    QSignalSpy lastAppliedSpy(configs[2], &OutputConfiguration::applied);
+
+    configs[0]->apply();
+    QVERIFY(requestedSpy.wait());
+    auto first = requestedSpy.first().first().value<OutputConfigurationInterface *>();
+    QCOMPARE(m_outputManagementInterface->inFlightConfiguration(), first);
+    QVERIFY(!m_outputManagementInterface->pendingConfiguration());
+
+    // the second one waits for the first one and is superseded by the third one
+    configs[1]->apply();
+    configs[2]->apply();
+    QVERIFY(supersededSpy.wait());
+    QVERIFY(secondFailedSpy.wait());
+    QCOMPARE(requestedSpy.count(), 1);
+    QCOMPARE(m_outputManagementInterface->inFlightConfiguration(), first);
+    OutputConfigurationInterface *last = m_outputManagementInterface->pendingConfiguration();
+    QVERIFY(last);
+    QVERIFY(last != first);
+    QCOMPARE(last->changes().count(), 1);
+    QCOMPARE(last->changes().first()->scaleF(), 1.75);
+
+    // finishing the first one hands over the last one
+    applyPendingChanges(first);
+    first->setApplied();
+    QCOMPARE(requestedSpy.count(), 2);
+    QCOMPARE(requestedSpy.last().first().value<OutputConfigurationInterface *>(), last);
+    QCOMPARE(m_outputManagementInterface->inFlightConfiguration(), last);
+    QVERIFY(!m_outputManagementInterface->pendingConfiguration());
+    QVERIFY(firstAppliedSpy.wait());
+
+    applyPendingChanges(last);
+    last->setApplied();
+    QVERIFY(!m_outputManagementInterface->inFlightConfiguration());
+    QVERIFY(lastAppliedSpy.wait());
+    QCOMPARE(output->scaleF(), 1.75);
+    QCOMPARE(secondFailedSpy.count(), 1);
+    qDeleteAll(configs);
+}
+
+void TestWaylandOutputManagement::testConfigurationTest()
+{
+    // a dry run which only allows integer scales
+    m_outputManagementInterface->setConfigurationTest([](OutputConfigurationInterface *config) {
+        const auto changes = config->changes();
+        return std::all_of(changes.constBegin(), changes.constEnd(), [](OutputChangeSet *changeSet) {
+            return !changeSet->scaleChanged() || qFuzzyCompare(changeSet->scaleF(), qRound(changeSet->scaleF()));
+        });
+    });
+    QSignalSpy requestedSpy(m_outputManagementInterface, &OutputManagementInterface::configurationChangeRequested);
+    QVERIFY(requestedSpy.isValid());
+    KWayland::Client::OutputDevice *output = m_clientOutputs.first();
+
+    createConfig();
+    QSignalSpy failedSpy(m_outputConfiguration, &OutputConfiguration::failed);
+    m_outputConfiguration->setScaleF(output, 1.5);
+    m_outputConfiguration->apply();
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(requestedSpy.count(), 0);
+
+    m_outputConfiguration->setScaleF(output, 2);
+    m_outputConfiguration->apply();
+    QVERIFY(requestedSpy.wait());
+    auto config = requestedSpy.first().first().value<OutputConfigurationInterface *>();
+    QVERIFY(m_outputManagementInterface->testConfiguration(config));
+
+    m_outputManagementInterface->setConfigurationTest(OutputManagementInterface::ConfigurationTest());
+    QVERIFY(m_outputManagementInterface->testConfiguration(config));
+}
+
 QTEST_GUILESS_MAIN(TestWaylandOutputManagement)
 #include "test_wayland_outputmanagement.moc"
@@ -60,21 +60,30 @@ private Q_SLOTS:
     void testPointerTransformation();
     void testPointerButton_data();
     void testPointerButton();
+    void testImplicitGrabOutlivesRecentSerials();
+    void testPointerMotionCoalescing();
+    void testProcessInputFrame();
     void testPointerSubSurfaceTree();
+    void testPointerFocusWithinClient();
     void testPointerSwipeGesture_data();
     void testPointerSwipeGesture();
     void testPointerPinchGesture_data();
     void testPointerPinchGesture();
     void testPointerAxis();
+    void testPointerAxes();
     void testKeyboardSubSurfaceTreeFromPointer();
     void testCursor();
     void testCursorDamage();
+    void testCursorImageKey();
     void testKeyboard();
+    void testServerSideKeyRepeat();
     void testCast();
     void testDestroy();
     void testSelection();
     void testDataDeviceForKeyboardSurface();
     void testTouch();
+    void testTouchMoveBatch();
+    void testTouchSequenceScale();
     void testDisconnect();
     void testKeymap();
 
@@ -768,11 +777,22 @@ void TestWaylandSeat::testPointerButton()
     QCOMPARE(buttonChangedSpy.last().at(1).value<quint32>(), msec);
     QCOMPARE(buttonChangedSpy.last().at(2).value<quint32>(), waylandButton);
     QCOMPARE(buttonChangedSpy.last().at(3).value<KWayland::Client::Pointer::ButtonState>(), Pointer::ButtonState::Pressed);
+    const quint32 pressSerial = m_seatInterface->pointerButtonSerial(waylandButton);
+    QVERIFY(m_seatInterface->hasImplicitPointerGrab(pressSerial));
+    QVERIFY(m_seatInterface->hasImplicitGrab(pressSerial, serverSurface));
+    QVERIFY(!m_seatInterface->hasImplicitGrab(pressSerial, nullptr));
+    QVERIFY(m_seatInterface->isInputSerial(pressSerial, serverSurface));
     msec = QDateTime::currentMSecsSinceEpoch();
     m_seatInterface->setTimestamp(QDateTime::currentMSecsSinceEpoch());
     m_seatInterface->pointerButtonReleased(qtButton);
     QCOMPARE(m_seatInterface->isPointerButtonPressed(waylandButton), false);
     QCOMPARE(m_seatInterface->isPointerButtonPressed(qtButton), false);
+    QVERIFY(!m_seatInterface->hasImplicitPointerGrab(pressSerial));
+    QVERIFY(!m_seatInterface->hasImplicitPointerGrab(m_seatInterface->pointerButtonSerial(waylandButton)));
+    QVERIFY(!m_seatInterface->hasImplicitGrab(pressSerial, serverSurface));
+    // the press is still a recent user action
+    QVERIFY(m_seatInterface->isInputSerial(pressSerial, serverSurface));
+    QVERIFY(!m_seatInterface->isInputSerial(m_seatInterface->pointerButtonSerial(waylandButton), serverSurface));
     QVERIFY(buttonChangedSpy.wait());
     QCOMPARE(buttonChangedSpy.count(), 2);
     QCOMPARE(buttonChangedSpy.last().at(0).value<quint32>(), m_seatInterface->pointerButtonSerial(waylandButton));
@@ -780,6 +800,216 @@ void TestWaylandSeat::testPointerButton()
     QCOMPARE(buttonChangedSpy.last().at(1).value<quint32>(), msec);
     QCOMPARE(buttonChangedSpy.last().at(2).value<quint32>(), waylandButton);
     QCOMPARE(buttonChangedSpy.last().at(3).value<KWayland::Client::Pointer::ButtonState>(), Pointer::ButtonState::Released);
+
+    // only the recent serials are known
+    for (int i = 0; i < 64; ++i) {
+        m_seatInterface->pointerButtonPressed(qtButton);
+        m_seatInterface->pointerButtonReleased(qtButton);
+    }
+    QVERIFY(!m_seatInterface->isInputSerial(pressSerial, serverSurface));
+}
+
+void TestWaylandSeat::testImplicitGrabOutlivesRecentSerials()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, SIGNAL(hasPointerChanged(bool)));
+    QVERIFY(pointerSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, SIGNAL(surfaceCreated(KWaylandServer::SurfaceInterface*)));
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    wl_display_flush(m_connection->display());
+    QCoreApplication::processEvents();
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    QVERIFY(m_seatInterface->focusedPointer());
+
+    m_seatInterface->pointerButtonPressed(Qt::LeftButton);
+    const quint32 pressSerial = m_seatInterface->pointerButtonSerial(Qt::LeftButton);
+    QVERIFY(m_seatInterface->hasImplicitPointerGrab(pressSerial));
+
+    // other presses and the serials used by the rest of the display push it out of the recent ones
+    int otherSerials = 0;
+    while (m_seatInterface->isInputSerial(pressSerial, serverSurface)) {
+        QVERIFY(otherSerials < 1000);
+        m_display->nextSerial();
+        m_seatInterface->pointerButtonPressed(Qt::RightButton);
+        m_seatInterface->pointerButtonReleased(Qt::RightButton);
+        otherSerials += 3;
+    }
+    QVERIFY(otherSerials > 64);
+
+    // the button is still held, so is its grab
+    QVERIFY(m_seatInterface->hasImplicitPointerGrab(pressSerial));
+    QVERIFY(m_seatInterface->hasImplicitGrab(pressSerial, serverSurface));
+    QVERIFY(!m_seatInterface->hasImplicitTouchGrab(pressSerial));
+
+    m_seatInterface->pointerButtonReleased(Qt::LeftButton);
+    QVERIFY(!m_seatInterface->hasImplicitPointerGrab(pressSerial));
+    QVERIFY(!m_seatInterface->hasImplicitGrab(pressSerial, serverSurface));
+}
+
+void TestWaylandSeat::testPointerMotionCoalescing()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(pointerSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    QSignalSpy enteredSpy(p.data(), &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy motionSpy(p.data(), &Pointer::motion);
+    QVERIFY(motionSpy.isValid());
+    QSignalSpy buttonChangedSpy(p.data(), &Pointer::buttonStateChanged);
+    QVERIFY(buttonChangedSpy.isValid());
+    QVector<QByteArray> events;
+    connect(p.data(), &Pointer::motion, this, [&events] { events << QByteArrayLiteral("motion"); });
+    connect(p.data(), &Pointer::buttonStateChanged, this, [&events] { events << QByteArrayLiteral("button"); });
+    wl_display_flush(m_connection->display());
+    QCoreApplication::processEvents();
+
+    QVERIFY(!m_seatInterface->isPointerMotionCoalescingEnabled());
+    m_seatInterface->setPointerMotionCoalescingEnabled(true);
+    QVERIFY(m_seatInterface->isPointerMotionCoalescingEnabled());
+    m_seatInterface->setPointerPos(QPoint(20, 18));
+    m_seatInterface->setFocusedPointerSurface(serverSurface, QPoint(10, 15));
+    QVERIFY(enteredSpy.wait());
+
+    // the motions until the button press get merged into one
+    const quint64 sentMotions = m_seatInterface->pointerMotionEventCount();
+    m_seatInterface->setPointerPos(QPoint(21, 18));
+    m_seatInterface->setPointerPos(QPoint(22, 19));
+    m_seatInterface->setPointerPos(QPoint(23, 20));
+    QCOMPARE(m_seatInterface->pointerMotionEventCount(), sentMotions);
+    QCOMPARE(m_seatInterface->coalescedPointerMotionEventCount(), 2u);
+    m_seatInterface->pointerButtonPressed(Qt::LeftButton);
+    QCOMPARE(m_seatInterface->pointerMotionEventCount(), sentMotions + 1);
+    QVERIFY(buttonChangedSpy.wait());
+    QCOMPARE(motionSpy.count(), 1);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(13, 5));
+    QCOMPARE(events, QVector<QByteArray>({QByteArrayLiteral("motion"), QByteArrayLiteral("button")}));
+
+    // a pending motion is sent when the display flushes its clients
+    m_seatInterface->setPointerPos(QPoint(24, 21));
+    QVERIFY(motionSpy.wait());
+    QCOMPARE(motionSpy.count(), 2);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(14, 6));
+    QCOMPARE(m_seatInterface->coalescedPointerMotionEventCount(), 2u);
+
+    m_seatInterface->pointerButtonReleased(Qt::LeftButton);
+    m_seatInterface->setPointerMotionCoalescingEnabled(false);
+}
+
+void TestWaylandSeat::testProcessInputFrame()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(pointerSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    QSignalSpy enteredSpy(p.data(), &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy motionSpy(p.data(), &Pointer::motion);
+    QVERIFY(motionSpy.isValid());
+    QSignalSpy frameSpy(p.data(), &Pointer::frame);
+    QVERIFY(frameSpy.isValid());
+    QVector<QByteArray> events;
+    connect(p.data(), &Pointer::motion, this, [&events] { events << QByteArrayLiteral("motion"); });
+    connect(p.data(), &Pointer::buttonStateChanged, this, [&events] { events << QByteArrayLiteral("button"); });
+    connect(p.data(), &Pointer::axisChanged, this, [&events] { events << QByteArrayLiteral("axis"); });
+    connect(p.data(), &Pointer::frame, this, [&events] { events << QByteArrayLiteral("frame"); });
+    wl_display_flush(m_connection->display());
+    QCoreApplication::processEvents();
+
+    m_seatInterface->setPointerPos(QPoint(20, 18));
+    m_seatInterface->setFocusedPointerSurface(serverSurface, QPoint(10, 15));
+    QVERIFY(enteredSpy.wait());
+    frameSpy.clear();
+    events.clear();
+
+    auto makeEvent = [](InputEvent::Type type, quint32 time) {
+        InputEvent event;
+        event.type = type;
+        event.time = time;
+        return event;
+    };
+    QVector<InputEvent> frame;
+    InputEvent motion = makeEvent(InputEvent::Type::PointerMotion, 10);
+    motion.position = QPointF(21, 18);
+    frame << motion;
+    motion.position = QPointF(23, 20);
+    frame << motion;
+    InputEvent button = makeEvent(InputEvent::Type::PointerButtonPressed, 11);
+    button.code = BTN_LEFT;
+    frame << button;
+    InputEvent axis = makeEvent(InputEvent::Type::PointerAxis, 12);
+    axis.delta = 10;
+    axis.axisSource = PointerAxisSource::Wheel;
+    frame << axis;
+    axis.orientation = Qt::Horizontal;
+    frame << axis;
+
+    // the motions are merged and all events form one frame
+    const quint64 sentMotions = m_seatInterface->pointerMotionEventCount();
+    QVERIFY(m_seatInterface->processInputFrame(frame).isEmpty());
+    QCOMPARE(m_seatInterface->pointerMotionEventCount(), sentMotions + 1);
+    QCOMPARE(m_seatInterface->timestamp(), 12u);
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 1);
+    QCOMPARE(motionSpy.count(), 1);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(13, 5));
+    QCOMPARE(events, QVector<QByteArray>({QByteArrayLiteral("motion"), QByteArrayLiteral("button"),
+                                          QByteArrayLiteral("axis"), QByteArrayLiteral("axis"),
+                                          QByteArrayLiteral("frame")}));
+    QVERIFY(m_seatInterface->isPointerButtonPressed(BTN_LEFT));
+
+    // a motion at the end of the frame is sent before the frame event
+    events.clear();
+    frame.clear();
+    button.type = InputEvent::Type::PointerButtonReleased;
+    frame << button;
+    motion.position = QPointF(24, 21);
+    frame << motion;
+    m_seatInterface->processInputFrame(frame);
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 2);
+    QCOMPARE(motionSpy.last().first().toPointF(), QPointF(14, 6));
+    QCOMPARE(events, QVector<QByteArray>({QByteArrayLiteral("button"), QByteArrayLiteral("motion"),
+                                          QByteArrayLiteral("frame")}));
+    QVERIFY(!m_seatInterface->isPointerButtonPressed(BTN_LEFT));
 }
 
 void TestWaylandSeat::testPointerSubSurfaceTree()
@@ -880,6 +1110,76 @@ void TestWaylandSeat::testPointerSubSurfaceTree()
     QCOMPARE(pointer->enteredSurface(), parentSurface.data());
 }
 
+void TestWaylandSeat::testPointerFocusWithinClient()
+{
+    // this test verifies that moving the pointer focus between surfaces of one client sends leave, enter and frame
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy hasPointerChangedSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(hasPointerChangedSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(hasPointerChangedSpy.wait());
+    QScopedPointer<Pointer> pointer(m_seat->createPointer());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s1(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface1 = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> s2(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface2 = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+
+    QSignalSpy enteredSpy(pointer.data(), &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy leftSpy(pointer.data(), &Pointer::left);
+    QVERIFY(leftSpy.isValid());
+    QSignalSpy frameSpy(pointer.data(), &Pointer::frame);
+    QVERIFY(frameSpy.isValid());
+
+    m_seatInterface->setPointerPos(QPointF(20, 20));
+    m_seatInterface->setFocusedPointerSurface(serverSurface1, QPointF(10, 10));
+    QVERIFY(enteredSpy.wait());
+    QCOMPARE(pointer->enteredSurface(), s1.data());
+    PointerInterface *serverPointer = m_seatInterface->focusedPointer();
+    QVERIFY(serverPointer);
+    QCOMPARE(frameSpy.count(), 1);
+
+    // the focused pointer stays the same
+    QSignalSpy focusedPointerChangedSpy(m_seatInterface, &SeatInterface::focusedPointerChanged);
+    QVERIFY(focusedPointerChangedSpy.isValid());
+    m_seatInterface->setFocusedPointerSurface(serverSurface2, QPointF(5, 5));
+    QCOMPARE(m_seatInterface->focusedPointerSurface(), serverSurface2);
+    QCOMPARE(m_seatInterface->focusedPointer(), serverPointer);
+    QCOMPARE(m_seatInterface->focusedPointerSurfacePosition(), QPointF(5, 5));
+    QVERIFY(focusedPointerChangedSpy.isEmpty());
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(leftSpy.count(), 1);
+    QCOMPARE(enteredSpy.count(), 2);
+    QCOMPARE(frameSpy.count(), 2);
+    QCOMPARE(enteredSpy.last().first().value<quint32>(), m_display->serial());
+    QCOMPARE(enteredSpy.last().last().toPointF(), QPointF(15, 15));
+    QCOMPARE(pointer->enteredSurface(), s2.data());
+
+    // destroying the previous surface doesn't reset the focus
+    QSignalSpy destroyedSpy(serverSurface1, &QObject::destroyed);
+    QVERIFY(destroyedSpy.isValid());
+    s1.reset();
+    QVERIFY(destroyedSpy.wait());
+    QCOMPARE(m_seatInterface->focusedPointerSurface(), serverSurface2);
+    QCOMPARE(m_seatInterface->focusedPointer(), serverPointer);
+
+    // but destroying the focused one does
+    QSignalSpy destroyed2Spy(serverSurface2, &QObject::destroyed);
+    QVERIFY(destroyed2Spy.isValid());
+    s2.reset();
+    QVERIFY(destroyed2Spy.wait());
+    QVERIFY(!m_seatInterface->focusedPointerSurface());
+    QCOMPARE(focusedPointerChangedSpy.count(), 1);
+    QVERIFY(!m_seatInterface->focusedPointer());
+}
+
 void TestWaylandSeat::testPointerSwipeGesture_data()
 {
     QTest::addColumn<bool>("cancel");
@@ -1213,6 +1513,102 @@ void TestWaylandSeat::testPointerAxis()
     QCOMPARE(axisStoppedSpy.count(), 1);
 }
 
+void TestWaylandSeat::testPointerAxes()
+{
+    // this test verifies that the scroll on both axes shares one frame and is merged within input frames
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy hasPointerChangedSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(hasPointerChangedSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(hasPointerChangedSpy.wait());
+    QScopedPointer<Pointer> pointer(m_seat->createPointer());
+    QVERIFY(pointer);
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    QSignalSpy frameSpy(pointer.data(), &Pointer::frame);
+    QVERIFY(frameSpy.isValid());
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 1);
+
+    QSignalSpy axisSourceSpy(pointer.data(), &Pointer::axisSourceChanged);
+    QVERIFY(axisSourceSpy.isValid());
+    QSignalSpy axisSpy(pointer.data(), &Pointer::axisChanged);
+    QVERIFY(axisSpy.isValid());
+    QSignalSpy axisDiscreteSpy(pointer.data(), &Pointer::axisDiscreteChanged);
+    QVERIFY(axisDiscreteSpy.isValid());
+    QSignalSpy axisStoppedSpy(pointer.data(), &Pointer::axisStopped);
+    QVERIFY(axisStoppedSpy.isValid());
+
+    // a diagonal scroll
+    m_seatInterface->setTimestamp(1);
+    m_seatInterface->pointerAxisV5(QPointF(3, 4), QPoint(), PointerAxisSource::Finger);
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 2);
+    QCOMPARE(axisSourceSpy.count(), 1);
+    QCOMPARE(axisSourceSpy.last().at(0).value<Pointer::AxisSource>(), Pointer::AxisSource::Finger);
+    QCOMPARE(axisDiscreteSpy.count(), 0);
+    QCOMPARE(axisSpy.count(), 2);
+    QCOMPARE(axisSpy.at(0).at(1).value<Pointer::Axis>(), Pointer::Axis::Vertical);
+    QCOMPARE(axisSpy.at(0).at(2).value<qreal>(), 4.0);
+    QCOMPARE(axisSpy.at(1).at(1).value<Pointer::Axis>(), Pointer::Axis::Horizontal);
+    QCOMPARE(axisSpy.at(1).at(2).value<qreal>(), 3.0);
+
+    // lifting the fingers stops both axes
+    m_seatInterface->setTimestamp(2);
+    m_seatInterface->pointerAxisV5(QPointF(), QPoint(), PointerAxisSource::Finger);
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 3);
+    QCOMPARE(axisSpy.count(), 2);
+    QCOMPARE(axisStoppedSpy.count(), 2);
+
+    // the wheel clicks of one input frame are summed up
+    auto makeAxis = [](Qt::Orientation orientation, qreal delta, qint32 discreteDelta, quint32 time) {
+        InputEvent event;
+        event.type = InputEvent::Type::PointerAxis;
+        event.time = time;
+        event.orientation = orientation;
+        event.delta = delta;
+        event.discreteDelta = discreteDelta;
+        event.axisSource = PointerAxisSource::Wheel;
+        return event;
+    };
+    m_seatInterface->processInputFrame({makeAxis(Qt::Vertical, 10, 1, 3), makeAxis(Qt::Horizontal, 10, 1, 4),
+                                        makeAxis(Qt::Vertical, 10, 1, 5)});
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 4);
+    QCOMPARE(axisSourceSpy.count(), 3);
+    QCOMPARE(axisSourceSpy.last().at(0).value<Pointer::AxisSource>(), Pointer::AxisSource::Wheel);
+    QCOMPARE(axisSpy.count(), 4);
+    QCOMPARE(axisSpy.at(2).at(0).value<quint32>(), 5u);
+    QCOMPARE(axisSpy.at(2).at(1).value<Pointer::Axis>(), Pointer::Axis::Vertical);
+    QCOMPARE(axisSpy.at(2).at(2).value<qreal>(), 20.0);
+    QCOMPARE(axisSpy.at(3).at(1).value<Pointer::Axis>(), Pointer::Axis::Horizontal);
+    QCOMPARE(axisSpy.at(3).at(2).value<qreal>(), 10.0);
+    QCOMPARE(axisDiscreteSpy.count(), 2);
+    QCOMPARE(axisDiscreteSpy.at(0).at(1).value<qint32>(), 2);
+    QCOMPARE(axisDiscreteSpy.at(1).at(1).value<qint32>(), 1);
+
+    // scroll which cancels out within an input frame is dropped, it doesn't stop the axes
+    m_seatInterface->processInputFrame({makeAxis(Qt::Vertical, 10, 1, 6), makeAxis(Qt::Vertical, -10, -1, 7)});
+    m_seatInterface->setTimestamp(8);
+    m_seatInterface->pointerAxisV5(QPointF(0, 5), QPoint(), PointerAxisSource::Finger);
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 5);
+    QCOMPARE(axisSpy.count(), 5);
+    QCOMPARE(axisSpy.last().at(0).value<quint32>(), 8u);
+    QCOMPARE(axisSpy.last().at(2).value<qreal>(), 5.0);
+    QCOMPARE(axisStoppedSpy.count(), 2);
+    QCOMPARE(axisDiscreteSpy.count(), 2);
+}
+
 void TestWaylandSeat::testKeyboardSubSurfaceTreeFromPointer()
 {
     // this test verifies that when clicking on a sub-surface the keyboard focus passes to it
@@ -1479,6 +1875,86 @@ void TestWaylandSeat::testCursorDamage()
     QCOMPARE(pointer->cursor()->surface()->buffer()->data(), blue);
 }
 
+void TestWaylandSeat::testCursorImageKey()
+{
+    // this test verifies that identical cursor images have the same key and committing the same image doesn't change the cursor
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy pointerSpy(m_seat, &Seat::hasPointerChanged);
+    QVERIFY(pointerSpy.isValid());
+    m_seatInterface->setHasPointer(true);
+    QVERIFY(pointerSpy.wait());
+
+    QScopedPointer<Pointer> p(m_seat->createPointer());
+    QVERIFY(p->isValid());
+    QSignalSpy enteredSpy(p.data(), &Pointer::entered);
+    QVERIFY(enteredSpy.isValid());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    m_compositor->createSurface(m_compositor);
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<KWaylandServer::SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    m_seatInterface->setFocusedPointerSurface(serverSurface);
+    QVERIFY(enteredSpy.wait());
+
+    auto pointer = m_seatInterface->focusedPointer();
+    QSignalSpy cursorChangedSpy(pointer, &PointerInterface::cursorChanged);
+    QVERIFY(cursorChangedSpy.isValid());
+
+    // a cursor without a buffer has no key
+    Surface *cursorSurface = m_compositor->createSurface(m_compositor);
+    QVERIFY(cursorSurface);
+    p->setCursor(cursorSurface, QPoint(0, 0));
+    QVERIFY(cursorChangedSpy.wait());
+    auto cursor = pointer->cursor();
+    QVERIFY(cursor);
+    QCOMPARE(cursor->imageKey(), quint64(0));
+    QVERIFY(cursor->shape().isEmpty());
+
+    QImage red(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    red.fill(Qt::red);
+    cursorSurface->attachBuffer(m_shm->createBuffer(red));
+    cursorSurface->damage(QRect(0, 0, 10, 10));
+    cursorSurface->commit(Surface::CommitFlag::None);
+    QVERIFY(cursorChangedSpy.wait());
+    QCOMPARE(cursorChangedSpy.count(), 2);
+    const quint64 redKey = cursor->imageKey();
+    QVERIFY(redKey != 0);
+
+    // committing an identical image in a new buffer keeps the cursor
+    QSignalSpy committedSpy(cursor->surface().data(), &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+    cursorSurface->attachBuffer(m_shm->createBuffer(red));
+    cursorSurface->damage(QRect(0, 0, 10, 10));
+    cursorSurface->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(cursorChangedSpy.count(), 2);
+    QCOMPARE(cursor->imageKey(), redKey);
+
+    // a different image changes the key
+    QImage blue(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    blue.fill(Qt::blue);
+    cursorSurface->attachBuffer(m_shm->createBuffer(blue));
+    cursorSurface->damage(QRect(0, 0, 10, 10));
+    cursorSurface->commit(Surface::CommitFlag::None);
+    QVERIFY(cursorChangedSpy.wait());
+    QCOMPARE(cursorChangedSpy.count(), 3);
+    QVERIFY(cursor->imageKey() != redKey);
+    QVERIFY(cursor->imageKey() != 0);
+
+    // another surface with the red image has the same key as the first one
+    Surface *otherCursorSurface = m_compositor->createSurface(m_compositor);
+    QVERIFY(otherCursorSurface);
+    otherCursorSurface->attachBuffer(m_shm->createBuffer(red));
+    otherCursorSurface->damage(QRect(0, 0, 10, 10));
+    otherCursorSurface->commit(Surface::CommitFlag::None);
+    p->setCursor(otherCursorSurface, QPoint(0, 0));
+    QVERIFY(cursorChangedSpy.wait());
+    QCOMPARE(cursor->imageKey(), redKey);
+}
+
 void TestWaylandSeat::testKeyboard()
 {
     using namespace KWayland::Client;
@@ -1665,6 +2141,116 @@ void TestWaylandSeat::testKeyboard()
     QCOMPARE(m_seatInterface->keyboard(), serverKeyboard);
 }
 
+void TestWaylandSeat::testServerSideKeyRepeat()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy keyboardSpy(m_seat, &Seat::hasKeyboardChanged);
+    QVERIFY(keyboardSpy.isValid());
+    m_seatInterface->setHasKeyboard(true);
+    QVERIFY(keyboardSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    QSignalSpy keyboardCreatedSpy(m_seatInterface, &SeatInterface::keyboardCreated);
+    QVERIFY(keyboardCreatedSpy.isValid());
+    QScopedPointer<Keyboard> keyboard(m_seat->createKeyboard());
+    QSignalSpy repeatInfoSpy(keyboard.data(), &Keyboard::keyRepeatChanged);
+    QVERIFY(repeatInfoSpy.isValid());
+    QVERIFY(keyboardCreatedSpy.wait());
+    QVERIFY(repeatInfoSpy.wait());
+
+    KeyboardInterface *serverKeyboard = m_seatInterface->keyboard();
+    QVERIFY(!serverKeyboard->hasServerSideKeyRepeat(serverSurface->client()));
+    serverKeyboard->setRepeatInfo(50, 100);
+    QVERIFY(repeatInfoSpy.wait());
+    QCOMPARE(keyboard->isKeyRepeatEnabled(), true);
+
+    // the client is told to not repeat the keys itself
+    serverKeyboard->setServerSideKeyRepeat(serverSurface->client(), true);
+    QVERIFY(serverKeyboard->hasServerSideKeyRepeat(serverSurface->client()));
+    QVERIFY(repeatInfoSpy.wait());
+    QCOMPARE(keyboard->isKeyRepeatEnabled(), false);
+    QCOMPARE(keyboard->keyRepeatDelay(), 100);
+
+    m_seatInterface->setFocusedKeyboardSurface(serverSurface);
+    QSignalSpy keyChangedSpy(keyboard.data(), &Keyboard::keyChanged);
+    QVERIFY(keyChangedSpy.isValid());
+
+    // holding the key gets it repeated as release and press pairs
+    m_seatInterface->setTimestamp(1000);
+    serverKeyboard->keyPressed(KEY_A);
+    QVERIFY(keyChangedSpy.wait());
+    QTRY_VERIFY(keyChangedSpy.count() >= 5);
+    QCOMPARE(keyChangedSpy.at(0).at(1).value<Keyboard::KeyState>(), Keyboard::KeyState::Pressed);
+    QCOMPARE(keyChangedSpy.at(0).at(2).value<quint32>(), 1000u);
+    QCOMPARE(keyChangedSpy.at(1).at(0).value<quint32>(), quint32(KEY_A));
+    QCOMPARE(keyChangedSpy.at(1).at(1).value<Keyboard::KeyState>(), Keyboard::KeyState::Released);
+    QCOMPARE(keyChangedSpy.at(1).at(2).value<quint32>(), 1100u);
+    QCOMPARE(keyChangedSpy.at(2).at(0).value<quint32>(), quint32(KEY_A));
+    QCOMPARE(keyChangedSpy.at(2).at(1).value<Keyboard::KeyState>(), Keyboard::KeyState::Pressed);
+    QCOMPARE(keyChangedSpy.at(2).at(2).value<quint32>(), 1100u);
+    QCOMPARE(keyChangedSpy.at(3).at(2).value<quint32>(), 1120u);
+    QCOMPARE(keyChangedSpy.at(4).at(2).value<quint32>(), 1120u);
+
+    // releasing the key ends the repeat
+    serverKeyboard->keyReleased(KEY_A);
+    QVERIFY(keyChangedSpy.wait());
+    const int count = keyChangedSpy.count();
+    QCOMPARE(keyChangedSpy.last().at(1).value<Keyboard::KeyState>(), Keyboard::KeyState::Released);
+    QVERIFY(!keyChangedSpy.wait(200));
+    QCOMPARE(keyChangedSpy.count(), count);
+
+    // keys the keymap doesn't repeat, like modifiers, are only sent once
+    serverKeyboard->setKeymap(QByteArrayLiteral(
+        "xkb_keymap {\n"
+        "    xkb_keycodes \"test\" { minimum = 8; maximum = 255; <AC01> = 38; <LFSH> = 50; };\n"
+        "    xkb_types \"test\" { type \"ONE_LEVEL\" { modifiers = none; map[none] = Level1; level_name[Level1] = \"Any\"; }; };\n"
+        "    xkb_compat \"test\" { };\n"
+        "    xkb_symbols \"test\" {\n"
+        "        key <AC01> { [ a ] };\n"
+        "        key <LFSH> { repeat = No, [ Shift_L ] };\n"
+        "        modifier_map Shift { <LFSH> };\n"
+        "    };\n"
+        "};\n"));
+    serverKeyboard->keyPressed(KEY_LEFTSHIFT);
+    QVERIFY(keyChangedSpy.wait());
+    QCOMPARE(keyChangedSpy.count(), count + 1);
+    QVERIFY(!keyChangedSpy.wait(300));
+    QCOMPARE(keyChangedSpy.count(), count + 1);
+    serverKeyboard->keyReleased(KEY_LEFTSHIFT);
+    QVERIFY(keyChangedSpy.wait());
+    QCOMPARE(keyChangedSpy.count(), count + 2);
+
+    // while the keys the keymap repeats still are
+    serverKeyboard->keyPressed(KEY_A);
+    QTRY_VERIFY(keyChangedSpy.count() >= count + 5);
+    serverKeyboard->keyReleased(KEY_A);
+    QVERIFY(keyChangedSpy.wait());
+    const int repeatedCount = keyChangedSpy.count();
+    QVERIFY(!keyChangedSpy.wait(200));
+    QCOMPARE(keyChangedSpy.count(), repeatedCount);
+
+    // without server side key repeat the client gets the repeat rate again
+    serverKeyboard->setServerSideKeyRepeat(serverSurface->client(), false);
+    QVERIFY(repeatInfoSpy.wait());
+    QCOMPARE(keyboard->isKeyRepeatEnabled(), true);
+    QCOMPARE(keyboard->keyRepeatRate(), 50);
+    serverKeyboard->keyPressed(KEY_A);
+    QVERIFY(keyChangedSpy.wait());
+    QVERIFY(!keyChangedSpy.wait(200));
+    QCOMPARE(keyChangedSpy.count(), repeatedCount + 1);
+    serverKeyboard->keyReleased(KEY_A);
+    QVERIFY(keyChangedSpy.wait());
+    m_seatInterface->setFocusedKeyboardSurface(nullptr);
+}
+
 void TestWaylandSeat::testCast()
 {
     using namespace KWayland::Client;
@@ -2164,6 +2750,129 @@ void TestWaylandSeat::testTouch()
     QCOMPARE(m_seatInterface->focusedTouchSurface(), serverSurface);
 }
 
+void TestWaylandSeat::testTouchMoveBatch()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy touchSpy(m_seat, &Seat::hasTouchChanged);
+    QVERIFY(touchSpy.isValid());
+    m_seatInterface->setHasTouch(true);
+    QVERIFY(touchSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    m_seatInterface->setFocusedTouchSurface(serverSurface);
+
+    QSignalSpy touchCreatedSpy(m_seatInterface, &SeatInterface::touchCreated);
+    QVERIFY(touchCreatedSpy.isValid());
+    QScopedPointer<Touch> touch(m_seat->createTouch());
+    QVERIFY(touch->isValid());
+    QVERIFY(touchCreatedSpy.wait());
+
+    QSignalSpy frameEndedSpy(touch.data(), &Touch::frameEnded);
+    QVERIFY(frameEndedSpy.isValid());
+    QSignalSpy pointMovedSpy(touch.data(), &Touch::pointMoved);
+    QVERIFY(pointMovedSpy.isValid());
+
+    QCOMPARE(m_seatInterface->touchDown(QPointF(1, 1)), 0);
+    QCOMPARE(m_seatInterface->touchDown(QPointF(2, 2)), 1);
+    QCOMPARE(m_seatInterface->touchDown(QPointF(3, 3)), 2);
+    m_seatInterface->touchFrame();
+    QVERIFY(frameEndedSpy.wait());
+
+    // a point which goes up in between does not change the ids of the other points
+    m_seatInterface->touchUp(1);
+    QCOMPARE(m_seatInterface->touchDown(QPointF(4, 4)), 3);
+    m_seatInterface->touchFrame();
+    QVERIFY(frameEndedSpy.wait());
+    QCOMPARE(frameEndedSpy.count(), 2);
+
+    // all points move within one frame
+    m_seatInterface->touchMoveBatch({{0, QPointF(5, 5)}, {2, QPointF(6, 6)}, {3, QPointF(7, 7)}, {1, QPointF(8, 8)}});
+    QVERIFY(frameEndedSpy.wait());
+    QCOMPARE(frameEndedSpy.count(), 3);
+    QCOMPARE(pointMovedSpy.count(), 3);
+    QCOMPARE(pointMovedSpy.at(0).first().value<TouchPoint*>()->position(), QPointF(5, 5));
+    QCOMPARE(pointMovedSpy.at(1).first().value<TouchPoint*>()->position(), QPointF(6, 6));
+    QCOMPARE(pointMovedSpy.at(2).first().value<TouchPoint*>()->position(), QPointF(7, 7));
+
+    // further points are ignored once all touch point slots are in use
+    for (int i = 3; i < 16; ++i) {
+        QCOMPARE(m_seatInterface->touchDown(QPointF(1, 1)), i + 1);
+    }
+    QCOMPARE(m_seatInterface->touchDown(QPointF(1, 1)), -1);
+    m_seatInterface->cancelTouchSequence();
+    QVERIFY(!m_seatInterface->isTouchSequence());
+    QCOMPARE(m_seatInterface->touchDown(QPointF(1, 1)), 0);
+    m_seatInterface->cancelTouchSequence();
+}
+
+void TestWaylandSeat::testTouchSequenceScale()
+{
+    // this test verifies that the input area scale is taken once for a touch sequence
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy touchSpy(m_seat, &Seat::hasTouchChanged);
+    QVERIFY(touchSpy.isValid());
+    m_seatInterface->setHasTouch(true);
+    QVERIFY(touchSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    serverSurface->setInputAreaScale(2);
+    m_seatInterface->setFocusedTouchSurface(serverSurface, QPointF(10, 10));
+
+    QSignalSpy touchCreatedSpy(m_seatInterface, &SeatInterface::touchCreated);
+    QVERIFY(touchCreatedSpy.isValid());
+    QScopedPointer<Touch> touch(m_seat->createTouch());
+    QVERIFY(touch->isValid());
+    QVERIFY(touchCreatedSpy.wait());
+
+    QSignalSpy sequenceStartedSpy(touch.data(), &Touch::sequenceStarted);
+    QVERIFY(sequenceStartedSpy.isValid());
+    QSignalSpy pointMovedSpy(touch.data(), &Touch::pointMoved);
+    QVERIFY(pointMovedSpy.isValid());
+    QSignalSpy frameEndedSpy(touch.data(), &Touch::frameEnded);
+    QVERIFY(frameEndedSpy.isValid());
+
+    QCOMPARE(m_seatInterface->touchDown(QPointF(14, 14)), 0);
+    m_seatInterface->touchFrame();
+    QVERIFY(sequenceStartedSpy.wait());
+    QCOMPARE(sequenceStartedSpy.first().first().value<TouchPoint*>()->position(), QPointF(2, 2));
+
+    // changing the scale during the sequence doesn't affect it
+    serverSurface->setInputAreaScale(4);
+    m_seatInterface->touchMove(0, QPointF(18, 18));
+    m_seatInterface->touchFrame();
+    QVERIFY(pointMovedSpy.wait());
+    QCOMPARE(pointMovedSpy.last().first().value<TouchPoint*>()->position(), QPointF(4, 4));
+    QCOMPARE(m_seatInterface->touchDown(QPointF(12, 12)), 1);
+    m_seatInterface->touchMoveBatch({{1, QPointF(20, 20)}});
+    QVERIFY(frameEndedSpy.wait());
+    QCOMPARE(pointMovedSpy.last().first().value<TouchPoint*>()->position(), QPointF(5, 5));
+    m_seatInterface->touchUp(0);
+    m_seatInterface->touchUp(1);
+    m_seatInterface->touchFrame();
+    QVERIFY(frameEndedSpy.wait());
+
+    // the next sequence uses the new scale
+    QCOMPARE(m_seatInterface->touchDown(QPointF(18, 18)), 0);
+    m_seatInterface->touchFrame();
+    QVERIFY(sequenceStartedSpy.wait());
+    QCOMPARE(sequenceStartedSpy.last().first().value<TouchPoint*>()->position(), QPointF(2, 2));
+    m_seatInterface->cancelTouchSequence();
+}
+
 void TestWaylandSeat::testDisconnect()
 {
     // this test verifies that disconnecting the client cleans up correctly
@@ -2271,7 +2980,9 @@ void TestWaylandSeat::testKeymap()
     fd = keymapChangedSpy.first().first().toInt();
     QVERIFY(fd != -1);
     QCOMPARE(keymapChangedSpy.first().last().value<quint32>(), 3u);
-    QVERIFY(file.open(fd, QIODevice::ReadWrite));address = reinterpret_cast<char*>(file.map(0, keymapChangedSpy.first().last().value<quint32>()));
+    // the keymap is sealed and shared between all keyboards, it can only be mapped read-only
+    QVERIFY(file.open(fd, QIODevice::ReadOnly));
+    address = reinterpret_cast<char*>(file.map(0, keymapChangedSpy.first().last().value<quint32>()));
     QVERIFY(address);
     QCOMPARE(qstrcmp(address, "bar"), 0);
 }
@@ -9,6 +9,7 @@
 #include "KWayland/Client/compositor.h"
 #include "KWayland/Client/connection_thread.h"
 #include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/idleinhibit.h"
 #include "KWayland/Client/region.h"
 #include "KWayland/Client/registry.h"
 #include "KWayland/Client/shm_pool.h"
@@ -18,8 +19,12 @@
 #include "../../src/server/buffer_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/compositor_interface.h"
+#include "../../src/server/idleinhibit_v1_interface.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/outputdamageaggregator.h"
 #include "../../src/server/subcompositor_interface.h"
 #include "../../src/server/surface_interface.h"
+#include "../../src/server/surfaceocclusion.h"
 // Wayland
 #include <wayland-client.h>
 
@@ -43,22 +48,30 @@ private Q_SLOTS:
     void testDestroy();
     void testCast();
     void testSyncMode();
+    void testSyncModeScale();
+    void testSyncModeEmptyCommit();
     void testDeSyncMode();
+    void testTreeCommitted();
     void testMainSurfaceFromTree();
     void testRemoveSurface();
     void testMappingOfSurfaceTree();
     void testSurfaceAt();
+    void testOcclusion();
+    void testOutputDamage();
     void testDestroyAttachedBuffer();
     void testDestroyParentSurface();
+    void testIdleInhibitTree();
 
 private:
     KWaylandServer::Display *m_display;
     KWaylandServer::CompositorInterface *m_compositorInterface;
     KWaylandServer::SubCompositorInterface *m_subcompositorInterface;
+    KWaylandServer::IdleInhibitManagerV1Interface *m_idleInhibitInterface;
     KWayland::Client::ConnectionThread *m_connection;
     KWayland::Client::Compositor *m_compositor;
     KWayland::Client::ShmPool *m_shm;
     KWayland::Client::SubCompositor *m_subCompositor;
+    KWayland::Client::IdleInhibitManager *m_idleInhibitManager;
     KWayland::Client::EventQueue *m_queue;
     QThread *m_thread;
 };
@@ -70,10 +83,12 @@ TestSubSurface::TestSubSurface(QObject *parent)
     , m_display(nullptr)
     , m_compositorInterface(nullptr)
     , m_subcompositorInterface(nullptr)
+    , m_idleInhibitInterface(nullptr)
     , m_connection(nullptr)
     , m_compositor(nullptr)
     , m_shm(nullptr)
     , m_subCompositor(nullptr)
+    , m_idleInhibitManager(nullptr)
     , m_queue(nullptr)
     , m_thread(nullptr)
 {
@@ -111,6 +126,8 @@ void TestSubSurface::init()
     QVERIFY(compositorSpy.isValid());
     QSignalSpy subCompositorSpy(&registry, SIGNAL(subCompositorAnnounced(quint32,quint32)));
     QVERIFY(subCompositorSpy.isValid());
+    QSignalSpy idleInhibitSpy(&registry, SIGNAL(idleInhibitManagerUnstableV1Announced(quint32,quint32)));
+    QVERIFY(idleInhibitSpy.isValid());
     QVERIFY(!registry.eventQueue());
     registry.setEventQueue(m_queue);
     QCOMPARE(registry.eventQueue(), m_queue);
@@ -121,6 +138,7 @@ void TestSubSurface::init()
     m_compositorInterface = new CompositorInterface(m_display, m_display);
     m_subcompositorInterface = new SubCompositorInterface(m_display, m_display);
     QVERIFY(m_subcompositorInterface);
+    m_idleInhibitInterface = new IdleInhibitManagerV1Interface(m_display, m_display);
 
     QVERIFY(subCompositorSpy.wait());
     m_subCompositor = registry.createSubCompositor(subCompositorSpy.first().first().value<quint32>(), subCompositorSpy.first().last().value<quint32>(), this);
@@ -132,6 +150,12 @@ void TestSubSurface::init()
 
     m_shm = registry.createShmPool(registry.interface(KWayland::Client::Registry::Interface::Shm).name, registry.interface(KWayland::Client::Registry::Interface::Shm).version, this);
     QVERIFY(m_shm->isValid());
+
+    if (idleInhibitSpy.isEmpty()) {
+        QVERIFY(idleInhibitSpy.wait());
+    }
+    m_idleInhibitManager = registry.createIdleInhibitManager(idleInhibitSpy.first().first().value<quint32>(), idleInhibitSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_idleInhibitManager->isValid());
 }
 
 void TestSubSurface::cleanup()
@@ -140,6 +164,10 @@ void TestSubSurface::cleanup()
         delete m_shm;
         m_shm = nullptr;
     }
+    if (m_idleInhibitManager) {
+        delete m_idleInhibitManager;
+        m_idleInhibitManager = nullptr;
+    }
     if (m_subCompositor) {
         delete m_subCompositor;
         m_subCompositor = nullptr;
@@ -650,6 +678,90 @@ void TestSubSurface::testSyncMode()
     QVERIFY(frameRenderedSpy.wait());
 }
 
+void TestSubSurface::testSyncModeScale()
+{
+    // this test verifies that a buffer scale set through the cached state of a synchronized
+    // sub-surface is applied even if it matches a scale the sub-surface had before
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto childSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(childSurface);
+
+    QScopedPointer<Surface> parent(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto parentSurface = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QVERIFY(parentSurface);
+    QSignalSpy subSurfaceTreeChangedSpy(parentSurface, &SurfaceInterface::subSurfaceTreeChanged);
+    QVERIFY(subSurfaceTreeChangedSpy.isValid());
+    QScopedPointer<SubSurface> subSurface(m_subCompositor->createSubSurface(QPointer<Surface>(surface.data()), QPointer<Surface>(parent.data())));
+    QVERIFY(subSurfaceTreeChangedSpy.wait());
+
+    QSignalSpy parentCommittedSpy(parentSurface, &SurfaceInterface::committed);
+    QVERIFY(parentCommittedSpy.isValid());
+
+    surface->setScale(2);
+    surface->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(childSurface->bufferScale(), 2);
+
+    surface->setScale(1);
+    surface->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(childSurface->bufferScale(), 1);
+}
+
+void TestSubSurface::testSyncModeEmptyCommit()
+{
+    // this test verifies that caching the state of a synchronized sub-surface doesn't leave
+    // stale state behind for the next commit
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto childSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> parent(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto parentSurface = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QSignalSpy subSurfaceTreeChangedSpy(parentSurface, &SurfaceInterface::subSurfaceTreeChanged);
+    QScopedPointer<SubSurface> subSurface(m_subCompositor->createSubSurface(QPointer<Surface>(surface.data()), QPointer<Surface>(parent.data())));
+    QVERIFY(subSurfaceTreeChangedSpy.wait());
+
+    QSignalSpy childDamagedSpy(childSurface, &SurfaceInterface::damaged);
+    QSignalSpy parentCommittedSpy(parentSurface, &SurfaceInterface::committed);
+
+    QImage image(QSize(200, 200), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(QRect(0, 0, 200, 200));
+    surface->setScale(2);
+    surface->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(childDamagedSpy.count(), 1);
+    QCOMPARE(childSurface->bufferScale(), 2);
+    QCOMPARE(childSurface->size(), QSize(100, 100));
+
+    // nothing set since the last commit, nothing changes
+    surface->commit(Surface::CommitFlag::None);
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentCommittedSpy.wait());
+    QCOMPARE(childDamagedSpy.count(), 1);
+    QVERIFY(childSurface->buffer());
+    QCOMPARE(childSurface->buffer()->data(), image);
+    QCOMPARE(childSurface->bufferScale(), 2);
+    QCOMPARE(childSurface->size(), QSize(100, 100));
+}
+
 void TestSubSurface::testDeSyncMode()
 {
     // this test verifies that state gets applied immediately in desync mode
@@ -708,6 +820,62 @@ void TestSubSurface::testDeSyncMode()
     QCOMPARE(childSurface->buffer()->data(), image);
 }
 
+void TestSubSurface::testTreeCommitted()
+{
+    // this test verifies that a commit applies the whole tree before any signal is emitted
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QScopedPointer<Surface> surface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto childSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> parent(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto parentSurface = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QSignalSpy subSurfaceTreeChangedSpy(parentSurface, &SurfaceInterface::subSurfaceTreeChanged);
+    QScopedPointer<SubSurface> subSurface(m_subCompositor->createSubSurface(QPointer<Surface>(surface.data()), QPointer<Surface>(parent.data())));
+    QVERIFY(subSurfaceTreeChangedSpy.wait());
+
+    QSignalSpy treeCommittedSpy(parentSurface, &SurfaceInterface::treeCommitted);
+    QSignalSpy childTreeCommittedSpy(childSurface, &SurfaceInterface::treeCommitted);
+    QSignalSpy childCommittedSpy(childSurface, &SurfaceInterface::committed);
+
+    QImage image(QSize(200, 200), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::black);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(QRect(0, 0, 200, 200));
+    subSurface->setPosition(QPoint(10, 20));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(childCommittedSpy.wait());
+    QCOMPARE(treeCommittedSpy.count(), 0);
+
+    // the child is already updated when the parent announces its changes
+    bool childApplied = false;
+    connect(parentSurface, &SurfaceInterface::damaged, this, [&childApplied, childSurface, subSurface = subSurface.data()]() {
+        childApplied = childSurface->buffer() && subSurface->position() == QPoint(10, 20);
+    });
+    QImage image2(QSize(400, 400), QImage::Format_ARGB32_Premultiplied);
+    image2.fill(Qt::red);
+    parent->attachBuffer(m_shm->createBuffer(image2));
+    parent->damage(QRect(0, 0, 400, 400));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(treeCommittedSpy.wait());
+    QCOMPARE(treeCommittedSpy.count(), 1);
+    QVERIFY(childApplied);
+    QVERIFY(childSurface->buffer());
+
+    // a desynchronized sub-surface commits the tree of its main surface
+    subSurface->setMode(SubSurface::Mode::Desynchronized);
+    image.fill(Qt::blue);
+    surface->attachBuffer(m_shm->createBuffer(image));
+    surface->damage(QRect(0, 0, 200, 200));
+    surface->commit(Surface::CommitFlag::None);
+    QVERIFY(treeCommittedSpy.wait());
+    QCOMPARE(treeCommittedSpy.count(), 2);
+    QCOMPARE(childTreeCommittedSpy.count(), 0);
+    QCOMPARE(childSurface->buffer()->data(), image);
+}
 
 void TestSubSurface::testMainSurfaceFromTree()
 {
@@ -1022,6 +1190,219 @@ void TestSubSurface::testSurfaceAt()
     // outside the geometries should be no surface
     QVERIFY(!parentServerSurface->surfaceAt(QPointF(-1, -1)));
     QVERIFY(!parentServerSurface->surfaceAt(QPointF(101, 101)));
+
+    // the render list goes from bottom to top and skips the surfaces without a buffer
+    QVector<SurfaceRenderEntry> renderList = parentServerSurface->renderList();
+    QCOMPARE(renderList.count(), 3);
+    QCOMPARE(renderList[0].surface, parentServerSurface);
+    QCOMPARE(renderList[0].offset, QPoint(0, 0));
+    QCOMPARE(renderList[0].buffer, parentServerSurface->buffer());
+    QCOMPARE(renderList[1].surface, childFor1ServerSurface);
+    QCOMPARE(renderList[1].offset, QPoint(0, 0));
+    QCOMPARE(renderList[1].buffer, childFor1ServerSurface->buffer());
+    QCOMPARE(renderList[2].surface, childFor2ServerSurface);
+    QCOMPARE(renderList[2].offset, QPoint(50, 50));
+    QCOMPARE(renderList[2].buffer, childFor2ServerSurface->buffer());
+    QCOMPARE(directChild2ServerSurface->renderList().count(), 1);
+    QCOMPARE(directChild2ServerSurface->renderList().first().offset, QPoint(50, 50));
+
+    // a new buffer of a child updates the list, the opaque region follows the offset
+    childFor2->setOpaqueRegion(m_compositor->createRegion(QRegion(0, 0, 10, 10)).get());
+    childFor2->attachBuffer(m_shm->createBuffer(partImage));
+    childFor2->damage(QRect(0, 0, 50, 50));
+    childFor2->commit(Surface::CommitFlag::None);
+    QVERIFY(treeChangedSpy.wait());
+    renderList = parentServerSurface->renderList();
+    QCOMPARE(renderList.count(), 3);
+    QCOMPARE(renderList[2].buffer, childFor2ServerSurface->buffer());
+    QCOMPARE(renderList[2].opaque, QRegion(50, 50, 10, 10));
+
+    // moving a grand child has to update the picking
+    treeChangedSpy.clear();
+    childFor2SubSurface->setPosition(QPoint(0, 50));
+    directChild2->commit(Surface::CommitFlag::None);
+    QVERIFY(treeChangedSpy.wait());
+    QCOMPARE(parentServerSurface->surfaceAt(QPointF(25, 75)), childFor2ServerSurface);
+    QCOMPARE(parentServerSurface->surfaceAt(QPointF(75, 75)), parentServerSurface);
+    QCOMPARE(parentServerSurface->inputSurfaceAt(QPointF(10, 60)), childFor2ServerSurface);
+    QCOMPARE(parentServerSurface->inputSurfaceAt(QPointF(60, 60)), parentServerSurface);
+    QCOMPARE(parentServerSurface->renderList().last().offset, QPoint(0, 50));
+
+    // so does unmapping it
+    treeChangedSpy.clear();
+    childFor2->attachBuffer(Buffer::Ptr());
+    childFor2->commit(Surface::CommitFlag::None);
+    QVERIFY(treeChangedSpy.wait());
+    QCOMPARE(parentServerSurface->surfaceAt(QPointF(25, 75)), parentServerSurface);
+    QCOMPARE(parentServerSurface->renderList().count(), 2);
+    QCOMPARE(parentServerSurface->renderList().last().surface, childFor1ServerSurface);
+}
+
+void TestSubSurface::testOcclusion()
+{
+    // this test verifies that the opaque regions of a stack of surface trees hide what's below them
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+
+    // the bottom window is translucent
+    QScopedPointer<Surface> bottom(m_compositor->createSurface());
+    bottom->attachBuffer(m_shm->createBuffer(image));
+    bottom->damage(QRect(0, 0, 100, 100));
+    bottom->commit(Surface::CommitFlag::None);
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *bottomServerSurface = serverSurfaceCreated.last().first().value<SurfaceInterface *>();
+
+    // the top window is opaque and has a translucent sub-surface sticking out at the bottom right
+    QScopedPointer<Surface> top(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *topServerSurface = serverSurfaceCreated.last().first().value<SurfaceInterface *>();
+    QScopedPointer<Surface> child(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *childServerSurface = serverSurfaceCreated.last().first().value<SurfaceInterface *>();
+    QScopedPointer<SubSurface> subSurface(m_subCompositor->createSubSurface(child.data(), top.data()));
+    subSurface->setMode(SubSurface::Mode::Desynchronized);
+    subSurface->setPosition(QPoint(90, 90));
+    QImage childImage(QSize(20, 20), QImage::Format_ARGB32_Premultiplied);
+    childImage.fill(Qt::green);
+    child->attachBuffer(m_shm->createBuffer(childImage));
+    child->damage(QRect(0, 0, 20, 20));
+    child->commit(Surface::CommitFlag::None);
+    QSignalSpy topCommittedSpy(topServerSurface, &SurfaceInterface::committed);
+    QVERIFY(topCommittedSpy.isValid());
+    top->setOpaqueRegion(m_compositor->createRegion(QRegion(0, 0, 100, 100)).get());
+    top->attachBuffer(m_shm->createBuffer(image));
+    top->damage(QRect(0, 0, 100, 100));
+    top->commit(Surface::CommitFlag::None);
+    QVERIFY(topCommittedSpy.wait());
+    QCOMPARE(topServerSurface->renderList().count(), 2);
+
+    SurfaceOcclusion occlusion;
+    QVector<SurfaceOcclusion::Window> stack{{bottomServerSurface, QPoint(50, 0)}, {topServerSurface, QPoint(0, 0)}};
+    QVERIFY(occlusion.update(stack));
+    QCOMPARE(occlusion.visibleRegion(topServerSurface), QRegion(0, 0, 100, 100));
+    QCOMPARE(occlusion.visibleRegion(childServerSurface), QRegion(0, 0, 20, 20));
+    QCOMPARE(occlusion.visibleRegion(bottomServerSurface), QRegion(50, 0, 50, 100));
+    // nothing changed, so nothing is recomputed
+    QVERIFY(!occlusion.update(stack));
+
+    // moving the top window over the bottom one hides it
+    stack[1].position = QPoint(50, 0);
+    QVERIFY(occlusion.update(stack));
+    QVERIFY(!occlusion.isVisible(bottomServerSurface));
+    QVERIFY(occlusion.isVisible(childServerSurface));
+    occlusion.applyOcclusion();
+    QVERIFY(bottomServerSurface->isOccluded());
+    QVERIFY(!topServerSurface->isOccluded());
+    QVERIFY(!childServerSurface->isOccluded());
+
+    // what is outside of the area is hidden as well
+    stack[1].position = QPoint(0, 0);
+    QVERIFY(occlusion.update(stack, QRect(0, 0, 100, 100)));
+    QVERIFY(!occlusion.isVisible(bottomServerSurface));
+    QCOMPARE(occlusion.visibleRegion(childServerSurface), QRegion(0, 0, 10, 10));
+    occlusion.applyOcclusion();
+    QVERIFY(bottomServerSurface->isOccluded());
+
+    QVERIFY(occlusion.update(stack));
+    occlusion.applyOcclusion();
+    QVERIFY(!bottomServerSurface->isOccluded());
+}
+
+void TestSubSurface::testOutputDamage()
+{
+    // this test verifies that the damage of a surface tree is collected in output coordinates
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> parent(m_compositor->createSurface());
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    parent->attachBuffer(m_shm->createBuffer(image));
+    parent->damage(QRect(0, 0, 100, 100));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *parentServerSurface = serverSurfaceCreated.last().first().value<SurfaceInterface *>();
+
+    QScopedPointer<Surface> child(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *childServerSurface = serverSurfaceCreated.last().first().value<SurfaceInterface *>();
+    QScopedPointer<SubSurface> subSurface(m_subCompositor->createSubSurface(child.data(), parent.data()));
+    subSurface->setMode(SubSurface::Mode::Desynchronized);
+    subSurface->setPosition(QPoint(10, 10));
+    QImage childImage(QSize(20, 20), QImage::Format_ARGB32_Premultiplied);
+    childImage.fill(Qt::green);
+    child->attachBuffer(m_shm->createBuffer(childImage));
+    child->damage(QRect(0, 0, 20, 20));
+    child->commit(Surface::CommitFlag::None);
+    QSignalSpy parentDamagedSpy(parentServerSurface, &SurfaceInterface::damaged);
+    QVERIFY(parentDamagedSpy.isValid());
+    parent->attachBuffer(m_shm->createBuffer(image));
+    parent->damage(QRect(0, 0, 1, 1));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentDamagedSpy.wait());
+    QCOMPARE(childServerSurface->subSurface()->position(), QPoint(10, 10));
+
+    QScopedPointer<OutputInterface> output(new OutputInterface(m_display));
+    QScopedPointer<OutputInterface> otherOutput(new OutputInterface(m_display));
+    OutputDamageAggregator aggregator;
+
+    // placing the tree damages the area it covers
+    aggregator.setPlacement(parentServerSurface, output.data(), QPoint(100, 0));
+    QCOMPARE(aggregator.takeDamage(output.data()), QRegion(100, 0, 100, 100));
+    QVERIFY(aggregator.damage(output.data()).isEmpty());
+    aggregator.setPlacement(parentServerSurface, otherOutput.data(), QPoint(-50, 0));
+    QCOMPARE(aggregator.takeDamage(otherOutput.data()), QRegion(-50, 0, 100, 100));
+
+    // the damage of a sub-surface is mapped to all outputs
+    QSignalSpy childDamagedSpy(childServerSurface, &SurfaceInterface::damaged);
+    QVERIFY(childDamagedSpy.isValid());
+    child->attachBuffer(m_shm->createBuffer(childImage));
+    child->damage(QRect(0, 0, 5, 5));
+    child->commit(Surface::CommitFlag::None);
+    QVERIFY(childDamagedSpy.wait());
+    QCOMPARE(aggregator.damage(output.data()), QRegion(110, 10, 5, 5));
+    QCOMPARE(aggregator.takeDamage(otherOutput.data()), QRegion(-40, 10, 5, 5));
+
+    // the damage of all commits is united until it's taken
+    parentDamagedSpy.clear();
+    parent->attachBuffer(m_shm->createBuffer(image));
+    parent->damage(QRect(50, 50, 10, 10));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentDamagedSpy.wait());
+    QCOMPARE(aggregator.takeDamage(output.data()), QRegion(110, 10, 5, 5) | QRegion(150, 50, 10, 10));
+
+    // past the maximum, only the bounding rectangle is kept
+    aggregator.setMaximumRects(1);
+    QCOMPARE(aggregator.maximumRects(), 1);
+    parentDamagedSpy.clear();
+    parent->attachBuffer(m_shm->createBuffer(image));
+    parent->damage(QRect(0, 0, 10, 10));
+    parent->damage(QRect(50, 50, 10, 10));
+    parent->commit(Surface::CommitFlag::None);
+    QVERIFY(parentDamagedSpy.wait());
+    QCOMPARE(aggregator.takeDamage(output.data()), QRegion(100, 0, 60, 60));
+    aggregator.setMaximumRects(0);
+    aggregator.takeDamage(otherOutput.data());
+
+    // moving the tree damages the old and the new area
+    aggregator.setPlacement(parentServerSurface, output.data(), QPoint(0, 0));
+    QCOMPARE(aggregator.takeDamage(output.data()), QRegion(0, 0, 200, 100));
+
+    // so does removing it, afterwards nothing is collected anymore
+    aggregator.removePlacement(parentServerSurface, output.data());
+    QCOMPARE(aggregator.takeDamage(output.data()), QRegion(0, 0, 100, 100));
+    childDamagedSpy.clear();
+    child->attachBuffer(m_shm->createBuffer(childImage));
+    child->damage(QRect(0, 0, 5, 5));
+    child->commit(Surface::CommitFlag::None);
+    QVERIFY(childDamagedSpy.wait());
+    QVERIFY(aggregator.damage(output.data()).isEmpty());
+    QCOMPARE(aggregator.takeDamage(otherOutput.data()), QRegion(-40, 10, 5, 5));
 }
 
 void TestSubSurface::testDestroyAttachedBuffer()
@@ -1103,5 +1484,68 @@ void TestSubSurface::testDestroyParentSurface()
     QVERIFY(destroySpy.wait());
 }
 
+void TestSubSurface::testIdleInhibitTree()
+{
+    // this test verifies that an inhibitor on a nested sub-surface inhibits idle for the whole tree
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+
+    QScopedPointer<Surface> parentSurface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto parentServerSurface = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> childSurface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto childServerSurface = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+    QScopedPointer<Surface> grandChildSurface(m_compositor->createSurface());
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto grandChildServerSurface = surfaceCreatedSpy.last().first().value<SurfaceInterface*>();
+
+    QSignalSpy subSurfaceTreeChangedSpy(parentServerSurface, &SurfaceInterface::subSurfaceTreeChanged);
+    QScopedPointer<SubSurface> childSubSurface(m_subCompositor->createSubSurface(childSurface.data(), parentSurface.data()));
+    QScopedPointer<SubSurface> grandChildSubSurface(m_subCompositor->createSubSurface(grandChildSurface.data(), childSurface.data()));
+    QVERIFY(subSurfaceTreeChangedSpy.wait());
+    QTRY_COMPARE(childServerSurface->childSubSurfaces().count(), 1);
+    QVERIFY(!parentServerSurface->treeInhibitsIdle());
+
+    QSignalSpy treeInhibitsIdleChangedSpy(parentServerSurface, &SurfaceInterface::treeInhibitsIdleChanged);
+    QScopedPointer<IdleInhibitor> inhibitor(m_idleInhibitManager->createInhibitor(grandChildSurface.data()));
+    QVERIFY(treeInhibitsIdleChangedSpy.wait());
+    QVERIFY(grandChildServerSurface->inhibitsIdle());
+    QVERIFY(!parentServerSurface->inhibitsIdle());
+    QVERIFY(parentServerSurface->treeInhibitsIdle());
+    QVERIFY(childServerSurface->treeInhibitsIdle());
+    QCOMPARE(m_idleInhibitInterface->inhibitingSurfaceCount(), 1);
+
+    // a second inhibiting surface in the tree doesn't change it
+    QScopedPointer<IdleInhibitor> parentInhibitor(m_idleInhibitManager->createInhibitor(parentSurface.data()));
+    QTRY_COMPARE(m_idleInhibitInterface->inhibitingSurfaceCount(), 2);
+    QCOMPARE(treeInhibitsIdleChangedSpy.count(), 1);
+    parentInhibitor.reset();
+    QTRY_COMPARE(m_idleInhibitInterface->inhibitingSurfaceCount(), 1);
+    QVERIFY(parentServerSurface->treeInhibitsIdle());
+
+    // occluding the inhibiting surface lifts the inhibition of the tree
+    grandChildServerSurface->setOccluded(true);
+    QCOMPARE(treeInhibitsIdleChangedSpy.count(), 2);
+    QVERIFY(!parentServerSurface->treeInhibitsIdle());
+    QCOMPARE(m_idleInhibitInterface->inhibitingSurfaceCount(), 0);
+    grandChildServerSurface->setOccluded(false);
+    QCOMPARE(treeInhibitsIdleChangedSpy.count(), 3);
+
+    // removing the sub-surface takes its inhibitors out of the tree, the child keeps them
+    childSubSurface.reset();
+    QVERIFY(treeInhibitsIdleChangedSpy.wait());
+    QVERIFY(!parentServerSurface->treeInhibitsIdle());
+    QVERIFY(childServerSurface->treeInhibitsIdle());
+
+    // and so does destroying the inhibiting surface
+    QSignalSpy childTreeInhibitsIdleChangedSpy(childServerSurface, &SurfaceInterface::treeInhibitsIdleChanged);
+    grandChildSurface.reset();
+    QVERIFY(childTreeInhibitsIdleChangedSpy.wait());
+    QVERIFY(!childServerSurface->treeInhibitsIdle());
+    QCOMPARE(m_idleInhibitInterface->inhibitingSurfaceCount(), 0);
+}
+
 QTEST_GUILESS_MAIN(TestSubSurface)
 #include "test_wayland_subsurface.moc"
@@ -7,6 +7,7 @@
 #include <QtTest>
 #include <QImage>
 #include <QPainter>
+#include <QThread>
 // KWin
 #include "KWayland/Client/compositor.h"
 #include "KWayland/Client/connection_thread.h"
@@ -18,8 +19,10 @@
 #include "KWayland/Client/registry.h"
 #include "KWayland/Client/shm_pool.h"
 #include "../../src/server/buffer_interface.h"
+#include "../../src/server/clientconnection.h"
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
+#include "../../src/server/framecallbackscheduler.h"
 #include "../../src/server/idleinhibit_v1_interface.h"
 #include "../../src/server/surface_interface.h"
 // Wayland
@@ -38,7 +41,14 @@ private Q_SLOTS:
 
     void testStaticAccessor();
     void testDamage();
+    void testDamageRects();
     void testFrameCallback();
+    void testFrameCallbackScheduler();
+    void testFrameCallbackBacklog();
+    void testFrameCallbackOccluded();
+    void testCommitRateLimit();
+    void testStatistics();
+    void testCommitObserver();
     void testAttachBuffer();
     void testMultipleSurfaces();
     void testOpaque();
@@ -47,12 +57,17 @@ private Q_SLOTS:
     void testDestroy();
     void testUnmapOfNotMappedSurface();
     void testDamageTracking();
+    void testDamageHistory();
+    void testConvertBuffer();
+    void testShmBufferAccess();
+    void testForEachDamagedSpan();
     void testSurfaceAt();
     void testDestroyAttachedBuffer();
     void testDestroyWithPendingCallback();
     void testOutput();
     void testDisconnect();
     void testInhibit();
+    void testInhibitOccluded();
 
 private:
     KWaylandServer::Display *m_display;
@@ -222,8 +237,11 @@ void TestWaylandSurface::testStaticAccessor()
     QCOMPARE(KWaylandServer::SurfaceInterface::get(serverSurface2->resource()), serverSurface2);
     QCOMPARE(KWaylandServer::SurfaceInterface::get(serverSurface2->id(), serverSurface2->client()), serverSurface2);
 
+    QCOMPARE(KWaylandServer::SurfaceInterface::surfaces(), (QList<KWaylandServer::SurfaceInterface *>{serverSurface1, serverSurface2}));
+
     const quint32 surfaceId1 = serverSurface1->id();
     const quint32 surfaceId2 = serverSurface2->id();
+    KWaylandServer::ClientConnection *client = serverSurface1->client();
 
     // delete s2 again
     delete s2;
@@ -241,6 +259,9 @@ void TestWaylandSurface::testStaticAccessor()
     QVERIFY(!KWaylandServer::SurfaceInterface::get(nullptr));
     QVERIFY(!KWaylandServer::SurfaceInterface::get(surfaceId1, nullptr));
     QVERIFY(!KWaylandServer::SurfaceInterface::get(surfaceId2, nullptr));
+    QVERIFY(!KWaylandServer::SurfaceInterface::get(surfaceId1, client));
+    QVERIFY(!KWaylandServer::SurfaceInterface::get(surfaceId2, client));
+    QVERIFY(KWaylandServer::SurfaceInterface::surfaces().isEmpty());
 }
 
 void TestWaylandSurface::testDamage()
@@ -332,6 +353,42 @@ void TestWaylandSurface::testDamage()
     QVERIFY(serverSurface->isMapped());
 }
 
+void TestWaylandSurface::testDamageRects()
+{
+    // this test verifies that many damage rectangles are united and simplified past the limit
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, SIGNAL(surfaceCreated(KWaylandServer::SurfaceInterface*)));
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    KWaylandServer::SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface*>();
+    QCOMPARE(serverSurface->maximumDamageRects(), 1024);
+    QSignalSpy damageSpy(serverSurface, SIGNAL(damaged(QRegion)));
+
+    QImage img(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    QRegion expected;
+    s->attachBuffer(m_shm->createBuffer(img));
+    for (int y = 0; y < 100; y += 5) {
+        for (int x = 0; x < 100; x += 10) {
+            const QRect rect(x + y % 3, y, 4, 2);
+            s->damage(rect);
+            expected += rect;
+        }
+    }
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(damageSpy.wait());
+    QCOMPARE(serverSurface->damage(), expected);
+
+    serverSurface->setMaximumDamageRects(4);
+    QCOMPARE(serverSurface->maximumDamageRects(), 4);
+    s->attachBuffer(m_shm->createBuffer(img));
+    for (int i = 0; i < 10; ++i) {
+        s->damage(QRect(i * 5, i * 7, 2, 2));
+    }
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(damageSpy.wait());
+    QCOMPARE(serverSurface->damage(), QRegion(0, 0, 47, 65));
+}
+
 void TestWaylandSurface::testFrameCallback()
 {
     QSignalSpy serverSurfaceCreated(m_compositorInterface, SIGNAL(surfaceCreated(KWaylandServer::SurfaceInterface*)));
@@ -353,12 +410,328 @@ void TestWaylandSurface::testFrameCallback()
     s->damage(QRect(0, 0, 10, 10));
     s->commit();
     QVERIFY(damageSpy.wait());
+    QCOMPARE(serverSurface->client()->pendingFrameCallbackCount(), 1);
+    QCOMPARE(serverSurface->client()->commitCount(), 1u);
     serverSurface->frameRendered(10);
+    QCOMPARE(serverSurface->client()->pendingFrameCallbackCount(), 0);
     QVERIFY(frameRenderedSpy.isEmpty());
     QVERIFY(frameRenderedSpy.wait());
     QVERIFY(!frameRenderedSpy.isEmpty());
 }
 
+void TestWaylandSurface::testFrameCallbackScheduler()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s1(m_compositor->createSurface());
+    QScopedPointer<KWayland::Client::Surface> s2(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    if (serverSurfaceCreated.count() < 2) {
+        QVERIFY(serverSurfaceCreated.wait());
+    }
+    SurfaceInterface *serverSurface1 = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    SurfaceInterface *serverSurface2 = serverSurfaceCreated.last().first().value<SurfaceInterface*>();
+
+    QSignalSpy committedSpy(serverSurface2, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+    QSignalSpy frameRendered1Spy(s1.data(), &KWayland::Client::Surface::frameRendered);
+    QVERIFY(frameRendered1Spy.isValid());
+    QSignalSpy frameRendered2Spy(s2.data(), &KWayland::Client::Surface::frameRendered);
+    QVERIFY(frameRendered2Spy.isValid());
+
+    QImage img(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s1->attachBuffer(m_shm->createBuffer(img));
+    s1->damage(QRect(0, 0, 10, 10));
+    s1->commit();
+    s2->attachBuffer(m_shm->createBuffer(img));
+    s2->damage(QRect(0, 0, 10, 10));
+    s2->commit();
+    QVERIFY(committedSpy.wait());
+    QVERIFY(serverSurface1->hasFrameCallbacks());
+    QVERIFY(serverSurface2->hasFrameCallbacks());
+
+    FrameCallbackScheduler::frameRendered({serverSurface1, serverSurface2}, 10);
+    QVERIFY(!serverSurface1->hasFrameCallbacks());
+    QVERIFY(!serverSurface2->hasFrameCallbacks());
+    QVERIFY(frameRendered2Spy.wait());
+    if (frameRendered1Spy.isEmpty()) {
+        QVERIFY(frameRendered1Spy.wait());
+    }
+    QCOMPARE(frameRendered1Spy.count(), 1);
+    QCOMPARE(frameRendered2Spy.count(), 1);
+}
+
+void TestWaylandSurface::testFrameCallbackBacklog()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->maximumPendingFrameCallbacks(), 500);
+    QVERIFY(!serverSurface->areFrameCallbacksThrottled());
+    serverSurface->setMaximumPendingFrameCallbacks(2);
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+    QSignalSpy throttledSpy(serverSurface, &SurfaceInterface::frameCallbacksThrottledChanged);
+    QVERIFY(throttledSpy.isValid());
+
+    // the client keeps requesting frame callbacks without the compositor rendering the surface
+    QVector<wl_callback *> callbacks;
+    for (int i = 0; i < 2; ++i) {
+        callbacks << wl_surface_frame(*s);
+        s->commit(KWayland::Client::Surface::CommitFlag::None);
+        QVERIFY(committedSpy.wait());
+    }
+    QVERIFY(throttledSpy.isEmpty());
+    QCOMPARE(serverSurface->client()->pendingFrameCallbackCount(), 2);
+
+    callbacks << wl_surface_frame(*s);
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(throttledSpy.count(), 1);
+    QVERIFY(serverSurface->areFrameCallbacksThrottled());
+    QVERIFY(!serverSurface->hasFrameCallbacks());
+    QCOMPARE(serverSurface->client()->pendingFrameCallbackCount(), 0);
+
+    // rendering the surface again ends the throttling
+    serverSurface->frameRendered(10);
+    QCOMPARE(throttledSpy.count(), 2);
+    QVERIFY(!serverSurface->areFrameCallbacksThrottled());
+
+    for (wl_callback *callback : qAsConst(callbacks)) {
+        wl_callback_destroy(callback);
+    }
+}
+
+void TestWaylandSurface::testFrameCallbackOccluded()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->frameCallbackIdleInterval(), 1000);
+    serverSurface->setFrameCallbackIdleInterval(10);
+
+    QSignalSpy throttledSpy(serverSurface, &SurfaceInterface::frameCallbacksThrottledChanged);
+    QVERIFY(throttledSpy.isValid());
+    serverSurface->setOccluded(true);
+    QVERIFY(serverSurface->isOccluded());
+    QVERIFY(serverSurface->areFrameCallbacksThrottled());
+    QCOMPARE(throttledSpy.count(), 1);
+
+    // the frame callback gets completed without the compositor rendering the surface
+    QSignalSpy frameRenderedSpy(s.data(), &KWayland::Client::Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    QImage img(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit();
+    QVERIFY(frameRenderedSpy.wait());
+
+    // a compositor rendering an occluded surface does not end the throttling
+    serverSurface->frameRendered(10);
+    QVERIFY(serverSurface->areFrameCallbacksThrottled());
+    serverSurface->setOccluded(false);
+    QVERIFY(serverSurface->areFrameCallbacksThrottled());
+    serverSurface->frameRendered(20);
+    QVERIFY(!serverSurface->areFrameCallbacksThrottled());
+    QCOMPARE(throttledSpy.count(), 2);
+}
+
+void TestWaylandSurface::testCommitRateLimit()
+{
+    // this test verifies that commits beyond the rate limit of a client emit merged signals
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    ClientConnection *client = serverSurface->client();
+    client->setCommitRateLimit(2, 500);
+    QCOMPARE(client->commitRateLimit(), 2);
+    QCOMPARE(client->commitRatePeriod(), 500);
+
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damagedSpy.isValid());
+
+    QImage img(QSize(40, 40), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    for (int i = 0; i < 5; ++i) {
+        s->attachBuffer(m_shm->createBuffer(img));
+        s->damage(QRect(i * 5, 0, 5, 5));
+        s->commit(KWayland::Client::Surface::CommitFlag::None);
+    }
+    // the first two commits are within the limit
+    QVERIFY(committedSpy.wait());
+    if (committedSpy.count() < 2) {
+        QVERIFY(committedSpy.wait());
+    }
+    QCOMPARE(committedSpy.count(), 2);
+    QCOMPARE(damagedSpy.count(), 2);
+
+    // the other ones are applied but signalled once at the end of the period
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(committedSpy.count(), 3);
+    QCOMPARE(damagedSpy.count(), 3);
+    QCOMPARE(damagedSpy.last().first().value<QRegion>(), QRegion(10, 0, 15, 5));
+    QCOMPARE(serverSurface->damage(), QRegion(20, 0, 5, 5));
+    QCOMPARE(client->commitCount(), 5u);
+    QCOMPARE(client->throttledCommitCount(), 3u);
+
+    // removing the limit emits the signals of every commit
+    client->setCommitRateLimit(0, 0);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 5, 5));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(committedSpy.count(), 4);
+    QCOMPARE(client->throttledCommitCount(), 3u);
+}
+
+void TestWaylandSurface::testStatistics()
+{
+    using namespace KWaylandServer;
+    qRegisterMetaType<SurfaceStatistics>();
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+    QCOMPARE(serverSurface->statisticsInterval(), 0);
+    serverSurface->setStatisticsInterval(100);
+    QCOMPARE(serverSurface->statisticsInterval(), 100);
+
+    QSignalSpy statisticsSpy(serverSurface, &SurfaceInterface::statisticsUpdated);
+    QVERIFY(statisticsSpy.isValid());
+    QSignalSpy damageSpy(serverSurface, &SurfaceInterface::damaged);
+    QVERIFY(damageSpy.isValid());
+    QImage img(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit();
+    QVERIFY(damageSpy.wait());
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 5, 2));
+    s->commit();
+    QVERIFY(damageSpy.wait());
+
+    SurfaceStatistics statistics = serverSurface->statistics();
+    QCOMPARE(statistics.commits, 2u);
+    QCOMPARE(statistics.damagedPixels, 110u);
+    QCOMPARE(statistics.bufferSize, QSize(10, 10));
+    QCOMPARE(statistics.frames, 0u);
+
+    // the latency is measured from the first commit which is not rendered yet
+    serverSurface->frameRendered(1);
+    statistics = serverSurface->statistics();
+    QCOMPARE(statistics.frames, 1u);
+    QVERIFY(statistics.lastFrameLatency > 0);
+    QCOMPARE(statistics.maximumFrameLatency, statistics.lastFrameLatency);
+    QCOMPARE(statistics.totalFrameLatency, statistics.lastFrameLatency);
+    // without a new commit there is no new frame
+    serverSurface->frameRendered(2);
+    QCOMPARE(serverSurface->statistics().frames, 1u);
+
+    // frame callbacks completed by the server are missed
+    serverSurface->setFrameCallbackIdleInterval(10);
+    serverSurface->setOccluded(true);
+    QSignalSpy frameRenderedSpy(s.data(), &KWayland::Client::Surface::frameRendered);
+    QVERIFY(frameRenderedSpy.isValid());
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit();
+    QVERIFY(frameRenderedSpy.wait());
+    QCOMPARE(serverSurface->statistics().missedFrameCallbacks, 1u);
+
+    QVERIFY(statisticsSpy.wait());
+    statistics = statisticsSpy.last().first().value<SurfaceStatistics>();
+    QCOMPARE(statistics.commits, 3u);
+    QCOMPARE(statistics.bufferSize, QSize(10, 10));
+
+    serverSurface->resetStatistics();
+    QCOMPARE(serverSurface->statistics().commits, 0u);
+    serverSurface->setStatisticsInterval(0);
+    QCOMPARE(serverSurface->statisticsInterval(), 0);
+    QVERIFY(!statisticsSpy.wait(200));
+}
+
+class CommitRecorder : public KWaylandServer::SurfaceCommitObserver
+{
+public:
+    void surfaceCommitted(KWaylandServer::SurfaceInterface *surface, const KWaylandServer::SurfaceCommitInfo &info) override
+    {
+        surfaces << surface;
+        commits << info;
+    }
+
+    QVector<KWaylandServer::SurfaceInterface *> surfaces;
+    QVector<KWaylandServer::SurfaceCommitInfo> commits;
+};
+
+void TestWaylandSurface::testCommitObserver()
+{
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    CommitRecorder recorder;
+    serverSurface->addCommitObserver(&recorder);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+    QVERIFY(committedSpy.isValid());
+
+    // mapping the surface is one call with all changes
+    QImage img(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit();
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(recorder.commits.count(), 1);
+    QCOMPARE(recorder.surfaces.first(), serverSurface);
+    const SurfaceCommitInfo::Changes mapChanges = SurfaceCommitInfo::Change::Mapped | SurfaceCommitInfo::Change::Damage
+        | SurfaceCommitInfo::Change::Size | SurfaceCommitInfo::Change::BufferSize | SurfaceCommitInfo::Change::SurfaceToBufferMatrix;
+    QCOMPARE(recorder.commits.first().changes & mapChanges, mapChanges);
+    QVERIFY(!(recorder.commits.first().changes & SurfaceCommitInfo::Change::Unmapped));
+    QCOMPARE(recorder.commits.first().damage, QRegion(0, 0, 10, 10));
+
+    // a commit without changes is reported, too
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(recorder.commits.count(), 2);
+    QCOMPARE(recorder.commits.last().changes, SurfaceCommitInfo::Changes());
+
+    s->attachBuffer((wl_buffer*)nullptr);
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(recorder.commits.count(), 3);
+    QVERIFY(recorder.commits.last().changes & SurfaceCommitInfo::Change::Unmapped);
+
+    serverSurface->removeCommitObserver(&recorder);
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(recorder.commits.count(), 3);
+}
+
 void TestWaylandSurface::testAttachBuffer()
 {
     // create the surface
@@ -683,6 +1056,7 @@ void TestWaylandSurface::testInput()
     QVERIFY(serverSurface->isMapped());
     QCOMPARE(inputRegionChangedSpy.count(), 1);
     QCOMPARE(serverSurface->input(), QRegion(0, 0, 100, 50));
+    QVERIFY(serverSurface->inputIsInfinite());
 
     // let's install an input region
     s->setInputRegion(m_compositor->createRegion(QRegion(0, 10, 20, 30)).get());
@@ -697,6 +1071,7 @@ void TestWaylandSurface::testInput()
     QVERIFY(committedSpy.wait());
     QCOMPARE(inputRegionChangedSpy.count(), 2);
     QCOMPARE(serverSurface->input(), QRegion(0, 10, 20, 30));
+    QVERIFY(!serverSurface->inputIsInfinite());
 
     // committing without setting a new region shouldn't change
     s->commit(Surface::CommitFlag::None);
@@ -718,6 +1093,17 @@ void TestWaylandSurface::testInput()
     QVERIFY(committedSpy.wait());
     QCOMPARE(inputRegionChangedSpy.count(), 4);
     QCOMPARE(serverSurface->input(), QRegion(0, 0, 100, 50));
+    QVERIFY(serverSurface->inputIsInfinite());
+
+    // the infinite region follows the size of the surface
+    QImage larger(200, 60, QImage::Format_RGB32);
+    larger.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(larger));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(inputRegionChangedSpy.count(), 5);
+    QCOMPARE(inputRegionChangedSpy.last().first().value<QRegion>(), QRegion(0, 0, 200, 60));
+    QCOMPARE(serverSurface->input(), QRegion(0, 0, 200, 60));
 }
 
 void TestWaylandSurface::testScale()
@@ -810,6 +1196,14 @@ void TestWaylandSurface::testScale()
     QCOMPARE(bufferScaleChangedSpy.count(), 1);
     QCOMPARE(serverSurface->bufferScale(), 2);
     QCOMPARE(serverSurface->size(), QSize(25,25));
+
+    // the integer scale mapping has to match the surface-to-buffer matrix
+    const QRegion surfaceRegion = QRegion(0, 0, 10, 5) | QRegion(3, 7, 20, 11);
+    const QRegion bufferRegion = QRegion(0, 0, 20, 10) | QRegion(6, 14, 40, 22);
+    QCOMPARE(serverSurface->mapToBuffer(surfaceRegion), bufferRegion);
+    QCOMPARE(serverSurface->mapFromBuffer(bufferRegion), surfaceRegion);
+    QCOMPARE(serverSurface->mapToBuffer(QPointF(3, 4)), serverSurface->surfaceToBufferMatrix().map(QPointF(3, 4)));
+    QCOMPARE(serverSurface->mapFromBuffer(QPointF(6, 8)), QPointF(3, 4));
 }
 
 void TestWaylandSurface::testDestroy()
@@ -931,6 +1325,210 @@ void TestWaylandSurface::testDamageTracking()
     QCOMPARE(serverSurface->damage(), QRegion(50, 40, 20, 30));
 }
 
+void TestWaylandSurface::testDamageHistory()
+{
+    // this test verifies that the damage since any recent buffer can be queried
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, SIGNAL(surfaceCreated(KWaylandServer::SurfaceInterface*)));
+    QScopedPointer<KWayland::Client::Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    KWaylandServer::SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface*>();
+    QCOMPARE(serverSurface->damageSequence(), 0u);
+    QCOMPARE(serverSurface->damageHistorySize(), 8);
+    serverSurface->setDamageHistorySize(3);
+    QSignalSpy committedSpy(serverSurface, SIGNAL(committed()));
+
+    QImage img(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 100, 100));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    const quint64 first = serverSurface->damageSequence();
+    QCOMPARE(first, 1u);
+    QCOMPARE(serverSurface->damageSince(first), QRegion());
+
+    const QRect rects[] = {QRect(0, 0, 10, 10), QRect(20, 20, 10, 10), QRect(40, 40, 10, 10)};
+    for (const QRect &rect : rects) {
+        s->attachBuffer(m_shm->createBuffer(img));
+        s->damage(rect);
+        s->commit(KWayland::Client::Surface::CommitFlag::None);
+        QVERIFY(committedSpy.wait());
+    }
+    QCOMPARE(serverSurface->damageSequence(), first + 3);
+    QCOMPARE(serverSurface->damageSince(first + 2), QRegion(rects[2]));
+    QCOMPARE(serverSurface->damageSince(first + 1), QRegion(rects[1]).united(rects[2]));
+    QCOMPARE(serverSurface->damageSince(first), QRegion(rects[0]).united(rects[1]).united(rects[2]));
+    // out of the history
+    QCOMPARE(serverSurface->damageSince(0), QRegion(0, 0, 100, 100));
+
+    // shrinking the history keeps the latest damage
+    serverSurface->setDamageHistorySize(2);
+    QCOMPARE(serverSurface->damageSince(first + 1), QRegion(rects[1]).united(rects[2]));
+    QCOMPARE(serverSurface->damageSince(first), QRegion(0, 0, 100, 100));
+
+    // a buffer of a different size damages everything
+    img = QImage(QSize(50, 50), QImage::Format_ARGB32_Premultiplied);
+    img.fill(Qt::black);
+    s->attachBuffer(m_shm->createBuffer(img));
+    s->damage(QRect(0, 0, 5, 5));
+    s->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->damageSince(first + 3), QRegion(0, 0, 50, 50));
+}
+
+void TestWaylandSurface::testConvertBuffer()
+{
+    // this tests that BufferInterface::convertTo only touches the requested region
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface*>();
+
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(QRect(0, 0, 100, 100));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+
+    // the first conversion allocates the image and converts the whole buffer
+    QImage converted;
+    QVERIFY(serverSurface->buffer()->convertTo(&converted, QRegion()));
+    QCOMPARE(converted.size(), QSize(100, 100));
+    QCOMPARE(converted.format(), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE(converted, image);
+
+    QPainter p;
+    p.begin(&image);
+    p.fillRect(QRect(0, 0, 100, 100), Qt::blue);
+    p.end();
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(QRect(0, 0, 10, 10));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+
+    // only the damaged part gets converted
+    QVERIFY(serverSurface->buffer()->convertTo(&converted, serverSurface->mapToBuffer(serverSurface->damage())));
+    QCOMPARE(converted.pixel(5, 5), qRgb(0, 0, 255));
+    QCOMPARE(converted.pixel(50, 50), qRgb(255, 0, 0));
+}
+
+void TestWaylandSurface::testShmBufferAccess()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> s1(m_compositor->createSurface());
+    QScopedPointer<Surface> s2(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    if (serverSurfaceCreated.count() < 2) {
+        QVERIFY(serverSurfaceCreated.wait());
+    }
+    SurfaceInterface *serverSurface1 = serverSurfaceCreated.first().first().value<SurfaceInterface*>();
+    SurfaceInterface *serverSurface2 = serverSurfaceCreated.last().first().value<SurfaceInterface*>();
+
+    QSignalSpy committedSpy(serverSurface2, &SurfaceInterface::committed);
+    QImage red(QSize(10, 10), QImage::Format_ARGB32_Premultiplied);
+    red.fill(Qt::red);
+    QImage blue(QSize(20, 20), QImage::Format_ARGB32_Premultiplied);
+    blue.fill(Qt::blue);
+    s1->attachBuffer(m_shm->createBuffer(red));
+    s1->commit(Surface::CommitFlag::None);
+    s2->attachBuffer(m_shm->createBuffer(blue));
+    s2->commit(Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    BufferInterface *buffer1 = serverSurface1->buffer();
+    BufferInterface *buffer2 = serverSurface2->buffer();
+    QVERIFY(buffer1);
+    QVERIFY(buffer2);
+
+    QVERIFY(!ShmBufferAccess(nullptr).isValid());
+    {
+        ShmBufferAccess access(buffer1);
+        QVERIFY(access.isValid());
+        QCOMPARE(access.size(), QSize(10, 10));
+        QCOMPARE(access.format(), quint32(WL_SHM_FORMAT_ARGB8888));
+        QCOMPARE(*reinterpret_cast<const QRgb *>(access.bits()), red.pixel(0, 0));
+        // the same buffer can be accessed again, but not another one
+        QVERIFY(ShmBufferAccess(buffer1).isValid());
+        QVERIFY(!buffer1->data().isNull());
+        QVERIFY(!ShmBufferAccess(buffer2).isValid());
+        QVERIFY(buffer2->data().isNull());
+
+        // while another thread can
+        bool valid = false;
+        QSize size;
+        QRgb pixel = 0;
+        QScopedPointer<QThread> thread(QThread::create([&] {
+            ShmBufferAccess access(buffer2);
+            valid = access.isValid();
+            size = access.size();
+            pixel = *reinterpret_cast<const QRgb *>(access.bits() + 19 * access.stride());
+        }));
+        thread->start();
+        QVERIFY(thread->wait());
+        QVERIFY(valid);
+        QCOMPARE(size, QSize(20, 20));
+        QCOMPARE(pixel, blue.pixel(0, 19));
+    }
+    QVERIFY(ShmBufferAccess(buffer2).isValid());
+    QVERIFY(!buffer2->data().isNull());
+}
+
+void TestWaylandSurface::testForEachDamagedSpan()
+{
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QSignalSpy serverSurfaceCreated(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(serverSurfaceCreated.isValid());
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QVERIFY(serverSurfaceCreated.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreated.first().first().value<KWaylandServer::SurfaceInterface*>();
+
+    // without a buffer there is nothing to iterate
+    QVERIFY(!serverSurface->forEachDamagedSpan([](const QRect &, const uchar *) {}));
+
+    QSignalSpy damagedSpy(serverSurface, &SurfaceInterface::damaged);
+    QImage image(QSize(100, 100), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    s->attachBuffer(m_shm->createBuffer(image));
+    s->damage(QRect(10, 20, 30, 5));
+    s->commit(Surface::CommitFlag::None);
+    QVERIFY(damagedSpy.wait());
+
+    QRegion visited;
+    int spanCount = 0;
+    QVERIFY(serverSurface->forEachDamagedSpan([&](const QRect &span, const uchar *bits) {
+        QCOMPARE(span.height(), 1);
+        QCOMPARE(*reinterpret_cast<const QRgb *>(bits), image.pixel(span.topLeft()));
+        visited += span;
+        spanCount++;
+    }));
+    QCOMPARE(spanCount, 5);
+    QCOMPARE(visited, QRegion(10, 20, 30, 5));
+
+    // copying into staging memory only writes the damaged pixels
+    QImage staging(image.size(), QImage::Format_ARGB32_Premultiplied);
+    staging.fill(Qt::blue);
+    BufferInterface *buffer = serverSurface->buffer();
+    QVERIFY(!buffer->copyTo(staging.bits(), 10, QRegion(0, 0, 10, 10)));
+    QVERIFY(buffer->copyTo(staging.bits(), staging.bytesPerLine(), serverSurface->mapToBuffer(serverSurface->damage())));
+    QCOMPARE(staging.pixel(10, 20), QColor(Qt::red).rgba());
+    QCOMPARE(staging.pixel(39, 24), QColor(Qt::red).rgba());
+    QCOMPARE(staging.pixel(9, 20), QColor(Qt::blue).rgba());
+    QCOMPARE(staging.pixel(10, 25), QColor(Qt::blue).rgba());
+    // whole rows are copied as a block
+    QVERIFY(buffer->copyTo(staging.bits(), staging.bytesPerLine(), QRegion(0, 50, 100, 2)));
+    QCOMPARE(staging.pixel(0, 50), QColor(Qt::red).rgba());
+    QCOMPARE(staging.pixel(99, 51), QColor(Qt::red).rgba());
+    QCOMPARE(staging.pixel(0, 52), QColor(Qt::blue).rgba());
+}
+
 void TestWaylandSurface::testSurfaceAt()
 {
     // this test verifies that surfaceAt(const QPointF&) works as expected for the case of no children
@@ -1121,6 +1719,7 @@ void TestWaylandSurface::testOutput()
     QVERIFY(clientOutput->isValid());
     m_connection->flush();
     m_display->dispatchEvents();
+    QCOMPARE(serverOutput->clientResources(serverSurface->client()).count(), 1);
 
     // now enter it
     serverSurface->setOutputs(QVector<OutputInterface*>{serverOutput});
@@ -1207,5 +1806,50 @@ void TestWaylandSurface::testInhibit()
     QCOMPARE(inhibitsChangedSpy.count(), 4);
 }
 
+void TestWaylandSurface::testInhibitOccluded()
+{
+    // an inhibitor only takes effect while the surface is visible
+    using namespace KWayland::Client;
+    using namespace KWaylandServer;
+    QScopedPointer<Surface> s(m_compositor->createSurface());
+    QSignalSpy surfaceCreatedSpy(m_compositorInterface, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface*>();
+    QVERIFY(serverSurface);
+
+    QSignalSpy inhibitsChangedSpy(serverSurface, &SurfaceInterface::inhibitsIdleChanged);
+    QSignalSpy managerInhibitedSpy(m_idleInhibitInterface, &IdleInhibitManagerV1Interface::inhibitedChanged);
+    QVERIFY(!m_idleInhibitInterface->isInhibited());
+
+    // an inhibitor on an occluded surface has no effect
+    serverSurface->setOccluded(true);
+    QScopedPointer<IdleInhibitor> inhibitor(m_idleInhibitManager->createInhibitor(s.data()));
+    QVERIFY(!inhibitsChangedSpy.wait(500));
+    QCOMPARE(serverSurface->inhibitsIdle(), false);
+    QVERIFY(!m_idleInhibitInterface->isInhibited());
+
+    // it does once the surface becomes visible
+    serverSurface->setOccluded(false);
+    QCOMPARE(inhibitsChangedSpy.count(), 1);
+    QCOMPARE(serverSurface->inhibitsIdle(), true);
+    QCOMPARE(managerInhibitedSpy.count(), 1);
+    QVERIFY(m_idleInhibitInterface->isInhibited());
+
+    serverSurface->setOccluded(true);
+    QCOMPARE(inhibitsChangedSpy.count(), 2);
+    QCOMPARE(serverSurface->inhibitsIdle(), false);
+    QCOMPARE(managerInhibitedSpy.count(), 2);
+    QVERIFY(!m_idleInhibitInterface->isInhibited());
+
+    // destroying a visibly inhibiting surface lifts the inhibition
+    serverSurface->setOccluded(false);
+    QCOMPARE(managerInhibitedSpy.count(), 3);
+    QSignalSpy destroyedSpy(serverSurface, &QObject::destroyed);
+    s.reset();
+    QVERIFY(destroyedSpy.wait());
+    QCOMPARE(managerInhibitedSpy.count(), 4);
+    QVERIFY(!m_idleInhibitInterface->isInhibited());
+}
+
 QTEST_GUILESS_MAIN(TestWaylandSurface)
 #include "test_wayland_surface.moc"
@@ -53,9 +53,14 @@ private Q_SLOTS:
     void testRequestShowingDesktop();
     void testParentWindow();
     void testGeometry();
+    void testGeometryThrottling();
     void testIcon();
+    void testSharedIcon();
+    void testReplaceIcon();
+    void testSameContent();
     void testPid();
     void testApplicationMenu();
+    void testBatchedUpdate();
 
     void cleanup();
 
@@ -574,6 +579,33 @@ void TestWindowManagement::testGeometry()
     QCOMPARE(window->geometry(), QRect(0, 0, 35, 45));
 }
 
+void TestWindowManagement::testGeometryThrottling()
+{
+    using namespace KWayland::Client;
+    // this test verifies that the geometries of an interactive move are coalesced
+    QSignalSpy windowGeometryChangedSpy(m_window, &PlasmaWindow::geometryChanged);
+    QVERIFY(windowGeometryChangedSpy.isValid());
+    m_windowInterface->setGeometryUpdateInterval(60000);
+    QCOMPARE(m_windowInterface->geometryUpdateInterval(), 60000);
+
+    // the first geometry is sent right away
+    m_windowInterface->setGeometry(QRect(0, 0, 100, 50));
+    QVERIFY(windowGeometryChangedSpy.wait());
+    QCOMPARE(m_window->geometry(), QRect(0, 0, 100, 50));
+    // the following ones wait for the interval
+    for (int i = 1; i <= 10; ++i) {
+        m_windowInterface->setGeometry(QRect(i, 0, 100, 50));
+    }
+    QVERIFY(!windowGeometryChangedSpy.wait(100));
+    QCOMPARE(windowGeometryChangedSpy.count(), 1);
+
+    // ending the move sends the final geometry
+    m_windowInterface->setGeometryUpdateInterval(0);
+    QVERIFY(windowGeometryChangedSpy.wait());
+    QCOMPARE(windowGeometryChangedSpy.count(), 2);
+    QCOMPARE(m_window->geometry(), QRect(10, 0, 100, 50));
+}
+
 void TestWindowManagement::testIcon()
 {
     using namespace KWayland::Client;
@@ -615,6 +647,109 @@ void TestWindowManagement::testIcon()
     QCOMPARE(m_window->icon().name(), QStringLiteral("xorg"));
 }
 
+void TestWindowManagement::testSharedIcon()
+{
+    using namespace KWayland::Client;
+    QSignalSpy iconChangedSpy(m_window, &PlasmaWindow::iconChanged);
+    QVERIFY(iconChangedSpy.isValid());
+    QVERIFY(iconChangedSpy.wait());
+
+    // two windows of the same application with the same icon
+    QPixmap p(32, 32);
+    p.fill(Qt::red);
+    const QIcon icon(p);
+    m_windowInterface->setIcon(icon);
+    QScopedPointer<KWaylandServer::PlasmaWindowInterface> otherWindowInterface(m_windowManagementInterface->createWindow(this, QUuid::createUuid()));
+    otherWindowInterface->setIcon(icon);
+    QSignalSpy windowSpy(m_windowManagement, &PlasmaWindowManagement::windowCreated);
+    QVERIFY(windowSpy.isValid());
+    QVERIFY(windowSpy.wait());
+    QScopedPointer<PlasmaWindow> otherWindow(windowSpy.first().first().value<PlasmaWindow *>());
+    QSignalSpy otherIconChangedSpy(otherWindow.data(), &PlasmaWindow::iconChanged);
+    QVERIFY(otherIconChangedSpy.isValid());
+    QVERIFY(otherIconChangedSpy.wait());
+    QTRY_COMPARE(m_window->icon().pixmap(32, 32), p);
+    QCOMPARE(otherWindow->icon().pixmap(32, 32), p);
+
+    // changing the icon of one window doesn't affect the other
+    QPixmap blue(32, 32);
+    blue.fill(Qt::blue);
+    m_windowInterface->setIcon(blue);
+    QTRY_COMPARE(m_window->icon().pixmap(32, 32), blue);
+    otherWindowInterface->unmap();
+    QSignalSpy unmappedSpy(otherWindow.data(), &PlasmaWindow::unmapped);
+    QVERIFY(unmappedSpy.wait());
+    QCOMPARE(otherWindow->icon().pixmap(32, 32), p);
+}
+
+void TestWindowManagement::testSameContent()
+{
+    using namespace KWayland::Client;
+    // icons created separately with the same pixmap, and the same app id
+    QPixmap p(32, 32);
+    p.fill(Qt::green);
+    QScopedPointer<KWaylandServer::PlasmaWindowInterface> firstWindowInterface(m_windowManagementInterface->createWindow(this, QUuid::createUuid()));
+    firstWindowInterface->setAppId(QStringLiteral("org.kde.foo"));
+    firstWindowInterface->setIcon(QIcon(p));
+    QScopedPointer<KWaylandServer::PlasmaWindowInterface> otherWindowInterface(m_windowManagementInterface->createWindow(this, QUuid::createUuid()));
+    otherWindowInterface->setAppId(QStringLiteral("org.kde.foo"));
+    otherWindowInterface->setIcon(QIcon(p.copy()));
+    QSignalSpy windowSpy(m_windowManagement, &PlasmaWindowManagement::windowCreated);
+    QVERIFY(windowSpy.isValid());
+    QTRY_COMPARE(windowSpy.count(), 2);
+    QScopedPointer<PlasmaWindow> firstWindow(windowSpy.first().first().value<PlasmaWindow *>());
+    QScopedPointer<PlasmaWindow> otherWindow(windowSpy.last().first().value<PlasmaWindow *>());
+    QTRY_COMPARE(firstWindow->appId(), QStringLiteral("org.kde.foo"));
+    QTRY_COMPARE(otherWindow->appId(), QStringLiteral("org.kde.foo"));
+    QTRY_COMPARE(firstWindow->icon().pixmap(32, 32).toImage(), p.toImage());
+
+    // destroying the first window doesn't drop what the other one still uses
+    QSignalSpy unmappedSpy(firstWindow.data(), &PlasmaWindow::unmapped);
+    QVERIFY(unmappedSpy.isValid());
+    firstWindowInterface.reset();
+    QVERIFY(unmappedSpy.wait());
+    otherWindowInterface->setTitle(QStringLiteral("other"));
+    QTRY_COMPARE(otherWindow->title(), QStringLiteral("other"));
+    QCOMPARE(otherWindow->appId(), QStringLiteral("org.kde.foo"));
+    QTRY_COMPARE(otherWindow->icon().pixmap(32, 32).toImage(), p.toImage());
+
+    // and the app id is sent anew once it changes
+    otherWindowInterface->setAppId(QStringLiteral("org.kde.bar"));
+    QTRY_COMPARE(otherWindow->appId(), QStringLiteral("org.kde.bar"));
+}
+
+void TestWindowManagement::testReplaceIcon()
+{
+    using namespace KWayland::Client;
+    QSignalSpy iconChangedSpy(m_window, &PlasmaWindow::iconChanged);
+    QVERIFY(iconChangedSpy.isValid());
+    QVERIFY(iconChangedSpy.wait());
+
+    QPixmap red(32, 32);
+    red.fill(Qt::red);
+    QIcon icon(red);
+    m_windowInterface->setIcon(icon);
+    QTRY_COMPARE(m_window->icon().pixmap(32, 32), red);
+
+    // a window never gets the bytes of the icon it had before
+    QPixmap green(32, 32);
+    green.fill(Qt::green);
+    icon = QIcon(green);
+    m_windowInterface->setIcon(icon);
+    QTRY_COMPARE(m_window->icon().pixmap(32, 32), green);
+
+    // nor the ones of an icon replaced while it is still being serialized
+    QPixmap blue(32, 32);
+    blue.fill(Qt::blue);
+    m_windowInterface->setIcon(QIcon(red));
+    m_windowInterface->setIcon(QIcon(blue));
+    QTRY_COMPARE(m_window->icon().pixmap(32, 32), blue);
+
+    // an icon whose entry got dropped is serialized again
+    m_windowInterface->setIcon(icon);
+    QTRY_COMPARE(m_window->icon().pixmap(32, 32), green);
+}
+
 void TestWindowManagement::testPid()
 {
     using namespace KWayland::Client;
@@ -649,5 +784,51 @@ void TestWindowManagement::testApplicationMenu()
     QCOMPARE(m_window->applicationMenuObjectPath(), objectPath);
 }
 
+static quint64 windowEvents(KWaylandServer::Display *display, const QByteArray &message)
+{
+    quint64 events = 0;
+    const KWaylandServer::ProtocolStatistics statistics = display->protocolStatistics();
+    for (const KWaylandServer::ProtocolMessageStatistics &statistic : statistics) {
+        if (statistic.interface == QByteArrayLiteral("org_kde_plasma_window") && statistic.message == message) {
+            events += statistic.count;
+        }
+    }
+    return events;
+}
+
+void TestWindowManagement::testBatchedUpdate()
+{
+    using namespace KWayland::Client;
+    // this test verifies that the changes of a batch are sent with one event per property
+    m_display->setProtocolStatisticsEnabled(true);
+    QSignalSpy maximizedChangedSpy(m_window, &PlasmaWindow::maximizedChanged);
+    QSignalSpy titleChangedSpy(m_window, &PlasmaWindow::titleChanged);
+
+    m_windowInterface->beginUpdate();
+    m_windowInterface->setKeepAbove(true);
+    m_windowInterface->setOnAllDesktops(true);
+    m_windowInterface->beginUpdate();
+    m_windowInterface->setMaximized(true);
+    m_windowInterface->setTitle(QStringLiteral("foo"));
+    m_windowInterface->setTitle(QStringLiteral("bar"));
+    m_windowInterface->commitUpdate();
+    m_windowInterface->setGeometry(QRect(0, 0, 100, 50));
+    // nothing is sent before the outermost commit
+    QVERIFY(!maximizedChangedSpy.wait(100));
+    QCOMPARE(windowEvents(m_display, QByteArrayLiteral("state_changed")), 0u);
+    m_windowInterface->commitUpdate();
+
+    QVERIFY(maximizedChangedSpy.wait());
+    QVERIFY(m_window->isKeepAbove());
+    QVERIFY(m_window->isOnAllDesktops());
+    QTRY_COMPARE(m_window->title(), QStringLiteral("bar"));
+    QTRY_COMPARE(m_window->geometry(), QRect(0, 0, 100, 50));
+    QCOMPARE(titleChangedSpy.count(), 1);
+    QCOMPARE(windowEvents(m_display, QByteArrayLiteral("state_changed")), 1u);
+    QCOMPARE(windowEvents(m_display, QByteArrayLiteral("title_changed")), 1u);
+    QCOMPARE(windowEvents(m_display, QByteArrayLiteral("geometry")), 1u);
+    m_display->setProtocolStatisticsEnabled(false);
+}
+
 QTEST_MAIN(TestWindowManagement)
 #include "test_wayland_windowmanagement.moc"
@@ -37,6 +37,7 @@ private Q_SLOTS:
     void testDeleteExported();
     void testExportTwoTimes();
     void testImportTwoTimes();
+    void testReparentChild();
 
 private:
     void doExport();
@@ -359,5 +360,35 @@ void TestForeign::testImportTwoTimes()
     QCOMPARE(m_foreignInterface->transientFor(childSurface2Interface), m_exportedSurfaceInterface.data());
 }
 
+void TestForeign::testReparentChild()
+{
+    doExport();
+
+    QSignalSpy transientSpy(m_foreignInterface, &KWaylandServer::XdgForeignV2Interface::transientChanged);
+    QVERIFY(transientSpy.isValid());
+
+    //Import the exported window another time and make it the parent of the same child
+    KWayland::Client::XdgImported *imported2 = m_importer->importTopLevel(m_exported->handle());
+    QVERIFY(imported2->isValid());
+    imported2->setParentOf(m_childSurface);
+    QVERIFY(transientSpy.wait());
+    QCOMPARE(transientSpy.last().first().value<KWaylandServer::SurfaceInterface *>(), m_childSurfaceInterface.data());
+    QCOMPARE(transientSpy.last().at(1).value<KWaylandServer::SurfaceInterface *>(), m_exportedSurfaceInterface.data());
+
+    //Deleting the first import must not break the relationship set up by the second one,
+    //only the destruction of the child resets it
+    transientSpy.clear();
+    m_imported->deleteLater();
+    m_imported = nullptr;
+    m_childSurface->deleteLater();
+    m_childSurface = nullptr;
+    QVERIFY(transientSpy.wait());
+    QCOMPARE(transientSpy.count(), 1);
+    QVERIFY(!transientSpy.first().first().value<KWaylandServer::SurfaceInterface *>());
+    QCOMPARE(transientSpy.first().at(1).value<KWaylandServer::SurfaceInterface *>(), m_exportedSurfaceInterface.data());
+
+    delete imported2;
+}
+
 QTEST_GUILESS_MAIN(TestForeign)
 #include "test_xdg_foreign.moc"
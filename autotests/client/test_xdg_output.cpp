@@ -28,6 +28,7 @@ private Q_SLOTS:
     void init();
     void cleanup();
     void testChanges();
+    void testUnchangedGeometry();
 private:
     KWaylandServer::Display *m_display;
     KWaylandServer::OutputInterface *m_serverOutput;
@@ -163,5 +164,62 @@ void TestXdgOutput::testChanges()
     QCOMPARE(xdgOutput->logicalSize(), QSize(100,200));
 }
 
+void TestXdgOutput::testUnchangedGeometry()
+{
+    using namespace KWayland::Client;
+    KWayland::Client::Registry registry;
+    QSignalSpy announced(&registry, &Registry::outputAnnounced);
+    QSignalSpy xdgOutputAnnounced(&registry, &Registry::xdgOutputAnnounced);
+
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(announced.wait());
+    if (xdgOutputAnnounced.count() != 1) {
+        QVERIFY(xdgOutputAnnounced.wait());
+    }
+
+    KWayland::Client::Output output;
+    QSignalSpy outputChanged(&output, &KWayland::Client::Output::changed);
+    output.setup(registry.bindOutput(announced.first().first().value<quint32>(), announced.first().last().value<quint32>()));
+    QVERIFY(outputChanged.wait());
+
+    QScopedPointer<XdgOutputManager> xdgOutputManager(registry.createXdgOutputManager(xdgOutputAnnounced.first().first().value<quint32>(), xdgOutputAnnounced.first().last().value<quint32>(), this));
+    QScopedPointer<XdgOutput> xdgOutput(xdgOutputManager->getXdgOutput(&output, this));
+    QSignalSpy xdgOutputChanged(xdgOutput.data(), &XdgOutput::changed);
+    QVERIFY(xdgOutputChanged.wait());
+    xdgOutputChanged.clear();
+
+    // nothing differs from what the client got, so nothing is sent
+    m_serverXdgOutput->setLogicalSize(QSize(640, 480));
+    m_serverXdgOutput->setLogicalSize(QSize(1280, 720));
+    m_serverXdgOutput->done();
+    QVERIFY(!xdgOutputChanged.wait(100));
+
+    // only the final geometry of a batch is sent
+    m_serverXdgOutput->beginUpdate();
+    m_serverXdgOutput->setLogicalPosition(QPoint(100, 200));
+    m_serverXdgOutput->done();
+    m_serverXdgOutput->setLogicalPosition(QPoint(300, 400));
+    m_serverXdgOutput->done();
+    m_serverXdgOutput->commitUpdate();
+    QVERIFY(xdgOutputChanged.wait());
+    QVERIFY(!xdgOutputChanged.wait(100));
+    QCOMPARE(xdgOutputChanged.count(), 1);
+    QCOMPARE(xdgOutput->logicalPosition(), QPoint(300, 400));
+    QCOMPARE(xdgOutput->logicalSize(), QSize(1280, 720));
+
+    // a batch without done() submits nothing, the changes go out with the next done()
+    xdgOutputChanged.clear();
+    m_serverXdgOutput->beginUpdate();
+    m_serverXdgOutput->setLogicalPosition(QPoint(500, 600));
+    m_serverXdgOutput->commitUpdate();
+    QVERIFY(!xdgOutputChanged.wait(100));
+    m_serverXdgOutput->done();
+    QVERIFY(xdgOutputChanged.wait());
+    QCOMPARE(xdgOutput->logicalPosition(), QPoint(500, 600));
+}
+
 QTEST_GUILESS_MAIN(TestXdgOutput)
 #include "test_xdg_output.moc"
@@ -18,6 +18,7 @@
 #include "KWayland/Client/shm_pool.h"
 #include "KWayland/Client/surface.h"
 // server
+#include "../../src/server/clientconnection.h"
 #include "../../src/server/display.h"
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/output_interface.h"
@@ -52,10 +53,13 @@ private Q_SLOTS:
     void testResize();
     void testTransient();
     void testPing();
+    void testPingAll();
     void testClose();
     void testConfigureStates_data();
     void testConfigureStates();
     void testConfigureMultipleAcks();
+    void testConfigureRepeatedStates();
+    void testConfigureCoalescing();
 
 private:
     XdgShellInterface *m_xdgShellInterface = nullptr;
@@ -473,6 +477,33 @@ void XdgShellTest::testPing()
     QVERIFY(pingTimeoutSpy.wait());
 }
 
+void XdgShellTest::testPingAll()
+{
+    // this test verifies that all clients with an xdg-surface get pinged in one go
+    SURFACE
+
+    QSignalSpy pongSpy(m_xdgShellInterface, &XdgShellInterface::pongReceived);
+    const QHash<ClientConnection *, quint32> serials = m_xdgShellInterface->pingAll();
+    QCOMPARE(serials.count(), 1);
+    QCOMPARE(serials.constBegin().key(), serverXdgToplevel->surface()->client());
+    QVERIFY(pongSpy.wait());
+    QCOMPARE(pongSpy.takeFirst().at(0).value<quint32>(), serials.constBegin().value());
+
+    // unanswered pings of a batch are delayed and time out individually
+    disconnect(m_connection, &ConnectionThread::eventsRead, m_queue, &EventQueue::dispatch);
+    QSignalSpy pingDelayedSpy(m_xdgShellInterface, &XdgShellInterface::pingDelayed);
+    QSignalSpy pingTimeoutSpy(m_xdgShellInterface, &XdgShellInterface::pingTimeout);
+    const quint32 first = m_xdgShellInterface->pingAll().value(serverXdgToplevel->surface()->client());
+    const quint32 second = m_xdgShellInterface->ping(serverXdgToplevel->xdgSurface());
+    QTRY_COMPARE(pingDelayedSpy.count(), 2);
+    QCOMPARE(pingDelayedSpy.at(0).at(0).value<quint32>(), first);
+    QCOMPARE(pingDelayedSpy.at(1).at(0).value<quint32>(), second);
+    QTRY_COMPARE(pingTimeoutSpy.count(), 2);
+    QCOMPARE(pingTimeoutSpy.at(0).at(0).value<quint32>(), first);
+    QCOMPARE(pingTimeoutSpy.at(1).at(0).value<quint32>(), second);
+    QCOMPARE(pongSpy.count(), 0);
+}
+
 void XdgShellTest::testClose()
 {
     // this test verifies that a close request is sent to the client
@@ -606,5 +637,72 @@ void XdgShellTest::testConfigureMultipleAcks()
     QCOMPARE(xdgSurface->size(), QSize(30, 40));
 }
 
+void XdgShellTest::testConfigureRepeatedStates()
+{
+    qRegisterMetaType<XdgShellSurface::States>();
+    // this test verifies that the states array reused across configures follows changes of the states
+    SURFACE
+
+    QSignalSpy configureSpy(xdgSurface.data(), &XdgShellSurface::configureRequested);
+    QVERIFY(configureSpy.isValid());
+
+    const XdgToplevelInterface::States activated = XdgToplevelInterface::State::Activated;
+    const XdgToplevelInterface::States resizing = activated | XdgToplevelInterface::State::Resizing;
+    serverXdgToplevel->sendConfigure(QSize(10, 20), resizing);
+    serverXdgToplevel->sendConfigure(QSize(20, 30), resizing);
+    serverXdgToplevel->sendConfigure(QSize(30, 40), activated);
+    serverXdgToplevel->sendConfigure(QSize(30, 40), XdgToplevelInterface::States());
+    QTRY_COMPARE(configureSpy.count(), 4);
+
+    const XdgShellSurface::States clientActivated = XdgShellSurface::State::Activated;
+    const XdgShellSurface::States clientResizing = clientActivated | XdgShellSurface::State::Resizing;
+    QCOMPARE(configureSpy.at(0).at(1).value<XdgShellSurface::States>(), clientResizing);
+    QCOMPARE(configureSpy.at(1).at(1).value<XdgShellSurface::States>(), clientResizing);
+    QCOMPARE(configureSpy.at(2).at(1).value<XdgShellSurface::States>(), clientActivated);
+    QCOMPARE(configureSpy.at(3).at(1).value<XdgShellSurface::States>(), XdgShellSurface::States());
+}
+
+void XdgShellTest::testConfigureCoalescing()
+{
+    // this test verifies that only one configure is in flight with coalescing enabled
+    SURFACE
+
+    QSignalSpy configureSpy(xdgSurface.data(), &XdgShellSurface::configureRequested);
+    QSignalSpy ackSpy(serverXdgToplevel->xdgSurface(), &XdgSurfaceInterface::configureAcknowledged);
+    QSignalSpy configureSentSpy(serverXdgToplevel, &XdgToplevelInterface::configureSent);
+
+    serverXdgToplevel->setConfigureCoalescingEnabled(true);
+    QVERIFY(serverXdgToplevel->isConfigureCoalescingEnabled());
+    const quint32 serial1 = serverXdgToplevel->sendConfigure(QSize(10, 20), XdgToplevelInterface::State::Resizing);
+    QVERIFY(serial1);
+    QCOMPARE(serverXdgToplevel->sendConfigure(QSize(20, 30), XdgToplevelInterface::State::Resizing), 0u);
+    QCOMPARE(serverXdgToplevel->sendConfigure(QSize(30, 40), XdgToplevelInterface::State::Resizing), 0u);
+    QCOMPARE(configureSentSpy.count(), 1);
+
+    QVERIFY(configureSpy.wait());
+    QVERIFY(!configureSpy.wait(100));
+    QCOMPARE(configureSpy.count(), 1);
+    QCOMPARE(configureSpy.last().at(0).toSize(), QSize(10, 20));
+
+    // acknowledging sends the latest deferred size
+    xdgSurface->ackConfigure(serial1);
+    QVERIFY(ackSpy.wait());
+    QCOMPARE(configureSentSpy.count(), 2);
+    const quint32 serial2 = configureSentSpy.last().at(0).value<quint32>();
+    QCOMPARE(configureSentSpy.last().at(1).toSize(), QSize(30, 40));
+    QVERIFY(configureSpy.wait());
+    QCOMPARE(configureSpy.count(), 2);
+    QCOMPARE(configureSpy.last().at(0).toSize(), QSize(30, 40));
+    QCOMPARE(configureSpy.last().at(2).value<quint32>(), serial2);
+
+    // disabling coalescing flushes the deferred configure
+    QCOMPARE(serverXdgToplevel->sendConfigure(QSize(40, 50), XdgToplevelInterface::States()), 0u);
+    serverXdgToplevel->setConfigureCoalescingEnabled(false);
+    QCOMPARE(configureSentSpy.count(), 3);
+    QVERIFY(configureSpy.wait());
+    QCOMPARE(configureSpy.last().at(0).toSize(), QSize(40, 50));
+    QVERIFY(serverXdgToplevel->sendConfigure(QSize(50, 60), XdgToplevelInterface::States()));
+}
+
 QTEST_GUILESS_MAIN(XdgShellTest)
 #include "test_xdg_shell.moc"
@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "benchmarkhelpers.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+static std::atomic<quint64> s_allocations(0);
+static std::atomic<qint64> s_liveAllocations(0);
+
+void *operator new(std::size_t size)
+{
+    if (void *p = std::malloc(size ? size : 1)) {
+        s_allocations++;
+        s_liveAllocations++;
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept
+{
+    if (p) {
+        s_liveAllocations--;
+        std::free(p);
+    }
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    if (p) {
+        s_liveAllocations--;
+        std::free(p);
+    }
+}
+
+namespace BenchmarkHelpers
+{
+
+quint64 allocationCount()
+{
+    return s_allocations;
+}
+
+qint64 liveAllocationCount()
+{
+    return s_liveAllocations;
+}
+
+const wl_registry_listener RegistryListener::s_listener = {
+    globalCallback,
+    globalRemoveCallback
+};
+
+void RegistryListener::listen(wl_registry *registry, GlobalCallback global, GlobalRemoveCallback globalRemove)
+{
+    m_global = std::move(global);
+    m_globalRemove = std::move(globalRemove);
+    wl_registry_add_listener(registry, &s_listener, this);
+}
+
+void RegistryListener::globalCallback(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    auto listener = static_cast<RegistryListener *>(data);
+    if (listener->m_global) {
+        listener->m_global(registry, name, interface, version);
+    }
+}
+
+void RegistryListener::globalRemoveCallback(void *data, wl_registry *registry, uint32_t name)
+{
+    Q_UNUSED(registry)
+    auto listener = static_cast<RegistryListener *>(data);
+    if (listener->m_globalRemove) {
+        listener->m_globalRemove(name);
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include <QtGlobal>
+
+#include <wayland-client.h>
+
+#include <functional>
+
+/**
+ * Helpers shared by the benchmarks which drive plain libwayland clients from the test thread.
+ *
+ * Linking benchmarkhelpers.cpp into a test replaces the global operator new and delete of the
+ * process with ones counting the allocations, including the ones inside the library.
+ **/
+namespace BenchmarkHelpers
+{
+
+/**
+ * @returns the number of allocations the process made so far.
+ **/
+quint64 allocationCount();
+
+/**
+ * @returns the number of allocations which haven't been freed yet, a cycle that leaks shows
+ * up as growth.
+ **/
+qint64 liveAllocationCount();
+
+/**
+ * Calls the given callbacks for the events of a wl_registry. The registry has to be destroyed
+ * before the listener and the listener must not be moved while it listens.
+ **/
+class RegistryListener
+{
+public:
+    using GlobalCallback = std::function<void(wl_registry *registry, uint32_t name, const char *interface, uint32_t version)>;
+    using GlobalRemoveCallback = std::function<void(uint32_t name)>;
+
+    /**
+     * Adds the listener to @p registry, a null @p globalRemove ignores the removed globals.
+     **/
+    void listen(wl_registry *registry, GlobalCallback global, GlobalRemoveCallback globalRemove = GlobalRemoveCallback());
+
+private:
+    static void globalCallback(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+    static void globalRemoveCallback(void *data, wl_registry *registry, uint32_t name);
+    static const wl_registry_listener s_listener;
+
+    GlobalCallback m_global;
+    GlobalRemoveCallback m_globalRemove;
+};
+
+}
@@ -0,0 +1,199 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/buffer_interface.h"
+#include "../../src/server/clientconnection.h"
+#include "../../src/server/display.h"
+// Wayland
+#include <wayland-server.h>
+// system
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class TestBufferInterface : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testLookup();
+    void testDestroy();
+    void testCoalescedRelease();
+    void benchmarkAttach_data();
+    void benchmarkAttach();
+};
+
+static ClientConnection *createConnection(Display *display, QVector<int> *sockets)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        return nullptr;
+    }
+    sockets->append(sv[1]);
+    return display->createClient(sv[0]);
+}
+
+void TestBufferInterface::testLookup()
+{
+    Display display;
+    display.start();
+    QVector<int> sockets;
+    ClientConnection *connection = createConnection(&display, &sockets);
+    QVERIFY(connection);
+
+    wl_resource *resource = connection->createResource(&wl_buffer_interface, 1, 0);
+    QVERIFY(resource);
+
+    BufferInterface *buffer = BufferInterface::get(&display, resource);
+    QVERIFY(buffer);
+    QCOMPARE(buffer->resource(), resource);
+    // looking up the same resource again must return the same instance
+    QCOMPARE(BufferInterface::get(&display, resource), buffer);
+
+    wl_resource *otherResource = connection->createResource(&wl_buffer_interface, 1, 0);
+    QVERIFY(otherResource);
+    BufferInterface *otherBuffer = BufferInterface::get(&display, otherResource);
+    QVERIFY(otherBuffer);
+    QVERIFY(otherBuffer != buffer);
+    QCOMPARE(BufferInterface::get(&display, resource), buffer);
+
+    QCOMPARE(BufferInterface::get(&display, nullptr), nullptr);
+
+    connection->destroy();
+    for (int fd : qAsConst(sockets)) {
+        close(fd);
+    }
+}
+
+void TestBufferInterface::testDestroy()
+{
+    Display display;
+    display.start();
+    QVector<int> sockets;
+    ClientConnection *connection = createConnection(&display, &sockets);
+    QVERIFY(connection);
+
+    wl_resource *resource = connection->createResource(&wl_buffer_interface, 1, 0);
+    QVERIFY(resource);
+    BufferInterface *buffer = BufferInterface::get(&display, resource);
+    QVERIFY(buffer);
+
+    QSignalSpy destroyedSpy(buffer, &BufferInterface::aboutToBeDestroyed);
+    QVERIFY(destroyedSpy.isValid());
+    QPointer<BufferInterface> guard(buffer);
+    wl_resource_destroy(resource);
+    QCOMPARE(destroyedSpy.count(), 1);
+    QVERIFY(guard.isNull());
+
+    connection->destroy();
+    for (int fd : qAsConst(sockets)) {
+        close(fd);
+    }
+}
+
+void TestBufferInterface::testCoalescedRelease()
+{
+    Display display;
+    display.start();
+    QVector<int> sockets;
+    ClientConnection *connection = createConnection(&display, &sockets);
+    QVERIFY(connection);
+    ClientConnection *otherConnection = createConnection(&display, &sockets);
+    QVERIFY(otherConnection);
+
+    QVector<BufferInterface *> buffers;
+    for (int i = 0; i < 8; ++i) {
+        wl_resource *resource = connection->createResource(&wl_buffer_interface, 1, 0);
+        QVERIFY(resource);
+        buffers << BufferInterface::get(&display, resource);
+    }
+    wl_resource *otherResource = otherConnection->createResource(&wl_buffer_interface, 1, 0);
+    QVERIFY(otherResource);
+    buffers << BufferInterface::get(&display, otherResource);
+
+    for (BufferInterface *buffer : qAsConst(buffers)) {
+        buffer->ref();
+    }
+    QCOMPARE(display.bufferReleaseCount(), 0u);
+    for (BufferInterface *buffer : qAsConst(buffers)) {
+        buffer->unref();
+    }
+    // eight releases of the first client share one flush, the other client needs its own
+    QCOMPARE(display.bufferReleaseCount(), 9u);
+    QCOMPARE(display.coalescedBufferReleaseCount(), 7u);
+
+    // once flushed, the next release needs a flush again
+    QVERIFY(QMetaObject::invokeMethod(&display, "flush"));
+    buffers.first()->ref();
+    buffers.first()->unref();
+    QCOMPARE(display.bufferReleaseCount(), 10u);
+    QCOMPARE(display.coalescedBufferReleaseCount(), 7u);
+
+    connection->destroy();
+    otherConnection->destroy();
+    for (int fd : qAsConst(sockets)) {
+        close(fd);
+    }
+}
+
+void TestBufferInterface::benchmarkAttach_data()
+{
+    QTest::addColumn<int>("clientCount");
+
+    QTest::newRow("1 client") << 1;
+    QTest::newRow("10 clients") << 10;
+    QTest::newRow("40 clients") << 40;
+    QTest::newRow("100 clients") << 100;
+}
+
+void TestBufferInterface::benchmarkAttach()
+{
+    // Every client triple-buffers, the lookup happens on every wl_surface.attach
+    static const int buffersPerClient = 3;
+    QFETCH(int, clientCount);
+
+    Display display;
+    display.start();
+    QVector<int> sockets;
+    QVector<ClientConnection *> connections;
+    QVector<wl_resource *> resources;
+    for (int i = 0; i < clientCount; ++i) {
+        ClientConnection *connection = createConnection(&display, &sockets);
+        QVERIFY(connection);
+        connections << connection;
+        for (int j = 0; j < buffersPerClient; ++j) {
+            wl_resource *resource = connection->createResource(&wl_buffer_interface, 1, 0);
+            QVERIFY(resource);
+            QVERIFY(BufferInterface::get(&display, resource));
+            resources << resource;
+        }
+    }
+
+    QElapsedTimer timer;
+    qint64 attachCount = 0;
+    timer.start();
+    QBENCHMARK {
+        for (wl_resource *resource : qAsConst(resources)) {
+            BufferInterface::get(&display, resource);
+        }
+        attachCount += resources.count();
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    qInfo("%d clients: %.1f ns/attach", clientCount, double(elapsed) / qMax<qint64>(attachCount, 1));
+
+    for (ClientConnection *connection : qAsConst(connections)) {
+        connection->destroy();
+    }
+    for (int fd : qAsConst(sockets)) {
+        close(fd);
+    }
+}
+
+QTEST_GUILESS_MAIN(TestBufferInterface)
+#include "test_buffer_interface.moc"
@@ -0,0 +1,155 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/contenttype_v1_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-content-type-v1.h"
+
+using namespace KWaylandServer;
+
+class ContentTypeManager : public QtWayland::wp_content_type_manager_v1
+{
+};
+
+class TestContentTypeInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestContentTypeInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testContentType();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    ContentTypeManager *m_contentTypeManager = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-contenttype-test-0");
+
+void TestContentTypeInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new ContentTypeManagerV1Interface(&m_display, this);
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_content_type_manager_v1")) {
+            m_contentTypeManager = new ContentTypeManager();
+            m_contentTypeManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_contentTypeManager);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(),
+                                                    compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+}
+
+TestContentTypeInterface::~TestContentTypeInterface()
+{
+    delete m_contentTypeManager;
+    m_contentTypeManager = nullptr;
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestContentTypeInterface::testContentType()
+{
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto surface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QCOMPARE(surface->contentType(), ContentType::None);
+
+    QSignalSpy committedSpy(surface, &SurfaceInterface::committed);
+    QSignalSpy contentTypeChangedSpy(surface, &SurfaceInterface::contentTypeChanged);
+    QtWayland::wp_content_type_v1 contentType(m_contentTypeManager->get_surface_content_type(*clientSurface));
+
+    // the content type is double-buffered
+    contentType.set_content_type(QtWayland::wp_content_type_v1::type_game);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(contentTypeChangedSpy.wait());
+    QCOMPARE(surface->contentType(), ContentType::Game);
+
+    // setting the same content type again doesn't change it
+    contentType.set_content_type(QtWayland::wp_content_type_v1::type_game);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(contentTypeChangedSpy.count(), 1);
+
+    contentType.set_content_type(QtWayland::wp_content_type_v1::type_video);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(contentTypeChangedSpy.wait());
+    QCOMPARE(surface->contentType(), ContentType::Video);
+
+    // destroying the content type object resets it with the next commit
+    contentType.destroy();
+    m_connection->flush();
+    QVERIFY(!contentTypeChangedSpy.wait(100));
+    QCOMPARE(surface->contentType(), ContentType::Video);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(contentTypeChangedSpy.wait());
+    QCOMPARE(surface->contentType(), ContentType::None);
+}
+
+QTEST_GUILESS_MAIN(TestContentTypeInterface)
+#include "test_contenttype_v1_interface.moc"
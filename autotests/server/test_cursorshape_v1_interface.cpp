@@ -0,0 +1,212 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QImage>
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/cursorshape_v1_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/pointer_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/pointer.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/seat.h"
+#include "KWayland/Client/shm_pool.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-cursor-shape-v1.h"
+
+using namespace KWaylandServer;
+
+class CursorShapeManager : public QtWayland::wp_cursor_shape_manager_v1
+{
+};
+
+class TestCursorShapeInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestCursorShapeInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPointerShape();
+    void testInvalidShape();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+    KWayland::Client::Seat *m_clientSeat = nullptr;
+    KWayland::Client::ShmPool *m_shm = nullptr;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    SeatInterface *m_serverSeat;
+    CursorShapeManager *m_cursorShapeManager = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-cursorshape-test-0");
+
+void TestCursorShapeInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+    m_display.createShm();
+
+    new CursorShapeManagerV1Interface(&m_display, this);
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+    m_serverSeat = new SeatInterface(&m_display, this);
+    m_serverSeat->setHasPointer(true);
+    m_serverSeat->create();
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_cursor_shape_manager_v1")) {
+            m_cursorShapeManager = new CursorShapeManager();
+            m_cursorShapeManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_cursorShapeManager);
+
+    m_clientCompositor = registry->createCompositor(registry->interface(KWayland::Client::Registry::Interface::Compositor).name,
+                                                    registry->interface(KWayland::Client::Registry::Interface::Compositor).version, this);
+    QVERIFY(m_clientCompositor->isValid());
+    m_shm = registry->createShmPool(registry->interface(KWayland::Client::Registry::Interface::Shm).name,
+                                    registry->interface(KWayland::Client::Registry::Interface::Shm).version, this);
+    QVERIFY(m_shm->isValid());
+    m_clientSeat = registry->createSeat(registry->interface(KWayland::Client::Registry::Interface::Seat).name,
+                                        registry->interface(KWayland::Client::Registry::Interface::Seat).version, this);
+    QSignalSpy hasPointerSpy(m_clientSeat, &KWayland::Client::Seat::hasPointerChanged);
+    QVERIFY(hasPointerSpy.wait());
+}
+
+TestCursorShapeInterface::~TestCursorShapeInterface()
+{
+    delete m_cursorShapeManager;
+    m_cursorShapeManager = nullptr;
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestCursorShapeInterface::testPointerShape()
+{
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto surface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+
+    QScopedPointer<KWayland::Client::Pointer> pointer(m_clientSeat->createPointer());
+    QSignalSpy enteredSpy(pointer.data(), &KWayland::Client::Pointer::entered);
+    m_serverSeat->setFocusedPointerSurface(surface);
+    QVERIFY(enteredSpy.wait());
+    const quint32 serial = enteredSpy.first().first().value<quint32>();
+    PointerInterface *serverPointer = m_serverSeat->focusedPointer();
+    QVERIFY(serverPointer);
+
+    // setting a shape creates the cursor without any surface
+    QSignalSpy cursorChangedSpy(serverPointer, &PointerInterface::cursorChanged);
+    QtWayland::wp_cursor_shape_device_v1 device(m_cursorShapeManager->get_pointer(*pointer));
+    device.set_shape(serial, QtWayland::wp_cursor_shape_device_v1::shape_text);
+    QVERIFY(cursorChangedSpy.wait());
+    Cursor *cursor = serverPointer->cursor();
+    QVERIFY(cursor);
+    QCOMPARE(cursor->shape(), QStringLiteral("text"));
+    QCOMPARE(cursor->enteredSerial(), serial);
+    QVERIFY(!cursor->surface());
+    QCOMPARE(cursor->imageKey(), quint64(0));
+
+    QSignalSpy shapeChangedSpy(cursor, &Cursor::shapeChanged);
+    device.set_shape(serial, QtWayland::wp_cursor_shape_device_v1::shape_ew_resize);
+    QVERIFY(shapeChangedSpy.wait());
+    QCOMPARE(cursor->shape(), QStringLiteral("ew-resize"));
+
+    // setting the same shape again doesn't change anything
+    QSignalSpy changedSpy(cursor, &Cursor::changed);
+    device.set_shape(serial, QtWayland::wp_cursor_shape_device_v1::shape_ew_resize);
+    device.set_shape(serial, QtWayland::wp_cursor_shape_device_v1::shape_pointer);
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(changedSpy.count(), 1);
+    QCOMPARE(cursor->shape(), QStringLiteral("pointer"));
+
+    // a cursor surface replaces the shape
+    QImage image(QSize(8, 8), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::green);
+    QScopedPointer<KWayland::Client::Surface> cursorSurface(m_clientCompositor->createSurface(this));
+    cursorSurface->attachBuffer(m_shm->createBuffer(image));
+    cursorSurface->damage(image.rect());
+    cursorSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    pointer->setCursor(cursorSurface.data(), QPoint(1, 1));
+    QVERIFY(shapeChangedSpy.wait());
+    QVERIFY(cursor->shape().isEmpty());
+    QVERIFY(cursor->surface());
+    QVERIFY(cursor->imageKey() != 0);
+
+    // and the other way around
+    device.set_shape(serial, QtWayland::wp_cursor_shape_device_v1::shape_default);
+    QVERIFY(shapeChangedSpy.wait());
+    QCOMPARE(cursor->shape(), QStringLiteral("default"));
+    QVERIFY(!cursor->surface());
+    QCOMPARE(cursor->hotspot(), QPoint());
+    QCOMPARE(cursor->imageKey(), quint64(0));
+
+    device.destroy();
+    m_serverSeat->setFocusedPointerSurface(nullptr);
+}
+
+void TestCursorShapeInterface::testInvalidShape()
+{
+    QScopedPointer<KWayland::Client::Pointer> pointer(m_clientSeat->createPointer());
+    QtWayland::wp_cursor_shape_device_v1 device(m_cursorShapeManager->get_pointer(*pointer));
+
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    device.set_shape(0, 0);
+    QVERIFY(errorSpy.wait());
+}
+
+QTEST_GUILESS_MAIN(TestCursorShapeInterface)
+
+#include "test_cursorshape_v1_interface.moc"
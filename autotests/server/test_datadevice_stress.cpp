@@ -0,0 +1,544 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QSocketNotifier>
+#include <QThread>
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/abstract_data_source.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/datacontroldevicemanager_v1_interface.h"
+#include "../../src/server/datadevicemanager_interface.h"
+#include "../../src/server/datatransfermonitor.h"
+#include "../../src/server/display.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+// KWayland
+#include <KWayland/Client/compositor.h>
+#include <KWayland/Client/connection_thread.h>
+#include <KWayland/Client/datadevice.h>
+#include <KWayland/Client/datadevicemanager.h>
+#include <KWayland/Client/dataoffer.h>
+#include <KWayland/Client/event_queue.h>
+#include <KWayland/Client/keyboard.h>
+#include <KWayland/Client/registry.h>
+#include <KWayland/Client/seat.h>
+#include <KWayland/Client/surface.h>
+
+#include "qwayland-wlr-data-control-unstable-v1.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+static const QString s_socketName = QStringLiteral("kwayland-test-datadevice-stress-0");
+
+// copy and paste cycles per data row
+static const int s_cycles = 50;
+// how long a single step of a cycle may take before the benchmark gives up
+static const int s_timeout = 5000;
+
+/**
+ * A selection set by the compositor, which writes the same payload for all its mime types
+ * without blocking the event loop.
+ **/
+class PayloadSource : public AbstractDataSource
+{
+    Q_OBJECT
+public:
+    PayloadSource(const QStringList &mimeTypes, const QByteArray &payload)
+        : m_mimeTypes(mimeTypes)
+        , m_payload(payload)
+    {
+    }
+    ~PayloadSource() override
+    {
+        emit aboutToBeDestroyed();
+        for (const Writer &writer : qAsConst(m_writers)) {
+            delete writer.notifier;
+            close(writer.fd);
+        }
+    }
+
+    void requestData(const QString &mimeType, qint32 fd) override
+    {
+        Q_UNUSED(mimeType)
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        m_writers << Writer{fd, 0, nullptr};
+        write(m_writers.count() - 1);
+    }
+    void cancel() override
+    {
+    }
+    QStringList mimeTypes() const override
+    {
+        return m_mimeTypes;
+    }
+
+private:
+    struct Writer
+    {
+        int fd;
+        int offset;
+        QSocketNotifier *notifier;
+    };
+
+    void write(int index)
+    {
+        Writer &writer = m_writers[index];
+        while (writer.offset < m_payload.size()) {
+            const ssize_t count = ::write(writer.fd, m_payload.constData() + writer.offset, m_payload.size() - writer.offset);
+            if (count > 0) {
+                writer.offset += count;
+                continue;
+            }
+            if (count < 0 && errno == EINTR) {
+                continue;
+            }
+            if (count < 0 && errno == EAGAIN) {
+                if (!writer.notifier) {
+                    const int fd = writer.fd;
+                    writer.notifier = new QSocketNotifier(fd, QSocketNotifier::Write, this);
+                    connect(writer.notifier, &QSocketNotifier::activated, this, [this, fd] {
+                        for (int i = 0; i < m_writers.count(); ++i) {
+                            if (m_writers.at(i).fd == fd) {
+                                write(i);
+                                return;
+                            }
+                        }
+                    });
+                }
+                return;
+            }
+            break;
+        }
+        if (writer.notifier) {
+            writer.notifier->setEnabled(false);
+            writer.notifier->deleteLater();
+        }
+        close(writer.fd);
+        m_writers.removeAt(index);
+    }
+
+    QStringList m_mimeTypes;
+    QByteArray m_payload;
+    QVector<Writer> m_writers;
+};
+
+class DataControlDeviceManager : public QtWayland::zwlr_data_control_manager_v1
+{
+public:
+    ~DataControlDeviceManager()
+    {
+        destroy();
+    }
+};
+
+class DataControlOffer : public QtWayland::zwlr_data_control_offer_v1
+{
+public:
+    explicit DataControlOffer(struct ::zwlr_data_control_offer_v1 *id)
+        : QtWayland::zwlr_data_control_offer_v1(id)
+    {
+    }
+    ~DataControlOffer()
+    {
+        destroy();
+    }
+};
+
+/**
+ * A clipboard manager which listens to all selections without ever pasting them.
+ **/
+class DataControlDevice : public QtWayland::zwlr_data_control_device_v1
+{
+public:
+    ~DataControlDevice()
+    {
+        qDeleteAll(m_offers);
+        destroy();
+    }
+
+    int offerCount = 0;
+    int selectionCount = 0;
+
+protected:
+    void zwlr_data_control_device_v1_data_offer(struct ::zwlr_data_control_offer_v1 *id) override
+    {
+        m_offers << new DataControlOffer(id);
+        offerCount++;
+    }
+    void zwlr_data_control_device_v1_selection(struct ::zwlr_data_control_offer_v1 *id) override
+    {
+        // only the offer of the new selection is still of use
+        for (auto it = m_offers.begin(); it != m_offers.end();) {
+            if ((*it)->object() != id) {
+                delete *it;
+                it = m_offers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        selectionCount++;
+    }
+
+private:
+    QVector<DataControlOffer *> m_offers;
+};
+
+/**
+ * Measures copy and paste cycles of compositor selections with a varying number of mime
+ * types, payload sizes and data control clients listening in. A cycle sets a new selection,
+ * waits until the focused client and all listeners got its offer and then pastes it in the
+ * focused client. The latency of the announcement and of the paste, the offers created and
+ * the bytes copied are reported per data row.
+ **/
+class TestDataDeviceStress : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkCopyPaste_data();
+    void benchmarkCopyPaste();
+
+private:
+    struct Connection
+    {
+        KWayland::Client::ConnectionThread *connection = nullptr;
+        KWayland::Client::EventQueue *queue = nullptr;
+        KWayland::Client::Registry *registry = nullptr;
+        KWayland::Client::Seat *seat = nullptr;
+        DataControlDeviceManager *dataControlDeviceManager = nullptr;
+        DataControlDevice *dataControlDevice = nullptr;
+    };
+    bool setupConnection(Connection *c);
+    void cleanupConnection(Connection *c);
+    template<typename Condition>
+    bool waitFor(Condition condition);
+
+    Display m_display;
+    SeatInterface *m_seat = nullptr;
+    QThread *m_thread = nullptr;
+
+    Connection m_paster;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::DataDeviceManager *m_dataDeviceManager = nullptr;
+    KWayland::Client::DataDevice *m_dataDevice = nullptr;
+    KWayland::Client::Keyboard *m_keyboard = nullptr;
+    KWayland::Client::Surface *m_surface = nullptr;
+    QVector<Connection *> m_listeners;
+};
+
+void TestDataDeviceStress::initTestCase()
+{
+    // a paste which gets cut short must not end the benchmark
+    signal(SIGPIPE, SIG_IGN);
+
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasKeyboard(true);
+    m_seat->create();
+    CompositorInterface *compositor = new CompositorInterface(&m_display, this);
+    new DataDeviceManagerInterface(&m_display, this);
+    new DataControlDeviceManagerV1Interface(&m_display, this);
+
+    // all connections share one thread, the events are dispatched on the main thread
+    m_thread = new QThread(this);
+    m_thread->start();
+
+    QVERIFY(setupConnection(&m_paster));
+    using Interface = KWayland::Client::Registry::Interface;
+    KWayland::Client::Registry *registry = m_paster.registry;
+    m_compositor = registry->createCompositor(registry->interface(Interface::Compositor).name,
+                                              registry->interface(Interface::Compositor).version, this);
+    m_dataDeviceManager = registry->createDataDeviceManager(registry->interface(Interface::DataDeviceManager).name,
+                                                            registry->interface(Interface::DataDeviceManager).version, this);
+    QVERIFY(m_dataDeviceManager->isValid());
+
+    QSignalSpy hasKeyboardSpy(m_paster.seat, &KWayland::Client::Seat::hasKeyboardChanged);
+    QVERIFY(hasKeyboardSpy.wait());
+    m_keyboard = m_paster.seat->createKeyboard(this);
+    m_dataDevice = m_dataDeviceManager->getDataDevice(m_paster.seat, this);
+    QVERIFY(m_dataDevice->isValid());
+
+    QSignalSpy surfaceCreatedSpy(compositor, &CompositorInterface::surfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    QSignalSpy keyboardEnteredSpy(m_keyboard, &KWayland::Client::Keyboard::entered);
+    m_seat->setFocusedKeyboardSurface(surfaceCreatedSpy.first().first().value<SurfaceInterface *>());
+    QVERIFY(keyboardEnteredSpy.wait());
+}
+
+void TestDataDeviceStress::cleanupTestCase()
+{
+    for (Connection *listener : qAsConst(m_listeners)) {
+        cleanupConnection(listener);
+        delete listener;
+    }
+    m_listeners.clear();
+    delete m_surface;
+    delete m_dataDevice;
+    delete m_keyboard;
+    delete m_dataDeviceManager;
+    delete m_compositor;
+    cleanupConnection(&m_paster);
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+    }
+}
+
+bool TestDataDeviceStress::setupConnection(Connection *c)
+{
+    c->connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(c->connection, &KWayland::Client::ConnectionThread::connected);
+    c->connection->setSocketName(s_socketName);
+    c->connection->moveToThread(m_thread);
+    c->connection->initConnection();
+    if (!connectedSpy.wait()) {
+        return false;
+    }
+
+    c->queue = new KWayland::Client::EventQueue(this);
+    c->queue->setup(c->connection);
+
+    c->registry = new KWayland::Client::Registry(this);
+    quint32 dataControlName = 0;
+    quint32 dataControlVersion = 0;
+    connect(c->registry, &KWayland::Client::Registry::interfaceAnnounced, this,
+            [&dataControlName, &dataControlVersion](const QByteArray &interface, quint32 name, quint32 version) {
+                if (interface == "zwlr_data_control_manager_v1") {
+                    dataControlName = name;
+                    dataControlVersion = version;
+                }
+            });
+    QSignalSpy interfacesAnnouncedSpy(c->registry, &KWayland::Client::Registry::interfacesAnnounced);
+    c->registry->setEventQueue(c->queue);
+    c->registry->create(c->connection);
+    c->registry->setup();
+    if (!interfacesAnnouncedSpy.wait()) {
+        return false;
+    }
+    disconnect(c->registry, &KWayland::Client::Registry::interfaceAnnounced, this, nullptr);
+
+    using Interface = KWayland::Client::Registry::Interface;
+    c->seat = c->registry->createSeat(c->registry->interface(Interface::Seat).name,
+                                      c->registry->interface(Interface::Seat).version, this);
+    if (!c->seat->isValid()) {
+        return false;
+    }
+    if (dataControlName == 0) {
+        return false;
+    }
+    c->dataControlDeviceManager = new DataControlDeviceManager;
+    c->dataControlDeviceManager->init(c->registry->registry(), dataControlName, dataControlVersion);
+    return true;
+}
+
+void TestDataDeviceStress::cleanupConnection(Connection *c)
+{
+    delete c->dataControlDevice;
+    c->dataControlDevice = nullptr;
+    delete c->dataControlDeviceManager;
+    c->dataControlDeviceManager = nullptr;
+    delete c->seat;
+    c->seat = nullptr;
+    delete c->registry;
+    c->registry = nullptr;
+    delete c->queue;
+    c->queue = nullptr;
+    if (c->connection) {
+        c->connection->deleteLater();
+        c->connection = nullptr;
+    }
+}
+
+template<typename Condition>
+bool TestDataDeviceStress::waitFor(Condition condition)
+{
+    // the display flushes its clients whenever the event loop is about to block, so this
+    // has to block rather than spin, the timer only bounds the wait
+    QTimer tick;
+    tick.start(100);
+    QElapsedTimer timer;
+    timer.start();
+    while (!condition()) {
+        if (timer.elapsed() > s_timeout) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+    }
+    return true;
+}
+
+void TestDataDeviceStress::benchmarkCopyPaste_data()
+{
+    QTest::addColumn<int>("mimeTypeCount");
+    QTest::addColumn<int>("payloadSize");
+    QTest::addColumn<int>("listenerCount");
+    QTest::addColumn<bool>("monitored");
+    QTest::addColumn<bool>("persistent");
+
+    QTest::addRow("1 type, 64 B") << 1 << 64 << 0 << false << false;
+    QTest::addRow("32 types, 64 B") << 32 << 64 << 0 << false << false;
+    QTest::addRow("1 type, 4 KiB") << 1 << 4 * 1024 << 0 << false << false;
+    QTest::addRow("1 type, 1 MiB") << 1 << 1024 * 1024 << 0 << false << false;
+    QTest::addRow("8 types, 4 KiB, 4 listeners") << 8 << 4 * 1024 << 4 << false << false;
+    QTest::addRow("32 types, 64 B, 16 listeners") << 32 << 64 << 16 << false << false;
+    QTest::addRow("8 types, 4 KiB, 16 listeners") << 8 << 4 * 1024 << 16 << false << false;
+    QTest::addRow("1 type, 1 MiB, monitored") << 1 << 1024 * 1024 << 0 << true << false;
+    QTest::addRow("8 types, 4 KiB, 4 listeners, monitored") << 8 << 4 * 1024 << 4 << true << false;
+    QTest::addRow("1 type, 1 MiB, persistent") << 1 << 1024 * 1024 << 0 << false << true;
+    QTest::addRow("8 types, 4 KiB, 4 listeners, persistent") << 8 << 4 * 1024 << 4 << false << true;
+}
+
+void TestDataDeviceStress::benchmarkCopyPaste()
+{
+    QFETCH(int, mimeTypeCount);
+    QFETCH(int, payloadSize);
+    QFETCH(int, listenerCount);
+    QFETCH(bool, monitored);
+    QFETCH(bool, persistent);
+
+    // the listeners are kept for the following data rows, they only ever grow
+    while (m_listeners.count() < listenerCount) {
+        auto listener = new Connection;
+        m_listeners << listener;
+        QVERIFY(setupConnection(listener));
+        listener->dataControlDevice = new DataControlDevice;
+        listener->dataControlDevice->init(listener->dataControlDeviceManager->get_data_device(*listener->seat));
+        listener->connection->flush();
+    }
+    // the surplus listeners of earlier rows only drop their devices
+    for (int i = 0; i < m_listeners.count(); ++i) {
+        Connection *listener = m_listeners.at(i);
+        if (i >= listenerCount && listener->dataControlDevice) {
+            delete listener->dataControlDevice;
+            listener->dataControlDevice = nullptr;
+            listener->connection->flush();
+        } else if (i < listenerCount && !listener->dataControlDevice) {
+            listener->dataControlDevice = new DataControlDevice;
+            listener->dataControlDevice->init(listener->dataControlDeviceManager->get_data_device(*listener->seat));
+            listener->connection->flush();
+        }
+    }
+    const QVector<Connection *> listeners = m_listeners.mid(0, listenerCount);
+    // let the server register the data control devices
+    QTest::qWait(100);
+
+    QScopedPointer<DataTransferMonitor> monitor;
+    if (monitored) {
+        monitor.reset(new DataTransferMonitor(&m_display));
+    }
+    if (persistent) {
+        m_seat->setPersistentSelectionMimeTypes({QStringLiteral("*/*")});
+    }
+
+    QStringList mimeTypes;
+    for (int i = 0; i < mimeTypeCount; ++i) {
+        mimeTypes << QStringLiteral("application/x-kwayland-stress-%1").arg(i);
+    }
+    const QByteArray payload(payloadSize, 'x');
+
+    int pasterOffers = 0;
+    connect(m_dataDevice, &KWayland::Client::DataDevice::selectionOffered, this, [&pasterOffers] {
+        pasterOffers++;
+    });
+    int listenerOffers = 0;
+    for (const Connection *listener : listeners) {
+        listenerOffers -= listener->dataControlDevice->offerCount;
+    }
+
+    QScopedPointer<PayloadSource> source;
+    qint64 announceTime = 0;
+    qint64 pasteTime = 0;
+    qint64 bytes = 0;
+    int cycles = 0;
+    int expectedOffers = pasterOffers;
+    QBENCHMARK {
+        for (int i = 0; i < s_cycles; ++i) {
+            QVector<int> selections;
+            for (const Connection *listener : listeners) {
+                selections << listener->dataControlDevice->selectionCount;
+            }
+
+            QElapsedTimer timer;
+            timer.start();
+            QScopedPointer<PayloadSource> next(new PayloadSource(mimeTypes, payload));
+            m_seat->setSelection(next.data());
+            source.swap(next);
+            next.reset();
+            expectedOffers++;
+            QVERIFY(waitFor([&] {
+                if (pasterOffers < expectedOffers) {
+                    return false;
+                }
+                for (int j = 0; j < listeners.count(); ++j) {
+                    if (listeners.at(j)->dataControlDevice->selectionCount == selections.at(j)) {
+                        return false;
+                    }
+                }
+                return true;
+            }));
+            announceTime += timer.nsecsElapsed();
+
+            KWayland::Client::DataOffer *offer = m_dataDevice->offeredSelection();
+            QVERIFY(offer);
+            int pipeFds[2];
+            QVERIFY(pipe2(pipeFds, O_CLOEXEC | O_NONBLOCK) == 0);
+            timer.start();
+            offer->receive(mimeTypes.last(), pipeFds[1]);
+            close(pipeFds[1]);
+            m_paster.connection->flush();
+
+            qint64 received = 0;
+            bool complete = false;
+            QSocketNotifier notifier(pipeFds[0], QSocketNotifier::Read);
+            connect(&notifier, &QSocketNotifier::activated, this, [&] {
+                char buffer[64 * 1024];
+                ssize_t count;
+                while ((count = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+                    received += count;
+                }
+                complete = count == 0 || errno != EAGAIN;
+            });
+            QVERIFY(waitFor([&complete] {
+                return complete;
+            }));
+            notifier.setEnabled(false);
+            close(pipeFds[0]);
+            pasteTime += timer.nsecsElapsed();
+            QCOMPARE(received, qint64(payloadSize));
+            bytes += received;
+            cycles++;
+        }
+    }
+
+    for (const Connection *listener : listeners) {
+        listenerOffers += listener->dataControlDevice->offerCount;
+    }
+    disconnect(m_dataDevice, &KWayland::Client::DataDevice::selectionOffered, this, nullptr);
+    m_seat->setSelection(nullptr);
+    source.reset();
+    m_seat->setPersistentSelectionMimeTypes({});
+
+    qInfo("%d cycles: %.1f us per announcement, %.1f us per paste, %.1f offers per cycle, %lld bytes copied",
+          cycles,
+          announceTime / 1e3 / qMax(cycles, 1),
+          pasteTime / 1e3 / qMax(cycles, 1),
+          double(pasterOffers + listenerOffers) / qMax(cycles, 1),
+          bytes);
+}
+
+QTEST_GUILESS_MAIN(TestDataDeviceStress)
+#include "test_datadevice_stress.moc"
@@ -0,0 +1,190 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+#include <QTemporaryFile>
+#include <QThread>
+// WaylandServer
+#include "../../src/server/datatransferrelay.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class TestDataTransferRelay : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testTransfer_data();
+    void testTransfer();
+    void testClosedSink();
+    void testSourceOffset();
+};
+
+static QByteArray createData(int size)
+{
+    QByteArray data(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        data[i] = char(i * 7 + i / 256);
+    }
+    return data;
+}
+
+void TestDataTransferRelay::testTransfer_data()
+{
+    QTest::addColumn<int>("size");
+    QTest::addColumn<bool>("cached");
+
+    QTest::newRow("empty") << 0 << false;
+    QTest::newRow("small") << 13 << false;
+    QTest::newRow("large") << 4 * 1024 * 1024 + 17 << false;
+    QTest::newRow("small cached") << 13 << true;
+    QTest::newRow("large cached") << 4 * 1024 * 1024 + 17 << true;
+}
+
+void TestDataTransferRelay::testTransfer()
+{
+    // this test verifies that the relay passes all the data on, also when the sink is slower
+    QFETCH(int, size);
+    QFETCH(bool, cached);
+    const QByteArray data = createData(size);
+
+    int source[2];
+    int sink[2];
+    QVERIFY(pipe2(source, O_CLOEXEC) == 0);
+    QVERIFY(pipe2(sink, O_CLOEXEC) == 0);
+
+    DataTransferRelay relay;
+    QTemporaryFile cache;
+    if (cached) {
+        QVERIFY(cache.open());
+        relay.setCacheFd(dup(cache.handle()));
+    }
+    QSignalSpy finishedSpy(&relay, &DataTransferRelay::finished);
+    QVERIFY(finishedSpy.isValid());
+    QVERIFY(relay.start(source[0], sink[1]));
+    QVERIFY(relay.isActive());
+
+    // the source client and the receiving client
+    const int writeFd = source[1];
+    QScopedPointer<QThread> writer(QThread::create([&data, writeFd] {
+        const int fd = writeFd;
+        for (int offset = 0; offset < data.size();) {
+            const ssize_t count = write(fd, data.constData() + offset, qMin(data.size() - offset, 100000));
+            if (count <= 0) {
+                break;
+            }
+            offset += count;
+        }
+        close(fd);
+    }));
+    QByteArray received;
+    const int readFd = sink[0];
+    QScopedPointer<QThread> reader(QThread::create([&received, readFd] {
+        const int fd = readFd;
+        char buffer[8192];
+        ssize_t count;
+        while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+            received.append(buffer, count);
+            // a receiver which takes its time
+            if (received.size() % 3 == 0) {
+                usleep(10);
+            }
+        }
+        close(fd);
+    }));
+    writer->start();
+    reader->start();
+
+    QVERIFY(finishedSpy.wait());
+    QVERIFY(writer->wait());
+    QVERIFY(reader->wait());
+    QCOMPARE(finishedSpy.first().first().toBool(), true);
+    QVERIFY(!relay.isActive());
+    QCOMPARE(received.size(), data.size());
+    QVERIFY(received == data);
+    QCOMPARE(relay.bytesTransferred(), quint64(size));
+    QVERIFY(relay.elapsed() > 0);
+    if (size) {
+        QVERIFY(relay.throughput() > 0);
+    }
+
+    if (cached) {
+        QCOMPARE(relay.bytesCached(), quint64(size));
+        QVERIFY(cache.seek(0));
+        QVERIFY(cache.readAll() == data);
+    } else {
+        QCOMPARE(relay.bytesCached(), quint64(0));
+    }
+}
+
+void TestDataTransferRelay::testClosedSink()
+{
+    // this test verifies that a receiver going away fails the relay instead of the process
+    int source[2];
+    int sink[2];
+    QVERIFY(pipe2(source, O_CLOEXEC) == 0);
+    QVERIFY(pipe2(sink, O_CLOEXEC) == 0);
+    close(sink[0]);
+
+    DataTransferRelay relay;
+    QSignalSpy finishedSpy(&relay, &DataTransferRelay::finished);
+    QVERIFY(finishedSpy.isValid());
+    QVERIFY(relay.start(source[0], sink[1]));
+
+    const QByteArray data = createData(1000);
+    QCOMPARE(write(source[1], data.constData(), data.size()), ssize_t(data.size()));
+    QVERIFY(finishedSpy.wait());
+    QCOMPARE(finishedSpy.first().first().toBool(), false);
+    QCOMPARE(relay.bytesTransferred(), quint64(0));
+    close(source[1]);
+
+    // a relay is only used once
+    QVERIFY(pipe2(source, O_CLOEXEC) == 0);
+    QVERIFY(!relay.start(source[0], source[1]));
+}
+
+void TestDataTransferRelay::testSourceOffset()
+{
+    // this test verifies that relays sharing a file read it from their own offsets
+    const QByteArray data = createData(1000);
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QCOMPARE(file.write(data), qint64(data.size()));
+    QVERIFY(file.flush());
+
+    int sinks[2][2];
+    QVERIFY(pipe2(sinks[0], O_CLOEXEC) == 0);
+    QVERIFY(pipe2(sinks[1], O_CLOEXEC) == 0);
+    DataTransferRelay first;
+    DataTransferRelay second;
+    QSignalSpy firstFinishedSpy(&first, &DataTransferRelay::finished);
+    QVERIFY(firstFinishedSpy.isValid());
+    QSignalSpy secondFinishedSpy(&second, &DataTransferRelay::finished);
+    QVERIFY(secondFinishedSpy.isValid());
+    first.setSourceOffset(0);
+    second.setSourceOffset(100);
+    QVERIFY(first.start(dup(file.handle()), sinks[0][1]));
+    QVERIFY(second.start(dup(file.handle()), sinks[1][1]));
+    QVERIFY(firstFinishedSpy.wait());
+    if (secondFinishedSpy.isEmpty()) {
+        QVERIFY(secondFinishedSpy.wait());
+    }
+    QCOMPARE(firstFinishedSpy.first().first().toBool(), true);
+    QCOMPARE(secondFinishedSpy.first().first().toBool(), true);
+
+    char buffer[2048];
+    QCOMPARE(read(sinks[0][0], buffer, sizeof(buffer)), ssize_t(data.size()));
+    QVERIFY(QByteArray(buffer, data.size()) == data);
+    QCOMPARE(read(sinks[1][0], buffer, sizeof(buffer)), ssize_t(data.size() - 100));
+    QVERIFY(QByteArray(buffer, data.size() - 100) == data.mid(100));
+    close(sinks[0][0]);
+    close(sinks[1][0]);
+}
+
+QTEST_GUILESS_MAIN(TestDataTransferRelay)
+#include "test_datatransferrelay.moc"
@@ -10,7 +10,11 @@
 #include "../../src/server/clientconnection.h"
 #include "../../src/server/outputmanagement_interface.h"
 #include "../../src/server/output_interface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/protocolreplayer.h"
+#include "../../src/server/protocoltracer.h"
 // Wayland
+#include <wayland-client.h>
 #include <wayland-server.h>
 // system
 #include <sys/types.h>
@@ -27,9 +31,21 @@ private Q_SLOTS:
     void testStartStop();
     void testAddRemoveOutput();
     void testClientConnection();
+    void testTearDown();
     void testConnectNoSocket();
+    void testCreateClients();
     void testOutputManagement();
     void testAutoSocketName();
+    void testInputLatencyHistogram();
+    void testFlushAfterDispatch();
+    void testClientCongestion();
+    void testProtocolStatistics();
+    void testProtocolTracer();
+    void testClientRequestBudget();
+    void testProtocolEventLog();
+    void testProtocolRecording();
+    void testClientMemoryAccounting();
+    void testPerformanceSnapshot();
 };
 
 void TestWaylandServerDisplay::testSocketName()
@@ -116,6 +132,11 @@ void TestWaylandServerDisplay::testClientConnection()
     QVERIFY(connection->groupId() != 0);
     QVERIFY(connection->processId() != 0);
     QCOMPARE(connection->display(), &display);
+    if (!connection->isCredentialsReady()) {
+        QSignalSpy credentialsReadySpy(connection, &ClientConnection::credentialsReady);
+        QVERIFY(credentialsReadySpy.wait());
+    }
+    QVERIFY(connection->isCredentialsReady());
     QCOMPARE(connection->executablePath(), QCoreApplication::applicationFilePath());
     QCOMPARE((wl_client*)*connection, client);
     const ClientConnection &constRef = *connection;
@@ -161,6 +182,36 @@ void TestWaylandServerDisplay::testClientConnection()
     QVERIFY(display.connections().isEmpty());
 }
 
+void TestWaylandServerDisplay::testTearDown()
+{
+    QScopedPointer<Display> display(new Display);
+    display->addSocketName(QStringLiteral("kwin-wayland-server-display-test-tear-down"));
+    display->start();
+    QVERIFY(!display->isTearingDown());
+
+    int fds[2][2];
+    for (auto &sv : fds) {
+        QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+        QVERIFY(display->createClient(sv[0]));
+    }
+    QCOMPARE(display->connections().count(), 2);
+
+    // the clients are still announced as disconnected, but not removed one by one
+    int disconnected = 0;
+    Display *displayPointer = display.data();
+    connect(displayPointer, &Display::clientDisconnected, this, [displayPointer, &disconnected] {
+        QVERIFY(displayPointer->isTearingDown());
+        QVERIFY(displayPointer->connections().isEmpty());
+        disconnected++;
+    });
+    display.reset();
+    QCOMPARE(disconnected, 2);
+
+    for (auto &sv : fds) {
+        close(sv[1]);
+    }
+}
+
 void TestWaylandServerDisplay::testConnectNoSocket()
 {
     Display display;
@@ -178,6 +229,50 @@ void TestWaylandServerDisplay::testConnectNoSocket()
     close(sv[1]);
 }
 
+void TestWaylandServerDisplay::testCreateClients()
+{
+    Display display;
+    display.start();
+    QVERIFY(display.isRunning());
+    qRegisterMetaType<QVector<ClientConnection *>>();
+    QSignalSpy connectedSpy(&display, &Display::clientConnected);
+    QSignalSpy clientsConnectedSpy(&display, &Display::clientsConnected);
+
+    QVector<int> serverFds;
+    QVector<int> clientFds;
+    for (int i = 0; i < 3; ++i) {
+        int sv[2];
+        QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+        serverFds << sv[0];
+        clientFds << sv[1];
+    }
+    const QVector<ClientConnection *> connections = display.createClients(serverFds);
+    QCOMPARE(connections.count(), 3);
+    QCOMPARE(display.connections(), connections);
+    QVERIFY(connectedSpy.isEmpty());
+    QCOMPARE(clientsConnectedSpy.count(), 1);
+    QCOMPARE(clientsConnectedSpy.first().first().value<QVector<ClientConnection *>>(), connections);
+    for (int i = 0; i < connections.count(); ++i) {
+        QCOMPARE(display.getConnection(connections[i]->client()), connections[i]);
+        QCOMPARE(connections[i]->processId(), getpid());
+    }
+    QVERIFY(connectedSpy.isEmpty());
+
+    // an empty batch does not announce anything
+    QVERIFY(display.createClients({}).isEmpty());
+    QCOMPARE(clientsConnectedSpy.count(), 1);
+
+    QSignalSpy disconnectedSpy(&display, &Display::clientDisconnected);
+    for (ClientConnection *connection : connections) {
+        wl_client_destroy(connection->client());
+    }
+    QCOMPARE(disconnectedSpy.count(), 3);
+    QVERIFY(display.connections().isEmpty());
+    for (int fd : serverFds + clientFds) {
+        close(fd);
+    }
+}
+
 void TestWaylandServerDisplay::testOutputManagement()
 {
     Display display;
@@ -211,6 +306,534 @@ void TestWaylandServerDisplay::testAutoSocketName()
     QCOMPARE(socketNameChangedSpy1.count(), 1);
 }
 
+void TestWaylandServerDisplay::testInputLatencyHistogram()
+{
+    InputLatencyHistogram histogram;
+    QCOMPARE(histogram.count(), 0u);
+    QCOMPARE(histogram.percentile(0.5), 0);
+
+    histogram.addSample(500);
+    histogram.addSample(3000);
+    histogram.addSample(1000000);
+    QCOMPARE(histogram.count(), 3u);
+    QCOMPARE(histogram.bucket(0), 1u);
+    QCOMPARE(histogram.bucket(1), 1u);
+    QCOMPARE(histogram.bucket(9), 1u);
+    QCOMPARE(histogram.minimum(), 500);
+    QCOMPARE(histogram.maximum(), 1000000);
+    QCOMPARE(histogram.mean(), 334500);
+    // the median lies in the [2, 4) µs bucket
+    QCOMPARE(histogram.percentile(0.5), 4000);
+    QCOMPARE(histogram.percentile(1.0), 1000000);
+
+    InputLatencyHistogram other;
+    other.addSample(100);
+    histogram += other;
+    QCOMPARE(histogram.count(), 4u);
+    QCOMPARE(histogram.bucket(0), 2u);
+    QCOMPARE(histogram.minimum(), 100);
+
+    Display display;
+    QVERIFY(!display.isInputLatencyTrackingEnabled());
+    display.setInputLatencyTrackingEnabled(true);
+    QVERIFY(display.isInputLatencyTrackingEnabled());
+    QCOMPARE(display.inputLatency(InputLatencyEventType::Key).count(), 0u);
+}
+
+void TestWaylandServerDisplay::testFlushAfterDispatch()
+{
+    Display display;
+    QVERIFY(!display.flushesAfterDispatch());
+    display.setFlushAfterDispatch(true);
+    QVERIFY(display.flushesAfterDispatch());
+    display.start();
+
+    // dispatching now flushes the connected clients as well
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    auto client = display.createClient(sv[0]);
+    QVERIFY(client);
+    display.dispatchEvents();
+
+    wl_client_destroy(client->client());
+    close(sv[0]);
+    close(sv[1]);
+}
+void TestWaylandServerDisplay::testClientCongestion()
+{
+    Display display;
+    display.start();
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *client = display.createClient(sv[0]);
+    QVERIFY(client);
+    QCOMPARE(client->highWaterMark(), 0);
+    QVERIFY(!client->isCongested());
+
+    QSignalSpy congestedSpy(client, &ClientConnection::congested);
+    QVERIFY(congestedSpy.isValid());
+    QSignalSpy decongestedSpy(client, &ClientConnection::decongested);
+    QVERIFY(decongestedSpy.isValid());
+    client->setHighWaterMark(1);
+    QCOMPARE(client->highWaterMark(), 1);
+
+    // the other end of the socket never reads, so the event stays queued
+    wl_resource *callback = wl_resource_create(client->client(), &wl_callback_interface, 1, 0);
+    QVERIFY(callback);
+    wl_callback_send_done(callback, 0);
+    client->flush();
+    QVERIFY(client->queuedBytes() > 1);
+    QVERIFY(client->isCongested());
+    QCOMPARE(congestedSpy.count(), 1);
+
+    char buffer[64];
+    QVERIFY(read(sv[1], buffer, sizeof(buffer)) > 0);
+    client->flush();
+    QCOMPARE(client->queuedBytes(), 0);
+    QVERIFY(!client->isCongested());
+    QCOMPARE(decongestedSpy.count(), 1);
+
+    // catching up is noticed without another flush of the client
+    wl_callback_send_done(callback, 0);
+    client->flush();
+    QVERIFY(client->isCongested());
+    QCOMPARE(congestedSpy.count(), 2);
+    QVERIFY(read(sv[1], buffer, sizeof(buffer)) > 0);
+    QVERIFY(decongestedSpy.wait());
+    QVERIFY(!client->isCongested());
+    QCOMPARE(decongestedSpy.count(), 2);
+
+    wl_client_destroy(client->client());
+    close(sv[0]);
+    close(sv[1]);
+}
+void TestWaylandServerDisplay::testProtocolStatistics()
+{
+    Display display;
+    display.start();
+    QVERIFY(!display.isProtocolStatisticsEnabled());
+    display.setProtocolStatisticsEnabled(true);
+    QVERIFY(display.isProtocolStatisticsEnabled());
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *client = display.createClient(sv[0]);
+    QVERIFY(client);
+    QVERIFY(display.protocolStatistics(client).isEmpty());
+
+    wl_resource *callback = wl_resource_create(client->client(), &wl_callback_interface, 1, 0);
+    QVERIFY(callback);
+    wl_callback_send_done(callback, 0);
+    wl_callback_send_done(callback, 1);
+
+    const ProtocolStatistics statistics = display.protocolStatistics(client);
+    QCOMPARE(statistics.count(), 1);
+    QCOMPARE(statistics.first().client, client);
+    QCOMPARE(statistics.first().interface, QByteArrayLiteral("wl_callback"));
+    QCOMPARE(statistics.first().message, QByteArrayLiteral("done"));
+    QCOMPARE(statistics.first().opcode, 0u);
+    QCOMPARE(statistics.first().direction, ProtocolMessageStatistics::Direction::Event);
+    QCOMPARE(statistics.first().count, 2u);
+    // header and one uint argument per message
+    QCOMPARE(statistics.first().bytes, 24u);
+    QCOMPARE(display.protocolStatistics().count(), 1);
+
+    display.resetProtocolStatistics();
+    QVERIFY(display.protocolStatistics().isEmpty());
+
+    display.setProtocolStatisticsEnabled(false);
+    wl_callback_send_done(callback, 2);
+    QVERIFY(display.protocolStatistics().isEmpty());
+
+    wl_client_destroy(client->client());
+    close(sv[0]);
+    close(sv[1]);
+}
+
+class RecordingTracer : public ProtocolTracer
+{
+public:
+    void beginRequest(const char *interface, const char *request) override
+    {
+        requests << QByteArray(interface) + QByteArrayLiteral(".") + QByteArray(request);
+        depth++;
+    }
+    void endRequest(const char *interface, const char *request) override
+    {
+        Q_UNUSED(interface)
+        Q_UNUSED(request)
+        depth--;
+    }
+
+    QByteArrayList requests;
+    int depth = 0;
+};
+
+static void tracerRegistryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    Q_UNUSED(version)
+    if (qstrcmp(interface, wl_compositor_interface.name) == 0) {
+        *static_cast<wl_compositor **>(data) = static_cast<wl_compositor *>(wl_registry_bind(registry, name, &wl_compositor_interface, 1));
+    }
+}
+
+static void tracerRegistryGlobalRemove(void *data, wl_registry *registry, uint32_t name)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(registry)
+    Q_UNUSED(name)
+}
+
+static const wl_registry_listener s_tracerRegistryListener = {
+    tracerRegistryGlobal,
+    tracerRegistryGlobalRemove
+};
+
+void TestWaylandServerDisplay::testProtocolTracer()
+{
+    if (!ProtocolTracer::isSupported()) {
+        QSKIP("Built without KWAYLANDSERVER_TRACING");
+    }
+    QVERIFY(!ProtocolTracer::tracer());
+
+    Display display;
+    QVERIFY(display.start());
+    new CompositorInterface(&display, &display);
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+    QVERIFY(display.createClient(sv[0]));
+    wl_display *clientDisplay = wl_display_connect_to_fd(sv[1]);
+    QVERIFY(clientDisplay);
+    wl_compositor *compositor = nullptr;
+    wl_registry *registry = wl_display_get_registry(clientDisplay);
+    wl_registry_add_listener(registry, &s_tracerRegistryListener, &compositor);
+    wl_display_flush(clientDisplay);
+    display.dispatchEvents();
+    wl_display_flush_clients(display);
+    QVERIFY(wl_display_dispatch(clientDisplay) >= 0);
+    QVERIFY(compositor);
+
+    {
+        RecordingTracer tracer;
+        ProtocolTracer::setTracer(&tracer);
+        QCOMPARE(ProtocolTracer::tracer(), &tracer);
+
+        wl_region *region = wl_compositor_create_region(compositor);
+        wl_region_add(region, 0, 0, 10, 10);
+        wl_region_destroy(region);
+        wl_display_flush(clientDisplay);
+        display.dispatchEvents();
+
+        QCOMPARE(tracer.requests, QByteArrayList({
+            QByteArrayLiteral("wl_compositor.create_region"),
+            QByteArrayLiteral("wl_region.add"),
+            QByteArrayLiteral("wl_region.destroy"),
+        }));
+        QCOMPARE(tracer.depth, 0);
+    }
+    // destroying the installed tracer uninstalls it
+    QVERIFY(!ProtocolTracer::tracer());
+
+    wl_compositor_destroy(compositor);
+    wl_registry_destroy(registry);
+    wl_display_disconnect(clientDisplay);
+}
+
+void TestWaylandServerDisplay::testClientRequestBudget()
+{
+    Display display;
+    QVERIFY(display.start());
+    new CompositorInterface(&display, &display);
+    QCOMPARE(display.clientRequestBudget(), 0);
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+    ClientConnection *client = display.createClient(sv[0]);
+    QVERIFY(client);
+    wl_display *clientDisplay = wl_display_connect_to_fd(sv[1]);
+    QVERIFY(clientDisplay);
+    wl_compositor *compositor = nullptr;
+    wl_registry *registry = wl_display_get_registry(clientDisplay);
+    wl_registry_add_listener(registry, &s_tracerRegistryListener, &compositor);
+    wl_display_flush(clientDisplay);
+    display.dispatchEvents();
+    wl_display_flush_clients(display);
+    QVERIFY(wl_display_dispatch(clientDisplay) >= 0);
+    QVERIFY(compositor);
+    // nothing is accounted without a budget
+    QCOMPARE(client->requestCpuTime(), 0);
+
+    display.setClientRequestBudget(5);
+    QCOMPARE(display.clientRequestBudget(), 5);
+    QSignalSpy exceededSpy(&display, &Display::clientRequestBudgetExceeded);
+
+    // a client flooding the compositor within a single dispatch
+    for (int i = 0; i < 10; ++i) {
+        wl_region_destroy(wl_compositor_create_region(compositor));
+    }
+    wl_display_flush(clientDisplay);
+    display.dispatchEvents();
+    QCOMPARE(exceededSpy.count(), 1);
+    QCOMPARE(exceededSpy.first().at(0).value<ClientConnection *>(), client);
+    QCOMPARE(exceededSpy.first().at(1).toInt(), 20);
+    QCOMPARE(client->requestBudgetExceededCount(), 1u);
+    const qint64 cpuTime = client->requestCpuTime();
+    QVERIFY(cpuTime > 0);
+
+    // within the budget the requests are only accounted
+    wl_region_destroy(wl_compositor_create_region(compositor));
+    wl_display_flush(clientDisplay);
+    display.dispatchEvents();
+    QCOMPARE(exceededSpy.count(), 1);
+    QCOMPARE(client->requestBudgetExceededCount(), 1u);
+    QVERIFY(client->requestCpuTime() >= cpuTime);
+
+    display.setClientRequestBudget(0);
+    QCOMPARE(display.clientRequestBudget(), 0);
+
+    wl_compositor_destroy(compositor);
+    wl_registry_destroy(registry);
+    wl_display_disconnect(clientDisplay);
+}
+
+void TestWaylandServerDisplay::testProtocolEventLog()
+{
+    Display display;
+    display.start();
+    QVERIFY(!display.isProtocolEventLogEnabled());
+    QVERIFY(!display.dumpProtocolEventLog(-1));
+    QVERIFY(display.setProtocolEventLogEnabled(true));
+    QVERIFY(display.isProtocolEventLogEnabled());
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *client = display.createClient(sv[0]);
+    QVERIFY(client);
+
+    wl_resource *callback = wl_resource_create(client->client(), &wl_callback_interface, 1, 0);
+    QVERIFY(callback);
+    wl_callback_send_done(callback, 0);
+    wl_callback_send_done(callback, 0);
+    wl_callback_send_done(callback, 1);
+
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    QVERIFY(display.dumpProtocolEventLog(file.handle()));
+    QFile reader(file.fileName());
+    QVERIFY(reader.open(QIODevice::ReadOnly));
+    const QByteArray dump = reader.readAll();
+    QVERIFY(dump.size() > int(sizeof(ProtocolEventLogHeader)));
+
+    const auto header = reinterpret_cast<const ProtocolEventLogHeader *>(dump.constData());
+    QCOMPARE(header->magic, ProtocolEventLogHeader::magicValue);
+    QCOMPARE(header->version, ProtocolEventLogHeader::currentVersion);
+    QCOMPARE(header->recordSize, quint32(sizeof(ProtocolEventRecord)));
+    QCOMPARE(dump.size(), int(sizeof(ProtocolEventLogHeader) + header->capacity * header->recordSize));
+    QCOMPARE(header->written, 3u);
+
+    const auto records = reinterpret_cast<const ProtocolEventRecord *>(header + 1);
+    for (quint64 i = 0; i < header->written; ++i) {
+        QCOMPARE(records[i].sequence, i + 1);
+        QCOMPARE(records[i].clientPid, quint32(getpid()));
+        QCOMPARE(records[i].objectId, wl_resource_get_id(callback));
+        QCOMPARE(records[i].opcode, quint16(0));
+        QCOMPARE(records[i].direction, quint8(ProtocolEventRecord::Event));
+        QCOMPARE(records[i].argumentCount, quint8(1));
+        QCOMPARE(QByteArray(records[i].interface), QByteArrayLiteral("wl_callback"));
+    }
+    QVERIFY(records[1].timestamp >= records[0].timestamp);
+    QCOMPARE(records[1].argumentDigest, records[0].argumentDigest);
+    QVERIFY(records[2].argumentDigest != records[0].argumentDigest);
+    QCOMPARE(records[3].sequence, 0u);
+
+    display.setProtocolEventLogEnabled(false);
+    QVERIFY(!display.isProtocolEventLogEnabled());
+    QCOMPARE(display.protocolEventLogFd(), -1);
+
+    wl_client_destroy(client->client());
+    close(sv[0]);
+    close(sv[1]);
+}
+
+void TestWaylandServerDisplay::testProtocolRecording()
+{
+    QTemporaryFile file;
+    QVERIFY(file.open());
+    {
+        Display display;
+        QVERIFY(display.start());
+        new CompositorInterface(&display, &display);
+        QVERIFY(!display.isProtocolRecording());
+        QVERIFY(!display.stopProtocolRecording());
+        QVERIFY(display.startProtocolRecording(file.handle()));
+        QVERIFY(display.isProtocolRecording());
+        QVERIFY(!display.startProtocolRecording(file.handle()));
+
+        int sv[2];
+        QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+        QVERIFY(display.createClient(sv[0]));
+        wl_display *clientDisplay = wl_display_connect_to_fd(sv[1]);
+        QVERIFY(clientDisplay);
+        wl_compositor *compositor = nullptr;
+        wl_registry *registry = wl_display_get_registry(clientDisplay);
+        wl_registry_add_listener(registry, &s_tracerRegistryListener, &compositor);
+        wl_display_flush(clientDisplay);
+        display.dispatchEvents();
+        wl_display_flush_clients(display);
+        QVERIFY(wl_display_dispatch(clientDisplay) >= 0);
+        QVERIFY(compositor);
+
+        wl_surface *surface = wl_compositor_create_surface(compositor);
+        wl_surface_damage(surface, 0, 0, 10, 10);
+        wl_surface_commit(surface);
+        wl_surface_destroy(surface);
+        wl_compositor_destroy(compositor);
+        wl_registry_destroy(registry);
+        wl_display_flush(clientDisplay);
+        display.dispatchEvents();
+        wl_display_disconnect(clientDisplay);
+        display.dispatchEvents();
+        QVERIFY(display.connections().isEmpty());
+        QVERIFY(display.stopProtocolRecording());
+        QVERIFY(!display.isProtocolRecording());
+    }
+
+    Display display;
+    QVERIFY(display.start());
+    // the compositor global gets another name than in the recording
+    new OutputManagementInterface(&display, &display);
+    CompositorInterface *compositor = new CompositorInterface(&display, &display);
+    QSignalSpy surfaceCreatedSpy(compositor, &CompositorInterface::surfaceCreated);
+    QVERIFY(surfaceCreatedSpy.isValid());
+
+    ProtocolReplayer replayer(&display);
+    QVERIFY(replayer.load(file.fileName()));
+    QCOMPARE(replayer.clientCount(), 1);
+    // get_registry, bind, create_surface, damage, commit and destroy
+    QCOMPARE(replayer.requestCount(), 6u);
+    QVERIFY(replayer.replay());
+    QCOMPARE(replayer.replayedRequestCount(), 6u);
+    QCOMPARE(replayer.failedClientCount(), 0);
+    QCOMPARE(surfaceCreatedSpy.count(), 1);
+    QVERIFY(display.connections().isEmpty());
+
+    // without the compositor the bind can't be replayed
+    Display emptyDisplay;
+    QVERIFY(emptyDisplay.start());
+    ProtocolReplayer emptyReplayer(&emptyDisplay);
+    QVERIFY(emptyReplayer.load(file.fileName()));
+    QVERIFY(!emptyReplayer.replay());
+    QCOMPARE(emptyReplayer.failedClientCount(), 1);
+    QCOMPARE(emptyReplayer.replayedRequestCount(), 1u);
+}
+
+void TestWaylandServerDisplay::testClientMemoryAccounting()
+{
+    Display display;
+    QVERIFY(display.start());
+    new CompositorInterface(&display, &display);
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+    ClientConnection *client = display.createClient(sv[0]);
+    QVERIFY(client);
+    QCOMPARE(client->memoryUsage(), 0);
+    QCOMPARE(client->memoryLimit(), 0);
+    wl_display *clientDisplay = wl_display_connect_to_fd(sv[1]);
+    QVERIFY(clientDisplay);
+    wl_compositor *compositor = nullptr;
+    wl_registry *registry = wl_display_get_registry(clientDisplay);
+    wl_registry_add_listener(registry, &s_tracerRegistryListener, &compositor);
+    wl_display_flush(clientDisplay);
+    display.dispatchEvents();
+    wl_display_flush_clients(display);
+    QVERIFY(wl_display_dispatch(clientDisplay) >= 0);
+    QVERIFY(compositor);
+
+    QSignalSpy exceededSpy(client, &ClientConnection::memoryLimitExceeded);
+    QVERIFY(exceededSpy.isValid());
+    client->setMemoryLimit(1024);
+    QCOMPARE(client->memoryLimit(), 1024);
+
+    // disjoint damage rectangles pile up in the pending state
+    wl_surface *surface = wl_compositor_create_surface(compositor);
+    for (int i = 0; i < 16; ++i) {
+        wl_surface_damage(surface, i * 20, i * 20, 10, 10);
+    }
+    wl_display_flush(clientDisplay);
+    display.dispatchEvents();
+    const qint64 usage = client->memoryUsage(ClientMemoryCategory::SurfaceState);
+    QVERIFY(usage > 0);
+    QCOMPARE(client->memoryUsage(), usage);
+    QCOMPARE(client->memoryUsage(ClientMemoryCategory::Buffers), 0);
+    QVERIFY(usage < client->memoryLimit());
+
+    client->setMemoryLimit(usage / 2);
+    // the signal is delivered from the event loop
+    QCOMPARE(exceededSpy.count(), 0);
+    QVERIFY(exceededSpy.wait());
+    QCOMPARE(exceededSpy.count(), 1);
+
+    wl_surface_destroy(surface);
+    wl_display_flush(clientDisplay);
+    display.dispatchEvents();
+    QCOMPARE(client->memoryUsage(), 0);
+
+    wl_compositor_destroy(compositor);
+    wl_registry_destroy(registry);
+    wl_display_disconnect(clientDisplay);
+}
+
+void TestWaylandServerDisplay::testPerformanceSnapshot()
+{
+    Display display;
+    QVERIFY(display.start());
+    display.setProtocolStatisticsEnabled(true);
+
+    PerformanceSnapshot snapshot = display.performanceSnapshot();
+    QVERIFY(snapshot.timestamp > 0);
+    QVERIFY(snapshot.clients.isEmpty());
+    QVERIFY(snapshot.protocolStatistics.isEmpty());
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM, 0, sv) >= 0);
+    ClientConnection *client = display.createClient(sv[0]);
+    QVERIFY(client);
+    client->setCommitRateLimit(1, 16);
+    wl_resource *callback = wl_resource_create(client->client(), &wl_callback_interface, 1, 0);
+    QVERIFY(callback);
+    wl_callback_send_done(callback, 0);
+    display.setFlushAfterDispatch(true);
+    display.dispatchEvents();
+
+    snapshot = display.performanceSnapshot();
+    QCOMPARE(snapshot.flushCount, 1u);
+    QCOMPARE(snapshot.protocolStatistics.count(), 1);
+    QCOMPARE(snapshot.clients.count(), 1);
+    const ClientPerformanceSnapshot &clientSnapshot = snapshot.clients.first();
+    QCOMPARE(clientSnapshot.client, client);
+    QCOMPARE(clientSnapshot.processId, client->processId());
+    QCOMPARE(clientSnapshot.commitRateLimit, 1);
+    QCOMPARE(clientSnapshot.commitRatePeriod, 16);
+    QCOMPARE(clientSnapshot.pendingFrameCallbackCount, 0);
+    QCOMPARE(clientSnapshot.memoryUsage, 0);
+
+    const QVariantMap map = snapshot.toVariantMap();
+    QCOMPARE(map.value(QStringLiteral("flushCount")).toULongLong(), 1u);
+    QCOMPARE(map.value(QStringLiteral("inputLatency")).toList().count(), PerformanceSnapshot::inputLatencyEventTypeCount);
+    const QVariantList clients = map.value(QStringLiteral("clients")).toList();
+    QCOMPARE(clients.count(), 1);
+    QCOMPARE(clients.first().toMap().value(QStringLiteral("commitRateLimit")).toInt(), 1);
+    const QVariantList protocol = map.value(QStringLiteral("protocolStatistics")).toList();
+    QCOMPARE(protocol.count(), 1);
+    QCOMPARE(protocol.first().toMap().value(QStringLiteral("interface")).toString(), QStringLiteral("wl_callback"));
+
+    wl_client_destroy(client->client());
+    close(sv[0]);
+    close(sv[1]);
+    QVERIFY(display.performanceSnapshot().clients.isEmpty());
+}
 
 QTEST_GUILESS_MAIN(TestWaylandServerDisplay)
 #include "test_display.moc"
@@ -0,0 +1,267 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/appmenu_interface.h"
+#include "../../src/server/blur_interface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/contrast_interface.h"
+#include "../../src/server/datacontroldevicemanager_v1_interface.h"
+#include "../../src/server/datadevicemanager_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/dpms_interface.h"
+#include "../../src/server/eglstream_controller_interface.h"
+#include "../../src/server/fakeinput_interface.h"
+#include "../../src/server/idle_interface.h"
+#include "../../src/server/idleinhibit_v1_interface.h"
+#include "../../src/server/inputmethod_v1_interface.h"
+#include "../../src/server/keyboard_shortcuts_inhibit_v1_interface.h"
+#include "../../src/server/keystate_interface.h"
+#include "../../src/server/layershell_v1_interface.h"
+#include "../../src/server/linuxdmabuf_v1_interface.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/outputdevice_interface.h"
+#include "../../src/server/outputmanagement_interface.h"
+#include "../../src/server/plasmashell_interface.h"
+#include "../../src/server/plasmavirtualdesktop_interface.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+#include "../../src/server/pointerconstraints_v1_interface.h"
+#include "../../src/server/pointergestures_v1_interface.h"
+#include "../../src/server/primaryselectiondevicemanager_v1_interface.h"
+#include "../../src/server/relativepointer_v1_interface.h"
+#include "../../src/server/screencast_v1_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/server_decoration_interface.h"
+#include "../../src/server/server_decoration_palette_interface.h"
+#include "../../src/server/shadow_interface.h"
+#include "../../src/server/slide_interface.h"
+#include "../../src/server/subcompositor_interface.h"
+#include "../../src/server/tablet_v2_interface.h"
+#include "../../src/server/textinput_v2_interface.h"
+#include "../../src/server/textinput_v3_interface.h"
+#include "../../src/server/viewporter_interface.h"
+#include "../../src/server/xdgdecoration_v1_interface.h"
+#include "../../src/server/xdgforeign_v2_interface.h"
+#include "../../src/server/xdgoutput_v1_interface.h"
+#include "../../src/server/xdgshell_interface.h"
+// Wayland
+#include <wayland-client.h>
+#include <wayland-server.h>
+
+#include "benchmarkhelpers.h"
+
+#include <deque>
+
+#include <sys/socket.h>
+
+using namespace KWaylandServer;
+using namespace BenchmarkHelpers;
+
+/**
+ * Measures the time and the number of allocations of the compositor cold start: creating
+ * the Display and every global, starting it and letting a number of clients enumerate the
+ * registry and bind all globals.
+ *
+ * The clients are plain libwayland connections over socket pairs driven from the test
+ * thread. They bind the globals with placeholder interfaces and never read the events
+ * sent on the bound objects, so no client side protocol code is needed.
+ **/
+class TestDisplayStartup : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void benchmarkStartup_data();
+    void benchmarkStartup();
+};
+
+class Stage
+{
+public:
+    explicit Stage(const char *name)
+        : m_name(name)
+        , m_allocations(allocationCount())
+    {
+        m_timer.start();
+    }
+    ~Stage()
+    {
+        qInfo("%-12s %8.3f ms %8llu allocations", m_name, m_timer.nsecsElapsed() / 1e6,
+              allocationCount() - m_allocations);
+    }
+
+private:
+    const char *m_name;
+    quint64 m_allocations;
+    QElapsedTimer m_timer;
+};
+
+struct SyntheticClient
+{
+    struct Global {
+        quint32 name;
+        QByteArray interface;
+        quint32 version;
+    };
+
+    wl_display *display = nullptr;
+    wl_registry *registry = nullptr;
+    RegistryListener registryListener;
+    QVector<Global> globals;
+    // the placeholder interfaces have to outlive the proxies
+    std::deque<wl_interface> interfaces;
+};
+
+static void processServer(Display &display)
+{
+    display.dispatchEvents();
+    wl_display_flush_clients(display);
+}
+
+static void createGlobals(Display &display)
+{
+    display.createShm();
+    new CompositorInterface(&display, &display);
+    new SubCompositorInterface(&display, &display);
+    new DataDeviceManagerInterface(&display, &display);
+    new DataControlDeviceManagerV1Interface(&display, &display);
+    new PrimarySelectionDeviceManagerV1Interface(&display, &display);
+
+    SeatInterface *seat = new SeatInterface(&display, &display);
+    seat->setHasKeyboard(true);
+    seat->setHasPointer(true);
+    seat->setHasTouch(true);
+    seat->create();
+
+    OutputInterface *output = new OutputInterface(&display, &display);
+    output->addMode(QSize(1920, 1080), OutputInterface::ModeFlags(OutputInterface::ModeFlag::Preferred));
+    output->setCurrentMode(QSize(1920, 1080));
+    output->create();
+
+    OutputDeviceInterface *outputDevice = new OutputDeviceInterface(&display, &display);
+    OutputDeviceInterface::Mode mode;
+    mode.size = QSize(1920, 1080);
+    mode.id = 0;
+    outputDevice->addMode(mode);
+    outputDevice->setCurrentMode(0);
+    outputDevice->create();
+
+    (new OutputManagementInterface(&display, &display))->create();
+    (new LinuxDmabufUnstableV1Interface(&display, &display))->create();
+    new XdgOutputManagerV1Interface(&display, &display);
+
+    new XdgShellInterface(&display, &display);
+    new XdgDecorationManagerV1Interface(&display, &display);
+    new XdgForeignV2Interface(&display, &display);
+    new LayerShellV1Interface(&display, &display);
+    new ViewporterInterface(&display, &display);
+    new PointerConstraintsV1Interface(&display, &display);
+    new PointerGesturesV1Interface(&display, &display);
+    new RelativePointerManagerV1Interface(&display, &display);
+    new IdleInhibitManagerV1Interface(&display, &display);
+    new KeyboardShortcutsInhibitManagerV1Interface(&display, &display);
+    new TabletManagerV2Interface(&display, &display);
+    new TextInputManagerV2Interface(&display, &display);
+    new TextInputManagerV3Interface(&display, &display);
+    new InputMethodV1Interface(&display, &display);
+    new InputPanelV1Interface(&display, &display);
+    new EglStreamControllerInterface(&display, &display);
+
+    new PlasmaShellInterface(&display, &display);
+    new PlasmaWindowManagementInterface(&display, &display);
+    new PlasmaVirtualDesktopManagementInterface(&display, &display);
+    new ScreencastV1Interface(&display, &display);
+    new ServerSideDecorationManagerInterface(&display, &display);
+    new ServerSideDecorationPaletteManagerInterface(&display, &display);
+    new AppMenuManagerInterface(&display, &display);
+    new BlurManagerInterface(&display, &display);
+    new ContrastManagerInterface(&display, &display);
+    new ShadowManagerInterface(&display, &display);
+    new SlideManagerInterface(&display, &display);
+    new DpmsManagerInterface(&display, &display);
+    new IdleInterface(&display, &display);
+    new FakeInputInterface(&display, &display);
+    new KeyStateInterface(&display, &display);
+}
+
+void TestDisplayStartup::benchmarkStartup_data()
+{
+    QTest::addColumn<int>("clientCount");
+
+    QTest::newRow("1 client") << 1;
+    QTest::newRow("16 clients") << 16;
+    QTest::newRow("64 clients") << 64;
+}
+
+void TestDisplayStartup::benchmarkStartup()
+{
+    QFETCH(int, clientCount);
+
+    QBENCHMARK_ONCE {
+        Display display;
+        {
+            Stage stage("globals");
+            createGlobals(display);
+        }
+        {
+            Stage stage("start");
+            QVERIFY(display.start());
+        }
+
+        std::deque<SyntheticClient> clients(clientCount);
+        {
+            Stage stage("connect");
+            for (SyntheticClient &client : clients) {
+                int sv[2];
+                QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+                QVERIFY(display.createClient(sv[0]));
+                client.display = wl_display_connect_to_fd(sv[1]);
+                QVERIFY(client.display);
+            }
+        }
+        {
+            Stage stage("registry");
+            for (SyntheticClient &client : clients) {
+                client.registry = wl_display_get_registry(client.display);
+                client.registryListener.listen(client.registry, [&client](wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+                    Q_UNUSED(registry)
+                    client.globals.append({name, QByteArray(interface), version});
+                });
+                wl_display_flush(client.display);
+            }
+            processServer(display);
+            for (SyntheticClient &client : clients) {
+                QVERIFY(wl_display_prepare_read(client.display) == 0);
+                QVERIFY(wl_display_read_events(client.display) == 0);
+                QVERIFY(wl_display_dispatch_pending(client.display) >= 0);
+                QVERIFY(!client.globals.isEmpty());
+            }
+        }
+        {
+            Stage stage("bind");
+            for (SyntheticClient &client : clients) {
+                for (const SyntheticClient::Global &global : qAsConst(client.globals)) {
+                    client.interfaces.push_back(wl_interface{global.interface.constData(), int(global.version), 0, nullptr, 0, nullptr});
+                    wl_registry_bind(client.registry, global.name, &client.interfaces.back(), global.version);
+                }
+                wl_display_flush(client.display);
+            }
+            processServer(display);
+        }
+        QCOMPARE(display.connections().count(), clientCount);
+
+        {
+            Stage stage("teardown");
+            for (SyntheticClient &client : clients) {
+                wl_display_disconnect(client.display);
+            }
+            processServer(display);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestDisplayStartup)
+#include "test_display_startup.moc"
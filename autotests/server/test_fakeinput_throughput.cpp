@@ -0,0 +1,425 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QThread>
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/fakeinput_interface.h"
+#include "../../src/server/keyboard_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+// KWayland
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/fakeinput.h"
+#include "KWayland/Client/keyboard.h"
+#include "KWayland/Client/pointer.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/seat.h"
+#include "KWayland/Client/surface.h"
+#include "KWayland/Client/touch.h"
+
+#include <linux/input.h>
+
+using namespace KWaylandServer;
+
+static const QString s_socketName = QStringLiteral("kwayland-test-fakeinput-throughput-0");
+
+// the events injected by each benchmark run
+static const int s_eventCount = 2000;
+
+/**
+ * The part of a compositor which turns fake input into seat events, either from the single
+ * event signals of a FakeInputDevice or from its batches.
+ **/
+class FakeInputHarness : public QObject
+{
+    Q_OBJECT
+public:
+    FakeInputHarness(SeatInterface *seat, FakeInputDevice *device)
+        : m_seat(seat)
+    {
+        connect(device, &FakeInputDevice::pointerMotionRequested, this, &FakeInputHarness::pointerMotion);
+        connect(device, &FakeInputDevice::keyboardKeyPressRequested, this, [this](quint32 key) {
+            keyboardKey(key, true);
+        });
+        connect(device, &FakeInputDevice::keyboardKeyReleaseRequested, this, [this](quint32 key) {
+            keyboardKey(key, false);
+        });
+        connect(device, &FakeInputDevice::touchDownRequested, this, &FakeInputHarness::touchDown);
+        connect(device, &FakeInputDevice::touchMotionRequested, this, &FakeInputHarness::touchMotion);
+        connect(device, &FakeInputDevice::touchUpRequested, this, &FakeInputHarness::touchUp);
+        connect(device, &FakeInputDevice::touchFrameRequested, m_seat, &SeatInterface::touchFrame);
+        connect(device, &FakeInputDevice::eventsRequested, this, &FakeInputHarness::events);
+    }
+
+private:
+    void events(const QVector<FakeInputEvent> &events)
+    {
+        for (const FakeInputEvent &event : events) {
+            switch (event.type) {
+            case FakeInputEvent::Type::PointerMotion:
+                pointerMotion(event.delta);
+                break;
+            case FakeInputEvent::Type::KeyboardKeyPress:
+            case FakeInputEvent::Type::KeyboardKeyRelease:
+                keyboardKey(event.code, event.type == FakeInputEvent::Type::KeyboardKeyPress);
+                break;
+            case FakeInputEvent::Type::TouchDown:
+                touchDown(event.code, event.position);
+                break;
+            case FakeInputEvent::Type::TouchMotion:
+                touchMotion(event.code, event.position);
+                break;
+            case FakeInputEvent::Type::TouchUp:
+                touchUp(event.code);
+                break;
+            case FakeInputEvent::Type::TouchFrame:
+                m_seat->touchFrame();
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    void pointerMotion(const QSizeF &delta)
+    {
+        m_seat->setTimestamp(++m_timestamp);
+        m_seat->setPointerPos(m_seat->pointerPos() + QPointF(delta.width(), delta.height()));
+    }
+    void keyboardKey(quint32 key, bool pressed)
+    {
+        m_seat->setTimestamp(++m_timestamp);
+        if (pressed) {
+            m_seat->keyboard()->keyPressed(key);
+        } else {
+            m_seat->keyboard()->keyReleased(key);
+        }
+    }
+    void touchDown(quint32 id, const QPointF &pos)
+    {
+        m_seat->setTimestamp(++m_timestamp);
+        m_touchIds.insert(id, m_seat->touchDown(pos));
+    }
+    void touchMotion(quint32 id, const QPointF &pos)
+    {
+        m_seat->setTimestamp(++m_timestamp);
+        m_seat->touchMove(m_touchIds.value(id), pos);
+    }
+    void touchUp(quint32 id)
+    {
+        m_seat->setTimestamp(++m_timestamp);
+        m_seat->touchUp(m_touchIds.take(id));
+    }
+
+    SeatInterface *m_seat;
+    QHash<quint32, qint32> m_touchIds;
+    quint32 m_timestamp = 0;
+};
+
+/**
+ * Measures how many fake input events per second make it from an injecting client through
+ * the seat to the focused client, and the latency of a single pointer motion.
+ **/
+class TestFakeInputThroughput : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkThroughput_data();
+    void benchmarkThroughput();
+    void benchmarkMotionLatency_data();
+    void benchmarkMotionLatency();
+
+private:
+    void sendEvents(const QByteArray &kind, int count);
+    bool waitForCount(const int *counter, int count);
+
+    Display m_display;
+    SeatInterface *m_seat = nullptr;
+    FakeInputDevice *m_device = nullptr;
+    FakeInputHarness *m_harness = nullptr;
+
+    // the client receiving the input
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::Seat *m_clientSeat = nullptr;
+    KWayland::Client::Surface *m_surface = nullptr;
+    KWayland::Client::Pointer *m_pointer = nullptr;
+    KWayland::Client::Keyboard *m_keyboard = nullptr;
+    KWayland::Client::Touch *m_touch = nullptr;
+    QThread *m_thread = nullptr;
+    int m_motions = 0;
+    int m_keys = 0;
+    int m_touchMotions = 0;
+
+    // the remote desktop client injecting the input
+    KWayland::Client::ConnectionThread *m_injectorConnection = nullptr;
+    KWayland::Client::EventQueue *m_injectorQueue = nullptr;
+    KWayland::Client::FakeInput *m_fakeInput = nullptr;
+    QThread *m_injectorThread = nullptr;
+};
+
+void TestFakeInputThroughput::initTestCase()
+{
+    qRegisterMetaType<QVector<FakeInputEvent>>();
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasPointer(true);
+    m_seat->setHasKeyboard(true);
+    m_seat->setHasTouch(true);
+    m_seat->create();
+    CompositorInterface *compositor = new CompositorInterface(&m_display, this);
+    FakeInputInterface *fakeInput = new FakeInputInterface(&m_display, this);
+
+    // the receiving client
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    using Interface = KWayland::Client::Registry::Interface;
+    m_compositor = registry.createCompositor(registry.interface(Interface::Compositor).name,
+                                             registry.interface(Interface::Compositor).version, this);
+    m_clientSeat = registry.createSeat(registry.interface(Interface::Seat).name,
+                                       registry.interface(Interface::Seat).version, this);
+    QSignalSpy hasTouchSpy(m_clientSeat, &KWayland::Client::Seat::hasTouchChanged);
+    QVERIFY(hasTouchSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(compositor, &CompositorInterface::surfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+
+    QSignalSpy touchCreatedSpy(m_seat, &SeatInterface::touchCreated);
+    m_pointer = m_clientSeat->createPointer(this);
+    m_keyboard = m_clientSeat->createKeyboard(this);
+    m_touch = m_clientSeat->createTouch(this);
+    QVERIFY(touchCreatedSpy.wait());
+    connect(m_pointer, &KWayland::Client::Pointer::motion, this, [this]() {
+        m_motions++;
+    });
+    connect(m_keyboard, &KWayland::Client::Keyboard::keyChanged, this, [this]() {
+        m_keys++;
+    });
+    connect(m_touch, &KWayland::Client::Touch::pointMoved, this, [this]() {
+        m_touchMotions++;
+    });
+
+    m_seat->setFocusedPointerSurface(serverSurface);
+    m_seat->setFocusedKeyboardSurface(serverSurface);
+    m_seat->setFocusedTouchSurface(serverSurface);
+    QVERIFY(m_seat->focusedPointer());
+
+    // the injecting client
+    QSignalSpy deviceCreatedSpy(fakeInput, &FakeInputInterface::deviceCreated);
+    m_injectorConnection = new KWayland::Client::ConnectionThread;
+    QSignalSpy injectorConnectedSpy(m_injectorConnection, &KWayland::Client::ConnectionThread::connected);
+    m_injectorConnection->setSocketName(s_socketName);
+    m_injectorThread = new QThread(this);
+    m_injectorConnection->moveToThread(m_injectorThread);
+    m_injectorThread->start();
+    m_injectorConnection->initConnection();
+    QVERIFY(injectorConnectedSpy.wait());
+
+    m_injectorQueue = new KWayland::Client::EventQueue(this);
+    m_injectorQueue->setup(m_injectorConnection);
+
+    KWayland::Client::Registry injectorRegistry;
+    QSignalSpy injectorAnnouncedSpy(&injectorRegistry, &KWayland::Client::Registry::interfacesAnnounced);
+    injectorRegistry.setEventQueue(m_injectorQueue);
+    injectorRegistry.create(m_injectorConnection->display());
+    injectorRegistry.setup();
+    QVERIFY(injectorAnnouncedSpy.wait());
+    m_fakeInput = injectorRegistry.createFakeInput(injectorRegistry.interface(Interface::FakeInput).name,
+                                                   injectorRegistry.interface(Interface::FakeInput).version, this);
+    QVERIFY(m_fakeInput->isValid());
+    QVERIFY(deviceCreatedSpy.wait());
+    m_device = deviceCreatedSpy.first().first().value<FakeInputDevice *>();
+    m_device->setAuthentication(true);
+    m_harness = new FakeInputHarness(m_seat, m_device);
+}
+
+void TestFakeInputThroughput::cleanupTestCase()
+{
+    delete m_harness;
+    delete m_fakeInput;
+    delete m_injectorQueue;
+    if (m_injectorConnection) {
+        m_injectorConnection->deleteLater();
+        m_injectorConnection = nullptr;
+    }
+    if (m_injectorThread) {
+        m_injectorThread->quit();
+        m_injectorThread->wait();
+    }
+
+    delete m_touch;
+    delete m_keyboard;
+    delete m_pointer;
+    delete m_surface;
+    delete m_clientSeat;
+    delete m_compositor;
+    delete m_queue;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+    }
+}
+
+void TestFakeInputThroughput::sendEvents(const QByteArray &kind, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (kind == "motion") {
+            // back and forth, so the pointer stays where it is
+            m_fakeInput->requestPointerMove(QSizeF(i % 2 ? -1 : 1, 0));
+        } else if (kind == "key") {
+            if (i % 2) {
+                m_fakeInput->requestKeyboardKeyRelease(quint32(KEY_A));
+            } else {
+                m_fakeInput->requestKeyboardKeyPress(quint32(KEY_A));
+            }
+        } else if (kind == "touch") {
+            m_fakeInput->requestTouchMotion(0, QPointF(i % 2 ? 10 : 11, 10));
+            m_fakeInput->requestTouchFrame();
+        }
+    }
+}
+
+bool TestFakeInputThroughput::waitForCount(const int *counter, int count)
+{
+    QElapsedTimer timeout;
+    timeout.start();
+    while (*counter < count) {
+        if (timeout.elapsed() > 10000) {
+            return false;
+        }
+        QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents, 10);
+    }
+    return true;
+}
+
+void TestFakeInputThroughput::benchmarkThroughput_data()
+{
+    QTest::addColumn<QByteArray>("kind");
+    QTest::addColumn<bool>("batched");
+    // the events the injecting client sends before it flushes its connection
+    QTest::addColumn<int>("burst");
+
+    const QByteArrayList kinds = {QByteArrayLiteral("motion"), QByteArrayLiteral("key"), QByteArrayLiteral("touch")};
+    for (const QByteArray &kind : kinds) {
+        for (int burst : {1, 10, 100}) {
+            QTest::addRow("%s/single/%d", kind.constData(), burst) << kind << false << burst;
+            QTest::addRow("%s/batched/%d", kind.constData(), burst) << kind << true << burst;
+        }
+    }
+}
+
+void TestFakeInputThroughput::benchmarkThroughput()
+{
+    QFETCH(QByteArray, kind);
+    QFETCH(bool, batched);
+    QFETCH(int, burst);
+    m_device->setBatched(batched);
+
+    const int *counter = &m_motions;
+    if (kind == "key") {
+        counter = &m_keys;
+    } else if (kind == "touch") {
+        counter = &m_touchMotions;
+        m_fakeInput->requestTouchDown(0, QPointF(10, 10));
+        m_fakeInput->requestTouchFrame();
+        m_injectorConnection->flush();
+        QTRY_VERIFY(m_seat->isTouchSequence());
+    }
+
+    QElapsedTimer timer;
+    qint64 eventCount = 0;
+    timer.start();
+    QBENCHMARK {
+        const int target = *counter + s_eventCount;
+        for (int sent = 0; sent < s_eventCount; sent += burst) {
+            sendEvents(kind, burst);
+            m_injectorConnection->flush();
+            QCoreApplication::processEvents();
+        }
+        QVERIFY(waitForCount(counter, target));
+        eventCount += s_eventCount;
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    qInfo("%s: %.0f events/s", QTest::currentDataTag(), eventCount * 1e9 / qMax<qint64>(elapsed, 1));
+
+    if (kind == "touch") {
+        m_fakeInput->requestTouchUp(0);
+        m_fakeInput->requestTouchFrame();
+        m_injectorConnection->flush();
+        QTRY_VERIFY(!m_seat->isTouchSequence());
+    }
+}
+
+void TestFakeInputThroughput::benchmarkMotionLatency_data()
+{
+    QTest::addColumn<bool>("batched");
+
+    QTest::addRow("single") << false;
+    QTest::addRow("batched") << true;
+}
+
+void TestFakeInputThroughput::benchmarkMotionLatency()
+{
+    // one motion at a time, from the request of the injecting client until the pointer
+    // of the receiving client saw it
+    QFETCH(bool, batched);
+    m_device->setBatched(batched);
+
+    static const int samples = 200;
+    qint64 total = 0;
+    qint64 worst = 0;
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < samples; ++i) {
+            const int target = m_motions + 1;
+            QElapsedTimer latency;
+            latency.start();
+            m_fakeInput->requestPointerMove(QSizeF(i % 2 ? -1 : 1, 0));
+            m_injectorConnection->flush();
+            QVERIFY(waitForCount(&m_motions, target));
+            const qint64 elapsed = latency.nsecsElapsed();
+            total += elapsed;
+            worst = std::max(worst, elapsed);
+        }
+    }
+    qInfo("%s: %.1f us average, %.1f us worst", QTest::currentDataTag(), total / 1e3 / samples, worst / 1e3);
+}
+
+QTEST_GUILESS_MAIN(TestFakeInputThroughput)
+#include "test_fakeinput_throughput.moc"
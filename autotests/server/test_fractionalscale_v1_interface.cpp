@@ -0,0 +1,206 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/fractionalscale_v1_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/subcompositor_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/subcompositor.h"
+#include "KWayland/Client/subsurface.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-fractional-scale-v1.h"
+
+using namespace KWaylandServer;
+
+class FractionalScaleManager : public QtWayland::wp_fractional_scale_manager_v1
+{
+};
+
+class FractionalScale : public QObject, public QtWayland::wp_fractional_scale_v1
+{
+    Q_OBJECT
+
+public:
+    FractionalScale(struct ::wp_fractional_scale_v1 *object)
+        : QtWayland::wp_fractional_scale_v1(object)
+    {
+    }
+
+    ~FractionalScale() override
+    {
+        destroy();
+    }
+
+Q_SIGNALS:
+    void preferredScale(uint32_t scale);
+
+protected:
+    void wp_fractional_scale_v1_preferred_scale(uint32_t scale) override
+    {
+        Q_EMIT preferredScale(scale);
+    }
+};
+
+class TestFractionalScaleInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestFractionalScaleInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPreferredScale();
+    void testSubSurface();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+    KWayland::Client::SubCompositor *m_clientSubCompositor;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    FractionalScaleManager *m_fractionalScaleManager = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-fractionalscale-test-0");
+
+void TestFractionalScaleInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new FractionalScaleManagerV1Interface(&m_display, this);
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+    new SubCompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_fractional_scale_manager_v1")) {
+            m_fractionalScaleManager = new FractionalScaleManager();
+            m_fractionalScaleManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    QSignalSpy subCompositorSpy(registry, &KWayland::Client::Registry::subCompositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_fractionalScaleManager);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(),
+                                                    compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+
+    m_clientSubCompositor = registry->createSubCompositor(subCompositorSpy.first().first().value<quint32>(),
+                                                          subCompositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientSubCompositor->isValid());
+}
+
+TestFractionalScaleInterface::~TestFractionalScaleInterface()
+{
+    delete m_fractionalScaleManager;
+    m_fractionalScaleManager = nullptr;
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestFractionalScaleInterface::testPreferredScale()
+{
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto surface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QCOMPARE(surface->preferredScale(), 1.0);
+    surface->setPreferredScale(1.5);
+
+    // the current scale is sent right away
+    QScopedPointer<FractionalScale> fractionalScale(new FractionalScale(m_fractionalScaleManager->get_fractional_scale(*clientSurface)));
+    QSignalSpy preferredScaleSpy(fractionalScale.data(), &FractionalScale::preferredScale);
+    QVERIFY(preferredScaleSpy.wait());
+    QCOMPARE(preferredScaleSpy.last().first().value<uint32_t>(), 180u);
+
+    surface->setPreferredScale(1.25);
+    QVERIFY(preferredScaleSpy.wait());
+    QCOMPARE(preferredScaleSpy.last().first().value<uint32_t>(), 150u);
+
+    // the same scale isn't sent again
+    surface->setPreferredScale(1.25);
+    QVERIFY(!preferredScaleSpy.wait(100));
+    QCOMPARE(preferredScaleSpy.count(), 2);
+}
+
+void TestFractionalScaleInterface::testSubSurface()
+{
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> parentSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto parent = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+    QScopedPointer<KWayland::Client::Surface> childSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto child = surfaceCreatedSpy.last().first().value<SurfaceInterface *>();
+    parent->setPreferredScale(1.75);
+
+    // a sub-surface takes the scale of its parent
+    QSignalSpy childSubSurfaceAddedSpy(parent, &SurfaceInterface::childSubSurfaceAdded);
+    QScopedPointer<KWayland::Client::SubSurface> subSurface(m_clientSubCompositor->createSubSurface(childSurface.data(), parentSurface.data()));
+    parentSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(childSubSurfaceAddedSpy.wait());
+    QCOMPARE(child->preferredScale(), 1.75);
+
+    QScopedPointer<FractionalScale> fractionalScale(new FractionalScale(m_fractionalScaleManager->get_fractional_scale(*childSurface)));
+    QSignalSpy preferredScaleSpy(fractionalScale.data(), &FractionalScale::preferredScale);
+    QVERIFY(preferredScaleSpy.wait());
+    QCOMPARE(preferredScaleSpy.last().first().value<uint32_t>(), 210u);
+
+    parent->setPreferredScale(2);
+    QVERIFY(preferredScaleSpy.wait());
+    QCOMPARE(preferredScaleSpy.last().first().value<uint32_t>(), 240u);
+    QCOMPARE(child->preferredScale(), 2.0);
+}
+
+QTEST_GUILESS_MAIN(TestFractionalScaleInterface)
+#include "test_fractionalscale_v1_interface.moc"
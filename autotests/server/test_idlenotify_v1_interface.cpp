@@ -0,0 +1,199 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/idle_interface.h"
+#include "../../src/server/idlenotify_v1_interface.h"
+#include "../../src/server/seat_interface.h"
+
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/seat.h"
+
+#include "qwayland-ext-idle-notify-v1.h"
+
+using namespace KWaylandServer;
+
+class IdleNotifier : public QtWayland::ext_idle_notifier_v1
+{
+public:
+    IdleNotifier(wl_registry *registry, quint32 id, quint32 version)
+        : QtWayland::ext_idle_notifier_v1(registry, id, version)
+    {
+    }
+    ~IdleNotifier() override
+    {
+        destroy();
+    }
+};
+
+class IdleNotification : public QObject, public QtWayland::ext_idle_notification_v1
+{
+    Q_OBJECT
+public:
+    explicit IdleNotification(::ext_idle_notification_v1 *notification)
+        : QtWayland::ext_idle_notification_v1(notification)
+    {
+    }
+    ~IdleNotification() override
+    {
+        destroy();
+    }
+
+Q_SIGNALS:
+    void idled();
+    void resumed();
+
+protected:
+    void ext_idle_notification_v1_idled() override
+    {
+        Q_EMIT idled();
+    }
+    void ext_idle_notification_v1_resumed() override
+    {
+        Q_EMIT resumed();
+    }
+};
+
+class TestIdleNotifyV1Interface : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testIdleAndResume();
+    void testInhibit();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KWayland::Client::Seat *m_clientSeat = nullptr;
+    IdleNotifier *m_notifier = nullptr;
+    QThread *m_thread = nullptr;
+
+    Display *m_display = nullptr;
+    SeatInterface *m_seat = nullptr;
+    IdleInterface *m_idle = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-idle-notify-v1-0");
+
+void TestIdleNotifyV1Interface::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+
+    m_seat = new SeatInterface(m_display, this);
+    m_seat->create();
+    m_idle = new IdleInterface(m_display, this);
+    new IdleNotifierV1Interface(m_display, m_idle, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new KWayland::Client::Registry(this);
+    connect(m_registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == "ext_idle_notifier_v1") {
+            m_notifier = new IdleNotifier(m_registry->registry(), id, version);
+        }
+    });
+    connect(m_registry, &KWayland::Client::Registry::seatAnnounced, this, [this](quint32 name, quint32 version) {
+        m_clientSeat = m_registry->createSeat(name, version, this);
+    });
+    QSignalSpy allAnnouncedSpy(m_registry, &KWayland::Client::Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_notifier);
+    QVERIFY(m_clientSeat);
+}
+
+void TestIdleNotifyV1Interface::cleanup()
+{
+    delete m_notifier;
+    m_notifier = nullptr;
+    delete m_clientSeat;
+    m_clientSeat = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void TestIdleNotifyV1Interface::testIdleAndResume()
+{
+    // the notification has no minimum timeout, unlike org_kde_kwin_idle_timeout
+    QScopedPointer<IdleNotification> notification(new IdleNotification(m_notifier->get_idle_notification(100, *m_clientSeat)));
+    QSignalSpy idledSpy(notification.data(), &IdleNotification::idled);
+    QSignalSpy resumedSpy(notification.data(), &IdleNotification::resumed);
+    QVERIFY(idledSpy.wait(1000));
+    QCOMPARE(resumedSpy.count(), 0);
+
+    // input on the seat resumes it and restarts the timeout
+    m_seat->setTimestamp(1);
+    QVERIFY(resumedSpy.wait());
+    QVERIFY(idledSpy.wait(1000));
+    QCOMPARE(idledSpy.count(), 2);
+
+    // simulated activity behaves like input
+    m_idle->simulateUserActivity();
+    QVERIFY(resumedSpy.wait());
+    QCOMPARE(resumedSpy.count(), 2);
+}
+
+void TestIdleNotifyV1Interface::testInhibit()
+{
+    QSignalSpy inhibitedSpy(m_idle, &IdleInterface::inhibitedChanged);
+    m_idle->inhibit();
+    QCOMPARE(inhibitedSpy.count(), 1);
+
+    QScopedPointer<IdleNotification> notification(new IdleNotification(m_notifier->get_idle_notification(100, *m_clientSeat)));
+    QSignalSpy idledSpy(notification.data(), &IdleNotification::idled);
+    QVERIFY(!idledSpy.wait(500));
+
+    // lifting the inhibition restarts the timeout
+    m_idle->uninhibit();
+    QCOMPARE(inhibitedSpy.count(), 2);
+    QVERIFY(idledSpy.wait(1000));
+}
+
+QTEST_GUILESS_MAIN(TestIdleNotifyV1Interface)
+#include "test_idlenotify_v1_interface.moc"
@@ -64,6 +64,7 @@ Q_SIGNALS:
     void preferred_language(QString lang);
     void surrounding_text(QString lang, quint32 cursor, quint32 anchor);
     void reset();
+    void commit_state(quint32 serial);
 
 protected:
     void zwp_input_method_context_v1_content_type(uint32_t hint, uint32_t purpose) override
@@ -88,6 +89,10 @@ protected:
     {
         Q_EMIT reset();
     }
+    void zwp_input_method_context_v1_commit_state(uint32_t serial) override
+    {
+        Q_EMIT commit_state(serial);
+    }
 private:
     quint32 imHint = 0;
     quint32 imPurpose = 0;
@@ -147,6 +152,8 @@ private Q_SLOTS:
     void testContentHints();
     void testContentPurpose_data();
     void testContentPurpose();
+    void testUpdate();
+    void testSurroundingTextLimit();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -417,6 +424,13 @@ void TestInputMethodInterface::testContext()
     QCOMPARE(surroundingTextSpy.last().at(1).value<quint32>(), 2);
     QCOMPARE(surroundingTextSpy.last().at(2).value<quint32>(), 4);
 
+    // unchanged surrounding text is not sent again
+    serverContext->sendSurroundingText("Hello Plasma!", 2, 4);
+    serverContext->sendSurroundingText("Hello Plasma!", 3, 3);
+    QVERIFY(surroundingTextSpy.wait());
+    QCOMPARE(surroundingTextSpy.count(), 2);
+    QCOMPARE(surroundingTextSpy.last().at(1).value<quint32>(), 3);
+
     // reset
     QSignalSpy resetSpy(imContext, &InputMethodV1Context::reset);
     QVERIFY(resetSpy.isValid());
@@ -424,6 +438,11 @@ void TestInputMethodInterface::testContext()
     QVERIFY(resetSpy.wait());
     QCOMPARE(resetSpy.count(), 1);
 
+    // after a reset the input method gets the full state again
+    serverContext->sendSurroundingText("Hello Plasma!", 3, 3);
+    QVERIFY(surroundingTextSpy.wait());
+    QCOMPARE(surroundingTextSpy.count(), 3);
+
     // send deactivate and verify server interface resets context
     m_inputMethodIface->sendDeactivate();
     QVERIFY(inputMethodDeactivateSpy.wait());
@@ -596,6 +615,120 @@ void TestInputMethodInterface::testContentPurpose()
     QVERIFY(!m_inputMethod->context());
 }
 
+void TestInputMethodInterface::testUpdate()
+{
+    QVERIFY(m_inputMethodIface);
+    QSignalSpy inputMethodActivateSpy(m_inputMethod, &InputMethodV1::activated);
+    QSignalSpy inputMethodDeactivateSpy(m_inputMethod, &InputMethodV1::deactivated);
+    m_inputMethodIface->sendActivate();
+    QVERIFY(inputMethodActivateSpy.wait());
+
+    KWaylandServer::InputMethodContextV1Interface *serverContext = m_inputMethodIface->context();
+    QVERIFY(serverContext);
+    InputMethodV1Context *imContext = m_inputMethod->context();
+    QVERIFY(imContext);
+
+    QStringList events;
+    connect(imContext, &InputMethodV1Context::reset, this, [&events]() {
+        events << QStringLiteral("reset");
+    });
+    connect(imContext, &InputMethodV1Context::content_type_changed, this, [&events]() {
+        events << QStringLiteral("content_type");
+    });
+    connect(imContext, &InputMethodV1Context::surrounding_text, this, [&events](const QString &text) {
+        events << QStringLiteral("surrounding_text ") + text;
+    });
+    connect(imContext, &InputMethodV1Context::preferred_language, this, [&events](const QString &language) {
+        events << QStringLiteral("preferred_language ") + language;
+    });
+    connect(imContext, &InputMethodV1Context::invoke_action, this, [&events](quint32 button) {
+        events << QStringLiteral("invoke_action %1").arg(button);
+    });
+    QSignalSpy commitStateSpy(imContext, &InputMethodV1Context::commit_state);
+    connect(imContext, &InputMethodV1Context::commit_state, this, [&events](quint32 serial) {
+        events << QStringLiteral("commit_state %1").arg(serial);
+    });
+
+    // everything within an update is sent in one go, ending with the commit_state
+    serverContext->beginUpdate();
+    serverContext->sendSurroundingText(QStringLiteral("a"), 1, 1);
+    serverContext->beginUpdate();
+    serverContext->sendSurroundingText(QStringLiteral("ab"), 2, 2);
+    serverContext->sendContentType(KWaylandServer::TextInputContentHint::None, KWaylandServer::TextInputContentPurpose::Digits);
+    serverContext->sendPreferredLanguage(QStringLiteral("ja"));
+    serverContext->sendInvokeAction(1, 0);
+    serverContext->sendReset();
+    serverContext->sendCommitState(3);
+    serverContext->commitUpdate(4);
+    QVERIFY(!commitStateSpy.wait(100));
+    serverContext->commitUpdate(5);
+    QVERIFY(commitStateSpy.wait());
+    QCOMPARE(events, QStringList({
+        QStringLiteral("reset"),
+        QStringLiteral("content_type"),
+        QStringLiteral("surrounding_text ab"),
+        QStringLiteral("preferred_language ja"),
+        QStringLiteral("invoke_action 1"),
+        QStringLiteral("commit_state 5"),
+    }));
+
+    // unchanged surrounding text is not sent again
+    events.clear();
+    serverContext->beginUpdate();
+    serverContext->sendSurroundingText(QStringLiteral("ab"), 2, 2);
+    serverContext->commitUpdate(6);
+    QVERIFY(commitStateSpy.wait());
+    QCOMPARE(events, QStringList({QStringLiteral("commit_state 6")}));
+
+    m_inputMethodIface->sendDeactivate();
+    QVERIFY(inputMethodDeactivateSpy.wait());
+}
+
+void TestInputMethodInterface::testSurroundingTextLimit()
+{
+    QVERIFY(m_inputMethodIface);
+    QSignalSpy inputMethodActivateSpy(m_inputMethod, &InputMethodV1::activated);
+    QSignalSpy inputMethodDeactivateSpy(m_inputMethod, &InputMethodV1::deactivated);
+    m_inputMethodIface->sendActivate();
+    QVERIFY(inputMethodActivateSpy.wait());
+
+    KWaylandServer::InputMethodContextV1Interface *serverContext = m_inputMethodIface->context();
+    QVERIFY(serverContext);
+    InputMethodV1Context *imContext = m_inputMethod->context();
+    QVERIFY(imContext);
+    QSignalSpy surroundingTextSpy(imContext, &InputMethodV1Context::surrounding_text);
+
+    const QString text = QString(100, QLatin1Char('a')) + QStringLiteral("€") + QString(100, QLatin1Char('b'));
+    QCOMPARE(serverContext->surroundingTextLimit(), 0);
+
+    // a text within the limit is sent as it is
+    serverContext->setSurroundingTextLimit(1000);
+    serverContext->sendSurroundingText(text, 100, 100);
+    QVERIFY(surroundingTextSpy.wait());
+    QCOMPARE(surroundingTextSpy.last().at(0).toString(), text);
+    QCOMPARE(surroundingTextSpy.last().at(1).value<quint32>(), 100u);
+
+    // a longer one is clipped around the cursor, without cutting the euro sign in half
+    serverContext->setSurroundingTextLimit(20);
+    serverContext->sendSurroundingText(text, 100, 100);
+    QVERIFY(surroundingTextSpy.wait());
+    QCOMPARE(surroundingTextSpy.last().at(0).toString(), QString(10, QLatin1Char('a')) + QStringLiteral("€") + QString(7, QLatin1Char('b')));
+    QCOMPARE(surroundingTextSpy.last().at(1).value<quint32>(), 10u);
+    QCOMPARE(surroundingTextSpy.last().at(2).value<quint32>(), 10u);
+
+    // the window starts after a sequence it would cut into
+    serverContext->sendSurroundingText(text, 111, 111);
+    QVERIFY(surroundingTextSpy.wait());
+    QCOMPARE(surroundingTextSpy.last().at(0).toString(), QString(18, QLatin1Char('b')));
+    QCOMPARE(surroundingTextSpy.last().at(1).value<quint32>(), 8u);
+
+    // the same clipped text is not sent again
+    serverContext->sendSurroundingText(text, 111, 111);
+    QVERIFY(!surroundingTextSpy.wait(100));
+
+    m_inputMethodIface->sendDeactivate();
+    QVERIFY(inputMethodDeactivateSpy.wait());
+}
 
 QTEST_GUILESS_MAIN(TestInputMethodInterface)
 #include "test_inputmethod_interface.moc"
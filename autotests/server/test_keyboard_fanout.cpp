@@ -0,0 +1,195 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QThread>
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/keyboard_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+// KWayland
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/keyboard.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/seat.h"
+#include "KWayland/Client/surface.h"
+// Wayland
+#include <wayland-server.h>
+
+#include <linux/input.h>
+
+using namespace KWaylandServer;
+
+static const QString s_socketName = QStringLiteral("kwayland-test-keyboard-fanout-0");
+
+/**
+ * Measures how many key and modifier events per second the seat dispatches to the
+ * focused client.
+ **/
+class TestKeyboardFanOut : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void testKeyboardBoundAfterFocus();
+    void benchmarkKeys();
+    void benchmarkModifiers();
+
+private:
+    void report(const char *name, qint64 eventCount, qint64 nsecs);
+
+    Display m_display;
+    SeatInterface *m_seat = nullptr;
+    SurfaceInterface *m_serverSurface = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::Seat *m_clientSeat = nullptr;
+    KWayland::Client::Surface *m_surface = nullptr;
+    KWayland::Client::Keyboard *m_keyboard = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+// events sent between two flushes of the display
+static const int s_eventsPerBatch = 100;
+
+void TestKeyboardFanOut::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasKeyboard(true);
+    m_seat->create();
+    CompositorInterface *compositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    using Interface = KWayland::Client::Registry::Interface;
+    m_compositor = registry.createCompositor(registry.interface(Interface::Compositor).name,
+                                             registry.interface(Interface::Compositor).version, this);
+    m_clientSeat = registry.createSeat(registry.interface(Interface::Seat).name,
+                                       registry.interface(Interface::Seat).version, this);
+
+    QSignalSpy hasKeyboardSpy(m_clientSeat, &KWayland::Client::Seat::hasKeyboardChanged);
+    QVERIFY(hasKeyboardSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(compositor, &CompositorInterface::surfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    m_serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+}
+
+void TestKeyboardFanOut::cleanupTestCase()
+{
+    delete m_keyboard;
+    delete m_surface;
+    delete m_clientSeat;
+    delete m_compositor;
+    delete m_queue;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+    }
+}
+
+void TestKeyboardFanOut::report(const char *name, qint64 eventCount, qint64 nsecs)
+{
+    qInfo("%s: %.0f events/s", name, eventCount * 1e9 / qMax<qint64>(nsecs, 1));
+    // drop the events the client has queued meanwhile
+    QCoreApplication::processEvents();
+}
+
+void TestKeyboardFanOut::testKeyboardBoundAfterFocus()
+{
+    // a keyboard created while its client already has the focus gets the key events
+    m_seat->setFocusedKeyboardSurface(m_serverSurface);
+    QSignalSpy keyboardCreatedSpy(m_seat, &SeatInterface::keyboardCreated);
+    m_keyboard = m_clientSeat->createKeyboard(this);
+    QVERIFY(keyboardCreatedSpy.wait());
+
+    QSignalSpy keyChangedSpy(m_keyboard, &KWayland::Client::Keyboard::keyChanged);
+    m_seat->keyboard()->keyPressed(KEY_A);
+    m_seat->keyboard()->keyReleased(KEY_A);
+    QVERIFY(keyChangedSpy.wait());
+    if (keyChangedSpy.count() < 2) {
+        QVERIFY(keyChangedSpy.wait());
+    }
+    QCOMPARE(keyChangedSpy.count(), 2);
+    QCOMPARE(keyChangedSpy.first().first().value<quint32>(), quint32(KEY_A));
+
+    // entering again is unaffected
+    m_seat->setFocusedKeyboardSurface(nullptr);
+    m_seat->setFocusedKeyboardSurface(m_serverSurface);
+    QSignalSpy enteredSpy(m_keyboard, &KWayland::Client::Keyboard::entered);
+    QVERIFY(enteredSpy.wait());
+}
+
+void TestKeyboardFanOut::benchmarkKeys()
+{
+    QVERIFY(m_seat->focusedKeyboardSurface());
+    KeyboardInterface *keyboard = m_seat->keyboard();
+    QElapsedTimer timer;
+    qint64 eventCount = 0;
+    timer.start();
+    QBENCHMARK {
+        for (int i = 0; i < s_eventsPerBatch / 2; ++i) {
+            keyboard->keyPressed(KEY_A);
+            keyboard->keyReleased(KEY_A);
+        }
+        wl_display_flush_clients(m_display);
+        eventCount += s_eventsPerBatch;
+    }
+    report("keys", eventCount, timer.nsecsElapsed());
+}
+
+void TestKeyboardFanOut::benchmarkModifiers()
+{
+    QVERIFY(m_seat->focusedKeyboardSurface());
+    KeyboardInterface *keyboard = m_seat->keyboard();
+    QElapsedTimer timer;
+    qint64 eventCount = 0;
+    timer.start();
+    QBENCHMARK {
+        for (int i = 0; i < s_eventsPerBatch; ++i) {
+            keyboard->updateModifiers(i % 2, 0, 0, 0);
+        }
+        wl_display_flush_clients(m_display);
+        eventCount += s_eventsPerBatch;
+    }
+    report("modifiers", eventCount, timer.nsecsElapsed());
+}
+
+QTEST_GUILESS_MAIN(TestKeyboardFanOut)
+#include "test_keyboard_fanout.moc"
@@ -72,6 +72,7 @@ public:
 
 private Q_SLOTS:
     void initTestCase();
+    void testFocusedInhibitor();
     void testKeyboardShortcuts();
 
 private:
@@ -100,6 +101,7 @@ void TestKeyboardShortcutsInhibitorInterface::initTestCase()
     QVERIFY(m_display.isRunning());
 
     m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasKeyboard(true);
     m_seat->create();
     m_serverCompositor = new CompositorInterface(&m_display, this);
     m_manager = new KeyboardShortcutsInhibitManagerV1Interface(&m_display, this);
@@ -172,6 +174,39 @@ TestKeyboardShortcutsInhibitorInterface::~TestKeyboardShortcutsInhibitorInterfac
     m_connection = nullptr;
 }
 
+void TestKeyboardShortcutsInhibitorInterface::testFocusedInhibitor()
+{
+    // this test verifies that the seat tracks the inhibitor of the focused keyboard surface
+    auto surface = m_surfaces[2];
+    m_seat->setFocusedKeyboardSurface(surface);
+    QCOMPARE(m_seat->focusedKeyboardShortcutsInhibitor(), nullptr);
+
+    // creating an inhibitor for the focused surface updates the seat
+    QSignalSpy inhibitorCreatedSpy(m_manager, &KeyboardShortcutsInhibitManagerV1Interface::inhibitorCreated);
+    auto inhibitorClient = new KeyboardShortcutsInhibitor(m_inhibitManagerClient->inhibit_shortcuts(m_clientSurfaces[2], m_clientSeat->operator wl_seat *()));
+    QVERIFY(inhibitorCreatedSpy.wait());
+    auto inhibitorServer = m_manager->findInhibitor(surface, m_seat);
+    QVERIFY(inhibitorServer);
+    QCOMPARE(m_seat->focusedKeyboardShortcutsInhibitor(), inhibitorServer);
+    QVERIFY(m_seat->focusedKeyboardShortcutsInhibitor()->isActive());
+
+    // and it follows the keyboard focus
+    m_seat->setFocusedKeyboardSurface(m_surfaces[1]);
+    QCOMPARE(m_seat->focusedKeyboardShortcutsInhibitor(), nullptr);
+    m_seat->setFocusedKeyboardSurface(surface);
+    QCOMPARE(m_seat->focusedKeyboardShortcutsInhibitor(), inhibitorServer);
+
+    // destroying the inhibitor resets it
+    QSignalSpy destroyedSpy(inhibitorServer, &QObject::destroyed);
+    inhibitorClient->destroy();
+    delete inhibitorClient;
+    QVERIFY(destroyedSpy.wait());
+    QCOMPARE(m_seat->focusedKeyboardShortcutsInhibitor(), nullptr);
+    QCOMPARE(m_manager->findInhibitor(surface, m_seat), nullptr);
+
+    m_seat->setFocusedKeyboardSurface(nullptr);
+}
+
 void TestKeyboardShortcutsInhibitorInterface::testKeyboardShortcuts()
 {
     auto clientSurface = m_clientSurfaces[0];
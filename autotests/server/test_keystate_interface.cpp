@@ -0,0 +1,181 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/keystate_interface.h"
+
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+
+#include "qwayland-keystate.h"
+
+using namespace KWaylandServer;
+
+class KeyState : public QObject, public QtWayland::org_kde_kwin_keystate
+{
+    Q_OBJECT
+public:
+    KeyState(wl_registry *registry, quint32 id, quint32 version)
+        : QtWayland::org_kde_kwin_keystate(registry, id, version)
+    {
+    }
+
+Q_SIGNALS:
+    void stateChanged(quint32 key, quint32 state);
+
+protected:
+    void org_kde_kwin_keystate_stateChanged(uint32_t key, uint32_t state) override
+    {
+        Q_EMIT stateChanged(key, state);
+    }
+};
+
+class TestKeyStateInterface : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void init();
+    void cleanup();
+
+    void testFetchStates();
+    void testOnlyChanges();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    KeyState *m_keyState = nullptr;
+    QThread *m_thread = nullptr;
+
+    Display *m_display = nullptr;
+    KeyStateInterface *m_keyStateInterface = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwayland-test-keystate-interface-0");
+
+void TestKeyStateInterface::init()
+{
+    m_display = new Display(this);
+    m_display->addSocketName(s_socketName);
+    m_display->start();
+    QVERIFY(m_display->isRunning());
+    m_keyStateInterface = new KeyStateInterface(m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    m_registry = new KWayland::Client::Registry(this);
+    connect(m_registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == "org_kde_kwin_keystate") {
+            m_keyState = new KeyState(m_registry->registry(), id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(m_registry, &KWayland::Client::Registry::interfacesAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_keyState);
+}
+
+void TestKeyStateInterface::cleanup()
+{
+    delete m_keyState;
+    m_keyState = nullptr;
+    delete m_registry;
+    m_registry = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    delete m_display;
+    m_display = nullptr;
+}
+
+void TestKeyStateInterface::testFetchStates()
+{
+    QSignalSpy stateChangedSpy(m_keyState, &KeyState::stateChanged);
+    m_keyStateInterface->setState(KeyStateInterface::Key::NumLock, KeyStateInterface::Locked);
+
+    // fetching always sends all the states
+    m_keyState->fetchStates();
+    m_connection->flush();
+    QVERIFY(stateChangedSpy.wait());
+    while (stateChangedSpy.count() < 3) {
+        QVERIFY(stateChangedSpy.wait());
+    }
+    QCOMPARE(stateChangedSpy.count(), 3);
+    QCOMPARE(stateChangedSpy[0][0].value<quint32>(), quint32(KeyStateInterface::Key::CapsLock));
+    QCOMPARE(stateChangedSpy[0][1].value<quint32>(), quint32(KeyStateInterface::Unlocked));
+    QCOMPARE(stateChangedSpy[1][0].value<quint32>(), quint32(KeyStateInterface::Key::NumLock));
+    QCOMPARE(stateChangedSpy[1][1].value<quint32>(), quint32(KeyStateInterface::Locked));
+    QCOMPARE(stateChangedSpy[2][0].value<quint32>(), quint32(KeyStateInterface::Key::ScrollLock));
+    QCOMPARE(stateChangedSpy[2][1].value<quint32>(), quint32(KeyStateInterface::Unlocked));
+}
+
+void TestKeyStateInterface::testOnlyChanges()
+{
+    QSignalSpy stateChangedSpy(m_keyState, &KeyState::stateChanged);
+    m_keyState->fetchStates();
+    m_connection->flush();
+    while (stateChangedSpy.count() < 3) {
+        QVERIFY(stateChangedSpy.wait());
+    }
+    stateChangedSpy.clear();
+
+    // setting the current state again sends nothing
+    m_keyStateInterface->setState(KeyStateInterface::Key::CapsLock, KeyStateInterface::Unlocked);
+    QVERIFY(!stateChangedSpy.wait(100));
+
+    // a change and its revert within one go send nothing either
+    m_keyStateInterface->setState(KeyStateInterface::Key::CapsLock, KeyStateInterface::Locked);
+    m_keyStateInterface->setState(KeyStateInterface::Key::CapsLock, KeyStateInterface::Unlocked);
+    QVERIFY(!stateChangedSpy.wait(100));
+
+    // only the keys which changed are sent
+    m_keyStateInterface->setState(KeyStateInterface::Key::CapsLock, KeyStateInterface::Latched);
+    m_keyStateInterface->setState(KeyStateInterface::Key::CapsLock, KeyStateInterface::Locked);
+    m_keyStateInterface->setState(KeyStateInterface::Key::ScrollLock, KeyStateInterface::Locked);
+    QVERIFY(stateChangedSpy.wait());
+    if (stateChangedSpy.count() < 2) {
+        QVERIFY(stateChangedSpy.wait());
+    }
+    QVERIFY(!stateChangedSpy.wait(100));
+    QCOMPARE(stateChangedSpy.count(), 2);
+    QCOMPARE(stateChangedSpy[0][0].value<quint32>(), quint32(KeyStateInterface::Key::CapsLock));
+    QCOMPARE(stateChangedSpy[0][1].value<quint32>(), quint32(KeyStateInterface::Locked));
+    QCOMPARE(stateChangedSpy[1][0].value<quint32>(), quint32(KeyStateInterface::Key::ScrollLock));
+    QCOMPARE(stateChangedSpy[1][1].value<quint32>(), quint32(KeyStateInterface::Locked));
+}
+
+QTEST_GUILESS_MAIN(TestKeyStateInterface)
+#include "test_keystate_interface.moc"
@@ -10,12 +10,14 @@
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
 #include "../../src/server/layershell_v1_interface.h"
+#include "../../src/server/output_interface.h"
 #include "../../src/server/surface_interface.h"
 #include "../../src/server/xdgshell_interface.h"
 
 #include "KWayland/Client/compositor.h"
 #include "KWayland/Client/connection_thread.h"
 #include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/output.h"
 #include "KWayland/Client/registry.h"
 #include "KWayland/Client/surface.h"
 
@@ -39,6 +41,20 @@ public:
     ~LayerSurfaceV1() override { destroy(); }
 };
 
+class ConfigurableLayerSurfaceV1 : public LayerSurfaceV1
+{
+public:
+    quint32 lastSerial = 0;
+
+protected:
+    void zwlr_layer_surface_v1_configure(uint32_t serial, uint32_t width, uint32_t height) override
+    {
+        Q_UNUSED(width)
+        Q_UNUSED(height)
+        lastSerial = serial;
+    }
+};
+
 class XdgShell : public QtWayland::xdg_wm_base
 {
 public:
@@ -83,6 +99,8 @@ private Q_SLOTS:
     void testLayer_data();
     void testLayer();
     void testPopup();
+    void testConfigureBatch();
+    void testWorkArea();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -96,6 +114,8 @@ private:
     LayerShellV1Interface *m_serverLayerShell = nullptr;
     XdgShell *m_clientXdgShell = nullptr;
     XdgShellInterface *m_serverXdgShell = nullptr;
+    OutputInterface *m_serverOutput = nullptr;
+    KWayland::Client::Output *m_clientOutput = nullptr;
 };
 
 static const QString s_socketName = QStringLiteral("kwin-wayland-server-layer-shell-v1-test-0");
@@ -109,6 +129,10 @@ void TestLayerShellV1Interface::initTestCase()
     m_serverLayerShell = new LayerShellV1Interface(&m_display, this);
     m_serverXdgShell = new XdgShellInterface(&m_display, this);
     m_serverCompositor = new CompositorInterface(&m_display, this);
+    m_serverOutput = new OutputInterface(&m_display, this);
+    m_serverOutput->addMode(QSize(1920, 1080));
+    m_serverOutput->setCurrentMode(QSize(1920, 1080));
+    m_serverOutput->create();
 
     m_connection = new KWayland::Client::ConnectionThread;
     QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
@@ -138,6 +162,10 @@ void TestLayerShellV1Interface::initTestCase()
             m_clientXdgShell->init(*registry, id, version);
         }
     });
+    connect(registry, &KWayland::Client::Registry::outputAnnounced, this, [this, registry](quint32 name, quint32 version) {
+        m_clientOutput = new KWayland::Client::Output(this);
+        m_clientOutput->setup(registry->bindOutput(name, version));
+    });
     QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfaceAnnounced);
     QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
     QSignalSpy shmSpy(registry, &KWayland::Client::Registry::shmAnnounced);
@@ -534,6 +562,155 @@ void TestLayerShellV1Interface::testPopup()
     QCOMPARE(serverPopupShellSurface->parentSurface(), serverPanelSurface);
 }
 
+void TestLayerShellV1Interface::testConfigureBatch()
+{
+    QSignalSpy layerSurfaceCreatedSpy(m_serverLayerShell, &LayerShellV1Interface::surfaceCreated);
+    QVERIFY(layerSurfaceCreatedSpy.isValid());
+
+    // Create a panel, a dock and a wallpaper.
+    QScopedPointer<KWayland::Client::Surface> clientPanelSurface(m_clientCompositor->createSurface(this));
+    QScopedPointer<ConfigurableLayerSurfaceV1> clientPanelShellSurface(new ConfigurableLayerSurfaceV1);
+    clientPanelShellSurface->init(m_clientLayerShell->get_layer_surface(*clientPanelSurface, nullptr,
+                                                                        LayerShellV1::layer_top,
+                                                                        QStringLiteral("panel")));
+    QVERIFY(layerSurfaceCreatedSpy.wait());
+    auto serverPanelShellSurface = layerSurfaceCreatedSpy.last().first().value<LayerSurfaceV1Interface *>();
+
+    QScopedPointer<KWayland::Client::Surface> clientDockSurface(m_clientCompositor->createSurface(this));
+    QScopedPointer<ConfigurableLayerSurfaceV1> clientDockShellSurface(new ConfigurableLayerSurfaceV1);
+    clientDockShellSurface->init(m_clientLayerShell->get_layer_surface(*clientDockSurface, nullptr,
+                                                                       LayerShellV1::layer_top,
+                                                                       QStringLiteral("dock")));
+    QVERIFY(layerSurfaceCreatedSpy.wait());
+    auto serverDockShellSurface = layerSurfaceCreatedSpy.last().first().value<LayerSurfaceV1Interface *>();
+
+    QScopedPointer<KWayland::Client::Surface> clientWallpaperSurface(m_clientCompositor->createSurface(this));
+    QScopedPointer<ConfigurableLayerSurfaceV1> clientWallpaperShellSurface(new ConfigurableLayerSurfaceV1);
+    clientWallpaperShellSurface->init(m_clientLayerShell->get_layer_surface(*clientWallpaperSurface, nullptr,
+                                                                            LayerShellV1::layer_background,
+                                                                            QStringLiteral("wallpaper")));
+    QVERIFY(layerSurfaceCreatedSpy.wait());
+    auto serverWallpaperShellSurface = layerSurfaceCreatedSpy.last().first().value<LayerSurfaceV1Interface *>();
+
+    QSignalSpy configuresAcknowledgedSpy(m_serverLayerShell, &LayerShellV1Interface::configuresAcknowledged);
+    QVERIFY(configuresAcknowledgedSpy.isValid());
+
+    // Relayout all three surfaces at once.
+    QHash<LayerSurfaceV1Interface *, QSize> sizes;
+    sizes.insert(serverPanelShellSurface, QSize(1920, 30));
+    sizes.insert(serverDockShellSurface, QSize(600, 60));
+    sizes.insert(serverWallpaperShellSurface, QSize(1920, 1080));
+    const quint32 batch = m_serverLayerShell->sendConfigures(sizes);
+    QVERIFY(batch);
+    QVERIFY(m_serverLayerShell->isConfigurePending(batch));
+
+    QTRY_VERIFY(clientPanelShellSurface->lastSerial);
+    QTRY_VERIFY(clientDockShellSurface->lastSerial);
+    QTRY_VERIFY(clientWallpaperShellSurface->lastSerial);
+
+    // The batch is pending until every surface has acknowledged its configure event.
+    QSignalSpy panelAcknowledgedSpy(serverPanelShellSurface, &LayerSurfaceV1Interface::configureAcknowledged);
+    clientPanelShellSurface->ack_configure(clientPanelShellSurface->lastSerial);
+    QVERIFY(panelAcknowledgedSpy.wait());
+    QSignalSpy dockAcknowledgedSpy(serverDockShellSurface, &LayerSurfaceV1Interface::configureAcknowledged);
+    clientDockShellSurface->ack_configure(clientDockShellSurface->lastSerial);
+    QVERIFY(dockAcknowledgedSpy.wait());
+    QCOMPARE(configuresAcknowledgedSpy.count(), 0);
+    QVERIFY(m_serverLayerShell->isConfigurePending(batch));
+
+    // A destroyed surface doesn't hold the batch back.
+    QSignalSpy wallpaperDestroyedSpy(serverWallpaperShellSurface, &LayerSurfaceV1Interface::aboutToBeDestroyed);
+    clientWallpaperShellSurface.reset();
+    QVERIFY(configuresAcknowledgedSpy.wait());
+    QCOMPARE(wallpaperDestroyedSpy.count(), 1);
+    QCOMPARE(configuresAcknowledgedSpy.count(), 1);
+    QCOMPARE(configuresAcknowledgedSpy.first().first().value<quint32>(), batch);
+    QVERIFY(!m_serverLayerShell->isConfigurePending(batch));
+
+    // A closed surface doesn't hold the batch back either.
+    sizes.remove(serverWallpaperShellSurface);
+    const quint32 secondBatch = m_serverLayerShell->sendConfigures(sizes);
+    QVERIFY(secondBatch);
+    QVERIFY(secondBatch != batch);
+    const quint32 previousDockSerial = clientDockShellSurface->lastSerial;
+    QTRY_VERIFY(clientDockShellSurface->lastSerial != previousDockSerial);
+    clientDockShellSurface->ack_configure(clientDockShellSurface->lastSerial);
+    QVERIFY(dockAcknowledgedSpy.wait());
+    QCOMPARE(configuresAcknowledgedSpy.count(), 1);
+    serverPanelShellSurface->sendClosed();
+    QCOMPARE(configuresAcknowledgedSpy.count(), 2);
+    QCOMPARE(configuresAcknowledgedSpy.last().first().value<quint32>(), secondBatch);
+
+    // Nothing is sent to closed surfaces.
+    sizes.remove(serverDockShellSurface);
+    QCOMPARE(m_serverLayerShell->sendConfigures(sizes), 0u);
+}
+
+void TestLayerShellV1Interface::testWorkArea()
+{
+    QTRY_VERIFY(m_clientOutput);
+    QCOMPARE(m_serverLayerShell->workArea(m_serverOutput), QRect(0, 0, 1920, 1080));
+    QSignalSpy workAreaChangedSpy(m_serverLayerShell, &LayerShellV1Interface::workAreaChanged);
+    QVERIFY(workAreaChangedSpy.isValid());
+    QSignalSpy layerSurfaceCreatedSpy(m_serverLayerShell, &LayerShellV1Interface::surfaceCreated);
+    QVERIFY(layerSurfaceCreatedSpy.isValid());
+
+    // A panel at the top edge, its margin is reserved as well.
+    QScopedPointer<KWayland::Client::Surface> clientPanelSurface(m_clientCompositor->createSurface(this));
+    QScopedPointer<LayerSurfaceV1> clientPanelShellSurface(new LayerSurfaceV1);
+    clientPanelShellSurface->init(m_clientLayerShell->get_layer_surface(*clientPanelSurface, *m_clientOutput,
+                                                                        LayerShellV1::layer_top,
+                                                                        QStringLiteral("panel")));
+    QVERIFY(layerSurfaceCreatedSpy.wait());
+    auto serverPanelShellSurface = layerSurfaceCreatedSpy.last().first().value<LayerSurfaceV1Interface *>();
+    clientPanelShellSurface->set_anchor(LayerSurfaceV1::anchor_top | LayerSurfaceV1::anchor_left | LayerSurfaceV1::anchor_right);
+    clientPanelShellSurface->set_size(0, 30);
+    clientPanelShellSurface->set_exclusive_zone(30);
+    clientPanelShellSurface->set_margin(5, 0, 0, 0);
+    clientPanelSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(workAreaChangedSpy.wait());
+    QCOMPARE(workAreaChangedSpy.last().at(0).value<OutputInterface *>(), m_serverOutput);
+    QCOMPARE(workAreaChangedSpy.last().at(1).toRect(), QRect(0, 35, 1920, 1045));
+    QCOMPARE(m_serverLayerShell->workArea(m_serverOutput), QRect(0, 35, 1920, 1045));
+
+    // A dock at the bottom edge.
+    QScopedPointer<KWayland::Client::Surface> clientDockSurface(m_clientCompositor->createSurface(this));
+    QScopedPointer<LayerSurfaceV1> clientDockShellSurface(new LayerSurfaceV1);
+    clientDockShellSurface->init(m_clientLayerShell->get_layer_surface(*clientDockSurface, *m_clientOutput,
+                                                                       LayerShellV1::layer_top,
+                                                                       QStringLiteral("dock")));
+    QVERIFY(layerSurfaceCreatedSpy.wait());
+    clientDockShellSurface->set_anchor(LayerSurfaceV1::anchor_bottom);
+    clientDockShellSurface->set_size(600, 60);
+    clientDockShellSurface->set_exclusive_zone(60);
+    clientDockSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(workAreaChangedSpy.wait());
+    QCOMPARE(workAreaChangedSpy.count(), 2);
+    QCOMPARE(workAreaChangedSpy.last().at(1).toRect(), QRect(0, 35, 1920, 985));
+
+    // Changes which don't touch the exclusive zone don't change the work area.
+    QSignalSpy desiredSizeChangedSpy(serverPanelShellSurface, &LayerSurfaceV1Interface::desiredSizeChanged);
+    QVERIFY(desiredSizeChangedSpy.isValid());
+    clientPanelShellSurface->set_size(0, 40);
+    clientPanelSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(desiredSizeChangedSpy.wait());
+    QCOMPARE(workAreaChangedSpy.count(), 2);
+
+    // The work area follows the output.
+    m_serverOutput->setGlobalPosition(QPoint(1920, 0));
+    QCOMPARE(workAreaChangedSpy.count(), 3);
+    QCOMPARE(workAreaChangedSpy.last().at(1).toRect(), QRect(1920, 35, 1920, 985));
+
+    // A destroyed surface doesn't reserve space anymore.
+    QSignalSpy panelDestroyedSpy(serverPanelShellSurface, &LayerSurfaceV1Interface::aboutToBeDestroyed);
+    clientPanelShellSurface.reset();
+    QVERIFY(workAreaChangedSpy.wait());
+    QCOMPARE(panelDestroyedSpy.count(), 1);
+    QCOMPARE(workAreaChangedSpy.last().at(1).toRect(), QRect(1920, 0, 1920, 1020));
+
+    m_serverOutput->setGlobalPosition(QPoint(0, 0));
+}
+
 QTEST_GUILESS_MAIN(TestLayerShellV1Interface)
 
 #include "test_layershellv1_interface.moc"
@@ -0,0 +1,566 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/linuxdmabuf_v1_interface.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "KWayland/Client/buffer.h"
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/region.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-linux-dmabuf-unstable-v1.h"
+
+#include <sys/mman.h>
+#include <sys/sysmacros.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+// the same values as in drm_fourcc.h
+static const uint32_t s_formatXrgb8888 = 0x34325258;
+static const uint32_t s_formatArgb8888 = 0x34325241;
+static const uint64_t s_modifierLinear = 0;
+static const uint64_t s_modifierInvalid = 0x00ffffffffffffffULL;
+static const uint64_t s_modifierTiled = 0x0100000000000001ULL;
+
+class TestBuffer : public LinuxDmabufUnstableV1Buffer
+{
+public:
+    TestBuffer(const QVector<LinuxDmabufUnstableV1Interface::Plane> &planes, uint32_t format, const QSize &size, int *alive)
+        : LinuxDmabufUnstableV1Buffer(format, size)
+        , m_planes(planes)
+        , m_alive(alive)
+    {
+        (*m_alive)++;
+    }
+    ~TestBuffer() override
+    {
+        for (const LinuxDmabufUnstableV1Interface::Plane &plane : qAsConst(m_planes)) {
+            close(plane.fd);
+        }
+        (*m_alive)--;
+    }
+
+private:
+    QVector<LinuxDmabufUnstableV1Interface::Plane> m_planes;
+    int *m_alive;
+};
+
+class TestImpl : public LinuxDmabufUnstableV1Interface::Impl
+{
+public:
+    LinuxDmabufUnstableV1Buffer *importBuffer(const QVector<LinuxDmabufUnstableV1Interface::Plane> &planes,
+                                              uint32_t format,
+                                              const QSize &size,
+                                              LinuxDmabufUnstableV1Interface::Flags flags) override
+    {
+        Q_UNUSED(flags)
+        imports++;
+        return new TestBuffer(planes, format, size, &alive);
+    }
+
+    int imports = 0;
+    int alive = 0;
+};
+
+class LinuxDmabuf : public QObject, public QtWayland::zwp_linux_dmabuf_v1
+{
+    Q_OBJECT
+public:
+    ~LinuxDmabuf() override
+    {
+        destroy();
+    }
+
+    QVector<QPair<uint32_t, uint64_t>> modifiers;
+    QVector<uint32_t> formats;
+
+protected:
+    void zwp_linux_dmabuf_v1_format(uint32_t format) override
+    {
+        formats << format;
+    }
+    void zwp_linux_dmabuf_v1_modifier(uint32_t format, uint32_t modifier_hi, uint32_t modifier_lo) override
+    {
+        modifiers << qMakePair(format, (uint64_t(modifier_hi) << 32) | modifier_lo);
+    }
+};
+
+class LinuxDmabufFeedback : public QObject, public QtWayland::zwp_linux_dmabuf_feedback_v1
+{
+    Q_OBJECT
+public:
+    struct Tranche
+    {
+        dev_t device = 0;
+        uint32_t flags = 0;
+        QVector<QPair<uint32_t, uint64_t>> formats;
+    };
+
+    ~LinuxDmabufFeedback() override
+    {
+        destroy();
+    }
+
+    // the state after the last done event
+    dev_t mainDevice = 0;
+    QVector<Tranche> tranches;
+    int doneCount = 0;
+
+Q_SIGNALS:
+    void done();
+
+protected:
+    void zwp_linux_dmabuf_feedback_v1_format_table(int32_t fd, uint32_t size) override
+    {
+        m_table.clear();
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            return;
+        }
+        struct Entry {
+            uint32_t format;
+            uint32_t padding;
+            uint64_t modifier;
+        };
+        const Entry *entries = static_cast<const Entry *>(data);
+        for (uint32_t i = 0; i < size / sizeof(Entry); ++i) {
+            m_table << qMakePair(entries[i].format, entries[i].modifier);
+        }
+        munmap(data, size);
+    }
+    void zwp_linux_dmabuf_feedback_v1_main_device(wl_array *device) override
+    {
+        memcpy(&m_mainDevice, device->data, sizeof(dev_t));
+    }
+    void zwp_linux_dmabuf_feedback_v1_tranche_target_device(wl_array *device) override
+    {
+        memcpy(&m_tranche.device, device->data, sizeof(dev_t));
+    }
+    void zwp_linux_dmabuf_feedback_v1_tranche_flags(uint32_t flags) override
+    {
+        m_tranche.flags = flags;
+    }
+    void zwp_linux_dmabuf_feedback_v1_tranche_formats(wl_array *indices) override
+    {
+        const uint16_t *index = static_cast<const uint16_t *>(indices->data);
+        for (size_t i = 0; i < indices->size / sizeof(uint16_t); ++i) {
+            m_tranche.formats << m_table.value(index[i]);
+        }
+    }
+    void zwp_linux_dmabuf_feedback_v1_tranche_done() override
+    {
+        m_tranches << m_tranche;
+        m_tranche = Tranche();
+    }
+    void zwp_linux_dmabuf_feedback_v1_done() override
+    {
+        mainDevice = m_mainDevice;
+        tranches = m_tranches;
+        m_tranches.clear();
+        doneCount++;
+        Q_EMIT done();
+    }
+
+private:
+    QVector<QPair<uint32_t, uint64_t>> m_table;
+    dev_t m_mainDevice = 0;
+    Tranche m_tranche;
+    QVector<Tranche> m_tranches;
+};
+
+class TestLinuxDmabufInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestLinuxDmabufInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testLegacyModifiers();
+    void testDefaultFeedback();
+    void testScanoutFeedback();
+    void testSurfaceTranches();
+    void testImportCache();
+    void testScanoutCandidate();
+
+private:
+    LinuxDmabuf *bind(quint32 version);
+
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+    KWayland::Client::Registry *m_registry;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    LinuxDmabufUnstableV1Interface *m_linuxDmabuf;
+    OutputInterface *m_output;
+    quint32 m_linuxDmabufName = 0;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-linuxdmabuf-test-0");
+
+void TestLinuxDmabufInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+    m_output = new OutputInterface(&m_display, this);
+    m_output->create();
+    m_linuxDmabuf = new LinuxDmabufUnstableV1Interface(&m_display, this);
+    m_linuxDmabuf->create();
+    m_linuxDmabuf->setMainDevice(makedev(226, 128));
+    m_linuxDmabuf->setSupportedFormatsWithModifiers({
+        {s_formatXrgb8888, {s_modifierLinear, s_modifierTiled}},
+        {s_formatArgb8888, {}},
+    });
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new KWayland::Client::Registry(this);
+    connect(m_registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this](const QByteArray &interface, quint32 id) {
+        if (interface == QByteArrayLiteral("zwp_linux_dmabuf_v1")) {
+            m_linuxDmabufName = id;
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(m_registry, &KWayland::Client::Registry::compositorAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_linuxDmabufName);
+
+    m_clientCompositor = m_registry->createCompositor(compositorSpy.first().first().value<quint32>(),
+                                                      compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+}
+
+TestLinuxDmabufInterface::~TestLinuxDmabufInterface()
+{
+    delete m_clientCompositor;
+    delete m_registry;
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+LinuxDmabuf *TestLinuxDmabufInterface::bind(quint32 version)
+{
+    auto linuxDmabuf = new LinuxDmabuf;
+    linuxDmabuf->init(*m_registry, m_linuxDmabufName, version);
+    return linuxDmabuf;
+}
+
+void TestLinuxDmabufInterface::testLegacyModifiers()
+{
+    // this test verifies that clients before version 4 still get an event per modifier
+    QScopedPointer<LinuxDmabuf> linuxDmabuf(bind(3));
+    QTRY_COMPARE(linuxDmabuf->modifiers.count(), 3);
+    QVERIFY(linuxDmabuf->modifiers.contains(qMakePair(s_formatXrgb8888, s_modifierLinear)));
+    QVERIFY(linuxDmabuf->modifiers.contains(qMakePair(s_formatXrgb8888, s_modifierTiled)));
+    QVERIFY(linuxDmabuf->modifiers.contains(qMakePair(s_formatArgb8888, s_modifierInvalid)));
+
+    // and only the linear and implicit formats before version 3
+    QScopedPointer<LinuxDmabuf> oldLinuxDmabuf(bind(2));
+    QTRY_COMPARE(oldLinuxDmabuf->formats.count(), 2);
+    QVERIFY(oldLinuxDmabuf->modifiers.isEmpty());
+}
+
+void TestLinuxDmabufInterface::testDefaultFeedback()
+{
+    // this test verifies that version 4 clients get the formats from the feedback only
+    QScopedPointer<LinuxDmabuf> linuxDmabuf(bind(4));
+    QScopedPointer<LinuxDmabufFeedback> feedback(new LinuxDmabufFeedback);
+    feedback->init(linuxDmabuf->get_default_feedback());
+    QSignalSpy doneSpy(feedback.data(), &LinuxDmabufFeedback::done);
+    QVERIFY(doneSpy.wait());
+    QVERIFY(linuxDmabuf->modifiers.isEmpty());
+    QVERIFY(linuxDmabuf->formats.isEmpty());
+
+    QCOMPARE(feedback->mainDevice, makedev(226, 128));
+    QCOMPARE(feedback->tranches.count(), 1);
+    const LinuxDmabufFeedback::Tranche tranche = feedback->tranches.first();
+    QCOMPARE(tranche.device, makedev(226, 128));
+    QCOMPARE(tranche.flags, 0u);
+    QCOMPARE(tranche.formats.count(), 3);
+    QVERIFY(tranche.formats.contains(qMakePair(s_formatXrgb8888, s_modifierLinear)));
+    QVERIFY(tranche.formats.contains(qMakePair(s_formatXrgb8888, s_modifierTiled)));
+    QVERIFY(tranche.formats.contains(qMakePair(s_formatArgb8888, s_modifierInvalid)));
+
+    // a new set of formats comes with a new table
+    m_linuxDmabuf->setSupportedFormatsWithModifiers({{s_formatXrgb8888, {s_modifierLinear}}});
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.count(), 1);
+    QCOMPARE(feedback->tranches.first().formats, (QVector<QPair<uint32_t, uint64_t>>{qMakePair(s_formatXrgb8888, s_modifierLinear)}));
+
+    m_linuxDmabuf->setSupportedFormatsWithModifiers({
+        {s_formatXrgb8888, {s_modifierLinear, s_modifierTiled}},
+        {s_formatArgb8888, {}},
+    });
+    QVERIFY(doneSpy.wait());
+}
+
+void TestLinuxDmabufInterface::testScanoutFeedback()
+{
+    // this test verifies that a surface put on an output prefers its scanout formats
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> surface(m_clientCompositor->createSurface());
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+
+    QScopedPointer<LinuxDmabuf> linuxDmabuf(bind(4));
+    QScopedPointer<LinuxDmabufFeedback> defaultFeedback(new LinuxDmabufFeedback);
+    defaultFeedback->init(linuxDmabuf->get_default_feedback());
+    QScopedPointer<LinuxDmabufFeedback> feedback(new LinuxDmabufFeedback);
+    feedback->init(linuxDmabuf->get_surface_feedback(*surface));
+    QSignalSpy doneSpy(feedback.data(), &LinuxDmabufFeedback::done);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.count(), 1);
+    QCOMPARE(defaultFeedback->doneCount, 1);
+
+    // the scanout formats alone don't change the feedback of the surface
+    m_linuxDmabuf->setScanoutFormatsWithModifiers(m_output, {{s_formatXrgb8888, {s_modifierLinear}}});
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.count(), 1);
+
+    m_linuxDmabuf->setScanoutOutput(serverSurface, m_output);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.count(), 2);
+    QCOMPARE(feedback->tranches.first().flags, uint32_t(ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT));
+    QCOMPARE(feedback->tranches.first().formats, (QVector<QPair<uint32_t, uint64_t>>{qMakePair(s_formatXrgb8888, s_modifierLinear)}));
+    QCOMPARE(feedback->tranches.last().flags, 0u);
+    QCOMPARE(feedback->tranches.last().formats.count(), 3);
+
+    // the default feedback is left alone
+    QCOMPARE(defaultFeedback->doneCount, 2);
+    QCOMPARE(defaultFeedback->tranches.count(), 1);
+
+    m_linuxDmabuf->setScanoutOutput(serverSurface, nullptr);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.count(), 1);
+    m_linuxDmabuf->setScanoutFormatsWithModifiers(m_output, {});
+}
+
+void TestLinuxDmabufInterface::testSurfaceTranches()
+{
+    // this test verifies that the tranches of a surface are preferred over the imported formats
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> surface(m_clientCompositor->createSurface());
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+
+    QScopedPointer<LinuxDmabuf> linuxDmabuf(bind(4));
+    QScopedPointer<LinuxDmabufFeedback> defaultFeedback(new LinuxDmabufFeedback);
+    defaultFeedback->init(linuxDmabuf->get_default_feedback());
+    QScopedPointer<LinuxDmabufFeedback> feedback(new LinuxDmabufFeedback);
+    feedback->init(linuxDmabuf->get_surface_feedback(*surface));
+    QSignalSpy doneSpy(feedback.data(), &LinuxDmabufFeedback::done);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(defaultFeedback->doneCount, 1);
+
+    // an overlay plane on another device which takes known pairs only
+    LinuxDmabufUnstableV1Interface::Tranche overlay;
+    overlay.device = makedev(226, 0);
+    overlay.formats = {{s_formatXrgb8888, {s_modifierTiled}}};
+    overlay.flags = LinuxDmabufUnstableV1Interface::Scanout;
+    m_linuxDmabuf->setSurfaceTranches(serverSurface, {overlay});
+    QCOMPARE(m_linuxDmabuf->surfaceTranches(serverSurface).count(), 1);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.count(), 2);
+    QCOMPARE(feedback->tranches.first().device, makedev(226, 0));
+    QCOMPARE(feedback->tranches.first().flags, uint32_t(ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT));
+    QCOMPARE(feedback->tranches.first().formats, (QVector<QPair<uint32_t, uint64_t>>{qMakePair(s_formatXrgb8888, s_modifierTiled)}));
+    QCOMPARE(feedback->tranches.last().device, makedev(226, 128));
+    QCOMPARE(defaultFeedback->doneCount, 1);
+
+    // a pair which isn't in the table yet makes everybody get a new table
+    overlay.formats = {{s_formatArgb8888, {s_modifierTiled}}};
+    m_linuxDmabuf->setSurfaceTranches(serverSurface, {overlay});
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.first().formats, (QVector<QPair<uint32_t, uint64_t>>{qMakePair(s_formatArgb8888, s_modifierTiled)}));
+    QCOMPARE(feedback->tranches.last().formats.count(), 3);
+    QCOMPARE(defaultFeedback->doneCount, 2);
+    QCOMPARE(defaultFeedback->tranches.count(), 1);
+    QCOMPARE(defaultFeedback->tranches.first().formats.count(), 3);
+
+    m_linuxDmabuf->setSurfaceTranches(serverSurface, {});
+    QVERIFY(m_linuxDmabuf->surfaceTranches(serverSurface).isEmpty());
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(feedback->tranches.count(), 1);
+}
+
+void TestLinuxDmabufInterface::testImportCache()
+{
+    // this test verifies that buffers over the same dmabuf share one import
+    TestImpl impl;
+    m_linuxDmabuf->setImpl(&impl);
+    m_linuxDmabuf->setImportCacheSize(2);
+    QCOMPARE(m_linuxDmabuf->importCacheSize(), 2);
+
+    // any file which can be sought is as good as a dmabuf here
+    const int fd = memfd_create("kwayland-test-dmabuf", MFD_CLOEXEC);
+    QVERIFY(fd >= 0);
+    QCOMPARE(ftruncate(fd, 4096), 0);
+
+    QScopedPointer<LinuxDmabuf> linuxDmabuf(bind(4));
+    auto createBuffer = [&](uint32_t offset) {
+        QtWayland::zwp_linux_buffer_params_v1 params(linuxDmabuf->create_params());
+        params.add(fd, 0, offset, 64, s_modifierLinear >> 32, s_modifierLinear & 0xffffffff);
+        wl_buffer *buffer = params.create_immed(16, 16, s_formatXrgb8888, 0);
+        params.destroy();
+        m_connection->flush();
+        return buffer;
+    };
+
+    wl_buffer *first = createBuffer(0);
+    wl_buffer *second = createBuffer(0);
+    wl_buffer *third = createBuffer(1024);
+    QTRY_COMPARE(impl.imports, 2);
+    QCOMPARE(impl.alive, 2);
+
+    // the unused imports stay around for the next buffers
+    wl_buffer_destroy(first);
+    wl_buffer_destroy(second);
+    wl_buffer_destroy(third);
+    wl_buffer *fourth = createBuffer(0);
+    wl_buffer *fifth = createBuffer(2048);
+    QTRY_COMPARE(impl.imports, 3);
+    QCOMPARE(impl.alive, 3);
+
+    // without a cache only the imports in use are left
+    m_linuxDmabuf->setImportCacheSize(0);
+    QCOMPARE(impl.alive, 2);
+    wl_buffer_destroy(fourth);
+    wl_buffer_destroy(fifth);
+    m_connection->flush();
+    QTRY_COMPARE(impl.alive, 0);
+
+    close(fd);
+    m_linuxDmabuf->setImpl(nullptr);
+}
+
+void TestLinuxDmabufInterface::testScanoutCandidate()
+{
+    // this test verifies when the dmabuf of a surface can be scanned out directly
+    using Candidate = SurfaceInterface::ScanoutCandidate;
+    TestImpl impl;
+    m_linuxDmabuf->setImpl(&impl);
+    m_output->addMode(QSize(16, 16));
+    m_output->setCurrentMode(QSize(16, 16));
+
+    const int fd = memfd_create("kwayland-test-dmabuf", MFD_CLOEXEC);
+    QVERIFY(fd >= 0);
+    QCOMPARE(ftruncate(fd, 4096), 0);
+
+    QSignalSpy serverSurfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> surface(m_clientCompositor->createSurface());
+    QVERIFY(serverSurfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = serverSurfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::NoBuffer);
+    QSignalSpy committedSpy(serverSurface, &SurfaceInterface::committed);
+
+    QScopedPointer<LinuxDmabuf> linuxDmabuf(bind(4));
+    auto attachBuffer = [&](const QSize &size, uint32_t format, uint64_t modifier) {
+        QtWayland::zwp_linux_buffer_params_v1 params(linuxDmabuf->create_params());
+        params.add(fd, 0, 0, size.width() * 4, modifier >> 32, modifier & 0xffffffff);
+        wl_buffer *buffer = params.create_immed(size.width(), size.height(), format, 0);
+        params.destroy();
+        surface->attachBuffer(buffer);
+        surface->damage(QRect(QPoint(0, 0), size));
+        surface->commit(KWayland::Client::Surface::CommitFlag::None);
+        return buffer;
+    };
+
+    wl_buffer *opaqueBuffer = attachBuffer(QSize(16, 16), s_formatXrgb8888, s_modifierLinear);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::Candidate);
+    QCOMPARE(serverSurface->scanoutCandidate(nullptr), Candidate::Candidate);
+
+    // the output checks aren't cached
+    m_output->setTransform(OutputInterface::Transform::Rotated90);
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::Transformed);
+    m_output->setTransform(OutputInterface::Transform::Normal);
+    m_output->addMode(QSize(32, 32));
+    m_output->setCurrentMode(QSize(32, 32));
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::NotCoveringOutput);
+    QCOMPARE(serverSurface->scanoutCandidate(nullptr), Candidate::Candidate);
+    m_output->setCurrentMode(QSize(16, 16));
+
+    // a buffer with an alpha channel has to be covered by the opaque region
+    wl_buffer *translucentBuffer = attachBuffer(QSize(16, 16), s_formatArgb8888, s_modifierInvalid);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::Translucent);
+    surface->setOpaqueRegion(m_clientCompositor->createRegion(QRegion(0, 0, 16, 16)).get());
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::Candidate);
+
+    // the buffer scale leaves the surface smaller than the buffer
+    surface->setScale(2);
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->size(), QSize(8, 8));
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::Translucent);
+    surface->setOpaqueRegion(m_clientCompositor->createRegion(QRegion(0, 0, 8, 8)).get());
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::Candidate);
+
+    surface->attachBuffer(KWayland::Client::Buffer::Ptr());
+    surface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QCOMPARE(serverSurface->scanoutCandidate(m_output), Candidate::NoBuffer);
+
+    wl_buffer_destroy(opaqueBuffer);
+    wl_buffer_destroy(translucentBuffer);
+    m_connection->flush();
+    QTRY_COMPARE(impl.alive, 0);
+    close(fd);
+    m_linuxDmabuf->setImpl(nullptr);
+}
+
+QTEST_GUILESS_MAIN(TestLinuxDmabufInterface)
+
+#include "test_linuxdmabuf_v1_interface.moc"
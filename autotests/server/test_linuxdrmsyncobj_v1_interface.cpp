@@ -0,0 +1,224 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/linuxdrmsyncobj_v1_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/shm_pool.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-linux-drm-syncobj-v1.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class SyncObjManager : public QtWayland::wp_linux_drm_syncobj_manager_v1
+{
+};
+
+class TestLinuxDrmSyncObjInterface : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void init();
+    void cleanup();
+    void testImplicitCommit();
+    void testSurfaceExists();
+    void testInvalidTimeline();
+    void testUnsupportedBuffer();
+
+private:
+    SurfaceInterface *createSurface(KWayland::Client::Surface **clientSurface);
+    uint32_t waitForError();
+
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Compositor *m_clientCompositor = nullptr;
+    KWayland::Client::ShmPool *m_shm = nullptr;
+    KWayland::Client::Registry *m_registry = nullptr;
+    SyncObjManager *m_syncObjManager = nullptr;
+
+    QThread *m_thread = nullptr;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-linuxdrmsyncobj-test-0");
+
+void TestLinuxDrmSyncObjInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_display.createShm();
+    new LinuxDrmSyncObjManagerV1Interface(&m_display, this);
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+}
+
+void TestLinuxDrmSyncObjInterface::init()
+{
+    // a protocol error ends the connection, so every test gets its own
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    m_registry = new KWayland::Client::Registry(this);
+    connect(m_registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_linux_drm_syncobj_manager_v1")) {
+            m_syncObjManager = new SyncObjManager();
+            m_syncObjManager->init(*m_registry, id, version);
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(m_registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(m_registry, &KWayland::Client::Registry::compositorAnnounced);
+    QSignalSpy shmSpy(m_registry, &KWayland::Client::Registry::shmAnnounced);
+    m_registry->setEventQueue(m_queue);
+    m_registry->create(m_connection->display());
+    QVERIFY(m_registry->isValid());
+    m_registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_syncObjManager);
+
+    m_clientCompositor = m_registry->createCompositor(compositorSpy.first().first().value<quint32>(),
+                                                      compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+    m_shm = m_registry->createShmPool(shmSpy.first().first().value<quint32>(),
+                                      shmSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_shm->isValid());
+}
+
+void TestLinuxDrmSyncObjInterface::cleanup()
+{
+#define CLEANUP(variable) \
+    delete variable;      \
+    variable = nullptr;
+    CLEANUP(m_syncObjManager)
+    CLEANUP(m_shm)
+    CLEANUP(m_clientCompositor)
+    CLEANUP(m_registry)
+    CLEANUP(m_queue)
+#undef CLEANUP
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+SurfaceInterface *TestLinuxDrmSyncObjInterface::createSurface(KWayland::Client::Surface **clientSurface)
+{
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    *clientSurface = m_clientCompositor->createSurface(this);
+    if (!surfaceCreatedSpy.wait()) {
+        return nullptr;
+    }
+    return surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+}
+
+uint32_t TestLinuxDrmSyncObjInterface::waitForError()
+{
+    QSignalSpy errorSpy(m_connection, &KWayland::Client::ConnectionThread::errorOccurred);
+    m_connection->flush();
+    if (!errorSpy.wait()) {
+        return UINT32_MAX;
+    }
+    const wl_interface *interface = nullptr;
+    return wl_display_get_protocol_error(m_connection->display(), &interface, nullptr);
+}
+
+void TestLinuxDrmSyncObjInterface::testImplicitCommit()
+{
+    // this test verifies that commits without a new buffer don't need timeline points
+    KWayland::Client::Surface *clientSurface;
+    SurfaceInterface *surface = createSurface(&clientSurface);
+    QVERIFY(surface);
+    QtWayland::wp_linux_drm_syncobj_surface_v1 syncObjSurface(m_syncObjManager->get_surface(*clientSurface));
+
+    QSignalSpy committedSpy(surface, &SurfaceInterface::committed);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(!surface->acquirePoint().isValid());
+    QVERIFY(!surface->releasePoint().isValid());
+
+    // without the synchronization object any buffer can be attached again
+    syncObjSurface.destroy();
+    QImage image(QSize(16, 16), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    clientSurface->attachBuffer(m_shm->createBuffer(image));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+    QVERIFY(surface->buffer());
+    QVERIFY(!surface->releasePoint().isValid());
+
+    delete clientSurface;
+}
+
+void TestLinuxDrmSyncObjInterface::testSurfaceExists()
+{
+    KWayland::Client::Surface *clientSurface;
+    QVERIFY(createSurface(&clientSurface));
+    m_syncObjManager->get_surface(*clientSurface);
+    m_syncObjManager->get_surface(*clientSurface);
+    QCOMPARE(waitForError(), uint32_t(QtWayland::wp_linux_drm_syncobj_manager_v1::error_surface_exists));
+    delete clientSurface;
+}
+
+void TestLinuxDrmSyncObjInterface::testInvalidTimeline()
+{
+    const int fd = memfd_create("kwayland-test-timeline", MFD_CLOEXEC);
+    QVERIFY(fd >= 0);
+    m_syncObjManager->import_timeline(fd);
+    close(fd);
+    QCOMPARE(waitForError(), uint32_t(QtWayland::wp_linux_drm_syncobj_manager_v1::error_invalid_timeline));
+}
+
+void TestLinuxDrmSyncObjInterface::testUnsupportedBuffer()
+{
+    // this test verifies that only dmabuf buffers can be synchronized explicitly
+    KWayland::Client::Surface *clientSurface;
+    SurfaceInterface *surface = createSurface(&clientSurface);
+    QVERIFY(surface);
+    m_syncObjManager->get_surface(*clientSurface);
+
+    QSignalSpy committedSpy(surface, &SurfaceInterface::committed);
+    QImage image(QSize(16, 16), QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::red);
+    clientSurface->attachBuffer(m_shm->createBuffer(image));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QCOMPARE(waitForError(), uint32_t(QtWayland::wp_linux_drm_syncobj_surface_v1::error_unsupported_buffer));
+    QVERIFY(committedSpy.isEmpty());
+    delete clientSurface;
+}
+
+QTEST_GUILESS_MAIN(TestLinuxDrmSyncObjInterface)
+#include "test_linuxdrmsyncobj_v1_interface.moc"
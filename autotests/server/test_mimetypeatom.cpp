@@ -0,0 +1,72 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/mimetypeatom.h"
+
+using namespace KWaylandServer;
+
+class TestMimeTypeAtom : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void testNull();
+    void testInterning();
+    void testRelease();
+};
+
+void TestMimeTypeAtom::testNull()
+{
+    const MimeTypeAtom atom;
+    QVERIFY(atom.isNull());
+    QCOMPARE(atom.id(), 0u);
+    QCOMPARE(atom.toString(), QString());
+    QCOMPARE(atom.constData(), "");
+}
+
+void TestMimeTypeAtom::testInterning()
+{
+    // this test verifies that all atoms of a mime type share one entry
+    const int count = MimeTypeAtom::internedCount();
+    const MimeTypeAtom text(QStringLiteral("text/plain"));
+    const MimeTypeAtom other(QString::fromUtf8("text/plain;charset=utf-8"));
+    const MimeTypeAtom copy(QString::fromLatin1("text/plain"));
+    QCOMPARE(MimeTypeAtom::internedCount(), count + 2);
+
+    QVERIFY(!text.isNull());
+    QVERIFY(text == copy);
+    QVERIFY(text != other);
+    QCOMPARE(text.id(), copy.id());
+    QVERIFY(text.id() != other.id());
+    QCOMPARE(text.constData(), copy.constData());
+    QCOMPARE(other.toUtf8(), QByteArrayLiteral("text/plain;charset=utf-8"));
+
+    const QStringList mimeTypes = MimeTypeAtom::toStringList({text, other});
+    QCOMPARE(mimeTypes, QStringList({QStringLiteral("text/plain"), QStringLiteral("text/plain;charset=utf-8")}));
+}
+
+void TestMimeTypeAtom::testRelease()
+{
+    // this test verifies that the entry goes away with the last atom
+    const int count = MimeTypeAtom::internedCount();
+    MimeTypeAtom atom(QStringLiteral("image/png"));
+    MimeTypeAtoms atoms{atom, atom};
+    QCOMPARE(MimeTypeAtom::internedCount(), count + 1);
+
+    atom = MimeTypeAtom();
+    QCOMPARE(MimeTypeAtom::internedCount(), count + 1);
+    atoms.clear();
+    QCOMPARE(MimeTypeAtom::internedCount(), count);
+
+    // interning again works
+    const MimeTypeAtom again(QStringLiteral("image/png"));
+    QCOMPARE(again.toString(), QStringLiteral("image/png"));
+    QCOMPARE(MimeTypeAtom::internedCount(), count + 1);
+}
+
+QTEST_GUILESS_MAIN(TestMimeTypeAtom)
+#include "test_mimetypeatom.moc"
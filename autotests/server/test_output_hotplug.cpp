@@ -0,0 +1,287 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/outputdevice_interface.h"
+#include "../../src/server/xdgoutput_v1_interface.h"
+// Wayland
+#include <wayland-client.h>
+#include <wayland-server.h>
+#include "wayland-org_kde_kwin_outputdevice-client-protocol.h"
+#include "wayland-xdg-output-unstable-v1-client-protocol.h"
+
+#include "benchmarkhelpers.h"
+
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+
+using namespace KWaylandServer;
+using namespace BenchmarkHelpers;
+
+// clients which bind every output, like the panels, docks and daemons of a session
+static const int s_clientCount = 8;
+static const int s_warmupCycles = 5;
+static const int s_cycles = 200;
+// upper bound of the events a bound client gets for one plug and unplug of an output,
+// raise it only together with a justification of the new events
+static const int s_maxEventsPerClient = 48;
+
+struct HotplugClient
+{
+    struct Output {
+        uint32_t name = 0;
+        wl_output *output = nullptr;
+        zxdg_output_v1 *xdgOutput = nullptr;
+        org_kde_kwin_outputdevice *outputDevice = nullptr;
+    };
+
+    wl_display *display = nullptr;
+    wl_registry *registry = nullptr;
+    RegistryListener registryListener;
+    zxdg_output_manager_v1 *xdgOutputManager = nullptr;
+    std::vector<Output> outputs;
+};
+
+static void registryGlobal(HotplugClient *client, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    if (qstrcmp(interface, zxdg_output_manager_v1_interface.name) == 0) {
+        client->xdgOutputManager = static_cast<zxdg_output_manager_v1 *>(wl_registry_bind(registry, name, &zxdg_output_manager_v1_interface, qMin(version, 3u)));
+    } else if (qstrcmp(interface, wl_output_interface.name) == 0) {
+        HotplugClient::Output output;
+        output.name = name;
+        output.output = static_cast<wl_output *>(wl_registry_bind(registry, name, &wl_output_interface, qMin(version, 3u)));
+        if (client->xdgOutputManager) {
+            output.xdgOutput = zxdg_output_manager_v1_get_xdg_output(client->xdgOutputManager, output.output);
+        }
+        client->outputs.push_back(output);
+    } else if (qstrcmp(interface, org_kde_kwin_outputdevice_interface.name) == 0) {
+        HotplugClient::Output output;
+        output.name = name;
+        output.outputDevice = static_cast<org_kde_kwin_outputdevice *>(wl_registry_bind(registry, name, &org_kde_kwin_outputdevice_interface, qMin(version, 2u)));
+        client->outputs.push_back(output);
+    }
+}
+
+static void registryGlobalRemove(HotplugClient *client, uint32_t name)
+{
+    for (auto it = client->outputs.begin(); it != client->outputs.end(); ++it) {
+        if (it->name != name) {
+            continue;
+        }
+        if (it->xdgOutput) {
+            zxdg_output_v1_destroy(it->xdgOutput);
+        }
+        if (it->output) {
+            if (wl_proxy_get_version(reinterpret_cast<wl_proxy *>(it->output)) >= WL_OUTPUT_RELEASE_SINCE_VERSION) {
+                wl_output_release(it->output);
+            } else {
+                wl_output_destroy(it->output);
+            }
+        }
+        if (it->outputDevice) {
+            org_kde_kwin_outputdevice_destroy(it->outputDevice);
+        }
+        client->outputs.erase(it);
+        return;
+    }
+}
+
+/**
+ * Plugs and unplugs an output, with its wl_output, xdg-output and outputdevice, while
+ * several clients have bound all of them, like a docking station that flaps. Measures the
+ * events sent per hotplug, the time until server and clients are idle again and the
+ * growth of the live allocations. The clients are plain libwayland connections over
+ * socket pairs driven from the test thread.
+ **/
+class TestOutputHotplug : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkHotplug();
+
+private:
+    void hotplug();
+    bool dispatchClient(HotplugClient &client);
+    void quiesce();
+    quint64 sentEvents() const;
+
+    Display m_display;
+    XdgOutputManagerV1Interface *m_xdgOutputManager = nullptr;
+    std::vector<HotplugClient> m_clients;
+};
+
+void TestOutputHotplug::initTestCase()
+{
+    QVERIFY(m_display.start());
+    m_display.setProtocolStatisticsEnabled(true);
+    m_xdgOutputManager = new XdgOutputManagerV1Interface(&m_display, this);
+
+    m_clients.resize(s_clientCount);
+    for (HotplugClient &client : m_clients) {
+        int sv[2];
+        QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+        QVERIFY(m_display.createClient(sv[0]));
+        client.display = wl_display_connect_to_fd(sv[1]);
+        QVERIFY(client.display);
+        client.registry = wl_display_get_registry(client.display);
+        client.registryListener.listen(
+            client.registry,
+            [&client](wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+                registryGlobal(&client, registry, name, interface, version);
+            },
+            [&client](uint32_t name) {
+                registryGlobalRemove(&client, name);
+            });
+    }
+    quiesce();
+    for (const HotplugClient &client : m_clients) {
+        QVERIFY(client.xdgOutputManager);
+    }
+}
+
+void TestOutputHotplug::cleanupTestCase()
+{
+    for (HotplugClient &client : m_clients) {
+        if (client.xdgOutputManager) {
+            zxdg_output_manager_v1_destroy(client.xdgOutputManager);
+        }
+        if (client.registry) {
+            wl_registry_destroy(client.registry);
+        }
+        if (client.display) {
+            wl_display_disconnect(client.display);
+        }
+    }
+}
+
+bool TestOutputHotplug::dispatchClient(HotplugClient &client)
+{
+    wl_display_flush(client.display);
+    while (wl_display_prepare_read(client.display) != 0) {
+        wl_display_dispatch_pending(client.display);
+    }
+    pollfd pfd = {wl_display_get_fd(client.display), POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0) {
+        wl_display_read_events(client.display);
+    } else {
+        wl_display_cancel_read(client.display);
+    }
+    const int dispatched = wl_display_dispatch_pending(client.display);
+    wl_display_flush(client.display);
+    return dispatched > 0;
+}
+
+void TestOutputHotplug::quiesce()
+{
+    // idle once a round neither dispatches anything on a client nor sends a message
+    quint64 messages = 0;
+    bool busy = true;
+    while (busy) {
+        m_display.dispatchEvents();
+        wl_display_flush_clients(m_display);
+        busy = false;
+        for (HotplugClient &client : m_clients) {
+            busy |= dispatchClient(client);
+        }
+        m_display.dispatchEvents();
+        wl_display_flush_clients(m_display);
+
+        quint64 total = 0;
+        const ProtocolStatistics statistics = m_display.protocolStatistics();
+        for (const ProtocolMessageStatistics &message : statistics) {
+            total += message.count;
+        }
+        busy |= total != messages;
+        messages = total;
+    }
+}
+
+quint64 TestOutputHotplug::sentEvents() const
+{
+    quint64 events = 0;
+    const ProtocolStatistics statistics = m_display.protocolStatistics();
+    for (const ProtocolMessageStatistics &message : statistics) {
+        if (message.direction == ProtocolMessageStatistics::Direction::Event) {
+            events += message.count;
+        }
+    }
+    return events;
+}
+
+void TestOutputHotplug::hotplug()
+{
+    auto output = new OutputInterface(&m_display);
+    output->setPhysicalSize(QSize(520, 290));
+    output->addMode(QSize(3840, 2160), OutputInterface::ModeFlag::Preferred, 60000);
+    output->setCurrentMode(QSize(3840, 2160), 60000);
+    output->setScale(2);
+    output->create();
+
+    auto xdgOutput = m_xdgOutputManager->createXdgOutput(output, output);
+    xdgOutput->setName(QStringLiteral("DP-1"));
+    xdgOutput->setDescription(QStringLiteral("Docking station"));
+    xdgOutput->setLogicalPosition(QPoint(1920, 0));
+    xdgOutput->setLogicalSize(QSize(1920, 1080));
+    xdgOutput->done();
+
+    auto outputDevice = new OutputDeviceInterface(&m_display);
+    OutputDeviceInterface::Mode mode;
+    mode.id = 0;
+    mode.size = QSize(3840, 2160);
+    mode.refreshRate = 60000;
+    mode.flags = OutputDeviceInterface::ModeFlags(OutputDeviceInterface::ModeFlag::Preferred);
+    outputDevice->addMode(mode);
+    outputDevice->setCurrentMode(0);
+    outputDevice->setUuid(QByteArrayLiteral("dock-dp-1"));
+    outputDevice->setEdid(QByteArray(256, 'e'));
+    outputDevice->create();
+    quiesce();
+
+    delete outputDevice;
+    delete output;
+    quiesce();
+}
+
+void TestOutputHotplug::benchmarkHotplug()
+{
+    for (int i = 0; i < s_warmupCycles; ++i) {
+        hotplug();
+    }
+    for (const HotplugClient &client : m_clients) {
+        QVERIFY(client.outputs.empty());
+    }
+
+    m_display.resetProtocolStatistics();
+    const qint64 liveAllocations = liveAllocationCount();
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < s_cycles; ++i) {
+            hotplug();
+        }
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    const double eventsPerHotplug = double(sentEvents()) / s_cycles;
+    // the statistics grow with the messages seen, not with the cycles
+    const qint64 growth = liveAllocationCount() - liveAllocations;
+
+    qInfo("%d clients: %.1f events/hotplug, %.1f us until idle, %lld allocations grown",
+          s_clientCount, eventsPerHotplug, elapsed / 1000.0 / s_cycles, growth);
+
+    QVERIFY(eventsPerHotplug <= s_clientCount * s_maxEventsPerClient);
+    // one leaked object per hotplug would add up over a day of flapping
+    QVERIFY(growth < s_cycles);
+}
+
+QTEST_GUILESS_MAIN(TestOutputHotplug)
+#include "test_output_hotplug.moc"
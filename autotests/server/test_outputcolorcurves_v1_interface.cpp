@@ -0,0 +1,252 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/outputcolorcurves_v1_interface.h"
+#include "../../src/server/outputdevice_interface.h"
+
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+
+#include "qwayland-kde-output-color-curves-v1.h"
+#include "qwayland-org_kde_kwin_outputdevice.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class ColorCurvesManager : public QtWayland::kde_output_color_curves_manager_v1
+{
+};
+
+class OutputDevice : public QtWayland::org_kde_kwin_outputdevice
+{
+public:
+    int colorCurvesEvents = 0;
+
+protected:
+    void org_kde_kwin_outputdevice_colorcurves(wl_array *red, wl_array *green, wl_array *blue) override
+    {
+        Q_UNUSED(red)
+        Q_UNUSED(green)
+        Q_UNUSED(blue)
+        colorCurvesEvents++;
+    }
+};
+
+class ColorCurves : public QObject, public QtWayland::kde_output_color_curves_v1
+{
+    Q_OBJECT
+
+public:
+    ~ColorCurves() override
+    {
+        unmap();
+        destroy();
+    }
+
+    /**
+     * Copies the red ramp following the generation protocol.
+     */
+    QVector<quint16> red() const
+    {
+        const auto header = static_cast<const quint32 *>(m_memory);
+        while (true) {
+            const quint32 generation = __atomic_load_n(&header[0], __ATOMIC_ACQUIRE);
+            if (generation % 2) {
+                continue;
+            }
+            QVector<quint16> ramp(header[1]);
+            memcpy(ramp.data(), header + 2, ramp.size() * sizeof(quint16));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&header[0], __ATOMIC_RELAXED) == generation) {
+                return ramp;
+            }
+        }
+    }
+
+    int fd = -1;
+    void *m_memory = nullptr;
+    size_t m_size = 0;
+
+Q_SIGNALS:
+    void rampsReceived();
+    void changed(quint32 generation);
+
+protected:
+    void kde_output_color_curves_v1_ramps(int32_t fd, uint32_t size) override
+    {
+        unmap();
+        this->fd = fd;
+        m_size = size;
+        m_memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        emit rampsReceived();
+    }
+    void kde_output_color_curves_v1_changed(uint32_t generation) override
+    {
+        emit changed(generation);
+    }
+
+private:
+    void unmap()
+    {
+        if (m_memory && m_memory != MAP_FAILED) {
+            munmap(m_memory, m_size);
+        }
+        m_memory = nullptr;
+        if (fd >= 0) {
+            close(fd);
+            fd = -1;
+        }
+    }
+};
+
+class TestOutputColorCurvesV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestOutputColorCurvesV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testSharedRamps();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    QThread *m_thread;
+
+    Display m_display;
+    OutputDeviceInterface *m_serverOutputDevice;
+    ColorCurvesManager *m_manager = nullptr;
+    OutputDevice *m_outputDevice = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-output-color-curves-test-0");
+
+static OutputDeviceInterface::ColorCurves makeCurves(int size, quint16 offset)
+{
+    OutputDeviceInterface::ColorCurves curves;
+    for (int i = 0; i < size; ++i) {
+        curves.red << quint16(i + offset);
+        curves.green << quint16(2 * i + offset);
+        curves.blue << quint16(3 * i + offset);
+    }
+    return curves;
+}
+
+void TestOutputColorCurvesV1Interface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_serverOutputDevice = new OutputDeviceInterface(&m_display, this);
+    OutputDeviceInterface::Mode mode;
+    mode.id = 0;
+    mode.size = QSize(1920, 1080);
+    m_serverOutputDevice->addMode(mode);
+    m_serverOutputDevice->setColorCurves(makeCurves(256, 0));
+    m_serverOutputDevice->create();
+    new OutputColorCurvesManagerV1Interface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("kde_output_color_curves_manager_v1")) {
+            m_manager = new ColorCurvesManager();
+            m_manager->init(*registry, id, version);
+        } else if (interface == QByteArrayLiteral("org_kde_kwin_outputdevice")) {
+            m_outputDevice = new OutputDevice();
+            m_outputDevice->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_manager);
+    QVERIFY(m_outputDevice);
+}
+
+TestOutputColorCurvesV1Interface::~TestOutputColorCurvesV1Interface()
+{
+    delete m_manager;
+    delete m_outputDevice;
+    delete m_queue;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_connection->deleteLater();
+}
+
+void TestOutputColorCurvesV1Interface::testSharedRamps()
+{
+    ColorCurves curves;
+    QSignalSpy rampsSpy(&curves, &ColorCurves::rampsReceived);
+    QSignalSpy changedSpy(&curves, &ColorCurves::changed);
+    curves.init(m_manager->get_color_curves(m_outputDevice->object()));
+    QVERIFY(rampsSpy.wait());
+    QVERIFY(curves.m_memory != MAP_FAILED);
+    QCOMPARE(curves.red(), makeCurves(256, 0).red);
+    // the ramps can be read, but not changed by the clients
+    QCOMPARE(mmap(nullptr, curves.m_size, PROT_READ | PROT_WRITE, MAP_SHARED, curves.fd, 0), MAP_FAILED);
+    const quint16 entry = 0xffff;
+    QVERIFY(pwrite(curves.fd, &entry, sizeof(entry), 8) < 0);
+    // neither through the descriptor reopened for writing
+    const QByteArray path = QByteArrayLiteral("/proc/self/fd/") + QByteArray::number(curves.fd);
+    const int writableFd = open(path.constData(), O_RDWR | O_CLOEXEC);
+    if (writableFd >= 0) {
+        QVERIFY(pwrite(writableFd, &entry, sizeof(entry), 8) < 0);
+        QCOMPARE(mmap(nullptr, curves.m_size, PROT_READ | PROT_WRITE, MAP_SHARED, writableFd, 0), MAP_FAILED);
+        close(writableFd);
+    }
+    QCOMPARE(curves.red(), makeCurves(256, 0).red);
+
+    // an update of the same size only announces the new generation
+    const int colorCurvesEvents = m_outputDevice->colorCurvesEvents;
+    m_serverOutputDevice->setColorCurves(makeCurves(256, 7));
+    QVERIFY(changedSpy.wait());
+    QCOMPARE(rampsSpy.count(), 1);
+    QCOMPARE(changedSpy.last().first().value<quint32>() % 2, 0u);
+    QCOMPARE(curves.red(), makeCurves(256, 7).red);
+    // the output device no longer carries the ramps, its event would have arrived first
+    QCOMPARE(m_outputDevice->colorCurvesEvents, colorCurvesEvents);
+
+    // a different size needs a new mapping
+    m_serverOutputDevice->setColorCurves(makeCurves(1024, 3));
+    QVERIFY(rampsSpy.wait());
+    QCOMPARE(curves.red(), makeCurves(1024, 3).red);
+}
+
+QTEST_GUILESS_MAIN(TestOutputColorCurvesV1Interface)
+
+#include "test_outputcolorcurves_v1_interface.moc"
@@ -0,0 +1,186 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/plasmawindowinterest_v1_interface.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+
+#include "qwayland-kde-plasma-window-interest-v1.h"
+#include "qwayland-plasma-window-management.h"
+
+using namespace KWaylandServer;
+
+class InterestManager : public QtWayland::kde_plasma_window_interest_manager_v1
+{
+};
+
+class WindowManagement : public QtWayland::org_kde_plasma_window_management
+{
+};
+
+class Window : public QObject, public QtWayland::org_kde_plasma_window
+{
+    Q_OBJECT
+
+public:
+    ~Window() override
+    {
+        destroy();
+    }
+
+    int titleEvents = 0;
+    int stateEvents = 0;
+    int geometryEvents = 0;
+
+Q_SIGNALS:
+    void initialState();
+    void geometryChanged();
+
+protected:
+    void org_kde_plasma_window_title_changed(const QString &title) override
+    {
+        Q_UNUSED(title)
+        titleEvents++;
+    }
+    void org_kde_plasma_window_state_changed(uint32_t flags) override
+    {
+        Q_UNUSED(flags)
+        stateEvents++;
+    }
+    void org_kde_plasma_window_geometry(int32_t x, int32_t y, uint32_t width, uint32_t height) override
+    {
+        Q_UNUSED(x)
+        Q_UNUSED(y)
+        Q_UNUSED(width)
+        Q_UNUSED(height)
+        geometryEvents++;
+        emit geometryChanged();
+    }
+    void org_kde_plasma_window_initial_state() override
+    {
+        emit initialState();
+    }
+};
+
+class TestPlasmaWindowInterestV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestPlasmaWindowInterestV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testGeometryOnly();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    QThread *m_thread;
+
+    Display m_display;
+    PlasmaWindowManagementInterface *m_serverWindowManagement;
+    InterestManager *m_manager = nullptr;
+    WindowManagement *m_windowManagement = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-plasma-window-interest-test-0");
+
+void TestPlasmaWindowInterestV1Interface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_serverWindowManagement = new PlasmaWindowManagementInterface(&m_display, this);
+    new PlasmaWindowInterestManagerV1Interface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("kde_plasma_window_interest_manager_v1")) {
+            m_manager = new InterestManager();
+            m_manager->init(*registry, id, version);
+        } else if (interface == QByteArrayLiteral("org_kde_plasma_window_management")) {
+            m_windowManagement = new WindowManagement();
+            m_windowManagement->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_manager);
+    QVERIFY(m_windowManagement);
+}
+
+TestPlasmaWindowInterestV1Interface::~TestPlasmaWindowInterestV1Interface()
+{
+    delete m_manager;
+    delete m_windowManagement;
+    delete m_queue;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_connection->deleteLater();
+}
+
+void TestPlasmaWindowInterestV1Interface::testGeometryOnly()
+{
+    // a pager only asks for the geometries
+    m_manager->set_interest(m_windowManagement->object(), QtWayland::kde_plasma_window_interest_manager_v1::property_geometry);
+
+    PlasmaWindowInterface *serverWindow = m_serverWindowManagement->createWindow(this, QUuid::createUuid());
+    serverWindow->setTitle(QStringLiteral("foo"));
+    serverWindow->setGeometry(QRect(0, 0, 100, 50));
+
+    Window window;
+    QSignalSpy initialStateSpy(&window, &Window::initialState);
+    QSignalSpy geometryChangedSpy(&window, &Window::geometryChanged);
+    window.init(m_windowManagement->get_window(serverWindow->internalId()));
+    QVERIFY(initialStateSpy.wait());
+    QCOMPARE(window.geometryEvents, 1);
+    QCOMPARE(window.titleEvents, 0);
+    QCOMPARE(window.stateEvents, 0);
+
+    // later changes skip the other properties as well
+    serverWindow->setTitle(QStringLiteral("bar"));
+    serverWindow->setActive(true);
+    serverWindow->setGeometry(QRect(10, 0, 100, 50));
+    QVERIFY(geometryChangedSpy.wait());
+    QCOMPARE(window.geometryEvents, 2);
+    QCOMPARE(window.titleEvents, 0);
+    QCOMPARE(window.stateEvents, 0);
+}
+
+QTEST_GUILESS_MAIN(TestPlasmaWindowInterestV1Interface)
+
+#include "test_plasmawindowinterest_v1_interface.moc"
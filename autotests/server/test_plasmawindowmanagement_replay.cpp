@@ -0,0 +1,358 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QRandomGenerator>
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/display.h"
+#include "../../src/server/plasmavirtualdesktop_interface.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+// Wayland
+#include <wayland-client.h>
+#include <wayland-server.h>
+#include "qwayland-plasma-window-management.h"
+
+#include "benchmarkhelpers.h"
+
+#include <memory>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <time.h>
+
+using namespace KWaylandServer;
+using namespace BenchmarkHelpers;
+
+// the task manager, pager, window switcher and friends of a session
+static const int s_clientCount = 6;
+static const int s_windowCount = 40;
+static const int s_desktopCount = 4;
+static const int s_operationCount = 4000;
+// the trace is the same on every run, so the numbers of two builds can be compared
+static const quint32 s_traceSeed = 0x6b77696e;
+
+class Window : public QtWayland::org_kde_plasma_window
+{
+public:
+    explicit Window(struct ::org_kde_plasma_window *window)
+        : QtWayland::org_kde_plasma_window(window)
+    {
+    }
+    ~Window() override
+    {
+        destroy();
+    }
+};
+
+class WindowManagement : public QtWayland::org_kde_plasma_window_management
+{
+public:
+    std::vector<std::unique_ptr<Window>> windows;
+
+protected:
+    void org_kde_plasma_window_management_window(uint32_t id) override
+    {
+        windows.emplace_back(new Window(get_window(id)));
+    }
+    void org_kde_plasma_window_management_window_with_uuid(uint32_t id, const QString &uuid) override
+    {
+        Q_UNUSED(uuid)
+        windows.emplace_back(new Window(get_window(id)));
+    }
+};
+
+struct ReplayClient
+{
+    wl_display *display = nullptr;
+    wl_registry *registry = nullptr;
+    RegistryListener registryListener;
+    std::unique_ptr<WindowManagement> windowManagement;
+};
+
+struct ReplayOperation
+{
+    enum class Type {
+        FocusChange,
+        TitleUpdate,
+        Move,
+        DesktopSwitch,
+    };
+    Type type = Type::TitleUpdate;
+    int window = 0;
+    int value = 0;
+};
+
+struct ReplayCost
+{
+    int operations = 0;
+    quint64 events = 0;
+    quint64 bytes = 0;
+    qint64 cpuNsecs = 0;
+};
+
+static qint64 threadCpuTime()
+{
+    timespec time;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+/**
+ * Replays a fixed trace of focus changes, terminal title updates, window moves and
+ * virtual desktop switches on a PlasmaWindowManagementInterface with several windows and
+ * bound clients, and reports the events, bytes and server CPU time per kind of operation.
+ * The clients are plain libwayland connections over socket pairs driven from the test
+ * thread, the CPU time they take to decode the events is not attributed to the server.
+ **/
+class TestPlasmaWindowManagementReplay : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkReplay();
+
+private:
+    void createTrace();
+    void replay(const ReplayOperation &operation);
+    bool dispatchClient(ReplayClient &client);
+    void dispatchServer();
+    void quiesce();
+    void sentEvents(quint64 *events, quint64 *bytes) const;
+
+    Display m_display;
+    PlasmaVirtualDesktopManagementInterface *m_desktopManagement = nullptr;
+    PlasmaWindowManagementInterface *m_windowManagement = nullptr;
+    QVector<PlasmaWindowInterface *> m_windows;
+    QVector<quint32> m_stackingOrder;
+    std::vector<ReplayClient> m_clients;
+    std::vector<ReplayOperation> m_trace;
+    int m_activeWindow = 0;
+    int m_currentDesktop = 0;
+};
+
+void TestPlasmaWindowManagementReplay::initTestCase()
+{
+    QVERIFY(m_display.start());
+    m_display.setProtocolStatisticsEnabled(true);
+
+    m_desktopManagement = new PlasmaVirtualDesktopManagementInterface(&m_display, this);
+    for (int i = 0; i < s_desktopCount; ++i) {
+        PlasmaVirtualDesktopInterface *desktop = m_desktopManagement->createDesktop(QStringLiteral("desktop-%1").arg(i));
+        desktop->setName(QStringLiteral("Desktop %1").arg(i + 1));
+        desktop->setActive(i == 0);
+    }
+    m_windowManagement = new PlasmaWindowManagementInterface(&m_display, this);
+    m_windowManagement->setPlasmaVirtualDesktopManagementInterface(m_desktopManagement);
+
+    for (int i = 0; i < s_windowCount; ++i) {
+        PlasmaWindowInterface *window = m_windowManagement->createWindow(this, QUuid::createUuid());
+        window->beginUpdate();
+        window->setTitle(QStringLiteral("user@host: ~/src/project-%1").arg(i));
+        window->setAppId(i % 3 ? QStringLiteral("org.kde.konsole") : QStringLiteral("org.kde.dolphin"));
+        window->setPid(1000 + i);
+        window->setGeometry(QRect(40 * (i % 10), 30 * (i % 8), 1280, 800));
+        window->addPlasmaVirtualDesktop(QStringLiteral("desktop-%1").arg(i % s_desktopCount));
+        window->commitUpdate();
+        m_windows << window;
+        m_stackingOrder << window->internalId();
+    }
+    m_windows.first()->setActive(true);
+    m_windowManagement->setStackingOrder(m_stackingOrder);
+
+    m_clients.resize(s_clientCount);
+    for (ReplayClient &client : m_clients) {
+        int sv[2];
+        QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+        QVERIFY(m_display.createClient(sv[0]));
+        client.display = wl_display_connect_to_fd(sv[1]);
+        QVERIFY(client.display);
+        client.registry = wl_display_get_registry(client.display);
+        client.registryListener.listen(client.registry, [&client](wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+            if (qstrcmp(interface, "org_kde_plasma_window_management") == 0) {
+                client.windowManagement.reset(new WindowManagement);
+                client.windowManagement->init(registry, name, qMin<uint32_t>(version, WindowManagement::interface()->version));
+            }
+        });
+    }
+    quiesce();
+    for (const ReplayClient &client : m_clients) {
+        QVERIFY(client.windowManagement);
+        QCOMPARE(int(client.windowManagement->windows.size()), s_windowCount);
+    }
+
+    createTrace();
+}
+
+void TestPlasmaWindowManagementReplay::cleanupTestCase()
+{
+    for (ReplayClient &client : m_clients) {
+        client.windowManagement.reset();
+        if (client.registry) {
+            wl_registry_destroy(client.registry);
+        }
+        if (client.display) {
+            wl_display_disconnect(client.display);
+        }
+    }
+}
+
+void TestPlasmaWindowManagementReplay::createTrace()
+{
+    QRandomGenerator generator(s_traceSeed);
+    m_trace.resize(s_operationCount);
+    for (ReplayOperation &operation : m_trace) {
+        // terminals update their title with every prompt and command, the other
+        // operations follow the user
+        const int kind = generator.bounded(100);
+        if (kind < 50) {
+            operation.type = ReplayOperation::Type::TitleUpdate;
+        } else if (kind < 75) {
+            operation.type = ReplayOperation::Type::Move;
+        } else if (kind < 95) {
+            operation.type = ReplayOperation::Type::FocusChange;
+        } else {
+            operation.type = ReplayOperation::Type::DesktopSwitch;
+        }
+        operation.window = generator.bounded(s_windowCount);
+        operation.value = generator.bounded(1000);
+    }
+}
+
+void TestPlasmaWindowManagementReplay::replay(const ReplayOperation &operation)
+{
+    switch (operation.type) {
+    case ReplayOperation::Type::FocusChange: {
+        // activating a window raises it as well
+        m_windows[m_activeWindow]->setActive(false);
+        m_activeWindow = operation.window;
+        m_windows[m_activeWindow]->setActive(true);
+        const quint32 id = m_windows[m_activeWindow]->internalId();
+        m_stackingOrder.removeOne(id);
+        m_stackingOrder.append(id);
+        m_windowManagement->setStackingOrder(m_stackingOrder);
+        break;
+    }
+    case ReplayOperation::Type::TitleUpdate:
+        m_windows[operation.window]->setTitle(QStringLiteral("user@host: ~/src/project-%1 (make -j%2)").arg(operation.window).arg(operation.value));
+        break;
+    case ReplayOperation::Type::Move:
+        m_windows[operation.window]->setGeometry(QRect(operation.value, operation.value / 2, 1280, 800));
+        break;
+    case ReplayOperation::Type::DesktopSwitch: {
+        // the active window is taken along to the next desktop
+        PlasmaWindowInterface *window = m_windows[m_activeWindow];
+        const QString previous = QStringLiteral("desktop-%1").arg(m_currentDesktop);
+        m_currentDesktop = (m_currentDesktop + 1) % s_desktopCount;
+        const QString current = QStringLiteral("desktop-%1").arg(m_currentDesktop);
+        m_desktopManagement->desktop(previous)->setActive(false);
+        m_desktopManagement->desktop(current)->setActive(true);
+        window->beginUpdate();
+        window->addPlasmaVirtualDesktop(current);
+        window->removePlasmaVirtualDesktop(previous);
+        window->commitUpdate();
+        break;
+    }
+    }
+}
+
+bool TestPlasmaWindowManagementReplay::dispatchClient(ReplayClient &client)
+{
+    wl_display_flush(client.display);
+    while (wl_display_prepare_read(client.display) != 0) {
+        wl_display_dispatch_pending(client.display);
+    }
+    pollfd pfd = {wl_display_get_fd(client.display), POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0) {
+        wl_display_read_events(client.display);
+    } else {
+        wl_display_cancel_read(client.display);
+    }
+    const int dispatched = wl_display_dispatch_pending(client.display);
+    wl_display_flush(client.display);
+    return dispatched > 0;
+}
+
+void TestPlasmaWindowManagementReplay::dispatchServer()
+{
+    m_display.dispatchEvents();
+    wl_display_flush_clients(m_display);
+}
+
+void TestPlasmaWindowManagementReplay::quiesce()
+{
+    bool busy = true;
+    while (busy) {
+        dispatchServer();
+        busy = false;
+        for (ReplayClient &client : m_clients) {
+            busy |= dispatchClient(client);
+        }
+    }
+    dispatchServer();
+}
+
+void TestPlasmaWindowManagementReplay::sentEvents(quint64 *events, quint64 *bytes) const
+{
+    *events = 0;
+    *bytes = 0;
+    const ProtocolStatistics statistics = m_display.protocolStatistics();
+    for (const ProtocolMessageStatistics &message : statistics) {
+        if (message.direction == ProtocolMessageStatistics::Direction::Event) {
+            *events += message.count;
+            *bytes += message.bytes;
+        }
+    }
+}
+
+void TestPlasmaWindowManagementReplay::benchmarkReplay()
+{
+    static const char *const s_names[] = {"focus change", "title update", "move", "desktop switch"};
+    ReplayCost costs[4];
+
+    m_display.resetProtocolStatistics();
+    QBENCHMARK_ONCE {
+        for (const ReplayOperation &operation : m_trace) {
+            quint64 eventsBefore, bytesBefore;
+            sentEvents(&eventsBefore, &bytesBefore);
+
+            // the server side of an operation: the compositor changing the windows and the
+            // events written to the clients
+            const qint64 cpuBefore = threadCpuTime();
+            replay(operation);
+            dispatchServer();
+            const qint64 cpuNsecs = threadCpuTime() - cpuBefore;
+
+            quiesce();
+            quint64 eventsAfter, bytesAfter;
+            sentEvents(&eventsAfter, &bytesAfter);
+
+            ReplayCost &cost = costs[int(operation.type)];
+            cost.operations++;
+            cost.events += eventsAfter - eventsBefore;
+            cost.bytes += bytesAfter - bytesBefore;
+            cost.cpuNsecs += cpuNsecs;
+        }
+    }
+
+    for (int i = 0; i < 4; ++i) {
+        const ReplayCost &cost = costs[i];
+        if (!cost.operations) {
+            continue;
+        }
+        qInfo("%s: %d operations, %.1f events/op, %.1f bytes/op, %.2f us/op",
+              s_names[i], cost.operations,
+              double(cost.events) / cost.operations,
+              double(cost.bytes) / cost.operations,
+              cost.cpuNsecs / 1000.0 / cost.operations);
+        // every operation is seen by every client
+        QVERIFY(cost.events >= quint64(cost.operations));
+    }
+}
+
+QTEST_GUILESS_MAIN(TestPlasmaWindowManagementReplay)
+#include "test_plasmawindowmanagement_replay.moc"
@@ -0,0 +1,263 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+#include "../../src/server/plasmawindowsnapshot_v1_interface.h"
+
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+
+#include "qwayland-kde-plasma-window-snapshot-v1.h"
+#include "qwayland-plasma-window-management.h"
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+class SnapshotManager : public QtWayland::kde_plasma_window_snapshot_manager_v1
+{
+};
+
+class WindowManagement : public QtWayland::org_kde_plasma_window_management
+{
+};
+
+struct SnapshotWindow
+{
+    quint32 id = 0;
+    quint32 state = 0;
+    quint32 pid = 0;
+    QRect geometry;
+    QString uuid;
+    QString title;
+    QString appId;
+    QStringList desktops;
+};
+
+/**
+ * Parses the snapshot following the layout described in the protocol.
+ */
+class SnapshotReader
+{
+public:
+    SnapshotReader(const char *data, quint32 size)
+        : m_data(data)
+        , m_size(size)
+    {
+    }
+
+    quint32 readUInt()
+    {
+        quint32 value = 0;
+        if (m_offset + sizeof(value) <= m_size) {
+            memcpy(&value, m_data + m_offset, sizeof(value));
+        }
+        m_offset += sizeof(value);
+        return value;
+    }
+
+    QString readString()
+    {
+        const quint32 length = readUInt();
+        const QString string = QString::fromUtf8(m_data + m_offset, qMin(length, m_size - qMin(m_offset, m_size)));
+        m_offset += (length + 3) / 4 * 4;
+        return string;
+    }
+
+    bool atEnd() const
+    {
+        return m_offset == m_size;
+    }
+
+private:
+    const char *m_data;
+    quint32 m_size;
+    quint32 m_offset = 0;
+};
+
+class Snapshot : public QObject, public QtWayland::kde_plasma_window_snapshot_v1
+{
+    Q_OBJECT
+
+public:
+    ~Snapshot() override
+    {
+        destroy();
+    }
+
+    quint32 format = 0;
+    QVector<SnapshotWindow> windows;
+    bool complete = false;
+
+Q_SIGNALS:
+    void received();
+
+protected:
+    void kde_plasma_window_snapshot_v1_snapshot(int32_t fd, uint32_t size) override
+    {
+        void *memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (memory != MAP_FAILED) {
+            SnapshotReader reader(static_cast<const char *>(memory), size);
+            format = reader.readUInt();
+            const quint32 count = reader.readUInt();
+            for (quint32 i = 0; i < count; ++i) {
+                SnapshotWindow window;
+                window.id = reader.readUInt();
+                window.state = reader.readUInt();
+                window.pid = reader.readUInt();
+                const int x = reader.readUInt();
+                const int y = reader.readUInt();
+                const int width = reader.readUInt();
+                const int height = reader.readUInt();
+                window.geometry = QRect(x, y, width, height);
+                window.uuid = reader.readString();
+                window.title = reader.readString();
+                window.appId = reader.readString();
+                const quint32 desktops = reader.readUInt();
+                for (quint32 j = 0; j < desktops; ++j) {
+                    window.desktops << reader.readString();
+                }
+                windows << window;
+            }
+            complete = reader.atEnd();
+            munmap(memory, size);
+        }
+        emit received();
+    }
+    void kde_plasma_window_snapshot_v1_failed() override
+    {
+        emit received();
+    }
+};
+
+class TestPlasmaWindowSnapshotV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestPlasmaWindowSnapshotV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testSnapshot();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    QThread *m_thread;
+
+    Display m_display;
+    PlasmaWindowManagementInterface *m_serverWindowManagement;
+    SnapshotManager *m_manager = nullptr;
+    WindowManagement *m_windowManagement = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-plasma-window-snapshot-test-0");
+
+void TestPlasmaWindowSnapshotV1Interface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_serverWindowManagement = new PlasmaWindowManagementInterface(&m_display, this);
+    new PlasmaWindowSnapshotManagerV1Interface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("kde_plasma_window_snapshot_manager_v1")) {
+            m_manager = new SnapshotManager();
+            m_manager->init(*registry, id, version);
+        } else if (interface == QByteArrayLiteral("org_kde_plasma_window_management")) {
+            m_windowManagement = new WindowManagement();
+            m_windowManagement->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_manager);
+    QVERIFY(m_windowManagement);
+}
+
+TestPlasmaWindowSnapshotV1Interface::~TestPlasmaWindowSnapshotV1Interface()
+{
+    delete m_manager;
+    delete m_windowManagement;
+    delete m_queue;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_connection->deleteLater();
+}
+
+void TestPlasmaWindowSnapshotV1Interface::testSnapshot()
+{
+    PlasmaWindowInterface *first = m_serverWindowManagement->createWindow(this, QUuid::createUuid());
+    first->beginUpdate();
+    first->setTitle(QStringLiteral("Konsole"));
+    first->setAppId(QStringLiteral("org.kde.konsole"));
+    first->setPid(42);
+    first->setActive(true);
+    first->setGeometry(QRect(10, 20, 640, 480));
+    first->commitUpdate();
+    PlasmaWindowInterface *second = m_serverWindowManagement->createWindow(this, QUuid::createUuid());
+    // an odd length needs padding
+    second->setTitle(QStringLiteral("Ünïcode"));
+
+    Snapshot snapshot;
+    QSignalSpy receivedSpy(&snapshot, &Snapshot::received);
+    snapshot.init(m_manager->get_snapshot(m_windowManagement->object()));
+    QVERIFY(receivedSpy.wait());
+    QCOMPARE(snapshot.format, 1u);
+    QVERIFY(snapshot.complete);
+    QCOMPARE(snapshot.windows.count(), 2);
+
+    const SnapshotWindow &window = snapshot.windows.at(0);
+    QCOMPARE(window.id, first->internalId());
+    QCOMPARE(window.uuid.toUtf8(), first->uuid());
+    QCOMPARE(window.title, QStringLiteral("Konsole"));
+    QCOMPARE(window.appId, QStringLiteral("org.kde.konsole"));
+    QCOMPARE(window.pid, 42u);
+    QVERIFY(window.state & ORG_KDE_PLASMA_WINDOW_MANAGEMENT_STATE_ACTIVE);
+    QCOMPARE(window.geometry, QRect(10, 20, 640, 480));
+    QVERIFY(window.desktops.isEmpty());
+
+    QCOMPARE(snapshot.windows.at(1).id, second->internalId());
+    QCOMPARE(snapshot.windows.at(1).title, QStringLiteral("Ünïcode"));
+    QCOMPARE(snapshot.windows.at(1).geometry, QRect(0, 0, 0, 0));
+}
+
+QTEST_GUILESS_MAIN(TestPlasmaWindowSnapshotV1Interface)
+
+#include "test_plasmawindowsnapshot_v1_interface.moc"
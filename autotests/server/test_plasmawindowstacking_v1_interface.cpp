@@ -0,0 +1,202 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+#include "../../src/server/plasmawindowstacking_v1_interface.h"
+
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+
+#include "qwayland-kde-plasma-window-stacking-v1.h"
+#include "qwayland-plasma-window-management.h"
+
+using namespace KWaylandServer;
+
+class StackingManager : public QtWayland::kde_plasma_window_stacking_manager_v1
+{
+};
+
+class WindowManagement : public QtWayland::org_kde_plasma_window_management
+{
+public:
+    int stackingOrderEvents = 0;
+
+protected:
+    void org_kde_plasma_window_management_stacking_order_changed(wl_array *ids) override
+    {
+        Q_UNUSED(ids)
+        stackingOrderEvents++;
+    }
+};
+
+class Stacking : public QObject, public QtWayland::kde_plasma_window_stacking_v1
+{
+    Q_OBJECT
+
+public:
+    ~Stacking() override
+    {
+        destroy();
+    }
+
+    QVector<quint32> stackingOrder;
+    // the events of the last change
+    int events = 0;
+
+Q_SIGNALS:
+    void done();
+
+protected:
+    void kde_plasma_window_stacking_v1_place(uint32_t window, uint32_t previous) override
+    {
+        stackingOrder.removeOne(window);
+        stackingOrder.insert(previous ? stackingOrder.indexOf(previous) + 1 : 0, window);
+        events++;
+    }
+    void kde_plasma_window_stacking_v1_remove(uint32_t window) override
+    {
+        stackingOrder.removeOne(window);
+        events++;
+    }
+    void kde_plasma_window_stacking_v1_done() override
+    {
+        emit done();
+    }
+};
+
+class TestPlasmaWindowStackingV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestPlasmaWindowStackingV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testIncrementalStackingOrder();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    QThread *m_thread;
+
+    Display m_display;
+    PlasmaWindowManagementInterface *m_serverWindowManagement;
+    StackingManager *m_manager = nullptr;
+    WindowManagement *m_windowManagement = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-plasma-window-stacking-test-0");
+
+void TestPlasmaWindowStackingV1Interface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_serverWindowManagement = new PlasmaWindowManagementInterface(&m_display, this);
+    QVector<quint32> stackingOrder;
+    for (int i = 0; i < 4; ++i) {
+        stackingOrder << m_serverWindowManagement->createWindow(this, QUuid::createUuid())->internalId();
+    }
+    m_serverWindowManagement->setStackingOrder(stackingOrder);
+    new PlasmaWindowStackingManagerV1Interface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("kde_plasma_window_stacking_manager_v1")) {
+            m_manager = new StackingManager();
+            m_manager->init(*registry, id, version);
+        } else if (interface == QByteArrayLiteral("org_kde_plasma_window_management")) {
+            m_windowManagement = new WindowManagement();
+            m_windowManagement->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_manager);
+    QVERIFY(m_windowManagement);
+}
+
+TestPlasmaWindowStackingV1Interface::~TestPlasmaWindowStackingV1Interface()
+{
+    delete m_manager;
+    delete m_windowManagement;
+    delete m_queue;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_connection->deleteLater();
+}
+
+void TestPlasmaWindowStackingV1Interface::testIncrementalStackingOrder()
+{
+    Stacking stacking;
+    QSignalSpy doneSpy(&stacking, &Stacking::done);
+    stacking.init(m_manager->get_stacking(m_windowManagement->object()));
+    QVERIFY(doneSpy.wait());
+    QVector<quint32> stackingOrder = m_serverWindowManagement->stackingOrder();
+    QCOMPARE(stacking.stackingOrder, stackingOrder);
+    const int stackingOrderEvents = m_windowManagement->stackingOrderEvents;
+
+    // raising a window only sends that window
+    stacking.events = 0;
+    stackingOrder.move(1, 3);
+    m_serverWindowManagement->setStackingOrder(stackingOrder);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(stacking.stackingOrder, stackingOrder);
+    QCOMPARE(stacking.events, 1);
+    // the full stacking order would have arrived first
+    QCOMPARE(m_windowManagement->stackingOrderEvents, stackingOrderEvents);
+
+    // lowering a window to the bottom
+    stacking.events = 0;
+    stackingOrder.move(2, 0);
+    m_serverWindowManagement->setStackingOrder(stackingOrder);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(stacking.stackingOrder, stackingOrder);
+    QCOMPARE(stacking.events, 1);
+
+    // a window leaving and a new one on top
+    stacking.events = 0;
+    stackingOrder.removeFirst();
+    stackingOrder.append(m_serverWindowManagement->createWindow(this, QUuid::createUuid())->internalId());
+    m_serverWindowManagement->setStackingOrder(stackingOrder);
+    QVERIFY(doneSpy.wait());
+    QCOMPARE(stacking.stackingOrder, stackingOrder);
+    QCOMPARE(stacking.events, 2);
+    QCOMPARE(m_windowManagement->stackingOrderEvents, stackingOrderEvents);
+}
+
+QTEST_GUILESS_MAIN(TestPlasmaWindowStackingV1Interface)
+
+#include "test_plasmawindowstacking_v1_interface.moc"
@@ -0,0 +1,330 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/display.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+#include "../../src/server/plasmawindowthumbnail_v1_interface.h"
+
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+
+#include "qwayland-kde-plasma-window-thumbnail-v1.h"
+#include "qwayland-plasma-window-management.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+Q_DECLARE_METATYPE(KWaylandServer::PlasmaWindowThumbnailV1Interface *)
+
+class ThumbnailManager : public QtWayland::kde_plasma_window_thumbnail_manager_v1
+{
+};
+
+class WindowManagement : public QtWayland::org_kde_plasma_window_management
+{
+};
+
+class Thumbnail : public QObject, public QtWayland::kde_plasma_window_thumbnail_v1
+{
+    Q_OBJECT
+
+public:
+    ~Thumbnail() override
+    {
+        destroy();
+    }
+
+    quint32 serial = 0;
+    QSize size;
+    quint32 format = 0;
+    quint64 modifier = 0;
+    quint32 planeCount = 0;
+    quint32 receivedPlanes = 0;
+
+Q_SIGNALS:
+    void frameDone();
+    void closed();
+
+protected:
+    void kde_plasma_window_thumbnail_v1_frame(uint32_t serial, uint32_t width, uint32_t height, uint32_t format,
+                                              uint32_t modifier_hi, uint32_t modifier_lo, uint32_t num_planes) override
+    {
+        this->serial = serial;
+        size = QSize(width, height);
+        this->format = format;
+        modifier = (quint64(modifier_hi) << 32) | modifier_lo;
+        planeCount = num_planes;
+        receivedPlanes = 0;
+    }
+    void kde_plasma_window_thumbnail_v1_plane(uint32_t index, int32_t fd, uint32_t offset, uint32_t stride) override
+    {
+        Q_UNUSED(index)
+        Q_UNUSED(offset)
+        Q_UNUSED(stride)
+        ::close(fd);
+        receivedPlanes++;
+    }
+    void kde_plasma_window_thumbnail_v1_done() override
+    {
+        emit frameDone();
+    }
+    void kde_plasma_window_thumbnail_v1_closed() override
+    {
+        emit closed();
+    }
+};
+
+class TestPlasmaWindowThumbnailV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestPlasmaWindowThumbnailV1Interface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testFrames();
+    void testRate();
+    void testFrameSize_data();
+    void testFrameSize();
+    void testUnknownWindow();
+    void testWindowDestroyed();
+
+private:
+    PlasmaWindowThumbnailV1Interface *createThumbnail(Thumbnail *thumbnail, PlasmaWindowInterface *window, const QSize &maximumSize, uint32_t rate);
+    quint32 sendFrame(PlasmaWindowThumbnailV1Interface *thumbnail);
+
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    QThread *m_thread;
+
+    Display m_display;
+    PlasmaWindowManagementInterface *m_serverWindowManagement;
+    PlasmaWindowThumbnailManagerV1Interface *m_serverManager;
+    ThumbnailManager *m_manager = nullptr;
+    WindowManagement *m_windowManagement = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-plasma-window-thumbnail-test-0");
+// DRM_FORMAT_XRGB8888
+static const uint32_t s_format = 0x34325258;
+
+void TestPlasmaWindowThumbnailV1Interface::initTestCase()
+{
+    qRegisterMetaType<PlasmaWindowThumbnailV1Interface *>();
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_serverWindowManagement = new PlasmaWindowManagementInterface(&m_display, this);
+    m_serverManager = new PlasmaWindowThumbnailManagerV1Interface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("kde_plasma_window_thumbnail_manager_v1")) {
+            m_manager = new ThumbnailManager();
+            m_manager->init(*registry, id, version);
+        } else if (interface == QByteArrayLiteral("org_kde_plasma_window_management")) {
+            m_windowManagement = new WindowManagement();
+            m_windowManagement->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_manager);
+    QVERIFY(m_windowManagement);
+}
+
+TestPlasmaWindowThumbnailV1Interface::~TestPlasmaWindowThumbnailV1Interface()
+{
+    delete m_manager;
+    delete m_windowManagement;
+    delete m_queue;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+    }
+    m_connection->deleteLater();
+}
+
+PlasmaWindowThumbnailV1Interface *TestPlasmaWindowThumbnailV1Interface::createThumbnail(Thumbnail *thumbnail, PlasmaWindowInterface *window,
+                                                                                         const QSize &maximumSize, uint32_t rate)
+{
+    QSignalSpy thumbnailCreatedSpy(m_serverManager, &PlasmaWindowThumbnailManagerV1Interface::thumbnailCreated);
+    thumbnail->init(m_manager->get_thumbnail(m_windowManagement->object(), QString::fromUtf8(window->uuid()),
+                                             maximumSize.width(), maximumSize.height(), rate));
+    if (!thumbnailCreatedSpy.wait()) {
+        return nullptr;
+    }
+    return thumbnailCreatedSpy.first().first().value<PlasmaWindowThumbnailV1Interface *>();
+}
+
+quint32 TestPlasmaWindowThumbnailV1Interface::sendFrame(PlasmaWindowThumbnailV1Interface *thumbnail)
+{
+    // any descriptor does, the client doesn't import it
+    const int fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+    const LinuxDmabufUnstableV1Interface::Plane plane = {fd, 0, 800, 0x00ffffffffffffffULL};
+    const quint32 serial = thumbnail->sendFrame({plane}, s_format, QSize(200, 100));
+    ::close(fd);
+    return serial;
+}
+
+void TestPlasmaWindowThumbnailV1Interface::testFrames()
+{
+    PlasmaWindowInterface *serverWindow = m_serverWindowManagement->createWindow(this, QUuid::createUuid());
+    QScopedPointer<Thumbnail> thumbnail(new Thumbnail);
+    QSignalSpy frameDoneSpy(thumbnail.data(), &Thumbnail::frameDone);
+    PlasmaWindowThumbnailV1Interface *serverThumbnail = createThumbnail(thumbnail.data(), serverWindow, QSize(200, 200), 0);
+    QVERIFY(serverThumbnail);
+    QCOMPARE(serverThumbnail->window(), serverWindow);
+    QCOMPARE(serverThumbnail->maximumSize(), QSize(200, 200));
+    QCOMPARE(serverThumbnail->maximumRate(), 15);
+    QSignalSpy frameRequestedSpy(serverThumbnail, &PlasmaWindowThumbnailV1Interface::frameRequested);
+    QSignalSpy frameReleasedSpy(serverThumbnail, &PlasmaWindowThumbnailV1Interface::frameReleased);
+    // no rate limit, the frames are only limited by the damage and the held frames
+    m_serverManager->setMaximumRate(0);
+    QCOMPARE(serverThumbnail->maximumRate(), 0);
+
+    // the first frame was requested when the thumbnail was created
+    const quint32 firstSerial = sendFrame(serverThumbnail);
+    QVERIFY(firstSerial);
+    QVERIFY(frameDoneSpy.wait());
+    QCOMPARE(thumbnail->serial, firstSerial);
+    QCOMPARE(thumbnail->size, QSize(200, 100));
+    QCOMPARE(thumbnail->format, s_format);
+    QCOMPARE(thumbnail->modifier, 0x00ffffffffffffffULL);
+    QCOMPARE(thumbnail->planeCount, 1u);
+    QCOMPARE(thumbnail->receivedPlanes, 1u);
+
+    // nothing changed, so no frame is requested
+    QVERIFY(!frameRequestedSpy.wait(100));
+    serverThumbnail->markDamaged();
+    serverThumbnail->markDamaged();
+    QCOMPARE(frameRequestedSpy.count(), 1);
+    const quint32 secondSerial = sendFrame(serverThumbnail);
+    QVERIFY(frameDoneSpy.wait());
+    QCOMPARE(thumbnail->serial, secondSerial);
+
+    // the client holds two frames, the next one waits for a release
+    serverThumbnail->markDamaged();
+    QCOMPARE(frameRequestedSpy.count(), 1);
+    thumbnail->release(firstSerial);
+    QVERIFY(frameReleasedSpy.wait());
+    QCOMPARE(frameReleasedSpy.first().first().value<quint32>(), firstSerial);
+    QCOMPARE(frameRequestedSpy.count(), 2);
+
+    // the remaining frame is released with the thumbnail
+    sendFrame(serverThumbnail);
+    QSignalSpy destroyedSpy(serverThumbnail, &QObject::destroyed);
+    thumbnail.reset();
+    QVERIFY(destroyedSpy.wait());
+    QCOMPARE(frameReleasedSpy.count(), 3);
+    m_serverManager->setMaximumRate(15);
+    delete serverWindow;
+}
+
+void TestPlasmaWindowThumbnailV1Interface::testRate()
+{
+    PlasmaWindowInterface *serverWindow = m_serverWindowManagement->createWindow(this, QUuid::createUuid());
+    Thumbnail thumbnail;
+    QSignalSpy frameDoneSpy(&thumbnail, &Thumbnail::frameDone);
+    // the client asks for less than the compositor allows
+    PlasmaWindowThumbnailV1Interface *serverThumbnail = createThumbnail(&thumbnail, serverWindow, QSize(200, 200), 5);
+    QVERIFY(serverThumbnail);
+    QCOMPARE(serverThumbnail->maximumRate(), 5);
+    QSignalSpy frameRequestedSpy(serverThumbnail, &PlasmaWindowThumbnailV1Interface::frameRequested);
+    QSignalSpy frameReleasedSpy(serverThumbnail, &PlasmaWindowThumbnailV1Interface::frameReleased);
+
+    QElapsedTimer timer;
+    timer.start();
+    thumbnail.release(sendFrame(serverThumbnail));
+    QVERIFY(frameReleasedSpy.wait());
+
+    // the damage is only sent on after the 200 ms of a frame at 5 Hz
+    serverThumbnail->markDamaged();
+    QCOMPARE(frameRequestedSpy.count(), 0);
+    QVERIFY(frameRequestedSpy.wait());
+    QVERIFY(timer.elapsed() >= 180);
+    delete serverWindow;
+}
+
+void TestPlasmaWindowThumbnailV1Interface::testFrameSize_data()
+{
+    QTest::addColumn<QSize>("windowSize");
+    QTest::addColumn<QSize>("frameSize");
+
+    QTest::newRow("fits") << QSize(300, 100) << QSize(300, 100);
+    QTest::newRow("wide") << QSize(1600, 900) << QSize(400, 225);
+    QTest::newRow("tall") << QSize(600, 1200) << QSize(150, 300);
+    QTest::newRow("line") << QSize(100000, 10) << QSize(400, 1);
+    QTest::newRow("empty") << QSize() << QSize();
+}
+
+void TestPlasmaWindowThumbnailV1Interface::testFrameSize()
+{
+    PlasmaWindowInterface *serverWindow = m_serverWindowManagement->createWindow(this, QUuid::createUuid());
+    Thumbnail thumbnail;
+    PlasmaWindowThumbnailV1Interface *serverThumbnail = createThumbnail(&thumbnail, serverWindow, QSize(400, 300), 0);
+    QVERIFY(serverThumbnail);
+    QFETCH(QSize, windowSize);
+    QTEST(serverThumbnail->frameSize(windowSize), "frameSize");
+    delete serverWindow;
+}
+
+void TestPlasmaWindowThumbnailV1Interface::testUnknownWindow()
+{
+    QSignalSpy thumbnailCreatedSpy(m_serverManager, &PlasmaWindowThumbnailManagerV1Interface::thumbnailCreated);
+    Thumbnail thumbnail;
+    QSignalSpy closedSpy(&thumbnail, &Thumbnail::closed);
+    thumbnail.init(m_manager->get_thumbnail(m_windowManagement->object(), QUuid::createUuid().toString(), 200, 200, 0));
+    QVERIFY(closedSpy.wait());
+    QVERIFY(thumbnailCreatedSpy.isEmpty());
+}
+
+void TestPlasmaWindowThumbnailV1Interface::testWindowDestroyed()
+{
+    PlasmaWindowInterface *serverWindow = m_serverWindowManagement->createWindow(this, QUuid::createUuid());
+    Thumbnail thumbnail;
+    QSignalSpy closedSpy(&thumbnail, &Thumbnail::closed);
+    PlasmaWindowThumbnailV1Interface *serverThumbnail = createThumbnail(&thumbnail, serverWindow, QSize(200, 200), 0);
+    QVERIFY(serverThumbnail);
+
+    delete serverWindow;
+    QVERIFY(serverThumbnail->isClosed());
+    QVERIFY(!serverThumbnail->window());
+    QCOMPARE(sendFrame(serverThumbnail), 0u);
+    QVERIFY(closedSpy.wait());
+}
+
+QTEST_GUILESS_MAIN(TestPlasmaWindowThumbnailV1Interface)
+
+#include "test_plasmawindowthumbnail_v1_interface.moc"
@@ -0,0 +1,217 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QThread>
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/pointergestures_v1_interface.h"
+#include "../../src/server/relativepointer_v1_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/surface_interface.h"
+// KWayland
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/pointer.h"
+#include "KWayland/Client/pointergestures.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/relativepointer.h"
+#include "KWayland/Client/seat.h"
+#include "KWayland/Client/surface.h"
+// Wayland
+#include <wayland-server.h>
+
+using namespace KWaylandServer;
+
+static const QString s_socketName = QStringLiteral("kwayland-test-pointer-fanout-0");
+
+/**
+ * Measures how many relative motion and gesture update events per second the seat
+ * dispatches to a focused client which has bound all the pointer extensions.
+ **/
+class TestPointerFanOut : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkRelativeMotion();
+    void benchmarkSwipeUpdate();
+    void benchmarkPinchUpdate();
+
+private:
+    void report(const char *name, qint64 eventCount, qint64 nsecs);
+
+    Display m_display;
+    SeatInterface *m_seat = nullptr;
+    KWayland::Client::ConnectionThread *m_connection = nullptr;
+    KWayland::Client::EventQueue *m_queue = nullptr;
+    KWayland::Client::Compositor *m_compositor = nullptr;
+    KWayland::Client::Seat *m_clientSeat = nullptr;
+    KWayland::Client::RelativePointerManager *m_relativePointerManager = nullptr;
+    KWayland::Client::PointerGestures *m_pointerGestures = nullptr;
+    KWayland::Client::Surface *m_surface = nullptr;
+    KWayland::Client::Pointer *m_pointer = nullptr;
+    KWayland::Client::RelativePointer *m_relativePointer = nullptr;
+    KWayland::Client::PointerSwipeGesture *m_swipeGesture = nullptr;
+    KWayland::Client::PointerPinchGesture *m_pinchGesture = nullptr;
+    QThread *m_thread = nullptr;
+};
+
+// events sent between two flushes of the display
+static const int s_eventsPerBatch = 100;
+
+void TestPointerFanOut::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasPointer(true);
+    m_seat->create();
+    CompositorInterface *compositor = new CompositorInterface(&m_display, this);
+    new RelativePointerManagerV1Interface(&m_display, this);
+    new PointerGesturesV1Interface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    KWayland::Client::Registry registry;
+    QSignalSpy interfacesAnnouncedSpy(&registry, &KWayland::Client::Registry::interfacesAnnounced);
+    registry.setEventQueue(m_queue);
+    registry.create(m_connection->display());
+    QVERIFY(registry.isValid());
+    registry.setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+
+    using Interface = KWayland::Client::Registry::Interface;
+    m_compositor = registry.createCompositor(registry.interface(Interface::Compositor).name,
+                                             registry.interface(Interface::Compositor).version, this);
+    m_clientSeat = registry.createSeat(registry.interface(Interface::Seat).name,
+                                       registry.interface(Interface::Seat).version, this);
+    m_relativePointerManager = registry.createRelativePointerManager(registry.interface(Interface::RelativePointerManagerUnstableV1).name,
+                                                                     registry.interface(Interface::RelativePointerManagerUnstableV1).version, this);
+    m_pointerGestures = registry.createPointerGestures(registry.interface(Interface::PointerGesturesUnstableV1).name,
+                                                       registry.interface(Interface::PointerGesturesUnstableV1).version, this);
+    QVERIFY(m_relativePointerManager->isValid());
+    QVERIFY(m_pointerGestures->isValid());
+
+    QSignalSpy hasPointerSpy(m_clientSeat, &KWayland::Client::Seat::hasPointerChanged);
+    QVERIFY(hasPointerSpy.wait());
+
+    QSignalSpy surfaceCreatedSpy(compositor, &CompositorInterface::surfaceCreated);
+    m_surface = m_compositor->createSurface(this);
+    QVERIFY(surfaceCreatedSpy.wait());
+    SurfaceInterface *serverSurface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+
+    QSignalSpy pointerCreatedSpy(m_seat, &SeatInterface::pointerCreated);
+    m_pointer = m_clientSeat->createPointer(this);
+    m_relativePointer = m_relativePointerManager->createRelativePointer(m_pointer, this);
+    m_swipeGesture = m_pointerGestures->createSwipeGesture(m_pointer, this);
+    m_pinchGesture = m_pointerGestures->createPinchGesture(m_pointer, this);
+    QVERIFY(pointerCreatedSpy.wait());
+    // let the server register the pointer extensions
+    m_connection->flush();
+    QTest::qWait(100);
+
+    m_seat->setFocusedPointerSurface(serverSurface);
+    QVERIFY(m_seat->focusedPointer());
+}
+
+void TestPointerFanOut::cleanupTestCase()
+{
+    delete m_pinchGesture;
+    delete m_swipeGesture;
+    delete m_relativePointer;
+    delete m_pointer;
+    delete m_surface;
+    delete m_pointerGestures;
+    delete m_relativePointerManager;
+    delete m_clientSeat;
+    delete m_compositor;
+    delete m_queue;
+    if (m_connection) {
+        m_connection->deleteLater();
+        m_connection = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+    }
+}
+
+void TestPointerFanOut::report(const char *name, qint64 eventCount, qint64 nsecs)
+{
+    qInfo("%s: %.0f events/s", name, eventCount * 1e9 / qMax<qint64>(nsecs, 1));
+    // drop the events the client has queued meanwhile
+    QCoreApplication::processEvents();
+}
+
+void TestPointerFanOut::benchmarkRelativeMotion()
+{
+    QElapsedTimer timer;
+    qint64 eventCount = 0;
+    timer.start();
+    QBENCHMARK {
+        for (int i = 0; i < s_eventsPerBatch; ++i) {
+            m_seat->relativePointerMotion(QSizeF(1, 1), QSizeF(1, 1), i);
+        }
+        wl_display_flush_clients(m_display);
+        eventCount += s_eventsPerBatch;
+    }
+    report("relative motion", eventCount, timer.nsecsElapsed());
+}
+
+void TestPointerFanOut::benchmarkSwipeUpdate()
+{
+    m_seat->startPointerSwipeGesture(3);
+    QElapsedTimer timer;
+    qint64 eventCount = 0;
+    timer.start();
+    QBENCHMARK {
+        for (int i = 0; i < s_eventsPerBatch; ++i) {
+            m_seat->updatePointerSwipeGesture(QSizeF(1, 1));
+        }
+        wl_display_flush_clients(m_display);
+        eventCount += s_eventsPerBatch;
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    m_seat->endPointerSwipeGesture();
+    report("swipe update", eventCount, elapsed);
+}
+
+void TestPointerFanOut::benchmarkPinchUpdate()
+{
+    m_seat->startPointerPinchGesture(2);
+    QElapsedTimer timer;
+    qint64 eventCount = 0;
+    timer.start();
+    QBENCHMARK {
+        for (int i = 0; i < s_eventsPerBatch; ++i) {
+            m_seat->updatePointerPinchGesture(QSizeF(1, 1), 1.0, 0.0);
+        }
+        wl_display_flush_clients(m_display);
+        eventCount += s_eventsPerBatch;
+    }
+    const qint64 elapsed = timer.nsecsElapsed();
+    m_seat->endPointerPinchGesture();
+    report("pinch update", eventCount, elapsed);
+}
+
+QTEST_GUILESS_MAIN(TestPointerFanOut)
+#include "test_pointer_fanout.moc"
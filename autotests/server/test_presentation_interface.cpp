@@ -0,0 +1,271 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/presentation_interface.h"
+#include "../../src/server/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/output.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-presentation-time.h"
+
+#include <time.h>
+
+using namespace KWaylandServer;
+
+class Presentation : public QtWayland::wp_presentation
+{
+public:
+    void wp_presentation_clock_id(uint32_t clk_id) override
+    {
+        clockId = clk_id;
+    }
+
+    int clockId = -1;
+};
+
+class PresentationFeedback : public QObject, public QtWayland::wp_presentation_feedback
+{
+    Q_OBJECT
+
+public:
+    explicit PresentationFeedback(::wp_presentation_feedback *feedback)
+        : QtWayland::wp_presentation_feedback(feedback)
+    {
+    }
+    ~PresentationFeedback() override
+    {
+        // the server destroys its side along with the last event
+        wp_presentation_feedback_destroy(object());
+    }
+
+    void wp_presentation_feedback_sync_output(struct ::wl_output *output) override
+    {
+        syncOutputs << output;
+    }
+    void wp_presentation_feedback_presented(uint32_t tv_sec_hi, uint32_t tv_sec_lo, uint32_t tv_nsec, uint32_t refresh, uint32_t seq_hi, uint32_t seq_lo, uint32_t flags) override
+    {
+        const quint64 seconds = (quint64(tv_sec_hi) << 32) | tv_sec_lo;
+        timestamp = std::chrono::seconds(seconds) + std::chrono::nanoseconds(tv_nsec);
+        this->refresh = std::chrono::nanoseconds(refresh);
+        sequence = (quint64(seq_hi) << 32) | seq_lo;
+        kinds = flags;
+        finished = true;
+        Q_EMIT presented();
+    }
+    void wp_presentation_feedback_discarded() override
+    {
+        finished = true;
+        Q_EMIT discarded();
+    }
+
+    QVector<::wl_output *> syncOutputs;
+    std::chrono::nanoseconds timestamp;
+    std::chrono::nanoseconds refresh;
+    quint64 sequence = 0;
+    uint32_t kinds = 0;
+    bool finished = false;
+
+Q_SIGNALS:
+    void presented();
+    void discarded();
+};
+
+class TestPresentationInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestPresentationInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPresented();
+    void testSuperseded();
+    void testDiscard();
+
+private:
+    SurfaceInterface *createSurface(KWayland::Client::Surface **clientSurface);
+
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+    KWayland::Client::Output *m_clientOutput;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    OutputInterface *m_output;
+    Presentation *m_presentation = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-presentation-test-0");
+
+void TestPresentationInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new PresentationInterface(&m_display, this);
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+    m_output = new OutputInterface(&m_display, this);
+    m_output->create();
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_presentation")) {
+            m_presentation = new Presentation();
+            m_presentation->init(*registry, id, version);
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    QSignalSpy outputSpy(registry, &KWayland::Client::Registry::outputAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_presentation);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(),
+                                                    compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+    m_clientOutput = registry->createOutput(outputSpy.first().first().value<quint32>(),
+                                            outputSpy.first().last().value<quint32>(), this);
+    QSignalSpy outputChangedSpy(m_clientOutput, &KWayland::Client::Output::changed);
+    QVERIFY(outputChangedSpy.wait());
+    QCOMPARE(m_presentation->clockId, int(CLOCK_MONOTONIC));
+}
+
+TestPresentationInterface::~TestPresentationInterface()
+{
+    delete m_presentation;
+    m_presentation = nullptr;
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+SurfaceInterface *TestPresentationInterface::createSurface(KWayland::Client::Surface **clientSurface)
+{
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    *clientSurface = m_clientCompositor->createSurface(this);
+    if (!surfaceCreatedSpy.wait()) {
+        return nullptr;
+    }
+    return surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+}
+
+void TestPresentationInterface::testPresented()
+{
+    KWayland::Client::Surface *clientSurface;
+    SurfaceInterface *surface = createSurface(&clientSurface);
+    QVERIFY(surface);
+
+    PresentationFeedback feedback(m_presentation->feedback(*clientSurface));
+    QSignalSpy committedSpy(surface, &SurfaceInterface::committed);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    PresentationTime time;
+    time.timestamp = std::chrono::seconds(5000000000ULL) + std::chrono::nanoseconds(123456);
+    time.refreshInterval = std::chrono::nanoseconds(16666666);
+    time.sequence = 0x100000002ULL;
+    time.kinds = PresentationKind::Vsync | PresentationKind::ZeroCopy;
+    QSignalSpy presentedSpy(&feedback, &PresentationFeedback::presented);
+    surface->presented(m_output, time);
+    QVERIFY(presentedSpy.wait());
+    QCOMPARE(feedback.syncOutputs, QVector<::wl_output *>{*m_clientOutput});
+    QCOMPARE(feedback.timestamp, time.timestamp);
+    QCOMPARE(feedback.refresh, time.refreshInterval);
+    QCOMPARE(feedback.sequence, time.sequence);
+    QCOMPARE(feedback.kinds, uint32_t(QtWayland::wp_presentation_feedback::kind_vsync | QtWayland::wp_presentation_feedback::kind_zero_copy));
+
+    delete clientSurface;
+}
+
+void TestPresentationInterface::testSuperseded()
+{
+    // this test verifies that the feedback of a commit replaced before its presentation is discarded
+    KWayland::Client::Surface *clientSurface;
+    SurfaceInterface *surface = createSurface(&clientSurface);
+    QVERIFY(surface);
+
+    PresentationFeedback first(m_presentation->feedback(*clientSurface));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    PresentationFeedback second(m_presentation->feedback(*clientSurface));
+    QSignalSpy discardedSpy(&first, &PresentationFeedback::discarded);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(discardedSpy.wait());
+    QVERIFY(!second.finished);
+
+    QSignalSpy presentedSpy(&second, &PresentationFeedback::presented);
+    surface->presented(nullptr, PresentationTime());
+    QVERIFY(presentedSpy.wait());
+    QVERIFY(second.syncOutputs.isEmpty());
+
+    delete clientSurface;
+}
+
+void TestPresentationInterface::testDiscard()
+{
+    KWayland::Client::Surface *clientSurface;
+    SurfaceInterface *surface = createSurface(&clientSurface);
+    QVERIFY(surface);
+
+    PresentationFeedback feedback(m_presentation->feedback(*clientSurface));
+    QSignalSpy committedSpy(surface, &SurfaceInterface::committed);
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(committedSpy.wait());
+
+    QSignalSpy discardedSpy(&feedback, &PresentationFeedback::discarded);
+    surface->discardPresentationFeedback();
+    QVERIFY(discardedSpy.wait());
+
+    // destroying the surface discards the feedback which hasn't become current yet
+    PresentationFeedback pending(m_presentation->feedback(*clientSurface));
+    QSignalSpy pendingDiscardedSpy(&pending, &PresentationFeedback::discarded);
+    delete clientSurface;
+    QVERIFY(pendingDiscardedSpy.wait());
+}
+
+QTEST_GUILESS_MAIN(TestPresentationInterface)
+#include "test_presentation_interface.moc"
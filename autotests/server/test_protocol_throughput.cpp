@@ -0,0 +1,1127 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+#include <QDirIterator>
+#include <QRandomGenerator>
+#include <QXmlStreamReader>
+// WaylandServer
+#include "../../src/server/appmenu_interface.h"
+#include "../../src/server/blur_interface.h"
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/contrast_interface.h"
+#include "../../src/server/datacontroldevicemanager_v1_interface.h"
+#include "../../src/server/datadevicemanager_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/dpms_interface.h"
+#include "../../src/server/eglstream_controller_interface.h"
+#include "../../src/server/fakeinput_interface.h"
+#include "../../src/server/idle_interface.h"
+#include "../../src/server/idleinhibit_v1_interface.h"
+#include "../../src/server/inputmethod_v1_interface.h"
+#include "../../src/server/keyboard_shortcuts_inhibit_v1_interface.h"
+#include "../../src/server/keystate_interface.h"
+#include "../../src/server/layershell_v1_interface.h"
+#include "../../src/server/linuxdmabuf_v1_interface.h"
+#include "../../src/server/output_interface.h"
+#include "../../src/server/outputdevice_interface.h"
+#include "../../src/server/outputmanagement_interface.h"
+#include "../../src/server/plasmashell_interface.h"
+#include "../../src/server/plasmavirtualdesktop_interface.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
+#include "../../src/server/pointerconstraints_v1_interface.h"
+#include "../../src/server/pointergestures_v1_interface.h"
+#include "../../src/server/primaryselectiondevicemanager_v1_interface.h"
+#include "../../src/server/relativepointer_v1_interface.h"
+#include "../../src/server/screencast_v1_interface.h"
+#include "../../src/server/seat_interface.h"
+#include "../../src/server/server_decoration_interface.h"
+#include "../../src/server/server_decoration_palette_interface.h"
+#include "../../src/server/shadow_interface.h"
+#include "../../src/server/slide_interface.h"
+#include "../../src/server/subcompositor_interface.h"
+#include "../../src/server/tablet_v2_interface.h"
+#include "../../src/server/textinput_v2_interface.h"
+#include "../../src/server/textinput_v3_interface.h"
+#include "../../src/server/viewporter_interface.h"
+#include "../../src/server/xdgdecoration_v1_interface.h"
+#include "../../src/server/xdgforeign_v2_interface.h"
+#include "../../src/server/xdgoutput_v1_interface.h"
+#include "../../src/server/xdgshell_interface.h"
+// Wayland
+#include <wayland-client.h>
+#include <wayland-server.h>
+
+#include "benchmarkhelpers.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+
+using namespace KWaylandServer;
+using namespace BenchmarkHelpers;
+
+// how often the learned request stream of a global is replayed
+static const int s_repetitions = 200;
+// requests written before the server dispatches, well below the socket buffer size
+static const int s_batchSize = 32;
+// how deep the objects created by requests are exercised in turn
+static const int s_maxDepth = 2;
+static const int s_maxLearningAttempts = 64;
+static const int s_fuzzRequestCount = 20000;
+// created objects per fuzzed connection
+static const int s_maxObjects = 512;
+
+struct ProtocolArgument
+{
+    // the wl_message signature character
+    char type = 'i';
+    QByteArray interface;
+    bool nullable = false;
+};
+
+struct ProtocolMessage
+{
+    QByteArray name;
+    quint32 since = 1;
+    bool destructor = false;
+    std::vector<ProtocolArgument> arguments;
+
+    QByteArray signature;
+    std::vector<const wl_interface *> types;
+
+    QByteArray createdInterface() const
+    {
+        for (const ProtocolArgument &argument : arguments) {
+            if (argument.type == 'n') {
+                return argument.interface;
+            }
+        }
+        return QByteArray();
+    }
+    bool hasArgument(char type) const
+    {
+        return std::any_of(arguments.cbegin(), arguments.cend(), [type](const ProtocolArgument &argument) {
+            return argument.type == type;
+        });
+    }
+};
+
+struct ProtocolInterface
+{
+    QByteArray name;
+    quint32 version = 1;
+    std::vector<ProtocolMessage> requests;
+    std::vector<ProtocolMessage> events;
+
+    std::vector<wl_message> nativeRequests;
+    std::vector<wl_message> nativeEvents;
+    wl_interface native = {};
+};
+
+/**
+ * The protocol descriptions of the XML files qtwaylandscanner consumes, turned into the
+ * wl_interface tables libwayland-client marshals requests with.
+ **/
+class ProtocolRegistry
+{
+public:
+    void load(const QString &directory);
+    void resolve();
+    const ProtocolInterface *find(const QByteArray &name) const;
+    bool isEmpty() const;
+
+private:
+    void parse(const QString &fileName);
+    void resolveMessages(std::vector<ProtocolMessage> &messages, std::vector<wl_message> &native);
+
+    // the wl_interfaces point at each other, so the elements must not move
+    std::deque<ProtocolInterface> m_interfaces;
+    QHash<QByteArray, ProtocolInterface *> m_byName;
+};
+
+static char argumentType(const QStringRef &type)
+{
+    if (type == QLatin1String("uint")) {
+        return 'u';
+    } else if (type == QLatin1String("fixed")) {
+        return 'f';
+    } else if (type == QLatin1String("string")) {
+        return 's';
+    } else if (type == QLatin1String("object")) {
+        return 'o';
+    } else if (type == QLatin1String("new_id")) {
+        return 'n';
+    } else if (type == QLatin1String("array")) {
+        return 'a';
+    } else if (type == QLatin1String("fd")) {
+        return 'h';
+    }
+    return 'i';
+}
+
+void ProtocolRegistry::load(const QString &directory)
+{
+    if (directory.isEmpty()) {
+        return;
+    }
+    QStringList fileNames;
+    QDirIterator it(directory, {QStringLiteral("*.xml")}, QDir::Files, QDirIterator::Subdirectories);
+    while (it.hasNext()) {
+        fileNames << it.next();
+    }
+    fileNames.sort();
+    for (const QString &fileName : qAsConst(fileNames)) {
+        parse(fileName);
+    }
+}
+
+void ProtocolRegistry::parse(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return;
+    }
+    QXmlStreamReader xml(&file);
+    ProtocolInterface *interface = nullptr;
+    ProtocolMessage *message = nullptr;
+    while (!xml.atEnd()) {
+        xml.readNext();
+        if (xml.isStartElement()) {
+            const QXmlStreamAttributes attributes = xml.attributes();
+            if (xml.name() == QLatin1String("interface")) {
+                const QByteArray name = attributes.value(QLatin1String("name")).toUtf8();
+                if (m_byName.contains(name)) {
+                    // the first description of an interface wins
+                    xml.skipCurrentElement();
+                    continue;
+                }
+                m_interfaces.emplace_back();
+                interface = &m_interfaces.back();
+                interface->name = name;
+                interface->version = qMax(1u, attributes.value(QLatin1String("version")).toUInt());
+                m_byName.insert(name, interface);
+            } else if (interface && (xml.name() == QLatin1String("request") || xml.name() == QLatin1String("event"))) {
+                std::vector<ProtocolMessage> &messages = xml.name() == QLatin1String("request") ? interface->requests : interface->events;
+                messages.emplace_back();
+                message = &messages.back();
+                message->name = attributes.value(QLatin1String("name")).toUtf8();
+                message->since = qMax(1u, attributes.value(QLatin1String("since")).toUInt());
+                message->destructor = attributes.value(QLatin1String("type")) == QLatin1String("destructor");
+            } else if (message && xml.name() == QLatin1String("arg")) {
+                ProtocolArgument argument;
+                argument.type = argumentType(attributes.value(QLatin1String("type")));
+                argument.interface = attributes.value(QLatin1String("interface")).toUtf8();
+                argument.nullable = attributes.value(QLatin1String("allow-null")) == QLatin1String("true");
+                message->arguments.push_back(argument);
+            }
+        } else if (xml.isEndElement()) {
+            if (xml.name() == QLatin1String("request") || xml.name() == QLatin1String("event")) {
+                message = nullptr;
+            } else if (xml.name() == QLatin1String("interface")) {
+                interface = nullptr;
+            }
+        }
+    }
+}
+
+void ProtocolRegistry::resolve()
+{
+    // libwayland-client needs an interface for every object it creates, referenced
+    // interfaces without a description get an empty one
+    QVector<QByteArray> missing;
+    for (const ProtocolInterface &interface : m_interfaces) {
+        for (const std::vector<ProtocolMessage> *messages : {&interface.requests, &interface.events}) {
+            for (const ProtocolMessage &message : *messages) {
+                for (const ProtocolArgument &argument : message.arguments) {
+                    if (!argument.interface.isEmpty() && !m_byName.contains(argument.interface) && !missing.contains(argument.interface)) {
+                        missing << argument.interface;
+                    }
+                }
+            }
+        }
+    }
+    for (const QByteArray &name : qAsConst(missing)) {
+        m_interfaces.emplace_back();
+        m_interfaces.back().name = name;
+        m_byName.insert(name, &m_interfaces.back());
+    }
+
+    for (ProtocolInterface &interface : m_interfaces) {
+        resolveMessages(interface.requests, interface.nativeRequests);
+        resolveMessages(interface.events, interface.nativeEvents);
+        interface.native.name = interface.name.constData();
+        interface.native.version = int(interface.version);
+        interface.native.method_count = int(interface.nativeRequests.size());
+        interface.native.methods = interface.nativeRequests.data();
+        interface.native.event_count = int(interface.nativeEvents.size());
+        interface.native.events = interface.nativeEvents.data();
+    }
+}
+
+void ProtocolRegistry::resolveMessages(std::vector<ProtocolMessage> &messages, std::vector<wl_message> &native)
+{
+    native.reserve(messages.size());
+    for (ProtocolMessage &message : messages) {
+        if (message.since > 1) {
+            message.signature = QByteArray::number(message.since);
+        }
+        for (const ProtocolArgument &argument : message.arguments) {
+            if (argument.type == 'n' && argument.interface.isEmpty()) {
+                // an untyped new_id is preceded by the interface name and version
+                message.signature += "sun";
+                message.types.insert(message.types.end(), 3, nullptr);
+                continue;
+            }
+            if (argument.nullable) {
+                message.signature += '?';
+            }
+            message.signature += argument.type;
+            const ProtocolInterface *referenced = m_byName.value(argument.interface);
+            message.types.push_back(referenced ? &referenced->native : nullptr);
+        }
+        native.push_back({message.name.constData(), message.signature.constData(), message.types.data()});
+    }
+}
+
+const ProtocolInterface *ProtocolRegistry::find(const QByteArray &name) const
+{
+    return m_byName.value(name);
+}
+
+bool ProtocolRegistry::isEmpty() const
+{
+    return m_interfaces.empty();
+}
+
+class Connection;
+
+struct Object
+{
+    wl_proxy *proxy = nullptr;
+    const ProtocolInterface *interface = nullptr;
+    quint32 version = 1;
+    Connection *connection = nullptr;
+    bool alive = true;
+};
+
+struct Arguments
+{
+    std::vector<wl_argument> values;
+    // storage of the strings and arrays the values point at
+    std::deque<QByteArray> strings;
+    std::deque<wl_array> arrays;
+};
+
+struct ProtocolCounters
+{
+    quint64 requests = 0;
+    quint64 events = 0;
+};
+
+/**
+ * A plain libwayland-client connection to the Display over a socket pair, driven from the
+ * test thread. Each object gets a generic dispatcher, so the events are counted without any
+ * client side protocol code.
+ **/
+class Connection
+{
+public:
+    struct Global {
+        quint32 name;
+        QByteArray interface;
+        quint32 version;
+    };
+
+    Connection(Display *server, const ProtocolRegistry *registry, const QSet<QByteArray> *quarantine, int batchSize);
+    ~Connection();
+
+    bool connect();
+    bool roundtrip();
+    void process();
+    bool hasError() const;
+
+    QVector<Global> globals() const;
+    Object *bind(const Global &global);
+    void bindAll();
+
+    Object *send(Object *object, int opcode, Arguments &arguments);
+    void release(Object *object);
+
+    bool isQuarantined(const ProtocolInterface *interface, const ProtocolMessage &request) const;
+    bool buildValidArguments(const ProtocolMessage &request, Arguments &arguments, int depth);
+    bool buildRandomArguments(const ProtocolMessage &request, QRandomGenerator &random, Arguments &arguments);
+    Object *randomObject(QRandomGenerator &random);
+
+    QByteArray lastRequest() const;
+    QHash<QByteArray, ProtocolCounters> counters() const;
+    quint64 serverNsecs() const;
+    quint64 serverAllocations() const;
+    void resetCounters();
+
+    static int dispatchEvent(const void *implementation, void *target, uint32_t opcode, const wl_message *message, wl_argument *arguments);
+
+private:
+    Object *adopt(wl_proxy *proxy, const ProtocolInterface *interface);
+    Object *provide(const QByteArray &interface, int depth);
+    void eventReceived(Object *object, uint32_t opcode, wl_argument *arguments);
+    void readEvents();
+    int aliveObjectCount() const;
+
+    Display *m_server;
+    const ProtocolRegistry *m_registry;
+    const QSet<QByteArray> *m_quarantine;
+    const int m_batchSize;
+    int m_pending = 0;
+
+    wl_display *m_display = nullptr;
+    wl_registry *m_wlRegistry = nullptr;
+    RegistryListener m_registryListener;
+    QVector<Global> m_globals;
+    // the dispatchers point at the objects, so the elements must not move
+    std::deque<Object> m_objects;
+
+    QByteArray m_lastRequest;
+    QHash<QByteArray, ProtocolCounters> m_counters;
+    quint64 m_serverNsecs = 0;
+    quint64 m_serverAllocations = 0;
+};
+
+Connection::Connection(Display *server, const ProtocolRegistry *registry, const QSet<QByteArray> *quarantine, int batchSize)
+    : m_server(server)
+    , m_registry(registry)
+    , m_quarantine(quarantine)
+    , m_batchSize(batchSize)
+{
+}
+
+Connection::~Connection()
+{
+    if (!m_display) {
+        return;
+    }
+    for (Object &object : m_objects) {
+        if (object.alive) {
+            wl_proxy_destroy(object.proxy);
+        }
+    }
+    if (m_wlRegistry) {
+        wl_registry_destroy(m_wlRegistry);
+    }
+    wl_display_disconnect(m_display);
+    m_server->dispatchEvents();
+}
+
+bool Connection::connect()
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        return false;
+    }
+    if (!m_server->createClient(sv[0])) {
+        return false;
+    }
+    m_display = wl_display_connect_to_fd(sv[1]);
+    if (!m_display) {
+        return false;
+    }
+    m_wlRegistry = wl_display_get_registry(m_display);
+    m_registryListener.listen(m_wlRegistry, [this](wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+        Q_UNUSED(registry)
+        m_globals.append({name, QByteArray(interface), version});
+    });
+    return roundtrip() && !m_globals.isEmpty();
+}
+
+static void syncDone(void *data, wl_callback *callback, uint32_t serial)
+{
+    Q_UNUSED(callback)
+    Q_UNUSED(serial)
+    *static_cast<bool *>(data) = true;
+}
+
+static const wl_callback_listener s_syncListener = {
+    syncDone
+};
+
+bool Connection::roundtrip()
+{
+    bool done = false;
+    wl_callback *callback = wl_display_sync(m_display);
+    wl_callback_add_listener(callback, &s_syncListener, &done);
+    for (int i = 0; i < 16 && !done && !hasError(); ++i) {
+        process();
+    }
+    wl_callback_destroy(callback);
+    return done;
+}
+
+void Connection::process()
+{
+    m_pending = 0;
+    wl_display_flush(m_display);
+
+    QElapsedTimer timer;
+    const quint64 allocations = allocationCount();
+    timer.start();
+    m_server->dispatchEvents();
+    wl_display_flush_clients(*m_server);
+    m_serverNsecs += timer.nsecsElapsed();
+    m_serverAllocations += allocationCount() - allocations;
+
+    readEvents();
+}
+
+void Connection::readEvents()
+{
+    while (wl_display_prepare_read(m_display) != 0) {
+        if (wl_display_dispatch_pending(m_display) < 0) {
+            return;
+        }
+    }
+    pollfd pfd = {wl_display_get_fd(m_display), POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0) {
+        wl_display_read_events(m_display);
+    } else {
+        wl_display_cancel_read(m_display);
+    }
+    wl_display_dispatch_pending(m_display);
+}
+
+bool Connection::hasError() const
+{
+    return !m_display || wl_display_get_error(m_display) != 0;
+}
+
+QVector<Connection::Global> Connection::globals() const
+{
+    return m_globals;
+}
+
+Object *Connection::bind(const Global &global)
+{
+    const ProtocolInterface *interface = m_registry->find(global.interface);
+    if (!interface || (interface->requests.empty() && interface->events.empty())) {
+        return nullptr;
+    }
+    const quint32 version = qMin(global.version, interface->version);
+    wl_proxy *proxy = static_cast<wl_proxy *>(wl_registry_bind(m_wlRegistry, global.name, &interface->native, version));
+    if (!proxy) {
+        return nullptr;
+    }
+    m_counters[interface->name].requests++;
+    return adopt(proxy, interface);
+}
+
+void Connection::bindAll()
+{
+    for (const Global &global : qAsConst(m_globals)) {
+        bind(global);
+    }
+}
+
+Object *Connection::adopt(wl_proxy *proxy, const ProtocolInterface *interface)
+{
+    m_objects.emplace_back();
+    Object *object = &m_objects.back();
+    object->proxy = proxy;
+    object->interface = interface;
+    object->version = wl_proxy_get_version(proxy);
+    object->connection = this;
+    wl_proxy_add_dispatcher(proxy, dispatchEvent, nullptr, object);
+    return object;
+}
+
+int Connection::dispatchEvent(const void *implementation, void *target, uint32_t opcode, const wl_message *message, wl_argument *arguments)
+{
+    Q_UNUSED(implementation)
+    Q_UNUSED(message)
+    Object *object = static_cast<Object *>(wl_proxy_get_user_data(static_cast<wl_proxy *>(target)));
+    object->connection->eventReceived(object, opcode, arguments);
+    return 0;
+}
+
+void Connection::eventReceived(Object *object, uint32_t opcode, wl_argument *arguments)
+{
+    m_counters[object->interface->name].events++;
+    if (opcode >= object->interface->events.size()) {
+        return;
+    }
+    // objects created by the server become targets of requests as well
+    int index = 0;
+    for (const ProtocolArgument &argument : object->interface->events[opcode].arguments) {
+        if (argument.type == 'n' && argument.interface.isEmpty()) {
+            index += 3;
+            continue;
+        }
+        if (argument.type == 'n' && arguments[index].o) {
+            if (const ProtocolInterface *interface = m_registry->find(argument.interface)) {
+                adopt(reinterpret_cast<wl_proxy *>(arguments[index].o), interface);
+            }
+        }
+        index++;
+    }
+}
+
+Object *Connection::send(Object *object, int opcode, Arguments &arguments)
+{
+    if (hasError() || !object->alive) {
+        return nullptr;
+    }
+    const ProtocolMessage &request = object->interface->requests[opcode];
+    const ProtocolInterface *created = nullptr;
+    if (request.hasArgument('n')) {
+        created = m_registry->find(request.createdInterface());
+    }
+    m_lastRequest = object->interface->name + '.' + request.name;
+    m_counters[object->interface->name].requests++;
+
+    Object *child = nullptr;
+    if (created) {
+        wl_proxy *proxy = wl_proxy_marshal_array_constructor_versioned(object->proxy, opcode, arguments.values.data(), &created->native, object->version);
+        if (proxy) {
+            child = adopt(proxy, created);
+        }
+    } else {
+        wl_proxy_marshal_array(object->proxy, opcode, arguments.values.data());
+    }
+    if (request.destructor) {
+        wl_proxy_destroy(object->proxy);
+        object->alive = false;
+    }
+
+    if (++m_pending >= m_batchSize) {
+        process();
+    }
+    return child;
+}
+
+void Connection::release(Object *object)
+{
+    const std::vector<ProtocolMessage> &requests = object->interface->requests;
+    for (int opcode = 0; opcode < int(requests.size()); ++opcode) {
+        const ProtocolMessage &request = requests[opcode];
+        if (!request.destructor || request.since > object->version || isQuarantined(object->interface, request)) {
+            continue;
+        }
+        Arguments arguments;
+        if (buildValidArguments(request, arguments, 0)) {
+            send(object, opcode, arguments);
+            return;
+        }
+    }
+}
+
+bool Connection::isQuarantined(const ProtocolInterface *interface, const ProtocolMessage &request) const
+{
+    return m_quarantine && m_quarantine->contains(interface->name + '.' + request.name);
+}
+
+Object *Connection::provide(const QByteArray &interface, int depth)
+{
+    for (auto it = m_objects.rbegin(); it != m_objects.rend(); ++it) {
+        if (it->alive && it->interface->name == interface) {
+            return &(*it);
+        }
+    }
+    if (depth >= s_maxDepth) {
+        return nullptr;
+    }
+    // create the object with the first request that can, e.g. wl_compositor.create_surface
+    for (size_t i = 0; i < m_objects.size(); ++i) {
+        Object *object = &m_objects[i];
+        if (!object->alive) {
+            continue;
+        }
+        const std::vector<ProtocolMessage> &requests = object->interface->requests;
+        for (int opcode = 0; opcode < int(requests.size()); ++opcode) {
+            const ProtocolMessage &request = requests[opcode];
+            if (request.destructor || request.since > object->version || request.createdInterface() != interface
+                    || isQuarantined(object->interface, request)) {
+                continue;
+            }
+            Arguments arguments;
+            if (!buildValidArguments(request, arguments, depth + 1)) {
+                continue;
+            }
+            return send(object, opcode, arguments);
+        }
+    }
+    return nullptr;
+}
+
+bool Connection::buildValidArguments(const ProtocolMessage &request, Arguments &arguments, int depth)
+{
+    for (const ProtocolArgument &argument : request.arguments) {
+        wl_argument value = {};
+        switch (argument.type) {
+        case 'i':
+            value.i = 1;
+            break;
+        case 'u':
+            value.u = 1;
+            break;
+        case 'f':
+            value.f = wl_fixed_from_int(1);
+            break;
+        case 's':
+            arguments.strings.push_back(QByteArrayLiteral("synthetic"));
+            value.s = arguments.strings.back().constData();
+            break;
+        case 'a':
+            arguments.arrays.push_back(wl_array{0, 0, nullptr});
+            value.a = &arguments.arrays.back();
+            break;
+        case 'o':
+            if (argument.nullable) {
+                value.o = nullptr;
+            } else if (Object *object = provide(argument.interface, depth)) {
+                value.o = reinterpret_cast<wl_object *>(object->proxy);
+            } else {
+                return false;
+            }
+            break;
+        case 'n':
+            if (argument.interface.isEmpty()) {
+                return false;
+            }
+            break;
+        case 'h':
+        default:
+            // file descriptors are not synthesized
+            return false;
+        }
+        arguments.values.push_back(value);
+    }
+    return !hasError();
+}
+
+static qint32 randomInt(QRandomGenerator &random)
+{
+    static const qint32 interesting[] = {0, 1, -1, std::numeric_limits<qint32>::min(), std::numeric_limits<qint32>::max()};
+    if (random.bounded(2)) {
+        return interesting[random.bounded(int(sizeof(interesting) / sizeof(interesting[0])))];
+    }
+    return random.bounded(-4096, 4096);
+}
+
+bool Connection::buildRandomArguments(const ProtocolMessage &request, QRandomGenerator &random, Arguments &arguments)
+{
+    for (const ProtocolArgument &argument : request.arguments) {
+        wl_argument value = {};
+        switch (argument.type) {
+        case 'i':
+            value.i = randomInt(random);
+            break;
+        case 'u':
+            value.u = quint32(randomInt(random));
+            break;
+        case 'f':
+            value.f = randomInt(random);
+            break;
+        case 's':
+            if (argument.nullable && random.bounded(8) == 0) {
+                value.s = nullptr;
+            } else {
+                QByteArray string(random.bounded(64), Qt::Uninitialized);
+                for (char &c : string) {
+                    c = char(random.bounded(0x20, 0x7f));
+                }
+                arguments.strings.push_back(string);
+                value.s = arguments.strings.back().constData();
+            }
+            break;
+        case 'a': {
+            QByteArray data(random.bounded(64), Qt::Uninitialized);
+            for (char &c : data) {
+                c = char(random.bounded(256));
+            }
+            arguments.strings.push_back(data);
+            QByteArray &storage = arguments.strings.back();
+            arguments.arrays.push_back(wl_array{size_t(storage.size()), size_t(storage.size()), storage.data()});
+            value.a = &arguments.arrays.back();
+            break;
+        }
+        case 'o': {
+            // mostly objects of the right interface, but also null and mismatching objects
+            const int choice = random.bounded(8);
+            Object *object = nullptr;
+            if (choice < 5) {
+                for (auto it = m_objects.rbegin(); it != m_objects.rend(); ++it) {
+                    if (it->alive && it->interface->name == argument.interface) {
+                        object = &(*it);
+                        break;
+                    }
+                }
+            } else if (choice < 7) {
+                object = randomObject(random);
+            }
+            value.o = object ? reinterpret_cast<wl_object *>(object->proxy) : nullptr;
+            break;
+        }
+        case 'n':
+            if (argument.interface.isEmpty() || aliveObjectCount() >= s_maxObjects) {
+                return false;
+            }
+            break;
+        case 'h':
+        default:
+            return false;
+        }
+        arguments.values.push_back(value);
+    }
+    return true;
+}
+
+Object *Connection::randomObject(QRandomGenerator &random)
+{
+    if (m_objects.empty()) {
+        return nullptr;
+    }
+    for (int attempt = 0; attempt < 8; ++attempt) {
+        Object *object = &m_objects[random.bounded(int(m_objects.size()))];
+        if (object->alive) {
+            return object;
+        }
+    }
+    return nullptr;
+}
+
+int Connection::aliveObjectCount() const
+{
+    return std::count_if(m_objects.cbegin(), m_objects.cend(), [](const Object &object) {
+        return object.alive;
+    });
+}
+
+QByteArray Connection::lastRequest() const
+{
+    return m_lastRequest;
+}
+
+QHash<QByteArray, ProtocolCounters> Connection::counters() const
+{
+    return m_counters;
+}
+
+quint64 Connection::serverNsecs() const
+{
+    return m_serverNsecs;
+}
+
+quint64 Connection::serverAllocations() const
+{
+    return m_serverAllocations;
+}
+
+void Connection::resetCounters()
+{
+    m_counters.clear();
+    m_serverNsecs = 0;
+    m_serverAllocations = 0;
+}
+
+/**
+ * Replays request streams synthesized from the protocol XML against a Display with all
+ * globals and reports the throughput of the server's protocol layer.
+ *
+ * For every global a stream is derived that calls every request of the bound object with
+ * plain arguments, exercises the objects created by it in turn and destroys them again.
+ * Requests which make the server post an error are learned and left out, so what remains
+ * is a valid stream, which is replayed to report requests/s, events/s and allocations per
+ * request. The fuzz rows send random requests with random arguments instead and only
+ * check that the server survives them.
+ **/
+class TestProtocolThroughput : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void benchmarkValidStream_data();
+    void benchmarkValidStream();
+    void testRandomStream_data();
+    void testRandomStream();
+
+private:
+    void createGlobals();
+    void exercise(Connection &connection, Object *object, int depth);
+    void report(const QByteArray &global, const Connection &connection);
+
+    Display m_display;
+    ProtocolRegistry m_registry;
+    QVector<Connection::Global> m_globals;
+    QSet<QByteArray> m_quarantine;
+};
+
+void TestProtocolThroughput::createGlobals()
+{
+    m_display.createShm();
+    new CompositorInterface(&m_display, &m_display);
+    new SubCompositorInterface(&m_display, &m_display);
+    new DataDeviceManagerInterface(&m_display, &m_display);
+    new DataControlDeviceManagerV1Interface(&m_display, &m_display);
+    new PrimarySelectionDeviceManagerV1Interface(&m_display, &m_display);
+
+    SeatInterface *seat = new SeatInterface(&m_display, &m_display);
+    seat->setHasKeyboard(true);
+    seat->setHasPointer(true);
+    seat->setHasTouch(true);
+    seat->create();
+
+    OutputInterface *output = new OutputInterface(&m_display, &m_display);
+    output->addMode(QSize(1920, 1080), OutputInterface::ModeFlags(OutputInterface::ModeFlag::Preferred));
+    output->setCurrentMode(QSize(1920, 1080));
+    output->create();
+
+    OutputDeviceInterface *outputDevice = new OutputDeviceInterface(&m_display, &m_display);
+    OutputDeviceInterface::Mode mode;
+    mode.size = QSize(1920, 1080);
+    mode.id = 0;
+    outputDevice->addMode(mode);
+    outputDevice->setCurrentMode(0);
+    outputDevice->create();
+
+    (new OutputManagementInterface(&m_display, &m_display))->create();
+    (new LinuxDmabufUnstableV1Interface(&m_display, &m_display))->create();
+    new XdgOutputManagerV1Interface(&m_display, &m_display);
+
+    new XdgShellInterface(&m_display, &m_display);
+    new XdgDecorationManagerV1Interface(&m_display, &m_display);
+    new XdgForeignV2Interface(&m_display, &m_display);
+    new LayerShellV1Interface(&m_display, &m_display);
+    new ViewporterInterface(&m_display, &m_display);
+    new PointerConstraintsV1Interface(&m_display, &m_display);
+    new PointerGesturesV1Interface(&m_display, &m_display);
+    new RelativePointerManagerV1Interface(&m_display, &m_display);
+    new IdleInhibitManagerV1Interface(&m_display, &m_display);
+    new KeyboardShortcutsInhibitManagerV1Interface(&m_display, &m_display);
+    new TabletManagerV2Interface(&m_display, &m_display);
+    new TextInputManagerV2Interface(&m_display, &m_display);
+    new TextInputManagerV3Interface(&m_display, &m_display);
+    new InputMethodV1Interface(&m_display, &m_display);
+    new InputPanelV1Interface(&m_display, &m_display);
+    new EglStreamControllerInterface(&m_display, &m_display);
+
+    new PlasmaShellInterface(&m_display, &m_display);
+    new PlasmaWindowManagementInterface(&m_display, &m_display);
+    new PlasmaVirtualDesktopManagementInterface(&m_display, &m_display);
+    new ScreencastV1Interface(&m_display, &m_display);
+    new ServerSideDecorationManagerInterface(&m_display, &m_display);
+    new ServerSideDecorationPaletteManagerInterface(&m_display, &m_display);
+    new AppMenuManagerInterface(&m_display, &m_display);
+    new BlurManagerInterface(&m_display, &m_display);
+    new ContrastManagerInterface(&m_display, &m_display);
+    new ShadowManagerInterface(&m_display, &m_display);
+    new SlideManagerInterface(&m_display, &m_display);
+    new DpmsManagerInterface(&m_display, &m_display);
+    new IdleInterface(&m_display, &m_display);
+    new FakeInputInterface(&m_display, &m_display);
+    new KeyStateInterface(&m_display, &m_display);
+}
+
+void TestProtocolThroughput::initTestCase()
+{
+    m_registry.load(QStringLiteral(WAYLAND_PROTOCOL_DIR));
+    m_registry.load(QStringLiteral(PLASMA_WAYLAND_PROTOCOLS_DIR));
+    m_registry.load(QStringLiteral(WAYLAND_PROTOCOLS_DIR));
+    if (m_registry.isEmpty()) {
+        QSKIP("No protocol descriptions found");
+    }
+    m_registry.resolve();
+
+    createGlobals();
+    QVERIFY(m_display.start());
+
+    Connection probe(&m_display, &m_registry, nullptr, 1);
+    QVERIFY(probe.connect());
+    for (const Connection::Global &global : probe.globals()) {
+        if (m_registry.find(global.interface)) {
+            m_globals << global;
+        }
+    }
+    QVERIFY(!m_globals.isEmpty());
+}
+
+void TestProtocolThroughput::exercise(Connection &connection, Object *object, int depth)
+{
+    const ProtocolInterface *interface = object->interface;
+    for (int opcode = 0; opcode < int(interface->requests.size()); ++opcode) {
+        const ProtocolMessage &request = interface->requests[opcode];
+        if (connection.hasError() || !object->alive) {
+            return;
+        }
+        if (request.destructor || request.since > object->version || connection.isQuarantined(interface, request)) {
+            continue;
+        }
+        Arguments arguments;
+        if (!connection.buildValidArguments(request, arguments, 0)) {
+            continue;
+        }
+        if (Object *child = connection.send(object, opcode, arguments)) {
+            if (depth < s_maxDepth) {
+                exercise(connection, child, depth + 1);
+            }
+            connection.release(child);
+        }
+    }
+}
+
+void TestProtocolThroughput::report(const QByteArray &global, const Connection &connection)
+{
+    const QHash<QByteArray, ProtocolCounters> counters = connection.counters();
+    quint64 requests = 0;
+    quint64 events = 0;
+    for (const ProtocolCounters &counter : counters) {
+        requests += counter.requests;
+        events += counter.events;
+    }
+    const double seconds = qMax<quint64>(connection.serverNsecs(), 1) / 1e9;
+    qInfo("%-40s %12.0f requests/s %12.0f events/s %8.2f allocations/request", global.constData(),
+          requests / seconds, events / seconds, double(connection.serverAllocations()) / qMax<quint64>(requests, 1));
+
+    QList<QByteArray> interfaces = counters.keys();
+    std::sort(interfaces.begin(), interfaces.end());
+    for (const QByteArray &interface : qAsConst(interfaces)) {
+        const ProtocolCounters &counter = counters[interface];
+        if (counter.requests || counter.events) {
+            qInfo("    %-36s %12llu requests   %12llu events", interface.constData(), counter.requests, counter.events);
+        }
+    }
+}
+
+void TestProtocolThroughput::benchmarkValidStream_data()
+{
+    QTest::addColumn<QByteArray>("interface");
+
+    for (const Connection::Global &global : qAsConst(m_globals)) {
+        QTest::newRow(global.interface.constData()) << global.interface;
+    }
+}
+
+void TestProtocolThroughput::benchmarkValidStream()
+{
+    QFETCH(QByteArray, interface);
+    auto it = std::find_if(m_globals.constBegin(), m_globals.constEnd(), [interface](const Connection::Global &global) {
+        return global.interface == interface;
+    });
+    QVERIFY(it != m_globals.constEnd());
+    const Connection::Global global = *it;
+
+    // learn which requests the server rejects with the plain arguments by sending one
+    // request at a time, the failing request is always the last one sent
+    bool learned = false;
+    for (int attempt = 0; attempt < s_maxLearningAttempts && !learned; ++attempt) {
+        Connection connection(&m_display, &m_registry, &m_quarantine, 1);
+        QVERIFY(connection.connect());
+        connection.bindAll();
+        QVERIFY(connection.roundtrip());
+        Object *object = connection.bind(global);
+        QVERIFY(object);
+        // twice, the second round catches the requests that may only be sent once
+        exercise(connection, object, 0);
+        exercise(connection, object, 0);
+        connection.process();
+        if (!connection.hasError()) {
+            learned = true;
+            break;
+        }
+        const QByteArray request = connection.lastRequest();
+        if (request.isEmpty() || m_quarantine.contains(request)) {
+            break;
+        }
+        m_quarantine.insert(request);
+    }
+    if (!learned) {
+        QSKIP("No valid request stream found");
+    }
+
+    Connection connection(&m_display, &m_registry, &m_quarantine, s_batchSize);
+    QVERIFY(connection.connect());
+    connection.bindAll();
+    QVERIFY(connection.roundtrip());
+    Object *object = connection.bind(global);
+    QVERIFY(object);
+    QVERIFY(connection.roundtrip());
+    connection.resetCounters();
+
+    QBENCHMARK_ONCE {
+        for (int i = 0; i < s_repetitions && !connection.hasError(); ++i) {
+            exercise(connection, object, 0);
+        }
+        connection.process();
+    }
+    if (connection.hasError()) {
+        QWARN(qPrintable(QStringLiteral("The stream failed at %1").arg(QString::fromUtf8(connection.lastRequest()))));
+        return;
+    }
+    report(global.interface, connection);
+}
+
+void TestProtocolThroughput::testRandomStream_data()
+{
+    QTest::addColumn<quint32>("seed");
+
+    QTest::newRow("seed 1") << 1u;
+    QTest::newRow("seed 2") << 2u;
+    QTest::newRow("seed 3") << 3u;
+    QTest::newRow("seed 4") << 4u;
+}
+
+void TestProtocolThroughput::testRandomStream()
+{
+    QFETCH(quint32, seed);
+    QRandomGenerator random(seed);
+
+    std::unique_ptr<Connection> connection;
+    int protocolErrors = 0;
+    quint64 requests = 0;
+    for (int i = 0; i < s_fuzzRequestCount; ++i) {
+        if (!connection || connection->hasError()) {
+            if (connection) {
+                protocolErrors++;
+            }
+            connection.reset(new Connection(&m_display, &m_registry, nullptr, 16));
+            QVERIFY(connection->connect());
+            connection->bindAll();
+        }
+        Object *object = connection->randomObject(random);
+        if (!object || object->interface->requests.empty()) {
+            continue;
+        }
+        const int opcode = random.bounded(int(object->interface->requests.size()));
+        const ProtocolMessage &request = object->interface->requests[opcode];
+        // libwayland-client refuses requests newer than the object
+        if (request.since > object->version) {
+            continue;
+        }
+        Arguments arguments;
+        if (!connection->buildRandomArguments(request, random, arguments)) {
+            continue;
+        }
+        connection->send(object, opcode, arguments);
+        requests++;
+    }
+    if (connection) {
+        connection->process();
+    }
+    connection.reset();
+    qInfo("%llu requests, %d protocol errors", requests, protocolErrors);
+
+    // the server still serves new clients
+    Connection probe(&m_display, &m_registry, nullptr, 1);
+    QVERIFY(probe.connect());
+    probe.bindAll();
+    QVERIFY(probe.roundtrip());
+}
+
+QTEST_GUILESS_MAIN(TestProtocolThroughput)
+#include "test_protocol_throughput.moc"
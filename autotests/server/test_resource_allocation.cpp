@@ -0,0 +1,156 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+// Wayland
+#include <wayland-client.h>
+#include <wayland-server.h>
+
+#include "benchmarkhelpers.h"
+
+#include <sys/socket.h>
+
+using namespace KWaylandServer;
+using namespace BenchmarkHelpers;
+
+/**
+ * Measures how fast short-lived client objects are created and destroyed, one million
+ * wl_region and wl_callback objects each. The client is a plain libwayland connection
+ * over a socket pair driven from the test thread.
+ **/
+class TestResourceAllocation : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkRegions();
+    void benchmarkFrameCallbacks();
+
+private:
+    void roundtrip();
+    void report(const char *name, qint64 objectCount, qint64 nsecs);
+
+    Display m_display;
+    SurfaceInterface *m_serverSurface = nullptr;
+    wl_display *m_clientDisplay = nullptr;
+    wl_registry *m_registry = nullptr;
+    RegistryListener m_registryListener;
+    wl_compositor *m_compositor = nullptr;
+    wl_surface *m_surface = nullptr;
+};
+
+static const int s_objectCount = 1000000;
+// below the default limit of pending frame callbacks
+static const int s_objectsPerBatch = 250;
+
+void TestResourceAllocation::roundtrip()
+{
+    wl_display_flush(m_clientDisplay);
+    m_display.dispatchEvents();
+    wl_display_flush_clients(m_display);
+}
+
+void TestResourceAllocation::initTestCase()
+{
+    QVERIFY(m_display.start());
+    CompositorInterface *compositor = new CompositorInterface(&m_display, this);
+    connect(compositor, &CompositorInterface::surfaceCreated, this, [this](SurfaceInterface *surface) {
+        m_serverSurface = surface;
+    });
+
+    int sv[2];
+    QVERIFY(socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) >= 0);
+    QVERIFY(m_display.createClient(sv[0]));
+    m_clientDisplay = wl_display_connect_to_fd(sv[1]);
+    QVERIFY(m_clientDisplay);
+
+    m_registry = wl_display_get_registry(m_clientDisplay);
+    m_registryListener.listen(m_registry, [this](wl_registry *registry, uint32_t name, const char *interface, uint32_t version) {
+        Q_UNUSED(version)
+        if (qstrcmp(interface, wl_compositor_interface.name) == 0) {
+            m_compositor = static_cast<wl_compositor *>(wl_registry_bind(registry, name, &wl_compositor_interface, 1));
+        }
+    });
+    roundtrip();
+    QCOMPARE(wl_display_dispatch(m_clientDisplay) >= 0, true);
+    QVERIFY(m_compositor);
+
+    m_surface = wl_compositor_create_surface(m_compositor);
+    roundtrip();
+    QVERIFY(m_serverSurface);
+}
+
+void TestResourceAllocation::cleanupTestCase()
+{
+    if (m_surface) {
+        wl_surface_destroy(m_surface);
+    }
+    if (m_compositor) {
+        wl_compositor_destroy(m_compositor);
+    }
+    if (m_registry) {
+        wl_registry_destroy(m_registry);
+    }
+    if (m_clientDisplay) {
+        wl_display_disconnect(m_clientDisplay);
+    }
+}
+
+void TestResourceAllocation::report(const char *name, qint64 objectCount, qint64 nsecs)
+{
+    qInfo("%s: %.0f objects/s", name, objectCount * 1e9 / qMax<qint64>(nsecs, 1));
+}
+
+void TestResourceAllocation::benchmarkRegions()
+{
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        for (int created = 0; created < s_objectCount; created += s_objectsPerBatch) {
+            for (int i = 0; i < s_objectsPerBatch; ++i) {
+                wl_region *region = wl_compositor_create_region(m_compositor);
+                wl_region_add(region, 0, 0, 10, 10);
+                wl_region_destroy(region);
+            }
+            roundtrip();
+            // collect the delete_id events so that the client can reuse the object ids
+            QVERIFY(wl_display_dispatch(m_clientDisplay) >= 0);
+        }
+    }
+    report("wl_region", s_objectCount, timer.nsecsElapsed());
+}
+
+void TestResourceAllocation::benchmarkFrameCallbacks()
+{
+    QVector<wl_callback *> callbacks(s_objectsPerBatch);
+    QElapsedTimer timer;
+    timer.start();
+    QBENCHMARK_ONCE {
+        for (int created = 0; created < s_objectCount; created += s_objectsPerBatch) {
+            for (int i = 0; i < s_objectsPerBatch; ++i) {
+                callbacks[i] = wl_surface_frame(m_surface);
+            }
+            wl_surface_commit(m_surface);
+            wl_display_flush(m_clientDisplay);
+            m_display.dispatchEvents();
+            m_serverSurface->frameRendered(created);
+            wl_display_flush_clients(m_display);
+            QVERIFY(wl_display_dispatch(m_clientDisplay) >= 0);
+            for (wl_callback *callback : qAsConst(callbacks)) {
+                wl_callback_destroy(callback);
+            }
+        }
+    }
+    report("wl_callback", s_objectCount, timer.nsecsElapsed());
+}
+
+QTEST_GUILESS_MAIN(TestResourceAllocation)
+#include "test_resource_allocation.moc"
@@ -14,6 +14,7 @@
 // WaylandServer
 #include "../../src/server/compositor_interface.h"
 #include "../../src/server/display.h"
+#include "../../src/server/plasmawindowmanagement_interface.h"
 #include "../../src/server/seat_interface.h"
 #include "../../src/server/screencast_v1_interface.h"
 
@@ -41,8 +42,13 @@ public:
         Q_EMIT created(node);
     }
 
+    void zkde_screencast_stream_unstable_v1_failed(const QString &error) override {
+        Q_EMIT failed(error);
+    }
+
 Q_SIGNALS:
     void created(quint32 node);
+    void failed(const QString &error);
 };
 
 class ScreencastV1 : public QObject, public QtWayland::zkde_screencast_unstable_v1
@@ -58,6 +64,11 @@ public:
     ScreencastStreamV1 *createWindowStream(const QString &uuid) {
         return new ScreencastStreamV1(stream_window(uuid, 2), this);
     }
+
+    ScreencastStreamV1 *createRegionStream(const QRect &region, qreal scale) {
+        return new ScreencastStreamV1(stream_region(region.x(), region.y(), region.width(), region.height(),
+                                                    wl_fixed_from_double(scale), 4), this);
+    }
 };
 
 class TestScreencastV1Interface : public QObject
@@ -74,6 +85,10 @@ public:
 private Q_SLOTS:
     void initTestCase();
     void testCreate();
+    void testFrameRequests();
+    void testRegion();
+    void testInvalidRegion();
+    void testWindowByUuid();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -129,7 +144,7 @@ void TestScreencastV1Interface::initTestCase()
     connect(&registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, &registry] (const QByteArray &interfaceName, quint32 name, quint32 version) {
         if (interfaceName != "zkde_screencast_unstable_v1")
             return;
-        Q_ASSERT(version == 1);
+        Q_ASSERT(version == 3);
         m_screencast = new ScreencastV1(this);
         m_screencast->init(&*registry, name, version);
     });
@@ -175,6 +190,117 @@ void TestScreencastV1Interface::testCreate()
     QVERIFY(spyStop.count() || spyStop.wait());
 }
 
+void TestScreencastV1Interface::testFrameRequests()
+{
+    // this test verifies that frames are requested for damage only, at the maximum framerate
+    m_screencastInterface->setMaximumFramerate(10);
+    auto stream = m_screencast->createWindowStream("4");
+    QSignalSpy spyWorking(stream, &ScreencastStreamV1::created);
+    QVERIFY(spyWorking.wait());
+    QVERIFY(m_triggered);
+    QCOMPARE(m_triggered->cursorMode(), int(KWaylandServer::ScreencastV1Interface::Embedded));
+    QCOMPARE(m_triggered->maximumFramerate(), 10.0);
+
+    QSignalSpy frameSpy(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::frameRequested);
+    m_triggered->addDamage(QRect(0, 0, 10, 10));
+    m_triggered->addDamage(QRect(20, 0, 10, 10));
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.count(), 1);
+    QCOMPARE(frameSpy.first().first().value<QRegion>(), QRegion(0, 0, 10, 10) + QRegion(20, 0, 10, 10));
+
+    // the next frame waits for the frame interval
+    QElapsedTimer timer;
+    timer.start();
+    m_triggered->addDamage(QRect(0, 0, 5, 5));
+    QVERIFY(frameSpy.wait());
+    QVERIFY(timer.elapsed() >= 90);
+    QCOMPARE(frameSpy.last().first().value<QRegion>(), QRegion(0, 0, 5, 5));
+
+    // a cursor update doesn't damage anything
+    m_triggered->setMaximumFramerate(0);
+    m_triggered->addCursorUpdate();
+    QVERIFY(frameSpy.wait());
+    QVERIFY(frameSpy.last().first().value<QRegion>().isEmpty());
+
+    // nothing changed, no frame
+    QVERIFY(!frameSpy.wait(200));
+    QCOMPARE(frameSpy.count(), 3);
+
+    QSignalSpy spyStop(m_triggered, &KWaylandServer::ScreencastStreamV1Interface::finished);
+    stream->close();
+    QVERIFY(spyStop.wait());
+}
+
+void TestScreencastV1Interface::testRegion()
+{
+    // this test verifies that region streams only get the damage inside of the region
+    QSignalSpy requestedSpy(m_screencastInterface, &KWaylandServer::ScreencastV1Interface::regionScreencastRequested);
+    auto stream = m_screencast->createRegionStream(QRect(100, 100, 400, 300), 2);
+    QVERIFY(requestedSpy.wait());
+    auto streamInterface = requestedSpy.first().at(0).value<KWaylandServer::ScreencastStreamV1Interface *>();
+    QCOMPARE(requestedSpy.first().at(1).toRect(), QRect(100, 100, 400, 300));
+    QCOMPARE(requestedSpy.first().at(2).toReal(), 2.0);
+    QCOMPARE(requestedSpy.first().at(3).value<KWaylandServer::ScreencastV1Interface::CursorMode>(), KWaylandServer::ScreencastV1Interface::Metadata);
+    QCOMPARE(streamInterface->region(), QRect(100, 100, 400, 300));
+    QCOMPARE(streamInterface->scale(), 2.0);
+    streamInterface->sendCreated(124);
+    QSignalSpy spyWorking(stream, &ScreencastStreamV1::created);
+    QVERIFY(spyWorking.wait());
+
+    QSignalSpy frameSpy(streamInterface, &KWaylandServer::ScreencastStreamV1Interface::frameRequested);
+    streamInterface->setMaximumFramerate(0);
+    streamInterface->addDamage(QRect(0, 0, 50, 50));
+    QVERIFY(!frameSpy.wait(100));
+    streamInterface->addDamage(QRect(90, 90, 20, 20));
+    QVERIFY(frameSpy.wait());
+    QCOMPARE(frameSpy.first().first().value<QRegion>(), QRegion(0, 0, 10, 10));
+
+    QSignalSpy spyStop(streamInterface, &KWaylandServer::ScreencastStreamV1Interface::finished);
+    stream->close();
+    QVERIFY(spyStop.wait());
+}
+
+void TestScreencastV1Interface::testInvalidRegion()
+{
+    QSignalSpy requestedSpy(m_screencastInterface, &KWaylandServer::ScreencastV1Interface::regionScreencastRequested);
+    auto stream = m_screencast->createRegionStream(QRect(0, 0, 0, 300), 1);
+    QSignalSpy failedSpy(stream, &ScreencastStreamV1::failed);
+    QVERIFY(failedSpy.wait());
+    QVERIFY(requestedSpy.isEmpty());
+    stream->close();
+}
+
+void TestScreencastV1Interface::testWindowByUuid()
+{
+    // this test verifies that window streams get the window resolved by the window management
+    KWaylandServer::PlasmaWindowManagementInterface windowManagement(m_display);
+    m_screencastInterface->setWindowManagement(&windowManagement);
+    KWaylandServer::PlasmaWindowInterface *window = windowManagement.createWindow(this, QUuid::createUuid());
+    QSignalSpy uuidRequestedSpy(m_screencastInterface, &KWaylandServer::ScreencastV1Interface::windowScreencastRequested);
+    QSignalSpy requestedSpy(m_screencastInterface, &KWaylandServer::ScreencastV1Interface::plasmaWindowScreencastRequested);
+
+    auto stream = m_screencast->createWindowStream(QString::fromUtf8(window->uuid()));
+    QVERIFY(requestedSpy.wait());
+    auto streamInterface = requestedSpy.first().at(0).value<KWaylandServer::ScreencastStreamV1Interface *>();
+    QCOMPARE(requestedSpy.first().at(1).value<KWaylandServer::PlasmaWindowInterface *>(), window);
+    QCOMPARE(streamInterface->window(), window);
+    QVERIFY(uuidRequestedSpy.isEmpty());
+    QSignalSpy spyStop(streamInterface, &KWaylandServer::ScreencastStreamV1Interface::finished);
+    stream->close();
+    QVERIFY(spyStop.wait());
+
+    // an unknown window fails without asking the compositor
+    auto unknownStream = m_screencast->createWindowStream(QUuid::createUuid().toString());
+    QSignalSpy failedSpy(unknownStream, &ScreencastStreamV1::failed);
+    QVERIFY(failedSpy.wait());
+    QCOMPARE(requestedSpy.count(), 1);
+    QVERIFY(uuidRequestedSpy.isEmpty());
+    unknownStream->close();
+
+    delete window;
+    m_screencastInterface->setWindowManagement(nullptr);
+}
+
 QTEST_GUILESS_MAIN(TestScreencastV1Interface)
 
 #include "test_screencast.moc"
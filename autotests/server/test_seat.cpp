@@ -6,10 +6,13 @@
 // Qt
 #include <QtTest>
 // WaylandServer
+#include "../../src/server/abstract_data_source.h"
 #include "../../src/server/display.h"
 #include "../../src/server/pointer_interface.h"
 #include "../../src/server/seat_interface.h"
 
+#include <unistd.h>
+
 using namespace KWaylandServer;
 
 
@@ -23,10 +26,33 @@ private Q_SLOTS:
     void testPointerPos();
     void testRepeatInfo();
     void testMultiple();
+    void testFlushInputImmediately();
+    void testPrimarySelectionDebounce();
 };
 
 static const QString s_socketName = QStringLiteral("kwin-wayland-server-seat-test-0");
 
+class TestDataSource : public AbstractDataSource
+{
+    Q_OBJECT
+public:
+    void requestData(const QString &mimeType, qint32 fd) override
+    {
+        Q_UNUSED(mimeType)
+        close(fd);
+    }
+    void cancel() override
+    {
+        cancelled = true;
+    }
+    QStringList mimeTypes() const override
+    {
+        return {QStringLiteral("text/plain")};
+    }
+
+    bool cancelled = false;
+};
+
 void TestWaylandServerSeat::testCapabilities()
 {
     Display display;
@@ -203,6 +229,67 @@ void TestWaylandServerSeat::testMultiple()
     delete seat1;
     QCOMPARE(display.seats().count(), 0);
 }
+void TestWaylandServerSeat::testFlushInputImmediately()
+{
+    Display display;
+    display.addSocketName(s_socketName);
+    display.start();
+    SeatInterface *seat = new SeatInterface(&display);
+    seat->setHasPointer(true);
+    seat->setHasKeyboard(true);
+    QVERIFY(!seat->flushesInputImmediately());
+    seat->setFlushInputImmediately(true);
+    QVERIFY(seat->flushesInputImmediately());
+
+    // without a focused surface there is nothing to flush
+    seat->pointerButtonPressed(Qt::LeftButton);
+    QVERIFY(seat->isPointerButtonPressed(Qt::LeftButton));
+    seat->pointerButtonReleased(Qt::LeftButton);
+    QVERIFY(!seat->isPointerButtonPressed(Qt::LeftButton));
+
+    seat->setFlushInputImmediately(false);
+    QVERIFY(!seat->flushesInputImmediately());
+}
+
+void TestWaylandServerSeat::testPrimarySelectionDebounce()
+{
+    // this test verifies that only a primary selection which stays for the interval is announced
+    Display display;
+    display.addSocketName(s_socketName);
+    display.start();
+    SeatInterface *seat = new SeatInterface(&display, &display);
+    seat->setPrimarySelectionDebounceInterval(100);
+    QCOMPARE(seat->primarySelectionDebounceInterval(), 100);
+
+    QSignalSpy primarySelectionChangedSpy(seat, &SeatInterface::primarySelectionChanged);
+    QVERIFY(primarySelectionChangedSpy.isValid());
+
+    // every change restarts the interval
+    TestDataSource sources[4];
+    for (TestDataSource &source : sources) {
+        seat->setPrimarySelection(&source);
+        QTest::qWait(50);
+    }
+    QVERIFY(primarySelectionChangedSpy.isEmpty());
+    QVERIFY(sources[0].cancelled);
+    QVERIFY(sources[2].cancelled);
+    QVERIFY(!sources[3].cancelled);
+
+    QVERIFY(primarySelectionChangedSpy.wait());
+    QCOMPARE(primarySelectionChangedSpy.count(), 1);
+    QCOMPARE(primarySelectionChangedSpy.first().first().value<AbstractDataSource*>(), &sources[3]);
+
+    // disabling it announces a pending selection right away
+    seat->setPrimarySelection(nullptr);
+    QCOMPARE(primarySelectionChangedSpy.count(), 1);
+    seat->setPrimarySelectionDebounceInterval(0);
+    QCOMPARE(primarySelectionChangedSpy.count(), 2);
+    QVERIFY(!primarySelectionChangedSpy.last().first().value<AbstractDataSource*>());
+
+    seat->setPrimarySelection(&sources[0]);
+    QCOMPARE(primarySelectionChangedSpy.count(), 3);
+    seat->setPrimarySelection(nullptr);
+}
 
 QTEST_GUILESS_MAIN(TestWaylandServerSeat)
 #include "test_seat.moc"
@@ -83,12 +83,46 @@ public:
         surfaceApproximated[surface]++;
     }
 
+    void zwp_tablet_tool_v2_motion(wl_fixed_t /*x*/, wl_fixed_t /*y*/) override
+    {
+        events << QByteArrayLiteral("motion");
+    }
+
+    void zwp_tablet_tool_v2_down(uint32_t /*serial*/) override
+    {
+        events << QByteArrayLiteral("down");
+    }
+
+    void zwp_tablet_tool_v2_up() override
+    {
+        events << QByteArrayLiteral("up");
+    }
+
+    void zwp_tablet_tool_v2_pressure(uint32_t pressure) override
+    {
+        events << QByteArrayLiteral("pressure");
+        lastPressure = pressure;
+    }
+
+    void zwp_tablet_tool_v2_distance(uint32_t /*distance*/) override
+    {
+        events << QByteArrayLiteral("distance");
+    }
+
+    void zwp_tablet_tool_v2_tilt(wl_fixed_t /*tilt_x*/, wl_fixed_t /*tilt_y*/) override
+    {
+        events << QByteArrayLiteral("tilt");
+    }
+
     void zwp_tablet_tool_v2_frame(uint32_t time) override
     {
+        events << QByteArrayLiteral("frame");
         Q_EMIT frame(time);
     }
 
     QHash<struct ::wl_surface *, int> surfaceApproximated;
+    QVector<QByteArray> events;
+    quint32 lastPressure = 0;
 Q_SIGNALS:
     void frame(quint32 time);
 };
@@ -144,6 +178,7 @@ private Q_SLOTS:
     void testAddPad();
     void testInteractSimple();
     void testInteractSurfaceChange();
+    void testFrameBatch();
 
 private:
     KWayland::Client::ConnectionThread *m_connection;
@@ -266,6 +301,16 @@ void TestTabletInterface::testAdd()
     QVERIFY(m_tool);
     QVERIFY(toolSpy.wait() || toolSpy.count() == 1);
     QCOMPARE(m_tabletSeatClient->m_tools.count(), 1);
+    QCOMPARE(seatInterface->toolByHardwareId(0), m_tool);
+    QCOMPARE(seatInterface->toolByHardwareSerial(0), m_tool);
+
+    // the first tool added with an id is found
+    auto airbrush = seatInterface->addTool(TabletToolV2Interface::Airbrush, 0x100000001, 0, {});
+    QVERIFY(toolSpy.wait() || toolSpy.count() == 2);
+    QCOMPARE(seatInterface->toolByHardwareSerial(0x100000001), airbrush);
+    QCOMPARE(seatInterface->toolByHardwareId(0), m_tool);
+    QVERIFY(!seatInterface->toolByHardwareId(42));
+    QVERIFY(!seatInterface->toolByHardwareSerial(42));
 
     QVERIFY(!m_tool->isClientSupported()); //There's no surface in it yet
     m_tool->setCurrentSurface(nullptr);
@@ -351,5 +396,47 @@ void TestTabletInterface::testInteractSurfaceChange()
     QCOMPARE(m_tabletSeatClient->m_tools[0]->surfaceApproximated.count(), 2);
 }
 
+void TestTabletInterface::testFrameBatch()
+{
+    Tool *tool = m_tabletSeatClient->m_tools[0];
+    QSignalSpy frameSpy(tool, &Tool::frame);
+    m_tool->setCurrentSurface(m_surfaces[0]);
+    m_tool->sendProximityIn(m_tablet);
+    tool->events.clear();
+
+    // the first frame on a surface contains all axes the tool has
+    TabletToolV2Interface::ToolState state;
+    state.position = QPointF(1, 1);
+    state.pressure = 10;
+    state.distance = 5;
+    m_tool->sendFrameBatch(state, s_serial++);
+    QVERIFY(frameSpy.wait(500));
+    QCOMPARE(tool->events, QVector<QByteArray>({QByteArrayLiteral("motion"), QByteArrayLiteral("pressure"),
+                                                QByteArrayLiteral("tilt"), QByteArrayLiteral("frame")}));
+
+    // later frames only contain the changed axes
+    tool->events.clear();
+    state.down = true;
+    state.pressure = 20;
+    m_tool->sendFrameBatch(state, s_serial++);
+    QVERIFY(frameSpy.wait(500));
+    QCOMPARE(tool->events, QVector<QByteArray>({QByteArrayLiteral("down"), QByteArrayLiteral("pressure"),
+                                                QByteArrayLiteral("frame")}));
+    QCOMPARE(tool->lastPressure, 20u);
+
+    tool->events.clear();
+    m_tool->sendPressure(30);
+    state.pressure = 30;
+    state.down = false;
+    m_tool->sendFrameBatch(state, s_serial++);
+    QVERIFY(frameSpy.wait(500));
+    QCOMPARE(tool->events, QVector<QByteArray>({QByteArrayLiteral("pressure"), QByteArrayLiteral("up"),
+                                                QByteArrayLiteral("frame")}));
+
+    m_tool->sendProximityOut();
+    m_tool->sendFrame(s_serial++);
+    QVERIFY(frameSpy.wait(500));
+}
+
 QTEST_GUILESS_MAIN(TestTabletInterface)
 #include "test_tablet_interface.moc"
@@ -0,0 +1,142 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/tearingcontrol_v1_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/surface_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-tearing-control-v1.h"
+
+using namespace KWaylandServer;
+
+class TearingControlManager : public QtWayland::wp_tearing_control_manager_v1
+{
+};
+
+class TestTearingControlInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestTearingControlInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPresentationHint();
+
+private:
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+
+    QThread *m_thread;
+    Display m_display;
+    CompositorInterface *m_serverCompositor;
+    TearingControlManager *m_tearingControlManager = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-tearingcontrol-test-0");
+
+void TestTearingControlInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    new TearingControlManagerV1Interface(&m_display, this);
+    m_serverCompositor = new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("wp_tearing_control_manager_v1")) {
+            m_tearingControlManager = new TearingControlManager();
+            m_tearingControlManager->init(*registry, id, version);
+        }
+    });
+    QSignalSpy interfacesAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(interfacesAnnouncedSpy.wait());
+    QVERIFY(m_tearingControlManager);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(),
+                                                    compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+}
+
+TestTearingControlInterface::~TestTearingControlInterface()
+{
+    delete m_tearingControlManager;
+    m_tearingControlManager = nullptr;
+    if (m_queue) {
+        delete m_queue;
+        m_queue = nullptr;
+    }
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+void TestTearingControlInterface::testPresentationHint()
+{
+    QSignalSpy surfaceCreatedSpy(m_serverCompositor, &CompositorInterface::surfaceCreated);
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QVERIFY(surfaceCreatedSpy.wait());
+    auto surface = surfaceCreatedSpy.first().first().value<SurfaceInterface *>();
+    QCOMPARE(surface->presentationHint(), PresentationHint::VSync);
+
+    QSignalSpy presentationHintChangedSpy(surface, &SurfaceInterface::presentationHintChanged);
+    QtWayland::wp_tearing_control_v1 tearingControl(m_tearingControlManager->get_tearing_control(*clientSurface));
+
+    // the presentation hint is double-buffered
+    tearingControl.set_presentation_hint(QtWayland::wp_tearing_control_v1::presentation_hint_async);
+    m_connection->flush();
+    QVERIFY(!presentationHintChangedSpy.wait(100));
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(presentationHintChangedSpy.wait());
+    QCOMPARE(surface->presentationHint(), PresentationHint::Async);
+
+    // destroying the tearing control object reverts to vsync with the next commit
+    tearingControl.destroy();
+    clientSurface->commit(KWayland::Client::Surface::CommitFlag::None);
+    QVERIFY(presentationHintChangedSpy.wait());
+    QCOMPARE(surface->presentationHint(), PresentationHint::VSync);
+}
+
+QTEST_GUILESS_MAIN(TestTearingControlInterface)
+#include "test_tearingcontrol_v1_interface.moc"
@@ -11,6 +11,7 @@
 #include "../../src/server/display.h"
 #include "../../src/server/surface_interface.h"
 #include "../../src/server/seat_interface.h"
+#include "../../src/server/textinput_v2_interface.h"
 #include "../../src/server/textinput_v3_interface.h"
 
 #include "KWayland/Client/compositor.h"
@@ -250,6 +251,13 @@ void TestTextInputV3Interface::testEnableDisable()
     QCOMPARE(m_serverTextInputV3->surroundingTextCursorPosition(), 0);
     QCOMPARE(m_serverTextInputV3->surroundingTextSelectionAnchor(), 3);
 
+    // text input v2 of the seat uses the same state
+    TextInputV2Interface *serverTextInputV2 = m_seat->textInputV2();
+    QVERIFY(serverTextInputV2);
+    QCOMPARE(serverTextInputV2->cursorRectangle(), QRect(0, 0, 20, 20));
+    QCOMPARE(serverTextInputV2->surroundingText(), QString("KDE Plasma Desktop"));
+    QCOMPARE(serverTextInputV2->surroundingTextSelectionAnchor(), 3);
+
     // disabling we should not get the event
     m_clientTextInputV3->disable();
     QCOMPARE(textInputEnabledSpy.count(), 1);
@@ -162,6 +162,7 @@ void TestViewporterInterface::testCropScale()
     QCOMPARE(surfaceToBufferMatrixChangedSpy.count(), 1);
     QCOMPARE(serverSurface->size(), QSize(100, 50));
     QCOMPARE(serverSurface->mapToBuffer(QPointF(0, 0)), QPointF(0, 0));
+    QCOMPARE(serverSurface->bufferSourceBox(), QRect(0, 0, 200, 100));
 
     // Create a viewport for the surface.
     QScopedPointer<Viewport> clientViewport(new Viewport);
@@ -175,6 +176,7 @@ void TestViewporterInterface::testCropScale()
     QCOMPARE(surfaceToBufferMatrixChangedSpy.count(), 2);
     QCOMPARE(serverSurface->size(), QSize(30, 20));
     QCOMPARE(serverSurface->mapToBuffer(QPointF(0, 0)), QPointF(20, 20));
+    QCOMPARE(serverSurface->bufferSourceBox(), QRect(20, 20, 60, 40));
 
     // Scale the surface.
     clientViewport->set_destination(500, 250);
@@ -183,6 +185,7 @@ void TestViewporterInterface::testCropScale()
     QCOMPARE(surfaceToBufferMatrixChangedSpy.count(), 3);
     QCOMPARE(serverSurface->size(), QSize(500, 250));
     QCOMPARE(serverSurface->mapToBuffer(QPointF(0, 0)), QPointF(20, 20));
+    QCOMPARE(serverSurface->bufferSourceBox(), QRect(20, 20, 60, 40));
 
     // If the viewport is destroyed, the crop and scale state will be unset on a next commit.
     clientViewport->destroy();
@@ -191,6 +194,7 @@ void TestViewporterInterface::testCropScale()
     QCOMPARE(surfaceToBufferMatrixChangedSpy.count(), 4);
     QCOMPARE(serverSurface->size(), QSize(100, 50));
     QCOMPARE(serverSurface->mapToBuffer(QPointF(0, 0)), QPointF(0, 0));
+    QCOMPARE(serverSurface->bufferSourceBox(), QRect(0, 0, 200, 100));
 }
 
 QTEST_GUILESS_MAIN(TestViewporterInterface)
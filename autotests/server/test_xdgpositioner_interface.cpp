@@ -0,0 +1,252 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include <QThread>
+#include <QtTest>
+
+#include "../../src/server/compositor_interface.h"
+#include "../../src/server/display.h"
+#include "../../src/server/xdgshell_interface.h"
+
+#include "KWayland/Client/compositor.h"
+#include "KWayland/Client/connection_thread.h"
+#include "KWayland/Client/event_queue.h"
+#include "KWayland/Client/registry.h"
+#include "KWayland/Client/surface.h"
+
+#include "qwayland-xdg-shell.h"
+
+Q_DECLARE_METATYPE(KWaylandServer::XdgPopupInterface *)
+
+using namespace KWaylandServer;
+
+class XdgShell : public QtWayland::xdg_wm_base
+{
+public:
+    ~XdgShell() { destroy(); }
+};
+
+class XdgSurface : public QtWayland::xdg_surface
+{
+public:
+    ~XdgSurface() { destroy(); }
+};
+
+class XdgPositioner : public QtWayland::xdg_positioner
+{
+public:
+    ~XdgPositioner() { destroy(); }
+};
+
+class XdgPopup : public QtWayland::xdg_popup
+{
+public:
+    ~XdgPopup() { destroy(); }
+};
+
+class TestXdgPositionerInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~TestXdgPositionerInterface() override;
+
+private Q_SLOTS:
+    void initTestCase();
+    void testPlacement_data();
+    void testPlacement();
+    void testCachedPlacement();
+
+private:
+    KWaylandServer::XdgPositioner createPositioner(const QRect &anchorRect, uint32_t anchor, uint32_t gravity,
+                                                   const QPoint &offset, uint32_t constraintAdjustment);
+
+    KWayland::Client::ConnectionThread *m_connection;
+    KWayland::Client::EventQueue *m_queue;
+    KWayland::Client::Compositor *m_clientCompositor;
+
+    QThread *m_thread;
+    Display m_display;
+    XdgShell *m_clientXdgShell = nullptr;
+    XdgShellInterface *m_serverXdgShell = nullptr;
+};
+
+static const QString s_socketName = QStringLiteral("kwin-wayland-server-xdg-positioner-test-0");
+static const QSize s_popupSize(200, 100);
+static const QRect s_bounds(0, 0, 1000, 800);
+
+void TestXdgPositionerInterface::initTestCase()
+{
+    m_display.addSocketName(s_socketName);
+    m_display.start();
+    QVERIFY(m_display.isRunning());
+
+    m_serverXdgShell = new XdgShellInterface(&m_display, this);
+    new CompositorInterface(&m_display, this);
+
+    m_connection = new KWayland::Client::ConnectionThread;
+    QSignalSpy connectedSpy(m_connection, &KWayland::Client::ConnectionThread::connected);
+    m_connection->setSocketName(s_socketName);
+
+    m_thread = new QThread(this);
+    m_connection->moveToThread(m_thread);
+    m_thread->start();
+
+    m_connection->initConnection();
+    QVERIFY(connectedSpy.wait());
+
+    m_queue = new KWayland::Client::EventQueue(this);
+    m_queue->setup(m_connection);
+    QVERIFY(m_queue->isValid());
+
+    auto registry = new KWayland::Client::Registry(this);
+    connect(registry, &KWayland::Client::Registry::interfaceAnnounced, this, [this, registry](const QByteArray &interface, quint32 id, quint32 version) {
+        if (interface == QByteArrayLiteral("xdg_wm_base")) {
+            m_clientXdgShell = new XdgShell();
+            m_clientXdgShell->init(*registry, id, version);
+        }
+    });
+    QSignalSpy allAnnouncedSpy(registry, &KWayland::Client::Registry::interfacesAnnounced);
+    QSignalSpy compositorSpy(registry, &KWayland::Client::Registry::compositorAnnounced);
+    registry->setEventQueue(m_queue);
+    registry->create(m_connection->display());
+    QVERIFY(registry->isValid());
+    registry->setup();
+    QVERIFY(allAnnouncedSpy.wait());
+    QVERIFY(m_clientXdgShell);
+
+    m_clientCompositor = registry->createCompositor(compositorSpy.first().first().value<quint32>(),
+                                                    compositorSpy.first().last().value<quint32>(), this);
+    QVERIFY(m_clientCompositor->isValid());
+}
+
+TestXdgPositionerInterface::~TestXdgPositionerInterface()
+{
+    delete m_clientXdgShell;
+    m_clientXdgShell = nullptr;
+    delete m_queue;
+    m_queue = nullptr;
+    if (m_thread) {
+        m_thread->quit();
+        m_thread->wait();
+        delete m_thread;
+        m_thread = nullptr;
+    }
+    m_connection->deleteLater();
+    m_connection = nullptr;
+}
+
+KWaylandServer::XdgPositioner TestXdgPositionerInterface::createPositioner(const QRect &anchorRect, uint32_t anchor, uint32_t gravity,
+                                                                           const QPoint &offset, uint32_t constraintAdjustment)
+{
+    QSignalSpy popupCreatedSpy(m_serverXdgShell, &XdgShellInterface::popupCreated);
+
+    QScopedPointer<KWayland::Client::Surface> clientSurface(m_clientCompositor->createSurface(this));
+    QScopedPointer<XdgSurface> clientXdgSurface(new XdgSurface);
+    clientXdgSurface->init(m_clientXdgShell->get_xdg_surface(*clientSurface));
+
+    QScopedPointer<::XdgPositioner> positioner(new ::XdgPositioner);
+    positioner->init(m_clientXdgShell->create_positioner());
+    positioner->set_size(s_popupSize.width(), s_popupSize.height());
+    positioner->set_anchor_rect(anchorRect.x(), anchorRect.y(), anchorRect.width(), anchorRect.height());
+    positioner->set_anchor(anchor);
+    positioner->set_gravity(gravity);
+    positioner->set_offset(offset.x(), offset.y());
+    positioner->set_constraint_adjustment(constraintAdjustment);
+
+    QScopedPointer<XdgPopup> clientXdgPopup(new XdgPopup);
+    clientXdgPopup->init(clientXdgSurface->get_popup(nullptr, positioner->object()));
+    if (!popupCreatedSpy.wait()) {
+        return KWaylandServer::XdgPositioner();
+    }
+    // the popup keeps a copy of the state of the positioner
+    return popupCreatedSpy.last().first().value<XdgPopupInterface *>()->positioner();
+}
+
+void TestXdgPositionerInterface::testPlacement_data()
+{
+    QTest::addColumn<QRect>("parentGeometry");
+    QTest::addColumn<QRect>("anchorRect");
+    QTest::addColumn<uint32_t>("anchor");
+    QTest::addColumn<uint32_t>("gravity");
+    QTest::addColumn<QPoint>("offset");
+    QTest::addColumn<uint32_t>("constraintAdjustment");
+    QTest::addColumn<QRect>("placement");
+
+    using Positioner = QtWayland::xdg_positioner;
+    const uint32_t none = Positioner::constraint_adjustment_none;
+
+    QTest::newRow("below") << QRect(100, 100, 400, 300) << QRect(10, 10, 50, 20)
+                           << uint32_t(Positioner::anchor_bottom_left) << uint32_t(Positioner::gravity_bottom_right)
+                           << QPoint() << none << QRect(110, 130, 200, 100);
+    QTest::newRow("offset") << QRect(100, 100, 400, 300) << QRect(10, 10, 50, 20)
+                            << uint32_t(Positioner::anchor_bottom_left) << uint32_t(Positioner::gravity_bottom_right)
+                            << QPoint(5, 6) << none << QRect(115, 136, 200, 100);
+    QTest::newRow("centered") << QRect(100, 100, 400, 300) << QRect(10, 10, 50, 20)
+                              << uint32_t(Positioner::anchor_none) << uint32_t(Positioner::gravity_none)
+                              << QPoint() << none << QRect(35, 70, 200, 100);
+
+    // right of an anchor rect close to the right edge of the bounds
+    const QRect rightParent(700, 100, 400, 300);
+    const uint32_t right = Positioner::anchor_right;
+    const uint32_t gravityRight = Positioner::gravity_right;
+    QTest::newRow("constrained") << rightParent << QRect(250, 10, 50, 20) << right << gravityRight
+                                 << QPoint() << none << QRect(1000, 70, 200, 100);
+    QTest::newRow("flip x") << rightParent << QRect(250, 10, 50, 20) << right << gravityRight
+                            << QPoint() << uint32_t(Positioner::constraint_adjustment_flip_x) << QRect(750, 70, 200, 100);
+    QTest::newRow("slide x") << rightParent << QRect(250, 10, 50, 20) << right << gravityRight
+                             << QPoint() << uint32_t(Positioner::constraint_adjustment_slide_x) << QRect(800, 70, 200, 100);
+    QTest::newRow("resize x") << rightParent << QRect(150, 10, 50, 20) << right << gravityRight
+                              << QPoint() << uint32_t(Positioner::constraint_adjustment_resize_x) << QRect(900, 70, 100, 100);
+    // the flipped popup would be constrained on the left, so it slides instead
+    QTest::newRow("flip x falls back to slide") << QRect(100, 100, 400, 300) << QRect(-50, 10, 860, 20) << right << gravityRight
+                                                << QPoint() << uint32_t(Positioner::constraint_adjustment_flip_x | Positioner::constraint_adjustment_slide_x)
+                                                << QRect(800, 70, 200, 100);
+
+    QTest::newRow("flip y") << QRect(100, 600, 400, 300) << QRect(10, 100, 50, 20)
+                            << uint32_t(Positioner::anchor_bottom) << uint32_t(Positioner::gravity_bottom)
+                            << QPoint() << uint32_t(Positioner::constraint_adjustment_flip_y) << QRect(35, 600, 200, 100);
+    QTest::newRow("slide y") << QRect(100, 600, 400, 300) << QRect(10, 100, 50, 20)
+                             << uint32_t(Positioner::anchor_bottom) << uint32_t(Positioner::gravity_bottom)
+                             << QPoint() << uint32_t(Positioner::constraint_adjustment_slide_y) << QRect(35, 700, 200, 100);
+}
+
+void TestXdgPositionerInterface::testPlacement()
+{
+    QFETCH(QRect, parentGeometry);
+    QFETCH(QRect, anchorRect);
+    QFETCH(uint32_t, anchor);
+    QFETCH(uint32_t, gravity);
+    QFETCH(QPoint, offset);
+    QFETCH(uint32_t, constraintAdjustment);
+
+    const KWaylandServer::XdgPositioner positioner = createPositioner(anchorRect, anchor, gravity, offset, constraintAdjustment);
+    QVERIFY(positioner.isComplete());
+    QTEST(positioner.placement(parentGeometry, s_bounds), "placement");
+}
+
+void TestXdgPositionerInterface::testCachedPlacement()
+{
+    const KWaylandServer::XdgPositioner positioner = createPositioner(QRect(250, 10, 50, 20),
+                                                                      QtWayland::xdg_positioner::anchor_right,
+                                                                      QtWayland::xdg_positioner::gravity_right, QPoint(),
+                                                                      QtWayland::xdg_positioner::constraint_adjustment_slide_x);
+    QVERIFY(positioner.isComplete());
+    const QRect parentGeometry(700, 100, 400, 300);
+    QCOMPARE(positioner.placement(parentGeometry, s_bounds), QRect(800, 70, 200, 100));
+    // copies share the cached placement
+    const KWaylandServer::XdgPositioner copy = positioner;
+    QCOMPARE(copy.placement(parentGeometry, s_bounds), QRect(800, 70, 200, 100));
+
+    // other geometries are placed anew, e.g. when the parent of a reactive popup moved
+    QCOMPARE(copy.placement(parentGeometry.translated(-400, 0), s_bounds), QRect(600, 70, 200, 100));
+    QCOMPARE(positioner.placement(parentGeometry, QRect(0, 0, 2000, 800)), QRect(1000, 70, 200, 100));
+    QCOMPARE(positioner.placement(parentGeometry, s_bounds), QRect(800, 70, 200, 100));
+}
+
+QTEST_GUILESS_MAIN(TestXdgPositionerInterface)
+
+#include "test_xdgpositioner_interface.moc"
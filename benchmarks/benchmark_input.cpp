@@ -0,0 +1,130 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/keyboard_interface.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/surface_interface.h"
+
+#include "benchmarkclient.h"
+
+using namespace KWaylandServer;
+
+// events sent before the server is flushed
+static const int s_batchSize = 64;
+// evdev code of KEY_A
+static const quint32 s_key = 30;
+
+/**
+ * Measures how fast the seat sends pointer motion and key events to the focused surface of a
+ * client which bound a wl_pointer and a wl_keyboard.
+ **/
+class BenchmarkInput : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkPointerMotion();
+    void benchmarkKeyEvents();
+
+private:
+    Display m_display;
+    SeatInterface *m_seat = nullptr;
+    SurfaceInterface *m_serverSurface = nullptr;
+    BenchmarkClient *m_client = nullptr;
+    wl_compositor *m_compositor = nullptr;
+    wl_seat *m_clientSeat = nullptr;
+    wl_surface *m_surface = nullptr;
+    wl_pointer *m_pointer = nullptr;
+    wl_keyboard *m_keyboard = nullptr;
+};
+
+void BenchmarkInput::initTestCase()
+{
+    QVERIFY(m_display.start());
+    CompositorInterface *compositor = new CompositorInterface(&m_display, this);
+    connect(compositor, &CompositorInterface::surfaceCreated, this, [this](SurfaceInterface *surface) {
+        m_serverSurface = surface;
+    });
+    m_seat = new SeatInterface(&m_display, this);
+    m_seat->setHasPointer(true);
+    m_seat->setHasKeyboard(true);
+    m_seat->create();
+
+    m_client = new BenchmarkClient(&m_display);
+    QVERIFY(m_client->isValid());
+    m_compositor = m_client->bind<wl_compositor>(&wl_compositor_interface, 4);
+    m_clientSeat = m_client->bind<wl_seat>(&wl_seat_interface, 5);
+    QVERIFY(m_compositor);
+    QVERIFY(m_clientSeat);
+    m_client->observe(m_clientSeat);
+
+    m_surface = wl_compositor_create_surface(m_compositor);
+    m_client->observe(m_surface);
+    m_pointer = wl_seat_get_pointer(m_clientSeat);
+    m_client->observe(m_pointer);
+    m_keyboard = wl_seat_get_keyboard(m_clientSeat);
+    m_client->observe(m_keyboard);
+    QVERIFY(m_client->roundtrip());
+    QVERIFY(m_serverSurface);
+
+    m_seat->setFocusedPointerSurface(m_serverSurface);
+    m_seat->setFocusedKeyboardSurface(m_serverSurface);
+    QVERIFY(m_seat->focusedPointer());
+    QVERIFY(m_seat->keyboard());
+    m_client->pump();
+    m_client->takeEventCount();
+}
+
+void BenchmarkInput::cleanupTestCase()
+{
+    wl_keyboard_destroy(m_keyboard);
+    wl_pointer_destroy(m_pointer);
+    wl_surface_destroy(m_surface);
+    wl_seat_destroy(m_clientSeat);
+    wl_compositor_destroy(m_compositor);
+    delete m_client;
+    m_client = nullptr;
+}
+
+void BenchmarkInput::benchmarkPointerMotion()
+{
+    quint32 time = 0;
+    QBENCHMARK {
+        for (int i = 0; i < s_batchSize; ++i) {
+            m_seat->setTimestamp(++time);
+            m_seat->setPointerPos(QPointF(time % 2, 0));
+        }
+        m_client->dispatchServer();
+        m_client->dispatchClient();
+    }
+    QVERIFY(m_client->isValid());
+    QVERIFY(m_client->takeEventCount() > 0);
+}
+
+void BenchmarkInput::benchmarkKeyEvents()
+{
+    KeyboardInterface *keyboard = m_seat->keyboard();
+    quint32 time = 0;
+    QBENCHMARK {
+        for (int i = 0; i < s_batchSize; ++i) {
+            m_seat->setTimestamp(++time);
+            keyboard->keyPressed(s_key);
+            keyboard->keyReleased(s_key);
+        }
+        m_client->dispatchServer();
+        m_client->dispatchClient();
+    }
+    QVERIFY(m_client->isValid());
+    QVERIFY(m_client->takeEventCount() > 0);
+}
+
+QTEST_GUILESS_MAIN(BenchmarkInput)
+#include "benchmark_input.moc"
@@ -0,0 +1,149 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/surface_interface.h"
+
+#include "benchmarkclient.h"
+
+using namespace KWaylandServer;
+
+// requests written before the server dispatches them
+static const int s_batchSize = 64;
+
+/**
+ * Measures the server side of wl_surface commits, buffer attaches and frame callbacks of a
+ * single surface.
+ **/
+class BenchmarkSurface : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkCommit();
+    void benchmarkAttach();
+    void benchmarkFrameCallbacks();
+
+private:
+    Display m_display;
+    CompositorInterface *m_compositor = nullptr;
+    SurfaceInterface *m_serverSurface = nullptr;
+    BenchmarkClient *m_client = nullptr;
+    wl_compositor *m_clientCompositor = nullptr;
+    wl_shm *m_shm = nullptr;
+    wl_surface *m_surface = nullptr;
+    wl_buffer *m_buffers[2] = {nullptr, nullptr};
+};
+
+void BenchmarkSurface::initTestCase()
+{
+    QVERIFY(m_display.start());
+    m_display.createShm();
+    m_compositor = new CompositorInterface(&m_display, this);
+    connect(m_compositor, &CompositorInterface::surfaceCreated, this, [this](SurfaceInterface *surface) {
+        m_serverSurface = surface;
+    });
+
+    m_client = new BenchmarkClient(&m_display);
+    QVERIFY(m_client->isValid());
+    m_clientCompositor = m_client->bind<wl_compositor>(&wl_compositor_interface, 4);
+    m_shm = m_client->bind<wl_shm>(&wl_shm_interface, 1);
+    QVERIFY(m_clientCompositor);
+    QVERIFY(m_shm);
+    m_client->observe(m_shm);
+
+    m_surface = wl_compositor_create_surface(m_clientCompositor);
+    m_client->observe(m_surface);
+    for (wl_buffer *&buffer : m_buffers) {
+        buffer = m_client->createShmBuffer(m_shm, QSize(64, 64));
+        QVERIFY(buffer);
+        m_client->observe(buffer);
+    }
+    wl_surface_attach(m_surface, m_buffers[0], 0, 0);
+    wl_surface_damage(m_surface, 0, 0, 64, 64);
+    wl_surface_commit(m_surface);
+    QVERIFY(m_client->roundtrip());
+    QVERIFY(m_serverSurface);
+    QCOMPARE(m_serverSurface->size(), QSize(64, 64));
+}
+
+void BenchmarkSurface::cleanupTestCase()
+{
+    for (wl_buffer *buffer : m_buffers) {
+        wl_buffer_destroy(buffer);
+    }
+    wl_surface_destroy(m_surface);
+    wl_shm_destroy(m_shm);
+    wl_compositor_destroy(m_clientCompositor);
+    delete m_client;
+    m_client = nullptr;
+}
+
+void BenchmarkSurface::benchmarkCommit()
+{
+    QBENCHMARK {
+        for (int i = 0; i < s_batchSize; ++i) {
+            wl_surface_damage(m_surface, i % 64, 0, 1, 1);
+            wl_surface_commit(m_surface);
+        }
+        m_client->pump();
+    }
+    QVERIFY(m_client->isValid());
+}
+
+void BenchmarkSurface::benchmarkAttach()
+{
+    // every attach releases the other buffer
+    int index = 0;
+    QBENCHMARK {
+        for (int i = 0; i < s_batchSize; ++i) {
+            index = 1 - index;
+            wl_surface_attach(m_surface, m_buffers[index], 0, 0);
+            wl_surface_damage(m_surface, 0, 0, 64, 64);
+            wl_surface_commit(m_surface);
+        }
+        m_client->pump();
+    }
+    QVERIFY(m_client->isValid());
+}
+
+static void frameDone(void *data, wl_callback *callback, uint32_t time)
+{
+    Q_UNUSED(time)
+    ++*static_cast<int *>(data);
+    wl_callback_destroy(callback);
+}
+
+static const wl_callback_listener s_frameListener = {
+    frameDone
+};
+
+void BenchmarkSurface::benchmarkFrameCallbacks()
+{
+    int requested = 0;
+    int done = 0;
+    quint32 time = 0;
+    QBENCHMARK {
+        for (int i = 0; i < s_batchSize; ++i) {
+            wl_callback_add_listener(wl_surface_frame(m_surface), &s_frameListener, &done);
+            wl_surface_commit(m_surface);
+        }
+        requested += s_batchSize;
+        m_client->pump();
+        m_serverSurface->frameRendered(++time);
+        m_client->dispatchServer();
+        m_client->dispatchClient();
+    }
+    QVERIFY(m_client->isValid());
+    QCOMPARE(done, requested);
+}
+
+QTEST_GUILESS_MAIN(BenchmarkSurface)
+#include "benchmark_surface.moc"
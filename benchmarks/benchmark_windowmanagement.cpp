@@ -0,0 +1,178 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QtTest>
+// WaylandServer
+#include "../src/server/display.h"
+#include "../src/server/plasmawindowmanagement_interface.h"
+
+#include "benchmarkclient.h"
+
+#include "wayland-plasma-window-management-client-protocol.h"
+
+#include <cstring>
+
+using namespace KWaylandServer;
+
+// e.g. a task manager, a pager and a few applets
+static const int s_clientCount = 8;
+static const int s_windowCount = 32;
+
+/**
+ * Measures the broadcasts of the plasma window management to clients which have created an
+ * org_kde_plasma_window for every window, as plasmashell does.
+ **/
+class BenchmarkWindowManagement : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void benchmarkTitleChange();
+    void benchmarkGeometryChange();
+    void benchmarkWindowCreation();
+
+private:
+    void dispatchAll();
+
+    Display m_display;
+    PlasmaWindowManagementInterface *m_windowManagement = nullptr;
+    QVector<PlasmaWindowInterface *> m_windows;
+    QVector<BenchmarkClient *> m_clients;
+    QVector<org_kde_plasma_window_management *> m_clientWindowManagements;
+    BenchmarkClient::EventHandler m_windowManagementHandler;
+    BenchmarkClient::EventHandler m_windowHandler;
+};
+
+void BenchmarkWindowManagement::initTestCase()
+{
+    QVERIFY(m_display.start());
+    m_windowManagement = new PlasmaWindowManagementInterface(&m_display, this);
+    for (int i = 0; i < s_windowCount; ++i) {
+        m_windows << m_windowManagement->createWindow(this, QUuid::createUuid());
+    }
+
+    // every announced window is requested, and released again once it's unmapped
+    m_windowManagementHandler = [this](void *proxy, uint32_t opcode, const wl_message *message, const wl_argument *arguments) {
+        Q_UNUSED(opcode)
+        auto windowManagement = static_cast<org_kde_plasma_window_management *>(proxy);
+        BenchmarkClient *client = static_cast<BenchmarkClient *>(org_kde_plasma_window_management_get_user_data(windowManagement));
+        org_kde_plasma_window *window = nullptr;
+        if (std::strcmp(message->name, "window_with_uuid") == 0) {
+            window = org_kde_plasma_window_management_get_window_by_uuid(windowManagement, arguments[1].s);
+        } else if (std::strcmp(message->name, "window") == 0) {
+            window = org_kde_plasma_window_management_get_window(windowManagement, arguments[0].u);
+        }
+        if (window) {
+            client->observe(window, &m_windowHandler);
+        }
+    };
+    m_windowHandler = [](void *proxy, uint32_t opcode, const wl_message *message, const wl_argument *arguments) {
+        Q_UNUSED(opcode)
+        Q_UNUSED(arguments)
+        // the server destroys the resource right after, so only the proxy goes away
+        if (std::strcmp(message->name, "unmapped") == 0) {
+            wl_proxy_destroy(static_cast<wl_proxy *>(proxy));
+        }
+    };
+
+    for (int i = 0; i < s_clientCount; ++i) {
+        BenchmarkClient *client = new BenchmarkClient(&m_display);
+        QVERIFY(client->isValid());
+        auto windowManagement = client->bind<org_kde_plasma_window_management>(&org_kde_plasma_window_management_interface, 13);
+        QVERIFY(windowManagement);
+        client->observe(windowManagement, &m_windowManagementHandler);
+        // after observe(), adding the dispatcher resets the user data
+        org_kde_plasma_window_management_set_user_data(windowManagement, client);
+        m_clients << client;
+        m_clientWindowManagements << windowManagement;
+    }
+    // the second round trip delivers the initial state of the requested windows
+    for (BenchmarkClient *client : qAsConst(m_clients)) {
+        QVERIFY(client->roundtrip());
+        QVERIFY(client->roundtrip());
+        QVERIFY(client->takeEventCount() > quint64(s_windowCount));
+    }
+}
+
+void BenchmarkWindowManagement::cleanupTestCase()
+{
+    qDeleteAll(m_windows);
+    m_windows.clear();
+    dispatchAll();
+    for (org_kde_plasma_window_management *windowManagement : qAsConst(m_clientWindowManagements)) {
+        org_kde_plasma_window_management_destroy(windowManagement);
+    }
+    qDeleteAll(m_clients);
+    m_clients.clear();
+}
+
+void BenchmarkWindowManagement::dispatchAll()
+{
+    for (BenchmarkClient *client : qAsConst(m_clients)) {
+        client->pump();
+    }
+    // the requests the events triggered, e.g. for new windows
+    for (BenchmarkClient *client : qAsConst(m_clients)) {
+        client->pump();
+    }
+}
+
+void BenchmarkWindowManagement::benchmarkTitleChange()
+{
+    int round = 0;
+    QBENCHMARK {
+        const QString title = QStringLiteral("Window title %1").arg(++round % 2);
+        for (PlasmaWindowInterface *window : qAsConst(m_windows)) {
+            window->setTitle(title);
+        }
+        m_clients.first()->dispatchServer();
+        for (BenchmarkClient *client : qAsConst(m_clients)) {
+            client->dispatchClient();
+        }
+    }
+    for (BenchmarkClient *client : qAsConst(m_clients)) {
+        QVERIFY(client->isValid());
+        QVERIFY(client->takeEventCount() > 0);
+    }
+}
+
+void BenchmarkWindowManagement::benchmarkGeometryChange()
+{
+    int round = 0;
+    QBENCHMARK {
+        const QRect geometry(0, 0, 100 + ++round % 2, 100);
+        for (PlasmaWindowInterface *window : qAsConst(m_windows)) {
+            window->setGeometry(geometry);
+        }
+        m_clients.first()->dispatchServer();
+        for (BenchmarkClient *client : qAsConst(m_clients)) {
+            client->dispatchClient();
+        }
+    }
+    for (BenchmarkClient *client : qAsConst(m_clients)) {
+        QVERIFY(client->isValid());
+        QVERIFY(client->takeEventCount() > 0);
+    }
+}
+
+void BenchmarkWindowManagement::benchmarkWindowCreation()
+{
+    QBENCHMARK {
+        PlasmaWindowInterface *window = m_windowManagement->createWindow(this, QUuid::createUuid());
+        window->setTitle(QStringLiteral("Transient window"));
+        m_clients.first()->dispatchServer();
+        dispatchAll();
+        delete window;
+        dispatchAll();
+    }
+    for (BenchmarkClient *client : qAsConst(m_clients)) {
+        QVERIFY(client->isValid());
+    }
+}
+
+QTEST_GUILESS_MAIN(BenchmarkWindowManagement)
+#include "benchmark_windowmanagement.moc"
@@ -0,0 +1,209 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "benchmarkclient.h"
+
+#include "../src/server/display.h"
+
+#include <QtGlobal>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+static const wl_registry_listener s_registryListener = {
+    BenchmarkClient::registryGlobal,
+    BenchmarkClient::registryGlobalRemove
+};
+
+BenchmarkClient::BenchmarkClient(Display *server)
+    : m_server(server)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+        return;
+    }
+    m_connection = m_server->createClient(sv[0]);
+    if (!m_connection) {
+        close(sv[1]);
+        return;
+    }
+    m_display = wl_display_connect_to_fd(sv[1]);
+    if (!m_display) {
+        return;
+    }
+    m_registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(m_registry, &s_registryListener, this);
+    roundtrip();
+}
+
+BenchmarkClient::~BenchmarkClient()
+{
+    if (!m_display) {
+        return;
+    }
+    if (m_registry) {
+        wl_registry_destroy(m_registry);
+    }
+    wl_display_disconnect(m_display);
+    // let the server notice the hang up
+    dispatchServer();
+}
+
+bool BenchmarkClient::isValid() const
+{
+    return m_display && !m_globals.isEmpty() && wl_display_get_error(m_display) == 0;
+}
+
+wl_display *BenchmarkClient::display() const
+{
+    return m_display;
+}
+
+ClientConnection *BenchmarkClient::connection() const
+{
+    return m_connection;
+}
+
+void BenchmarkClient::registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    Q_UNUSED(registry)
+    static_cast<BenchmarkClient *>(data)->m_globals.append({name, QByteArray(interface), version});
+}
+
+void BenchmarkClient::registryGlobalRemove(void *data, wl_registry *registry, uint32_t name)
+{
+    Q_UNUSED(registry)
+    QVector<Global> &globals = static_cast<BenchmarkClient *>(data)->m_globals;
+    for (auto it = globals.begin(); it != globals.end(); ++it) {
+        if (it->name == name) {
+            globals.erase(it);
+            return;
+        }
+    }
+}
+
+void *BenchmarkClient::bindGlobal(const wl_interface *interface, quint32 version)
+{
+    for (const Global &global : qAsConst(m_globals)) {
+        if (global.interface == interface->name) {
+            return wl_registry_bind(m_registry, global.name, interface, qMin(version, global.version));
+        }
+    }
+    return nullptr;
+}
+
+void BenchmarkClient::observe(void *proxy, const EventHandler *handler)
+{
+    Observer *&observer = m_observersByHandler[handler];
+    if (!observer) {
+        m_observers.push_back({this, handler});
+        observer = &m_observers.back();
+    }
+    wl_proxy_add_dispatcher(static_cast<wl_proxy *>(proxy), dispatchEvent, observer, nullptr);
+}
+
+int BenchmarkClient::dispatchEvent(const void *implementation, void *target, uint32_t opcode, const wl_message *message, wl_argument *arguments)
+{
+    const Observer *observer = static_cast<const Observer *>(implementation);
+    observer->client->m_eventCount++;
+    if (observer->handler && *observer->handler) {
+        (*observer->handler)(target, opcode, message, arguments);
+    }
+    // the signature starts with the version, nullable arguments are prefixed with a '?'
+    int index = 0;
+    for (const char *type = message->signature; *type; ++type) {
+        if (*type == '?' || (*type >= '0' && *type <= '9')) {
+            continue;
+        }
+        if (*type == 'h') {
+            close(arguments[index].h);
+        }
+        ++index;
+    }
+    return 0;
+}
+
+quint64 BenchmarkClient::takeEventCount()
+{
+    const quint64 count = m_eventCount;
+    m_eventCount = 0;
+    return count;
+}
+
+wl_buffer *BenchmarkClient::createShmBuffer(wl_shm *shm, const QSize &size)
+{
+    const int stride = size.width() * 4;
+    const int bytes = stride * size.height();
+    const int fd = memfd_create("kwaylandserver-benchmark-buffer", MFD_CLOEXEC);
+    if (fd == -1) {
+        return nullptr;
+    }
+    if (ftruncate(fd, bytes) < 0) {
+        close(fd);
+        return nullptr;
+    }
+    wl_shm_pool *pool = wl_shm_create_pool(shm, fd, bytes);
+    wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0, size.width(), size.height(), stride, WL_SHM_FORMAT_ARGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+    return buffer;
+}
+
+void BenchmarkClient::dispatchServer()
+{
+    m_server->dispatchEvents();
+    // what runs before the Qt event loop blocks, e.g. coalesced pointer motion goes out
+    m_server->flush();
+}
+
+void BenchmarkClient::dispatchClient()
+{
+    while (wl_display_prepare_read(m_display) != 0) {
+        if (wl_display_dispatch_pending(m_display) < 0) {
+            return;
+        }
+    }
+    pollfd pfd = {wl_display_get_fd(m_display), POLLIN, 0};
+    if (poll(&pfd, 1, 0) > 0) {
+        wl_display_read_events(m_display);
+    } else {
+        wl_display_cancel_read(m_display);
+    }
+    wl_display_dispatch_pending(m_display);
+}
+
+void BenchmarkClient::pump()
+{
+    wl_display_flush(m_display);
+    dispatchServer();
+    dispatchClient();
+}
+
+static void syncDone(void *data, wl_callback *callback, uint32_t serial)
+{
+    Q_UNUSED(callback)
+    Q_UNUSED(serial)
+    *static_cast<bool *>(data) = true;
+}
+
+static const wl_callback_listener s_syncListener = {
+    syncDone
+};
+
+bool BenchmarkClient::roundtrip()
+{
+    bool done = false;
+    wl_callback *callback = wl_display_sync(m_display);
+    wl_callback_add_listener(callback, &s_syncListener, &done);
+    for (int i = 0; i < 16 && !done && wl_display_get_error(m_display) == 0; ++i) {
+        pump();
+    }
+    wl_callback_destroy(callback);
+    return done;
+}
@@ -0,0 +1,122 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_BENCHMARKCLIENT_H
+#define KWAYLAND_SERVER_BENCHMARKCLIENT_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QSize>
+#include <QVector>
+
+#include <wayland-client.h>
+
+#include <deque>
+#include <functional>
+
+namespace KWaylandServer
+{
+class ClientConnection;
+class Display;
+}
+
+/**
+ * A plain libwayland-client connection to a Display of the same process, over a socket pair
+ * handed to Display::createClient(). Neither end runs an event loop: pump() flushes the
+ * requests, lets the server dispatch them, flushes the server and dispatches the events the
+ * client got, so every iteration of a benchmark does the same work.
+ *
+ * The client has no protocol code of its own, observe() counts the events of an object and
+ * passes them to an optional handler.
+ **/
+class BenchmarkClient
+{
+public:
+    typedef std::function<void(void *proxy, uint32_t opcode, const wl_message *message, const wl_argument *arguments)> EventHandler;
+
+    explicit BenchmarkClient(KWaylandServer::Display *server);
+    ~BenchmarkClient();
+
+    /**
+     * @returns whether the connection is up and the globals were announced
+     **/
+    bool isValid() const;
+    wl_display *display() const;
+    KWaylandServer::ClientConnection *connection() const;
+
+    /**
+     * Binds the global of @p interface, @c nullptr if the server has none. The version is
+     * capped to the one the server announced.
+     **/
+    template<typename T>
+    T *bind(const wl_interface *interface, quint32 version)
+    {
+        return static_cast<T *>(bindGlobal(interface, version));
+    }
+
+    /**
+     * Counts the events sent to @p proxy and passes them to @p handler, which has to outlive
+     * the proxy. File descriptors in the events are closed after the handler returns.
+     *
+     * All proxies observed with the same handler share its dispatcher, so objects created
+     * while a benchmark runs don't add up.
+     **/
+    void observe(void *proxy, const EventHandler *handler = nullptr);
+    /**
+     * @returns the number of events received by the observed objects and resets it
+     **/
+    quint64 takeEventCount();
+
+    /**
+     * Creates a wl_buffer of @p size in ARGB8888 backed by a memfd.
+     **/
+    wl_buffer *createShmBuffer(wl_shm *shm, const QSize &size);
+
+    /**
+     * Dispatches the requests the server received and flushes the Display.
+     **/
+    void dispatchServer();
+    /**
+     * Reads and dispatches the events waiting on the socket of the client, without blocking.
+     **/
+    void dispatchClient();
+    /**
+     * Flushes the client, then dispatchServer() followed by dispatchClient().
+     **/
+    void pump();
+    /**
+     * Pumps until the server answered a wl_display.sync issued now.
+     **/
+    bool roundtrip();
+
+    static void registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+    static void registryGlobalRemove(void *data, wl_registry *registry, uint32_t name);
+
+private:
+    struct Global {
+        quint32 name;
+        QByteArray interface;
+        quint32 version;
+    };
+    struct Observer {
+        BenchmarkClient *client;
+        const EventHandler *handler;
+    };
+
+    void *bindGlobal(const wl_interface *interface, quint32 version);
+    static int dispatchEvent(const void *implementation, void *target, uint32_t opcode, const wl_message *message, wl_argument *arguments);
+
+    KWaylandServer::Display *m_server;
+    KWaylandServer::ClientConnection *m_connection = nullptr;
+    wl_display *m_display = nullptr;
+    wl_registry *m_registry = nullptr;
+    QVector<Global> m_globals;
+    // the dispatchers point at the observers, so the elements must not move
+    std::deque<Observer> m_observers;
+    QHash<const EventHandler *, Observer *> m_observersByHandler;
+    quint64 m_eventCount = 0;
+};
+
+#endif
@@ -0,0 +1,738 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QSize>
+#include <QTimer>
+#include <QVector>
+// WaylandServer
+#include "../src/server/compositor_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/plasmawindowmanagement_interface.h"
+#include "../src/server/subcompositor_interface.h"
+#include "../src/server/surface_interface.h"
+#include "../src/server/xdgshell_interface.h"
+// Wayland
+#include <wayland-client.h>
+
+#include "wayland-plasma-window-management-client-protocol.h"
+#include "wayland-xdg-shell-client-protocol.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <deque>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+using namespace KWaylandServer;
+
+/**
+ * Starts a Display with the globals of a desktop shell and connects hundreds of protocol
+ * clients to it over socket pairs. The clients run in forked worker processes without Qt, so
+ * the CPU time and the resident memory sampled in this process belong to the server alone.
+ *
+ * Every client maps a toplevel with a few sub-surfaces backed by shm buffers, binds the
+ * plasma window management like a task manager, and commits new buffers at a fixed rate. A
+ * wl_display.sync follows each commit, the time until it is answered is the latency of the
+ * client. The server completes the frame callbacks of all surfaces at the refresh rate and
+ * announces every toplevel as a plasma window.
+ **/
+
+struct Options {
+    int clients = 100;
+    int processes = 4;
+    // commits of each client per second
+    int rate = 30;
+    int subsurfaces = 2;
+    int duration = 10;
+    int refreshRate = 60;
+    QSize bufferSize = QSize(64, 64);
+};
+
+// what a worker reports for each of its clients once it is stopped
+struct ClientReport {
+    quint32 commits;
+    quint32 samples;
+    double meanLatency;
+    double p99Latency;
+    double maxLatency;
+    bool failed;
+};
+
+static qint64 monotonicUsecs()
+{
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return qint64(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+static int ignoreEvent(const void *implementation, void *target, uint32_t opcode, const wl_message *message, wl_argument *arguments)
+{
+    Q_UNUSED(implementation)
+    Q_UNUSED(target)
+    Q_UNUSED(opcode)
+    Q_UNUSED(message)
+    Q_UNUSED(arguments)
+    return 0;
+}
+
+/**
+ * One protocol client of a worker process, driven by the poll loop of the worker.
+ **/
+class LoadClient
+{
+public:
+    LoadClient(int fd, const Options &options, qint64 start);
+    ~LoadClient();
+
+    bool isValid() const;
+    int fd() const;
+    qint64 nextCommit() const;
+    void commit();
+    void dispatch();
+    void flush();
+    ClientReport report() const;
+
+    static void registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version);
+    static void registryGlobalRemove(void *data, wl_registry *registry, uint32_t name);
+    static void ping(void *data, xdg_wm_base *shell, uint32_t serial);
+    static void surfaceConfigure(void *data, xdg_surface *surface, uint32_t serial);
+    static void toplevelConfigure(void *data, xdg_toplevel *toplevel, int32_t width, int32_t height, wl_array *states);
+    static void toplevelClose(void *data, xdg_toplevel *toplevel);
+    static void syncDone(void *data, wl_callback *callback, uint32_t serial);
+
+private:
+    wl_buffer *createBuffer();
+    bool roundtrip();
+
+    const Options &m_options;
+    wl_display *m_display = nullptr;
+    wl_registry *m_registry = nullptr;
+    wl_compositor *m_compositor = nullptr;
+    wl_subcompositor *m_subcompositor = nullptr;
+    wl_shm *m_shm = nullptr;
+    xdg_wm_base *m_shell = nullptr;
+    org_kde_plasma_window_management *m_windowManagement = nullptr;
+
+    wl_surface *m_surface = nullptr;
+    xdg_surface *m_xdgSurface = nullptr;
+    xdg_toplevel *m_toplevel = nullptr;
+    std::vector<wl_surface *> m_childSurfaces;
+    std::vector<wl_subsurface *> m_subsurfaces;
+    // committed alternately, the server releases the other one meanwhile
+    wl_buffer *m_buffers[2] = {nullptr, nullptr};
+    int m_bufferIndex = 0;
+    bool m_configured = false;
+
+    qint64 m_nextCommit;
+    qint64 m_interval;
+    quint32 m_commits = 0;
+    // the send time of each sync that wasn't answered yet
+    std::deque<qint64> m_pendingSyncs;
+    std::vector<quint32> m_latencies;
+};
+
+static const wl_registry_listener s_registryListener = {
+    LoadClient::registryGlobal,
+    LoadClient::registryGlobalRemove,
+};
+
+static const xdg_wm_base_listener s_shellListener = {
+    LoadClient::ping,
+};
+
+static const xdg_surface_listener s_xdgSurfaceListener = {
+    LoadClient::surfaceConfigure,
+};
+
+static const xdg_toplevel_listener s_toplevelListener = {
+    LoadClient::toplevelConfigure,
+    LoadClient::toplevelClose,
+};
+
+static const wl_callback_listener s_syncListener = {
+    LoadClient::syncDone,
+};
+
+static const wl_buffer_listener s_bufferListener = {
+    [](void *data, wl_buffer *buffer) {
+        Q_UNUSED(data)
+        Q_UNUSED(buffer)
+    },
+};
+
+LoadClient::LoadClient(int fd, const Options &options, qint64 start)
+    : m_options(options)
+    , m_interval(1000000 / std::max(options.rate, 1))
+{
+    // spread the commits of the clients over the interval
+    m_nextCommit = start + (qint64(fd) * 7919) % m_interval;
+
+    m_display = wl_display_connect_to_fd(fd);
+    if (!m_display) {
+        return;
+    }
+    m_registry = wl_display_get_registry(m_display);
+    wl_registry_add_listener(m_registry, &s_registryListener, this);
+    if (!roundtrip() || !m_compositor || !m_subcompositor || !m_shm || !m_shell) {
+        return;
+    }
+    xdg_wm_base_add_listener(m_shell, &s_shellListener, this);
+    if (m_windowManagement) {
+        // the windows are only counted by the server, the events don't matter here
+        wl_proxy_add_dispatcher(reinterpret_cast<wl_proxy *>(m_windowManagement), ignoreEvent, nullptr, nullptr);
+    }
+
+    for (wl_buffer *&buffer : m_buffers) {
+        buffer = createBuffer();
+        if (!buffer) {
+            return;
+        }
+        wl_buffer_add_listener(buffer, &s_bufferListener, this);
+    }
+
+    m_surface = wl_compositor_create_surface(m_compositor);
+    m_xdgSurface = xdg_wm_base_get_xdg_surface(m_shell, m_surface);
+    xdg_surface_add_listener(m_xdgSurface, &s_xdgSurfaceListener, this);
+    m_toplevel = xdg_surface_get_toplevel(m_xdgSurface);
+    xdg_toplevel_add_listener(m_toplevel, &s_toplevelListener, this);
+    xdg_toplevel_set_title(m_toplevel, "load generator");
+    xdg_toplevel_set_app_id(m_toplevel, "org.kde.kwaylandserver.loadgenerator");
+
+    for (int i = 0; i < m_options.subsurfaces; ++i) {
+        wl_surface *child = wl_compositor_create_surface(m_compositor);
+        wl_subsurface *subsurface = wl_subcompositor_get_subsurface(m_subcompositor, child, m_surface);
+        wl_subsurface_set_position(subsurface, 8 * (i + 1), 8 * (i + 1));
+        wl_subsurface_set_desync(subsurface);
+        wl_surface_attach(child, m_buffers[0], 0, 0);
+        wl_surface_damage(child, 0, 0, m_options.bufferSize.width(), m_options.bufferSize.height());
+        wl_surface_commit(child);
+        m_childSurfaces.push_back(child);
+        m_subsurfaces.push_back(subsurface);
+    }
+    // the initial commit without a buffer asks for the first configure
+    wl_surface_commit(m_surface);
+    roundtrip();
+}
+
+LoadClient::~LoadClient()
+{
+    if (!m_display) {
+        return;
+    }
+    // the server hangs up on all clients at once when the worker exits, only the client side
+    // memory is released here
+    wl_display_disconnect(m_display);
+}
+
+bool LoadClient::isValid() const
+{
+    return m_display && m_surface && wl_display_get_error(m_display) == 0;
+}
+
+int LoadClient::fd() const
+{
+    return wl_display_get_fd(m_display);
+}
+
+qint64 LoadClient::nextCommit() const
+{
+    return m_nextCommit;
+}
+
+wl_buffer *LoadClient::createBuffer()
+{
+    const int stride = m_options.bufferSize.width() * 4;
+    const int bytes = stride * m_options.bufferSize.height();
+    const int fd = memfd_create("kwaylandserver-loadgenerator", MFD_CLOEXEC);
+    if (fd == -1) {
+        return nullptr;
+    }
+    if (ftruncate(fd, bytes) < 0) {
+        close(fd);
+        return nullptr;
+    }
+    wl_shm_pool *pool = wl_shm_create_pool(m_shm, fd, bytes);
+    wl_buffer *buffer = wl_shm_pool_create_buffer(pool, 0, m_options.bufferSize.width(), m_options.bufferSize.height(),
+                                                  stride, WL_SHM_FORMAT_ARGB8888);
+    wl_shm_pool_destroy(pool);
+    close(fd);
+    return buffer;
+}
+
+bool LoadClient::roundtrip()
+{
+    return wl_display_roundtrip(m_display) >= 0;
+}
+
+void LoadClient::commit()
+{
+    m_nextCommit += m_interval;
+    if (!m_configured) {
+        return;
+    }
+    m_bufferIndex = 1 - m_bufferIndex;
+    const QSize size = m_options.bufferSize;
+    for (wl_surface *child : m_childSurfaces) {
+        wl_surface_attach(child, m_buffers[m_bufferIndex], 0, 0);
+        wl_surface_damage(child, 0, 0, size.width(), size.height());
+        wl_surface_commit(child);
+    }
+    wl_surface_attach(m_surface, m_buffers[m_bufferIndex], 0, 0);
+    wl_surface_damage(m_surface, 0, 0, size.width(), size.height());
+    wl_surface_commit(m_surface);
+    m_commits++;
+
+    wl_callback_add_listener(wl_display_sync(m_display), &s_syncListener, this);
+    m_pendingSyncs.push_back(monotonicUsecs());
+}
+
+void LoadClient::dispatch()
+{
+    if (wl_display_prepare_read(m_display) == 0) {
+        wl_display_read_events(m_display);
+    }
+    wl_display_dispatch_pending(m_display);
+}
+
+void LoadClient::flush()
+{
+    wl_display_flush(m_display);
+}
+
+ClientReport LoadClient::report() const
+{
+    ClientReport report = {m_commits, quint32(m_latencies.size()), 0, 0, 0, !isValid()};
+    if (m_latencies.empty()) {
+        return report;
+    }
+    std::vector<quint32> latencies = m_latencies;
+    std::sort(latencies.begin(), latencies.end());
+    double sum = 0;
+    for (quint32 latency : latencies) {
+        sum += latency;
+    }
+    report.meanLatency = sum / latencies.size() / 1000.0;
+    report.p99Latency = latencies[std::min(latencies.size() - 1, latencies.size() * 99 / 100)] / 1000.0;
+    report.maxLatency = latencies.back() / 1000.0;
+    return report;
+}
+
+void LoadClient::registryGlobal(void *data, wl_registry *registry, uint32_t name, const char *interface, uint32_t version)
+{
+    LoadClient *client = static_cast<LoadClient *>(data);
+    const QByteArray name_ = interface;
+    if (name_ == wl_compositor_interface.name) {
+        client->m_compositor = static_cast<wl_compositor *>(wl_registry_bind(registry, name, &wl_compositor_interface, std::min(version, 4u)));
+    } else if (name_ == wl_subcompositor_interface.name) {
+        client->m_subcompositor = static_cast<wl_subcompositor *>(wl_registry_bind(registry, name, &wl_subcompositor_interface, 1));
+    } else if (name_ == wl_shm_interface.name) {
+        client->m_shm = static_cast<wl_shm *>(wl_registry_bind(registry, name, &wl_shm_interface, 1));
+        wl_proxy_add_dispatcher(reinterpret_cast<wl_proxy *>(client->m_shm), ignoreEvent, nullptr, nullptr);
+    } else if (name_ == xdg_wm_base_interface.name) {
+        client->m_shell = static_cast<xdg_wm_base *>(wl_registry_bind(registry, name, &xdg_wm_base_interface, 1));
+    } else if (name_ == org_kde_plasma_window_management_interface.name) {
+        client->m_windowManagement = static_cast<org_kde_plasma_window_management *>(
+            wl_registry_bind(registry, name, &org_kde_plasma_window_management_interface, std::min(version, 13u)));
+    }
+}
+
+void LoadClient::registryGlobalRemove(void *data, wl_registry *registry, uint32_t name)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(registry)
+    Q_UNUSED(name)
+}
+
+void LoadClient::ping(void *data, xdg_wm_base *shell, uint32_t serial)
+{
+    Q_UNUSED(data)
+    xdg_wm_base_pong(shell, serial);
+}
+
+void LoadClient::surfaceConfigure(void *data, xdg_surface *surface, uint32_t serial)
+{
+    LoadClient *client = static_cast<LoadClient *>(data);
+    xdg_surface_ack_configure(surface, serial);
+    if (!client->m_configured) {
+        client->m_configured = true;
+        client->m_nextCommit = std::min(client->m_nextCommit, monotonicUsecs());
+    }
+}
+
+void LoadClient::toplevelConfigure(void *data, xdg_toplevel *toplevel, int32_t width, int32_t height, wl_array *states)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(toplevel)
+    Q_UNUSED(width)
+    Q_UNUSED(height)
+    Q_UNUSED(states)
+}
+
+void LoadClient::toplevelClose(void *data, xdg_toplevel *toplevel)
+{
+    Q_UNUSED(data)
+    Q_UNUSED(toplevel)
+}
+
+void LoadClient::syncDone(void *data, wl_callback *callback, uint32_t serial)
+{
+    Q_UNUSED(serial)
+    LoadClient *client = static_cast<LoadClient *>(data);
+    wl_callback_destroy(callback);
+    if (client->m_pendingSyncs.empty()) {
+        return;
+    }
+    client->m_latencies.push_back(quint32(monotonicUsecs() - client->m_pendingSyncs.front()));
+    client->m_pendingSyncs.pop_front();
+}
+
+/**
+ * The main loop of a worker process, runs until @p controlFd is closed by the server process.
+ **/
+static int runWorker(const QVector<int> &fds, const Options &options, int controlFd, int resultFd)
+{
+    const qint64 start = monotonicUsecs();
+    std::vector<LoadClient *> clients;
+    clients.reserve(fds.size());
+    for (int fd : fds) {
+        clients.push_back(new LoadClient(fd, options, start));
+    }
+
+    std::vector<pollfd> pfds(clients.size() + 1);
+    pfds[0] = {controlFd, POLLIN, 0};
+    bool running = true;
+    while (running) {
+        const qint64 now = monotonicUsecs();
+        qint64 nextCommit = now + 1000000;
+        for (LoadClient *client : clients) {
+            if (!client->isValid()) {
+                continue;
+            }
+            if (client->nextCommit() <= now) {
+                client->commit();
+            }
+            client->flush();
+            nextCommit = std::min(nextCommit, client->nextCommit());
+        }
+        for (size_t i = 0; i < clients.size(); ++i) {
+            pfds[i + 1] = {clients[i]->isValid() ? clients[i]->fd() : -1, POLLIN, 0};
+        }
+        const int timeout = int(std::max<qint64>(0, (nextCommit - monotonicUsecs() + 999) / 1000));
+        if (poll(pfds.data(), pfds.size(), timeout) < 0 && errno != EINTR) {
+            break;
+        }
+        if (pfds[0].revents) {
+            running = false;
+        }
+        for (size_t i = 0; i < clients.size(); ++i) {
+            if (pfds[i + 1].revents & POLLIN) {
+                clients[i]->dispatch();
+            }
+        }
+    }
+
+    for (LoadClient *client : clients) {
+        const ClientReport report = client->report();
+        if (write(resultFd, &report, sizeof(report)) != ssize_t(sizeof(report))) {
+            return 1;
+        }
+        delete client;
+    }
+    return 0;
+}
+
+/**
+ * The Display and the compositor logic of the server process.
+ **/
+class LoadServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LoadServer(const Options &options, QObject *parent = nullptr);
+
+    Display *display();
+    void startSampling();
+    void printSummary(const QVector<ClientReport> &reports) const;
+
+private:
+    void sample();
+    void renderFrame();
+
+    const Options &m_options;
+    Display m_display;
+    XdgShellInterface *m_shell;
+    PlasmaWindowManagementInterface *m_windowManagement;
+    QHash<XdgToplevelInterface *, PlasmaWindowInterface *> m_windows;
+    QTimer m_frameTimer;
+    QTimer m_sampleTimer;
+    QElapsedTimer m_clock;
+    quint64 m_commits = 0;
+    quint64 m_sampledCommits = 0;
+    qint64 m_sampledCpu = 0;
+    qint64 m_sampledTime = 0;
+    double m_peakCpu = 0;
+    double m_peakRss = 0;
+};
+
+static qint64 processCpuUsecs()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+static double residentMiB()
+{
+    long pages = 0;
+    if (FILE *statm = fopen("/proc/self/statm", "r")) {
+        long size;
+        if (fscanf(statm, "%ld %ld", &size, &pages) != 2) {
+            pages = 0;
+        }
+        fclose(statm);
+    }
+    return pages * double(sysconf(_SC_PAGESIZE)) / (1024 * 1024);
+}
+
+LoadServer::LoadServer(const Options &options, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+{
+    m_display.start();
+    m_display.createShm();
+    CompositorInterface *compositor = new CompositorInterface(&m_display, this);
+    new SubCompositorInterface(&m_display, this);
+    m_shell = new XdgShellInterface(&m_display, this);
+    m_windowManagement = new PlasmaWindowManagementInterface(&m_display, this);
+
+    connect(compositor, &CompositorInterface::surfaceCreated, this, [this](SurfaceInterface *surface) {
+        connect(surface, &SurfaceInterface::committed, this, [this] {
+            m_commits++;
+        });
+    });
+    connect(m_shell, &XdgShellInterface::toplevelCreated, this, [this](XdgToplevelInterface *toplevel) {
+        connect(toplevel, &XdgToplevelInterface::initializeRequested, this, [toplevel] {
+            toplevel->sendConfigure(QSize(), XdgToplevelInterface::States());
+        });
+        PlasmaWindowInterface *window = m_windowManagement->createWindow(this, QUuid::createUuid());
+        window->setTitle(toplevel->windowTitle());
+        connect(toplevel, &XdgToplevelInterface::windowTitleChanged, window, &PlasmaWindowInterface::setTitle);
+        m_windows.insert(toplevel, window);
+        connect(toplevel, &QObject::destroyed, this, [this, toplevel] {
+            delete m_windows.take(toplevel);
+        });
+    });
+
+    m_frameTimer.setTimerType(Qt::PreciseTimer);
+    m_frameTimer.setInterval(1000 / std::max(m_options.refreshRate, 1));
+    connect(&m_frameTimer, &QTimer::timeout, this, &LoadServer::renderFrame);
+    m_sampleTimer.setInterval(1000);
+    connect(&m_sampleTimer, &QTimer::timeout, this, &LoadServer::sample);
+}
+
+Display *LoadServer::display()
+{
+    return &m_display;
+}
+
+void LoadServer::startSampling()
+{
+    m_clock.start();
+    m_sampledCpu = processCpuUsecs();
+    m_sampledTime = 0;
+    m_frameTimer.start();
+    m_sampleTimer.start();
+}
+
+void LoadServer::renderFrame()
+{
+    const quint32 time = quint32(m_clock.elapsed());
+    const QList<SurfaceInterface *> surfaces = SurfaceInterface::surfaces();
+    for (SurfaceInterface *surface : surfaces) {
+        surface->frameRendered(time);
+    }
+}
+
+void LoadServer::sample()
+{
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+    const qint64 cpu = processCpuUsecs();
+    const double cpuPercent = 100.0 * (cpu - m_sampledCpu) / std::max<qint64>(now - m_sampledTime, 1);
+    const double rss = residentMiB();
+    const double commitRate = (m_commits - m_sampledCommits) * 1e6 / std::max<qint64>(now - m_sampledTime, 1);
+    m_peakCpu = std::max(m_peakCpu, cpuPercent);
+    m_peakRss = std::max(m_peakRss, rss);
+    printf("%6.1fs clients %5d windows %5d cpu %6.1f%% rss %8.1f MiB commits/s %9.0f\n",
+           now / 1e6, m_display.connections().count(), m_windows.count(), cpuPercent, rss, commitRate);
+    fflush(stdout);
+    m_sampledCpu = cpu;
+    m_sampledTime = now;
+    m_sampledCommits = m_commits;
+}
+
+void LoadServer::printSummary(const QVector<ClientReport> &reports) const
+{
+    QVector<double> p99s;
+    double worstLatency = 0;
+    double meanSum = 0;
+    quint64 commits = 0;
+    int failed = 0;
+    for (const ClientReport &report : reports) {
+        commits += report.commits;
+        if (report.failed) {
+            failed++;
+        }
+        if (report.samples == 0) {
+            continue;
+        }
+        p99s << report.p99Latency;
+        meanSum += report.meanLatency;
+        worstLatency = std::max(worstLatency, report.maxLatency);
+    }
+    std::sort(p99s.begin(), p99s.end());
+    printf("\nclients %d (failed %d), commits %llu, peak cpu %.1f%%, peak rss %.1f MiB\n",
+           reports.count(), failed, static_cast<unsigned long long>(commits), m_peakCpu, m_peakRss);
+    if (!p99s.isEmpty()) {
+        printf("latency per client: mean %.2f ms, median p99 %.2f ms, worst p99 %.2f ms, max %.2f ms\n",
+               meanSum / p99s.count(), p99s.at(p99s.count() / 2), p99s.last(), worstLatency);
+    }
+}
+
+static bool parseOptions(const QCoreApplication &app, Options *options)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Connects synthetic clients to an in-process KWaylandServer and samples its load"));
+    parser.addHelpOption();
+    const QCommandLineOption clients(QStringLiteral("clients"), QStringLiteral("Number of clients"), QStringLiteral("count"), QString::number(options->clients));
+    const QCommandLineOption processes(QStringLiteral("processes"), QStringLiteral("Worker processes running the clients"), QStringLiteral("count"), QString::number(options->processes));
+    const QCommandLineOption rate(QStringLiteral("rate"), QStringLiteral("Commits per second of each client"), QStringLiteral("hz"), QString::number(options->rate));
+    const QCommandLineOption subsurfaces(QStringLiteral("subsurfaces"), QStringLiteral("Sub-surfaces of each toplevel"), QStringLiteral("count"), QString::number(options->subsurfaces));
+    const QCommandLineOption duration(QStringLiteral("duration"), QStringLiteral("Seconds to run"), QStringLiteral("seconds"), QString::number(options->duration));
+    const QCommandLineOption refreshRate(QStringLiteral("refresh-rate"), QStringLiteral("Frame callbacks per second"), QStringLiteral("hz"), QString::number(options->refreshRate));
+    const QCommandLineOption bufferSize(QStringLiteral("buffer-size"), QStringLiteral("Size of the shm buffers"), QStringLiteral("WxH"), QStringLiteral("64x64"));
+    parser.addOptions({clients, processes, rate, subsurfaces, duration, refreshRate, bufferSize});
+    parser.process(app);
+
+    options->clients = std::max(parser.value(clients).toInt(), 1);
+    options->processes = qBound(1, parser.value(processes).toInt(), options->clients);
+    options->rate = std::max(parser.value(rate).toInt(), 1);
+    options->subsurfaces = std::max(parser.value(subsurfaces).toInt(), 0);
+    options->duration = std::max(parser.value(duration).toInt(), 1);
+    options->refreshRate = std::max(parser.value(refreshRate).toInt(), 1);
+    const QStringList size = parser.value(bufferSize).split(QLatin1Char('x'));
+    if (size.count() != 2 || size[0].toInt() <= 0 || size[1].toInt() <= 0) {
+        fprintf(stderr, "Invalid buffer size %s\n", qPrintable(parser.value(bufferSize)));
+        return false;
+    }
+    options->bufferSize = QSize(size[0].toInt(), size[1].toInt());
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    Options options;
+    if (!parseOptions(app, &options)) {
+        return 1;
+    }
+    // a worker which failed must not take the server down when it hangs up
+    signal(SIGPIPE, SIG_IGN);
+
+    LoadServer server(options);
+
+    struct Worker {
+        pid_t pid;
+        int controlFd;
+        int resultFd;
+        int clients;
+    };
+    QVector<Worker> workers;
+    QVector<int> serverFds;
+    for (int i = 0; i < options.processes; ++i) {
+        const int clientCount = options.clients / options.processes + (i < options.clients % options.processes ? 1 : 0);
+        QVector<int> clientFds;
+        for (int j = 0; j < clientCount; ++j) {
+            int sv[2];
+            if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sv) < 0) {
+                perror("socketpair");
+                return 1;
+            }
+            serverFds << sv[0];
+            clientFds << sv[1];
+        }
+        int control[2];
+        int result[2];
+        if (pipe2(control, O_CLOEXEC) < 0 || pipe2(result, O_CLOEXEC) < 0) {
+            perror("pipe");
+            return 1;
+        }
+        const pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            // the worker only keeps the client ends of its own sockets
+            for (int fd : qAsConst(serverFds)) {
+                close(fd);
+            }
+            for (const Worker &worker : qAsConst(workers)) {
+                close(worker.controlFd);
+                close(worker.resultFd);
+            }
+            close(control[1]);
+            close(result[0]);
+            _exit(runWorker(clientFds, options, control[0], result[1]));
+        }
+        for (int fd : qAsConst(clientFds)) {
+            close(fd);
+        }
+        close(control[0]);
+        close(result[1]);
+        workers.append({pid, control[1], result[0], clientCount});
+    }
+
+    server.display()->createClients(serverFds);
+    server.startSampling();
+
+    QTimer::singleShot(options.duration * 1000, &app, &QCoreApplication::quit);
+    app.exec();
+
+    // stops the workers, which then report their clients
+    QVector<ClientReport> reports;
+    for (const Worker &worker : qAsConst(workers)) {
+        close(worker.controlFd);
+    }
+    for (const Worker &worker : qAsConst(workers)) {
+        for (int i = 0; i < worker.clients; ++i) {
+            ClientReport report;
+            if (read(worker.resultFd, &report, sizeof(report)) != ssize_t(sizeof(report))) {
+                break;
+            }
+            reports << report;
+        }
+        close(worker.resultFd);
+        waitpid(worker.pid, nullptr, 0);
+    }
+    server.printSummary(reports);
+    return 0;
+}
+
+#include "loadgenerator.moc"
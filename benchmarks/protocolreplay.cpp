@@ -0,0 +1,119 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+// Qt
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+// WaylandServer
+#include "../src/server/compositor_interface.h"
+#include "../src/server/datadevicemanager_interface.h"
+#include "../src/server/display.h"
+#include "../src/server/output_interface.h"
+#include "../src/server/plasmashell_interface.h"
+#include "../src/server/plasmawindowmanagement_interface.h"
+#include "../src/server/primaryselectiondevicemanager_v1_interface.h"
+#include "../src/server/protocolreplayer.h"
+#include "../src/server/seat_interface.h"
+#include "../src/server/subcompositor_interface.h"
+#include "../src/server/surface_interface.h"
+#include "../src/server/viewporter_interface.h"
+#include "../src/server/xdgdecoration_v1_interface.h"
+#include "../src/server/xdgoutput_v1_interface.h"
+#include "../src/server/xdgshell_interface.h"
+
+#include <cstdio>
+
+#include <sys/resource.h>
+
+using namespace KWaylandServer;
+
+/**
+ * Replays a protocol recording, see Display::startProtocolRecording, against a Display with
+ * the globals most Plasma clients bind, and reports the CPU time the server spent on it.
+ * Clients binding other globals are not replayed.
+ **/
+
+static qint64 processCpuUsecs()
+{
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000000 + usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+int main(int argc, char **argv)
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Replays a protocol recording against an in-process KWaylandServer"));
+    parser.addHelpOption();
+    const QCommandLineOption originalSpeed(QStringLiteral("original-speed"), QStringLiteral("Send the requests at their recorded times"));
+    const QCommandLineOption repeat(QStringLiteral("repeat"), QStringLiteral("Number of replays"), QStringLiteral("count"), QStringLiteral("1"));
+    parser.addOptions({originalSpeed, repeat});
+    parser.addPositionalArgument(QStringLiteral("recording"), QStringLiteral("The protocol recording"));
+    parser.process(app);
+    if (parser.positionalArguments().count() != 1) {
+        parser.showHelp(1);
+    }
+
+    Display display;
+    if (!display.start()) {
+        return 1;
+    }
+    display.createShm();
+    CompositorInterface *compositor = new CompositorInterface(&display, &display);
+    new SubCompositorInterface(&display, &display);
+    new ViewporterInterface(&display, &display);
+    new DataDeviceManagerInterface(&display, &display);
+    new PrimarySelectionDeviceManagerV1Interface(&display, &display);
+    new PlasmaShellInterface(&display, &display);
+    new PlasmaWindowManagementInterface(&display, &display);
+    new XdgDecorationManagerV1Interface(&display, &display);
+    new XdgOutputManagerV1Interface(&display, &display);
+    XdgShellInterface *shell = new XdgShellInterface(&display, &display);
+
+    OutputInterface *output = new OutputInterface(&display, &display);
+    output->addMode(QSize(1920, 1080), OutputInterface::ModeFlag::Current | OutputInterface::ModeFlag::Preferred);
+    output->setCurrentMode(QSize(1920, 1080));
+    SeatInterface *seat = new SeatInterface(&display, &display);
+    seat->setHasPointer(true);
+    seat->setHasKeyboard(true);
+    seat->setHasTouch(true);
+    seat->create();
+
+    // the toplevels are mapped as a compositor would, the frame callbacks are completed right away
+    QObject::connect(shell, &XdgShellInterface::toplevelCreated, &display, [](XdgToplevelInterface *toplevel) {
+        QObject::connect(toplevel, &XdgToplevelInterface::initializeRequested, toplevel, [toplevel] {
+            toplevel->sendConfigure(QSize(), XdgToplevelInterface::States());
+        });
+    });
+    QElapsedTimer clock;
+    clock.start();
+    QObject::connect(compositor, &CompositorInterface::surfaceCreated, &display, [&clock](SurfaceInterface *surface) {
+        QObject::connect(surface, &SurfaceInterface::committed, surface, [surface, &clock] {
+            surface->frameRendered(quint32(clock.elapsed()));
+        });
+    });
+
+    ProtocolReplayer replayer(&display);
+    if (!replayer.load(parser.positionalArguments().first())) {
+        return 1;
+    }
+    printf("%d clients, %llu requests over %.1f s\n", replayer.clientCount(),
+           static_cast<unsigned long long>(replayer.requestCount()), replayer.duration() / 1e9);
+
+    const ProtocolReplayer::Speed speed = parser.isSet(originalSpeed) ? ProtocolReplayer::Speed::Original : ProtocolReplayer::Speed::Maximum;
+    const int count = qMax(parser.value(repeat).toInt(), 1);
+    for (int i = 0; i < count; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        const qint64 cpu = processCpuUsecs();
+        replayer.replay(speed);
+        printf("replay %d: %llu requests, %d failed clients, %.1f ms cpu, %.1f ms wall\n", i + 1,
+               static_cast<unsigned long long>(replayer.replayedRequestCount()), replayer.failedClientCount(),
+               (processCpuUsecs() - cpu) / 1000.0, timer.nsecsElapsed() / 1e6);
+    }
+    return 0;
+}
@@ -1 +1,3 @@
 #cmakedefine01 HAVE_LINUX_INPUT_H
+#cmakedefine01 HAVE_MEMFD
+#cmakedefine01 KWAYLANDSERVER_TRACING
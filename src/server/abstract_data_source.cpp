@@ -6,8 +6,29 @@
 
 #include "abstract_data_source.h"
 
+#include <QAtomicInteger>
+
 using namespace KWaylandServer;
 
+static QAtomicInteger<quint64> s_lastGeneration;
+
 AbstractDataSource::AbstractDataSource(QObject *parent)
     : QObject(parent)
+    , m_generation(++s_lastGeneration)
 {}
+
+quint64 AbstractDataSource::generation() const
+{
+    return m_generation;
+}
+
+MimeTypeAtoms AbstractDataSource::mimeTypeAtoms() const
+{
+    const QStringList mimeTypes = this->mimeTypes();
+    MimeTypeAtoms atoms;
+    atoms.reserve(mimeTypes.count());
+    for (const QString &mimeType : mimeTypes) {
+        atoms << MimeTypeAtom(mimeType);
+    }
+    return atoms;
+}
@@ -10,6 +10,7 @@
 #include "clientconnection.h"
 
 #include "datadevicemanager_interface.h"
+#include "mimetypeatom.h"
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
@@ -38,6 +39,13 @@ public:
     virtual void cancel() = 0;
 
     virtual QStringList mimeTypes() const = 0;
+    /**
+     * @returns the offered mime types as interned atoms, in the order of mimeTypes(). The
+     * data offers send these, so a data source which keeps its mime types as atoms should
+     * reimplement it. The default implementation interns mimeTypes().
+     * @since 5.22
+     **/
+    virtual MimeTypeAtoms mimeTypeAtoms() const;
 
     /**
      * @returns The Drag and Drop actions supported by this DataSourceInterface.
@@ -65,6 +73,14 @@ public:
         return nullptr;
     };
 
+    /**
+     * @returns a number identifying this data source, it is larger for every data source
+     * created later and never reused. Unlike the pointer of a destroyed data source it can
+     * be used to tell whether a selection is still the one seen before.
+     * @since 5.22
+     **/
+    quint64 generation() const;
+
 Q_SIGNALS:
     void aboutToBeDestroyed();
 
@@ -73,6 +89,9 @@ Q_SIGNALS:
 
 protected:
     explicit AbstractDataSource(QObject *parent = nullptr);
+
+private:
+    const quint64 m_generation;
 };
 
 }
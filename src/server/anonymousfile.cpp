@@ -0,0 +1,97 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "anonymousfile_p.h"
+// Qt
+#include <QTemporaryFile>
+
+#include <config-kwaylandserver.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+namespace AnonymousFile
+{
+
+/**
+ * Creates an unlinked temporary file holding @p content, @returns a descriptor of it opened
+ * with @p flags.
+ */
+static int createTemporaryFile(int flags, const QByteArray &content = QByteArray())
+{
+    QTemporaryFile file;
+    if (!file.open() || !writeAll(file.handle(), content)) {
+        return -1;
+    }
+    const QByteArray path = file.fileName().toUtf8();
+    const int fd = open(path.constData(), flags | O_CLOEXEC);
+    // the unlinked file stays alive as long as the descriptor is open
+    unlink(path.constData());
+    return fd;
+}
+
+int create(const char *name, qint64 size, bool sealable)
+{
+    int fd = -1;
+#if HAVE_MEMFD
+    fd = memfd_create(name, MFD_CLOEXEC | (sealable ? MFD_ALLOW_SEALING : 0));
+#else
+    Q_UNUSED(name)
+    Q_UNUSED(sealable)
+#endif
+    if (fd < 0) {
+        fd = createTemporaryFile(O_RDWR);
+        if (fd < 0) {
+            return -1;
+        }
+    }
+    if (size > 0 && ftruncate(fd, off_t(size)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int createReadOnly(const char *name, const QByteArray &content)
+{
+#if HAVE_MEMFD
+    int fd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (fd >= 0) {
+        if (writeAll(fd, content) &&
+                fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL) == 0) {
+            return fd;
+        }
+        close(fd);
+    }
+#else
+    Q_UNUSED(name)
+#endif
+    return createTemporaryFile(O_RDONLY, content);
+}
+
+bool writeAll(int fd, const char *data, qint64 size)
+{
+    while (size > 0) {
+        const ssize_t written = write(fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+}
+
+}
@@ -0,0 +1,52 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef KWAYLAND_SERVER_ANONYMOUSFILE_P_H
+#define KWAYLAND_SERVER_ANONYMOUSFILE_P_H
+
+#include <QByteArray>
+
+namespace KWaylandServer
+{
+
+/**
+ * Helpers creating files without a name, to pass data to clients in a file descriptor.
+ *
+ * A memfd is used if memfd_create() is available, otherwise an unlinked temporary file. All
+ * descriptors are created with O_CLOEXEC.
+ */
+namespace AnonymousFile
+{
+
+/**
+ * Creates an empty file of @p size bytes and returns a read-write descriptor of it, or @c -1.
+ * With @p sealable the memfd accepts seals, the temporary file fallback never does.
+ */
+int create(const char *name, qint64 size = 0, bool sealable = false);
+
+/**
+ * Creates a file holding @p content and returns a descriptor of it which the receivers can't
+ * use to change the content, or @c -1. The memfd is sealed against writes and size changes,
+ * the temporary file fallback is only opened read-only.
+ */
+int createReadOnly(const char *name, const QByteArray &content);
+
+/**
+ * Writes the @p size bytes at @p data to @p fd, retrying interrupted and partial writes.
+ * @returns @c false if a write failed.
+ */
+bool writeAll(int fd, const char *data, qint64 size);
+
+inline bool writeAll(int fd, const QByteArray &content)
+{
+    return writeAll(fd, content.constData(), content.size());
+}
+
+}
+
+}
+
+#endif // KWAYLAND_SERVER_ANONYMOUSFILE_P_H
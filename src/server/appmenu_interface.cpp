@@ -7,6 +7,7 @@
 #include "display.h"
 #include "surface_interface.h"
 
+#include <QHash>
 #include <QtGlobal>
 
 #include "qwayland-server-appmenu.h"
@@ -21,7 +22,8 @@ class AppMenuManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_appm
 public:
     AppMenuManagerInterfacePrivate(AppMenuManagerInterface *q, Display *d);
 
-    QVector<AppMenuInterface*> appmenus;
+    // the surface may be gone before its appmenu, the lookup compares the guarded surface
+    QHash<SurfaceInterface *, AppMenuInterface *> appmenus;
     AppMenuManagerInterface *q;
 
 protected:
@@ -42,9 +44,12 @@ void AppMenuManagerInterfacePrivate::org_kde_kwin_appmenu_manager_create(Resourc
     }
     auto appmenu = new AppMenuInterface(s, appmenu_resource);
 
-    appmenus.append(appmenu);
-    QObject::connect(appmenu, &QObject::destroyed, q, [=]() {
-        appmenus.removeOne(appmenu);
+    appmenus.insert(s, appmenu);
+    QObject::connect(appmenu, &QObject::destroyed, q, [this, s, appmenu]() {
+        auto it = appmenus.find(s);
+        if (it != appmenus.end() && *it == appmenu) {
+            appmenus.erase(it);
+        }
     });
     emit q->appMenuCreated(appmenu);
 }
@@ -113,10 +118,9 @@ AppMenuManagerInterface::~AppMenuManagerInterface()
 
 AppMenuInterface* AppMenuManagerInterface::appMenuForSurface(SurfaceInterface *surface)
 {
-    for (AppMenuInterface* menu: d->appmenus) {
-        if (menu->surface() == surface) {
-            return menu;
-        }
+    AppMenuInterface *menu = d->appmenus.value(surface);
+    if (menu && menu->surface() == surface) {
+        return menu;
     }
     return nullptr;
 }
@@ -8,6 +8,7 @@
 #include "blur_interface.h"
 #include "region_interface.h"
 #include "display.h"
+#include "regioninterner_p.h"
 #include "surface_interface_p.h"
 
 #include <wayland-server.h>
@@ -24,7 +25,11 @@ class BlurManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_blur_ma
 public:
     BlurManagerInterfacePrivate(BlurManagerInterface *q, Display *d);
 
+    static BlurManagerInterfacePrivate *get(BlurManagerInterface *manager);
+
     BlurManagerInterface *q;
+    // blur regions are shared by all surfaces, a shell tends to use the same few
+    RegionInterner regions;
 
 protected:
     void org_kde_kwin_blur_manager_create(Resource *resource, uint32_t id, wl_resource *surface) override;
@@ -37,6 +42,11 @@ BlurManagerInterfacePrivate::BlurManagerInterfacePrivate(BlurManagerInterface *_
 {
 }
 
+BlurManagerInterfacePrivate *BlurManagerInterfacePrivate::get(BlurManagerInterface *manager)
+{
+    return manager->d.data();
+}
+
 void BlurManagerInterfacePrivate::org_kde_kwin_blur_manager_unset(Resource *resource, wl_resource *surface)
 {
     Q_UNUSED(resource);
@@ -61,7 +71,7 @@ void BlurManagerInterfacePrivate::org_kde_kwin_blur_manager_create(Resource *res
         wl_client_post_no_memory(resource->client());
         return;
     }
-    auto blur = new BlurInterface(blur_resource);
+    auto blur = new BlurInterface(q, blur_resource);
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
     surfacePrivate->setBlur(blur);
 }
@@ -77,11 +87,12 @@ BlurManagerInterface::~BlurManagerInterface() = default;
 class BlurInterfacePrivate : public QtWaylandServer::org_kde_kwin_blur
 {
 public:
-    BlurInterfacePrivate(BlurInterface *q, wl_resource *resource);
+    BlurInterfacePrivate(BlurInterface *q, BlurManagerInterface *manager, wl_resource *resource);
     QRegion pendingRegion;
     QRegion currentRegion;
 
     BlurInterface *q;
+    QPointer<BlurManagerInterface> manager;
 
 protected:
     void org_kde_kwin_blur_destroy_resource(Resource *resource) override;
@@ -100,7 +111,9 @@ void BlurInterfacePrivate::org_kde_kwin_blur_set_region(Resource *resource, wl_r
 {
     Q_UNUSED(resource)
     RegionInterface *r = RegionInterface::get(region);
-    if (r) {
+    if (r && manager) {
+        pendingRegion = BlurManagerInterfacePrivate::get(manager)->regions.intern(r->region());
+    } else if (r) {
         pendingRegion = r->region();
     } else {
         pendingRegion = QRegion();
@@ -120,15 +133,16 @@ void BlurInterfacePrivate::org_kde_kwin_blur_destroy_resource(Resource *resource
     delete q;
 }
 
-BlurInterfacePrivate::BlurInterfacePrivate(BlurInterface *_q, wl_resource *resource)
+BlurInterfacePrivate::BlurInterfacePrivate(BlurInterface *_q, BlurManagerInterface *manager, wl_resource *resource)
     : QtWaylandServer::org_kde_kwin_blur(resource)
     , q(_q)
+    , manager(manager)
 {
 }
 
-BlurInterface::BlurInterface(wl_resource *resource)
+BlurInterface::BlurInterface(BlurManagerInterface *manager, wl_resource *resource)
     : QObject()
-    , d(new BlurInterfacePrivate(this, resource))
+    , d(new BlurInterfacePrivate(this, manager, resource))
 {
 }
 
@@ -37,6 +37,7 @@ public:
 
 private:
     QScopedPointer<BlurManagerInterfacePrivate> d;
+    friend class BlurManagerInterfacePrivate;
 };
 
 /**
@@ -68,7 +69,7 @@ Q_SIGNALS:
     void regionChanged();
 
 private:
-    explicit BlurInterface(wl_resource *resource);
+    explicit BlurInterface(BlurManagerInterface *manager, wl_resource *resource);
     friend class BlurManagerInterfacePrivate;
 
     QScopedPointer<BlurInterfacePrivate> d;
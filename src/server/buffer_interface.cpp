@@ -4,27 +4,26 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "buffer_interface.h"
+#include "buffer_interface_p.h"
+#include "clientconnection_p.h"
 #include "compositor_interface.h"
 #include "display.h"
+#include "display_p.h"
 #include "logging.h"
 #include "linuxdmabuf_v1_interface.h"
+#include "shmconversion_p.h"
 // Wayland
 #include <wayland-server.h>
 // EGL
 #include <EGL/egl.h>
-#include <QtGui/qopengl.h>
+
+#include <cstring>
 
 #include "drm_fourcc.h"
 
 namespace KWaylandServer
 {
 
-namespace EGL
-{
-typedef GLboolean(*eglQueryWaylandBufferWL_func)(EGLDisplay dpy, struct wl_resource *buffer, EGLint attribute, EGLint *value);
-eglQueryWaylandBufferWL_func eglQueryWaylandBufferWL = nullptr;
-}
-
 class BufferInterface::Private
 {
 public:
@@ -32,38 +31,63 @@ public:
     ~Private();
     QImage::Format format() const;
     QImage createImage();
+    bool convertImage(QImage *image, const QRegion &region);
+    bool forEachSpan(const QRegion &region, const std::function<void(const QRect &, const uchar *)> &callback);
+    bool copyTo(uchar *destination, int destinationStride, const QRegion &region);
+    /**
+     * The approximate size of the buffer's storage.
+     */
+    qint64 storageBytes() const;
+    Display *display;
     wl_resource *buffer;
     wl_shm_buffer *shmBuffer;
     LinuxDmabufBuffer *dmabufBuffer;
     int refCount;
     QSize size;
     bool alpha;
+    // attributed while the compositor holds a reference
+    ClientMemoryAccount memoryAccount{ClientMemoryCategory::Buffers};
+    // the nodes of the BufferDestroyObservers watching this buffer
+    wl_list destroyObservers;
 
     static BufferInterface *get(wl_resource *r);
 
+    /**
+     * Begins an access to the shm buffer in the calling thread, fails if the thread is
+     * accessing another buffer.
+     */
+    bool beginAccess();
+    void endAccess();
+
 private:
     static void destroyListenerCallback(wl_listener *listener, void *data);
     static Private *cast(wl_resource *r);
     static void imageBufferCleanupHandler(void *info);
-    static QList<Private*> s_buffers;
-    static Private *s_accessedBuffer;
-    static int s_accessCounter;
+    // libwayland guards one shm pool per thread against SIGBUS, so the accessed buffer is
+    // tracked per thread and buffers can be accessed concurrently from different threads
+    static thread_local Private *s_accessedBuffer;
+    static thread_local int s_accessCounter;
 
     BufferInterface *q;
-    wl_listener listener;
+    // The destroy listener doubles as the lookup key: wl_resource_get_destroy_listener()
+    // finds it on the resource itself, so no global list of buffers has to be walked.
+    struct DestroyListener {
+        wl_listener listener;
+        Private *d;
+    } destroyListener;
 };
 
-QList<BufferInterface::Private*> BufferInterface::Private::s_buffers;
-BufferInterface::Private *BufferInterface::Private::s_accessedBuffer = nullptr;
-int BufferInterface::Private::s_accessCounter = 0;
+thread_local BufferInterface::Private *BufferInterface::Private::s_accessedBuffer = nullptr;
+thread_local int BufferInterface::Private::s_accessCounter = 0;
 
 BufferInterface::Private *BufferInterface::Private::cast(wl_resource *r)
 {
-    auto it = std::find_if(s_buffers.constBegin(), s_buffers.constEnd(), [r](Private *d) { return d->buffer == r; });
-    if (it == s_buffers.constEnd()) {
+    wl_listener *listener = wl_resource_get_destroy_listener(r, destroyListenerCallback);
+    if (!listener) {
         return nullptr;
     }
-    return *it;
+    DestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+    return destroyListener->d;
 }
 
 BufferInterface *BufferInterface::Private::get(wl_resource *r)
@@ -78,36 +102,57 @@ BufferInterface *BufferInterface::Private::get(wl_resource *r)
 void BufferInterface::Private::imageBufferCleanupHandler(void *info)
 {
     Private *p = reinterpret_cast<Private*>(info);
-    Q_ASSERT(p == s_accessedBuffer);
+    p->endAccess();
+}
+
+bool BufferInterface::Private::beginAccess()
+{
+    if (s_accessedBuffer != nullptr && s_accessedBuffer != this) {
+        return false;
+    }
+    s_accessedBuffer = this;
+    s_accessCounter++;
+    wl_shm_buffer_begin_access(shmBuffer);
+    return true;
+}
+
+void BufferInterface::Private::endAccess()
+{
+    Q_ASSERT(this == s_accessedBuffer);
     Q_ASSERT(s_accessCounter > 0);
     s_accessCounter--;
     if (s_accessCounter == 0) {
         s_accessedBuffer = nullptr;
     }
-    wl_shm_buffer_end_access(p->shmBuffer);
+    wl_shm_buffer_end_access(shmBuffer);
 }
 
 BufferInterface::Private::Private(BufferInterface *q, Display *display, wl_resource *resource)
-    : buffer(resource)
+    : display(display)
+    , buffer(resource)
     , shmBuffer(wl_shm_buffer_get(resource))
     , dmabufBuffer(nullptr)
     , refCount(0)
     , alpha(false)
     , q(q)
 {
+    wl_list_init(&destroyObservers);
     if (!shmBuffer && wl_resource_instance_of(resource, &wl_buffer_interface, LinuxDmabufUnstableV1Interface::bufferImplementation())) {
         dmabufBuffer = static_cast<LinuxDmabufBuffer *>(wl_resource_get_user_data(resource));
     }
-    s_buffers << this;
-    listener.notify = destroyListenerCallback;
-    listener.link.prev = nullptr;
-    listener.link.next = nullptr;
-    wl_resource_add_destroy_listener(resource, &listener);
+    memoryAccount.setClient(ClientConnectionPrivate::fromClient(wl_resource_get_client(resource)));
+    destroyListener.d = this;
+    destroyListener.listener.notify = destroyListenerCallback;
+    destroyListener.listener.link.prev = nullptr;
+    destroyListener.listener.link.next = nullptr;
+    wl_resource_add_destroy_listener(resource, &destroyListener.listener);
     if (shmBuffer) {
         size = QSize(wl_shm_buffer_get_width(shmBuffer), wl_shm_buffer_get_height(shmBuffer));
         // check alpha
         switch (wl_shm_buffer_get_format(shmBuffer)) {
         case WL_SHM_FORMAT_ARGB8888:
+        case WL_SHM_FORMAT_ABGR8888:
+        case WL_SHM_FORMAT_ARGB2101010:
             alpha = true;
             break;
         case WL_SHM_FORMAT_XRGB8888:
@@ -153,32 +198,27 @@ BufferInterface::Private::Private(BufferInterface *q, Display *display, wl_resou
         }
         size = dmabufBuffer->size();
     } else {
-        EGLDisplay eglDisplay = display->eglDisplay();
-        static bool resolved = false;
-        using namespace EGL;
-        if (!resolved && eglDisplay != EGL_NO_DISPLAY) {
-            eglQueryWaylandBufferWL = (eglQueryWaylandBufferWL_func)eglGetProcAddress("eglQueryWaylandBufferWL");
-            resolved = true;
-        }
+        const DisplayPrivate *displayPrivate = DisplayPrivate::get(display);
+        const auto eglQueryWaylandBufferWL = displayPrivate->eglQueryWaylandBuffer;
         if (eglQueryWaylandBufferWL) {
+            const EGLDisplay eglDisplay = displayPrivate->eglDisplay;
             EGLint width, height;
-            bool valid = false;
-            valid = eglQueryWaylandBufferWL(eglDisplay, buffer, EGL_WIDTH, &width);
-            valid = valid && eglQueryWaylandBufferWL(eglDisplay, buffer, EGL_HEIGHT, &height);
-            if (valid) {
+            // a buffer which isn't an EGL buffer already fails the first query
+            if (eglQueryWaylandBufferWL(eglDisplay, buffer, EGL_WIDTH, &width) &&
+                    eglQueryWaylandBufferWL(eglDisplay, buffer, EGL_HEIGHT, &height)) {
                 size = QSize(width, height);
-            }
-            // check alpha
-            EGLint format;
-            if (eglQueryWaylandBufferWL(eglDisplay, buffer, EGL_TEXTURE_FORMAT, &format)) {
-                switch (format) {
-                case EGL_TEXTURE_RGBA:
-                    alpha = true;
-                    break;
-                case EGL_TEXTURE_RGB:
-                default:
-                    alpha = false;
-                    break;
+                // check alpha
+                EGLint format;
+                if (eglQueryWaylandBufferWL(eglDisplay, buffer, EGL_TEXTURE_FORMAT, &format)) {
+                    switch (format) {
+                    case EGL_TEXTURE_RGBA:
+                        alpha = true;
+                        break;
+                    case EGL_TEXTURE_RGB:
+                    default:
+                        alpha = false;
+                        break;
+                    }
                 }
             }
         }
@@ -187,8 +227,7 @@ BufferInterface::Private::Private(BufferInterface *q, Display *display, wl_resou
 
 BufferInterface::Private::~Private()
 {
-    wl_list_remove(&listener.link);
-    s_buffers.removeAll(this);
+    wl_list_remove(&destroyListener.listener.link);
 }
 
 BufferInterface *BufferInterface::get(Display *display, wl_resource *r)
@@ -212,6 +251,8 @@ BufferInterface::BufferInterface(Display *display, wl_resource *resource)
 
 BufferInterface::~BufferInterface()
 {
+    // the observers drop their references
+    BufferDestroyObserver::notifyDestroyed(&d->destroyObservers, this);
     if (d->refCount != 0) {
         qCWarning(KWAYLAND_SERVER) << "Buffer destroyed while still being referenced, ref count:" << d->refCount;
     }
@@ -219,16 +260,28 @@ BufferInterface::~BufferInterface()
 
 void BufferInterface::Private::destroyListenerCallback(wl_listener *listener, void *data)
 {
-    Q_UNUSED(listener);
-    auto b = cast(reinterpret_cast<wl_resource*>(data));
+    Q_UNUSED(data);
+    DestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+    auto b = destroyListener->d;
     b->buffer = nullptr;
     emit b->q->aboutToBeDestroyed(b->q);
     delete b->q;
 }
 
+qint64 BufferInterface::Private::storageBytes() const
+{
+    if (shmBuffer) {
+        return qint64(wl_shm_buffer_get_stride(shmBuffer)) * wl_shm_buffer_get_height(shmBuffer);
+    }
+    // dmabufs and EGL buffers are assumed to use four bytes per pixel
+    return qint64(size.width()) * size.height() * 4;
+}
+
 void BufferInterface::ref()
 {
-    d->refCount++;
+    if (d->refCount++ == 0) {
+        d->memoryAccount.setBytes(d->storageBytes());
+    }
 }
 
 void BufferInterface::unref()
@@ -236,9 +289,10 @@ void BufferInterface::unref()
     Q_ASSERT(d->refCount > 0);
     d->refCount--;
     if (d->refCount == 0) {
+        d->memoryAccount.setBytes(0);
         if (d->buffer) {
             wl_buffer_send_release(d->buffer);
-            wl_client_flush(wl_resource_get_client(d->buffer));
+            DisplayPrivate::get(d->display)->scheduleBufferRelease(wl_resource_get_client(d->buffer));
         }
     }
 }
@@ -268,16 +322,13 @@ QImage BufferInterface::Private::createImage()
     if (!shmBuffer) {
         return QImage();
     }
-    if (s_accessedBuffer != nullptr && s_accessedBuffer != this) {
-        return QImage();
-    }
     const QImage::Format imageFormat = format();
     if (imageFormat == QImage::Format_Invalid) {
         return QImage();
     }
-    s_accessedBuffer = this;
-    s_accessCounter++;
-    wl_shm_buffer_begin_access(shmBuffer);
+    if (!beginAccess()) {
+        return QImage();
+    }
     return QImage((const uchar*)wl_shm_buffer_get_data(shmBuffer),
                   size.width(),
                   size.height(),
@@ -286,6 +337,127 @@ QImage BufferInterface::Private::createImage()
                   &imageBufferCleanupHandler, this);
 }
 
+bool BufferInterface::convertTo(QImage *image, const QRegion &region)
+{
+    return d->convertImage(image, region);
+}
+
+bool BufferInterface::Private::convertImage(QImage *image, const QRegion &region)
+{
+    if (!shmBuffer || !image) {
+        return false;
+    }
+    if (s_accessedBuffer != nullptr && s_accessedBuffer != this) {
+        return false;
+    }
+    const uint32_t shmFormat = wl_shm_buffer_get_format(shmBuffer);
+    const QImage::Format imageFormat = ShmConversion::targetFormat(shmFormat);
+    if (imageFormat == QImage::Format_Invalid) {
+        return false;
+    }
+
+    const QRect bufferRect(QPoint(0, 0), size);
+    QRegion convertedRegion = region & bufferRect;
+    if (image->size() != size || image->format() != imageFormat) {
+        *image = QImage(size, imageFormat);
+        convertedRegion = bufferRect;
+    } else {
+        // make sure we don't write into memory shared with another QImage
+        image->detach();
+    }
+    if (image->isNull()) {
+        return false;
+    }
+
+    wl_shm_buffer_begin_access(shmBuffer);
+    const uchar *source = static_cast<const uchar *>(wl_shm_buffer_get_data(shmBuffer));
+    const int stride = wl_shm_buffer_get_stride(shmBuffer);
+    for (const QRect &rect : convertedRegion) {
+        ShmConversion::convert(shmFormat, source, stride, image, rect);
+    }
+    wl_shm_buffer_end_access(shmBuffer);
+    return true;
+}
+
+bool BufferInterface::forEachSpan(const QRegion &region, const std::function<void(const QRect &span, const uchar *bits)> &callback)
+{
+    return d->forEachSpan(region, callback);
+}
+
+bool BufferInterface::Private::forEachSpan(const QRegion &region, const std::function<void(const QRect &, const uchar *)> &callback)
+{
+    if (!shmBuffer) {
+        return false;
+    }
+    if (s_accessedBuffer != nullptr && s_accessedBuffer != this) {
+        return false;
+    }
+    const int bytesPerPixel = ShmConversion::bytesPerPixel(wl_shm_buffer_get_format(shmBuffer));
+    if (bytesPerPixel == 0) {
+        return false;
+    }
+    const QRegion clipped = region & QRect(QPoint(0, 0), size);
+    if (clipped.isEmpty()) {
+        return true;
+    }
+
+    wl_shm_buffer_begin_access(shmBuffer);
+    const uchar *bits = static_cast<const uchar *>(wl_shm_buffer_get_data(shmBuffer));
+    const int stride = wl_shm_buffer_get_stride(shmBuffer);
+    for (const QRect &rect : clipped) {
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            callback(QRect(rect.x(), y, rect.width(), 1), bits + y * stride + rect.x() * bytesPerPixel);
+        }
+    }
+    wl_shm_buffer_end_access(shmBuffer);
+    return true;
+}
+
+bool BufferInterface::copyTo(uchar *destination, int destinationStride, const QRegion &region)
+{
+    return d->copyTo(destination, destinationStride, region);
+}
+
+bool BufferInterface::Private::copyTo(uchar *destination, int destinationStride, const QRegion &region)
+{
+    if (!shmBuffer || !destination) {
+        return false;
+    }
+    if (s_accessedBuffer != nullptr && s_accessedBuffer != this) {
+        return false;
+    }
+    const int bytesPerPixel = ShmConversion::bytesPerPixel(wl_shm_buffer_get_format(shmBuffer));
+    if (bytesPerPixel == 0) {
+        return false;
+    }
+    if (destinationStride < size.width() * bytesPerPixel) {
+        return false;
+    }
+    const QRegion clipped = region & QRect(QPoint(0, 0), size);
+    if (clipped.isEmpty()) {
+        return true;
+    }
+
+    wl_shm_buffer_begin_access(shmBuffer);
+    const uchar *bits = static_cast<const uchar *>(wl_shm_buffer_get_data(shmBuffer));
+    const int stride = wl_shm_buffer_get_stride(shmBuffer);
+    for (const QRect &rect : clipped) {
+        if (rect.width() == size.width() && stride == destinationStride) {
+            // full rows of identically laid out memory are one contiguous block
+            const size_t start = size_t(rect.y()) * stride;
+            memcpy(destination + start, bits + start, size_t(rect.height()) * stride);
+            continue;
+        }
+        const size_t offset = size_t(rect.x()) * bytesPerPixel;
+        const size_t rowBytes = size_t(rect.width()) * bytesPerPixel;
+        for (int y = rect.top(); y <= rect.bottom(); ++y) {
+            memcpy(destination + size_t(y) * destinationStride + offset, bits + size_t(y) * stride + offset, rowBytes);
+        }
+    }
+    wl_shm_buffer_end_access(shmBuffer);
+    return true;
+}
+
 bool BufferInterface::isReferenced() const
 {
     return d->refCount > 0;
@@ -335,4 +507,94 @@ bool BufferInterface::hasAlphaChannel() const
     return d->alpha;
 }
 
+BufferDestroyObserver::~BufferDestroyObserver()
+{
+    for (Node *node : qAsConst(m_nodes)) {
+        wl_list_remove(&node->link);
+        delete node;
+    }
+}
+
+void BufferDestroyObserver::observe(BufferInterface *buffer)
+{
+    for (const Node *node : qAsConst(m_nodes)) {
+        if (node->buffer == buffer) {
+            return;
+        }
+    }
+    Node *node = new Node{{}, this, buffer};
+    wl_list_insert(buffer->d->destroyObservers.prev, &node->link);
+    m_nodes.append(node);
+}
+
+void BufferDestroyObserver::stopObserving(BufferInterface *buffer)
+{
+    for (auto it = m_nodes.begin(); it != m_nodes.end(); ++it) {
+        if ((*it)->buffer == buffer) {
+            wl_list_remove(&(*it)->link);
+            delete *it;
+            m_nodes.erase(it);
+            return;
+        }
+    }
+}
+
+void BufferDestroyObserver::notifyDestroyed(wl_list *observers, BufferInterface *buffer)
+{
+    // unlink each node before its callback, the observer may start or stop observing others
+    while (!wl_list_empty(observers)) {
+        Node *node = wl_container_of(observers->next, node, link);
+        BufferDestroyObserver *observer = node->observer;
+        wl_list_remove(&node->link);
+        observer->m_nodes.removeOne(node);
+        delete node;
+        observer->bufferDestroyed(buffer);
+    }
+}
+
+ShmBufferAccess::ShmBufferAccess(BufferInterface *buffer)
+{
+    if (!buffer || !buffer->d->shmBuffer || !buffer->d->beginAccess()) {
+        return;
+    }
+    wl_shm_buffer *shmBuffer = buffer->d->shmBuffer;
+    m_buffer = buffer;
+    m_bits = static_cast<const uchar *>(wl_shm_buffer_get_data(shmBuffer));
+    m_stride = wl_shm_buffer_get_stride(shmBuffer);
+    m_format = wl_shm_buffer_get_format(shmBuffer);
+    m_size = buffer->d->size;
+}
+
+ShmBufferAccess::~ShmBufferAccess()
+{
+    if (m_buffer) {
+        m_buffer->d->endAccess();
+    }
+}
+
+bool ShmBufferAccess::isValid() const
+{
+    return m_buffer;
+}
+
+const uchar *ShmBufferAccess::bits() const
+{
+    return m_bits;
+}
+
+int ShmBufferAccess::stride() const
+{
+    return m_stride;
+}
+
+quint32 ShmBufferAccess::format() const
+{
+    return m_format;
+}
+
+QSize ShmBufferAccess::size() const
+{
+    return m_size;
+}
+
 }
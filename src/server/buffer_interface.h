@@ -8,9 +8,12 @@
 
 #include <QImage>
 #include <QObject>
+#include <QRegion>
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
+#include <functional>
+
 struct wl_resource;
 struct wl_shm_buffer;
 
@@ -103,9 +106,11 @@ public:
      * QImage can be used and when this method can be invoked.
      *
      * It is not safe to have two shared memory QImages for different BufferInterfaces at
-     * the same time. This method ensures that this does not happen and returns a null
-     * QImage if a different BufferInterface's data is still mapped to a QImage. Please note
-     * that this also applies to all implicitly data shared copies.
+     * the same time in the same thread. This method ensures that this does not happen and returns
+     * a null QImage if a different BufferInterface's data is still mapped to a QImage in the calling
+     * thread. Please note that this also applies to all implicitly data shared copies. The last
+     * copy has to be destroyed in the thread which called this method, see ShmBufferAccess for
+     * accessing buffers from other threads.
      *
      * In case it is needed to keep a copy, a deep copy has to be performed by using QImage::copy.
      *
@@ -116,6 +121,66 @@ public:
      **/
     QImage data();
 
+    /**
+     * Converts the shared memory buffer into @p image, restricted to @p region.
+     *
+     * In contrast to data() this also supports formats that cannot be mapped to a QImage
+     * directly, i.e. @c WL_SHM_FORMAT_RGB565, @c WL_SHM_FORMAT_XBGR8888, @c WL_SHM_FORMAT_ABGR8888,
+     * @c WL_SHM_FORMAT_XRGB2101010 and @c WL_SHM_FORMAT_ARGB2101010 in addition to the formats
+     * supported by data(). The @p image is a deep copy in either QImage::Format_RGB32 or
+     * QImage::Format_ARGB32_Premultiplied, so it stays valid after the buffer got released.
+     *
+     * The @p region is in buffer coordinates. A compositor is supposed to pass the same @p image
+     * on every commit together with e.g. SurfaceInterface::mapToBuffer(SurfaceInterface::trackedDamage()),
+     * so only the pixels that actually changed get converted. If @p image does not match the size
+     * or the format of the buffer, it gets reallocated and the whole buffer is converted.
+     *
+     * @returns @c true on success, @c false if this is not a shared memory buffer, the format is not
+     * supported or another BufferInterface's data is currently mapped with data()
+     * @see data
+     * @since 5.22
+     **/
+    bool convertTo(QImage *image, const QRegion &region);
+
+    /**
+     * Invokes @p callback for every row span of the shared memory buffer covered by @p region.
+     *
+     * The @p region is in buffer coordinates and gets clipped to the size of the buffer. The
+     * callback receives the span, a rectangle with a height of one pixel in buffer coordinates,
+     * and a pointer to the first byte of that span in the client's shared memory. The pointer
+     * is only valid for the duration of the callback and must not be written to.
+     *
+     * This allows to stream only the changed bytes of the buffer, e.g. when uploading a texture,
+     * without touching the rest of the shared memory mapping.
+     *
+     * @returns @c false if this is not a shared memory buffer, the pixel size of its format is unknown
+     * or another BufferInterface's data is currently mapped with data(), otherwise @c true
+     * @see SurfaceInterface::forEachDamagedSpan
+     * @since 5.22
+     **/
+    bool forEachSpan(const QRegion &region, const std::function<void(const QRect &span, const uchar *bits)> &callback);
+
+    /**
+     * Copies the pixels of the shared memory buffer covered by @p region into @p destination.
+     *
+     * The @p destination has the layout of the buffer, i.e. the same pixel format and size, with
+     * @p destinationStride bytes per row. Only the bytes inside @p region are written, the rest of
+     * @p destination is left untouched. This is meant for a compositor staging uploads in memory it
+     * owns, e.g. a persistently mapped pixel buffer object it updates with the damage of every
+     * commit. Once the copy is done the compositor doesn't need to read the buffer anymore and can
+     * let it be released while the GPU upload from the staging memory is still in flight.
+     *
+     * The @p region is in buffer coordinates and gets clipped to the size of the buffer. Whole rows
+     * with matching strides are copied as one block.
+     *
+     * @returns @c false if this is not a shared memory buffer, the pixel size of its format is unknown,
+     * @p destinationStride is smaller than a row of the buffer or another BufferInterface's data is
+     * currently mapped with data(), otherwise @c true
+     * @see forEachSpan
+     * @since 5.22
+     **/
+    bool copyTo(uchar *destination, int destinationStride, const QRegion &region);
+
     /**
      * Returns the width of the buffer in device pixels.
      */
@@ -145,8 +210,8 @@ public:
 
     /**
      * Returns whether the format of the BufferInterface has an alpha channel.
-     * For shared memory buffers returns @c true for format @c WL_SHM_FORMAT_ARGB8888,
-     * for all other formats returns @c false.
+     * For shared memory buffers returns @c true for formats @c WL_SHM_FORMAT_ARGB8888,
+     * @c WL_SHM_FORMAT_ABGR8888 and @c WL_SHM_FORMAT_ARGB2101010, for all other formats returns @c false.
      *
      * For EGL buffers returns @c true for format @c EGL_TEXTURE_RGBA, for all other formats
      * returns @c false.
@@ -168,10 +233,75 @@ Q_SIGNALS:
     void sizeChanged();
 
 private:
+    friend class BufferDestroyObserver;
+    friend class ShmBufferAccess;
     class Private;
     QScopedPointer<Private> d;
 };
 
+/**
+ * @brief Scoped read access to the memory of a shared memory BufferInterface.
+ *
+ * The access guard allows to read the pixels of a shared memory buffer from any thread, e.g. to
+ * upload several buffers to textures in parallel render threads. Each thread can access one
+ * buffer at a time, a thread accessing the same buffer several times is fine. Constructing a
+ * guard for a different buffer than the one the thread accesses already, including through
+ * BufferInterface::data(), yields an invalid guard. The guard must be destroyed in the thread
+ * which constructed it.
+ *
+ * The memory is shared with the client, which may truncate the underlying file at any time.
+ * Reading beyond its end raises SIGBUS, which libwayland handles for the thread owning the
+ * access by mapping zeroed memory in place of the pool. The read then returns zeros instead of
+ * crashing the compositor, and the client is disconnected with an error once the access ends.
+ * As that error is written to the client's connection, the guards must be destroyed while the
+ * Display is not being dispatched.
+ *
+ * The BufferInterface must stay alive while the guard exists. The simplest way to ensure this is
+ * to not dispatch the Display until all guards are gone, so no client request can destroy the
+ * buffer in the meantime.
+ *
+ * @code
+ * // in a render thread
+ * ShmBufferAccess access(buffer);
+ * if (access.isValid()) {
+ *     upload(access.bits(), access.stride(), access.size(), access.format());
+ * }
+ * @endcode
+ *
+ * @see BufferInterface::data
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT ShmBufferAccess
+{
+public:
+    explicit ShmBufferAccess(BufferInterface *buffer);
+    ~ShmBufferAccess();
+
+    /**
+     * @returns @c false if the buffer is not a shared memory buffer or the calling thread is
+     * accessing another buffer
+     **/
+    bool isValid() const;
+    /**
+     * The first byte of the buffer, only valid while the guard exists, it must not be written to.
+     **/
+    const uchar *bits() const;
+    int stride() const;
+    /**
+     * The wl_shm format of the buffer.
+     **/
+    quint32 format() const;
+    QSize size() const;
+
+private:
+    Q_DISABLE_COPY(ShmBufferAccess)
+    BufferInterface *m_buffer = nullptr;
+    const uchar *m_bits = nullptr;
+    int m_stride = 0;
+    quint32 m_format = 0;
+    QSize m_size;
+};
+
 }
 
 Q_DECLARE_METATYPE(KWaylandServer::BufferInterface*)
@@ -0,0 +1,59 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <QVector>
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+
+class BufferInterface;
+
+/**
+ * Gets notified before the BufferInterfaces it observes are destroyed.
+ *
+ * This replaces connecting to BufferInterface::aboutToBeDestroyed for the objects holding on
+ * to buffers, e.g. the states of a surface. Observing a buffer links a node into an intrusive
+ * list of the buffer, observing it once more is a no-op, so attaching the same buffers over
+ * and over costs neither a connection nor an allocation.
+ */
+class BufferDestroyObserver
+{
+public:
+    BufferDestroyObserver() = default;
+    virtual ~BufferDestroyObserver();
+
+    void observe(BufferInterface *buffer);
+    void stopObserving(BufferInterface *buffer);
+
+    /**
+     * Notifies and unlinks all observers of a buffer, called by the buffer before it's
+     * destroyed.
+     */
+    static void notifyDestroyed(wl_list *observers, BufferInterface *buffer);
+
+protected:
+    /**
+     * Called when @p buffer is about to be destroyed, it isn't observed anymore at this point.
+     */
+    virtual void bufferDestroyed(BufferInterface *buffer) = 0;
+
+private:
+    Q_DISABLE_COPY(BufferDestroyObserver)
+
+    struct Node {
+        wl_list link;
+        BufferDestroyObserver *observer;
+        BufferInterface *buffer;
+    };
+    // the buffers currently observed, a handful at most
+    QVector<Node *> m_nodes;
+};
+
+}
@@ -4,80 +4,173 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "clientconnection.h"
+#include "clientconnection_p.h"
 #include "display.h"
+#include "display_p.h"
+#include "surface_interface_p.h"
 // Qt
 #include <QFileInfo>
+#include <QFutureWatcher>
 #include <QVector>
+#include <QtConcurrentRun>
 // Wayland
 #include <wayland-server.h>
+// system
+#include <sys/ioctl.h>
 
 namespace KWaylandServer
 {
 
-class ClientConnection::Private
+ClientConnectionPrivate *ClientConnectionPrivate::get(ClientConnection *connection)
 {
-public:
-    explicit Private(wl_client *c, Display *display, ClientConnection *q);
-    ~Private();
-
-    wl_client *client;
-    Display *display;
-    pid_t pid = 0;
-    uid_t user = 0;
-    gid_t group = 0;
-    QString executablePath;
-
-private:
-    static void destroyListenerCallback(wl_listener *listener, void *data);
-    ClientConnection *q;
-    wl_listener listener;
-    static QVector<Private*> s_allClients;
-};
+    return connection->d.data();
+}
 
-QVector<ClientConnection::Private*> ClientConnection::Private::s_allClients;
+ClientConnection *ClientConnectionPrivate::fromClient(wl_client *client)
+{
+    wl_listener *listener = wl_client_get_destroy_listener(client, destroyListenerCallback);
+    if (!listener) {
+        return nullptr;
+    }
+    return reinterpret_cast<DestroyListener *>(listener)->connection->q;
+}
 
-ClientConnection::Private::Private(wl_client *c, Display *display, ClientConnection *q)
+ClientConnectionPrivate::ClientConnectionPrivate(wl_client *c, Display *display, ClientConnection *q)
     : client(c)
     , display(display)
+    , throttledCommitTimer(display)
+    , congestionTimer(display)
     , q(q)
 {
-    s_allClients << this;
-    listener.notify = destroyListenerCallback;
-    wl_client_add_destroy_listener(c, &listener);
+    destroyListener.listener.notify = destroyListenerCallback;
+    destroyListener.connection = this;
+    wl_client_add_destroy_listener(c, &destroyListener.listener);
     wl_client_get_credentials(client, &pid, &user, &group);
-    executablePath = QFileInfo(QStringLiteral("/proc/%1/exe").arg(pid)).symLinkTarget();
+    const pid_t clientPid = pid;
+    executablePathFuture = QtConcurrent::run([clientPid] {
+        return QFileInfo(QStringLiteral("/proc/%1/exe").arg(clientPid)).symLinkTarget();
+    });
+    throttledCommitTimer.setCallback([this] {
+        flushThrottledCommits();
+    });
+    congestionTimer.setCallback([this] {
+        updateCongestion();
+    });
 }
 
-ClientConnection::Private::~Private()
+ClientConnectionPrivate::~ClientConnectionPrivate()
 {
     if (client) {
-        wl_list_remove(&listener.link);
+        wl_list_remove(&destroyListener.listener.link);
     }
-    s_allClients.removeAt(s_allClients.indexOf(this));
 }
 
-void ClientConnection::Private::destroyListenerCallback(wl_listener *listener, void *data)
+void ClientConnectionPrivate::destroyListenerCallback(wl_listener *listener, void *data)
 {
-    Q_UNUSED(listener)
-    wl_client *client = reinterpret_cast<wl_client*>(data);
-    auto it = std::find_if(s_allClients.constBegin(), s_allClients.constEnd(),
-        [client](Private *c) {
-            return c->client == client;
-        }
-    );
-    Q_ASSERT(it != s_allClients.constEnd());
-    auto p = (*it);
+    Q_UNUSED(data)
+    auto p = reinterpret_cast<DestroyListener *>(listener)->connection;
     auto q = p->q;
     p->client = nullptr;
-    wl_list_remove(&p->listener.link);
+    wl_list_remove(&p->destroyListener.listener.link);
     emit q->disconnected(q);
     q->deleteLater();
 }
 
+void ClientConnectionPrivate::recordCommit()
+{
+    commits++;
+    if (!commitInterval.isValid()) {
+        commitInterval.start();
+        commitsAtIntervalStart = commits;
+        return;
+    }
+    const qint64 elapsed = commitInterval.elapsed();
+    if (elapsed >= 1000) {
+        commitRate = (commits - commitsAtIntervalStart) * 1000.0 / elapsed;
+        commitsAtIntervalStart = commits;
+        commitInterval.restart();
+    }
+}
+
+void ClientConnectionPrivate::updateCongestion()
+{
+    if (highWaterMark <= 0 || !client) {
+        congestionTimer.stop();
+        return;
+    }
+    const bool wasCongested = congested;
+    congested = q->queuedBytes() > highWaterMark;
+    if (congested) {
+        congestionTimer.start(congestionPollInterval);
+    } else {
+        congestionTimer.stop();
+    }
+    if (congested && !wasCongested) {
+        emit q->congested();
+    } else if (!congested && wasCongested) {
+        emit q->decongested();
+    }
+}
+
+void ClientConnectionPrivate::accountMemory(ClientMemoryCategory category, qint64 delta)
+{
+    memory[int(category)] += delta;
+    if (memoryLimit <= 0) {
+        return;
+    }
+    const bool wasExceeded = memoryLimitExceeded;
+    memoryLimitExceeded = q->memoryUsage() > memoryLimit;
+    if (memoryLimitExceeded && !wasExceeded) {
+        // most accounting happens inside requests of the client, which must not be destroyed
+        // from there
+        QPointer<ClientConnection> connection(q);
+        QMetaObject::invokeMethod(q, [connection] {
+            if (connection && ClientConnectionPrivate::get(connection)->memoryLimitExceeded) {
+                emit connection->memoryLimitExceeded();
+            }
+        }, Qt::QueuedConnection);
+    }
+}
+
+ClientMemoryAccount::ClientMemoryAccount(ClientMemoryCategory category)
+    : m_category(category)
+{
+}
+
+ClientMemoryAccount::~ClientMemoryAccount()
+{
+    setBytes(0);
+}
+
+void ClientMemoryAccount::setClient(ClientConnection *client)
+{
+    if (m_client == client) {
+        return;
+    }
+    const qint64 bytes = m_bytes;
+    setBytes(0);
+    m_client = client;
+    setBytes(bytes);
+}
+
+void ClientMemoryAccount::setBytes(qint64 bytes)
+{
+    if (m_client && bytes != m_bytes) {
+        ClientConnectionPrivate::get(m_client)->accountMemory(m_category, bytes - m_bytes);
+    }
+    m_bytes = bytes;
+}
+
 ClientConnection::ClientConnection(wl_client *c, Display *parent)
     : QObject(parent)
-    , d(new Private(c, parent, this))
+    , d(new ClientConnectionPrivate(c, parent, this))
 {
+    auto watcher = new QFutureWatcher<QString>(this);
+    connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher] {
+        watcher->deleteLater();
+        emit credentialsReady();
+    });
+    watcher->setFuture(d->executablePathFuture);
 }
 
 ClientConnection::~ClientConnection() = default;
@@ -88,6 +181,8 @@ void ClientConnection::flush()
         return;
     }
     wl_client_flush(d->client);
+    DisplayPrivate::get(d->display)->inputLatency.clientFlushed(this);
+    d->updateCongestion();
 }
 
 void ClientConnection::destroy()
@@ -151,7 +246,172 @@ uid_t ClientConnection::userId() const
 
 QString ClientConnection::executablePath() const
 {
-    return d->executablePath;
+    return d->executablePathFuture.result();
+}
+
+bool ClientConnection::isCredentialsReady() const
+{
+    return d->executablePathFuture.isFinished();
+}
+
+int ClientConnection::pendingFrameCallbackCount() const
+{
+    return d->pendingFrameCallbacks;
+}
+
+quint64 ClientConnection::commitCount() const
+{
+    return d->commits;
+}
+
+qreal ClientConnection::commitsPerSecond() const
+{
+    return d->commitRate;
+}
+
+bool ClientConnectionPrivate::throttleCommit(SurfaceInterface *surface)
+{
+    if (commitRateLimit <= 0) {
+        return false;
+    }
+    if (!commitPeriod.isValid() || commitPeriod.elapsed() >= commitRatePeriod) {
+        commitPeriod.start();
+        periodCommits = 0;
+    }
+    if (++periodCommits <= commitRateLimit) {
+        return false;
+    }
+    throttledCommits++;
+    if (!throttledSurfaces.contains(surface)) {
+        throttledSurfaces.append(surface);
+    }
+    if (!throttledCommitTimer.isActive()) {
+        throttledCommitTimer.start(commitRatePeriod - commitPeriod.elapsed());
+    }
+    return true;
+}
+
+void ClientConnectionPrivate::flushThrottledCommits()
+{
+    const QVector<QPointer<SurfaceInterface>> surfaces = std::move(throttledSurfaces);
+    throttledSurfaces.clear();
+    for (const QPointer<SurfaceInterface> &surface : surfaces) {
+        if (surface) {
+            SurfaceInterfacePrivate::get(surface)->flushThrottledCommit();
+        }
+    }
+}
+
+void ClientConnection::setCommitRateLimit(int commits, int periodMsec)
+{
+    d->commitRateLimit = commits;
+    d->commitRatePeriod = periodMsec;
+    d->commitPeriod.invalidate();
+    if (commits <= 0) {
+        d->throttledCommitTimer.stop();
+        d->flushThrottledCommits();
+    }
+}
+
+int ClientConnection::commitRateLimit() const
+{
+    return d->commitRateLimit;
+}
+
+int ClientConnection::commitRatePeriod() const
+{
+    return d->commitRatePeriod;
+}
+
+quint64 ClientConnection::throttledCommitCount() const
+{
+    return d->throttledCommits;
+}
+
+qint64 ClientConnection::requestCpuTime() const
+{
+    return d->requestCpuTime;
+}
+
+quint64 ClientConnection::requestBudgetExceededCount() const
+{
+    return d->requestBudgetExceeded;
+}
+
+qint64 ClientConnection::queuedBytes() const
+{
+    if (!d->client) {
+        return 0;
+    }
+#if defined(TIOCOUTQ)
+    int queued = 0;
+    if (ioctl(wl_client_get_fd(d->client), TIOCOUTQ, &queued) == 0) {
+        return queued;
+    }
+#elif defined(FIONWRITE)
+    int queued = 0;
+    if (ioctl(wl_client_get_fd(d->client), FIONWRITE, &queued) == 0) {
+        return queued;
+    }
+#endif
+    return -1;
+}
+
+void ClientConnection::setHighWaterMark(qint64 bytes)
+{
+    bytes = qMax<qint64>(bytes, 0);
+    if (d->highWaterMark == bytes) {
+        return;
+    }
+    d->highWaterMark = bytes;
+    QSet<ClientConnection *> &monitoredClients = DisplayPrivate::get(d->display)->congestionMonitoredClients;
+    if (bytes) {
+        monitoredClients.insert(this);
+        d->updateCongestion();
+    } else {
+        monitoredClients.remove(this);
+        d->congestionTimer.stop();
+        if (d->congested) {
+            d->congested = false;
+            emit decongested();
+        }
+    }
+}
+
+qint64 ClientConnection::highWaterMark() const
+{
+    return d->highWaterMark;
+}
+
+bool ClientConnection::isCongested() const
+{
+    return d->congested;
+}
+
+qint64 ClientConnection::memoryUsage() const
+{
+    qint64 bytes = 0;
+    for (qint64 categoryBytes : d->memory) {
+        bytes += categoryBytes;
+    }
+    return bytes;
+}
+
+qint64 ClientConnection::memoryUsage(ClientMemoryCategory category) const
+{
+    return d->memory[int(category)];
+}
+
+void ClientConnection::setMemoryLimit(qint64 bytes)
+{
+    d->memoryLimit = qMax<qint64>(bytes, 0);
+    d->memoryLimitExceeded = false;
+    d->accountMemory(ClientMemoryCategory::Buffers, 0);
+}
+
+qint64 ClientConnection::memoryLimit() const
+{
+    return d->memoryLimit;
 }
 
 }
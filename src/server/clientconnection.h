@@ -19,8 +19,38 @@ struct wl_resource;
 namespace KWaylandServer
 {
 
+class ClientConnectionPrivate;
 class Display;
 
+/**
+ * The kinds of compositor memory attributed to the client it is held for.
+ *
+ * @see ClientConnection::memoryUsage
+ * @since 5.22
+ **/
+enum class ClientMemoryCategory {
+    /**
+     * The shared memory buffers and dmabufs the compositor holds a reference to.
+     **/
+    Buffers,
+    /**
+     * The damage, opaque and input regions in the states of the client's surfaces.
+     **/
+    SurfaceState,
+    /**
+     * The MIME types offered by the client's data sources.
+     **/
+    DataSources,
+    /**
+     * The titles, application ids and icons of the plasma windows of the client's process.
+     **/
+    Windows,
+    /**
+     * The surrounding text and preferred language the client set on text inputs.
+     **/
+    TextInput
+};
+
 /**
  * @brief Convenient Class which represents a wl_client.
  *
@@ -102,10 +132,164 @@ public:
      *
      * If the executable path cannot be resolved an empty QString is returned.
      *
+     * The path is resolved once in a worker thread when the client connects. If it is not
+     * resolved yet, this call waits for it.
+     *
      * @see processId
+     * @see isCredentialsReady
      * @since 5.6
      **/
     QString executablePath() const;
+    /**
+     * @returns Whether executablePath() has been resolved and can be returned without
+     * waiting. The pid, uid and gid are always available.
+     * @see credentialsReady
+     * @since 5.22
+     **/
+    bool isCredentialsReady() const;
+
+    /**
+     * Returns the number of frame callbacks requested by this client which have not been
+     * signalled yet.
+     *
+     * A number that keeps growing indicates that the surfaces of the client are no longer
+     * presented, e.g. because they are hidden, which is a common reason for clients that appear
+     * to hang.
+     *
+     * @see SurfaceInterface::frameRendered
+     * @since 5.22
+     **/
+    int pendingFrameCallbackCount() const;
+    /**
+     * Returns the number of wl_surface.commit requests of this client on all its surfaces.
+     *
+     * @see commitsPerSecond
+     * @since 5.22
+     **/
+    quint64 commitCount() const;
+    /**
+     * Returns the number of surface commits per second, measured over the last completed
+     * interval of at least one second.
+     *
+     * @see commitCount
+     * @since 5.22
+     **/
+    qreal commitsPerSecond() const;
+    /**
+     * Limits the surface commits of this client to @p commits per @p periodMsec milliseconds,
+     * usually the refresh period of the compositor.
+     *
+     * Commits beyond the limit are still applied, but their SurfaceInterface::damaged() and
+     * SurfaceInterface::committed() signals are merged: each surface emits them once at the
+     * end of the period with the damage of all the throttled commits. This keeps a client that
+     * commits in a loop without waiting for frame callbacks from causing needless repaints.
+     *
+     * The default value @c 0 for @p commits disables the limit.
+     *
+     * @see throttledCommitCount
+     * @since 5.22
+     **/
+    void setCommitRateLimit(int commits, int periodMsec);
+    /**
+     * @see setCommitRateLimit
+     * @since 5.22
+     **/
+    int commitRateLimit() const;
+    /**
+     * @see setCommitRateLimit
+     * @since 5.22
+     **/
+    int commitRatePeriod() const;
+    /**
+     * Returns the number of commits of this client whose signals got merged because they
+     * exceeded the commitRateLimit().
+     * @since 5.22
+     **/
+    quint64 throttledCommitCount() const;
+
+    /**
+     * Returns the thread CPU time in nanoseconds spent on the requests of this client,
+     * including the handlers of the compositor connected to the signals they emit. Only
+     * accounted while the Display has a client request budget.
+     *
+     * @see Display::setClientRequestBudget
+     * @since 5.22
+     **/
+    qint64 requestCpuTime() const;
+    /**
+     * Returns the number of dispatches in which this client sent more requests than the
+     * Display::clientRequestBudget().
+     * @since 5.22
+     **/
+    quint64 requestBudgetExceededCount() const;
+
+    /**
+     * Returns the number of bytes written to the socket of this client which the client has
+     * not read yet, or @c -1 if the platform does not provide this information.
+     *
+     * Events still queued inside libwayland because the socket is full are not included.
+     *
+     * @see setHighWaterMark
+     * @since 5.22
+     **/
+    qint64 queuedBytes() const;
+    /**
+     * Sets the number of unread bytes above which the client is considered congested. The
+     * Display compares queuedBytes() against it whenever it flushes its clients. A congested
+     * client is checked again every few milliseconds, so it's noticed when it caught up even if
+     * nothing else is sent to it.
+     *
+     * While a client is congested its pointer motion events are coalesced and only the latest
+     * position is sent once the client catches up or another pointer event is sent.
+     *
+     * The default value @c 0 disables the congestion tracking.
+     *
+     * @see isCongested
+     * @see congested
+     * @since 5.22
+     **/
+    void setHighWaterMark(qint64 bytes);
+    /**
+     * @see setHighWaterMark
+     * @since 5.22
+     **/
+    qint64 highWaterMark() const;
+    /**
+     * @returns Whether more than highWaterMark() bytes were waiting for the client at the
+     * last flush.
+     * @see congested
+     * @since 5.22
+     **/
+    bool isCongested() const;
+
+    /**
+     * Returns the approximate number of bytes of compositor memory held on behalf of this
+     * client in all categories.
+     *
+     * The numbers are estimates of the payload, e.g. the rectangles of a region or the pixels
+     * of a buffer, not of the exact heap usage.
+     *
+     * @see setMemoryLimit
+     * @since 5.22
+     **/
+    qint64 memoryUsage() const;
+    /**
+     * Returns the approximate number of bytes of compositor memory held on behalf of this
+     * client in @p category.
+     * @since 5.22
+     **/
+    qint64 memoryUsage(ClientMemoryCategory category) const;
+    /**
+     * Sets the number of bytes of memoryUsage() above which memoryLimitExceeded() is emitted.
+     * The default value @c 0 disables the limit.
+     * @since 5.22
+     **/
+    void setMemoryLimit(qint64 bytes);
+    /**
+     * @see setMemoryLimit
+     * @since 5.22
+     **/
+    qint64 memoryLimit() const;
 
     /**
      * Cast operator the native wl_client this ClientConnection represents.
@@ -130,12 +314,37 @@ Q_SIGNALS:
      * Signal emitted when the ClientConnection got disconnected from the server.
      **/
     void disconnected(KWaylandServer::ClientConnection*);
+    /**
+     * Emitted once the executablePath() has been resolved.
+     * @see isCredentialsReady
+     * @since 5.22
+     **/
+    void credentialsReady();
+    /**
+     * Emitted when the number of bytes the client has not read yet exceeds the highWaterMark().
+     * @see decongested
+     * @since 5.22
+     **/
+    void congested();
+    /**
+     * Emitted when a congested client has read enough to get below the highWaterMark() again.
+     * @see congested
+     * @since 5.22
+     **/
+    void decongested();
+    /**
+     * Emitted when memoryUsage() grows above the memoryLimit(). The signal is delivered from
+     * the event loop, not from within a request of the client, so it is safe to destroy() the
+     * client in response.
+     * @since 5.22
+     **/
+    void memoryLimitExceeded();
 
 private:
     friend class Display;
+    friend class ClientConnectionPrivate;
     explicit ClientConnection(wl_client *c, Display *parent);
-    class Private;
-    QScopedPointer<Private> d;
+    QScopedPointer<ClientConnectionPrivate> d;
 };
 
 }
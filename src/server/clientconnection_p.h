@@ -0,0 +1,132 @@
+/*
+    SPDX-FileCopyrightText: 2014 Martin Gräßlin <mgraesslin@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "clientconnection.h"
+#include "eventlooptimer_p.h"
+
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QHash>
+#include <QPointer>
+#include <QString>
+#include <QVector>
+
+#include <wayland-server-core.h>
+
+#include <array>
+
+namespace KWaylandServer
+{
+
+class SurfaceInterface;
+
+class ClientConnectionPrivate
+{
+public:
+    static ClientConnectionPrivate *get(ClientConnection *connection);
+    /**
+     * @returns The ClientConnection created for @p client, found through its destroy listener
+     * without searching all connections, or @c nullptr if there is none.
+     **/
+    static ClientConnection *fromClient(wl_client *client);
+
+    explicit ClientConnectionPrivate(wl_client *c, Display *display, ClientConnection *q);
+    ~ClientConnectionPrivate();
+
+    void recordCommit();
+    /**
+     * @returns Whether the commit of @p surface exceeds the commit rate limit. The signals
+     * of the commit are then emitted by flushThrottledCommits() at the end of the period.
+     **/
+    bool throttleCommit(SurfaceInterface *surface);
+    void flushThrottledCommits();
+    /**
+     * Compares the queued bytes against the high-water mark and emits the congestion signals.
+     * While the client is congested it's checked again every congestionPollInterval ms.
+     **/
+    void updateCongestion();
+    /**
+     * Adds @p delta bytes to the memory attributed to the client in @p category.
+     **/
+    void accountMemory(ClientMemoryCategory category, qint64 delta);
+
+    wl_client *client;
+    Display *display;
+    pid_t pid = 0;
+    uid_t user = 0;
+    gid_t group = 0;
+    // resolving /proc/<pid>/exe may block, so it happens in a worker thread
+    QFuture<QString> executablePathFuture;
+
+    // the surfaces of the client by their object id, see SurfaceInterface::get()
+    QHash<quint32, SurfaceInterface *> surfaces;
+
+    int pendingFrameCallbacks = 0;
+    quint64 commits = 0;
+    quint64 commitsAtIntervalStart = 0;
+    qreal commitRate = 0;
+    QElapsedTimer commitInterval;
+
+    int commitRateLimit = 0;
+    int commitRatePeriod = 0;
+    int periodCommits = 0;
+    quint64 throttledCommits = 0;
+
+    // accounted by the DispatchBudget of the Display
+    qint64 requestCpuTime = 0;
+    quint64 requestBudgetExceeded = 0;
+    QElapsedTimer commitPeriod;
+    EventLoopTimer throttledCommitTimer;
+    QVector<QPointer<SurfaceInterface>> throttledSurfaces;
+
+    qint64 highWaterMark = 0;
+    bool congested = false;
+    // a congested client may read its queue while nothing else is sent to it
+    EventLoopTimer congestionTimer;
+    static constexpr int congestionPollInterval = 10;
+
+    static constexpr int memoryCategoryCount = int(ClientMemoryCategory::TextInput) + 1;
+    std::array<qint64, memoryCategoryCount> memory = {};
+    qint64 memoryLimit = 0;
+    bool memoryLimitExceeded = false;
+
+private:
+    static void destroyListenerCallback(wl_listener *listener, void *data);
+    ClientConnection *q;
+    // the wl_listener has to stay the first member, the callback casts it back to its wrapper
+    struct DestroyListener {
+        wl_listener listener;
+        ClientConnectionPrivate *connection;
+    } destroyListener;
+};
+
+/**
+ * The approximate bytes one object holds on behalf of a client in one category. The object
+ * updates the size whenever its data changes, destroying the account releases the bytes.
+ */
+class ClientMemoryAccount
+{
+public:
+    explicit ClientMemoryAccount(ClientMemoryCategory category);
+    ~ClientMemoryAccount();
+
+    void setClient(ClientConnection *client);
+    void setBytes(qint64 bytes);
+    qint64 bytes() const {
+        return m_bytes;
+    }
+
+private:
+    const ClientMemoryCategory m_category;
+    QPointer<ClientConnection> m_client;
+    qint64 m_bytes = 0;
+
+    Q_DISABLE_COPY(ClientMemoryAccount)
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,217 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "clipboardcache_p.h"
+#include "anonymousfile_p.h"
+#include "datatransferrelay.h"
+#include "logging.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <utility>
+
+namespace KWaylandServer
+{
+
+// anything bigger is left to the clipboard manager
+static const qint64 s_maxEntrySize = 64 * 1024 * 1024;
+
+struct ClipboardCache::Entry
+{
+    MimeTypeAtom mimeType;
+    // the file holding the data
+    int fd = -1;
+    qint64 size = 0;
+    // moves the data from the origin into the file until it is complete
+    DataTransferRelay *recording = nullptr;
+    bool complete = false;
+    // the receive requests which came in before the data was complete
+    QVector<int> waiting;
+};
+
+bool ClipboardCache::matches(const QString &mimeType, const QStringList &patterns)
+{
+    for (const QString &pattern : patterns) {
+        if (pattern.endsWith(QLatin1String("/*"))) {
+            if (mimeType.startsWith(pattern.leftRef(pattern.size() - 1))) {
+                return true;
+            }
+        } else if (mimeType == pattern) {
+            return true;
+        }
+    }
+    return false;
+}
+
+ClipboardCache::ClipboardCache(AbstractDataSource *origin, const QStringList &patterns, QObject *parent)
+    : ClipboardCache(origin, patterns, s_maxEntrySize, parent)
+{
+}
+
+ClipboardCache::ClipboardCache(AbstractDataSource *origin, const QStringList &patterns, qint64 maxEntrySize, QObject *parent)
+    : AbstractDataSource(parent)
+    , m_origin(origin)
+    , m_maxEntrySize(maxEntrySize)
+{
+    const QStringList mimeTypes = origin->mimeTypes();
+    for (const QString &mimeType : mimeTypes) {
+        if (!matches(mimeType, patterns)) {
+            continue;
+        }
+        int fds[2];
+        if (pipe2(fds, O_CLOEXEC | O_NONBLOCK) != 0) {
+            qCWarning(KWAYLAND_SERVER) << "Failed to create a pipe for the clipboard cache";
+            break;
+        }
+        const int fd = AnonymousFile::create("kwaylandserver-clipboard");
+        // the relay closes its sink once it finished, the entry keeps the file
+        const int sink = fd >= 0 ? fcntl(fd, F_DUPFD_CLOEXEC, 0) : -1;
+        if (sink < 0) {
+            qCWarning(KWAYLAND_SERVER) << "Failed to create a file for the clipboard cache";
+            if (fd >= 0) {
+                close(fd);
+            }
+            close(fds[0]);
+            close(fds[1]);
+            break;
+        }
+        auto entry = new Entry;
+        entry->mimeType = MimeTypeAtom(mimeType);
+        entry->fd = fd;
+        entry->recording = new DataTransferRelay(this);
+        entry->recording->setSizeLimit(m_maxEntrySize);
+        connect(entry->recording, &DataTransferRelay::finished, this, [this, entry](bool success) {
+            finishEntry(entry, success);
+        });
+        if (!entry->recording->start(fds[0], sink)) {
+            close(fds[1]);
+            delete entry->recording;
+            close(entry->fd);
+            delete entry;
+            break;
+        }
+        m_entries << entry;
+        // takes the write end
+        origin->requestData(mimeType, fds[1]);
+    }
+}
+
+ClipboardCache::~ClipboardCache()
+{
+    emit aboutToBeDestroyed();
+    // the relays are children of the cache and close their descriptors themselves
+    for (Entry *entry : qAsConst(m_entries)) {
+        for (int fd : qAsConst(entry->waiting)) {
+            close(fd);
+        }
+        close(entry->fd);
+        delete entry;
+    }
+}
+
+ClipboardCache::Entry *ClipboardCache::entry(const QString &mimeType) const
+{
+    for (Entry *entry : m_entries) {
+        if (entry->mimeType.toString() == mimeType) {
+            return entry;
+        }
+    }
+    return nullptr;
+}
+
+void ClipboardCache::finishEntry(Entry *entry, bool complete)
+{
+    // this is running from the finished signal of the relay
+    entry->size = entry->recording->bytesTransferred();
+    entry->recording->deleteLater();
+    entry->recording = nullptr;
+
+    const QVector<int> waiting = std::exchange(entry->waiting, {});
+    if (!complete) {
+        // the origin might still be able to serve them
+        for (int fd : waiting) {
+            if (m_origin) {
+                m_origin->requestData(entry->mimeType.toString(), fd);
+            } else {
+                close(fd);
+            }
+        }
+        m_entries.removeOne(entry);
+        close(entry->fd);
+        delete entry;
+        return;
+    }
+    entry->complete = true;
+    for (int fd : waiting) {
+        startTransfer(entry, fd);
+    }
+}
+
+void ClipboardCache::requestData(const QString &mimeType, qint32 fd)
+{
+    Entry *entry = this->entry(mimeType);
+    if (!entry) {
+        if (m_origin) {
+            m_origin->requestData(mimeType, fd);
+        } else {
+            close(fd);
+        }
+        return;
+    }
+    if (!entry->complete) {
+        entry->waiting << fd;
+        return;
+    }
+    startTransfer(entry, fd);
+}
+
+void ClipboardCache::startTransfer(Entry *entry, int fd)
+{
+    // every transfer reads the file from its own offset, the relay closes its duplicate
+    const int source = fcntl(entry->fd, F_DUPFD_CLOEXEC, 0);
+    if (source < 0) {
+        close(fd);
+        return;
+    }
+    auto relay = new DataTransferRelay(this);
+    relay->setSourceOffset(0);
+    connect(relay, &DataTransferRelay::finished, relay, &QObject::deleteLater);
+    if (!relay->start(source, fd)) {
+        delete relay;
+    }
+}
+
+void ClipboardCache::cancel()
+{
+    // nobody to tell, the seat deletes the cache once it got replaced
+}
+
+QStringList ClipboardCache::mimeTypes() const
+{
+    return MimeTypeAtom::toStringList(mimeTypeAtoms());
+}
+
+MimeTypeAtoms ClipboardCache::mimeTypeAtoms() const
+{
+    MimeTypeAtoms mimeTypes;
+    mimeTypes.reserve(m_entries.count());
+    for (const Entry *entry : m_entries) {
+        mimeTypes << entry->mimeType;
+    }
+    return mimeTypes;
+}
+
+AbstractDataSource *ClipboardCache::origin() const
+{
+    return m_origin;
+}
+
+bool ClipboardCache::isEmpty() const
+{
+    return m_entries.isEmpty();
+}
+
+}
@@ -0,0 +1,75 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include "abstract_data_source.h"
+
+#include <QPointer>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+/**
+ * A copy of a clipboard selection or of the data of a drag held by the server, so the
+ * selection outlives the client which set it and drop targets get the data without a
+ * round trip to the dragging client.
+ *
+ * The cache starts reading the chosen mime types from its origin into memory backed files
+ * as soon as it is created. The receive requests of the data offers for the cache are
+ * served from those files by a DataTransferRelay each, without involving any client.
+ * Requests for mime types which are not cached, or turned out too large, are passed on to
+ * the origin while it exists.
+ **/
+class ClipboardCache : public AbstractDataSource
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Caches the mime types of @p origin which match one of the @p patterns, see matches().
+     **/
+    ClipboardCache(AbstractDataSource *origin, const QStringList &patterns, QObject *parent = nullptr);
+    /**
+     * Caches like the constructor above, a mime type with more than @p maxEntrySize bytes
+     * is dropped from the cache.
+     **/
+    ClipboardCache(AbstractDataSource *origin, const QStringList &patterns, qint64 maxEntrySize, QObject *parent = nullptr);
+    ~ClipboardCache() override;
+
+    void requestData(const QString &mimeType, qint32 fd) override;
+    void cancel() override;
+    QStringList mimeTypes() const override;
+    MimeTypeAtoms mimeTypeAtoms() const override;
+
+    /**
+     * @returns the data source which is cached, @c null once it got destroyed
+     **/
+    AbstractDataSource *origin() const;
+    /**
+     * @returns whether none of the mime types could be cached
+     **/
+    bool isEmpty() const;
+
+    /**
+     * @returns whether @p mimeType is one of the @p patterns, a pattern with the subtype
+     * @c * matches all mime types of its media type
+     **/
+    static bool matches(const QString &mimeType, const QStringList &patterns);
+
+private:
+    struct Entry;
+
+    Entry *entry(const QString &mimeType) const;
+    void finishEntry(Entry *entry, bool complete);
+    void startTransfer(Entry *entry, int fd);
+
+    QPointer<AbstractDataSource> m_origin;
+    qint64 m_maxEntrySize;
+    QVector<Entry *> m_entries;
+};
+
+}
@@ -0,0 +1,120 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "contenttype_v1_interface.h"
+#include "contenttype_v1_interface_p.h"
+#include "display.h"
+#include "surface_interface_p.h"
+
+static const int s_version = 1;
+
+namespace KWaylandServer
+{
+
+class ContentTypeManagerV1InterfacePrivate : public QtWaylandServer::wp_content_type_manager_v1
+{
+protected:
+    void wp_content_type_manager_v1_destroy(Resource *resource) override;
+    void wp_content_type_manager_v1_get_surface_content_type(Resource *resource, uint32_t id, struct ::wl_resource *surface) override;
+};
+
+void ContentTypeManagerV1InterfacePrivate::wp_content_type_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void ContentTypeManagerV1InterfacePrivate::wp_content_type_manager_v1_get_surface_content_type(Resource *resource, uint32_t id, struct ::wl_resource *surface_resource)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
+    if (ContentTypeV1Interface::get(surface)) {
+        wl_resource_post_error(resource->handle, error_already_constructed,
+                               "the specified surface already has a content type object");
+        return;
+    }
+
+    wl_resource *contentTypeResource = wl_resource_create(resource->client(), &wp_content_type_v1_interface,
+                                                          resource->version(), id);
+    if (!contentTypeResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new ContentTypeV1Interface(surface, contentTypeResource);
+}
+
+ContentTypeV1Interface::ContentTypeV1Interface(SurfaceInterface *surface, wl_resource *resource)
+    : QtWaylandServer::wp_content_type_v1(resource)
+    , surface(surface)
+{
+    SurfaceInterfacePrivate::get(surface)->contentTypeExtension = this;
+}
+
+ContentTypeV1Interface::~ContentTypeV1Interface()
+{
+    if (surface) {
+        SurfaceInterfacePrivate::get(surface)->contentTypeExtension = nullptr;
+    }
+}
+
+ContentTypeV1Interface *ContentTypeV1Interface::get(SurfaceInterface *surface)
+{
+    return SurfaceInterfacePrivate::get(surface)->contentTypeExtension;
+}
+
+void ContentTypeV1Interface::wp_content_type_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void ContentTypeV1Interface::wp_content_type_v1_destroy(Resource *resource)
+{
+    // like setting the content type to none, applied with the next commit
+    if (surface) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->pending.contentType = ContentType::None;
+        surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::ContentTypeChanged;
+    }
+    wl_resource_destroy(resource->handle);
+}
+
+void ContentTypeV1Interface::wp_content_type_v1_set_content_type(Resource *resource, uint32_t content_type)
+{
+    Q_UNUSED(resource)
+    if (!surface) {
+        return;
+    }
+    ContentType contentType;
+    switch (content_type) {
+    case type_photo:
+        contentType = ContentType::Photo;
+        break;
+    case type_video:
+        contentType = ContentType::Video;
+        break;
+    case type_game:
+        contentType = ContentType::Game;
+        break;
+    default:
+        contentType = ContentType::None;
+        break;
+    }
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->pending.contentType = contentType;
+    surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::ContentTypeChanged;
+}
+
+ContentTypeManagerV1Interface::ContentTypeManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new ContentTypeManagerV1InterfacePrivate)
+{
+    d->init(*display, s_version);
+}
+
+ContentTypeManagerV1Interface::~ContentTypeManagerV1Interface()
+{
+}
+
+} // namespace KWaylandServer
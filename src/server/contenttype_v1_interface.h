@@ -0,0 +1,65 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class ContentTypeManagerV1InterfacePrivate;
+
+/**
+ * The kind of content a client shows on a surface.
+ *
+ * @see SurfaceInterface::contentType
+ * @since 5.22
+ */
+enum class ContentType {
+    None = 0,
+    /**
+     * Still pictures, which may be shown with minimal processing.
+     */
+    Photo = 1,
+    /**
+     * A video or animation, which benefits from accurate timing.
+     */
+    Video = 2,
+    /**
+     * A running game, which benefits from low latency.
+     */
+    Game = 3,
+};
+
+/**
+ * The ContentTypeManagerV1Interface lets clients describe the content of their surfaces.
+ *
+ * The content type is a hint the compositor can use for its scheduling and power policy, for
+ * instance to prefer direct scanout and variable refresh rates for games or to time the frames
+ * of a video more accurately. The content type of a surface is provided by
+ * SurfaceInterface::contentType().
+ *
+ * ContentTypeManagerV1Interface corresponds to the Wayland interface @c wp_content_type_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT ContentTypeManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit ContentTypeManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~ContentTypeManagerV1Interface() override;
+
+private:
+    QScopedPointer<ContentTypeManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
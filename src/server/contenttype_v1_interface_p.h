@@ -0,0 +1,34 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "qwayland-server-content-type-v1.h"
+
+#include <QPointer>
+
+namespace KWaylandServer
+{
+
+class SurfaceInterface;
+
+class ContentTypeV1Interface : public QtWaylandServer::wp_content_type_v1
+{
+public:
+    ContentTypeV1Interface(SurfaceInterface *surface, wl_resource *resource);
+    ~ContentTypeV1Interface() override;
+
+    static ContentTypeV1Interface *get(SurfaceInterface *surface);
+
+    QPointer<SurfaceInterface> surface;
+
+protected:
+    void wp_content_type_v1_destroy_resource(Resource *resource) override;
+    void wp_content_type_v1_destroy(Resource *resource) override;
+    void wp_content_type_v1_set_content_type(Resource *resource, uint32_t content_type) override;
+};
+
+} // namespace KWaylandServer
@@ -7,6 +7,7 @@
 #include "contrast_interface.h"
 #include "region_interface.h"
 #include "display.h"
+#include "regioninterner_p.h"
 #include "surface_interface_p.h"
 
 #include <wayland-server.h>
@@ -20,16 +21,28 @@ static const quint32 s_version = 1;
 class ContrastManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_contrast_manager
 {
 public:
-    ContrastManagerInterfacePrivate(Display *display);
+    ContrastManagerInterfacePrivate(ContrastManagerInterface *q, Display *display);
+
+    static ContrastManagerInterfacePrivate *get(ContrastManagerInterface *manager);
+
+    ContrastManagerInterface *q;
+    // contrast regions are shared by all surfaces, a shell tends to use the same few
+    RegionInterner regions;
 
 protected:
     void org_kde_kwin_contrast_manager_create(Resource *resource, uint32_t id, wl_resource *surface) override;
     void org_kde_kwin_contrast_manager_unset(Resource *resource, wl_resource *surface) override;
 };
 
-ContrastManagerInterfacePrivate::ContrastManagerInterfacePrivate(Display *display)
+ContrastManagerInterfacePrivate::ContrastManagerInterfacePrivate(ContrastManagerInterface *_q, Display *display)
     : QtWaylandServer::org_kde_kwin_contrast_manager(*display, s_version)
+    , q(_q)
+{
+}
+
+ContrastManagerInterfacePrivate *ContrastManagerInterfacePrivate::get(ContrastManagerInterface *manager)
 {
+    return manager->d.data();
 }
 
 void ContrastManagerInterfacePrivate::org_kde_kwin_contrast_manager_create(Resource *resource, uint32_t id, wl_resource *surface)
@@ -45,7 +58,7 @@ void ContrastManagerInterfacePrivate::org_kde_kwin_contrast_manager_create(Resou
         wl_client_post_no_memory(resource->client());
         return;
     }
-    auto contrast = new ContrastInterface(contrast_resource);
+    auto contrast = new ContrastInterface(q, contrast_resource);
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
     surfacePrivate->setContrast(contrast);
 }
@@ -63,7 +76,7 @@ void ContrastManagerInterfacePrivate::org_kde_kwin_contrast_manager_unset(Resour
 
 ContrastManagerInterface::ContrastManagerInterface(Display *display, QObject *parent)
     : QObject(parent)
-    , d(new ContrastManagerInterfacePrivate(display))
+    , d(new ContrastManagerInterfacePrivate(this, display))
 {
 }
 
@@ -72,17 +85,18 @@ ContrastManagerInterface::~ContrastManagerInterface() = default;
 class ContrastInterfacePrivate : public QtWaylandServer::org_kde_kwin_contrast
 {
 public:
-    ContrastInterfacePrivate(ContrastInterface *_q, wl_resource *resource);
+    ContrastInterfacePrivate(ContrastInterface *_q, ContrastManagerInterface *manager, wl_resource *resource);
 
     QRegion pendingRegion;
     QRegion currentRegion;
-    qreal pendingContrast;
-    qreal currentContrast;
-    qreal pendingIntensity;
-    qreal currentIntensity;
-    qreal pendingSaturation;
-    qreal currentSaturation;
+    qreal pendingContrast = 0;
+    qreal currentContrast = 0;
+    qreal pendingIntensity = 0;
+    qreal currentIntensity = 0;
+    qreal pendingSaturation = 0;
+    qreal currentSaturation = 0;
     ContrastInterface *q;
+    QPointer<ContrastManagerInterface> manager;
 
 protected:
     void org_kde_kwin_contrast_commit(Resource *resource) override;
@@ -108,7 +122,9 @@ void ContrastInterfacePrivate::org_kde_kwin_contrast_set_region(Resource *resour
 {
     Q_UNUSED(resource)
     RegionInterface *r = RegionInterface::get(region);
-    if (r) {
+    if (r && manager) {
+        pendingRegion = ContrastManagerInterfacePrivate::get(manager)->regions.intern(r->region());
+    } else if (r) {
         pendingRegion = r->region();
     } else {
         pendingRegion = QRegion();
@@ -144,15 +160,16 @@ void ContrastInterfacePrivate::org_kde_kwin_contrast_destroy_resource(Resource *
     delete q;
 }
 
-ContrastInterfacePrivate::ContrastInterfacePrivate(ContrastInterface *_q, wl_resource *resource)
+ContrastInterfacePrivate::ContrastInterfacePrivate(ContrastInterface *_q, ContrastManagerInterface *manager, wl_resource *resource)
     : QtWaylandServer::org_kde_kwin_contrast(resource)
     , q(_q)
+    , manager(manager)
 {
 }
 
-ContrastInterface::ContrastInterface(wl_resource *resource)
+ContrastInterface::ContrastInterface(ContrastManagerInterface *manager, wl_resource *resource)
     : QObject()
-    , d(new ContrastInterfacePrivate(this, resource))
+    , d(new ContrastInterfacePrivate(this, manager, resource))
 {
 }
 
@@ -39,6 +39,7 @@ public:
 
 private:
     QScopedPointer<ContrastManagerInterfacePrivate> d;
+    friend class ContrastManagerInterfacePrivate;
 };
 
 /**
@@ -66,7 +67,7 @@ public:
     qreal saturation() const;
 
 private:
-    explicit ContrastInterface(wl_resource *resource);
+    explicit ContrastInterface(ContrastManagerInterface *manager, wl_resource *resource);
     friend class ContrastManagerInterfacePrivate;
 
     QScopedPointer<ContrastInterfacePrivate> d;
@@ -0,0 +1,230 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "cursorshape_v1_interface.h"
+#include "display.h"
+#include "pointer_interface_p.h"
+#include "tablet_v2_interface_p.h"
+
+#include "qwayland-server-cursor-shape-v1.h"
+
+#include <QPointer>
+
+static const int s_version = 1;
+
+namespace KWaylandServer
+{
+
+class CursorShapeManagerV1InterfacePrivate : public QtWaylandServer::wp_cursor_shape_manager_v1
+{
+protected:
+    void wp_cursor_shape_manager_v1_destroy(Resource *resource) override;
+    void wp_cursor_shape_manager_v1_get_pointer(Resource *resource, uint32_t cursor_shape_device, struct ::wl_resource *pointer) override;
+    void wp_cursor_shape_manager_v1_get_tablet_tool_v2(Resource *resource, uint32_t cursor_shape_device, struct ::wl_resource *tablet_tool) override;
+};
+
+/**
+ * The cursor shape device of either a pointer or a tablet tool.
+ */
+class CursorShapeDeviceV1Interface : public QtWaylandServer::wp_cursor_shape_device_v1
+{
+public:
+    CursorShapeDeviceV1Interface(PointerInterface *pointer, wl_resource *resource);
+    CursorShapeDeviceV1Interface(wl_resource *tabletTool, wl_resource *resource);
+    ~CursorShapeDeviceV1Interface() override;
+
+protected:
+    void wp_cursor_shape_device_v1_destroy_resource(Resource *resource) override;
+    void wp_cursor_shape_device_v1_destroy(Resource *resource) override;
+    void wp_cursor_shape_device_v1_set_shape(Resource *resource, uint32_t serial, uint32_t shape) override;
+
+private:
+    static void tabletToolDestroyed(wl_listener *listener, void *data);
+
+    QPointer<PointerInterface> m_pointer;
+    // the tablet tool resource is not a QObject, it's tracked with a destroy listener
+    struct TabletToolDestroyListener {
+        wl_listener listener;
+        CursorShapeDeviceV1Interface *device;
+    } m_tabletToolDestroyListener;
+    wl_resource *m_tabletTool = nullptr;
+};
+
+static QString shapeName(uint32_t shape)
+{
+    switch (shape) {
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_default:
+        return QStringLiteral("default");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_context_menu:
+        return QStringLiteral("context-menu");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_help:
+        return QStringLiteral("help");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_pointer:
+        return QStringLiteral("pointer");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_progress:
+        return QStringLiteral("progress");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_wait:
+        return QStringLiteral("wait");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_cell:
+        return QStringLiteral("cell");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_crosshair:
+        return QStringLiteral("crosshair");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_text:
+        return QStringLiteral("text");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_vertical_text:
+        return QStringLiteral("vertical-text");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_alias:
+        return QStringLiteral("alias");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_copy:
+        return QStringLiteral("copy");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_move:
+        return QStringLiteral("move");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_no_drop:
+        return QStringLiteral("no-drop");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_not_allowed:
+        return QStringLiteral("not-allowed");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_grab:
+        return QStringLiteral("grab");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_grabbing:
+        return QStringLiteral("grabbing");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_e_resize:
+        return QStringLiteral("e-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_n_resize:
+        return QStringLiteral("n-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_ne_resize:
+        return QStringLiteral("ne-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_nw_resize:
+        return QStringLiteral("nw-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_s_resize:
+        return QStringLiteral("s-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_se_resize:
+        return QStringLiteral("se-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_sw_resize:
+        return QStringLiteral("sw-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_w_resize:
+        return QStringLiteral("w-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_ew_resize:
+        return QStringLiteral("ew-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_ns_resize:
+        return QStringLiteral("ns-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_nesw_resize:
+        return QStringLiteral("nesw-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_nwse_resize:
+        return QStringLiteral("nwse-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_col_resize:
+        return QStringLiteral("col-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_row_resize:
+        return QStringLiteral("row-resize");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_all_scroll:
+        return QStringLiteral("all-scroll");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_zoom_in:
+        return QStringLiteral("zoom-in");
+    case QtWaylandServer::wp_cursor_shape_device_v1::shape_zoom_out:
+        return QStringLiteral("zoom-out");
+    default:
+        return QString();
+    }
+}
+
+void CursorShapeManagerV1InterfacePrivate::wp_cursor_shape_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void CursorShapeManagerV1InterfacePrivate::wp_cursor_shape_manager_v1_get_pointer(Resource *resource, uint32_t cursor_shape_device, struct ::wl_resource *pointer)
+{
+    wl_resource *deviceResource = wl_resource_create(resource->client(), &wp_cursor_shape_device_v1_interface,
+                                                     resource->version(), cursor_shape_device);
+    if (!deviceResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new CursorShapeDeviceV1Interface(PointerInterface::get(pointer), deviceResource);
+}
+
+void CursorShapeManagerV1InterfacePrivate::wp_cursor_shape_manager_v1_get_tablet_tool_v2(Resource *resource, uint32_t cursor_shape_device, struct ::wl_resource *tablet_tool)
+{
+    wl_resource *deviceResource = wl_resource_create(resource->client(), &wp_cursor_shape_device_v1_interface,
+                                                     resource->version(), cursor_shape_device);
+    if (!deviceResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new CursorShapeDeviceV1Interface(tablet_tool, deviceResource);
+}
+
+CursorShapeDeviceV1Interface::CursorShapeDeviceV1Interface(PointerInterface *pointer, wl_resource *resource)
+    : QtWaylandServer::wp_cursor_shape_device_v1(resource)
+    , m_pointer(pointer)
+{
+    m_tabletToolDestroyListener.listener.notify = tabletToolDestroyed;
+    m_tabletToolDestroyListener.device = this;
+    wl_list_init(&m_tabletToolDestroyListener.listener.link);
+}
+
+CursorShapeDeviceV1Interface::CursorShapeDeviceV1Interface(wl_resource *tabletTool, wl_resource *resource)
+    : QtWaylandServer::wp_cursor_shape_device_v1(resource)
+    , m_tabletTool(tabletTool)
+{
+    m_tabletToolDestroyListener.listener.notify = tabletToolDestroyed;
+    m_tabletToolDestroyListener.device = this;
+    wl_resource_add_destroy_listener(tabletTool, &m_tabletToolDestroyListener.listener);
+}
+
+CursorShapeDeviceV1Interface::~CursorShapeDeviceV1Interface()
+{
+    wl_list_remove(&m_tabletToolDestroyListener.listener.link);
+}
+
+void CursorShapeDeviceV1Interface::tabletToolDestroyed(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data)
+    TabletToolDestroyListener *destroyListener = wl_container_of(listener, destroyListener, listener);
+    CursorShapeDeviceV1Interface *device = destroyListener->device;
+    device->m_tabletTool = nullptr;
+    wl_list_remove(&listener->link);
+    wl_list_init(&listener->link);
+}
+
+void CursorShapeDeviceV1Interface::wp_cursor_shape_device_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void CursorShapeDeviceV1Interface::wp_cursor_shape_device_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void CursorShapeDeviceV1Interface::wp_cursor_shape_device_v1_set_shape(Resource *resource, uint32_t serial, uint32_t shape)
+{
+    const QString name = shapeName(shape);
+    if (name.isEmpty()) {
+        wl_resource_post_error(resource->handle, error_invalid_shape, "unknown cursor shape %u", shape);
+        return;
+    }
+    if (m_pointer) {
+        m_pointer->d_func()->setCursorShape(serial, name);
+    } else if (m_tabletTool) {
+        if (TabletToolV2InterfacePrivate *tool = TabletToolV2InterfacePrivate::get(m_tabletTool)) {
+            tool->setCursorShape(m_tabletTool, serial, name);
+        }
+    }
+}
+
+CursorShapeManagerV1Interface::CursorShapeManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new CursorShapeManagerV1InterfacePrivate)
+{
+    d->init(*display, s_version);
+}
+
+CursorShapeManagerV1Interface::~CursorShapeManagerV1Interface()
+{
+}
+
+} // namespace KWaylandServer
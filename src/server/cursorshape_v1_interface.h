@@ -0,0 +1,46 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class CursorShapeManagerV1InterfacePrivate;
+
+/**
+ * The CursorShapeManagerV1Interface lets clients set their cursor by naming a shape.
+ *
+ * Instead of attaching an image of their cursor theme to a cursor surface, clients ask for
+ * a shape like "text" or "pointer" and the compositor renders it from its own cursor theme.
+ * No shm buffer is involved, so for the compositor a cursor change is a swap to a texture
+ * it already has.
+ *
+ * The shapes set for a pointer are provided by Cursor::shape(), the shapes set for a tablet
+ * tool by TabletCursorV2::shape().
+ *
+ * CursorShapeManagerV1Interface corresponds to the Wayland interface @c wp_cursor_shape_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT CursorShapeManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CursorShapeManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~CursorShapeManagerV1Interface() override;
+
+private:
+    QScopedPointer<CursorShapeManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -6,6 +6,7 @@
 #include "datacontroloffer_v1_interface.h"
 #include "datacontroldevice_v1_interface.h"
 #include "datacontrolsource_v1_interface.h"
+#include "datatransfermonitor_p.h"
 // Qt
 #include <QStringList>
 #include <QPointer>
@@ -51,12 +52,11 @@ void DataControlOfferV1InterfacePrivate::zwlr_data_control_offer_v1_destroy_reso
 
 void DataControlOfferV1InterfacePrivate::zwlr_data_control_offer_v1_receive(Resource *resource, const QString &mimeType, qint32 fd)
 {
-    Q_UNUSED(resource)
     if (!source) {
         close(fd);
         return;
     }
-    source->requestData(mimeType, fd);
+    DataTransferMonitorPrivate::requestData(source, mimeType, fd, resource->client());
 }
 
 DataControlOfferV1Interface::DataControlOfferV1Interface(AbstractDataSource *source, wl_resource *resource)
@@ -76,8 +76,10 @@ DataControlOfferV1Interface::~DataControlOfferV1Interface() = default;
 void DataControlOfferV1Interface::sendAllOffers()
 {
     Q_ASSERT(d->source);
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    // the atoms carry the encoded names, nothing to convert per offer
+    const MimeTypeAtoms mimeTypes = d->source->mimeTypeAtoms();
+    for (const MimeTypeAtom &mimeType : mimeTypes) {
+        zwlr_data_control_offer_v1_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
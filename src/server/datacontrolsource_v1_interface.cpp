@@ -22,7 +22,9 @@ class DataControlSourceV1InterfacePrivate : public QtWaylandServer::zwlr_data_co
 public:
     DataControlSourceV1InterfacePrivate(DataControlSourceV1Interface *q, ::wl_resource *resource);
 
-    QStringList mimeTypes;
+    MimeTypeAtoms mimeTypes;
+    // the strings of mimeTypes, built on the first call of mimeTypes() after an offer
+    mutable QStringList mimeTypeNames;
     DataControlSourceV1Interface *q;
 
 protected:
@@ -46,7 +48,8 @@ void DataControlSourceV1InterfacePrivate::zwlr_data_control_source_v1_destroy_re
 
 void DataControlSourceV1InterfacePrivate::zwlr_data_control_source_v1_offer(Resource *, const QString &mimeType)
 {
-    mimeTypes << mimeType;
+    mimeTypes << MimeTypeAtom(mimeType);
+    mimeTypeNames.clear();
     emit q->mimeTypeOffered(mimeType);
 }
 
@@ -75,6 +78,14 @@ void DataControlSourceV1Interface::cancel()
 }
 
 QStringList DataControlSourceV1Interface::mimeTypes() const
+{
+    if (d->mimeTypeNames.isEmpty()) {
+        d->mimeTypeNames = MimeTypeAtom::toStringList(d->mimeTypes);
+    }
+    return d->mimeTypeNames;
+}
+
+MimeTypeAtoms DataControlSourceV1Interface::mimeTypeAtoms() const
 {
     return d->mimeTypes;
 }
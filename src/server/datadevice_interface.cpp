@@ -7,10 +7,12 @@
 */
 #include "datadevice_interface.h"
 #include "datadevice_interface_p.h"
+#include "clipboardcache_p.h"
 #include "datadevicemanager_interface.h"
 #include "datasource_interface.h"
 #include "dataoffer_interface.h"
 #include "display.h"
+#include "output_interface.h"
 #include "pointer_interface.h"
 #include "seat_interface.h"
 #include "seat_interface_p.h"
@@ -31,7 +33,7 @@ public:
 };
 
 DragAndDropIconPrivate::DragAndDropIconPrivate(SurfaceInterface *surface)
-    : SurfaceRole(surface, QByteArrayLiteral("dnd_icon"))
+    : SurfaceRole(surface, SurfaceRole::Type::DragAndDropIcon)
 {
 }
 
@@ -77,6 +79,94 @@ void DataDeviceInterfacePrivate::endDrag()
     icon.reset();
 }
 
+bool DataDeviceInterfacePrivate::hasSelection(AbstractDataSource *source) const
+{
+    if (!selectionSent || !seat->isSelectionDeduplicationEnabled()) {
+        return false;
+    }
+    if (!source) {
+        return sentSelectionGeneration == 0;
+    }
+    return sentSelectionGeneration == source->generation() && sentSelectionOffer;
+}
+
+qint64 DataDeviceInterfacePrivate::motionInterval() const
+{
+    // one refresh cycle of the fastest output the target is on
+    int refreshRate = 0;
+    if (drag.surface) {
+        const QVector<OutputInterface *> outputs = drag.surface->outputs();
+        for (OutputInterface *output : outputs) {
+            refreshRate = qMax(refreshRate, output->refreshRate());
+        }
+    }
+    if (refreshRate <= 0) {
+        refreshRate = 60000;
+    }
+    return 1000000000000ll / refreshRate;
+}
+
+void DataDeviceInterfacePrivate::sendMotion(const QPointF &pos)
+{
+    SeatInterface::Private *seatPrivate = seat->d_func();
+    if (seatPrivate->dragMotionThrottling) {
+        const qint64 interval = motionInterval();
+        const qint64 elapsed = drag.lastMotion.isValid() ? drag.lastMotion.nsecsElapsed() : interval;
+        if (drag.hasPendingMotion || elapsed < interval) {
+            if (drag.hasPendingMotion) {
+                seatPrivate->coalescedDragMotionCount++;
+            }
+            drag.hasPendingMotion = true;
+            drag.pendingMotion = pos;
+            drag.pendingMotionTime = seat->timestamp();
+            if (!motionTimer) {
+                motionTimer = new QTimer(q);
+                motionTimer->setSingleShot(true);
+                motionTimer->setTimerType(Qt::PreciseTimer);
+                QObject::connect(motionTimer, &QTimer::timeout, q, [this] {
+                    flushPendingMotion();
+                });
+            }
+            if (!motionTimer->isActive()) {
+                motionTimer->start(int((interval - elapsed + 999999) / 1000000));
+            }
+            return;
+        }
+    }
+    send_motion(seat->timestamp(), wl_fixed_from_double(pos.x()), wl_fixed_from_double(pos.y()));
+    seatPrivate->dragMotionCount++;
+    drag.lastMotion.start();
+    wl_client_flush(resource()->client());
+}
+
+void DataDeviceInterfacePrivate::flushPendingMotion()
+{
+    if (motionTimer) {
+        motionTimer->stop();
+    }
+    if (!drag.hasPendingMotion) {
+        return;
+    }
+    drag.hasPendingMotion = false;
+    send_motion(drag.pendingMotionTime, wl_fixed_from_double(drag.pendingMotion.x()), wl_fixed_from_double(drag.pendingMotion.y()));
+    seat->d_func()->dragMotionCount++;
+    drag.lastMotion.start();
+    wl_client_flush(resource()->client());
+}
+
+void DataDeviceInterfacePrivate::discardPendingMotion()
+{
+    if (motionTimer) {
+        motionTimer->stop();
+    }
+    if (drag.hasPendingMotion) {
+        drag.hasPendingMotion = false;
+        seat->d_func()->coalescedDragMotionCount++;
+    }
+    // the next target gets its first motion right away
+    drag.lastMotion.invalidate();
+}
+
 void DataDeviceInterfacePrivate::data_device_start_drag(Resource *resource, wl_resource *sourceResource, wl_resource *originResource, wl_resource *iconResource, uint32_t serial)
 {
     SurfaceInterface *iconSurface = SurfaceInterface::get(iconResource);
@@ -85,7 +175,7 @@ void DataDeviceInterfacePrivate::data_device_start_drag(Resource *resource, wl_r
     if (surfaceRole) {
         wl_resource_post_error(resource->handle, error_role,
                                "the icon surface already has a role assigned %s",
-                               surfaceRole->name().constData());
+                               surfaceRole->name());
         return;
     }
 
@@ -99,14 +189,9 @@ void DataDeviceInterfacePrivate::data_device_start_drag(Resource *resource, wl_r
         // origin is a proxy surface
         focusSurface = proxyRemoteSurface.data();
     }
-    const bool pointerGrab = seat->hasImplicitPointerGrab(serial) && seat->focusedPointerSurface() == focusSurface;
-    if (!pointerGrab) {
-        // Client doesn't have pointer grab.
-        const bool touchGrab = seat->hasImplicitTouchGrab(serial) && seat->focusedTouchSurface() == focusSurface;
-        if (!touchGrab) {
-            // Client neither has pointer nor touch grab. No drag start allowed.
-            return;
-        }
+    if (!seat->hasImplicitGrab(serial, focusSurface)) {
+        // Client neither has pointer nor touch grab. No drag start allowed.
+        return;
     }
     // TODO: source is allowed to be null, handled client internally!
     source = dataSource;
@@ -215,20 +300,34 @@ DataSourceInterface *DataDeviceInterface::selection() const
 
 void DataDeviceInterface::sendSelection(AbstractDataSource *other)
 {
+    if (other && d->hasSelection(other)) {
+        return;
+    }
     auto r = d->createDataOffer(other);
     if (!r) {
         return;
     }
     d->send_selection(r->resource());
+    d->selectionSent = true;
+    d->sentSelectionGeneration = other->generation();
+    d->sentSelectionOffer = r;
 }
 
 void DataDeviceInterface::sendClearSelection()
 {
+    if (d->hasSelection(nullptr)) {
+        return;
+    }
     d->send_selection(nullptr);
+    d->selectionSent = true;
+    d->sentSelectionGeneration = 0;
+    d->sentSelectionOffer = nullptr;
 }
 
 void DataDeviceInterface::drop()
 {
+    // the target has to know where the drop happened
+    d->flushPendingMotion();
     d->send_drop();
     if (d->drag.posConnection) {
         disconnect(d->drag.posConnection);
@@ -243,6 +342,7 @@ void DataDeviceInterface::drop()
 void DataDeviceInterface::updateDragTarget(SurfaceInterface *surface, quint32 serial)
 {
     if (d->drag.surface) {
+        d->discardPendingMotion();
         if (d->drag.surface->resource()) {
             d->send_leave();
         }
@@ -279,14 +379,15 @@ void DataDeviceInterface::updateDragTarget(SurfaceInterface *surface, quint32 se
         source->setAccepted(false);
     }
     DataOfferInterface *offer = d->createDataOffer(source);
+    ClipboardCache *prefetch = d->seat->d_func()->dragPrefetch;
+    if (offer && prefetch && prefetch->origin() == source) {
+        offer->setDataCache(prefetch);
+    }
     d->drag.surface = surface;
     if (d->seat->isDragPointer()) {
         d->drag.posConnection = connect(d->seat, &SeatInterface::pointerPosChanged, this,
             [this] {
-                const QPointF pos = d->seat->dragSurfaceTransformation().map(d->seat->pointerPos());
-                d->send_motion(d->seat->timestamp(),
-                                        wl_fixed_from_double(pos.x()), wl_fixed_from_double(pos.y()));
-                wl_client_flush(d->resource()->client());
+                d->sendMotion(d->seat->dragSurfaceTransformation().map(d->seat->pointerPos()));
             }
         );
     } else if (d->seat->isDragTouch()) {
@@ -297,15 +398,13 @@ void DataDeviceInterface::updateDragTarget(SurfaceInterface *surface, quint32 se
                     // different touch down has been moved
                     return;
                 }
-                const QPointF pos = d->seat->dragSurfaceTransformation().map(globalPosition);
-                d->send_motion(d->seat->timestamp(),
-                               wl_fixed_from_double(pos.x()), wl_fixed_from_double(pos.y()));
-                wl_client_flush(d->resource()->client());
+                d->sendMotion(d->seat->dragSurfaceTransformation().map(globalPosition));
             }
         );
     }
     d->drag.destroyConnection = connect(d->drag.surface, &QObject::destroyed, this,
         [this] {
+            d->discardPendingMotion();
             d->send_leave();
             if (d->drag.posConnection) {
                 disconnect(d->drag.posConnection);
@@ -7,7 +7,9 @@
 
 #pragma once
 
+#include <QElapsedTimer>
 #include <QPointer>
+#include <QTimer>
 
 #include "qwayland-server-wayland.h"
 
@@ -31,6 +33,18 @@ public:
 
     DataOfferInterface *createDataOffer(AbstractDataSource *source);
     void endDrag();
+    /**
+     * @returns whether the client still has the offer for @p source, or got the selection cleared
+     * if @p source is @c null, and the seat skips sending it again
+     **/
+    bool hasSelection(AbstractDataSource *source) const;
+    /**
+     * Sends a motion to @p pos, or keeps it for later if motions are throttled.
+     **/
+    void sendMotion(const QPointF &pos);
+    void flushPendingMotion();
+    void discardPendingMotion();
+    qint64 motionInterval() const;
 
     SeatInterface *seat;
     DataDeviceInterface *q;
@@ -39,6 +53,10 @@ public:
     QScopedPointer<DragAndDropIcon> icon;
     QPointer<DataSourceInterface> selection;
     QPointer<SurfaceInterface> proxyRemoteSurface;
+    // the last selection sent, a generation of 0 is a cleared selection
+    bool selectionSent = false;
+    quint64 sentSelectionGeneration = 0;
+    QPointer<DataOfferInterface> sentSelectionOffer;
 
     struct Drag {
         SurfaceInterface *surface = nullptr;
@@ -47,8 +65,14 @@ public:
         QMetaObject::Connection sourceActionConnection;
         QMetaObject::Connection targetActionConnection;
         quint32 serial = 0;
+        // the motion held back by the throttling
+        bool hasPendingMotion = false;
+        QPointF pendingMotion;
+        quint32 pendingMotionTime = 0;
+        QElapsedTimer lastMotion;
     };
     Drag drag;
+    QTimer *motionTimer = nullptr;
 
 protected:
     void data_device_destroy_resource(Resource *resource) override;
@@ -7,6 +7,7 @@
 #include "dataoffer_interface.h"
 #include "datadevice_interface.h"
 #include "datasource_interface.h"
+#include "datatransfermonitor_p.h"
 
 // Qt
 #include <QStringList>
@@ -25,6 +26,8 @@ public:
     DataOfferInterfacePrivate(AbstractDataSource *source, DataOfferInterface *q, wl_resource *resource);
     DataOfferInterface *q;
     QPointer<AbstractDataSource> source;
+    // a copy of the data of source held by the server, if any
+    QPointer<AbstractDataSource> cache;
 
     // defaults are set to sensible values for < version 3 interfaces
     DataDeviceManagerInterface::DnDActions supportedDnDActions = DataDeviceManagerInterface::DnDAction::Copy | DataDeviceManagerInterface::DnDAction::Move;
@@ -59,12 +62,15 @@ void DataOfferInterfacePrivate::data_offer_accept(Resource *resource, uint32_t s
 
 void DataOfferInterfacePrivate::data_offer_receive(Resource *resource, const QString &mime_type, int32_t fd)
 {
-    Q_UNUSED(resource)
     if (!source) {
         close(fd);
         return;
     }
-    source->requestData(mime_type, fd);
+    if (cache) {
+        DataTransferMonitorPrivate::requestData(cache, mime_type, fd, resource->client());
+        return;
+    }
+    DataTransferMonitorPrivate::requestData(source, mime_type, fd, resource->client());
 }
 
 void DataOfferInterfacePrivate::data_offer_destroy(QtWaylandServer::wl_data_offer::Resource *resource)
@@ -165,10 +171,17 @@ DataOfferInterface::DataOfferInterface(AbstractDataSource *source, wl_resource *
 
 DataOfferInterface::~DataOfferInterface() = default;
 
+void DataOfferInterface::setDataCache(AbstractDataSource *cache)
+{
+    d->cache = cache;
+}
+
 void DataOfferInterface::sendAllOffers()
 {
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    // the atoms carry the encoded names, nothing to convert per offer
+    const MimeTypeAtoms mimeTypes = d->source->mimeTypeAtoms();
+    for (const MimeTypeAtom &mimeType : mimeTypes) {
+        wl_data_offer_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
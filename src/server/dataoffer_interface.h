@@ -64,6 +64,11 @@ Q_SIGNALS:
 private:
     friend class DataDeviceInterfacePrivate;
     explicit DataOfferInterface(AbstractDataSource *source, wl_resource *resource);
+    /**
+     * Makes @p cache serve the receive requests instead of the source, see
+     * SeatInterface::setDragPrefetchMimeTypes.
+     **/
+    void setDataCache(AbstractDataSource *cache);
 
     QScopedPointer<DataOfferInterfacePrivate> d;
 };
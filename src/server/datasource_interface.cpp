@@ -7,6 +7,7 @@
 #include "datasource_interface.h"
 #include "datadevicemanager_interface.h"
 #include "clientconnection.h"
+#include "clientconnection_p.h"
 #include "utils.h"
 // Qt
 #include <QStringList>
@@ -24,9 +25,12 @@ public:
     DataSourceInterfacePrivate(DataSourceInterface *_q, ::wl_resource *resource);
 
     DataSourceInterface *q;
-    QStringList mimeTypes;
+    MimeTypeAtoms mimeTypes;
+    // the strings of mimeTypes, built on the first call of mimeTypes() after an offer
+    mutable QStringList mimeTypeNames;
     DataDeviceManagerInterface::DnDActions supportedDnDActions = DataDeviceManagerInterface::DnDAction::None;
     bool isAccepted = false;
+    ClientMemoryAccount memoryAccount{ClientMemoryCategory::DataSources};
 
 protected:
     void data_source_destroy_resource(Resource *resource) override;
@@ -42,6 +46,7 @@ DataSourceInterfacePrivate::DataSourceInterfacePrivate(DataSourceInterface *_q,
     : QtWaylandServer::wl_data_source(resource)
     , q(_q)
 {
+    memoryAccount.setClient(ClientConnectionPrivate::fromClient(wl_resource_get_client(resource)));
 }
 
 void DataSourceInterfacePrivate::data_source_destroy_resource(Resource *resource)
@@ -54,8 +59,7 @@ void DataSourceInterfacePrivate::data_source_destroy_resource(Resource *resource
 void DataSourceInterfacePrivate::data_source_offer(QtWaylandServer::wl_data_source::Resource *resource, const QString &mime_type)
 {
     Q_UNUSED(resource)
-    mimeTypes << mime_type;
-    emit q->mimeTypeOffered(mime_type);
+    offer(mime_type);
 }
 
 void DataSourceInterfacePrivate::data_source_destroy(QtWaylandServer::wl_data_source::Resource *resource)
@@ -65,7 +69,9 @@ void DataSourceInterfacePrivate::data_source_destroy(QtWaylandServer::wl_data_so
 
 void DataSourceInterfacePrivate::offer(const QString &mimeType)
 {
-    mimeTypes << mimeType;
+    mimeTypes << MimeTypeAtom(mimeType);
+    mimeTypeNames.clear();
+    memoryAccount.setBytes(memoryAccount.bytes() + qint64(sizeof(MimeTypeAtom)) + mimeType.size() * qint64(sizeof(QChar)));
     emit q->mimeTypeOffered(mimeType);
 }
 
@@ -123,6 +129,14 @@ void DataSourceInterface::cancel()
 }
 
 QStringList DataSourceInterface::mimeTypes() const
+{
+    if (d->mimeTypeNames.isEmpty()) {
+        d->mimeTypeNames = MimeTypeAtom::toStringList(d->mimeTypes);
+    }
+    return d->mimeTypeNames;
+}
+
+MimeTypeAtoms DataSourceInterface::mimeTypeAtoms() const
 {
     return d->mimeTypes;
 }
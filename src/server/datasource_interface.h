@@ -32,6 +32,7 @@ public:
     void cancel() override;
 
     QStringList mimeTypes() const override;
+    MimeTypeAtoms mimeTypeAtoms() const override;
 
     static DataSourceInterface *get(wl_resource *native);
 
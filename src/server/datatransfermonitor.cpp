@@ -0,0 +1,268 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "datatransfermonitor.h"
+#include "datatransfermonitor_p.h"
+#include "abstract_data_source.h"
+#include "clientconnection.h"
+#include "clientconnection_p.h"
+#include "datatransferrelay.h"
+#include "display.h"
+#include "display_p.h"
+#include "logging.h"
+// Qt
+#include <QTimer>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+DataTransferMonitorPrivate::DataTransferMonitorPrivate(DataTransferMonitor *q)
+    : q(q)
+{
+    clock.start();
+}
+
+void DataTransferMonitorPrivate::requestData(AbstractDataSource *source, const QString &mimeType, qint32 fd, wl_client *target)
+{
+    ClientConnection *targetConnection = ClientConnectionPrivate::fromClient(target);
+    DataTransferMonitor *monitor = nullptr;
+    if (targetConnection && targetConnection->display()) {
+        monitor = DisplayPrivate::get(targetConnection->display())->dataTransferMonitor;
+    }
+    if (!monitor) {
+        source->requestData(mimeType, fd);
+        return;
+    }
+    monitor->d->startTransfer(source, mimeType, fd, targetConnection);
+}
+
+void DataTransferMonitorPrivate::startTransfer(AbstractDataSource *source, const QString &mimeType, qint32 fd, ClientConnection *target)
+{
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create the pipe of a monitored data transfer";
+        source->requestData(mimeType, fd);
+        return;
+    }
+    auto relay = new DataTransferRelay(q);
+    relay->setSizeLimit(q->sizeLimit(mimeType));
+    if (!relay->start(fds[0], fd)) {
+        // the relay closed both ends, the source writing into nothing tells the client
+        close(fds[1]);
+        delete relay;
+        return;
+    }
+
+    auto transfer = new Transfer;
+    transfer->relay = relay;
+    if (wl_client *client = source->client()) {
+        transfer->source = ClientConnectionPrivate::fromClient(client);
+    } else {
+        transfer->serverSource = true;
+    }
+    transfer->target = target;
+    transfer->mimeType = mimeType;
+    transfer->lastProgress = clock.nsecsElapsed();
+    transfers << transfer;
+    QObject::connect(relay, &DataTransferRelay::finished, q, [this, transfer](bool success) {
+        finishTransfer(transfer, success);
+    });
+
+    if (!stallTimer) {
+        stallTimer = new QTimer(q);
+        QObject::connect(stallTimer, &QTimer::timeout, q, [this] {
+            checkStalls();
+        });
+    }
+    if (!stallTimer->isActive()) {
+        // often enough to notice a stall soon after the timeout
+        stallTimer->start(qMax(100, stallTimeout / 4));
+    }
+
+    // takes the write end
+    source->requestData(mimeType, fds[1]);
+}
+
+DataTransferProgress DataTransferMonitorPrivate::progress(const Transfer *transfer) const
+{
+    DataTransferProgress progress;
+    progress.source = transfer->source;
+    progress.target = transfer->target;
+    progress.mimeType = transfer->mimeType;
+    progress.bytes = transfer->relay->bytesTransferred();
+    progress.elapsed = transfer->relay->elapsed();
+    progress.stalled = transfer->stalled;
+    return progress;
+}
+
+bool DataTransferMonitorPrivate::isTracked(const Transfer *transfer) const
+{
+    return (transfer->source || transfer->serverSource) && transfer->target;
+}
+
+DataTransferStatistics &DataTransferMonitorPrivate::statistics(const Transfer *transfer)
+{
+    ClientConnection *source = transfer->source;
+    ClientConnection *target = transfer->target;
+    DataTransferStatistics &statistics = this->statistics[qMakePair(source, target)];
+    statistics.source = source;
+    statistics.target = target;
+    return statistics;
+}
+
+void DataTransferMonitorPrivate::finishTransfer(Transfer *transfer, bool success)
+{
+    transfers.removeOne(transfer);
+    const DataTransferProgress progress = this->progress(transfer);
+    const bool refused = transfer->relay->isSizeLimitExceeded();
+
+    // the statistics of a client are gone with it
+    if (isTracked(transfer)) {
+        DataTransferStatistics &statistics = this->statistics(transfer);
+        statistics.transfers++;
+        if (!success) {
+            statistics.failedTransfers++;
+        }
+        if (refused) {
+            statistics.refusedTransfers++;
+        }
+        statistics.bytes += progress.bytes;
+        statistics.duration += progress.elapsed;
+    }
+
+    // this is running from the relay's finished signal
+    transfer->relay->deleteLater();
+    delete transfer;
+    if (transfers.isEmpty() && stallTimer) {
+        stallTimer->stop();
+    }
+
+    if (refused) {
+        emit q->transferRefused(progress);
+    }
+    emit q->transferFinished(progress, success);
+}
+
+void DataTransferMonitorPrivate::checkStalls()
+{
+    const qint64 now = clock.nsecsElapsed();
+    const QVector<Transfer *> transfers = this->transfers;
+    for (Transfer *transfer : transfers) {
+        const quint64 bytes = transfer->relay->bytesTransferred();
+        if (bytes != transfer->lastBytes) {
+            transfer->lastBytes = bytes;
+            transfer->lastProgress = now;
+            continue;
+        }
+        if (transfer->stalled || now - transfer->lastProgress < stallTimeout * qint64(1000000)) {
+            continue;
+        }
+        transfer->stalled = true;
+        if (isTracked(transfer)) {
+            statistics(transfer).stalledTransfers++;
+        }
+        emit q->transferStalled(progress(transfer));
+    }
+}
+
+DataTransferMonitor::DataTransferMonitor(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new DataTransferMonitorPrivate(this))
+{
+    qRegisterMetaType<DataTransferProgress>();
+    d->display = display;
+    DisplayPrivate::get(display)->dataTransferMonitor = this;
+    connect(display, &Display::clientDisconnected, this, [this](ClientConnection *client) {
+        for (auto it = d->statistics.begin(); it != d->statistics.end();) {
+            if (it.key().first == client || it.key().second == client) {
+                it = d->statistics.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    });
+}
+
+DataTransferMonitor::~DataTransferMonitor()
+{
+    if (d->display) {
+        DisplayPrivate::get(d->display)->dataTransferMonitor = nullptr;
+    }
+    // the relays are children, deleting them stops the transfers
+    qDeleteAll(d->transfers);
+}
+
+void DataTransferMonitor::setSizeLimit(const QString &mimeType, quint64 bytes)
+{
+    if (bytes == 0) {
+        d->sizeLimits.remove(mimeType);
+    } else {
+        d->sizeLimits.insert(mimeType, bytes);
+    }
+}
+
+quint64 DataTransferMonitor::sizeLimit(const QString &mimeType) const
+{
+    auto it = d->sizeLimits.constFind(mimeType);
+    if (it != d->sizeLimits.constEnd()) {
+        return *it;
+    }
+    const int slash = mimeType.indexOf(QLatin1Char('/'));
+    if (slash < 0) {
+        return 0;
+    }
+    return d->sizeLimits.value(mimeType.left(slash + 1) + QLatin1Char('*'));
+}
+
+void DataTransferMonitor::setStallTimeout(int msec)
+{
+    d->stallTimeout = qMax(1, msec);
+    if (d->stallTimer && d->stallTimer->isActive()) {
+        d->stallTimer->start(qMax(100, d->stallTimeout / 4));
+    }
+}
+
+int DataTransferMonitor::stallTimeout() const
+{
+    return d->stallTimeout;
+}
+
+QVector<DataTransferStatistics> DataTransferMonitor::statistics() const
+{
+    QVector<DataTransferStatistics> statistics;
+    statistics.reserve(d->statistics.count());
+    for (const DataTransferStatistics &entry : qAsConst(d->statistics)) {
+        statistics << entry;
+    }
+    return statistics;
+}
+
+DataTransferStatistics DataTransferMonitor::statistics(ClientConnection *source, ClientConnection *target) const
+{
+    DataTransferStatistics statistics = d->statistics.value(qMakePair(source, target));
+    statistics.source = source;
+    statistics.target = target;
+    return statistics;
+}
+
+QVector<DataTransferProgress> DataTransferMonitor::activeTransfers() const
+{
+    QVector<DataTransferProgress> transfers;
+    transfers.reserve(d->transfers.count());
+    for (const DataTransferMonitorPrivate::Transfer *transfer : qAsConst(d->transfers)) {
+        transfers << d->progress(transfer);
+    }
+    return transfers;
+}
+
+void DataTransferMonitor::resetStatistics()
+{
+    d->statistics.clear();
+}
+
+}
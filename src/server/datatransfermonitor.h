@@ -0,0 +1,155 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include <QObject>
+#include <QVector>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+
+class ClientConnection;
+class DataTransferMonitorPrivate;
+class Display;
+
+/**
+ * @brief The data moved from one source client to one target client.
+ *
+ * The client pointers are only meant to identify the clients, @c source is @c null for data
+ * sources created by the compositor, e.g. the clipboard copy kept by the server.
+ *
+ * @see DataTransferMonitor::statistics
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT DataTransferStatistics
+{
+    ClientConnection *source = nullptr;
+    ClientConnection *target = nullptr;
+    /**
+     * The finished transfers, including the failed ones.
+     **/
+    quint64 transfers = 0;
+    quint64 failedTransfers = 0;
+    /**
+     * The transfers which didn't make progress for the stall timeout at least once.
+     **/
+    quint64 stalledTransfers = 0;
+    /**
+     * The transfers stopped because they exceeded the size limit of their mime type.
+     **/
+    quint64 refusedTransfers = 0;
+    quint64 bytes = 0;
+    /**
+     * The time spent in all finished transfers, in nanoseconds.
+     **/
+    qint64 duration = 0;
+};
+
+/**
+ * @brief A data transfer which is going on at the moment.
+ *
+ * @see DataTransferMonitor::activeTransfers
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT DataTransferProgress
+{
+    ClientConnection *source = nullptr;
+    ClientConnection *target = nullptr;
+    QString mimeType;
+    /**
+     * The bytes the target got so far.
+     **/
+    quint64 bytes = 0;
+    /**
+     * The time since the target asked for the data, in nanoseconds.
+     **/
+    qint64 elapsed = 0;
+    bool stalled = false;
+};
+
+/**
+ * @brief Watches the clipboard, primary selection and drag and drop transfers of a Display.
+ *
+ * While a DataTransferMonitor exists, the data a client receives from a data offer doesn't go
+ * straight from the source client to it. Instead the source writes into a pipe and a
+ * DataTransferRelay moves the data on to the receiving client, which lets the monitor count
+ * the bytes, time the transfer, notice transfers which stopped making progress and stop
+ * transfers larger than the size limit of their mime type. The relay moves the data inside
+ * the kernel, the overhead is a pipe and a few system calls per transfer.
+ *
+ * The statistics are kept per pair of source and target client and dropped once either of
+ * them disconnects.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT DataTransferMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DataTransferMonitor(Display *display, QObject *parent = nullptr);
+    ~DataTransferMonitor() override;
+
+    /**
+     * Stops transfers of @p mimeType after @p bytes, the receiving client then gets at most
+     * @p bytes. A mime type with the subtype @c * matches all mime types of its media type, an
+     * exact mime type wins over it. A limit of @c 0 removes the limit of @p mimeType.
+     **/
+    void setSizeLimit(const QString &mimeType, quint64 bytes);
+    /**
+     * @returns the size limit which applies to @p mimeType, @c 0 if it's not limited
+     **/
+    quint64 sizeLimit(const QString &mimeType) const;
+
+    /**
+     * Sets the time in milliseconds a transfer may go without moving any data before it is
+     * reported as stalled. Stalled transfers are not stopped. The default is 5 seconds.
+     **/
+    void setStallTimeout(int msec);
+    int stallTimeout() const;
+
+    /**
+     * @returns the statistics of all pairs of source and target client
+     **/
+    QVector<DataTransferStatistics> statistics() const;
+    /**
+     * @returns the statistics of the transfers from @p source to @p target
+     **/
+    DataTransferStatistics statistics(ClientConnection *source, ClientConnection *target) const;
+    /**
+     * @returns the transfers going on at the moment
+     **/
+    QVector<DataTransferProgress> activeTransfers() const;
+    /**
+     * Clears the statistics, the active transfers are still counted once they finish.
+     **/
+    void resetStatistics();
+
+Q_SIGNALS:
+    /**
+     * Emitted when a transfer didn't move any data for the stall timeout.
+     **/
+    void transferStalled(const KWaylandServer::DataTransferProgress &transfer);
+    /**
+     * Emitted when a transfer was stopped because it exceeded the size limit of its mime type.
+     **/
+    void transferRefused(const KWaylandServer::DataTransferProgress &transfer);
+    /**
+     * Emitted when a transfer ended, @p success is @c false if the source, the target or the
+     * size limit stopped it early.
+     **/
+    void transferFinished(const KWaylandServer::DataTransferProgress &transfer, bool success);
+
+private:
+    friend class DataTransferMonitorPrivate;
+    QScopedPointer<DataTransferMonitorPrivate> d;
+};
+
+}
+
+Q_DECLARE_METATYPE(KWaylandServer::DataTransferProgress)
@@ -0,0 +1,66 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include "datatransfermonitor.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPair>
+#include <QPointer>
+
+struct wl_client;
+
+namespace KWaylandServer
+{
+
+class AbstractDataSource;
+class DataTransferRelay;
+
+class DataTransferMonitorPrivate
+{
+public:
+    explicit DataTransferMonitorPrivate(DataTransferMonitor *q);
+
+    /**
+     * Passes the receive request of the client @p target for @p mimeType on to @p source,
+     * through the monitor of the display of @p target if there is one.
+     **/
+    static void requestData(AbstractDataSource *source, const QString &mimeType, qint32 fd, wl_client *target);
+
+    struct Transfer {
+        DataTransferRelay *relay = nullptr;
+        QPointer<ClientConnection> source;
+        QPointer<ClientConnection> target;
+        // the source is the compositor's, there is no source client
+        bool serverSource = false;
+        QString mimeType;
+        quint64 lastBytes = 0;
+        qint64 lastProgress = 0;
+        bool stalled = false;
+    };
+
+    void startTransfer(AbstractDataSource *source, const QString &mimeType, qint32 fd, ClientConnection *target);
+    void finishTransfer(Transfer *transfer, bool success);
+    void checkStalls();
+    DataTransferProgress progress(const Transfer *transfer) const;
+    /**
+     * @returns whether both clients of @p transfer are still connected
+     **/
+    bool isTracked(const Transfer *transfer) const;
+    DataTransferStatistics &statistics(const Transfer *transfer);
+
+    DataTransferMonitor *q;
+    QPointer<Display> display;
+    QHash<QString, quint64> sizeLimits;
+    int stallTimeout = 5000;
+    QTimer *stallTimer = nullptr;
+    QElapsedTimer clock;
+    QVector<Transfer *> transfers;
+    QHash<QPair<ClientConnection *, ClientConnection *>, DataTransferStatistics> statistics;
+};
+
+}
@@ -0,0 +1,390 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "datatransferrelay.h"
+#include "logging.h"
+// Qt
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QSocketNotifier>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+// what is taken from the source before it is passed on, at most one pipe buffer
+static const size_t s_chunkSize = 64 * 1024;
+// the copy through user space when a descriptor can't splice
+static const size_t s_spillSize = 4096;
+
+class DataTransferRelayPrivate
+{
+public:
+    explicit DataTransferRelayPrivate(DataTransferRelay *q);
+    ~DataTransferRelayPrivate();
+
+    void pump();
+    ssize_t fill();
+    ssize_t drain();
+    bool teeToCache(size_t length);
+    void waitFor(QSocketNotifier *notifier);
+    void finish(bool success);
+    void closeAll();
+
+    DataTransferRelay *q;
+    int source = -1;
+    int sink = -1;
+    int cache = -1;
+    // where the source is read from, -1 for its position
+    loff_t sourceOffset = -1;
+    // the data read from the source until the sink takes it
+    int buffer[2] = {-1, -1};
+    // the duplicate of buffer on the way to the cache
+    int cacheBuffer[2] = {-1, -1};
+    // the bytes in buffer and spill
+    size_t buffered = 0;
+    QByteArray spill;
+    bool sourceFinished = false;
+    bool active = false;
+
+    QSocketNotifier *sourceNotifier = nullptr;
+    QSocketNotifier *sinkNotifier = nullptr;
+
+    quint64 transferred = 0;
+    quint64 cached = 0;
+    quint64 received = 0;
+    quint64 sizeLimit = 0;
+    bool sizeLimitExceeded = false;
+    QElapsedTimer timer;
+    qint64 duration = -1;
+};
+
+static void closeFd(int &fd)
+{
+    if (fd != -1) {
+        close(fd);
+        fd = -1;
+    }
+}
+
+static void setNonBlocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+DataTransferRelayPrivate::DataTransferRelayPrivate(DataTransferRelay *q)
+    : q(q)
+{
+}
+
+DataTransferRelayPrivate::~DataTransferRelayPrivate()
+{
+    closeAll();
+}
+
+void DataTransferRelayPrivate::closeAll()
+{
+    closeFd(source);
+    closeFd(sink);
+    closeFd(cache);
+    closeFd(buffer[0]);
+    closeFd(buffer[1]);
+    closeFd(cacheBuffer[0]);
+    closeFd(cacheBuffer[1]);
+}
+
+ssize_t DataTransferRelayPrivate::fill()
+{
+    loff_t *offset = sourceOffset >= 0 ? &sourceOffset : nullptr;
+    const ssize_t count = splice(source, offset, buffer[1], nullptr, s_chunkSize, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    if (count >= 0 || (errno != EINVAL && errno != ENOSYS)) {
+        return count;
+    }
+    // the source can't splice, the empty pipe takes a whole spill at once
+    char data[s_spillSize];
+    const ssize_t read = offset ? pread(source, data, sizeof(data), *offset) : ::read(source, data, sizeof(data));
+    if (read <= 0) {
+        return read;
+    }
+    const ssize_t written = write(buffer[1], data, read);
+    if (offset && written > 0) {
+        *offset += written;
+    }
+    return written;
+}
+
+ssize_t DataTransferRelayPrivate::drain()
+{
+    if (spill.isEmpty()) {
+        const ssize_t count = splice(buffer[0], nullptr, sink, nullptr, buffered, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (count >= 0 || (errno != EINVAL && errno != ENOSYS)) {
+            return count;
+        }
+        // the sink can't splice, what the sink doesn't take is kept in the spill
+        spill.resize(qMin(buffered, s_spillSize));
+        const ssize_t read = ::read(buffer[0], spill.data(), spill.size());
+        if (read < 0) {
+            spill.clear();
+            return read;
+        }
+        spill.resize(read);
+    }
+    const ssize_t count = write(sink, spill.constData(), spill.size());
+    if (count > 0) {
+        spill.remove(0, count);
+    }
+    return count;
+}
+
+bool DataTransferRelayPrivate::teeToCache(size_t length)
+{
+    // the cache buffer is as large as the buffer and empty, a single tee duplicates all of it
+    ssize_t count;
+    do {
+        count = tee(buffer[0], cacheBuffer[1], length, SPLICE_F_NONBLOCK);
+    } while (count < 0 && errno == EINTR);
+    if (count != ssize_t(length)) {
+        return false;
+    }
+    while (length > 0) {
+        ssize_t moved = splice(cacheBuffer[0], nullptr, cache, nullptr, length, SPLICE_F_MOVE);
+        if (moved < 0 && (errno == EINVAL || errno == ENOSYS)) {
+            char data[s_spillSize];
+            moved = read(cacheBuffer[0], data, qMin(length, sizeof(data)));
+            if (moved > 0 && write(cache, data, moved) != moved) {
+                return false;
+            }
+        }
+        if (moved < 0 && errno == EINTR) {
+            continue;
+        }
+        if (moved <= 0) {
+            return false;
+        }
+        length -= moved;
+        cached += moved;
+    }
+    return true;
+}
+
+void DataTransferRelayPrivate::waitFor(QSocketNotifier *notifier)
+{
+    sourceNotifier->setEnabled(notifier == sourceNotifier);
+    sinkNotifier->setEnabled(notifier == sinkNotifier);
+}
+
+void DataTransferRelayPrivate::pump()
+{
+    // a sink with a closed reading end must not take the compositor down
+    sigset_t pipeSignal;
+    sigset_t previous;
+    sigemptyset(&pipeSignal);
+    sigaddset(&pipeSignal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSignal, &previous);
+    auto restoreSignals = [&]() {
+        if (!sigismember(&previous, SIGPIPE)) {
+            const timespec timeout = {0, 0};
+            while (sigtimedwait(&pipeSignal, nullptr, &timeout) > 0) {
+            }
+        }
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    };
+
+    while (true) {
+        if (buffered == 0) {
+            if (sourceFinished) {
+                restoreSignals();
+                finish(true);
+                return;
+            }
+            const ssize_t count = fill();
+            if (count < 0) {
+                const int error = errno;
+                if (error == EINTR) {
+                    continue;
+                }
+                restoreSignals();
+                if (error == EAGAIN) {
+                    waitFor(sourceNotifier);
+                } else {
+                    finish(false);
+                }
+                return;
+            }
+            if (count == 0) {
+                sourceFinished = true;
+                continue;
+            }
+            buffered = count;
+            received += count;
+            if (sizeLimit && received > sizeLimit) {
+                sizeLimitExceeded = true;
+                restoreSignals();
+                finish(false);
+                return;
+            }
+            if (cache != -1 && !teeToCache(buffered)) {
+                qCWarning(KWAYLAND_SERVER) << "Failed to write the cache of a data transfer";
+                restoreSignals();
+                finish(false);
+                return;
+            }
+        }
+
+        const ssize_t count = drain();
+        if (count < 0) {
+            const int error = errno;
+            if (error == EINTR) {
+                continue;
+            }
+            restoreSignals();
+            if (error == EAGAIN) {
+                waitFor(sinkNotifier);
+            } else {
+                finish(false);
+            }
+            return;
+        }
+        buffered -= count;
+        transferred += count;
+    }
+}
+
+void DataTransferRelayPrivate::finish(bool success)
+{
+    // this is running from the activated signal of one of the notifiers
+    sourceNotifier->setEnabled(false);
+    sourceNotifier->deleteLater();
+    sourceNotifier = nullptr;
+    sinkNotifier->setEnabled(false);
+    sinkNotifier->deleteLater();
+    sinkNotifier = nullptr;
+
+    closeAll();
+    spill.clear();
+    active = false;
+    duration = timer.nsecsElapsed();
+    emit q->finished(success);
+}
+
+DataTransferRelay::DataTransferRelay(QObject *parent)
+    : QObject(parent)
+    , d(new DataTransferRelayPrivate(this))
+{
+}
+
+DataTransferRelay::~DataTransferRelay() = default;
+
+void DataTransferRelay::setCacheFd(int fd)
+{
+    if (d->active || d->timer.isValid()) {
+        close(fd);
+        return;
+    }
+    closeFd(d->cache);
+    d->cache = fd;
+}
+
+void DataTransferRelay::setSizeLimit(quint64 bytes)
+{
+    d->sizeLimit = bytes;
+}
+
+bool DataTransferRelay::isSizeLimitExceeded() const
+{
+    return d->sizeLimitExceeded;
+}
+
+void DataTransferRelay::setSourceOffset(qint64 offset)
+{
+    if (d->active || d->timer.isValid()) {
+        return;
+    }
+    d->sourceOffset = offset;
+}
+
+bool DataTransferRelay::start(int source, int sink)
+{
+    // a relay is only used once
+    if (d->timer.isValid()) {
+        close(source);
+        close(sink);
+        return false;
+    }
+    d->source = source;
+    d->sink = sink;
+    d->timer.start();
+
+    if (pipe2(d->buffer, O_CLOEXEC | O_NONBLOCK) != 0) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create the pipe of a data transfer relay";
+        d->closeAll();
+        d->duration = 0;
+        return false;
+    }
+    if (d->cache != -1) {
+        if (pipe2(d->cacheBuffer, O_CLOEXEC | O_NONBLOCK) != 0) {
+            qCWarning(KWAYLAND_SERVER) << "Failed to create the pipe of a data transfer relay";
+            d->closeAll();
+            d->duration = 0;
+            return false;
+        }
+        const int size = fcntl(d->buffer[0], F_GETPIPE_SZ);
+        if (size > 0 && fcntl(d->cacheBuffer[0], F_GETPIPE_SZ) < size) {
+            fcntl(d->cacheBuffer[0], F_SETPIPE_SZ, size);
+        }
+    }
+    setNonBlocking(d->source);
+    setNonBlocking(d->sink);
+
+    d->sourceNotifier = new QSocketNotifier(d->source, QSocketNotifier::Read, this);
+    connect(d->sourceNotifier, &QSocketNotifier::activated, this, [this] {
+        d->pump();
+    });
+    d->sinkNotifier = new QSocketNotifier(d->sink, QSocketNotifier::Write, this);
+    d->sinkNotifier->setEnabled(false);
+    connect(d->sinkNotifier, &QSocketNotifier::activated, this, [this] {
+        d->pump();
+    });
+    d->active = true;
+    return true;
+}
+
+bool DataTransferRelay::isActive() const
+{
+    return d->active;
+}
+
+quint64 DataTransferRelay::bytesTransferred() const
+{
+    return d->transferred;
+}
+
+quint64 DataTransferRelay::bytesCached() const
+{
+    return d->cached;
+}
+
+qint64 DataTransferRelay::elapsed() const
+{
+    if (d->duration >= 0) {
+        return d->duration;
+    }
+    return d->timer.isValid() ? d->timer.nsecsElapsed() : 0;
+}
+
+double DataTransferRelay::throughput() const
+{
+    const qint64 nsecs = elapsed();
+    if (nsecs <= 0) {
+        return 0;
+    }
+    return d->transferred * 1e9 / nsecs;
+}
+
+}
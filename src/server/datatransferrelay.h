@@ -0,0 +1,103 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include <QObject>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+
+class DataTransferRelayPrivate;
+
+/**
+ * @brief Moves the data of a transfer between two file descriptors inside the kernel.
+ *
+ * AbstractDataSource::requestData passes the receiver's file descriptor straight to the
+ * source. When the compositor has to be in the middle of a transfer, e.g. to synchronize
+ * the clipboard with Xwayland or to inspect a drag and drop, it can instead give the
+ * source one end of a pipe and let a DataTransferRelay forward the data to the receiver.
+ * The data is moved with splice through a pipe owned by the relay, it never gets copied
+ * to user space unless one of the file descriptors doesn't support splicing.
+ *
+ * The relay runs on the event loop and never blocks, a slow receiver only stops the
+ * reading from the source until it caught up. Optionally the data is duplicated into a
+ * cache file with tee while it passes through.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT DataTransferRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DataTransferRelay(QObject *parent = nullptr);
+    ~DataTransferRelay() override;
+
+    /**
+     * Makes the relay write a copy of the data to @p fd, at its current position. The relay
+     * takes the ownership of @p fd. Has to be called before start().
+     **/
+    void setCacheFd(int fd);
+    /**
+     * Makes the relay fail once the source provided more than @p bytes, the sink then got
+     * at most @p bytes. @c 0, the default, doesn't limit the transfer.
+     **/
+    void setSizeLimit(quint64 bytes);
+    /**
+     * @returns whether the relay stopped because the source exceeded the size limit
+     * @see setSizeLimit
+     **/
+    bool isSizeLimitExceeded() const;
+    /**
+     * Makes the relay read the source from @p offset on without moving the position of the
+     * source, so several relays can share one file as their source. The source has to be a
+     * file then. Has to be called before start().
+     **/
+    void setSourceOffset(qint64 offset);
+
+    /**
+     * Starts moving the data from @p source to @p sink until @p source reaches its end. The
+     * relay takes the ownership of both file descriptors and closes them once it finished.
+     * @returns @c false if the relay could not be set up, finished is not emitted then
+     **/
+    bool start(int source, int sink);
+
+    /**
+     * @returns whether the relay is still moving data
+     **/
+    bool isActive() const;
+
+    /**
+     * @returns the bytes written to the sink so far
+     **/
+    quint64 bytesTransferred() const;
+    /**
+     * @returns the bytes written to the cache file so far
+     **/
+    quint64 bytesCached() const;
+    /**
+     * @returns the time from start() until now, or until the relay finished, in nanoseconds
+     **/
+    qint64 elapsed() const;
+    /**
+     * @returns the average throughput to the sink in bytes per second
+     **/
+    double throughput() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted once the relay stopped, @p success is @c false if it failed to read from the
+     * source or to write to the sink or the cache file.
+     **/
+    void finished(bool success);
+
+private:
+    QScopedPointer<DataTransferRelayPrivate> d;
+};
+
+}
@@ -0,0 +1,95 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "dispatchbudget_p.h"
+#include "clientconnection.h"
+#include "clientconnection_p.h"
+
+#include <time.h>
+
+namespace KWaylandServer
+{
+
+static qint64 threadCpuTime()
+{
+    timespec time;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time) != 0) {
+        return 0;
+    }
+    return qint64(time.tv_sec) * 1000000000 + time.tv_nsec;
+}
+
+void DispatchBudget::setBudget(wl_display *display, int requests)
+{
+    m_budget = qMax(requests, 0);
+    const bool enabled = m_budget > 0;
+    if (enabled == isEnabled()) {
+        return;
+    }
+    if (enabled) {
+        m_logger = wl_display_add_protocol_logger(display, logger, this);
+    } else {
+        wl_protocol_logger_destroy(m_logger);
+        m_logger = nullptr;
+        m_requests.clear();
+        m_lastClient = nullptr;
+    }
+}
+
+void DispatchBudget::begin()
+{
+    m_requests.clear();
+    m_lastClient = nullptr;
+}
+
+QVector<QPair<ClientConnection *, int>> DispatchBudget::end()
+{
+    charge(threadCpuTime());
+    m_lastClient = nullptr;
+
+    QVector<QPair<ClientConnection *, int>> exceeded;
+    for (auto it = m_requests.constBegin(); it != m_requests.constEnd(); ++it) {
+        if (it.value() > m_budget) {
+            ClientConnectionPrivate::get(it.key())->requestBudgetExceeded++;
+            exceeded.append(qMakePair(it.key(), it.value()));
+        }
+    }
+    m_requests.clear();
+    return exceeded;
+}
+
+void DispatchBudget::charge(qint64 now)
+{
+    if (m_lastClient) {
+        ClientConnectionPrivate::get(m_lastClient)->requestCpuTime += now - m_lastTime;
+    }
+    m_lastTime = now;
+}
+
+void DispatchBudget::logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    // events are sent from within the handlers, which are already charged
+    if (type != WL_PROTOCOL_LOGGER_REQUEST) {
+        return;
+    }
+    auto budget = static_cast<DispatchBudget *>(data);
+    // don't create a ClientConnection for a client which is being destroyed
+    ClientConnection *client = ClientConnectionPrivate::fromClient(wl_resource_get_client(message->resource));
+    budget->charge(threadCpuTime());
+    budget->m_lastClient = client;
+    if (client) {
+        budget->m_requests[client]++;
+    }
+}
+
+void DispatchBudget::removeClient(ClientConnection *client)
+{
+    m_requests.remove(client);
+    if (m_lastClient == client) {
+        m_lastClient = nullptr;
+    }
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include <QHash>
+#include <QVector>
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+
+class ClientConnection;
+
+/**
+ * Counts the requests each client gets dispatched within one iteration of the Wayland event
+ * loop and the thread CPU time spent on them, through a protocol logger. The time from one
+ * request to the next one is charged to the client of the first, so it includes the signal
+ * handlers of the compositor. The logger is only installed while a budget is set and has to
+ * be removed before the wl_display is destroyed.
+ */
+class DispatchBudget
+{
+public:
+    bool isEnabled() const {
+        return m_logger;
+    }
+    int budget() const {
+        return m_budget;
+    }
+    void setBudget(wl_display *display, int requests);
+
+    void begin();
+    /**
+     * Charges the time since the last request and returns the clients above the budget in
+     * this iteration together with their number of requests.
+     */
+    QVector<QPair<ClientConnection *, int>> end();
+
+    void removeClient(ClientConnection *client);
+
+private:
+    static void logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    void charge(qint64 now);
+
+    wl_protocol_logger *m_logger = nullptr;
+    int m_budget = 0;
+    QHash<ClientConnection *, int> m_requests;
+    ClientConnection *m_lastClient = nullptr;
+    qint64 m_lastTime = 0;
+};
+
+}
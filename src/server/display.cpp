@@ -6,12 +6,23 @@
 */
 #include "display.h"
 #include "display_p.h"
+#include "clientconnection_p.h"
+#include "fakeinput_interface_p.h"
 #include "logging.h"
+#include "output_interface.h"
+#include "outputdevice_interface.h"
+#include "performancesnapshot_p.h"
+#include "seat_interface.h"
+#include "shmconversion_p.h"
+#include "xdgoutput_v1_interface.h"
 
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDebug>
 #include <QAbstractEventDispatcher>
 
+#include <wayland-server-protocol.h>
+
 namespace KWaylandServer
 {
 
@@ -31,17 +42,52 @@ void DisplayPrivate::registerSocketName(const QString &socketName)
     emit q->socketNamesChanged();
 }
 
+void DisplayPrivate::scheduleBufferRelease(wl_client *client)
+{
+    bufferReleaseCount++;
+    if (!running) {
+        // there is no aboutToBlock which would flush the client later on
+        wl_client_flush(client);
+        return;
+    }
+    // the client may already be destroyed, getConnection() would create a new connection for it
+    ClientConnection *connection = ClientConnectionPrivate::fromClient(client);
+    if (!connection) {
+        wl_client_flush(client);
+        return;
+    }
+    if (pendingBufferReleaseClients.contains(connection)) {
+        coalescedBufferReleaseCount++;
+        return;
+    }
+    pendingBufferReleaseClients.insert(connection);
+}
+
 Display::Display(QObject *parent)
     : QObject(parent)
     , d(new DisplayPrivate(this))
 {
     d->display = wl_display_create();
     d->loop = wl_display_get_event_loop(d->display);
+    d->timerQueue.reset(new EventLoopTimerQueue(d->loop));
 }
 
 Display::~Display()
 {
+    d->protocolStatistics.setEnabled(d->display, false);
+    d->dispatchBudget.setBudget(d->display, 0);
+    d->protocolEventLog.setEnabled(d->display, false);
+    d->protocolRecorder.stop();
+
+    // the per-client state is dropped in one go rather than client by client
+    d->tearingDown = true;
+    d->clients.clear();
     wl_display_destroy_clients(d->display);
+    d->pendingBufferReleaseClients.clear();
+    d->congestionMonitoredClients.clear();
+    d->inputLatency.reset();
+    d->protocolStatistics.reset();
+    d->timerQueue.reset();
     wl_display_destroy(d->display);
 }
 
@@ -104,20 +150,312 @@ bool Display::start()
 
 void Display::dispatchEvents()
 {
+    const bool budget = d->dispatchBudget.isEnabled();
+    if (budget) {
+        d->dispatchBudget.begin();
+    }
     if (wl_event_loop_dispatch(d->loop, 0) != 0) {
         qCWarning(KWAYLAND_SERVER) << "Error on dispatching Wayland event loop";
     }
+    if (budget) {
+        const auto exceeded = d->dispatchBudget.end();
+        for (const auto &client : exceeded) {
+            emit clientRequestBudgetExceeded(client.first, client.second);
+        }
+    }
+    if (d->flushAfterDispatch) {
+        flush();
+    }
+}
+
+void Display::setFlushAfterDispatch(bool enabled)
+{
+    d->flushAfterDispatch = enabled;
+}
+
+bool Display::flushesAfterDispatch() const
+{
+    return d->flushAfterDispatch;
 }
 
 void Display::flush()
 {
+    // batched fake input may produce seat events, which have to make it into this flush
+    for (FakeInputInterface *fakeInput : qAsConst(d->fakeInputs)) {
+        FakeInputInterfacePrivate::get(fakeInput)->flushEvents();
+    }
+    for (SeatInterface *seat : qAsConst(d->seats)) {
+        seat->flushPointerMotion();
+    }
+    // wl_display_flush_clients() below pushes the released buffers out, too
+    d->pendingBufferReleaseClients.clear();
     wl_display_flush_clients(d->display);
+    d->flushCount++;
+    d->inputLatency.allClientsFlushed();
+    for (ClientConnection *client : qAsConst(d->congestionMonitoredClients)) {
+        ClientConnectionPrivate::get(client)->updateCongestion();
+    }
+}
+
+void Display::setInputLatencyTrackingEnabled(bool enabled)
+{
+    d->inputLatency.setEnabled(enabled);
+}
+
+bool Display::isInputLatencyTrackingEnabled() const
+{
+    return d->inputLatency.isEnabled();
+}
+
+InputLatencyHistogram Display::inputLatency(InputLatencyEventType type) const
+{
+    return d->inputLatency.histogram(type);
+}
+
+InputLatencyHistogram Display::inputLatency(InputLatencyEventType type, ClientConnection *client) const
+{
+    return d->inputLatency.histogram(type, client);
+}
+
+void Display::resetInputLatency()
+{
+    d->inputLatency.reset();
+}
+
+void Display::setProtocolStatisticsEnabled(bool enabled)
+{
+    d->protocolStatistics.setEnabled(d->display, enabled);
+}
+
+bool Display::isProtocolStatisticsEnabled() const
+{
+    return d->protocolStatistics.isEnabled();
+}
+
+ProtocolStatistics Display::protocolStatistics() const
+{
+    return d->protocolStatistics.statistics();
+}
+
+ProtocolStatistics Display::protocolStatistics(ClientConnection *client) const
+{
+    return d->protocolStatistics.statistics(client);
+}
+
+void Display::resetProtocolStatistics()
+{
+    d->protocolStatistics.reset();
+}
+
+void Display::setProtocolStatisticsDumpInterval(int interval)
+{
+    if (interval <= 0) {
+        delete d->protocolStatisticsDumpTimer;
+        d->protocolStatisticsDumpTimer = nullptr;
+        return;
+    }
+    if (!d->protocolStatisticsDumpTimer) {
+        d->protocolStatisticsDumpTimer = new QTimer(this);
+        connect(d->protocolStatisticsDumpTimer, &QTimer::timeout, this, [this] {
+            // the twenty message kinds with the most bytes
+            d->protocolStatistics.dump(20);
+        });
+    }
+    d->protocolStatisticsDumpTimer->start(interval);
+}
+
+int Display::protocolStatisticsDumpInterval() const
+{
+    return d->protocolStatisticsDumpTimer ? d->protocolStatisticsDumpTimer->interval() : 0;
+}
+
+void Display::setClientRequestBudget(int requests)
+{
+    d->dispatchBudget.setBudget(d->display, requests);
+}
+
+int Display::clientRequestBudget() const
+{
+    return d->dispatchBudget.budget();
+}
+
+bool Display::setProtocolEventLogEnabled(bool enabled)
+{
+    return d->protocolEventLog.setEnabled(d->display, enabled);
+}
+
+bool Display::isProtocolEventLogEnabled() const
+{
+    return d->protocolEventLog.isEnabled();
+}
+
+int Display::protocolEventLogFd() const
+{
+    return d->protocolEventLog.fd();
+}
+
+bool Display::dumpProtocolEventLog(int fd) const
+{
+    return d->protocolEventLog.dump(fd);
+}
+
+bool Display::startProtocolRecording(int fd)
+{
+    return d->protocolRecorder.start(d->display, fd);
+}
+
+bool Display::stopProtocolRecording()
+{
+    return d->protocolRecorder.stop();
+}
+
+bool Display::isProtocolRecording() const
+{
+    return d->protocolRecorder.isRecording();
+}
+
+void Display::beginOutputLayoutUpdate()
+{
+    if (d->outputLayoutUpdateDepth++ > 0) {
+        return;
+    }
+    for (OutputInterface *output : qAsConst(d->outputs)) {
+        output->beginUpdate();
+    }
+    for (XdgOutputV1Interface *output : qAsConst(d->xdgOutputs)) {
+        output->beginUpdate();
+    }
+    for (OutputDeviceInterface *output : qAsConst(d->outputdevices)) {
+        output->beginUpdate();
+    }
+}
+
+void Display::commitOutputLayoutUpdate()
+{
+    Q_ASSERT(d->outputLayoutUpdateDepth > 0);
+    if (--d->outputLayoutUpdateDepth > 0) {
+        return;
+    }
+    // the xdg-output events go first, so that clients binding version 3 get them in the same
+    // batch as the wl_output changes, terminated by a single wl_output done
+    const QList<XdgOutputV1Interface *> xdgOutputs = d->xdgOutputs;
+    for (XdgOutputV1Interface *output : xdgOutputs) {
+        output->commitUpdate();
+    }
+    const QList<OutputInterface *> outputs = d->outputs;
+    for (OutputInterface *output : outputs) {
+        output->commitUpdate();
+    }
+    const QList<OutputDeviceInterface *> outputDevices = d->outputdevices;
+    for (OutputDeviceInterface *output : outputDevices) {
+        output->commitUpdate();
+    }
+    flush();
+}
+
+quint64 Display::bufferReleaseCount() const
+{
+    return d->bufferReleaseCount;
+}
+
+quint64 Display::coalescedBufferReleaseCount() const
+{
+    return d->coalescedBufferReleaseCount;
+}
+
+PerformanceSnapshot Display::performanceSnapshot() const
+{
+    PerformanceSnapshot snapshot;
+    snapshot.timestamp = QDateTime::currentMSecsSinceEpoch();
+    snapshot.flushCount = d->flushCount;
+    snapshot.bufferReleaseCount = d->bufferReleaseCount;
+    snapshot.coalescedBufferReleaseCount = d->coalescedBufferReleaseCount;
+    snapshot.protocolStatistics = d->protocolStatistics.statistics();
+    for (int i = 0; i < PerformanceSnapshot::inputLatencyEventTypeCount; ++i) {
+        snapshot.inputLatency[i] = d->inputLatency.histogram(InputLatencyEventType(i));
+    }
+    snapshot.clients.reserve(d->clients.count());
+    for (ClientConnection *client : qAsConst(d->clients)) {
+        ClientPerformanceSnapshot clientSnapshot;
+        clientSnapshot.client = client;
+        clientSnapshot.processId = client->processId();
+        clientSnapshot.executablePath = client->executablePath();
+        clientSnapshot.memoryUsage = client->memoryUsage();
+        for (int i = 0; i < ClientPerformanceSnapshot::memoryCategoryCount; ++i) {
+            clientSnapshot.memoryUsageByCategory[i] = client->memoryUsage(ClientMemoryCategory(i));
+        }
+        clientSnapshot.pendingFrameCallbackCount = client->pendingFrameCallbackCount();
+        clientSnapshot.commitCount = client->commitCount();
+        clientSnapshot.commitsPerSecond = client->commitsPerSecond();
+        clientSnapshot.commitRateLimit = client->commitRateLimit();
+        clientSnapshot.commitRatePeriod = client->commitRatePeriod();
+        clientSnapshot.throttledCommitCount = client->throttledCommitCount();
+        clientSnapshot.requestCpuTime = client->requestCpuTime();
+        clientSnapshot.requestBudgetExceededCount = client->requestBudgetExceededCount();
+        clientSnapshot.queuedBytes = client->queuedBytes();
+        clientSnapshot.congested = client->isCongested();
+        snapshot.clients.append(clientSnapshot);
+    }
+    return snapshot;
+}
+
+bool Display::setPerformanceDBusExportEnabled(bool enabled)
+{
+    if (enabled == isPerformanceDBusExportEnabled()) {
+        return true;
+    }
+    if (!enabled) {
+        delete d->performanceDBusExport;
+        d->performanceDBusExport = nullptr;
+        return true;
+    }
+    auto dbusExport = new PerformanceDBusExport(this);
+    if (!dbusExport->registerObject()) {
+        qCWarning(KWAYLAND_SERVER) << "Could not export the performance snapshot on the session bus";
+        delete dbusExport;
+        return false;
+    }
+    d->performanceDBusExport = dbusExport;
+    return true;
+}
+
+bool Display::isPerformanceDBusExportEnabled() const
+{
+    return d->performanceDBusExport;
 }
 
 void Display::createShm()
 {
     Q_ASSERT(d->display);
     wl_display_init_shm(d->display);
+    for (quint32 format : qAsConst(d->shmFormats)) {
+        wl_display_add_shm_format(d->display, format);
+    }
+    d->shmCreated = true;
+}
+
+void Display::setShmFormats(const QVector<quint32> &formats)
+{
+    if (d->shmCreated) {
+        qCWarning(KWAYLAND_SERVER) << "The shm formats have to be set before the shm global is created";
+        return;
+    }
+    d->shmFormats.clear();
+    for (quint32 format : formats) {
+        if (format == WL_SHM_FORMAT_ARGB8888 || format == WL_SHM_FORMAT_XRGB8888 || d->shmFormats.contains(format)) {
+            continue;
+        }
+        if (ShmConversion::targetFormat(format) == QImage::Format_Invalid) {
+            qCWarning(KWAYLAND_SERVER) << "Ignoring shm format" << format << "which can't be converted";
+            continue;
+        }
+        d->shmFormats.append(format);
+    }
+}
+
+QVector<quint32> Display::shmFormats() const
+{
+    return QVector<quint32>{WL_SHM_FORMAT_ARGB8888, WL_SHM_FORMAT_XRGB8888} + d->shmFormats;
 }
 
 quint32 Display::nextSerial()
@@ -135,6 +473,11 @@ bool Display::isRunning() const
     return d->running;
 }
 
+bool Display::isTearingDown() const
+{
+    return d->tearingDown;
+}
+
 Display::operator wl_display*()
 {
     return d->display;
@@ -160,29 +503,39 @@ QVector<SeatInterface*> Display::seats() const
     return d->seats;
 }
 
-ClientConnection *Display::getConnection(wl_client *client)
+ClientConnection *DisplayPrivate::createConnection(wl_client *client)
 {
-    Q_ASSERT(client);
-    auto it = std::find_if(d->clients.constBegin(), d->clients.constEnd(),
-        [client](ClientConnection *c) {
-            return c->client() == client;
-        }
-    );
-    if (it != d->clients.constEnd()) {
-        return *it;
-    }
-    // no ConnectionData yet, create it
-    auto c = new ClientConnection(client, this);
-    d->clients << c;
-    connect(c, &ClientConnection::disconnected, this,
+    auto c = new ClientConnection(client, q);
+    clients << c;
+    QObject::connect(c, &ClientConnection::disconnected, q,
         [this] (ClientConnection *c) {
-            const int index = d->clients.indexOf(c);
+            if (tearingDown) {
+                emit q->clientDisconnected(c);
+                return;
+            }
+            const int index = clients.indexOf(c);
             Q_ASSERT(index != -1);
-            d->clients.remove(index);
-            Q_ASSERT(d->clients.indexOf(c) == -1);
-            emit clientDisconnected(c);
+            clients.remove(index);
+            Q_ASSERT(clients.indexOf(c) == -1);
+            pendingBufferReleaseClients.remove(c);
+            inputLatency.removeClient(c);
+            congestionMonitoredClients.remove(c);
+            protocolStatistics.removeClient(c);
+            dispatchBudget.removeClient(c);
+            emit q->clientDisconnected(c);
         }
     );
+    return c;
+}
+
+ClientConnection *Display::getConnection(wl_client *client)
+{
+    Q_ASSERT(client);
+    if (ClientConnection *c = ClientConnectionPrivate::fromClient(client)) {
+        return c;
+    }
+    // no ConnectionData yet, create it
+    auto c = d->createConnection(client);
     emit clientConnected(c);
     return c;
 }
@@ -204,6 +557,27 @@ ClientConnection *Display::createClient(int fd)
     return getConnection(c);
 }
 
+QVector<ClientConnection *> Display::createClients(const QVector<int> &fds)
+{
+    Q_ASSERT(d->display);
+    QVector<ClientConnection *> connections;
+    connections.reserve(fds.count());
+    d->clients.reserve(d->clients.count() + fds.count());
+    for (int fd : fds) {
+        Q_ASSERT(fd != -1);
+        wl_client *c = wl_client_create(d->display, fd);
+        if (!c) {
+            qCWarning(KWAYLAND_SERVER) << "Failed to create a client for fd" << fd;
+            continue;
+        }
+        connections << d->createConnection(c);
+    }
+    if (!connections.isEmpty()) {
+        emit clientsConnected(connections);
+    }
+    return connections;
+}
+
 void Display::setEglDisplay(void *display)
 {
     if (d->eglDisplay != EGL_NO_DISPLAY) {
@@ -211,6 +585,9 @@ void Display::setEglDisplay(void *display)
         return;
     }
     d->eglDisplay = (EGLDisplay)display;
+    if (d->eglDisplay != EGL_NO_DISPLAY) {
+        d->eglQueryWaylandBuffer = reinterpret_cast<DisplayPrivate::EglQueryWaylandBufferFunc>(eglGetProcAddress("eglQueryWaylandBufferWL"));
+    }
 }
 
 void *Display::eglDisplay() const
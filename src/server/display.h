@@ -13,6 +13,11 @@
 #include <KWaylandServer/kwaylandserver_export.h>
 
 #include "clientconnection.h"
+#include "inputlatency.h"
+#include "performancesnapshot.h"
+#include "protocoleventlog.h"
+#include "protocolrecording.h"
+#include "protocolstatistics.h"
 
 struct wl_client;
 struct wl_display;
@@ -90,6 +95,25 @@ public:
     bool start();
     void dispatchEvents();
 
+    /**
+     * Sets whether the clients are flushed right after each dispatch of the Wayland event loop.
+     *
+     * By default the events queued during a dispatch are only flushed once the Qt event loop
+     * is about to block. If the compositor does expensive work, like rendering a frame, before
+     * it returns to the event loop, the replies to the dispatched requests wait for it. With
+     * this enabled they are written to the clients before dispatchEvents() returns.
+     *
+     * Disabled by default.
+     * @since 5.22
+     **/
+    void setFlushAfterDispatch(bool enabled);
+    /**
+     * @returns Whether the clients are flushed after each dispatch.
+     * @see setFlushAfterDispatch
+     * @since 5.22
+     **/
+    bool flushesAfterDispatch() const;
+
     /**
      * Create a client for the given file descriptor.
      *
@@ -102,14 +126,60 @@ public:
      * @returns The new ClientConnection or @c null on failure.
      **/
     ClientConnection *createClient(int fd);
+    /**
+     * Creates clients for all the given @p fds at once, e.g. for the sockets handed out to
+     * applications started together with the session.
+     *
+     * Unlike createClient() the clientConnected signal is not emitted for the new
+     * connections, instead clientsConnected is emitted once with all of them. The
+     * credentials of the clients are resolved lazily like for any other connection.
+     *
+     * @param fds The file descriptors for the sockets to the clients
+     * @returns The new ClientConnections, without the ones that could not be created.
+     * @see createClient
+     * @since 5.22
+     **/
+    QVector<ClientConnection *> createClients(const QVector<int> &fds);
 
     operator wl_display*();
     operator wl_display*() const;
     bool isRunning() const;
+    /**
+     * @returns Whether the Display is being destroyed and tears down all of its clients.
+     *
+     * All clients and their resources are destroyed at once, the library skips the change
+     * signals of the objects which die with them, e.g. SurfaceInterface::childSubSurfaceRemoved,
+     * and connections() is empty. The clientDisconnected and destroyed signals are still emitted,
+     * handlers can check this to drop their per-object bookkeeping instead of updating it.
+     * @since 5.22
+     **/
+    bool isTearingDown() const;
 
     void createShm();
     /**
-     * @returns All SeatInterface currently managed on the Display.
+     * Sets the wl_shm formats advertised in addition to @c WL_SHM_FORMAT_ARGB8888 and
+     * @c WL_SHM_FORMAT_XRGB8888, which every compositor supports. Formats which
+     * BufferInterface::convertTo() can't convert are ignored, so a compositor reading shm
+     * buffers with convertTo() can advertise e.g. @c WL_SHM_FORMAT_RGB565 for clients that
+     * want to use less memory.
+     *
+     * libwayland can't withdraw an advertised format, so the formats have to be set before
+     * createShm() is called.
+     *
+     * @see shmFormats
+     * @since 5.22
+     **/
+    void setShmFormats(const QVector<quint32> &formats);
+    /**
+     * @returns The advertised wl_shm formats, including the two mandatory ones.
+     * @see setShmFormats
+     * @since 5.22
+     **/
+    QVector<quint32> shmFormats() const;
+    /**
+     * @returns All SeatInterface currently managed on the Display. The list is shared with
+     * the Display, so calling this doesn't copy the seats. To find the seat of a wl_seat
+     * resource use SeatInterface::get() instead of searching the list.
      * @since 5.6
      **/
     QVector<SeatInterface*> seats() const;
@@ -142,6 +212,245 @@ public:
      **/
     void *eglDisplay() const;
 
+    /**
+     * Returns the number of wl_buffer.release events sent since the Display got created.
+     *
+     * Released buffers are not flushed to the client immediately, all releases happening
+     * within one dispatch cycle get flushed together once the event loop is about to block.
+     *
+     * @see coalescedBufferReleaseCount
+     * @since 5.22
+     **/
+    quint64 bufferReleaseCount() const;
+    /**
+     * Returns the number of wl_buffer.release events which did not need a flush of their own
+     * because another buffer of the same client had been released in the same dispatch cycle.
+     *
+     * @see bufferReleaseCount
+     * @since 5.22
+     **/
+    quint64 coalescedBufferReleaseCount() const;
+
+    /**
+     * Sets whether the time input events spend inside the server is measured.
+     *
+     * For each input event sent to a client, the time between the seat receiving it and the
+     * client being flushed is recorded in a histogram for the event type and the client. The
+     * entry time is taken when the seat method is called, e.g. SeatInterface::setPointerPos(),
+     * so the compositor should call it as soon as the event has been read from the device.
+     *
+     * Tracking is disabled by default. Disabling it keeps the recorded histograms.
+     *
+     * @see inputLatency
+     * @since 5.22
+     **/
+    void setInputLatencyTrackingEnabled(bool enabled);
+    /**
+     * @returns Whether input latency is tracked.
+     * @since 5.22
+     **/
+    bool isInputLatencyTrackingEnabled() const;
+    /**
+     * @returns The latency histogram of all events of @p type sent to any client.
+     * @since 5.22
+     **/
+    InputLatencyHistogram inputLatency(InputLatencyEventType type) const;
+    /**
+     * @returns The latency histogram of the events of @p type sent to @p client. The
+     * histograms of a client are dropped when it disconnects.
+     * @since 5.22
+     **/
+    InputLatencyHistogram inputLatency(InputLatencyEventType type, ClientConnection *client) const;
+    /**
+     * Clears all input latency histograms.
+     * @since 5.22
+     **/
+    void resetInputLatency();
+
+    /**
+     * Sets whether the requests and events of all clients are counted.
+     *
+     * The counters are kept per client and per message of every interface, so they cover
+     * all globals. When disabled, no protocol logger is installed and there is no
+     * overhead. Disabling it keeps the counters.
+     *
+     * @see protocolStatistics
+     * @since 5.22
+     **/
+    void setProtocolStatisticsEnabled(bool enabled);
+    /**
+     * @returns Whether protocol messages are counted.
+     * @since 5.22
+     **/
+    bool isProtocolStatisticsEnabled() const;
+    /**
+     * @returns A snapshot of the message counters of all connected clients.
+     * @since 5.22
+     **/
+    ProtocolStatistics protocolStatistics() const;
+    /**
+     * @returns A snapshot of the message counters of @p client. The counters of a client are
+     * dropped when it disconnects.
+     * @since 5.22
+     **/
+    ProtocolStatistics protocolStatistics(ClientConnection *client) const;
+    /**
+     * Clears all protocol message counters.
+     * @since 5.22
+     **/
+    void resetProtocolStatistics();
+    /**
+     * Sets the interval in milliseconds in which the message kinds with the most traffic are
+     * logged to the KWAYLAND_SERVER category. @c 0, the default, disables the dump.
+     * @see setProtocolStatisticsEnabled
+     * @since 5.22
+     **/
+    void setProtocolStatisticsDumpInterval(int interval);
+    /**
+     * @see setProtocolStatisticsDumpInterval
+     * @since 5.22
+     **/
+    int protocolStatisticsDumpInterval() const;
+
+    /**
+     * Sets how many requests of a single client one dispatch of the Wayland event loop may
+     * handle before the client is reported with clientRequestBudgetExceeded().
+     *
+     * libwayland reads a client once per dispatch and handles all requests it read, so a
+     * client can't be stopped in the middle of a dispatch. The compositor can deprioritize the
+     * reported clients instead, e.g. with ClientConnection::setCommitRateLimit(). While a budget
+     * is set the CPU time of the requests of each client is accounted as well, see
+     * ClientConnection::requestCpuTime().
+     *
+     * The default value @c 0 disables the budget and installs no protocol logger.
+     * @since 5.22
+     **/
+    void setClientRequestBudget(int requests);
+    /**
+     * @see setClientRequestBudget
+     * @since 5.22
+     **/
+    int clientRequestBudget() const;
+
+    /**
+     * Sets whether the requests and events of all clients are recorded in the protocol event
+     * log, a ring buffer of binary records of the most recent messages.
+     *
+     * Unlike @c WAYLAND_DEBUG=server nothing is formatted: a record holds the time, the client,
+     * the object, the opcode and a digest of the arguments, which is cheap enough to leave the
+     * log enabled in production. It is meant to be dumped after a crash or on a signal, see
+     * dumpProtocolEventLog(). Disabling the log discards it.
+     *
+     * @returns @c false if the memory for the log could not be allocated.
+     * @see ProtocolEventLogHeader
+     * @since 5.22
+     **/
+    bool setProtocolEventLogEnabled(bool enabled);
+    /**
+     * @returns Whether protocol messages are recorded in the protocol event log.
+     * @since 5.22
+     **/
+    bool isProtocolEventLogEnabled() const;
+    /**
+     * @returns The memfd holding the protocol event log, @c -1 if the log is disabled or not
+     * backed by a memfd. It stays owned by the Display; another process can map it read-only
+     * to inspect the log of a compositor that hangs.
+     * @since 5.22
+     **/
+    int protocolEventLogFd() const;
+    /**
+     * Writes the protocol event log with its ProtocolEventLogHeader to @p fd. The function is
+     * async-signal-safe, so it can be called from a crash or signal handler.
+     *
+     * @returns @c false if the log is disabled or could not be written.
+     * @since 5.22
+     **/
+    bool dumpProtocolEventLog(int fd) const;
+
+    /**
+     * Starts writing the requests of all clients to @p fd, see ProtocolRecordingHeader for
+     * the format. Together with the content of the requests their time and the file
+     * descriptors they carry are recorded, so ProtocolReplayer can send them to another
+     * Display later on, e.g. to compare the cost of a captured session between releases.
+     *
+     * Clients are identified by the order of their first request. To get a recording that
+     * can be replayed, start it before any client connects. The fd is not owned and has to
+     * stay open until stopProtocolRecording().
+     *
+     * Unlike the protocol event log the recording holds everything a client sent, including
+     * text typed into input methods and clipboard mime types, and grows without bound.
+     *
+     * @returns @c false if a recording is already running or the header could not be written.
+     * @see ProtocolReplayer
+     * @since 5.22
+     **/
+    bool startProtocolRecording(int fd);
+    /**
+     * Stops the protocol recording and writes the remaining buffered requests.
+     *
+     * @returns @c false if no recording was running or writing it failed at some point.
+     * @since 5.22
+     **/
+    bool stopProtocolRecording();
+    /**
+     * @returns Whether the requests are written to a protocol recording.
+     * @since 5.22
+     **/
+    bool isProtocolRecording() const;
+
+    /**
+     * Starts an update of the output layout spanning all outputs.
+     *
+     * Until the matching commitOutputLayoutUpdate() no property change of any OutputInterface,
+     * XdgOutputV1Interface or OutputDeviceInterface is sent to the clients, as if beginUpdate()
+     * had been called on each of them. Outputs created in the meantime are included. This way
+     * applying an OutputConfigurationInterface which moves several outputs doesn't show the
+     * clients the invalid layouts in between.
+     *
+     * Calls can be nested, the changes are sent by the outermost commitOutputLayoutUpdate().
+     * @see OutputInterface::beginUpdate
+     * @since 5.22
+     **/
+    void beginOutputLayoutUpdate();
+    /**
+     * Ends the update started by beginOutputLayoutUpdate(). The changes of all outputs are sent
+     * and flushed to the clients together. As outside of an update, the geometry of an
+     * XdgOutputV1Interface is only sent if XdgOutputV1Interface::done() was called for it.
+     * @since 5.22
+     **/
+    void commitOutputLayoutUpdate();
+
+    /**
+     * @returns The performance counters of the Display and of all connected clients, in one
+     * place: the flush and buffer release counts, the protocol statistics, the input latency
+     * histograms and per client the memory usage, the frame callback backlog, the commit rate
+     * and throttling, the request CPU time and the socket congestion.
+     *
+     * Taking a snapshot only copies counters which are kept anyway, so it is cheap enough to
+     * be scraped periodically.
+     *
+     * @see setPerformanceDBusExportEnabled
+     * @since 5.22
+     **/
+    PerformanceSnapshot performanceSnapshot() const;
+    /**
+     * Sets whether performanceSnapshot() is exported on the session bus, as the method
+     * @c Snapshot of the interface @c org.kde.KWaylandServer.Performance at the path
+     * @c /org/kde/KWaylandServer/Performance. It returns PerformanceSnapshot::toVariantMap().
+     *
+     * Disabled by default.
+     *
+     * @returns @c false if the object could not be registered, e.g. because there is no session
+     * bus or another Display of the process exports its snapshot already.
+     * @since 5.22
+     **/
+    bool setPerformanceDBusExportEnabled(bool enabled);
+    /**
+     * @see setPerformanceDBusExportEnabled
+     * @since 5.22
+     **/
+    bool isPerformanceDBusExportEnabled() const;
+
 private Q_SLOTS:
     void flush();
 
@@ -149,7 +458,18 @@ Q_SIGNALS:
     void socketNamesChanged();
     void runningChanged(bool);
     void clientConnected(KWaylandServer::ClientConnection*);
+    /**
+     * Emitted once with all connections created by createClients().
+     * @since 5.22
+     **/
+    void clientsConnected(const QVector<KWaylandServer::ClientConnection *> &connections);
     void clientDisconnected(KWaylandServer::ClientConnection*);
+    /**
+     * Emitted after a dispatch in which @p client sent @p requests requests, more than the
+     * clientRequestBudget().
+     * @since 5.22
+     **/
+    void clientRequestBudgetExceeded(KWaylandServer::ClientConnection *client, int requests);
 
 private:
     friend class DisplayPrivate;
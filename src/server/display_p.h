@@ -7,11 +7,22 @@
 
 #pragma once
 
+#include "dispatchbudget_p.h"
+#include "eventlooptimer_p.h"
+#include "inputlatency_p.h"
+#include "protocoleventlog_p.h"
+#include "protocolrecorder_p.h"
+#include "protocolstatistics_p.h"
+
 #include <wayland-server-core.h>
 
 #include <QList>
+#include <QPointer>
+#include <QScopedPointer>
+#include <QSet>
 #include <QSocketNotifier>
 #include <QString>
+#include <QTimer>
 #include <QVector>
 
 #include <EGL/egl.h>
@@ -21,9 +32,13 @@ namespace KWaylandServer
 
 class ClientConnection;
 class Display;
+class DataTransferMonitor;
+class FakeInputInterface;
 class OutputInterface;
 class OutputDeviceInterface;
 class SeatInterface;
+class PerformanceDBusExport;
+class XdgOutputV1Interface;
 
 class DisplayPrivate
 {
@@ -32,18 +47,54 @@ public:
     DisplayPrivate(Display *q);
 
     void registerSocketName(const QString &socketName);
+    void scheduleBufferRelease(wl_client *client);
+    /**
+     * Creates the ClientConnection for @p client without announcing it.
+     */
+    ClientConnection *createConnection(wl_client *client);
 
     Display *q;
     QSocketNotifier *socketNotifier = nullptr;
     wl_display *display = nullptr;
     wl_event_loop *loop = nullptr;
+    // shared by the EventLoopTimers, destroyed together with the clients
+    QScopedPointer<EventLoopTimerQueue> timerQueue;
     bool running = false;
+    // set in ~Display while all clients get destroyed, see Display::isTearingDown()
+    bool tearingDown = false;
+    bool flushAfterDispatch = false;
     QList<OutputInterface *> outputs;
     QList<OutputDeviceInterface *> outputdevices;
+    QList<XdgOutputV1Interface *> xdgOutputs;
+    // outputs created during an output layout update join it
+    int outputLayoutUpdateDepth = 0;
     QVector<SeatInterface *> seats;
+    // fake input globals whose batched events are delivered before the clients are flushed
+    QVector<FakeInputInterface *> fakeInputs;
     QVector<ClientConnection *> clients;
     QStringList socketNames;
+    bool shmCreated = false;
+    // the formats advertised besides ARGB8888 and XRGB8888
+    QVector<quint32> shmFormats;
     EGLDisplay eglDisplay = EGL_NO_DISPLAY;
+    // eglQueryWaylandBufferWL, resolved when the EGLDisplay is set, null if EGL lacks it
+    using EglQueryWaylandBufferFunc = EGLBoolean (*)(EGLDisplay dpy, wl_resource *buffer, EGLint attribute, EGLint *value);
+    EglQueryWaylandBufferFunc eglQueryWaylandBuffer = nullptr;
+    // clients with released buffers waiting for the next flush
+    QSet<ClientConnection *> pendingBufferReleaseClients;
+    quint64 bufferReleaseCount = 0;
+    quint64 coalescedBufferReleaseCount = 0;
+    quint64 flushCount = 0;
+    InputLatencyTracker inputLatency;
+    // clients with a high-water mark, checked for congestion after each flush
+    QSet<ClientConnection *> congestionMonitoredClients;
+    DispatchBudget dispatchBudget;
+    ProtocolStatisticsRecorder protocolStatistics;
+    QTimer *protocolStatisticsDumpTimer = nullptr;
+    ProtocolEventLog protocolEventLog;
+    ProtocolRecorder protocolRecorder;
+    QPointer<DataTransferMonitor> dataTransferMonitor;
+    PerformanceDBusExport *performanceDBusExport = nullptr;
 };
 
 } // namespace KWaylandServer
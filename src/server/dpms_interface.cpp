@@ -15,23 +15,33 @@ static const quint32 s_version = 1;
 DpmsManagerInterfacePrivate::DpmsManagerInterfacePrivate(DpmsManagerInterface *_q, Display *display)
     : QtWaylandServer::org_kde_kwin_dpms_manager(*display, s_version)
     , q(_q)
+    , inert(new DpmsInterface(nullptr))
 {
 }
 
+DpmsManagerInterfacePrivate::~DpmsManagerInterfacePrivate()
+{
+    qDeleteAll(outputs);
+    delete inert;
+}
+
 void DpmsManagerInterfacePrivate::org_kde_kwin_dpms_manager_get(Resource *resource, uint32_t id, wl_resource *output)
 {
     OutputInterface *o = OutputInterface::get(output);
-
-    wl_resource *dpms_resource = wl_resource_create(resource->client(), &org_kde_kwin_dpms_interface, resource->version(), id);
-    if (!dpms_resource) {
-        wl_client_post_no_memory(resource->client());
+    if (!o) {
+        inert->add(resource->client(), id, resource->version());
         return;
     }
-    auto dpms = new DpmsInterface(o, dpms_resource);
 
-    dpms->sendSupported();
-    dpms->sendMode();
-    dpms->sendDone();
+    DpmsInterface *dpms = outputs.value(o);
+    if (!dpms) {
+        dpms = new DpmsInterface(o);
+        outputs.insert(o, dpms);
+        QObject::connect(o, &QObject::destroyed, q, [this, o] {
+            delete outputs.take(o);
+        });
+    }
+    dpms->add(resource->client(), id, resource->version());
 }
 
 DpmsManagerInterface::DpmsManagerInterface(Display *display, QObject *parent)
@@ -42,41 +52,65 @@ DpmsManagerInterface::DpmsManagerInterface(Display *display, QObject *parent)
 
 DpmsManagerInterface::~DpmsManagerInterface() = default;
 
-DpmsInterface::DpmsInterface(OutputInterface *output, wl_resource *resource)
+DpmsInterface::DpmsInterface(OutputInterface *output)
     : QObject()
-    , QtWaylandServer::org_kde_kwin_dpms(resource)
     , output(output)
 {
+    if (!output) {
+        return;
+    }
     connect(output, &OutputInterface::dpmsSupportedChanged, this,
         [this] {
-            sendSupported();
-            sendDone();
+            const auto clientResources = resourceMap();
+            for (Resource *resource : clientResources) {
+                sendSupported(resource);
+                send_done(resource->handle);
+            }
         }
     );
     connect(output, &OutputInterface::dpmsModeChanged, this,
         [this] {
-            sendMode();
-            sendDone();
+            const auto clientResources = resourceMap();
+            for (Resource *resource : clientResources) {
+                sendMode(resource);
+                send_done(resource->handle);
+            }
         }
     );
 }
 
-DpmsInterface::~DpmsInterface() = default;
+DpmsInterface::~DpmsInterface()
+{
+#if QT_VERSION < QT_VERSION_CHECK(5, 15, 2)
+    // the resources can outlive the output, destroy them so pending requests no-op
+    const auto clientResources = resourceMap();
+    for (Resource *resource : clientResources) {
+        wl_resource_destroy(resource->handle);
+    }
+#endif
+}
 
-void DpmsInterface::org_kde_kwin_dpms_release(Resource *resource)
+void DpmsInterface::org_kde_kwin_dpms_bind_resource(Resource *resource)
 {
-    wl_resource_destroy(resource->handle);
+    if (!output) {
+        return;
+    }
+    sendSupported(resource);
+    sendMode(resource);
+    send_done(resource->handle);
 }
 
-void DpmsInterface::org_kde_kwin_dpms_destroy_resource(Resource *resource)
+void DpmsInterface::org_kde_kwin_dpms_release(Resource *resource)
 {
-    Q_UNUSED(resource)
-    delete this;
+    wl_resource_destroy(resource->handle);
 }
 
 void DpmsInterface::org_kde_kwin_dpms_set(Resource *resource, uint32_t mode)
 {
     Q_UNUSED(resource)
+    if (!output) {
+        return;
+    }
     OutputInterface::DpmsMode dpmsMode;
     switch (mode) {
     case ORG_KDE_KWIN_DPMS_MODE_ON:
@@ -97,12 +131,12 @@ void DpmsInterface::org_kde_kwin_dpms_set(Resource *resource, uint32_t mode)
     emit output->dpmsModeRequested(dpmsMode);
 }
 
-void DpmsInterface::sendSupported()
+void DpmsInterface::sendSupported(Resource *resource)
 {
-    send_supported(output->isDpmsSupported() ? 1 : 0);
+    send_supported(resource->handle, output->isDpmsSupported() ? 1 : 0);
 }
 
-void DpmsInterface::sendMode()
+void DpmsInterface::sendMode(Resource *resource)
 {
     const auto mode = output->dpmsMode();
     org_kde_kwin_dpms_mode wlMode;
@@ -122,12 +156,7 @@ void DpmsInterface::sendMode()
     default:
         Q_UNREACHABLE();
     }
-    send_mode(wlMode);
-}
-
-void DpmsInterface::sendDone()
-{
-    send_done();
+    send_mode(resource->handle, wlMode);
 }
 
 }
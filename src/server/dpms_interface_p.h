@@ -8,39 +8,49 @@
 
 #include "dpms_interface.h"
 
+#include <QHash>
+
 #include <qwayland-server-dpms.h>
 
 namespace KWaylandServer
 {
 
 class OutputInterface;
+class DpmsInterface;
 
 class DpmsManagerInterfacePrivate : public QtWaylandServer::org_kde_kwin_dpms_manager
 {
 public:
     DpmsManagerInterfacePrivate(DpmsManagerInterface *q, Display *d);
+    ~DpmsManagerInterfacePrivate() override;
 
     DpmsManagerInterface *q;
+    QHash<OutputInterface *, DpmsInterface *> outputs;
+    // holds the resources created for outputs which are already gone
+    DpmsInterface *inert;
 
 protected:
     void org_kde_kwin_dpms_manager_get(Resource *resource, uint32_t id, wl_resource *output) override;
 };
 
-class DpmsInterface : public QObject, QtWaylandServer::org_kde_kwin_dpms
+/**
+ * The org_kde_kwin_dpms resources of one output. All clients share it, so a DPMS change
+ * is sent to the resources directly instead of through a connection per resource.
+ */
+class DpmsInterface : public QObject, public QtWaylandServer::org_kde_kwin_dpms
 {
     Q_OBJECT
 public:
-    explicit DpmsInterface(OutputInterface *output, wl_resource *resource);
+    explicit DpmsInterface(OutputInterface *output);
     ~DpmsInterface() override;
 
-    void sendSupported();
-    void sendMode();
-    void sendDone();
+    void sendSupported(Resource *resource);
+    void sendMode(Resource *resource);
 
     OutputInterface *output;
 
 protected:
-    void org_kde_kwin_dpms_destroy_resource(Resource *resource) override;
+    void org_kde_kwin_dpms_bind_resource(Resource *resource) override;
     void org_kde_kwin_dpms_set(Resource *resource, uint32_t mode) override;
     void org_kde_kwin_dpms_release(Resource *resource) override;
 
@@ -0,0 +1,159 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "eventlooptimer_p.h"
+#include "display.h"
+#include "display_p.h"
+
+#include <wayland-server-core.h>
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+namespace KWaylandServer
+{
+
+// timers due this long after the earliest deadline fire in the same wakeup
+static const qint64 s_coalescingSlack = 5;
+
+EventLoopTimerQueue::EventLoopTimerQueue(wl_event_loop *loop)
+    : m_source(wl_event_loop_add_timer(loop, handleTimeout, this))
+{
+}
+
+EventLoopTimerQueue::~EventLoopTimerQueue()
+{
+    for (const auto &entry : m_deadlines) {
+        entry.second->m_active = false;
+    }
+    if (m_source) {
+        wl_event_source_remove(m_source);
+    }
+}
+
+qint64 EventLoopTimerQueue::now()
+{
+    using namespace std::chrono;
+    return duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+void EventLoopTimerQueue::schedule(EventLoopTimer *timer, qint64 deadline)
+{
+    timer->m_position = m_deadlines.emplace(deadline, timer);
+    timer->m_sequence = ++m_sequence;
+    timer->m_active = true;
+    // a deadline shortly after the armed one is served by the same wakeup
+    if (m_armedDeadline == -1 || deadline + s_coalescingSlack < m_armedDeadline) {
+        arm();
+    }
+}
+
+void EventLoopTimerQueue::cancel(EventLoopTimer *timer)
+{
+    m_deadlines.erase(timer->m_position);
+    timer->m_active = false;
+    // an early wakeup just re-arms for the next deadline, only an empty queue disarms
+    if (m_deadlines.empty()) {
+        arm();
+    }
+}
+
+void EventLoopTimerQueue::arm()
+{
+    if (!m_source) {
+        return;
+    }
+    if (m_deadlines.empty()) {
+        m_armedDeadline = -1;
+        wl_event_source_timer_update(m_source, 0);
+        return;
+    }
+    m_armedDeadline = m_deadlines.begin()->first;
+    // a delay of 0 would disarm the timerfd, overdue timers fire with the next dispatch
+    const qint64 delay = std::max<qint64>(m_armedDeadline - now(), 1);
+    wl_event_source_timer_update(m_source, int(std::min<qint64>(delay, std::numeric_limits<int>::max())));
+}
+
+int EventLoopTimerQueue::handleTimeout(void *data)
+{
+    static_cast<EventLoopTimerQueue *>(data)->dispatch();
+    return 0;
+}
+
+void EventLoopTimerQueue::dispatch()
+{
+    m_armedDeadline = -1;
+    const qint64 limit = now() + s_coalescingSlack;
+    const quint64 sequence = m_sequence;
+
+    // callbacks may start, stop or delete any timer, so look at the front again after each one
+    auto it = m_deadlines.begin();
+    while (it != m_deadlines.end() && it->first <= limit) {
+        EventLoopTimer *timer = it->second;
+        if (timer->m_sequence > sequence) {
+            ++it;
+            continue;
+        }
+        m_deadlines.erase(it);
+        timer->m_active = false;
+        // the callback may delete the timer and with it the function
+        const std::function<void()> callback = timer->m_callback;
+        if (callback) {
+            callback();
+        }
+        it = m_deadlines.begin();
+    }
+
+    arm();
+}
+
+EventLoopTimer::EventLoopTimer(Display *display)
+    : m_display(display)
+{
+}
+
+EventLoopTimer::~EventLoopTimer()
+{
+    stop();
+}
+
+EventLoopTimerQueue *EventLoopTimer::queue() const
+{
+    if (!m_display) {
+        return nullptr;
+    }
+    return DisplayPrivate::get(m_display)->timerQueue.data();
+}
+
+void EventLoopTimer::setCallback(std::function<void()> callback)
+{
+    m_callback = std::move(callback);
+}
+
+void EventLoopTimer::start(qint64 msec)
+{
+    EventLoopTimerQueue *timerQueue = queue();
+    if (!timerQueue) {
+        return;
+    }
+    if (m_active) {
+        timerQueue->cancel(this);
+    }
+    timerQueue->schedule(this, EventLoopTimerQueue::now() + std::max<qint64>(msec, 0));
+}
+
+void EventLoopTimer::stop()
+{
+    if (!m_active) {
+        return;
+    }
+    if (EventLoopTimerQueue *timerQueue = queue()) {
+        timerQueue->cancel(this);
+    }
+    m_active = false;
+}
+
+}
@@ -0,0 +1,94 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_EVENTLOOPTIMER_P_H
+#define KWAYLAND_SERVER_EVENTLOOPTIMER_P_H
+
+#include <QPointer>
+
+#include <functional>
+#include <map>
+
+struct wl_event_loop;
+struct wl_event_source;
+
+namespace KWaylandServer
+{
+
+class Display;
+class EventLoopTimer;
+
+/**
+ * The deadlines of all EventLoopTimers of a Display, sorted in a single queue. One timerfd
+ * source on the event loop of the Display is armed for the earliest deadline, all timers which
+ * are due within a few milliseconds of it fire in the same wakeup.
+ */
+class EventLoopTimerQueue
+{
+public:
+    explicit EventLoopTimerQueue(wl_event_loop *loop);
+    ~EventLoopTimerQueue();
+
+    void schedule(EventLoopTimer *timer, qint64 deadline);
+    void cancel(EventLoopTimer *timer);
+
+    /**
+     * @returns the current time of the monotonic clock the deadlines refer to, in milliseconds
+     */
+    static qint64 now();
+
+private:
+    typedef std::multimap<qint64, EventLoopTimer *> Deadlines;
+    static int handleTimeout(void *data);
+    void dispatch();
+    void arm();
+
+    wl_event_source *m_source = nullptr;
+    Deadlines m_deadlines;
+    // the deadline the timerfd fires for, -1 if it is disarmed
+    qint64 m_armedDeadline = -1;
+    // timers (re)started by a callback don't fire again in the same wakeup
+    quint64 m_sequence = 0;
+    friend class EventLoopTimer;
+};
+
+/**
+ * A single shot timer which is dispatched together with the clients of the Display, it doesn't
+ * need a running Qt event loop. The callback is invoked from wl_event_loop_dispatch().
+ *
+ * A timer becomes inactive once its Display is destroyed.
+ */
+class EventLoopTimer
+{
+public:
+    explicit EventLoopTimer(Display *display);
+    ~EventLoopTimer();
+
+    void setCallback(std::function<void()> callback);
+
+    /**
+     * Fires the timer in @p msec milliseconds, restarting it if it is already active.
+     */
+    void start(qint64 msec);
+    void stop();
+    bool isActive() const {
+        return m_active;
+    }
+
+private:
+    EventLoopTimerQueue *queue() const;
+
+    QPointer<Display> m_display;
+    std::function<void()> m_callback;
+    EventLoopTimerQueue::Deadlines::iterator m_position;
+    quint64 m_sequence = 0;
+    bool m_active = false;
+    friend class EventLoopTimerQueue;
+    Q_DISABLE_COPY(EventLoopTimer)
+};
+
+}
+
+#endif
@@ -3,14 +3,16 @@
 
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
-#include "fakeinput_interface.h"
+#include "fakeinput_interface_p.h"
 #include "display.h"
+#include "display_p.h"
 
 #include <QSizeF>
 #include <QPointF>
 
 #include <wayland-server.h>
-#include <qwayland-server-fake-input.h>
+
+#include <utility>
 
 
 namespace KWaylandServer
@@ -18,40 +20,24 @@ namespace KWaylandServer
 
 static const quint32 s_version = 4;
 
-class FakeInputInterfacePrivate : public QtWaylandServer::org_kde_kwin_fake_input
-{
-public:
-    FakeInputInterfacePrivate(FakeInputInterface *_q, Display *display);
-    QList<FakeInputDevice*> devices;
-
-private:
-    FakeInputDevice *device(wl_resource *r);
-
-    FakeInputInterface *q;
-    static QList<quint32> touchIds;
-
-protected:
-    void org_kde_kwin_fake_input_bind_resource(Resource *resource) override;
-    void org_kde_kwin_fake_input_destroy_resource(Resource *resource) override;
-    void org_kde_kwin_fake_input_authenticate(Resource *resource, const QString &application, const QString &reason) override;
-    void org_kde_kwin_fake_input_pointer_motion(Resource *resource, wl_fixed_t delta_x, wl_fixed_t delta_y) override;
-    void org_kde_kwin_fake_input_button(Resource *resource, uint32_t button, uint32_t state) override;
-    void org_kde_kwin_fake_input_axis(Resource *resource, uint32_t axis, wl_fixed_t value) override;
-    void org_kde_kwin_fake_input_touch_down(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y) override;
-    void org_kde_kwin_fake_input_touch_motion(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y) override;
-    void org_kde_kwin_fake_input_touch_up(Resource *resource, uint32_t id) override;
-    void org_kde_kwin_fake_input_touch_cancel(Resource *resource) override;
-    void org_kde_kwin_fake_input_touch_frame(Resource *resource) override;
-    void org_kde_kwin_fake_input_pointer_motion_absolute(Resource *resource, wl_fixed_t x, wl_fixed_t y) override;
-    void org_kde_kwin_fake_input_keyboard_key(Resource *resource, uint32_t button, uint32_t state) override;
-};
-
-QList<quint32> FakeInputInterfacePrivate::touchIds = QList<quint32>();
-
 FakeInputInterfacePrivate::FakeInputInterfacePrivate(FakeInputInterface *_q, Display *display)
     : QtWaylandServer::org_kde_kwin_fake_input(*display, s_version)
     , q(_q)
+    , display(display)
 {
+    DisplayPrivate::get(display)->fakeInputs.append(q);
+}
+
+FakeInputInterfacePrivate::~FakeInputInterfacePrivate()
+{
+    if (display) {
+        DisplayPrivate::get(display)->fakeInputs.removeOne(q);
+    }
+}
+
+FakeInputInterfacePrivate *FakeInputInterfacePrivate::get(FakeInputInterface *fakeInput)
+{
+    return fakeInput->d.data();
 }
 
 FakeInputInterface::FakeInputInterface(Display *display, QObject *parent)
@@ -62,33 +48,57 @@ FakeInputInterface::FakeInputInterface(Display *display, QObject *parent)
 
 FakeInputInterface::~FakeInputInterface() = default;
 
+void FakeInputInterfacePrivate::flushEvents()
+{
+    const QVector<FakeInputDevice *> flushed = std::exchange(pendingDevices, {});
+    for (FakeInputDevice *device : flushed) {
+        const QVector<FakeInputEvent> events = std::exchange(FakeInputDevicePrivate::get(device)->pendingEvents, {});
+        emit device->eventsRequested(events);
+    }
+}
+
+QtWaylandServer::org_kde_kwin_fake_input::Resource *FakeInputInterfacePrivate::org_kde_kwin_fake_input_allocate()
+{
+    return new FakeInputResource;
+}
+
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_bind_resource(Resource *resource)
 {
     FakeInputDevice *device = new FakeInputDevice(q, resource->handle);
+    // the device is looked up for every event, keep it with the resource
+    static_cast<FakeInputResource *>(resource)->device = device;
     devices << device;
-    QObject::connect(device, &FakeInputDevice::destroyed, q, [device, this] { devices.removeAll(device); });
+    QObject::connect(device, &FakeInputDevice::destroyed, q, [device, this] {
+        devices.removeAll(device);
+        pendingDevices.removeOne(device);
+    });
     emit q->deviceCreated(device);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_destroy_resource(Resource *resource)
 {
-    if (FakeInputDevice *d = device(resource->handle)) {
+    FakeInputResource *fakeInputResource = static_cast<FakeInputResource *>(resource);
+    if (FakeInputDevice *d = fakeInputResource->device) {
+        // the events of a client which is gone are not delivered anymore
+        pendingDevices.removeOne(d);
+        FakeInputDevicePrivate::get(d)->pendingEvents.clear();
+        fakeInputResource->device = nullptr;
         d->deleteLater();
     }
 }
 
-FakeInputDevice *FakeInputInterfacePrivate::device(wl_resource *r)
+FakeInputDevicePrivate *FakeInputInterfacePrivate::authenticatedDevice(Resource *resource) const
 {
-    auto it = std::find_if(devices.constBegin(), devices.constEnd(), [r] (FakeInputDevice *device) { return device->resource() == r; } );
-    if (it != devices.constEnd()) {
-        return *it;
+    FakeInputDevice *device = static_cast<FakeInputResource *>(resource)->device;
+    if (!device || !device->isAuthenticated()) {
+        return nullptr;
     }
-    return nullptr;
+    return FakeInputDevicePrivate::get(device);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_authenticate(Resource *resource, const QString &application, const QString &reason)
 {
-    FakeInputDevice *d = device(resource->handle);
+    FakeInputDevice *d = static_cast<FakeInputResource *>(resource)->device;
     if (!d) {
         return;
     }
@@ -97,35 +107,53 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_authenticate(Resource *r
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_pointer_motion(Resource *resource, wl_fixed_t delta_x, wl_fixed_t delta_y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
+        return;
+    }
+    const QSizeF delta(wl_fixed_to_double(delta_x), wl_fixed_to_double(delta_y));
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::PointerMotion;
+        event.delta = delta;
+        d->queueEvent(event);
         return;
     }
-    emit d->pointerMotionRequested(QSizeF(wl_fixed_to_double(delta_x), wl_fixed_to_double(delta_y)));
+    emit d->q->pointerMotionRequested(delta);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_button(Resource *resource, uint32_t button, uint32_t state)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
+    FakeInputEvent event;
     switch (state) {
     case WL_POINTER_BUTTON_STATE_PRESSED:
-        emit d->pointerButtonPressRequested(button);
+        event.type = FakeInputEvent::Type::PointerButtonPress;
         break;
     case WL_POINTER_BUTTON_STATE_RELEASED:
-        emit d->pointerButtonReleaseRequested(button);
+        event.type = FakeInputEvent::Type::PointerButtonRelease;
         break;
     default:
         // nothing
-        break;
+        return;
+    }
+    if (d->batched) {
+        event.code = button;
+        d->queueEvent(event);
+    } else if (event.type == FakeInputEvent::Type::PointerButtonPress) {
+        emit d->q->pointerButtonPressRequested(button);
+    } else {
+        emit d->q->pointerButtonReleaseRequested(button);
     }
 }
+
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_axis(Resource *resource, uint32_t axis, wl_fixed_t value)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
     Qt::Orientation orientation;
@@ -140,112 +168,178 @@ void FakeInputInterfacePrivate::org_kde_kwin_fake_input_axis(Resource *resource,
         // invalid
         return;
     }
-    emit d->pointerAxisRequested(orientation, wl_fixed_to_double(value));
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::PointerAxis;
+        event.orientation = orientation;
+        event.axisDelta = wl_fixed_to_double(value);
+        d->queueEvent(event);
+        return;
+    }
+    emit d->q->pointerAxisRequested(orientation, wl_fixed_to_double(value));
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_down(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
+        return;
+    }
+    if (d->touchIds.contains(id)) {
         return;
     }
-    if (touchIds.contains(id)) {
+    d->touchIds.insert(id);
+    const QPointF pos(wl_fixed_to_double(x), wl_fixed_to_double(y));
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::TouchDown;
+        event.code = id;
+        event.position = pos;
+        d->queueEvent(event);
         return;
     }
-    touchIds << id;
-    emit d->touchDownRequested(id, QPointF(wl_fixed_to_double(x), wl_fixed_to_double(y)));
+    emit d->q->touchDownRequested(id, pos);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_motion(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
+        return;
+    }
+    if (!d->touchIds.contains(id)) {
         return;
     }
-    if (!touchIds.contains(id)) {
+    const QPointF pos(wl_fixed_to_double(x), wl_fixed_to_double(y));
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::TouchMotion;
+        event.code = id;
+        event.position = pos;
+        d->queueEvent(event);
         return;
     }
-    emit d->touchMotionRequested(id, QPointF(wl_fixed_to_double(x), wl_fixed_to_double(y)));
+    emit d->q->touchMotionRequested(id, pos);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_up(Resource *resource, uint32_t id)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
+        return;
+    }
+    if (!d->touchIds.remove(id)) {
         return;
     }
-    if (!touchIds.contains(id)) {
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::TouchUp;
+        event.code = id;
+        d->queueEvent(event);
         return;
     }
-    touchIds.removeOne(id);
-    emit d->touchUpRequested(id);
+    emit d->q->touchUpRequested(id);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_cancel(Resource *resource)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
-    touchIds.clear();
-    emit d->touchCancelRequested();
+    d->touchIds.clear();
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::TouchCancel;
+        d->queueEvent(event);
+        return;
+    }
+    emit d->q->touchCancelRequested();
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_touch_frame(Resource *resource)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
+        return;
+    }
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::TouchFrame;
+        d->queueEvent(event);
         return;
     }
-    emit d->touchFrameRequested();
+    emit d->q->touchFrameRequested();
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_pointer_motion_absolute(Resource *resource, wl_fixed_t x, wl_fixed_t y)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
+        return;
+    }
+    const QPointF pos(wl_fixed_to_double(x), wl_fixed_to_double(y));
+    if (d->batched) {
+        FakeInputEvent event;
+        event.type = FakeInputEvent::Type::PointerMotionAbsolute;
+        event.position = pos;
+        d->queueEvent(event);
         return;
     }
-    emit d->pointerMotionAbsoluteRequested(QPointF(wl_fixed_to_double(x), wl_fixed_to_double(y)));
+    emit d->q->pointerMotionAbsoluteRequested(pos);
 }
 
 void FakeInputInterfacePrivate::org_kde_kwin_fake_input_keyboard_key(Resource *resource, uint32_t button, uint32_t state)
 {
-    FakeInputDevice *d = device(resource->handle);
-    if (!d || !d->isAuthenticated()) {
+    FakeInputDevicePrivate *d = authenticatedDevice(resource);
+    if (!d) {
         return;
     }
+    FakeInputEvent event;
     switch (state) {
     case WL_KEYBOARD_KEY_STATE_PRESSED:
-        emit d->keyboardKeyPressRequested(button);
+        event.type = FakeInputEvent::Type::KeyboardKeyPress;
         break;
     case WL_KEYBOARD_KEY_STATE_RELEASED:
-        emit d->keyboardKeyReleaseRequested(button);
+        event.type = FakeInputEvent::Type::KeyboardKeyRelease;
         break;
     default:
         // nothing
-        break;
+        return;
+    }
+    if (d->batched) {
+        event.code = button;
+        d->queueEvent(event);
+    } else if (event.type == FakeInputEvent::Type::KeyboardKeyPress) {
+        emit d->q->keyboardKeyPressRequested(button);
+    } else {
+        emit d->q->keyboardKeyReleaseRequested(button);
     }
 }
 
-class FakeInputDevicePrivate
-{
-public:
-    FakeInputDevicePrivate(FakeInputInterface *interface, wl_resource *resource);
-    wl_resource *resource;
-    FakeInputInterface *interface;
-    bool authenticated = false;
-};
-
-FakeInputDevicePrivate::FakeInputDevicePrivate(FakeInputInterface *interface, wl_resource *resource)
-    : resource(resource)
+FakeInputDevicePrivate::FakeInputDevicePrivate(FakeInputDevice *q, FakeInputInterface *interface, wl_resource *resource)
+    : q(q)
+    , resource(resource)
     , interface(interface)
 {
 }
 
+FakeInputDevicePrivate *FakeInputDevicePrivate::get(FakeInputDevice *device)
+{
+    return device->d.data();
+}
+
+void FakeInputDevicePrivate::queueEvent(const FakeInputEvent &event)
+{
+    if (pendingEvents.isEmpty()) {
+        FakeInputInterfacePrivate::get(interface)->pendingDevices.append(q);
+    }
+    pendingEvents.append(event);
+}
+
 FakeInputDevice::FakeInputDevice(FakeInputInterface *parent, wl_resource *resource)
     : QObject(parent)
-    , d(new FakeInputDevicePrivate(parent, resource))
+    , d(new FakeInputDevicePrivate(this, parent, resource))
 {
 }
 
@@ -266,4 +360,22 @@ bool FakeInputDevice::isAuthenticated() const
     return d->authenticated;
 }
 
+void FakeInputDevice::setBatched(bool batched)
+{
+    if (d->batched == batched) {
+        return;
+    }
+    d->batched = batched;
+    if (!batched && !d->pendingEvents.isEmpty()) {
+        // deliver what has been collected so far before switching to single events
+        FakeInputInterfacePrivate::get(d->interface)->pendingDevices.removeOne(this);
+        emit eventsRequested(std::exchange(d->pendingEvents, {}));
+    }
+}
+
+bool FakeInputDevice::isBatched() const
+{
+    return d->batched;
+}
+
 }
@@ -9,6 +9,7 @@
 #include <QPointF>
 #include <QSizeF>
 #include <QObject>
+#include <QVector>
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
@@ -22,6 +23,48 @@ class FakeInputDevice;
 class FakeInputDevicePrivate;
 class FakeInputInterfacePrivate;
 
+/**
+ * A fake input event, as delivered by a batched FakeInputDevice.
+ *
+ * @see FakeInputDevice::setBatched
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT FakeInputEvent
+{
+    enum class Type {
+        PointerMotion,
+        PointerMotionAbsolute,
+        PointerButtonPress,
+        PointerButtonRelease,
+        PointerAxis,
+        TouchDown,
+        TouchMotion,
+        TouchUp,
+        TouchCancel,
+        TouchFrame,
+        KeyboardKeyPress,
+        KeyboardKeyRelease,
+    };
+    Type type = Type::PointerMotion;
+    /**
+     * The button, the key or the id of the touch point.
+     **/
+    quint32 code = 0;
+    /**
+     * The position of an absolute pointer motion or of a touch point.
+     **/
+    QPointF position;
+    /**
+     * The delta of a relative pointer motion.
+     **/
+    QSizeF delta;
+    /**
+     * The orientation and the delta of a pointer axis event.
+     **/
+    Qt::Orientation orientation = Qt::Vertical;
+    qreal axisDelta = 0;
+};
+
 /**
  * @brief Represents the Global for org_kde_kwin_fake_input interface.
  *
@@ -55,6 +98,7 @@ Q_SIGNALS:
     void deviceCreated(KWaylandServer::FakeInputDevice *device);
 
 private:
+    friend class FakeInputInterfacePrivate;
     QScopedPointer<FakeInputInterfacePrivate> d;
 };
 
@@ -86,6 +130,24 @@ public:
      **/
     bool isAuthenticated() const;
 
+    /**
+     * Sets whether the events of this device are delivered in batches. A batched device
+     * collects the events a client sent until the Display flushes its clients, that is once
+     * the pending requests have been dispatched, and delivers them with a single
+     * eventsRequested signal instead of one signal per event. This is meant for remote
+     * desktop and automation clients sending a lot of events.
+     *
+     * The default is @c false.
+     * @see eventsRequested
+     * @since 5.22
+     **/
+    void setBatched(bool batched);
+    /**
+     * @see setBatched
+     * @since 5.22
+     **/
+    bool isBatched() const;
+
 Q_SIGNALS:
     /**
      * Request for authentication.
@@ -162,9 +224,17 @@ Q_SIGNALS:
      * @since 5.63
      **/
     void keyboardKeyReleaseRequested(quint32 key);
+    /**
+     * Requests the @p events of a batched device, in the order the client sent them.
+     *
+     * @see setBatched
+     * @since 5.22
+     **/
+    void eventsRequested(const QVector<KWaylandServer::FakeInputEvent> &events);
 
 private:
     friend class FakeInputInterfacePrivate;
+    friend class FakeInputDevicePrivate;
     FakeInputDevice(FakeInputInterface *parent, wl_resource *resource);
     QScopedPointer<FakeInputDevicePrivate> d;
 };
@@ -172,5 +242,6 @@ private:
 }
 
 Q_DECLARE_METATYPE(KWaylandServer::FakeInputDevice*)
+Q_DECLARE_METATYPE(KWaylandServer::FakeInputEvent)
 
 #endif
@@ -0,0 +1,87 @@
+/*
+    SPDX-FileCopyrightText: 2015 Martin Gräßlin <mgraesslin@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_FAKEINPUT_INTERFACE_P_H
+#define KWAYLAND_SERVER_FAKEINPUT_INTERFACE_P_H
+
+#include "fakeinput_interface.h"
+
+#include <QPointer>
+#include <QSet>
+
+#include <qwayland-server-fake-input.h>
+
+namespace KWaylandServer
+{
+
+class FakeInputInterfacePrivate : public QtWaylandServer::org_kde_kwin_fake_input
+{
+public:
+    FakeInputInterfacePrivate(FakeInputInterface *_q, Display *display);
+    ~FakeInputInterfacePrivate() override;
+
+    static FakeInputInterfacePrivate *get(FakeInputInterface *fakeInput);
+
+    /**
+     * Delivers the events batched since the last flush, called by the Display before it
+     * flushes its clients.
+     **/
+    void flushEvents();
+
+    QList<FakeInputDevice*> devices;
+    // batched devices with events waiting for the next flush
+    QVector<FakeInputDevice*> pendingDevices;
+
+private:
+    class FakeInputResource : public Resource
+    {
+    public:
+        FakeInputDevice *device = nullptr;
+    };
+
+    FakeInputDevicePrivate *authenticatedDevice(Resource *resource) const;
+
+    FakeInputInterface *q;
+    QPointer<Display> display;
+
+protected:
+    Resource *org_kde_kwin_fake_input_allocate() override;
+    void org_kde_kwin_fake_input_bind_resource(Resource *resource) override;
+    void org_kde_kwin_fake_input_destroy_resource(Resource *resource) override;
+    void org_kde_kwin_fake_input_authenticate(Resource *resource, const QString &application, const QString &reason) override;
+    void org_kde_kwin_fake_input_pointer_motion(Resource *resource, wl_fixed_t delta_x, wl_fixed_t delta_y) override;
+    void org_kde_kwin_fake_input_button(Resource *resource, uint32_t button, uint32_t state) override;
+    void org_kde_kwin_fake_input_axis(Resource *resource, uint32_t axis, wl_fixed_t value) override;
+    void org_kde_kwin_fake_input_touch_down(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y) override;
+    void org_kde_kwin_fake_input_touch_motion(Resource *resource, uint32_t id, wl_fixed_t x, wl_fixed_t y) override;
+    void org_kde_kwin_fake_input_touch_up(Resource *resource, uint32_t id) override;
+    void org_kde_kwin_fake_input_touch_cancel(Resource *resource) override;
+    void org_kde_kwin_fake_input_touch_frame(Resource *resource) override;
+    void org_kde_kwin_fake_input_pointer_motion_absolute(Resource *resource, wl_fixed_t x, wl_fixed_t y) override;
+    void org_kde_kwin_fake_input_keyboard_key(Resource *resource, uint32_t button, uint32_t state) override;
+};
+
+class FakeInputDevicePrivate
+{
+public:
+    FakeInputDevicePrivate(FakeInputDevice *q, FakeInputInterface *interface, wl_resource *resource);
+
+    static FakeInputDevicePrivate *get(FakeInputDevice *device);
+
+    void queueEvent(const FakeInputEvent &event);
+
+    FakeInputDevice *q;
+    wl_resource *resource;
+    FakeInputInterface *interface;
+    bool authenticated = false;
+    bool batched = false;
+    // the touch points which are down on this device
+    QSet<quint32> touchIds;
+    QVector<FakeInputEvent> pendingEvents;
+};
+
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include <wayland-server.h>
 
 #include <QByteArray>
+#include <QHash>
 
 namespace KWaylandServer
 {
@@ -19,13 +20,23 @@ class FilteredDisplay::Private
 public:
     Private(FilteredDisplay *_q);
     FilteredDisplay *q;
+    // the allowInterface() results; the interfaces are static data, so they identify the globals
+    QHash<ClientConnection *, QHash<const wl_interface *, bool>> allowed;
+
     static bool globalFilterCallback(const wl_client *client, const wl_global *global, void *data)
     {
         auto t = static_cast<FilteredDisplay::Private*>(data);
         auto clientConnection = t->q->getConnection(const_cast<wl_client*>(client));
         auto interface = wl_global_get_interface(global);
+        QHash<const wl_interface *, bool> &clientAllowed = t->allowed[clientConnection];
+        auto it = clientAllowed.constFind(interface);
+        if (it != clientAllowed.constEnd()) {
+            return *it;
+        }
         auto name = QByteArray::fromRawData(interface->name, strlen(interface->name));
-        return t->q->allowInterface(clientConnection, name);
+        const bool allow = t->q->allowInterface(clientConnection, name);
+        clientAllowed.insert(interface, allow);
+        return allow;
     };
 };
 
@@ -44,10 +55,22 @@ FilteredDisplay::FilteredDisplay(QObject *parent):
         }
         wl_display_set_global_filter(*this, Private::globalFilterCallback, d.data());
     });
+    connect(this, &Display::clientDisconnected, this, [this](ClientConnection *client) {
+        d->allowed.remove(client);
+    });
 }
 
 FilteredDisplay::~FilteredDisplay()
 {
 }
 
+void FilteredDisplay::invalidateInterfaceFilter(ClientConnection *client)
+{
+    if (client) {
+        d->allowed.remove(client);
+    } else {
+        d->allowed.clear();
+    }
+}
+
 }
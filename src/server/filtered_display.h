@@ -35,9 +35,21 @@ public:
 * When false will not see these globals for a given interface in the registry,
 * and any manual attempts to bind will fail
 *
+* The result is cached per client and interface, call invalidateInterfaceFilter() when the
+* policy changes.
+*
 * @return true if the client should be able to access the global with the following interfaceName
 */
     virtual bool allowInterface(ClientConnection *client, const QByteArray &interfaceName) = 0;
+
+/**
+* Drops the cached allowInterface() results of @arg client, or of all clients if @arg client
+* is @c nullptr, so that allowInterface() gets asked again on the next registry
+* enumeration or bind.
+*
+* @since 5.22
+*/
+    void invalidateInterfaceFilter(ClientConnection *client = nullptr);
 private:
     class Private;
     QScopedPointer<Private> d;
@@ -0,0 +1,49 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class FractionalScaleManagerV1InterfacePrivate;
+
+/**
+ * The FractionalScaleManagerV1Interface tells clients the fractional scale to render their
+ * surfaces at.
+ *
+ * The integer buffer scale makes clients render at 2x on outputs with a scale of 1.25 or 1.5,
+ * and the compositor has to scale the buffers down again. With the preferred fractional scale
+ * of a surface a client renders its buffer at the native resolution instead, keeps the buffer
+ * scale at 1 and sets the surface size as destination of its wp_viewport, so the buffer maps
+ * 1:1 to the pixels of the output.
+ *
+ * The compositor sets the preferred scale of a surface with SurfaceInterface::setPreferredScale(),
+ * typically the largest OutputDeviceInterface::scaleF() of the outputs the surface is on.
+ *
+ * FractionalScaleManagerV1Interface corresponds to the Wayland interface
+ * @c wp_fractional_scale_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT FractionalScaleManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FractionalScaleManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~FractionalScaleManagerV1Interface() override;
+
+private:
+    QScopedPointer<FractionalScaleManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,42 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "qwayland-server-fractional-scale-v1.h"
+
+#include <QPointer>
+
+namespace KWaylandServer
+{
+
+class SurfaceInterface;
+
+class FractionalScaleV1Interface : public QtWaylandServer::wp_fractional_scale_v1
+{
+public:
+    FractionalScaleV1Interface(SurfaceInterface *surface, wl_resource *resource);
+    ~FractionalScaleV1Interface() override;
+
+    static FractionalScaleV1Interface *get(SurfaceInterface *surface);
+
+    /**
+     * Sends @p scale to the client unless it got told about it already.
+     */
+    void setPreferredScale(qreal scale);
+
+    QPointer<SurfaceInterface> surface;
+
+protected:
+    void wp_fractional_scale_v1_destroy_resource(Resource *resource) override;
+    void wp_fractional_scale_v1_destroy(Resource *resource) override;
+
+private:
+    // in 120ths, as sent to the client
+    uint32_t m_preferredScale = 0;
+};
+
+} // namespace KWaylandServer
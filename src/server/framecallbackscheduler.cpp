@@ -0,0 +1,98 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "framecallbackscheduler.h"
+#include "clientconnection.h"
+#include "output_interface.h"
+#include "surface_interface.h"
+#include "surface_interface_p.h"
+
+#include <QPointer>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+class FrameCallbackSchedulerPrivate
+{
+public:
+    // guarded, a surface might get destroyed between scheduling and dispatching
+    QVector<QPointer<SurfaceInterface>> surfaces;
+};
+
+FrameCallbackScheduler::FrameCallbackScheduler()
+    : d(new FrameCallbackSchedulerPrivate)
+{
+}
+
+FrameCallbackScheduler::~FrameCallbackScheduler() = default;
+
+void FrameCallbackScheduler::addSurface(SurfaceInterface *surface)
+{
+    if (surface) {
+        d->surfaces.append(surface);
+    }
+}
+
+void FrameCallbackScheduler::addSurfaces(const QList<SurfaceInterface *> &surfaces)
+{
+    d->surfaces.reserve(d->surfaces.count() + surfaces.count());
+    for (SurfaceInterface *surface : surfaces) {
+        addSurface(surface);
+    }
+}
+
+void FrameCallbackScheduler::addOutput(OutputInterface *output)
+{
+    const QList<SurfaceInterface *> surfaces = SurfaceInterface::surfaces();
+    for (SurfaceInterface *surface : surfaces) {
+        // sub-surfaces are handled together with their parent
+        if (surface->subSurface()) {
+            continue;
+        }
+        if (surface->outputs().contains(output)) {
+            d->surfaces.append(surface);
+        }
+    }
+}
+
+void FrameCallbackScheduler::dispatch(quint32 msec)
+{
+    QVector<ClientConnection *> clients;
+    for (const QPointer<SurfaceInterface> &surface : qAsConst(d->surfaces)) {
+        if (!surface) {
+            continue;
+        }
+        if (!SurfaceInterfacePrivate::get(surface)->sendFrameCallbacks(msec)) {
+            continue;
+        }
+        ClientConnection *client = surface->client();
+        // the number of distinct clients per output is small, a linear search beats hashing
+        if (!clients.contains(client)) {
+            clients.append(client);
+        }
+    }
+    d->surfaces.clear();
+
+    for (ClientConnection *client : qAsConst(clients)) {
+        client->flush();
+    }
+}
+
+void FrameCallbackScheduler::frameRendered(const QList<SurfaceInterface *> &surfaces, quint32 msec)
+{
+    FrameCallbackScheduler scheduler;
+    scheduler.addSurfaces(surfaces);
+    scheduler.dispatch(msec);
+}
+
+void FrameCallbackScheduler::frameRendered(OutputInterface *output, quint32 msec)
+{
+    FrameCallbackScheduler scheduler;
+    scheduler.addOutput(output);
+    scheduler.dispatch(msec);
+}
+
+}
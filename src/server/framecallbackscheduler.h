@@ -0,0 +1,82 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_FRAMECALLBACKSCHEDULER_H
+#define KWAYLAND_SERVER_FRAMECALLBACKSCHEDULER_H
+
+#include <QList>
+#include <QScopedPointer>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+class FrameCallbackSchedulerPrivate;
+class OutputInterface;
+class SurfaceInterface;
+
+/**
+ * @brief Sends the wl_callback.done events of many surfaces in one batch.
+ *
+ * Calling SurfaceInterface::frameRendered() for every surface shown on an output flushes the
+ * owning client once per surface. The FrameCallbackScheduler collects the surfaces that have
+ * been presented, sends all done events with the same timestamp and flushes every distinct
+ * ClientConnection only once.
+ *
+ * @code
+ * FrameCallbackScheduler scheduler;
+ * scheduler.addOutput(output);
+ * scheduler.dispatch(timestamp);
+ * @endcode
+ *
+ * The frame callbacks of the sub-surfaces are sent together with their parent surfaces.
+ *
+ * @see SurfaceInterface::frameRendered
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT FrameCallbackScheduler
+{
+public:
+    FrameCallbackScheduler();
+    ~FrameCallbackScheduler();
+
+    /**
+     * Schedules the frame callbacks of @p surface and its sub-surfaces for the next dispatch().
+     **/
+    void addSurface(SurfaceInterface *surface);
+    /**
+     * Schedules the frame callbacks of all @p surfaces and their sub-surfaces.
+     **/
+    void addSurfaces(const QList<SurfaceInterface *> &surfaces);
+    /**
+     * Schedules the frame callbacks of all surfaces which are on the @p output.
+     *
+     * @see SurfaceInterface::outputs
+     **/
+    void addOutput(OutputInterface *output);
+
+    /**
+     * Sends the done event with the timestamp @p msec to the frame callbacks of all scheduled
+     * surfaces and flushes each affected client once. Afterwards the scheduler is empty again.
+     **/
+    void dispatch(quint32 msec);
+
+    /**
+     * Convenience method for dispatching the frame callbacks of @p surfaces in one go.
+     **/
+    static void frameRendered(const QList<SurfaceInterface *> &surfaces, quint32 msec);
+    /**
+     * Convenience method for dispatching the frame callbacks of all surfaces on @p output.
+     **/
+    static void frameRendered(OutputInterface *output, quint32 msec);
+
+private:
+    QScopedPointer<FrameCallbackSchedulerPrivate> d;
+    Q_DISABLE_COPY(FrameCallbackScheduler)
+};
+
+}
+
+#endif
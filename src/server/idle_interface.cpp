@@ -7,6 +7,10 @@
 #include "display.h"
 #include "seat_interface.h"
 
+#include <algorithm>
+#include <limits>
+#include <utility>
+
 namespace KWaylandServer
 {
 
@@ -14,8 +18,18 @@ static const quint32 s_version = 1;
 
 IdleInterfacePrivate::IdleInterfacePrivate(IdleInterface *_q, Display *display)
     : QtWaylandServer::org_kde_kwin_idle(*display, s_version)
+    , timer(display)
     , q(_q)
 {
+    clock.start();
+    timer.setCallback([this]() {
+        processWatchers();
+    });
+}
+
+IdleInterfacePrivate *IdleInterfacePrivate::get(IdleInterface *idle)
+{
+    return idle->d.data();
 }
 
 void IdleInterfacePrivate::org_kde_kwin_idle_get_idle_timeout(Resource *resource, uint32_t id, wl_resource *seat, uint32_t timeout)
@@ -30,14 +44,163 @@ void IdleInterfacePrivate::org_kde_kwin_idle_get_idle_timeout(Resource *resource
     }
 
     IdleTimeoutInterface *idleTimeout = new IdleTimeoutInterface(s, q, idleTimoutResource);
-    idleTimeouts << idleTimeout;
-
-    QObject::connect(idleTimeout, &IdleTimeoutInterface::destroyed, q, [this, idleTimeout]() {
-        idleTimeouts.removeOne(idleTimeout);
-    });
     idleTimeout->setup(timeout);
 }
 
+void IdleInterfacePrivate::addWatcher(IdleWatcher *watcher)
+{
+    SeatInterface *seat = watcher->seat;
+    if (!seats.contains(seat)) {
+        seats.insert(seat, SeatActivity());
+        QObject::connect(seat, &SeatInterface::timestampChanged, q, [this, seat]() {
+            handleSeatActivity(seat);
+        });
+        QObject::connect(seat, &QObject::destroyed, q, [this, seat]() {
+            seats.remove(seat);
+        });
+    }
+
+    watchers.append(watcher);
+    watcher->lastActivity = clock.elapsed();
+    if (inhibitCount == 0) {
+        // don't start if inhibited
+        scheduleTimer(deadline(watcher));
+    }
+}
+
+void IdleInterfacePrivate::removeWatcher(IdleWatcher *watcher)
+{
+    watchers.removeOne(watcher);
+    auto it = seats.find(watcher->seat);
+    if (it != seats.end()) {
+        it->idleWatchers.removeOne(watcher);
+    }
+    if (watchers.isEmpty()) {
+        timer.stop();
+    }
+}
+
+void IdleInterfacePrivate::handleSeatActivity(SeatInterface *seat)
+{
+    // called for every input event, only note the time unless some watchers are idle
+    auto it = seats.find(seat);
+    if (it == seats.end()) {
+        return;
+    }
+    it->lastActivity = clock.elapsed();
+    if (inhibitCount > 0 || it->idleWatchers.isEmpty()) {
+        return;
+    }
+    const QVector<IdleWatcher *> idleWatchers = std::exchange(it->idleWatchers, {});
+    for (IdleWatcher *watcher : idleWatchers) {
+        resume(watcher);
+    }
+}
+
+void IdleInterfacePrivate::simulateUserActivity(IdleWatcher *watcher)
+{
+    if (!watcher->isConfigured) {
+        // not yet configured
+        return;
+    }
+    if (inhibitCount > 0) {
+        // ignored while inhibited
+        return;
+    }
+    watcher->lastActivity = clock.elapsed();
+    if (watcher->isIdle) {
+        auto it = seats.find(watcher->seat);
+        if (it != seats.end()) {
+            it->idleWatchers.removeOne(watcher);
+        }
+        resume(watcher);
+    }
+}
+
+void IdleInterfacePrivate::simulateUserActivity()
+{
+    if (inhibitCount > 0) {
+        // ignored while inhibited
+        return;
+    }
+    lastActivity = clock.elapsed();
+    for (auto it = seats.begin(); it != seats.end(); ++it) {
+        const QVector<IdleWatcher *> idleWatchers = std::exchange(it->idleWatchers, {});
+        for (IdleWatcher *watcher : idleWatchers) {
+            resume(watcher);
+        }
+    }
+}
+
+void IdleInterfacePrivate::handleInhibitedChanged()
+{
+    if (inhibitCount > 0) {
+        timer.stop();
+        for (auto it = seats.begin(); it != seats.end(); ++it) {
+            const QVector<IdleWatcher *> idleWatchers = std::exchange(it->idleWatchers, {});
+            for (IdleWatcher *watcher : idleWatchers) {
+                watcher->isIdle = false;
+                watcher->sendResumed();
+            }
+        }
+    } else {
+        // all watchers start over
+        lastActivity = clock.elapsed();
+        processWatchers();
+    }
+}
+
+void IdleInterfacePrivate::resume(IdleWatcher *watcher)
+{
+    watcher->isIdle = false;
+    watcher->sendResumed();
+    scheduleTimer(deadline(watcher));
+}
+
+qint64 IdleInterfacePrivate::deadline(const IdleWatcher *watcher) const
+{
+    const qint64 seatActivity = seats.value(watcher->seat).lastActivity;
+    return std::max({watcher->lastActivity, seatActivity, lastActivity}) + watcher->interval;
+}
+
+void IdleInterfacePrivate::scheduleTimer(qint64 deadline)
+{
+    // an armed timer firing too early is fine, it re-arms itself for the actual deadline
+    if (timer.isActive() && timerDeadline <= deadline) {
+        return;
+    }
+    timerDeadline = deadline;
+    timer.start(deadline - clock.elapsed());
+}
+
+void IdleInterfacePrivate::processWatchers()
+{
+    if (inhibitCount > 0) {
+        return;
+    }
+    timer.stop();
+
+    const qint64 now = clock.elapsed();
+    qint64 nextDeadline = std::numeric_limits<qint64>::max();
+    for (IdleWatcher *watcher : qAsConst(watchers)) {
+        if (!watcher->isConfigured || watcher->isIdle) {
+            continue;
+        }
+        const qint64 watcherDeadline = deadline(watcher);
+        if (watcherDeadline <= now) {
+            watcher->isIdle = true;
+            seats[watcher->seat].idleWatchers.append(watcher);
+            watcher->sendIdle();
+        } else {
+            nextDeadline = std::min(nextDeadline, watcherDeadline);
+        }
+    }
+
+    if (nextDeadline != std::numeric_limits<qint64>::max()) {
+        scheduleTimer(nextDeadline);
+    }
+}
+
 IdleInterface::IdleInterface(Display *display, QObject *parent)
     : QObject(parent)
     , d(new IdleInterfacePrivate(this, display))
@@ -50,6 +213,7 @@ void IdleInterface::inhibit()
 {
     d->inhibitCount++;
     if (d->inhibitCount == 1) {
+        d->handleInhibitedChanged();
         emit inhibitedChanged();
     }
 }
@@ -58,6 +222,7 @@ void IdleInterface::uninhibit()
 {
     d->inhibitCount--;
     if (d->inhibitCount == 0) {
+        d->handleInhibitedChanged();
         emit inhibitedChanged();
     }
 }
@@ -69,42 +234,58 @@ bool IdleInterface::isInhibited() const
 
 void IdleInterface::simulateUserActivity()
 {
-    for (auto i : qAsConst(d->idleTimeouts)) {
-        i->simulateUserActivity();
+    d->simulateUserActivity();
+}
+
+IdleWatcher::IdleWatcher(SeatInterface *seat, IdleInterface *manager)
+    : seat(seat)
+    , manager(manager)
+{
+}
+
+IdleWatcher::~IdleWatcher()
+{
+    if (manager && isConfigured) {
+        IdleInterfacePrivate::get(manager)->removeWatcher(this);
+    }
+}
+
+void IdleWatcher::setup(int interval)
+{
+    if (isConfigured || !manager) {
+        return;
+    }
+    this->interval = interval;
+    isConfigured = true;
+    IdleInterfacePrivate::get(manager)->addWatcher(this);
+}
+
+void IdleWatcher::simulateUserActivity()
+{
+    if (manager) {
+        IdleInterfacePrivate::get(manager)->simulateUserActivity(this);
     }
 }
 
 IdleTimeoutInterface::IdleTimeoutInterface(SeatInterface *seat, IdleInterface *manager, wl_resource *resource)
     : QObject()
     , QtWaylandServer::org_kde_kwin_idle_timeout(resource)
-    , seat(seat)
-    , manager(manager)
+    , IdleWatcher(seat, manager)
 {
-    connect(seat, &SeatInterface::timestampChanged, this,
-        [this] {
-            simulateUserActivity();
-        }
-    );
-    connect(manager, &IdleInterface::inhibitedChanged, this,
-        [this, manager] {
-            if (!timer) {
-                // not yet configured
-                return;
-            }
-            if (manager->isInhibited()) {
-                if (!timer->isActive()) {
-                    send_resumed();
-                }
-                timer->stop();
-            } else {
-                timer->start();
-            }
-        }
-    );
 }
 
 IdleTimeoutInterface::~IdleTimeoutInterface() = default;
 
+void IdleTimeoutInterface::sendIdle()
+{
+    send_idle();
+}
+
+void IdleTimeoutInterface::sendResumed()
+{
+    send_resumed();
+}
+
 void IdleTimeoutInterface::org_kde_kwin_idle_timeout_release(Resource *resource)
 {
     wl_resource_destroy(resource->handle);
@@ -121,44 +302,13 @@ void IdleTimeoutInterface::org_kde_kwin_idle_timeout_simulate_user_activity(Reso
     Q_UNUSED(resource)
     simulateUserActivity();
 }
-void IdleTimeoutInterface::simulateUserActivity()
-{
-    if (!timer) {
-        // not yet configured
-        return;
-    }
-    if (manager->isInhibited()) {
-        // ignored while inhibited
-        return;
-    }
-    if (!timer->isActive()) {
-        send_resumed();
-    }
-    timer->start();
-}
 
 void IdleTimeoutInterface::setup(quint32 timeout)
 {
-    if (timer) {
-        return;
-    }
-
     if (timeout > INT_MAX)
         timeout = INT_MAX;
 
-    timer = new QTimer(this);
-    timer->setSingleShot(true);
     // less than 500 msec is not idle by definition
-    timer->setInterval(qMax(timeout, 500u));
-    QObject::connect(timer, &QTimer::timeout, this,
-        [this] {
-            send_idle();
-        }
-    );
-    if (manager->isInhibited()) {
-        // don't start if inhibited
-        return;
-    }
-    timer->start();
+    IdleWatcher::setup(qMax(timeout, 500u));
 }
 }
@@ -103,6 +103,7 @@ Q_SIGNALS:
 
 private:
     QScopedPointer<IdleInterfacePrivate> d;
+    friend class IdleInterfacePrivate;
 };
 
 }
@@ -7,10 +7,13 @@
 #define KWAYLAND_SERVER_IDLE_INTERFACE_P_H
 
 #include "idle_interface.h"
+#include "eventlooptimer_p.h"
 
 #include <qwayland-server-idle.h>
 
-#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QPointer>
 
 
 namespace KWaylandServer
@@ -18,35 +21,89 @@ namespace KWaylandServer
 
 class Display;
 class SeatInterface;
-class IdleTimeoutInterface;
-class IdleTimeoutInterface;
 
+/**
+ * Something waiting for the seat to become idle, e.g. an org_kde_kwin_idle_timeout or an
+ * ext_idle_notification_v1. All watchers are driven by the IdleInterface they are added to.
+ */
+class IdleWatcher
+{
+public:
+    IdleWatcher(SeatInterface *seat, IdleInterface *manager);
+    virtual ~IdleWatcher();
+
+    /**
+     * Starts waiting for @p interval milliseconds of inactivity.
+     */
+    void setup(int interval);
+    void simulateUserActivity();
+
+    virtual void sendIdle() = 0;
+    virtual void sendResumed() = 0;
+
+    SeatInterface *seat;
+    QPointer<IdleInterface> manager;
+    qint64 lastActivity = 0;
+    int interval = 0;
+    bool isConfigured = false;
+    bool isIdle = false;
+};
+
+/**
+ * The idle watchers of all clients share one timer. Input only records the time of the last
+ * activity of the seat, the timer is armed for the earliest deadline and re-armed for the next
+ * one when it fires, if the activity in between pushed the deadline further away.
+ */
 class IdleInterfacePrivate : public QtWaylandServer::org_kde_kwin_idle
 {
 public:
     IdleInterfacePrivate(IdleInterface *_q, Display *display);
 
+    static IdleInterfacePrivate *get(IdleInterface *idle);
+
+    void addWatcher(IdleWatcher *watcher);
+    void removeWatcher(IdleWatcher *watcher);
+    void handleSeatActivity(SeatInterface *seat);
+    void simulateUserActivity(IdleWatcher *watcher);
+    void simulateUserActivity();
+    void handleInhibitedChanged();
+
+    qint64 deadline(const IdleWatcher *watcher) const;
+    void scheduleTimer(qint64 deadline);
+    void processWatchers();
+    void resume(IdleWatcher *watcher);
+
+    struct SeatActivity {
+        qint64 lastActivity = 0;
+        // the watchers on the seat which are idle, resumed by the next activity
+        QVector<IdleWatcher *> idleWatchers;
+    };
+
+    // a counter rather than a signal, watchers don't need to be told about inhibition
     int inhibitCount = 0;
-    QVector<IdleTimeoutInterface *> idleTimeouts;
+    QVector<IdleWatcher *> watchers;
+    QHash<SeatInterface *, SeatActivity> seats;
+    // all watchers restart from here, e.g. after the compositor simulated activity
+    qint64 lastActivity = 0;
+    QElapsedTimer clock;
+    EventLoopTimer timer;
+    qint64 timerDeadline = 0;
     IdleInterface *q;
 
 protected:
     void org_kde_kwin_idle_get_idle_timeout(Resource *resource, uint32_t id, wl_resource *seat, uint32_t timeout) override;
 };
 
-class IdleTimeoutInterface : public QObject, QtWaylandServer::org_kde_kwin_idle_timeout
+class IdleTimeoutInterface : public QObject, public QtWaylandServer::org_kde_kwin_idle_timeout, public IdleWatcher
 {
     Q_OBJECT
 public:
     explicit IdleTimeoutInterface(SeatInterface *seat, IdleInterface *parent, wl_resource *resource);
     ~IdleTimeoutInterface() override;
     void setup(quint32 timeout);
-    void simulateUserActivity();
 
-private:
-    SeatInterface *seat;
-    IdleInterface *manager;
-    QTimer *timer = nullptr;
+    void sendIdle() override;
+    void sendResumed() override;
 
 protected:
     void org_kde_kwin_idle_timeout_destroy_resource(Resource *resource) override;
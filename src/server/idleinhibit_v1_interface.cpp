@@ -38,10 +38,46 @@ void IdleInhibitManagerV1InterfacePrivate::zwp_idle_inhibit_manager_v1_create_in
     }
     auto inhibitor = new IdleInhibitorV1Interface(inhibitorResource);
 
+    trackSurface(s);
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(s);
     surfacePrivate->installIdleInhibitor(inhibitor);
 }
 
+void IdleInhibitManagerV1InterfacePrivate::trackSurface(SurfaceInterface *surface)
+{
+    if (surfaces.contains(surface)) {
+        return;
+    }
+    surfaces.insert(surface);
+    QObject::connect(surface, &SurfaceInterface::inhibitsIdleChanged, q, [this, surface]() {
+        updateSurface(surface);
+    });
+    QObject::connect(surface, &QObject::destroyed, q, [this, surface]() {
+        removeSurface(surface);
+    });
+}
+
+void IdleInhibitManagerV1InterfacePrivate::updateSurface(SurfaceInterface *surface)
+{
+    const bool wasInhibited = !inhibitingSurfaces.isEmpty();
+    if (surface->inhibitsIdle()) {
+        inhibitingSurfaces.insert(surface);
+    } else {
+        inhibitingSurfaces.remove(surface);
+    }
+    if (wasInhibited != !inhibitingSurfaces.isEmpty()) {
+        emit q->inhibitedChanged();
+    }
+}
+
+void IdleInhibitManagerV1InterfacePrivate::removeSurface(SurfaceInterface *surface)
+{
+    surfaces.remove(surface);
+    if (inhibitingSurfaces.remove(surface) && inhibitingSurfaces.isEmpty()) {
+        emit q->inhibitedChanged();
+    }
+}
+
 IdleInhibitManagerV1Interface::IdleInhibitManagerV1Interface(Display *display, QObject *parent)
     : QObject(parent)
     , d(new IdleInhibitManagerV1InterfacePrivate(this, display))
@@ -50,6 +86,16 @@ IdleInhibitManagerV1Interface::IdleInhibitManagerV1Interface(Display *display, Q
 
 IdleInhibitManagerV1Interface::~IdleInhibitManagerV1Interface() = default;
 
+bool IdleInhibitManagerV1Interface::isInhibited() const
+{
+    return !d->inhibitingSurfaces.isEmpty();
+}
+
+int IdleInhibitManagerV1Interface::inhibitingSurfaceCount() const
+{
+    return d->inhibitingSurfaces.count();
+}
+
 IdleInhibitorV1Interface::IdleInhibitorV1Interface(wl_resource *resource)
     : QObject(nullptr)
     , QtWaylandServer::zwp_idle_inhibitor_v1(resource)
@@ -23,6 +23,11 @@ class IdleInhibitManagerV1InterfacePrivate;
  * SurfaceInterface. Whether a SurfaceInterface inhibits idle is exposes through
  * @link{SurfaceInterface::inhibitsIdle}.
  *
+ * An inhibitor only has an effect while its surface is visible, the compositor tells which
+ * surfaces are not with SurfaceInterface::setOccluded. Whether any visible surface inhibits idle
+ * is kept up to date as surfaces change and provided by isInhibited, a compositor typically
+ * forwards inhibitedChanged to IdleInterface::inhibit and IdleInterface::uninhibit.
+ *
  * @since 5.41
  **/
 class KWAYLANDSERVER_EXPORT IdleInhibitManagerV1Interface : public QObject
@@ -33,6 +38,28 @@ public:
     explicit IdleInhibitManagerV1Interface(Display *display, QObject *parent = nullptr);
     ~IdleInhibitManagerV1Interface() override;
 
+    /**
+     * @returns whether at least one visible surface has an idle inhibitor
+     * @see inhibitedChanged
+     * @since 5.22
+     **/
+    bool isInhibited() const;
+    /**
+     * @returns the number of visible surfaces with an idle inhibitor, kept up to date as
+     * inhibitors come and go, so it's no walk over the surfaces
+     * @see SurfaceInterface::treeInhibitsIdle
+     * @since 5.22
+     **/
+    int inhibitingSurfaceCount() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the first visible surface starts or the last one stops inhibiting idle.
+     * @see isInhibited
+     * @since 5.22
+     **/
+    void inhibitedChanged();
+
 private:
     QScopedPointer<IdleInhibitManagerV1InterfacePrivate> d;
 };
@@ -8,17 +8,28 @@
 
 #include "idleinhibit_v1_interface.h"
 
+#include <QSet>
+
 #include <qwayland-server-idle-inhibit-unstable-v1.h>
 
 namespace KWaylandServer
 {
 
+class SurfaceInterface;
+
 class IdleInhibitManagerV1InterfacePrivate : public QtWaylandServer::zwp_idle_inhibit_manager_v1
 {
 public:
     IdleInhibitManagerV1InterfacePrivate(IdleInhibitManagerV1Interface *_q, Display *display);
 
+    void trackSurface(SurfaceInterface *surface);
+    void updateSurface(SurfaceInterface *surface);
+    void removeSurface(SurfaceInterface *surface);
+
     IdleInhibitManagerV1Interface *q;
+    // surfaces with inhibitors created through this manager, and the ones currently inhibiting
+    QSet<SurfaceInterface *> surfaces;
+    QSet<SurfaceInterface *> inhibitingSurfaces;
 
 protected:
     void zwp_idle_inhibit_manager_v1_destroy(Resource *resource) override;
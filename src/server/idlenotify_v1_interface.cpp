@@ -0,0 +1,113 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "idlenotify_v1_interface.h"
+#include "display.h"
+#include "idle_interface_p.h"
+#include "seat_interface.h"
+
+#include <QPointer>
+
+#include <algorithm>
+#include <climits>
+
+#include "qwayland-server-ext-idle-notify-v1.h"
+
+namespace KWaylandServer
+{
+
+static const int s_version = 1;
+
+class IdleNotifierV1InterfacePrivate : public QtWaylandServer::ext_idle_notifier_v1
+{
+public:
+    IdleNotifierV1InterfacePrivate(Display *display, IdleInterface *idle);
+
+    QPointer<IdleInterface> idle;
+
+protected:
+    void ext_idle_notifier_v1_destroy(Resource *resource) override;
+    void ext_idle_notifier_v1_get_idle_notification(Resource *resource, uint32_t id, uint32_t timeout, struct ::wl_resource *seat) override;
+};
+
+class IdleNotificationV1Interface : public QtWaylandServer::ext_idle_notification_v1, public IdleWatcher
+{
+public:
+    IdleNotificationV1Interface(SeatInterface *seat, IdleInterface *idle, wl_resource *resource);
+
+    void sendIdle() override;
+    void sendResumed() override;
+
+protected:
+    void ext_idle_notification_v1_destroy_resource(Resource *resource) override;
+    void ext_idle_notification_v1_destroy(Resource *resource) override;
+};
+
+IdleNotifierV1InterfacePrivate::IdleNotifierV1InterfacePrivate(Display *display, IdleInterface *idle)
+    : QtWaylandServer::ext_idle_notifier_v1(*display, s_version)
+    , idle(idle)
+{
+}
+
+void IdleNotifierV1InterfacePrivate::ext_idle_notifier_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void IdleNotifierV1InterfacePrivate::ext_idle_notifier_v1_get_idle_notification(Resource *resource, uint32_t id, uint32_t timeout, struct ::wl_resource *seat)
+{
+    SeatInterface *s = SeatInterface::get(seat);
+    Q_ASSERT(s);
+
+    wl_resource *notificationResource = wl_resource_create(resource->client(), &ext_idle_notification_v1_interface,
+                                                           resource->version(), id);
+    if (!notificationResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+
+    auto notification = new IdleNotificationV1Interface(s, idle, notificationResource);
+    notification->setup(int(std::min<uint32_t>(timeout, INT_MAX)));
+}
+
+IdleNotificationV1Interface::IdleNotificationV1Interface(SeatInterface *seat, IdleInterface *idle, wl_resource *resource)
+    : QtWaylandServer::ext_idle_notification_v1(resource)
+    , IdleWatcher(seat, idle)
+{
+}
+
+void IdleNotificationV1Interface::sendIdle()
+{
+    send_idled();
+}
+
+void IdleNotificationV1Interface::sendResumed()
+{
+    send_resumed();
+}
+
+void IdleNotificationV1Interface::ext_idle_notification_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void IdleNotificationV1Interface::ext_idle_notification_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+IdleNotifierV1Interface::IdleNotifierV1Interface(Display *display, IdleInterface *idle, QObject *parent)
+    : QObject(parent)
+    , d(new IdleNotifierV1InterfacePrivate(display, idle))
+{
+}
+
+IdleNotifierV1Interface::~IdleNotifierV1Interface()
+{
+}
+
+} // namespace KWaylandServer
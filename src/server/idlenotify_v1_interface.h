@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class IdleInterface;
+class IdleNotifierV1InterfacePrivate;
+
+/**
+ * The IdleNotifierV1Interface notifies clients when a seat has been idle for a given time.
+ *
+ * It is the standard counterpart of IdleInterface and runs on the same idle engine, the
+ * notifications of both protocols share one timer and input only records the time of the
+ * last activity of the seat. Inhibiting the IdleInterface with IdleInterface::inhibit(), e.g.
+ * while a surface with an idle inhibitor is visible, inhibits the notifications as well.
+ *
+ * IdleNotifierV1Interface corresponds to the Wayland interface @c ext_idle_notifier_v1.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT IdleNotifierV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * Creates the notifier global, the idle state is tracked by @p idle.
+     */
+    IdleNotifierV1Interface(Display *display, IdleInterface *idle, QObject *parent = nullptr);
+    ~IdleNotifierV1Interface() override;
+
+private:
+    QScopedPointer<IdleNotifierV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,175 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "inputlatency.h"
+#include "inputlatency_p.h"
+
+#include <QtAlgorithms>
+#include <QtMath>
+
+#include <chrono>
+#include <utility>
+
+namespace KWaylandServer
+{
+
+static qint64 currentTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+quint64 InputLatencyHistogram::count() const
+{
+    return m_count;
+}
+
+quint64 InputLatencyHistogram::bucket(int index) const
+{
+    if (index < 0 || index >= bucketCount) {
+        return 0;
+    }
+    return m_buckets[index];
+}
+
+qint64 InputLatencyHistogram::minimum() const
+{
+    return m_minimum;
+}
+
+qint64 InputLatencyHistogram::maximum() const
+{
+    return m_maximum;
+}
+
+qint64 InputLatencyHistogram::mean() const
+{
+    return m_count ? m_total / qint64(m_count) : 0;
+}
+
+qint64 InputLatencyHistogram::percentile(qreal percentile) const
+{
+    if (!m_count) {
+        return 0;
+    }
+    const quint64 rank = qBound<quint64>(1, quint64(qCeil(qBound<qreal>(0, percentile, 1) * m_count)), m_count);
+    quint64 seen = 0;
+    for (int i = 0; i < bucketCount; ++i) {
+        seen += m_buckets[i];
+        if (seen >= rank) {
+            if (i == bucketCount - 1) {
+                return m_maximum;
+            }
+            return qMin(m_maximum, (qint64(2) << i) * 1000);
+        }
+    }
+    return m_maximum;
+}
+
+void InputLatencyHistogram::addSample(qint64 nanoseconds)
+{
+    nanoseconds = qMax<qint64>(nanoseconds, 0);
+    const quint64 microseconds = quint64(nanoseconds) / 1000;
+    const int index = microseconds < 2 ? 0 : qMin(63 - int(qCountLeadingZeroBits(microseconds)), bucketCount - 1);
+    m_buckets[index]++;
+    if (!m_count || nanoseconds < m_minimum) {
+        m_minimum = nanoseconds;
+    }
+    m_maximum = qMax(m_maximum, nanoseconds);
+    m_total += nanoseconds;
+    m_count++;
+}
+
+InputLatencyHistogram &InputLatencyHistogram::operator+=(const InputLatencyHistogram &other)
+{
+    if (!other.m_count) {
+        return *this;
+    }
+    for (int i = 0; i < bucketCount; ++i) {
+        m_buckets[i] += other.m_buckets[i];
+    }
+    m_minimum = m_count ? qMin(m_minimum, other.m_minimum) : other.m_minimum;
+    m_maximum = qMax(m_maximum, other.m_maximum);
+    m_total += other.m_total;
+    m_count += other.m_count;
+    return *this;
+}
+
+void InputLatencyTracker::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if (!enabled) {
+        m_pending.clear();
+    }
+}
+
+void InputLatencyTracker::recordEvent(ClientConnection *client, InputLatencyEventType type)
+{
+    if (!m_enabled || !client) {
+        return;
+    }
+    m_pending[client].append({type, currentTime()});
+}
+
+void InputLatencyTracker::clientFlushed(ClientConnection *client)
+{
+    auto it = m_pending.find(client);
+    if (it == m_pending.end()) {
+        return;
+    }
+    const QVector<PendingEvent> events = it.value();
+    m_pending.erase(it);
+    completeEvents(client, events, currentTime());
+}
+
+void InputLatencyTracker::allClientsFlushed()
+{
+    if (m_pending.isEmpty()) {
+        return;
+    }
+    const qint64 now = currentTime();
+    const QHash<ClientConnection *, QVector<PendingEvent>> pending = std::exchange(m_pending, {});
+    for (auto it = pending.constBegin(); it != pending.constEnd(); ++it) {
+        completeEvents(it.key(), it.value(), now);
+    }
+}
+
+void InputLatencyTracker::completeEvents(ClientConnection *client, const QVector<PendingEvent> &events, qint64 now)
+{
+    Histograms &clientHistograms = m_clientHistograms[client];
+    for (const PendingEvent &event : events) {
+        const qint64 latency = now - event.entryTime;
+        m_histograms[int(event.type)].addSample(latency);
+        clientHistograms[int(event.type)].addSample(latency);
+    }
+}
+
+void InputLatencyTracker::removeClient(ClientConnection *client)
+{
+    m_pending.remove(client);
+    m_clientHistograms.remove(client);
+}
+
+void InputLatencyTracker::reset()
+{
+    m_pending.clear();
+    m_clientHistograms.clear();
+    m_histograms = Histograms();
+}
+
+InputLatencyHistogram InputLatencyTracker::histogram(InputLatencyEventType type) const
+{
+    return m_histograms[int(type)];
+}
+
+InputLatencyHistogram InputLatencyTracker::histogram(InputLatencyEventType type, ClientConnection *client) const
+{
+    auto it = m_clientHistograms.constFind(client);
+    if (it == m_clientHistograms.constEnd()) {
+        return InputLatencyHistogram();
+    }
+    return (*it)[int(type)];
+}
+
+}
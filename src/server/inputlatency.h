@@ -0,0 +1,93 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_INPUTLATENCY_H
+#define KWAYLAND_SERVER_INPUTLATENCY_H
+
+#include <QtGlobal>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <array>
+
+namespace KWaylandServer
+{
+
+/**
+ * The kinds of input events whose latency is tracked by the Display.
+ *
+ * @see Display::setInputLatencyTrackingEnabled
+ * @since 5.22
+ **/
+enum class InputLatencyEventType {
+    PointerMotion,
+    PointerButton,
+    PointerAxis,
+    Key,
+    Touch
+};
+
+/**
+ * @brief Histogram of the time input events spend inside the server.
+ *
+ * A sample is the time between the seat receiving an input event, e.g. with
+ * SeatInterface::setPointerPos() or KeyboardInterface::keyPressed(), and the event being
+ * written to the client's socket. The samples are sorted into buckets of powers of two
+ * microseconds: bucket @c 0 holds the samples below 2 µs, bucket @c i the samples in
+ * [2^i, 2^(i+1)) µs and the last bucket all longer samples.
+ *
+ * @see Display::inputLatency
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT InputLatencyHistogram
+{
+public:
+    static constexpr int bucketCount = 24;
+
+    /**
+     * @returns The number of samples.
+     **/
+    quint64 count() const;
+    /**
+     * @returns The number of samples in bucket @p index.
+     **/
+    quint64 bucket(int index) const;
+    /**
+     * @returns The shortest sample in nanoseconds, @c 0 without samples.
+     **/
+    qint64 minimum() const;
+    /**
+     * @returns The longest sample in nanoseconds, @c 0 without samples.
+     **/
+    qint64 maximum() const;
+    /**
+     * @returns The mean of the samples in nanoseconds, @c 0 without samples.
+     **/
+    qint64 mean() const;
+    /**
+     * @returns An upper bound in nanoseconds for the latency of the given @p percentile of
+     * the samples, for example @c 0.99 for the 99th percentile. The bound is the end of the
+     * bucket holding that sample, clamped to maximum().
+     **/
+    qint64 percentile(qreal percentile) const;
+
+    /**
+     * Adds a sample of @p nanoseconds.
+     **/
+    void addSample(qint64 nanoseconds);
+
+    InputLatencyHistogram &operator+=(const InputLatencyHistogram &other);
+
+private:
+    std::array<quint64, bucketCount> m_buckets = {};
+    quint64 m_count = 0;
+    qint64 m_minimum = 0;
+    qint64 m_maximum = 0;
+    qint64 m_total = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_INPUTLATENCY_P_H
+#define KWAYLAND_SERVER_INPUTLATENCY_P_H
+
+#include "inputlatency.h"
+
+#include <QHash>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+class ClientConnection;
+
+/**
+ * Records when input events enter the seat and completes the samples once the client the
+ * events were sent to is flushed.
+ */
+class InputLatencyTracker
+{
+public:
+    static constexpr int eventTypeCount = int(InputLatencyEventType::Touch) + 1;
+    typedef std::array<InputLatencyHistogram, eventTypeCount> Histograms;
+
+    bool isEnabled() const {
+        return m_enabled;
+    }
+    void setEnabled(bool enabled);
+
+    /**
+     * Records that an event of @p type for @p client entered the server now.
+     */
+    void recordEvent(ClientConnection *client, InputLatencyEventType type);
+    /**
+     * Completes the samples of the events recorded for @p client.
+     */
+    void clientFlushed(ClientConnection *client);
+    void allClientsFlushed();
+    void removeClient(ClientConnection *client);
+    void reset();
+
+    InputLatencyHistogram histogram(InputLatencyEventType type) const;
+    InputLatencyHistogram histogram(InputLatencyEventType type, ClientConnection *client) const;
+
+private:
+    struct PendingEvent {
+        InputLatencyEventType type;
+        qint64 entryTime;
+    };
+    void completeEvents(ClientConnection *client, const QVector<PendingEvent> &events, qint64 now);
+
+    bool m_enabled = false;
+    QHash<ClientConnection *, QVector<PendingEvent>> m_pending;
+    QHash<ClientConnection *, Histograms> m_clientHistograms;
+    Histograms m_histograms;
+};
+
+}
+
+#endif
@@ -12,6 +12,7 @@
 #include "surfacerole_p.h"
 
 #include <QHash>
+#include <algorithm>
 
 #include "qwayland-server-input-method-unstable-v1.h"
 #include "qwayland-server-text-input-unstable-v1.h"
@@ -126,6 +127,13 @@ public:
         return ret;
     }
 
+    void zwp_input_method_context_v1_bind_resource(Resource *resource) override
+    {
+        Q_UNUSED(resource)
+        // the new resource has not seen any state yet
+        resetSentState();
+    }
+
     void zwp_input_method_context_v1_destroy_resource(Resource *resource) override
     {
         Q_UNUSED(resource)
@@ -139,6 +147,156 @@ public:
         wl_resource_destroy(resource->handle);
     }
 
+    void resetSentState()
+    {
+        sentSurroundingText.valid = false;
+        sentContentType.valid = false;
+    }
+
+    void sendSurroundingText(const QString &text, quint32 cursor, quint32 anchor)
+    {
+        // a UTF-16 code unit takes at most three bytes in UTF-8, shorter texts always fit
+        if (surroundingTextLimit > 0 && text.size() * 3 > surroundingTextLimit) {
+            QString clippedText;
+            quint32 clippedCursor = cursor;
+            quint32 clippedAnchor = anchor;
+            if (clipSurroundingText(text, &clippedText, &clippedCursor, &clippedAnchor)) {
+                sendClippedSurroundingText(clippedText, clippedCursor, clippedAnchor);
+                return;
+            }
+        }
+        sendClippedSurroundingText(text, cursor, anchor);
+    }
+
+    /**
+     * Cuts @p text down to surroundingTextLimit bytes of UTF-8 around the cursor and the
+     * anchor, which are byte offsets and get moved along. Returns @c false if the text fits.
+     **/
+    bool clipSurroundingText(const QString &text, QString *clippedText, quint32 *cursor, quint32 *anchor) const
+    {
+        const QByteArray utf8 = text.toUtf8();
+        const int size = utf8.size();
+        if (size <= surroundingTextLimit) {
+            return false;
+        }
+        int low = std::min(int(std::min(*cursor, *anchor)), size);
+        int high = std::min(int(std::max(*cursor, *anchor)), size);
+        if (high - low > surroundingTextLimit) {
+            // the selection alone doesn't fit, keep the text around the cursor
+            low = high = std::min(int(*cursor), size);
+        }
+        int start = std::max(0, low - (surroundingTextLimit - (high - low)) / 2);
+        int end = std::min(size, start + surroundingTextLimit);
+        start = std::max(0, end - surroundingTextLimit);
+        // don't cut through a UTF-8 sequence
+        auto isContinuation = [&utf8](int i) {
+            return (uchar(utf8[i]) & 0xc0) == 0x80;
+        };
+        while (start < size && isContinuation(start)) {
+            start++;
+        }
+        while (end > start && end < size && isContinuation(end)) {
+            end--;
+        }
+        *clippedText = QString::fromUtf8(utf8.constData() + start, end - start);
+        *cursor = quint32(qBound(0, int(*cursor) - start, end - start));
+        *anchor = quint32(qBound(0, int(*anchor) - start, end - start));
+        return true;
+    }
+
+    void sendClippedSurroundingText(const QString &text, quint32 cursor, quint32 anchor)
+    {
+        if (sentSurroundingText.valid && sentSurroundingText.text == text
+                && sentSurroundingText.cursor == cursor && sentSurroundingText.anchor == anchor) {
+            return;
+        }
+        sentSurroundingText = {true, text, cursor, anchor};
+
+        for (auto r : resources()) {
+            send_surrounding_text(r->handle, text, cursor, anchor);
+        }
+    }
+
+    void sendContentType(quint32 hint, quint32 purpose)
+    {
+        if (sentContentType.valid && sentContentType.hint == hint && sentContentType.purpose == purpose) {
+            return;
+        }
+        sentContentType = {true, hint, purpose};
+
+        for (auto r : resources()) {
+            send_content_type(r->handle, hint, purpose);
+        }
+    }
+
+    void sendReset()
+    {
+        // the input method drops its state on reset, so everything has to be sent again
+        resetSentState();
+        for (auto r : resources()) {
+            send_reset(r->handle);
+        }
+    }
+
+    void sendPendingUpdate(quint32 serial)
+    {
+        if (pending.reset) {
+            sendReset();
+        }
+        if (pending.contentType) {
+            sendContentType(pending.hint, pending.purpose);
+        }
+        if (pending.surroundingText) {
+            sendSurroundingText(pending.text, pending.cursor, pending.anchor);
+        }
+        if (pending.preferredLanguage) {
+            for (auto r : resources()) {
+                send_preferred_language(r->handle, pending.language);
+            }
+        }
+        for (const auto &action : qAsConst(pending.invokeActions)) {
+            for (auto r : resources()) {
+                send_invoke_action(r->handle, action.first, action.second);
+            }
+        }
+        for (auto r : resources()) {
+            send_commit_state(r->handle, serial);
+        }
+        pending = {};
+    }
+
+    // the state last sent to the input method, used to drop redundant updates
+    struct {
+        bool valid = false;
+        QString text;
+        quint32 cursor = 0;
+        quint32 anchor = 0;
+    } sentSurroundingText;
+    struct {
+        bool valid = false;
+        quint32 hint = 0;
+        quint32 purpose = 0;
+    } sentContentType;
+
+    int surroundingTextLimit = 0;
+
+    // calls made between beginUpdate() and the outermost commitUpdate(), only the latest
+    // state is kept and sent in one go
+    int updateDepth = 0;
+    struct {
+        bool reset = false;
+        bool surroundingText = false;
+        QString text;
+        quint32 cursor = 0;
+        quint32 anchor = 0;
+        bool contentType = false;
+        quint32 hint = 0;
+        quint32 purpose = 0;
+        bool preferredLanguage = false;
+        QString language;
+        QVector<QPair<quint32, quint32>> invokeActions;
+    } pending;
+
 private:
     InputMethodContextV1Interface *const q;
     QVector<Qt::KeyboardModifiers> mods;
@@ -152,9 +310,37 @@ InputMethodContextV1Interface::InputMethodContextV1Interface(InputMethodV1Interf
 
 InputMethodContextV1Interface::~InputMethodContextV1Interface() = default;
 
+void InputMethodContextV1Interface::setSurroundingTextLimit(int bytes)
+{
+    d->surroundingTextLimit = std::max(bytes, 0);
+}
+
+int InputMethodContextV1Interface::surroundingTextLimit() const
+{
+    return d->surroundingTextLimit;
+}
+
+void InputMethodContextV1Interface::beginUpdate()
+{
+    d->updateDepth++;
+}
+
+void InputMethodContextV1Interface::commitUpdate(quint32 serial)
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0) {
+        return;
+    }
+    d->sendPendingUpdate(serial);
+}
+
 void InputMethodContextV1Interface::sendCommitState(uint32_t serial)
 {
-    for (auto r : d->resourceMap()) {
+    if (d->updateDepth > 0) {
+        // the update ends with the commit_state of commitUpdate()
+        return;
+    }
+    for (auto r : d->resources()) {
         d->send_commit_state(r->handle, serial);
     }
 }
@@ -240,37 +426,58 @@ void InputMethodContextV1Interface::sendContentType(TextInputContentHints hint,
         contentPurpose = QtWaylandServer::zwp_text_input_v1::content_purpose_alpha;
     }
 
-    for (auto r : d->resourceMap()) {
-        d->send_content_type(r->handle, contentHint, contentPurpose);
+    if (d->updateDepth > 0) {
+        d->pending.contentType = true;
+        d->pending.hint = contentHint;
+        d->pending.purpose = contentPurpose;
+        return;
     }
+    d->sendContentType(contentHint, contentPurpose);
 }
 
 void InputMethodContextV1Interface::sendInvokeAction(uint32_t button, uint32_t index)
 {
-    for (auto r : d->resourceMap()) {
+    if (d->updateDepth > 0) {
+        d->pending.invokeActions.append(qMakePair(button, index));
+        return;
+    }
+    for (auto r : d->resources()) {
         d->send_invoke_action(r->handle, button, index);
     }
 }
 
 void InputMethodContextV1Interface::sendPreferredLanguage(const QString &language)
 {
-    for (auto r : d->resourceMap()) {
+    if (d->updateDepth > 0) {
+        d->pending.preferredLanguage = true;
+        d->pending.language = language;
+        return;
+    }
+    for (auto r : d->resources()) {
         d->send_preferred_language(r->handle, language);
     }
 }
 
 void InputMethodContextV1Interface::sendReset()
 {
-    for (auto r : d->resourceMap()) {
-        d->send_reset(r->handle);
+    if (d->updateDepth > 0) {
+        // the reset goes out first, followed by the latest state
+        d->pending.reset = true;
+        return;
     }
+    d->sendReset();
 }
 
 void InputMethodContextV1Interface::sendSurroundingText(const QString &text, uint32_t cursor, uint32_t anchor)
 {
-    for (auto r : d->resourceMap()) {
-        d->send_surrounding_text(r->handle, text, cursor, anchor);
+    if (d->updateDepth > 0) {
+        d->pending.surroundingText = true;
+        d->pending.text = text;
+        d->pending.cursor = cursor;
+        d->pending.anchor = anchor;
+        return;
     }
+    d->sendSurroundingText(text, cursor, anchor);
 }
 
 class InputPanelSurfaceV1InterfacePrivate : public QtWaylandServer::zwp_input_panel_surface_v1, public SurfaceRole
@@ -279,7 +486,7 @@ class InputPanelSurfaceV1InterfacePrivate : public QtWaylandServer::zwp_input_pa
 public:
     InputPanelSurfaceV1InterfacePrivate(SurfaceInterface *surface, quint32 id, InputPanelSurfaceV1Interface *q)
         : zwp_input_panel_surface_v1()
-        , SurfaceRole(surface, QByteArrayLiteral("input_panel_surface_v1"))
+        , SurfaceRole(surface, SurfaceRole::Type::InputPanelSurface)
         , q(q)
     {
         Q_UNUSED(id)
@@ -331,7 +538,7 @@ public:
         if (surfaceRole) {
             wl_resource_post_error(resource->handle, 0,
                                    "the surface already has a role assigned %s",
-                                   surfaceRole->name().constData());
+                                   surfaceRole->name());
             return;
         }
 
@@ -67,13 +67,62 @@ class KWAYLANDSERVER_EXPORT InputMethodContextV1Interface : public QObject
 public:
     ~InputMethodContextV1Interface() override;
 
+    /**
+     * Sends the surrounding text to the input method. Nothing is sent if it equals the
+     * surrounding text sent last, unless sendReset() has been called since.
+     *
+     * The @p cursor and @p anchor are byte offsets into the UTF-8 encoded @p text, as provided
+     * by the text input interfaces. A text longer than the surroundingTextLimit is clipped
+     * around them first.
+     **/
     void sendSurroundingText(const QString &text, quint32 cursor, quint32 anchor);
+    /**
+     * Limits the surrounding text sent to the input method to @p bytes of UTF-8 around the
+     * cursor and the selection anchor, the cursor and anchor are adjusted accordingly. Input
+     * methods only look at the text near the cursor, so editors with large documents don't
+     * have to be forwarded in full on every keystroke. If the selection is longer than the
+     * limit, the text around the cursor is kept.
+     *
+     * The default of @c 0 means no limit.
+     * @see sendSurroundingText
+     * @since 5.22
+     **/
+    void setSurroundingTextLimit(int bytes);
+    /**
+     * @see setSurroundingTextLimit
+     * @since 5.22
+     **/
+    int surroundingTextLimit() const;
     void sendReset();
+    /**
+     * Sends the content type to the input method. Like sendSurroundingText(), an unchanged
+     * content type is not sent again.
+     **/
     void sendContentType(KWaylandServer::TextInputContentHints hint, KWaylandServer::TextInputContentPurpose purpose);
     void sendInvokeAction(quint32 button, quint32 index);
     void sendCommitState(quint32 serial);
     void sendPreferredLanguage(const QString &language);
 
+    /**
+     * Starts an update of the text input state. Until the matching commitUpdate() the
+     * surrounding text, content type, preferred language, reset and invoke actions are not sent
+     * but collected, only the latest surrounding text, content type and preferred language are
+     * kept. sendCommitState() has no effect during an update.
+     *
+     * Calls can be nested, the update is sent by the outermost commitUpdate().
+     * @see commitUpdate
+     * @since 5.22
+     **/
+    void beginUpdate();
+    /**
+     * Ends the update started by beginUpdate(). The collected state is sent in one burst which
+     * ends with a commit_state event with @p serial. A pending reset is sent first, so the
+     * state after it is what the input method keeps. Unchanged surrounding text and content
+     * type are not sent again.
+     * @since 5.22
+     **/
+    void commitUpdate(quint32 serial);
+
 Q_SIGNALS:
     void commitString(quint32 serial, const QString &text);
     void preeditString(quint32 serial, const QString &text, const QString &commit);
@@ -10,12 +10,11 @@
 #include "seat_interface_p.h"
 #include "surface_interface.h"
 #include "compositor_interface.h"
+#include "sharedkeymap_p.h"
 // Qt
-#include <QTemporaryFile>
+#include <QTimer>
 #include <QVector>
 
-#include <unistd.h>
-
 namespace KWaylandServer
 {
 
@@ -26,17 +25,86 @@ KeyboardInterfacePrivate::KeyboardInterfacePrivate(SeatInterface *s)
 
 void KeyboardInterfacePrivate::keyboard_bind_resource(Resource *resource)
 {
-    if (resource->version() >= WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) {
-        send_repeat_info(resource->handle, keyRepeat.charactersPerSecond, keyRepeat.delay);
-    }
+    sendRepeatInfo(resource);
     if (!keymap.isNull()) {
-        send_keymap(resource->handle, keymap_format::keymap_format_xkb_v1, keymap->handle(), keymap->size());
+        send_keymap(resource->handle, keymap_format::keymap_format_xkb_v1, keymap->fd(), keymap->size());
+    }
+    if (focusedSurface && focusedSurface->client()->client() == resource->client()) {
+        focusedKeyboards.append(resource);
+    }
+}
+
+void KeyboardInterfacePrivate::keyboard_destroy_resource(Resource *resource)
+{
+    focusedKeyboards.removeOne(resource);
+}
+
+void KeyboardInterfacePrivate::sendRepeatInfo(Resource *resource)
+{
+    if (resource->version() < WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) {
+        return;
+    }
+    for (ClientConnection *client : qAsConst(serverSideKeyRepeatClients)) {
+        if (client->client() == resource->client()) {
+            // the server repeats the keys, the client must not repeat them once more
+            send_repeat_info(resource->handle, 0, keyRepeat.delay);
+            return;
+        }
+    }
+    send_repeat_info(resource->handle, keyRepeat.charactersPerSecond, keyRepeat.delay);
+}
+
+void KeyboardInterfacePrivate::startServerSideKeyRepeat(quint32 key)
+{
+    if (keyRepeat.charactersPerSecond <= 0 || !serverSideKeyRepeatClients.contains(focusedSurface->client())) {
+        return;
+    }
+    // modifiers and the like don't repeat, nor do they stop the repeat of a held key
+    if (keymap && !keymap->keyRepeats(key)) {
+        return;
+    }
+    serverSideKeyRepeat.key = key;
+    serverSideKeyRepeat.timestamp = seat->timestamp() + keyRepeat.delay;
+    serverSideKeyRepeat.timer->start(keyRepeat.delay);
+}
+
+void KeyboardInterfacePrivate::stopServerSideKeyRepeat()
+{
+    serverSideKeyRepeat.timer->stop();
+    serverSideKeyRepeat.key = 0;
+}
+
+void KeyboardInterfacePrivate::sendServerSideKeyRepeat()
+{
+    if (!focusedSurface || keyRepeat.charactersPerSecond <= 0) {
+        stopServerSideKeyRepeat();
+        return;
     }
+    // a release followed by a press keeps the key state of the client balanced
+    const quint32 releaseSerial = seat->d_func()->nextSerial();
+    const quint32 pressSerial = seat->d_func()->nextSerial();
+    for (Resource *keyboardResource : qAsConst(focusedKeyboards)) {
+        send_key(keyboardResource->handle, releaseSerial, serverSideKeyRepeat.timestamp, serverSideKeyRepeat.key, key_state::key_state_released);
+        send_key(keyboardResource->handle, pressSerial, serverSideKeyRepeat.timestamp, serverSideKeyRepeat.key, key_state::key_state_pressed);
+    }
+
+    const int interval = qMax(1000 / keyRepeat.charactersPerSecond, 1);
+    serverSideKeyRepeat.timestamp += interval;
+    serverSideKeyRepeat.timer->setInterval(interval);
+}
+
+QVector<KeyboardInterfacePrivate::Resource *> KeyboardInterfacePrivate::keyboardsForClient(ClientConnection *client) const
+{
+    return resourcesForClient(client->client());
 }
 
-QList<KeyboardInterfacePrivate::Resource *> KeyboardInterfacePrivate::keyboardsForClient(ClientConnection *client) const
+void KeyboardInterfacePrivate::updateFocusedKeyboards()
 {
-    return resourceMap().values(client->client());
+    if (focusedSurface) {
+        focusedKeyboards = keyboardsForClient(focusedSurface->client());
+    } else {
+        focusedKeyboards.clear();
+    }
 }
 
 void KeyboardInterfacePrivate::focusChildSurface(SurfaceInterface *childSurface, quint32 serial)
@@ -54,7 +122,7 @@ void KeyboardInterfacePrivate::sendLeave(SurfaceInterface *surface, quint32 seri
     if (!surface) {
         return;
     }
-    const QList<Resource *> keyboards = keyboardsForClient(surface->client());
+    const QVector<Resource *> keyboards = keyboardsForClient(surface->client());
     for (Resource *keyboardResource : keyboards) {
         send_leave(keyboardResource->handle, serial, surface->resource());
     }
@@ -65,13 +133,13 @@ void KeyboardInterfacePrivate::sendEnter(SurfaceInterface *surface, quint32 seri
     if (!surface) {
         return;
     }
-    const auto states = pressedKeys();
+    const QVector<quint32> &pressed = keys.pressed();
     QByteArray data = QByteArray::fromRawData(
-        reinterpret_cast<const char*>(states.constData()),
-        sizeof(quint32) * states.size()
+        reinterpret_cast<const char*>(pressed.constData()),
+        sizeof(quint32) * pressed.size()
     );
 
-    const QList<Resource *> keyboards = keyboardsForClient(surface->client());
+    const QVector<Resource *> keyboards = keyboardsForClient(surface->client());
     for (Resource *keyboardResource : keyboards) {
         send_enter(keyboardResource->handle, serial, surface->resource(), data);
     }
@@ -84,30 +152,18 @@ void KeyboardInterface::setKeymap(const QByteArray &content)
     if (content.isNull()) {
         return;
     }
-    QScopedPointer<QTemporaryFile> tmp{new QTemporaryFile(this)};
-    if (!tmp->open()) {
-        return;
-    }
-    unlink(tmp->fileName().toUtf8().constData());
-    if (!tmp->resize(content.size())) {
-        return;
-    }
-    uchar *address = tmp->map(0, content.size());
-    if (!address) {
-        return;
-    }
-    if (qstrncpy(reinterpret_cast<char*>(address), content.constData(), content.size() + 1) == nullptr) {
+    const QSharedPointer<SharedKeymap> keymap = SharedKeymap::get(content);
+    if (keymap.isNull()) {
         return;
     }
-    tmp->unmap(address);
 
-    d->sendKeymap(tmp->handle(), content.size());
-    d->keymap.swap(tmp);
+    d->sendKeymap(keymap->fd(), keymap->size());
+    d->keymap = keymap;
 }
 
 void KeyboardInterfacePrivate::sendKeymap(int fd, quint32 size)
 {
-    const QList<Resource *> keyboards = resourceMap().values();
+    const QVector<Resource *> keyboards = resources();
     for (Resource *keyboardResource : keyboards) {
         send_keymap(keyboardResource->handle, keymap_format::keymap_format_xkb_v1, fd, size);
     }
@@ -118,29 +174,24 @@ void KeyboardInterfacePrivate::sendModifiers(quint32 depressed, quint32 latched,
     if (!focusedSurface) {
         return;
     }
-    const QList<Resource *> keyboards = keyboardsForClient(focusedSurface->client());
-    for (Resource *keyboardResource : keyboards) {
+    for (Resource *keyboardResource : qAsConst(focusedKeyboards)) {
         send_modifiers(keyboardResource->handle, serial, depressed, latched, locked, group);
     }
 }
 
 bool KeyboardInterfacePrivate::updateKey(quint32 key, State state)
 {
-    auto it = states.find(key);
-    if (it == states.end()) {
-        states.insert(key, state);
-        return true;
-    }
-    if (it.value() == state) {
-        return false;
-    }
-    it.value() = state;
-    return true;
+    return keys.update(key, state == State::Pressed);
 }
 
 KeyboardInterface::KeyboardInterface(SeatInterface *seat)
     : d(new KeyboardInterfacePrivate(seat))
 {
+    d->serverSideKeyRepeat.timer = new QTimer(this);
+    d->serverSideKeyRepeat.timer->setTimerType(Qt::PreciseTimer);
+    connect(d->serverSideKeyRepeat.timer, &QTimer::timeout, this, [this] {
+        d->sendServerSideKeyRepeat();
+    });
 }
 
 KeyboardInterface::~KeyboardInterface() = default;
@@ -152,19 +203,23 @@ void KeyboardInterfacePrivate::sendModifiers()
 
 void KeyboardInterface::setFocusedSurface(SurfaceInterface *surface, quint32 serial)
 {
+    d->stopServerSideKeyRepeat();
     d->sendLeave(d->focusedChildSurface, serial);
     disconnect(d->destroyConnection);
     d->focusedChildSurface.clear();
     d->focusedSurface = surface;
+    d->updateFocusedKeyboards();
     if (!d->focusedSurface) {
         return;
     }
     d->destroyConnection = connect(d->focusedSurface, &SurfaceInterface::aboutToBeDestroyed, this,
         [this] {
             CompositorInterface *compositor = d->focusedChildSurface->compositor();
+            d->stopServerSideKeyRepeat();
             d->sendLeave(d->focusedChildSurface.data(), compositor->display()->nextSerial());
             d->focusedSurface = nullptr;
             d->focusedChildSurface.clear();
+            d->focusedKeyboards.clear();
         }
     );
     d->focusedChildSurface = QPointer<SurfaceInterface>(surface);
@@ -172,17 +227,6 @@ void KeyboardInterface::setFocusedSurface(SurfaceInterface *surface, quint32 ser
     d->sendEnter(d->focusedSurface, serial);
 }
 
-QVector<quint32> KeyboardInterfacePrivate::pressedKeys() const
-{
-    QVector<quint32> keys;
-    for (auto it = states.constBegin(); it != states.constEnd(); ++it) {
-        if (it.value() == State::Pressed) {
-            keys << it.key();
-        }
-    }
-    return keys;
-}
-
 
 void KeyboardInterface::keyPressed(quint32 key)
 {
@@ -194,11 +238,14 @@ void KeyboardInterface::keyPressed(quint32 key)
         return;
     }
 
-    const QList<KeyboardInterfacePrivate::Resource *> keyboards = d->keyboardsForClient(d->focusedSurface->client());
+    d->seat->d_func()->recordInputLatency(d->focusedSurface, InputLatencyEventType::Key);
     const quint32 serial = d->seat->d_func()->nextSerial();
-    for (KeyboardInterfacePrivate::Resource *keyboardResource : keyboards) {
+    d->seat->d_func()->recordInputSerial(serial, SeatInterface::Private::InputSerial::Type::Key, d->focusedSurface);
+    for (KeyboardInterfacePrivate::Resource *keyboardResource : qAsConst(d->focusedKeyboards)) {
         d->send_key(keyboardResource->handle, serial, d->seat->timestamp(), key, KeyboardInterfacePrivate::key_state::key_state_pressed);
     }
+    d->startServerSideKeyRepeat(key);
+    d->seat->d_func()->flushInput(d->focusedSurface);
 }
 
 void KeyboardInterface::keyReleased(quint32 key)
@@ -211,11 +258,15 @@ void KeyboardInterface::keyReleased(quint32 key)
         return;
     }
 
-    const QList<KeyboardInterfacePrivate::Resource *> keyboards = d->keyboardsForClient(d->focusedSurface->client());
+    d->seat->d_func()->recordInputLatency(d->focusedSurface, InputLatencyEventType::Key);
     const quint32 serial = d->seat->d_func()->nextSerial();
-    for (KeyboardInterfacePrivate::Resource *keyboardResource : keyboards) {
+    for (KeyboardInterfacePrivate::Resource *keyboardResource : qAsConst(d->focusedKeyboards)) {
         d->send_key(keyboardResource->handle, serial, d->seat->timestamp(), key, KeyboardInterfacePrivate::key_state::key_state_released);
     }
+    if (d->serverSideKeyRepeat.key == key) {
+        d->stopServerSideKeyRepeat();
+    }
+    d->seat->d_func()->flushInput(d->focusedSurface);
 }
 
 void KeyboardInterface::updateModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group)
@@ -246,14 +297,41 @@ void KeyboardInterface::setRepeatInfo(qint32 charactersPerSecond, qint32 delay)
 {
     d->keyRepeat.charactersPerSecond = qMax(charactersPerSecond, 0);
     d->keyRepeat.delay = qMax(delay, 0);
-    const QList<KeyboardInterfacePrivate::Resource *> keyboards = d->resourceMap().values();
+    d->stopServerSideKeyRepeat();
+    const QVector<KeyboardInterfacePrivate::Resource *> keyboards = d->resources();
     for (KeyboardInterfacePrivate::Resource *keyboardResource : keyboards) {
-        if (keyboardResource->version() >= WL_KEYBOARD_REPEAT_INFO_SINCE_VERSION) {
-            d->send_repeat_info(keyboardResource->handle, d->keyRepeat.charactersPerSecond, d->keyRepeat.delay);
-        }
+        d->sendRepeatInfo(keyboardResource);
+    }
+}
+
+void KeyboardInterface::setServerSideKeyRepeat(ClientConnection *client, bool enabled)
+{
+    if (!client || d->serverSideKeyRepeatClients.contains(client) == enabled) {
+        return;
+    }
+    if (enabled) {
+        d->serverSideKeyRepeatClients.insert(client);
+        connect(client, &ClientConnection::disconnected, this, [this](ClientConnection *client) {
+            d->serverSideKeyRepeatClients.remove(client);
+        });
+    } else {
+        d->serverSideKeyRepeatClients.remove(client);
+        disconnect(client, &ClientConnection::disconnected, this, nullptr);
+    }
+    if (d->focusedSurface && d->focusedSurface->client() == client) {
+        d->stopServerSideKeyRepeat();
+    }
+    const QVector<KeyboardInterfacePrivate::Resource *> keyboards = d->keyboardsForClient(client);
+    for (KeyboardInterfacePrivate::Resource *keyboardResource : keyboards) {
+        d->sendRepeatInfo(keyboardResource);
     }
 }
 
+bool KeyboardInterface::hasServerSideKeyRepeat(ClientConnection *client) const
+{
+    return d->serverSideKeyRepeatClients.contains(client);
+}
+
 SurfaceInterface *KeyboardInterface::focusedSurface() const
 {
     return d->focusedSurface;
@@ -13,6 +13,7 @@
 namespace KWaylandServer
 {
 
+class ClientConnection;
 class SeatInterface;
 class SurfaceInterface;
 class KeyboardInterfacePrivate;
@@ -57,6 +58,27 @@ public:
      **/
     void setRepeatInfo(qint32 charactersPerSecond, qint32 delay);
 
+    /**
+     * Sets whether key repeat for the keyboards of @p client is driven by the server.
+     *
+     * The repeat info sent to the keyboards of such a client disables key repeat. Instead,
+     * while a key is held with a surface of the client focused, the server synthesizes a
+     * release and a press event of the key at the rate and delay set with setRepeatInfo().
+     * This is meant for clients which don't implement key repeat or can't keep up with it.
+     *
+     * By default key repeat is left to the clients.
+     *
+     * @see hasServerSideKeyRepeat
+     * @since 5.22
+     **/
+    void setServerSideKeyRepeat(ClientConnection *client, bool enabled);
+    /**
+     * @returns Whether key repeat for the keyboards of @p client is driven by the server.
+     * @see setServerSideKeyRepeat
+     * @since 5.22
+     **/
+    bool hasServerSideKeyRepeat(ClientConnection *client) const;
+
     void keyPressed(quint32 key);
     void keyReleased(quint32 key);
 
@@ -6,18 +6,22 @@
 #ifndef WAYLAND_SERVER_KEYBOARD_INTERFACE_P_H
 #define WAYLAND_SERVER_KEYBOARD_INTERFACE_P_H
 #include "keyboard_interface.h"
+#include "pressedcodes_p.h"
 
 #include <qwayland-server-wayland.h>
 
 #include <QPointer>
 #include <QHash>
+#include <QSet>
+#include <QSharedPointer>
 
-class QTemporaryFile;
+class QTimer;
 
 namespace KWaylandServer
 {
 
 class ClientConnection;
+class SharedKeymap;
 
 class KeyboardInterfacePrivate : public QtWaylandServer::wl_keyboard
 {
@@ -27,9 +31,14 @@ public:
 
     void sendKeymap(int fd, quint32 size);
     void sendModifiers();
+    void sendRepeatInfo(Resource *resource);
     void sendModifiers(quint32 depressed, quint32 latched, quint32 locked, quint32 group, quint32 serial);
 
-    QList<Resource *> keyboardsForClient(ClientConnection *client) const;
+    QVector<Resource *> keyboardsForClient(ClientConnection *client) const;
+    /**
+     * Resets focusedKeyboards to the keyboards of the client owning the focused surface.
+     */
+    void updateFocusedKeyboards();
     void focusChildSurface(SurfaceInterface *childSurface, quint32 serial);
     void sendLeave(SurfaceInterface *surface, quint32 serial);
     void sendEnter(SurfaceInterface *surface, quint32 serial);
@@ -38,15 +47,30 @@ public:
 
     SeatInterface *seat;
     SurfaceInterface *focusedSurface = nullptr;
+    // the keyboards of the client owning the focused surface, kept up to date on bind and
+    // destroy so the key and modifier events don't have to look them up
+    QVector<Resource *> focusedKeyboards;
     QPointer<SurfaceInterface> focusedChildSurface;
     QMetaObject::Connection destroyConnection;
-    QScopedPointer<QTemporaryFile> keymap;
+    QSharedPointer<SharedKeymap> keymap;
 
     struct {
         qint32 charactersPerSecond = 0;
         qint32 delay = 0;
     } keyRepeat;
 
+    void startServerSideKeyRepeat(quint32 key);
+    void stopServerSideKeyRepeat();
+    void sendServerSideKeyRepeat();
+
+    QSet<ClientConnection *> serverSideKeyRepeatClients;
+    // the key repeated on behalf of the focused client, if any
+    struct {
+        QTimer *timer = nullptr;
+        quint32 key = 0;
+        quint32 timestamp = 0;
+    } serverSideKeyRepeat;
+
     struct Modifiers {
         quint32 depressed = 0;
         quint32 latched = 0;
@@ -60,12 +84,12 @@ public:
         Released,
         Pressed
     };
-    QHash<quint32, State> states;
+    PressedCodes keys;
     bool updateKey(quint32 key, State state);
-    QVector<quint32> pressedKeys() const;
 
 protected:
     void keyboard_bind_resource(Resource *resource) override;
+    void keyboard_destroy_resource(Resource *resource) override;
 };
 
 }
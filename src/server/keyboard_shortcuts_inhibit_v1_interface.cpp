@@ -9,7 +9,7 @@
 #include <qwayland-server-keyboard-shortcuts-inhibit-unstable-v1.h>
 
 #include "display.h"
-#include "seat_interface.h"
+#include "seat_interface_p.h"
 #include "surface_interface.h"
 
 static const int s_version = 1;
@@ -26,7 +26,7 @@ public:
     KeyboardShortcutsInhibitorV1Interface *q;
     QPointer<KeyboardShortcutsInhibitManagerV1Interface> m_manager;
     SurfaceInterface *const m_surface;
-    SeatInterface *const m_seat;
+    const QPointer<SeatInterface> m_seat;
     bool m_active;
 
 protected:
@@ -80,6 +80,9 @@ KeyboardShortcutsInhibitorV1InterfacePrivate::zwp_keyboard_shortcuts_inhibitor_v
     if (m_manager) {
         m_manager->removeInhibitor(m_surface, m_seat);
     }
+    if (m_seat) {
+        m_seat->d_func()->unregisterKeyboardShortcutsInhibitor(q);
+    }
     delete q;
 }
 
@@ -142,6 +145,9 @@ void KeyboardShortcutsInhibitManagerV1InterfacePrivate::zwp_keyboard_shortcuts_i
                                                         resource->version(), id);
     auto inhibitor = new KeyboardShortcutsInhibitorV1Interface(surface, seat, q, inhibitorResource);
     m_inhibitors[{surface, seat}] = inhibitor;
+    if (seat) {
+        seat->d_func()->registerKeyboardShortcutsInhibitor(inhibitor);
+    }
     Q_EMIT q->inhibitorCreated(inhibitor);
     inhibitor->setActive(true);
 }
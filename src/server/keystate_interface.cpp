@@ -8,6 +8,7 @@
 #include "display.h"
 
 #include <QDebug>
+#include <QTimer>
 #include <QVector>
 #include <qwayland-server-keystate.h>
 
@@ -15,37 +16,73 @@ namespace KWaylandServer
 {
 
 static const quint32 s_version = 1;
+static const int s_keyCount = 3;
 
 class KeyStateInterfacePrivate : public QtWaylandServer::org_kde_kwin_keystate
 {
 public:
-    KeyStateInterfacePrivate(Display *d)
+    KeyStateInterfacePrivate(KeyStateInterface *q, Display *d)
         : QtWaylandServer::org_kde_kwin_keystate(*d, s_version)
-    {}
+    {
+        // changes made in one go, e.g. when the keymap gets reset, go out together
+        sendTimer.setSingleShot(true);
+        sendTimer.setInterval(0);
+        QObject::connect(&sendTimer, &QTimer::timeout, q, [this]() {
+            sendChanges();
+        });
+    }
+
+    class KeyStateResource : public Resource
+    {
+    public:
+        // the states the client has been told about, -1 if none yet
+        int sentStates[s_keyCount] = {-1, -1, -1};
+    };
+
+    Resource *org_kde_kwin_keystate_allocate() override {
+        return new KeyStateResource;
+    }
 
     void org_kde_kwin_keystate_fetchStates(Resource *resource) override {
+        KeyStateResource *keyStateResource = static_cast<KeyStateResource *>(resource);
         for (int i = 0; i < m_keyStates.count(); ++i) {
             send_stateChanged(resource->handle, i, m_keyStates[i]);
+            keyStateResource->sentStates[i] = m_keyStates[i];
+        }
+    }
+
+    void sendChanges() {
+        const auto clients = resourceMap();
+        for (Resource *resource : clients) {
+            KeyStateResource *keyStateResource = static_cast<KeyStateResource *>(resource);
+            for (int i = 0; i < m_keyStates.count(); ++i) {
+                if (keyStateResource->sentStates[i] == m_keyStates[i]) {
+                    continue;
+                }
+                send_stateChanged(resource->handle, i, m_keyStates[i]);
+                keyStateResource->sentStates[i] = m_keyStates[i];
+            }
         }
     }
 
-    QVector<KeyStateInterface::State> m_keyStates = QVector<KeyStateInterface::State>(3, KeyStateInterface::Unlocked);
+    QVector<KeyStateInterface::State> m_keyStates = QVector<KeyStateInterface::State>(s_keyCount, KeyStateInterface::Unlocked);
+    QTimer sendTimer;
 };
 
 KeyStateInterface::KeyStateInterface(Display* d, QObject* parent)
     : QObject(parent)
-    , d(new KeyStateInterfacePrivate(d))
+    , d(new KeyStateInterfacePrivate(this, d))
 {}
 
 KeyStateInterface::~KeyStateInterface() = default;
 
 void KeyStateInterface::setState(KeyStateInterface::Key key, KeyStateInterface::State state)
 {
-    d->m_keyStates[int(key)] = state;
-
-    for (auto r : d->resourceMap()) {
-        d->send_stateChanged(r->handle, int(key), int(state));
+    if (d->m_keyStates[int(key)] == state) {
+        return;
     }
+    d->m_keyStates[int(key)] = state;
+    d->sendTimer.start();
 }
 
 }
@@ -42,6 +42,13 @@ public:
     };
     Q_ENUM(State)
 
+    /**
+     * Sets the state @p s of the key @p k.
+     *
+     * Clients are only told about states which differ from what they have been sent before.
+     * Changes made in one go, before the event loop runs again, are sent together, a state
+     * changed back in the meantime is not sent at all.
+     **/
     void setState(Key k, State s);
 
 private:
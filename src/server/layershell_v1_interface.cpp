@@ -7,10 +7,12 @@
 #include "layershell_v1_interface.h"
 #include "display.h"
 #include "logging.h"
+#include "output_interface.h"
 #include "surface_interface.h"
 #include "surfacerole_p.h"
 #include "xdgshell_interface_p.h"
 
+#include <QHash>
 #include <QPointer>
 #include <QQueue>
 
@@ -26,8 +28,34 @@ class LayerShellV1InterfacePrivate : public QtWaylandServer::zwlr_layer_shell_v1
 public:
     LayerShellV1InterfacePrivate(LayerShellV1Interface *q, Display *display);
 
+    static LayerShellV1InterfacePrivate *get(LayerShellV1Interface *shell);
+
+    quint32 sendConfigures(const QHash<LayerSurfaceV1Interface *, QSize> &sizes);
+    void handleConfigureAcknowledged(LayerSurfaceV1Interface *surface);
+    void removeSurface(LayerSurfaceV1Interface *surface);
+    void completeBatches();
+    void updateExclusiveZone(LayerSurfaceV1Interface *surface);
+    void updateWorkArea(OutputInterface *output);
+
+    struct ConfigureBatch
+    {
+        quint32 id;
+        QHash<LayerSurfaceV1Interface *, quint32> serials;
+    };
+
+    struct WorkArea
+    {
+        // the space each layer surface on the output reserves
+        QHash<LayerSurfaceV1Interface *, QMargins> exclusiveMargins;
+        QRect rect;
+    };
+
     LayerShellV1Interface *q;
     Display *display;
+    QList<ConfigureBatch> configureBatches;
+    quint32 lastBatchId = 0;
+    // only the outputs which had layer surfaces with an exclusive zone
+    QHash<OutputInterface *, WorkArea> workAreas;
 
 protected:
     void zwlr_layer_shell_v1_get_layer_surface(Resource *resource, uint32_t id,
@@ -54,6 +82,7 @@ public:
     LayerSurfaceV1InterfacePrivate(LayerSurfaceV1Interface *q, SurfaceInterface *surface);
 
     void commit() override;
+    QMargins exclusiveMargins() const;
 
     LayerSurfaceV1Interface *q;
     LayerShellV1Interface *shell;
@@ -111,7 +140,7 @@ void LayerShellV1InterfacePrivate::zwlr_layer_shell_v1_get_layer_surface(Resourc
     if (surfaceRole) {
         wl_resource_post_error(resource->handle, error_role,
                                "the wl_surface already has a role assigned %s",
-                               surfaceRole->name().constData());
+                               surfaceRole->name());
         return;
     }
 
@@ -134,6 +163,149 @@ void LayerShellV1InterfacePrivate::zwlr_layer_shell_v1_destroy(Resource *resourc
     wl_resource_destroy(resource->handle);
 }
 
+LayerShellV1InterfacePrivate *LayerShellV1InterfacePrivate::get(LayerShellV1Interface *shell)
+{
+    return shell->d.data();
+}
+
+quint32 LayerShellV1InterfacePrivate::sendConfigures(const QHash<LayerSurfaceV1Interface *, QSize> &sizes)
+{
+    ConfigureBatch batch;
+    for (auto it = sizes.constBegin(); it != sizes.constEnd(); ++it) {
+        LayerSurfaceV1Interface *surface = it.key();
+        if (surface->d->shell != q) {
+            qCWarning(KWAYLAND_SERVER) << "Cannot configure a layer shell surface of another layer shell";
+            continue;
+        }
+        const quint32 serial = surface->sendConfigure(it.value());
+        if (serial) {
+            batch.serials.insert(surface, serial);
+        }
+    }
+    if (batch.serials.isEmpty()) {
+        return 0;
+    }
+
+    batch.id = ++lastBatchId;
+    if (!batch.id) {
+        batch.id = ++lastBatchId;
+    }
+    configureBatches.append(batch);
+
+    return batch.id;
+}
+
+void LayerShellV1InterfacePrivate::handleConfigureAcknowledged(LayerSurfaceV1Interface *surface)
+{
+    const QQueue<quint32> &pendingSerials = surface->d->serials;
+    for (ConfigureBatch &batch : configureBatches) {
+        auto it = batch.serials.find(surface);
+        if (it != batch.serials.end() && !pendingSerials.contains(*it)) {
+            batch.serials.erase(it);
+        }
+    }
+    completeBatches();
+}
+
+void LayerShellV1InterfacePrivate::removeSurface(LayerSurfaceV1Interface *surface)
+{
+    for (ConfigureBatch &batch : configureBatches) {
+        batch.serials.remove(surface);
+    }
+    completeBatches();
+    // A closed or destroyed surface doesn't reserve space anymore.
+    for (auto it = workAreas.begin(); it != workAreas.end(); ++it) {
+        if (it->exclusiveMargins.remove(surface)) {
+            updateWorkArea(it.key());
+            break;
+        }
+    }
+}
+
+void LayerShellV1InterfacePrivate::completeBatches()
+{
+    // Batches are settled in the order they were sent, a relayout is only done once the
+    // relayouts that preceded it are done as well.
+    while (!configureBatches.isEmpty() && configureBatches.first().serials.isEmpty()) {
+        const quint32 id = configureBatches.takeFirst().id;
+        emit q->configuresAcknowledged(id);
+    }
+}
+
+static QRect outputGeometry(OutputInterface *output)
+{
+    QSize size = output->pixelSize();
+    switch (output->transform()) {
+    case OutputInterface::Transform::Rotated90:
+    case OutputInterface::Transform::Rotated270:
+    case OutputInterface::Transform::Flipped90:
+    case OutputInterface::Transform::Flipped270:
+        size.transpose();
+        break;
+    default:
+        break;
+    }
+    return QRect(output->globalPosition(), size / qMax(output->scale(), 1));
+}
+
+void LayerShellV1InterfacePrivate::updateExclusiveZone(LayerSurfaceV1Interface *surface)
+{
+    OutputInterface *output = surface->output();
+    if (!output) {
+        return;
+    }
+    const QMargins margins = surface->d->exclusiveMargins();
+    auto it = workAreas.find(output);
+    if (it == workAreas.end()) {
+        if (margins.isNull()) {
+            return;
+        }
+        it = workAreas.insert(output, WorkArea{{}, outputGeometry(output)});
+        // The work area follows the output, the entry is dropped with it.
+        auto update = [this, output]() {
+            updateWorkArea(output);
+        };
+        QObject::connect(output, &OutputInterface::globalPositionChanged, q, update);
+        QObject::connect(output, &OutputInterface::pixelSizeChanged, q, update);
+        QObject::connect(output, &OutputInterface::scaleChanged, q, update);
+        QObject::connect(output, &OutputInterface::transformChanged, q, update);
+        QObject::connect(output, &QObject::destroyed, q, [this, output]() {
+            workAreas.remove(output);
+        });
+    }
+
+    if (margins.isNull()) {
+        if (!it->exclusiveMargins.remove(surface)) {
+            return;
+        }
+    } else {
+        auto current = it->exclusiveMargins.find(surface);
+        if (current != it->exclusiveMargins.end() && *current == margins) {
+            return;
+        }
+        it->exclusiveMargins.insert(surface, margins);
+    }
+    updateWorkArea(output);
+}
+
+void LayerShellV1InterfacePrivate::updateWorkArea(OutputInterface *output)
+{
+    auto it = workAreas.find(output);
+    if (it == workAreas.end()) {
+        return;
+    }
+    QMargins reserved;
+    for (const QMargins &margins : qAsConst(it->exclusiveMargins)) {
+        reserved += margins;
+    }
+    const QRect rect = outputGeometry(output).marginsRemoved(reserved);
+    if (it->rect == rect) {
+        return;
+    }
+    it->rect = rect;
+    emit q->workAreaChanged(output, rect);
+}
+
 LayerShellV1Interface::LayerShellV1Interface(Display *display, QObject *parent)
     : QObject(parent)
     , d(new LayerShellV1InterfacePrivate(this, display))
@@ -149,9 +321,33 @@ Display *LayerShellV1Interface::display() const
     return d->display;
 }
 
+quint32 LayerShellV1Interface::sendConfigures(const QHash<LayerSurfaceV1Interface *, QSize> &sizes)
+{
+    return d->sendConfigures(sizes);
+}
+
+bool LayerShellV1Interface::isConfigurePending(quint32 batch) const
+{
+    for (const LayerShellV1InterfacePrivate::ConfigureBatch &configureBatch : qAsConst(d->configureBatches)) {
+        if (configureBatch.id == batch) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QRect LayerShellV1Interface::workArea(OutputInterface *output) const
+{
+    auto it = d->workAreas.constFind(output);
+    if (it == d->workAreas.constEnd()) {
+        return outputGeometry(output);
+    }
+    return it->rect;
+}
+
 LayerSurfaceV1InterfacePrivate::LayerSurfaceV1InterfacePrivate(LayerSurfaceV1Interface *q,
                                                                SurfaceInterface *surface)
-    : SurfaceRole(surface, QByteArrayLiteral("layer_surface_v1"))
+    : SurfaceRole(surface, SurfaceRole::Type::LayerSurface)
     , q(q)
     , surface(surface)
 {
@@ -161,6 +357,7 @@ void LayerSurfaceV1InterfacePrivate::zwlr_layer_surface_v1_destroy_resource(Reso
 {
     Q_UNUSED(resource)
     emit q->aboutToBeDestroyed();
+    LayerShellV1InterfacePrivate::get(shell)->removeSurface(q);
     delete q;
 }
 
@@ -243,6 +440,7 @@ void LayerSurfaceV1InterfacePrivate::zwlr_layer_surface_v1_ack_configure(Resourc
     if (!isClosed) {
         emit q->configureAcknowledged(serial);
     }
+    LayerShellV1InterfacePrivate::get(shell)->handleConfigureAcknowledged(q);
 }
 
 void LayerSurfaceV1InterfacePrivate::zwlr_layer_surface_v1_destroy(Resource *resource)
@@ -296,6 +494,7 @@ void LayerSurfaceV1InterfacePrivate::commit()
         current = LayerSurfaceV1State();
         pending = LayerSurfaceV1State();
 
+        LayerShellV1InterfacePrivate::get(shell)->updateExclusiveZone(q);
         return;
     }
 
@@ -321,6 +520,32 @@ void LayerSurfaceV1InterfacePrivate::commit()
     if (previous.margins != current.margins) {
         emit q->marginsChanged();
     }
+    if (previous.exclusiveZone != current.exclusiveZone || previous.anchor != current.anchor
+            || previous.margins != current.margins) {
+        LayerShellV1InterfacePrivate::get(shell)->updateExclusiveZone(q);
+    }
+}
+
+QMargins LayerSurfaceV1InterfacePrivate::exclusiveMargins() const
+{
+    if (!isCommitted || isClosed) {
+        return QMargins();
+    }
+    // The margin of the anchor edge keeps the surface away from the edge, the space is
+    // reserved as well.
+    const int zone = current.exclusiveZone;
+    switch (q->exclusiveEdge()) {
+    case Qt::TopEdge:
+        return QMargins(0, zone + current.margins.top(), 0, 0);
+    case Qt::RightEdge:
+        return QMargins(0, 0, zone + current.margins.right(), 0);
+    case Qt::BottomEdge:
+        return QMargins(0, 0, 0, zone + current.margins.bottom());
+    case Qt::LeftEdge:
+        return QMargins(zone + current.margins.left(), 0, 0, 0);
+    default:
+        return QMargins();
+    }
 }
 
 LayerSurfaceV1Interface::LayerSurfaceV1Interface(LayerShellV1Interface *shell,
@@ -454,6 +679,8 @@ void LayerSurfaceV1Interface::sendClosed()
     if (!d->isClosed) {
         d->send_closed();
         d->isClosed = true;
+        // A closed surface is not going to be laid out anymore, don't wait for it.
+        LayerShellV1InterfacePrivate::get(d->shell)->removeSurface(this);
     }
 }
 
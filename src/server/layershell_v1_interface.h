@@ -8,7 +8,9 @@
 
 #include "display.h"
 
+#include <QHash>
 #include <QMargins>
+#include <QRect>
 
 namespace KWaylandServer
 {
@@ -40,14 +42,73 @@ public:
      */
     Display *display() const;
 
+    /**
+     * Sends configure events to several layer surfaces at once, e.g. after the work area of an
+     * output has changed. @a sizes maps every affected layer surface to its new desired size,
+     * see LayerSurfaceV1Interface::sendConfigure().
+     *
+     * All configure events are sent within the same dispatch and are acknowledged as a whole,
+     * this function returns the id of the batch, configuresAcknowledged() is emitted with it
+     * once every surface in the batch has acknowledged its configure event, has been closed
+     * or has been destroyed. Closed surfaces are skipped, if no configure event could be
+     * sent, @c 0 is returned and configuresAcknowledged() is not emitted.
+     *
+     * @see configuresAcknowledged()
+     * @see isConfigurePending()
+     * @since 5.22
+     */
+    quint32 sendConfigures(const QHash<LayerSurfaceV1Interface *, QSize> &sizes);
+
+    /**
+     * Returns @c true if some surfaces of the configure @a batch have not acknowledged their
+     * configure events yet; otherwise returns @c false.
+     *
+     * @since 5.22
+     */
+    bool isConfigurePending(quint32 batch) const;
+
+    /**
+     * Returns the geometry of @a output, in the global compositor space, without the space
+     * reserved by the exclusive zones of the layer surfaces on it. The exclusive zones on an
+     * edge add up, e.g. two panels at the top edge reserve the space for both.
+     *
+     * Only layer surfaces which asked for @a output are taken into account, the surfaces
+     * without an output are placed by the compositor, which reserves their space itself.
+     *
+     * @see workAreaChanged()
+     * @since 5.22
+     */
+    QRect workArea(OutputInterface *output) const;
+
 Q_SIGNALS:
     /**
      * This signal is emitted when a new layer surface @a surface has been created.
      */
     void surfaceCreated(LayerSurfaceV1Interface *surface);
 
+    /**
+     * This signal is emitted when all surfaces of the configure @a batch have acknowledged
+     * their configure events. Batches settle in the order they were sent.
+     *
+     * @see sendConfigures()
+     * @since 5.22
+     */
+    void configuresAcknowledged(quint32 batch);
+
+    /**
+     * This signal is emitted when the work area of @a output has changed to @a workArea,
+     * because a layer surface on it committed another exclusive zone, anchor or margin, was
+     * unmapped, closed or destroyed, or because the geometry of @a output changed while layer
+     * surfaces reserve space on it. It is not emitted if the work area stays the same.
+     *
+     * @see workArea()
+     * @since 5.22
+     */
+    void workAreaChanged(OutputInterface *output, const QRect &workArea);
+
 private:
     QScopedPointer<LayerShellV1InterfacePrivate> d;
+    friend class LayerShellV1InterfacePrivate;
 };
 
 /**
@@ -177,6 +238,7 @@ Q_SIGNALS:
 
 private:
     QScopedPointer<LayerSurfaceV1InterfacePrivate> d;
+    friend class LayerShellV1InterfacePrivate;
 };
 
 } // namespace KWaylandServer
@@ -8,18 +8,28 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "linuxdmabuf_v1_interface.h"
+#include "anonymousfile_p.h"
 
 #include "drm_fourcc.h"
 #include "global_p.h"
+#include "logging.h"
+#include "output_interface.h"
+#include "surface_interface.h"
 #include "wayland-linux-dmabuf-unstable-v1-server-protocol.h"
 #include "wayland-server-protocol.h"
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
+#include <QDataStream>
+#include <QPointer>
 #include <QVector>
 
+
 #include <array>
 #include <assert.h>
+#include <limits>
+#include <string.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 namespace KWaylandServer
@@ -104,9 +114,88 @@ public:
 
     void bind(wl_client *client, uint32_t version, uint32_t id) override final;
     void createParams(wl_client *client, wl_resource *resource, uint32_t id);
+    void createFeedback(wl_client *client, wl_resource *resource, uint32_t id, SurfaceInterface *surface);
+
+    void buildFormatTable();
+    QByteArray trancheIndices(const QHash<uint32_t, QSet<uint64_t>> &formats);
+    bool isSupported(uint32_t format, uint64_t modifier) const;
+    void sendFeedback(wl_resource *resource, SurfaceInterface *surface);
+    void sendTranche(wl_resource *resource, dev_t device, const QByteArray &indices, uint32_t flags);
+    void updateFeedback(SurfaceInterface *surface);
+    void trackSurface(SurfaceInterface *surface);
 
     static void unbind(wl_client *client, wl_resource *resource);
     static void createParamsCallback(wl_client *client, wl_resource *resource, uint32_t id);
+    static void getDefaultFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id);
+    static void getSurfaceFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *surface);
+
+    /**
+     * An entry of the format table, as laid out in the shared memory clients map.
+     **/
+    struct FormatModifier
+    {
+        uint32_t format;
+        uint32_t padding;
+        uint64_t modifier;
+    };
+    static_assert(sizeof(FormatModifier) == 16, "The format table entries are 16 bytes wide");
+
+    /**
+     * A zwp_linux_dmabuf_feedback_v1, for @c surface or the default one if it was created
+     * without a surface.
+     **/
+    struct Feedback
+    {
+        V1Iface::Private *dmabufInterface;
+        wl_resource *resource;
+        QPointer<SurfaceInterface> surface;
+        bool isDefault;
+    };
+
+    dev_t mainDevice = 0;
+    // the entries of the supported formats come first, followed by the scanout only ones
+    QVector<FormatModifier> formatTable;
+    int supportedFormatCount = 0;
+    QHash<QPair<uint32_t, uint64_t>, uint16_t> formatIndices;
+    int formatTableFd = -1;
+    // the indices of the tranches, passed to the clients as they are
+    QByteArray defaultTranche;
+    QHash<OutputInterface *, QHash<uint32_t, QSet<uint64_t>>> scanoutFormats;
+    QHash<OutputInterface *, QByteArray> scanoutTranches;
+    QHash<SurfaceInterface *, OutputInterface *> scanoutOutputs;
+
+    /**
+     * An import of the compositor shared by all wl_buffers over the same dmabufs with the
+     * same layout. Once unused it is kept in releasedImports until the cache is full.
+     **/
+    struct ImportedBuffer
+    {
+        V1Iface::Private *dmabufInterface;
+        LinuxDmabufUnstableV1Buffer *buffer;
+        QByteArray key;
+        int resourceCount;
+    };
+    struct ImportListener
+    {
+        wl_listener listener;
+        ImportedBuffer *import;
+    };
+    void releaseImport(ImportedBuffer *import);
+    void trimImportCache();
+
+    int importCacheSize = 0;
+    QHash<QByteArray, ImportedBuffer *> importCache;
+    // the least recently used first
+    QVector<ImportedBuffer *> releasedImports;
+
+    struct SurfaceTranches
+    {
+        QVector<V1Iface::Tranche> tranches;
+        QVector<QByteArray> indices;
+    };
+    QHash<SurfaceInterface *, SurfaceTranches> surfaceTranches;
+    QSet<SurfaceInterface *> trackedSurfaces;
+    QVector<Feedback *> feedbacks;
 
 private:
     class Params
@@ -121,6 +210,7 @@ private:
 
         void add(int fd, uint32_t plane_idx, uint32_t offset, uint32_t stride, uint64_t modifier);
         void create(wl_client *client, uint32_t bufferId, const QSize &size, uint32_t format, uint32_t flags);
+        QByteArray importKey(const QSize &size, uint32_t format, uint32_t flags) const;
 
         static void destroy(wl_client *client, wl_resource *resource);
         static void add(wl_client *client, wl_resource *resource, int fd, uint32_t plane_idx, uint32_t offset, uint32_t stride, uint32_t modifier_hi, uint32_t modifier_lo);
@@ -138,6 +228,7 @@ private:
     };
 
     static const struct zwp_linux_dmabuf_v1_interface s_implementation;
+    static const struct zwp_linux_dmabuf_feedback_v1_interface s_feedbackImplementation;
     static const struct wl_buffer_interface s_bufferImplementation;
 };
 
@@ -165,7 +256,13 @@ void V1Iface::Private::Params::createImmed(wl_client *client, wl_resource *resou
 #ifndef K_DOXYGEN
 const struct zwp_linux_dmabuf_v1_interface V1Iface::Private::s_implementation = {
     [](wl_client *, wl_resource *resource) { wl_resource_destroy(resource); }, // unbind
-    createParamsCallback
+    createParamsCallback,
+    getDefaultFeedbackCallback,
+    getSurfaceFeedbackCallback
+};
+
+const struct zwp_linux_dmabuf_feedback_v1_interface V1Iface::Private::s_feedbackImplementation = {
+    [](wl_client *, wl_resource *resource) { wl_resource_destroy(resource); } // destroy
 };
 
 const struct wl_buffer_interface V1Iface::Private::s_bufferImplementation = {
@@ -252,6 +349,20 @@ void V1Iface::Private::Params::create(wl_client *client, uint32_t bufferId, cons
         return;
     }
 
+    // Version 4 clients only get to know the pairs of the format table
+    if (wl_resource_get_version(m_resource) >= 4) {
+        for (uint32_t i = 0; i < m_planeCount; i++) {
+            if (m_dmabufInterface->isSupported(format, m_planes[i].modifier)) {
+                continue;
+            }
+            wl_resource_post_error(m_resource,
+                                   ZWP_LINUX_BUFFER_PARAMS_V1_ERROR_INVALID_FORMAT,
+                                   "format 0x%x with modifier 0x%llx was not advertised for plane %i",
+                                   format, static_cast<unsigned long long>(m_planes[i].modifier), i);
+            return;
+        }
+    }
+
     for (uint32_t i = 0; i < m_planeCount; i++) {
         auto &plane = m_planes[i];
 
@@ -302,32 +413,75 @@ void V1Iface::Private::Params::create(wl_client *client, uint32_t bufferId, cons
 
     // Import the buffer
     // -----------------
-    QVector<V1Iface::Plane> planes;
-    planes.reserve(m_planeCount);
-    for (uint32_t i = 0; i < m_planeCount; i++)
-        planes << m_planes[i];
-
-    LinuxDmabufUnstableV1Buffer *buffer = m_dmabufInterface->impl->importBuffer(planes,
-                                                                                format,
-                                                                                size,
-                                                                                (V1Iface::Flags) flags);
-    if (buffer) {
-        // The buffer has ownership of the file descriptors now
-        for (auto &plane : m_planes) {
-            plane.fd = -1;
+    // a buffer over the same dmabufs with the same layout reuses the compositor's import
+    const QByteArray key = m_dmabufInterface->importCacheSize > 0 ? importKey(size, format, flags) : QByteArray();
+    ImportedBuffer *import = key.isEmpty() ? nullptr : m_dmabufInterface->importCache.value(key);
+    LinuxDmabufUnstableV1Buffer *buffer = nullptr;
+    if (import) {
+        m_dmabufInterface->releasedImports.removeOne(import);
+        buffer = import->buffer;
+    } else {
+        QVector<V1Iface::Plane> planes;
+        planes.reserve(m_planeCount);
+        for (uint32_t i = 0; i < m_planeCount; i++)
+            planes << m_planes[i];
+
+        buffer = m_dmabufInterface->impl->importBuffer(planes,
+                                                       format,
+                                                       size,
+                                                       (V1Iface::Flags) flags);
+        if (buffer) {
+            // The buffer has ownership of the file descriptors now
+            for (auto &plane : m_planes) {
+                plane.fd = -1;
+            }
+            if (!key.isEmpty()) {
+                import = new ImportedBuffer{m_dmabufInterface, buffer, key, 0};
+                m_dmabufInterface->importCache.insert(key, import);
+            }
         }
-
+    }
+    if (buffer) {
         wl_resource *resource = wl_resource_create(client, &wl_buffer_interface, 1, bufferId);
         if (!resource ) {
             postNoMemory();
-            delete buffer;
+            if (import) {
+                m_dmabufInterface->releaseImport(import);
+            } else {
+                delete buffer;
+            }
             return;
         }
 
-        wl_resource_set_implementation(resource, m_dmabufInterface->q->bufferImplementation(), buffer,
-                                       [](wl_resource *resource) { // Destructor
-                                            delete static_cast<LinuxDmabufUnstableV1Buffer *>(wl_resource_get_user_data(resource));
-                                       });
+        if (import) {
+            // the import is only gone once the last of its buffers is
+            import->resourceCount++;
+            wl_resource_set_implementation(resource, m_dmabufInterface->q->bufferImplementation(), buffer, nullptr);
+            auto listener = new ImportListener;
+            listener->import = import;
+            listener->listener.notify = [](wl_listener *listener, void *data) {
+                Q_UNUSED(data)
+                ImportListener *importListener = wl_container_of(listener, importListener, listener);
+                ImportedBuffer *import = importListener->import;
+                wl_list_remove(&listener->link);
+                delete importListener;
+                if (--import->resourceCount > 0) {
+                    return;
+                }
+                if (import->dmabufInterface) {
+                    import->dmabufInterface->releaseImport(import);
+                } else {
+                    delete import->buffer;
+                    delete import;
+                }
+            };
+            wl_resource_add_destroy_listener(resource, &listener->listener);
+        } else {
+            wl_resource_set_implementation(resource, m_dmabufInterface->q->bufferImplementation(), buffer,
+                                           [](wl_resource *resource) { // Destructor
+                                                delete static_cast<LinuxDmabufUnstableV1Buffer *>(wl_resource_get_user_data(resource));
+                                           });
+        }
 
         // XXX Do we need this?
         //buffer->setResource(resource);
@@ -407,7 +561,7 @@ void V1Iface::Private::Params::add(wl_client *client, wl_resource *resource,
     params->add(fd, plane_idx, offset, stride, (uint64_t(modifier_hi) << 32) | modifier_lo);
 }
 
-const uint32_t V1Iface::Private::s_version = 3;
+const uint32_t V1Iface::Private::s_version = 4;
 #endif
 
 V1Iface::Private::Private(V1Iface *q, Display *display)
@@ -416,7 +570,229 @@ V1Iface::Private::Private(V1Iface *q, Display *display)
 {
 }
 
-V1Iface::Private::~Private() = default;
+V1Iface::Private::~Private()
+{
+    // the feedback objects and the buffers of the clients outlive the global
+    for (Feedback *feedback : qAsConst(feedbacks)) {
+        feedback->dmabufInterface = nullptr;
+    }
+    for (ImportedBuffer *import : qAsConst(importCache)) {
+        if (import->resourceCount > 0) {
+            import->dmabufInterface = nullptr;
+        } else {
+            delete import->buffer;
+            delete import;
+        }
+    }
+    if (formatTableFd != -1) {
+        ::close(formatTableFd);
+    }
+}
+
+QByteArray V1Iface::Private::Params::importKey(const QSize &size, uint32_t format, uint32_t flags) const
+{
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream << size << format << flags;
+    for (uint32_t i = 0; i < m_planeCount; i++) {
+        const auto &plane = m_planes[i];
+        // a dmabuf keeps its identity while it is alive, and the cached import keeps it alive
+        struct stat status;
+        if (fstat(plane.fd, &status) != 0) {
+            return QByteArray();
+        }
+        stream << quint64(status.st_dev) << quint64(status.st_ino) << plane.offset << plane.stride << quint64(plane.modifier);
+    }
+    return key;
+}
+
+void V1Iface::Private::releaseImport(ImportedBuffer *import)
+{
+    releasedImports.append(import);
+    trimImportCache();
+}
+
+void V1Iface::Private::trimImportCache()
+{
+    while (releasedImports.count() > importCacheSize) {
+        ImportedBuffer *import = releasedImports.takeFirst();
+        importCache.remove(import->key);
+        delete import->buffer;
+        delete import;
+    }
+}
+
+QByteArray V1Iface::Private::trancheIndices(const QHash<uint32_t, QSet<uint64_t>> &formats)
+{
+    QByteArray indices;
+    for (auto it = formats.constBegin(); it != formats.constEnd(); ++it) {
+        QSet<uint64_t> modifiers = it.value();
+        if (modifiers.isEmpty()) {
+            modifiers << DRM_FORMAT_MOD_INVALID;
+        }
+        for (uint64_t modifier : qAsConst(modifiers)) {
+            const QPair<uint32_t, uint64_t> key(it.key(), modifier);
+            auto index = formatIndices.constFind(key);
+            if (index == formatIndices.constEnd()) {
+                if (formatTable.count() > std::numeric_limits<uint16_t>::max()) {
+                    qCWarning(KWAYLAND_SERVER) << "Too many dmabuf formats and modifiers, ignoring format" << it.key();
+                    continue;
+                }
+                index = formatIndices.insert(key, formatTable.count());
+                formatTable.append(FormatModifier{it.key(), 0, modifier});
+            }
+            const uint16_t value = *index;
+            indices.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+    }
+    return indices;
+}
+
+void V1Iface::Private::buildFormatTable()
+{
+    formatTable.clear();
+    formatIndices.clear();
+    scanoutTranches.clear();
+    defaultTranche = trancheIndices(supportedFormatsWithModifiers);
+    supportedFormatCount = formatTable.count();
+    for (auto it = scanoutFormats.constBegin(); it != scanoutFormats.constEnd(); ++it) {
+        scanoutTranches.insert(it.key(), trancheIndices(it.value()));
+    }
+    for (SurfaceTranches &surface : surfaceTranches) {
+        surface.indices.clear();
+        for (const V1Iface::Tranche &tranche : qAsConst(surface.tranches)) {
+            surface.indices << trancheIndices(tranche.formats);
+        }
+    }
+
+    // the clients which got the old table keep their own descriptor of it
+    if (formatTableFd != -1) {
+        ::close(formatTableFd);
+    }
+    const QByteArray content(reinterpret_cast<const char *>(formatTable.constData()),
+                             formatTable.count() * sizeof(FormatModifier));
+    formatTableFd = AnonymousFile::createReadOnly("kwaylandserver-dmabuf-formats", content);
+    if (formatTableFd == -1) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create the dmabuf format table";
+    }
+}
+
+bool V1Iface::Private::isSupported(uint32_t format, uint64_t modifier) const
+{
+    return formatIndices.contains(qMakePair(format, modifier));
+}
+
+void V1Iface::Private::sendTranche(wl_resource *resource, dev_t device, const QByteArray &indices, uint32_t flags)
+{
+    wl_array target;
+    target.size = sizeof(dev_t);
+    target.alloc = 0;
+    target.data = &device;
+    zwp_linux_dmabuf_feedback_v1_send_tranche_target_device(resource, &target);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_flags(resource, flags);
+
+    // the indices are sent as they are kept, without copying them
+    wl_array array;
+    array.size = indices.size();
+    array.alloc = 0;
+    array.data = const_cast<char *>(indices.constData());
+    zwp_linux_dmabuf_feedback_v1_send_tranche_formats(resource, &array);
+    zwp_linux_dmabuf_feedback_v1_send_tranche_done(resource);
+}
+
+void V1Iface::Private::sendFeedback(wl_resource *resource, SurfaceInterface *surface)
+{
+    if (formatTableFd != -1) {
+        zwp_linux_dmabuf_feedback_v1_send_format_table(resource, formatTableFd,
+                                                       formatTable.count() * sizeof(FormatModifier));
+    }
+    wl_array device;
+    device.size = sizeof(dev_t);
+    device.alloc = 0;
+    device.data = &mainDevice;
+    zwp_linux_dmabuf_feedback_v1_send_main_device(resource, &device);
+
+    if (surface) {
+        auto tranches = surfaceTranches.constFind(surface);
+        if (tranches != surfaceTranches.constEnd()) {
+            for (int i = 0; i < tranches->tranches.count(); ++i) {
+                const V1Iface::Tranche &tranche = tranches->tranches.at(i);
+                if (tranches->indices.at(i).isEmpty()) {
+                    continue;
+                }
+                sendTranche(resource, tranche.device ? tranche.device : mainDevice, tranches->indices.at(i),
+                            tranche.flags & V1Iface::Scanout ? ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT : 0);
+            }
+        } else {
+            auto it = scanoutTranches.constFind(scanoutOutputs.value(surface));
+            if (it != scanoutTranches.constEnd() && !it->isEmpty()) {
+                sendTranche(resource, mainDevice, *it, ZWP_LINUX_DMABUF_FEEDBACK_V1_TRANCHE_FLAGS_SCANOUT);
+            }
+        }
+    }
+    sendTranche(resource, mainDevice, defaultTranche, 0);
+    zwp_linux_dmabuf_feedback_v1_send_done(resource);
+}
+
+void V1Iface::Private::updateFeedback(SurfaceInterface *surface)
+{
+    for (Feedback *feedback : qAsConst(feedbacks)) {
+        if (feedback->isDefault) {
+            if (!surface) {
+                sendFeedback(feedback->resource, nullptr);
+            }
+        } else if (feedback->surface && (!surface || feedback->surface == surface)) {
+            sendFeedback(feedback->resource, feedback->surface);
+        }
+    }
+}
+
+void V1Iface::Private::trackSurface(SurfaceInterface *surface)
+{
+    if (trackedSurfaces.contains(surface)) {
+        return;
+    }
+    trackedSurfaces.insert(surface);
+    QObject::connect(surface, &QObject::destroyed, q, [this, surface] {
+        trackedSurfaces.remove(surface);
+        scanoutOutputs.remove(surface);
+        surfaceTranches.remove(surface);
+    });
+}
+
+void V1Iface::Private::createFeedback(wl_client *client, wl_resource *resource, uint32_t id, SurfaceInterface *surface)
+{
+    wl_resource *feedbackResource = wl_resource_create(client, &zwp_linux_dmabuf_feedback_v1_interface,
+                                                       wl_resource_get_version(resource), id);
+    if (!feedbackResource) {
+        wl_resource_post_no_memory(resource);
+        return;
+    }
+
+    auto feedback = new Feedback{this, feedbackResource, surface, !surface};
+    feedbacks.append(feedback);
+    wl_resource_set_implementation(feedbackResource, &s_feedbackImplementation, feedback,
+                                   [](wl_resource *resource) {
+                                       auto feedback = static_cast<Feedback *>(wl_resource_get_user_data(resource));
+                                       if (feedback->dmabufInterface) {
+                                           feedback->dmabufInterface->feedbacks.removeOne(feedback);
+                                       }
+                                       delete feedback;
+                                   });
+    sendFeedback(feedbackResource, surface);
+}
+
+void V1Iface::Private::getDefaultFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id)
+{
+    V1Iface::Private *global = static_cast<V1Iface::Private *>(wl_resource_get_user_data(resource));
+    global->createFeedback(client, resource, id, nullptr);
+}
+
+void V1Iface::Private::getSurfaceFeedbackCallback(wl_client *client, wl_resource *resource, uint32_t id, wl_resource *surface)
+{
+    V1Iface::Private *global = static_cast<V1Iface::Private *>(wl_resource_get_user_data(resource));
+    global->createFeedback(client, resource, id, SurfaceInterface::get(surface));
+}
 
 void V1Iface::Private::bind(wl_client *client, uint32_t version, uint32_t id)
 {
@@ -431,23 +807,19 @@ void V1Iface::Private::bind(wl_client *client, uint32_t version, uint32_t id)
     // Send formats & modifiers
     // ------------------------
 
-    QHash<uint32_t, QSet<uint64_t>>::const_iterator it = supportedFormatsWithModifiers.constBegin();
-    while (it != supportedFormatsWithModifiers.constEnd()) {
-        QSet<uint64_t> modifiers = it.value();
-        if (modifiers.isEmpty()) {
-            modifiers << DRM_FORMAT_MOD_INVALID;
-        }
-
-        for (uint64_t modifier : qAsConst(modifiers)) {
-            if (version >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
-                const uint32_t modifier_lo = modifier & 0xFFFFFFFF;
-                const uint32_t modifier_hi = modifier >> 32;
-                zwp_linux_dmabuf_v1_send_modifier(resource, it.key(), modifier_hi, modifier_lo);
-            } else if (modifier == DRM_FORMAT_MOD_LINEAR || modifier == DRM_FORMAT_MOD_INVALID) {
-                zwp_linux_dmabuf_v1_send_format(resource, it.key());
-            }
+    // version 4 clients get them from the feedback instead
+    if (version >= ZWP_LINUX_DMABUF_V1_GET_DEFAULT_FEEDBACK_SINCE_VERSION) {
+        return;
+    }
+    for (int i = 0; i < supportedFormatCount; i++) {
+        const FormatModifier &entry = formatTable.at(i);
+        if (version >= ZWP_LINUX_DMABUF_V1_MODIFIER_SINCE_VERSION) {
+            const uint32_t modifier_lo = entry.modifier & 0xFFFFFFFF;
+            const uint32_t modifier_hi = entry.modifier >> 32;
+            zwp_linux_dmabuf_v1_send_modifier(resource, entry.format, modifier_hi, modifier_lo);
+        } else if (entry.modifier == DRM_FORMAT_MOD_LINEAR || entry.modifier == DRM_FORMAT_MOD_INVALID) {
+            zwp_linux_dmabuf_v1_send_format(resource, entry.format);
         }
-        it++;
     }
 }
 
@@ -481,7 +853,111 @@ void V1Iface::setImpl(V1Iface::Impl *impl)
 
 void V1Iface::setSupportedFormatsWithModifiers(QHash<uint32_t, QSet<uint64_t> > set)
 {
-    d_func()->supportedFormatsWithModifiers = set;
+    Private *d = d_func();
+    d->supportedFormatsWithModifiers = set;
+    d->buildFormatTable();
+    d->updateFeedback(nullptr);
+}
+
+void V1Iface::setMainDevice(dev_t device)
+{
+    Private *d = d_func();
+    if (d->mainDevice == device) {
+        return;
+    }
+    d->mainDevice = device;
+    d->updateFeedback(nullptr);
+}
+
+dev_t V1Iface::mainDevice() const
+{
+    return d_func()->mainDevice;
+}
+
+void V1Iface::setImportCacheSize(int size)
+{
+    Private *d = d_func();
+    d->importCacheSize = qMax(0, size);
+    d->trimImportCache();
+}
+
+int V1Iface::importCacheSize() const
+{
+    return d_func()->importCacheSize;
+}
+
+void V1Iface::setScanoutFormatsWithModifiers(OutputInterface *output, const QHash<uint32_t, QSet<uint64_t> > &set)
+{
+    Private *d = d_func();
+    if (set.isEmpty()) {
+        if (!d->scanoutFormats.remove(output)) {
+            return;
+        }
+    } else {
+        if (!d->scanoutFormats.contains(output)) {
+            connect(output, &QObject::destroyed, this, [this, output] {
+                setScanoutFormatsWithModifiers(output, {});
+                Private *d = d_func();
+                for (auto it = d->scanoutOutputs.begin(); it != d->scanoutOutputs.end();) {
+                    if (it.value() == output) {
+                        it = d->scanoutOutputs.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+            });
+        }
+        d->scanoutFormats.insert(output, set);
+    }
+    d->buildFormatTable();
+    d->updateFeedback(nullptr);
+}
+
+void V1Iface::setScanoutOutput(SurfaceInterface *surface, OutputInterface *output)
+{
+    Private *d = d_func();
+    if (d->scanoutOutputs.value(surface) == output) {
+        return;
+    }
+    if (output) {
+        d->trackSurface(surface);
+        d->scanoutOutputs.insert(surface, output);
+    } else {
+        d->scanoutOutputs.remove(surface);
+    }
+    d->updateFeedback(surface);
+}
+
+void V1Iface::setSurfaceTranches(SurfaceInterface *surface, const QVector<Tranche> &tranches)
+{
+    Private *d = d_func();
+    if (tranches.isEmpty()) {
+        if (d->surfaceTranches.remove(surface)) {
+            d->updateFeedback(surface);
+        }
+        return;
+    }
+    d->trackSurface(surface);
+
+    Private::SurfaceTranches &entry = d->surfaceTranches[surface];
+    entry.tranches = tranches;
+    entry.indices.clear();
+    const int tableSize = d->formatTable.count();
+    for (const Tranche &tranche : tranches) {
+        entry.indices << d->trancheIndices(tranche.formats);
+    }
+    if (d->formatTable.count() != tableSize) {
+        // the clients only know the indices of the table they got
+        d->buildFormatTable();
+        d->updateFeedback(nullptr);
+    } else {
+        d->updateFeedback(surface);
+    }
+}
+
+QVector<V1Iface::Tranche> V1Iface::surfaceTranches(SurfaceInterface *surface) const
+{
+    return d_func()->surfaceTranches.value(surface).tranches;
 }
 
 const struct wl_buffer_interface *V1Iface::bufferImplementation()
@@ -16,11 +16,15 @@
 #include <QSet>
 #include <QSize>
 
+#include <sys/types.h>
+
 struct wl_buffer_interface;
 
 namespace KWaylandServer
 {
 class BufferInterface;
+class OutputInterface;
+class SurfaceInterface;
 
 /**
  * The base class for linux-dmabuf buffers
@@ -97,6 +101,25 @@ public:
         uint64_t modifier;  /// The layout modifier
     };
 
+    enum TrancheFlag {
+        Scanout             = (1 << 0)     /// The buffers may be scanned out directly
+    };
+
+    Q_DECLARE_FLAGS(TrancheFlags, TrancheFlag)
+
+    /**
+     * A set of formats and modifiers the dmabuf feedback of a surface prefers, e.g. the
+     * ones a plane of an output can scan out. All formats of one tranche are preferred
+     * equally.
+     * @see setSurfaceTranches
+     * @since 5.22
+     */
+    struct Tranche {
+        dev_t device = 0;                                /// The target device, @c 0 for the main device
+        QHash<uint32_t, QSet<uint64_t> > formats;     /// The formats with their modifiers
+        TrancheFlags flags;
+    };
+
     /**
      * The Iface class provides an interface from the LinuxDmabufInterface into the compositor
      */
@@ -117,6 +140,10 @@ public:
          * Note that it is the responsibility of the caller to close the file descriptors
          * when the import fails.
          *
+         * With an import cache, the returned buffer is shared by all wl_buffers created
+         * over the same dmabufs with the same layout.
+         * @see setImportCacheSize
+         *
          * @return The imported buffer on success, and nullptr otherwise.
          */
         virtual LinuxDmabufUnstableV1Buffer *importBuffer(const QVector<Plane> &planes,
@@ -137,8 +164,87 @@ public:
      */
     void setImpl(Impl *impl);
 
+    /**
+     * Sets the formats and modifiers the compositor can import. Clients binding version 4
+     * get them through the dmabuf feedback, as indices into a format table which is built
+     * once here and shared by all clients, the older ones get one event per format and
+     * modifier on bind. A format without modifiers is supported with an implicit modifier.
+     **/
     void setSupportedFormatsWithModifiers(QHash<uint32_t, QSet<uint64_t> > set);
 
+    /**
+     * Makes wl_buffers created over dmabufs which were imported already reuse that import,
+     * instead of passing them to Impl::importBuffer again. Clients recycling their swapchains
+     * or video players creating a wl_buffer per frame over a pool of dmabufs then don't
+     * cost the compositor a new import, e.g. an EGLImage, per wl_buffer. The dmabufs are
+     * told apart by the device and inode of their file descriptors, together with the
+     * offsets, strides and modifiers of the planes, the format, the size and the flags.
+     *
+     * Up to @p size imports no wl_buffer uses anymore are kept, holding on to their dmabufs,
+     * the least recently used ones are deleted first. The default @c 0 disables the cache.
+     * @since 5.22
+     **/
+    void setImportCacheSize(int size);
+    /**
+     * @returns how many unused imports are kept for reuse
+     * @see setImportCacheSize
+     * @since 5.22
+     **/
+    int importCacheSize() const;
+
+    /**
+     * Sets the device the compositor imports dmabufs on, which the dmabuf feedback
+     * advertises as the main device and as the target device of all tranches. Has to be
+     * set before clients binding version 4 create feedback objects.
+     * @since 5.22
+     **/
+    void setMainDevice(dev_t device);
+    /**
+     * @returns the device advertised as the main device of the dmabuf feedback
+     * @see setMainDevice
+     * @since 5.22
+     **/
+    dev_t mainDevice() const;
+
+    /**
+     * Sets the formats and modifiers the planes of @p output can scan out directly. An
+     * empty @p set removes them. They are offered to the surfaces which are put on
+     * @p output with setScanoutOutput, in a tranche flagged for direct scanout which is
+     * preferred over the formats the compositor can import.
+     * @see setScanoutOutput
+     * @since 5.22
+     **/
+    void setScanoutFormatsWithModifiers(OutputInterface *output, const QHash<uint32_t, QSet<uint64_t> > &set);
+    /**
+     * Makes the feedback of @p surface prefer the scanout formats of @p output, e.g. while
+     * the surface is fullscreen on it and could be scanned out directly. The clients
+     * which asked for the feedback of @p surface get it again, so they can allocate their
+     * next buffers for direct scanout. A @c null @p output goes back to the formats the
+     * compositor can import.
+     * @see setScanoutFormatsWithModifiers
+     * @since 5.22
+     **/
+    void setScanoutOutput(SurfaceInterface *surface, OutputInterface *output);
+    /**
+     * Makes the feedback of @p surface prefer the @p tranches, in the given order, over the
+     * formats the compositor can import, e.g. when the compositor decided that @p surface
+     * is a candidate for the primary plane or an overlay plane of an output and knows the
+     * formats and modifiers that plane accepts. While set, the tranches replace the scanout
+     * formats of the output set with setScanoutOutput. An empty list removes them.
+     *
+     * Formats which are not in the format table yet make all clients get a new table, the
+     * compositor should prefer the pairs it passed to setSupportedFormatsWithModifiers or
+     * setScanoutFormatsWithModifiers.
+     * @since 5.22
+     **/
+    void setSurfaceTranches(SurfaceInterface *surface, const QVector<Tranche> &tranches);
+    /**
+     * @returns the tranches the feedback of @p surface prefers
+     * @see setSurfaceTranches
+     * @since 5.22
+     **/
+    QVector<Tranche> surfaceTranches(SurfaceInterface *surface) const;
+
     /**
      * Returns the LinuxDmabufInterface for the given resource.
      **/
@@ -160,5 +266,6 @@ private:
 
 Q_DECLARE_METATYPE(KWaylandServer::LinuxDmabufUnstableV1Interface*)
 Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::LinuxDmabufUnstableV1Interface::Flags)
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::LinuxDmabufUnstableV1Interface::TrancheFlags)
 
 #endif // WAYLAND_SERVER_LINUXDMABUF_INTERFACE_H
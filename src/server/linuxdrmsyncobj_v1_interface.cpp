@@ -0,0 +1,217 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "linuxdrmsyncobj_v1_interface.h"
+#include "buffer_interface.h"
+#include "display.h"
+#include "linuxdrmsyncobj_v1_interface_p.h"
+#include "surface_interface_p.h"
+#include "utils.h"
+
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+static const int s_version = 1;
+
+/**
+ * The kernel names the files of DRM synchronization objects "syncobj_file". Without procfs the
+ * file descriptor can't be checked, it is then left to the compositor to fail to import it.
+ */
+static bool isSyncObjFile(int fd)
+{
+    char target[64];
+    const QByteArray path = QByteArrayLiteral("/proc/self/fd/") + QByteArray::number(fd);
+    const ssize_t length = readlink(path.constData(), target, sizeof(target));
+    if (length < 0) {
+        return true;
+    }
+    return QByteArray::fromRawData(target, length) == QByteArrayLiteral("anon_inode:syncobj_file");
+}
+
+LinuxDrmSyncObjTimelineV1::LinuxDrmSyncObjTimelineV1(int fd)
+    : m_fd(fd)
+{
+}
+
+LinuxDrmSyncObjTimelineV1::~LinuxDrmSyncObjTimelineV1()
+{
+    close(m_fd);
+}
+
+int LinuxDrmSyncObjTimelineV1::fd() const
+{
+    return m_fd;
+}
+
+LinuxDrmSyncObjTimelineV1Interface::LinuxDrmSyncObjTimelineV1Interface(const QSharedPointer<LinuxDrmSyncObjTimelineV1> &timeline, wl_resource *resource)
+    : QtWaylandServer::wp_linux_drm_syncobj_timeline_v1(resource)
+    , timeline(timeline)
+{
+}
+
+void LinuxDrmSyncObjTimelineV1Interface::wp_linux_drm_syncobj_timeline_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void LinuxDrmSyncObjTimelineV1Interface::wp_linux_drm_syncobj_timeline_v1_destroy(Resource *resource)
+{
+    // the points set on the timeline keep it alive
+    wl_resource_destroy(resource->handle);
+}
+
+LinuxDrmSyncObjSurfaceV1Interface::LinuxDrmSyncObjSurfaceV1Interface(LinuxDrmSyncObjManagerV1Interface *manager, SurfaceInterface *surface, wl_resource *resource)
+    : QtWaylandServer::wp_linux_drm_syncobj_surface_v1(resource)
+    , manager(manager)
+    , surface(surface)
+{
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->syncObjSurface = this;
+    surfacePrivate->syncObjManager = manager;
+}
+
+LinuxDrmSyncObjSurfaceV1Interface::~LinuxDrmSyncObjSurfaceV1Interface()
+{
+    if (surface) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->syncObjSurface = nullptr;
+        // the points set since the last commit are discarded, the committed ones stay
+        surfacePrivate->pending.acquirePoint = LinuxDrmSyncObjPointV1();
+        surfacePrivate->pending.releasePoint = LinuxDrmSyncObjPointV1();
+    }
+}
+
+LinuxDrmSyncObjSurfaceV1Interface *LinuxDrmSyncObjSurfaceV1Interface::get(SurfaceInterface *surface)
+{
+    return SurfaceInterfacePrivate::get(surface)->syncObjSurface;
+}
+
+bool LinuxDrmSyncObjSurfaceV1Interface::checkCommit()
+{
+    const SurfaceInterfacePrivate::State &pending = SurfaceInterfacePrivate::get(surface)->pending;
+    const bool hasBuffer = (pending.changes & SurfaceInterfacePrivate::State::BufferChanged) && pending.buffer;
+    if (!hasBuffer) {
+        if (pending.acquirePoint.isValid() || pending.releasePoint.isValid()) {
+            wl_resource_post_error(resource()->handle, error_no_buffer, "timeline points set without a buffer");
+            return false;
+        }
+        return true;
+    }
+    if (!pending.buffer->linuxDmabufBuffer()) {
+        wl_resource_post_error(resource()->handle, error_unsupported_buffer, "only dmabuf buffers support explicit synchronization");
+        return false;
+    }
+    if (!pending.acquirePoint.isValid()) {
+        wl_resource_post_error(resource()->handle, error_no_acquire_point, "no acquire point set for the buffer");
+        return false;
+    }
+    if (!pending.releasePoint.isValid()) {
+        wl_resource_post_error(resource()->handle, error_no_release_point, "no release point set for the buffer");
+        return false;
+    }
+    if (pending.acquirePoint.timeline == pending.releasePoint.timeline && pending.acquirePoint.point >= pending.releasePoint.point) {
+        wl_resource_post_error(resource()->handle, error_conflicting_points, "the release point must come after the acquire point");
+        return false;
+    }
+    return true;
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_set_acquire_point(Resource *resource, struct ::wl_resource *timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    if (!surface) {
+        wl_resource_post_error(resource->handle, error_no_surface, "the wl_surface was destroyed");
+        return;
+    }
+    auto timelineInterface = resource_cast<LinuxDrmSyncObjTimelineV1Interface *>(timeline);
+    LinuxDrmSyncObjPointV1 &point = SurfaceInterfacePrivate::get(surface)->pending.acquirePoint;
+    point.timeline = timelineInterface->timeline;
+    point.point = (quint64(point_hi) << 32) | point_lo;
+}
+
+void LinuxDrmSyncObjSurfaceV1Interface::wp_linux_drm_syncobj_surface_v1_set_release_point(Resource *resource, struct ::wl_resource *timeline, uint32_t point_hi, uint32_t point_lo)
+{
+    if (!surface) {
+        wl_resource_post_error(resource->handle, error_no_surface, "the wl_surface was destroyed");
+        return;
+    }
+    auto timelineInterface = resource_cast<LinuxDrmSyncObjTimelineV1Interface *>(timeline);
+    LinuxDrmSyncObjPointV1 &point = SurfaceInterfacePrivate::get(surface)->pending.releasePoint;
+    point.timeline = timelineInterface->timeline;
+    point.point = (quint64(point_hi) << 32) | point_lo;
+}
+
+LinuxDrmSyncObjManagerV1InterfacePrivate::LinuxDrmSyncObjManagerV1InterfacePrivate(LinuxDrmSyncObjManagerV1Interface *q)
+    : q(q)
+{
+}
+
+void LinuxDrmSyncObjManagerV1InterfacePrivate::wp_linux_drm_syncobj_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void LinuxDrmSyncObjManagerV1InterfacePrivate::wp_linux_drm_syncobj_manager_v1_get_surface(Resource *resource, uint32_t id, struct ::wl_resource *surface_resource)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
+    if (LinuxDrmSyncObjSurfaceV1Interface::get(surface)) {
+        wl_resource_post_error(resource->handle, error_surface_exists, "the surface already has a synchronization object");
+        return;
+    }
+
+    wl_resource *surfaceResource = wl_resource_create(resource->client(), &wp_linux_drm_syncobj_surface_v1_interface,
+                                                      resource->version(), id);
+    if (!surfaceResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new LinuxDrmSyncObjSurfaceV1Interface(q, surface, surfaceResource);
+}
+
+void LinuxDrmSyncObjManagerV1InterfacePrivate::wp_linux_drm_syncobj_manager_v1_import_timeline(Resource *resource, uint32_t id, int32_t fd)
+{
+    if (!isSyncObjFile(fd)) {
+        close(fd);
+        wl_resource_post_error(resource->handle, error_invalid_timeline, "the file descriptor is not a drm_syncobj");
+        return;
+    }
+
+    wl_resource *timelineResource = wl_resource_create(resource->client(), &wp_linux_drm_syncobj_timeline_v1_interface,
+                                                       resource->version(), id);
+    if (!timelineResource) {
+        close(fd);
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new LinuxDrmSyncObjTimelineV1Interface(QSharedPointer<LinuxDrmSyncObjTimelineV1>::create(fd), timelineResource);
+}
+
+LinuxDrmSyncObjManagerV1Interface::LinuxDrmSyncObjManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new LinuxDrmSyncObjManagerV1InterfacePrivate(this))
+{
+    qRegisterMetaType<LinuxDrmSyncObjPointV1>();
+    d->init(*display, s_version);
+}
+
+LinuxDrmSyncObjManagerV1Interface::~LinuxDrmSyncObjManagerV1Interface()
+{
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,113 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+#include <QSharedPointer>
+
+namespace KWaylandServer
+{
+
+class Display;
+class LinuxDrmSyncObjManagerV1InterfacePrivate;
+
+/**
+ * A DRM synchronization object timeline imported by a client.
+ *
+ * The timeline owns the drm_syncobj file descriptor the client sent, the compositor imports it
+ * into its DRM device with drmSyncobjFDToHandle() to wait for or signal points on it. The
+ * timeline stays alive as long as a point on it is referenced, even after the client destroyed
+ * the wp_linux_drm_syncobj_timeline_v1 object.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT LinuxDrmSyncObjTimelineV1
+{
+public:
+    /**
+     * Takes ownership of @p fd.
+     **/
+    explicit LinuxDrmSyncObjTimelineV1(int fd);
+    ~LinuxDrmSyncObjTimelineV1();
+
+    /**
+     * @returns the drm_syncobj file descriptor, it is closed along with the timeline
+     **/
+    int fd() const;
+
+private:
+    Q_DISABLE_COPY(LinuxDrmSyncObjTimelineV1)
+    int m_fd;
+};
+
+/**
+ * A point on a LinuxDrmSyncObjTimelineV1, set by the client for the buffer of a surface commit.
+ *
+ * @see SurfaceInterface::acquirePoint
+ * @see SurfaceInterface::releasePoint
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT LinuxDrmSyncObjPointV1
+{
+    QSharedPointer<LinuxDrmSyncObjTimelineV1> timeline;
+    quint64 point = 0;
+
+    bool isValid() const
+    {
+        return !timeline.isNull();
+    }
+};
+
+/**
+ * The LinuxDrmSyncObjManagerV1Interface lets clients synchronize their buffers explicitly.
+ *
+ * Instead of relying on the implicit fences of a dmabuf, a client attaching a buffer to a
+ * surface with a wp_linux_drm_syncobj_surface_v1 sets an acquire point, which the compositor
+ * waits for before it reads the buffer, and a release point, which the compositor signals once
+ * it's done with the buffer. The compositor can thus hand a buffer back as soon as the GPU
+ * finished reading it rather than when the next buffer replaced it, and the client doesn't have
+ * to wait for wl_buffer.release, which the compositor may not send at all in this case.
+ *
+ * The points of the current buffer are provided by SurfaceInterface::acquirePoint() and
+ * SurfaceInterface::releasePoint(). The compositor has to keep a copy of the release point
+ * along with the buffer and signal it when it stops using the buffer, for instance with
+ * drmSyncobjTimelineSignal() or by transferring the fence of its last read into the point.
+ * Buffers which never become current, because a synchronized sub-surface committed again,
+ * are reported with releasePointDropped(), their release points must be signaled right away.
+ *
+ * Only dmabuf buffers support explicit synchronization, attaching any other buffer to a
+ * surface with explicit synchronization is a protocol error.
+ *
+ * LinuxDrmSyncObjManagerV1Interface corresponds to the Wayland interface
+ * @c wp_linux_drm_syncobj_manager_v1.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT LinuxDrmSyncObjManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit LinuxDrmSyncObjManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~LinuxDrmSyncObjManagerV1Interface() override;
+
+Q_SIGNALS:
+    /**
+     * Emitted when a buffer got replaced before it became the current buffer of its surface.
+     * The compositor never reads it, so @p releasePoint has to be signaled immediately.
+     **/
+    void releasePointDropped(const KWaylandServer::LinuxDrmSyncObjPointV1 &releasePoint);
+
+private:
+    QScopedPointer<LinuxDrmSyncObjManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
+
+Q_DECLARE_METATYPE(KWaylandServer::LinuxDrmSyncObjPointV1)
@@ -0,0 +1,69 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "linuxdrmsyncobj_v1_interface.h"
+
+#include "qwayland-server-linux-drm-syncobj-v1.h"
+
+#include <QPointer>
+
+namespace KWaylandServer
+{
+
+class SurfaceInterface;
+
+class LinuxDrmSyncObjTimelineV1Interface : public QtWaylandServer::wp_linux_drm_syncobj_timeline_v1
+{
+public:
+    LinuxDrmSyncObjTimelineV1Interface(const QSharedPointer<LinuxDrmSyncObjTimelineV1> &timeline, wl_resource *resource);
+
+    QSharedPointer<LinuxDrmSyncObjTimelineV1> timeline;
+
+protected:
+    void wp_linux_drm_syncobj_timeline_v1_destroy_resource(Resource *resource) override;
+    void wp_linux_drm_syncobj_timeline_v1_destroy(Resource *resource) override;
+};
+
+class LinuxDrmSyncObjSurfaceV1Interface : public QtWaylandServer::wp_linux_drm_syncobj_surface_v1
+{
+public:
+    LinuxDrmSyncObjSurfaceV1Interface(LinuxDrmSyncObjManagerV1Interface *manager, SurfaceInterface *surface, wl_resource *resource);
+    ~LinuxDrmSyncObjSurfaceV1Interface() override;
+
+    static LinuxDrmSyncObjSurfaceV1Interface *get(SurfaceInterface *surface);
+
+    /**
+     * Checks the pending state of the surface before it gets committed, @c false if a protocol
+     * error has been posted.
+     **/
+    bool checkCommit();
+
+    QPointer<LinuxDrmSyncObjManagerV1Interface> manager;
+    QPointer<SurfaceInterface> surface;
+
+protected:
+    void wp_linux_drm_syncobj_surface_v1_destroy_resource(Resource *resource) override;
+    void wp_linux_drm_syncobj_surface_v1_destroy(Resource *resource) override;
+    void wp_linux_drm_syncobj_surface_v1_set_acquire_point(Resource *resource, struct ::wl_resource *timeline, uint32_t point_hi, uint32_t point_lo) override;
+    void wp_linux_drm_syncobj_surface_v1_set_release_point(Resource *resource, struct ::wl_resource *timeline, uint32_t point_hi, uint32_t point_lo) override;
+};
+
+class LinuxDrmSyncObjManagerV1InterfacePrivate : public QtWaylandServer::wp_linux_drm_syncobj_manager_v1
+{
+public:
+    explicit LinuxDrmSyncObjManagerV1InterfacePrivate(LinuxDrmSyncObjManagerV1Interface *q);
+
+    LinuxDrmSyncObjManagerV1Interface *q;
+
+protected:
+    void wp_linux_drm_syncobj_manager_v1_destroy(Resource *resource) override;
+    void wp_linux_drm_syncobj_manager_v1_get_surface(Resource *resource, uint32_t id, struct ::wl_resource *surface) override;
+    void wp_linux_drm_syncobj_manager_v1_import_timeline(Resource *resource, uint32_t id, int32_t fd) override;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,121 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "mimetypeatom.h"
+// Qt
+#include <QHash>
+#include <QSharedData>
+
+namespace KWaylandServer
+{
+
+class MimeTypeAtomData : public QSharedData
+{
+public:
+    MimeTypeAtomData(const QString &mimeType, quint32 id);
+    ~MimeTypeAtomData();
+
+    QString string;
+    QByteArray utf8;
+    quint32 id;
+};
+
+struct MimeTypeAtomTable
+{
+    QHash<QString, MimeTypeAtomData *> atoms;
+    quint32 lastId = 0;
+};
+Q_GLOBAL_STATIC(MimeTypeAtomTable, s_table)
+
+MimeTypeAtomData::MimeTypeAtomData(const QString &mimeType, quint32 id)
+    : string(mimeType)
+    , utf8(mimeType.toUtf8())
+    , id(id)
+{
+}
+
+MimeTypeAtomData::~MimeTypeAtomData()
+{
+    // the table is gone already if the last atom is a static one
+    if (!s_table.isDestroyed()) {
+        s_table->atoms.remove(string);
+    }
+}
+
+MimeTypeAtom::MimeTypeAtom() = default;
+
+MimeTypeAtom::MimeTypeAtom(const QString &mimeType)
+{
+    MimeTypeAtomTable *table = s_table;
+    auto it = table->atoms.constFind(mimeType);
+    if (it != table->atoms.constEnd()) {
+        d = *it;
+        return;
+    }
+    // zero is the null atom
+    if (++table->lastId == 0) {
+        ++table->lastId;
+    }
+    d = new MimeTypeAtomData(mimeType, table->lastId);
+    table->atoms.insert(mimeType, d.data());
+}
+
+MimeTypeAtom::MimeTypeAtom(const MimeTypeAtom &other) = default;
+
+MimeTypeAtom::~MimeTypeAtom() = default;
+
+MimeTypeAtom &MimeTypeAtom::operator=(const MimeTypeAtom &other) = default;
+
+bool MimeTypeAtom::isNull() const
+{
+    return !d;
+}
+
+quint32 MimeTypeAtom::id() const
+{
+    return d ? d->id : 0;
+}
+
+QString MimeTypeAtom::toString() const
+{
+    return d ? d->string : QString();
+}
+
+QByteArray MimeTypeAtom::toUtf8() const
+{
+    return d ? d->utf8 : QByteArray();
+}
+
+const char *MimeTypeAtom::constData() const
+{
+    return d ? d->utf8.constData() : "";
+}
+
+bool MimeTypeAtom::operator==(const MimeTypeAtom &other) const
+{
+    return d == other.d;
+}
+
+bool MimeTypeAtom::operator!=(const MimeTypeAtom &other) const
+{
+    return d != other.d;
+}
+
+int MimeTypeAtom::internedCount()
+{
+    return s_table->atoms.count();
+}
+
+QStringList MimeTypeAtom::toStringList(const QVector<MimeTypeAtom> &atoms)
+{
+    QStringList mimeTypes;
+    mimeTypes.reserve(atoms.count());
+    for (const MimeTypeAtom &atom : atoms) {
+        mimeTypes << atom.toString();
+    }
+    return mimeTypes;
+}
+
+}
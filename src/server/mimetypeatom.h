@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include <QExplicitlySharedDataPointer>
+#include <QMetaType>
+#include <QStringList>
+#include <QVector>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+
+class MimeTypeAtomData;
+
+/**
+ * @brief An interned mime type of a data transfer.
+ *
+ * All MimeTypeAtoms created for the same mime type share a single entry of a table, which
+ * holds the mime type together with its UTF-8 encoding. Data sources store the offered
+ * mime types as atoms and the data offers send the UTF-8 strings of the table, so a mime
+ * type is converted once however many offers and clients see it. The entry is released
+ * once the last atom of the mime type goes away.
+ *
+ * @see AbstractDataSource::mimeTypeAtoms
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT MimeTypeAtom
+{
+public:
+    MimeTypeAtom();
+    explicit MimeTypeAtom(const QString &mimeType);
+    MimeTypeAtom(const MimeTypeAtom &other);
+    ~MimeTypeAtom();
+    MimeTypeAtom &operator=(const MimeTypeAtom &other);
+
+    bool isNull() const;
+    /**
+     * @returns the id of the mime type, unique while an atom of it exists, @c 0 if null
+     **/
+    quint32 id() const;
+    QString toString() const;
+    QByteArray toUtf8() const;
+    /**
+     * @returns the null terminated UTF-8 encoding of the mime type
+     **/
+    const char *constData() const;
+
+    bool operator==(const MimeTypeAtom &other) const;
+    bool operator!=(const MimeTypeAtom &other) const;
+
+    /**
+     * @returns the number of mime types interned at the moment
+     **/
+    static int internedCount();
+
+    /**
+     * @returns the mime types of @p atoms
+     **/
+    static QStringList toStringList(const QVector<MimeTypeAtom> &atoms);
+
+private:
+    QExplicitlySharedDataPointer<MimeTypeAtomData> d;
+};
+
+typedef QVector<MimeTypeAtom> MimeTypeAtoms;
+
+}
+
+Q_DECLARE_TYPEINFO(KWaylandServer::MimeTypeAtom, Q_MOVABLE_TYPE);
@@ -8,6 +8,7 @@
 #include "global_p.h"
 #include "display.h"
 
+#include <QHash>
 #include <QVector>
 
 #include <wayland-server.h>
@@ -28,6 +29,8 @@ public:
     void sendDone(const ResourceData &data);
     void updateGeometry();
     void updateScale();
+    void updateCurrentMode();
+    void sendPendingChanges();
 
     QSize physicalSize;
     QPoint globalPosition;
@@ -38,10 +41,20 @@ public:
     Transform transform = Transform::Normal;
     QList<Mode> modes;
     QList<ResourceData> resources;
+    // the resources of each client, surfaces look them up whenever they enter or leave the output
+    QHash<wl_client *, QVector<wl_resource *>> clientResources;
     struct {
         DpmsMode mode = DpmsMode::Off;
         bool supported = false;
     } dpms;
+    int updateDepth = 0;
+    struct {
+        bool geometry = false;
+        bool scale = false;
+        bool currentMode = false;
+    } pendingChanges;
+    // clients which need a done event at the end of the batch even if nothing else changed
+    QVector<wl_client *> pendingDoneClients;
 
     static OutputInterface *get(wl_resource *native);
 
@@ -56,12 +69,10 @@ private:
     void sendScale(const ResourceData &data);
 
     OutputInterface *q;
-    static QVector<Private*> s_privates;
     static const struct wl_output_interface s_interface;
     static const quint32 s_version;
 };
 
-QVector<OutputInterface::Private*> OutputInterface::Private::s_privates;
 const quint32 OutputInterface::Private::s_version = 3;
 
 OutputInterface::Private::Private(OutputInterface *q, Display *d)
@@ -70,8 +81,7 @@ OutputInterface::Private::Private(OutputInterface *q, Display *d)
 {
     DisplayPrivate *displayPrivate = DisplayPrivate::get(display);
     displayPrivate->outputs.append(q);
-
-    s_privates << this;
+    updateDepth = displayPrivate->outputLayoutUpdateDepth > 0 ? 1 : 0;
 }
 
 OutputInterface::Private::~Private()
@@ -81,7 +91,10 @@ OutputInterface::Private::~Private()
         displayPrivate->outputs.removeOne(q);
     }
 
-    s_privates.removeAll(this);
+    // the resources outlive the global, make sure they no longer resolve to it
+    for (const ResourceData &data : qAsConst(resources)) {
+        wl_resource_set_user_data(data.resource, nullptr);
+    }
 }
 
 #ifndef K_DOXYGEN
@@ -106,34 +119,17 @@ OutputInterface *OutputInterface::Private::get(wl_resource *native)
 
 OutputInterface::Private *OutputInterface::Private::cast(wl_resource *native)
 {
-    for (auto it = s_privates.constBegin(); it != s_privates.constEnd(); ++it) {
-        const auto &resources = (*it)->resources;
-        auto rit = std::find_if(resources.constBegin(), resources.constEnd(), [native] (const ResourceData &data) { return data.resource == native; });
-        if (rit != resources.constEnd()) {
-            return (*it);
-        }
+    if (!native || !wl_resource_instance_of(native, &wl_output_interface, &s_interface)) {
+        return nullptr;
     }
-    return nullptr;
+    return static_cast<Private *>(wl_resource_get_user_data(native));
 }
 
 OutputInterface::OutputInterface(Display *display, QObject *parent)
     : Global(new Private(this, display), parent)
 {
     Q_D();
-    connect(this, &OutputInterface::currentModeChanged, this,
-        [this] {
-            Q_D();
-            auto currentModeIt = std::find_if(d->modes.constBegin(), d->modes.constEnd(), [](const Mode &mode) { return mode.flags.testFlag(ModeFlag::Current); });
-            if (currentModeIt == d->modes.constEnd()) {
-                return;
-            }
-            for (auto it = d->resources.constBegin(); it != d->resources.constEnd(); ++it) {
-                d->sendMode((*it).resource, *currentModeIt);
-                d->sendDone(*it);
-            }
-            wl_display_flush_clients(*(d->display));
-        }
-    );
+    connect(this, &OutputInterface::currentModeChanged,    this, [d] { d->updateCurrentMode(); });
     connect(this, &OutputInterface::subPixelChanged,       this, [d] { d->updateGeometry(); });
     connect(this, &OutputInterface::transformChanged,      this, [d] { d->updateGeometry(); });
     connect(this, &OutputInterface::globalPositionChanged, this, [d] { d->updateGeometry(); });
@@ -316,6 +312,7 @@ void OutputInterface::Private::bind(wl_client *client, uint32_t version, uint32_
     r.resource = resource;
     r.version = version;
     resources << r;
+    clientResources[client].append(resource);
 
     sendGeometry(resource);
     sendScale(r);
@@ -351,6 +348,13 @@ void OutputInterface::Private::unbind(wl_resource *resource)
     if (it != o->resources.end()) {
         o->resources.erase(it);
     }
+    auto clientIt = o->clientResources.find(wl_resource_get_client(resource));
+    if (clientIt != o->clientResources.end()) {
+        clientIt->removeOne(resource);
+        if (clientIt->isEmpty()) {
+            o->clientResources.erase(clientIt);
+        }
+    }
 }
 
 void OutputInterface::Private::sendMode(wl_resource *resource, const Mode &mode)
@@ -401,17 +405,87 @@ void OutputInterface::Private::sendDone(const ResourceData &data)
 
 void OutputInterface::Private::updateGeometry()
 {
-    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
-        sendGeometry((*it).resource);
-        sendDone(*it);
-    }
+    pendingChanges.geometry = true;
+    sendPendingChanges();
 }
 
 void OutputInterface::Private::updateScale()
 {
-    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
-        sendScale(*it);
-        sendDone(*it);
+    pendingChanges.scale = true;
+    sendPendingChanges();
+}
+
+void OutputInterface::Private::updateCurrentMode()
+{
+    pendingChanges.currentMode = true;
+    sendPendingChanges();
+}
+
+void OutputInterface::Private::sendPendingChanges()
+{
+    if (updateDepth > 0) {
+        return;
+    }
+    auto currentModeIt = modes.constEnd();
+    if (pendingChanges.currentMode) {
+        currentModeIt = std::find_if(modes.constBegin(), modes.constEnd(), [](const Mode &mode) { return mode.flags.testFlag(ModeFlag::Current); });
+    }
+    const bool sendCurrentMode = currentModeIt != modes.constEnd();
+    if (pendingChanges.geometry || pendingChanges.scale || sendCurrentMode) {
+        for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
+            if (pendingChanges.geometry) {
+                sendGeometry((*it).resource);
+            }
+            if (pendingChanges.scale) {
+                sendScale(*it);
+            }
+            if (sendCurrentMode) {
+                sendMode((*it).resource, *currentModeIt);
+            }
+            sendDone(*it);
+        }
+        if (sendCurrentMode) {
+            wl_display_flush_clients(*display);
+        }
+    } else if (!pendingDoneClients.isEmpty()) {
+        for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
+            if (pendingDoneClients.contains(wl_resource_get_client((*it).resource))) {
+                sendDone(*it);
+            }
+        }
+    }
+    pendingChanges = {};
+    pendingDoneClients.clear();
+}
+
+void OutputInterface::beginUpdate()
+{
+    Q_D();
+    d->updateDepth++;
+}
+
+void OutputInterface::commitUpdate()
+{
+    Q_D();
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth == 0) {
+        d->sendPendingChanges();
+    }
+}
+
+void OutputInterface::done(wl_client *client)
+{
+    Q_D();
+    if (d->updateDepth > 0) {
+        if (!d->pendingDoneClients.contains(client)) {
+            d->pendingDoneClients.append(client);
+        }
+        return;
+    }
+    for (auto it = d->resources.constBegin(); it != d->resources.constEnd(); ++it) {
+        if (wl_resource_get_client((*it).resource) == client) {
+            d->sendDone(*it);
+        }
     }
 }
 
@@ -519,13 +593,7 @@ bool OutputInterface::isDpmsSupported() const
 QVector<wl_resource *> OutputInterface::clientResources(ClientConnection *client) const
 {
     Q_D();
-    QVector<wl_resource *> ret;
-    for (auto it = d->resources.constBegin(), end = d->resources.constEnd(); it != end; ++it) {
-        if (wl_resource_get_client((*it).resource) == client->client()) {
-            ret << (*it).resource;
-        }
-    }
-    return ret;
+    return d->clientResources.value(client->client());
 }
 
 bool OutputInterface::isEnabled() const
@@ -99,6 +99,30 @@ public:
     void addMode(const QSize &size, ModeFlags flags = ModeFlags(), int refreshRate = 60000);
     void setCurrentMode(const QSize &size, int refreshRate = 60000);
 
+    /**
+     * Starts a batch of property changes. The changes made until the matching commitUpdate()
+     * are sent to the clients together, followed by a single done event, so that a mode switch
+     * changing e.g. the position, scale and mode doesn't make the clients update several times.
+     *
+     * Calls can be nested, the changes are sent by the outermost commitUpdate(). The change
+     * signals are still emitted right away.
+     * @since 5.22
+     **/
+    void beginUpdate();
+    /**
+     * Ends the batch started by beginUpdate() and sends the changed properties to the clients.
+     * @since 5.22
+     **/
+    void commitUpdate();
+    /**
+     * Sends a done event to the wl_output resources of @p client, so that it applies the
+     * properties of extensions such as xdg-output version 3 which have no done event of their
+     * own. Within a batch the done event is deferred to the commitUpdate().
+     * @internal
+     * @since 5.22
+     **/
+    void done(wl_client *client);
+
     /**
      * Sets whether Dpms is supported for this output.
      * Default is @c false.
@@ -40,7 +40,7 @@ OutputChangeSet::Private *OutputChangeSet::d_func() const
 bool OutputChangeSet::enabledChanged() const
 {
     Q_D();
-    return d->enabled != d->o->enabled();
+    return d->requested.testFlag(Change::Enabled) && d->enabled != d->o->enabled();
 }
 
 OutputDeviceInterface::Enablement OutputChangeSet::enabled() const
@@ -52,7 +52,7 @@ OutputDeviceInterface::Enablement OutputChangeSet::enabled() const
 bool OutputChangeSet::modeChanged() const
 {
     Q_D();
-    return d->modeId != d->o->currentModeId();
+    return d->requested.testFlag(Change::Mode) && d->modeId != d->o->currentModeId();
 }
 
 int OutputChangeSet::mode() const
@@ -64,7 +64,7 @@ int OutputChangeSet::mode() const
 bool OutputChangeSet::transformChanged() const
 {
     Q_D();
-    return d->transform != d->o->transform();
+    return d->requested.testFlag(Change::Transform) && d->transform != d->o->transform();
 }
 
 OutputDeviceInterface::Transform OutputChangeSet::transform() const
@@ -75,7 +75,7 @@ OutputDeviceInterface::Transform OutputChangeSet::transform() const
 bool OutputChangeSet::positionChanged() const
 {
     Q_D();
-    return d->position != d->o->globalPosition();
+    return d->requested.testFlag(Change::Position) && d->position != d->o->globalPosition();
 }
 
 QPoint OutputChangeSet::position() const
@@ -87,7 +87,7 @@ QPoint OutputChangeSet::position() const
 bool OutputChangeSet::scaleChanged() const
 {
     Q_D();
-    return !qFuzzyCompare(d->scale, d->o->scaleF());
+    return d->requested.testFlag(Change::Scale) && !qFuzzyCompare(d->scale, d->o->scaleF());
 }
 
 int OutputChangeSet::scale() const
@@ -105,7 +105,7 @@ qreal OutputChangeSet::scaleF() const
 bool OutputChangeSet::colorCurvesChanged() const
 {
     Q_D();
-    return d->colorCurves != d->o->colorCurves();
+    return d->requested.testFlag(Change::ColorCurves) && d->colorCurves != d->o->colorCurves();
 }
 
 OutputDeviceInterface::ColorCurves OutputChangeSet::colorCurves() const
@@ -114,4 +114,21 @@ OutputDeviceInterface::ColorCurves OutputChangeSet::colorCurves() const
     return d->colorCurves;
 }
 
+OutputChangeSet::Changes OutputChangeSet::changes() const
+{
+    Changes changed;
+    changed.setFlag(Change::Enabled, enabledChanged());
+    changed.setFlag(Change::Mode, modeChanged());
+    changed.setFlag(Change::Transform, transformChanged());
+    changed.setFlag(Change::Position, positionChanged());
+    changed.setFlag(Change::Scale, scaleChanged());
+    changed.setFlag(Change::ColorCurves, colorCurvesChanged());
+    return changed;
+}
+
+bool OutputChangeSet::isNoop() const
+{
+    return !changes();
+}
+
 }
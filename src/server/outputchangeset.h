@@ -31,6 +31,34 @@ class KWAYLANDSERVER_EXPORT OutputChangeSet : public QObject
 public:
     virtual ~OutputChangeSet();
 
+    /**
+     * The properties of an outputdevice a change set can hold.
+     * @since 5.22
+     **/
+    enum class Change {
+        Enabled = 1 << 0,
+        Mode = 1 << 1,
+        Transform = 1 << 2,
+        Position = 1 << 3,
+        Scale = 1 << 4,
+        ColorCurves = 1 << 5
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
+    /**
+     * The properties set by the client which differ from the current state of the
+     * outputdevice. Properties the client did not set are not compared, so a change set
+     * only moving the outputdevice doesn't compare the color curves.
+     * @since 5.22
+     **/
+    Changes changes() const;
+    /**
+     * Whether applying this change set leaves the outputdevice as it is.
+     * @returns @c true if none of the properties set by the client differs
+     * @since 5.22
+     **/
+    bool isNoop() const;
+
     /** Whether the enabled() property of the outputdevice changed.
      * @returns @c true if the enabled property of the outputdevice has changed.
      */
@@ -94,4 +122,6 @@ private:
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::OutputChangeSet::Changes)
+
 #endif
@@ -26,6 +26,8 @@ public:
     QPoint position;
     qreal scale;
     OutputDeviceInterface::ColorCurves colorCurves;
+    // the properties set by the client, the others still hold the state of the outputdevice
+    Changes requested;
 };
 
 }
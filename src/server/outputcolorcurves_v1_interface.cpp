@@ -0,0 +1,307 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "outputcolorcurves_v1_interface.h"
+#include "anonymousfile_p.h"
+#include "display.h"
+#include "logging.h"
+#include "outputdevice_interface.h"
+
+#include "qwayland-server-kde-output-color-curves-v1.h"
+
+#include <QHash>
+
+#include <config-kwaylandserver.h>
+
+#include <atomic>
+#include <new>
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+static const int s_version = 1;
+
+#if HAVE_MEMFD && !defined(F_SEAL_FUTURE_WRITE)
+// Linux 5.1, missing in older kernel headers
+#define F_SEAL_FUTURE_WRITE 0x0010
+#endif
+
+struct ColorCurvesHeader
+{
+    std::atomic<quint32> generation;
+    quint32 size;
+};
+
+static_assert(sizeof(ColorCurvesHeader) == 8, "The header is part of the protocol");
+static_assert(ATOMIC_INT_LOCK_FREE == 2, "The generation is shared with other processes");
+
+/**
+ * The ramps of one output device in shared memory. The compositor keeps a writable
+ * mapping, the clients get a file descriptor which can't be written through.
+ *
+ * The memfd is sealed with F_SEAL_FUTURE_WRITE once the compositor mapped it, so the ramps
+ * are updated in place while every other write is refused, also through a descriptor
+ * reopened from /proc. Without that seal every update is written to a fresh write-sealed
+ * copy, which gets announced like a new mapping.
+ */
+class SharedColorCurves
+{
+public:
+    ~SharedColorCurves();
+
+    /**
+     * Writes @p curves, replacing the mapping if the number of entries changed or the
+     * clients get copies.
+     * @returns whether the mapping got replaced.
+     */
+    bool update(const OutputDeviceInterface::ColorCurves &curves);
+
+    int fd() const {
+        return m_fd;
+    }
+    quint32 size() const {
+        return m_size;
+    }
+    quint32 generation() const {
+        return m_header ? m_header->generation.load(std::memory_order_relaxed) : 0;
+    }
+
+private:
+    bool allocate(quint32 entries);
+    bool copy();
+    void release();
+
+    // the descriptor sent to the clients
+    int m_fd = -1;
+    quint32 m_size = 0;
+    ColorCurvesHeader *m_header = nullptr;
+    // whether m_header is private memory copied into a new m_fd on every update
+    bool m_copies = false;
+};
+
+SharedColorCurves::~SharedColorCurves()
+{
+    release();
+}
+
+void SharedColorCurves::release()
+{
+    if (m_header) {
+        munmap(m_header, m_size);
+        m_header = nullptr;
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+    m_size = 0;
+    m_copies = false;
+}
+
+bool SharedColorCurves::allocate(quint32 entries)
+{
+    release();
+    const quint32 size = sizeof(ColorCurvesHeader) + 3 * entries * sizeof(quint16);
+
+    void *memory = MAP_FAILED;
+#if HAVE_MEMFD
+    const int fd = AnonymousFile::create("kwaylandserver-color-curves", size, true);
+    if (fd >= 0) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        // the seal leaves the mapping above writable, but refuses all other writes
+        if (memory != MAP_FAILED && fcntl(fd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_FUTURE_WRITE | F_SEAL_SEAL) != 0) {
+            munmap(memory, size);
+            memory = MAP_FAILED;
+        }
+        if (memory == MAP_FAILED) {
+            close(fd);
+        } else {
+            m_fd = fd;
+        }
+    }
+#endif
+    if (memory == MAP_FAILED) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        m_copies = true;
+    }
+    if (memory == MAP_FAILED) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to map the color curves";
+        release();
+        return false;
+    }
+    m_size = size;
+    m_header = new (memory) ColorCurvesHeader;
+    m_header->generation.store(0, std::memory_order_relaxed);
+    m_header->size = entries;
+    return true;
+}
+
+bool SharedColorCurves::copy()
+{
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
+    m_fd = AnonymousFile::createReadOnly("kwaylandserver-color-curves", QByteArray::fromRawData(reinterpret_cast<const char *>(m_header), m_size));
+    if (m_fd < 0) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create a file for the color curves";
+        return false;
+    }
+    return true;
+}
+
+bool SharedColorCurves::update(const OutputDeviceInterface::ColorCurves &curves)
+{
+    const quint32 entries = qMax(curves.red.size(), qMax(curves.green.size(), curves.blue.size()));
+    bool replaced = false;
+    if (!m_header || m_header->size != entries) {
+        if (!allocate(entries)) {
+            return false;
+        }
+        replaced = true;
+    }
+
+    // the generation is odd while the ramps are written, see the protocol description
+    const quint32 generation = m_header->generation.load(std::memory_order_relaxed);
+    m_header->generation.store(generation + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    quint16 *ramps = reinterpret_cast<quint16 *>(m_header + 1);
+    for (const QVector<quint16> *ramp : {&curves.red, &curves.green, &curves.blue}) {
+        memcpy(ramps, ramp->constData(), ramp->size() * sizeof(quint16));
+        memset(ramps + ramp->size(), 0, (entries - ramp->size()) * sizeof(quint16));
+        ramps += entries;
+    }
+
+    m_header->generation.store(generation + 2, std::memory_order_release);
+    if (m_copies) {
+        return copy();
+    }
+    return replaced;
+}
+
+/**
+ * The color curves of one output device, shared by the resources of all clients.
+ */
+class OutputColorCurvesV1Interface : public QObject, public QtWaylandServer::kde_output_color_curves_v1
+{
+public:
+    explicit OutputColorCurvesV1Interface(OutputDeviceInterface *device, QObject *parent);
+
+    void addResource(Resource *managerResource, uint32_t id, wl_resource *deviceResource);
+
+protected:
+    void kde_output_color_curves_v1_bind_resource(Resource *resource) override;
+    void kde_output_color_curves_v1_destroy(Resource *resource) override;
+
+private:
+    void update();
+
+    OutputDeviceInterface *m_device;
+    SharedColorCurves m_curves;
+};
+
+OutputColorCurvesV1Interface::OutputColorCurvesV1Interface(OutputDeviceInterface *device, QObject *parent)
+    : QObject(parent)
+    , m_device(device)
+{
+    m_curves.update(device->colorCurves());
+    connect(device, &OutputDeviceInterface::colorCurvesChanged, this, &OutputColorCurvesV1Interface::update);
+}
+
+void OutputColorCurvesV1Interface::addResource(Resource *managerResource, uint32_t id, wl_resource *deviceResource)
+{
+    m_device->setColorCurvesShared(deviceResource);
+    add(managerResource->client(), id, managerResource->version());
+}
+
+void OutputColorCurvesV1Interface::update()
+{
+    const bool replaced = m_curves.update(m_device->colorCurves());
+    if (m_curves.fd() < 0) {
+        return;
+    }
+    if (replaced) {
+        const auto clientResources = resourceMap();
+        for (Resource *resource : clientResources) {
+            send_ramps(resource->handle, m_curves.fd(), m_curves.size());
+        }
+    } else {
+        const quint32 generation = m_curves.generation();
+        const auto clientResources = resourceMap();
+        for (Resource *resource : clientResources) {
+            send_changed(resource->handle, generation);
+        }
+    }
+}
+
+void OutputColorCurvesV1Interface::kde_output_color_curves_v1_bind_resource(Resource *resource)
+{
+    if (m_curves.fd() >= 0) {
+        send_ramps(resource->handle, m_curves.fd(), m_curves.size());
+    }
+}
+
+void OutputColorCurvesV1Interface::kde_output_color_curves_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+class OutputColorCurvesManagerV1InterfacePrivate : public QtWaylandServer::kde_output_color_curves_manager_v1
+{
+public:
+    OutputColorCurvesManagerV1InterfacePrivate(OutputColorCurvesManagerV1Interface *q, Display *display);
+
+    OutputColorCurvesManagerV1Interface *q;
+    QHash<OutputDeviceInterface *, OutputColorCurvesV1Interface *> curves;
+
+protected:
+    void kde_output_color_curves_manager_v1_destroy(Resource *resource) override;
+    void kde_output_color_curves_manager_v1_get_color_curves(Resource *resource, uint32_t id, wl_resource *outputdevice) override;
+};
+
+OutputColorCurvesManagerV1InterfacePrivate::OutputColorCurvesManagerV1InterfacePrivate(OutputColorCurvesManagerV1Interface *q, Display *display)
+    : QtWaylandServer::kde_output_color_curves_manager_v1(*display, s_version)
+    , q(q)
+{
+}
+
+void OutputColorCurvesManagerV1InterfacePrivate::kde_output_color_curves_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void OutputColorCurvesManagerV1InterfacePrivate::kde_output_color_curves_manager_v1_get_color_curves(Resource *resource, uint32_t id, wl_resource *outputdevice)
+{
+    OutputDeviceInterface *device = OutputDeviceInterface::get(outputdevice);
+    if (!device) {
+        // the output device is already gone
+        return;
+    }
+    OutputColorCurvesV1Interface *deviceCurves = curves.value(device);
+    if (!deviceCurves) {
+        deviceCurves = new OutputColorCurvesV1Interface(device, q);
+        curves.insert(device, deviceCurves);
+        QObject::connect(device, &QObject::destroyed, q, [this, device] {
+            delete curves.take(device);
+        });
+    }
+    deviceCurves->addResource(resource, id, outputdevice);
+}
+
+OutputColorCurvesManagerV1Interface::OutputColorCurvesManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new OutputColorCurvesManagerV1InterfacePrivate(this, display))
+{
+}
+
+OutputColorCurvesManagerV1Interface::~OutputColorCurvesManagerV1Interface() = default;
+
+} // namespace KWaylandServer
@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class OutputColorCurvesManagerV1InterfacePrivate;
+
+/**
+ * The OutputColorCurvesManagerV1Interface shares the color curves of the OutputDeviceInterface
+ * objects with the clients through shared memory.
+ *
+ * The ramps are written once per change into a mapping shared by all clients, which are only
+ * told the new generation. Clients using it no longer receive the full ramps with the
+ * colorcurves event of the output device, which makes animating the color curves cheap.
+ *
+ * OutputColorCurvesManagerV1Interface corresponds to the Wayland interface
+ * @c kde_output_color_curves_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT OutputColorCurvesManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OutputColorCurvesManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~OutputColorCurvesManagerV1Interface() override;
+
+private:
+    QScopedPointer<OutputColorCurvesManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
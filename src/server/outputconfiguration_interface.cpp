@@ -18,6 +18,8 @@
 #include <QDebug>
 #include <QSize>
 
+#include <algorithm>
+
 namespace KWaylandServer
 {
 
@@ -99,7 +101,9 @@ void OutputConfigurationInterface::Private::enableCallback(wl_client *client, wl
                                     OutputDeviceInterface::Enablement::Enabled :
                                     OutputDeviceInterface::Enablement::Disabled;
     OutputDeviceInterface *o = OutputDeviceInterface::get(outputdevice);
-    s->pendingChanges(o)->d_func()->enabled = _enable;
+    auto changeSet = s->pendingChanges(o)->d_func();
+    changeSet->enabled = _enable;
+    changeSet->requested |= OutputChangeSet::Change::Enabled;
 }
 
 void OutputConfigurationInterface::Private::modeCallback(wl_client *client, wl_resource *resource, wl_resource * outputdevice, int32_t mode_id)
@@ -120,7 +124,9 @@ void OutputConfigurationInterface::Private::modeCallback(wl_client *client, wl_r
     }
     auto s = cast<Private>(resource);
     Q_ASSERT(s);
-    s->pendingChanges(o)->d_func()->modeId = mode_id;
+    auto changeSet = s->pendingChanges(o)->d_func();
+    changeSet->modeId = mode_id;
+    changeSet->requested |= OutputChangeSet::Change::Mode;
 }
 
 void OutputConfigurationInterface::Private::transformCallback(wl_client *client, wl_resource *resource, wl_resource * outputdevice, int32_t transform)
@@ -151,7 +157,9 @@ void OutputConfigurationInterface::Private::transformCallback(wl_client *client,
     OutputDeviceInterface *o = OutputDeviceInterface::get(outputdevice);
     auto s = cast<Private>(resource);
     Q_ASSERT(s);
-    s->pendingChanges(o)->d_func()->transform = _transform;
+    auto changeSet = s->pendingChanges(o)->d_func();
+    changeSet->transform = _transform;
+    changeSet->requested |= OutputChangeSet::Change::Transform;
 }
 
 void OutputConfigurationInterface::Private::positionCallback(wl_client *client, wl_resource *resource, wl_resource * outputdevice, int32_t x, int32_t y)
@@ -161,7 +169,9 @@ void OutputConfigurationInterface::Private::positionCallback(wl_client *client,
     OutputDeviceInterface *o = OutputDeviceInterface::get(outputdevice);
     auto s = cast<Private>(resource);
     Q_ASSERT(s);
-    s->pendingChanges(o)->d_func()->position = _pos;
+    auto changeSet = s->pendingChanges(o)->d_func();
+    changeSet->position = _pos;
+    changeSet->requested |= OutputChangeSet::Change::Position;
 }
 
 void OutputConfigurationInterface::Private::scaleCallback(wl_client *client, wl_resource *resource, wl_resource * outputdevice, int32_t scale)
@@ -174,7 +184,9 @@ void OutputConfigurationInterface::Private::scaleCallback(wl_client *client, wl_
     OutputDeviceInterface *o = OutputDeviceInterface::get(outputdevice);
     auto s = cast<Private>(resource);
     Q_ASSERT(s);
-    s->pendingChanges(o)->d_func()->scale = scale;
+    auto changeSet = s->pendingChanges(o)->d_func();
+    changeSet->scale = scale;
+    changeSet->requested |= OutputChangeSet::Change::Scale;
 }
 
 void OutputConfigurationInterface::Private::scaleFCallback(wl_client *client, wl_resource *resource, wl_resource * outputdevice, wl_fixed_t scale_fixed)
@@ -190,7 +202,9 @@ void OutputConfigurationInterface::Private::scaleFCallback(wl_client *client, wl
     auto s = cast<Private>(resource);
     Q_ASSERT(s);
 
-    s->pendingChanges(o)->d_func()->scale = scale;
+    auto changeSet = s->pendingChanges(o)->d_func();
+    changeSet->scale = scale;
+    changeSet->requested |= OutputChangeSet::Change::Scale;
 }
 
 void OutputConfigurationInterface::Private::applyCallback(wl_client *client, wl_resource *resource)
@@ -234,13 +248,16 @@ void OutputConfigurationInterface::Private::colorcurvesCallback(wl_client *clien
     fillVector(green, &cc.green);
     fillVector(blue, &cc.blue);
 
-    s->pendingChanges(o)->d_func()->colorCurves = cc;
+    auto changeSet = s->pendingChanges(o)->d_func();
+    changeSet->colorCurves = cc;
+    changeSet->requested |= OutputChangeSet::Change::ColorCurves;
 }
 
 void OutputConfigurationInterface::Private::emitConfigurationChangeRequested() const
 {
     auto configinterface = reinterpret_cast<OutputConfigurationInterface *>(q);
-    emit outputManagement->configurationChangeRequested(configinterface);
+    // the output management decides whether it's handed over right away, queued or rejected
+    outputManagement->requestConfigurationChange(configinterface);
 }
 
 
@@ -262,11 +279,32 @@ QHash<OutputDeviceInterface*, OutputChangeSet*> OutputConfigurationInterface::ch
     return d->changes;
 }
 
+QHash<OutputDeviceInterface*, OutputChangeSet*> OutputConfigurationInterface::effectiveChanges() const
+{
+    Q_D();
+    QHash<OutputDeviceInterface*, OutputChangeSet*> effective;
+    for (auto it = d->changes.constBegin(); it != d->changes.constEnd(); ++it) {
+        if (!it.value()->isNoop()) {
+            effective.insert(it.key(), it.value());
+        }
+    }
+    return effective;
+}
+
+bool OutputConfigurationInterface::isNoop() const
+{
+    Q_D();
+    return std::all_of(d->changes.constBegin(), d->changes.constEnd(), [](OutputChangeSet *changeSet) {
+        return changeSet->isNoop();
+    });
+}
+
 void OutputConfigurationInterface::setApplied()
 {
     Q_D();
     d->clearPendingChanges();
     d->sendApplied();
+    d->outputManagement->finishConfiguration(this);
 }
 
 void OutputConfigurationInterface::Private::sendApplied()
@@ -282,6 +320,7 @@ void OutputConfigurationInterface::setFailed()
     Q_D();
     d->clearPendingChanges();
     d->sendFailed();
+    d->outputManagement->finishConfiguration(this);
 }
 
 void OutputConfigurationInterface::Private::sendFailed()
@@ -307,12 +346,7 @@ bool OutputConfigurationInterface::Private::hasPendingChanges(OutputDeviceInterf
     if (it == changes.constEnd()) {
         return false;
     }
-    auto c = *it;
-    return c->enabledChanged() ||
-    c->modeChanged() ||
-    c->transformChanged() ||
-    c->positionChanged() ||
-    c->scaleChanged();
+    return !(*it)->isNoop();
 }
 
 void OutputConfigurationInterface::Private::clearPendingChanges()
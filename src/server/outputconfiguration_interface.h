@@ -58,6 +58,20 @@ public:
      * @see OutputManagement
      */
     QHash<OutputDeviceInterface*, OutputChangeSet*> changes() const;
+    /**
+     * Like changes(), but without the change sets which would leave their outputdevice as
+     * it is, so the compositor only has to validate and test the outputdevices that change.
+     * @see OutputChangeSet::isNoop
+     * @since 5.22
+     **/
+    QHash<OutputDeviceInterface*, OutputChangeSet*> effectiveChanges() const;
+    /**
+     * Whether applying this configuration leaves all outputdevices as they are. The
+     * compositor can call setApplied() right away in that case.
+     * @see OutputChangeSet::isNoop
+     * @since 5.22
+     **/
+    bool isNoop() const;
 
 public Q_SLOTS:
     /**
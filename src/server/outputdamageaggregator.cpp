@@ -0,0 +1,255 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "outputdamageaggregator.h"
+#include "output_interface.h"
+#include "rectaccumulator_p.h"
+#include "subcompositor_interface.h"
+#include "surface_interface.h"
+
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+class OutputDamageAggregatorPrivate
+{
+public:
+    struct Tree {
+        // the position of the main surface on each output
+        QHash<OutputInterface *, QPoint> placements;
+        // the surfaces and sub-surfaces of the tree whose signals are connected
+        QVector<QPointer<QObject>> connected;
+        // the area covered by the mapped surfaces, relative to the main surface
+        QRect bounds;
+    };
+
+    OutputDamageAggregatorPrivate(OutputDamageAggregator *q);
+
+    void track(SurfaceInterface *mainSurface);
+    void untrack(SurfaceInterface *mainSurface);
+    void connectSurface(SurfaceInterface *mainSurface, SurfaceInterface *surface, Tree *tree);
+    void surfaceDamaged(SurfaceInterface *mainSurface, SurfaceInterface *surface, const QRegion &region);
+    void updateBounds(SurfaceInterface *mainSurface);
+    void addDamage(OutputInterface *output, const QRegion &region);
+
+    OutputDamageAggregator *q;
+    QHash<SurfaceInterface *, Tree> trees;
+    QHash<OutputInterface *, RectAccumulator> outputDamage;
+    int maximumRects = 0;
+};
+
+static QRect treeBounds(SurfaceInterface *mainSurface)
+{
+    QRect bounds;
+    const QVector<SurfaceRenderEntry> renderList = mainSurface->renderList();
+    for (const SurfaceRenderEntry &entry : renderList) {
+        bounds |= QRect(entry.offset, entry.surface->size());
+    }
+    return bounds;
+}
+
+static QPoint offsetInTree(SurfaceInterface *surface)
+{
+    QPoint offset;
+    while (SubSurfaceInterface *subSurface = surface->subSurface()) {
+        SurfaceInterface *parent = subSurface->parentSurface();
+        if (!parent) {
+            break;
+        }
+        offset += subSurface->position();
+        surface = parent;
+    }
+    return offset;
+}
+
+OutputDamageAggregatorPrivate::OutputDamageAggregatorPrivate(OutputDamageAggregator *q)
+    : q(q)
+{
+}
+
+void OutputDamageAggregatorPrivate::track(SurfaceInterface *mainSurface)
+{
+    Tree &tree = trees[mainSurface];
+    for (const QPointer<QObject> &object : qAsConst(tree.connected)) {
+        if (object) {
+            QObject::disconnect(object, nullptr, q, nullptr);
+        }
+    }
+    tree.connected.clear();
+    connectSurface(mainSurface, mainSurface, &tree);
+
+    QObject::connect(mainSurface, &QObject::destroyed, q, [this, mainSurface] {
+        untrack(mainSurface);
+    });
+}
+
+void OutputDamageAggregatorPrivate::untrack(SurfaceInterface *mainSurface)
+{
+    auto it = trees.find(mainSurface);
+    if (it == trees.end()) {
+        return;
+    }
+    for (auto placement = it->placements.constBegin(); placement != it->placements.constEnd(); ++placement) {
+        addDamage(placement.key(), it->bounds.translated(placement.value()));
+    }
+    for (const QPointer<QObject> &object : qAsConst(it->connected)) {
+        if (object) {
+            QObject::disconnect(object, nullptr, q, nullptr);
+        }
+    }
+    trees.erase(it);
+}
+
+void OutputDamageAggregatorPrivate::connectSurface(SurfaceInterface *mainSurface, SurfaceInterface *surface, Tree *tree)
+{
+    tree->connected.append(surface);
+    QObject::connect(surface, &SurfaceInterface::damaged, q, [this, mainSurface, surface](const QRegion &region) {
+        surfaceDamaged(mainSurface, surface, region);
+    });
+    auto boundsChanged = [this, mainSurface] {
+        updateBounds(mainSurface);
+    };
+    QObject::connect(surface, &SurfaceInterface::mapped, q, boundsChanged);
+    QObject::connect(surface, &SurfaceInterface::unmapped, q, boundsChanged);
+    QObject::connect(surface, &SurfaceInterface::sizeChanged, q, boundsChanged);
+    auto treeChanged = [this, mainSurface] {
+        track(mainSurface);
+        updateBounds(mainSurface);
+    };
+    QObject::connect(surface, &SurfaceInterface::childSubSurfaceAdded, q, treeChanged);
+    QObject::connect(surface, &SurfaceInterface::childSubSurfaceRemoved, q, treeChanged);
+
+    const QList<SubSurfaceInterface *> children = surface->childSubSurfaces();
+    for (SubSurfaceInterface *child : children) {
+        tree->connected.append(child);
+        QObject::connect(child, &SubSurfaceInterface::positionChanged, q, boundsChanged);
+        if (child->surface()) {
+            connectSurface(mainSurface, child->surface(), tree);
+        }
+    }
+}
+
+void OutputDamageAggregatorPrivate::surfaceDamaged(SurfaceInterface *mainSurface, SurfaceInterface *surface, const QRegion &region)
+{
+    const auto it = trees.constFind(mainSurface);
+    if (it == trees.constEnd()) {
+        return;
+    }
+    const QPoint offset = offsetInTree(surface);
+    for (auto placement = it->placements.constBegin(); placement != it->placements.constEnd(); ++placement) {
+        addDamage(placement.key(), region.translated(placement.value() + offset));
+    }
+}
+
+void OutputDamageAggregatorPrivate::updateBounds(SurfaceInterface *mainSurface)
+{
+    auto it = trees.find(mainSurface);
+    if (it == trees.end()) {
+        return;
+    }
+    // a sub-surface may have moved within the bounds, so the old area is damaged in any case
+    const QRect bounds = treeBounds(mainSurface);
+    const QRegion changed = QRegion(it->bounds) | bounds;
+    it->bounds = bounds;
+    for (auto placement = it->placements.constBegin(); placement != it->placements.constEnd(); ++placement) {
+        addDamage(placement.key(), changed.translated(placement.value()));
+    }
+}
+
+void OutputDamageAggregatorPrivate::addDamage(OutputInterface *output, const QRegion &region)
+{
+    auto it = outputDamage.find(output);
+    if (it == outputDamage.end()) {
+        it = outputDamage.insert(output, RectAccumulator());
+        it->setMaximumCount(maximumRects);
+        QObject::connect(output, &QObject::destroyed, q, [this, output] {
+            outputDamage.remove(output);
+            for (Tree &tree : trees) {
+                tree.placements.remove(output);
+            }
+        });
+    }
+    for (const QRect &rect : region) {
+        it->add(rect);
+    }
+}
+
+OutputDamageAggregator::OutputDamageAggregator(QObject *parent)
+    : QObject(parent)
+    , d(new OutputDamageAggregatorPrivate(this))
+{
+}
+
+OutputDamageAggregator::~OutputDamageAggregator() = default;
+
+void OutputDamageAggregator::setPlacement(SurfaceInterface *surface, OutputInterface *output, const QPoint &position)
+{
+    if (!surface || !output) {
+        return;
+    }
+    if (!d->trees.contains(surface)) {
+        d->track(surface);
+        d->trees[surface].bounds = treeBounds(surface);
+    }
+    OutputDamageAggregatorPrivate::Tree &tree = d->trees[surface];
+    auto placement = tree.placements.find(output);
+    if (placement != tree.placements.end()) {
+        if (*placement == position) {
+            return;
+        }
+        d->addDamage(output, tree.bounds.translated(*placement));
+        *placement = position;
+    } else {
+        tree.placements.insert(output, position);
+    }
+    d->addDamage(output, tree.bounds.translated(position));
+}
+
+void OutputDamageAggregator::removePlacement(SurfaceInterface *surface, OutputInterface *output)
+{
+    auto it = d->trees.find(surface);
+    if (it == d->trees.end()) {
+        return;
+    }
+    auto placement = it->placements.find(output);
+    if (placement == it->placements.end()) {
+        return;
+    }
+    d->addDamage(output, it->bounds.translated(*placement));
+    it->placements.erase(placement);
+    if (it->placements.isEmpty()) {
+        d->untrack(surface);
+    }
+}
+
+void OutputDamageAggregator::setMaximumRects(int count)
+{
+    d->maximumRects = count;
+    for (RectAccumulator &accumulator : d->outputDamage) {
+        accumulator.setMaximumCount(count);
+    }
+}
+
+int OutputDamageAggregator::maximumRects() const
+{
+    return d->maximumRects;
+}
+
+QRegion OutputDamageAggregator::damage(OutputInterface *output) const
+{
+    const auto it = d->outputDamage.constFind(output);
+    return it != d->outputDamage.constEnd() ? it->region() : QRegion();
+}
+
+QRegion OutputDamageAggregator::takeDamage(OutputInterface *output)
+{
+    auto it = d->outputDamage.find(output);
+    return it != d->outputDamage.end() ? it->take() : QRegion();
+}
+
+}
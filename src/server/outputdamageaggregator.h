@@ -0,0 +1,89 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_OUTPUTDAMAGEAGGREGATOR_H
+#define KWAYLAND_SERVER_OUTPUTDAMAGEAGGREGATOR_H
+
+#include <QObject>
+#include <QPoint>
+#include <QRegion>
+#include <QScopedPointer>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+class OutputDamageAggregatorPrivate;
+class OutputInterface;
+class SurfaceInterface;
+
+/**
+ * @brief Collects the damage of surface trees per OutputInterface.
+ *
+ * The compositor tells the aggregator where the main surfaces are shown with setPlacement(),
+ * the aggregator then maps the damage of every surface of their sub-surface trees into the
+ * coordinates of the outputs. The damage of all commits between two frames is united, the
+ * compositor takes it once per frame with takeDamage(), e.g. for a partial page flip.
+ *
+ * @code
+ * OutputDamageAggregator aggregator;
+ * aggregator.setPlacement(window->surface(), output, window->pos() - output->pos());
+ * ...
+ * const QRegion damage = aggregator.takeDamage(output);
+ * @endcode
+ *
+ * Besides the damaged regions of the surfaces, placing, moving and removing a surface tree
+ * damages the area it covers, and so do sub-surfaces getting added, removed, moved, resized,
+ * mapped or unmapped. The damage is in the logical coordinates of the output and isn't clipped
+ * to its geometry.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT OutputDamageAggregator : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit OutputDamageAggregator(QObject *parent = nullptr);
+    ~OutputDamageAggregator() override;
+
+    /**
+     * Shows the sub-surface tree of the main surface @p surface on @p output, with @p position
+     * being the position of @p surface relative to the output. A surface can be shown on any
+     * number of outputs, calling this again for the same output moves it.
+     **/
+    void setPlacement(SurfaceInterface *surface, OutputInterface *output, const QPoint &position);
+    /**
+     * Stops collecting the damage of @p surface for @p output, the area the sub-surface tree
+     * covered on it is damaged one last time.
+     **/
+    void removePlacement(SurfaceInterface *surface, OutputInterface *output);
+
+    /**
+     * Sets the number of rectangles per output above which only the bounding rectangle of the
+     * damage is kept, @c 0 disables the limit. The default is @c 0.
+     **/
+    void setMaximumRects(int count);
+    /**
+     * @see setMaximumRects
+     **/
+    int maximumRects() const;
+
+    /**
+     * @returns the damage collected for @p output since the last takeDamage()
+     **/
+    QRegion damage(OutputInterface *output) const;
+    /**
+     * @returns the damage collected for @p output and clears it
+     **/
+    QRegion takeDamage(OutputInterface *output);
+
+private:
+    QScopedPointer<OutputDamageAggregatorPrivate> d;
+};
+
+}
+
+#endif
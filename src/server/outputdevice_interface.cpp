@@ -4,6 +4,7 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "outputdevice_interface.h"
+#include "clientconnection.h"
 #include "display_p.h"
 #include "global_p.h"
 #include "display.h"
@@ -12,6 +13,8 @@
 #include <wayland-server.h>
 #include "wayland-org_kde_kwin_outputdevice-server-protocol.h"
 #include <QDebug>
+#include <QHash>
+#include <QTimer>
 
 namespace KWaylandServer
 {
@@ -22,6 +25,8 @@ public:
     struct ResourceData {
         wl_resource *resource;
         uint32_t version;
+        // the client gets the color curves through kde_output_color_curves_v1
+        bool colorCurvesShared = false;
     };
     Private(OutputDeviceInterface *q, Display *d);
     ~Private();
@@ -33,11 +38,15 @@ public:
     void updateEnabled();
     void updateScale();
     void updateColorCurves();
+    void flushColorCurves();
     void updateEisaId();
     void updateSerialNumber();
+    void updateCurrentMode();
+    void sendPendingChanges();
 
     void sendGeometry(wl_resource *resource);
     void sendMode(wl_resource *resource, const Mode &mode);
+    void sendModes(wl_resource *resource);
     void sendDone(const ResourceData &data);
     void sendUuid(const ResourceData &data);
     void sendEdid(const ResourceData &data);
@@ -54,20 +63,61 @@ public:
     qreal scale = 1.0;
     QString serialNumber;
     QString eisaId;
+    // the string arguments of the events, encoded once per change instead of once per resource
+    QByteArray manufacturerUtf8 = QByteArrayLiteral("org.kde.kwin");
+    QByteArray modelUtf8 = QByteArrayLiteral("none");
+    QByteArray serialNumberUtf8;
+    QByteArray eisaIdUtf8;
     SubPixel subPixel = SubPixel::Unknown;
     Transform transform = Transform::Normal;
     ColorCurves colorCurves;
     QList<Mode> modes;
     Mode currentMode;
+    // modes are never removed, so indices into modes stay valid
+    QHash<int, int> modeIndexById;
+    QHash<QPair<quint64, int>, int> modeIndexBySize;
+    int currentModeIndex = -1;
+    int preferredModeIndex = -1;
+    // whether modeEvents matches modes
+    bool modeEventsValid = false;
     QList<ResourceData> resources;
+    // the resources of each client, the list is shared with the callers of clientResources()
+    QHash<wl_client *, QVector<wl_resource *>> clientResources;
 
     QByteArray edid;
+    // the edid event carries base64, encoded once per change instead of once per bind
+    QByteArray encodedEdid;
     Enablement enabled = Enablement::Enabled;
     QByteArray uuid;
 
+    // limits the rate of colorcurves events, while it runs further changes are coalesced
+    QTimer *colorCurvesTimer = nullptr;
+    bool colorCurvesCoalesced = false;
+
+    int updateDepth = 0;
+    struct {
+        bool geometry = false;
+        bool scale = false;
+        bool colorCurves = false;
+        bool currentMode = false;
+    } pendingChanges;
+
     static OutputDeviceInterface *get(wl_resource *native);
+    static QPair<quint64, int> modeKey(const QSize &size, int refreshRate) {
+        return qMakePair((quint64(quint32(size.width())) << 32) | quint32(size.height()), refreshRate);
+    }
 
 private:
+    struct ModeEvent {
+        int32_t flags;
+        int32_t width;
+        int32_t height;
+        int32_t refreshRate;
+        int32_t id;
+    };
+    static ModeEvent toModeEvent(const Mode &mode);
+    // the mode events of a bind in the order they are sent, rebuilt when the modes change
+    QVector<ModeEvent> modeEvents;
     static Private *cast(wl_resource *native);
     static void unbind(wl_resource *resource);
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
@@ -76,21 +126,17 @@ private:
 
     static const quint32 s_version;
     OutputDeviceInterface *q;
-    static QVector<Private*> s_privates;
 };
 
 const quint32 OutputDeviceInterface::Private::s_version = 2;
 
-QVector<OutputDeviceInterface::Private*> OutputDeviceInterface::Private::s_privates;
-
 OutputDeviceInterface::Private::Private(OutputDeviceInterface *q, Display *d)
     : Global::Private(d, &org_kde_kwin_outputdevice_interface, s_version)
     , q(q)
 {
     DisplayPrivate *displayPrivate = DisplayPrivate::get(display);
     displayPrivate->outputdevices.append(q);
-
-    s_privates << this;
+    updateDepth = displayPrivate->outputLayoutUpdateDepth > 0 ? 1 : 0;
 }
 
 OutputDeviceInterface::Private::~Private()
@@ -100,7 +146,10 @@ OutputDeviceInterface::Private::~Private()
         displayPrivate->outputdevices.removeOne(q);
     }
 
-    s_privates.removeAll(this);
+    // the resources outlive the global, make sure they no longer resolve to it
+    for (const ResourceData &data : qAsConst(resources)) {
+        wl_resource_set_user_data(data.resource, nullptr);
+    }
 }
 
 OutputDeviceInterface *OutputDeviceInterface::Private::get(wl_resource *native)
@@ -113,30 +162,17 @@ OutputDeviceInterface *OutputDeviceInterface::Private::get(wl_resource *native)
 
 OutputDeviceInterface::Private *OutputDeviceInterface::Private::cast(wl_resource *native)
 {
-    for (auto it = s_privates.constBegin(); it != s_privates.constEnd(); ++it) {
-        const auto &resources = (*it)->resources;
-        auto rit = std::find_if(resources.begin(), resources.end(), [native] (const ResourceData &data) { return data.resource == native; });
-        if (rit != resources.end()) {
-            return (*it);
-        }
+    if (!native || !wl_resource_instance_of(native, &org_kde_kwin_outputdevice_interface, nullptr)) {
+        return nullptr;
     }
-    return nullptr;
+    return static_cast<Private *>(wl_resource_get_user_data(native));
 }
 
 OutputDeviceInterface::OutputDeviceInterface(Display *display, QObject *parent)
     : Global(new Private(this, display), parent)
 {
     Q_D();
-    connect(this, &OutputDeviceInterface::currentModeChanged, this,
-        [d] {
-            Q_ASSERT(d->currentMode.id >= 0);
-            for (auto it = d->resources.constBegin(); it != d->resources.constEnd(); ++it) {
-                d->sendMode((*it).resource, d->currentMode);
-                d->sendDone(*it);
-            }
-            wl_display_flush_clients(*(d->display));
-        }
-    );
+    connect(this, &OutputDeviceInterface::currentModeChanged,    this, [d] { d->updateCurrentMode(); });
     connect(this, &OutputDeviceInterface::subPixelChanged,       this, [d] { d->updateGeometry(); });
     connect(this, &OutputDeviceInterface::transformChanged,      this, [d] { d->updateGeometry(); });
     connect(this, &OutputDeviceInterface::globalPositionChanged, this, [d] { d->updateGeometry(); });
@@ -180,112 +216,95 @@ void OutputDeviceInterface::addMode(Mode &mode)
     Q_ASSERT(mode.size.isValid());
     Q_D();
 
-    auto currentModeIt = std::find_if(d->modes.begin(), d->modes.end(),
-        [](const Mode &mode) {
-            return mode.flags.testFlag(ModeFlag::Current);
+    int index = d->modeIndexById.value(mode.id, -1);
+    if (index != -1) {
+        const Mode &existingMode = d->modes.at(index);
+        if (existingMode.size != mode.size || existingMode.refreshRate != mode.refreshRate) {
+            qCWarning(KWAYLAND_SERVER) << "Duplicate Mode id" << mode.id << ": not adding mode" << mode.size << mode.refreshRate;
+            return;
         }
-    );
-    if (currentModeIt == d->modes.end() && !mode.flags.testFlag(ModeFlag::Current)) {
+    }
+
+    if (d->currentModeIndex == -1 && !mode.flags.testFlag(ModeFlag::Current)) {
         // no mode with current flag - enforce
         mode.flags |= ModeFlag::Current;
     }
-    if (currentModeIt != d->modes.end() && mode.flags.testFlag(ModeFlag::Current)) {
+    if (index != -1 && d->modes.at(index).flags == mode.flags) {
+        // nothing to do
+        return;
+    }
+    if (d->currentModeIndex != -1 && d->currentModeIndex != index && mode.flags.testFlag(ModeFlag::Current)) {
         // another mode has the current flag - remove
-        (*currentModeIt).flags &= ~uint(ModeFlag::Current);
+        d->modes[d->currentModeIndex].flags &= ~uint(ModeFlag::Current);
+        d->currentModeIndex = -1;
     }
-
-    if (mode.flags.testFlag(ModeFlag::Preferred)) {
+    if (d->preferredModeIndex != -1 && d->preferredModeIndex != index && mode.flags.testFlag(ModeFlag::Preferred)) {
         // remove from existing Preferred mode
-        auto preferredIt = std::find_if(d->modes.begin(), d->modes.end(),
-            [](const Mode &mode) {
-                return mode.flags.testFlag(ModeFlag::Preferred);
-            }
-        );
-        if (preferredIt != d->modes.end()) {
-            (*preferredIt).flags &= ~uint(ModeFlag::Preferred);
-        }
+        d->modes[d->preferredModeIndex].flags &= ~uint(ModeFlag::Preferred);
+        d->preferredModeIndex = -1;
     }
 
-    auto existingModeIt = std::find_if(d->modes.begin(), d->modes.end(),
-        [mode](const Mode &mode_it) {
-            return mode.size == mode_it.size &&
-                   mode.refreshRate == mode_it.refreshRate &&
-                   mode.id == mode_it.id;
-        }
-    );
-    auto emitChanges = [this, d, mode] {
-        emit modesChanged();
-        if (mode.flags.testFlag(ModeFlag::Current)) {
-            d->currentMode = mode;
-            emit refreshRateChanged(mode.refreshRate);
-            emit pixelSizeChanged(mode.size);
-            emit currentModeChanged();
-        }
-    };
-    if (existingModeIt != d->modes.end()) {
-        if ((*existingModeIt).flags == mode.flags) {
-            // nothing to do
-            return;
-        }
-        (*existingModeIt).flags = mode.flags;
-        emitChanges();
-        return;
+    if (index != -1) {
+        d->modes[index].flags = mode.flags;
     } else {
-        auto idIt = std::find_if(d->modes.constBegin(), d->modes.constEnd(),
-                                        [mode](const Mode &mode_it) {
-                                            return mode.id == mode_it.id;
-                                        }
-        );
-        if (idIt != d->modes.constEnd()) {
-            qCWarning(KWAYLAND_SERVER) << "Duplicate Mode id" << mode.id << ": not adding mode" << mode.size << mode.refreshRate;
-            return;
+        index = d->modes.count();
+        d->modes << mode;
+        d->modeIndexById.insert(mode.id, index);
+        const auto key = Private::modeKey(mode.size, mode.refreshRate);
+        if (!d->modeIndexBySize.contains(key)) {
+            d->modeIndexBySize.insert(key, index);
         }
+    }
+    d->modeEventsValid = false;
+    if (mode.flags.testFlag(ModeFlag::Current)) {
+        d->currentModeIndex = index;
+    } else if (d->currentModeIndex == index) {
+        d->currentModeIndex = -1;
+    }
+    if (mode.flags.testFlag(ModeFlag::Preferred)) {
+        d->preferredModeIndex = index;
+    } else if (d->preferredModeIndex == index) {
+        d->preferredModeIndex = -1;
+    }
 
+    emit modesChanged();
+    if (mode.flags.testFlag(ModeFlag::Current)) {
+        d->currentMode = mode;
+        emit refreshRateChanged(mode.refreshRate);
+        emit pixelSizeChanged(mode.size);
+        emit currentModeChanged();
     }
-    d->modes << mode;
-    emitChanges();
 }
 
 void OutputDeviceInterface::setCurrentMode(const int modeId)
 {
     Q_D();
-    auto currentModeIt = std::find_if(d->modes.begin(), d->modes.end(),
-        [](const Mode &mode) {
-            return mode.flags.testFlag(ModeFlag::Current);
-        }
-    );
-    if (currentModeIt != d->modes.end()) {
+    const int index = d->modeIndexById.value(modeId, -1);
+    Q_ASSERT(index != -1);
+    d->modeEventsValid = false;
+    if (d->currentModeIndex != -1) {
         // another mode has the current flag - remove
-        (*currentModeIt).flags &= ~uint(ModeFlag::Current);
+        d->modes[d->currentModeIndex].flags &= ~uint(ModeFlag::Current);
     }
 
-    auto existingModeIt = std::find_if(d->modes.begin(), d->modes.end(),
-        [modeId](const Mode &mode) {
-            return mode.id == modeId;
-        }
-    );
-
-    Q_ASSERT(existingModeIt != d->modes.end());
-    (*existingModeIt).flags |= ModeFlag::Current;
-    d->currentMode = *existingModeIt;
+    Mode &mode = d->modes[index];
+    mode.flags |= ModeFlag::Current;
+    d->currentModeIndex = index;
+    d->currentMode = mode;
     emit modesChanged();
-    emit refreshRateChanged((*existingModeIt).refreshRate);
-    emit pixelSizeChanged((*existingModeIt).size);
+    emit refreshRateChanged(mode.refreshRate);
+    emit pixelSizeChanged(mode.size);
     emit currentModeChanged();
 }
 
 bool OutputDeviceInterface::setCurrentMode(const QSize &size, int refreshRate)
 {
     Q_D();
-    auto mode = std::find_if(d->modes.constBegin(), d->modes.constEnd(),
-        [size, refreshRate](const Mode &mode) {
-            return mode.size == size && mode.refreshRate == refreshRate;
-        }
-    );
-    if (mode == d->modes.constEnd()) {
+    const int index = d->modeIndexBySize.value(Private::modeKey(size, refreshRate), -1);
+    if (index == -1) {
         return false;
     }
-    setCurrentMode((*mode).id);
+    setCurrentMode(d->modes.at(index).id);
     return true;
 }
 
@@ -345,28 +364,14 @@ void OutputDeviceInterface::Private::bind(wl_client *client, uint32_t version, u
     r.resource = resource;
     r.version = version;
     resources << r;
+    clientResources[client].append(resource);
 
     sendGeometry(resource);
     sendScale(r);
     sendColorCurves(r);
     sendEisaId(r);
     sendSerialNumber(r);
-
-    auto currentModeIt = modes.constEnd();
-    for (auto it = modes.constBegin(); it != modes.constEnd(); ++it) {
-        const Mode &mode = *it;
-        if (mode.flags.testFlag(ModeFlag::Current)) {
-            // needs to be sent as last mode
-            currentModeIt = it;
-            continue;
-        }
-        sendMode(resource, mode);
-    }
-
-    if (currentModeIt != modes.constEnd()) {
-        sendMode(resource, *currentModeIt);
-    }
-
+    sendModes(resource);
     sendUuid(r);
     sendEdid(r);
     sendEnabled(r);
@@ -385,9 +390,16 @@ void OutputDeviceInterface::Private::unbind(wl_resource *resource)
     if (it != o->resources.end()) {
         o->resources.erase(it);
     }
+    auto clientIt = o->clientResources.find(wl_resource_get_client(resource));
+    if (clientIt != o->clientResources.end()) {
+        clientIt->removeOne(resource);
+        if (clientIt->isEmpty()) {
+            o->clientResources.erase(clientIt);
+        }
+    }
 }
 
-void OutputDeviceInterface::Private::sendMode(wl_resource *resource, const Mode &mode)
+OutputDeviceInterface::Private::ModeEvent OutputDeviceInterface::Private::toModeEvent(const Mode &mode)
 {
     int32_t flags = 0;
     if (mode.flags.testFlag(ModeFlag::Current)) {
@@ -396,13 +408,34 @@ void OutputDeviceInterface::Private::sendMode(wl_resource *resource, const Mode
     if (mode.flags.testFlag(ModeFlag::Preferred)) {
         flags |= WL_OUTPUT_MODE_PREFERRED;
     }
-    org_kde_kwin_outputdevice_send_mode(resource,
-                        flags,
-                        mode.size.width(),
-                        mode.size.height(),
-                        mode.refreshRate,
-                        mode.id);
+    return ModeEvent{flags, mode.size.width(), mode.size.height(), mode.refreshRate, mode.id};
+}
+
+void OutputDeviceInterface::Private::sendMode(wl_resource *resource, const Mode &mode)
+{
+    const ModeEvent event = toModeEvent(mode);
+    org_kde_kwin_outputdevice_send_mode(resource, event.flags, event.width, event.height, event.refreshRate, event.id);
+}
 
+void OutputDeviceInterface::Private::sendModes(wl_resource *resource)
+{
+    if (!modeEventsValid) {
+        modeEvents.clear();
+        modeEvents.reserve(modes.count());
+        for (int i = 0; i < modes.count(); ++i) {
+            // the current mode needs to be sent as last mode
+            if (i != currentModeIndex) {
+                modeEvents << toModeEvent(modes.at(i));
+            }
+        }
+        if (currentModeIndex != -1) {
+            modeEvents << toModeEvent(modes.at(currentModeIndex));
+        }
+        modeEventsValid = true;
+    }
+    for (const ModeEvent &event : qAsConst(modeEvents)) {
+        org_kde_kwin_outputdevice_send_mode(resource, event.flags, event.width, event.height, event.refreshRate, event.id);
+    }
 }
 
 void OutputDeviceInterface::Private::sendGeometry(wl_resource *resource)
@@ -413,8 +446,8 @@ void OutputDeviceInterface::Private::sendGeometry(wl_resource *resource)
                             physicalSize.width(),
                             physicalSize.height(),
                             toSubPixel(),
-                            qPrintable(manufacturer),
-                            qPrintable(model),
+                            manufacturerUtf8.constData(),
+                            modelUtf8.constData(),
                             toTransform());
 }
 
@@ -429,7 +462,7 @@ void OutputDeviceInterface::Private::sendScale(const ResourceData &data)
 
 void OutputDeviceInterface::Private::sendColorCurves(const ResourceData &data)
 {
-    if (data.version < ORG_KDE_KWIN_OUTPUTDEVICE_COLORCURVES_SINCE_VERSION) {
+    if (data.version < ORG_KDE_KWIN_OUTPUTDEVICE_COLORCURVES_SINCE_VERSION || data.colorCurvesShared) {
         return;
     }
 
@@ -456,7 +489,7 @@ void KWaylandServer::OutputDeviceInterface::Private::sendSerialNumber(const Reso
 {
     if (wl_resource_get_version(data.resource) >= ORG_KDE_KWIN_OUTPUTDEVICE_SERIAL_NUMBER_SINCE_VERSION) {
         org_kde_kwin_outputdevice_send_serial_number(data.resource,
-                                            qPrintable(serialNumber));
+                                            serialNumberUtf8.constData());
     }
 }
 
@@ -464,7 +497,7 @@ void KWaylandServer::OutputDeviceInterface::Private::sendEisaId(const ResourceDa
 {
     if (wl_resource_get_version(data.resource) >= ORG_KDE_KWIN_OUTPUTDEVICE_EISA_ID_SINCE_VERSION) {
         org_kde_kwin_outputdevice_send_eisa_id(data.resource,
-                                            qPrintable(eisaId));
+                                            eisaIdUtf8.constData());
     }
 }
 
@@ -476,25 +509,90 @@ void OutputDeviceInterface::Private::sendDone(const ResourceData &data)
 
 void OutputDeviceInterface::Private::updateGeometry()
 {
-    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
-        sendGeometry((*it).resource);
-        sendDone(*it);
-    }
+    pendingChanges.geometry = true;
+    sendPendingChanges();
 }
 
 void OutputDeviceInterface::Private::updateScale()
 {
-    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
-        sendScale(*it);
-        sendDone(*it);
-    }
+    pendingChanges.scale = true;
+    sendPendingChanges();
 }
 
 void OutputDeviceInterface::Private::updateColorCurves()
 {
-    for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
-        sendColorCurves(*it);
-        sendDone(*it);
+    if (colorCurvesTimer && colorCurvesTimer->isActive()) {
+        colorCurvesCoalesced = true;
+        return;
+    }
+    pendingChanges.colorCurves = true;
+    sendPendingChanges();
+    if (colorCurvesTimer) {
+        colorCurvesTimer->start();
+    }
+}
+
+void OutputDeviceInterface::Private::flushColorCurves()
+{
+    if (!colorCurvesCoalesced) {
+        return;
+    }
+    colorCurvesCoalesced = false;
+    pendingChanges.colorCurves = true;
+    sendPendingChanges();
+    if (colorCurvesTimer) {
+        // the window restarts, so a steady stream of changes is sent at the chosen rate
+        colorCurvesTimer->start();
+    }
+}
+
+void OutputDeviceInterface::Private::updateCurrentMode()
+{
+    Q_ASSERT(currentMode.id >= 0);
+    pendingChanges.currentMode = true;
+    sendPendingChanges();
+}
+
+void OutputDeviceInterface::Private::sendPendingChanges()
+{
+    if (updateDepth > 0) {
+        return;
+    }
+    if (pendingChanges.geometry || pendingChanges.scale || pendingChanges.colorCurves || pendingChanges.currentMode) {
+        for (auto it = resources.constBegin(); it != resources.constEnd(); ++it) {
+            if (pendingChanges.geometry) {
+                sendGeometry((*it).resource);
+            }
+            if (pendingChanges.scale) {
+                sendScale(*it);
+            }
+            if (pendingChanges.colorCurves) {
+                sendColorCurves(*it);
+            }
+            if (pendingChanges.currentMode) {
+                sendMode((*it).resource, currentMode);
+            }
+            sendDone(*it);
+        }
+        if (pendingChanges.currentMode) {
+            wl_display_flush_clients(*display);
+        }
+    }
+    pendingChanges = {};
+}
+
+void OutputDeviceInterface::beginUpdate()
+{
+    Q_D();
+    d->updateDepth++;
+}
+
+void OutputDeviceInterface::commitUpdate()
+{
+    Q_D();
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth == 0) {
+        d->sendPendingChanges();
     }
 }
 
@@ -519,15 +617,30 @@ bool OutputDeviceInterface::ColorCurves::operator!=(const ColorCurves &cc) const
 
 SETTER(setPhysicalSize, const QSize&, physicalSize)
 SETTER(setGlobalPosition, const QPoint&, globalPosition)
-SETTER(setManufacturer, const QString&, manufacturer)
-SETTER(setModel, const QString&, model)
-SETTER(setSerialNumber, const QString&, serialNumber)
-SETTER(setEisaId, const QString&, eisaId)
 SETTER(setSubPixel, SubPixel, subPixel)
 SETTER(setTransform, Transform, transform)
 
 #undef SETTER
 
+#define STRING_SETTER(setterName, argumentName) \
+    void OutputDeviceInterface::setterName(const QString &arg) \
+    { \
+        Q_D(); \
+        if (d->argumentName == arg) { \
+            return; \
+        } \
+        d->argumentName = arg; \
+        d->argumentName##Utf8 = arg.toUtf8(); \
+        emit argumentName##Changed(d->argumentName); \
+    }
+
+STRING_SETTER(setManufacturer, manufacturer)
+STRING_SETTER(setModel, model)
+STRING_SETTER(setSerialNumber, serialNumber)
+STRING_SETTER(setEisaId, eisaId)
+
+#undef STRING_SETTER
+
 void OutputDeviceInterface::setScale(int scale)
 {
     Q_D();
@@ -623,15 +736,28 @@ QList< OutputDeviceInterface::Mode > OutputDeviceInterface::modes() const
     return d->modes;
 }
 
+void OutputDeviceInterface::setColorCurvesShared(wl_resource *resource)
+{
+    Q_D();
+    auto it = std::find_if(d->resources.begin(), d->resources.end(), [resource](const Private::ResourceData &r) { return r.resource == resource; });
+    if (it != d->resources.end()) {
+        (*it).colorCurvesShared = true;
+    }
+}
+
+QVector<wl_resource *> OutputDeviceInterface::clientResources(ClientConnection *client) const
+{
+    Q_D();
+    return d->clientResources.value(client->client());
+}
+
 int OutputDeviceInterface::currentModeId() const
 {
     Q_D();
-    for (const Mode &m: d->modes) {
-        if (m.flags.testFlag(OutputDeviceInterface::ModeFlag::Current)) {
-            return m.id;
-        }
+    if (d->currentModeIndex == -1) {
+        return -1;
     }
-    return -1;
+    return d->modes.at(d->currentModeIndex).id;
 }
 
 OutputDeviceInterface::Private *OutputDeviceInterface::d_func() const
@@ -639,6 +765,29 @@ OutputDeviceInterface::Private *OutputDeviceInterface::d_func() const
     return reinterpret_cast<Private*>(d.data());
 }
 
+void OutputDeviceInterface::setColorCurvesUpdateInterval(int msec)
+{
+    Q_D();
+    if (msec <= 0) {
+        delete d->colorCurvesTimer;
+        d->colorCurvesTimer = nullptr;
+        d->flushColorCurves();
+        return;
+    }
+    if (!d->colorCurvesTimer) {
+        d->colorCurvesTimer = new QTimer(this);
+        d->colorCurvesTimer->setSingleShot(true);
+        connect(d->colorCurvesTimer, &QTimer::timeout, this, [d] { d->flushColorCurves(); });
+    }
+    d->colorCurvesTimer->setInterval(msec);
+}
+
+int OutputDeviceInterface::colorCurvesUpdateInterval() const
+{
+    Q_D();
+    return d->colorCurvesTimer ? d->colorCurvesTimer->interval() : 0;
+}
+
 void OutputDeviceInterface::setColorCurves(const ColorCurves &colorCurves)
 {
     Q_D();
@@ -654,6 +803,7 @@ void OutputDeviceInterface::setEdid(const QByteArray &edid)
 {
     Q_D();
     d->edid = edid;
+    d->encodedEdid = edid.toBase64();
     d->updateEdid();
     emit edidChanged();
 }
@@ -698,8 +848,7 @@ QByteArray OutputDeviceInterface::uuid() const
 
 void KWaylandServer::OutputDeviceInterface::Private::sendEdid(const ResourceData &data)
 {
-    org_kde_kwin_outputdevice_send_edid(data.resource,
-                                        edid.toBase64().constData());
+    org_kde_kwin_outputdevice_send_edid(data.resource, encodedEdid.constData());
 }
 
 void KWaylandServer::OutputDeviceInterface::Private::sendEnabled(const ResourceData &data)
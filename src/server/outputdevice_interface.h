@@ -19,6 +19,7 @@ struct wl_resource;
 namespace KWaylandServer
 {
 
+class ClientConnection;
 class Display;
 
 /** @class OutputDeviceInterface
@@ -128,6 +129,22 @@ public:
     void setSubPixel(SubPixel subPixel);
     void setTransform(Transform transform);
     void setColorCurves(const ColorCurves &colorCurves);
+    /**
+     * Sets the minimum interval in milliseconds between two colorcurves events sent to the
+     * clients. Changes made within the interval are coalesced, the clients get the latest
+     * color curves once it elapsed. colorCurves() and colorCurvesChanged() are not affected,
+     * so the compositor can keep driving the hardware at full rate.
+     *
+     * The default of @c 0 sends every change right away.
+     * @since 5.22
+     **/
+    void setColorCurvesUpdateInterval(int msec);
+    /**
+     * @returns the minimum interval between two colorcurves events, @c 0 if not limited
+     * @see setColorCurvesUpdateInterval
+     * @since 5.22
+     **/
+    int colorCurvesUpdateInterval() const;
 
     /**
      * Add an additional mode to this output device. This is only allowed before create() is called
@@ -147,6 +164,35 @@ public:
     void setEnabled(OutputDeviceInterface::Enablement enabled);
     void setUuid(const QByteArray &uuid);
 
+    /**
+     * Starts a batch of property changes. The changes made until the matching commitUpdate()
+     * are sent to the clients together, followed by a single done event.
+     *
+     * Calls can be nested, the changes are sent by the outermost commitUpdate().
+     * @see OutputInterface::beginUpdate
+     * @since 5.22
+     **/
+    void beginUpdate();
+    /**
+     * Ends the batch started by beginUpdate() and sends the changed properties to the clients.
+     * @since 5.22
+     **/
+    void commitUpdate();
+
+    /**
+     * Stops sending the colorcurves event to @p resource, its client gets the color curves
+     * through OutputColorCurvesManagerV1Interface instead.
+     * @internal
+     * @since 5.22
+     **/
+    void setColorCurvesShared(wl_resource *resource);
+
+    /**
+     * @returns all org_kde_kwin_outputdevice resources bound by @p client
+     * @since 5.22
+     **/
+    QVector<wl_resource *> clientResources(ClientConnection *client) const;
+
     static OutputDeviceInterface *get(wl_resource *native);
     static QList<OutputDeviceInterface *>list();
 
@@ -13,6 +13,7 @@
 #include "wayland-output-management-server-protocol.h"
 
 #include <QHash>
+#include <QPointer>
 
 namespace KWaylandServer
 {
@@ -22,6 +23,15 @@ class OutputManagementInterface::Private : public Global::Private
 public:
     Private(OutputManagementInterface *q, Display *d);
 
+    void requestConfigurationChange(OutputConfigurationInterface *config);
+    void finishConfiguration(OutputConfigurationInterface *config);
+    void handOver(OutputConfigurationInterface *config);
+
+    bool queueing = false;
+    QPointer<OutputConfigurationInterface> inFlight;
+    QPointer<OutputConfigurationInterface> pending;
+    ConfigurationTest test;
+
 private:
     void bind(wl_client *client, uint32_t version, uint32_t id) override;
 
@@ -55,6 +65,112 @@ OutputManagementInterface::~OutputManagementInterface()
 {
 }
 
+OutputManagementInterface::Private *OutputManagementInterface::d_func() const
+{
+    return reinterpret_cast<Private*>(d.data());
+}
+
+void OutputManagementInterface::setConfigurationQueueingEnabled(bool enabled)
+{
+    Private *d = d_func();
+    if (d->queueing == enabled) {
+        return;
+    }
+    d->queueing = enabled;
+    if (!enabled) {
+        d->inFlight.clear();
+        if (OutputConfigurationInterface *config = d->pending) {
+            d->pending.clear();
+            d->handOver(config);
+        }
+    }
+}
+
+bool OutputManagementInterface::isConfigurationQueueingEnabled() const
+{
+    return d_func()->queueing;
+}
+
+OutputConfigurationInterface *OutputManagementInterface::inFlightConfiguration() const
+{
+    return d_func()->inFlight;
+}
+
+OutputConfigurationInterface *OutputManagementInterface::pendingConfiguration() const
+{
+    return d_func()->pending;
+}
+
+void OutputManagementInterface::setConfigurationTest(const ConfigurationTest &test)
+{
+    d_func()->test = test;
+}
+
+bool OutputManagementInterface::testConfiguration(OutputConfigurationInterface *configuration) const
+{
+    const ConfigurationTest &test = d_func()->test;
+    return !test || test(configuration);
+}
+
+void OutputManagementInterface::requestConfigurationChange(OutputConfigurationInterface *configuration)
+{
+    d_func()->requestConfigurationChange(configuration);
+}
+
+void OutputManagementInterface::finishConfiguration(OutputConfigurationInterface *configuration)
+{
+    d_func()->finishConfiguration(configuration);
+}
+
+void OutputManagementInterface::Private::requestConfigurationChange(OutputConfigurationInterface *config)
+{
+    if (!q->testConfiguration(config)) {
+        config->setFailed();
+        return;
+    }
+    if (!queueing) {
+        handOver(config);
+        return;
+    }
+    if (inFlight) {
+        // this includes the in flight configuration being applied again
+        if (pending && pending != config) {
+            OutputConfigurationInterface *superseded = pending;
+            pending.clear();
+            emit q->configurationSuperseded(superseded);
+            superseded->setFailed();
+        }
+        pending = config;
+        return;
+    }
+    handOver(config);
+}
+
+void OutputManagementInterface::Private::handOver(OutputConfigurationInterface *config)
+{
+    if (queueing) {
+        inFlight = config;
+    }
+    emit q->configurationChangeRequested(config);
+}
+
+void OutputManagementInterface::Private::finishConfiguration(OutputConfigurationInterface *config)
+{
+    if (pending == config && inFlight != config) {
+        // failed by the test or by the compositor before it was handed over
+        pending.clear();
+        return;
+    }
+    if (inFlight != config) {
+        return;
+    }
+    inFlight.clear();
+    if (OutputConfigurationInterface *next = pending) {
+        pending.clear();
+        handOver(next);
+    }
+}
+
 void OutputManagementInterface::Private::createConfigurationCallback(wl_client *client, wl_resource *resource, uint32_t id)
 {
     cast(resource)->createConfiguration(client, resource, id);
@@ -73,6 +189,13 @@ void OutputManagementInterface::Private::createConfiguration(wl_client* client,
     configurationInterfaces[resource] = config;
     connect(config, &QObject::destroyed, q, [this, resource] {
         configurationInterfaces.remove(resource);
+        // the QPointers are already cleared, a destroyed in flight configuration lets the
+        // pending one through
+        if (!inFlight && pending) {
+            OutputConfigurationInterface *next = pending;
+            pending.clear();
+            handOver(next);
+        }
     });
 }
 
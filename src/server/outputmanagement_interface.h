@@ -10,6 +10,8 @@
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
+#include <functional>
+
 namespace KWaylandServer
 {
 
@@ -36,6 +38,69 @@ public:
     explicit OutputManagementInterface(Display *display, QObject *parent = nullptr);
     virtual ~OutputManagementInterface();
 
+    /**
+     * A dry run of a configuration, see setConfigurationTest().
+     * @since 5.22
+     **/
+    using ConfigurationTest = std::function<bool(OutputConfigurationInterface *configuration)>;
+
+    /**
+     * Sets whether applied configurations are queued.
+     *
+     * Without queueing, configurationChangeRequested is emitted for every configuration a
+     * client applies. With queueing, only one configuration is in flight: the one handed to
+     * the compositor until it calls OutputConfigurationInterface::setApplied() or
+     * OutputConfigurationInterface::setFailed(). Configurations applied meanwhile wait as the
+     * pending configuration, and a newer one supersedes it: the older one fails right away
+     * without reaching the compositor. So a settings UI sending a configuration for every step
+     * of a scale slider causes at most two mode sets, not one per step.
+     *
+     * Disabling the queueing hands the pending configuration over right away.
+     *
+     * The default is @c false.
+     * @see configurationSuperseded
+     * @since 5.22
+     **/
+    void setConfigurationQueueingEnabled(bool enabled);
+    /**
+     * @see setConfigurationQueueingEnabled
+     * @since 5.22
+     **/
+    bool isConfigurationQueueingEnabled() const;
+    /**
+     * @returns The configuration handed to the compositor which is neither applied nor failed
+     * yet, @c null if there is none or queueing is disabled.
+     * @see setConfigurationQueueingEnabled
+     * @since 5.22
+     **/
+    OutputConfigurationInterface *inFlightConfiguration() const;
+    /**
+     * @returns The configuration waiting for the in flight configuration to finish, @c null if
+     * there is none.
+     * @see setConfigurationQueueingEnabled
+     * @since 5.22
+     **/
+    OutputConfigurationInterface *pendingConfiguration() const;
+
+    /**
+     * Sets the dry run for the configurations clients apply, e.g. a check whether the modes
+     * fit the bandwidth of the outputs. The test must not apply anything. A configuration the
+     * test rejects fails right away, before it gets queued or handed to the compositor, so a
+     * client finds out about an invalid configuration without any output being touched.
+     *
+     * An empty test, the default, accepts all configurations.
+     * @see testConfiguration
+     * @since 5.22
+     **/
+    void setConfigurationTest(const ConfigurationTest &test);
+    /**
+     * Runs the dry run set with setConfigurationTest() on @p configuration.
+     *
+     * @returns @c true if there is no test or @p configuration passes it.
+     * @since 5.22
+     **/
+    bool testConfiguration(OutputConfigurationInterface *configuration) const;
+
 Q_SIGNALS:
     /**
      * Emitted after the client has requested an OutputConfiguration to be applied.
@@ -51,9 +116,20 @@ Q_SIGNALS:
      * @see OutputInterface
      */
     void configurationChangeRequested(KWaylandServer::OutputConfigurationInterface *configurationInterface);
+    /**
+     * Emitted when @p configurationInterface was pending and got superseded by a newer
+     * configuration, right before it fails.
+     * @see setConfigurationQueueingEnabled
+     * @since 5.22
+     **/
+    void configurationSuperseded(KWaylandServer::OutputConfigurationInterface *configurationInterface);
 
 private:
+    friend class OutputConfigurationInterface;
+    void requestConfigurationChange(OutputConfigurationInterface *configuration);
+    void finishConfiguration(OutputConfigurationInterface *configuration);
     class Private;
+    Private *d_func() const;
 };
 
 }
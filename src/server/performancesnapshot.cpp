@@ -0,0 +1,118 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "performancesnapshot.h"
+#include "performancesnapshot_p.h"
+#include "display.h"
+
+#include <QDBusConnection>
+#include <QVariantList>
+
+namespace KWaylandServer
+{
+
+static const QString s_dbusPath = QStringLiteral("/org/kde/KWaylandServer/Performance");
+
+static QVariantMap histogramToVariantMap(const InputLatencyHistogram &histogram)
+{
+    QVariantList buckets;
+    buckets.reserve(InputLatencyHistogram::bucketCount);
+    for (int i = 0; i < InputLatencyHistogram::bucketCount; ++i) {
+        buckets.append(histogram.bucket(i));
+    }
+    return {
+        {QStringLiteral("count"), histogram.count()},
+        {QStringLiteral("minimum"), histogram.minimum()},
+        {QStringLiteral("maximum"), histogram.maximum()},
+        {QStringLiteral("mean"), histogram.mean()},
+        {QStringLiteral("p50"), histogram.percentile(0.5)},
+        {QStringLiteral("p99"), histogram.percentile(0.99)},
+        {QStringLiteral("buckets"), buckets},
+    };
+}
+
+static QVariantMap clientToVariantMap(const ClientPerformanceSnapshot &client)
+{
+    QVariantList memoryUsageByCategory;
+    for (qint64 bytes : client.memoryUsageByCategory) {
+        memoryUsageByCategory.append(bytes);
+    }
+    return {
+        {QStringLiteral("processId"), qint64(client.processId)},
+        {QStringLiteral("executablePath"), client.executablePath},
+        {QStringLiteral("memoryUsage"), client.memoryUsage},
+        {QStringLiteral("memoryUsageByCategory"), memoryUsageByCategory},
+        {QStringLiteral("pendingFrameCallbackCount"), client.pendingFrameCallbackCount},
+        {QStringLiteral("commitCount"), client.commitCount},
+        {QStringLiteral("commitsPerSecond"), client.commitsPerSecond},
+        {QStringLiteral("commitRateLimit"), client.commitRateLimit},
+        {QStringLiteral("commitRatePeriod"), client.commitRatePeriod},
+        {QStringLiteral("throttledCommitCount"), client.throttledCommitCount},
+        {QStringLiteral("requestCpuTime"), client.requestCpuTime},
+        {QStringLiteral("requestBudgetExceededCount"), client.requestBudgetExceededCount},
+        {QStringLiteral("queuedBytes"), client.queuedBytes},
+        {QStringLiteral("congested"), client.congested},
+    };
+}
+
+QVariantMap PerformanceSnapshot::toVariantMap() const
+{
+    QVariantList protocol;
+    protocol.reserve(protocolStatistics.count());
+    for (const ProtocolMessageStatistics &message : protocolStatistics) {
+        protocol.append(QVariantMap{
+            {QStringLiteral("processId"), qint64(message.client ? message.client->processId() : 0)},
+            {QStringLiteral("interface"), QString::fromLatin1(message.interface)},
+            {QStringLiteral("message"), QString::fromLatin1(message.message)},
+            {QStringLiteral("request"), message.direction == ProtocolMessageStatistics::Direction::Request},
+            {QStringLiteral("count"), message.count},
+            {QStringLiteral("bytes"), message.bytes},
+        });
+    }
+    QVariantList latency;
+    for (const InputLatencyHistogram &histogram : inputLatency) {
+        latency.append(histogramToVariantMap(histogram));
+    }
+    QVariantList clientList;
+    clientList.reserve(clients.count());
+    for (const ClientPerformanceSnapshot &client : clients) {
+        clientList.append(clientToVariantMap(client));
+    }
+    return {
+        {QStringLiteral("timestamp"), timestamp},
+        {QStringLiteral("flushCount"), flushCount},
+        {QStringLiteral("bufferReleaseCount"), bufferReleaseCount},
+        {QStringLiteral("coalescedBufferReleaseCount"), coalescedBufferReleaseCount},
+        {QStringLiteral("protocolStatistics"), protocol},
+        {QStringLiteral("inputLatency"), latency},
+        {QStringLiteral("clients"), clientList},
+    };
+}
+
+PerformanceDBusExport::PerformanceDBusExport(Display *display)
+    : QObject(display)
+    , m_display(display)
+{
+}
+
+PerformanceDBusExport::~PerformanceDBusExport()
+{
+    if (m_registered) {
+        QDBusConnection::sessionBus().unregisterObject(s_dbusPath);
+    }
+}
+
+bool PerformanceDBusExport::registerObject()
+{
+    m_registered = QDBusConnection::sessionBus().registerObject(s_dbusPath, this, QDBusConnection::ExportScriptableSlots);
+    return m_registered;
+}
+
+QVariantMap PerformanceDBusExport::Snapshot() const
+{
+    return m_display->performanceSnapshot().toVariantMap();
+}
+
+}
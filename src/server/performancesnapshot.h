@@ -0,0 +1,135 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PERFORMANCESNAPSHOT_H
+#define KWAYLAND_SERVER_PERFORMANCESNAPSHOT_H
+
+#include "clientconnection.h"
+#include "inputlatency.h"
+#include "protocolstatistics.h"
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <array>
+
+namespace KWaylandServer
+{
+
+/**
+ * @brief The performance counters of one client at the time of a PerformanceSnapshot.
+ *
+ * @see ClientConnection
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT ClientPerformanceSnapshot
+{
+    /**
+     * The number of values in memoryUsageByCategory, one per ClientMemoryCategory.
+     **/
+    static constexpr int memoryCategoryCount = int(ClientMemoryCategory::TextInput) + 1;
+
+    /**
+     * The client. The pointer is only meant to identify the client and may belong to a
+     * client that has disconnected since.
+     **/
+    ClientConnection *client = nullptr;
+    pid_t processId = 0;
+    QString executablePath;
+    /**
+     * @see ClientConnection::memoryUsage
+     **/
+    qint64 memoryUsage = 0;
+    /**
+     * The memoryUsage split up, indexed by ClientMemoryCategory.
+     **/
+    std::array<qint64, memoryCategoryCount> memoryUsageByCategory = {};
+    /**
+     * The frame callback backlog, see ClientConnection::pendingFrameCallbackCount.
+     **/
+    int pendingFrameCallbackCount = 0;
+    quint64 commitCount = 0;
+    qreal commitsPerSecond = 0;
+    /**
+     * The commit rate limit, @c 0 if the client isn't throttled.
+     * @see ClientConnection::setCommitRateLimit
+     **/
+    int commitRateLimit = 0;
+    int commitRatePeriod = 0;
+    quint64 throttledCommitCount = 0;
+    /**
+     * @see ClientConnection::requestCpuTime
+     **/
+    qint64 requestCpuTime = 0;
+    quint64 requestBudgetExceededCount = 0;
+    /**
+     * @see ClientConnection::queuedBytes
+     **/
+    qint64 queuedBytes = -1;
+    bool congested = false;
+};
+
+/**
+ * @brief All performance counters of a Display at one point in time.
+ *
+ * The snapshot only holds copies, so it can be kept, compared with a later one or sent
+ * elsewhere. Counters that have to be enabled, like the protocol statistics and the input
+ * latency, are empty while they are disabled.
+ *
+ * @see Display::performanceSnapshot
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT PerformanceSnapshot
+{
+    /**
+     * The number of histograms in inputLatency, one per InputLatencyEventType.
+     **/
+    static constexpr int inputLatencyEventTypeCount = int(InputLatencyEventType::Touch) + 1;
+
+    /**
+     * The time the snapshot was taken, in milliseconds since the epoch.
+     **/
+    qint64 timestamp = 0;
+    /**
+     * The number of times all clients were flushed, usually once per iteration of the event
+     * loop.
+     **/
+    quint64 flushCount = 0;
+    /**
+     * @see Display::bufferReleaseCount
+     **/
+    quint64 bufferReleaseCount = 0;
+    /**
+     * @see Display::coalescedBufferReleaseCount
+     **/
+    quint64 coalescedBufferReleaseCount = 0;
+    /**
+     * The message counters of all clients, see Display::setProtocolStatisticsEnabled.
+     **/
+    ProtocolStatistics protocolStatistics;
+    /**
+     * The latency of the input events sent to any client, indexed by InputLatencyEventType,
+     * see Display::setInputLatencyTrackingEnabled.
+     **/
+    std::array<InputLatencyHistogram, inputLatencyEventTypeCount> inputLatency;
+    QVector<ClientPerformanceSnapshot> clients;
+
+    /**
+     * @returns The snapshot as a map of basic types, as it is sent by the D-Bus export. The
+     * keys are the names of the members, the clients and the protocol statistics are lists
+     * of maps and each histogram is a map with its count, minimum, maximum, mean, 50th and
+     * 99th percentile and buckets.
+     *
+     * @see Display::setPerformanceDBusExportEnabled
+     **/
+    QVariantMap toVariantMap() const;
+};
+
+}
+
+#endif
@@ -0,0 +1,42 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include <QObject>
+#include <QVariantMap>
+
+namespace KWaylandServer
+{
+
+class Display;
+
+/**
+ * Exports Display::performanceSnapshot() on the session bus, so the telemetry of a compositor
+ * can be scraped with e.g. qdbus without the compositor logging it.
+ **/
+class PerformanceDBusExport : public QObject
+{
+    Q_OBJECT
+    Q_CLASSINFO("D-Bus Interface", "org.kde.KWaylandServer.Performance")
+
+public:
+    explicit PerformanceDBusExport(Display *display);
+    ~PerformanceDBusExport() override;
+
+    /**
+     * @returns @c false if the object path is taken, e.g. by another Display of the process.
+     **/
+    bool registerObject();
+
+public Q_SLOTS:
+    Q_SCRIPTABLE QVariantMap Snapshot() const;
+
+private:
+    Display *m_display;
+    bool m_registered = false;
+};
+
+} // namespace KWaylandServer
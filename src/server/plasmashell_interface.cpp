@@ -25,6 +25,7 @@ public:
 private:
     void org_kde_plasma_shell_get_surface(Resource * resource, uint32_t id, struct ::wl_resource *surface) override;
     PlasmaShellInterface *q;
+    bool commitAligned = false;
 };
 
 PlasmaShellInterfacePrivate::PlasmaShellInterfacePrivate(PlasmaShellInterface *_q, Display *display)
@@ -49,6 +50,27 @@ public:
     bool m_skipSwitcher = false;
     bool m_panelTakesFocus = false;
     bool m_visible = true;
+
+    /**
+     * The latest requested properties, applied with applyPending().
+     **/
+    struct {
+        QPoint globalPos;
+        PlasmaShellSurfaceInterface::Role role = PlasmaShellSurfaceInterface::Role::Normal;
+        PlasmaShellSurfaceInterface::PanelBehavior panelBehavior = PlasmaShellSurfaceInterface::PanelBehavior::AlwaysVisible;
+        PlasmaShellSurfaceInterface::WindowType windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION;
+        bool skipTaskbar = false;
+        bool skipSwitcher = false;
+        bool panelTakesFocus = false;
+        bool visible = true;
+    } pending;
+    PlasmaShellSurfaceInterface::Properties pendingProperties;
+    bool commitAligned = false;
+
+    void setCommitAligned();
+    void setPending(PlasmaShellSurfaceInterface::Property property);
+    void applyPending();
+
 private:
     void org_kde_plasma_surface_destroy_resource(Resource *resource) override;
     void org_kde_plasma_surface_destroy(Resource *resource) override;
@@ -76,6 +98,16 @@ PlasmaShellInterface::PlasmaShellInterface(Display *display, QObject *parent)
 
 PlasmaShellInterface::~PlasmaShellInterface() = default;
 
+void PlasmaShellInterface::setCommitAligned(bool commitAligned)
+{
+    d->commitAligned = commitAligned;
+}
+
+bool PlasmaShellInterface::isCommitAligned() const
+{
+    return d->commitAligned;
+}
+
 void PlasmaShellInterfacePrivate::org_kde_plasma_shell_get_surface(QtWaylandServer::org_kde_plasma_shell::Resource * resource, uint32_t id, struct ::wl_resource * surface)
 {
     SurfaceInterface *s = SurfaceInterface::get(surface);
@@ -86,6 +118,9 @@ void PlasmaShellInterfacePrivate::org_kde_plasma_shell_get_surface(QtWaylandServ
     wl_resource *shell_resource = wl_resource_create(resource->client(), &org_kde_plasma_surface_interface, resource->version(), id);
 
     auto shellSurface = new PlasmaShellSurfaceInterface(s, shell_resource);
+    if (commitAligned) {
+        shellSurface->d->setCommitAligned();
+    }
     emit q->surfaceCreated(shellSurface);
 }
 
@@ -99,6 +134,96 @@ PlasmaShellSurfaceInterfacePrivate::PlasmaShellSurfaceInterfacePrivate(PlasmaShe
 {
 }
 
+void PlasmaShellSurfaceInterfacePrivate::setCommitAligned()
+{
+    commitAligned = true;
+    QObject::connect(surface, &SurfaceInterface::committed, q, [this] {
+        applyPending();
+    });
+}
+
+void PlasmaShellSurfaceInterfacePrivate::setPending(PlasmaShellSurfaceInterface::Property property)
+{
+    pendingProperties |= property;
+    if (!commitAligned) {
+        applyPending();
+    }
+}
+
+void PlasmaShellSurfaceInterfacePrivate::applyPending()
+{
+    using Property = PlasmaShellSurfaceInterface::Property;
+    const PlasmaShellSurfaceInterface::Properties requested = pendingProperties;
+    pendingProperties = {};
+
+    PlasmaShellSurfaceInterface::Properties changed;
+    if (requested & Property::Position && (!m_positionSet || m_globalPos != pending.globalPos)) {
+        m_positionSet = true;
+        m_globalPos = pending.globalPos;
+        changed |= Property::Position;
+    }
+    if (requested & Property::Role && m_role != pending.role) {
+        m_role = pending.role;
+        changed |= Property::Role;
+    }
+    if (requested & Property::PanelBehavior && m_panelBehavior != pending.panelBehavior) {
+        m_panelBehavior = pending.panelBehavior;
+        changed |= Property::PanelBehavior;
+    }
+    if (requested & Property::PanelTakesFocus && m_panelTakesFocus != pending.panelTakesFocus) {
+        m_panelTakesFocus = pending.panelTakesFocus;
+        changed |= Property::PanelTakesFocus;
+    }
+    // these have always been announced for every request
+    if (requested & Property::SkipTaskbar) {
+        m_skipTaskbar = pending.skipTaskbar;
+        changed |= Property::SkipTaskbar;
+    }
+    if (requested & Property::SkipSwitcher) {
+        m_skipSwitcher = pending.skipSwitcher;
+        changed |= Property::SkipSwitcher;
+    }
+    if (requested & Property::Visible) {
+        m_visible = pending.visible;
+        changed |= Property::Visible;
+    }
+    if (requested & Property::WindowType) {
+        m_windowType = pending.windowType;
+        changed |= Property::WindowType;
+    }
+    if (!changed) {
+        return;
+    }
+
+    if (!commitAligned) {
+        if (changed & Property::Position) {
+            emit q->positionChanged();
+        }
+        if (changed & Property::Role) {
+            emit q->roleChanged();
+        }
+        if (changed & Property::PanelBehavior) {
+            emit q->panelBehaviorChanged();
+        }
+        if (changed & Property::PanelTakesFocus) {
+            emit q->panelTakesFocusChanged();
+        }
+        if (changed & Property::SkipTaskbar) {
+            emit q->skipTaskbarChanged();
+        }
+        if (changed & Property::SkipSwitcher) {
+            emit q->skipSwitcherChanged();
+        }
+        if (changed & Property::Visible) {
+            emit q->visibleChanged();
+        }
+        if (changed & Property::WindowType) {
+            emit q->windowTypeChanged();
+        }
+    }
+    emit q->propertiesChanged(changed);
+}
+
 PlasmaShellSurfaceInterface::PlasmaShellSurfaceInterface(SurfaceInterface *surface, wl_resource *resource)
     : d(new PlasmaShellSurfaceInterfacePrivate(this, surface, resource))
 {
@@ -131,13 +256,8 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_output(Resou
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_position(Resource *resource, int32_t x, int32_t y)
 {
     Q_UNUSED(resource);
-    QPoint globalPos(x, y);
-    if (m_globalPos == globalPos && m_positionSet) {
-        return;
-    }
-    m_positionSet = true;
-    m_globalPos = globalPos;
-    emit q->positionChanged();
+    pending.globalPos = QPoint(x, y);
+    setPending(PlasmaShellSurfaceInterface::Property::Position);
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_role(Resource *resource, uint32_t role)
@@ -169,11 +289,8 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_role(Resourc
         r = PlasmaShellSurfaceInterface::Role::Normal;
         break;
     }
-    if (r == m_role) {
-        return;
-    }
-    m_role = r;
-    emit q->roleChanged();
+    pending.role = r;
+    setPending(PlasmaShellSurfaceInterface::Property::Role);
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_panel_behavior(Resource *resource, uint32_t flag)
@@ -195,27 +312,24 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_panel_behavi
     default:
         break;
     }
-    if (m_panelBehavior == newBehavior) {
-        return;
-    }
-    m_panelBehavior = newBehavior;
-    emit q->panelBehaviorChanged();
+    pending.panelBehavior = newBehavior;
+    setPending(PlasmaShellSurfaceInterface::Property::PanelBehavior);
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_skip_taskbar(Resource *resource, uint32_t skip)
 {
     Q_UNUSED(resource)
 
-    m_skipTaskbar = (bool)skip;
-    emit q->skipTaskbarChanged();
+    pending.skipTaskbar = (bool)skip;
+    setPending(PlasmaShellSurfaceInterface::Property::SkipTaskbar);
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_skip_switcher(Resource *resource, uint32_t skip)
 {
     Q_UNUSED(resource)
 
-    m_skipSwitcher = (bool)skip;
-    emit q->skipSwitcherChanged();
+    pending.skipSwitcher = (bool)skip;
+    setPending(PlasmaShellSurfaceInterface::Property::SkipSwitcher);
 }
 
 // JINGOS extend protocols
@@ -223,109 +337,110 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_visible(Reso
 {
     Q_UNUSED(resource)
 
-    m_visible = (bool)visible;
-    emit q->visibleChanged();
+    pending.visible = (bool)visible;
+    setPending(PlasmaShellSurfaceInterface::Property::Visible);
 }
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_window_type(Resource *resource, uint32_t window_type)
 {
     switch (window_type) {
     case window_type_wallpaper:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_WALLPAPER;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_WALLPAPER;
         break;
     case window_type_desktop:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DESKTOP;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DESKTOP;
         break;
     case window_type_dialog:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DIALOG;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DIALOG;
         break;
     case window_type_sys_splash:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SYS_SPLASH;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SYS_SPLASH;
         break;
     case window_type_search_bar:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SEARCH_BAR;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SEARCH_BAR;
         break;
     case window_type_notification:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_NOTIFICATION;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_NOTIFICATION;
         break;
     case window_type_critical_notification:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_CRITICAL_NOTIFICATION;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_CRITICAL_NOTIFICATION;
         break;
     case window_type_input_method:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_INPUT_METHOD;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_INPUT_METHOD;
         break;
     case window_type_input_method_dialog:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_INPUT_METHOD_DIALOG;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_INPUT_METHOD_DIALOG;
         break;
     case window_type_dnd:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DND;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DND;
         break;
     case window_type_dock:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DOCK;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_DOCK;
         break;
     case window_type_application_overlay:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION_OVERLAY;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION_OVERLAY;
         break;
     case window_type_status_bar:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_STATUS_BAR;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_STATUS_BAR;
         break;
     case window_type_status_bar_panel:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_STATUS_BAR_PANEL;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_STATUS_BAR_PANEL;
         break;
     case window_type_toast:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_TOAST;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_TOAST;
         break;
     case window_type_keyguard:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_KEYGUARD;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_KEYGUARD;
         break;
     case window_type_phone:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_PHONE;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_PHONE;
         break;
     case window_type_system_dialog:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SYSTEM_DIALOG;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SYSTEM_DIALOG;
         break;
     case window_type_system_error:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SYSTEM_ERROR;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SYSTEM_ERROR;
         break;
     case window_type_voice_interaction:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_VOICE_INTERACTION;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_VOICE_INTERACTION;
         break;
     case window_type_screenshot:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SCREENSHOT;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_SCREENSHOT;
         break;
     case window_type_boot_progress:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_BOOT_PROGRESS;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_BOOT_PROGRESS;
         break;
     case window_type_pointer:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_POINTER;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_POINTER;
         break;
     case window_type_last_sys_layer:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_LAST_SYS_LAYER;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_LAST_SYS_LAYER;
         break;
     case window_type_base_application:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_BASE_APPLICATION;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_BASE_APPLICATION;
         break;
     case window_type_application:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION;
         break;
     case window_type_application_starting:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION_STARTING;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION_STARTING;
         break;
     case window_type_last_application_window:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_LAST_APPLICATION_WINDOW;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_LAST_APPLICATION_WINDOW;
         break;
     default:
-        m_windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION;
+        pending.windowType = PlasmaShellSurfaceInterface::WindowType::TYPE_APPLICATION;
         break;
 
     }
-    emit q->windowTypeChanged();
+    setPending(PlasmaShellSurfaceInterface::Property::WindowType);
 }
 // JINGOS extend protocols
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_panel_auto_hide_hide(Resource *resource)
 {
-    if (m_role != PlasmaShellSurfaceInterface::Role::Panel || (m_panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::AutoHide && m_panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::WindowsCanCover)) {
+    // checked against the requested state, which might not be committed yet
+    if (pending.role != PlasmaShellSurfaceInterface::Role::Panel || (pending.panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::AutoHide && pending.panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::WindowsCanCover)) {
         wl_resource_post_error(resource->handle, error_panel_not_auto_hide, "Not an auto hide panel");
         return;
     }
@@ -334,7 +449,7 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_panel_auto_hide_
 
 void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_panel_auto_hide_show(Resource *resource)
 {
-    if (m_role != PlasmaShellSurfaceInterface::Role::Panel || m_panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::AutoHide) {
+    if (pending.role != PlasmaShellSurfaceInterface::Role::Panel || pending.panelBehavior != PlasmaShellSurfaceInterface::PanelBehavior::AutoHide) {
         wl_resource_post_error(resource->handle, error_panel_not_auto_hide, "Not an auto hide panel");
         return;
     }
@@ -345,11 +460,8 @@ void PlasmaShellSurfaceInterfacePrivate::org_kde_plasma_surface_set_panel_takes_
 {
     Q_UNUSED(resource)
 
-    if (m_panelTakesFocus == takesFocus) {
-        return;
-    }
-    m_panelTakesFocus = takesFocus;
-    emit q->panelTakesFocusChanged();
+    pending.panelTakesFocus = takesFocus;
+    setPending(PlasmaShellSurfaceInterface::Property::PanelTakesFocus);
 }
 
 QPoint PlasmaShellSurfaceInterface::position() const
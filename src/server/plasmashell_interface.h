@@ -44,6 +44,25 @@ public:
     explicit PlasmaShellInterface(Display *display, QObject *parent);
     virtual ~PlasmaShellInterface();
 
+    /**
+     * Makes the PlasmaShellSurfaceInterfaces created from now on apply their requested
+     * properties together on the next commit of their SurfaceInterface, like double buffered
+     * surface state. Instead of one signal per property such a surface emits a single
+     * PlasmaShellSurfaceInterface::propertiesChanged for all properties changed by the commit,
+     * so a panel that gets reconfigured causes only one re-evaluation of the work area.
+     *
+     * The default of @c false applies and announces every request right away.
+     * @see PlasmaShellSurfaceInterface::propertiesChanged
+     * @since 5.22
+     **/
+    void setCommitAligned(bool commitAligned);
+    /**
+     * @returns whether new surfaces apply their properties on the next surface commit
+     * @see setCommitAligned
+     * @since 5.22
+     **/
+    bool isCommitAligned() const;
+
 Q_SIGNALS:
     /**
      * Emitted whenever a PlasmaShellSurfaceInterface got created.
@@ -199,6 +218,23 @@ public:
     };
 
     WindowType windowType() const;
+
+    /**
+     * The properties reported by propertiesChanged.
+     * @since 5.22
+     **/
+    enum class Property {
+        Position = 0x1,
+        Role = 0x2,
+        PanelBehavior = 0x4,
+        SkipTaskbar = 0x8,
+        SkipSwitcher = 0x10,
+        PanelTakesFocus = 0x20,
+        Visible = 0x40,
+        WindowType = 0x80
+    };
+    Q_DECLARE_FLAGS(Properties, Property)
+
 Q_SIGNALS:
     /**
      * A change of global position has been requested.
@@ -259,6 +295,15 @@ Q_SIGNALS:
     void panelTakesFocusChanged();
 
     void windowTypeChanged();
+    /**
+     * Emitted once the requested @p properties got applied, after the signals of the
+     * individual properties. A surface of a PlasmaShellInterface which is commit aligned
+     * emits only this signal, once per surface commit.
+     * @see PlasmaShellInterface::setCommitAligned
+     * @since 5.22
+     **/
+    void propertiesChanged(KWaylandServer::PlasmaShellSurfaceInterface::Properties properties);
+
 private:
     friend class PlasmaShellInterfacePrivate;
     explicit PlasmaShellSurfaceInterface(SurfaceInterface *surface, wl_resource *resource);
@@ -267,7 +312,9 @@ private:
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::PlasmaShellSurfaceInterface::Properties)
 Q_DECLARE_METATYPE(KWaylandServer::PlasmaShellSurfaceInterface::Role)
 Q_DECLARE_METATYPE(KWaylandServer::PlasmaShellSurfaceInterface::PanelBehavior)
+Q_DECLARE_METATYPE(KWaylandServer::PlasmaShellSurfaceInterface::Properties)
 
 #endif
@@ -0,0 +1,54 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "plasmawindowinterest_v1_interface.h"
+#include "display.h"
+#include "plasmawindowmanagement_interface.h"
+
+#include "qwayland-server-kde-plasma-window-interest-v1.h"
+
+namespace KWaylandServer
+{
+
+static const int s_version = 1;
+
+class PlasmaWindowInterestManagerV1InterfacePrivate : public QtWaylandServer::kde_plasma_window_interest_manager_v1
+{
+public:
+    explicit PlasmaWindowInterestManagerV1InterfacePrivate(Display *display);
+
+protected:
+    void kde_plasma_window_interest_manager_v1_destroy(Resource *resource) override;
+    void kde_plasma_window_interest_manager_v1_set_interest(Resource *resource, wl_resource *window_management, uint32_t properties) override;
+};
+
+PlasmaWindowInterestManagerV1InterfacePrivate::PlasmaWindowInterestManagerV1InterfacePrivate(Display *display)
+    : QtWaylandServer::kde_plasma_window_interest_manager_v1(*display, s_version)
+{
+}
+
+void PlasmaWindowInterestManagerV1InterfacePrivate::kde_plasma_window_interest_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void PlasmaWindowInterestManagerV1InterfacePrivate::kde_plasma_window_interest_manager_v1_set_interest(Resource *resource, wl_resource *window_management, uint32_t properties)
+{
+    Q_UNUSED(resource)
+    if (PlasmaWindowManagementInterface *windowManagement = PlasmaWindowManagementInterface::get(window_management)) {
+        windowManagement->setInterest(window_management, properties);
+    }
+}
+
+PlasmaWindowInterestManagerV1Interface::PlasmaWindowInterestManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new PlasmaWindowInterestManagerV1InterfacePrivate(display))
+{
+}
+
+PlasmaWindowInterestManagerV1Interface::~PlasmaWindowInterestManagerV1Interface() = default;
+
+} // namespace KWaylandServer
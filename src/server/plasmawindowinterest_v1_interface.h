@@ -0,0 +1,41 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class PlasmaWindowInterestManagerV1InterfacePrivate;
+
+/**
+ * The PlasmaWindowInterestManagerV1Interface lets the clients of a PlasmaWindowManagementInterface
+ * choose the window properties they need, the PlasmaWindowInterface objects don't send the
+ * other ones to them, neither when a client binds a window nor when the properties change.
+ *
+ * PlasmaWindowInterestManagerV1Interface corresponds to the Wayland interface
+ * @c kde_plasma_window_interest_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT PlasmaWindowInterestManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlasmaWindowInterestManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~PlasmaWindowInterestManagerV1Interface() override;
+
+private:
+    QScopedPointer<PlasmaWindowInterestManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
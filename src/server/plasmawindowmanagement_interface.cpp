@@ -4,27 +4,367 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "plasmawindowmanagement_interface.h"
+#include "clientconnection_p.h"
 #include "display.h"
 #include "logging.h"
 #include "surface_interface.h"
 #include "plasmavirtualdesktop_interface.h"
 
 #include <QtConcurrentRun>
-#include <QFile>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFutureWatcher>
 #include <QIcon>
 #include <QList>
+#include <QMap>
 #include <QVector>
 #include <QRect>
 #include <QHash>
+#include <QSet>
+#include <QSharedPointer>
+#include <QSocketNotifier>
+#include <QTimer>
 #include <QUuid>
 
 #include <qwayland-server-plasma-window-management.h>
+#include "qwayland-server-kde-plasma-window-interest-v1.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <utility>
 
 namespace KWaylandServer
 {
 
 static const quint32 s_version = 13;
 
+/**
+ * The serialized icons of the windows. Windows with the same icon share the bytes, which are
+ * serialized once on the thread pool and written to the clients without blocking.
+ *
+ * Custom icons are serialized right away, the windows don't keep their pixmaps then, and icons
+ * with the same content share the bytes even if they were created separately. Themed icons are
+ * only serialized once a client asks for them, and again once the icon theme changed.
+ *
+ * The entries are identified by a serial, never by QIcon::cacheKey(), so a window can't be
+ * handed the bytes of an icon that replaced its own. The cache key only finds the entry an
+ * icon already has: it changes whenever the content of an icon is altered, but a themed icon
+ * keeps it across a change of the icon theme.
+ */
+class PlasmaWindowIconCache : public QObject
+{
+public:
+    ~PlasmaWindowIconCache() override;
+
+    /**
+     * Adds a window using @p icon, which is identified by the returned serial from then on.
+     */
+    qint64 acquire(const QIcon &icon);
+    void release(qint64 key);
+    /**
+     * Writes the serialized icon with @p key to @p fd and closes it.
+     */
+    void send(qint64 key, int fd);
+
+private:
+    struct Entry {
+        // only until it is serialized, unless it is themed
+        QIcon icon;
+        qint64 cacheKey = 0;
+        // the icon theme a themed icon is serialized with, null for custom icons
+        QString themeName;
+        QByteArray data;
+        QByteArray hash;
+        // the fds waiting for the serialization to finish
+        QVector<int> pendingFds;
+        int windows = 0;
+        bool loading = false;
+    };
+    void load(qint64 key);
+    void write(int fd, const QByteArray &data);
+    void remove(QHash<qint64, Entry>::iterator it);
+    void releaseData(const QByteArray &hash);
+
+    QHash<qint64, Entry> m_entries;
+    // the serial of the latest entry by the QIcon::cacheKey() of its icon
+    QHash<qint64, qint64> m_serials;
+    qint64 m_lastSerial = 0;
+    // the serialized icons by the hash of their content, an icon is dropped once no entry
+    // shares its bytes anymore
+    QHash<QByteArray, QByteArray> m_data;
+};
+
+/**
+ * The app ids and themed icon names of the windows, most of them are shared by all windows of
+ * an application. A string is kept with its UTF-8 encoding as long as a window uses it.
+ */
+class PlasmaWindowStringPool
+{
+public:
+    void acquire(const QString &string, QString *shared, QByteArray *utf8)
+    {
+        if (string.isEmpty()) {
+            *shared = QString();
+            *utf8 = QByteArray();
+            return;
+        }
+        auto it = m_strings.find(string);
+        if (it == m_strings.end()) {
+            // a deep copy, the pool can't tell when literals are unused
+            it = m_strings.insert(QString(string.constData(), string.size()), string.toUtf8());
+        }
+        *shared = it.key();
+        *utf8 = it.value();
+    }
+    void release(QString *shared, QByteArray *utf8)
+    {
+        if (shared->isEmpty()) {
+            return;
+        }
+        auto it = m_strings.find(*shared);
+        *shared = QString();
+        *utf8 = QByteArray();
+        if (it != m_strings.end() && it.key().isDetached()) {
+            m_strings.erase(it);
+        }
+    }
+
+private:
+    QHash<QString, QByteArray> m_strings;
+};
+
+/**
+ * The window properties the clients are interested in, set through
+ * kde_plasma_window_interest_manager_v1. Clients which didn't set any get all properties.
+ */
+class PlasmaWindowInterests
+{
+public:
+    bool contains(wl_client *client, quint32 property) const
+    {
+        return m_interests.value(client, All) & property;
+    }
+    void set(wl_client *client, quint32 properties)
+    {
+        m_interests.insert(client, properties);
+    }
+    void remove(wl_client *client)
+    {
+        m_interests.remove(client);
+    }
+
+    enum : quint32 {
+        Title = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_TITLE,
+        AppId = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_APP_ID,
+        Pid = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_PID,
+        VirtualDesktop = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_VIRTUAL_DESKTOP,
+        State = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_STATE,
+        Icon = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_ICON,
+        Geometry = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_GEOMETRY,
+        ParentWindow = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_PARENT_WINDOW,
+        ApplicationMenu = KDE_PLASMA_WINDOW_INTEREST_MANAGER_V1_PROPERTY_APPLICATION_MENU,
+        All = ~0u
+    };
+
+private:
+    QHash<wl_client *, quint32> m_interests;
+};
+
+/**
+ * Writes an icon to the fd of a get_icon request, whenever the pipe has room for more.
+ */
+class PlasmaWindowIconWriter : public QObject
+{
+public:
+    PlasmaWindowIconWriter(int fd, const QByteArray &data, QObject *parent);
+    ~PlasmaWindowIconWriter() override;
+
+    void write();
+
+private:
+    int m_fd;
+    QByteArray m_data;
+    int m_offset = 0;
+    QSocketNotifier *m_notifier = nullptr;
+};
+
+PlasmaWindowIconWriter::PlasmaWindowIconWriter(int fd, const QByteArray &data, QObject *parent)
+    : QObject(parent)
+    , m_fd(fd)
+    , m_data(data)
+{
+    fcntl(m_fd, F_SETFL, fcntl(m_fd, F_GETFL) | O_NONBLOCK);
+}
+
+PlasmaWindowIconWriter::~PlasmaWindowIconWriter()
+{
+    close(m_fd);
+}
+
+void PlasmaWindowIconWriter::write()
+{
+    while (m_offset < m_data.size()) {
+        const ssize_t written = ::write(m_fd, m_data.constData() + m_offset, m_data.size() - m_offset);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                if (!m_notifier) {
+                    m_notifier = new QSocketNotifier(m_fd, QSocketNotifier::Write, this);
+                    connect(m_notifier, &QSocketNotifier::activated, this, &PlasmaWindowIconWriter::write);
+                }
+                return;
+            }
+            // the client closed the pipe
+            break;
+        }
+        m_offset += written;
+    }
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+    }
+    deleteLater();
+}
+
+PlasmaWindowIconCache::~PlasmaWindowIconCache()
+{
+    for (const Entry &entry : qAsConst(m_entries)) {
+        for (int fd : entry.pendingFds) {
+            close(fd);
+        }
+    }
+}
+
+qint64 PlasmaWindowIconCache::acquire(const QIcon &icon)
+{
+    const qint64 cacheKey = icon.cacheKey();
+    const QString themeName = icon.name().isEmpty() ? QString() : QIcon::themeName();
+    const auto serial = m_serials.constFind(cacheKey);
+    if (serial != m_serials.constEnd()) {
+        Entry &entry = m_entries[*serial];
+        if (entry.themeName == themeName) {
+            entry.windows++;
+            return *serial;
+        }
+    }
+    const qint64 key = ++m_lastSerial;
+    m_serials[cacheKey] = key;
+    Entry &entry = m_entries[key];
+    entry.icon = icon;
+    entry.cacheKey = cacheKey;
+    entry.themeName = themeName;
+    entry.windows = 1;
+    if (!icon.isNull() && themeName.isNull()) {
+        entry.loading = true;
+        load(key);
+    }
+    return key;
+}
+
+void PlasmaWindowIconCache::release(qint64 key)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        return;
+    }
+    // an entry being serialized is removed once the pending fds got it
+    if (--it->windows == 0 && !it->loading) {
+        remove(it);
+    }
+}
+
+void PlasmaWindowIconCache::remove(QHash<qint64, Entry>::iterator it)
+{
+    const QByteArray hash = it->hash;
+    const auto serial = m_serials.find(it->cacheKey);
+    if (serial != m_serials.end() && *serial == it.key()) {
+        m_serials.erase(serial);
+    }
+    m_entries.erase(it);
+    releaseData(hash);
+}
+
+void PlasmaWindowIconCache::releaseData(const QByteArray &hash)
+{
+    auto data = m_data.find(hash);
+    if (data != m_data.end() && data->isDetached()) {
+        m_data.erase(data);
+    }
+}
+
+void PlasmaWindowIconCache::send(qint64 key, int fd)
+{
+    auto it = m_entries.find(key);
+    if (it == m_entries.end()) {
+        close(fd);
+        return;
+    }
+    if (!it->loading && !it->themeName.isNull() && it->themeName != QIcon::themeName()) {
+        // the bytes show the icon of the previous theme
+        const QByteArray hash = std::exchange(it->hash, QByteArray());
+        it->data = QByteArray();
+        it->themeName = QIcon::themeName();
+        releaseData(hash);
+    }
+    if (!it->loading && !it->data.isNull()) {
+        write(fd, it->data);
+        return;
+    }
+    it->pendingFds.append(fd);
+    if (!it->loading) {
+        it->loading = true;
+        load(key);
+    }
+}
+
+void PlasmaWindowIconCache::load(qint64 key)
+{
+    auto watcher = new QFutureWatcher<QByteArray>(this);
+    connect(watcher, &QFutureWatcherBase::finished, this, [this, watcher, key] {
+        watcher->deleteLater();
+        auto it = m_entries.find(key);
+        Q_ASSERT(it != m_entries.end());
+        it->loading = false;
+        if (it->themeName.isNull()) {
+            it->icon = QIcon();
+        }
+        const QByteArray result = watcher->result();
+        it->hash = QCryptographicHash::hash(result, QCryptographicHash::Sha1);
+        QByteArray &shared = m_data[it->hash];
+        if (shared.isNull()) {
+            shared = result;
+        }
+        it->data = shared;
+        const QVector<int> fds = it->pendingFds;
+        it->pendingFds.clear();
+        const QByteArray data = it->data;
+        if (it->windows == 0) {
+            remove(it);
+        }
+        for (int fd : fds) {
+            write(fd, data);
+        }
+    });
+    // serializing a themed icon loads all its sizes, keep that off the compositor thread
+    watcher->setFuture(QtConcurrent::run(
+        [] (const QIcon &icon) {
+            QByteArray data;
+            QDataStream ds(&data, QIODevice::WriteOnly);
+            ds << icon;
+            return data;
+        }, m_entries.value(key).icon
+    ));
+}
+
+void PlasmaWindowIconCache::write(int fd, const QByteArray &data)
+{
+    auto writer = new PlasmaWindowIconWriter(fd, data, this);
+    writer->write();
+}
+
 class PlasmaWindowManagementInterfacePrivate : public QtWaylandServer::org_kde_plasma_window_management
 {
 public:
@@ -32,18 +372,36 @@ public:
     void sendShowingDesktopState();
     void sendStackingOrderChanged();
     void sendShowingDesktopState(wl_resource *resource);
-    void sendStackingOrderChanged(wl_resource *resource);
+    void sendStackingOrderChanged(Resource *resource, wl_array *data);
+    QByteArray stackingOrderData() const;
+    void updateStackingOrderUuids();
 
     PlasmaWindowManagementInterface::ShowingDesktopState state = PlasmaWindowManagementInterface::ShowingDesktopState::Disabled;
-    QList<PlasmaWindowInterface*> windows;
+    void removeWindow(PlasmaWindowInterface *window, quint32 windowId, const QString &uuid);
+
+    // ordered by the id, thus in the order of creation
+    QMap<quint32, PlasmaWindowInterface *> windows;
+    QHash<QString, PlasmaWindowInterface *> windowsByUuid;
     QPointer<PlasmaVirtualDesktopManagementInterface> plasmaVirtualDesktopManagementInterface = nullptr;
     quint32 windowIdCounter = 0;
+    int updateDepth = 0;
+    // the windows in the batch started by beginUpdate(), they are committed together
+    QVector<QPointer<PlasmaWindowInterface>> updatingWindows;
     QVector<quint32> stackingOrder;
-    QVector<QString> stackingOrderUuids;
+    // the ';' separated uuids of the stacking order, built once per change for all resources
+    QByteArray stackingOrderUuids;
+    // the resources which get the stacking order through kde_plasma_window_stacking_v1
+    QSet<Resource *> incrementalStackingResources;
+    // shared with the windows, which can outlive the manager
+    QSharedPointer<PlasmaWindowIconCache> iconCache = QSharedPointer<PlasmaWindowIconCache>::create();
+    QSharedPointer<PlasmaWindowStringPool> strings = QSharedPointer<PlasmaWindowStringPool>::create();
+    QSharedPointer<PlasmaWindowInterests> interests = QSharedPointer<PlasmaWindowInterests>::create();
     PlasmaWindowManagementInterface *q;
+    Display *display;
 
 protected:
     void org_kde_plasma_window_management_bind_resource(Resource *resource) override;
+    void org_kde_plasma_window_management_destroy_resource(Resource *resource) override;
     void org_kde_plasma_window_management_show_desktop(Resource *resource, uint32_t state) override;
     void org_kde_plasma_window_management_get_window(Resource *resource, uint32_t id, uint32_t internal_window_id) override;
     void org_kde_plasma_window_management_get_window_by_uuid(Resource *resource, uint32_t id, const QString &internal_window_uuid) override;
@@ -57,6 +415,7 @@ public:
 
     void setTitle(const QString &title);
     void setAppId(const QString &appId);
+    void setSharedString(QString *string, QByteArray *utf8, const QString &value);
     void setPid(quint32 pid);
     void setThemedIconName(const QString &iconName);
     void setIcon(const QIcon &icon);
@@ -67,28 +426,65 @@ public:
     void setGeometry(const QRect &geometry);
     void setApplicationMenuPaths(const QString &service, const QString &object);
     wl_resource *resourceForParent(PlasmaWindowInterface *parent, Resource *child) const;
+    void updateMemoryOwner();
+    void updateMemoryUsage();
+    void sendPendingChanges();
+    void flushGeometry();
+    void enterPlasmaVirtualDesktop(PlasmaVirtualDesktopInterface *desktop);
+    void leavePlasmaVirtualDesktop(const QString &id);
+    bool isInterested(Resource *resource, quint32 property) const;
 
     quint32 windowId = 0;
     QHash<SurfaceInterface*, QRect> minimizedGeometries;
     PlasmaWindowManagementInterface *wm;
+    Display *display = nullptr;
 
     bool unmapped = false;
     bool destroyed = false;
     PlasmaWindowInterface *parentWindow = nullptr;
     QMetaObject::Connection parentWindowDestroyConnection;
     QStringList plasmaVirtualDesktops;
+    // one per desktop of the window, removing it once its desktop is destroyed, so a desktop
+    // going away only touches its own windows
+    QHash<QString, QMetaObject::Connection> plasmaVirtualDesktopConnections;
     QRect geometry;
     PlasmaWindowInterface *q;
     QString m_title;
+    // the app id and themed icon name come from the string pool
     QString m_appId;
+    // the strings are sent to every interested resource, encoded once per change
+    QByteArray m_titleUtf8;
+    QByteArray m_appIdUtf8;
     quint32 m_pid = 0;
     QString m_themedIconName;
+    QByteArray m_themedIconNameUtf8;
     QString m_appServiceName;
     QString m_appObjectPath;
-    QIcon m_icon;
+    // the key of the icon in the icon cache, the window doesn't keep the icon itself
+    qint64 m_iconKey = 0;
+    qint64 m_iconBytes = 0;
+    QSharedPointer<PlasmaWindowIconCache> iconCache;
+    QSharedPointer<PlasmaWindowStringPool> strings;
+    QSharedPointer<PlasmaWindowInterests> interests;
     quint32 m_virtualDesktop = 0;
     quint32 m_state = 0;
     QString uuid;
+    ClientMemoryAccount memoryAccount{ClientMemoryCategory::Windows};
+    QTimer *geometryTimer = nullptr;
+    bool geometryCoalesced = false;
+    int updateDepth = 0;
+    struct {
+        bool title = false;
+        bool appId = false;
+        bool pid = false;
+        bool virtualDesktop = false;
+        bool state = false;
+        bool geometry = false;
+        bool applicationMenu = false;
+        bool plasmaVirtualDesktops = false;
+    } pendingChanges;
+    // the desktops when the batch started, the clients get the difference once it's committed
+    QStringList batchPlasmaVirtualDesktops;
 
 protected:
     void org_kde_plasma_window_bind_resource(Resource *resource) override;
@@ -110,12 +506,13 @@ protected:
 PlasmaWindowManagementInterfacePrivate::PlasmaWindowManagementInterfacePrivate(PlasmaWindowManagementInterface *_q, Display *display)
     : QtWaylandServer::org_kde_plasma_window_management(*display, s_version)
     , q(_q)
+    , display(display)
 {
 }
 
 void PlasmaWindowManagementInterfacePrivate::sendShowingDesktopState()
 {
-    const auto clientResources = resourceMap();
+    const auto clientResources = resources();
     for (auto resource : clientResources) {
         sendShowingDesktopState(resource->handle);
     }
@@ -140,39 +537,70 @@ void PlasmaWindowManagementInterfacePrivate::sendShowingDesktopState(wl_resource
 
 void PlasmaWindowManagementInterfacePrivate::sendStackingOrderChanged()
 {
-    const auto clientResources = resourceMap();
-    for (auto resource : clientResources) {
-        sendStackingOrderChanged(resource->handle);
+    // like the broadcast, converted once, but skipping the resources which only get the changes
+    const QByteArray data = stackingOrderData();
+    wl_array array;
+    array.size = data.size();
+    array.data = const_cast<char *>(data.constData());
+    array.alloc = 0;
+    const auto clientResources = resources();
+    for (Resource *resource : clientResources) {
+        sendStackingOrderChanged(resource, &array);
     }
 }
 
-void PlasmaWindowManagementInterfacePrivate::sendStackingOrderChanged(wl_resource *r)
+void PlasmaWindowManagementInterfacePrivate::sendStackingOrderChanged(Resource *resource, wl_array *data)
 {
-    if (wl_resource_get_version(r) < ORG_KDE_PLASMA_WINDOW_MANAGEMENT_STACKING_ORDER_CHANGED_SINCE_VERSION) {
+    if (incrementalStackingResources.contains(resource)) {
         return;
     }
+    if (resource->version() >= stacking_order_changed_since_version) {
+        org_kde_plasma_window_management_send_stacking_order_changed(resource->handle, data);
+    }
+    if (resource->version() >= stacking_order_uuid_changed_since_version) {
+        org_kde_plasma_window_management_send_stacking_order_uuid_changed(resource->handle, stackingOrderUuids.constData());
+    }
+}
 
-    send_stacking_order_changed(r, QByteArray::fromRawData(reinterpret_cast<const char*>(stackingOrder.constData()), sizeof(uint32_t) * stackingOrder.size()));
+QByteArray PlasmaWindowManagementInterfacePrivate::stackingOrderData() const
+{
+    return QByteArray::fromRawData(reinterpret_cast<const char*>(stackingOrder.constData()), sizeof(uint32_t) * stackingOrder.size());
+}
 
-    QString uuids;
-    for (const auto &uuid : qAsConst(stackingOrderUuids)) {
-        uuids += uuid;
-        uuids += QStringLiteral(";");
+void PlasmaWindowManagementInterfacePrivate::updateStackingOrderUuids()
+{
+    QString joined;
+    for (quint32 id : qAsConst(stackingOrder)) {
+        if (PlasmaWindowInterface *window = windows.value(id)) {
+            joined += window->d->uuid;
+        }
+        joined += QLatin1Char(';');
     }
-
-    send_stacking_order_uuid_changed(r, uuids);
+    stackingOrderUuids = joined.toUtf8();
 }
 
 void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_bind_resource(Resource *resource)
 {
     for (auto window : windows) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_MANAGEMENT_WINDOW_WITH_UUID_SINCE_VERSION) {
-            send_window_with_uuid(resource->handle, window->d->windowId, window->d->uuid);
-        } else {
+        if (!send_window_with_uuid_if_supported(resource->handle, window->d->windowId, window->d->uuid)) {
             send_window(resource->handle, window->d->windowId);
         }
     }
-    sendStackingOrderChanged(resource->handle);
+    const QByteArray data = stackingOrderData();
+    wl_array array;
+    array.size = data.size();
+    array.data = const_cast<char *>(data.constData());
+    array.alloc = 0;
+    sendStackingOrderChanged(resource, &array);
+}
+
+void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_destroy_resource(Resource *resource)
+{
+    incrementalStackingResources.remove(resource);
+    const auto clientResources = resourcesForClient(resource->client());
+    if (std::all_of(clientResources.begin(), clientResources.end(), [resource](Resource *other) { return other == resource; })) {
+        interests->remove(resource->client());
+    }
 }
 
 void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_show_desktop(Resource *resource, uint32_t state)
@@ -193,11 +621,9 @@ void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_sh
 
 void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_get_window(Resource *resource, uint32_t id, uint32_t internal_window_id)
 {
-    for (auto window : windows) {
-        if (window->d->windowId == internal_window_id) {
-            window->d->add(resource->client(), id, resource->version());
-            return;
-        }
+    if (PlasmaWindowInterface *window = windows.value(internal_window_id)) {
+        window->d->add(resource->client(), id, resource->version());
+        return;
     }
     // create a temp window just for the resource and directly send an unmapped
     PlasmaWindowInterface *window = new PlasmaWindowInterface(q, q);
@@ -207,20 +633,29 @@ void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_ge
 
 void PlasmaWindowManagementInterfacePrivate::org_kde_plasma_window_management_get_window_by_uuid(Resource *resource, uint32_t id, const QString &internal_window_uuid)
 {
-    auto it = std::find_if(windows.constBegin(), windows.constEnd(),
-        [internal_window_uuid] (PlasmaWindowInterface *window) {
-            return window->d->uuid == internal_window_uuid;
-        }
-    );
-    if (it == windows.constEnd()) {
+    PlasmaWindowInterface *window = windowsByUuid.value(internal_window_uuid);
+    if (!window) {
         qCWarning(KWAYLAND_SERVER) << "Could not find window with uuid" << internal_window_uuid;
         // create a temp window just for the resource and directly send an unmapped
-        PlasmaWindowInterface *window = new PlasmaWindowInterface(q, q);
+        window = new PlasmaWindowInterface(q, q);
         window->d->unmapped = true;
         window->d->add(resource->client(), id, resource->version());
         return;
     }
-    (*it)->d->add(resource->client(), id, resource->version());
+    window->d->add(resource->client(), id, resource->version());
+}
+
+void PlasmaWindowManagementInterfacePrivate::removeWindow(PlasmaWindowInterface *window, quint32 windowId, const QString &uuid)
+{
+    // the entries can already belong to another window, e.g. one created with the same uuid
+    auto it = windows.find(windowId);
+    if (it != windows.end() && *it == window) {
+        windows.erase(it);
+    }
+    auto uuidIt = windowsByUuid.find(uuid);
+    if (uuidIt != windowsByUuid.end() && *uuidIt == window) {
+        windowsByUuid.erase(uuidIt);
+    }
 }
 
 PlasmaWindowManagementInterface::PlasmaWindowManagementInterface(Display *display, QObject *parent)
@@ -244,29 +679,69 @@ PlasmaWindowInterface *PlasmaWindowManagementInterface::createWindow(QObject *pa
 {
     PlasmaWindowInterface *window = new PlasmaWindowInterface(this, parent);
 
+    window->d->display = d->display;
+    window->d->iconCache = d->iconCache;
+    window->d->m_iconKey = window->d->iconCache->acquire(QIcon());
+    window->d->strings = d->strings;
+    window->d->interests = d->interests;
     window->d->uuid = uuid.toString();
     window->d->windowId = ++d->windowIdCounter; //NOTE the window id is deprecated
 
-    const auto clientResources = d->resourceMap();
+    const auto clientResources = d->resources();
     for (auto resource : clientResources) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_MANAGEMENT_WINDOW_WITH_UUID_SINCE_VERSION) {
-            d->send_window_with_uuid(resource->handle, window->d->windowId, window->d->uuid);
-        } else {
+        if (!d->send_window_with_uuid_if_supported(resource->handle, window->d->windowId, window->d->uuid)) {
             d->send_window(resource->handle, window->d->windowId);
         }
     }
-    d->windows << window;
+    d->windows.insert(window->d->windowId, window);
+    d->windowsByUuid.insert(window->d->uuid, window);
+    if (d->updateDepth > 0) {
+        window->beginUpdate();
+        d->updatingWindows.append(window);
+    }
+    // the private of the window is gone once destroyed is emitted
     connect(window, &QObject::destroyed, this,
-        [this, window] {
-            d->windows.removeAll(window);
+        [this, window, windowId = window->d->windowId, uuid = window->d->uuid] {
+            d->removeWindow(window, windowId, uuid);
         }
     );
     return window;
 }
 
+void PlasmaWindowManagementInterface::beginUpdate()
+{
+    if (d->updateDepth++ > 0) {
+        return;
+    }
+    d->updatingWindows.reserve(d->windows.count());
+    for (PlasmaWindowInterface *window : qAsConst(d->windows)) {
+        window->beginUpdate();
+        d->updatingWindows.append(window);
+    }
+}
+
+void PlasmaWindowManagementInterface::commitUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth > 0) {
+        return;
+    }
+    const QVector<QPointer<PlasmaWindowInterface>> windows = std::exchange(d->updatingWindows, {});
+    for (const QPointer<PlasmaWindowInterface> &window : windows) {
+        if (window) {
+            window->commitUpdate();
+        }
+    }
+}
+
 QList<PlasmaWindowInterface*> PlasmaWindowManagementInterface::windows() const
 {
-    return d->windows;
+    return d->windows.values();
+}
+
+PlasmaWindowInterface *PlasmaWindowManagementInterface::windowByUuid(const QString &uuid) const
+{
+    return d->windowsByUuid.value(uuid);
 }
 
 void PlasmaWindowManagementInterface::unmapWindow(PlasmaWindowInterface *window)
@@ -274,8 +749,7 @@ void PlasmaWindowManagementInterface::unmapWindow(PlasmaWindowInterface *window)
     if (!window) {
         return;
     }
-    d->windows.removeOne(window);
-    Q_ASSERT(!d->windows.contains(window));
+    d->removeWindow(window, window->d->windowId, window->d->uuid);
     window->d->unmap();
 }
 
@@ -285,7 +759,76 @@ void PlasmaWindowManagementInterface::setStackingOrder(const QVector<quint32>& s
         return;
     }
     d->stackingOrder = stackingOrder;
+    d->updateStackingOrderUuids();
     d->sendStackingOrderChanged();
+    emit stackingOrderChanged();
+}
+
+QVector<quint32> PlasmaWindowManagementInterface::stackingOrder() const
+{
+    return d->stackingOrder;
+}
+
+void PlasmaWindowManagementInterface::setStackingOrderIncremental(wl_resource *resource)
+{
+    if (auto r = PlasmaWindowManagementInterfacePrivate::Resource::fromResource(resource)) {
+        d->incrementalStackingResources.insert(r);
+    }
+}
+
+void PlasmaWindowManagementInterface::setInterest(wl_resource *resource, quint32 properties)
+{
+    d->interests->set(wl_resource_get_client(resource), properties);
+}
+
+static void appendUInt(QByteArray &data, quint32 value)
+{
+    data.append(reinterpret_cast<const char *>(&value), sizeof(value));
+}
+
+static void appendString(QByteArray &data, const QString &string)
+{
+    const QByteArray utf8 = string.toUtf8();
+    appendUInt(data, utf8.size());
+    data.append(utf8);
+    // the strings are padded to the next 32 bit boundary
+    data.append((4 - utf8.size() % 4) % 4, '\0');
+}
+
+QByteArray PlasmaWindowManagementInterface::snapshot() const
+{
+    static const quint32 s_snapshotFormat = 1;
+    QByteArray data;
+    appendUInt(data, s_snapshotFormat);
+    appendUInt(data, d->windows.count());
+    for (PlasmaWindowInterface *window : qAsConst(d->windows)) {
+        const PlasmaWindowInterfacePrivate *w = window->d.data();
+        const QRect geometry = w->geometry.isValid() ? w->geometry : QRect(0, 0, 0, 0);
+        appendUInt(data, w->windowId);
+        appendUInt(data, w->m_state);
+        appendUInt(data, w->m_pid);
+        appendUInt(data, geometry.x());
+        appendUInt(data, geometry.y());
+        appendUInt(data, geometry.width());
+        appendUInt(data, geometry.height());
+        appendString(data, w->uuid);
+        appendString(data, w->m_title);
+        appendString(data, w->m_appId);
+        appendUInt(data, w->plasmaVirtualDesktops.count());
+        for (const QString &desktop : w->plasmaVirtualDesktops) {
+            appendString(data, desktop);
+        }
+    }
+    return data;
+}
+
+PlasmaWindowManagementInterface *PlasmaWindowManagementInterface::get(wl_resource *native)
+{
+    auto resource = PlasmaWindowManagementInterfacePrivate::Resource::fromResource(native);
+    if (!resource || !resource->object()) {
+        return nullptr;
+    }
+    return static_cast<PlasmaWindowManagementInterfacePrivate *>(resource->object())->q;
 }
 
 void PlasmaWindowManagementInterface::setPlasmaVirtualDesktopManagementInterface(PlasmaVirtualDesktopManagementInterface *manager)
@@ -311,8 +854,15 @@ PlasmaWindowInterfacePrivate::PlasmaWindowInterfacePrivate(PlasmaWindowManagemen
 
 PlasmaWindowInterfacePrivate::~PlasmaWindowInterfacePrivate()
 {
+    if (iconCache) {
+        iconCache->release(m_iconKey);
+    }
+    if (strings) {
+        strings->release(&m_appId, &m_appIdUtf8);
+        strings->release(&m_themedIconName, &m_themedIconNameUtf8);
+    }
     destroyed = true;
-    const auto clientResources = resourceMap();
+    const auto clientResources = resources();
     for (auto resource : clientResources) {
         if(!unmapped) {
             send_unmapped(resource->handle);
@@ -337,46 +887,55 @@ void PlasmaWindowInterfacePrivate::org_kde_plasma_window_destroy_resource(Resour
 
 void PlasmaWindowInterfacePrivate::org_kde_plasma_window_bind_resource(Resource *resource)
 {
+    if (isInterested(resource, PlasmaWindowInterests::VirtualDesktop)) {
+        send_virtual_desktop_changed(resource->handle, m_virtualDesktop);
 
-    send_virtual_desktop_changed(resource->handle, m_virtualDesktop);
-
-    for (const auto &desk : plasmaVirtualDesktops) {
-        send_virtual_desktop_entered(resource->handle, desk);
+        for (const auto &desk : plasmaVirtualDesktops) {
+            send_virtual_desktop_entered(resource->handle, desk);
+        }
     }
-    if (!m_appId.isEmpty()) {
-        send_app_id_changed(resource->handle, m_appId);
+    if (!m_appId.isEmpty() && isInterested(resource, PlasmaWindowInterests::AppId)) {
+        send_app_id_changed(resource->handle, m_appIdUtf8);
     }
-    if (m_pid != 0) {
+    if (m_pid != 0 && isInterested(resource, PlasmaWindowInterests::Pid)) {
         send_pid_changed(resource->handle, m_pid);
     }
-    if (!m_title.isEmpty()) {
-        send_title_changed(resource->handle, m_title);
+    if (!m_title.isEmpty() && isInterested(resource, PlasmaWindowInterests::Title)) {
+        send_title_changed(resource->handle, m_titleUtf8);
     }
-    if (!m_appObjectPath.isEmpty() || !m_appServiceName.isEmpty()) {
+    if ((!m_appObjectPath.isEmpty() || !m_appServiceName.isEmpty()) && isInterested(resource, PlasmaWindowInterests::ApplicationMenu)) {
         send_application_menu(resource->handle, m_appServiceName, m_appObjectPath);
     }
-    send_state_changed(resource->handle, m_state);
-    if (!m_themedIconName.isEmpty()) {
-        send_themed_icon_name_changed(resource->handle, m_themedIconName);
-    } else {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ICON_CHANGED_SINCE_VERSION) {
-            send_icon_changed(resource->handle);
+    if (isInterested(resource, PlasmaWindowInterests::State)) {
+        send_state_changed(resource->handle, m_state);
+    }
+    if (isInterested(resource, PlasmaWindowInterests::Icon)) {
+        if (!m_themedIconName.isEmpty()) {
+            send_themed_icon_name_changed(resource->handle, m_themedIconName);
+        } else {
+            send_icon_changed_if_supported(resource->handle);
         }
     }
 
-    send_parent_window(resource->handle, resourceForParent(parentWindow, resource));
+    if (isInterested(resource, PlasmaWindowInterests::ParentWindow)) {
+        send_parent_window(resource->handle, resourceForParent(parentWindow, resource));
+    }
 
     if (unmapped) {
         send_unmapped(resource->handle);
     }
 
-    if (geometry.isValid() && resource->version() >= ORG_KDE_PLASMA_WINDOW_GEOMETRY_SINCE_VERSION) {
-        send_geometry(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
+    if (geometry.isValid() && isInterested(resource, PlasmaWindowInterests::Geometry)) {
+        send_geometry_if_supported(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
     }
 
-    if (resource->version() >= ORG_KDE_PLASMA_WINDOW_INITIAL_STATE_SINCE_VERSION) {
-        send_initial_state(resource->handle);
-    }
+    send_initial_state_if_supported(resource->handle);
+}
+
+bool PlasmaWindowInterfacePrivate::isInterested(Resource *resource, quint32 property) const
+{
+    // the temporary windows for unknown ids have no interests
+    return !interests || interests->contains(resource->client(), property);
 }
 
 void PlasmaWindowInterfacePrivate::setAppId(const QString &appId)
@@ -385,12 +944,22 @@ void PlasmaWindowInterfacePrivate::setAppId(const QString &appId)
         return;
     }
 
-    m_appId = appId;
-    const auto clientResources = resourceMap();
+    setSharedString(&m_appId, &m_appIdUtf8, appId);
+    updateMemoryUsage();
+    pendingChanges.appId = true;
+    sendPendingChanges();
+}
 
-    for (auto resource : clientResources) {
-        send_app_id_changed(resource->handle,m_appId);
+void PlasmaWindowInterfacePrivate::setSharedString(QString *string, QByteArray *utf8, const QString &value)
+{
+    // windows created for unknown ids have no pool
+    if (!strings) {
+        *string = value;
+        *utf8 = value.toUtf8();
+        return;
     }
+    strings->release(string, utf8);
+    strings->acquire(value, string, utf8);
 }
 
 void PlasmaWindowInterfacePrivate::setPid(quint32 pid)
@@ -399,11 +968,9 @@ void PlasmaWindowInterfacePrivate::setPid(quint32 pid)
         return;
     }
     m_pid = pid;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_pid_changed(resource->handle,pid);
-    }
+    updateMemoryOwner();
+    pendingChanges.pid = true;
+    sendPendingChanges();
 }
 
 void PlasmaWindowInterfacePrivate::setThemedIconName(const QString &iconName)
@@ -411,40 +978,48 @@ void PlasmaWindowInterfacePrivate::setThemedIconName(const QString &iconName)
     if (m_themedIconName == iconName) {
         return;
     }
-    m_themedIconName = iconName;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_themed_icon_name_changed(resource->handle, m_themedIconName);
+    setSharedString(&m_themedIconName, &m_themedIconNameUtf8, iconName);
+    updateMemoryUsage();
+    const auto clientResources = resources();
+    for (Resource *resource : clientResources) {
+        if (isInterested(resource, PlasmaWindowInterests::Icon)) {
+            org_kde_plasma_window_send_themed_icon_name_changed(resource->handle, m_themedIconNameUtf8.constData());
+        }
     }
 }
 
 void PlasmaWindowInterfacePrivate::setIcon(const QIcon &icon)
 {
-    m_icon = icon;
-    setThemedIconName(m_icon.name());
+    if (iconCache) {
+        // acquired first, setting the same icon again keeps its serialized bytes
+        const qint64 key = iconCache->acquire(icon);
+        iconCache->release(m_iconKey);
+        m_iconKey = key;
+    }
+    m_iconBytes = 0;
+    const auto sizes = icon.availableSizes();
+    for (const QSize &size : sizes) {
+        m_iconBytes += qint64(size.width()) * size.height() * 4;
+    }
+    setThemedIconName(icon.name());
+    updateMemoryUsage();
 
-    const auto clientResources = resourceMap();
-    for (auto resource : clientResources) {
-        if (resource->version() >= ORG_KDE_PLASMA_WINDOW_ICON_CHANGED_SINCE_VERSION) {
-            send_icon_changed(resource->handle);
+    const auto clientResources = resources();
+    for (Resource *resource : clientResources) {
+        if (isInterested(resource, PlasmaWindowInterests::Icon)) {
+            send_icon_changed_if_supported(resource->handle);
         }
     }
-
 }
 
 void PlasmaWindowInterfacePrivate::org_kde_plasma_window_get_icon(Resource *resource, int32_t fd)
 {
     Q_UNUSED(resource)
-    QtConcurrent::run(
-        [fd] (const QIcon &icon) {
-            QFile file;
-            file.open(fd, QIODevice::WriteOnly, QFileDevice::AutoCloseHandle);
-            QDataStream ds(&file);
-            ds << icon;
-            file.close();
-        }, m_icon
-    );
+    if (!iconCache) {
+        close(fd);
+        return;
+    }
+    iconCache->send(m_iconKey, fd);
 }
 
 void PlasmaWindowInterfacePrivate::org_kde_plasma_window_request_enter_virtual_desktop(Resource *resource, const QString &id)
@@ -471,11 +1046,40 @@ void PlasmaWindowInterfacePrivate::setTitle(const QString &title)
         return;
     }
     m_title = title;
-    const auto clientResources = resourceMap();
+    m_titleUtf8 = title.toUtf8();
+    updateMemoryUsage();
+    pendingChanges.title = true;
+    sendPendingChanges();
+}
 
-    for (auto resource : clientResources) {
-        send_title_changed(resource->handle, m_title);
+static qint64 stringBytes(const QString &string)
+{
+    return string.size() * qint64(sizeof(QChar));
+}
+
+void PlasmaWindowInterfacePrivate::updateMemoryOwner()
+{
+    // the window is announced by the compositor, the memory is charged to the client
+    // whose process it belongs to; only looked up when the pid changes, the other setters
+    // are called far more often
+    ClientConnection *owner = nullptr;
+    if (m_pid != 0) {
+        const auto connections = display->connections();
+        for (ClientConnection *connection : connections) {
+            if (connection->processId() == pid_t(m_pid)) {
+                owner = connection;
+                break;
+            }
+        }
     }
+    memoryAccount.setClient(owner);
+}
+
+void PlasmaWindowInterfacePrivate::updateMemoryUsage()
+{
+    const qint64 bytes = stringBytes(m_title) + stringBytes(m_appId) + stringBytes(m_themedIconName)
+        + m_titleUtf8.size() + m_appIdUtf8.size() + m_themedIconNameUtf8.size() + m_iconBytes;
+    memoryAccount.setBytes(bytes);
 }
 
 void PlasmaWindowInterfacePrivate::setVirtualDesktop(quint32 desktop)
@@ -484,17 +1088,14 @@ void PlasmaWindowInterfacePrivate::setVirtualDesktop(quint32 desktop)
         return;
     }
     m_virtualDesktop = desktop;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_virtual_desktop_changed(resource->handle, m_virtualDesktop);
-    }
+    pendingChanges.virtualDesktop = true;
+    sendPendingChanges();
 }
 
 void PlasmaWindowInterfacePrivate::unmap()
 {
     unmapped = true;
-    const auto clientResources = resourceMap();
+    const auto clientResources = resources();
 
     for (auto resource : clientResources) {
         send_unmapped(resource->handle);
@@ -517,11 +1118,8 @@ void PlasmaWindowInterfacePrivate::setState(org_kde_plasma_window_management_sta
         return;
     }
     m_state = newState;
-    const auto clientResources = resourceMap();
-
-    for (auto resource : clientResources) {
-        send_state_changed(resource->handle, m_state);
-    }
+    pendingChanges.state = true;
+    sendPendingChanges();
 }
 
 wl_resource *PlasmaWindowInterfacePrivate::resourceForParent(PlasmaWindowInterface *parent, Resource *child) const
@@ -530,14 +1128,12 @@ wl_resource *PlasmaWindowInterfacePrivate::resourceForParent(PlasmaWindowInterfa
         return nullptr;
     }
 
-    const auto parentResource = parent->d->resourceMap();
-
-    for (auto resource : parentResource) {
-        if (child->client() == resource->client()) {
-            return resource->handle;
-        }
+    // the most recently bound resource of the client, like QMultiMap::value() would pick
+    const auto parentResources = parent->d->resourcesForClient(child->client());
+    if (parentResources.isEmpty()) {
+        return nullptr;
     }
-    return nullptr;
+    return parentResources.last()->handle;
 }
 
 void PlasmaWindowInterfacePrivate::setParentWindow(PlasmaWindowInterface *window)
@@ -553,16 +1149,20 @@ void PlasmaWindowInterfacePrivate::setParentWindow(PlasmaWindowInterface *window
             [this] {
                 parentWindow = nullptr;
                 parentWindowDestroyConnection = QMetaObject::Connection();
-                const auto clientResources = resourceMap();
+                const auto clientResources = resources();
                 for (auto resource : clientResources) {
-                    send_parent_window(resource->handle, nullptr);
+                    if (isInterested(resource, PlasmaWindowInterests::ParentWindow)) {
+                        send_parent_window(resource->handle, nullptr);
+                    }
                 }
             }
         );
     }
-    const auto clientResources = resourceMap();
+    const auto clientResources = resources();
     for (auto resource : clientResources) {
-        send_parent_window(resource->handle, resourceForParent(window, resource));
+        if (isInterested(resource, PlasmaWindowInterests::ParentWindow)) {
+            send_parent_window(resource->handle, resourceForParent(window, resource));
+        }
     }
 }
 
@@ -575,13 +1175,75 @@ void PlasmaWindowInterfacePrivate::setGeometry(const QRect &geo)
     if (!geometry.isValid()) {
         return;
     }
+    if (geometryTimer && geometryTimer->isActive()) {
+        geometryCoalesced = true;
+        return;
+    }
+    pendingChanges.geometry = true;
+    sendPendingChanges();
+    if (geometryTimer) {
+        geometryTimer->start();
+    }
+}
+
+void PlasmaWindowInterfacePrivate::enterPlasmaVirtualDesktop(PlasmaVirtualDesktopInterface *desktop)
+{
+    const QString id = desktop->id();
+    if (updateDepth > 0 && !pendingChanges.plasmaVirtualDesktops) {
+        pendingChanges.plasmaVirtualDesktops = true;
+        batchPlasmaVirtualDesktops = plasmaVirtualDesktops;
+    }
+    plasmaVirtualDesktops << id;
+    //if the desktop dies, remove it from or list
+    plasmaVirtualDesktopConnections.insert(id, QObject::connect(desktop, &QObject::destroyed, q, [this, id] {
+        q->removePlasmaVirtualDesktop(id);
+    }));
+    if (updateDepth > 0) {
+        return;
+    }
 
-    const auto clientResources = resourceMap();
+    const auto clientResources = resources();
     for (auto resource : clientResources) {
-        if (resource->version() < ORG_KDE_PLASMA_WINDOW_GEOMETRY_SINCE_VERSION) {
-            continue;
+        if (isInterested(resource, PlasmaWindowInterests::VirtualDesktop)) {
+            send_virtual_desktop_entered(resource->handle, id);
         }
-        send_geometry(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
+    }
+}
+
+void PlasmaWindowInterfacePrivate::leavePlasmaVirtualDesktop(const QString &id)
+{
+    if (updateDepth > 0 && !pendingChanges.plasmaVirtualDesktops) {
+        pendingChanges.plasmaVirtualDesktops = true;
+        batchPlasmaVirtualDesktops = plasmaVirtualDesktops;
+    }
+    QObject::disconnect(plasmaVirtualDesktopConnections.take(id));
+    plasmaVirtualDesktops.removeOne(id);
+    if (updateDepth > 0) {
+        return;
+    }
+
+    const auto clientResources = resources();
+    for (auto resource : clientResources) {
+        if (isInterested(resource, PlasmaWindowInterests::VirtualDesktop)) {
+            send_virtual_desktop_left(resource->handle, id);
+        }
+    }
+}
+
+void PlasmaWindowInterfacePrivate::flushGeometry()
+{
+    if (!geometryCoalesced) {
+        return;
+    }
+    geometryCoalesced = false;
+    if (!geometry.isValid()) {
+        return;
+    }
+    pendingChanges.geometry = true;
+    sendPendingChanges();
+    if (geometryTimer) {
+        // the window restarts, so a move is sent at the chosen rate
+        geometryTimer->start();
     }
 }
 
@@ -592,13 +1254,72 @@ void PlasmaWindowInterfacePrivate::setApplicationMenuPaths(const QString &servic
     }
     m_appServiceName = service;
     m_appObjectPath = object;
-    const auto clientResources = resourceMap();
-    for (auto resource : clientResources) {
-        if (resource->version() < ORG_KDE_PLASMA_WINDOW_APPLICATION_MENU_SINCE_VERSION) {
-            continue;
+    pendingChanges.applicationMenu = true;
+    sendPendingChanges();
+}
+
+void PlasmaWindowInterfacePrivate::sendPendingChanges()
+{
+    if (updateDepth > 0) {
+        return;
+    }
+    // all changes of a batch go out back to back per resource, the strings are converted once
+    const QByteArray serviceName = pendingChanges.applicationMenu ? m_appServiceName.toUtf8() : QByteArray();
+    const QByteArray objectPath = pendingChanges.applicationMenu ? m_appObjectPath.toUtf8() : QByteArray();
+    // a geometry which got invalid again within the batch is not sent, like outside of it
+    const bool sendGeometry = pendingChanges.geometry && geometry.isValid();
+    // a desktop left and entered again within the batch is not sent at all
+    QVector<QByteArray> leftDesktops;
+    QVector<QByteArray> enteredDesktops;
+    if (pendingChanges.plasmaVirtualDesktops) {
+        for (const QString &id : qAsConst(batchPlasmaVirtualDesktops)) {
+            if (!plasmaVirtualDesktops.contains(id)) {
+                leftDesktops << id.toUtf8();
+            }
+        }
+        for (const QString &id : qAsConst(plasmaVirtualDesktops)) {
+            if (!batchPlasmaVirtualDesktops.contains(id)) {
+                enteredDesktops << id.toUtf8();
+            }
+        }
+        batchPlasmaVirtualDesktops.clear();
+    }
+
+    const auto clientResources = resources();
+    for (Resource *resource : clientResources) {
+        const int version = resource->version();
+        if (pendingChanges.title && isInterested(resource, PlasmaWindowInterests::Title)) {
+            send_title_changed(resource->handle, m_titleUtf8);
+        }
+        if (pendingChanges.appId && isInterested(resource, PlasmaWindowInterests::AppId)) {
+            send_app_id_changed(resource->handle, m_appIdUtf8);
+        }
+        if (pendingChanges.pid && version >= pid_changed_since_version && isInterested(resource, PlasmaWindowInterests::Pid)) {
+            org_kde_plasma_window_send_pid_changed(resource->handle, m_pid);
+        }
+        if (pendingChanges.virtualDesktop && isInterested(resource, PlasmaWindowInterests::VirtualDesktop)) {
+            org_kde_plasma_window_send_virtual_desktop_changed(resource->handle, m_virtualDesktop);
+        }
+        if (pendingChanges.state && isInterested(resource, PlasmaWindowInterests::State)) {
+            org_kde_plasma_window_send_state_changed(resource->handle, m_state);
+        }
+        if (sendGeometry && version >= geometry_since_version && isInterested(resource, PlasmaWindowInterests::Geometry)) {
+            org_kde_plasma_window_send_geometry(resource->handle, geometry.x(), geometry.y(), geometry.width(), geometry.height());
+        }
+        if (pendingChanges.applicationMenu && version >= application_menu_since_version
+                && isInterested(resource, PlasmaWindowInterests::ApplicationMenu)) {
+            org_kde_plasma_window_send_application_menu(resource->handle, serviceName.constData(), objectPath.constData());
+        }
+        if ((!leftDesktops.isEmpty() || !enteredDesktops.isEmpty()) && isInterested(resource, PlasmaWindowInterests::VirtualDesktop)) {
+            for (const QByteArray &id : qAsConst(leftDesktops)) {
+                send_virtual_desktop_left(resource->handle, id);
+            }
+            for (const QByteArray &id : qAsConst(enteredDesktops)) {
+                send_virtual_desktop_entered(resource->handle, id);
+            }
         }
-        send_application_menu(resource->handle, service, object);
     }
+    pendingChanges = {};
 }
 
 void PlasmaWindowInterfacePrivate::org_kde_plasma_window_close(Resource *resource)
@@ -749,6 +1470,19 @@ void PlasmaWindowInterface::setVirtualDesktop(quint32 desktop)
     d->setVirtualDesktop(desktop);
 }
 
+void PlasmaWindowInterface::beginUpdate()
+{
+    d->updateDepth++;
+}
+
+void PlasmaWindowInterface::commitUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth == 0) {
+        d->sendPendingChanges();
+    }
+}
+
 void PlasmaWindowInterface::unmap()
 {
     d->wm->unmapWindow(this);
@@ -797,30 +1531,24 @@ void PlasmaWindowInterface::setOnAllDesktops(bool set)
     if (!d->wm->plasmaVirtualDesktopManagementInterface()) {
         return;
     }
-    const auto clientResources = d->resourceMap();
     //the current vd management
     if (set) {
         if (d->plasmaVirtualDesktops.isEmpty()) {
             return;
         }
         //leaving everything means on all desktops
-        for (auto desk : plasmaVirtualDesktops()) {
-            for (auto resource : clientResources) {
-                d->send_virtual_desktop_left(resource->handle, desk);
-            }
+        const QStringList desktops = d->plasmaVirtualDesktops;
+        for (const QString &desk : desktops) {
+            d->leavePlasmaVirtualDesktop(desk);
         }
-        d->plasmaVirtualDesktops.clear();
     } else {
         if (!d->plasmaVirtualDesktops.isEmpty()) {
             return;
         }
         //enters the desktops which are active (usually only one  but not a given)
         for (auto desk : d->wm->plasmaVirtualDesktopManagementInterface()->desktops()) {
-            if (desk->isActive() && !d->plasmaVirtualDesktops.contains(desk->id())) {
-                d->plasmaVirtualDesktops << desk->id();
-                for (auto resource : clientResources) {
-                    d->send_virtual_desktop_entered(resource->handle, desk->id());
-                }
+            if (desk->isActive() && !d->plasmaVirtualDesktopConnections.contains(desk->id())) {
+                d->enterPlasmaVirtualDesktop(desk);
             }
         }
     }
@@ -874,7 +1602,7 @@ void PlasmaWindowInterface::setIcon(const QIcon &icon)
 void PlasmaWindowInterface::addPlasmaVirtualDesktop(const QString &id)
 {
     //don't add a desktop we're not sure it exists
-    if (!d->wm->plasmaVirtualDesktopManagementInterface() || d->plasmaVirtualDesktops.contains(id)) {
+    if (!d->wm->plasmaVirtualDesktopManagementInterface() || d->plasmaVirtualDesktopConnections.contains(id)) {
         return;
     }
 
@@ -884,30 +1612,16 @@ void PlasmaWindowInterface::addPlasmaVirtualDesktop(const QString &id)
         return;
     }
 
-    d->plasmaVirtualDesktops << id;
-
-    //if the desktop dies, remove it from or list
-    connect(desktop, &QObject::destroyed,
-            this, [this, id](){removePlasmaVirtualDesktop(id);});
-
-
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        d->send_virtual_desktop_entered(resource->handle, id);
-    }
+    d->enterPlasmaVirtualDesktop(desktop);
 }
 
 void PlasmaWindowInterface::removePlasmaVirtualDesktop(const QString &id)
 {
-    if (!d->plasmaVirtualDesktops.contains(id)) {
+    if (!d->plasmaVirtualDesktopConnections.contains(id)) {
         return;
     }
 
-    d->plasmaVirtualDesktops.removeAll(id);
-    const auto clientResources = d->resourceMap();
-    for (auto resource : clientResources) {
-        d->send_virtual_desktop_left(resource->handle, id);
-    }
+    d->leavePlasmaVirtualDesktop(id);
 
     //we went on all desktops
     if (d->plasmaVirtualDesktops.isEmpty()) {
@@ -955,6 +1669,27 @@ void PlasmaWindowInterface::setGeometry(const QRect &geometry)
     d->setGeometry(geometry);
 }
 
+void PlasmaWindowInterface::setGeometryUpdateInterval(int msec)
+{
+    if (msec <= 0) {
+        delete d->geometryTimer;
+        d->geometryTimer = nullptr;
+        d->flushGeometry();
+        return;
+    }
+    if (!d->geometryTimer) {
+        d->geometryTimer = new QTimer(this);
+        d->geometryTimer->setSingleShot(true);
+        connect(d->geometryTimer, &QTimer::timeout, this, [this] { d->flushGeometry(); });
+    }
+    d->geometryTimer->setInterval(msec);
+}
+
+int PlasmaWindowInterface::geometryUpdateInterval() const
+{
+    return d->geometryTimer ? d->geometryTimer->interval() : 0;
+}
+
 void PlasmaWindowInterface::setApplicationMenuPaths(const QString &serviceName, const QString &objectPath)
 {
     d->setApplicationMenuPaths(serviceName, objectPath);
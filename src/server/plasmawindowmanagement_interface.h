@@ -11,6 +11,7 @@
 #include <KWaylandServer/kwaylandserver_export.h>
 
 class QSize;
+struct wl_resource;
 
 namespace KWaylandServer
 {
@@ -40,6 +41,28 @@ public:
 
     PlasmaWindowInterface *createWindow(QObject *parent, const QUuid &uuid);
     QList<PlasmaWindowInterface*> windows() const;
+    /**
+     * @returns the window created with @p uuid, as returned by PlasmaWindowInterface::uuid(),
+     * or @c nullptr if there is none. A hash lookup, unlike searching windows().
+     * @since 5.22
+     **/
+    PlasmaWindowInterface *windowByUuid(const QString &uuid) const;
+
+    /**
+     * Starts a batch of changes to all windows, like PlasmaWindowInterface::beginUpdate() does
+     * for a single window. Windows created during the batch are part of it. Switching virtual
+     * desktops within a batch sends each client the desktops a window left and entered once
+     * per window, so pagers update once per switch.
+     *
+     * Calls can be nested, the changes are sent by the outermost commitUpdate().
+     * @since 5.22
+     **/
+    void beginUpdate();
+    /**
+     * Ends the batch started by beginUpdate() and sends the changes of all windows.
+     * @since 5.22
+     **/
+    void commitUpdate();
 
     /**
      * Unmaps the @p window previously created with {@link createWindow}.
@@ -78,9 +101,51 @@ public:
      * @since 5.70
      */
     void setStackingOrder(const QVector<quint32> &stackingOrder);
+    /**
+     * @returns the stacking order set with setStackingOrder
+     * @since 5.22
+     **/
+    QVector<quint32> stackingOrder() const;
+
+    /**
+     * Stops sending the full stacking order to @p resource, its client gets the changes
+     * through PlasmaWindowStackingManagerV1Interface instead.
+     * @internal
+     * @since 5.22
+     **/
+    void setStackingOrderIncremental(wl_resource *resource);
+
+    /**
+     * Sends only the window @p properties, a combination of the
+     * kde_plasma_window_interest_manager_v1 property bits, to the client of @p resource.
+     * @internal
+     * @since 5.22
+     **/
+    void setInterest(wl_resource *resource, quint32 properties);
+
+    /**
+     * @returns the windows serialized in the layout of the kde_plasma_window_snapshot_v1
+     * interface
+     * @internal
+     * @since 5.22
+     **/
+    QByteArray snapshot() const;
+
+    /**
+     * @returns the PlasmaWindowManagementInterface for the @p native resource
+     * @internal
+     * @since 5.22
+     **/
+    static PlasmaWindowManagementInterface *get(wl_resource *native);
 
 Q_SIGNALS:
     void requestChangeShowingDesktop(ShowingDesktopState requestedState);
+    /**
+     * Emitted when the stacking order changed.
+     * @see setStackingOrder
+     * @since 5.22
+     **/
+    void stackingOrderChanged();
 
 private:
     QScopedPointer<PlasmaWindowManagementInterfacePrivate> d;
@@ -179,6 +244,24 @@ public:
      * @since 5.25
      **/
     void setGeometry(const QRect &geometry);
+    /**
+     * Sets the minimum interval in milliseconds between two geometry events sent to the
+     * clients, e.g. the refresh interval of the output while the window is interactively
+     * moved or resized. Changes within the interval are coalesced, the clients get the latest
+     * geometry once it elapsed.
+     *
+     * Setting the interval back to the default of @c 0 sends a coalesced geometry right away,
+     * so the compositor can reset it when the move ends to get the final geometry out.
+     * @see setGeometry
+     * @since 5.22
+     **/
+    void setGeometryUpdateInterval(int msec);
+    /**
+     * @returns the minimum interval between two geometry events, @c 0 if not limited
+     * @see setGeometryUpdateInterval
+     * @since 5.22
+     **/
+    int geometryUpdateInterval() const;
 
     /**
      * Set the icon of the PlasmaWindowInterface.
@@ -224,6 +307,24 @@ public:
      */
     void setApplicationMenuPaths(const QString &serviceName, const QString &objectPath);
 
+    /**
+     * Starts a batch of changes. The title, app id, pid, virtual desktop, state, geometry and
+     * application menu changes made until the matching commitUpdate() are sent to each client
+     * together, with one event per property, so that e.g. a window rule setting several states
+     * results in a single state_changed event. Of the Plasma virtual desktops only the ones
+     * the window actually left or entered during the batch are sent.
+     *
+     * Calls can be nested, the changes are sent by the outermost commitUpdate().
+     * @see OutputInterface::beginUpdate
+     * @since 5.22
+     **/
+    void beginUpdate();
+    /**
+     * Ends the batch started by beginUpdate() and sends the changed properties to the clients.
+     * @since 5.22
+     **/
+    void commitUpdate();
+
     /**
      * Return the window internal id
      *
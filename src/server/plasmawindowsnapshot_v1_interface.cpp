@@ -0,0 +1,96 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "plasmawindowsnapshot_v1_interface.h"
+#include "anonymousfile_p.h"
+#include "display.h"
+#include "logging.h"
+#include "plasmawindowmanagement_interface.h"
+
+#include "qwayland-server-kde-plasma-window-snapshot-v1.h"
+
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+static const int s_version = 1;
+
+class PlasmaWindowSnapshotV1Interface : public QtWaylandServer::kde_plasma_window_snapshot_v1
+{
+public:
+    PlasmaWindowSnapshotV1Interface(wl_client *client, uint32_t id, int version);
+
+protected:
+    void kde_plasma_window_snapshot_v1_destroy_resource(Resource *resource) override;
+    void kde_plasma_window_snapshot_v1_destroy(Resource *resource) override;
+};
+
+PlasmaWindowSnapshotV1Interface::PlasmaWindowSnapshotV1Interface(wl_client *client, uint32_t id, int version)
+    : QtWaylandServer::kde_plasma_window_snapshot_v1(client, id, version)
+{
+}
+
+void PlasmaWindowSnapshotV1Interface::kde_plasma_window_snapshot_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void PlasmaWindowSnapshotV1Interface::kde_plasma_window_snapshot_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+class PlasmaWindowSnapshotManagerV1InterfacePrivate : public QtWaylandServer::kde_plasma_window_snapshot_manager_v1
+{
+public:
+    explicit PlasmaWindowSnapshotManagerV1InterfacePrivate(Display *display);
+
+protected:
+    void kde_plasma_window_snapshot_manager_v1_destroy(Resource *resource) override;
+    void kde_plasma_window_snapshot_manager_v1_get_snapshot(Resource *resource, uint32_t id, wl_resource *window_management) override;
+};
+
+PlasmaWindowSnapshotManagerV1InterfacePrivate::PlasmaWindowSnapshotManagerV1InterfacePrivate(Display *display)
+    : QtWaylandServer::kde_plasma_window_snapshot_manager_v1(*display, s_version)
+{
+}
+
+void PlasmaWindowSnapshotManagerV1InterfacePrivate::kde_plasma_window_snapshot_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void PlasmaWindowSnapshotManagerV1InterfacePrivate::kde_plasma_window_snapshot_manager_v1_get_snapshot(Resource *resource, uint32_t id, wl_resource *window_management)
+{
+    auto snapshot = new PlasmaWindowSnapshotV1Interface(resource->client(), id, resource->version());
+    PlasmaWindowManagementInterface *windowManagement = PlasmaWindowManagementInterface::get(window_management);
+    if (!windowManagement) {
+        snapshot->send_failed();
+        return;
+    }
+    const QByteArray content = windowManagement->snapshot();
+    const int fd = AnonymousFile::createReadOnly("kwaylandserver-window-snapshot", content);
+    if (fd < 0) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create a file for the window snapshot";
+        snapshot->send_failed();
+        return;
+    }
+    snapshot->send_snapshot(fd, content.size());
+    // the descriptor is duplicated into the message
+    close(fd);
+}
+
+PlasmaWindowSnapshotManagerV1Interface::PlasmaWindowSnapshotManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new PlasmaWindowSnapshotManagerV1InterfacePrivate(display))
+{
+}
+
+PlasmaWindowSnapshotManagerV1Interface::~PlasmaWindowSnapshotManagerV1Interface() = default;
+
+} // namespace KWaylandServer
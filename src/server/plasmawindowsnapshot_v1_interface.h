@@ -0,0 +1,41 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class PlasmaWindowSnapshotManagerV1InterfacePrivate;
+
+/**
+ * The PlasmaWindowSnapshotManagerV1Interface hands the windows of a PlasmaWindowManagementInterface
+ * to a client in one piece of read-only shared memory, so that a task manager starting with
+ * many windows open doesn't need a message for every window property.
+ *
+ * PlasmaWindowSnapshotManagerV1Interface corresponds to the Wayland interface
+ * @c kde_plasma_window_snapshot_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT PlasmaWindowSnapshotManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlasmaWindowSnapshotManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~PlasmaWindowSnapshotManagerV1Interface() override;
+
+private:
+    QScopedPointer<PlasmaWindowSnapshotManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,228 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "plasmawindowstacking_v1_interface.h"
+#include "display.h"
+#include "plasmawindowmanagement_interface.h"
+
+#include "qwayland-server-kde-plasma-window-stacking-v1.h"
+
+#include <QHash>
+#include <QPointer>
+#include <QVector>
+
+#include <algorithm>
+
+namespace KWaylandServer
+{
+
+static const int s_version = 1;
+
+struct StackingOperation
+{
+    quint32 window;
+    // the window below, 0 for the bottom, unused for a removal
+    quint32 previous;
+    bool remove;
+};
+
+/**
+ * Computes the operations turning @p from into @p to. The longest run of windows which keep
+ * their relative order stays in place, all other windows are placed above their new neighbour.
+ * Raising a single window thus results in a single operation.
+ */
+static QVector<StackingOperation> stackingOperations(const QVector<quint32> &from, const QVector<quint32> &to)
+{
+    QVector<StackingOperation> operations;
+
+    QHash<quint32, int> fromPositions;
+    fromPositions.reserve(from.size());
+    for (int i = 0; i < from.size(); ++i) {
+        fromPositions.insert(from[i], i);
+    }
+    QHash<quint32, int> toPositions;
+    toPositions.reserve(to.size());
+    for (int i = 0; i < to.size(); ++i) {
+        toPositions.insert(to[i], i);
+    }
+    for (quint32 window : from) {
+        if (!toPositions.contains(window)) {
+            operations.append({window, 0, true});
+        }
+    }
+
+    // the old positions of the windows which remain, in the new order
+    QVector<int> positions;
+    QVector<int> indices;
+    for (int i = 0; i < to.size(); ++i) {
+        auto it = fromPositions.constFind(to[i]);
+        if (it != fromPositions.constEnd()) {
+            positions.append(*it);
+            indices.append(i);
+        }
+    }
+
+    // longest increasing subsequence of the old positions
+    QVector<int> tails;
+    QVector<int> predecessors(positions.size(), -1);
+    for (int k = 0; k < positions.size(); ++k) {
+        auto it = std::lower_bound(tails.begin(), tails.end(), positions[k], [&positions](int tail, int position) {
+            return positions[tail] < position;
+        });
+        const int length = it - tails.begin();
+        if (length > 0) {
+            predecessors[k] = tails[length - 1];
+        }
+        if (length == tails.size()) {
+            tails.append(k);
+        } else {
+            tails[length] = k;
+        }
+    }
+    QVector<bool> kept(to.size(), false);
+    for (int k = tails.isEmpty() ? -1 : tails.last(); k >= 0; k = predecessors[k]) {
+        kept[indices[k]] = true;
+    }
+
+    for (int i = 0; i < to.size(); ++i) {
+        if (!kept[i]) {
+            operations.append({to[i], i > 0 ? to[i - 1] : 0, false});
+        }
+    }
+    return operations;
+}
+
+/**
+ * The stacking order of one window management, shared by the resources of all clients.
+ */
+class PlasmaWindowStackingV1Interface : public QObject, public QtWaylandServer::kde_plasma_window_stacking_v1
+{
+public:
+    explicit PlasmaWindowStackingV1Interface(PlasmaWindowManagementInterface *windowManagement, QObject *parent);
+
+    void addResource(Resource *managerResource, uint32_t id, wl_resource *windowManagementResource);
+
+protected:
+    void kde_plasma_window_stacking_v1_bind_resource(Resource *resource) override;
+    void kde_plasma_window_stacking_v1_destroy(Resource *resource) override;
+
+private:
+    void update();
+
+    QPointer<PlasmaWindowManagementInterface> m_windowManagement;
+    QVector<quint32> m_stackingOrder;
+};
+
+PlasmaWindowStackingV1Interface::PlasmaWindowStackingV1Interface(PlasmaWindowManagementInterface *windowManagement, QObject *parent)
+    : QObject(parent)
+    , m_windowManagement(windowManagement)
+{
+    if (windowManagement) {
+        m_stackingOrder = windowManagement->stackingOrder();
+        connect(windowManagement, &PlasmaWindowManagementInterface::stackingOrderChanged, this, &PlasmaWindowStackingV1Interface::update);
+    }
+}
+
+void PlasmaWindowStackingV1Interface::addResource(Resource *managerResource, uint32_t id, wl_resource *windowManagementResource)
+{
+    if (m_windowManagement) {
+        m_windowManagement->setStackingOrderIncremental(windowManagementResource);
+    }
+    add(managerResource->client(), id, managerResource->version());
+}
+
+void PlasmaWindowStackingV1Interface::update()
+{
+    const QVector<quint32> stackingOrder = m_windowManagement->stackingOrder();
+    const QVector<StackingOperation> operations = stackingOperations(m_stackingOrder, stackingOrder);
+    m_stackingOrder = stackingOrder;
+    if (operations.isEmpty()) {
+        return;
+    }
+    const auto clientResources = resourceMap();
+    for (Resource *resource : clientResources) {
+        for (const StackingOperation &operation : operations) {
+            if (operation.remove) {
+                send_remove(resource->handle, operation.window);
+            } else {
+                send_place(resource->handle, operation.window, operation.previous);
+            }
+        }
+        send_done(resource->handle);
+    }
+}
+
+void PlasmaWindowStackingV1Interface::kde_plasma_window_stacking_v1_bind_resource(Resource *resource)
+{
+    quint32 previous = 0;
+    for (quint32 window : qAsConst(m_stackingOrder)) {
+        send_place(resource->handle, window, previous);
+        previous = window;
+    }
+    send_done(resource->handle);
+}
+
+void PlasmaWindowStackingV1Interface::kde_plasma_window_stacking_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+class PlasmaWindowStackingManagerV1InterfacePrivate : public QtWaylandServer::kde_plasma_window_stacking_manager_v1
+{
+public:
+    PlasmaWindowStackingManagerV1InterfacePrivate(PlasmaWindowStackingManagerV1Interface *q, Display *display);
+
+    PlasmaWindowStackingManagerV1Interface *q;
+    QHash<PlasmaWindowManagementInterface *, PlasmaWindowStackingV1Interface *> stackings;
+    // for the requests on a window management which is already gone
+    PlasmaWindowStackingV1Interface *inert = nullptr;
+
+protected:
+    void kde_plasma_window_stacking_manager_v1_destroy(Resource *resource) override;
+    void kde_plasma_window_stacking_manager_v1_get_stacking(Resource *resource, uint32_t id, wl_resource *window_management) override;
+};
+
+PlasmaWindowStackingManagerV1InterfacePrivate::PlasmaWindowStackingManagerV1InterfacePrivate(PlasmaWindowStackingManagerV1Interface *q, Display *display)
+    : QtWaylandServer::kde_plasma_window_stacking_manager_v1(*display, s_version)
+    , q(q)
+{
+}
+
+void PlasmaWindowStackingManagerV1InterfacePrivate::kde_plasma_window_stacking_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void PlasmaWindowStackingManagerV1InterfacePrivate::kde_plasma_window_stacking_manager_v1_get_stacking(Resource *resource, uint32_t id, wl_resource *window_management)
+{
+    PlasmaWindowManagementInterface *windowManagement = PlasmaWindowManagementInterface::get(window_management);
+    if (!windowManagement) {
+        if (!inert) {
+            inert = new PlasmaWindowStackingV1Interface(nullptr, q);
+        }
+        inert->addResource(resource, id, window_management);
+        return;
+    }
+    PlasmaWindowStackingV1Interface *stacking = stackings.value(windowManagement);
+    if (!stacking) {
+        stacking = new PlasmaWindowStackingV1Interface(windowManagement, q);
+        stackings.insert(windowManagement, stacking);
+        QObject::connect(windowManagement, &QObject::destroyed, q, [this, windowManagement] {
+            delete stackings.take(windowManagement);
+        });
+    }
+    stacking->addResource(resource, id, window_management);
+}
+
+PlasmaWindowStackingManagerV1Interface::PlasmaWindowStackingManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new PlasmaWindowStackingManagerV1InterfacePrivate(this, display))
+{
+}
+
+PlasmaWindowStackingManagerV1Interface::~PlasmaWindowStackingManagerV1Interface() = default;
+
+} // namespace KWaylandServer
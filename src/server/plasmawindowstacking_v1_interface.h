@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class PlasmaWindowStackingManagerV1InterfacePrivate;
+
+/**
+ * The PlasmaWindowStackingManagerV1Interface sends the stacking order of a
+ * PlasmaWindowManagementInterface as a sequence of changes.
+ *
+ * When a window is raised, the clients using it are told about that window only, not about the
+ * whole stacking order. The changes are computed once per PlasmaWindowManagementInterface::setStackingOrder()
+ * for all clients.
+ *
+ * PlasmaWindowStackingManagerV1Interface corresponds to the Wayland interface
+ * @c kde_plasma_window_stacking_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT PlasmaWindowStackingManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlasmaWindowStackingManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~PlasmaWindowStackingManagerV1Interface() override;
+
+private:
+    QScopedPointer<PlasmaWindowStackingManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
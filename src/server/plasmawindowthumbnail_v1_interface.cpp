@@ -0,0 +1,264 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "plasmawindowthumbnail_v1_interface.h"
+#include "display.h"
+#include "eventlooptimer_p.h"
+#include "logging.h"
+#include "plasmawindowmanagement_interface.h"
+
+#include "qwayland-server-kde-plasma-window-thumbnail-v1.h"
+
+#include <QPointer>
+
+#include <climits>
+
+namespace KWaylandServer
+{
+
+static const int s_version = 1;
+static const int s_defaultMaximumRate = 15;
+// one frame shown by the client and one it can switch to
+static const int s_maximumHeldFrames = 2;
+
+class PlasmaWindowThumbnailManagerV1InterfacePrivate : public QtWaylandServer::kde_plasma_window_thumbnail_manager_v1
+{
+public:
+    PlasmaWindowThumbnailManagerV1InterfacePrivate(PlasmaWindowThumbnailManagerV1Interface *q, Display *display);
+
+    PlasmaWindowThumbnailManagerV1Interface *q;
+    Display *display;
+    int maximumRate = s_defaultMaximumRate;
+
+protected:
+    void kde_plasma_window_thumbnail_manager_v1_destroy(Resource *resource) override;
+    void kde_plasma_window_thumbnail_manager_v1_get_thumbnail(Resource *resource, uint32_t id, wl_resource *window_management,
+                                                              const QString &uuid, uint32_t max_width, uint32_t max_height,
+                                                              uint32_t max_rate) override;
+};
+
+class PlasmaWindowThumbnailV1InterfacePrivate : public QtWaylandServer::kde_plasma_window_thumbnail_v1
+{
+public:
+    PlasmaWindowThumbnailV1InterfacePrivate(PlasmaWindowThumbnailV1Interface *q, Display *display, wl_client *client, uint32_t id, int version);
+
+    void maybeRequestFrame();
+    int maximumRate() const;
+
+    PlasmaWindowThumbnailV1Interface *q;
+    QPointer<PlasmaWindowThumbnailManagerV1Interface> manager;
+    QPointer<PlasmaWindowInterface> window;
+    QSize maximumSize;
+    int clientMaximumRate = 0;
+    // the frames are requested no more often than the rate from the Wayland event loop
+    EventLoopTimer rateTimer;
+    QVector<quint32> heldFrames;
+    quint32 serial = 0;
+    bool damaged = false;
+    bool frameRequested = false;
+    bool closed = false;
+
+protected:
+    void kde_plasma_window_thumbnail_v1_destroy_resource(Resource *resource) override;
+    void kde_plasma_window_thumbnail_v1_destroy(Resource *resource) override;
+    void kde_plasma_window_thumbnail_v1_release(Resource *resource, uint32_t serial) override;
+};
+
+PlasmaWindowThumbnailManagerV1InterfacePrivate::PlasmaWindowThumbnailManagerV1InterfacePrivate(PlasmaWindowThumbnailManagerV1Interface *q, Display *display)
+    : QtWaylandServer::kde_plasma_window_thumbnail_manager_v1(*display, s_version)
+    , q(q)
+    , display(display)
+{
+}
+
+void PlasmaWindowThumbnailManagerV1InterfacePrivate::kde_plasma_window_thumbnail_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void PlasmaWindowThumbnailManagerV1InterfacePrivate::kde_plasma_window_thumbnail_manager_v1_get_thumbnail(Resource *resource, uint32_t id,
+                                                                                                          wl_resource *window_management,
+                                                                                                          const QString &uuid, uint32_t max_width,
+                                                                                                          uint32_t max_height, uint32_t max_rate)
+{
+    PlasmaWindowManagementInterface *windowManagement = PlasmaWindowManagementInterface::get(window_management);
+    PlasmaWindowInterface *window = windowManagement ? windowManagement->windowByUuid(uuid) : nullptr;
+    const QSize maximumSize(qMin(max_width, uint32_t(INT_MAX)), qMin(max_height, uint32_t(INT_MAX)));
+    auto thumbnail = new PlasmaWindowThumbnailV1Interface(q, display, window, maximumSize, qMin(max_rate, uint32_t(INT_MAX)),
+                                                          resource->client(), id, resource->version());
+    if (!window) {
+        qCWarning(KWAYLAND_SERVER) << "Could not find window with uuid" << uuid << "for a thumbnail";
+        thumbnail->close();
+        return;
+    }
+    emit q->thumbnailCreated(thumbnail);
+    // the first frame
+    thumbnail->markDamaged();
+}
+
+PlasmaWindowThumbnailManagerV1Interface::PlasmaWindowThumbnailManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new PlasmaWindowThumbnailManagerV1InterfacePrivate(this, display))
+{
+}
+
+PlasmaWindowThumbnailManagerV1Interface::~PlasmaWindowThumbnailManagerV1Interface() = default;
+
+void PlasmaWindowThumbnailManagerV1Interface::setMaximumRate(int rate)
+{
+    d->maximumRate = rate;
+}
+
+int PlasmaWindowThumbnailManagerV1Interface::maximumRate() const
+{
+    return d->maximumRate;
+}
+
+PlasmaWindowThumbnailV1InterfacePrivate::PlasmaWindowThumbnailV1InterfacePrivate(PlasmaWindowThumbnailV1Interface *q, Display *display,
+                                                                                  wl_client *client, uint32_t id, int version)
+    : QtWaylandServer::kde_plasma_window_thumbnail_v1(client, id, version)
+    , q(q)
+    , rateTimer(display)
+{
+    rateTimer.setCallback([this]() {
+        maybeRequestFrame();
+    });
+}
+
+int PlasmaWindowThumbnailV1InterfacePrivate::maximumRate() const
+{
+    const int compositorRate = manager ? manager->maximumRate() : s_defaultMaximumRate;
+    if (compositorRate <= 0) {
+        return clientMaximumRate;
+    }
+    if (clientMaximumRate <= 0) {
+        return compositorRate;
+    }
+    return qMin(compositorRate, clientMaximumRate);
+}
+
+void PlasmaWindowThumbnailV1InterfacePrivate::maybeRequestFrame()
+{
+    if (closed || !damaged || frameRequested || rateTimer.isActive() || heldFrames.count() >= s_maximumHeldFrames) {
+        return;
+    }
+    damaged = false;
+    frameRequested = true;
+    emit q->frameRequested();
+}
+
+void PlasmaWindowThumbnailV1InterfacePrivate::kde_plasma_window_thumbnail_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    closed = true;
+    const QVector<quint32> frames = std::exchange(heldFrames, {});
+    for (quint32 frame : frames) {
+        emit q->frameReleased(frame);
+    }
+    delete q;
+}
+
+void PlasmaWindowThumbnailV1InterfacePrivate::kde_plasma_window_thumbnail_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void PlasmaWindowThumbnailV1InterfacePrivate::kde_plasma_window_thumbnail_v1_release(Resource *resource, uint32_t serial)
+{
+    if (!heldFrames.removeOne(serial)) {
+        wl_resource_post_error(resource->handle, error_invalid_serial, "no frame with serial %u is held", serial);
+        return;
+    }
+    emit q->frameReleased(serial);
+    maybeRequestFrame();
+}
+
+PlasmaWindowThumbnailV1Interface::PlasmaWindowThumbnailV1Interface(PlasmaWindowThumbnailManagerV1Interface *manager, Display *display,
+                                                                   PlasmaWindowInterface *window, const QSize &maximumSize, int maximumRate,
+                                                                   wl_client *client, uint32_t id, int version)
+    : d(new PlasmaWindowThumbnailV1InterfacePrivate(this, display, client, id, version))
+{
+    d->manager = manager;
+    d->window = window;
+    d->maximumSize = maximumSize;
+    d->clientMaximumRate = maximumRate;
+    if (window) {
+        connect(window, &QObject::destroyed, this, &PlasmaWindowThumbnailV1Interface::close);
+    }
+}
+
+PlasmaWindowThumbnailV1Interface::~PlasmaWindowThumbnailV1Interface() = default;
+
+PlasmaWindowInterface *PlasmaWindowThumbnailV1Interface::window() const
+{
+    return d->window;
+}
+
+QSize PlasmaWindowThumbnailV1Interface::maximumSize() const
+{
+    return d->maximumSize;
+}
+
+int PlasmaWindowThumbnailV1Interface::maximumRate() const
+{
+    return d->maximumRate();
+}
+
+QSize PlasmaWindowThumbnailV1Interface::frameSize(const QSize &windowSize) const
+{
+    if (windowSize.isEmpty() || (windowSize.width() <= d->maximumSize.width() && windowSize.height() <= d->maximumSize.height())) {
+        return windowSize;
+    }
+    // never scaled down to nothing, a thumbnail of a very wide window gets at least a line
+    return windowSize.scaled(d->maximumSize, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+}
+
+void PlasmaWindowThumbnailV1Interface::markDamaged()
+{
+    d->damaged = true;
+    d->maybeRequestFrame();
+}
+
+quint32 PlasmaWindowThumbnailV1Interface::sendFrame(const QVector<LinuxDmabufUnstableV1Interface::Plane> &planes, uint32_t format, const QSize &size)
+{
+    d->frameRequested = false;
+    if (d->closed || planes.isEmpty()) {
+        return 0;
+    }
+    if (++d->serial == 0) {
+        ++d->serial;
+    }
+    const quint64 modifier = planes.first().modifier;
+    d->send_frame(d->serial, size.width(), size.height(), format, modifier >> 32, modifier & 0xffffffff, planes.count());
+    for (int i = 0; i < planes.count(); ++i) {
+        d->send_plane(i, planes[i].fd, planes[i].offset, planes[i].stride);
+    }
+    d->send_done();
+    d->heldFrames.append(d->serial);
+
+    const int rate = maximumRate();
+    if (rate > 0) {
+        d->rateTimer.start(qMax(1000 / rate, 1));
+    }
+    return d->serial;
+}
+
+void PlasmaWindowThumbnailV1Interface::close()
+{
+    if (d->closed) {
+        return;
+    }
+    d->closed = true;
+    d->rateTimer.stop();
+    d->send_closed();
+}
+
+bool PlasmaWindowThumbnailV1Interface::isClosed() const
+{
+    return d->closed;
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,143 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "linuxdmabuf_v1_interface.h"
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+#include <QSize>
+#include <QVector>
+
+struct wl_client;
+
+namespace KWaylandServer
+{
+
+class Display;
+class PlasmaWindowInterface;
+class PlasmaWindowThumbnailManagerV1InterfacePrivate;
+class PlasmaWindowThumbnailV1InterfacePrivate;
+
+/**
+ * The PlasmaWindowThumbnailManagerV1Interface lets task switchers and task managers show live
+ * previews of the windows of a PlasmaWindowManagementInterface, without a full resolution
+ * screencast per window. The compositor renders scaled down copies of a window into dmabufs
+ * and sends them with PlasmaWindowThumbnailV1Interface::sendFrame().
+ *
+ * PlasmaWindowThumbnailManagerV1Interface corresponds to the Wayland interface
+ * @c kde_plasma_window_thumbnail_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT PlasmaWindowThumbnailManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PlasmaWindowThumbnailManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~PlasmaWindowThumbnailManagerV1Interface() override;
+
+    /**
+     * Sets the highest number of frames per second a thumbnail gets, whatever its client asks
+     * for. The default is @c 15, a value of @c 0 or less doesn't limit the rate.
+     */
+    void setMaximumRate(int rate);
+    int maximumRate() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when a client asked for a @p thumbnail of a window. The compositor should connect
+     * to PlasmaWindowThumbnailV1Interface::frameRequested before returning, the first frame is
+     * requested right after this signal.
+     */
+    void thumbnailCreated(KWaylandServer::PlasmaWindowThumbnailV1Interface *thumbnail);
+
+private:
+    QScopedPointer<PlasmaWindowThumbnailManagerV1InterfacePrivate> d;
+};
+
+/**
+ * A live thumbnail of a PlasmaWindowInterface. Frames are only requested after the window
+ * was damaged, see markDamaged(), at most at the rate of the thumbnail and only while the
+ * client holds fewer than two frames it didn't release yet. The compositor answers every
+ * frameRequested() with sendFrame(), or with close() if it can't render the window.
+ *
+ * The thumbnail is destroyed with its resource, all frames are released then.
+ *
+ * PlasmaWindowThumbnailV1Interface corresponds to the Wayland interface
+ * @c kde_plasma_window_thumbnail_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT PlasmaWindowThumbnailV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    ~PlasmaWindowThumbnailV1Interface() override;
+
+    /**
+     * @returns the window of the thumbnail, @c nullptr once it is destroyed
+     */
+    PlasmaWindowInterface *window() const;
+    /**
+     * @returns the size the frames have to fit into
+     */
+    QSize maximumSize() const;
+    /**
+     * @returns the highest number of frames per second, the lower one of the rate the client
+     * asked for and PlasmaWindowThumbnailManagerV1Interface::maximumRate(), @c 0 if neither
+     * limits it
+     */
+    int maximumRate() const;
+    /**
+     * @returns the size of a frame for a window of @p windowSize, scaled down to fit into the
+     * maximumSize() with the same aspect ratio
+     */
+    QSize frameSize(const QSize &windowSize) const;
+
+    /**
+     * Tells the thumbnail the content of the window changed, a new frame is requested once the
+     * rate and the frames held by the client allow.
+     */
+    void markDamaged();
+    /**
+     * Sends a frame in the dmabuf of @p planes with @p format and @p size, which should be
+     * frameSize() of the window. The file descriptors are duplicated, the dmabuf must not be
+     * rendered into again before frameReleased() is emitted with the returned serial.
+     *
+     * @returns the serial of the frame, @c 0 if the thumbnail is closed
+     */
+    quint32 sendFrame(const QVector<LinuxDmabufUnstableV1Interface::Plane> &planes, uint32_t format, const QSize &size);
+    /**
+     * Tells the client that no more frames are sent, e.g. because the window is unmapped.
+     * Done automatically when the window is destroyed.
+     */
+    void close();
+    bool isClosed() const;
+
+Q_SIGNALS:
+    /**
+     * Emitted when the compositor should render the window and call sendFrame().
+     */
+    void frameRequested();
+    /**
+     * Emitted when the client is done with the frame with @p serial, its dmabuf can be reused.
+     */
+    void frameReleased(quint32 serial);
+
+private:
+    PlasmaWindowThumbnailV1Interface(PlasmaWindowThumbnailManagerV1Interface *manager, Display *display,
+                                     PlasmaWindowInterface *window, const QSize &maximumSize, int maximumRate,
+                                     wl_client *client, uint32_t id, int version);
+    QScopedPointer<PlasmaWindowThumbnailV1InterfacePrivate> d;
+    friend class PlasmaWindowThumbnailManagerV1InterfacePrivate;
+};
+
+} // namespace KWaylandServer
@@ -5,11 +5,14 @@
 */
 #include "pointer_interface.h"
 #include "pointer_interface_p.h"
+#include "buffer_interface.h"
 #include "pointerconstraints_v1_interface.h"
 #include "pointergestures_v1_interface_p.h"
 #include "resource_p.h"
 #include "relativepointer_v1_interface_p.h"
 #include "seat_interface.h"
+#include "seat_interface_p.h"
+#include "shmconversion_p.h"
 #include "display.h"
 #include "subcompositor_interface.h"
 #include "surface_interface.h"
@@ -28,11 +31,16 @@ public:
     quint32 enteredSerial = 0;
     QPoint hotspot;
     QPointer<SurfaceInterface> surface;
+    QString shape;
+    quint64 imageKey = 0;
 
-    void update(const QPointer<SurfaceInterface> &surface, quint32 serial, const QPoint &hotspot);
+    void update(const QPointer<SurfaceInterface> &surface, quint32 serial, const QPoint &hotspot,
+                const QString &shape = QString());
 
 private:
-    qreal oldScale = 1.;
+    void handleDamage();
+
+    QMetaObject::Connection damagedConnection;
     Cursor *q;
 };
 
@@ -55,6 +63,19 @@ void PointerInterface::Private::setCursor(quint32 serial, SurfaceInterface *surf
     }
 }
 
+void PointerInterface::Private::setCursorShape(quint32 serial, const QString &shape)
+{
+    if (!cursor) {
+        Q_Q(PointerInterface);
+        cursor = new Cursor(q);
+        cursor->d->update(QPointer<SurfaceInterface>(), serial, QPoint(), shape);
+        QObject::connect(cursor, &Cursor::changed, q, &PointerInterface::cursorChanged);
+        emit q->cursorChanged();
+    } else {
+        cursor->d->update(QPointer<SurfaceInterface>(), serial, QPoint(), shape);
+    }
+}
+
 void PointerInterface::Private::sendLeave(SurfaceInterface *surface, quint32 serial)
 {
     if (!surface) {
@@ -194,9 +215,151 @@ void PointerInterface::Private::sendFrame()
     if (!resource || wl_resource_get_version(resource) < WL_POINTER_FRAME_SINCE_VERSION) {
         return;
     }
+    if (seat->d_func()->inInputFrame) {
+        addToInputFrame();
+        inputFramePending = true;
+        return;
+    }
     wl_pointer_send_frame(resource);
 }
 
+void PointerInterface::Private::sendMotion(const QPointF &position, quint32 time)
+{
+    seat->d_func()->pointerMotionCount++;
+    wl_pointer_send_motion(resource, time, wl_fixed_from_double(position.x()), wl_fixed_from_double(position.y()));
+}
+
+void PointerInterface::Private::sendAxisSource(PointerAxisSource source)
+{
+    if (source == PointerAxisSource::Unknown || wl_resource_get_version(resource) < WL_POINTER_AXIS_SOURCE_SINCE_VERSION) {
+        return;
+    }
+    wl_pointer_axis_source wlSource;
+    switch (source) {
+    case PointerAxisSource::Wheel:
+        wlSource = WL_POINTER_AXIS_SOURCE_WHEEL;
+        break;
+    case PointerAxisSource::Finger:
+        wlSource = WL_POINTER_AXIS_SOURCE_FINGER;
+        break;
+    case PointerAxisSource::Continuous:
+        wlSource = WL_POINTER_AXIS_SOURCE_CONTINUOUS;
+        break;
+    case PointerAxisSource::WheelTilt:
+        wlSource = WL_POINTER_AXIS_SOURCE_WHEEL_TILT;
+        break;
+    default:
+        Q_UNREACHABLE();
+        break;
+    }
+    wl_pointer_send_axis_source(resource, wlSource);
+}
+
+void PointerInterface::Private::sendAxis(Qt::Orientation orientation, qreal delta, qint32 discreteDelta, quint32 time)
+{
+    const quint32 version = wl_resource_get_version(resource);
+    const auto wlOrientation = (orientation == Qt::Vertical)
+        ? WL_POINTER_AXIS_VERTICAL_SCROLL
+        : WL_POINTER_AXIS_HORIZONTAL_SCROLL;
+    if (delta != 0.0) {
+        if (discreteDelta && version >= WL_POINTER_AXIS_DISCRETE_SINCE_VERSION) {
+            wl_pointer_send_axis_discrete(resource, wlOrientation, discreteDelta);
+        }
+        wl_pointer_send_axis(resource, time, wlOrientation, wl_fixed_from_double(delta));
+    } else if (version >= WL_POINTER_AXIS_STOP_SINCE_VERSION) {
+        wl_pointer_send_axis_stop(resource, time, wlOrientation);
+    }
+}
+
+void PointerInterface::Private::sendAxes(const QPointF &delta, const QPoint &discreteDelta, PointerAxisSource source, quint32 time)
+{
+    sendAxisSource(source);
+    const bool stop = delta.x() == 0.0 && delta.y() == 0.0;
+    if (stop || delta.y() != 0.0) {
+        sendAxis(Qt::Vertical, delta.y(), discreteDelta.y(), time);
+    }
+    if (stop || delta.x() != 0.0) {
+        sendAxis(Qt::Horizontal, delta.x(), discreteDelta.x(), time);
+    }
+}
+
+bool PointerInterface::Private::sendPendingAxis()
+{
+    hasPendingAxis = false;
+    if (!resource) {
+        return false;
+    }
+    if (pendingAxisDelta.x() == 0.0 && pendingAxisDelta.y() == 0.0) {
+        // the merged scroll cancelled out, which is no stop
+        return false;
+    }
+    sendAxes(pendingAxisDelta, pendingAxisDiscreteDelta, pendingAxisSource, pendingAxisTime);
+    return true;
+}
+
+void PointerInterface::Private::flushPendingAxis()
+{
+    if (!hasPendingAxis) {
+        return;
+    }
+    if (sendPendingAxis()) {
+        sendFrame();
+    }
+}
+
+void PointerInterface::Private::flushPendingMotion()
+{
+    // the scroll was merged before the motion happened
+    flushPendingAxis();
+    if (!hasPendingMotion) {
+        return;
+    }
+    hasPendingMotion = false;
+    if (!resource) {
+        return;
+    }
+    sendMotion(pendingMotionPosition, pendingMotionTime);
+    sendFrame();
+}
+
+void PointerInterface::Private::flushDecongestedMotion()
+{
+    if (!hasPendingMotion && !hasPendingAxis) {
+        return;
+    }
+    if (seat->d_func()->inInputFrame) {
+        // sent by endInputFrame() or the flush of the Display with the rest of the frame
+        addToInputFrame();
+        return;
+    }
+    flushPendingMotion();
+    client->flush();
+}
+
+void PointerInterface::Private::addToInputFrame()
+{
+    if (inInputFrame || !seat->d_func()->inInputFrame) {
+        return;
+    }
+    inInputFrame = true;
+    seat->d_func()->inputFramePointers.append(QPointer<PointerInterface>(q_func()));
+}
+
+void PointerInterface::Private::endInputFrame()
+{
+    inInputFrame = false;
+    if (hasPendingAxis && sendPendingAxis()) {
+        // shares the frame event with the motion below
+        inputFramePending = true;
+    }
+    if (hasPendingMotion && !seat->isPointerMotionCoalescingEnabled() && !client->isCongested()) {
+        flushPendingMotion();
+    } else if (inputFramePending) {
+        sendFrame();
+    }
+    inputFramePending = false;
+}
+
 #ifndef K_DOXYGEN
 const struct wl_pointer_interface PointerInterface::Private::s_interface = {
     setCursorCallback,
@@ -230,6 +393,7 @@ PointerInterface::PointerInterface(SeatInterface *parent, wl_resource *parentRes
             targetSurface = d->focusedSurface;
         }
         if (targetSurface != d->focusedChildSurface.data()) {
+            d->flushPendingMotion();
             const quint32 serial = d->seat->display()->nextSerial();
             d->sendLeave(d->focusedChildSurface.data(), serial);
             d->focusedChildSurface = QPointer<SurfaceInterface>(targetSurface);
@@ -238,9 +402,18 @@ PointerInterface::PointerInterface(SeatInterface *parent, wl_resource *parentRes
             d->client->flush();
         } else {
             const QPointF adjustedPos = pos - surfacePosition(d->focusedChildSurface);
-            wl_pointer_send_motion(d->resource, d->seat->timestamp(),
-                                   wl_fixed_from_double(adjustedPos.x()), wl_fixed_from_double(adjustedPos.y()));
-            d->sendFrame();
+            if (d->seat->isPointerMotionCoalescingEnabled() || d->seat->d_func()->inInputFrame || d->client->isCongested()) {
+                if (d->hasPendingMotion) {
+                    d->seat->d_func()->coalescedPointerMotionCount++;
+                }
+                d->addToInputFrame();
+                d->hasPendingMotion = true;
+                d->pendingMotionPosition = adjustedPos;
+                d->pendingMotionTime = d->seat->timestamp();
+            } else {
+                d->sendMotion(adjustedPos, d->seat->timestamp());
+                d->sendFrame();
+            }
         }
     });
 }
@@ -250,6 +423,7 @@ PointerInterface::~PointerInterface() = default;
 void PointerInterface::setFocusedSurface(SurfaceInterface *surface, quint32 serial)
 {
     Q_D();
+    d->flushPendingMotion();
     d->sendLeave(d->focusedChildSurface.data(), serial);
     disconnect(d->destroyConnection);
     if (!surface) {
@@ -261,6 +435,9 @@ void PointerInterface::setFocusedSurface(SurfaceInterface *surface, quint32 seri
     d->destroyConnection = connect(d->focusedSurface, &SurfaceInterface::aboutToBeDestroyed, this,
         [this] {
             Q_D();
+            // the motion and the scroll were relative to the destroyed surface
+            d->hasPendingMotion = false;
+            d->hasPendingAxis = false;
             d->sendLeave(d->focusedChildSurface.data(), d->global->display()->nextSerial());
             d->sendFrame();
             d->focusedSurface = nullptr;
@@ -284,6 +461,7 @@ void PointerInterface::buttonPressed(quint32 button, quint32 serial)
     if (!d->resource) {
         return;
     }
+    d->flushPendingMotion();
     wl_pointer_send_button(d->resource, serial, d->seat->timestamp(), button, WL_POINTER_BUTTON_STATE_PRESSED);
     d->sendFrame();
 }
@@ -295,6 +473,7 @@ void PointerInterface::buttonReleased(quint32 button, quint32 serial)
     if (!d->resource) {
         return;
     }
+    d->flushPendingMotion();
     wl_pointer_send_button(d->resource, serial, d->seat->timestamp(), button, WL_POINTER_BUTTON_STATE_RELEASED);
     d->sendFrame();
 }
@@ -306,44 +485,39 @@ void PointerInterface::axis(Qt::Orientation orientation, qreal delta, qint32 dis
     if (!d->resource) {
         return;
     }
+    d->flushPendingMotion();
+    d->sendAxisSource(source);
+    d->sendAxis(orientation, delta, discreteDelta, d->seat->timestamp());
+    d->sendFrame();
+}
 
-    const quint32 version = wl_resource_get_version(d->resource);
-
-    const auto wlOrientation = (orientation == Qt::Vertical)
-        ? WL_POINTER_AXIS_VERTICAL_SCROLL
-        : WL_POINTER_AXIS_HORIZONTAL_SCROLL;
-
-    if (source != PointerAxisSource::Unknown && version >= WL_POINTER_AXIS_SOURCE_SINCE_VERSION) {
-        wl_pointer_axis_source wlSource;
-        switch (source) {
-        case PointerAxisSource::Wheel:
-            wlSource = WL_POINTER_AXIS_SOURCE_WHEEL;
-            break;
-        case PointerAxisSource::Finger:
-            wlSource = WL_POINTER_AXIS_SOURCE_FINGER;
-            break;
-        case PointerAxisSource::Continuous:
-            wlSource = WL_POINTER_AXIS_SOURCE_CONTINUOUS;
-            break;
-        case PointerAxisSource::WheelTilt:
-            wlSource = WL_POINTER_AXIS_SOURCE_WHEEL_TILT;
-            break;
-        default:
-            Q_UNREACHABLE();
-            break;
-        }
-        wl_pointer_send_axis_source(d->resource, wlSource);
+void PointerInterface::axis(const QPointF &delta, const QPoint &discreteDelta, PointerAxisSource source)
+{
+    Q_D();
+    Q_ASSERT(d->focusedSurface);
+    if (!d->resource) {
+        return;
     }
-
-    if (delta != 0.0) {
-        if (discreteDelta && version >= WL_POINTER_AXIS_DISCRETE_SINCE_VERSION) {
-            wl_pointer_send_axis_discrete(d->resource, wlOrientation, discreteDelta);
+    const bool stop = delta.x() == 0.0 && delta.y() == 0.0;
+    if (d->seat->d_func()->inInputFrame && !stop) {
+        // a motion in between keeps the scroll before and after it apart
+        if (d->hasPendingMotion || (d->hasPendingAxis && d->pendingAxisSource != source)) {
+            d->flushPendingMotion();
         }
-        wl_pointer_send_axis(d->resource, d->seat->timestamp(), wlOrientation, wl_fixed_from_double(delta));
-    } else if (version >= WL_POINTER_AXIS_STOP_SINCE_VERSION) {
-        wl_pointer_send_axis_stop(d->resource, d->seat->timestamp(), wlOrientation);
+        if (!d->hasPendingAxis) {
+            d->addToInputFrame();
+            d->hasPendingAxis = true;
+            d->pendingAxisDelta = QPointF();
+            d->pendingAxisDiscreteDelta = QPoint();
+            d->pendingAxisSource = source;
+        }
+        d->pendingAxisDelta += delta;
+        d->pendingAxisDiscreteDelta += discreteDelta;
+        d->pendingAxisTime = d->seat->timestamp();
+        return;
     }
-
+    d->flushPendingMotion();
+    d->sendAxes(delta, discreteDelta, source, d->seat->timestamp());
     d->sendFrame();
 }
 
@@ -354,6 +528,7 @@ void PointerInterface::axis(Qt::Orientation orientation, quint32 delta)
     if (!d->resource) {
         return;
     }
+    d->flushPendingMotion();
     wl_pointer_send_axis(d->resource, d->seat->timestamp(),
                          (orientation == Qt::Vertical) ? WL_POINTER_AXIS_VERTICAL_SCROLL : WL_POINTER_AXIS_HORIZONTAL_SCROLL,
                          wl_fixed_from_int(delta));
@@ -380,6 +555,7 @@ void PointerInterface::relativeMotion(const QSizeF &delta, const QSizeF &deltaNo
     if (d->relativePointersV1.isEmpty()) {
         return;
     }
+    d->flushPendingMotion();
     for (RelativePointerV1Interface *relativePointer : qAsConst(d->relativePointersV1)) {
         relativePointer->send_relative_motion(microseconds >> 32, microseconds & 0xffffffff,
                                               wl_fixed_from_double(delta.width()),
@@ -406,7 +582,45 @@ Cursor::Private::Private(Cursor *q, PointerInterface *pointer)
 {
 }
 
-void Cursor::Private::update(const QPointer< SurfaceInterface > &s, quint32 serial, const QPoint &p)
+// A key for the pixels of the shm buffer attached to @p surface, 0 if there is none. Two hashes
+// with different seeds make up the key, so that different images practically never share one.
+static quint64 cursorImageKey(SurfaceInterface *surface)
+{
+    BufferInterface *buffer = surface ? surface->buffer() : nullptr;
+    if (!buffer || !buffer->shmBuffer()) {
+        return 0;
+    }
+    const uint32_t format = wl_shm_buffer_get_format(buffer->shmBuffer());
+    const int bytesPerPixel = ShmConversion::bytesPerPixel(format);
+    if (bytesPerPixel == 0) {
+        return 0;
+    }
+    const QSize size = buffer->size();
+    uint low = qHash((quint64(size.width()) << 32) | quint64(size.height()), format);
+    uint high = qHash(low, 0x9e3779b9u);
+    const bool mapped = buffer->forEachSpan(QRect(QPoint(0, 0), size), [&](const QRect &span, const uchar *bits) {
+        const size_t length = size_t(span.width()) * bytesPerPixel;
+        low = qHashBits(bits, length, low);
+        high = qHashBits(bits, length, high);
+    });
+    if (!mapped) {
+        return 0;
+    }
+    return (quint64(high) << 32) | low;
+}
+
+void Cursor::Private::handleDamage()
+{
+    const quint64 key = cursorImageKey(surface);
+    if (key != 0 && key == imageKey) {
+        // the client committed the same image again, whatever the compositor made of it is still valid
+        return;
+    }
+    imageKey = key;
+    emit q->changed();
+}
+
+void Cursor::Private::update(const QPointer< SurfaceInterface > &s, quint32 serial, const QPoint &p, const QString &newShape)
 {
     bool emitChanged = false;
     if (enteredSerial != serial) {
@@ -420,16 +634,22 @@ void Cursor::Private::update(const QPointer< SurfaceInterface > &s, quint32 seri
         emit q->hotspotChanged();
     }
     if (surface != s) {
-        if (!surface.isNull()) {
-            QObject::disconnect(surface.data(), &SurfaceInterface::damaged, q, &Cursor::changed);
-        }
+        QObject::disconnect(damagedConnection);
         surface = s;
         if (!surface.isNull()) {
-            QObject::connect(surface.data(), &SurfaceInterface::damaged, q, &Cursor::changed);
+            damagedConnection = QObject::connect(surface.data(), &SurfaceInterface::damaged, q, [this] {
+                handleDamage();
+            });
         }
+        imageKey = cursorImageKey(surface);
         emitChanged = true;
         emit q->surfaceChanged();
     }
+    if (shape != newShape) {
+        shape = newShape;
+        emitChanged = true;
+        emit q->shapeChanged();
+    }
     if (emitChanged) {
         emit q->changed();
     }
@@ -463,4 +683,14 @@ QPointer< SurfaceInterface > Cursor::surface() const
     return d->surface;
 }
 
+QString Cursor::shape() const
+{
+    return d->shape;
+}
+
+quint64 Cursor::imageKey() const
+{
+    return d->imageKey;
+}
+
 }
@@ -59,11 +59,13 @@ private:
     void buttonReleased(quint32 button, quint32 serial);
     void axis(Qt::Orientation orientation, qreal delta, qint32 discreteDelta, PointerAxisSource source);
     void axis(Qt::Orientation orientation, quint32 delta);
+    void axis(const QPointF &delta, const QPoint &discreteDelta, PointerAxisSource source);
     void relativeMotion(const QSizeF &delta, const QSizeF &deltaNonAccelerated, quint64 microseconds);
     friend class SeatInterface;
     friend class RelativePointerV1Interface;
     friend class PointerPinchGestureV1Interface;
     friend class PointerSwipeGestureV1Interface;
+    friend class CursorShapeDeviceV1Interface;
     explicit PointerInterface(SeatInterface *parent, wl_resource *parentResource);
     class Private;
     Private *d_func() const;
@@ -95,11 +97,40 @@ public:
      * The SurfaceInterface for the image content of the Cursor.
      **/
     QPointer<SurfaceInterface> surface() const;
+    /**
+     * The name of the cursor shape the client set with the cursor shape protocol, e.g.
+     * @c "text" or @c "ew-resize". The names are the ones of the CSS cursor property, which
+     * cursor themes use as well, the compositor renders the shape from its cursor theme.
+     *
+     * The shape is empty if the Cursor uses a surface, and the surface is @c null if the
+     * Cursor uses a shape.
+     *
+     * @see CursorShapeManagerV1Interface
+     * @since 5.22
+     **/
+    QString shape() const;
+    /**
+     * A key identifying the content of the shm buffer attached to the surface, @c 0 if
+     * there is none or the buffer is not a shared memory buffer.
+     *
+     * Most clients use the same cursor theme, so the images they attach are often identical.
+     * The key is a hash of the pixels, the compositor can keep the textures of cursor images
+     * in a cache keyed by it and swap textures instead of uploading the buffer whenever a
+     * client sets its cursor. When a client commits an image identical to the current one,
+     * changed is not emitted.
+     *
+     * @since 5.22
+     **/
+    quint64 imageKey() const;
 
 Q_SIGNALS:
     void hotspotChanged();
     void enteredSerialChanged();
     void surfaceChanged();
+    /**
+     * @since 5.22
+     **/
+    void shapeChanged();
     void changed();
 
 private:
@@ -7,6 +7,7 @@
 #define WAYLAND_SERVER_POINTER_INTERFACE_P_H
 #include "pointer_interface.h"
 #include "resource_p.h"
+#include "seat_interface.h"
 
 #include <QPointer>
 #include <QVector>
@@ -31,9 +32,57 @@ public:
     QVector<PointerSwipeGestureV1Interface *> swipeGesturesV1;
     QVector<PointerPinchGestureV1Interface *> pinchGesturesV1;
 
+    // the last motion relative to focusedChildSurface if motion events are coalesced
+    bool hasPendingMotion = false;
+    QPointF pendingMotionPosition;
+    quint32 pendingMotionTime = 0;
+    // the scroll of both axes merged within an input frame, sent before any other pointer event
+    bool hasPendingAxis = false;
+    QPointF pendingAxisDelta;
+    QPoint pendingAxisDiscreteDelta;
+    PointerAxisSource pendingAxisSource = PointerAxisSource::Unknown;
+    quint32 pendingAxisTime = 0;
+    // whether the pointer is in SeatInterface::Private::inputFramePointers and owes a frame
+    bool inInputFrame = false;
+    bool inputFramePending = false;
+
     void sendLeave(SurfaceInterface *surface, quint32 serial);
     void sendEnter(SurfaceInterface *surface, const QPointF &parentSurfacePosition, quint32 serial);
     void sendFrame();
+    void sendMotion(const QPointF &position, quint32 time);
+    void sendAxisSource(PointerAxisSource source);
+    /**
+     * Sends the scroll on @p orientation, or an axis_stop event if @p delta is @c 0.
+     */
+    void sendAxis(Qt::Orientation orientation, qreal delta, qint32 discreteDelta, quint32 time);
+    /**
+     * Sends the scroll on both axes without a frame event, axes without a delta are left out
+     * unless neither has one, which stops both.
+     */
+    void sendAxes(const QPointF &delta, const QPoint &discreteDelta, PointerAxisSource source, quint32 time);
+    /**
+     * Sends the merged scroll without a frame event. Deltas which cancelled out are dropped.
+     * @returns Whether anything was sent.
+     */
+    bool sendPendingAxis();
+    /**
+     * Sends the merged scroll, if any, followed by a frame event.
+     */
+    void flushPendingAxis();
+    /**
+     * Sends the merged scroll and the coalesced motion event, if any, followed by a frame event.
+     */
+    void flushPendingMotion();
+    /**
+     * Sends the motion held back while the client was congested as soon as it has caught up,
+     * rather than with the next input event or flush of the Display.
+     */
+    void flushDecongestedMotion();
+    void addToInputFrame();
+    /**
+     * Sends the merged motion and the single frame event at the end of an input frame.
+     */
+    void endInputFrame();
 
     void registerRelativePointerV1(RelativePointerV1Interface *relativePointer);
     void registerSwipeGestureV1(PointerSwipeGestureV1Interface *gesture);
@@ -43,6 +92,11 @@ public:
     void unregisterSwipeGestureV1(PointerSwipeGestureV1Interface *gesture);
     void unregisterPinchGestureV1(PointerPinchGestureV1Interface *gesture);
 
+    /**
+     * Sets the cursor to the named @p shape, for wp_cursor_shape_device_v1.
+     */
+    void setCursorShape(quint32 serial, const QString &shape);
+
     void startSwipeGesture(quint32 serial, quint32 fingerCount);
     void updateSwipeGesture(const QSizeF &delta);
     void endSwipeGesture(quint32 serial);
@@ -12,11 +12,82 @@
 #include "region_interface.h"
 #include "surface_interface_p.h"
 
+#include <QtMath>
+
 namespace KWaylandServer
 {
 
 static const int s_version = 1;
 
+// The smallest step a wl_fixed_t position can take, used to keep confined positions inside
+// of the right and bottom edges, which are exclusive.
+static const qreal s_fixedEpsilon = 1.0 / 256;
+
+void PointerConstraintRegion::update(const QRegion &region, SurfaceInterface *surface)
+{
+    const QRegion input = surface ? surface->input() : QRegion();
+    if (m_valid && m_region == region && m_input == input) {
+        return;
+    }
+    m_region = region;
+    m_input = input;
+    m_effective = region.isEmpty() ? input : region.intersected(input);
+    m_bounds = m_effective.boundingRect();
+    m_valid = true;
+}
+
+const QRegion &PointerConstraintRegion::effective(const QRegion &region, SurfaceInterface *surface)
+{
+    update(region, surface);
+    return m_effective;
+}
+
+bool PointerConstraintRegion::contains(const QRegion &region, SurfaceInterface *surface, const QPointF &pos)
+{
+    update(region, surface);
+    const QPoint pixel(qFloor(pos.x()), qFloor(pos.y()));
+    if (!m_bounds.contains(pixel)) {
+        return false;
+    }
+    if (m_effective.rectCount() == 1) {
+        return true;
+    }
+    return m_effective.contains(pixel);
+}
+
+static QPointF clampToRect(const QRect &rect, const QPointF &pos)
+{
+    return QPointF(qBound<qreal>(rect.x(), pos.x(), rect.x() + rect.width() - s_fixedEpsilon),
+                   qBound<qreal>(rect.y(), pos.y(), rect.y() + rect.height() - s_fixedEpsilon));
+}
+
+QPointF PointerConstraintRegion::confine(const QRegion &region, SurfaceInterface *surface, const QPointF &pos)
+{
+    update(region, surface);
+    if (m_effective.isEmpty()) {
+        return pos;
+    }
+    if (m_effective.rectCount() == 1) {
+        return clampToRect(m_bounds, pos);
+    }
+    const QPoint pixel(qFloor(pos.x()), qFloor(pos.y()));
+    if (m_bounds.contains(pixel) && m_effective.contains(pixel)) {
+        return pos;
+    }
+    QPointF closest;
+    qreal closestDistance = -1;
+    for (const QRect &rect : m_effective) {
+        const QPointF candidate = clampToRect(rect, pos);
+        const QPointF delta = candidate - pos;
+        const qreal distance = QPointF::dotProduct(delta, delta);
+        if (closestDistance < 0 || distance < closestDistance) {
+            closest = candidate;
+            closestDistance = distance;
+        }
+    }
+    return closest;
+}
+
 PointerConstraintsV1InterfacePrivate::PointerConstraintsV1InterfacePrivate(Display *display)
     : QtWaylandServer::zwp_pointer_constraints_v1(*display, s_version)
 {
@@ -72,6 +143,7 @@ void PointerConstraintsV1InterfacePrivate::zwp_pointer_constraints_v1_lock_point
     auto lockedPointer = new LockedPointerV1Interface(LockedPointerV1Interface::LifeTime(lifetime),
                                                       regionFromResource(region_resource),
                                                       lockedPointerResource);
+    LockedPointerV1InterfacePrivate::get(lockedPointer)->surface = surface;
 
     SurfaceInterfacePrivate::get(surface)->installPointerConstraint(lockedPointer);
 }
@@ -120,6 +192,7 @@ void PointerConstraintsV1InterfacePrivate::zwp_pointer_constraints_v1_confine_po
     auto confinedPointer = new ConfinedPointerV1Interface(ConfinedPointerV1Interface::LifeTime(lifetime),
                                                           regionFromResource(region_resource),
                                                           confinedPointerResource);
+    ConfinedPointerV1InterfacePrivate::get(confinedPointer)->surface = surface;
 
     SurfaceInterfacePrivate::get(surface)->installPointerConstraint(confinedPointer);
 }
@@ -218,6 +291,16 @@ QRegion LockedPointerV1Interface::region() const
     return d->region;
 }
 
+QRegion LockedPointerV1Interface::effectiveRegion() const
+{
+    return d->effectiveRegion.effective(d->region, d->surface);
+}
+
+bool LockedPointerV1Interface::contains(const QPointF &pos) const
+{
+    return d->effectiveRegion.contains(d->region, d->surface, pos);
+}
+
 QPointF LockedPointerV1Interface::cursorPositionHint() const
 {
     return d->hint;
@@ -309,6 +392,21 @@ QRegion ConfinedPointerV1Interface::region() const
     return d->region;
 }
 
+QRegion ConfinedPointerV1Interface::effectiveRegion() const
+{
+    return d->effectiveRegion.effective(d->region, d->surface);
+}
+
+bool ConfinedPointerV1Interface::contains(const QPointF &pos) const
+{
+    return d->effectiveRegion.contains(d->region, d->surface, pos);
+}
+
+QPointF ConfinedPointerV1Interface::confine(const QPointF &pos) const
+{
+    return d->effectiveRegion.confine(d->region, d->surface, pos);
+}
+
 bool ConfinedPointerV1Interface::isConfined() const
 {
     return d->isConfined;
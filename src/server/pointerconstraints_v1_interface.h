@@ -84,6 +84,27 @@ public:
      */
     QRegion region() const;
 
+    /**
+     * The region the pointer has to be in for the lock to activate, that is the intersection
+     * of region() and the input region of the SurfaceInterface, or the input region alone if
+     * region() is empty.
+     *
+     * The intersection is cached until either region changes, so this can be called on every
+     * pointer motion.
+     *
+     * @see contains
+     * @since 5.22
+     */
+    QRegion effectiveRegion() const;
+
+    /**
+     * Whether @p pos, in surface-local coordinates, is inside of the effectiveRegion.
+     *
+     * @see effectiveRegion
+     * @since 5.22
+     */
+    bool contains(const QPointF &pos) const;
+
     /**
      * Indicates where the mouse cursor should be positioned after it has been unlocked again.
      * The compositor can warp the cursor at this moment to the position. For that it
@@ -200,6 +221,40 @@ public:
      */
     QRegion region() const;
 
+    /**
+     * The region the pointer has to be in for the confinement to activate, that is the intersection
+     * of region() and the input region of the SurfaceInterface, or the input region alone if
+     * region() is empty.
+     *
+     * The intersection is cached until either region changes, so this can be called on every
+     * pointer motion.
+     *
+     * @see contains
+     * @since 5.22
+     */
+    QRegion effectiveRegion() const;
+
+    /**
+     * Whether @p pos, in surface-local coordinates, is inside of the effectiveRegion.
+     *
+     * @see effectiveRegion
+     * @since 5.22
+     */
+    bool contains(const QPointF &pos) const;
+
+    /**
+     * Returns @p pos, in surface-local coordinates, moved to the closest point inside of the
+     * effectiveRegion. Positions inside of the region are returned unchanged. If the
+     * effectiveRegion is empty @p pos is returned as well.
+     *
+     * This is meant to be called on every pointer motion while the confinement is active,
+     * regions consisting of a single rectangle are handled without testing the region.
+     *
+     * @see effectiveRegion
+     * @since 5.22
+     */
+    QPointF confine(const QPointF &pos) const;
+
     /**
      * Whether the Compositor set this pointer confinement to be active.
      * @see setConfined
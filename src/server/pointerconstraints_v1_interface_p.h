@@ -11,9 +11,35 @@
 
 #include "qwayland-server-pointer-constraints-unstable-v1.h"
 
+#include <QPointer>
+
 namespace KWaylandServer
 {
 
+/**
+ * The region of a pointer constraint intersected with the input region of its surface.
+ *
+ * The intersection is computed when it's first needed after either of the regions changed,
+ * which is detected by comparing against the regions it was computed from. QRegion is
+ * implicitly shared, so the comparison is cheap as long as nothing changed.
+ */
+class PointerConstraintRegion
+{
+public:
+    const QRegion &effective(const QRegion &region, SurfaceInterface *surface);
+    bool contains(const QRegion &region, SurfaceInterface *surface, const QPointF &pos);
+    QPointF confine(const QRegion &region, SurfaceInterface *surface, const QPointF &pos);
+
+private:
+    void update(const QRegion &region, SurfaceInterface *surface);
+
+    QRegion m_region;
+    QRegion m_input;
+    QRegion m_effective;
+    QRect m_bounds;
+    bool m_valid = false;
+};
+
 class PointerConstraintsV1InterfacePrivate : public QtWaylandServer::zwp_pointer_constraints_v1
 {
 public:
@@ -53,6 +79,8 @@ public:
     bool hasPendingRegion = false;
     bool hasPendingHint = false;
     bool isLocked = false;
+    QPointer<SurfaceInterface> surface;
+    PointerConstraintRegion effectiveRegion;
 
 protected:
     void zwp_locked_pointer_v1_destroy_resource(Resource *resource) override;
@@ -81,6 +109,8 @@ public:
     QRegion pendingRegion;
     bool hasPendingRegion = false;
     bool isConfined = false;
+    QPointer<SurfaceInterface> surface;
+    PointerConstraintRegion effectiveRegion;
 
 protected:
     void zwp_confined_pointer_v1_destroy_resource(Resource *resource) override;
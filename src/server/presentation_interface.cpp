@@ -0,0 +1,147 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "presentation_interface.h"
+#include "presentation_interface_p.h"
+#include "clientconnection.h"
+#include "display.h"
+#include "output_interface.h"
+#include "surface_interface_p.h"
+
+#include "qwayland-server-presentation-time.h"
+
+#include <time.h>
+
+static const int s_version = 1;
+
+namespace KWaylandServer
+{
+
+class PresentationInterfacePrivate : public QtWaylandServer::wp_presentation
+{
+protected:
+    void wp_presentation_bind_resource(Resource *resource) override;
+    void wp_presentation_destroy(Resource *resource) override;
+    void wp_presentation_feedback(Resource *resource, struct ::wl_resource *surface, uint32_t callback) override;
+};
+
+void PresentationInterfacePrivate::wp_presentation_bind_resource(Resource *resource)
+{
+    send_clock_id(resource->handle, CLOCK_MONOTONIC);
+}
+
+void PresentationInterfacePrivate::wp_presentation_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void PresentationInterfacePrivate::wp_presentation_feedback(Resource *resource, struct ::wl_resource *surface_resource, uint32_t callback)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
+    wl_resource *feedbackResource = wl_resource_create(resource->client(), &wp_presentation_feedback_interface,
+                                                       resource->version(), callback);
+    if (!feedbackResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    SurfaceInterfacePrivate::get(surface)->pending.presentationFeedback.append(feedbackResource);
+}
+
+PresentationFeedbackList::PresentationFeedbackList()
+{
+    wl_list_init(&m_list);
+}
+
+PresentationFeedbackList::PresentationFeedbackList(const PresentationFeedbackList &other)
+{
+    Q_UNUSED(other)
+    wl_list_init(&m_list);
+}
+
+PresentationFeedbackList::~PresentationFeedbackList()
+{
+    sendDiscarded();
+}
+
+PresentationFeedbackList &PresentationFeedbackList::operator=(const PresentationFeedbackList &other)
+{
+    Q_UNUSED(other)
+    return *this;
+}
+
+bool PresentationFeedbackList::isEmpty() const
+{
+    return wl_list_empty(&m_list);
+}
+
+void PresentationFeedbackList::destroyFeedback(wl_resource *feedback)
+{
+    wl_list *link = wl_resource_get_link(feedback);
+    wl_list_remove(link);
+    wl_list_init(link);
+}
+
+void PresentationFeedbackList::append(wl_resource *feedback)
+{
+    wl_resource_set_implementation(feedback, nullptr, nullptr, destroyFeedback);
+    wl_list_insert(m_list.prev, wl_resource_get_link(feedback));
+}
+
+void PresentationFeedbackList::takeFrom(PresentationFeedbackList *other)
+{
+    wl_list_insert_list(m_list.prev, &other->m_list);
+    wl_list_init(&other->m_list);
+}
+
+void PresentationFeedbackList::sendPresented(OutputInterface *output, const PresentationTime &time)
+{
+    if (isEmpty()) {
+        return;
+    }
+    const std::chrono::seconds seconds = std::chrono::duration_cast<std::chrono::seconds>(time.timestamp);
+    const quint64 tvSec = seconds.count();
+    const quint32 tvNsec = (time.timestamp - seconds).count();
+    const quint32 refresh = time.refreshInterval.count();
+
+    wl_resource *feedback;
+    wl_resource *next;
+    wl_resource_for_each_safe(feedback, next, &m_list) {
+        if (output) {
+            // all feedback of a surface belongs to the same client, but this is not the hot path
+            wl_client *client = wl_resource_get_client(feedback);
+            const QVector<wl_resource *> outputResources = output->clientResources(output->display()->getConnection(client));
+            for (wl_resource *outputResource : outputResources) {
+                wp_presentation_feedback_send_sync_output(feedback, outputResource);
+            }
+        }
+        wp_presentation_feedback_send_presented(feedback, tvSec >> 32, tvSec & 0xffffffff, tvNsec, refresh,
+                                                time.sequence >> 32, time.sequence & 0xffffffff, uint32_t(time.kinds));
+        wl_resource_destroy(feedback);
+    }
+}
+
+void PresentationFeedbackList::sendDiscarded()
+{
+    wl_resource *feedback;
+    wl_resource *next;
+    wl_resource_for_each_safe(feedback, next, &m_list) {
+        wp_presentation_feedback_send_discarded(feedback);
+        wl_resource_destroy(feedback);
+    }
+}
+
+PresentationInterface::PresentationInterface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new PresentationInterfacePrivate)
+{
+    d->init(*display, s_version);
+}
+
+PresentationInterface::~PresentationInterface()
+{
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,106 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+#include <chrono>
+
+namespace KWaylandServer
+{
+
+class Display;
+class PresentationInterfacePrivate;
+
+/**
+ * How a content update got presented.
+ *
+ * The values are the same as the ones of @c wp_presentation_feedback.kind.
+ *
+ * @since 5.22
+ */
+enum class PresentationKind {
+    /**
+     * The update was presented in sync with the vertical retrace, without tearing.
+     */
+    Vsync = 0x1,
+    /**
+     * The timestamp comes from the display hardware rather than from a software clock.
+     */
+    HwClock = 0x2,
+    /**
+     * The hardware signaled the completion of the presentation, the timestamp isn't guessed.
+     */
+    HwCompletion = 0x4,
+    /**
+     * The buffer of the client was scanned out directly, without a copy by the compositor.
+     */
+    ZeroCopy = 0x8,
+};
+Q_DECLARE_FLAGS(PresentationKinds, PresentationKind)
+
+/**
+ * The time at which a content update turned into light on an output.
+ *
+ * @see SurfaceInterface::presented
+ * @since 5.22
+ */
+struct KWAYLANDSERVER_EXPORT PresentationTime
+{
+    /**
+     * The time of the presentation, e.g. the vblank, on CLOCK_MONOTONIC.
+     */
+    std::chrono::nanoseconds timestamp = std::chrono::nanoseconds::zero();
+    /**
+     * The time until the next possible presentation, zero if it's unknown or the output has a
+     * variable refresh rate.
+     */
+    std::chrono::nanoseconds refreshInterval = std::chrono::nanoseconds::zero();
+    /**
+     * The vblank counter of the output, zero if the output doesn't have one.
+     */
+    quint64 sequence = 0;
+    PresentationKinds kinds;
+};
+
+/**
+ * The PresentationInterface tells clients when exactly their content updates were presented.
+ *
+ * Unlike frame callbacks, which only give a millisecond timestamp of when the compositor
+ * rendered a frame, the presentation feedback of a commit carries the time of the vblank that
+ * put it on screen, the refresh interval and vblank counter of the output and whether the
+ * buffer was scanned out directly. Video players and games use it to pace their frames.
+ *
+ * The feedback requested by a client goes along with the commit it was requested for. The
+ * compositor reports the presentation of the current state of a surface with
+ * SurfaceInterface::presented(), or that it won't be presented with
+ * SurfaceInterface::discardPresentationFeedback(). Feedback of a commit which got replaced
+ * by a newer one before the compositor reported it is discarded automatically.
+ *
+ * The timestamps are always on CLOCK_MONOTONIC.
+ *
+ * PresentationInterface corresponds to the Wayland interface @c wp_presentation.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT PresentationInterface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit PresentationInterface(Display *display, QObject *parent = nullptr);
+    ~PresentationInterface() override;
+
+private:
+    QScopedPointer<PresentationInterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
+
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::PresentationKinds)
@@ -0,0 +1,57 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "presentation_interface.h"
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+
+class OutputInterface;
+
+/**
+ * Intrusive list of wp_presentation_feedback resources of one content update.
+ *
+ * Like the FrameCallbackList, the feedback resources are linked through the link of their
+ * wl_resource and belong to exactly one list, copying or assigning a list does not copy them.
+ * A destroyed feedback unlinks itself from its list.
+ */
+class PresentationFeedbackList
+{
+public:
+    PresentationFeedbackList();
+    PresentationFeedbackList(const PresentationFeedbackList &other);
+    ~PresentationFeedbackList();
+
+    PresentationFeedbackList &operator=(const PresentationFeedbackList &other);
+
+    bool isEmpty() const;
+
+    void append(wl_resource *feedback);
+    /**
+     * Moves all feedback of @p other to the end of this list.
+     */
+    void takeFrom(PresentationFeedbackList *other);
+    /**
+     * Sends the presented event with the given @p time to all feedback and destroys it. The
+     * client is told about the wl_output resources of @p output it has bound first.
+     */
+    void sendPresented(OutputInterface *output, const PresentationTime &time);
+    /**
+     * Sends the discarded event to all feedback and destroys it.
+     */
+    void sendDiscarded();
+
+private:
+    static void destroyFeedback(wl_resource *feedback);
+
+    wl_list m_list;
+};
+
+} // namespace KWaylandServer
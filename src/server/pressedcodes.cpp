@@ -0,0 +1,47 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "pressedcodes_p.h"
+
+namespace KWaylandServer
+{
+
+bool PressedCodes::isTracked(quint32 code)
+{
+    return code < KEY_CNT;
+}
+
+bool PressedCodes::update(quint32 code, bool pressed)
+{
+    if (!isTracked(code)) {
+        return true;
+    }
+    if (m_known.test(code) && m_pressed.test(code) == pressed) {
+        return false;
+    }
+    m_known.set(code);
+    if (m_pressed.test(code) != pressed) {
+        m_pressed.set(code, pressed);
+        if (pressed) {
+            m_pressedCodes.append(code);
+        } else {
+            m_pressedCodes.removeOne(code);
+        }
+    }
+    return true;
+}
+
+bool PressedCodes::isPressed(quint32 code) const
+{
+    return isTracked(code) && m_pressed.test(code);
+}
+
+const QVector<quint32> &PressedCodes::pressed() const
+{
+    return m_pressedCodes;
+}
+
+}
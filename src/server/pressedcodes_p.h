@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <QVector>
+
+#include <linux/input.h>
+
+#include <bitset>
+
+namespace KWaylandServer
+{
+
+/**
+ * Tracks which evdev key or button codes are pressed.
+ *
+ * The states are kept in bitsets indexed by the code, so updating or querying a code doesn't
+ * hash or allocate. The pressed codes are additionally kept in the order they got pressed,
+ * ready to be sent as the array of a wl_keyboard.enter event.
+ *
+ * Codes of @c KEY_CNT and above are not tracked, they are never reported as pressed.
+ */
+class PressedCodes
+{
+public:
+    /**
+     * Sets the state of @p code, returns @c false if it already was in that state. A code
+     * seen for the first time counts as a change, even when it is released.
+     */
+    bool update(quint32 code, bool pressed);
+    bool isPressed(quint32 code) const;
+
+    /**
+     * The pressed codes, in the order they got pressed.
+     */
+    const QVector<quint32> &pressed() const;
+
+    static bool isTracked(quint32 code);
+
+private:
+    std::bitset<KEY_CNT> m_known;
+    std::bitset<KEY_CNT> m_pressed;
+    QVector<quint32> m_pressedCodes;
+};
+
+}
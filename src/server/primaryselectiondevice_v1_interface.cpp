@@ -23,10 +23,15 @@ public:
     PrimarySelectionDeviceV1InterfacePrivate(PrimarySelectionDeviceV1Interface *q, SeatInterface *seat, wl_resource *resource);
 
     PrimarySelectionOfferV1Interface *createDataOffer(AbstractDataSource *source);
+    bool hasSelection(AbstractDataSource *source) const;
 
     PrimarySelectionDeviceV1Interface *q;
     SeatInterface *seat;
     QPointer<PrimarySelectionSourceV1Interface> selection;
+    // the last selection sent, a generation of 0 is a cleared selection
+    bool selectionSent = false;
+    quint64 sentSelectionGeneration = 0;
+    QPointer<PrimarySelectionOfferV1Interface> sentSelectionOffer;
 
 private:
     void setSelection(PrimarySelectionSourceV1Interface *dataSource);
@@ -73,6 +78,17 @@ void PrimarySelectionDeviceV1InterfacePrivate::zwp_primary_selection_device_v1_d
     wl_resource_destroy(resource->handle);
 }
 
+bool PrimarySelectionDeviceV1InterfacePrivate::hasSelection(AbstractDataSource *source) const
+{
+    if (!selectionSent || !seat->isSelectionDeduplicationEnabled()) {
+        return false;
+    }
+    if (!source) {
+        return sentSelectionGeneration == 0;
+    }
+    return sentSelectionGeneration == source->generation() && sentSelectionOffer;
+}
+
 PrimarySelectionOfferV1Interface *PrimarySelectionDeviceV1InterfacePrivate::createDataOffer(AbstractDataSource *source)
 {
     if (!source) {
@@ -123,16 +139,28 @@ void PrimarySelectionDeviceV1Interface::sendSelection(AbstractDataSource *other)
         sendClearSelection();
         return;
     }
+    if (d->hasSelection(other)) {
+        return;
+    }
     PrimarySelectionOfferV1Interface *offer = d->createDataOffer(other);
     if (!offer) {
         return;
     }
     d->send_selection(offer->resource());
+    d->selectionSent = true;
+    d->sentSelectionGeneration = other->generation();
+    d->sentSelectionOffer = offer;
 }
 
 void PrimarySelectionDeviceV1Interface::sendClearSelection()
 {
+    if (d->hasSelection(nullptr)) {
+        return;
+    }
     d->send_selection(nullptr);
+    d->selectionSent = true;
+    d->sentSelectionGeneration = 0;
+    d->sentSelectionOffer = nullptr;
 }
 
 wl_client *PrimarySelectionDeviceV1Interface::client() const
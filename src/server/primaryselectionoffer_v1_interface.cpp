@@ -6,6 +6,7 @@
 #include "primaryselectionoffer_v1_interface.h"
 #include "primaryselectiondevice_v1_interface.h"
 #include "primaryselectionsource_v1_interface.h"
+#include "datatransfermonitor_p.h"
 // Qt
 #include <QStringList>
 #include <QPointer>
@@ -50,12 +51,11 @@ void PrimarySelectionOfferV1InterfacePrivate::zwp_primary_selection_offer_v1_des
 
 void PrimarySelectionOfferV1InterfacePrivate::zwp_primary_selection_offer_v1_receive(Resource *resource, const QString &mimeType, qint32 fd)
 {
-    Q_UNUSED(resource)
     if (!source) {
         close(fd);
         return;
     }
-    source->requestData(mimeType, fd);
+    DataTransferMonitorPrivate::requestData(source, mimeType, fd, resource->client());
 }
 
 PrimarySelectionOfferV1Interface::PrimarySelectionOfferV1Interface(AbstractDataSource *source, wl_resource *resource)
@@ -74,8 +74,10 @@ PrimarySelectionOfferV1Interface::~PrimarySelectionOfferV1Interface() = default;
 
 void PrimarySelectionOfferV1Interface::sendAllOffers()
 {
-    for (const QString &mimeType : d->source->mimeTypes()) {
-        d->send_offer(mimeType);
+    // the atoms carry the encoded names, nothing to convert per offer
+    const MimeTypeAtoms mimeTypes = d->source->mimeTypeAtoms();
+    for (const MimeTypeAtom &mimeType : mimeTypes) {
+        zwp_primary_selection_offer_v1_send_offer(d->resource()->handle, mimeType.constData());
     }
 }
 
@@ -22,7 +22,9 @@ class PrimarySelectionSourceV1InterfacePrivate : public QtWaylandServer::zwp_pri
 public:
     PrimarySelectionSourceV1InterfacePrivate(PrimarySelectionSourceV1Interface *q, ::wl_resource *resource);
 
-    QStringList mimeTypes;
+    MimeTypeAtoms mimeTypes;
+    // the strings of mimeTypes, built on the first call of mimeTypes() after an offer
+    mutable QStringList mimeTypeNames;
     PrimarySelectionSourceV1Interface *q;
 protected:
     void zwp_primary_selection_source_v1_destroy_resource(Resource *resource) override;
@@ -45,7 +47,8 @@ void PrimarySelectionSourceV1InterfacePrivate::zwp_primary_selection_source_v1_d
 
 void PrimarySelectionSourceV1InterfacePrivate::zwp_primary_selection_source_v1_offer(Resource *, const QString &mimeType)
 {
-    mimeTypes << mimeType;
+    mimeTypes << MimeTypeAtom(mimeType);
+    mimeTypeNames.clear();
     emit q->mimeTypeOffered(mimeType);
 }
 
@@ -74,6 +77,14 @@ void PrimarySelectionSourceV1Interface::cancel()
 }
 
 QStringList PrimarySelectionSourceV1Interface::mimeTypes() const
+{
+    if (d->mimeTypeNames.isEmpty()) {
+        d->mimeTypeNames = MimeTypeAtom::toStringList(d->mimeTypes);
+    }
+    return d->mimeTypeNames;
+}
+
+MimeTypeAtoms PrimarySelectionSourceV1Interface::mimeTypeAtoms() const
 {
     return d->mimeTypes;
 }
@@ -31,6 +31,7 @@ public:
     void cancel() override;
 
     QStringList mimeTypes() const override;
+    MimeTypeAtoms mimeTypeAtoms() const override;
 
     static PrimarySelectionSourceV1Interface *get(wl_resource *native);
     wl_client *client() const override;
@@ -0,0 +1,190 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "protocoleventlog_p.h"
+#include "logging.h"
+#include "protocolmessage_p.h"
+
+#include <config-kwaylandserver.h>
+
+#include <atomic>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+static const size_t s_logSize = sizeof(ProtocolEventLogHeader) + ProtocolEventLog::capacity * sizeof(ProtocolEventRecord);
+
+static_assert((ProtocolEventLog::capacity & (ProtocolEventLog::capacity - 1)) == 0, "The slot is computed with a mask");
+
+static quint32 hashBytes(quint32 hash, const void *data, size_t size)
+{
+    const uchar *bytes = static_cast<const uchar *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static quint32 argumentDigest(const wl_protocol_logger_message *message)
+{
+    quint32 hash = 2166136261u;
+    forEachArgument(message, [&hash](char type, const wl_argument &value) {
+        switch (type) {
+        case 'i':
+        case 'u':
+        case 'f':
+        case 'n':
+            hash = hashBytes(hash, &value.u, sizeof(value.u));
+            break;
+        case 'o': {
+            const quint32 id = value.o ? wl_resource_get_id(reinterpret_cast<wl_resource *>(value.o)) : 0;
+            hash = hashBytes(hash, &id, sizeof(id));
+            break;
+        }
+        case 's':
+            if (value.s) {
+                hash = hashBytes(hash, value.s, strlen(value.s));
+            }
+            break;
+        case 'a':
+            if (value.a) {
+                hash = hashBytes(hash, value.a->data, value.a->size);
+            }
+            break;
+        }
+    });
+    return hash;
+}
+
+ProtocolEventLog::~ProtocolEventLog()
+{
+    Q_ASSERT(!m_logger);
+    unmap();
+}
+
+bool ProtocolEventLog::map()
+{
+    if (m_header) {
+        return true;
+    }
+    void *memory = MAP_FAILED;
+#if HAVE_MEMFD
+    m_fd = memfd_create("kwaylandserver-protocol-log", MFD_CLOEXEC);
+    if (m_fd >= 0) {
+        if (ftruncate(m_fd, s_logSize) == 0) {
+            memory = mmap(nullptr, s_logSize, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+        }
+        if (memory == MAP_FAILED) {
+            close(m_fd);
+            m_fd = -1;
+        }
+    }
+#endif
+    if (memory == MAP_FAILED) {
+        memory = mmap(nullptr, s_logSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+    if (memory == MAP_FAILED) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to map the protocol event log";
+        return false;
+    }
+    // the mapping is zero filled, so all records start out unused
+    m_header = static_cast<ProtocolEventLogHeader *>(memory);
+    m_header->magic = ProtocolEventLogHeader::magicValue;
+    m_header->version = ProtocolEventLogHeader::currentVersion;
+    m_header->capacity = capacity;
+    m_header->recordSize = sizeof(ProtocolEventRecord);
+    m_records = reinterpret_cast<ProtocolEventRecord *>(m_header + 1);
+    return true;
+}
+
+void ProtocolEventLog::unmap()
+{
+    if (m_header) {
+        munmap(m_header, s_logSize);
+        m_header = nullptr;
+        m_records = nullptr;
+    }
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+bool ProtocolEventLog::setEnabled(wl_display *display, bool enabled)
+{
+    if (enabled == isEnabled()) {
+        return true;
+    }
+    if (enabled) {
+        if (!map()) {
+            return false;
+        }
+        m_logger = wl_display_add_protocol_logger(display, logger, this);
+    } else {
+        wl_protocol_logger_destroy(m_logger);
+        m_logger = nullptr;
+        unmap();
+    }
+    return true;
+}
+
+void ProtocolEventLog::logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    auto log = static_cast<ProtocolEventLog *>(data);
+    const quint64 sequence = log->m_header->written + 1;
+    ProtocolEventRecord &record = log->m_records[(sequence - 1) & (capacity - 1)];
+    // invalidate the slot first, so a dump taken while it is written doesn't show a
+    // record mixing two messages
+    record.sequence = 0;
+    std::atomic_signal_fence(std::memory_order_release);
+
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    record.timestamp = quint64(now.tv_sec) * 1000000000 + quint64(now.tv_nsec);
+    pid_t pid = 0;
+    wl_client_get_credentials(wl_resource_get_client(message->resource), &pid, nullptr, nullptr);
+    record.clientPid = quint32(pid);
+    record.objectId = wl_resource_get_id(message->resource);
+    record.opcode = quint16(message->message_opcode);
+    record.direction = type == WL_PROTOCOL_LOGGER_REQUEST ? ProtocolEventRecord::Request : ProtocolEventRecord::Event;
+    record.argumentCount = quint8(message->arguments_count);
+    record.argumentDigest = argumentDigest(message);
+    strncpy(record.interface, wl_resource_get_class(message->resource), sizeof(record.interface) - 1);
+    record.interface[sizeof(record.interface) - 1] = '\0';
+
+    std::atomic_signal_fence(std::memory_order_release);
+    record.sequence = sequence;
+    log->m_header->written = sequence;
+}
+
+bool ProtocolEventLog::dump(int fd) const
+{
+    if (!m_header) {
+        return false;
+    }
+    const char *data = reinterpret_cast<const char *>(m_header);
+    size_t remaining = s_logSize;
+    while (remaining > 0) {
+        const ssize_t written = write(fd, data, remaining);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        remaining -= written;
+    }
+    return true;
+}
+
+}
@@ -0,0 +1,86 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLEVENTLOG_H
+#define KWAYLAND_SERVER_PROTOCOLEVENTLOG_H
+
+#include <QtGlobal>
+
+namespace KWaylandServer
+{
+
+/**
+ * @brief The header at the start of the protocol event log.
+ *
+ * The log, see Display::setProtocolEventLogEnabled, is this header followed by @c capacity
+ * records of @c recordSize bytes. The records form a ring: record @c i of all records ever
+ * written is stored in slot <tt>i % capacity</tt>, @c written is the number of records
+ * written so far.
+ *
+ * @see ProtocolEventRecord
+ * @since 5.22
+ **/
+struct ProtocolEventLogHeader
+{
+    /**
+     * @c KWEL in little endian.
+     **/
+    static constexpr quint32 magicValue = 0x4c45574b;
+    static constexpr quint32 currentVersion = 1;
+
+    quint32 magic;
+    quint32 version;
+    quint32 capacity;
+    quint32 recordSize;
+    quint64 written;
+    char reserved[40];
+};
+
+/**
+ * @brief A request or event in the protocol event log.
+ *
+ * The arguments are not stored, only a FNV-1a digest of them: integers and object ids are
+ * hashed as four bytes in host byte order, strings and arrays by their content, file
+ * descriptors are left out. Equal digests hence hint at the same message being repeated.
+ *
+ * @since 5.22
+ **/
+struct ProtocolEventRecord
+{
+    enum Direction : quint8 {
+        Request,
+        Event
+    };
+
+    /**
+     * The number of the record counting from @c 1, written after all other fields. A record
+     * whose sequence does not match its slot is either unused or was being written.
+     **/
+    quint64 sequence;
+    /**
+     * CLOCK_MONOTONIC in nanoseconds.
+     **/
+    quint64 timestamp;
+    /**
+     * The process id of the client.
+     **/
+    quint32 clientPid;
+    quint32 objectId;
+    quint16 opcode;
+    quint8 direction;
+    quint8 argumentCount;
+    quint32 argumentDigest;
+    /**
+     * The name of the interface of the object, truncated and null terminated.
+     **/
+    char interface[32];
+};
+
+static_assert(sizeof(ProtocolEventLogHeader) == 64, "The log header is part of the dump format");
+static_assert(sizeof(ProtocolEventRecord) == 64, "The log records are part of the dump format");
+
+}
+
+#endif
@@ -0,0 +1,55 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLEVENTLOG_P_H
+#define KWAYLAND_SERVER_PROTOCOLEVENTLOG_P_H
+
+#include "protocoleventlog.h"
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+
+/**
+ * Writes the binary protocol event log of a wl_display through a protocol logger. The ring
+ * lives in a memfd, or in anonymous memory where memfds are not available, which is only
+ * mapped while the log is enabled. The logger has to be removed before the wl_display is
+ * destroyed.
+ */
+class ProtocolEventLog
+{
+public:
+    static constexpr quint32 capacity = 8192;
+
+    ~ProtocolEventLog();
+
+    bool isEnabled() const {
+        return m_logger;
+    }
+    bool setEnabled(wl_display *display, bool enabled);
+
+    int fd() const {
+        return m_fd;
+    }
+    /**
+     * Writes the mapped log to @p fd. Only calls write(), so it is async-signal-safe.
+     */
+    bool dump(int fd) const;
+
+private:
+    static void logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    bool map();
+    void unmap();
+
+    wl_protocol_logger *m_logger = nullptr;
+    int m_fd = -1;
+    ProtocolEventLogHeader *m_header = nullptr;
+    ProtocolEventRecord *m_records = nullptr;
+};
+
+}
+
+#endif
@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#pragma once
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+
+/**
+ * Calls @p callback with the type and the value of every argument of a @p message passed to
+ * a protocol logger, in the order of the signature.
+ *
+ * The signature also holds the since version and the markers of nullable arguments, they
+ * are skipped. The type is one of the wl_message signature characters @c i, @c u, @c f,
+ * @c s, @c o, @c n, @c a and @c h.
+ */
+template<typename Callback>
+void forEachArgument(const wl_protocol_logger_message *message, Callback callback)
+{
+    int argument = 0;
+    for (const char *signature = message->message->signature; *signature && argument < message->arguments_count; ++signature) {
+        switch (*signature) {
+        case 'i':
+        case 'u':
+        case 'f':
+        case 's':
+        case 'o':
+        case 'n':
+        case 'a':
+        case 'h':
+            callback(*signature, message->arguments[argument]);
+            argument++;
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,220 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "protocolrecorder_p.h"
+#include "logging.h"
+#include "protocolmessage_p.h"
+
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+// the buffered entries are written once they exceed this size
+static const int s_flushThreshold = 64 * 1024;
+
+static void appendWord(QByteArray &buffer, quint32 word)
+{
+    buffer.append(reinterpret_cast<const char *>(&word), sizeof(word));
+}
+
+static void appendPadded(QByteArray &buffer, const void *data, quint32 size)
+{
+    buffer.append(static_cast<const char *>(data), size);
+    // the wire format aligns everything to 32 bit
+    static const char padding[3] = {0, 0, 0};
+    buffer.append(padding, (4 - size % 4) % 4);
+}
+
+ProtocolRecorder::~ProtocolRecorder()
+{
+    Q_ASSERT(!m_logger);
+}
+
+quint64 ProtocolRecorder::timestamp() const
+{
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return quint64(now.tv_sec) * 1000000000 + quint64(now.tv_nsec) - m_start;
+}
+
+bool ProtocolRecorder::start(wl_display *display, int fd)
+{
+    if (isRecording()) {
+        return false;
+    }
+    m_fd = fd;
+    m_failed = false;
+    m_start = 0;
+    m_start = timestamp();
+    m_buffer.reserve(2 * s_flushThreshold);
+    const ProtocolRecordingHeader header = {ProtocolRecordingHeader::magicValue, ProtocolRecordingHeader::currentVersion, 0};
+    if (!write(reinterpret_cast<const char *>(&header), sizeof(header))) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to write the protocol recording header:" << strerror(errno);
+        m_fd = -1;
+        return false;
+    }
+    m_logger = wl_display_add_protocol_logger(display, logger, this);
+    return true;
+}
+
+bool ProtocolRecorder::stop()
+{
+    if (!isRecording()) {
+        return false;
+    }
+    wl_protocol_logger_destroy(m_logger);
+    m_logger = nullptr;
+    for (ClientListener *listener : qAsConst(m_clients)) {
+        wl_list_remove(&listener->listener.link);
+        delete listener;
+    }
+    m_clients.clear();
+    m_nextClient = 0;
+    const bool ok = flush() && !m_failed;
+    m_buffer = QByteArray();
+    m_fd = -1;
+    return ok;
+}
+
+ProtocolRecorder::ClientListener *ProtocolRecorder::clientListener(wl_client *client)
+{
+    ClientListener *&listener = m_clients[client];
+    if (!listener) {
+        listener = new ClientListener;
+        listener->listener.notify = clientDestroyed;
+        listener->recorder = this;
+        listener->index = m_nextClient++;
+        wl_client_add_destroy_listener(client, &listener->listener);
+    }
+    return listener;
+}
+
+void ProtocolRecorder::clientDestroyed(wl_listener *listener, void *data)
+{
+    ClientListener *clientListener = wl_container_of(listener, clientListener, listener);
+    ProtocolRecorder *recorder = clientListener->recorder;
+    const ProtocolRecordingEntry entry = {recorder->timestamp(), clientListener->index, ProtocolRecordingEntry::Disconnect, 0, 0, 0, 0};
+    recorder->m_buffer.append(reinterpret_cast<const char *>(&entry), sizeof(entry));
+    recorder->m_clients.remove(static_cast<wl_client *>(data));
+    wl_list_remove(&clientListener->listener.link);
+    delete clientListener;
+}
+
+void ProtocolRecorder::logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    if (type != WL_PROTOCOL_LOGGER_REQUEST) {
+        return;
+    }
+    auto recorder = static_cast<ProtocolRecorder *>(data);
+    if (recorder->m_failed) {
+        return;
+    }
+    recorder->record(message);
+    if (recorder->m_buffer.size() >= s_flushThreshold && !recorder->flush()) {
+        // the logger can't be removed from within its callback
+        qCWarning(KWAYLAND_SERVER) << "Failed to write the protocol recording:" << strerror(errno);
+        recorder->m_failed = true;
+    }
+}
+
+void ProtocolRecorder::record(const wl_protocol_logger_message *message)
+{
+    const ClientListener *client = clientListener(wl_resource_get_client(message->resource));
+    const char *interface = wl_resource_get_class(message->resource);
+    quint8 flags = 0;
+    if (message->message_opcode == 1 && strcmp(interface, "wl_display") == 0) {
+        flags |= ProtocolRecordingEntry::GetRegistry;
+    } else if (message->message_opcode == 0 && strcmp(interface, "wl_registry") == 0) {
+        flags |= ProtocolRecordingEntry::RegistryBind;
+    }
+
+    const int entryOffset = m_buffer.size();
+    const ProtocolRecordingEntry placeholder = {timestamp(), client->index, ProtocolRecordingEntry::Request, flags, 0, 0, 0};
+    m_buffer.append(reinterpret_cast<const char *>(&placeholder), sizeof(placeholder));
+    const int messageOffset = m_buffer.size();
+    appendWord(m_buffer, wl_resource_get_id(message->resource));
+    // the size is patched in below
+    appendWord(m_buffer, 0);
+
+    int fds[4];
+    int fdCount = 0;
+    forEachArgument(message, [this, &fds, &fdCount](char type, const wl_argument &value) {
+        switch (type) {
+        case 'i':
+        case 'u':
+        case 'f':
+            appendWord(m_buffer, value.u);
+            break;
+        case 'n':
+            appendWord(m_buffer, value.n);
+            break;
+        case 'o':
+            appendWord(m_buffer, value.o ? wl_resource_get_id(reinterpret_cast<wl_resource *>(value.o)) : 0);
+            break;
+        case 's': {
+            const quint32 length = value.s ? strlen(value.s) + 1 : 0;
+            appendWord(m_buffer, length);
+            appendPadded(m_buffer, value.s, length);
+            break;
+        }
+        case 'a': {
+            const quint32 size = value.a ? value.a->size : 0;
+            appendWord(m_buffer, size);
+            appendPadded(m_buffer, value.a ? value.a->data : nullptr, size);
+            break;
+        }
+        case 'h':
+            // no request in the core or the extension protocols carries more fds
+            if (fdCount < 4) {
+                fds[fdCount++] = value.h;
+            }
+            break;
+        }
+    });
+
+    const quint32 size = m_buffer.size() - messageOffset;
+    const quint32 sizeAndOpcode = (size << 16) | message->message_opcode;
+    memcpy(m_buffer.data() + messageOffset + sizeof(quint32), &sizeAndOpcode, sizeof(sizeAndOpcode));
+    ProtocolRecordingEntry *entry = reinterpret_cast<ProtocolRecordingEntry *>(m_buffer.data() + entryOffset);
+    entry->size = size;
+    entry->fdCount = fdCount;
+
+    for (int i = 0; i < fdCount; ++i) {
+        struct stat info;
+        const quint64 fdSize = fstat(fds[i], &info) == 0 && S_ISREG(info.st_mode) ? quint64(info.st_size) : 0;
+        m_buffer.append(reinterpret_cast<const char *>(&fdSize), sizeof(fdSize));
+    }
+}
+
+bool ProtocolRecorder::write(const char *data, size_t size)
+{
+    while (size > 0) {
+        const ssize_t written = ::write(m_fd, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+bool ProtocolRecorder::flush()
+{
+    const bool ok = write(m_buffer.constData(), m_buffer.size());
+    // keeps the reserved capacity
+    m_buffer.resize(0);
+    return ok;
+}
+
+}
@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLRECORDER_P_H
+#define KWAYLAND_SERVER_PROTOCOLRECORDER_P_H
+
+#include "protocolrecording.h"
+
+#include <QByteArray>
+#include <QHash>
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+
+/**
+ * Writes the requests of all clients of a wl_display to a file descriptor through a protocol
+ * logger, see ProtocolRecordingHeader for the format. The entries are buffered and written
+ * in chunks. The recorder has to be stopped before the wl_display is destroyed.
+ */
+class ProtocolRecorder
+{
+public:
+    ~ProtocolRecorder();
+
+    bool isRecording() const {
+        return m_logger;
+    }
+    bool start(wl_display *display, int fd);
+    /**
+     * @returns @c false if writing the recording failed at some point.
+     */
+    bool stop();
+
+private:
+    struct ClientListener {
+        wl_listener listener;
+        ProtocolRecorder *recorder;
+        quint32 index;
+    };
+
+    static void logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    static void clientDestroyed(wl_listener *listener, void *data);
+    ClientListener *clientListener(wl_client *client);
+    quint64 timestamp() const;
+    void record(const wl_protocol_logger_message *message);
+    bool write(const char *data, size_t size);
+    bool flush();
+
+    wl_protocol_logger *m_logger = nullptr;
+    int m_fd = -1;
+    quint64 m_start = 0;
+    bool m_failed = false;
+    QByteArray m_buffer;
+    QHash<wl_client *, ClientListener *> m_clients;
+    quint32 m_nextClient = 0;
+};
+
+}
+
+#endif
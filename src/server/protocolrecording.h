@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLRECORDING_H
+#define KWAYLAND_SERVER_PROTOCOLRECORDING_H
+
+#include <QtGlobal>
+
+namespace KWaylandServer
+{
+
+/**
+ * @brief The header at the start of a protocol recording.
+ *
+ * A recording, see Display::startProtocolRecording, is this header followed by entries of
+ * variable size until the end of the file. All fields are in host byte order, a recording
+ * is meant to be replayed on the machine it was taken on.
+ *
+ * @see ProtocolRecordingEntry
+ * @see ProtocolReplayer
+ * @since 5.22
+ **/
+struct ProtocolRecordingHeader
+{
+    /**
+     * @c KWPR in little endian.
+     **/
+    static constexpr quint32 magicValue = 0x5250574b;
+    static constexpr quint32 currentVersion = 1;
+
+    quint32 magic;
+    quint32 version;
+    quint64 reserved;
+};
+
+/**
+ * @brief A request or a disconnect in a protocol recording.
+ *
+ * A request entry is followed by @c size bytes holding the request in the Wayland wire
+ * format, exactly as the client sent it, and @c fdCount 64 bit sizes of the file descriptors
+ * it carried. The content of the file descriptors is not recorded, a replay passes memfds of
+ * the recorded sizes instead.
+ *
+ * @since 5.22
+ **/
+struct ProtocolRecordingEntry
+{
+    enum Type : quint8 {
+        Request,
+        /**
+         * The client disconnected or was disconnected by the server, @c size and @c fdCount
+         * are @c 0.
+         **/
+        Disconnect
+    };
+    enum Flag : quint8 {
+        /**
+         * The request is a wl_display.get_registry.
+         **/
+        GetRegistry = 0x1,
+        /**
+         * The request is a wl_registry.bind, whose global name has to be mapped to the name
+         * of the global with the same interface when replaying.
+         **/
+        RegistryBind = 0x2
+    };
+
+    /**
+     * CLOCK_MONOTONIC in nanoseconds since the recording started.
+     **/
+    quint64 timestamp;
+    /**
+     * The client, numbered in the order of their first request counting from @c 0.
+     **/
+    quint32 client;
+    quint8 type;
+    quint8 flags;
+    quint16 fdCount;
+    quint32 size;
+    quint32 reserved;
+};
+
+static_assert(sizeof(ProtocolRecordingHeader) == 16, "The recording header is part of the file format");
+static_assert(sizeof(ProtocolRecordingEntry) == 24, "The recording entries are part of the file format");
+
+}
+
+#endif
@@ -0,0 +1,486 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "protocolreplayer.h"
+#include "anonymousfile_p.h"
+#include "display.h"
+#include "display_p.h"
+#include "logging.h"
+#include "protocolrecording.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+// requests sent at maximum speed before the Display gets dispatched
+static const int s_dispatchBatch = 64;
+// libwayland passes at most this many fds with one chunk of data
+static const int s_maxFds = 28;
+// dispatches of the Display waiting for room in a client socket before the client is given up
+static const int s_maxSendAttempts = 1000;
+
+struct ReplayClient
+{
+    int fd = -1;
+    bool failed = false;
+    // events not parsed yet
+    QByteArray input;
+    QSet<quint32> registries;
+    // the global names announced to the client by interface
+    QHash<QByteArray, quint32> globals;
+};
+
+class ProtocolReplayerPrivate
+{
+public:
+    explicit ProtocolReplayerPrivate(Display *display);
+
+    ProtocolRecordingEntry entry(int offset) const;
+    bool connectClient(ReplayClient &client);
+    void closeClient(ReplayClient &client);
+    void fail(ReplayClient &client, int index, const char *reason);
+    bool send(ReplayClient &client, int index, const QByteArray &message, const quint64 *fdSizes, int fdCount);
+    bool readEvents(ReplayClient &client, int index);
+    bool handleEvent(ReplayClient &client, int index, const char *message, quint32 size);
+    void dispatchServer();
+    void waitUntil(const QElapsedTimer &timer, quint64 timestamp);
+
+    Display *display;
+    QByteArray recording;
+    // the offset of every entry in the recording
+    QVector<int> entries;
+    int clientCount = 0;
+    quint64 requestCount = 0;
+    quint64 duration = 0;
+    QVector<ReplayClient> clients;
+    quint64 replayedRequestCount = 0;
+    int failedClientCount = 0;
+};
+
+static quint32 readWord(const char *data)
+{
+    quint32 word;
+    memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+ProtocolReplayerPrivate::ProtocolReplayerPrivate(Display *display)
+    : display(display)
+{
+}
+
+ProtocolRecordingEntry ProtocolReplayerPrivate::entry(int offset) const
+{
+    // the entries are only aligned to 32 bit
+    ProtocolRecordingEntry entry;
+    memcpy(&entry, recording.constData() + offset, sizeof(entry));
+    return entry;
+}
+
+bool ProtocolReplayerPrivate::connectClient(ReplayClient &client)
+{
+    int sv[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0, sv) < 0) {
+        return false;
+    }
+    if (!display->createClient(sv[0])) {
+        close(sv[0]);
+        close(sv[1]);
+        return false;
+    }
+    client.fd = sv[1];
+    return true;
+}
+
+void ProtocolReplayerPrivate::closeClient(ReplayClient &client)
+{
+    if (client.fd >= 0) {
+        close(client.fd);
+        client.fd = -1;
+    }
+}
+
+void ProtocolReplayerPrivate::fail(ReplayClient &client, int index, const char *reason)
+{
+    qCWarning(KWAYLAND_SERVER) << "Stopped the replay of client" << index << ":" << reason;
+    client.failed = true;
+    closeClient(client);
+}
+
+bool ProtocolReplayerPrivate::send(ReplayClient &client, int index, const QByteArray &message, const quint64 *fdSizes, int fdCount)
+{
+    int fds[s_maxFds];
+    for (int i = 0; i < fdCount; ++i) {
+        fds[i] = AnonymousFile::create("kwaylandserver-replay", qint64(fdSizes[i]));
+        if (fds[i] < 0) {
+            for (int j = 0; j < i; ++j) {
+                close(fds[j]);
+            }
+            fail(client, index, "could not create a file descriptor");
+            return false;
+        }
+    }
+
+    bool ok = true;
+    int sent = 0;
+    int attempts = 0;
+    while (sent < message.size()) {
+        iovec iov = {const_cast<char *>(message.constData()) + sent, size_t(message.size() - sent)};
+        msghdr header = {};
+        header.msg_iov = &iov;
+        header.msg_iovlen = 1;
+        char control[CMSG_SPACE(sizeof(int) * s_maxFds)];
+        // the fds go with the first byte of the request
+        if (sent == 0 && fdCount > 0) {
+            header.msg_control = control;
+            header.msg_controllen = CMSG_SPACE(sizeof(int) * fdCount);
+            cmsghdr *cmsg = CMSG_FIRSTHDR(&header);
+            cmsg->cmsg_level = SOL_SOCKET;
+            cmsg->cmsg_type = SCM_RIGHTS;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int) * fdCount);
+            memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * fdCount);
+        }
+        const ssize_t written = sendmsg(client.fd, &header, MSG_NOSIGNAL);
+        if (written >= 0) {
+            sent += written;
+            continue;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        if (errno != EAGAIN || ++attempts > s_maxSendAttempts) {
+            fail(client, index, errno == EAGAIN ? "the server stopped reading" : "disconnected by the server");
+            ok = false;
+            break;
+        }
+        // makes room in the socket
+        dispatchServer();
+        if (client.fd < 0) {
+            ok = false;
+            break;
+        }
+    }
+    for (int i = 0; i < fdCount; ++i) {
+        close(fds[i]);
+    }
+    return ok;
+}
+
+bool ProtocolReplayerPrivate::readEvents(ReplayClient &client, int index)
+{
+    char buffer[4096];
+    char control[CMSG_SPACE(sizeof(int) * s_maxFds)];
+    while (true) {
+        iovec iov = {buffer, sizeof(buffer)};
+        msghdr header = {};
+        header.msg_iov = &iov;
+        header.msg_iovlen = 1;
+        header.msg_control = control;
+        header.msg_controllen = sizeof(control);
+        const ssize_t received = recvmsg(client.fd, &header, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN) {
+                break;
+            }
+            fail(client, index, "disconnected by the server");
+            return false;
+        }
+        if (received == 0) {
+            fail(client, index, "disconnected by the server");
+            return false;
+        }
+        // the fds of the events, e.g. keymaps, are not needed
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+                const int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (int i = 0; i < count; ++i) {
+                    int fd;
+                    memcpy(&fd, CMSG_DATA(cmsg) + i * sizeof(int), sizeof(fd));
+                    close(fd);
+                }
+            }
+        }
+        client.input.append(buffer, received);
+    }
+
+    int offset = 0;
+    while (client.input.size() - offset >= 8) {
+        const quint32 size = readWord(client.input.constData() + offset + 4) >> 16;
+        if (size < 8) {
+            fail(client, index, "received a malformed event");
+            return false;
+        }
+        if (quint32(client.input.size() - offset) < size) {
+            break;
+        }
+        if (!handleEvent(client, index, client.input.constData() + offset, size)) {
+            return false;
+        }
+        offset += size;
+    }
+    client.input.remove(0, offset);
+    return true;
+}
+
+bool ProtocolReplayerPrivate::handleEvent(ReplayClient &client, int index, const char *message, quint32 size)
+{
+    const quint32 id = readWord(message);
+    const quint32 opcode = readWord(message + 4) & 0xffff;
+    if (id == 1 && opcode == 0) {
+        // wl_display.error
+        QByteArray reason = QByteArrayLiteral("protocol error");
+        if (size > 20) {
+            reason += ": " + QByteArray(message + 20, int(qMin(readWord(message + 16), size - 20))).chopped(1);
+        }
+        fail(client, index, reason.constData());
+        return false;
+    }
+    if (!client.registries.contains(id)) {
+        return true;
+    }
+    if (opcode == 0 && size >= 16) {
+        // wl_registry.global, the first global of an interface is bound
+        const quint32 name = readWord(message + 8);
+        const quint32 length = readWord(message + 12);
+        if (length > 0 && length <= size - 16) {
+            const QByteArray interface(message + 16, int(length) - 1);
+            if (!client.globals.contains(interface)) {
+                client.globals.insert(interface, name);
+            }
+        }
+    } else if (opcode == 1 && size >= 12) {
+        // wl_registry.global_remove
+        const quint32 name = readWord(message + 8);
+        for (auto it = client.globals.begin(); it != client.globals.end();) {
+            if (it.value() == name) {
+                it = client.globals.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+    return true;
+}
+
+void ProtocolReplayerPrivate::dispatchServer()
+{
+    display->dispatchEvents();
+    display->flush();
+    for (int i = 0; i < clients.count(); ++i) {
+        if (clients[i].fd >= 0) {
+            readEvents(clients[i], i);
+        }
+    }
+}
+
+void ProtocolReplayerPrivate::waitUntil(const QElapsedTimer &timer, quint64 timestamp)
+{
+    const int loopFd = wl_event_loop_get_fd(DisplayPrivate::get(display)->loop);
+    while (true) {
+        const qint64 remaining = qint64(timestamp) - timer.nsecsElapsed();
+        if (remaining <= 0) {
+            return;
+        }
+        QVector<pollfd> fds;
+        fds.append({loopFd, POLLIN, 0});
+        for (const ReplayClient &client : qAsConst(clients)) {
+            if (client.fd >= 0) {
+                fds.append({client.fd, POLLIN, 0});
+            }
+        }
+        poll(fds.data(), fds.count(), int((remaining + 999999) / 1000000));
+        dispatchServer();
+    }
+}
+
+ProtocolReplayer::ProtocolReplayer(Display *display)
+    : d(new ProtocolReplayerPrivate(display))
+{
+}
+
+ProtocolReplayer::~ProtocolReplayer() = default;
+
+bool ProtocolReplayer::load(const QString &fileName)
+{
+    d->recording.clear();
+    d->entries.clear();
+    d->clientCount = 0;
+    d->requestCount = 0;
+    d->duration = 0;
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to open the protocol recording" << fileName << ":" << file.errorString();
+        return false;
+    }
+    QByteArray recording = file.readAll();
+    ProtocolRecordingHeader header;
+    if (recording.size() < int(sizeof(header))) {
+        qCWarning(KWAYLAND_SERVER) << fileName << "is no protocol recording";
+        return false;
+    }
+    memcpy(&header, recording.constData(), sizeof(header));
+    if (header.magic != ProtocolRecordingHeader::magicValue || header.version != ProtocolRecordingHeader::currentVersion) {
+        qCWarning(KWAYLAND_SERVER) << fileName << "is no protocol recording of version" << ProtocolRecordingHeader::currentVersion;
+        return false;
+    }
+
+    QVector<int> entries;
+    int clientCount = 0;
+    quint64 requestCount = 0;
+    quint64 duration = 0;
+    int offset = sizeof(header);
+    while (offset < recording.size()) {
+        ProtocolRecordingEntry entry;
+        if (recording.size() - offset < int(sizeof(entry))) {
+            qCWarning(KWAYLAND_SERVER) << "The protocol recording" << fileName << "is truncated";
+            return false;
+        }
+        memcpy(&entry, recording.constData() + offset, sizeof(entry));
+        const qint64 end = qint64(offset) + sizeof(entry) + entry.size + entry.fdCount * sizeof(quint64);
+        const bool valid = entry.type == ProtocolRecordingEntry::Disconnect
+            ? entry.size == 0 && entry.fdCount == 0
+            : entry.type == ProtocolRecordingEntry::Request && entry.size >= 8 && entry.size % 4 == 0 && entry.fdCount <= s_maxFds;
+        if (!valid || end > recording.size() || entry.client >= 0xffff) {
+            qCWarning(KWAYLAND_SERVER) << "The protocol recording" << fileName << "is corrupted at offset" << offset;
+            return false;
+        }
+        entries.append(offset);
+        clientCount = qMax(clientCount, int(entry.client) + 1);
+        if (entry.type == ProtocolRecordingEntry::Request) {
+            requestCount++;
+        }
+        duration = qMax(duration, entry.timestamp);
+        offset = int(end);
+    }
+
+    d->recording = recording;
+    d->entries = entries;
+    d->clientCount = clientCount;
+    d->requestCount = requestCount;
+    d->duration = duration;
+    return true;
+}
+
+int ProtocolReplayer::clientCount() const
+{
+    return d->clientCount;
+}
+
+quint64 ProtocolReplayer::requestCount() const
+{
+    return d->requestCount;
+}
+
+quint64 ProtocolReplayer::duration() const
+{
+    return d->duration;
+}
+
+bool ProtocolReplayer::replay(Speed speed)
+{
+    d->clients.clear();
+    d->clients.resize(d->clientCount);
+    d->replayedRequestCount = 0;
+    QVector<bool> disconnected(d->clientCount, false);
+
+    QElapsedTimer timer;
+    timer.start();
+    int batch = 0;
+    for (int offset : qAsConst(d->entries)) {
+        const ProtocolRecordingEntry entry = d->entry(offset);
+        if (speed == Speed::Original) {
+            d->waitUntil(timer, entry.timestamp);
+        }
+        const int index = int(entry.client);
+        ReplayClient &client = d->clients[index];
+        if (client.failed || disconnected[index]) {
+            continue;
+        }
+        if (entry.type == ProtocolRecordingEntry::Disconnect) {
+            d->closeClient(client);
+            disconnected[index] = true;
+            continue;
+        }
+        if (client.fd < 0 && !d->connectClient(client)) {
+            d->fail(client, index, "could not connect");
+            continue;
+        }
+
+        const char *data = d->recording.constData() + offset + sizeof(entry);
+        QByteArray message(data, int(entry.size));
+        if (entry.flags & ProtocolRecordingEntry::GetRegistry && entry.size >= 12) {
+            client.registries.insert(readWord(data + 8));
+        }
+        if (entry.flags & ProtocolRecordingEntry::RegistryBind && entry.size >= 16) {
+            const quint32 length = readWord(data + 12);
+            if (length == 0 || length > entry.size - 16) {
+                d->fail(client, index, "recorded a malformed wl_registry.bind");
+                continue;
+            }
+            const QByteArray interface(data + 16, int(length) - 1);
+            if (!client.globals.contains(interface)) {
+                // the globals are announced once the wl_display.get_registry got dispatched
+                d->dispatchServer();
+            }
+            const auto it = client.globals.constFind(interface);
+            if (it == client.globals.constEnd()) {
+                d->fail(client, index, QByteArray(interface + " is not offered by the Display").constData());
+                continue;
+            }
+            const quint32 name = it.value();
+            memcpy(message.data() + 8, &name, sizeof(name));
+        }
+
+        quint64 fdSizes[s_maxFds];
+        memcpy(fdSizes, data + entry.size, entry.fdCount * sizeof(quint64));
+        if (!d->send(client, index, message, fdSizes, entry.fdCount)) {
+            continue;
+        }
+        d->replayedRequestCount++;
+        if (speed == Speed::Maximum && ++batch >= s_dispatchBatch) {
+            d->dispatchServer();
+            batch = 0;
+        }
+    }
+    d->dispatchServer();
+
+    d->failedClientCount = 0;
+    for (ReplayClient &client : d->clients) {
+        if (client.failed) {
+            d->failedClientCount++;
+        }
+        d->closeClient(client);
+    }
+    // lets the Display notice the hang ups
+    d->dispatchServer();
+    return d->failedClientCount == 0;
+}
+
+quint64 ProtocolReplayer::replayedRequestCount() const
+{
+    return d->replayedRequestCount;
+}
+
+int ProtocolReplayer::failedClientCount() const
+{
+    return d->failedClientCount;
+}
+
+}
@@ -0,0 +1,107 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLREPLAYER_H
+#define KWAYLAND_SERVER_PROTOCOLREPLAYER_H
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QScopedPointer>
+#include <QString>
+
+namespace KWaylandServer
+{
+
+class Display;
+class ProtocolReplayerPrivate;
+
+/**
+ * @brief Sends the requests of a protocol recording to a Display.
+ *
+ * Every client of the recording is connected to the Display through a socket pair and its
+ * requests are written to the socket as they were recorded, see
+ * Display::startProtocolRecording. The Display is dispatched by the replayer itself, so the
+ * Display has to be started and should offer the same globals as the recording compositor
+ * did. A wl_registry.bind of a global whose interface the Display doesn't offer stops the
+ * replay of that client.
+ *
+ * This is meant for comparing the server side cost of a captured session between releases,
+ * the events sent to the replayed clients are read and discarded. The content of file
+ * descriptors isn't part of a recording, so the clients pass empty memfds of the recorded
+ * sizes, e.g. for shm pools.
+ *
+ * @code
+ * Display display;
+ * display.start();
+ * // create the globals of the recording compositor
+ * ProtocolReplayer replayer(&display);
+ * if (replayer.load(QStringLiteral("session.kwpr"))) {
+ *     replayer.replay(ProtocolReplayer::Speed::Maximum);
+ * }
+ * @endcode
+ *
+ * @see ProtocolRecordingHeader
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT ProtocolReplayer
+{
+public:
+    enum class Speed {
+        /**
+         * Every request is sent at the time it was recorded.
+         **/
+        Original,
+        /**
+         * The requests are sent as fast as the Display handles them.
+         **/
+        Maximum
+    };
+
+    explicit ProtocolReplayer(Display *display);
+    ~ProtocolReplayer();
+
+    /**
+     * Reads the recording in @p fileName.
+     * @returns @c false if the file can't be read or is no valid recording.
+     **/
+    bool load(const QString &fileName);
+    /**
+     * @returns The number of clients in the loaded recording.
+     **/
+    int clientCount() const;
+    /**
+     * @returns The number of requests in the loaded recording.
+     **/
+    quint64 requestCount() const;
+    /**
+     * @returns The time from the start of the recording to its last entry in nanoseconds.
+     **/
+    quint64 duration() const;
+
+    /**
+     * Replays the loaded recording, returns once all requests have been sent and handled.
+     * All replayed clients are disconnected at the end.
+     *
+     * @returns @c false if a client could not be replayed completely, e.g. because the
+     * Display posted a protocol error.
+     **/
+    bool replay(Speed speed = Speed::Maximum);
+    /**
+     * @returns The number of requests sent by the last replay().
+     **/
+    quint64 replayedRequestCount() const;
+    /**
+     * @returns The number of clients the last replay() could not replay completely.
+     **/
+    int failedClientCount() const;
+
+private:
+    Q_DISABLE_COPY(ProtocolReplayer)
+    QScopedPointer<ProtocolReplayerPrivate> d;
+};
+
+}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "protocolstatistics.h"
+#include "protocolstatistics_p.h"
+#include "clientconnection.h"
+#include "clientconnection_p.h"
+#include "logging.h"
+#include "protocolmessage_p.h"
+
+#include <algorithm>
+
+#include <string.h>
+
+namespace KWaylandServer
+{
+
+static quint64 padded(quint64 size)
+{
+    return (size + 3) & ~quint64(3);
+}
+
+static quint64 messageSize(const wl_protocol_logger_message *message)
+{
+    // every message starts with the object id, the opcode and the size
+    quint64 size = 8;
+    forEachArgument(message, [&size](char type, const wl_argument &value) {
+        switch (type) {
+        case 'i':
+        case 'u':
+        case 'f':
+        case 'o':
+        case 'n':
+            size += 4;
+            break;
+        case 's':
+            size += 4 + (value.s ? padded(strlen(value.s) + 1) : 0);
+            break;
+        case 'a':
+            size += 4 + (value.a ? padded(value.a->size) : 0);
+            break;
+        case 'h':
+            // file descriptors are passed out of band
+            break;
+        }
+    });
+    return size;
+}
+
+void ProtocolStatisticsRecorder::setEnabled(wl_display *display, bool enabled)
+{
+    if (enabled == isEnabled()) {
+        return;
+    }
+    if (enabled) {
+        m_logger = wl_display_add_protocol_logger(display, logger, this);
+    } else {
+        wl_protocol_logger_destroy(m_logger);
+        m_logger = nullptr;
+    }
+}
+
+void ProtocolStatisticsRecorder::logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message)
+{
+    auto recorder = static_cast<ProtocolStatisticsRecorder *>(data);
+    // don't create a ClientConnection for a client which is being destroyed
+    ClientConnection *client = ClientConnectionPrivate::fromClient(wl_resource_get_client(message->resource));
+    if (!client) {
+        return;
+    }
+    const auto direction = type == WL_PROTOCOL_LOGGER_REQUEST ? ProtocolMessageStatistics::Direction::Request
+                                                              : ProtocolMessageStatistics::Direction::Event;
+    Counter &counter = recorder->m_counters[client][Key(message->message, int(direction))];
+    if (!counter.interface) {
+        counter.interface = wl_resource_get_class(message->resource);
+        counter.opcode = message->message_opcode;
+    }
+    counter.count++;
+    counter.bytes += messageSize(message);
+}
+
+void ProtocolStatisticsRecorder::removeClient(ClientConnection *client)
+{
+    m_counters.remove(client);
+}
+
+void ProtocolStatisticsRecorder::reset()
+{
+    m_counters.clear();
+}
+
+ProtocolMessageStatistics ProtocolStatisticsRecorder::entry(ClientConnection *client, const Key &key, const Counter &counter)
+{
+    ProtocolMessageStatistics statistics;
+    statistics.client = client;
+    statistics.interface = QByteArray(counter.interface);
+    statistics.message = QByteArray(key.first->name);
+    statistics.opcode = counter.opcode;
+    statistics.direction = ProtocolMessageStatistics::Direction(key.second);
+    statistics.count = counter.count;
+    statistics.bytes = counter.bytes;
+    return statistics;
+}
+
+ProtocolStatistics ProtocolStatisticsRecorder::statistics() const
+{
+    ProtocolStatistics ret;
+    for (auto it = m_counters.constBegin(); it != m_counters.constEnd(); ++it) {
+        ret += statistics(it.key());
+    }
+    return ret;
+}
+
+ProtocolStatistics ProtocolStatisticsRecorder::statistics(ClientConnection *client) const
+{
+    ProtocolStatistics ret;
+    const Counters counters = m_counters.value(client);
+    ret.reserve(counters.count());
+    for (auto it = counters.constBegin(); it != counters.constEnd(); ++it) {
+        ret.append(entry(client, it.key(), it.value()));
+    }
+    return ret;
+}
+
+void ProtocolStatisticsRecorder::dump(int limit) const
+{
+    ProtocolStatistics entries = statistics();
+    std::sort(entries.begin(), entries.end(),
+        [] (const ProtocolMessageStatistics &a, const ProtocolMessageStatistics &b) {
+            return a.bytes > b.bytes;
+        }
+    );
+    if (entries.count() > limit) {
+        entries.resize(limit);
+    }
+    for (const ProtocolMessageStatistics &statistics : qAsConst(entries)) {
+        qCInfo(KWAYLAND_SERVER, "pid %d %s %s.%s: %llu messages, %llu bytes",
+               int(statistics.client->processId()),
+               statistics.direction == ProtocolMessageStatistics::Direction::Request ? "request" : "event",
+               statistics.interface.constData(), statistics.message.constData(),
+               statistics.count, statistics.bytes);
+    }
+}
+
+}
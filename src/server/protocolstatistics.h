@@ -0,0 +1,63 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLSTATISTICS_H
+#define KWAYLAND_SERVER_PROTOCOLSTATISTICS_H
+
+#include <QByteArray>
+#include <QVector>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+
+class ClientConnection;
+
+/**
+ * @brief The number of times a client sent or received one message of a Wayland interface.
+ *
+ * @see Display::protocolStatistics
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT ProtocolMessageStatistics
+{
+    enum class Direction {
+        /**
+         * A request sent by the client.
+         **/
+        Request,
+        /**
+         * An event sent to the client.
+         **/
+        Event
+    };
+    /**
+     * The client which sent or received the message. The pointer is only meant to identify
+     * the client and may belong to a client that has disconnected since.
+     **/
+    ClientConnection *client = nullptr;
+    /**
+     * The name of the interface, e.g. @c wl_surface.
+     **/
+    QByteArray interface;
+    /**
+     * The name of the request or event, e.g. @c commit.
+     **/
+    QByteArray message;
+    quint32 opcode = 0;
+    Direction direction = Direction::Request;
+    quint64 count = 0;
+    /**
+     * The size of the messages on the wire, excluding file descriptors.
+     **/
+    quint64 bytes = 0;
+};
+
+typedef QVector<ProtocolMessageStatistics> ProtocolStatistics;
+
+}
+
+#endif
@@ -0,0 +1,64 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLSTATISTICS_P_H
+#define KWAYLAND_SERVER_PROTOCOLSTATISTICS_P_H
+
+#include "protocolstatistics.h"
+
+#include <QHash>
+#include <QPair>
+
+#include <wayland-server-core.h>
+
+namespace KWaylandServer
+{
+
+/**
+ * Counts the protocol messages of a wl_display through a protocol logger. The logger is
+ * only installed while the statistics are enabled and has to be removed before the
+ * wl_display is destroyed.
+ */
+class ProtocolStatisticsRecorder
+{
+public:
+    bool isEnabled() const {
+        return m_logger;
+    }
+    void setEnabled(wl_display *display, bool enabled);
+
+    void removeClient(ClientConnection *client);
+    void reset();
+
+    ProtocolStatistics statistics() const;
+    ProtocolStatistics statistics(ClientConnection *client) const;
+
+    /**
+     * Logs the @p limit message kinds with the most bytes.
+     */
+    void dump(int limit) const;
+
+private:
+    struct Counter {
+        const char *interface = nullptr;
+        quint32 opcode = 0;
+        quint64 count = 0;
+        quint64 bytes = 0;
+    };
+    // the message descriptions are static data of the interfaces, so they identify a message;
+    // the second member is the ProtocolMessageStatistics::Direction
+    typedef QPair<const wl_message *, int> Key;
+    typedef QHash<Key, Counter> Counters;
+
+    static void logger(void *data, wl_protocol_logger_type type, const wl_protocol_logger_message *message);
+    static ProtocolMessageStatistics entry(ClientConnection *client, const Key &key, const Counter &counter);
+
+    wl_protocol_logger *m_logger = nullptr;
+    QHash<ClientConnection *, Counters> m_counters;
+};
+
+}
+
+#endif
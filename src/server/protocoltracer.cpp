@@ -0,0 +1,44 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "protocoltracer.h"
+#include "protocoltracer_p.h"
+
+#include <config-kwaylandserver.h>
+
+namespace KWaylandServer
+{
+
+ProtocolTracer *ProtocolTracerPrivate::tracer = nullptr;
+
+ProtocolTracer::~ProtocolTracer()
+{
+    if (ProtocolTracerPrivate::tracer == this) {
+        ProtocolTracerPrivate::tracer = nullptr;
+    }
+}
+
+void ProtocolTracer::event(const char *interface, const char *event)
+{
+    Q_UNUSED(interface)
+    Q_UNUSED(event)
+}
+
+void ProtocolTracer::setTracer(ProtocolTracer *tracer)
+{
+    ProtocolTracerPrivate::tracer = tracer;
+}
+
+ProtocolTracer *ProtocolTracer::tracer()
+{
+    return ProtocolTracerPrivate::tracer;
+}
+
+bool ProtocolTracer::isSupported()
+{
+    return KWAYLANDSERVER_TRACING;
+}
+
+}
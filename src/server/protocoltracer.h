@@ -0,0 +1,67 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLTRACER_H
+#define KWAYLAND_SERVER_PROTOCOLTRACER_H
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+
+/**
+ * @brief Receives the requests handled and the events sent by the generated protocol code.
+ *
+ * A profiler backend implements this interface and installs itself with setTracer(). The
+ * request handlers of all protocols implemented with the generated code call beginRequest()
+ * when they start and endRequest() when they return, which allows attributing server time
+ * per protocol request. Requests handled while no tracer is installed cost one pointer
+ * compare.
+ *
+ * The hooks are only built with the KWAYLANDSERVER_TRACING build option, see isSupported().
+ * All methods are called from the thread dispatching the Display.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT ProtocolTracer
+{
+public:
+    virtual ~ProtocolTracer();
+
+    /**
+     * Called before the handler of @p request of @p interface runs. The names are string
+     * literals, e.g. @c "wl_surface" and @c "commit", that stay valid for the lifetime of the
+     * process.
+     **/
+    virtual void beginRequest(const char *interface, const char *request) = 0;
+    /**
+     * Called after the handler of @p request of @p interface returned.
+     **/
+    virtual void endRequest(const char *interface, const char *request) = 0;
+    /**
+     * Called when @p event of @p interface is sent to one resource or broadcast to all
+     * resources of an object. The default implementation does nothing.
+     **/
+    virtual void event(const char *interface, const char *event);
+
+    /**
+     * Installs @p tracer, @c null uninstalls the current tracer. The tracer is not owned and
+     * must stay alive until it is uninstalled; it must not be replaced from within its own
+     * callbacks.
+     **/
+    static void setTracer(ProtocolTracer *tracer);
+    /**
+     * @returns The installed tracer or @c null.
+     **/
+    static ProtocolTracer *tracer();
+    /**
+     * @returns Whether the library was built with the protocol trace hooks.
+     **/
+    static bool isSupported();
+};
+
+}
+
+#endif
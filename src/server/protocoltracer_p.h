@@ -0,0 +1,62 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_PROTOCOLTRACER_P_H
+#define KWAYLAND_SERVER_PROTOCOLTRACER_P_H
+
+#include "protocoltracer.h"
+
+#include <QtGlobal>
+
+namespace KWaylandServer
+{
+
+class ProtocolTracerPrivate
+{
+public:
+    static ProtocolTracer *tracer;
+};
+
+/**
+ * Reports the request handled in its scope to the installed ProtocolTracer.
+ */
+class ProtocolTraceScope
+{
+public:
+    ProtocolTraceScope(const char *interface, const char *request)
+        : m_tracer(ProtocolTracerPrivate::tracer)
+        , m_interface(interface)
+        , m_request(request)
+    {
+        if (Q_UNLIKELY(m_tracer)) {
+            m_tracer->beginRequest(m_interface, m_request);
+        }
+    }
+    ~ProtocolTraceScope()
+    {
+        if (Q_UNLIKELY(m_tracer)) {
+            m_tracer->endRequest(m_interface, m_request);
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(ProtocolTraceScope)
+    ProtocolTracer *m_tracer;
+    const char *m_interface;
+    const char *m_request;
+};
+
+}
+
+// the hooks the generated protocol code is wrapped in, see ecm_add_qtwayland_server_protocol_kde()
+#define QTWAYLANDSERVER_TRACE_REQUEST(interface, request) \
+    KWaylandServer::ProtocolTraceScope protocolTraceScope(interface, request)
+#define QTWAYLANDSERVER_TRACE_EVENT(interface, event) \
+    do { \
+        if (Q_UNLIKELY(KWaylandServer::ProtocolTracerPrivate::tracer)) \
+            KWaylandServer::ProtocolTracerPrivate::tracer->event(interface, event); \
+    } while (false)
+
+#endif
@@ -0,0 +1,82 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "rectaccumulator_p.h"
+
+namespace KWaylandServer
+{
+
+void RectAccumulator::setMaximumCount(int count)
+{
+    m_maximumCount = count;
+}
+
+int RectAccumulator::maximumCount() const
+{
+    return m_maximumCount;
+}
+
+bool RectAccumulator::isEmpty() const
+{
+    return m_boundingRect.isEmpty();
+}
+
+void RectAccumulator::add(const QRect &rect)
+{
+    if (rect.isEmpty()) {
+        return;
+    }
+    m_boundingRect |= rect;
+    if (m_simplified) {
+        return;
+    }
+    if (m_maximumCount > 0 && m_rects.count() >= m_maximumCount) {
+        m_rects.clear();
+        m_simplified = true;
+        return;
+    }
+    // consecutive requests often repeat or extend the previous rectangle
+    if (!m_rects.isEmpty() && m_rects.last().contains(rect)) {
+        return;
+    }
+    m_rects.append(rect);
+}
+
+void RectAccumulator::clear()
+{
+    m_rects.clear();
+    m_boundingRect = QRect();
+    m_simplified = false;
+}
+
+static QRegion unite(const QRect *rects, int count)
+{
+    if (count == 1) {
+        return QRegion(rects[0]);
+    }
+    const int half = count / 2;
+    return unite(rects, half).united(unite(rects + half, count - half));
+}
+
+QRegion RectAccumulator::region() const
+{
+    if (m_simplified) {
+        return m_boundingRect;
+    }
+    if (m_rects.isEmpty()) {
+        return QRegion();
+    }
+    return unite(m_rects.constData(), m_rects.count());
+}
+
+QRegion RectAccumulator::take()
+{
+    const QRegion result = region();
+    clear();
+    return result;
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,56 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <QRect>
+#include <QRegion>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+/**
+ * Collects rectangles which are united into a QRegion only once they are needed.
+ *
+ * Uniting a QRegion with a rectangle rebuilds its bands, so a client sending many small
+ * rectangles one request at a time costs quadratic time. The accumulator only appends them
+ * and unites them pairwise in the end.
+ *
+ * Past the maximum count, the rectangles are replaced with their bounding rectangle. This
+ * bounds the memory a client can make the compositor allocate between two commits.
+ */
+class RectAccumulator
+{
+public:
+    /**
+     * Sets the number of rectangles above which only the bounding rectangle is kept, @c 0
+     * disables the limit.
+     */
+    void setMaximumCount(int count);
+    int maximumCount() const;
+
+    bool isEmpty() const;
+    void add(const QRect &rect);
+    void clear();
+
+    /**
+     * Returns the union of all added rectangles.
+     */
+    QRegion region() const;
+    /**
+     * Returns the union of all added rectangles and clears the accumulator.
+     */
+    QRegion take();
+
+private:
+    QVector<QRect> m_rects;
+    QRect m_boundingRect;
+    int m_maximumCount = 0;
+    bool m_simplified = false;
+};
+
+} // namespace KWaylandServer
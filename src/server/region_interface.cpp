@@ -6,8 +6,11 @@
 */
 #include "region_interface.h"
 #include "compositor_interface.h"
+#include "rectaccumulator_p.h"
 #include "utils.h"
 
+#include <QMetaMethod>
+
 #include "qwayland-server-wayland.h"
 
 namespace KWaylandServer
@@ -18,8 +21,16 @@ class RegionInterfacePrivate : public QtWaylandServer::wl_region
 public:
     RegionInterfacePrivate(RegionInterface *q, wl_resource *resource);
 
+    /**
+     * Unites the added rectangles with the region.
+     */
+    void flush();
+    void notifyChanged();
+
     RegionInterface *q;
     QRegion qtRegion;
+    // the rectangles added since the region was last needed
+    RectAccumulator pendingRects;
 
 protected:
     void region_destroy_resource(Resource *resource) override;
@@ -44,16 +55,34 @@ void RegionInterfacePrivate::region_destroy(Resource *resource)
     wl_resource_destroy(resource->handle);
 }
 
+void RegionInterfacePrivate::flush()
+{
+    if (!pendingRects.isEmpty()) {
+        qtRegion += pendingRects.take();
+    }
+}
+
+void RegionInterfacePrivate::notifyChanged()
+{
+    // Building the region for every request would defeat accumulating the rectangles.
+    static const QMetaMethod regionChangedSignal = QMetaMethod::fromSignal(&RegionInterface::regionChanged);
+    if (q->isSignalConnected(regionChangedSignal)) {
+        flush();
+        emit q->regionChanged(qtRegion);
+    }
+}
+
 void RegionInterfacePrivate::region_add(Resource *, int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    qtRegion += QRegion(x, y, width, height);
-    emit q->regionChanged(qtRegion);
+    pendingRects.add(QRect(x, y, width, height));
+    notifyChanged();
 }
 
 void RegionInterfacePrivate::region_subtract(Resource *, int32_t x, int32_t y, int32_t width, int32_t height)
 {
+    flush();
     qtRegion -= QRegion(x, y, width, height);
-    emit q->regionChanged(qtRegion);
+    notifyChanged();
 }
 
 RegionInterface::RegionInterface(CompositorInterface *compositor, wl_resource *resource)
@@ -68,6 +97,7 @@ RegionInterface::~RegionInterface()
 
 QRegion RegionInterface::region() const
 {
+    d->flush();
     return d->qtRegion;
 }
 
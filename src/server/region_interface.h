@@ -52,6 +52,7 @@ Q_SIGNALS:
 
 private:
     friend class CompositorInterfacePrivate;
+    friend class RegionInterfacePrivate;
     explicit RegionInterface(CompositorInterface *compositor, wl_resource *resource);
     QScopedPointer<RegionInterfacePrivate> d;
 };
@@ -0,0 +1,50 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "regioninterner_p.h"
+
+namespace KWaylandServer
+{
+
+RegionInterner::RegionInterner(int capacity)
+    : m_capacity(capacity)
+{
+    m_regions.reserve(capacity);
+}
+
+QRegion RegionInterner::intern(const QRegion &region)
+{
+    if (region.isEmpty()) {
+        return QRegion();
+    }
+    if (m_capacity <= 0) {
+        return region;
+    }
+
+    const QRect boundingRect = region.boundingRect();
+    const int rectCount = region.rectCount();
+    for (int i = 0; i < m_regions.count(); ++i) {
+        const QRegion &candidate = m_regions[i];
+        // cheap checks first, comparing the rectangles is linear in their count
+        if (candidate.rectCount() != rectCount || candidate.boundingRect() != boundingRect) {
+            continue;
+        }
+        if (candidate == region) {
+            if (i != 0) {
+                m_regions.move(i, 0);
+            }
+            return m_regions.first();
+        }
+    }
+
+    if (m_regions.count() == m_capacity) {
+        m_regions.removeLast();
+    }
+    m_regions.prepend(region);
+    return region;
+}
+
+} // namespace KWaylandServer
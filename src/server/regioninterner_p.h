@@ -0,0 +1,40 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <QRegion>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+/**
+ * Hands out one shared QRegion for all equal regions it has recently seen.
+ *
+ * Clients tend to send the same few regions over and over, e.g. the blur region of every
+ * panel or menu with the same rounded corners, or the same region again for every frame of
+ * an animation. Interned regions share their data, which saves memory and makes comparing
+ * them cheap, since QRegion compares the shared data before comparing the rectangles.
+ */
+class RegionInterner
+{
+public:
+    explicit RegionInterner(int capacity = 16);
+
+    /**
+     * Returns a region equal to @p region which shares its data with the previous regions
+     * equal to it.
+     */
+    QRegion intern(const QRegion &region);
+
+private:
+    // most recently used first
+    QVector<QRegion> m_regions;
+    int m_capacity;
+};
+
+} // namespace KWaylandServer
@@ -12,8 +12,6 @@
 namespace KWaylandServer
 {
 
-QList<Resource::Private*> Resource::Private::s_allResources;
-
 Resource::Private::Private(Resource *q, Global *g, wl_resource *parentResource, const wl_interface *interface, const void *implementation)
     : parentResource(parentResource)
     , global(g)
@@ -21,12 +19,13 @@ Resource::Private::Private(Resource *q, Global *g, wl_resource *parentResource,
     , m_interface(interface)
     , m_interfaceImplementation(implementation)
 {
-    s_allResources << this;
+    m_lookupListener.d = this;
+    m_lookupListener.listener.notify = lookupListenerCallback;
+    wl_list_init(&m_lookupListener.listener.link);
 }
 
 Resource::Private::~Private()
 {
-    s_allResources.removeAll(this);
     if (resource) {
         wl_resource_destroy(resource);
     }
@@ -42,6 +41,14 @@ void Resource::Private::create(ClientConnection *c, quint32 version, quint32 id)
         return;
     }
     wl_resource_set_implementation(resource, m_interfaceImplementation, this, unbind);
+    wl_resource_add_destroy_listener(resource, &m_lookupListener.listener);
+}
+
+void Resource::Private::lookupListenerCallback(wl_listener *listener, void *data)
+{
+    Q_UNUSED(data)
+    wl_list_remove(&listener->link);
+    wl_list_init(&listener->link);
 }
 
 void Resource::Private::unbind(wl_resource *r)
@@ -31,29 +31,12 @@ public:
         if (!native) {
             return nullptr;
         }
-        auto it = std::find_if(s_allResources.constBegin(), s_allResources.constEnd(),
-            [native](Private *p) {
-                return p->resource == native;
-            }
-        );
-        if (it == s_allResources.constEnd()) {
+        wl_listener *listener = wl_resource_get_destroy_listener(native, lookupListenerCallback);
+        if (!listener) {
             return nullptr;
         }
-        return reinterpret_cast<ResourceDerived*>((*it)->q);
-    }
-    template <typename ResourceDerived>
-    static ResourceDerived *get(quint32 id, const ClientConnection *c) {
-        static_assert(std::is_base_of<Resource, ResourceDerived>::value,
-                      "ResourceDerived must be derived from Resource");
-        auto it = std::find_if(s_allResources.constBegin(), s_allResources.constEnd(),
-            [id, c](Private *p) {
-                return c == p->client && p->resource && wl_resource_get_id(p->resource) == id;
-            }
-        );
-        if (it == s_allResources.constEnd()) {
-            return nullptr;
-        }
-        return reinterpret_cast<ResourceDerived*>((*it)->q);
+        LookupListener *lookupListener = wl_container_of(listener, lookupListener, listener);
+        return reinterpret_cast<ResourceDerived*>(lookupListener->d->q);
     }
 
 protected:
@@ -69,9 +52,15 @@ protected:
     static void resourceDestroyedCallback(wl_client *client, wl_resource *resource);
 
     Resource *q;
-    static QList<Private*> s_allResources;
 
 private:
+    static void lookupListenerCallback(wl_listener *listener, void *data);
+
+    // identifies resources created by a Resource, see get()
+    struct LookupListener {
+        wl_listener listener;
+        Private *d;
+    } m_lookupListener;
     const wl_interface *const m_interface;
     const void *const m_interfaceImplementation;
 };
@@ -0,0 +1,84 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_RESOURCEPOOL_P_H
+#define KWAYLAND_SERVER_RESOURCEPOOL_P_H
+
+#include <QtGlobal>
+
+#include <cstddef>
+#include <new>
+
+QT_BEGIN_NAMESPACE
+
+// included by the generated code of the protocols with POOLED_RESOURCES, the Resource classes
+// of the pooled interfaces allocate through a ResourceAllocator
+namespace QtWaylandServer
+{
+
+class ResourceAllocator
+{
+public:
+    virtual ~ResourceAllocator() {}
+    virtual void *allocate(std::size_t size) = 0;
+    virtual void deallocate(void *pointer, std::size_t size) = 0;
+};
+
+/**
+ * Keeps up to MaximumFreeBlocks freed blocks of the most common size for reuse.
+ */
+class ResourcePool : public ResourceAllocator
+{
+public:
+    ~ResourcePool() override
+    {
+        while (m_free) {
+            Block *block = m_free;
+            m_free = block->next;
+            ::operator delete(block);
+        }
+    }
+
+    void *allocate(std::size_t size) override
+    {
+        if (!m_blockSize && size >= sizeof(Block)) {
+            m_blockSize = size;
+        }
+        if (size == m_blockSize && m_free) {
+            Block *block = m_free;
+            m_free = block->next;
+            m_freeCount--;
+            return block;
+        }
+        return ::operator new(size);
+    }
+
+    void deallocate(void *pointer, std::size_t size) override
+    {
+        if (size != m_blockSize || m_freeCount >= MaximumFreeBlocks) {
+            ::operator delete(pointer);
+            return;
+        }
+        Block *block = static_cast<Block *>(pointer);
+        block->next = m_free;
+        m_free = block;
+        m_freeCount++;
+    }
+
+private:
+    struct Block {
+        Block *next;
+    };
+    enum { MaximumFreeBlocks = 1024 };
+    Block *m_free = nullptr;
+    std::size_t m_blockSize = 0;
+    int m_freeCount = 0;
+};
+
+}
+
+QT_END_NAMESPACE
+
+#endif
@@ -7,15 +7,22 @@
 #include "screencast_v1_interface.h"
 #include "display.h"
 #include "output_interface.h"
+#include "plasmawindowmanagement_interface.h"
+#include "surface_interface.h"
 
 #include <QDebug>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+
+#include <climits>
 
 #include "qwayland-server-zkde-screencast-unstable-v1.h"
 
 namespace KWaylandServer
 {
 
-static int s_version = 1;
+static int s_version = 3;
 
 class ScreencastStreamV1InterfacePrivate : public QtWaylandServer::zkde_screencast_stream_unstable_v1
 {
@@ -42,10 +49,50 @@ public:
         wl_resource_destroy(resource->handle);
     }
 
+    void scheduleFrame();
+
     bool stopped = false;
     ScreencastStreamV1Interface *const q;
+    int cursorMode = ScreencastV1Interface::Hidden;
+    qreal maximumFramerate = 0;
+    QHash<uint32_t, QSet<uint64_t>> dmabufFormats;
+    QRect region;
+    qreal scale = 1;
+    QPointer<PlasmaWindowInterface> window;
+    QPointer<SurfaceInterface> surface;
+    QMetaObject::Connection damagedConnection;
+    QRegion damage;
+    bool frameScheduled = false;
+    QElapsedTimer lastFrame;
+    QTimer *frameTimer = nullptr;
 };
 
+void ScreencastStreamV1InterfacePrivate::scheduleFrame()
+{
+    if (stopped || frameScheduled) {
+        return;
+    }
+    frameScheduled = true;
+    if (!frameTimer) {
+        frameTimer = new QTimer(q);
+        frameTimer->setSingleShot(true);
+        QObject::connect(frameTimer, &QTimer::timeout, q, [this] {
+            frameScheduled = false;
+            lastFrame.start();
+            const QRegion damage = this->damage;
+            this->damage = QRegion();
+            Q_EMIT q->frameRequested(damage);
+        });
+    }
+    // the damage of one event loop iteration goes into one frame
+    qint64 delay = 0;
+    if (maximumFramerate > 0 && lastFrame.isValid()) {
+        const qint64 interval = qRound64(1000 / maximumFramerate);
+        delay = qMax<qint64>(0, interval - lastFrame.elapsed());
+    }
+    frameTimer->start(delay);
+}
+
 ScreencastStreamV1Interface::ScreencastStreamV1Interface(QObject *parent)
     : QObject(parent)
     , d(new ScreencastStreamV1InterfacePrivate(this))
@@ -71,6 +118,85 @@ void ScreencastStreamV1Interface::sendClosed()
     }
 }
 
+int ScreencastStreamV1Interface::cursorMode() const
+{
+    return d->cursorMode;
+}
+
+void ScreencastStreamV1Interface::setMaximumFramerate(qreal fps)
+{
+    d->maximumFramerate = qMax<qreal>(0, fps);
+}
+
+qreal ScreencastStreamV1Interface::maximumFramerate() const
+{
+    return d->maximumFramerate;
+}
+
+void ScreencastStreamV1Interface::setDmabufFormats(const QHash<uint32_t, QSet<uint64_t>> &formats)
+{
+    d->dmabufFormats = formats;
+}
+
+QHash<uint32_t, QSet<uint64_t>> ScreencastStreamV1Interface::dmabufFormats() const
+{
+    return d->dmabufFormats;
+}
+
+void ScreencastStreamV1Interface::setSurface(SurfaceInterface *surface)
+{
+    if (d->surface == surface) {
+        return;
+    }
+    disconnect(d->damagedConnection);
+    d->surface = surface;
+    if (surface) {
+        d->damagedConnection = connect(surface, &SurfaceInterface::damaged, this, &ScreencastStreamV1Interface::addDamage);
+    }
+}
+
+SurfaceInterface *ScreencastStreamV1Interface::surface() const
+{
+    return d->surface;
+}
+
+PlasmaWindowInterface *ScreencastStreamV1Interface::window() const
+{
+    return d->window;
+}
+
+QRect ScreencastStreamV1Interface::region() const
+{
+    return d->region;
+}
+
+qreal ScreencastStreamV1Interface::scale() const
+{
+    return d->scale;
+}
+
+void ScreencastStreamV1Interface::addDamage(const QRegion &damage)
+{
+    if (damage.isEmpty()) {
+        return;
+    }
+    if (d->region.isValid()) {
+        const QRegion croppedDamage = damage & d->region;
+        if (croppedDamage.isEmpty()) {
+            return;
+        }
+        d->damage += croppedDamage.translated(-d->region.topLeft());
+    } else {
+        d->damage += damage;
+    }
+    d->scheduleFrame();
+}
+
+void ScreencastStreamV1Interface::addCursorUpdate()
+{
+    d->scheduleFrame();
+}
+
 class ScreencastV1InterfacePrivate : public QtWaylandServer::zkde_screencast_unstable_v1
 {
 public:
@@ -80,21 +206,58 @@ public:
     {
     }
 
-    ScreencastStreamV1Interface *createStream(Resource *resource, quint32 streamid) const
+    ScreencastStreamV1Interface *createStream(Resource *resource, quint32 streamid, uint32_t pointer) const
     {
         auto stream = new ScreencastStreamV1Interface(q);
         stream->d->init(resource->client(), streamid, resource->version());
+        stream->d->cursorMode = pointer;
+        stream->d->maximumFramerate = maximumFramerate;
+        stream->d->dmabufFormats = dmabufFormats;
         return stream;
     }
 
     void zkde_screencast_unstable_v1_stream_output(Resource *resource, uint32_t streamid, struct ::wl_resource *output, uint32_t pointer) override
     {
-        Q_EMIT q->outputScreencastRequested(createStream(resource, streamid), OutputInterface::get(output), ScreencastV1Interface::CursorMode(pointer));
+        Q_EMIT q->outputScreencastRequested(createStream(resource, streamid, pointer), OutputInterface::get(output), ScreencastV1Interface::CursorMode(pointer));
     }
 
     void zkde_screencast_unstable_v1_stream_window(Resource *resource, uint32_t streamid, const QString &uuid, uint32_t pointer) override
     {
-        Q_EMIT q->windowScreencastRequested(createStream(resource, streamid), uuid, ScreencastV1Interface::CursorMode(pointer));
+        ScreencastStreamV1Interface *stream = createStream(resource, streamid, pointer);
+        if (!windowManagement) {
+            Q_EMIT q->windowScreencastRequested(stream, uuid, ScreencastV1Interface::CursorMode(pointer));
+            return;
+        }
+        PlasmaWindowInterface *window = windowManagement->windowByUuid(uuid);
+        if (!window) {
+            stream->sendFailed(QStringLiteral("Unknown window"));
+            return;
+        }
+        stream->d->window = window;
+        Q_EMIT q->plasmaWindowScreencastRequested(stream, window, ScreencastV1Interface::CursorMode(pointer));
+    }
+
+    void zkde_screencast_unstable_v1_stream_virtual_output(Resource *resource, uint32_t streamid, const QString &name, int32_t width, int32_t height, wl_fixed_t scale, uint32_t pointer) override
+    {
+        ScreencastStreamV1Interface *stream = createStream(resource, streamid, pointer);
+        stream->d->scale = wl_fixed_to_double(scale);
+        if (width <= 0 || height <= 0 || stream->d->scale <= 0) {
+            stream->sendFailed(QStringLiteral("Invalid size or scale of the virtual output"));
+            return;
+        }
+        Q_EMIT q->virtualOutputScreencastRequested(stream, name, QSize(width, height), stream->d->scale, ScreencastV1Interface::CursorMode(pointer));
+    }
+
+    void zkde_screencast_unstable_v1_stream_region(Resource *resource, uint32_t streamid, int32_t x, int32_t y, uint32_t width, uint32_t height, wl_fixed_t scale, uint32_t pointer) override
+    {
+        ScreencastStreamV1Interface *stream = createStream(resource, streamid, pointer);
+        stream->d->scale = wl_fixed_to_double(scale);
+        if (width == 0 || height == 0 || width > INT_MAX || height > INT_MAX || stream->d->scale <= 0) {
+            stream->sendFailed(QStringLiteral("Invalid region or scale"));
+            return;
+        }
+        stream->d->region = QRect(x, y, width, height);
+        Q_EMIT q->regionScreencastRequested(stream, stream->d->region, stream->d->scale, ScreencastV1Interface::CursorMode(pointer));
     }
 
     void zkde_screencast_unstable_v1_destroy(Resource *resource) override
@@ -103,6 +266,9 @@ public:
     }
 
     ScreencastV1Interface *const q;
+    qreal maximumFramerate = 0;
+    QHash<uint32_t, QSet<uint64_t>> dmabufFormats;
+    QPointer<PlasmaWindowManagementInterface> windowManagement;
 };
 
 ScreencastV1Interface::ScreencastV1Interface(Display *display, QObject *parent)
@@ -113,4 +279,34 @@ ScreencastV1Interface::ScreencastV1Interface(Display *display, QObject *parent)
 
 ScreencastV1Interface::~ScreencastV1Interface() = default;
 
+void ScreencastV1Interface::setMaximumFramerate(qreal fps)
+{
+    d->maximumFramerate = qMax<qreal>(0, fps);
+}
+
+qreal ScreencastV1Interface::maximumFramerate() const
+{
+    return d->maximumFramerate;
+}
+
+void ScreencastV1Interface::setDmabufFormats(const QHash<uint32_t, QSet<uint64_t>> &formats)
+{
+    d->dmabufFormats = formats;
+}
+
+QHash<uint32_t, QSet<uint64_t>> ScreencastV1Interface::dmabufFormats() const
+{
+    return d->dmabufFormats;
+}
+
+void ScreencastV1Interface::setWindowManagement(PlasmaWindowManagementInterface *windowManagement)
+{
+    d->windowManagement = windowManagement;
+}
+
+PlasmaWindowManagementInterface *ScreencastV1Interface::windowManagement() const
+{
+    return d->windowManagement;
+}
+
 } // namespace KWaylandServer
@@ -6,8 +6,12 @@
 
 #pragma once
 
+#include <QHash>
 #include <QObject>
+#include <QRect>
+#include <QRegion>
 #include <QScopedPointer>
+#include <QSet>
 #include <KWaylandServer/kwaylandserver_export.h>
 
 struct wl_resource;
@@ -17,9 +21,12 @@ namespace KWaylandServer
 
 class Display;
 class OutputInterface;
+class PlasmaWindowInterface;
+class PlasmaWindowManagementInterface;
 class ScreencastV1InterfacePrivate;
 class ScreencastStreamV1InterfacePrivate;
 class ScreencastStreamV1Interface;
+class SurfaceInterface;
 
 class KWAYLANDSERVER_EXPORT ScreencastStreamV1Interface : public QObject
 {
@@ -31,8 +38,87 @@ public:
     void sendFailed(const QString &error);
     void sendClosed();
 
+    /**
+     * @returns how the client wants the cursor to be recorded, an int of
+     * ScreencastV1Interface::CursorMode
+     * @since 5.22
+     **/
+    int cursorMode() const;
+
+    /**
+     * Limits how often frameRequested() is emitted, @c 0 doesn't limit it. The default is the
+     * ScreencastV1Interface::maximumFramerate() at the time the stream was requested.
+     * @since 5.22
+     **/
+    void setMaximumFramerate(qreal fps);
+    qreal maximumFramerate() const;
+
+    /**
+     * Sets the dmabuf formats and modifiers the compositor offers when it negotiates the
+     * PipeWire stream, a format without modifiers only supports the implicit modifier. The
+     * default are the ScreencastV1Interface::dmabufFormats() at the time the stream was requested.
+     * @since 5.22
+     **/
+    void setDmabufFormats(const QHash<uint32_t, QSet<uint64_t>> &formats);
+    QHash<uint32_t, QSet<uint64_t>> dmabufFormats() const;
+
+    /**
+     * @returns the window of a window stream, if it was resolved by the window management
+     * set with ScreencastV1Interface::setWindowManagement, @c nullptr otherwise
+     * @since 5.22
+     **/
+    PlasmaWindowInterface *window() const;
+
+    /**
+     * Feeds the damage of @p surface into the stream, in surface-local coordinates. Meant for
+     * window streams, whose window the compositor looked up from the requested uuid.
+     * @since 5.22
+     **/
+    void setSurface(SurfaceInterface *surface);
+    SurfaceInterface *surface() const;
+
+    /**
+     * @returns the rectangle of a region stream in global logical coordinates, an invalid
+     * rectangle for other streams
+     * @see ScreencastV1Interface::regionScreencastRequested
+     * @since 5.22
+     **/
+    QRect region() const;
+    /**
+     * @returns the scale of the stream in relation to the logical size of what it records,
+     * only set for region and virtual output streams
+     * @since 5.22
+     **/
+    qreal scale() const;
+
+    /**
+     * Adds @p damage to the next frame, e.g. the damage of the output of an output stream or
+     * the area of an embedded cursor.
+     *
+     * The damage of a region stream is in global logical coordinates, so the compositor can
+     * pass on the damage of its outputs as is. The damage outside of region() doesn't request
+     * a frame, the rest is translated into the region.
+     * @since 5.22
+     **/
+    void addDamage(const QRegion &damage);
+    /**
+     * Requests a frame for a moved or changed cursor without damaging the content. Used with
+     * the cursor mode ScreencastV1Interface::Metadata, the frame then only updates the cursor
+     * metadata of the stream.
+     * @since 5.22
+     **/
+    void addCursorUpdate();
+
 Q_SIGNALS:
     void finished();
+    /**
+     * Emitted when the stream should get a new frame, at most maximumFramerate() times per
+     * second. The @p damage accumulated since the previous frame can be the only area the
+     * compositor copies and the encoder encodes, it's empty if only the cursor changed. A
+     * static content doesn't request any frames.
+     * @since 5.22
+     **/
+    void frameRequested(const QRegion &damage);
 
 private:
     friend class ScreencastV1InterfacePrivate;
@@ -55,9 +141,61 @@ public:
     };
     Q_ENUM(CursorMode);
 
+    /**
+     * The maximum framerate of new streams, @c 0 doesn't limit them. The default is @c 0.
+     * @see ScreencastStreamV1Interface::setMaximumFramerate
+     * @since 5.22
+     **/
+    void setMaximumFramerate(qreal fps);
+    qreal maximumFramerate() const;
+
+    /**
+     * The dmabuf formats and modifiers of new streams.
+     * @see ScreencastStreamV1Interface::setDmabufFormats
+     * @since 5.22
+     **/
+    void setDmabufFormats(const QHash<uint32_t, QSet<uint64_t>> &formats);
+    QHash<uint32_t, QSet<uint64_t>> dmabufFormats() const;
+
+    /**
+     * Resolves the uuids of window streams against the windows of @p windowManagement, see
+     * PlasmaWindowManagementInterface::windowByUuid. Window streams are then requested with
+     * plasmaWindowScreencastRequested instead of windowScreencastRequested, and streams of
+     * unknown windows fail right away.
+     * @since 5.22
+     **/
+    void setWindowManagement(PlasmaWindowManagementInterface *windowManagement);
+    PlasmaWindowManagementInterface *windowManagement() const;
+
 Q_SIGNALS:
     void outputScreencastRequested(ScreencastStreamV1Interface *stream, OutputInterface *output, CursorMode mode);
+    /**
+     * Requests a stream of the window with the uuid @p winid, emitted if no window management
+     * is set.
+     * @see setWindowManagement
+     **/
     void windowScreencastRequested(ScreencastStreamV1Interface *stream, const QString &winid, CursorMode mode);
+    /**
+     * Requests a stream of @p window, emitted instead of windowScreencastRequested once a
+     * window management is set.
+     * @see setWindowManagement
+     * @since 5.22
+     **/
+    void plasmaWindowScreencastRequested(ScreencastStreamV1Interface *stream, PlasmaWindowInterface *window, CursorMode mode);
+    /**
+     * Requests a stream of a new virtual output named @p name with the logical @p size and
+     * @p scale. The compositor removes the output when the stream is finished.
+     * @since 5.22
+     **/
+    void virtualOutputScreencastRequested(ScreencastStreamV1Interface *stream, const QString &name, const QSize &size, qreal scale, CursorMode mode);
+    /**
+     * Requests a stream of the @p region of the workspace in global logical coordinates, which
+     * may span several outputs. The compositor only copies the region into the buffers of the
+     * stream, scaled by @p scale. Empty regions and invalid scales fail before this is emitted.
+     * @see ScreencastStreamV1Interface::region
+     * @since 5.22
+     **/
+    void regionScreencastRequested(ScreencastStreamV1Interface *stream, const QRect &region, qreal scale, CursorMode mode);
 
 private:
     QScopedPointer<ScreencastV1InterfacePrivate> d;
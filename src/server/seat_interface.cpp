@@ -5,6 +5,8 @@
     SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
 */
 #include "abstract_data_source.h"
+#include "clipboardcache_p.h"
+#include "clientconnection.h"
 #include "display_p.h"
 #include "seat_interface.h"
 #include "seat_interface_p.h"
@@ -36,7 +38,8 @@
 #include <linux/input.h>
 #endif
 
-#include <functional>
+#include <algorithm>
+#include <utility>
 
 namespace KWaylandServer
 {
@@ -50,8 +53,6 @@ SeatInterface::Private::Private(SeatInterface *q, Display *display)
     : Global::Private(display, &wl_seat_interface, s_version)
     , q(q)
 {
-    textInputV2 = new TextInputV2Interface(q);
-    textInputV3 = new TextInputV3Interface(q);
 }
 
 #ifndef K_DOXYGEN
@@ -118,7 +119,7 @@ void SeatInterface::Private::bind(wl_client *client, uint32_t version, uint32_t
 
 void SeatInterface::Private::unbind(wl_resource *r)
 {
-    cast(r)->resources.removeAll(r);
+    cast(r)->resources.removeOne(r);
 }
 
 void SeatInterface::Private::releaseCallback(wl_client *client, wl_resource *resource)
@@ -129,22 +130,58 @@ void SeatInterface::Private::releaseCallback(wl_client *client, wl_resource *res
 
 void SeatInterface::Private::updatePointerButtonSerial(quint32 button, quint32 serial)
 {
-    auto it = globalPointer.buttonSerials.find(button);
-    if (it == globalPointer.buttonSerials.end()) {
-        globalPointer.buttonSerials.insert(button, serial);
-        return;
+    if (PressedCodes::isTracked(button)) {
+        globalPointer.buttonSerials[button] = serial;
     }
-    it.value() = serial;
 }
 
 void SeatInterface::Private::updatePointerButtonState(quint32 button, Pointer::State state)
 {
-    auto it = globalPointer.buttonStates.find(button);
-    if (it == globalPointer.buttonStates.end()) {
-        globalPointer.buttonStates.insert(button, state);
-        return;
+    globalPointer.buttons.update(button, state == Pointer::State::Pressed);
+}
+
+void SeatInterface::Private::recordInputSerial(quint32 serial, InputSerial::Type type, SurfaceInterface *surface)
+{
+    InputSerial &slot = inputSerials[serial % inputSerialCount];
+    slot.serial = serial;
+    slot.type = type;
+    slot.grab = type != InputSerial::Type::Key;
+    slot.surface = surface;
+}
+
+void SeatInterface::Private::endImplicitGrab(quint32 serial)
+{
+    InputSerial &slot = inputSerials[serial % inputSerialCount];
+    if (slot.serial == serial) {
+        slot.grab = false;
+    }
+}
+
+const SeatInterface::Private::InputSerial *SeatInterface::Private::findInputSerial(quint32 serial) const
+{
+    const InputSerial &slot = inputSerials[serial % inputSerialCount];
+    if (slot.type == InputSerial::Type::None || slot.serial != serial) {
+        return nullptr;
+    }
+    return &slot;
+}
+
+bool SeatInterface::Private::isPressedButtonSerial(quint32 serial) const
+{
+    const QVector<quint32> &pressed = globalPointer.buttons.pressed();
+    return std::any_of(pressed.constBegin(), pressed.constEnd(), [this, serial](quint32 button) {
+        return globalPointer.buttonSerials[button] == serial;
+    });
+}
+
+bool SeatInterface::Private::isTouchPointSerial(quint32 serial) const
+{
+    for (int i = 0; i < globalTouch.pointCount; ++i) {
+        if (globalTouch.points[i].serial == serial) {
+            return true;
+        }
     }
-    it.value() = state;
+    return false;
 }
 
 void SeatInterface::Private::sendName(wl_resource *r)
@@ -183,47 +220,33 @@ SeatInterface::Private *SeatInterface::Private::cast(wl_resource *r)
 namespace {
 template <typename T>
 static
-T *interfaceForSurface(SurfaceInterface *surface, const QVector<T*> &interfaces)
+QVector<T *> interfacesWithResource(const QVector<T*> &interfaces)
 {
-    if (!surface) {
-        return nullptr;
-    }
-
-    for (auto it = interfaces.constBegin(); it != interfaces.constEnd(); ++it) {
-        if ((*it)->client() == surface->client()) {
-            return (*it);
-        }
+    auto it = std::find_if(interfaces.constBegin(), interfaces.constEnd(), [](T *interface) {
+        return !interface->resource();
+    });
+    if (it == interfaces.constEnd()) {
+        return interfaces;
     }
-    return nullptr;
-}
-
-template <typename T>
-static
-QVector<T *> interfacesForSurface(SurfaceInterface *surface, const QVector<T*> &interfaces)
-{
     QVector<T *> ret;
-    if (!surface) {
-        return ret;
-    }
-
     for (auto it = interfaces.constBegin(); it != interfaces.constEnd(); ++it) {
-        if ((*it)->client() == surface->client() && (*it)->resource()) {
+        if ((*it)->resource()) {
             ret << *it;
         }
     }
     return ret;
 }
 
-template <typename T>
+// the interfaces are taken by value, the method might modify the devices of the seat
+// the method is a template argument so that the lambdas get inlined instead of being
+// wrapped in a std::function for every event
+template <typename T, typename Method>
 static
-bool forEachInterface(SurfaceInterface *surface, const QVector<T*> &interfaces, std::function<void (T*)> method)
+bool forEachInterface(const QVector<T*> interfaces, Method &&method)
 {
-    if (!surface) {
-        return false;
-    }
     bool calledAtLeastOne = false;
     for (auto it = interfaces.constBegin(); it != interfaces.constEnd(); ++it) {
-        if ((*it)->client() == surface->client() && (*it)->resource()) {
+        if ((*it)->resource()) {
             method(*it);
             calledAtLeastOne = true;
         }
@@ -233,36 +256,101 @@ bool forEachInterface(SurfaceInterface *surface, const QVector<T*> &interfaces,
 
 }
 
-QVector<PointerInterface *> SeatInterface::Private::pointersForSurface(SurfaceInterface *surface) const
+const SeatInterface::Private::ClientDevices &SeatInterface::Private::devicesForClient(ClientConnection *client) const
 {
-    return interfacesForSurface(surface, pointers);
+    static const ClientDevices noDevices;
+    auto it = clientDevices.constFind(client);
+    if (it == clientDevices.constEnd()) {
+        return noDevices;
+    }
+    return *it;
 }
 
-QVector<TouchInterface *> SeatInterface::Private::touchsForSurface(SurfaceInterface *surface) const
+void SeatInterface::Private::flushInput(SurfaceInterface *surface)
+{
+    queueInputFlush(surface);
+    if (!inInputFrame) {
+        flushQueuedInput();
+    }
+}
+
+void SeatInterface::Private::queueInputFlush(SurfaceInterface *surface)
+{
+    if (!flushInputImmediately || !surface) {
+        return;
+    }
+    ClientConnection *client = surface->client();
+    if (!inputFlushClients.contains(client)) {
+        inputFlushClients.append(client);
+    }
+}
+
+void SeatInterface::Private::flushQueuedInput()
 {
-    return interfacesForSurface(surface, touchs);
+    const QVector<QPointer<ClientConnection>> clients = std::exchange(inputFlushClients, {});
+    for (const QPointer<ClientConnection> &client : clients) {
+        if (client) {
+            client->flush();
+        }
+    }
 }
 
-QVector<DataDeviceInterface *> SeatInterface::Private::dataDevicesForSurface(SurfaceInterface *surface) const
+void SeatInterface::Private::recordInputLatency(SurfaceInterface *surface, InputLatencyEventType type)
 {
     if (!surface) {
-        return {};
+        return;
     }
-    QVector<DataDeviceInterface *> primarySelectionDevices;
-    for (auto it = dataDevices.constBegin(); it != dataDevices.constEnd(); ++it) {
-        if ((*it)->client() == *surface->client()) {
-            primarySelectionDevices << *it;
-        }
+    InputLatencyTracker &tracker = DisplayPrivate::get(display)->inputLatency;
+    if (tracker.isEnabled()) {
+        tracker.recordEvent(surface->client(), type);
+    }
+}
+
+const SeatInterface::Private::ClientDevices &SeatInterface::Private::devicesForSurface(SurfaceInterface *surface) const
+{
+    return devicesForClient(surface ? surface->client() : nullptr);
+}
+
+template <typename T>
+void SeatInterface::Private::removeClientDevice(ClientConnection *client, QVector<T *> ClientDevices::*devices, T *device)
+{
+    auto it = clientDevices.find(client);
+    if (it == clientDevices.end()) {
+        return;
+    }
+    ((*it).*devices).removeOne(device);
+    if (it->isEmpty()) {
+        clientDevices.erase(it);
     }
-    return primarySelectionDevices;
+}
+
+QVector<PointerInterface *> SeatInterface::Private::pointersForSurface(SurfaceInterface *surface) const
+{
+    return interfacesWithResource(devicesForSurface(surface).pointers);
+}
+
+QVector<TouchInterface *> SeatInterface::Private::touchsForSurface(SurfaceInterface *surface) const
+{
+    return interfacesWithResource(devicesForSurface(surface).touchs);
+}
+
+QVector<DataDeviceInterface *> SeatInterface::Private::dataDevicesForSurface(SurfaceInterface *surface) const
+{
+    return devicesForSurface(surface).dataDevices;
+}
+
+QVector<PrimarySelectionDeviceV1Interface *> SeatInterface::Private::primarySelectionDevicesForSurface(SurfaceInterface *surface) const
+{
+    return devicesForSurface(surface).primarySelectionDevices;
 }
 
 void SeatInterface::Private::registerDataDevice(DataDeviceInterface *dataDevice)
 {
     Q_ASSERT(dataDevice->seat() == q);
-    dataDevices << dataDevice;
-    auto dataDeviceCleanup = [this, dataDevice] {
-        dataDevices.removeOne(dataDevice);
+    ClientConnection *clientConnection = display->getConnection(dataDevice->client());
+    clientDevices[clientConnection].dataDevices << dataDevice;
+    auto dataDeviceCleanup = [this, dataDevice, clientConnection] {
+        removeClientDevice(clientConnection, &ClientDevices::dataDevices, dataDevice);
         globalKeyboard.focus.selections.removeOne(dataDevice);
     };
     QObject::connect(dataDevice, &QObject::destroyed, q, dataDeviceCleanup);
@@ -282,11 +370,11 @@ void SeatInterface::Private::registerDataDevice(DataDeviceInterface *dataDevice)
             auto *dragSurface = dataDevice->origin();
             if (q->hasImplicitPointerGrab(dragSerial)) {
                 drag.mode = Drag::Mode::Pointer;
-                drag.sourcePointer = interfaceForSurface(dragSurface, pointers);
+                drag.sourcePointer = devicesForSurface(dragSurface).pointers.value(0);
                 drag.transformation = globalPointer.focus.transformation;
             } else if (q->hasImplicitTouchGrab(dragSerial)) {
                 drag.mode = Drag::Mode::Touch;
-                drag.sourceTouch = interfaceForSurface(dragSurface, touchs);
+                drag.sourceTouch = devicesForSurface(dragSurface).touchs.value(0);
                 // TODO: touch transformation
             } else {
                 // no implicit grab, abort drag
@@ -302,7 +390,7 @@ void SeatInterface::Private::registerDataDevice(DataDeviceInterface *dataDevice)
                 drag.transformation = globalPointer.focus.transformation;
             }
             drag.source = dataDevice;
-            drag.sourcePointer = interfaceForSurface(originSurface, pointers);
+            drag.sourcePointer = devicesForSurface(originSurface).pointers.value(0);
             drag.destroyConnection = QObject::connect(dataDevice, &DataDeviceInterface::aboutToBeDestroyed, q,
                 [this] {
                     cancelDrag(display->nextSerial());
@@ -317,6 +405,7 @@ void SeatInterface::Private::registerDataDevice(DataDeviceInterface *dataDevice)
             } else {
                 drag.dragSourceDestroyConnection = QMetaObject::Connection();
             }
+            startDragPrefetch(dataDevice->dragSource());
             dataDevice->updateDragTarget(proxied ? nullptr : originSurface, dataDevice->dragImplicitGrabSerial());
             emit q->dragStarted();
             emit q->dragSurfaceChanged();
@@ -327,7 +416,7 @@ void SeatInterface::Private::registerDataDevice(DataDeviceInterface *dataDevice)
         // same client?
         if (*globalKeyboard.focus.surface->client() == dataDevice->client()) {
             globalKeyboard.focus.selections.append(dataDevice);
-            if (currentSelection) {
+            if (currentSelection && !selectionPending) {
                 dataDevice->sendSelection(currentSelection);
             }
         }
@@ -363,7 +452,7 @@ void SeatInterface::Private::registerDataControlDevice(DataControlDeviceV1Interf
             q->setSelection(nullptr);
         }
     );
-    if (currentSelection) {
+    if (currentSelection && !selectionPending) {
         dataDevice->sendSelection(currentSelection);
     }
 }
@@ -372,9 +461,10 @@ void SeatInterface::Private::registerPrimarySelectionDevice(PrimarySelectionDevi
 {
     Q_ASSERT(primarySelectionDevice->seat() == q);
 
-    primarySelectionDevices << primarySelectionDevice;
-    auto dataDeviceCleanup = [this, primarySelectionDevice] {
-        primarySelectionDevices.removeOne(primarySelectionDevice);
+    ClientConnection *clientConnection = display->getConnection(primarySelectionDevice->client());
+    clientDevices[clientConnection].primarySelectionDevices << primarySelectionDevice;
+    auto dataDeviceCleanup = [this, primarySelectionDevice, clientConnection] {
+        removeClientDevice(clientConnection, &ClientDevices::primarySelectionDevices, primarySelectionDevice);
         globalKeyboard.focus.primarySelections.removeOne(primarySelectionDevice);
     };
     QObject::connect(primarySelectionDevice, &QObject::destroyed, q, dataDeviceCleanup);
@@ -393,13 +483,29 @@ void SeatInterface::Private::registerPrimarySelectionDevice(PrimarySelectionDevi
         // same client?
         if (*globalKeyboard.focus.surface->client() == primarySelectionDevice->client()) {
             globalKeyboard.focus.primarySelections.append(primarySelectionDevice);
-            if (currentPrimarySelection) {
+            if (currentPrimarySelection && !primarySelectionPending) {
                 primarySelectionDevice->sendSelection(currentPrimarySelection);
             }
         }
     }
 }
 
+void SeatInterface::Private::startDragPrefetch(AbstractDataSource *source)
+{
+    delete dragPrefetch;
+    if (!source || dragPrefetchMimeTypes.isEmpty()) {
+        return;
+    }
+    auto prefetch = new ClipboardCache(source, dragPrefetchMimeTypes, dragPrefetchSizeLimit, q);
+    if (prefetch->isEmpty()) {
+        delete prefetch;
+        return;
+    }
+    // the drop target receives the data after the drag ended, the prefetch serves that as well
+    QObject::connect(source, &AbstractDataSource::aboutToBeDestroyed, prefetch, &QObject::deleteLater);
+    dragPrefetch = prefetch;
+}
+
 void SeatInterface::Private::cancelDrag(quint32 serial)
 {
     if (drag.target) {
@@ -522,7 +628,10 @@ void SeatInterface::Private::getPointer(wl_client *client, wl_resource *resource
         delete pointer;
         return;
     }
-    pointers << pointer;
+    clientDevices[clientConnection].pointers << pointer;
+    QObject::connect(clientConnection, &ClientConnection::decongested, pointer, [pointer] {
+        pointer->d_func()->flushDecongestedMotion();
+    });
     if (globalPointer.focus.surface && globalPointer.focus.surface->client() == clientConnection) {
         // this is a pointer for the currently focused pointer surface
         globalPointer.focus.pointers << pointer;
@@ -534,8 +643,8 @@ void SeatInterface::Private::getPointer(wl_client *client, wl_resource *resource
         }
     }
     QObject::connect(pointer, &QObject::destroyed, q,
-        [pointer,this] {
-            pointers.removeAt(pointers.indexOf(pointer));
+        [pointer, clientConnection, this] {
+            removeClientDevice(clientConnection, &ClientDevices::pointers, pointer);
             if (globalPointer.focus.pointers.removeOne(pointer)) {
                 if (globalPointer.focus.pointers.isEmpty()) {
                     emit q->focusedPointerChanged(nullptr);
@@ -577,17 +686,17 @@ void SeatInterface::Private::getTouch(wl_client *client, wl_resource *resource,
         delete touch;
         return;
     }
-    touchs << touch;
+    clientDevices[clientConnection].touchs << touch;
     if (globalTouch.focus.surface && globalTouch.focus.surface->client() == clientConnection) {
         // this is a touch for the currently focused touch surface
         globalTouch.focus.touchs << touch;
-        if (!globalTouch.ids.isEmpty()) {
+        if (!globalTouch.isEmpty()) {
             // TODO: send out all the points
         }
     }
     QObject::connect(touch, &QObject::destroyed, q,
-        [touch,this] {
-            touchs.removeAt(touchs.indexOf(touch));
+        [touch, clientConnection, this] {
+            removeClientDevice(clientConnection, &ClientDevices::touchs, touch);
             globalTouch.focus.touchs.removeOne(touch);
         }
     );
@@ -648,15 +757,68 @@ void SeatInterface::setPointerPos(const QPointF &pos)
         return;
     }
     d->globalPointer.pos = newPos;
+    d->recordInputLatency(d->globalPointer.focus.surface, InputLatencyEventType::PointerMotion);
     emit pointerPosChanged(newPos);
 }
 
+void SeatInterface::setPointerMotionCoalescingEnabled(bool enabled)
+{
+    Q_D();
+    if (d->pointerMotionCoalescing == enabled) {
+        return;
+    }
+    flushPointerMotion();
+    d->pointerMotionCoalescing = enabled;
+}
+
+bool SeatInterface::isPointerMotionCoalescingEnabled() const
+{
+    Q_D();
+    return d->pointerMotionCoalescing;
+}
+
+void SeatInterface::flushPointerMotion()
+{
+    Q_D();
+    for (PointerInterface *pointer : qAsConst(d->globalPointer.focus.pointers)) {
+        // a congested client gets the latest position once it has caught up
+        if (pointer->client()->isCongested()) {
+            continue;
+        }
+        pointer->d_func()->flushPendingMotion();
+    }
+}
+
+quint64 SeatInterface::pointerMotionEventCount() const
+{
+    Q_D();
+    return d->pointerMotionCount;
+}
+
+quint64 SeatInterface::coalescedPointerMotionEventCount() const
+{
+    Q_D();
+    return d->coalescedPointerMotionCount;
+}
+
 quint32 SeatInterface::timestamp() const
 {
     Q_D();
     return d->timestamp;
 }
 
+void SeatInterface::setFlushInputImmediately(bool enabled)
+{
+    Q_D();
+    d->flushInputImmediately = enabled;
+}
+
+bool SeatInterface::flushesInputImmediately() const
+{
+    Q_D();
+    return d->flushInputImmediately;
+}
+
 void SeatInterface::setTimestamp(quint32 time)
 {
     Q_D();
@@ -692,7 +854,7 @@ void SeatInterface::setDragTarget(SurfaceInterface *surface, const QPointF &glob
         setPointerPos(globalPosition);
     } else if (d->drag.mode == Private::Drag::Mode::Touch &&
                d->globalTouch.focus.firstTouchPos != globalPosition) {
-        touchMove(d->globalTouch.ids.first(), globalPosition);
+        touchMove(d->globalTouch.points[0].id, globalPosition);
     }
     if (d->drag.target) {
         d->drag.surface = surface;
@@ -742,6 +904,29 @@ void SeatInterface::setFocusedPointerSurface(SurfaceInterface *surface, const QM
         return;
     }
     const quint32 serial = d->display->nextSerial();
+    SurfaceInterface *previousSurface = d->globalPointer.focus.surface;
+    if (previousSurface && surface && previousSurface->client() == surface->client()) {
+        // the pointers of the client stay the same, they only need the leave, enter and frame
+        if (previousSurface != surface) {
+            disconnect(d->globalPointer.focus.destroyConnection);
+            d->globalPointer.focus.destroyConnection = connect(surface, &QObject::destroyed, this,
+                [this] {
+                    Q_D();
+                    d->globalPointer.focus = Private::Pointer::Focus();
+                    emit focusedPointerChanged(nullptr);
+                }
+            );
+            d->globalPointer.focus.surface = surface;
+        }
+        d->globalPointer.focus.offset = QPointF();
+        d->globalPointer.focus.transformation = transformation;
+        d->globalPointer.focus.serial = serial;
+        for (auto it = d->globalPointer.focus.pointers.constBegin(), end = d->globalPointer.focus.pointers.constEnd(); it != end; ++it) {
+            (*it)->setFocusedSurface(surface, serial);
+            (*it)->d_func()->sendFrame();
+        }
+        return;
+    }
     QSet<PointerInterface *> framePointers;
     for (auto it = d->globalPointer.focus.pointers.constBegin(), end = d->globalPointer.focus.pointers.constEnd(); it != end; ++it) {
         (*it)->setFocusedSurface(nullptr, serial);
@@ -863,11 +1048,7 @@ bool SeatInterface::isPointerButtonPressed(Qt::MouseButton button) const
 bool SeatInterface::isPointerButtonPressed(quint32 button) const
 {
     Q_D();
-    auto it = d->globalPointer.buttonStates.constFind(button);
-    if (it == d->globalPointer.buttonStates.constEnd()) {
-        return false;
-    }
-    return it.value() == Private::Pointer::State::Pressed ? true : false;
+    return d->globalPointer.buttons.isPressed(button);
 }
 
 void SeatInterface::pointerAxisV5(Qt::Orientation orientation, qreal delta, qint32 discreteDelta, PointerAxisSource source)
@@ -878,9 +1059,27 @@ void SeatInterface::pointerAxisV5(Qt::Orientation orientation, qreal delta, qint
         return;
     }
     if (d->globalPointer.focus.surface) {
+        d->recordInputLatency(d->globalPointer.focus.surface, InputLatencyEventType::PointerAxis);
         for (auto it = d->globalPointer.focus.pointers.constBegin(), end = d->globalPointer.focus.pointers.constEnd(); it != end; ++it) {
             (*it)->axis(orientation, delta, discreteDelta, source);
         }
+        d->flushInput(d->globalPointer.focus.surface);
+    }
+}
+
+void SeatInterface::pointerAxisV5(const QPointF &delta, const QPoint &discreteDelta, PointerAxisSource source)
+{
+    Q_D();
+    if (d->drag.mode == Private::Drag::Mode::Pointer) {
+        // ignore
+        return;
+    }
+    if (d->globalPointer.focus.surface) {
+        d->recordInputLatency(d->globalPointer.focus.surface, InputLatencyEventType::PointerAxis);
+        for (auto it = d->globalPointer.focus.pointers.constBegin(), end = d->globalPointer.focus.pointers.constEnd(); it != end; ++it) {
+            (*it)->axis(delta, discreteDelta, source);
+        }
+        d->flushInput(d->globalPointer.focus.surface);
     }
 }
 
@@ -892,9 +1091,11 @@ void SeatInterface::pointerAxis(Qt::Orientation orientation, quint32 delta)
         return;
     }
     if (d->globalPointer.focus.surface) {
+        d->recordInputLatency(d->globalPointer.focus.surface, InputLatencyEventType::PointerAxis);
         for (auto it = d->globalPointer.focus.pointers.constBegin(), end = d->globalPointer.focus.pointers.constEnd(); it != end; ++it) {
             (*it)->axis(orientation, delta);
         }
+        d->flushInput(d->globalPointer.focus.surface);
     }
 }
 
@@ -913,11 +1114,13 @@ void SeatInterface::pointerButtonPressed(quint32 button)
     const quint32 serial = d->display->nextSerial();
     d->updatePointerButtonSerial(button, serial);
     d->updatePointerButtonState(button, Private::Pointer::State::Pressed);
+    d->recordInputSerial(serial, Private::InputSerial::Type::PointerButton, d->globalPointer.focus.surface);
     if (d->drag.mode == Private::Drag::Mode::Pointer) {
         // ignore
         return;
     }
     if (auto *focusSurface = d->globalPointer.focus.surface) {
+        d->recordInputLatency(focusSurface, InputLatencyEventType::PointerButton);
         for (auto it = d->globalPointer.focus.pointers.constBegin(), end = d->globalPointer.focus.pointers.constEnd(); it != end; ++it) {
             (*it)->buttonPressed(button, serial);
         }
@@ -928,6 +1131,7 @@ void SeatInterface::pointerButtonPressed(quint32 button)
                 d->keyboard->d->focusChildSurface(p->d_func()->focusedChildSurface, serial);
             }
         }
+        d->flushInput(focusSurface);
     }
 }
 
@@ -945,6 +1149,7 @@ void SeatInterface::pointerButtonReleased(quint32 button)
     Q_D();
     const quint32 serial = d->display->nextSerial();
     const quint32 currentButtonSerial = pointerButtonSerial(button);
+    d->endImplicitGrab(currentButtonSerial);
     d->updatePointerButtonSerial(button, serial);
     d->updatePointerButtonState(button, Private::Pointer::State::Released);
     if (d->drag.mode == Private::Drag::Mode::Pointer) {
@@ -956,9 +1161,11 @@ void SeatInterface::pointerButtonReleased(quint32 button)
         return;
     }
     if (d->globalPointer.focus.surface) {
+        d->recordInputLatency(d->globalPointer.focus.surface, InputLatencyEventType::PointerButton);
         for (auto it = d->globalPointer.focus.pointers.constBegin(), end = d->globalPointer.focus.pointers.constEnd(); it != end; ++it) {
             (*it)->buttonReleased(button, serial);
         }
+        d->flushInput(d->globalPointer.focus.surface);
     }
 }
 
@@ -970,11 +1177,10 @@ quint32 SeatInterface::pointerButtonSerial(Qt::MouseButton button) const
 quint32 SeatInterface::pointerButtonSerial(quint32 button) const
 {
     Q_D();
-    auto it = d->globalPointer.buttonSerials.constFind(button);
-    if (it == d->globalPointer.buttonSerials.constEnd()) {
+    if (!PressedCodes::isTracked(button)) {
         return 0;
     }
-    return it.value();
+    return d->globalPointer.buttonSerials[button];
 }
 
 void SeatInterface::relativePointerMotion(const QSizeF &delta, const QSizeF &deltaNonAccelerated, quint64 microseconds)
@@ -998,7 +1204,7 @@ void SeatInterface::startPointerSwipeGesture(quint32 fingerCount)
         return;
     }
     const quint32 serial = d->display->nextSerial();
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [serial, fingerCount] (PointerInterface *p) {
             p->d_func()->startSwipeGesture(serial, fingerCount);
         }
@@ -1011,7 +1217,7 @@ void SeatInterface::updatePointerSwipeGesture(const QSizeF &delta)
     if (d->globalPointer.gestureSurface.isNull()) {
         return;
     }
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [delta] (PointerInterface *p) {
             p->d_func()->updateSwipeGesture(delta);
         }
@@ -1025,7 +1231,7 @@ void SeatInterface::endPointerSwipeGesture()
         return;
     }
     const quint32 serial = d->display->nextSerial();
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [serial] (PointerInterface *p) {
             p->d_func()->endSwipeGesture(serial);
         }
@@ -1040,7 +1246,7 @@ void SeatInterface::cancelPointerSwipeGesture()
         return;
     }
     const quint32 serial = d->display->nextSerial();
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [serial] (PointerInterface *p) {
             p->d_func()->cancelSwipeGesture(serial);
         }
@@ -1059,7 +1265,7 @@ void SeatInterface::startPointerPinchGesture(quint32 fingerCount)
         return;
     }
     const quint32 serial = d->display->nextSerial();
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [serial, fingerCount] (PointerInterface *p) {
             p->d_func()->startPinchGesture(serial, fingerCount);
         }
@@ -1072,7 +1278,7 @@ void SeatInterface::updatePointerPinchGesture(const QSizeF &delta, qreal scale,
     if (d->globalPointer.gestureSurface.isNull()) {
         return;
     }
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [delta, scale, rotation] (PointerInterface *p) {
             p->d_func()->updatePinchGesture(delta, scale, rotation);
         }
@@ -1086,7 +1292,7 @@ void SeatInterface::endPointerPinchGesture()
         return;
     }
     const quint32 serial = d->display->nextSerial();
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [serial] (PointerInterface *p) {
             p->d_func()->endPinchGesture(serial);
         }
@@ -1101,7 +1307,7 @@ void SeatInterface::cancelPointerPinchGesture()
         return;
     }
     const quint32 serial = d->display->nextSerial();
-    forEachInterface<PointerInterface>(d->globalPointer.gestureSurface.data(), d->pointers,
+    forEachInterface<PointerInterface>(d->devicesForSurface(d->globalPointer.gestureSurface.data()).pointers,
         [serial] (PointerInterface *p) {
             p->d_func()->cancelPinchGesture(serial);
         }
@@ -1125,12 +1331,20 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
 
     const quint32 serial = d->display->nextSerial();
 
-    if (d->globalKeyboard.focus.surface) {
+    SurfaceInterface *previousSurface = d->globalKeyboard.focus.surface;
+    // the devices of a client don't depend on which of its surfaces has focus and they already got
+    // the current selection when the client was focused, or when they were created afterwards
+    const bool sameClient = previousSurface && surface && previousSurface->client() == surface->client();
+    const QVector<DataDeviceInterface *> previousSelections = d->globalKeyboard.focus.selections;
+    const QVector<PrimarySelectionDeviceV1Interface *> previousPrimarySelections = d->globalKeyboard.focus.primarySelections;
+
+    if (previousSurface) {
         disconnect(d->globalKeyboard.focus.destroyConnection);
     }
     d->globalKeyboard.focus = Private::Keyboard::Focus();
     d->globalKeyboard.focus.surface = surface;
     if (d->globalKeyboard.focus.surface) {
+        d->globalKeyboard.focus.shortcutsInhibitor = d->globalKeyboard.shortcutsInhibitors.value(surface);
         d->globalKeyboard.focus.destroyConnection = connect(surface, &QObject::destroyed, this,
             [this] {
                 Q_D();
@@ -1138,30 +1352,35 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
             }
         );
         d->globalKeyboard.focus.serial = serial;
-        // selection?
-        const QVector<DataDeviceInterface *> dataDevices = d->dataDevicesForSurface(surface);
-        d->globalKeyboard.focus.selections = dataDevices;
-        for (auto dataDevice : dataDevices) {
-            if (d->currentSelection) {
-                dataDevice->sendSelection(d->currentSelection);
-            } else {
-                dataDevice->sendClearSelection();
-            }
-        }
-        // primary selection
-        QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevices;
-        for (auto it = d->primarySelectionDevices.constBegin(); it != d->primarySelectionDevices.constEnd(); ++it) {
-            if ((*it)->client() == *surface->client()) {
-                primarySelectionDevices << *it;
+        if (sameClient) {
+            d->globalKeyboard.focus.selections = previousSelections;
+            d->globalKeyboard.focus.primarySelections = previousPrimarySelections;
+        } else {
+            // selection?
+            const QVector<DataDeviceInterface *> dataDevices = d->dataDevicesForSurface(surface);
+            d->globalKeyboard.focus.selections = dataDevices;
+            // a pending fan-out reaches the new focus anyway
+            if (!d->selectionPending) {
+                for (auto dataDevice : dataDevices) {
+                    if (d->currentSelection) {
+                        dataDevice->sendSelection(d->currentSelection);
+                    } else {
+                        dataDevice->sendClearSelection();
+                    }
+                }
             }
-        }
-
-        d->globalKeyboard.focus.primarySelections = primarySelectionDevices;
-        for (auto primaryDataDevice : primarySelectionDevices) {
-            if (d->currentSelection) {
-                primaryDataDevice->sendSelection(d->currentPrimarySelection);
-            } else {
-                primaryDataDevice->sendClearSelection();
+            // primary selection
+            const QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevices = d->primarySelectionDevicesForSurface(surface);
+
+            d->globalKeyboard.focus.primarySelections = primarySelectionDevices;
+            if (!d->primarySelectionPending) {
+                for (auto primaryDataDevice : primarySelectionDevices) {
+                    if (d->currentPrimarySelection) {
+                        primaryDataDevice->sendSelection(d->currentPrimarySelection);
+                    } else {
+                        primaryDataDevice->sendClearSelection();
+                    }
+                }
             }
         }
     }
@@ -1174,6 +1393,33 @@ void SeatInterface::setFocusedKeyboardSurface(SurfaceInterface *surface)
     }
 }
 
+KeyboardShortcutsInhibitorV1Interface *SeatInterface::focusedKeyboardShortcutsInhibitor() const
+{
+    Q_D();
+    return d->globalKeyboard.focus.shortcutsInhibitor;
+}
+
+void SeatInterface::Private::registerKeyboardShortcutsInhibitor(KeyboardShortcutsInhibitorV1Interface *inhibitor)
+{
+    SurfaceInterface *surface = inhibitor->surface();
+    globalKeyboard.shortcutsInhibitors.insert(surface, inhibitor);
+    if (globalKeyboard.focus.surface == surface) {
+        globalKeyboard.focus.shortcutsInhibitor = inhibitor;
+    }
+}
+
+void SeatInterface::Private::unregisterKeyboardShortcutsInhibitor(KeyboardShortcutsInhibitorV1Interface *inhibitor)
+{
+    SurfaceInterface *surface = inhibitor->surface();
+    auto it = globalKeyboard.shortcutsInhibitors.find(surface);
+    if (it != globalKeyboard.shortcutsInhibitors.end() && *it == inhibitor) {
+        globalKeyboard.shortcutsInhibitors.erase(it);
+    }
+    if (globalKeyboard.focus.shortcutsInhibitor == inhibitor) {
+        globalKeyboard.focus.shortcutsInhibitor = nullptr;
+    }
+}
+
 KeyboardInterface *SeatInterface::keyboard() const
 {
     Q_D();
@@ -1190,7 +1436,10 @@ void SeatInterface::cancelTouchSequence()
         // cancel the drag, don't drop. serial does not matter
         d->cancelDrag(0);
     }
-    d->globalTouch.ids.clear();
+    for (int i = 0; i < d->globalTouch.pointCount; ++i) {
+        d->endImplicitGrab(d->globalTouch.points[i].serial);
+    }
+    d->globalTouch.pointCount = 0;
 }
 
 TouchInterface *SeatInterface::focusedTouch() const
@@ -1217,7 +1466,7 @@ QPointF SeatInterface::focusedTouchSurfacePosition() const
 bool SeatInterface::isTouchSequence() const
 {
     Q_D();
-    return !d->globalTouch.ids.isEmpty();
+    return !d->globalTouch.isEmpty();
 }
 
 void SeatInterface::setFocusedTouchSurface(SurfaceInterface *surface, const QPointF &surfacePosition)
@@ -1260,16 +1509,22 @@ void SeatInterface::setFocusedTouchSurfacePosition(const QPointF &surfacePositio
 qint32 SeatInterface::touchDown(const QPointF &globalPosition)
 {
     Q_D();
-    const qint32 id = d->globalTouch.ids.isEmpty() ? 0 : d->globalTouch.ids.lastKey() + 1;
+    if (d->globalTouch.pointCount == Private::Touch::maximumPoints) {
+        qCWarning(KWAYLAND_SERVER) << "Ignoring touch down, too many touch points";
+        return -1;
+    }
+    const qint32 id = d->globalTouch.isEmpty() ? 0 : d->globalTouch.points[d->globalTouch.pointCount - 1].id + 1;
     const qint32 serial = display()->nextSerial();
 
     // casper_yang for scale
-    qreal eventScale = 1.;
-    if (d->globalTouch.focus.surface) {
-        eventScale = d->globalTouch.focus.surface->getInputAreaScale();
+    if (id == 0) {
+        // the points of the sequence go to the same surface, later events use the scale of the grab
+        d->globalTouch.focus.eventScale = d->globalTouch.focus.surface ? d->globalTouch.focus.surface->getInputAreaScale() : 1.;
     }
+    const qreal eventScale = d->globalTouch.focus.eventScale;
 
     const auto pos = (globalPosition - d->globalTouch.focus.offset) / eventScale;
+    d->recordInputLatency(d->globalTouch.focus.surface, InputLatencyEventType::Touch);
     for (auto it = d->globalTouch.focus.touchs.constBegin(), end = d->globalTouch.focus.touchs.constEnd(); it != end; ++it) {
         (*it)->down(id, serial, pos);
     }
@@ -1283,7 +1538,7 @@ qint32 SeatInterface::touchDown(const QPointF &globalPosition)
     if (id == 0 && d->globalTouch.focus.touchs.isEmpty()) {
         // If the client did not bind the touch interface fall back
         // to at least emulating touch through pointer events.
-        forEachInterface<PointerInterface>(focusedTouchSurface(), d->pointers,
+        forEachInterface<PointerInterface>(d->devicesForSurface(focusedTouchSurface()).pointers,
             [this, pos, serial] (PointerInterface *p) {
                 wl_pointer_send_enter(p->resource(), serial,
                                 focusedTouchSurface()->resource(),
@@ -1298,57 +1553,100 @@ qint32 SeatInterface::touchDown(const QPointF &globalPosition)
     }
 #endif
 
-    d->globalTouch.ids[id] = serial;
+    d->globalTouch.points[d->globalTouch.pointCount++] = {id, quint32(serial)};
+    d->recordInputSerial(serial, Private::InputSerial::Type::TouchDown, d->globalTouch.focus.surface);
     return id;
 }
 
-void SeatInterface::touchMove(qint32 id, const QPointF &globalPosition)
+SeatInterface::Private::Touch::Point *SeatInterface::Private::Touch::findPoint(qint32 id)
 {
-    Q_D();
-    if (!d->globalTouch.ids.contains(id)) {
+    for (int i = 0; i < pointCount; ++i) {
+        if (points[i].id == id) {
+            return &points[i];
+        }
+    }
+    return nullptr;
+}
+
+const SeatInterface::Private::Touch::Point *SeatInterface::Private::Touch::findPoint(qint32 id) const
+{
+    return const_cast<Touch *>(this)->findPoint(id);
+}
+
+void SeatInterface::Private::Touch::removePoint(qint32 id)
+{
+    Point *point = findPoint(id);
+    if (!point) {
         return;
     }
-    // casper_yang for scale
-    qreal eventScale = 1.;
-    if (d->globalTouch.focus.surface) {
-        eventScale = d->globalTouch.focus.surface->getInputAreaScale();
+    std::copy(point + 1, points.begin() + pointCount, point);
+    pointCount--;
+}
+
+void SeatInterface::Private::moveTouchPoint(qint32 id, const QPointF &globalPosition)
+{
+    const Touch::Point *point = globalTouch.findPoint(id);
+    if (!point) {
+        return;
     }
-    const auto pos = (globalPosition - d->globalTouch.focus.offset) / eventScale;
-    for (auto it = d->globalTouch.focus.touchs.constBegin(), end = d->globalTouch.focus.touchs.constEnd(); it != end; ++it) {
+    const qreal eventScale = globalTouch.focus.eventScale;
+    const auto pos = (globalPosition - globalTouch.focus.offset) / eventScale;
+    recordInputLatency(globalTouch.focus.surface, InputLatencyEventType::Touch);
+    for (auto it = globalTouch.focus.touchs.constBegin(), end = globalTouch.focus.touchs.constEnd(); it != end; ++it) {
         (*it)->move(id, pos);
     }
 
     if (id == 0) {
         // casper_yang for scale
-        d->globalTouch.focus.firstTouchPos = globalPosition / eventScale;
+        globalTouch.focus.firstTouchPos = globalPosition / eventScale;
     }
 
-    if (id == 0 && d->globalTouch.focus.touchs.isEmpty()) {
+    if (id == 0 && globalTouch.focus.touchs.isEmpty()) {
         // Client did not bind touch, fall back to emulating with pointer events.
-        forEachInterface<PointerInterface>(focusedTouchSurface(), d->pointers,
+        forEachInterface<PointerInterface>(devicesForSurface(globalTouch.focus.surface).pointers,
             [this, pos] (PointerInterface *p) {
-                wl_pointer_send_motion(p->resource(), timestamp(),
+                wl_pointer_send_motion(p->resource(), timestamp,
                                        wl_fixed_from_double(pos.x()), wl_fixed_from_double(pos.y()));
                 p->d_func()->sendFrame();
             }
         );
     }
     // casper_yang for scale
-    emit touchMoved(id, d->globalTouch.ids[id], globalPosition / eventScale);
+    emit q->touchMoved(id, point->serial, globalPosition / eventScale);
+}
+
+void SeatInterface::touchMove(qint32 id, const QPointF &globalPosition)
+{
+    Q_D();
+    d->moveTouchPoint(id, globalPosition);
+}
+
+void SeatInterface::touchMoveBatch(const QVector<QPair<qint32, QPointF>> &points)
+{
+    Q_D();
+    if (points.isEmpty()) {
+        return;
+    }
+    for (const auto &point : points) {
+        d->moveTouchPoint(point.first, point.second);
+    }
+    touchFrame();
 }
 
 void SeatInterface::touchUp(qint32 id)
 {
     Q_D();
-    if (!d->globalTouch.ids.contains(id)) {
+    const Private::Touch::Point *point = d->globalTouch.findPoint(id);
+    if (!point) {
         return;
     }
     const qint32 serial = display()->nextSerial();
     if (d->drag.mode == Private::Drag::Mode::Touch &&
-            d->drag.source->dragImplicitGrabSerial() == d->globalTouch.ids.value(id)) {
+            d->drag.source->dragImplicitGrabSerial() == point->serial) {
         // the implicitly grabbing touch point has been upped
         d->endDrag(serial);
     }
+    d->recordInputLatency(d->globalTouch.focus.surface, InputLatencyEventType::Touch);
     for (auto it = d->globalTouch.focus.touchs.constBegin(), end = d->globalTouch.focus.touchs.constEnd(); it != end; ++it) {
         (*it)->up(id, serial);
     }
@@ -1357,7 +1655,7 @@ void SeatInterface::touchUp(qint32 id)
     if (id == 0 && d->globalTouch.focus.touchs.isEmpty()) {
         // Client did not bind touch, fall back to emulating with pointer events.
         const quint32 serial = display()->nextSerial();
-        forEachInterface<PointerInterface>(focusedTouchSurface(), d->pointers,
+        forEachInterface<PointerInterface>(d->devicesForSurface(focusedTouchSurface()).pointers,
             [this, serial] (PointerInterface *p) {
                 wl_pointer_send_button(p->resource(), serial, timestamp(), BTN_LEFT, WL_POINTER_BUTTON_STATE_RELEASED);
                 p->d_func()->sendFrame();
@@ -1366,7 +1664,8 @@ void SeatInterface::touchUp(qint32 id)
     }
 #endif
 
-    d->globalTouch.ids.remove(id);
+    d->endImplicitGrab(point->serial);
+    d->globalTouch.removePoint(id);
 }
 
 void SeatInterface::touchFrame()
@@ -1379,6 +1678,84 @@ void SeatInterface::touchFrame()
     for (auto it = d->globalTouch.focus.touchs.constBegin(), end = d->globalTouch.focus.touchs.constEnd(); it != end; ++it) {
         (*it)->frame();
     }
+    d->flushInput(d->globalTouch.focus.surface);
+}
+
+QVector<qint32> SeatInterface::processInputFrame(const QVector<InputEvent> &events)
+{
+    Q_D();
+    QVector<qint32> touchIds;
+    // a nested frame is merged into the outer one
+    const bool outerFrame = !d->inInputFrame;
+    d->inInputFrame = true;
+    bool touchChanged = false;
+
+    for (const InputEvent &event : events) {
+        setTimestamp(event.time);
+        switch (event.type) {
+        case InputEvent::Type::PointerMotion:
+            setPointerPos(event.position);
+            break;
+        case InputEvent::Type::PointerButtonPressed:
+            pointerButtonPressed(event.code);
+            break;
+        case InputEvent::Type::PointerButtonReleased:
+            pointerButtonReleased(event.code);
+            break;
+        case InputEvent::Type::PointerAxis:
+            if (event.delta == 0) {
+                // stops only the one axis
+                pointerAxisV5(event.orientation, event.delta, event.discreteDelta, event.axisSource);
+            } else if (event.orientation == Qt::Vertical) {
+                pointerAxisV5(QPointF(0, event.delta), QPoint(0, event.discreteDelta), event.axisSource);
+            } else {
+                pointerAxisV5(QPointF(event.delta, 0), QPoint(event.discreteDelta, 0), event.axisSource);
+            }
+            break;
+        case InputEvent::Type::TouchDown:
+            touchIds.append(touchDown(event.position));
+            touchChanged = true;
+            break;
+        case InputEvent::Type::TouchMove:
+            touchMove(event.touchId, event.position);
+            touchChanged = true;
+            break;
+        case InputEvent::Type::TouchUp:
+            touchUp(event.touchId);
+            touchChanged = true;
+            break;
+        case InputEvent::Type::KeyPressed:
+            if (d->keyboard) {
+                d->keyboard->keyPressed(event.code);
+            }
+            break;
+        case InputEvent::Type::KeyReleased:
+            if (d->keyboard) {
+                d->keyboard->keyReleased(event.code);
+            }
+            break;
+        }
+    }
+
+    if (!outerFrame) {
+        return touchIds;
+    }
+    d->inInputFrame = false;
+    const QVector<QPointer<PointerInterface>> pointers = std::exchange(d->inputFramePointers, {});
+    for (const QPointer<PointerInterface> &pointer : pointers) {
+        if (pointer) {
+            pointer->d_func()->endInputFrame();
+        }
+    }
+    if (touchChanged) {
+        // unlike touchFrame() this also terminates a frame which ended the touch sequence
+        for (TouchInterface *touch : qAsConst(d->globalTouch.focus.touchs)) {
+            touch->frame();
+        }
+        d->queueInputFlush(d->globalTouch.focus.surface);
+    }
+    d->flushQueuedInput();
+    return touchIds;
 }
 
 bool SeatInterface::hasImplicitTouchGrab(quint32 serial) const
@@ -1388,7 +1765,32 @@ bool SeatInterface::hasImplicitTouchGrab(quint32 serial) const
         // origin surface has been destroyed
         return false;
     }
-    return d->globalTouch.ids.key(serial, -1) != -1;
+    const Private::InputSerial *inputSerial = d->findInputSerial(serial);
+    if (!inputSerial) {
+        return d->isTouchPointSerial(serial);
+    }
+    return inputSerial->type == Private::InputSerial::Type::TouchDown && inputSerial->grab;
+}
+
+bool SeatInterface::hasImplicitGrab(quint32 serial, SurfaceInterface *surface) const
+{
+    Q_D();
+    if (!surface) {
+        return false;
+    }
+    const Private::InputSerial *inputSerial = d->findInputSerial(serial);
+    if (!inputSerial) {
+        return (d->isPressedButtonSerial(serial) && d->globalPointer.focus.surface == surface)
+            || (d->isTouchPointSerial(serial) && d->globalTouch.focus.surface == surface);
+    }
+    return inputSerial->grab && inputSerial->surface == surface;
+}
+
+bool SeatInterface::isInputSerial(quint32 serial, SurfaceInterface *surface) const
+{
+    Q_D();
+    const Private::InputSerial *inputSerial = d->findInputSerial(serial);
+    return surface && inputSerial && inputSerial->surface == surface;
 }
 
 bool SeatInterface::isDrag() const
@@ -1412,13 +1814,12 @@ bool SeatInterface::isDragTouch() const
 bool SeatInterface::hasImplicitPointerGrab(quint32 serial) const
 {
     Q_D();
-    const auto &serials = d->globalPointer.buttonSerials;
-    for (auto it = serials.constBegin(), end = serials.constEnd(); it != end; it++) {
-        if (it.value() == serial) {
-            return isPointerButtonPressed(it.key());
-        }
+    // a released button's serial is the one of its release, it can't start a grab
+    const Private::InputSerial *inputSerial = d->findInputSerial(serial);
+    if (!inputSerial) {
+        return d->isPressedButtonSerial(serial);
     }
-    return false;
+    return inputSerial->type == Private::InputSerial::Type::PointerButton && inputSerial->grab;
 }
 
 QMatrix4x4 SeatInterface::dragSurfaceTransformation() const
@@ -1454,27 +1855,34 @@ void SeatInterface::setFocusedTextInputSurface(SurfaceInterface *surface)
     Q_D();
     const quint32 serial = d->display->nextSerial();
 
-    if (d->focusedTextInputSurface) {
-        disconnect(d->focusedSurfaceDestroyConnection);
-    }
-
     if (d->focusedTextInputSurface != surface){
-        d->textInputV2->d->sendLeave(serial, d->focusedTextInputSurface);
-        d->textInputV3->d->sendLeave(d->focusedTextInputSurface);
+        if (d->focusedTextInputSurface) {
+            disconnect(d->focusedSurfaceDestroyConnection);
+        }
+        if (d->textInputV2) {
+            d->textInputV2->d->sendLeave(serial, d->focusedTextInputSurface);
+        }
+        if (d->textInputV3) {
+            d->textInputV3->d->sendLeave(d->focusedTextInputSurface);
+        }
         d->focusedTextInputSurface = surface;
+        if (d->focusedTextInputSurface) {
+            d->focusedSurfaceDestroyConnection = connect(surface, &SurfaceInterface::aboutToBeDestroyed, this,
+                [this] {
+                    setFocusedTextInputSurface(nullptr);
+                }
+            );
+        }
         emit focusedTextInputSurfaceChanged();
     }
 
-    if (d->focusedTextInputSurface) {
-        d->focusedSurfaceDestroyConnection = connect(surface, &SurfaceInterface::aboutToBeDestroyed, this,
-            [this] {
-                setFocusedTextInputSurface(nullptr);
-            }
-        );
+    // without a text input nobody has bound the text input managers yet
+    if (d->textInputV2) {
+        d->textInputV2->d->sendEnter(surface, serial);
+    }
+    if (d->textInputV3) {
+        d->textInputV3->d->sendEnter(surface);
     }
-
-    d->textInputV2->d->sendEnter(surface, serial);
-    d->textInputV3->d->sendEnter(surface);
     // TODO: setFocusedSurface like in other interfaces
 }
 
@@ -1487,12 +1895,22 @@ SurfaceInterface *SeatInterface::focusedTextInputSurface() const
 TextInputV2Interface *SeatInterface::textInputV2() const
 {
     Q_D();
+    if (!d->textInputV2) {
+        d->textInputV2 = new TextInputV2Interface(const_cast<SeatInterface *>(this));
+        d->textInputV2->d->state = d->textInputState;
+    }
     return d->textInputV2;
 }
 
 TextInputV3Interface *SeatInterface::textInputV3() const
 {
     Q_D();
+    if (!d->textInputV3) {
+        d->textInputV3 = new TextInputV3Interface(const_cast<SeatInterface *>(this));
+        d->textInputV3->d->state = d->textInputState;
+        // there are no resources yet, this only makes the new text input track the focus
+        d->textInputV3->d->sendEnter(d->focusedTextInputSurface);
+    }
     return d->textInputV3;
 }
 AbstractDataSource *SeatInterface::selection() const
@@ -1513,32 +1931,229 @@ void SeatInterface::setSelection(AbstractDataSource *selection)
         disconnect(d->currentSelection, nullptr, this, nullptr);
     }
 
+    if (d->selectionCache && d->selectionCache != selection) {
+        d->selectionCache->deleteLater();
+        d->selectionCache = nullptr;
+    }
+
     if (selection) {
-        auto cleanup = [this]() {
-            setSelection(nullptr);
+        auto cleanup = [this, selection]() {
+            Q_D();
+            ClipboardCache *cache = d->selectionCache;
+            if (cache && cache->origin() == selection && !cache->isEmpty()) {
+                setSelection(cache);
+            } else {
+                setSelection(nullptr);
+            }
         };
         connect(selection, &DataSourceInterface::aboutToBeDestroyed, this, cleanup);
+        if (!d->persistentSelectionMimeTypes.isEmpty() && selection != d->selectionCache) {
+            d->selectionCache = new ClipboardCache(selection, d->persistentSelectionMimeTypes, this);
+        }
     }
 
     d->currentSelection = selection;
 
-    for (auto focussedSelection: qAsConst(d->globalKeyboard.focus.selections)) {
-        if (selection) {
-            focussedSelection->sendSelection(selection);
+    if (d->selectionCoalescingInterval > 0) {
+        d->scheduleSelectionFanOut(false);
+    } else {
+        d->fanOutSelection();
+    }
+}
+
+void SeatInterface::Private::fanOutSelection()
+{
+    selectionPending = false;
+    for (auto focussedSelection: qAsConst(globalKeyboard.focus.selections)) {
+        if (currentSelection) {
+            focussedSelection->sendSelection(currentSelection);
         } else {
             focussedSelection->sendClearSelection();
         }
     }
 
-    for (auto control : qAsConst(d->dataControlDevices)) {
-        if (selection) {
-            control->sendSelection(selection);
+    for (auto control : qAsConst(dataControlDevices)) {
+        if (currentSelection) {
+            control->sendSelection(currentSelection);
         } else {
             control->sendClearSelection();
         }
     }
 
-    emit selectionChanged(selection);
+    emit q->selectionChanged(currentSelection);
+}
+
+void SeatInterface::Private::fanOutPrimarySelection()
+{
+    primarySelectionPending = false;
+    for (auto focussedSelection: qAsConst(globalKeyboard.focus.primarySelections)) {
+        if (currentPrimarySelection) {
+            focussedSelection->sendSelection(currentPrimarySelection);
+        } else {
+            focussedSelection->sendClearSelection();
+        }
+    }
+
+    emit q->primarySelectionChanged(currentPrimarySelection);
+}
+
+void SeatInterface::Private::scheduleSelectionFanOut(bool primary)
+{
+    if (primary) {
+        primarySelectionPending = true;
+    } else {
+        selectionPending = true;
+    }
+    if (!selectionFanOutTimer) {
+        selectionFanOutTimer = new QTimer(q);
+        selectionFanOutTimer->setSingleShot(true);
+        QObject::connect(selectionFanOutTimer, &QTimer::timeout, q, [this] {
+            flushSelectionFanOut();
+        });
+    }
+    // not restarted, a continuous stream of changes still gets announced once per interval
+    if (!selectionFanOutTimer->isActive()) {
+        selectionFanOutTimer->start(selectionCoalescingInterval);
+    }
+}
+
+void SeatInterface::Private::flushSelectionFanOut()
+{
+    if (selectionFanOutTimer) {
+        selectionFanOutTimer->stop();
+    }
+    if (selectionPending) {
+        fanOutSelection();
+    }
+    // a debounced primary selection waits for its own timer
+    if (primarySelectionPending && !(primarySelectionDebounceTimer && primarySelectionDebounceTimer->isActive())) {
+        fanOutPrimarySelection();
+    }
+}
+
+void SeatInterface::Private::debouncePrimarySelectionFanOut()
+{
+    primarySelectionPending = true;
+    if (!primarySelectionDebounceTimer) {
+        primarySelectionDebounceTimer = new QTimer(q);
+        primarySelectionDebounceTimer->setSingleShot(true);
+        QObject::connect(primarySelectionDebounceTimer, &QTimer::timeout, q, [this] {
+            if (primarySelectionPending) {
+                fanOutPrimarySelection();
+            }
+        });
+    }
+    // restarted, only a selection which stays for the whole interval gets announced
+    primarySelectionDebounceTimer->start(primarySelectionDebounceInterval);
+}
+
+void SeatInterface::setPrimarySelectionDebounceInterval(int msec)
+{
+    Q_D();
+    d->primarySelectionDebounceInterval = qMax(0, msec);
+    if (d->primarySelectionDebounceInterval == 0 && d->primarySelectionDebounceTimer && d->primarySelectionDebounceTimer->isActive()) {
+        d->primarySelectionDebounceTimer->stop();
+        d->fanOutPrimarySelection();
+    }
+}
+
+int SeatInterface::primarySelectionDebounceInterval() const
+{
+    Q_D();
+    return d->primarySelectionDebounceInterval;
+}
+
+void SeatInterface::setSelectionCoalescingInterval(int msec)
+{
+    Q_D();
+    d->selectionCoalescingInterval = qMax(0, msec);
+    if (d->selectionCoalescingInterval == 0) {
+        d->flushSelectionFanOut();
+    }
+}
+
+int SeatInterface::selectionCoalescingInterval() const
+{
+    Q_D();
+    return d->selectionCoalescingInterval;
+}
+
+void SeatInterface::setSelectionDeduplicationEnabled(bool enabled)
+{
+    Q_D();
+    d->selectionDeduplication = enabled;
+}
+
+bool SeatInterface::isSelectionDeduplicationEnabled() const
+{
+    Q_D();
+    return d->selectionDeduplication;
+}
+
+void SeatInterface::setPersistentSelectionMimeTypes(const QStringList &mimeTypes)
+{
+    Q_D();
+    d->persistentSelectionMimeTypes = mimeTypes;
+}
+
+QStringList SeatInterface::persistentSelectionMimeTypes() const
+{
+    Q_D();
+    return d->persistentSelectionMimeTypes;
+}
+
+void SeatInterface::setDragMotionThrottlingEnabled(bool enabled)
+{
+    Q_D();
+    if (d->dragMotionThrottling == enabled) {
+        return;
+    }
+    if (d->drag.target) {
+        DataDeviceInterfacePrivate::get(d->drag.target)->flushPendingMotion();
+    }
+    d->dragMotionThrottling = enabled;
+}
+
+bool SeatInterface::isDragMotionThrottlingEnabled() const
+{
+    Q_D();
+    return d->dragMotionThrottling;
+}
+
+quint64 SeatInterface::dragMotionEventCount() const
+{
+    Q_D();
+    return d->dragMotionCount;
+}
+
+quint64 SeatInterface::coalescedDragMotionEventCount() const
+{
+    Q_D();
+    return d->coalescedDragMotionCount;
+}
+
+void SeatInterface::setDragPrefetchMimeTypes(const QStringList &mimeTypes)
+{
+    Q_D();
+    d->dragPrefetchMimeTypes = mimeTypes;
+}
+
+QStringList SeatInterface::dragPrefetchMimeTypes() const
+{
+    Q_D();
+    return d->dragPrefetchMimeTypes;
+}
+
+void SeatInterface::setDragPrefetchSizeLimit(int bytes)
+{
+    Q_D();
+    d->dragPrefetchSizeLimit = qMax(0, bytes);
+}
+
+int SeatInterface::dragPrefetchSizeLimit() const
+{
+    Q_D();
+    return d->dragPrefetchSizeLimit;
 }
 
 void SeatInterface::setPrimarySelection(AbstractDataSource *selection)
@@ -1561,15 +2176,13 @@ void SeatInterface::setPrimarySelection(AbstractDataSource *selection)
 
     d->currentPrimarySelection = selection;
 
-    for (auto focussedSelection: qAsConst(d->globalKeyboard.focus.primarySelections)) {
-        if (selection) {
-            focussedSelection->sendSelection(selection);
-        } else {
-            focussedSelection->sendClearSelection();
-        }
+    if (d->primarySelectionDebounceInterval > 0) {
+        d->debouncePrimarySelectionFanOut();
+    } else if (d->selectionCoalescingInterval > 0) {
+        d->scheduleSelectionFanOut(true);
+    } else {
+        d->fanOutPrimarySelection();
     }
-
-    emit primarySelectionChanged(selection);
 }
 
 }
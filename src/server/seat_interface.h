@@ -9,6 +9,8 @@
 #include <QObject>
 #include <QPoint>
 #include <QMatrix4x4>
+#include <QPair>
+#include <QVector>
 
 #include <KWaylandServer/kwaylandserver_export.h>
 #include "global.h"
@@ -25,6 +27,7 @@ namespace KWaylandServer
 class DataDeviceInterface;
 class AbstractDataSource;
 class Display;
+class KeyboardShortcutsInhibitorV1Interface;
 class SurfaceInterface;
 class TextInputV2Interface;
 class TextInputV3Interface;
@@ -57,6 +60,51 @@ enum class PointerAxisSource {
     WheelTilt
 };
 
+/**
+ * An input event passed to SeatInterface::processInputFrame().
+ *
+ * Only the members relevant for the @p type are used:
+ * @li PointerMotion: @p position in global coordinates as passed to SeatInterface::setPointerPos()
+ * @li PointerButtonPressed, PointerButtonReleased: the native @p code
+ * @li PointerAxis: @p orientation, @p delta, @p discreteDelta and @p axisSource, the scroll of
+ *     consecutive events with the same source is merged like for SeatInterface::pointerAxisV5()
+ * @li TouchDown: @p position in global coordinates
+ * @li TouchMove: @p touchId and @p position in global coordinates
+ * @li TouchUp: @p touchId
+ * @li KeyPressed, KeyReleased: the native @p code
+ *
+ * @since 5.22
+ **/
+struct InputEvent
+{
+    enum class Type {
+        PointerMotion,
+        PointerButtonPressed,
+        PointerButtonReleased,
+        PointerAxis,
+        TouchDown,
+        TouchMove,
+        TouchUp,
+        KeyPressed,
+        KeyReleased
+    };
+    Type type = Type::PointerMotion;
+    /**
+     * The timestamp of the event in milliseconds, see SeatInterface::setTimestamp().
+     **/
+    quint32 time = 0;
+    QPointF position;
+    /**
+     * The button of a pointer button event or the key of a key event.
+     **/
+    quint32 code = 0;
+    qint32 touchId = 0;
+    Qt::Orientation orientation = Qt::Vertical;
+    qreal delta = 0;
+    qint32 discreteDelta = 0;
+    PointerAxisSource axisSource = PointerAxisSource::Unknown;
+};
+
 /**
  * @brief Represents a Seat on the Wayland Display.
  *
@@ -150,6 +198,25 @@ public:
     void setTimestamp(quint32 time);
     quint32 timestamp() const;
 
+    /**
+     * Sets whether discrete input events are flushed to the receiving client right away.
+     *
+     * Normally all clients are flushed together once the event loop is about to block. With
+     * this enabled, key events, pointer button and axis events and touch frames are followed
+     * by a flush of just the client they were sent to. Within processInputFrame() the clients
+     * are flushed once at the end of the frame. Pointer motion is not flushed on its own.
+     *
+     * Disabled by default.
+     * @since 5.22
+     **/
+    void setFlushInputImmediately(bool enabled);
+    /**
+     * @returns Whether discrete input events are flushed right away.
+     * @see setFlushInputImmediately
+     * @since 5.22
+     **/
+    bool flushesInputImmediately() const;
+
     /**
      * @name Drag'n'Drop related methods
      **/
@@ -218,6 +285,70 @@ public:
      * @since 5.6
      **/
     void setDragTarget(SurfaceInterface *surface, const QMatrix4x4 &inputTransformation = QMatrix4x4());
+    /**
+     * Enables or disables throttling of wl_data_device.motion events during drag and drop.
+     *
+     * With throttling enabled the drag target gets at most one motion event per refresh cycle
+     * of the fastest output its surface is on, pointer and touch motions in between are merged
+     * into the following motion event. A merged motion is sent before the drop, so the target
+     * always knows the final position. Motions merged while the drag leaves a surface are
+     * dropped together with the leave event.
+     *
+     * Throttling is disabled by default. Disabling it sends out a pending motion event.
+     * @see coalescedDragMotionEventCount
+     * @since 5.22
+     **/
+    void setDragMotionThrottlingEnabled(bool enabled);
+    /**
+     * @returns whether wl_data_device.motion events are throttled
+     * @see setDragMotionThrottlingEnabled
+     * @since 5.22
+     **/
+    bool isDragMotionThrottlingEnabled() const;
+    /**
+     * @returns the number of wl_data_device.motion events sent by this seat
+     * @since 5.22
+     **/
+    quint64 dragMotionEventCount() const;
+    /**
+     * @returns the number of drag motions merged into a later motion event or dropped with
+     * a leave event instead of being sent to the drag target
+     * @see setDragMotionThrottlingEnabled
+     * @since 5.22
+     **/
+    quint64 coalescedDragMotionEventCount() const;
+    /**
+     * Makes the server read the data of a drag and drop operation for the @p mimeTypes into
+     * memory as soon as the drag starts. The receive requests of the drop targets, e.g. file
+     * managers checking the dragged URIs while the pointer hovers them, are then served from
+     * memory instead of a round trip to the dragging client each. A mime type with the
+     * subtype @c * matches all mime types of its media type. Data larger than
+     * dragPrefetchSizeLimit is left to the dragging client.
+     *
+     * The default empty list doesn't prefetch anything.
+     * @see setDragPrefetchSizeLimit
+     * @since 5.22
+     **/
+    void setDragPrefetchMimeTypes(const QStringList &mimeTypes);
+    /**
+     * @returns the mime types prefetched at the start of a drag
+     * @see setDragPrefetchMimeTypes
+     * @since 5.22
+     **/
+    QStringList dragPrefetchMimeTypes() const;
+    /**
+     * Sets the largest data of a single mime type the drag prefetch keeps to @p bytes. The
+     * default is 64 KiB.
+     * @see setDragPrefetchMimeTypes
+     * @since 5.22
+     **/
+    void setDragPrefetchSizeLimit(int bytes);
+    /**
+     * @returns the largest data of a single mime type the drag prefetch keeps
+     * @see setDragPrefetchSizeLimit
+     * @since 5.22
+     **/
+    int dragPrefetchSizeLimit() const;
     ///@}
 
     /**
@@ -234,6 +365,48 @@ public:
      * @returns the global pointer position
      **/
     QPointF pointerPos() const;
+    /**
+     * Enables or disables coalescing of pointer motion events.
+     *
+     * With coalescing enabled, setPointerPos() does not send a motion event on its own.
+     * Motion events to the same surface are merged and only the last position is sent once
+     * the next pointer event (button, axis, relative motion or focus change) is sent, when
+     * flushPointerMotion() is called, or when the Display flushes its clients before the event
+     * loop goes to sleep. The order of motion, button and axis events is not changed.
+     *
+     * Coalescing is disabled by default. Disabling it sends out a pending motion event.
+     *
+     * @see flushPointerMotion
+     * @since 5.22
+     **/
+    void setPointerMotionCoalescingEnabled(bool enabled);
+    /**
+     * @returns Whether pointer motion events are coalesced.
+     * @see setPointerMotionCoalescingEnabled
+     * @since 5.22
+     **/
+    bool isPointerMotionCoalescingEnabled() const;
+    /**
+     * Sends a pending coalesced motion event to the focused pointer surface, followed by a
+     * wl_pointer.frame event. Does nothing if coalescing is disabled or there is no pending
+     * motion. The motion for a congested client is kept until it is no longer congested.
+     *
+     * @see setPointerMotionCoalescingEnabled
+     * @since 5.22
+     **/
+    void flushPointerMotion();
+    /**
+     * @returns The number of wl_pointer.motion events sent by this seat.
+     * @since 5.22
+     **/
+    quint64 pointerMotionEventCount() const;
+    /**
+     * @returns The number of pointer motions merged into a later motion event instead of
+     * being sent to the client.
+     * @see setPointerMotionCoalescingEnabled
+     * @since 5.22
+     **/
+    quint64 coalescedPointerMotionEventCount() const;
     /**
      * Sets the focused pointer @p surface.
      * All pointer events will be sent to the @p surface till a new focused pointer surface gets
@@ -387,6 +560,23 @@ public:
      * @todo Drop V5 suffix with KF6.
      **/
     void pointerAxisV5(Qt::Orientation orientation, qreal delta, qint32 discreteDelta, PointerAxisSource source);
+    /**
+     * Sends the scroll on both axes to the currently focused pointer surface, with a single
+     * axis_source and frame event, e.g. for diagonal touchpad scrolling.
+     *
+     * Axes with a @c 0 delta are left out. If neither axis has a delta, axis_stop events are
+     * sent for both, e.g. when the fingers are lifted off the touchpad.
+     *
+     * Within processInputFrame() the scroll of consecutive calls with the same @p source is
+     * merged, the summed deltas are sent before the next other pointer event or the end of
+     * the frame.
+     *
+     * @param delta The horizontal and vertical scroll.
+     * @param discreteDelta The number of discrete steps on each axis, e.g. mouse wheel clicks.
+     * @param source Describes how the axis event was physically generated.
+     * @since 5.22
+     **/
+    void pointerAxisV5(const QPointF &delta, const QPoint &discreteDelta, PointerAxisSource source);
     /**
      * @see pointerAxisV5
      **/
@@ -556,6 +746,19 @@ public:
     void setFocusedKeyboardSurface(SurfaceInterface *surface);
     SurfaceInterface *focusedKeyboardSurface() const;
     KeyboardInterface *keyboard() const;
+    /**
+     * The shortcuts inhibitor of the focusedKeyboardSurface for this seat, @c nullptr if the
+     * surface doesn't inhibit shortcuts. Shortcuts are inhibited while the inhibitor
+     * isActive().
+     *
+     * The inhibitor is looked up when the keyboard focus changes, so this is cheap enough to
+     * be called on every key press.
+     *
+     * @see setFocusedKeyboardSurface
+     * @see KeyboardShortcutsInhibitManagerV1Interface::findInhibitor
+     * @since 5.22
+     **/
+    KeyboardShortcutsInhibitorV1Interface *focusedKeyboardShortcutsInhibitor() const;
     ///@}
 
     /**
@@ -567,9 +770,24 @@ public:
     TouchInterface *focusedTouch() const;
     void setFocusedTouchSurfacePosition(const QPointF &surfacePosition);
     QPointF focusedTouchSurfacePosition() const;
+    /**
+     * Starts a new touch point at @p globalPosition and returns its id. At most 16 touch
+     * points can be active at the same time, further touch downs are ignored and return @c -1.
+     *
+     * The input area scale the focused touch surface has at the first touch down of a sequence
+     * applies to all points of the sequence.
+     **/
     qint32 touchDown(const QPointF &globalPosition);
     void touchUp(qint32 id);
     void touchMove(qint32 id, const QPointF &globalPosition);
+    /**
+     * Moves several touch points, given as pairs of id and global position, and sends a
+     * single touchFrame() after all of them.
+     *
+     * @see touchMove
+     * @since 5.22
+     **/
+    void touchMoveBatch(const QVector<QPair<qint32, QPointF>> &points);
     void touchFrame();
     void cancelTouchSequence();
     bool isTouchSequence() const;
@@ -581,6 +799,43 @@ public:
     bool hasImplicitTouchGrab(quint32 serial) const;
     ///@}
 
+    /**
+     * @returns true if @p serial is the one of a pressed pointer button or of an active touch
+     * point whose implicit grab started on @p surface. Requests which need an implicit grab,
+     * e.g. xdg_toplevel.move, xdg_toplevel.resize or wl_data_device.start_drag, can be checked
+     * with it. Recent serials are looked up without depending on the number of buttons or
+     * touch points.
+     * @see hasImplicitPointerGrab
+     * @see hasImplicitTouchGrab
+     * @since 5.22
+     **/
+    bool hasImplicitGrab(quint32 serial, SurfaceInterface *surface) const;
+    /**
+     * @returns true if @p serial is the one of a recent pointer button press, touch down or key
+     * press on @p surface, whether it's released or not. Requests which only have to be in
+     * response to user input, e.g. xdg_popup.grab, can be checked with it.
+     * @since 5.22
+     **/
+    bool isInputSerial(quint32 serial, SurfaceInterface *surface) const;
+
+    /**
+     * Processes the input @p events of one hardware frame at once.
+     *
+     * The events are routed in order like the corresponding single event methods would
+     * route them, with the seat's timestamp set to the time of each event. Unlike the single
+     * event methods, each client gets at most one wl_pointer.frame and one wl_touch.frame
+     * event, sent after all events of the frame. Pointer motions within the frame are merged
+     * into the last motion before any other pointer event, so at most one motion per pointer
+     * event group is sent.
+     *
+     * TouchDown events get the ids touchDown() would assign, they are returned in the order
+     * of the TouchDown events so that later frames can refer to the touch points.
+     *
+     * @see InputEvent
+     * @since 5.22
+     **/
+    QVector<qint32> processInputFrame(const QVector<InputEvent> &events);
+
     /**
      * @name Text input related methods.
      **/
@@ -618,12 +873,17 @@ public:
      * It is recommended to check the enabled state before interacting with the
      * TextInputV2Interface.
      *
+     * The text input is created on the first call or when the first client binds the
+     * text input manager.
+     *
      * @see focusedTextInputChanged
      * @see focusedTextInputSurface
      * @since 5.23
      **/
     TextInputV2Interface *textInputV2() const;
-    
+    /**
+     * Like textInputV2(), the text input is created on the first call.
+     **/
     TextInputV3Interface *textInputV3() const;
     ///@}
 
@@ -650,9 +910,92 @@ public:
      * @since 5.24
      **/
     void setSelection(AbstractDataSource *selection);
+    /**
+     * Makes the server keep a copy of the clipboard selection, so it can still be pasted
+     * after the client which set it went away without a clipboard manager having to take
+     * it over. When a selection is set its content for the @p mimeTypes is read into memory
+     * right away, once its source is destroyed the copy becomes the selection and serves
+     * all receive requests itself. A mime type with the subtype @c * matches all mime types
+     * of its media type. The content of a single mime type is limited to 64 MiB.
+     *
+     * The default empty list doesn't keep any copy.
+     * @see selection
+     * @since 5.22
+     **/
+    void setPersistentSelectionMimeTypes(const QStringList &mimeTypes);
+    /**
+     * @returns the mime types of the clipboard selection kept by the server
+     * @see setPersistentSelectionMimeTypes
+     * @since 5.22
+     **/
+    QStringList persistentSelectionMimeTypes() const;
+    /**
+     * Coalesces rapid changes of the clipboard and the primary selection. When a selection
+     * changes, the data devices of the focused client and the data control devices are only
+     * told about it once @p msec passed, about the selection which is current by then. The
+     * selections in between, e.g. while text is selected with the pointer in a terminal,
+     * never get offered to any client. selectionChanged and primarySelectionChanged are
+     * delayed the same way, while selection and the seat's primary selection change right away.
+     *
+     * The default @c 0 announces every change immediately.
+     * @see setSelection
+     * @see setPrimarySelection
+     * @since 5.22
+     **/
+    void setSelectionCoalescingInterval(int msec);
+    /**
+     * @returns the interval by which selection changes are coalesced, in milliseconds
+     * @see setSelectionCoalescingInterval
+     * @since 5.22
+     **/
+    int selectionCoalescingInterval() const;
+    /**
+     * Skips the selection and primary selection events for data devices which got the
+     * current selection already and still have its data offer, as it happens whenever the
+     * keyboard focus moves to a client again. The client keeps using that offer instead of
+     * getting a new one with all its mime types, e.g. a clipboard bridge doesn't see the same
+     * selection again whenever the focus moves between its surfaces and others. The protocol asks for a selection event before each
+     * keyboard enter, so this should only be enabled for clients which keep their selection
+     * offer until they get a new one, as all common toolkits do.
+     *
+     * Disabled by default.
+     * @see AbstractDataSource::generation
+     * @since 5.22
+     **/
+    void setSelectionDeduplicationEnabled(bool enabled);
+    /**
+     * Debounces changes of the primary selection, which terminals and editors update with
+     * every pointer motion while text gets selected. A new primary selection is only
+     * announced to the focused client, and with primarySelectionChanged, once it wasn't
+     * replaced for @p msec, so only the final selection of a drag is offered. The seat's own
+     * primary selection changes right away. Unlike setSelectionCoalescingInterval, every
+     * change restarts the interval. While set, it takes precedence over the coalescing
+     * interval for the primary selection.
+     *
+     * The default @c 0 doesn't debounce.
+     * @since 5.22
+     **/
+    void setPrimarySelectionDebounceInterval(int msec);
+    /**
+     * @returns the interval by which primary selection changes are debounced, in milliseconds
+     * @see setPrimarySelectionDebounceInterval
+     * @since 5.22
+     **/
+    int primarySelectionDebounceInterval() const;
+    /**
+     * @returns whether selections already seen by a data device are not sent again
+     * @see setSelectionDeduplicationEnabled
+     * @since 5.22
+     **/
+    bool isSelectionDeduplicationEnabled() const;
 
     void setPrimarySelection(AbstractDataSource *selection);
 
+    /**
+     * @returns The SeatInterface of the wl_seat resource @p native, or @c nullptr if @p native
+     * is not a wl_seat. The seat is stored in the resource, so the lookup doesn't depend on
+     * the number of seats or of bound resources.
+     **/
     static SeatInterface *get(wl_resource *native);
 
 Q_SIGNALS:
@@ -670,6 +1013,9 @@ Q_SIGNALS:
 
     /**
      * Emitted whenever the focused pointer changes
+     *
+     * Moving the pointer focus between surfaces of the same client doesn't change the
+     * focused pointer, the signal isn't emitted in that case.
      * @since 5.6
      **/
     void focusedPointerChanged(KWaylandServer::PointerInterface*);
@@ -716,9 +1062,13 @@ Q_SIGNALS:
 private:
     friend class DataControlDeviceV1Interface;
     friend class DataDeviceInterface;
+    friend class DataDeviceInterfacePrivate;
     friend class PrimarySelectionDeviceV1Interface;
     friend class TextInputManagerV2InterfacePrivate;
     friend class KeyboardInterface;
+    friend class KeyboardShortcutsInhibitorV1InterfacePrivate;
+    friend class KeyboardShortcutsInhibitManagerV1InterfacePrivate;
+    friend class PointerInterface;
 
     class Private;
     Private *d_func() const;
@@ -8,21 +8,30 @@
 // KWayland
 #include "seat_interface.h"
 #include "global_p.h"
+#include "inputlatency.h"
+#include "pressedcodes_p.h"
+#include "textinputstate_p.h"
 // Qt
 #include <QHash>
-#include <QMap>
 #include <QPointer>
+#include <QSharedPointer>
+#include <QTimer>
 #include <QVector>
 // Wayland
 #include <wayland-server.h>
 
+#include <array>
+
 namespace KWaylandServer
 {
 
 class AbstractDataSource;
+class ClipboardCache;
+class ClientConnection;
 class DataDeviceInterface;
 class DataSourceInterface;
 class DataControlDeviceV1Interface;
+class KeyboardShortcutsInhibitorV1Interface;
 class TextInputV2Interface;
 class TextInputV3Interface;
 class PrimarySelectionDeviceV1Interface;
@@ -38,28 +47,58 @@ public:
     QVector<KeyboardInterface *> keyboardsForSurface(SurfaceInterface *surface) const;
     QVector<TouchInterface *> touchsForSurface(SurfaceInterface *surface) const;
     QVector<DataDeviceInterface *> dataDevicesForSurface(SurfaceInterface *surface) const;
+    QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevicesForSurface(SurfaceInterface *surface) const;
     void registerPrimarySelectionDevice(PrimarySelectionDeviceV1Interface *primarySelectionDevice);
     void registerDataDevice(DataDeviceInterface *dataDevice);
     void registerDataControlDevice(DataControlDeviceV1Interface *dataDevice);
+    void startDragPrefetch(AbstractDataSource *source);
     void endDrag(quint32 serial);
     void cancelDrag(quint32 serial);
     quint32 nextSerial() const;
+    void scheduleSelectionFanOut(bool primary);
+    void flushSelectionFanOut();
+    void debouncePrimarySelectionFanOut();
+    void fanOutSelection();
+    void fanOutPrimarySelection();
 
     QString name;
     bool pointer = false;
     bool touch = false;
     QList<wl_resource*> resources;
     quint32 timestamp = 0;
-    QVector<PointerInterface*> pointers;
     QScopedPointer<KeyboardInterface> keyboard;
-    QVector<TouchInterface*> touchs;
-    QVector<DataDeviceInterface*> dataDevices;
-    QVector<PrimarySelectionDeviceV1Interface*> primarySelectionDevices;
     QVector<DataControlDeviceV1Interface*> dataControlDevices;
 
-    // TextInput v2
+    /**
+     * The devices a client has created for this seat. Looking up the devices of the focused
+     * client does not depend on the number of clients connected to the seat.
+     */
+    struct ClientDevices {
+        QVector<PointerInterface *> pointers;
+        QVector<TouchInterface *> touchs;
+        QVector<DataDeviceInterface *> dataDevices;
+        QVector<PrimarySelectionDeviceV1Interface *> primarySelectionDevices;
+
+        bool isEmpty() const {
+            return pointers.isEmpty() && touchs.isEmpty() && dataDevices.isEmpty() && primarySelectionDevices.isEmpty();
+        }
+    };
+    QHash<ClientConnection *, ClientDevices> clientDevices;
+    const ClientDevices &devicesForClient(ClientConnection *client) const;
+    const ClientDevices &devicesForSurface(SurfaceInterface *surface) const;
+    /**
+     * Records an input event of @p type for the client of @p surface if the Display tracks
+     * input latency.
+     **/
+    void recordInputLatency(SurfaceInterface *surface, InputLatencyEventType type);
+    template <typename T>
+    void removeClientDevice(ClientConnection *client, QVector<T *> ClientDevices::*devices, T *device);
+
+    // TextInput v2 and v3, created once a client binds the manager or the compositor asks for them
     QPointer<TextInputV2Interface> textInputV2;
     QPointer<TextInputV3Interface> textInputV3;
+    // their state, shared so a client binding both versions doesn't keep it twice
+    QSharedPointer<TextInputState> textInputState = QSharedPointer<TextInputState>::create();
 
     SurfaceInterface *focusedTextInputSurface = nullptr;
     QMetaObject::Connection focusedSurfaceDestroyConnection;
@@ -67,6 +106,22 @@ public:
     // the last thing copied into the clipboard content
     AbstractDataSource *currentSelection = nullptr;
     AbstractDataSource *currentPrimarySelection = nullptr;
+    // the copy of the clipboard selection which replaces it once its source is gone
+    QStringList persistentSelectionMimeTypes;
+    ClipboardCache *selectionCache = nullptr;
+    // the data of the last drag, kept until its source goes away
+    QStringList dragPrefetchMimeTypes;
+    int dragPrefetchSizeLimit = 64 * 1024;
+    QPointer<ClipboardCache> dragPrefetch;
+    // selection changes are announced once per interval, with the last selection
+    int selectionCoalescingInterval = 0;
+    QTimer *selectionFanOutTimer = nullptr;
+    bool selectionPending = false;
+    bool primarySelectionPending = false;
+    bool selectionDeduplication = false;
+    // primary selection changes are announced once they stayed for this interval
+    int primarySelectionDebounceInterval = 0;
+    QTimer *primarySelectionDebounceTimer = nullptr;
 
     // Pointer related members
     struct Pointer {
@@ -74,8 +129,9 @@ public:
             Released,
             Pressed
         };
-        QHash<quint32, quint32> buttonSerials;
-        QHash<quint32, State> buttonStates;
+        PressedCodes buttons;
+        // the serial of the last press or release, indexed by the button code
+        std::array<quint32, KEY_CNT> buttonSerials = {};
         QPointF pos;
         struct Focus {
             SurfaceInterface *surface = nullptr;
@@ -89,6 +145,25 @@ public:
         QPointer<SurfaceInterface> gestureSurface;
     };
     Pointer globalPointer;
+    bool pointerMotionCoalescing = false;
+    quint64 pointerMotionCount = 0;
+    quint64 coalescedPointerMotionCount = 0;
+    bool dragMotionThrottling = false;
+    quint64 dragMotionCount = 0;
+    quint64 coalescedDragMotionCount = 0;
+    // set while processInputFrame() defers the pointer frame events
+    bool inInputFrame = false;
+    QVector<QPointer<PointerInterface>> inputFramePointers;
+    bool flushInputImmediately = false;
+    // clients waiting for the flush at the end of the input frame
+    QVector<QPointer<ClientConnection>> inputFlushClients;
+    /**
+     * Flushes the client of @p surface if input is flushed immediately, or at the end of the
+     * current input frame.
+     **/
+    void flushInput(SurfaceInterface *surface);
+    void queueInputFlush(SurfaceInterface *surface);
+    void flushQueuedInput();
     void updatePointerButtonSerial(quint32 button, quint32 serial);
     void updatePointerButtonState(quint32 button, Pointer::State state);
 
@@ -100,10 +175,16 @@ public:
             quint32 serial = 0;
             QVector<DataDeviceInterface *> selections;
             QVector<PrimarySelectionDeviceV1Interface *> primarySelections;
+            KeyboardShortcutsInhibitorV1Interface *shortcutsInhibitor = nullptr;
         };
         Focus focus;
+        // the shortcuts inhibitors for this seat by their surface, the one of the focused
+        // surface is kept in the focus so checking it on a key press is a pointer compare
+        QHash<SurfaceInterface *, KeyboardShortcutsInhibitorV1Interface *> shortcutsInhibitors;
     };
     Keyboard globalKeyboard;
+    void registerKeyboardShortcutsInhibitor(KeyboardShortcutsInhibitorV1Interface *inhibitor);
+    void unregisterKeyboardShortcutsInhibitor(KeyboardShortcutsInhibitorV1Interface *inhibitor);
 
     // Touch related members
     struct Touch {
@@ -113,11 +194,61 @@ public:
             QMetaObject::Connection destroyConnection;
             QPointF offset = QPointF();
             QPointF firstTouchPos;
+            // the input area scale of the surface, taken when the implicit grab starts with
+            // the first touch down and kept for the whole sequence
+            qreal eventScale = 1.;
         };
         Focus focus;
-        QMap<qint32, quint32> ids;
+
+        struct Point {
+            qint32 id;
+            // the serial of the touch down event
+            quint32 serial;
+        };
+        // A touch screen reports at most ten points in practice, so the points are kept in
+        // a small array: the active points are packed at the front in the order they touched
+        // down. As a new point gets the highest id plus one, the ids are increasing as well.
+        static constexpr int maximumPoints = 16;
+        std::array<Point, maximumPoints> points;
+        int pointCount = 0;
+
+        Point *findPoint(qint32 id);
+        const Point *findPoint(qint32 id) const;
+        void removePoint(qint32 id);
+        bool isEmpty() const {
+            return pointCount == 0;
+        }
     };
     Touch globalTouch;
+    void moveTouchPoint(qint32 id, const QPointF &globalPosition);
+
+    // The serials of the recent button presses, touch downs and key presses, which requests
+    // like xdg_toplevel.move or wl_data_device.start_drag have to be in response to. A serial
+    // is kept in the slot of its low bits, so it's found without a search. Serials increase,
+    // one is only overwritten by another which is inputSerialCount newer. As serials are shared
+    // by the whole display, a still held grab can be older, so a miss has to be checked against
+    // the pressed buttons and the touch points.
+    struct InputSerial {
+        enum class Type {
+            None,
+            PointerButton,
+            TouchDown,
+            Key
+        };
+        quint32 serial = 0;
+        Type type = Type::None;
+        // the implicit grab of a pressed button or touch point lasts until it's released
+        bool grab = false;
+        QPointer<SurfaceInterface> surface;
+    };
+    static constexpr int inputSerialCount = 64;
+    std::array<InputSerial, inputSerialCount> inputSerials;
+    void recordInputSerial(quint32 serial, InputSerial::Type type, SurfaceInterface *surface);
+    void endImplicitGrab(quint32 serial);
+    const InputSerial *findInputSerial(quint32 serial) const;
+    // the exact checks for serials which are no longer in inputSerials
+    bool isPressedButtonSerial(quint32 serial) const;
+    bool isTouchPointSerial(quint32 serial) const;
 
     struct Drag {
         enum class Mode {
@@ -138,8 +269,10 @@ public:
     Drag drag;
 
     static SeatInterface *get(wl_resource *native) {
-        auto s = cast(native);
-        return s ? s->q : nullptr;
+        if (!native || !wl_resource_instance_of(native, &wl_seat_interface, &s_interface)) {
+            return nullptr;
+        }
+        return cast(native)->q;
     }
 
 private:
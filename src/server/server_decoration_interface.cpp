@@ -8,7 +8,7 @@
 #include "logging.h"
 #include "surface_interface.h"
 
-#include <QVector>
+#include <QHash>
 
 #include <qwayland-server-server-decoration.h>
 
@@ -69,7 +69,7 @@ void ServerSideDecorationManagerInterfacePrivate::setDefaultMode(ServerSideDecor
     defaultMode = mode;
     const uint32_t wlMode = modeWayland(mode);
 
-    const auto clientResources = resourceMap();
+    const auto clientResources = resources();
     for (Resource *resource : clientResources) {
         send_default_mode(resource->handle, wlMode);
     }
@@ -119,7 +119,9 @@ public:
 
 private:
     ServerSideDecorationInterface *q;
-    static QVector<ServerSideDecorationInterfacePrivate*> s_all;
+    // by surface, so that destroying hundreds of decorations doesn't search a list each time;
+    // a client may create several decorations for one surface
+    static QMultiHash<SurfaceInterface *, ServerSideDecorationInterfacePrivate *> s_all;
 
 protected:
     void org_kde_kwin_server_decoration_destroy_resource(Resource *resource) override;
@@ -127,7 +129,7 @@ protected:
     void org_kde_kwin_server_decoration_request_mode(Resource *resource, uint32_t mode) override;
 };
 
-QVector<ServerSideDecorationInterfacePrivate*> ServerSideDecorationInterfacePrivate::s_all;
+QMultiHash<SurfaceInterface *, ServerSideDecorationInterfacePrivate *> ServerSideDecorationInterfacePrivate::s_all;
 
 void ServerSideDecorationInterfacePrivate::org_kde_kwin_server_decoration_request_mode(Resource *resource, uint32_t mode)
 {
@@ -164,12 +166,13 @@ void ServerSideDecorationInterfacePrivate::org_kde_kwin_server_decoration_destro
 
 ServerSideDecorationInterface *ServerSideDecorationInterfacePrivate::get(SurfaceInterface *surface)
 {
-    for (ServerSideDecorationInterfacePrivate *decoration : qAsConst(s_all)) {
-        if (decoration->surface == surface) {
-            return decoration->q;
-        }
+    // the decorations of a surface are iterated from the latest to the oldest, the oldest one
+    // is returned, like when the decorations were kept in a list
+    ServerSideDecorationInterfacePrivate *decoration = nullptr;
+    for (auto it = s_all.constFind(surface); it != s_all.constEnd() && it.key() == surface; ++it) {
+        decoration = *it;
     }
-    return nullptr;
+    return decoration ? decoration->q : nullptr;
 }
 
 ServerSideDecorationInterfacePrivate::ServerSideDecorationInterfacePrivate(ServerSideDecorationInterface *_q, SurfaceInterface *surface, wl_resource *resource)
@@ -177,12 +180,12 @@ ServerSideDecorationInterfacePrivate::ServerSideDecorationInterfacePrivate(Serve
     , surface(surface)
     , q(_q)
 {
-    s_all << this;
+    s_all.insert(surface, this);
 }
 
 ServerSideDecorationInterfacePrivate::~ServerSideDecorationInterfacePrivate()
 {
-    s_all.removeAll(this);
+    s_all.remove(surface, this);
 }
 
 void ServerSideDecorationInterfacePrivate::setMode(ServerSideDecorationManagerInterface::Mode mode)
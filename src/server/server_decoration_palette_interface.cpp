@@ -8,6 +8,8 @@
 #include "surface_interface.h"
 #include "logging.h"
 
+#include <QHash>
+#include <QPointer>
 #include <QtGlobal>
 
 #include <qwayland-server-server-decoration-palette.h>
@@ -22,7 +24,8 @@ class ServerSideDecorationPaletteManagerInterfacePrivate : public QtWaylandServe
 public:
     ServerSideDecorationPaletteManagerInterfacePrivate(ServerSideDecorationPaletteManagerInterface *q, Display *display);
 
-    QVector<ServerSideDecorationPaletteInterface*> palettes;
+    // the surface may be gone before its palette, the lookup compares the guarded surface
+    QHash<SurfaceInterface *, ServerSideDecorationPaletteInterface *> palettes;
     ServerSideDecorationPaletteManagerInterface *q;
 
 protected:
@@ -46,9 +49,12 @@ void ServerSideDecorationPaletteManagerInterfacePrivate::org_kde_kwin_server_dec
     }
     auto palette = new ServerSideDecorationPaletteInterface(s, palette_resource);
 
-    palettes.append(palette);
-    QObject::connect(palette, &QObject::destroyed, q, [=]() {
-        palettes.removeOne(palette);
+    palettes.insert(s, palette);
+    QObject::connect(palette, &QObject::destroyed, q, [this, s, palette]() {
+        auto it = palettes.find(s);
+        if (it != palettes.end() && *it == palette) {
+            palettes.erase(it);
+        }
     });
     emit q->paletteCreated(palette);
 }
@@ -69,10 +75,9 @@ ServerSideDecorationPaletteManagerInterface::~ServerSideDecorationPaletteManager
 
 ServerSideDecorationPaletteInterface *ServerSideDecorationPaletteManagerInterface::paletteForSurface(SurfaceInterface *surface)
 {
-    for (ServerSideDecorationPaletteInterface *menu : qAsConst(d->palettes)) {
-        if (menu->surface() == surface) {
-            return menu;
-        }
+    ServerSideDecorationPaletteInterface *palette = d->palettes.value(surface);
+    if (palette && palette->surface() == surface) {
+        return palette;
     }
     return nullptr;
 }
@@ -82,7 +87,7 @@ class ServerSideDecorationPaletteInterfacePrivate : public QtWaylandServer::org_
 public:
     ServerSideDecorationPaletteInterfacePrivate(ServerSideDecorationPaletteInterface *_q, SurfaceInterface *surface, wl_resource *resource);
 
-    SurfaceInterface *surface;
+    QPointer<SurfaceInterface> surface;
     QString palette;
     ServerSideDecorationPaletteInterface *q;
 
@@ -5,9 +5,15 @@
 */
 #include "shadow_interface.h"
 #include "buffer_interface.h"
+#include "buffer_interface_p.h"
 #include "display.h"
 #include "surface_interface_p.h"
 
+#include <QPainter>
+#include <QtAlgorithms>
+
+#include <algorithm>
+
 #include <qwayland-server-shadow.h>
 
 namespace KWaylandServer
@@ -86,7 +92,7 @@ Display *ShadowManagerInterface::display() const
     return d->display;
 }
 
-class ShadowInterfacePrivate : public QtWaylandServer::org_kde_kwin_shadow
+class ShadowInterfacePrivate : public QtWaylandServer::org_kde_kwin_shadow, public BufferDestroyObserver
 {
 public:
     ShadowInterfacePrivate(ShadowInterface *_q, wl_resource *resource);
@@ -119,13 +125,30 @@ public:
 
     void commit();
     void attach(State::Flags flag, wl_resource *buffer);
+    void updateTile(ShadowInterface::Tile tile, BufferInterface *buffer);
+    void updateAtlasLayout();
+    BufferInterface *tile(ShadowInterface::Tile tile) const;
+
+    static uint hashTile(BufferInterface *buffer, bool *comparable);
+    static int tileIndex(ShadowInterface::Tile tile);
 
     ShadowManagerInterface *manager;
     State current;
     State pending;
     ShadowInterface *q;
 
+    static const int s_tileCount = 8;
+    uint tileHashes[s_tileCount] = {};
+    QRect atlasRects[s_tileCount];
+    ShadowInterface::Tiles changedTiles;
+    uint contentHash = 0;
+    // built on demand, the compositor might not use it at all
+    QImage atlas;
+    bool atlasDirty = false;
+
 protected:
+    void bufferDestroyed(BufferInterface *buffer) override;
+
     void org_kde_kwin_shadow_destroy_resource(Resource *resource) override;
     void org_kde_kwin_shadow_commit(Resource *resource) override;
     void org_kde_kwin_shadow_attach_left(Resource *resource, wl_resource *buffer) override;
@@ -147,6 +170,7 @@ protected:
 void ShadowInterfacePrivate::org_kde_kwin_shadow_commit(Resource *resource)
 {
     Q_UNUSED(resource)
+    changedTiles = ShadowInterface::Tiles();
 #define BUFFER( __FLAG__, __PART__ ) \
     if (pending.flags & State::Flags::__FLAG__##Buffer) { \
         if (current.__PART__) { \
@@ -156,6 +180,7 @@ void ShadowInterfacePrivate::org_kde_kwin_shadow_commit(Resource *resource)
             pending.__PART__->ref(); \
         } \
         current.__PART__ = pending.__PART__; \
+        updateTile(ShadowInterface::__FLAG__##Tile, current.__PART__); \
     }
     BUFFER(Left, left)
     BUFFER(TopLeft, topLeft)
@@ -167,48 +192,148 @@ void ShadowInterfacePrivate::org_kde_kwin_shadow_commit(Resource *resource)
     BUFFER(BottomLeft, bottomLeft)
 #undef BUFFER
 
+    if (changedTiles) {
+        contentHash = qHashRange(std::begin(tileHashes), std::end(tileHashes));
+        updateAtlasLayout();
+        atlas = QImage();
+        atlasDirty = true;
+    }
+
     if (pending.flags & State::Offset) {
         current.offset = pending.offset;
     }
     pending = State();
 }
 
+int ShadowInterfacePrivate::tileIndex(ShadowInterface::Tile tile)
+{
+    return qCountTrailingZeroBits(uint(tile));
+}
+
+uint ShadowInterfacePrivate::hashTile(BufferInterface *buffer, bool *comparable)
+{
+    *comparable = true;
+    if (!buffer) {
+        return 0;
+    }
+    const QImage image = buffer->data();
+    if (image.isNull()) {
+        // not a shared memory buffer, its content can't be compared
+        *comparable = false;
+        return qHash(buffer);
+    }
+    const uint seed = qHash(qMakePair(image.width(), image.height())) ^ uint(image.format());
+    return qHashBits(image.constBits(), image.sizeInBytes(), seed);
+}
+
+void ShadowInterfacePrivate::updateTile(ShadowInterface::Tile tile, BufferInterface *buffer)
+{
+    bool comparable;
+    const uint hash = hashTile(buffer, &comparable);
+    uint &currentHash = tileHashes[tileIndex(tile)];
+    if (!comparable || currentHash != hash) {
+        currentHash = hash;
+        changedTiles |= tile;
+    }
+}
+
+BufferInterface *ShadowInterfacePrivate::tile(ShadowInterface::Tile tile) const
+{
+    switch (tile) {
+    case ShadowInterface::LeftTile:
+        return current.left;
+    case ShadowInterface::TopLeftTile:
+        return current.topLeft;
+    case ShadowInterface::TopTile:
+        return current.top;
+    case ShadowInterface::TopRightTile:
+        return current.topRight;
+    case ShadowInterface::RightTile:
+        return current.right;
+    case ShadowInterface::BottomRightTile:
+        return current.bottomRight;
+    case ShadowInterface::BottomTile:
+        return current.bottom;
+    case ShadowInterface::BottomLeftTile:
+        return current.bottomLeft;
+    }
+    Q_UNREACHABLE();
+    return nullptr;
+}
+
+void ShadowInterfacePrivate::updateAtlasLayout()
+{
+    auto tileSize = [this](ShadowInterface::Tile t) {
+        BufferInterface *buffer = tile(t);
+        return buffer ? buffer->size() : QSize(0, 0);
+    };
+    const QSize topLeft = tileSize(ShadowInterface::TopLeftTile);
+    const QSize top = tileSize(ShadowInterface::TopTile);
+    const QSize topRight = tileSize(ShadowInterface::TopRightTile);
+    const QSize right = tileSize(ShadowInterface::RightTile);
+    const QSize bottomRight = tileSize(ShadowInterface::BottomRightTile);
+    const QSize bottom = tileSize(ShadowInterface::BottomTile);
+    const QSize bottomLeft = tileSize(ShadowInterface::BottomLeftTile);
+    const QSize left = tileSize(ShadowInterface::LeftTile);
+
+    // the tiles are laid out in a three by three grid, the center stays empty
+    const int leftColumn = std::max({topLeft.width(), left.width(), bottomLeft.width()});
+    const int centerColumn = std::max(top.width(), bottom.width());
+    const int topRow = std::max({topLeft.height(), top.height(), topRight.height()});
+    const int centerRow = std::max(left.height(), right.height());
+
+    const int centerX = leftColumn;
+    const int rightX = leftColumn + centerColumn;
+    const int centerY = topRow;
+    const int bottomY = topRow + centerRow;
+
+    atlasRects[tileIndex(ShadowInterface::TopLeftTile)] = QRect(QPoint(0, 0), topLeft);
+    atlasRects[tileIndex(ShadowInterface::TopTile)] = QRect(QPoint(centerX, 0), top);
+    atlasRects[tileIndex(ShadowInterface::TopRightTile)] = QRect(QPoint(rightX, 0), topRight);
+    atlasRects[tileIndex(ShadowInterface::RightTile)] = QRect(QPoint(rightX, centerY), right);
+    atlasRects[tileIndex(ShadowInterface::BottomRightTile)] = QRect(QPoint(rightX, bottomY), bottomRight);
+    atlasRects[tileIndex(ShadowInterface::BottomTile)] = QRect(QPoint(centerX, bottomY), bottom);
+    atlasRects[tileIndex(ShadowInterface::BottomLeftTile)] = QRect(QPoint(0, bottomY), bottomLeft);
+    atlasRects[tileIndex(ShadowInterface::LeftTile)] = QRect(QPoint(0, centerY), left);
+}
+
+void ShadowInterfacePrivate::bufferDestroyed(BufferInterface *buffer)
+{
+#define PENDING( __PART__ ) \
+    if (pending.__PART__ == buffer) { \
+        pending.__PART__ = nullptr; \
+    }
+    PENDING(left)
+    PENDING(topLeft)
+    PENDING(top)
+    PENDING(topRight)
+    PENDING(right)
+    PENDING(bottomRight)
+    PENDING(bottom)
+    PENDING(bottomLeft)
+#undef PENDING
+
+#define CURRENT( __PART__ ) \
+    if (current.__PART__ == buffer) { \
+        current.__PART__->unref(); \
+        current.__PART__ = nullptr; \
+    }
+    CURRENT(left)
+    CURRENT(topLeft)
+    CURRENT(top)
+    CURRENT(topRight)
+    CURRENT(right)
+    CURRENT(bottomRight)
+    CURRENT(bottom)
+    CURRENT(bottomLeft)
+#undef CURRENT
+}
+
 void ShadowInterfacePrivate::attach(ShadowInterfacePrivate::State::Flags flag, wl_resource *buffer)
 {
     BufferInterface *b = BufferInterface::get(manager->display(), buffer);
     if (b) {
-        QObject::connect(b, &BufferInterface::aboutToBeDestroyed, q,
-            [this](BufferInterface *buffer) {
-    #define PENDING( __PART__ ) \
-                if (pending.__PART__ == buffer) { \
-                    pending.__PART__ = nullptr; \
-                }
-                PENDING(left)
-                PENDING(topLeft)
-                PENDING(top)
-                PENDING(topRight)
-                PENDING(right)
-                PENDING(bottomRight)
-                PENDING(bottom)
-                PENDING(bottomLeft)
-    #undef PENDING
-
-    #define CURRENT( __PART__ ) \
-                if (current.__PART__ == buffer) { \
-                    current.__PART__->unref(); \
-                    current.__PART__ = nullptr; \
-                }
-                CURRENT(left)
-                CURRENT(topLeft)
-                CURRENT(top)
-                CURRENT(topRight)
-                CURRENT(right)
-                CURRENT(bottomRight)
-                CURRENT(bottom)
-                CURRENT(bottomLeft)
-    #undef CURRENT
-            }
-        );
+        observe(b);
     }
     switch (flag) {
     case State::LeftBuffer:
@@ -366,6 +491,58 @@ QMarginsF ShadowInterface::offset() const
     return d->current.offset;
 }
 
+ShadowInterface::Tiles ShadowInterface::changedTiles() const
+{
+    return d->changedTiles;
+}
+
+uint ShadowInterface::contentHash() const
+{
+    return d->contentHash;
+}
+
+QImage ShadowInterface::atlas() const
+{
+    if (!d->atlasDirty) {
+        return d->atlas;
+    }
+    d->atlasDirty = false;
+
+    QRect bounds;
+    for (const QRect &rect : d->atlasRects) {
+        bounds |= rect;
+    }
+    if (bounds.isEmpty()) {
+        d->atlas = QImage();
+        return d->atlas;
+    }
+
+    d->atlas = QImage(bounds.size(), QImage::Format_ARGB32_Premultiplied);
+    d->atlas.fill(Qt::transparent);
+
+    QPainter painter(&d->atlas);
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
+    for (int i = 0; i < ShadowInterfacePrivate::s_tileCount; ++i) {
+        BufferInterface *buffer = d->tile(Tile(1 << i));
+        if (!buffer) {
+            continue;
+        }
+        // only one shared memory buffer can be accessed at a time, the image has to go
+        // out of scope before the next tile is read
+        const QImage image = buffer->data();
+        if (!image.isNull()) {
+            painter.drawImage(d->atlasRects[i].topLeft(), image);
+        }
+    }
+
+    return d->atlas;
+}
+
+QRect ShadowInterface::atlasRect(Tile tile) const
+{
+    return d->atlasRects[ShadowInterfacePrivate::tileIndex(tile)];
+}
+
 #define BUFFER( __PART__ ) \
 BufferInterface *ShadowInterface::__PART__() const \
 { \
@@ -6,8 +6,10 @@
 #ifndef KWAYLAND_SERVER_SHADOW_INTERFACE_H
 #define KWAYLAND_SERVER_SHADOW_INTERFACE_H
 
-#include <QObject>
+#include <QImage>
 #include <QMarginsF>
+#include <QObject>
+#include <QRect>
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
@@ -39,6 +41,22 @@ class KWAYLANDSERVER_EXPORT ShadowInterface : public QObject
 {
     Q_OBJECT
 public:
+    /**
+     * The tiles a shadow is made of.
+     * @since 5.22
+     **/
+    enum Tile {
+        LeftTile = 1 << 0,
+        TopLeftTile = 1 << 1,
+        TopTile = 1 << 2,
+        TopRightTile = 1 << 3,
+        RightTile = 1 << 4,
+        BottomRightTile = 1 << 5,
+        BottomTile = 1 << 6,
+        BottomLeftTile = 1 << 7,
+    };
+    Q_DECLARE_FLAGS(Tiles, Tile)
+
     ~ShadowInterface() override;
 
     BufferInterface *left() const;
@@ -52,6 +70,43 @@ public:
 
     QMarginsF offset() const;
 
+    /**
+     * The tiles whose content changed with the last commit of the shadow. A tile that got a
+     * new buffer with the same content as the old one is not included, so the compositor
+     * only needs to upload the tiles returned here when it reacts to SurfaceInterface::shadowChanged.
+     *
+     * The content of shared memory buffers is compared, any other buffer counts as changed
+     * whenever it is replaced.
+     * @since 5.22
+     **/
+    Tiles changedTiles() const;
+
+    /**
+     * A hash of the content of all tiles. Shadows with the same hash have the same atlas(),
+     * a compositor can use it to share one texture for all windows with the same shadow style.
+     * Tiles which are not in shared memory buffers are hashed by their buffer, not by content.
+     * @see changedTiles
+     * @since 5.22
+     **/
+    uint contentHash() const;
+
+    /**
+     * All tiles packed into one image, in a three by three grid with the corner tiles in the
+     * corners and the center left empty. The position of every tile is provided by atlasRect().
+     *
+     * The atlas is built the first time it is needed after the tiles changed, only shared
+     * memory buffers can be packed, the area of any other tile is left transparent.
+     * @since 5.22
+     **/
+    QImage atlas() const;
+
+    /**
+     * @returns The source rectangle of @p tile in the atlas(), an empty rectangle if the shadow
+     * has no such tile.
+     * @since 5.22
+     **/
+    QRect atlasRect(Tile tile) const;
+
 private:
     explicit ShadowInterface(ShadowManagerInterface *manager, wl_resource *resource);
     friend class ShadowManagerInterfacePrivate;
@@ -61,4 +116,6 @@ private:
 
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::ShadowInterface::Tiles)
+
 #endif
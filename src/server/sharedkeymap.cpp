@@ -0,0 +1,92 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "sharedkeymap_p.h"
+#include "anonymousfile_p.h"
+#include "logging.h"
+// Qt
+#include <QCryptographicHash>
+#include <QHash>
+#include <QWeakPointer>
+
+#include <xkbcommon/xkbcommon.h>
+
+#include <unistd.h>
+
+namespace KWaylandServer
+{
+
+typedef QHash<QByteArray, QWeakPointer<SharedKeymap>> SharedKeymapHash;
+Q_GLOBAL_STATIC(SharedKeymapHash, s_keymaps)
+
+static xkb_keymap *compileKeymap(const QByteArray &content)
+{
+    // the keymap is complete, it doesn't need the system's rules or the environment
+    xkb_context *context = xkb_context_new(XKB_CONTEXT_NO_DEFAULT_INCLUDES | XKB_CONTEXT_NO_ENVIRONMENT_NAMES);
+    if (!context) {
+        return nullptr;
+    }
+    // the content may or may not end with the terminating null of the wire format
+    xkb_keymap *keymap = xkb_keymap_new_from_buffer(context, content.constData(), qstrnlen(content.constData(), content.size()),
+                                                    XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    // the keymap holds its own reference
+    xkb_context_unref(context);
+    return keymap;
+}
+
+SharedKeymap::SharedKeymap(const QByteArray &hash, int fd, quint32 size, xkb_keymap *xkbKeymap)
+    : m_hash(hash)
+    , m_fd(fd)
+    , m_size(size)
+    , m_xkbKeymap(xkbKeymap)
+{
+}
+
+SharedKeymap::~SharedKeymap()
+{
+    s_keymaps->remove(m_hash);
+    close(m_fd);
+    xkb_keymap_unref(m_xkbKeymap);
+}
+
+QSharedPointer<SharedKeymap> SharedKeymap::get(const QByteArray &content)
+{
+    const QByteArray hash = QCryptographicHash::hash(content, QCryptographicHash::Sha256);
+    if (QSharedPointer<SharedKeymap> keymap = s_keymaps->value(hash).toStrongRef()) {
+        return keymap;
+    }
+
+    const int fd = AnonymousFile::createReadOnly("kwaylandserver-keymap", content);
+    if (fd < 0) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to create a file for the keymap";
+        return QSharedPointer<SharedKeymap>();
+    }
+
+    xkb_keymap *xkbKeymap = compileKeymap(content);
+    if (!xkbKeymap) {
+        qCWarning(KWAYLAND_SERVER) << "Failed to compile the keymap, all keys are repeated";
+    }
+    QSharedPointer<SharedKeymap> keymap(new SharedKeymap(hash, fd, content.size(), xkbKeymap));
+    s_keymaps->insert(hash, keymap);
+    return keymap;
+}
+
+int SharedKeymap::fd() const
+{
+    return m_fd;
+}
+
+quint32 SharedKeymap::size() const
+{
+    return m_size;
+}
+
+bool SharedKeymap::keyRepeats(quint32 key) const
+{
+    // xkb keycodes are the evdev codes offset by 8
+    return !m_xkbKeymap || xkb_keymap_key_repeats(m_xkbKeymap, key + 8);
+}
+
+}
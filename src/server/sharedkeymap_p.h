@@ -0,0 +1,58 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef KWAYLAND_SERVER_SHAREDKEYMAP_P_H
+#define KWAYLAND_SERVER_SHAREDKEYMAP_P_H
+
+#include <QByteArray>
+#include <QSharedPointer>
+
+struct xkb_keymap;
+
+namespace KWaylandServer
+{
+
+/**
+ * A keymap in a file descriptor which can be passed to clients with wl_keyboard.keymap.
+ *
+ * Keymaps are shared by content: all keyboards of all seats which use the same keymap
+ * reference one SharedKeymap, which is freed as soon as the last keyboard drops it.
+ *
+ * If memfd_create() is available, the keymap lives in a sealed memfd which neither the
+ * compositor nor any client can modify, otherwise it falls back to an unlinked temporary
+ * file.
+ */
+class SharedKeymap
+{
+public:
+    ~SharedKeymap();
+
+    /**
+     * Returns the keymap with the given @p content, it is only created if no keyboard uses
+     * a keymap with the same content yet. Returns a null pointer if creating the keymap failed.
+     */
+    static QSharedPointer<SharedKeymap> get(const QByteArray &content);
+
+    int fd() const;
+    quint32 size() const;
+    /**
+     * Returns whether the keymap marks the Linux input event code @p key as repeating, which
+     * modifiers are not. Keys are considered repeating if the keymap could not be compiled.
+     */
+    bool keyRepeats(quint32 key) const;
+
+private:
+    SharedKeymap(const QByteArray &hash, int fd, quint32 size, xkb_keymap *xkbKeymap);
+
+    QByteArray m_hash;
+    int m_fd;
+    quint32 m_size;
+    xkb_keymap *m_xkbKeymap;
+};
+
+}
+
+#endif // KWAYLAND_SERVER_SHAREDKEYMAP_P_H
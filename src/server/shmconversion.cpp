@@ -0,0 +1,443 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "shmconversion_p.h"
+// Wayland
+#include <wayland-server-protocol.h>
+// std
+#include <cstring>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#include <immintrin.h>
+#define KWAYLANDSERVER_HAVE_AVX2_KERNELS 1
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
+
+namespace KWaylandServer
+{
+namespace ShmConversion
+{
+
+/*
+ * All kernels convert @p count pixels of a single row into 0xAARRGGBB words.
+ *
+ * Pixels in wl_shm buffers are premultiplied, so the kernels only reorder and widen or
+ * narrow the channels, alpha is passed through as is. Formats without an alpha channel
+ * get an opaque alpha, as required by QImage::Format_RGB32.
+ */
+using RowKernel = void (*)(const uchar *source, quint32 *target, int count);
+
+static inline quint32 loadPixel(const uchar *source)
+{
+    quint32 pixel;
+    std::memcpy(&pixel, source, sizeof(pixel));
+    return pixel;
+}
+
+static inline quint16 loadPixel16(const uchar *source)
+{
+    quint16 pixel;
+    std::memcpy(&pixel, source, sizeof(pixel));
+    return pixel;
+}
+
+static inline quint32 swapRedBlue(quint32 pixel)
+{
+    return (pixel & 0xff00ff00) | ((pixel >> 16) & 0xff) | ((pixel & 0xff) << 16);
+}
+
+static inline quint32 convertRgb565(quint16 pixel)
+{
+    const quint32 r = (pixel >> 11) & 0x1f;
+    const quint32 g = (pixel >> 5) & 0x3f;
+    const quint32 b = pixel & 0x1f;
+    return 0xff000000 | (((r << 3) | (r >> 2)) << 16) | (((g << 2) | (g >> 4)) << 8) | ((b << 3) | (b >> 2));
+}
+
+static inline quint32 convert2101010(quint32 pixel, quint32 alphaMask)
+{
+    const quint32 a = (pixel >> 30) * 0x55;
+    const quint32 r = (pixel >> 22) & 0xff;
+    const quint32 g = (pixel >> 12) & 0xff;
+    const quint32 b = (pixel >> 2) & 0xff;
+    return (a << 24) | (r << 16) | (g << 8) | b | alphaMask;
+}
+
+// Scalar tails, also used as the complete kernels on platforms without SIMD support
+
+static void copyRow(const uchar *source, quint32 *target, int count)
+{
+    std::memcpy(target, source, count * sizeof(quint32));
+}
+
+static void fillAlphaRowTail(const uchar *source, quint32 *target, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        target[i] = loadPixel(source + i * 4) | 0xff000000;
+    }
+}
+
+static void swapRedBlueRowTail(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    for (int i = 0; i < count; ++i) {
+        target[i] = swapRedBlue(loadPixel(source + i * 4)) | alphaMask;
+    }
+}
+
+static void rgb565RowTail(const uchar *source, quint32 *target, int count)
+{
+    for (int i = 0; i < count; ++i) {
+        target[i] = convertRgb565(loadPixel16(source + i * 2));
+    }
+}
+
+static void rgb2101010RowTail(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    for (int i = 0; i < count; ++i) {
+        target[i] = convert2101010(loadPixel(source + i * 4), alphaMask);
+    }
+}
+
+#if defined(__SSE2__)
+static void fillAlphaRowSse2(const uchar *source, quint32 *target, int count)
+{
+    const __m128i alpha = _mm_set1_epi32(int(0xff000000));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_or_si128(pixels, alpha));
+    }
+    fillAlphaRowTail(source + i * 4, target + i, count - i);
+}
+
+static void swapRedBlueRowSse2(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    const __m128i greenAlpha = _mm_set1_epi32(int(0xff00ff00));
+    const __m128i blue = _mm_set1_epi32(0xff);
+    const __m128i alpha = _mm_set1_epi32(int(alphaMask));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+        __m128i result = _mm_and_si128(pixels, greenAlpha);
+        result = _mm_or_si128(result, _mm_and_si128(_mm_srli_epi32(pixels, 16), blue));
+        result = _mm_or_si128(result, _mm_slli_epi32(_mm_and_si128(pixels, blue), 16));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_or_si128(result, alpha));
+    }
+    swapRedBlueRowTail(source + i * 4, target + i, count - i, alphaMask);
+}
+
+static void rgb565RowSse2(const uchar *source, quint32 *target, int count)
+{
+    const __m128i mask5 = _mm_set1_epi16(0x1f);
+    const __m128i mask6 = _mm_set1_epi16(0x3f);
+    const __m128i alpha = _mm_set1_epi16(short(0xff00));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 2));
+        const __m128i r = _mm_and_si128(_mm_srli_epi16(pixels, 11), mask5);
+        const __m128i g = _mm_and_si128(_mm_srli_epi16(pixels, 5), mask6);
+        const __m128i b = _mm_and_si128(pixels, mask5);
+        const __m128i r8 = _mm_or_si128(_mm_slli_epi16(r, 3), _mm_srli_epi16(r, 2));
+        const __m128i g8 = _mm_or_si128(_mm_slli_epi16(g, 2), _mm_srli_epi16(g, 4));
+        const __m128i b8 = _mm_or_si128(_mm_slli_epi16(b, 3), _mm_srli_epi16(b, 2));
+        // 16 bit lanes holding (blue | green << 8) and (red | alpha << 8), interleaved into BGRA
+        const __m128i blueGreen = _mm_or_si128(b8, _mm_slli_epi16(g8, 8));
+        const __m128i redAlpha = _mm_or_si128(r8, alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_unpacklo_epi16(blueGreen, redAlpha));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i + 4), _mm_unpackhi_epi16(blueGreen, redAlpha));
+    }
+    rgb565RowTail(source + i * 2, target + i, count - i);
+}
+
+static void rgb2101010RowSse2(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    const __m128i mask8 = _mm_set1_epi32(0xff);
+    const __m128i forcedAlpha = _mm_set1_epi32(int(alphaMask));
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 4));
+        // expand the two alpha bits to eight by replicating them
+        __m128i a = _mm_srli_epi32(pixels, 30);
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 2));
+        a = _mm_or_si128(a, _mm_slli_epi32(a, 4));
+        const __m128i r = _mm_and_si128(_mm_srli_epi32(pixels, 22), mask8);
+        const __m128i g = _mm_and_si128(_mm_srli_epi32(pixels, 12), mask8);
+        const __m128i b = _mm_and_si128(_mm_srli_epi32(pixels, 2), mask8);
+        __m128i result = _mm_or_si128(_mm_slli_epi32(a, 24), _mm_slli_epi32(r, 16));
+        result = _mm_or_si128(result, _mm_or_si128(_mm_slli_epi32(g, 8), b));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(target + i), _mm_or_si128(result, forcedAlpha));
+    }
+    rgb2101010RowTail(source + i * 4, target + i, count - i, alphaMask);
+}
+#endif
+
+#if defined(KWAYLANDSERVER_HAVE_AVX2_KERNELS)
+__attribute__((target("avx2")))
+static void fillAlphaRowAvx2(const uchar *source, quint32 *target, int count)
+{
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + i), _mm256_or_si256(pixels, alpha));
+    }
+    fillAlphaRowTail(source + i * 4, target + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void swapRedBlueRowAvx2(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                             2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    const __m256i alpha = _mm256_set1_epi32(int(alphaMask));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 4));
+        const __m256i result = _mm256_shuffle_epi8(pixels, shuffle);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + i), _mm256_or_si256(result, alpha));
+    }
+    swapRedBlueRowTail(source + i * 4, target + i, count - i, alphaMask);
+}
+
+__attribute__((target("avx2")))
+static void rgb565RowAvx2(const uchar *source, quint32 *target, int count)
+{
+    const __m256i mask5 = _mm256_set1_epi32(0x1f);
+    const __m256i mask6 = _mm256_set1_epi32(0x3f);
+    const __m256i alpha = _mm256_set1_epi32(int(0xff000000));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i *>(source + i * 2));
+        const __m256i pixels = _mm256_cvtepu16_epi32(packed);
+        const __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixels, 11), mask5);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 5), mask6);
+        const __m256i b = _mm256_and_si256(pixels, mask5);
+        const __m256i r8 = _mm256_or_si256(_mm256_slli_epi32(r, 3), _mm256_srli_epi32(r, 2));
+        const __m256i g8 = _mm256_or_si256(_mm256_slli_epi32(g, 2), _mm256_srli_epi32(g, 4));
+        const __m256i b8 = _mm256_or_si256(_mm256_slli_epi32(b, 3), _mm256_srli_epi32(b, 2));
+        __m256i result = _mm256_or_si256(alpha, _mm256_slli_epi32(r8, 16));
+        result = _mm256_or_si256(result, _mm256_or_si256(_mm256_slli_epi32(g8, 8), b8));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + i), result);
+    }
+    rgb565RowTail(source + i * 2, target + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void rgb2101010RowAvx2(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    const __m256i mask8 = _mm256_set1_epi32(0xff);
+    const __m256i alphaFactor = _mm256_set1_epi32(0x55);
+    const __m256i forcedAlpha = _mm256_set1_epi32(int(alphaMask));
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const __m256i pixels = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i * 4));
+        const __m256i a = _mm256_mullo_epi32(_mm256_srli_epi32(pixels, 30), alphaFactor);
+        const __m256i r = _mm256_and_si256(_mm256_srli_epi32(pixels, 22), mask8);
+        const __m256i g = _mm256_and_si256(_mm256_srli_epi32(pixels, 12), mask8);
+        const __m256i b = _mm256_and_si256(_mm256_srli_epi32(pixels, 2), mask8);
+        __m256i result = _mm256_or_si256(_mm256_slli_epi32(a, 24), _mm256_slli_epi32(r, 16));
+        result = _mm256_or_si256(result, _mm256_or_si256(_mm256_slli_epi32(g, 8), b));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(target + i), _mm256_or_si256(result, forcedAlpha));
+    }
+    rgb2101010RowTail(source + i * 4, target + i, count - i, alphaMask);
+}
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+static void fillAlphaRowNeon(const uchar *source, quint32 *target, int count)
+{
+    const uint32x4_t alpha = vdupq_n_u32(0xff000000);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t pixels = vreinterpretq_u32_u8(vld1q_u8(source + i * 4));
+        vst1q_u32(target + i, vorrq_u32(pixels, alpha));
+    }
+    fillAlphaRowTail(source + i * 4, target + i, count - i);
+}
+
+static void swapRedBlueRowNeon(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8x4_t pixels = vld4_u8(source + i * 4);
+        const uint8x8_t red = pixels.val[0];
+        pixels.val[0] = pixels.val[2];
+        pixels.val[2] = red;
+        if (alphaMask) {
+            pixels.val[3] = vdup_n_u8(0xff);
+        }
+        vst4_u8(reinterpret_cast<uint8_t *>(target + i), pixels);
+    }
+    swapRedBlueRowTail(source + i * 4, target + i, count - i, alphaMask);
+}
+
+static void rgb565RowNeon(const uchar *source, quint32 *target, int count)
+{
+    const uint16x8_t mask5 = vdupq_n_u16(0x1f);
+    const uint16x8_t mask6 = vdupq_n_u16(0x3f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const uint16x8_t pixels = vreinterpretq_u16_u8(vld1q_u8(source + i * 2));
+        const uint16x8_t r = vshrq_n_u16(pixels, 11);
+        const uint16x8_t g = vandq_u16(vshrq_n_u16(pixels, 5), mask6);
+        const uint16x8_t b = vandq_u16(pixels, mask5);
+        uint8x8x4_t result;
+        result.val[0] = vmovn_u16(vorrq_u16(vshlq_n_u16(b, 3), vshrq_n_u16(b, 2)));
+        result.val[1] = vmovn_u16(vorrq_u16(vshlq_n_u16(g, 2), vshrq_n_u16(g, 4)));
+        result.val[2] = vmovn_u16(vorrq_u16(vshlq_n_u16(r, 3), vshrq_n_u16(r, 2)));
+        result.val[3] = vdup_n_u8(0xff);
+        vst4_u8(reinterpret_cast<uint8_t *>(target + i), result);
+    }
+    rgb565RowTail(source + i * 2, target + i, count - i);
+}
+
+static void rgb2101010RowNeon(const uchar *source, quint32 *target, int count, quint32 alphaMask)
+{
+    const uint32x4_t mask8 = vdupq_n_u32(0xff);
+    const uint32x4_t forcedAlpha = vdupq_n_u32(alphaMask);
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        const uint32x4_t pixels = vreinterpretq_u32_u8(vld1q_u8(source + i * 4));
+        const uint32x4_t a = vmulq_n_u32(vshrq_n_u32(pixels, 30), 0x55);
+        const uint32x4_t r = vandq_u32(vshrq_n_u32(pixels, 22), mask8);
+        const uint32x4_t g = vandq_u32(vshrq_n_u32(pixels, 12), mask8);
+        const uint32x4_t b = vandq_u32(vshrq_n_u32(pixels, 2), mask8);
+        uint32x4_t result = vorrq_u32(vshlq_n_u32(a, 24), vshlq_n_u32(r, 16));
+        result = vorrq_u32(result, vorrq_u32(vshlq_n_u32(g, 8), b));
+        vst1q_u32(target + i, vorrq_u32(result, forcedAlpha));
+    }
+    rgb2101010RowTail(source + i * 4, target + i, count - i, alphaMask);
+}
+#endif
+
+struct Kernels
+{
+    RowKernel fillAlpha = fillAlphaRowTail;
+    void (*swapRedBlue)(const uchar *, quint32 *, int, quint32) = swapRedBlueRowTail;
+    RowKernel rgb565 = rgb565RowTail;
+    void (*rgb2101010)(const uchar *, quint32 *, int, quint32) = rgb2101010RowTail;
+};
+
+static Kernels selectKernels()
+{
+    Kernels kernels;
+#if defined(__SSE2__)
+    kernels.fillAlpha = fillAlphaRowSse2;
+    kernels.swapRedBlue = swapRedBlueRowSse2;
+    kernels.rgb565 = rgb565RowSse2;
+    kernels.rgb2101010 = rgb2101010RowSse2;
+#endif
+#if defined(KWAYLANDSERVER_HAVE_AVX2_KERNELS)
+    if (__builtin_cpu_supports("avx2")) {
+        kernels.fillAlpha = fillAlphaRowAvx2;
+        kernels.swapRedBlue = swapRedBlueRowAvx2;
+        kernels.rgb565 = rgb565RowAvx2;
+        kernels.rgb2101010 = rgb2101010RowAvx2;
+    }
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    kernels.fillAlpha = fillAlphaRowNeon;
+    kernels.swapRedBlue = swapRedBlueRowNeon;
+    kernels.rgb565 = rgb565RowNeon;
+    kernels.rgb2101010 = rgb2101010RowNeon;
+#endif
+    return kernels;
+}
+
+static const Kernels &kernels()
+{
+    static const Kernels s_kernels = selectKernels();
+    return s_kernels;
+}
+
+QImage::Format targetFormat(uint32_t shmFormat)
+{
+    switch (shmFormat) {
+    case WL_SHM_FORMAT_ARGB8888:
+    case WL_SHM_FORMAT_ABGR8888:
+    case WL_SHM_FORMAT_ARGB2101010:
+        return QImage::Format_ARGB32_Premultiplied;
+    case WL_SHM_FORMAT_XRGB8888:
+    case WL_SHM_FORMAT_XBGR8888:
+    case WL_SHM_FORMAT_XRGB2101010:
+    case WL_SHM_FORMAT_RGB565:
+        return QImage::Format_RGB32;
+    default:
+        return QImage::Format_Invalid;
+    }
+}
+
+int bytesPerPixel(uint32_t shmFormat)
+{
+    switch (shmFormat) {
+    case WL_SHM_FORMAT_ARGB8888:
+    case WL_SHM_FORMAT_XRGB8888:
+    case WL_SHM_FORMAT_ABGR8888:
+    case WL_SHM_FORMAT_XBGR8888:
+    case WL_SHM_FORMAT_RGBA8888:
+    case WL_SHM_FORMAT_RGBX8888:
+    case WL_SHM_FORMAT_BGRA8888:
+    case WL_SHM_FORMAT_BGRX8888:
+    case WL_SHM_FORMAT_ARGB2101010:
+    case WL_SHM_FORMAT_XRGB2101010:
+    case WL_SHM_FORMAT_ABGR2101010:
+    case WL_SHM_FORMAT_XBGR2101010:
+        return 4;
+    case WL_SHM_FORMAT_RGB888:
+    case WL_SHM_FORMAT_BGR888:
+        return 3;
+    case WL_SHM_FORMAT_RGB565:
+    case WL_SHM_FORMAT_BGR565:
+        return 2;
+    default:
+        return 0;
+    }
+}
+
+void convert(uint32_t shmFormat, const uchar *source, int sourceStride, QImage *target, const QRect &rect)
+{
+    const Kernels &k = kernels();
+    const int sourceBytesPerPixel = bytesPerPixel(shmFormat);
+    const int width = rect.width();
+
+    for (int y = rect.top(); y <= rect.bottom(); ++y) {
+        const uchar *sourceRow = source + y * sourceStride + rect.x() * sourceBytesPerPixel;
+        quint32 *targetRow = reinterpret_cast<quint32 *>(target->scanLine(y)) + rect.x();
+
+        switch (shmFormat) {
+        case WL_SHM_FORMAT_ARGB8888:
+            copyRow(sourceRow, targetRow, width);
+            break;
+        case WL_SHM_FORMAT_XRGB8888:
+            k.fillAlpha(sourceRow, targetRow, width);
+            break;
+        case WL_SHM_FORMAT_ABGR8888:
+            k.swapRedBlue(sourceRow, targetRow, width, 0);
+            break;
+        case WL_SHM_FORMAT_XBGR8888:
+            k.swapRedBlue(sourceRow, targetRow, width, 0xff000000);
+            break;
+        case WL_SHM_FORMAT_ARGB2101010:
+            k.rgb2101010(sourceRow, targetRow, width, 0);
+            break;
+        case WL_SHM_FORMAT_XRGB2101010:
+            k.rgb2101010(sourceRow, targetRow, width, 0xff000000);
+            break;
+        case WL_SHM_FORMAT_RGB565:
+            k.rgb565(sourceRow, targetRow, width);
+            break;
+        default:
+            Q_UNREACHABLE();
+        }
+    }
+}
+
+}
+}
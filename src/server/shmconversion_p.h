@@ -0,0 +1,49 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#ifndef KWAYLAND_SERVER_SHMCONVERSION_P_H
+#define KWAYLAND_SERVER_SHMCONVERSION_P_H
+
+#include <QImage>
+#include <QRect>
+
+namespace KWaylandServer
+{
+
+/**
+ * Helpers converting the pixels of a wl_shm buffer into a QImage compatible format.
+ *
+ * The row kernels are selected once at runtime, AVX2 and SSE2 variants are used on x86,
+ * NEON on ARM, every other platform falls back to portable C++.
+ */
+namespace ShmConversion
+{
+
+/**
+ * Returns the QImage format the given wl_shm @p shmFormat gets converted to, or
+ * QImage::Format_Invalid if the format is not supported.
+ */
+QImage::Format targetFormat(uint32_t shmFormat);
+
+/**
+ * Returns the number of bytes a single pixel of the given wl_shm @p shmFormat occupies,
+ * or @c 0 if the format is not known.
+ */
+int bytesPerPixel(uint32_t shmFormat);
+
+/**
+ * Converts the pixels in @p rect from the wl_shm buffer memory at @p source into @p target.
+ *
+ * The @p target image must have the size of the buffer and the format returned by
+ * targetFormat(). The @p rect must be contained in both the source and the target.
+ */
+void convert(uint32_t shmFormat, const uchar *source, int sourceStride, QImage *target, const QRect &rect);
+
+}
+
+}
+
+#endif // KWAYLAND_SERVER_SHMCONVERSION_P_H
@@ -8,6 +8,7 @@
 #include "display.h"
 #include "subsurface_interface_p.h"
 #include "surface_interface_p.h"
+#include "surfacetransaction_p.h"
 
 namespace KWaylandServer
 {
@@ -46,7 +47,7 @@ void SubCompositorInterfacePrivate::subcompositor_get_subsurface(Resource *resou
     if (surfaceRole) {
         wl_resource_post_error(resource->handle, error_bad_surface,
                                "the surface already has a role assigned %s",
-                               surfaceRole->name().constData());
+                               surfaceRole->name());
         return;
     }
 
@@ -93,7 +94,7 @@ SubSurfaceInterfacePrivate::SubSurfaceInterfacePrivate(SubSurfaceInterface *q,
                                                        SurfaceInterface *surface,
                                                        SurfaceInterface *parent,
                                                        ::wl_resource *resource)
-    : SurfaceRole(surface, QByteArrayLiteral("wl_subsurface"))
+    : SurfaceRole(surface, SurfaceRole::Type::SubSurface)
     , QtWaylandServer::wl_subsurface(resource)
     , q(q)
     , surface(surface)
@@ -183,65 +184,31 @@ void SubSurfaceInterfacePrivate::subsurface_set_desync(Resource *)
 
 void SubSurfaceInterfacePrivate::commit()
 {
-    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
-
-    if (q->isSynchronized()) {
-        commitToCache();
-    } else {
-        if (hasCacheState) {
-            commitToCache();
-            commitFromCache();
-        } else {
-            surfacePrivate->swapStates(&surfacePrivate->pending, &surfacePrivate->current, true);
-        }
-
-        const QList<SubSurfaceInterface *> children = surfacePrivate->current.children;
-        for (SubSurfaceInterface *subsurface : children) {
-            SubSurfaceInterfacePrivate *subsurfacePrivate = SubSurfaceInterfacePrivate::get(subsurface);
-            subsurfacePrivate->parentCommit();
-        }
-    }
-}
-
-void SubSurfaceInterfacePrivate::parentCommit(bool synchronized)
-{
-    if (hasPendingPosition) {
-        hasPendingPosition = false;
-        position = pendingPosition;
-        emit q->positionChanged(position);
-    }
-
-    if (synchronized || mode == SubSurfaceInterface::Mode::Synchronized) {
-        synchronizedCommit();
-    }
+    // The state of the sub-surface is applied by SurfaceInterfacePrivate::commit(), or along
+    // with its parent if it is synchronized. SurfaceTransaction doesn't call this.
 }
 
 void SubSurfaceInterfacePrivate::synchronizedCommit()
 {
-    const SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
-    commitFromCache();
-
-    const QList<SubSurfaceInterface *> children = surfacePrivate->current.children;
-    for (SubSurfaceInterface *subsurface : children) {
-        SubSurfaceInterfacePrivate *subsurfacePrivate = SubSurfaceInterfacePrivate::get(subsurface);
-        subsurfacePrivate->parentCommit(true);
-    }
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    SurfaceTransaction transaction;
+    transaction.add(surface, &surfacePrivate->cached, true);
+    transaction.apply();
+    transaction.emitTreeCommitted();
 }
 
 void SubSurfaceInterfacePrivate::commitToCache()
 {
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
-    surfacePrivate->swapStates(&surfacePrivate->pending, &surfacePrivate->cached, false);
+    if (hasCacheState) {
+        // the parent hasn't been committed since the last commit, merge with the cached state
+        surfacePrivate->swapStates(&surfacePrivate->pending, &surfacePrivate->cached, false);
+    } else {
+        surfacePrivate->moveState(&surfacePrivate->pending, &surfacePrivate->cached);
+    }
     hasCacheState = true;
 }
 
-void SubSurfaceInterfacePrivate::commitFromCache()
-{
-    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
-    surfacePrivate->swapStates(&surfacePrivate->cached, &surfacePrivate->current, true);
-    hasCacheState = false;
-}
-
 SubSurfaceInterface::SubSurfaceInterface(SurfaceInterface *surface, SurfaceInterface *parent,
                                          wl_resource *resource)
     : d(new SubSurfaceInterfacePrivate(this, surface, parent, resource))
@@ -251,18 +218,10 @@ SubSurfaceInterface::SubSurfaceInterface(SurfaceInterface *surface, SurfaceInter
     surfacePrivate->subSurface = this;
     parentPrivate->addChild(this);
 
-    // copy current state to subSurfacePending state
-    // it's the reference for all new pending state which needs to be committed
-    surfacePrivate->cached = surfacePrivate->current;
-    surfacePrivate->cached.blurIsSet = false;
-    surfacePrivate->cached.bufferIsSet = false;
-    surfacePrivate->cached.childrenChanged = false;
-    surfacePrivate->cached.contrastIsSet = false;
-    surfacePrivate->cached.frameCallbacks.clear();
-    surfacePrivate->cached.inputIsSet = false;
-    surfacePrivate->cached.opaqueIsSet = false;
-    surfacePrivate->cached.shadowIsSet = false;
-    surfacePrivate->cached.slideIsSet = false;
+    // the cached state starts out as the current one, only the fields flagged as changed are
+    // ever read and the frame callbacks can't be copied, so just the children are taken over
+    surfacePrivate->cached.children = surfacePrivate->current.children;
+    surfacePrivate->cached.changes = {};
 
     connect(surface, &SurfaceInterface::destroyed, this, [this]() { delete this; });
 }
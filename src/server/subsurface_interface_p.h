@@ -42,11 +42,12 @@ public:
 
     void commit() override;
 
-    void parentCommit(bool synchronized = false);
+    /**
+     * Applies the cached state once the sub-surface is no longer synchronized.
+     */
     void synchronizedCommit();
 
     void commitToCache();
-    void commitFromCache();
 
     SubSurfaceInterface *q;
     QPoint position = QPoint(0, 0);
@@ -6,19 +6,30 @@
 */
 #include "surface_interface.h"
 #include "surface_interface_p.h"
+#include "blur_interface.h"
 #include "buffer_interface.h"
 #include "clientconnection.h"
+#include "clientconnection_p.h"
 #include "compositor_interface.h"
+#include "contrast_interface.h"
 #include "display.h"
+#include "display_p.h"
+#include "fractionalscale_v1_interface_p.h"
 #include "idleinhibit_v1_interface_p.h"
+#include "linuxdrmsyncobj_v1_interface_p.h"
 #include "pointerconstraints_v1_interface_p.h"
 #include "region_interface.h"
 #include "subcompositor_interface.h"
 #include "subsurface_interface_p.h"
+#include "surfacetransaction_p.h"
 #include "surfacerole_p.h"
+#include "trace_p.h"
 #include "utils.h"
+#include "viewporter_interface_p.h"
 // std
 #include <algorithm>
+#include <chrono>
+#include <utility>
 
 // QT
 #include <QDebug>
@@ -27,58 +38,101 @@
 namespace KWaylandServer
 {
 
-QList<SurfaceInterface *> SurfaceInterfacePrivate::surfaces;
+wl_list SurfaceInterfacePrivate::surfaces = {&SurfaceInterfacePrivate::surfaces, &SurfaceInterfacePrivate::surfaces};
 
-KWaylandFrameCallback::KWaylandFrameCallback(wl_resource *resource, SurfaceInterface *surface)
-    : QtWaylandServer::wl_callback(resource)
-    , surface(surface)
+FrameCallbackList::FrameCallbackList()
 {
+    wl_list_init(&m_list);
 }
 
-void KWaylandFrameCallback::destroy()
+FrameCallbackList::~FrameCallbackList()
 {
-    wl_resource_destroy(resource()->handle);
+    destroyAll();
 }
 
-void KWaylandFrameCallback::callback_destroy_resource(Resource *)
+bool FrameCallbackList::isEmpty() const
 {
-    if (surface) {
-        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
-        surfacePrivate->current.frameCallbacks.removeOne(this);
-        surfacePrivate->pending.frameCallbacks.removeOne(this);
-        surfacePrivate->cached.frameCallbacks.removeOne(this);
+    return wl_list_empty(&m_list);
+}
+
+int FrameCallbackList::count() const
+{
+    return wl_list_length(&m_list);
+}
+
+void FrameCallbackList::destroyCallback(wl_resource *callback)
+{
+    auto surfacePrivate = static_cast<SurfaceInterfacePrivate *>(wl_resource_get_user_data(callback));
+    surfacePrivate->pendingFrameCallbacks--;
+    ClientConnectionPrivate::get(surfacePrivate->client)->pendingFrameCallbacks--;
+    wl_list *link = wl_resource_get_link(callback);
+    wl_list_remove(link);
+    wl_list_init(link);
+}
+
+void FrameCallbackList::append(wl_resource *callback, SurfaceInterfacePrivate *surface)
+{
+    surface->pendingFrameCallbacks++;
+    ClientConnectionPrivate::get(surface->client)->pendingFrameCallbacks++;
+    wl_resource_set_implementation(callback, nullptr, surface, destroyCallback);
+    wl_list_insert(m_list.prev, wl_resource_get_link(callback));
+}
+
+void FrameCallbackList::takeFrom(FrameCallbackList *other)
+{
+    wl_list_insert_list(m_list.prev, &other->m_list);
+    wl_list_init(&other->m_list);
+}
+
+void FrameCallbackList::sendDone(quint32 msec)
+{
+    wl_resource *callback;
+    wl_resource *next;
+    wl_resource_for_each_safe(callback, next, &m_list) {
+        wl_callback_send_done(callback, msec);
+        wl_resource_destroy(callback);
+    }
+}
+
+void FrameCallbackList::destroyAll()
+{
+    wl_resource *callback;
+    wl_resource *next;
+    wl_resource_for_each_safe(callback, next, &m_list) {
+        wl_resource_destroy(callback);
     }
-    delete this;
 }
 
 SurfaceInterfacePrivate::SurfaceInterfacePrivate(SurfaceInterface *q)
     : q(q)
 {
-    surfaces.append(q);
+    wl_list_insert(surfaces.prev, &surfaceLink);
+    pendingDamage.setMaximumCount(1024);
+    pendingBufferDamage.setMaximumCount(1024);
 }
 
 SurfaceInterfacePrivate::~SurfaceInterfacePrivate()
 {
-    // Need a copy to avoid hitting invalidated iterators in the for loop.
-    const QList<KWaylandFrameCallback *> currentFrameCallbacks = current.frameCallbacks;
-    for (KWaylandFrameCallback *frameCallback : currentFrameCallbacks) {
-        frameCallback->destroy();
-    }
-
-    const QList<KWaylandFrameCallback *> pendingFrameCallbacks = pending.frameCallbacks;
-    for (KWaylandFrameCallback *frameCallback : pendingFrameCallbacks) {
-        frameCallback->destroy();
-    }
+    current.frameCallbacks.destroyAll();
+    pending.frameCallbacks.destroyAll();
+    cached.frameCallbacks.destroyAll();
 
-    const QList<KWaylandFrameCallback *> cachedFrameCallbacks = cached.frameCallbacks;
-    for (KWaylandFrameCallback *frameCallback : cachedFrameCallbacks) {
-        frameCallback->destroy();
+    if (cached.changes & State::BufferChanged) {
+        dropReleasePoint(&cached);
     }
-
     if (current.buffer) {
         current.buffer->unref();
     }
-    surfaces.removeOne(q);
+    wl_list_remove(&surfaceLink);
+    if (client) {
+        ClientConnectionPrivate::get(client)->surfaces.remove(clientSurfaceId);
+    }
+    // the sub-surface removes itself from the parent once the surface is gone, too late to
+    // look up what the tree of the surface contributed
+    SurfaceInterface *parent = subSurface ? subSurface->parentSurface() : nullptr;
+    if (parent && treeIdleInhibitors > 0 && !DisplayPrivate::get(compositor->display())->tearingDown) {
+        SurfaceInterfacePrivate::get(parent)->addTreeIdleInhibitors(-treeIdleInhibitors);
+    }
 }
 
 void SurfaceInterfacePrivate::addChild(SubSurfaceInterface *child)
@@ -87,8 +141,11 @@ void SurfaceInterfacePrivate::addChild(SubSurfaceInterface *child)
     pending.children.append(child);
     cached.children.append(child);
     current.children.append(child);
+    invalidatePickingCache();
 
     child->surface()->setOutputs(outputs);
+    child->surface()->setPreferredScale(preferredScale);
+    addTreeIdleInhibitors(SurfaceInterfacePrivate::get(child->surface())->treeIdleInhibitors);
 
     emit q->childSubSurfaceAdded(child);
     emit q->subSurfaceTreeChanged();
@@ -98,14 +155,35 @@ void SurfaceInterfacePrivate::addChild(SubSurfaceInterface *child)
     QObject::connect(child->surface(), &SurfaceInterface::subSurfaceTreeChanged, q, &SurfaceInterface::subSurfaceTreeChanged);
 }
 
+static void removeChildFrom(QList<SubSurfaceInterface *> *children, SubSurfaceInterface *child)
+{
+    // A child is in the list only once. The sub-surfaces of a client going away are destroyed
+    // in the order they were created or the reverse one, so removing at either end is cheap
+    // and tearing down many sub-surfaces stays linear instead of quadratic.
+    if (children->isEmpty()) {
+        return;
+    }
+    if (children->last() == child) {
+        children->removeLast();
+    } else {
+        children->removeOne(child);
+    }
+}
+
 void SurfaceInterfacePrivate::removeChild(SubSurfaceInterface *child)
 {
     // protocol is not precise on how to handle the addition of new sub surfaces
-    pending.children.removeAll(child);
-    cached.children.removeAll(child);
-    current.children.removeAll(child);
-    emit q->childSubSurfaceRemoved(child);
-    emit q->subSurfaceTreeChanged();
+    removeChildFrom(&pending.children, child);
+    removeChildFrom(&cached.children, child);
+    removeChildFrom(&current.children, child);
+    invalidatePickingCache();
+    if (child->surface()) {
+        addTreeIdleInhibitors(-SurfaceInterfacePrivate::get(child->surface())->treeIdleInhibitors);
+    }
+    if (!DisplayPrivate::get(compositor->display())->tearingDown) {
+        emit q->childSubSurfaceRemoved(child);
+        emit q->subSurfaceTreeChanged();
+    }
     QObject::disconnect(child, &SubSurfaceInterface::positionChanged, q, &SurfaceInterface::subSurfaceTreeChanged);
     if (child->surface()) {
         QObject::disconnect(child->surface(), &SurfaceInterface::damaged, q, &SurfaceInterface::subSurfaceTreeChanged);
@@ -128,7 +206,7 @@ bool SurfaceInterfacePrivate::raiseChild(SubSurfaceInterface *subsurface, Surfac
         // it's to the parent, so needs to become last item
         pending.children.append(*it);
         pending.children.erase(it);
-        pending.childrenChanged = true;
+        pending.changes |= State::ChildrenChanged;
         return true;
     }
     if (!sibling->subSurface()) {
@@ -145,7 +223,7 @@ bool SurfaceInterfacePrivate::raiseChild(SubSurfaceInterface *subsurface, Surfac
     // find the iterator again
     siblingIt = std::find(pending.children.begin(), pending.children.end(), sibling->subSurface());
     pending.children.insert(++siblingIt, value);
-    pending.childrenChanged = true;
+    pending.changes |= State::ChildrenChanged;
     return true;
 }
 
@@ -164,7 +242,7 @@ bool SurfaceInterfacePrivate::lowerChild(SubSurfaceInterface *subsurface, Surfac
         auto value = *it;
         pending.children.erase(it);
         pending.children.prepend(value);
-        pending.childrenChanged = true;
+        pending.changes |= State::ChildrenChanged;
         return true;
     }
     if (!sibling->subSurface()) {
@@ -181,32 +259,40 @@ bool SurfaceInterfacePrivate::lowerChild(SubSurfaceInterface *subsurface, Surfac
     // find the iterator again
     siblingIt = std::find(pending.children.begin(), pending.children.end(), sibling->subSurface());
     pending.children.insert(siblingIt, value);
-    pending.childrenChanged = true;
+    pending.changes |= State::ChildrenChanged;
     return true;
 }
 
+static SurfaceInterfacePrivate::EffectState *effectsForWriting(SurfaceInterfacePrivate::State *state)
+{
+    if (!state->effects) {
+        state->effects = new SurfaceInterfacePrivate::EffectState;
+    }
+    return state->effects.data();
+}
+
 void SurfaceInterfacePrivate::setShadow(const QPointer<ShadowInterface> &shadow)
 {
-    pending.shadow = shadow;
-    pending.shadowIsSet = true;
+    effectsForWriting(&pending)->shadow = shadow;
+    pending.changes |= State::ShadowChanged;
 }
 
 void SurfaceInterfacePrivate::setBlur(const QPointer<BlurInterface> &blur)
 {
-    pending.blur = blur;
-    pending.blurIsSet = true;
+    effectsForWriting(&pending)->blur = blur;
+    pending.changes |= State::BlurChanged;
 }
 
 void SurfaceInterfacePrivate::setSlide(const QPointer<SlideInterface> &slide)
 {
-    pending.slide = slide;
-    pending.slideIsSet = true;
+    effectsForWriting(&pending)->slide = slide;
+    pending.changes |= State::SlideChanged;
 }
 
 void SurfaceInterfacePrivate::setContrast(const QPointer<ContrastInterface> &contrast)
 {
-    pending.contrast = contrast;
-    pending.contrastIsSet = true;
+    effectsForWriting(&pending)->contrast = contrast;
+    pending.changes |= State::ContrastChanged;
 }
 
 void SurfaceInterfacePrivate::installPointerConstraint(LockedPointerV1Interface *lock)
@@ -275,13 +361,38 @@ void SurfaceInterfacePrivate::installIdleInhibitor(IdleInhibitorV1Interface *inh
     QObject::connect(inhibitor, &IdleInhibitorV1Interface::destroyed, q,
         [this, inhibitor] {
             idleInhibitors.removeOne(inhibitor);
-            if (idleInhibitors.isEmpty()) {
-                emit q->inhibitsIdleChanged();
-            }
+            updateInhibitsIdle();
         }
     );
-    if (idleInhibitors.count() == 1) {
-        emit q->inhibitsIdleChanged();
+    updateInhibitsIdle();
+}
+
+void SurfaceInterfacePrivate::updateInhibitsIdle()
+{
+    // an inhibitor only counts while the surface can be seen
+    const bool inhibits = !idleInhibitors.isEmpty() && !occluded;
+    if (inhibitsIdle == inhibits) {
+        return;
+    }
+    inhibitsIdle = inhibits;
+    emit q->inhibitsIdleChanged();
+    addTreeIdleInhibitors(inhibits ? 1 : -1);
+}
+
+void SurfaceInterfacePrivate::addTreeIdleInhibitors(int delta)
+{
+    if (delta == 0) {
+        return;
+    }
+    // only the surfaces on the way up to the main surface change
+    for (SurfaceInterfacePrivate *surface = this; surface;) {
+        const bool inhibited = surface->treeIdleInhibitors > 0;
+        surface->treeIdleInhibitors += delta;
+        if (inhibited != (surface->treeIdleInhibitors > 0)) {
+            emit surface->q->treeInhibitsIdleChanged();
+        }
+        SurfaceInterface *parent = surface->subSurface ? surface->subSurface->parentSurface() : nullptr;
+        surface = parent ? SurfaceInterfacePrivate::get(parent) : nullptr;
     }
 }
 
@@ -299,22 +410,26 @@ void SurfaceInterfacePrivate::surface_destroy(Resource *resource)
 void SurfaceInterfacePrivate::surface_attach(Resource *resource, struct ::wl_resource *buffer, int32_t x, int32_t y)
 {
     Q_UNUSED(resource)
-    pending.bufferIsSet = true;
+    pending.changes |= State::BufferChanged;
     pending.offset = QPoint(x, y);
     if (!buffer) {
         // got a null buffer, deletes content in next frame
         pending.buffer = nullptr;
         pending.damage = QRegion();
         pending.bufferDamage = QRegion();
+        pendingDamage.clear();
+        pendingBufferDamage.clear();
         return;
     }
     pending.buffer = BufferInterface::get(compositor->display(), buffer);
-    QObject::connect(pending.buffer, &BufferInterface::aboutToBeDestroyed, q, &SurfaceInterface::handleBufferRemoved,  Qt::UniqueConnection);
+    if (pending.buffer) {
+        observe(pending.buffer);
+    }
 }
 
 void SurfaceInterfacePrivate::surface_damage(Resource *, int32_t x, int32_t y, int32_t width, int32_t height)
 {
-    pending.damage |= QRect(x, y, width, height);
+    pendingDamage.add(QRect(x, y, width, height));
 }
 
 void SurfaceInterfacePrivate::surface_frame(Resource *resource, uint32_t callback)
@@ -325,8 +440,9 @@ void SurfaceInterfacePrivate::surface_frame(Resource *resource, uint32_t callbac
         wl_resource_post_no_memory(resource->handle);
         return;
     }
-    pending.frameCallbacks.append(new KWaylandFrameCallback(callbackResource, q));
-    qDebug()<<"Sleep_noresponse:"<<pending.frameCallbacks.size()<<" "<<q->client()->processId();
+    pending.frameCallbacks.append(callbackResource, this);
+    KWS_TRACE() << "Frame callback requested by" << client->processId()
+                << "pending frame callbacks:" << client->pendingFrameCallbackCount();
 }
 
 void SurfaceInterfacePrivate::surface_set_opaque_region(Resource *resource, struct ::wl_resource *region)
@@ -334,16 +450,18 @@ void SurfaceInterfacePrivate::surface_set_opaque_region(Resource *resource, stru
     Q_UNUSED(resource)
     RegionInterface *r = RegionInterface::get(region);
     pending.opaque = r ? r->region() : QRegion();
-    pending.opaqueIsSet = true;
-
+    pending.changes |= State::OpaqueChanged;
+    updateMemoryUsage();
 }
 
 void SurfaceInterfacePrivate::surface_set_input_region(Resource *resource, struct ::wl_resource *region)
 {
     Q_UNUSED(resource)
     RegionInterface *r = RegionInterface::get(region);
-    pending.input = r ? r->region() : infiniteRegion();
-    pending.inputIsSet = true;
+    pending.input = r ? r->region() : QRegion();
+    pending.inputIsInfinite = !r;
+    pending.changes |= State::InputChanged;
+    updateMemoryUsage();
 }
 
 void SurfaceInterfacePrivate::surface_commit(Resource *resource)
@@ -356,20 +474,20 @@ void SurfaceInterfacePrivate::surface_set_buffer_transform(Resource *resource, i
 {
     Q_UNUSED(resource)
     pending.bufferTransform = OutputInterface::Transform(transform);
-    pending.bufferTransformIsSet = true;
+    pending.changes |= State::BufferTransformChanged;
 }
 
 void SurfaceInterfacePrivate::surface_set_buffer_scale(Resource *resource, int32_t scale)
 {
     Q_UNUSED(resource)
     pending.bufferScale = scale;
-    pending.bufferScaleIsSet = true;
+    pending.changes |= State::BufferScaleChanged;
 }
 
 void SurfaceInterfacePrivate::surface_damage_buffer(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height)
 {
     Q_UNUSED(resource)
-    pending.bufferDamage |= QRect(x, y, width, height);
+    pendingBufferDamage.add(QRect(x, y, width, height));
 }
 
 SurfaceInterface::SurfaceInterface(CompositorInterface *compositor, wl_resource *resource)
@@ -379,6 +497,9 @@ SurfaceInterface::SurfaceInterface(CompositorInterface *compositor, wl_resource
     d->compositor = compositor;
     d->init(resource);
     d->client = compositor->display()->getConnection(d->resource()->client());
+    d->memoryAccount.setClient(d->client);
+    d->clientSurfaceId = wl_resource_get_id(resource);
+    ClientConnectionPrivate::get(d->client)->surfaces.insert(d->clientSurfaceId, this);
 }
 
 SurfaceInterface::~SurfaceInterface()
@@ -407,31 +528,230 @@ CompositorInterface *SurfaceInterface::compositor() const
 
 QList<SurfaceInterface *> SurfaceInterface::surfaces()
 {
-    return SurfaceInterfacePrivate::surfaces;
+    QList<SurfaceInterface *> surfaces;
+    SurfaceInterfacePrivate *surface;
+    wl_list_for_each(surface, &SurfaceInterfacePrivate::surfaces, surfaceLink) {
+        surfaces.append(surface->q);
+    }
+    return surfaces;
+}
+
+bool SurfaceInterfacePrivate::sendFrameCallbacks(quint32 msec)
+{
+    bool sent = !current.frameCallbacks.isEmpty();
+    current.frameCallbacks.sendDone(msec);
+    committedFrameCallbacks = 0;
+    for (SubSurfaceInterface *subsurface : qAsConst(current.children)) {
+        if (SurfaceInterface *surface = subsurface->surface()) {
+            // sub-surfaces always belong to the same client
+            sent |= SurfaceInterfacePrivate::get(surface)->sendFrameCallbacks(msec);
+        }
+    }
+    return sent;
+}
+
+void SurfaceInterfacePrivate::sendPresentationFeedback(OutputInterface *output, const PresentationTime *time)
+{
+    if (time) {
+        current.presentationFeedback.sendPresented(output, *time);
+    } else {
+        current.presentationFeedback.sendDiscarded();
+    }
+    for (SubSurfaceInterface *subsurface : qAsConst(current.children)) {
+        if (SurfaceInterface *surface = subsurface->surface()) {
+            SurfaceInterfacePrivate::get(surface)->sendPresentationFeedback(output, time);
+        }
+    }
+}
+
+static quint32 currentFrameTime()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SurfaceInterfacePrivate::throttleFrameCallbacks()
+{
+    setFrameCallbacksThrottled(true);
+    if (statisticsTimer) {
+        statistics.missedFrameCallbacks += committedFrameCallbacks;
+    }
+    if (sendFrameCallbacks(currentFrameTime())) {
+        client->flush();
+    }
+}
+
+void SurfaceInterfacePrivate::setFrameCallbacksThrottled(bool throttled)
+{
+    if (frameCallbacksThrottled == throttled) {
+        return;
+    }
+    frameCallbacksThrottled = throttled;
+    KWS_TRACE() << "Frame callbacks of surface" << q->id() << "of" << client->processId()
+                << (throttled ? "throttled" : "no longer throttled");
+    emit q->frameCallbacksThrottledChanged();
+}
+
+void SurfaceInterfacePrivate::updateOccludedFrameTimer()
+{
+    if (!occluded || frameCallbackIdleInterval <= 0) {
+        occludedFrameTimer.reset();
+        return;
+    }
+    if (!occludedFrameTimer) {
+        occludedFrameTimer.reset(new EventLoopTimer(compositor->display()));
+        // repeats for as long as the surface stays occluded
+        occludedFrameTimer->setCallback([this]() {
+            occludedFrameTimer->start(frameCallbackIdleInterval);
+            throttleFrameCallbacks();
+        });
+    }
+    occludedFrameTimer->start(frameCallbackIdleInterval);
 }
 
 void SurfaceInterface::frameRendered(quint32 msec)
 {
-    // notify all callbacks
-    const bool needsFlush = !d->current.frameCallbacks.isEmpty();
-    while (!d->current.frameCallbacks.isEmpty()) {
-        KWaylandFrameCallback *frameCallback = d->current.frameCallbacks.takeFirst();
-        frameCallback->send_done(msec);
-        frameCallback->destroy();
+    KWS_TRACE() << "Frame rendered for surface" << id() << "of" << client()->processId();
+    if (d->frameLatencyTimer.isValid()) {
+        const qint64 latency = d->frameLatencyTimer.nsecsElapsed();
+        d->frameLatencyTimer.invalidate();
+        d->statistics.frames++;
+        d->statistics.lastFrameLatency = latency;
+        d->statistics.maximumFrameLatency = qMax(d->statistics.maximumFrameLatency, latency);
+        d->statistics.totalFrameLatency += latency;
     }
-    for (auto it = d->current.children.constBegin(); it != d->current.children.constEnd(); ++it) {
-        (*it)->surface()->frameRendered(msec);
+    if (!d->occluded) {
+        d->setFrameCallbacksThrottled(false);
     }
-    if (needsFlush)  {
+    // notify all callbacks
+    if (d->sendFrameCallbacks(msec)) {
         client()->flush();
     }
 }
 
+void SurfaceInterface::presented(OutputInterface *output, const PresentationTime &time)
+{
+    d->sendPresentationFeedback(output, &time);
+    client()->flush();
+}
+
+void SurfaceInterface::discardPresentationFeedback()
+{
+    d->sendPresentationFeedback(nullptr, nullptr);
+    client()->flush();
+}
+
 bool SurfaceInterface::hasFrameCallbacks() const
 {
     return !d->current.frameCallbacks.isEmpty();
 }
 
+void SurfaceInterface::setMaximumPendingFrameCallbacks(int count)
+{
+    d->maximumPendingFrameCallbacks = count;
+}
+
+int SurfaceInterface::maximumPendingFrameCallbacks() const
+{
+    return d->maximumPendingFrameCallbacks;
+}
+
+void SurfaceInterface::setMaximumDamageRects(int count)
+{
+    d->pendingDamage.setMaximumCount(count);
+    d->pendingBufferDamage.setMaximumCount(count);
+}
+
+int SurfaceInterface::maximumDamageRects() const
+{
+    return d->pendingDamage.maximumCount();
+}
+
+void SurfaceInterface::setFrameCallbackIdleInterval(int msec)
+{
+    if (d->frameCallbackIdleInterval == msec) {
+        return;
+    }
+    d->frameCallbackIdleInterval = msec;
+    d->updateOccludedFrameTimer();
+}
+
+int SurfaceInterface::frameCallbackIdleInterval() const
+{
+    return d->frameCallbackIdleInterval;
+}
+
+void SurfaceInterface::setOccluded(bool occluded)
+{
+    if (d->occluded == occluded) {
+        return;
+    }
+    d->occluded = occluded;
+    if (occluded) {
+        d->setFrameCallbacksThrottled(true);
+    }
+    d->updateOccludedFrameTimer();
+    d->updateInhibitsIdle();
+}
+
+bool SurfaceInterface::isOccluded() const
+{
+    return d->occluded;
+}
+
+bool SurfaceInterface::areFrameCallbacksThrottled() const
+{
+    return d->frameCallbacksThrottled;
+}
+
+void SurfaceInterface::setStatisticsInterval(int msec)
+{
+    if (msec <= 0) {
+        delete d->statisticsTimer;
+        d->statisticsTimer = nullptr;
+        d->frameLatencyTimer.invalidate();
+        return;
+    }
+    if (!d->statisticsTimer) {
+        d->statisticsTimer = new QTimer(this);
+        connect(d->statisticsTimer, &QTimer::timeout, this, [this] {
+            d->updateStatistics();
+            emit statisticsUpdated(statistics());
+        });
+        d->commitsAtStatisticsInterval = d->statistics.commits;
+        d->statisticsIntervalTimer.start();
+    }
+    d->statisticsTimer->start(msec);
+}
+
+int SurfaceInterface::statisticsInterval() const
+{
+    return d->statisticsTimer ? d->statisticsTimer->interval() : 0;
+}
+
+SurfaceStatistics SurfaceInterface::statistics() const
+{
+    SurfaceStatistics statistics = d->statistics;
+    statistics.bufferSize = d->bufferSize;
+    return statistics;
+}
+
+void SurfaceInterface::resetStatistics()
+{
+    d->statistics = SurfaceStatistics();
+    d->commitsAtStatisticsInterval = 0;
+    d->statisticsIntervalTimer.restart();
+    d->frameLatencyTimer.invalidate();
+}
+
+void SurfaceInterfacePrivate::updateStatistics()
+{
+    const qint64 elapsed = statisticsIntervalTimer.restart();
+    if (elapsed > 0) {
+        statistics.commitsPerSecond = (statistics.commits - commitsAtStatisticsInterval) * 1000.0 / elapsed;
+    }
+    commitsAtStatisticsInterval = statistics.commits;
+}
+
 QMatrix4x4 SurfaceInterfacePrivate::buildSurfaceToBufferMatrix(const State *state)
 {
     // The order of transforms is reversed, i.e. the viewport transform is the first one.
@@ -490,24 +810,201 @@ QMatrix4x4 SurfaceInterfacePrivate::buildSurfaceToBufferMatrix(const State *stat
     return surfaceToBufferMatrix;
 }
 
+bool SurfaceInterfacePrivate::SurfaceToBufferMatrixKey::operator==(const SurfaceToBufferMatrixKey &other) const
+{
+    return hasBuffer == other.hasBuffer
+        && bufferSize == other.bufferSize
+        && bufferScale == other.bufferScale
+        && bufferTransform == other.bufferTransform
+        && sourceGeometry == other.sourceGeometry
+        && size == other.size;
+}
+
+void SurfaceInterfacePrivate::updateSurfaceToBufferMatrix(const State *state)
+{
+    // Without a buffer the matrix is the identity, whatever the other properties are.
+    SurfaceToBufferMatrixKey key;
+    if (state->buffer) {
+        key.hasBuffer = true;
+        key.bufferSize = state->buffer->size();
+        key.bufferScale = state->bufferScale;
+        key.bufferTransform = state->bufferTransform;
+        key.sourceGeometry = state->sourceGeometry;
+        key.size = state->size;
+    }
+    if (key == surfaceToBufferMatrixKey) {
+        // the viewport was validated against the same buffer size already
+        return;
+    }
+    surfaceToBufferMatrixKey = key;
+    validateViewport(state);
+    surfaceToBufferMatrix = buildSurfaceToBufferMatrix(state);
+    bufferToSurfaceMatrix = surfaceToBufferMatrix.inverted();
+
+    bufferSourceBox = QRect();
+    if (key.hasBuffer) {
+        const QRectF box = surfaceToBufferMatrix.mapRect(QRectF(QPointF(0, 0), key.size));
+        const QRect integralBox = box.toRect();
+        const auto isIntegral = [](qreal value, int integral) {
+            return qAbs(value - integral) < 0.001;
+        };
+        if (isIntegral(box.x(), integralBox.x()) && isIntegral(box.y(), integralBox.y())
+                && isIntegral(box.width(), integralBox.width()) && isIntegral(box.height(), integralBox.height())) {
+            bufferSourceBox = integralBox;
+        }
+    }
+
+    if (!key.hasBuffer) {
+        surfaceToBufferScale = 1;
+    } else if (key.bufferTransform == OutputInterface::Transform::Normal
+               && !key.sourceGeometry.isValid() && key.bufferScale > 0) {
+        surfaceToBufferScale = key.bufferScale;
+    } else {
+        surfaceToBufferScale = 0;
+    }
+}
+
+void SurfaceInterfacePrivate::validateViewport(const State *state)
+{
+    if (!viewportExtension || !state->buffer || !state->sourceGeometry.isValid()) {
+        return;
+    }
+    QSizeF bounds = QSizeF(state->buffer->size()) / state->bufferScale;
+    switch (state->bufferTransform) {
+    case OutputInterface::Transform::Rotated90:
+    case OutputInterface::Transform::Rotated270:
+    case OutputInterface::Transform::Flipped90:
+    case OutputInterface::Transform::Flipped270:
+        bounds.transpose();
+        break;
+    default:
+        break;
+    }
+    if (!QRectF(QPointF(0, 0), bounds).contains(state->sourceGeometry)) {
+        wl_resource_post_error(viewportExtension->resource()->handle, QtWaylandServer::wp_viewport::error_out_of_buffer,
+                               "the source rectangle is outside of the buffer");
+        return;
+    }
+    const QSizeF sourceSize = state->sourceGeometry.size();
+    if (!state->destinationSize.isValid() && sourceSize != QSizeF(sourceSize.toSize())) {
+        wl_resource_post_error(viewportExtension->resource()->handle, QtWaylandServer::wp_viewport::error_bad_size,
+                               "the source size is not integer and no destination size is set");
+    }
+}
+
+static qint64 regionBytes(const QRegion &region)
+{
+    return region.rectCount() * qint64(sizeof(QRect));
+}
+
+void SurfaceInterfacePrivate::updateMemoryUsage()
+{
+    qint64 bytes = regionBytes(trackedDamage) + regionBytes(inputRegion);
+    for (const QRegion &damage : qAsConst(damageHistory)) {
+        bytes += regionBytes(damage);
+    }
+    for (const State *state : {&current, &pending, &cached}) {
+        bytes += regionBytes(state->damage) + regionBytes(state->bufferDamage)
+               + regionBytes(state->opaque) + regionBytes(state->input);
+    }
+    memoryAccount.setBytes(bytes);
+}
+
+void SurfaceInterfacePrivate::commitPointerConstraints()
+{
+    if (lockedPointer) {
+        auto lockedPointerPrivate = LockedPointerV1InterfacePrivate::get(lockedPointer);
+        lockedPointerPrivate->commit();
+    }
+    if (confinedPointer) {
+        auto confinedPointerPrivate = ConfinedPointerV1InterfacePrivate::get(confinedPointer);
+        confinedPointerPrivate->commit();
+    }
+}
+
+void SurfaceInterfacePrivate::resetAccumulatedState(State *state)
+{
+    // Only reset what accumulates between commits, the other fields are ignored as long as
+    // their change flag is not set.
+    state->changes = {};
+    state->buffer = nullptr;
+    state->acquirePoint = LinuxDrmSyncObjPointV1();
+    state->releasePoint = LinuxDrmSyncObjPointV1();
+    if (!state->damage.isEmpty()) {
+        state->damage = QRegion();
+    }
+    if (!state->bufferDamage.isEmpty()) {
+        state->bufferDamage = QRegion();
+    }
+}
+
+void SurfaceInterfacePrivate::moveState(State *source, State *target)
+{
+    // Nothing of the target is worth keeping, so all fields are swapped rather than copied.
+    // The children are the exception, the source is modified in place by the requests to
+    // restack sub-surfaces and has to keep the latest stacking order, the target shares it.
+    if (source->changes & State::ChildrenChanged) {
+        target->children = source->children;
+    }
+    std::swap(target->changes, source->changes);
+    target->damage.swap(source->damage);
+    target->bufferDamage.swap(source->bufferDamage);
+    target->opaque.swap(source->opaque);
+    target->input.swap(source->input);
+    std::swap(target->inputIsInfinite, source->inputIsInfinite);
+    std::swap(target->sourceGeometry, source->sourceGeometry);
+    std::swap(target->destinationSize, source->destinationSize);
+    std::swap(target->size, source->size);
+    std::swap(target->bufferScale, source->bufferScale);
+    std::swap(target->bufferTransform, source->bufferTransform);
+    std::swap(target->contentType, source->contentType);
+    std::swap(target->presentationHint, source->presentationHint);
+    target->frameCallbacks.takeFrom(&source->frameCallbacks);
+    target->presentationFeedback.takeFrom(&source->presentationFeedback);
+    std::swap(target->offset, source->offset);
+    std::swap(target->buffer, source->buffer);
+    std::swap(target->acquirePoint, source->acquirePoint);
+    std::swap(target->releasePoint, source->releasePoint);
+    target->effects.swap(source->effects);
+    commitPointerConstraints();
+
+    resetAccumulatedState(source);
+    updateMemoryUsage();
+}
+
 void SurfaceInterfacePrivate::swapStates(State *source, State *target, bool emitChanged)
 {
-    const bool bufferChanged = source->bufferIsSet;
-    const bool opaqueRegionChanged = source->opaqueIsSet;
-    const bool inputRegionChanged = source->inputIsSet;
-    const bool scaleFactorChanged = source->bufferScaleIsSet && (target->bufferScale != source->bufferScale);
-    const bool transformChanged = source->bufferTransformIsSet && (target->bufferTransform != source->bufferTransform);
-    const bool shadowChanged = source->shadowIsSet;
-    const bool blurChanged = source->blurIsSet;
-    const bool contrastChanged = source->contrastIsSet;
-    const bool slideChanged = source->slideIsSet;
-    const bool childrenChanged = source->childrenChanged;
+    const AppliedChanges applied = applyState(source, target, emitChanged);
+    if (emitChanged) {
+        emitChanges(applied);
+    }
+}
+
+SurfaceInterfacePrivate::AppliedChanges SurfaceInterfacePrivate::applyState(State *source, State *target, bool emitChanged)
+{
+    const State::Changes changes = source->changes;
+    const bool bufferChanged = changes & State::BufferChanged;
+    const bool opaqueRegionChanged = changes & State::OpaqueChanged;
+    const bool inputRegionChanged = changes & State::InputChanged;
+    const bool scaleFactorChanged = (changes & State::BufferScaleChanged) && (target->bufferScale != source->bufferScale);
+    const bool transformChanged = (changes & State::BufferTransformChanged) && (target->bufferTransform != source->bufferTransform);
+    const bool contentTypeChanged = (changes & State::ContentTypeChanged) && (target->contentType != source->contentType);
+    const bool presentationHintChanged = (changes & State::PresentationHintChanged) && (target->presentationHint != source->presentationHint);
+    const bool shadowChanged = changes & State::ShadowChanged;
+    const bool blurChanged = changes & State::BlurChanged;
+    const bool contrastChanged = changes & State::ContrastChanged;
+    const bool slideChanged = changes & State::SlideChanged;
+    const bool childrenChanged = changes & State::ChildrenChanged;
     const bool visibilityChanged = bufferChanged && (bool(source->buffer) != bool(target->buffer));
     const QSize oldSize = target->size;
     const QSize oldBufferSize = bufferSize;
     const QMatrix4x4 oldSurfaceToBufferMatrix = surfaceToBufferMatrix;
     const QRegion oldInputRegion = inputRegion;
+    const bool oldInputIsInfinite = target->inputIsInfinite;
     if (bufferChanged) {
+        if (!emitChanged && (target->changes & State::BufferChanged)) {
+            dropReleasePoint(target);
+        }
         // TODO: is the reffing correct for subsurfaces?
         if (target->buffer) {
             if (emitChanged) {
@@ -522,72 +1019,82 @@ void SurfaceInterfacePrivate::swapStates(State *source, State *target, bool emit
             }
         }
         target->buffer = source->buffer;
+        target->acquirePoint = source->acquirePoint;
+        target->releasePoint = source->releasePoint;
         target->offset = source->offset;
-        target->damage = source->damage;
-        target->bufferDamage = source->bufferDamage;
-        target->bufferIsSet = source->bufferIsSet;
+        target->damage = std::move(source->damage);
+        target->bufferDamage = std::move(source->bufferDamage);
     }
-    if (source->sourceGeometryIsSet) {
+    if (changes & State::SourceGeometryChanged) {
         target->sourceGeometry = source->sourceGeometry;
-        target->sourceGeometryIsSet = true;
     }
-    if (source->destinationSizeIsSet) {
+    if (changes & State::DestinationSizeChanged) {
         target->destinationSize = source->destinationSize;
-        target->destinationSizeIsSet = true;
     }
     if (childrenChanged) {
-        target->childrenChanged = source->childrenChanged;
         target->children = source->children;
     }
-    target->frameCallbacks.append(source->frameCallbacks);
-    qDebug()<<"Sleep_noresponse:"<<target->frameCallbacks.size();
-
-    if (shadowChanged) {
-        target->shadow = source->shadow;
-        target->shadowIsSet = true;
-    }
-    if (blurChanged) {
-        target->blur = source->blur;
-        target->blurIsSet = true;
+    if (target == &current) {
+        // the callbacks of one commit, counted here so the throttling doesn't walk the list
+        committedFrameCallbacks += source->frameCallbacks.count();
     }
-    if (contrastChanged) {
-        target->contrast = source->contrast;
-        target->contrastIsSet = true;
-    }
-    if (slideChanged) {
-        target->slide = source->slide;
-        target->slideIsSet = true;
+    target->frameCallbacks.takeFrom(&source->frameCallbacks);
+    // the content update of the target won't be presented anymore, it got superseded
+    target->presentationFeedback.sendDiscarded();
+    target->presentationFeedback.takeFrom(&source->presentationFeedback);
+
+    if (shadowChanged || blurChanged || contrastChanged || slideChanged) {
+        if (shadowChanged && blurChanged && contrastChanged && slideChanged) {
+            target->effects = source->effects;
+        } else {
+            // the unchanged effects of the source are stale, only the changed ones are taken
+            EffectState *effects = effectsForWriting(target);
+            if (shadowChanged) {
+                effects->shadow = source->effects.constData()->shadow;
+            }
+            if (blurChanged) {
+                effects->blur = source->effects.constData()->blur;
+            }
+            if (contrastChanged) {
+                effects->contrast = source->effects.constData()->contrast;
+            }
+            if (slideChanged) {
+                effects->slide = source->effects.constData()->slide;
+            }
+        }
     }
     if (inputRegionChanged) {
-        target->input = source->input;
-        target->inputIsSet = true;
+        target->input = std::move(source->input);
+        target->inputIsInfinite = source->inputIsInfinite;
     }
     if (opaqueRegionChanged) {
-        target->opaque = source->opaque;
-        target->opaqueIsSet = true;
+        target->opaque = std::move(source->opaque);
     }
-    if (scaleFactorChanged) {
+    // The cached state of a synchronized sub-surface is compared with the current state only
+    // when it gets applied, so the scale and transform have to be carried over unconditionally.
+    if (changes & State::BufferScaleChanged) {
         target->bufferScale = source->bufferScale;
-        target->bufferScaleIsSet = true;
     }
-    if (transformChanged) {
+    if (changes & State::BufferTransformChanged) {
         target->bufferTransform = source->bufferTransform;
-        target->bufferTransformIsSet = true;
     }
-    if (lockedPointer) {
-        auto lockedPointerPrivate = LockedPointerV1InterfacePrivate::get(lockedPointer);
-        lockedPointerPrivate->commit();
+    if (changes & State::ContentTypeChanged) {
+        target->contentType = source->contentType;
     }
-    if (confinedPointer) {
-        auto confinedPointerPrivate = ConfinedPointerV1InterfacePrivate::get(confinedPointer);
-        confinedPointerPrivate->commit();
+    if (changes & State::PresentationHintChanged) {
+        target->presentationHint = source->presentationHint;
     }
+    target->changes |= changes;
+    commitPointerConstraints();
 
-    *source = State{};
-    source->children = target->children;
+    // The children of the source are kept in sync with the target by addChild() and
+    // removeChild(), so they don't have to be copied back.
+    resetAccumulatedState(source);
+    updateMemoryUsage();
 
+    AppliedChanges applied;
     if (!emitChanged) {
-        return;
+        return applied;
     }
     // TODO: Refactor the state management code because it gets more clumsy.
     if (target->buffer) {
@@ -616,95 +1123,322 @@ void SurfaceInterfacePrivate::swapStates(State *source, State *target, bool emit
         target->size = QSize();
         bufferSize = QSize();
     }
-    surfaceToBufferMatrix = buildSurfaceToBufferMatrix(target);
-    bufferToSurfaceMatrix = surfaceToBufferMatrix.inverted();
+    updateSurfaceToBufferMatrix(target);
     // casper_yang for scale
-    inputRegion = target->input & QRect(QPoint(0, 0), target->size);
-    if (opaqueRegionChanged) {
-        emit q->opaqueChanged(target->opaque);
+    // an infinite input region always covers the whole surface, it's never intersected
+    if (!target->inputIsInfinite) {
+        if (inputRegionChanged || target->size != oldSize) {
+            inputRegion = target->input & QRect(QPoint(0, 0), target->size);
+        }
+    } else if (inputRegionChanged) {
+        inputRegion = QRegion();
     }
-    if (oldInputRegion != inputRegion) {
-        emit q->inputChanged(inputRegion);
+    const bool inputChanged = oldInputIsInfinite != target->inputIsInfinite
+        || (target->inputIsInfinite ? target->size != oldSize : oldInputRegion != inputRegion);
+    if (childrenChanged || visibilityChanged || target->size != oldSize || inputChanged) {
+        invalidatePickingCache();
+    } else if (target == &current && (bufferChanged || opaqueRegionChanged)) {
+        invalidateRenderList();
     }
-    if (scaleFactorChanged) {
-        emit q->bufferScaleChanged(target->bufferScale);
+    if (visibilityChanged) {
+        subSurfaceIsMapped = target->buffer;
+    }
+    if (bufferChanged && target->buffer && (!target->damage.isEmpty() || !target->bufferDamage.isEmpty())) {
+        // QRegion shares the data when one side of united() is empty or the damage lies within
+        // the rect given to intersected(), so the common cases don't allocate temporaries
+        QRegion damage = std::move(target->damage);
+        if (!target->bufferDamage.isEmpty()) {
+            damage = damage.united(q->mapFromBuffer(target->bufferDamage));
+        }
+        target->damage = damage.intersected(QRect(QPoint(0, 0), q->size()));
+        trackedDamage |= target->damage;
+        if (statisticsTimer) {
+            for (const QRect &rect : target->damage) {
+                statistics.damagedPixels += quint64(rect.width()) * rect.height();
+            }
+        }
+        applied.damaged = true;
     }
-    if (transformChanged) {
-        emit q->bufferTransformChanged(target->bufferTransform);
+    if (bufferChanged) {
+        // a different size or mapping replaces all the content the renderer may have
+        if (target->size != oldSize || surfaceToBufferMatrix != oldSurfaceToBufferMatrix) {
+            recordDamage(QRect(QPoint(0, 0), target->size));
+        } else {
+            recordDamage(target->damage);
+        }
     }
-    if (visibilityChanged) {
-        if (target->buffer) {
-            subSurfaceIsMapped = true;
+
+    applied.opaqueChanged = opaqueRegionChanged;
+    applied.inputChanged = inputChanged;
+    applied.bufferScaleChanged = scaleFactorChanged;
+    applied.bufferTransformChanged = transformChanged;
+    applied.contentTypeChanged = contentTypeChanged;
+    applied.presentationHintChanged = presentationHintChanged;
+    applied.visibilityChanged = visibilityChanged;
+    applied.surfaceToBufferMatrixChanged = surfaceToBufferMatrix != oldSurfaceToBufferMatrix;
+    applied.bufferSizeChanged = bufferSize != oldBufferSize;
+    applied.sizeChanged = target->size != oldSize;
+    applied.effectsChanged.setFlag(SurfaceInterface::Effect::Shadow, shadowChanged);
+    if (blurChanged) {
+        // clients tend to create a new blur object for every update, even if it's the same
+        const EffectParameters blurParameters = effectParameters(target->effects.constData()->blur.data());
+        applied.effectsChanged.setFlag(SurfaceInterface::Effect::Blur, blurParameters != notifiedBlur);
+        notifiedBlur = blurParameters;
+    }
+    if (contrastChanged) {
+        const EffectParameters contrastParameters = effectParameters(target->effects.constData()->contrast.data());
+        applied.effectsChanged.setFlag(SurfaceInterface::Effect::Contrast, contrastParameters != notifiedContrast);
+        notifiedContrast = contrastParameters;
+    }
+    applied.effectsChanged.setFlag(SurfaceInterface::Effect::SlideOnShowHide, slideChanged);
+    applied.childrenChanged = childrenChanged;
+    if (target == &current && (shadowChanged || blurChanged || contrastChanged || transformChanged
+                               || applied.surfaceToBufferMatrixChanged)) {
+        scanoutCandidateValid = false;
+    }
+    return applied;
+}
+
+SurfaceInterfacePrivate::EffectParameters SurfaceInterfacePrivate::effectParameters(BlurInterface *blur)
+{
+    EffectParameters parameters;
+    if (blur) {
+        parameters.isSet = true;
+        parameters.region = blur->region();
+    }
+    return parameters;
+}
+
+SurfaceInterfacePrivate::EffectParameters SurfaceInterfacePrivate::effectParameters(ContrastInterface *contrast)
+{
+    EffectParameters parameters;
+    if (contrast) {
+        parameters.isSet = true;
+        parameters.region = contrast->region();
+        parameters.contrast = contrast->contrast();
+        parameters.intensity = contrast->intensity();
+        parameters.saturation = contrast->saturation();
+    }
+    return parameters;
+}
+
+void SurfaceInterfacePrivate::emitChanges(const AppliedChanges &applied)
+{
+    if (applied.opaqueChanged) {
+        emit q->opaqueChanged(current.opaque);
+    }
+    if (applied.inputChanged) {
+        emit q->inputChanged(q->input());
+    }
+    if (applied.bufferScaleChanged) {
+        emit q->bufferScaleChanged(current.bufferScale);
+    }
+    if (applied.bufferTransformChanged) {
+        emit q->bufferTransformChanged(current.bufferTransform);
+    }
+    if (applied.contentTypeChanged) {
+        emit q->contentTypeChanged();
+    }
+    if (applied.presentationHintChanged) {
+        emit q->presentationHintChanged();
+    }
+    if (applied.visibilityChanged) {
+        if (current.buffer) {
             emit q->mapped();
         } else {
-            subSurfaceIsMapped = false;
             emit q->unmapped();
         }
     }
-    if (bufferChanged) {
-        if (target->buffer && (!target->damage.isEmpty() || !target->bufferDamage.isEmpty())) {
-            const QRegion windowRegion = QRegion(0, 0, q->size().width(), q->size().height());
-            const QRegion bufferDamage = q->mapFromBuffer(target->bufferDamage);
-            target->damage = windowRegion.intersected(target->damage.united(bufferDamage));
-            trackedDamage |= target->damage;
-            emit q->damaged(target->damage);
-            // workaround for https://bugreports.qt.io/browse/QTBUG-52092
-            // if the surface is a sub-surface, but the main surface is not yet mapped, fake frame rendered
-            if (subSurface) {
-                const auto mainSurface = subSurface->mainSurface();
-                if (!mainSurface || !mainSurface->buffer()) {
-                    q->frameRendered(0);
-                }
+    if (applied.damaged && commitThrottled) {
+        throttledDamage |= current.damage;
+    } else if (applied.damaged) {
+        emit q->damaged(current.damage);
+        // workaround for https://bugreports.qt.io/browse/QTBUG-52092
+        // if the surface is a sub-surface, but the main surface is not yet mapped, fake frame rendered
+        if (subSurface) {
+            const auto mainSurface = subSurface->mainSurface();
+            if (!mainSurface || !mainSurface->buffer()) {
+                q->frameRendered(0);
             }
         }
     }
-    if (surfaceToBufferMatrix != oldSurfaceToBufferMatrix) {
+    if (applied.surfaceToBufferMatrixChanged) {
         emit q->surfaceToBufferMatrixChanged();
     }
-    if (bufferSize != oldBufferSize) {
+    if (applied.bufferSizeChanged) {
         emit q->bufferSizeChanged();
     }
-    if (target->size != oldSize) {
+    if (applied.sizeChanged) {
         emit q->sizeChanged();
     }
-    if (shadowChanged) {
+    if (applied.effectsChanged & SurfaceInterface::Effect::Shadow) {
         emit q->shadowChanged();
     }
-    if (blurChanged) {
+    if (applied.effectsChanged & SurfaceInterface::Effect::Blur) {
         emit q->blurChanged();
     }
-    if (contrastChanged) {
+    if (applied.effectsChanged & SurfaceInterface::Effect::Contrast) {
         emit q->contrastChanged();
     }
-    if (slideChanged) {
+    if (applied.effectsChanged & SurfaceInterface::Effect::SlideOnShowHide) {
         emit q->slideOnShowHideChanged();
     }
-    if (childrenChanged) {
+    if (applied.effectsChanged) {
+        emit q->effectsChanged(applied.effectsChanged);
+    }
+    if (applied.childrenChanged) {
         emit q->subSurfaceTreeChanged();
     }
+
+    if (commitObservers.isEmpty()) {
+        return;
+    }
+    SurfaceCommitInfo info;
+    info.changes.setFlag(SurfaceCommitInfo::Change::Opaque, applied.opaqueChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::Input, applied.inputChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::BufferScale, applied.bufferScaleChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::BufferTransform, applied.bufferTransformChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::ContentType, applied.contentTypeChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::PresentationHint, applied.presentationHintChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::Mapped, applied.visibilityChanged && current.buffer);
+    info.changes.setFlag(SurfaceCommitInfo::Change::Unmapped, applied.visibilityChanged && !current.buffer);
+    info.changes.setFlag(SurfaceCommitInfo::Change::SurfaceToBufferMatrix, applied.surfaceToBufferMatrixChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::BufferSize, applied.bufferSizeChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::Size, applied.sizeChanged);
+    info.changes.setFlag(SurfaceCommitInfo::Change::SubSurfaceTree, applied.childrenChanged);
+    if (applied.damaged && !commitThrottled) {
+        info.changes |= SurfaceCommitInfo::Change::Damage;
+        info.damage = current.damage;
+    }
+    if (applied.effectsChanged) {
+        info.changes |= SurfaceCommitInfo::Change::Effects;
+        info.effects = applied.effectsChanged;
+    }
+    notifyCommitObservers(info);
+}
+
+void SurfaceInterfacePrivate::notifyCommitObservers(const SurfaceCommitInfo &info)
+{
+    // a copy, observers may remove themselves
+    const QVector<SurfaceCommitObserver *> observers = commitObservers;
+    for (SurfaceCommitObserver *observer : observers) {
+        if (commitObservers.contains(observer)) {
+            observer->surfaceCommitted(q, info);
+        }
+    }
+}
+
+void SurfaceInterfacePrivate::dropReleasePoint(const State *state)
+{
+    if (state->releasePoint.isValid() && syncObjManager) {
+        emit syncObjManager->releasePointDropped(state->releasePoint);
+    }
 }
 
 void SurfaceInterfacePrivate::commit()
 {
-    if (!subSurface) {
-        swapStates(&pending, &current, true);
+    if (syncObjSurface && !syncObjSurface->checkCommit()) {
+        return;
+    }
 
-        if (current.frameCallbacks.size() > 500) {
-            q->frameRendered(100);
-        }
-        // The position of a sub-surface is applied when its parent is committed.
-        const QList<SubSurfaceInterface *> children = current.children;
-        for (SubSurfaceInterface *subsurface : children) {
-            auto subsurfacePrivate = SubSurfaceInterfacePrivate::get(subsurface);
-            subsurfacePrivate->parentCommit();
+    // The damage rectangles are united only once per commit.
+    if (!pendingDamage.isEmpty()) {
+        pending.damage |= pendingDamage.take();
+    }
+    if (!pendingBufferDamage.isEmpty()) {
+        pending.bufferDamage |= pendingBufferDamage.take();
+    }
+
+    ClientConnectionPrivate::get(client)->recordCommit();
+    if (statisticsTimer) {
+        statistics.commits++;
+        if (!frameLatencyTimer.isValid()) {
+            frameLatencyTimer.start();
         }
     }
+    KWS_TRACE() << "Surface" << q->id() << "of" << client->processId() << "committed,"
+                << "commits per second:" << client->commitsPerSecond();
 
-    if (role) {
-        role->commit();
+    if (subSurface && subSurface->isSynchronized()) {
+        // applied along with the parent
+        SubSurfaceInterfacePrivate::get(subSurface)->commitToCache();
+        emit q->committed();
+        return;
     }
 
+    const bool throttled = ClientConnectionPrivate::get(client)->throttleCommit(q);
+    if (commitThrottled && !throttled) {
+        // a new period started before the held back signals were flushed
+        flushThrottledCommit();
+    }
+    commitThrottled = throttled;
+
+    SurfaceTransaction transaction;
+    if (subSurface && SubSurfaceInterfacePrivate::get(subSurface)->hasCacheState) {
+        SubSurfaceInterfacePrivate::get(subSurface)->commitToCache();
+        transaction.add(q, &cached);
+    } else {
+        transaction.add(q, &pending);
+    }
+    transaction.apply();
+
+    // A client that keeps committing while the compositor does not render it, e.g. because
+    // it is hidden, would pile up frame callbacks without bound. Only the committed ones
+    // count, the compositor can't complete the pending or cached ones anyway.
+    if (!subSurface && maximumPendingFrameCallbacks > 0 && committedFrameCallbacks > maximumPendingFrameCallbacks) {
+        throttleFrameCallbacks();
+    }
+
+    if (commitThrottled) {
+        // emitted by flushThrottledCommit() at the end of the period
+        return;
+    }
     emit q->committed();
+    transaction.emitTreeCommitted();
+}
+
+void SurfaceInterfacePrivate::flushThrottledCommit()
+{
+    if (!commitThrottled) {
+        return;
+    }
+    commitThrottled = false;
+    if (!throttledDamage.isEmpty()) {
+        const QRegion damage = std::exchange(throttledDamage, QRegion());
+        emit q->damaged(damage);
+        // same workaround as in emitChanges() for sub-surfaces of an unmapped main surface
+        if (subSurface) {
+            const auto mainSurface = subSurface->mainSurface();
+            if (!mainSurface || !mainSurface->buffer()) {
+                q->frameRendered(0);
+            }
+        }
+        if (!commitObservers.isEmpty()) {
+            SurfaceCommitInfo info;
+            info.changes = SurfaceCommitInfo::Change::Damage;
+            info.damage = damage;
+            notifyCommitObservers(info);
+        }
+    }
+    emit q->committed();
+    SurfaceInterface *mainSurface = subSurface ? subSurface->mainSurface() : q;
+    if (mainSurface) {
+        emit mainSurface->treeCommitted();
+    }
+}
+
+SurfaceCommitObserver::~SurfaceCommitObserver() = default;
+
+void SurfaceInterface::addCommitObserver(SurfaceCommitObserver *observer)
+{
+    if (!d->commitObservers.contains(observer)) {
+        d->commitObservers.append(observer);
+    }
+}
+
+void SurfaceInterface::removeCommitObserver(SurfaceCommitObserver *observer)
+{
+    d->commitObservers.removeOne(observer);
 }
 
 QRegion SurfaceInterface::damage() const
@@ -719,9 +1453,17 @@ QRegion SurfaceInterface::opaque() const
 
 QRegion SurfaceInterface::input() const
 {
+    if (d->current.inputIsInfinite) {
+        return QRect(QPoint(0, 0), d->current.size);
+    }
     return d->inputRegion;
 }
 
+bool SurfaceInterface::inputIsInfinite() const
+{
+    return d->current.inputIsInfinite;
+}
+
 qint32 SurfaceInterface::bufferScale() const
 {
     return d->current.bufferScale;
@@ -742,6 +1484,26 @@ QPoint SurfaceInterface::offset() const
     return d->current.offset;
 }
 
+ContentType SurfaceInterface::contentType() const
+{
+    return d->current.contentType;
+}
+
+PresentationHint SurfaceInterface::presentationHint() const
+{
+    return d->current.presentationHint;
+}
+
+LinuxDrmSyncObjPointV1 SurfaceInterface::acquirePoint() const
+{
+    return d->current.acquirePoint;
+}
+
+LinuxDrmSyncObjPointV1 SurfaceInterface::releasePoint() const
+{
+    return d->current.releasePoint;
+}
+
 SurfaceInterface *SurfaceInterface::get(wl_resource *native)
 {
     if (auto surfacePrivate = resource_cast<SurfaceInterfacePrivate *>(native)) {
@@ -752,13 +1514,10 @@ SurfaceInterface *SurfaceInterface::get(wl_resource *native)
 
 SurfaceInterface *SurfaceInterface::get(quint32 id, const ClientConnection *client)
 {
-    const QList<SurfaceInterface *> candidates = surfaces();
-    for (SurfaceInterface *surface : candidates) {
-        if (surface->client() == client && surface->id() == id) {
-            return surface;
-        }
+    if (!client) {
+        return nullptr;
     }
-    return nullptr;
+    return ClientConnectionPrivate::get(const_cast<ClientConnection *>(client))->surfaces.value(id);
 }
 
 QList<SubSurfaceInterface *> SurfaceInterface::childSubSurfaces() const
@@ -791,22 +1550,22 @@ QRect SurfaceInterface::boundingRect() const
 
 QPointer< ShadowInterface > SurfaceInterface::shadow() const
 {
-    return d->current.shadow;
+    return d->current.effects ? d->current.effects.constData()->shadow : QPointer<ShadowInterface>();
 }
 
 QPointer< BlurInterface > SurfaceInterface::blur() const
 {
-    return d->current.blur;
+    return d->current.effects ? d->current.effects.constData()->blur : QPointer<BlurInterface>();
 }
 
 QPointer< ContrastInterface > SurfaceInterface::contrast() const
 {
-    return d->current.contrast;
+    return d->current.effects ? d->current.effects.constData()->contrast : QPointer<ContrastInterface>();
 }
 
 QPointer< SlideInterface > SurfaceInterface::slideOnShowHide() const
 {
-    return d->current.slide;
+    return d->current.effects ? d->current.effects.constData()->slide : QPointer<SlideInterface>();
 }
 
 bool SurfaceInterface::isMapped() const
@@ -829,6 +1588,62 @@ void SurfaceInterface::resetTrackedDamage()
     d->trackedDamage = QRegion();
 }
 
+void SurfaceInterfacePrivate::recordDamage(const QRegion &damage)
+{
+    ++damageSequence;
+    damageHistory[damageSequence % damageHistory.count()] = damage;
+}
+
+quint64 SurfaceInterface::damageSequence() const
+{
+    return d->damageSequence;
+}
+
+QRegion SurfaceInterface::damageSince(quint64 sequence) const
+{
+    if (sequence >= d->damageSequence) {
+        return QRegion();
+    }
+    const int historySize = d->damageHistory.count();
+    if (d->damageSequence - sequence > quint64(historySize)) {
+        return QRect(QPoint(0, 0), size());
+    }
+    QRegion damage;
+    for (quint64 i = sequence + 1; i <= d->damageSequence; ++i) {
+        damage += d->damageHistory[i % historySize];
+    }
+    return damage;
+}
+
+void SurfaceInterface::setDamageHistorySize(int size)
+{
+    size = std::max(size, 1);
+    const int oldSize = d->damageHistory.count();
+    if (size == oldSize) {
+        return;
+    }
+    QVector<QRegion> history(size);
+    const quint64 kept = std::min<quint64>(std::min(size, oldSize), d->damageSequence);
+    for (quint64 i = d->damageSequence - kept + 1; i <= d->damageSequence; ++i) {
+        history[i % size] = d->damageHistory[i % oldSize];
+    }
+    d->damageHistory = history;
+    d->updateMemoryUsage();
+}
+
+int SurfaceInterface::damageHistorySize() const
+{
+    return d->damageHistory.count();
+}
+
+bool SurfaceInterface::forEachDamagedSpan(const std::function<void(const QRect &span, const uchar *bits)> &callback)
+{
+    if (!d->current.buffer) {
+        return false;
+    }
+    return d->current.buffer->forEachSpan(mapToBuffer(d->trackedDamage), callback);
+}
+
 QVector<OutputInterface *> SurfaceInterface::outputs() const
 {
     return d->outputs;
@@ -836,26 +1651,26 @@ QVector<OutputInterface *> SurfaceInterface::outputs() const
 
 void SurfaceInterface::setOutputs(const QVector<OutputInterface *> &outputs)
 {
-    QVector<OutputInterface *> removedOutputs = d->outputs;
-    for (auto it = outputs.constBegin(), end = outputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        removedOutputs.removeOne(o);
-    }
-    for (auto it = removedOutputs.constBegin(), end = removedOutputs.constEnd(); it != end; ++it) {
-        const auto resources = (*it)->clientResources(client());
+    // the compositor updates the outputs whenever a window moves, most of the time they stay
+    // the same and neither this surface nor its sub-surfaces have anything to send
+    bool changed = outputs.count() != d->outputs.count();
+    for (OutputInterface *o : qAsConst(d->outputs)) {
+        if (outputs.contains(o)) {
+            continue;
+        }
+        changed = true;
+        const auto resources = o->clientResources(client());
         for (wl_resource *outputResource : resources) {
             d->send_leave(outputResource);
         }
-        disconnect(d->outputDestroyedConnections.take(*it));
-        disconnect(d->outputBoundConnections.take(*it));
-    }
-    QVector<OutputInterface *> addedOutputsOutputs = outputs;
-    for (auto it = d->outputs.constBegin(), end = d->outputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
-        addedOutputsOutputs.removeOne(o);
+        disconnect(d->outputDestroyedConnections.take(o));
+        disconnect(d->outputBoundConnections.take(o));
     }
-    for (auto it = addedOutputsOutputs.constBegin(), end = addedOutputsOutputs.constEnd(); it != end; ++it) {
-        const auto o = *it;
+    for (OutputInterface *o : outputs) {
+        if (d->outputs.contains(o)) {
+            continue;
+        }
+        changed = true;
         const auto resources = o->clientResources(client());
         for (wl_resource *outputResource : resources) {
             d->send_enter(outputResource);
@@ -874,61 +1689,234 @@ void SurfaceInterface::setOutputs(const QVector<OutputInterface *> &outputs)
             d->send_enter(outputResource);
         });
     }
+    if (!changed) {
+        return;
+    }
 
     d->outputs = outputs;
-    for (auto child : d->current.children) {
+    for (auto child : qAsConst(d->current.children)) {
         child->surface()->setOutputs(outputs);
     }
 }
 
+qreal SurfaceInterface::preferredScale() const
+{
+    return d->preferredScale;
+}
+
+void SurfaceInterface::setPreferredScale(qreal scale)
+{
+    if (scale <= 0) {
+        return;
+    }
+    d->preferredScale = scale;
+    if (d->fractionalScaleExtension) {
+        d->fractionalScaleExtension->setPreferredScale(scale);
+    }
+    for (auto child : qAsConst(d->current.children)) {
+        child->surface()->setPreferredScale(scale);
+    }
+}
+
+void SurfaceInterfacePrivate::invalidatePickingCache()
+{
+    // The ancestors have to be invalidated even if this cache is already outdated, they
+    // might have been rebuilt from the current state of this surface in the meantime.
+    for (SurfaceInterfacePrivate *surface = this; surface; ) {
+        surface->pickingCacheValid = false;
+        surface->renderListValid = false;
+        surface->scanoutCandidateValid = false;
+        SurfaceInterface *parent = surface->subSurface ? surface->subSurface->parentSurface() : nullptr;
+        surface = parent ? SurfaceInterfacePrivate::get(parent) : nullptr;
+    }
+}
+
+static void collectPickingEntries(SurfaceInterface *surface, const QPointF &offset, qreal inputScale,
+                                  const QPointF &inputOffset, QVector<SurfaceInterfacePrivate::PickingEntry> *entries)
+{
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    // go from top to bottom. Top most child is last in list
+    const QList<SubSurfaceInterface *> &children = surfacePrivate->current.children;
+    for (auto it = children.crbegin(); it != children.crend(); ++it) {
+        SurfaceInterface *child = (*it)->surface();
+        SurfaceInterfacePrivate *childPrivate = SurfaceInterfacePrivate::get(child);
+        // the parent is mapped, so the mapping of the child only depends on its own state
+        if (!childPrivate->subSurfaceIsMapped) {
+            continue;
+        }
+        const QPointF position = (*it)->position();
+        collectPickingEntries(child, offset + position, inputScale / childPrivate->inputAreaScale,
+                              (inputOffset + position) / childPrivate->inputAreaScale, entries);
+    }
+    if (!surface->size().isEmpty()) {
+        entries->append({surface, QRectF(offset, surface->size()), inputScale, inputOffset,
+                         surfacePrivate->inputRegion, surfacePrivate->current.inputIsInfinite});
+    }
+}
+
+void SurfaceInterfacePrivate::updatePickingCache()
+{
+    if (pickingCacheValid) {
+        return;
+    }
+    pickingEntries.clear();
+    collectPickingEntries(q, QPointF(0, 0), 1 / inputAreaScale, QPointF(0, 0), &pickingEntries);
+    pickingBoundingRect = QRectF();
+    for (const PickingEntry &entry : qAsConst(pickingEntries)) {
+        pickingBoundingRect |= entry.geometry;
+    }
+    pickingCacheValid = true;
+}
+
+void SurfaceInterfacePrivate::invalidateRenderList()
+{
+    for (SurfaceInterfacePrivate *surface = this; surface; ) {
+        surface->renderListValid = false;
+        surface->scanoutCandidateValid = false;
+        SurfaceInterface *parent = surface->subSurface ? surface->subSurface->parentSurface() : nullptr;
+        surface = parent ? SurfaceInterfacePrivate::get(parent) : nullptr;
+    }
+}
+
+static void collectRenderEntries(SurfaceInterface *surface, const QPoint &offset, QVector<SurfaceRenderEntry> *entries)
+{
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    // go from bottom to top, the surface is below its children
+    if (surfacePrivate->current.buffer) {
+        entries->append({surface, offset, surfacePrivate->current.buffer, surfacePrivate->current.opaque.translated(offset)});
+    }
+    for (SubSurfaceInterface *subSurface : qAsConst(surfacePrivate->current.children)) {
+        SurfaceInterface *child = subSurface->surface();
+        if (!SurfaceInterfacePrivate::get(child)->subSurfaceIsMapped) {
+            continue;
+        }
+        collectRenderEntries(child, offset + subSurface->position(), entries);
+    }
+}
+
+void SurfaceInterfacePrivate::updateRenderList()
+{
+    if (renderListValid) {
+        return;
+    }
+    renderEntries.clear();
+    collectRenderEntries(q, QPoint(0, 0), &renderEntries);
+    renderListValid = true;
+}
+
+QVector<SurfaceRenderEntry> SurfaceInterface::renderList() const
+{
+    if (!isMapped()) {
+        return QVector<SurfaceRenderEntry>();
+    }
+    d->updateRenderList();
+    return d->renderEntries;
+}
+
+void SurfaceInterfacePrivate::updateScanoutCandidate()
+{
+    if (scanoutCandidateValid) {
+        return;
+    }
+    scanoutCandidateValid = true;
+    using Candidate = SurfaceInterface::ScanoutCandidate;
+    if (!current.buffer) {
+        scanoutCandidate = Candidate::NoBuffer;
+        return;
+    }
+    if (!current.buffer->linuxDmabufBuffer()) {
+        scanoutCandidate = Candidate::NotDmabuf;
+        return;
+    }
+    updateRenderList();
+    // the first entry is the surface itself
+    if (renderEntries.count() > 1) {
+        scanoutCandidate = Candidate::SubSurfaces;
+        return;
+    }
+    QSize unscaledSize = current.size * current.bufferScale;
+    switch (current.bufferTransform) {
+    case OutputInterface::Transform::Rotated90:
+    case OutputInterface::Transform::Rotated270:
+    case OutputInterface::Transform::Flipped90:
+    case OutputInterface::Transform::Flipped270:
+        unscaledSize.transpose();
+        break;
+    case OutputInterface::Transform::Normal:
+    case OutputInterface::Transform::Rotated180:
+    case OutputInterface::Transform::Flipped:
+    case OutputInterface::Transform::Flipped180:
+        break;
+    }
+    const QRect surfaceRect(QPoint(0, 0), current.size);
+    if (bufferSize != unscaledSize || (current.sourceGeometry.isValid() && current.sourceGeometry != QRectF(surfaceRect))) {
+        scanoutCandidate = Candidate::Scaled;
+        return;
+    }
+    // QRegion::contains() only checks for an overlap
+    if (current.buffer->hasAlphaChannel() && !QRegion(surfaceRect).subtracted(current.opaque).isEmpty()) {
+        scanoutCandidate = Candidate::Translucent;
+        return;
+    }
+    const EffectState *effects = current.effects.constData();
+    if (effects && (!effects->shadow.isNull() || !effects->blur.isNull() || !effects->contrast.isNull())) {
+        scanoutCandidate = Candidate::Effects;
+        return;
+    }
+    scanoutCandidate = Candidate::Candidate;
+}
+
+SurfaceInterface::ScanoutCandidate SurfaceInterface::scanoutCandidate(OutputInterface *output) const
+{
+    if (!isMapped()) {
+        return ScanoutCandidate::NoBuffer;
+    }
+    d->updateScanoutCandidate();
+    if (d->scanoutCandidate != ScanoutCandidate::Candidate || !output) {
+        return d->scanoutCandidate;
+    }
+    if (d->current.bufferTransform != output->transform()) {
+        return ScanoutCandidate::Transformed;
+    }
+    if (d->bufferSize != output->pixelSize()) {
+        return ScanoutCandidate::NotCoveringOutput;
+    }
+    return ScanoutCandidate::Candidate;
+}
+
 SurfaceInterface *SurfaceInterface::surfaceAt(const QPointF &position)
 {
     if (!isMapped()) {
         return nullptr;
     }
-    // go from top to bottom. Top most child is last in list
-    QListIterator<SubSurfaceInterface *> it(d->current.children);
-    it.toBack();
-    while (it.hasPrevious()) {
-        const auto &current = it.previous();
-        auto surface = current->surface();
-        if (auto s = surface->surfaceAt(position - current->position())) {
-            return s;
-        }
+    d->updatePickingCache();
+    if (!d->pickingBoundingRect.contains(position)) {
+        return nullptr;
     }
-    // check whether the geometry contains the pos
-    if (!size().isEmpty() && QRectF(QPoint(0, 0), size()).contains(position)) {
-        return this;
+    for (const SurfaceInterfacePrivate::PickingEntry &entry : qAsConst(d->pickingEntries)) {
+        // check whether the geometry contains the pos
+        if (entry.geometry.contains(position)) {
+            return entry.surface;
+        }
     }
     return nullptr;
 }
 
 SurfaceInterface *SurfaceInterface::inputSurfaceAt(const QPointF &position)
 {
-    // TODO: Most of this is very similar to SurfaceInterface::surfaceAt
-    //       Is there a way to reduce the code duplication?
     if (!isMapped()) {
         return nullptr;
     }
-
-    // casper_yang for scale
-    QPointF newPos = position /  d->inputAreaScale;
-
-    // go from top to bottom. Top most child is last in list
-    QListIterator<SubSurfaceInterface *> it(d->current.children);
-    it.toBack();
-    while (it.hasPrevious()) {
-        const auto &current = it.previous();
-        auto surface = current->surface();
-        if (auto s = surface->inputSurfaceAt(newPos - current->position())) {
-            return s;
+    d->updatePickingCache();
+    for (const SurfaceInterfacePrivate::PickingEntry &entry : qAsConst(d->pickingEntries)) {
+        // casper_yang for scale
+        const QPointF localPosition = position * entry.inputScale - entry.inputOffset;
+        // check whether the geometry and input region contain the pos
+        if (QRectF(QPointF(0, 0), entry.geometry.size()).contains(localPosition) &&
+                (entry.inputIsInfinite || entry.input.contains(localPosition.toPoint()))) {
+            return entry.surface;
         }
     }
-    // check whether the geometry and input region contain the pos
-    if (!size().isEmpty() && QRectF(QPoint(0, 0), size()).contains(newPos) &&
-            input().contains(newPos.toPoint())) {
-        return this;
-    }
     return nullptr;
 }
 
@@ -944,7 +1932,12 @@ ConfinedPointerV1Interface *SurfaceInterface::confinedPointer() const
 
 bool SurfaceInterface::inhibitsIdle() const
 {
-    return !d->idleInhibitors.isEmpty();
+    return d->inhibitsIdle;
+}
+
+bool SurfaceInterface::treeInhibitsIdle() const
+{
+    return d->treeIdleInhibitors > 0;
 }
 
 void SurfaceInterface::setDataProxy(SurfaceInterface *surface)
@@ -965,6 +1958,7 @@ void SurfaceInterface::setInputAreaScale(qreal scale)
         return;
     }
     d->inputAreaScale = scale;
+    d->invalidatePickingCache();
     emit inputAreaScaleChanged(scale);
 }
 
@@ -975,11 +1969,17 @@ qreal SurfaceInterface::getInputAreaScale()
 
 QPointF SurfaceInterface::mapToBuffer(const QPointF &point) const
 {
+    if (d->surfaceToBufferScale) {
+        return point * d->surfaceToBufferScale;
+    }
     return d->surfaceToBufferMatrix.map(point);
 }
 
 QPointF SurfaceInterface::mapFromBuffer(const QPointF &point) const
 {
+    if (d->surfaceToBufferScale) {
+        return point / d->surfaceToBufferScale;
+    }
     return d->bufferToSurfaceMatrix.map(point);
 }
 
@@ -994,11 +1994,37 @@ static QRegion map_helper(const QMatrix4x4 &matrix, const QRegion &region)
 
 QRegion SurfaceInterface::mapToBuffer(const QRegion &region) const
 {
+    const qint32 scale = d->surfaceToBufferScale;
+    if (scale == 1) {
+        return region;
+    } else if (scale) {
+        // Scaling all rects by the same integer factor keeps the region's band structure
+        QVector<QRect> rects;
+        rects.reserve(region.rectCount());
+        for (const QRect &rect : region) {
+            rects.append(QRect(rect.x() * scale, rect.y() * scale, rect.width() * scale, rect.height() * scale));
+        }
+        QRegion result;
+        result.setRects(rects.constData(), rects.count());
+        return result;
+    }
     return map_helper(d->surfaceToBufferMatrix, region);
 }
 
 QRegion SurfaceInterface::mapFromBuffer(const QRegion &region) const
 {
+    const qint32 scale = d->surfaceToBufferScale;
+    if (scale == 1) {
+        return region;
+    } else if (scale) {
+        // Rounding matches QMatrix4x4::mapRect(), rects may merge, so the region is rebuilt
+        QRegion result;
+        for (const QRect &rect : region) {
+            result += QRect(qRound(rect.x() / qreal(scale)), qRound(rect.y() / qreal(scale)),
+                            qRound(rect.width() / qreal(scale)), qRound(rect.height() / qreal(scale)));
+        }
+        return result;
+    }
     return map_helper(d->bufferToSurfaceMatrix, region);
 }
 
@@ -1007,17 +2033,23 @@ QMatrix4x4 SurfaceInterface::surfaceToBufferMatrix() const
     return d->surfaceToBufferMatrix;
 }
 
-void SurfaceInterface::handleBufferRemoved(BufferInterface *buffer)
+QRect SurfaceInterface::bufferSourceBox() const
 {
-    if (d->pending.buffer == buffer) {
-        d->pending.buffer = nullptr;
+    return d->bufferSourceBox;
+}
+
+void SurfaceInterfacePrivate::bufferDestroyed(BufferInterface *buffer)
+{
+    if (pending.buffer == buffer) {
+        pending.buffer = nullptr;
     }
-    if (d->cached.buffer == buffer) {
-        d->cached.buffer = nullptr;
+    if (cached.buffer == buffer) {
+        cached.buffer = nullptr;
     }
-    if (d->current.buffer == buffer) {
-        d->current.buffer->unref();
-        d->current.buffer = nullptr;
+    if (current.buffer == buffer) {
+        current.buffer->unref();
+        current.buffer = nullptr;
+        invalidateRenderList();
     }
 }
 
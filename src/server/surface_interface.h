@@ -16,6 +16,8 @@
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
+#include <functional>
+
 namespace KWaylandServer
 {
 class BlurInterface;
@@ -23,12 +25,77 @@ class BufferInterface;
 class ConfinedPointerV1Interface;
 class ContrastInterface;
 class CompositorInterface;
+enum class ContentType;
 class LockedPointerV1Interface;
+enum class PresentationHint;
+struct PresentationTime;
+struct LinuxDrmSyncObjPointV1;
 class ShadowInterface;
 class SlideInterface;
 class SubSurfaceInterface;
+class SurfaceCommitObserver;
+class SurfaceInterface;
 class SurfaceInterfacePrivate;
 
+/**
+ * @brief Commit and frame pacing counters of one surface.
+ *
+ * The counters are collected while a statistics interval is set and accumulate until
+ * SurfaceInterface::resetStatistics() is called.
+ *
+ * @see SurfaceInterface::setStatisticsInterval
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT SurfaceStatistics
+{
+    quint64 commits = 0;
+    /**
+     * The commits per second during the last statistics interval.
+     **/
+    qreal commitsPerSecond = 0;
+    /**
+     * The sum of the damaged areas of all commits, in surface-local pixels.
+     **/
+    quint64 damagedPixels = 0;
+    QSize bufferSize;
+    /**
+     * The number of frameRendered() calls which completed at least one commit.
+     **/
+    quint64 frames = 0;
+    /**
+     * The time between the first commit not rendered yet and frameRendered(), in nanoseconds:
+     * the latest one, the longest one and the sum of all of them.
+     **/
+    qint64 lastFrameLatency = 0;
+    qint64 maximumFrameLatency = 0;
+    qint64 totalFrameLatency = 0;
+    /**
+     * The frame callbacks the server completed on its own because the surface was occluded
+     * or had too many pending frame callbacks.
+     **/
+    quint64 missedFrameCallbacks = 0;
+};
+
+/**
+ * @brief A mapped surface of a sub-surface tree, as drawn by the compositor.
+ *
+ * @see SurfaceInterface::renderList
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT SurfaceRenderEntry
+{
+    SurfaceInterface *surface = nullptr;
+    /**
+     * The position of the surface relative to the main surface of the tree.
+     **/
+    QPoint offset;
+    BufferInterface *buffer = nullptr;
+    /**
+     * The opaque region of the surface, relative to the main surface of the tree.
+     **/
+    QRegion opaque;
+};
+
 /**
  * @brief Resource representing a wl_surface.
  *
@@ -73,6 +140,58 @@ class KWAYLANDSERVER_EXPORT SurfaceInterface : public QObject
     Q_PROPERTY(KWaylandServer::OutputInterface::Transform bufferTransform READ bufferTransform NOTIFY bufferTransformChanged)
     Q_PROPERTY(QSize size READ size NOTIFY sizeChanged)
 public:
+    /**
+     * The effect objects a client can attach to a surface.
+     * @see effectsChanged
+     * @since 5.22
+     **/
+    enum class Effect {
+        Shadow = 1 << 0,
+        Blur = 1 << 1,
+        Contrast = 1 << 2,
+        SlideOnShowHide = 1 << 3,
+    };
+    Q_DECLARE_FLAGS(Effects, Effect)
+
+    /**
+     * Whether the buffer of a surface can be scanned out directly, otherwise the first reason
+     * found against it.
+     * @see scanoutCandidate
+     * @since 5.22
+     **/
+    enum class ScanoutCandidate {
+        Candidate,
+        /**
+         * The surface is not mapped.
+         **/
+        NoBuffer,
+        NotDmabuf,
+        /**
+         * A sub-surface with a buffer is mapped on top of or below the surface.
+         **/
+        SubSurfaces,
+        /**
+         * The buffer is scaled or cropped by the buffer scale or a viewport.
+         **/
+        Scaled,
+        /**
+         * The buffer has an alpha channel and the opaque region doesn't cover the surface.
+         **/
+        Translucent,
+        /**
+         * A shadow, blur or contrast is attached to the surface.
+         **/
+        Effects,
+        /**
+         * The buffer transform differs from the transform of the output.
+         **/
+        Transformed,
+        /**
+         * The buffer is not as large as the pixel size of the output.
+         **/
+        NotCoveringOutput,
+    };
+
     explicit SurfaceInterface(CompositorInterface *compositor, wl_resource *resource);
     ~SurfaceInterface() override;
 
@@ -94,7 +213,8 @@ public:
     CompositorInterface *compositor() const;
 
     /**
-     * Returns a list with all created Wayland surfaces.
+     * Returns a list with all created Wayland surfaces, in the order they were created.
+     * The list is built on every call, prefer get() to find a specific surface.
      */
     static QList<SurfaceInterface *> surfaces();
 
@@ -157,13 +277,168 @@ public:
      * @since 5.20
      */
     QMatrix4x4 surfaceToBufferMatrix() const;
+    /**
+     * Returns the part of the buffer shown by the surface, in buffer pixel coordinates, with the
+     * buffer scale, the buffer transform and the viewport applied. Compositors cropping the
+     * buffer on a hardware plane can use it as it is, it's only computed again when the buffer
+     * size or one of them changes.
+     *
+     * If the crop doesn't fall on pixel boundaries, e.g. because of a fractional viewport source
+     * rectangle, or there is no buffer, a null rect is returned.
+     *
+     * @see surfaceToBufferMatrixChanged()
+     * @since 5.22
+     */
+    QRect bufferSourceBox() const;
 
     void frameRendered(quint32 msec);
+    /**
+     * Reports that the current state of this surface and its sub-surfaces was presented on
+     * @p output at the given @p time. The presentation feedback the client requested for it is
+     * sent and destroyed, the feedback of later commits is reported with their own
+     * presentation. @p output may be @c null if the surface isn't on any output.
+     *
+     * @see PresentationInterface
+     * @since 5.22
+     **/
+    void presented(OutputInterface *output, const PresentationTime &time);
+    /**
+     * Reports that the current state of this surface and its sub-surfaces won't be presented,
+     * e.g. because the surface got hidden.
+     *
+     * @see PresentationInterface
+     * @since 5.22
+     **/
+    void discardPresentationFeedback();
     bool hasFrameCallbacks() const;
 
+    /**
+     * Sets the maximum number of frame callbacks the client may have committed for this surface
+     * without the compositor calling frameRendered(). Callbacks which are requested but not
+     * committed yet, or held in the cache of a synchronized sub-surface, don't count. Once the
+     * limit is exceeded, the server completes the callbacks on its own and the surface becomes
+     * throttled.
+     *
+     * A @p count of @c 0 disables the limit. The default is @c 500.
+     *
+     * @see areFrameCallbacksThrottled()
+     * @since 5.22
+     */
+    void setMaximumPendingFrameCallbacks(int count);
+    /**
+     * @see setMaximumPendingFrameCallbacks()
+     * @since 5.22
+     */
+    int maximumPendingFrameCallbacks() const;
+    /**
+     * Sets the number of damage rectangles the client may send between two commits before
+     * they are replaced with their bounding rectangle. Damage rectangles are only united when
+     * the surface gets committed, so a client sending many small rectangles costs little, but
+     * their count has to be bounded.
+     *
+     * A @p count of @c 0 disables the limit. The default is @c 1024.
+     *
+     * @since 5.22
+     */
+    void setMaximumDamageRects(int count);
+    /**
+     * @see setMaximumDamageRects()
+     * @since 5.22
+     */
+    int maximumDamageRects() const;
+    /**
+     * Sets the interval in milliseconds at which the frame callbacks of an occluded surface
+     * are completed by the server. An interval of @c 0 means the frame callbacks of an occluded
+     * surface are only completed when the pending frame callback limit is hit.
+     *
+     * The default is @c 1000.
+     *
+     * @see setOccluded()
+     * @since 5.22
+     */
+    void setFrameCallbackIdleInterval(int msec);
+    /**
+     * @see setFrameCallbackIdleInterval()
+     * @since 5.22
+     */
+    int frameCallbackIdleInterval() const;
+    /**
+     * Marks the surface as @p occluded. The compositor is not going to render an occluded
+     * surface, so its frame callbacks are completed by the server at the frame callback idle
+     * interval instead. An occluded surface is always throttled and its idle inhibitors have
+     * no effect.
+     *
+     * @see setFrameCallbackIdleInterval(), areFrameCallbacksThrottled()
+     * @since 5.22
+     */
+    void setOccluded(bool occluded);
+    /**
+     * @see setOccluded()
+     * @since 5.22
+     */
+    bool isOccluded() const;
+    /**
+     * Returns @c true if the frame callbacks of this surface are completed by the server rather
+     * than by the compositor calling frameRendered(). The surface stops being throttled as soon
+     * as the compositor renders it while it is not occluded.
+     *
+     * @see frameCallbacksThrottledChanged()
+     * @since 5.22
+     */
+    bool areFrameCallbacksThrottled() const;
+
+    /**
+     * Sets the interval in milliseconds at which statisticsUpdated() is emitted. The
+     * statistics are only collected while the interval is set, the default @c 0 disables them.
+     *
+     * Only this surface is accounted, its sub-surfaces have their own statistics.
+     *
+     * @see statistics()
+     * @since 5.22
+     */
+    void setStatisticsInterval(int msec);
+    /**
+     * @see setStatisticsInterval()
+     * @since 5.22
+     */
+    int statisticsInterval() const;
+    /**
+     * @returns The statistics collected since the interval got set or resetStatistics().
+     * @since 5.22
+     */
+    SurfaceStatistics statistics() const;
+    /**
+     * Clears the statistics.
+     * @since 5.22
+     */
+    void resetStatistics();
+
+    /**
+     * Registers @p observer to be called once for every commit applied to the current state
+     * of this surface, after all change signals of the commit were emitted. The observer is
+     * not owned, it has to be removed with removeCommitObserver() before it's destroyed, and
+     * it isn't called anymore once the surface is destroyed.
+     *
+     * @see SurfaceCommitObserver
+     * @since 5.22
+     */
+    void addCommitObserver(SurfaceCommitObserver *observer);
+    /**
+     * Stops calling @p observer, it may be removed from within its own callback.
+     * @since 5.22
+     */
+    void removeCommitObserver(SurfaceCommitObserver *observer);
+
     QRegion damage() const;
     QRegion opaque() const;
     QRegion input() const;
+    /**
+     * Returns @c true if the client didn't set an input region, the whole surface accepts
+     * input then. Hit-testing can check the geometry of the surface alone in this case, input()
+     * is just its rectangle.
+     * @since 5.22
+     **/
+    bool inputIsInfinite() const;
     qint32 bufferScale() const;
     /**
      * Returns the buffer transform that had been applied to the buffer to compensate for
@@ -178,6 +453,39 @@ public:
      **/
     BufferInterface *buffer();
     QPoint offset() const;
+    /**
+     * Returns the kind of content the client shows on this surface, by default ContentType::None.
+     *
+     * @see ContentTypeManagerV1Interface
+     * @see contentTypeChanged
+     * @since 5.22
+     **/
+    ContentType contentType() const;
+    /**
+     * Returns whether the client accepts tearing for a lower latency, by default
+     * PresentationHint::VSync.
+     *
+     * @see TearingControlManagerV1Interface
+     * @see presentationHintChanged
+     * @since 5.22
+     **/
+    PresentationHint presentationHint() const;
+    /**
+     * Returns the point the compositor has to wait for before it reads the current buffer.
+     * The point is invalid if the client doesn't synchronize the buffer explicitly.
+     *
+     * @see LinuxDrmSyncObjManagerV1Interface
+     * @since 5.22
+     **/
+    LinuxDrmSyncObjPointV1 acquirePoint() const;
+    /**
+     * Returns the point the compositor has to signal once it doesn't use the current buffer
+     * anymore. The point is invalid if the client doesn't synchronize the buffer explicitly.
+     *
+     * @see LinuxDrmSyncObjManagerV1Interface
+     * @since 5.22
+     **/
+    LinuxDrmSyncObjPointV1 releasePoint() const;
     /**
      * Returns the current size of the surface, in surface coordinates.
      *
@@ -272,6 +580,64 @@ public:
      **/
     void resetTrackedDamage();
 
+    /**
+     * Returns the sequence number of the current buffer. It is incremented whenever a buffer
+     * gets committed, @c 0 means no buffer has been committed yet.
+     *
+     * Unlike trackedDamage(), the damage history serves any number of consumers: a renderer
+     * stores the sequence number it last painted the surface with, e.g. per output or per back
+     * buffer, and asks for damageSince() that sequence number the next time.
+     *
+     * @see damageSince
+     * @since 5.22
+     **/
+    quint64 damageSequence() const;
+
+    /**
+     * Returns the damage of all buffers committed after the buffer with the given @p sequence
+     * number, in surface-local coordinates. If @p sequence is older than the damage history,
+     * the whole surface is returned.
+     *
+     * A buffer of a different size or with a different buffer scale, transform or viewport
+     * counts as damaging the whole surface.
+     *
+     * @see damageSequence
+     * @see setDamageHistorySize
+     * @since 5.22
+     **/
+    QRegion damageSince(quint64 sequence) const;
+
+    /**
+     * Sets the number of buffer commits whose damage is kept, e.g. the number of back buffers
+     * of a renderer using the buffer age. The default is @c 8.
+     *
+     * @since 5.22
+     **/
+    void setDamageHistorySize(int size);
+    /**
+     * @see setDamageHistorySize
+     * @since 5.22
+     **/
+    int damageHistorySize() const;
+
+    /**
+     * Invokes @p callback for every damaged row span of the attached shared memory buffer.
+     *
+     * The spans are computed from trackedDamage() mapped to buffer coordinates with mapToBuffer()
+     * and clipped to the size of the buffer. The callback receives the span in buffer pixel
+     * coordinates and a pointer to its first byte in the client's shared memory, which is only
+     * valid during the callback. A compositor can use this to upload only the changed bytes of
+     * the buffer instead of touching the whole shared memory mapping.
+     *
+     * This does not reset the tracked damage, call resetTrackedDamage() once done.
+     *
+     * @returns @c false if no shared memory buffer is attached or it cannot be accessed
+     * @see BufferInterface::forEachSpan
+     * @see trackedDamage
+     * @since 5.22
+     **/
+    bool forEachDamagedSpan(const std::function<void(const QRect &span, const uchar *bits)> &callback);
+
     /**
      * Finds the SurfaceInterface at the given @p position in surface-local coordinates.
      * This can be either a descendant SurfaceInterface honoring the stacking order or
@@ -301,11 +667,45 @@ public:
      **/
     SurfaceInterface *inputSurfaceAt(const QPointF &position);
 
+    /**
+     * The mapped surfaces of the sub-surface tree of this SurfaceInterface with a buffer
+     * attached, including this SurfaceInterface itself, in stacking order from bottom to top.
+     *
+     * The list is cached and only rebuilt after the tree, the position of a sub-surface or the
+     * buffer or opaque region of one of its surfaces changed, so a compositor can call it for
+     * each frame instead of walking childSubSurfaces() itself. It's empty while this
+     * SurfaceInterface is unmapped.
+     *
+     * @see subSurfaceTreeChanged
+     * @since 5.22
+     **/
+    QVector<SurfaceRenderEntry> renderList() const;
+
+    /**
+     * Checks whether the buffer of this SurfaceInterface can be scanned out directly on
+     * @p output instead of being composited, e.g. for a fullscreen game or video.
+     *
+     * This requires a mapped dmabuf buffer without mapped sub-surfaces, which is neither
+     * scaled nor cropped, is opaque, has no shadow, blur or contrast, has the transform of
+     * @p output and is as large as its pixel size. The output checks are left out if
+     * @p output is @c nullptr. Whether a plane supports the format and modifier of the
+     * buffer is up to the compositor.
+     *
+     * The checks of the surface itself are cached until a commit changes their inputs, so
+     * a compositor can call this for each frame.
+     *
+     * @see ScanoutCandidate
+     * @since 5.22
+     **/
+    ScanoutCandidate scanoutCandidate(OutputInterface *output) const;
+
     /**
      * Sets the @p outputs this SurfaceInterface overlaps with, may be empty.
      *
      * The compositor should update whenever the SurfaceInterface becomes visible on
-     * an OutputInterface by e.g. getting (un)mapped, resized, moved, etc.
+     * an OutputInterface by e.g. getting (un)mapped, resized, moved, etc. Only the outputs
+     * which were entered or left are announced to the client, nothing is sent and the
+     * sub-surfaces are not updated if the outputs didn't change.
      *
      * @see outputs
      * @since 5.27
@@ -319,6 +719,18 @@ public:
      **/
     QVector<OutputInterface *> outputs() const;
 
+    /**
+     * Sets the fractional @p scale the client should render this surface and its sub-surfaces
+     * at, typically the largest scale of the outputs the surface is on. Clients which support
+     * fractional scales are told about it through a wp_fractional_scale_v1, the others keep
+     * following the integer scale of the outputs. The default is @c 1.
+     *
+     * @see FractionalScaleManagerV1Interface
+     * @since 5.22
+     **/
+    void setPreferredScale(qreal scale);
+    qreal preferredScale() const;
+
     /**
      * Pointer confinement installed on this SurfaceInterface.
      * @see pointerConstraintsChanged
@@ -335,10 +747,26 @@ public:
 
     /**
      * @returns Whether this SurfaceInterface wants idle to be inhibited on the Output it is shown
+     *
+     * An idle inhibitor only takes effect while the surface is visible, an occluded surface,
+     * e.g. a minimized or fully covered window, does not inhibit idle.
      * @see inhibitsIdleChanged
+     * @see setOccluded
      * @since 5.41
      **/
     bool inhibitsIdle() const;
+    /**
+     * @returns Whether this SurfaceInterface or any surface of its sub-surface tree inhibits idle,
+     * e.g. a video player with the inhibitor on the sub-surface showing the video.
+     *
+     * The number of inhibiting surfaces is counted per tree and updated as inhibitors come and
+     * go, surfaces get occluded and sub-surfaces are added or removed, so this doesn't walk
+     * the tree.
+     * @see inhibitsIdle
+     * @see treeInhibitsIdleChanged
+     * @since 5.22
+     **/
+    bool treeInhibitsIdle() const;
 
     /**
      * @returns The SurfaceInterface for the @p native resource.
@@ -431,6 +859,8 @@ Q_SIGNALS:
      **/
     void shadowChanged();
     /**
+     * Emitted when the blur() of the surface changed. A new blur object with the same region
+     * as the previous one is not reported.
      * @since 5.5
      **/
     void blurChanged();
@@ -439,9 +869,18 @@ Q_SIGNALS:
      **/
     void slideOnShowHideChanged();
     /**
+     * Emitted when the contrast() of the surface changed. A new contrast object with the same
+     * region and parameters as the previous one is not reported.
      * @since 5.5
      **/
     void contrastChanged();
+    /**
+     * Emitted once per commit which changed any of the shadow(), blur(), contrast() or
+     * slideOnShowHide() of the surface, after the signals of the individual effects. A
+     * compositor re-evaluating its effects on this signal does it once for all of them.
+     * @since 5.22
+     **/
+    void effectsChanged(KWaylandServer::SurfaceInterface::Effects effects);
     /**
      * Emitted whenever the tree of sub-surfaces changes in a way which requires a repaint.
      * @since 5.22
@@ -476,6 +915,12 @@ Q_SIGNALS:
      * @since 5.41
      **/
     void inhibitsIdleChanged();
+    /**
+     * Emitted whenever the sub-surface tree of this SurfaceInterface starts/ends to inhibit idle.
+     * @see treeInhibitsIdle
+     * @since 5.22
+     **/
+    void treeInhibitsIdleChanged();
 
     /**
      * Emitted when the Surface has been committed.
@@ -486,15 +931,115 @@ Q_SIGNALS:
      **/
     void committed();
 
-private:
-    void handleBufferRemoved(BufferInterface *buffer);
+    /**
+     * Emitted on a main surface once a commit has been applied to it or to any surface of its
+     * sub-surface tree, after all change signals and committed() of that commit. The states of
+     * the surface, of its synchronized sub-surfaces and of their roles are applied together, so
+     * the compositor needs to repaint only once per emission rather than once per surface.
+     *
+     * A synchronized sub-surface committing its state only caches it, which doesn't emit this
+     * signal until the parent surface gets committed.
+     *
+     * @see committed
+     * @since 5.22
+     **/
+    void treeCommitted();
+
+    /**
+     * Emitted whenever the surface enters or leaves the throttled frame callback state.
+     * @see areFrameCallbacksThrottled
+     * @since 5.22
+     **/
+    void frameCallbacksThrottledChanged();
+    /**
+     * Emitted every statisticsInterval() milliseconds with the current @p statistics.
+     * @see setStatisticsInterval
+     * @since 5.22
+     **/
+    void statisticsUpdated(const KWaylandServer::SurfaceStatistics &statistics);
 
+    /**
+     * Emitted when a commit changed the content type of this surface.
+     * @see contentType
+     * @since 5.22
+     **/
+    void contentTypeChanged();
+    /**
+     * Emitted when a commit changed the presentation hint of this surface.
+     * @see presentationHint
+     * @since 5.22
+     **/
+    void presentationHintChanged();
+
+private:
     QScopedPointer<SurfaceInterfacePrivate> d;
     friend class SurfaceInterfacePrivate;
 };
 
+/**
+ * @brief What a commit changed in the current state of a SurfaceInterface.
+ *
+ * @see SurfaceCommitObserver
+ * @since 5.22
+ **/
+struct KWAYLANDSERVER_EXPORT SurfaceCommitInfo
+{
+    enum class Change {
+        Opaque = 1 << 0,
+        Input = 1 << 1,
+        BufferScale = 1 << 2,
+        BufferTransform = 1 << 3,
+        ContentType = 1 << 4,
+        PresentationHint = 1 << 5,
+        Mapped = 1 << 6,
+        Unmapped = 1 << 7,
+        Damage = 1 << 8,
+        SurfaceToBufferMatrix = 1 << 9,
+        BufferSize = 1 << 10,
+        Size = 1 << 11,
+        Effects = 1 << 12,
+        SubSurfaceTree = 1 << 13,
+    };
+    Q_DECLARE_FLAGS(Changes, Change)
+
+    Changes changes;
+    /**
+     * The damage of the commit in surface-local coordinates, set along with Change::Damage.
+     **/
+    QRegion damage;
+    /**
+     * The effects which changed, set along with Change::Effects.
+     **/
+    SurfaceInterface::Effects effects;
+};
+
+/**
+ * @brief Receives the commits of a SurfaceInterface with a single virtual call.
+ *
+ * A compositor tracking many surfaces can register an observer with
+ * SurfaceInterface::addCommitObserver() instead of connecting to a dozen signals of each
+ * surface. The observer is called once per applied commit with the mask of what changed,
+ * the individual signals are still emitted before it. The damage of a commit held back by
+ * the commit rate limit is reported in a separate call once the limit releases it.
+ *
+ * All methods are called from the thread dispatching the Display.
+ *
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT SurfaceCommitObserver
+{
+public:
+    virtual ~SurfaceCommitObserver();
+
+    virtual void surfaceCommitted(SurfaceInterface *surface, const SurfaceCommitInfo &info) = 0;
+};
+
 }
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::SurfaceInterface::Effects)
+Q_DECLARE_OPERATORS_FOR_FLAGS(KWaylandServer::SurfaceCommitInfo::Changes)
 Q_DECLARE_METATYPE(KWaylandServer::SurfaceInterface*)
+Q_DECLARE_METATYPE(KWaylandServer::SurfaceInterface::Effects)
+Q_DECLARE_METATYPE(KWaylandServer::SurfaceStatistics)
 
 #endif
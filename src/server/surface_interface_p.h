@@ -8,9 +8,20 @@
 #define WAYLAND_SERVER_SURFACE_INTERFACE_P_H
 
 #include "surface_interface.h"
+#include "buffer_interface_p.h"
+#include "clientconnection_p.h"
+#include "contenttype_v1_interface.h"
+#include "eventlooptimer_p.h"
+#include "linuxdrmsyncobj_v1_interface.h"
+#include "presentation_interface_p.h"
+#include "rectaccumulator_p.h"
+#include "tearingcontrol_v1_interface.h"
 #include "utils.h"
 // Qt
+#include <QElapsedTimer>
 #include <QHash>
+#include <QSharedData>
+#include <QTimer>
 #include <QVector>
 // Wayland
 #include "qwayland-server-wayland.h"
@@ -18,57 +29,118 @@
 namespace KWaylandServer
 {
 
+class ContentTypeV1Interface;
+class FractionalScaleV1Interface;
 class IdleInhibitorV1Interface;
+class LinuxDrmSyncObjSurfaceV1Interface;
+class SurfaceInterfacePrivate;
 class SurfaceRole;
+class TearingControlV1Interface;
 class ViewportInterface;
 
-class KWaylandFrameCallback : public QtWaylandServer::wl_callback
+/**
+ * Intrusive list of wl_callback resources requested with wl_surface.frame.
+ *
+ * The callbacks are linked through the link of their wl_resource, so no wrapper object has to
+ * be allocated per frame callback. A destroyed callback unlinks itself from whatever list it
+ * is in and updates the pending frame callback count of its surface and client. The callbacks
+ * belong to exactly one list, so a list can't be copied, use takeFrom() to move callbacks
+ * between lists.
+ */
+class FrameCallbackList
 {
 public:
-    KWaylandFrameCallback(wl_resource *resource, SurfaceInterface *surface);
+    FrameCallbackList();
+    ~FrameCallbackList();
 
-    void destroy();
+    bool isEmpty() const;
+    int count() const;
 
-    QPointer<SurfaceInterface> surface;
+    /**
+     * Appends the @p callback, it is accounted as pending frame callback of @p surface and
+     * the client owning it.
+     */
+    void append(wl_resource *callback, SurfaceInterfacePrivate *surface);
+    /**
+     * Moves all callbacks of @p other to the end of this list.
+     */
+    void takeFrom(FrameCallbackList *other);
+    /**
+     * Sends the done event with the given @p msec timestamp to all callbacks and destroys them.
+     */
+    void sendDone(quint32 msec);
+    void destroyAll();
 
-protected:
-    void callback_destroy_resource(Resource *resource) override;
+private:
+    static void destroyCallback(wl_resource *callback);
+
+    wl_list m_list;
+
+    Q_DISABLE_COPY(FrameCallbackList)
 };
 
-class SurfaceInterfacePrivate : public QtWaylandServer::wl_surface
+class SurfaceInterfacePrivate : public QtWaylandServer::wl_surface, public BufferDestroyObserver
 {
 public:
+    /**
+     * The effect objects of a state, shared between the states until one of them changes.
+     */
+    struct EffectState : public QSharedData {
+        QPointer<ShadowInterface> shadow;
+        QPointer<BlurInterface> blur;
+        QPointer<ContrastInterface> contrast;
+        QPointer<SlideInterface> slide;
+    };
+
     struct State {
+        /**
+         * The properties a client has set since the state was last applied. Only the
+         * properties flagged here are moved to the next state on commit, all other fields
+         * of a pending or cached state may hold stale values and must not be read.
+         */
+        enum Change : quint32 {
+            BufferChanged = 1 << 0,
+            OpaqueChanged = 1 << 1,
+            InputChanged = 1 << 2,
+            SourceGeometryChanged = 1 << 3,
+            DestinationSizeChanged = 1 << 4,
+            ShadowChanged = 1 << 5,
+            BlurChanged = 1 << 6,
+            ContrastChanged = 1 << 7,
+            SlideChanged = 1 << 8,
+            ChildrenChanged = 1 << 9,
+            BufferScaleChanged = 1 << 10,
+            BufferTransformChanged = 1 << 11,
+            ContentTypeChanged = 1 << 12,
+            PresentationHintChanged = 1 << 13,
+        };
+        Q_DECLARE_FLAGS(Changes, Change)
+
+        Changes changes;
         QRegion damage = QRegion();
         QRegion bufferDamage = QRegion();
         QRegion opaque = QRegion();
-        QRegion input = infiniteRegion();
+        // without an explicit input region the whole surface accepts input, input is empty then
+        QRegion input = QRegion();
+        bool inputIsInfinite = true;
         QRectF sourceGeometry = QRectF();
         QSize destinationSize = QSize();
         QSize size = QSize();
-        bool sourceGeometryIsSet = false;
-        bool destinationSizeIsSet = false;
-        bool inputIsSet = false;
-        bool opaqueIsSet = false;
-        bool bufferIsSet = false;
-        bool shadowIsSet = false;
-        bool blurIsSet = false;
-        bool contrastIsSet = false;
-        bool slideIsSet = false;
-        bool childrenChanged = false;
-        bool bufferScaleIsSet = false;
-        bool bufferTransformIsSet = false;
         qint32 bufferScale = 1;
         OutputInterface::Transform bufferTransform = OutputInterface::Transform::Normal;
-        QList<KWaylandFrameCallback *> frameCallbacks;
+        ContentType contentType = ContentType::None;
+        PresentationHint presentationHint = PresentationHint::VSync;
+        FrameCallbackList frameCallbacks;
+        PresentationFeedbackList presentationFeedback;
         QPoint offset = QPoint();
         BufferInterface *buffer = nullptr;
+        // the explicit synchronization points of the buffer, set along with it
+        LinuxDrmSyncObjPointV1 acquirePoint;
+        LinuxDrmSyncObjPointV1 releasePoint;
         // stacking order: bottom (first) -> top (last)
         QList<SubSurfaceInterface *> children;
-        QPointer<ShadowInterface> shadow;
-        QPointer<BlurInterface> blur;
-        QPointer<ContrastInterface> contrast;
-        QPointer<SlideInterface> slide;
+        // null as long as the client didn't set any effect, which most never do
+        QSharedDataPointer<EffectState> effects;
     };
 
     static SurfaceInterfacePrivate *get(SurfaceInterface *surface) { return surface->d.data(); }
@@ -87,10 +159,123 @@ public:
     void installPointerConstraint(LockedPointerV1Interface *lock);
     void installPointerConstraint(ConfinedPointerV1Interface *confinement);
     void installIdleInhibitor(IdleInhibitorV1Interface *inhibitor);
+    void updateInhibitsIdle();
+    /**
+     * Adds @p delta to the inhibiting surfaces of the tree of this surface and of all its parents.
+     */
+    void addTreeIdleInhibitors(int delta);
 
     void commit();
+    /**
+     * Sends the done event to the frame callbacks of this surface and its sub-surfaces without
+     * flushing the client. Returns @c true if any done event has been sent.
+     */
+    bool sendFrameCallbacks(quint32 msec);
+    /**
+     * Sends the presentation feedback of the current state of this surface and its sub-surfaces
+     * without flushing the client. A null @p time discards the feedback.
+     */
+    void sendPresentationFeedback(OutputInterface *output, const PresentationTime *time);
+    /**
+     * Completes the frame callbacks on behalf of the compositor, the surface is considered
+     * throttled until the compositor calls frameRendered() for a visible surface again.
+     */
+    void throttleFrameCallbacks();
+    /**
+     * Emits the merged damaged() and committed() signals of the commits held back by the
+     * commit rate limit of the client.
+     */
+    void flushThrottledCommit();
+    void updateStatistics();
+    void setFrameCallbacksThrottled(bool throttled);
+    void updateOccludedFrameTimer();
     QMatrix4x4 buildSurfaceToBufferMatrix(const State *state);
+    void validateViewport(const State *state);
+    /**
+     * Rebuilds the surface-to-buffer matrix if any of its inputs in @p state has changed.
+     */
+    void updateSurfaceToBufferMatrix(const State *state);
     void swapStates(State *source, State *target, bool emitChanged);
+    /**
+     * Moves @p source into @p target, which must not hold any state that hasn't been applied
+     * yet, e.g. the cached state of a synchronized sub-surface after it has been applied. The
+     * fields are swapped, no region or list is copied. @p source is left with the stale fields
+     * of @p target, which are ignored until their change flag gets set again.
+     */
+    void moveState(State *source, State *target);
+    void resetAccumulatedState(State *state);
+    void commitPointerConstraints();
+    /**
+     * What changed when a state got applied to the current state, used to emit the change
+     * signals after the whole sub-surface tree has been updated.
+     */
+    struct AppliedChanges {
+        bool opaqueChanged = false;
+        bool inputChanged = false;
+        bool bufferScaleChanged = false;
+        bool bufferTransformChanged = false;
+        bool contentTypeChanged = false;
+        bool presentationHintChanged = false;
+        bool visibilityChanged = false;
+        bool damaged = false;
+        bool surfaceToBufferMatrixChanged = false;
+        bool bufferSizeChanged = false;
+        bool sizeChanged = false;
+        SurfaceInterface::Effects effectsChanged;
+        bool childrenChanged = false;
+    };
+    /**
+     * Moves @p source into @p target like swapStates() without emitting any signal. The
+     * returned changes are only filled in if @p emitChanged is set, i.e. @p target is current.
+     */
+    AppliedChanges applyState(State *source, State *target, bool emitChanged);
+    void emitChanges(const AppliedChanges &applied);
+    void notifyCommitObservers(const SurfaceCommitInfo &info);
+    /**
+     * The blur or contrast parameters the compositor got notified about last, setting a new
+     * blur or contrast object with the same parameters is not reported as a change.
+     */
+    struct EffectParameters {
+        bool isSet = false;
+        QRegion region;
+        qreal contrast = 0;
+        qreal intensity = 0;
+        qreal saturation = 0;
+
+        bool operator==(const EffectParameters &other) const
+        {
+            return isSet == other.isSet && region == other.region && contrast == other.contrast
+                && intensity == other.intensity && saturation == other.saturation;
+        }
+        bool operator!=(const EffectParameters &other) const
+        {
+            return !(*this == other);
+        }
+    };
+    static EffectParameters effectParameters(BlurInterface *blur);
+    static EffectParameters effectParameters(ContrastInterface *contrast);
+    /**
+     * Reports the release point of the buffer of @p state, which never became current.
+     */
+    void dropReleasePoint(const State *state);
+    /**
+     * Marks the cached picking data of this surface and all its ancestors as outdated.
+     */
+    void invalidatePickingCache();
+    void updatePickingCache();
+    /**
+     * Marks the render list of this surface and all its ancestors as outdated.
+     **/
+    void invalidateRenderList();
+    void updateRenderList();
+    /**
+     * Rebuilds the cached scanout checks which don't depend on the output.
+     */
+    void updateScanoutCandidate();
+    /**
+     * Attributes the regions of all states to the client.
+     */
+    void updateMemoryUsage();
 
     // casper_yang for scale
     qreal inputAreaScale = 1;
@@ -103,11 +288,43 @@ public:
     State current;
     State pending;
     State cached;
+    EffectParameters notifiedBlur;
+    EffectParameters notifiedContrast;
+    // the damage requested since the last commit, added to the pending state on commit
+    RectAccumulator pendingDamage;
+    RectAccumulator pendingBufferDamage;
     SubSurfaceInterface *subSurface = nullptr;
     QRegion trackedDamage;
+    /**
+     * Remembers the damage of a committed buffer.
+     */
+    void recordDamage(const QRegion &damage);
+    // the damage of the last buffer commits, indexed by their sequence number modulo the size
+    QVector<QRegion> damageHistory = QVector<QRegion>(8);
+    quint64 damageSequence = 0;
+    /**
+     * The inputs the surface-to-buffer matrix has been built from.
+     */
+    struct SurfaceToBufferMatrixKey {
+        bool hasBuffer = false;
+        QSize bufferSize;
+        qint32 bufferScale = 1;
+        OutputInterface::Transform bufferTransform = OutputInterface::Transform::Normal;
+        QRectF sourceGeometry;
+        QSize size;
+
+        bool operator==(const SurfaceToBufferMatrixKey &other) const;
+        bool operator!=(const SurfaceToBufferMatrixKey &other) const { return !(*this == other); }
+    };
+    SurfaceToBufferMatrixKey surfaceToBufferMatrixKey;
     QMatrix4x4 surfaceToBufferMatrix;
     QMatrix4x4 bufferToSurfaceMatrix;
+    // the surface mapped to the buffer, if it's on pixel boundaries
+    QRect bufferSourceBox;
+    // The scale factor if the surface-to-buffer matrix is a plain integer scale, 0 otherwise.
+    qint32 surfaceToBufferScale = 1;
     QSize bufferSize;
+    // the input region of the current state clipped to the surface, empty while it's infinite
     QRegion inputRegion;
 
     // workaround for https://bugreports.qt.io/browse/QTBUG-52192
@@ -116,22 +333,86 @@ public:
     // waiting on the frame callback of the never visible surface
     bool subSurfaceIsMapped = true;
 
+    // frame callbacks of the pending, cached and current state
+    int pendingFrameCallbacks = 0;
+    // frame callbacks of the current state, committed but not completed yet
+    int committedFrameCallbacks = 0;
+    int maximumPendingFrameCallbacks = 500;
+    int frameCallbackIdleInterval = 1000;
+    bool occluded = false;
+    bool frameCallbacksThrottled = false;
+    QScopedPointer<EventLoopTimer> occludedFrameTimer;
+
+    SurfaceStatistics statistics;
+    QTimer *statisticsTimer = nullptr;
+    quint64 commitsAtStatisticsInterval = 0;
+    QElapsedTimer statisticsIntervalTimer;
+    // runs from the first commit after the last frameRendered()
+    QElapsedTimer frameLatencyTimer;
+
+    // set while the signals of commits beyond the commit rate limit of the client are held back
+    bool commitThrottled = false;
+    QRegion throttledDamage;
+
     QVector<OutputInterface *> outputs;
 
+    /**
+     * A mapped surface of the sub-surface tree as used by surfaceAt() and inputSurfaceAt().
+     */
+    struct PickingEntry {
+        SurfaceInterface *surface;
+        // the geometry relative to the picking surface
+        QRectF geometry;
+        // maps a position of the picking surface to the surface-local input position,
+        // the input area scale is applied on each level of the tree
+        qreal inputScale;
+        QPointF inputOffset;
+        QRegion input;
+        bool inputIsInfinite;
+    };
+    // stacking order: top (first) -> bottom (last)
+    QVector<PickingEntry> pickingEntries;
+    QRectF pickingBoundingRect;
+    bool pickingCacheValid = false;
+    // the tree changes whenever the picking cache does, additionally on each buffer change
+    QVector<SurfaceRenderEntry> renderEntries;
+    bool renderListValid = false;
+    // invalidated along with the render list and on changes of the mapping or the effects
+    SurfaceInterface::ScanoutCandidate scanoutCandidate = SurfaceInterface::ScanoutCandidate::NoBuffer;
+    bool scanoutCandidateValid = false;
+
     LockedPointerV1Interface *lockedPointer = nullptr;
     ConfinedPointerV1Interface *confinedPointer = nullptr;
     QHash<OutputInterface*, QMetaObject::Connection> outputDestroyedConnections;
     QHash<OutputInterface*, QMetaObject::Connection> outputBoundConnections;
 
     QVector<IdleInhibitorV1Interface*> idleInhibitors;
+    bool inhibitsIdle = false;
+    // the surfaces of the sub-surface tree below this one which inhibit idle, including itself
+    int treeIdleInhibitors = 0;
     ViewportInterface *viewportExtension = nullptr;
+    ContentTypeV1Interface *contentTypeExtension = nullptr;
+    FractionalScaleV1Interface *fractionalScaleExtension = nullptr;
+    qreal preferredScale = 1;
+    TearingControlV1Interface *tearingControlExtension = nullptr;
+    LinuxDrmSyncObjSurfaceV1Interface *syncObjSurface = nullptr;
+    QPointer<LinuxDrmSyncObjManagerV1Interface> syncObjManager;
     SurfaceInterface *dataProxy = nullptr;
 
-    static QList<SurfaceInterface *> surfaces;
+    // all surfaces, linked through their surfaceLink, in order of creation
+    static wl_list surfaces;
+    wl_list surfaceLink;
+
+    QVector<SurfaceCommitObserver *> commitObservers;
 
     ClientConnection *client = nullptr;
+    // the key of the surface in the surfaces of its ClientConnectionPrivate
+    quint32 clientSurfaceId = 0;
+    ClientMemoryAccount memoryAccount{ClientMemoryCategory::SurfaceState};
 
 protected:
+    void bufferDestroyed(BufferInterface *buffer) override;
+
     void surface_destroy_resource(Resource *resource) override;
     void surface_destroy(Resource *resource) override;
     void surface_attach(Resource *resource, struct ::wl_resource *buffer, int32_t x, int32_t y) override;
@@ -149,6 +430,8 @@ private:
     QMetaObject::Connection constrainsUnboundConnection;
 };
 
+Q_DECLARE_OPERATORS_FOR_FLAGS(SurfaceInterfacePrivate::State::Changes)
+
 } // namespace KWaylandServer
 
 #endif
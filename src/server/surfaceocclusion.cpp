@@ -0,0 +1,106 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#include "surfaceocclusion.h"
+#include "surface_interface.h"
+
+#include <QHash>
+#include <QPointer>
+
+namespace KWaylandServer
+{
+
+class SurfaceOcclusionPrivate
+{
+public:
+    struct Layer {
+        // guarded, a surface might get destroyed between two updates
+        QPointer<SurfaceInterface> surface;
+        // in global coordinates
+        QRect geometry;
+        QRegion opaque;
+
+        bool operator==(const Layer &other) const
+        {
+            return surface == other.surface && geometry == other.geometry && opaque == other.opaque;
+        }
+    };
+
+    void computeVisibleRegions();
+
+    // stacking order: bottom (first) -> top (last)
+    QVector<Layer> layers;
+    QRect area;
+    // in surface-local coordinates
+    QHash<SurfaceInterface *, QRegion> visibleRegions;
+};
+
+void SurfaceOcclusionPrivate::computeVisibleRegions()
+{
+    visibleRegions.clear();
+    visibleRegions.reserve(layers.count());
+    QRegion covered;
+    for (auto it = layers.crbegin(); it != layers.crend(); ++it) {
+        if (!it->surface) {
+            continue;
+        }
+        QRegion visible = area.isValid() ? QRegion(it->geometry & area) : QRegion(it->geometry);
+        visible -= covered;
+        visibleRegions.insert(it->surface, visible.translated(-it->geometry.topLeft()));
+        // the protocol clips the opaque region to the surface
+        covered += it->opaque & it->geometry;
+    }
+}
+
+SurfaceOcclusion::SurfaceOcclusion()
+    : d(new SurfaceOcclusionPrivate)
+{
+}
+
+SurfaceOcclusion::~SurfaceOcclusion() = default;
+
+bool SurfaceOcclusion::update(const QVector<Window> &stack, const QRect &area)
+{
+    QVector<SurfaceOcclusionPrivate::Layer> layers;
+    layers.reserve(d->layers.count());
+    for (const Window &window : stack) {
+        if (!window.surface) {
+            continue;
+        }
+        const QVector<SurfaceRenderEntry> renderList = window.surface->renderList();
+        for (const SurfaceRenderEntry &entry : renderList) {
+            const QPoint position = window.position + entry.offset;
+            layers.append({entry.surface, QRect(position, entry.surface->size()), entry.opaque.translated(window.position)});
+        }
+    }
+    if (layers == d->layers && area == d->area) {
+        return false;
+    }
+    d->layers = std::move(layers);
+    d->area = area;
+    d->computeVisibleRegions();
+    return true;
+}
+
+QRegion SurfaceOcclusion::visibleRegion(SurfaceInterface *surface) const
+{
+    return d->visibleRegions.value(surface);
+}
+
+bool SurfaceOcclusion::isVisible(SurfaceInterface *surface) const
+{
+    return !d->visibleRegions.value(surface).isEmpty();
+}
+
+void SurfaceOcclusion::applyOcclusion() const
+{
+    for (const SurfaceOcclusionPrivate::Layer &layer : qAsConst(d->layers)) {
+        if (layer.surface) {
+            layer.surface->setOccluded(!isVisible(layer.surface));
+        }
+    }
+}
+
+}
@@ -0,0 +1,95 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+#ifndef KWAYLAND_SERVER_SURFACEOCCLUSION_H
+#define KWAYLAND_SERVER_SURFACEOCCLUSION_H
+
+#include <QPoint>
+#include <QRegion>
+#include <QScopedPointer>
+#include <QVector>
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+namespace KWaylandServer
+{
+class SurfaceInterface;
+class SurfaceOcclusionPrivate;
+
+/**
+ * @brief Computes the visible regions of a stack of surface trees.
+ *
+ * The compositor passes its main surfaces in stacking order together with their positions in
+ * global coordinates. The sub-surface trees are taken from SurfaceInterface::renderList(), the
+ * opaque region of every surface hides whatever is below it.
+ *
+ * @code
+ * SurfaceOcclusion occlusion;
+ * occlusion.update(stack, output->geometry());
+ * occlusion.applyOcclusion();
+ * @endcode
+ *
+ * The geometry, opaque region and position of each surface are compared with the previous
+ * update(), if nothing changed the visible regions are reused instead of recomputed.
+ *
+ * @see SurfaceInterface::renderList
+ * @see SurfaceInterface::setOccluded
+ * @since 5.22
+ **/
+class KWAYLANDSERVER_EXPORT SurfaceOcclusion
+{
+public:
+    /**
+     * A main surface of the stacking order.
+     **/
+    struct Window {
+        SurfaceInterface *surface = nullptr;
+        /**
+         * The position of the main surface in global coordinates.
+         **/
+        QPoint position;
+    };
+
+    SurfaceOcclusion();
+    ~SurfaceOcclusion();
+
+    /**
+     * Computes the visible regions of the surface trees of @p stack, ordered from bottom to top.
+     * If @p area is valid, everything outside of it is considered hidden, e.g. the parts of the
+     * surfaces outside of the output.
+     *
+     * @returns @c true if the visible regions changed since the last update
+     **/
+    bool update(const QVector<Window> &stack, const QRect &area = QRect());
+
+    /**
+     * @returns the visible region of @p surface in surface-local coordinates, empty if the
+     * surface is hidden or wasn't part of the last update()
+     **/
+    QRegion visibleRegion(SurfaceInterface *surface) const;
+    /**
+     * @returns whether some part of @p surface is visible
+     **/
+    bool isVisible(SurfaceInterface *surface) const;
+
+    /**
+     * Marks every surface of the last update() without a visible region as occluded and all
+     * others as not occluded. The frame callbacks of occluded surfaces are throttled and their
+     * idle inhibitors have no effect.
+     *
+     * Surfaces which are not part of the last update() are not changed.
+     *
+     * @see SurfaceInterface::setOccluded
+     **/
+    void applyOcclusion() const;
+
+private:
+    QScopedPointer<SurfaceOcclusionPrivate> d;
+    Q_DISABLE_COPY(SurfaceOcclusion)
+};
+
+}
+
+#endif
@@ -11,9 +11,9 @@
 namespace KWaylandServer
 {
 
-SurfaceRole::SurfaceRole(SurfaceInterface *surface, const QByteArray &name)
+SurfaceRole::SurfaceRole(SurfaceInterface *surface, Type type)
     : m_surface(surface)
-    , m_name(name)
+    , m_type(type)
 {
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
     surfacePrivate->role = this;
@@ -28,9 +28,23 @@ SurfaceRole::~SurfaceRole()
     }
 }
 
-QByteArray SurfaceRole::name() const
+const char *SurfaceRole::name() const
 {
-    return m_name;
+    switch (m_type) {
+    case Type::SubSurface:
+        return "wl_subsurface";
+    case Type::XdgToplevel:
+        return "xdg_toplevel";
+    case Type::XdgPopup:
+        return "xdg_popup";
+    case Type::LayerSurface:
+        return "layer_surface_v1";
+    case Type::InputPanelSurface:
+        return "input_panel_surface_v1";
+    case Type::DragAndDropIcon:
+        return "dnd_icon";
+    }
+    Q_UNREACHABLE();
 }
 
 SurfaceRole *SurfaceRole::get(SurfaceInterface *surface)
@@ -7,7 +7,6 @@
 #ifndef KWAYLAND_SERVER_SURFACEROLE_P_H
 #define KWAYLAND_SERVER_SURFACEROLE_P_H
 
-#include <QByteArray>
 #include <QPointer>
 
 namespace KWaylandServer
@@ -18,10 +17,29 @@ class SurfaceInterface;
 class SurfaceRole
 {
 public:
-    SurfaceRole(SurfaceInterface *surface, const QByteArray &name);
+    /**
+     * The roles a surface can have, the type is fixed by the implementing class.
+     */
+    enum class Type {
+        SubSurface,
+        XdgToplevel,
+        XdgPopup,
+        LayerSurface,
+        InputPanelSurface,
+        DragAndDropIcon,
+    };
+
+    SurfaceRole(SurfaceInterface *surface, Type type);
     virtual ~SurfaceRole();
 
-    QByteArray name() const;
+    Type type() const
+    {
+        return m_type;
+    }
+    /**
+     * The protocol name of the role, for error messages.
+     */
+    const char *name() const;
     const QPointer<SurfaceInterface> &surface() const
     {
         return m_surface;
@@ -33,7 +51,7 @@ public:
 
 private:
     QPointer<SurfaceInterface> m_surface;
-    QByteArray m_name;
+    const Type m_type;
 
     Q_DISABLE_COPY(SurfaceRole)
 };
@@ -0,0 +1,90 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "surfacetransaction_p.h"
+#include "subsurface_interface_p.h"
+#include "surfacerole_p.h"
+
+namespace KWaylandServer
+{
+
+void SurfaceTransaction::add(SurfaceInterface *surface, SurfaceInterfacePrivate::State *source, bool synchronized)
+{
+    m_entries.append(Entry{surface, source, {}});
+
+    // The children are the same in all states, only their stacking order may differ.
+    const QList<SubSurfaceInterface *> children = source->children;
+    for (SubSurfaceInterface *subsurface : children) {
+        SubSurfaceInterfacePrivate *subsurfacePrivate = SubSurfaceInterfacePrivate::get(subsurface);
+        // The position of a sub-surface is applied when its parent is committed.
+        if (subsurfacePrivate->hasPendingPosition) {
+            m_positions.append(subsurface);
+        }
+        if (!subsurfacePrivate->surface) {
+            continue;
+        }
+        if (synchronized || subsurfacePrivate->mode == SubSurfaceInterface::Mode::Synchronized) {
+            SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(subsurfacePrivate->surface);
+            add(subsurfacePrivate->surface, &surfacePrivate->cached, true);
+        }
+    }
+}
+
+void SurfaceTransaction::apply()
+{
+    for (Entry &entry : m_entries) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(entry.surface);
+        entry.applied = surfacePrivate->applyState(entry.source, &surfacePrivate->current, true);
+        if (entry.source == &surfacePrivate->cached) {
+            SubSurfaceInterfacePrivate::get(surfacePrivate->subSurface)->hasCacheState = false;
+        }
+    }
+    for (const QPointer<SubSurfaceInterface> &subsurface : qAsConst(m_positions)) {
+        SubSurfaceInterfacePrivate *subsurfacePrivate = SubSurfaceInterfacePrivate::get(subsurface);
+        subsurfacePrivate->hasPendingPosition = false;
+        subsurfacePrivate->position = subsurfacePrivate->pendingPosition;
+        if (subsurfacePrivate->parent) {
+            SurfaceInterfacePrivate::get(subsurfacePrivate->parent)->invalidatePickingCache();
+        }
+    }
+
+    // Connected slots may destroy any surface of the tree.
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (entry.surface) {
+            SurfaceInterfacePrivate::get(entry.surface)->emitChanges(entry.applied);
+        }
+    }
+    for (const QPointer<SubSurfaceInterface> &subsurface : qAsConst(m_positions)) {
+        if (subsurface) {
+            emit subsurface->positionChanged(subsurface->position());
+        }
+    }
+    for (const Entry &entry : qAsConst(m_entries)) {
+        if (entry.surface) {
+            SurfaceRole *role = SurfaceRole::get(entry.surface);
+            // sub-surfaces, usually the bulk of a transaction, have nothing to do in commit()
+            if (role && role->type() != SurfaceRole::Type::SubSurface) {
+                role->commit();
+            }
+        }
+    }
+}
+
+void SurfaceTransaction::emitTreeCommitted()
+{
+    if (m_entries.isEmpty() || !m_entries.first().surface) {
+        return;
+    }
+    SurfaceInterface *surface = m_entries.first().surface;
+    if (SubSurfaceInterface *subsurface = surface->subSurface()) {
+        surface = subsurface->mainSurface();
+    }
+    if (surface) {
+        emit surface->treeCommitted();
+    }
+}
+
+} // namespace KWaylandServer
@@ -0,0 +1,51 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "surface_interface_p.h"
+
+#include <QPointer>
+#include <QVector>
+
+namespace KWaylandServer
+{
+
+class SubSurfaceInterface;
+
+/**
+ * Applies the state of a surface and the cached state of its synchronized sub-surfaces as one
+ * unit. All states are applied before any change signal gets emitted, so the compositor never
+ * sees a partially updated sub-surface tree, then the roles of the surfaces are committed.
+ */
+class SurfaceTransaction
+{
+public:
+    /**
+     * Adds the @p source state of @p surface, along with the pending positions of its
+     * sub-surfaces and the cached states of the synchronized ones. If @p synchronized is set,
+     * all sub-surfaces are applied as if they were synchronized.
+     */
+    void add(SurfaceInterface *surface, SurfaceInterfacePrivate::State *source, bool synchronized = false);
+
+    void apply();
+
+    /**
+     * Emits SurfaceInterface::treeCommitted() for the main surface of the transaction.
+     */
+    void emitTreeCommitted();
+
+private:
+    struct Entry {
+        QPointer<SurfaceInterface> surface;
+        SurfaceInterfacePrivate::State *source;
+        SurfaceInterfacePrivate::AppliedChanges applied;
+    };
+    QVector<Entry> m_entries;
+    QVector<QPointer<SubSurfaceInterface>> m_positions;
+};
+
+} // namespace KWaylandServer
@@ -5,13 +5,11 @@
 */
 
 #include "tablet_v2_interface.h"
+#include "tablet_v2_interface_p.h"
 #include "display.h"
 #include "seat_interface.h"
 #include "surface_interface.h"
 
-#include "qwayland-server-tablet-unstable-v2.h"
-#include <QHash>
-
 namespace KWaylandServer
 {
 
@@ -72,7 +70,7 @@ bool TabletV2Interface::isSurfaceSupported(SurfaceInterface *surface) const
 void TabletV2Interface::sendRemoved()
 {
     d->m_removed = true;
-    for (QtWaylandServer::zwp_tablet_v2::Resource *resource : d->resourceMap()) {
+    for (QtWaylandServer::zwp_tablet_v2::Resource *resource : d->resources()) {
         d->send_removed(resource->handle);
     }
 }
@@ -82,30 +80,6 @@ TabletPadV2Interface *TabletV2Interface::pad() const
     return d->m_pad;
 }
 
-class TabletCursorV2Private
-{
-public:
-    TabletCursorV2Private(TabletCursorV2 *q) : q(q) {}
-
-    void update(quint32 serial, SurfaceInterface *surface, const QPoint &hotspot)
-    {
-        const bool diff = m_serial != serial || m_surface != surface || m_hotspot != hotspot;
-        if (diff) {
-            m_serial = serial;
-            m_surface = surface;
-            m_hotspot = hotspot;
-
-            Q_EMIT q->changed();
-        }
-    }
-
-    TabletCursorV2 *const q;
-
-    quint32 m_serial = 0;
-    SurfaceInterface* m_surface = nullptr;
-    QPoint m_hotspot;
-};
-
 TabletCursorV2::TabletCursorV2()
     : QObject()
     , d(new TabletCursorV2Private(this))
@@ -129,83 +103,10 @@ SurfaceInterface *TabletCursorV2::surface() const
     return d->m_surface;
 }
 
-class TabletToolV2InterfacePrivate : public QtWaylandServer::zwp_tablet_tool_v2
+QString TabletCursorV2::shape() const
 {
-public:
-    TabletToolV2InterfacePrivate(TabletToolV2Interface *q, Display *display,
-                                 TabletToolV2Interface::Type type, uint32_t hsh, uint32_t hsl,
-                                 uint32_t hih, uint32_t hil,
-                                 const QVector<TabletToolV2Interface::Capability>& capabilities)
-        : zwp_tablet_tool_v2()
-        , m_display(display)
-        , m_type(type)
-        , m_hardwareSerialHigh(hsh)
-        , m_hardwareSerialLow(hsl)
-        , m_hardwareIdHigh(hih)
-        , m_hardwareIdLow(hil)
-        , m_capabilities(capabilities)
-        , q(q)
-    {
-    }
-
-
-    wl_resource *targetResource()
-    {
-        if (!m_surface)
-            return nullptr;
-
-        ClientConnection *client = m_surface->client();
-        const Resource *r = resourceMap().value(*client);
-        return r ? r->handle : nullptr;
-    }
-
-    quint64 hardwareId() const
-    {
-        return quint64(quint64(m_hardwareIdHigh) << 32) + m_hardwareIdLow;
-    }
-    quint64 hardwareSerial() const
-    {
-        return quint64(quint64(m_hardwareSerialHigh) << 32) + m_hardwareSerialLow;
-    }
-
-    void zwp_tablet_tool_v2_bind_resource(QtWaylandServer::zwp_tablet_tool_v2::Resource * resource) override
-    {
-        TabletCursorV2 *&c = m_cursors[resource->handle];
-        if (!c)
-            c = new TabletCursorV2;
-    }
-
-    void zwp_tablet_tool_v2_set_cursor(Resource * resource, uint32_t serial, struct ::wl_resource * _surface, int32_t hotspot_x, int32_t hotspot_y) override
-    {
-        TabletCursorV2 *c = m_cursors[resource->handle];
-        c->d->update(serial, SurfaceInterface::get(_surface), {hotspot_x, hotspot_y});
-        if (resource->handle == targetResource())
-            q->cursorChanged(c);
-    }
-
-    void zwp_tablet_tool_v2_destroy_resource(Resource * resource) override {
-        delete m_cursors.take(resource->handle);
-        if (m_removed && resourceMap().isEmpty()) {
-            delete q;
-        }
-    }
-
-    void zwp_tablet_tool_v2_destroy(Resource *resource) override {
-        wl_resource_destroy(resource->handle);
-    }
-
-    Display *const m_display;
-    bool m_cleanup = false;
-    bool m_removed = false;
-    QPointer<SurfaceInterface> m_surface;
-    QPointer<TabletV2Interface> m_lastTablet;
-    const uint32_t m_type;
-    const uint32_t m_hardwareSerialHigh, m_hardwareSerialLow;
-    const uint32_t m_hardwareIdHigh, m_hardwareIdLow;
-    const QVector<TabletToolV2Interface::Capability> m_capabilities;
-    QHash<wl_resource *, TabletCursorV2 *> m_cursors;
-    TabletToolV2Interface *const q;
-};
+    return d->m_shape;
+}
 
 TabletToolV2Interface::TabletToolV2Interface(Display *display, Type type, uint32_t hsh,
                                              uint32_t hsl, uint32_t hih, uint32_t hil,
@@ -224,12 +125,14 @@ void TabletToolV2Interface::setCurrentSurface(SurfaceInterface *surface)
         return;
 
     TabletV2Interface *const lastTablet = d->m_lastTablet;
-    if (d->m_surface && d->resourceMap().contains(*d->m_surface->client())) {
+    if (d->targetResource()) {
         sendProximityOut();
         sendFrame(0);
     }
 
     d->m_surface = surface;
+    d->updateTargetResource();
+    d->m_sentStateValid = false;
 
     if (lastTablet && lastTablet->d->resourceForSurface(surface)) {
         sendProximityIn(lastTablet);
@@ -256,11 +159,13 @@ void TabletToolV2Interface::sendMotion(const QPointF &pos)
 {
     d->send_motion(d->targetResource(), wl_fixed_from_double(pos.x()),
                                         wl_fixed_from_double(pos.y()));
+    d->m_sentState.position = pos;
 }
 
 void TabletToolV2Interface::sendDistance(uint32_t distance)
 {
     d->send_distance(d->targetResource(), distance);
+    d->m_sentState.distance = distance;
 }
 
 void TabletToolV2Interface::sendFrame(uint32_t time)
@@ -269,6 +174,7 @@ void TabletToolV2Interface::sendFrame(uint32_t time)
 
     if (d->m_cleanup) {
         d->m_surface = nullptr;
+        d->m_targetResource = nullptr;
         d->m_lastTablet = nullptr;
         d->m_cleanup = false;
     }
@@ -277,22 +183,27 @@ void TabletToolV2Interface::sendFrame(uint32_t time)
 void TabletToolV2Interface::sendPressure(uint32_t pressure)
 {
     d->send_pressure(d->targetResource(), pressure);
+    d->m_sentState.pressure = pressure;
 }
 
 void TabletToolV2Interface::sendRotation(qreal rotation)
 {
     d->send_rotation(d->targetResource(), wl_fixed_from_double(rotation));
+    d->m_sentState.rotation = rotation;
 }
 
 void TabletToolV2Interface::sendSlider(int32_t position)
 {
     d->send_slider(d->targetResource(), position);
+    d->m_sentState.slider = position;
 }
 
 void TabletToolV2Interface::sendTilt(qreal degreesX, qreal degreesY)
 {
     d->send_tilt(d->targetResource(), wl_fixed_from_double(degreesX),
                                       wl_fixed_from_double(degreesY));
+    d->m_sentState.tiltX = degreesX;
+    d->m_sentState.tiltY = degreesY;
 }
 
 void TabletToolV2Interface::sendWheel(int32_t degrees, int32_t clicks)
@@ -306,6 +217,7 @@ void TabletToolV2Interface::sendProximityIn(TabletV2Interface *tablet)
     d->send_proximity_in(d->targetResource(), d->m_display->nextSerial(),
                          tabletResource, d->m_surface->resource());
     d->m_lastTablet = tablet;
+    d->m_sentStateValid = false;
 }
 
 void TabletToolV2Interface::sendProximityOut()
@@ -317,18 +229,65 @@ void TabletToolV2Interface::sendProximityOut()
 void TabletToolV2Interface::sendDown()
 {
     d->send_down(d->targetResource(), d->m_display->nextSerial());
+    d->m_sentState.down = true;
 }
 
 void TabletToolV2Interface::sendUp()
 {
     d->send_up(d->targetResource());
+    d->m_sentState.down = false;
+}
+
+void TabletToolV2Interface::sendFrameBatch(const ToolState &state, quint32 time)
+{
+    wl_resource *resource = d->targetResource();
+    if (!resource) {
+        return;
+    }
+    const bool all = !d->m_sentStateValid;
+    const ToolState &sent = d->m_sentState;
+    auto hasCapability = [this](Capability capability) {
+        return d->m_capabilities.contains(capability);
+    };
+
+    if (all || state.position != sent.position) {
+        d->send_motion(resource, wl_fixed_from_double(state.position.x()), wl_fixed_from_double(state.position.y()));
+    }
+    if (state.down && (all || !sent.down)) {
+        d->send_down(resource, d->m_display->nextSerial());
+    }
+    if (hasCapability(Pressure) && (all || state.pressure != sent.pressure)) {
+        d->send_pressure(resource, state.pressure);
+    }
+    if (hasCapability(Distance) && (all || state.distance != sent.distance)) {
+        d->send_distance(resource, state.distance);
+    }
+    if (hasCapability(Tilt) && (all || state.tiltX != sent.tiltX || state.tiltY != sent.tiltY)) {
+        d->send_tilt(resource, wl_fixed_from_double(state.tiltX), wl_fixed_from_double(state.tiltY));
+    }
+    if (hasCapability(Rotation) && (all || state.rotation != sent.rotation)) {
+        d->send_rotation(resource, wl_fixed_from_double(state.rotation));
+    }
+    if (hasCapability(Slider) && (all || state.slider != sent.slider)) {
+        d->send_slider(resource, state.slider);
+    }
+    if (hasCapability(Wheel) && (state.wheelDegrees != 0 || state.wheelClicks != 0)) {
+        d->send_wheel(resource, state.wheelDegrees, state.wheelClicks);
+    }
+    if (!state.down && !all && sent.down) {
+        d->send_up(resource);
+    }
+
+    d->m_sentState = state;
+    d->m_sentStateValid = true;
+    sendFrame(time);
 }
 
 void TabletToolV2Interface::sendRemoved()
 {
     d->m_removed = true;
 
-    for (QtWaylandServer::zwp_tablet_tool_v2::Resource *resource : d->resourceMap()) {
+    for (QtWaylandServer::zwp_tablet_tool_v2::Resource *resource : d->resources()) {
         d->send_removed(resource->handle);
     }
 }
@@ -580,7 +539,7 @@ void TabletPadV2Interface::sendButton(quint32 time, quint32 button, bool pressed
 void TabletPadV2Interface::sendRemoved()
 {
     d->m_removed = true;
-    for (auto resource : d->resourceMap()) {
+    for (auto resource : d->resources()) {
         d->send_removed(resource->handle);
     }
 }
@@ -718,8 +677,39 @@ public:
         pad->d->send_done(tabletResource);
     }
 
+    void indexTool(TabletToolV2Interface *tool)
+    {
+        // the first tool added with an id is found, like the lookups used to scan m_tools
+        if (!m_toolsByHardwareId.contains(tool->d->hardwareId())) {
+            m_toolsByHardwareId.insert(tool->d->hardwareId(), tool);
+        }
+        if (!m_toolsByHardwareSerial.contains(tool->d->hardwareSerial())) {
+            m_toolsByHardwareSerial.insert(tool->d->hardwareSerial(), tool);
+        }
+    }
+
+    // the tool is being destroyed already, its ids are passed in
+    void unindexTool(TabletToolV2Interface *tool, quint64 hardwareId, quint64 hardwareSerial)
+    {
+        const bool indexedById = m_toolsByHardwareId.value(hardwareId) == tool;
+        const bool indexedBySerial = m_toolsByHardwareSerial.value(hardwareSerial) == tool;
+        if (indexedById) {
+            m_toolsByHardwareId.remove(hardwareId);
+        }
+        if (indexedBySerial) {
+            m_toolsByHardwareSerial.remove(hardwareSerial);
+        }
+        if (indexedById || indexedBySerial) {
+            for (TabletToolV2Interface *other : qAsConst(m_tools)) {
+                indexTool(other);
+            }
+        }
+    }
+
     TabletSeatV2Interface *const q;
     QVector<TabletToolV2Interface *> m_tools;
+    QHash<quint64, TabletToolV2Interface *> m_toolsByHardwareId;
+    QHash<quint64, TabletToolV2Interface *> m_toolsByHardwareSerial;
     QHash<QString, TabletV2Interface *> m_tablets;
     QHash<QString, TabletPadV2Interface *> m_pads;
     Display *const m_display;
@@ -747,10 +737,12 @@ TabletToolV2Interface *TabletSeatV2Interface::addTool(TabletToolV2Interface::Typ
     }
 
     d->m_tools.append(tool);
-    QObject::connect(tool, &QObject::destroyed, this, [this](QObject *object) {
+    d->indexTool(tool);
+    QObject::connect(tool, &QObject::destroyed, this, [this, hardwareId, hardwareSerial](QObject *object) {
         auto tti = static_cast<TabletToolV2Interface *>(object);
         tti->d->send_removed();
         d->m_tools.removeAll(tti);
+        d->unindexTool(tti, hardwareId, hardwareSerial);
     });
     return tool;
 }
@@ -802,21 +794,12 @@ void TabletSeatV2Interface::removeDevice(const QString &sysname)
 
 TabletToolV2Interface *TabletSeatV2Interface::toolByHardwareId(quint64 hardwareId) const
 {
-    for (TabletToolV2Interface *tool : qAsConst(d->m_tools)) {
-        if (tool->d->hardwareId() == hardwareId) {
-            return tool;
-        }
-    }
-    return nullptr;
+    return d->m_toolsByHardwareId.value(hardwareId);
 }
 
 TabletToolV2Interface *TabletSeatV2Interface::toolByHardwareSerial(quint64 hardwareSerial) const
 {
-    for (TabletToolV2Interface *tool : qAsConst(d->m_tools)) {
-        if (tool->d->hardwareSerial() == hardwareSerial)
-            return tool;
-    }
-    return nullptr;
+    return d->m_toolsByHardwareSerial.value(hardwareSerial);
 }
 
 TabletPadV2Interface * TabletSeatV2Interface::padByName(const QString &name) const
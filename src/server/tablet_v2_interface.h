@@ -111,6 +111,39 @@ public:
     void sendFrame(quint32 time);
     void sendMotion(const QPointF &pos);
 
+    /**
+     * The state of a tool's axes as passed to sendFrameBatch().
+     *
+     * @since 5.22
+     */
+    struct ToolState {
+        QPointF position;
+        bool down = false;
+        quint32 pressure = 0;
+        quint32 distance = 0;
+        qreal tiltX = 0;
+        qreal tiltY = 0;
+        qreal rotation = 0;
+        qint32 slider = 0;
+        /**
+         * The wheel motion since the last frame, only sent if not zero.
+         */
+        qint32 wheelDegrees = 0;
+        qint32 wheelClicks = 0;
+    };
+
+    /**
+     * Sends the axes of @p state which changed since they were last sent to the current
+     * surface, followed by one frame event with the given @p time.
+     *
+     * Only the axes the tool has the capability for are sent. After the tool entered a
+     * surface all of them are considered changed. The single axis send methods update the
+     * same state, so both can be mixed.
+     *
+     * @since 5.22
+     */
+    void sendFrameBatch(const ToolState &state, quint32 time);
+
 Q_SIGNALS:
     void cursorChanged(TabletCursorV2 *cursor) const;
 
@@ -129,6 +162,15 @@ public:
     QPoint hotspot() const;
     quint32 enteredSerial() const;
     SurfaceInterface* surface() const;
+    /**
+     * The name of the cursor shape the client set with the cursor shape protocol, empty if
+     * the cursor uses the surface instead.
+     *
+     * @see Cursor::shape
+     * @see CursorShapeManagerV1Interface
+     * @since 5.22
+     */
+    QString shape() const;
 
 Q_SIGNALS:
     void changed();
@@ -0,0 +1,163 @@
+/*
+    SPDX-FileCopyrightText: 2019 Aleix Pol Gonzalez <aleixpol@kde.org>
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "tablet_v2_interface.h"
+#include "surface_interface.h"
+
+#include "qwayland-server-tablet-unstable-v2.h"
+
+#include <QHash>
+#include <QPointer>
+
+namespace KWaylandServer
+{
+
+class TabletCursorV2Private
+{
+public:
+    TabletCursorV2Private(TabletCursorV2 *q) : q(q) {}
+
+    void update(quint32 serial, SurfaceInterface *surface, const QPoint &hotspot, const QString &shape = QString())
+    {
+        const bool diff = m_serial != serial || m_surface != surface || m_hotspot != hotspot || m_shape != shape;
+        if (diff) {
+            m_serial = serial;
+            m_surface = surface;
+            m_hotspot = hotspot;
+            m_shape = shape;
+
+            Q_EMIT q->changed();
+        }
+    }
+
+    TabletCursorV2 *const q;
+
+    quint32 m_serial = 0;
+    SurfaceInterface* m_surface = nullptr;
+    QPoint m_hotspot;
+    QString m_shape;
+};
+
+class TabletToolV2InterfacePrivate : public QtWaylandServer::zwp_tablet_tool_v2
+{
+public:
+    TabletToolV2InterfacePrivate(TabletToolV2Interface *q, Display *display,
+                                 TabletToolV2Interface::Type type, uint32_t hsh, uint32_t hsl,
+                                 uint32_t hih, uint32_t hil,
+                                 const QVector<TabletToolV2Interface::Capability>& capabilities)
+        : zwp_tablet_tool_v2()
+        , m_display(display)
+        , m_type(type)
+        , m_hardwareSerialHigh(hsh)
+        , m_hardwareSerialLow(hsl)
+        , m_hardwareIdHigh(hih)
+        , m_hardwareIdLow(hil)
+        , m_capabilities(capabilities)
+        , q(q)
+    {
+    }
+
+
+    wl_resource *targetResource()
+    {
+        return m_surface ? m_targetResource : nullptr;
+    }
+
+    // looks up the resource of the current surface's client, it's cached until the surface
+    // changes or the client binds or destroys a tool resource
+    void updateTargetResource(wl_resource *ignored = nullptr)
+    {
+        m_targetResource = nullptr;
+        if (!m_surface)
+            return;
+
+        // the most recently bound resource first, like QMultiMap::value()
+        const QList<Resource *> resources = resourceMap().values(*m_surface->client());
+        for (const Resource *r : resources) {
+            if (r->handle != ignored) {
+                m_targetResource = r->handle;
+                return;
+            }
+        }
+    }
+
+    quint64 hardwareId() const
+    {
+        return quint64(quint64(m_hardwareIdHigh) << 32) + m_hardwareIdLow;
+    }
+    quint64 hardwareSerial() const
+    {
+        return quint64(quint64(m_hardwareSerialHigh) << 32) + m_hardwareSerialLow;
+    }
+
+    void zwp_tablet_tool_v2_bind_resource(QtWaylandServer::zwp_tablet_tool_v2::Resource * resource) override
+    {
+        TabletCursorV2 *&c = m_cursors[resource->handle];
+        if (!c)
+            c = new TabletCursorV2;
+        if (m_surface && m_surface->client()->client() == resource->client())
+            m_targetResource = resource->handle;
+    }
+
+    static TabletToolV2InterfacePrivate *get(wl_resource *resource)
+    {
+        Resource *r = Resource::fromResource(resource);
+        return r ? static_cast<TabletToolV2InterfacePrivate *>(r->object()) : nullptr;
+    }
+
+    // wp_cursor_shape_device_v1.set_shape for the tool resource @p toolResource
+    void setCursorShape(wl_resource *toolResource, quint32 serial, const QString &shape)
+    {
+        TabletCursorV2 *c = m_cursors.value(toolResource);
+        if (!c)
+            return;
+        c->d->update(serial, nullptr, QPoint(), shape);
+        if (toolResource == targetResource())
+            q->cursorChanged(c);
+    }
+
+    void zwp_tablet_tool_v2_set_cursor(Resource * resource, uint32_t serial, struct ::wl_resource * _surface, int32_t hotspot_x, int32_t hotspot_y) override
+    {
+        TabletCursorV2 *c = m_cursors[resource->handle];
+        c->d->update(serial, SurfaceInterface::get(_surface), {hotspot_x, hotspot_y});
+        if (resource->handle == targetResource())
+            q->cursorChanged(c);
+    }
+
+    void zwp_tablet_tool_v2_destroy_resource(Resource * resource) override {
+        delete m_cursors.take(resource->handle);
+        if (resource->handle == m_targetResource)
+            updateTargetResource(resource->handle);
+        if (m_removed && resourceMap().isEmpty()) {
+            delete q;
+        }
+    }
+
+    void zwp_tablet_tool_v2_destroy(Resource *resource) override {
+        wl_resource_destroy(resource->handle);
+    }
+
+    Display *const m_display;
+    bool m_cleanup = false;
+    bool m_removed = false;
+    QPointer<SurfaceInterface> m_surface;
+    wl_resource *m_targetResource = nullptr;
+    QPointer<TabletV2Interface> m_lastTablet;
+    const uint32_t m_type;
+    const uint32_t m_hardwareSerialHigh, m_hardwareSerialLow;
+    const uint32_t m_hardwareIdHigh, m_hardwareIdLow;
+    const QVector<TabletToolV2Interface::Capability> m_capabilities;
+    QHash<wl_resource *, TabletCursorV2 *> m_cursors;
+    // the axes last sent to the current surface, not valid until the first frame after
+    // the tool entered the surface
+    TabletToolV2Interface::ToolState m_sentState;
+    bool m_sentStateValid = false;
+    TabletToolV2Interface *const q;
+};
+
+} // namespace KWaylandServer
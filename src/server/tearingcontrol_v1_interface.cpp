@@ -0,0 +1,105 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#include "tearingcontrol_v1_interface.h"
+#include "display.h"
+#include "surface_interface_p.h"
+#include "tearingcontrol_v1_interface_p.h"
+
+static const int s_version = 1;
+
+namespace KWaylandServer
+{
+
+class TearingControlManagerV1InterfacePrivate : public QtWaylandServer::wp_tearing_control_manager_v1
+{
+protected:
+    void wp_tearing_control_manager_v1_destroy(Resource *resource) override;
+    void wp_tearing_control_manager_v1_get_tearing_control(Resource *resource, uint32_t id, struct ::wl_resource *surface) override;
+};
+
+void TearingControlManagerV1InterfacePrivate::wp_tearing_control_manager_v1_destroy(Resource *resource)
+{
+    wl_resource_destroy(resource->handle);
+}
+
+void TearingControlManagerV1InterfacePrivate::wp_tearing_control_manager_v1_get_tearing_control(Resource *resource, uint32_t id, struct ::wl_resource *surface_resource)
+{
+    SurfaceInterface *surface = SurfaceInterface::get(surface_resource);
+    if (TearingControlV1Interface::get(surface)) {
+        wl_resource_post_error(resource->handle, error_tearing_control_exists,
+                               "the specified surface already has a tearing control object");
+        return;
+    }
+
+    wl_resource *tearingControlResource = wl_resource_create(resource->client(), &wp_tearing_control_v1_interface,
+                                                             resource->version(), id);
+    if (!tearingControlResource) {
+        wl_resource_post_no_memory(resource->handle);
+        return;
+    }
+    new TearingControlV1Interface(surface, tearingControlResource);
+}
+
+TearingControlV1Interface::TearingControlV1Interface(SurfaceInterface *surface, wl_resource *resource)
+    : QtWaylandServer::wp_tearing_control_v1(resource)
+    , surface(surface)
+{
+    SurfaceInterfacePrivate::get(surface)->tearingControlExtension = this;
+}
+
+TearingControlV1Interface::~TearingControlV1Interface()
+{
+    if (surface) {
+        SurfaceInterfacePrivate::get(surface)->tearingControlExtension = nullptr;
+    }
+}
+
+TearingControlV1Interface *TearingControlV1Interface::get(SurfaceInterface *surface)
+{
+    return SurfaceInterfacePrivate::get(surface)->tearingControlExtension;
+}
+
+void TearingControlV1Interface::wp_tearing_control_v1_destroy_resource(Resource *resource)
+{
+    Q_UNUSED(resource)
+    delete this;
+}
+
+void TearingControlV1Interface::wp_tearing_control_v1_destroy(Resource *resource)
+{
+    // reverts to vsync with the next commit
+    if (surface) {
+        SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+        surfacePrivate->pending.presentationHint = PresentationHint::VSync;
+        surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::PresentationHintChanged;
+    }
+    wl_resource_destroy(resource->handle);
+}
+
+void TearingControlV1Interface::wp_tearing_control_v1_set_presentation_hint(Resource *resource, uint32_t hint)
+{
+    Q_UNUSED(resource)
+    if (!surface) {
+        return;
+    }
+    SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
+    surfacePrivate->pending.presentationHint = hint == presentation_hint_async ? PresentationHint::Async : PresentationHint::VSync;
+    surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::PresentationHintChanged;
+}
+
+TearingControlManagerV1Interface::TearingControlManagerV1Interface(Display *display, QObject *parent)
+    : QObject(parent)
+    , d(new TearingControlManagerV1InterfacePrivate)
+{
+    d->init(*display, s_version);
+}
+
+TearingControlManagerV1Interface::~TearingControlManagerV1Interface()
+{
+}
+
+} // namespace KWaylandServer
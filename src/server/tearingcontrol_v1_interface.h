@@ -0,0 +1,60 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <KWaylandServer/kwaylandserver_export.h>
+
+#include <QObject>
+
+namespace KWaylandServer
+{
+
+class Display;
+class TearingControlManagerV1InterfacePrivate;
+
+/**
+ * How the client wants the content of a surface to be presented.
+ *
+ * @see SurfaceInterface::presentationHint
+ * @since 5.22
+ */
+enum class PresentationHint {
+    /**
+     * The content is synchronized to the vertical blank, without tearing.
+     */
+    VSync = 0,
+    /**
+     * The content is presented with the least latency, tearing is acceptable.
+     */
+    Async = 1,
+};
+
+/**
+ * The TearingControlManagerV1Interface lets clients accept tearing in exchange for latency.
+ *
+ * A game can hint that its surface may be presented with asynchronous page flips. The hint is
+ * provided by SurfaceInterface::presentationHint(), the compositor is free to ignore it, e.g.
+ * because the surface isn't fullscreen or the hardware doesn't support asynchronous flips.
+ *
+ * TearingControlManagerV1Interface corresponds to the Wayland interface
+ * @c wp_tearing_control_manager_v1.
+ *
+ * @since 5.22
+ */
+class KWAYLANDSERVER_EXPORT TearingControlManagerV1Interface : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit TearingControlManagerV1Interface(Display *display, QObject *parent = nullptr);
+    ~TearingControlManagerV1Interface() override;
+
+private:
+    QScopedPointer<TearingControlManagerV1InterfacePrivate> d;
+};
+
+} // namespace KWaylandServer
@@ -163,7 +163,7 @@ void TextInputV2InterfacePrivate::commitString(const QString &text)
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_commit_string(resource->handle, text);
     }
@@ -175,7 +175,7 @@ void TextInputV2InterfacePrivate::keysymPressed(quint32 keysym, Qt::KeyboardModi
         return;
     }
     Q_UNUSED(modifiers)
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_keysym(resource->handle, seat ? seat->timestamp() : 0, keysym, WL_KEYBOARD_KEY_STATE_PRESSED, 0);
     }
@@ -187,7 +187,7 @@ void TextInputV2InterfacePrivate::keysymReleased(quint32 keysym, Qt::KeyboardMod
         return;
     }
     Q_UNUSED(modifiers)
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_keysym(resource->handle, seat ? seat->timestamp() : 0, keysym, WL_KEYBOARD_KEY_STATE_RELEASED, 0);
     }
@@ -198,7 +198,7 @@ void TextInputV2InterfacePrivate::deleteSurroundingText(quint32 beforeLength, qu
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_delete_surrounding_text(resource->handle, beforeLength, afterLength);
     }
@@ -209,7 +209,7 @@ void TextInputV2InterfacePrivate::setCursorPosition(qint32 index, qint32 anchor)
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_cursor_position(resource->handle, index, anchor);
     }
@@ -235,7 +235,7 @@ void TextInputV2InterfacePrivate::setTextDirection(Qt::LayoutDirection direction
         Q_UNREACHABLE();
         break;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_text_direction(resource->handle, wlDirection);
     }
@@ -246,7 +246,7 @@ void TextInputV2InterfacePrivate::setPreEditCursor(qint32 index)
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_preedit_cursor(resource->handle, index);
     }
@@ -257,7 +257,7 @@ void TextInputV2InterfacePrivate::sendInputPanelState()
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_input_panel_state(resource->handle,inputPanelVisible ? ZWP_TEXT_INPUT_V2_INPUT_PANEL_VISIBILITY_VISIBLE : ZWP_TEXT_INPUT_V2_INPUT_PANEL_VISIBILITY_HIDDEN,
                                overlappedSurfaceArea.x(), overlappedSurfaceArea.y(), overlappedSurfaceArea.width(), overlappedSurfaceArea.height());
@@ -269,7 +269,7 @@ void TextInputV2InterfacePrivate::sendLanguage()
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_language(resource->handle, language);
     }
@@ -312,21 +312,16 @@ void TextInputV2InterfacePrivate::zwp_text_input_v2_hide_input_panel(Resource *r
 
 void TextInputV2InterfacePrivate::zwp_text_input_v2_set_surrounding_text(Resource *resource, const QString &text, int32_t cursor, int32_t anchor)
 {
-    Q_UNUSED(resource)
-    surroundingText = QString(text);
-    surroundingTextCursorPosition = cursor;
-    surroundingTextSelectionAnchor = anchor;
-    emit q->surroundingTextChanged();
+    // clients tend to send the surrounding text again with every update
+    if (state->setSurroundingText(text, cursor, anchor, ClientConnectionPrivate::fromClient(resource->client()))) {
+        emit q->surroundingTextChanged();
+    }
 }
 
 void TextInputV2InterfacePrivate::zwp_text_input_v2_set_content_type(Resource *resource, uint32_t hint, uint32_t purpose)
 {
     Q_UNUSED(resource)
-    const auto contentHints = convertContentHint(hint);
-    const auto contentPurpose = convertContentPurpose(purpose);
-    if (this->contentHints != contentHints || this->contentPurpose != contentPurpose) {
-        this->contentHints = contentHints;
-        this->contentPurpose = contentPurpose;
+    if (state->setContentType(convertContentHint(hint), convertContentPurpose(purpose))) {
         emit q->contentTypeChanged();
     }
 }
@@ -334,31 +329,36 @@ void TextInputV2InterfacePrivate::zwp_text_input_v2_set_content_type(Resource *r
 void TextInputV2InterfacePrivate::zwp_text_input_v2_set_cursor_rectangle(Resource *resource, int32_t x, int32_t y, int32_t width, int32_t height)
 {
     Q_UNUSED(resource)
-    const QRect rect = QRect(x, y, width, height);
-    if (cursorRectangle != rect) {
-        cursorRectangle = rect;
-        emit q->cursorRectangleChanged(cursorRectangle);
+    if (state->setCursorRectangle(QRect(x, y, width, height))) {
+        emit q->cursorRectangleChanged(state->cursorRectangle);
     }
 }
 
 void TextInputV2InterfacePrivate::zwp_text_input_v2_set_preferred_language(Resource *resource, const QString &language)
 {
-    Q_UNUSED(resource)
     if (preferredLanguage != language) {
         preferredLanguage = language;
+        updateMemoryUsage(resource);
         emit q->preferredLanguageChanged(preferredLanguage);
     }
 }
 
+void TextInputV2InterfacePrivate::updateMemoryUsage(Resource *resource)
+{
+    // the state is shared by all clients on the seat, it's charged to the last one setting it
+    memoryAccount.setClient(ClientConnectionPrivate::fromClient(resource->client()));
+    memoryAccount.setBytes(preferredLanguage.size() * qint64(sizeof(QChar)));
+}
+
 void TextInputV2InterfacePrivate::zwp_text_input_v2_show_input_panel(Resource *resource)
 {
     Q_UNUSED(resource)
     emit q->requestShowInputPanel();
 }
 
-QList<TextInputV2InterfacePrivate::Resource *> TextInputV2InterfacePrivate::textInputsForClient(ClientConnection *client) const
+QVector<TextInputV2InterfacePrivate::Resource *> TextInputV2InterfacePrivate::textInputsForClient(ClientConnection *client) const
 {
-    return resourceMap().values(client->client());
+    return resourcesForClient(client->client());
 }
 
 TextInputV2Interface::TextInputV2Interface(SeatInterface *seat)
@@ -376,27 +376,27 @@ QString TextInputV2Interface::preferredLanguage() const
 
 TextInputContentHints TextInputV2Interface::contentHints() const
 {
-    return d->contentHints;
+    return d->state->contentHints;
 }
 
 TextInputContentPurpose KWaylandServer::TextInputV2Interface::contentPurpose() const
 {
-    return d->contentPurpose;
+    return d->state->contentPurpose;
 }
 
 QString TextInputV2Interface::surroundingText() const
 {
-    return d->surroundingText;
+    return d->state->surroundingText;
 }
 
 qint32 TextInputV2Interface::surroundingTextCursorPosition() const
 {
-    return d->surroundingTextCursorPosition;
+    return d->state->surroundingTextCursorPosition;
 }
 
 qint32 TextInputV2Interface::surroundingTextSelectionAnchor() const
 {
-    return d->surroundingTextSelectionAnchor;
+    return d->state->surroundingTextSelectionAnchor;
 }
 
 void TextInputV2Interface::preEdit(const QString &text, const QString &commit)
@@ -468,7 +468,7 @@ QPointer<SurfaceInterface> TextInputV2Interface::surface() const
 
 QRect TextInputV2Interface::cursorRectangle() const
 {
-    return d->cursorRectangle;
+    return d->state->cursorRectangle;
 }
 
 bool TextInputV2Interface::isEnabled() const
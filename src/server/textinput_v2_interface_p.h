@@ -6,10 +6,12 @@
 #ifndef KWAYLAND_SERVER_TEXTINPUT_INTERFACE_P_H
 #define KWAYLAND_SERVER_TEXTINPUT_INTERFACE_P_H
 #include "textinput_v2_interface.h"
-#include "clientconnection.h"
+#include "clientconnection_p.h"
+#include "textinputstate_p.h"
 
 #include <QPointer>
 #include <QRect>
+#include <QSharedPointer>
 #include <QVector>
 
 #include <qwayland-server-text-input-unstable-v2.h>
@@ -46,23 +48,21 @@ public:
     void keysymReleased(quint32 keysym, Qt::KeyboardModifiers modifiers);
     void sendInputPanelState();
     void sendLanguage();
+    void updateMemoryUsage(Resource *resource);
 
-    QList<Resource *> textInputsForClient(ClientConnection *client) const;
+    QVector<Resource *> textInputsForClient(ClientConnection *client) const;
     static TextInputV2InterfacePrivate *get(TextInputV2Interface *inputInterface) { return inputInterface->d.data(); }
 
     QString preferredLanguage;
-    QRect cursorRectangle;
-    TextInputContentHints contentHints = TextInputContentHint::None;
-    TextInputContentPurpose contentPurpose = TextInputContentPurpose::Normal;
+    // the surrounding text, content type and cursor rectangle, shared with text input v3
+    QSharedPointer<TextInputState> state = QSharedPointer<TextInputState>::create();
     SeatInterface *seat = nullptr;
     QPointer<SurfaceInterface> surface;
     bool enabled = false;
-    QString surroundingText;
-    qint32 surroundingTextCursorPosition = 0;
-    qint32 surroundingTextSelectionAnchor = 0;
     bool inputPanelVisible = false;
     QRect overlappedSurfaceArea;
     QString language;
+    ClientMemoryAccount memoryAccount{ClientMemoryCategory::TextInput};
     TextInputV2Interface *q;
 
 protected:
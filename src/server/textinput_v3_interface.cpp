@@ -145,10 +145,11 @@ void TextInputV3InterfacePrivate::zwp_text_input_v3_bind_resource(Resource *reso
     serialHash.insert(resource, 0);
 }
 
-void TextInputV3InterfacePrivate::zwp_text_input_v3_destroy(Resource *resource)
+void TextInputV3InterfacePrivate::zwp_text_input_v3_destroy_resource(Resource *resource)
 {
-    // drop resource from the serial hash
+    // drop resource from the serial hash, also when the client disconnects without destroying it
     serialHash.remove(resource);
+    enteredResources.remove(resource);
 }
 
 void TextInputV3InterfacePrivate::sendEnter(SurfaceInterface *s)
@@ -156,9 +157,17 @@ void TextInputV3InterfacePrivate::sendEnter(SurfaceInterface *s)
     if (!s) {
         return;
     }
+    if (surface != s) {
+        enteredResources.clear();
+    }
     surface = QPointer<SurfaceInterface>(s);
     const auto clientResources = textInputsForClient(s->client());
     for (auto resource : clientResources) {
+        // re-focusing the same surface only needs to enter the text inputs created meanwhile
+        if (enteredResources.contains(resource)) {
+            continue;
+        }
+        enteredResources.insert(resource);
         send_enter(resource->handle, s->resource());
     }
 }
@@ -169,6 +178,7 @@ void TextInputV3InterfacePrivate::sendLeave(SurfaceInterface *s)
         return;
     }
     surface.clear();
+    enteredResources.clear();
     const auto clientResources = textInputsForClient(s->client());
     for (auto resource : clientResources) {
         send_leave(resource->handle, s->resource());
@@ -180,7 +190,7 @@ void TextInputV3InterfacePrivate::sendPreEdit(const QString &text, const quint32
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_preedit_string(resource->handle, text, cursorBegin, cursorEnd);
     }
@@ -191,7 +201,7 @@ void TextInputV3InterfacePrivate::commitString(const QString &text)
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_commit_string(resource->handle, text);
     }
@@ -202,7 +212,7 @@ void TextInputV3InterfacePrivate::deleteSurroundingText(quint32 before, quint32
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         send_delete_surrounding_text(resource->handle, before, after);
     }
@@ -213,16 +223,16 @@ void TextInputV3InterfacePrivate::done()
     if (!surface) {
         return;
     }
-    const QList<Resource *> textInputs = textInputsForClient(surface->client());
+    const QVector<Resource *> textInputs = textInputsForClient(surface->client());
     for (auto resource : textInputs) {
         // zwp_text_input_v3.done takes the serial argument which is equal to number of commit requests issued
         send_done(resource->handle, serialHash[resource]);
     }
 }
 
-QList<TextInputV3InterfacePrivate::Resource *> TextInputV3InterfacePrivate::textInputsForClient(ClientConnection *client) const
+QVector<TextInputV3InterfacePrivate::Resource *> TextInputV3InterfacePrivate::textInputsForClient(ClientConnection *client) const
 {
-    return resourceMap().values(client->client());
+    return resourcesForClient(client->client());
 }
 
 void TextInputV3InterfacePrivate::zwp_text_input_v3_enable(Resource *resource)
@@ -242,7 +252,6 @@ void TextInputV3InterfacePrivate::zwp_text_input_v3_disable(Resource *resource)
 
 void TextInputV3InterfacePrivate::zwp_text_input_v3_set_surrounding_text(Resource *resource, const QString &text, int32_t cursor, int32_t anchor)
 {
-    Q_UNUSED(resource)
     // zwp_text_input_v3_set_surrounding_text is no-op if enabled request is not pending
     if (!pending.enabled) {
         return;
@@ -250,6 +259,7 @@ void TextInputV3InterfacePrivate::zwp_text_input_v3_set_surrounding_text(Resourc
     pending.surroundingText = text;
     pending.surroundingTextCursorPosition = cursor;
     pending.surroundingTextSelectionAnchor = anchor;
+    updateMemoryUsage(resource);
 }
 
 void TextInputV3InterfacePrivate::zwp_text_input_v3_set_content_type(Resource *resource, uint32_t hint, uint32_t purpose)
@@ -283,6 +293,13 @@ void TextInputV3InterfacePrivate::zwp_text_input_v3_set_text_change_cause(Resour
     pending.surroundingTextChangeCause = convertChangeCause(cause);
 }
 
+void TextInputV3InterfacePrivate::updateMemoryUsage(Resource *resource)
+{
+    // the state is shared by all clients on the seat, it's charged to the last one setting it
+    memoryAccount.setClient(ClientConnectionPrivate::fromClient(resource->client()));
+    memoryAccount.setBytes(pending.surroundingText.size() * qint64(sizeof(QChar)));
+}
+
 void TextInputV3InterfacePrivate::zwp_text_input_v3_commit(Resource *resource)
 {
     serialHash[resource]++;
@@ -297,25 +314,20 @@ void TextInputV3InterfacePrivate::zwp_text_input_v3_commit(Resource *resource)
         pending.surroundingTextChangeCause = TextInputChangeCause::InputMethod;
     }
 
-    if (contentHints != pending.contentHints || contentPurpose != pending.contentPurpose) {
-        contentHints = pending.contentHints;
-        contentPurpose = pending.contentPurpose;
+    if (state->setContentType(pending.contentHints, pending.contentPurpose)) {
         if (enabled) {
             emit q->contentTypeChanged();
         }
     }
 
-    if (cursorRectangle != pending.cursorRectangle) {
-        cursorRectangle = pending.cursorRectangle;
+    if (state->setCursorRectangle(pending.cursorRectangle)) {
         if (enabled) {
-            emit q->cursorRectangleChanged(cursorRectangle);
+            emit q->cursorRectangleChanged(state->cursorRectangle);
         }
     }
 
-    if (surroundingText != pending.surroundingText || surroundingTextCursorPosition != pending.surroundingTextCursorPosition || surroundingTextSelectionAnchor != pending.surroundingTextSelectionAnchor) {
-        surroundingText = pending.surroundingText;
-        surroundingTextCursorPosition = pending.surroundingTextCursorPosition;
-        surroundingTextSelectionAnchor = pending.surroundingTextSelectionAnchor;
+    if (state->setSurroundingText(pending.surroundingText, pending.surroundingTextCursorPosition, pending.surroundingTextSelectionAnchor,
+                                  ClientConnectionPrivate::fromClient(resource->client()))) {
         if (enabled) {
             emit q->surroundingTextChanged();
         }
@@ -346,27 +358,27 @@ TextInputV3Interface::~TextInputV3Interface() = default;
 
 TextInputContentHints TextInputV3Interface::contentHints() const
 {
-    return d->contentHints;
+    return d->state->contentHints;
 }
 
 TextInputContentPurpose TextInputV3Interface::contentPurpose() const
 {
-    return d->contentPurpose;
+    return d->state->contentPurpose;
 }
 
 QString TextInputV3Interface::surroundingText() const
 {
-    return d->surroundingText;
+    return d->state->surroundingText;
 }
 
 qint32 TextInputV3Interface::surroundingTextCursorPosition() const
 {
-    return d->surroundingTextCursorPosition;
+    return d->state->surroundingTextCursorPosition;
 }
 
 qint32 TextInputV3Interface::surroundingTextSelectionAnchor() const
 {
-    return d->surroundingTextSelectionAnchor;
+    return d->state->surroundingTextSelectionAnchor;
 }
 
 void TextInputV3Interface::deleteSurroundingText(quint32 beforeLength, quint32 afterLength)
@@ -396,7 +408,7 @@ QPointer<SurfaceInterface> TextInputV3Interface::surface() const
 
 QRect TextInputV3Interface::cursorRectangle() const
 {
-    return d->cursorRectangle;
+    return d->state->cursorRectangle;
 }
 
 bool TextInputV3Interface::isEnabled() const
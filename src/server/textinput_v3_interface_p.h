@@ -8,12 +8,15 @@
 #define KWAYLAND_SERVER_TEXTINPUT_V3_INTERFACE_P_H
 
 #include "textinput_v3_interface.h"
-#include "clientconnection.h"
+#include "clientconnection_p.h"
+#include "textinputstate_p.h"
 
 #include <QPointer>
 #include <QRect>
 #include <QVector>
 #include <QHash>
+#include <QSet>
+#include <QSharedPointer>
 
 #include <qwayland-server-text-input-unstable-v3.h>
 
@@ -44,22 +47,20 @@ public:
     void commitString(const QString &text);
     void deleteSurroundingText(quint32 beforeLength, quint32 afterLength);
     void done();
+    void updateMemoryUsage(Resource *resource);
 
-    QList<TextInputV3InterfacePrivate::Resource *> textInputsForClient(ClientConnection *client) const;
+    QVector<TextInputV3InterfacePrivate::Resource *> textInputsForClient(ClientConnection *client) const;
 
     static TextInputV3InterfacePrivate *get(TextInputV3Interface *inputInterface) { return inputInterface->d.data(); }
 
-    QRect cursorRectangle;
-    TextInputContentHints contentHints = TextInputContentHint::None;
-    TextInputContentPurpose contentPurpose = TextInputContentPurpose::Normal;
+    // the committed surrounding text, content type and cursor rectangle, shared with text
+    // input v2
+    QSharedPointer<TextInputState> state = QSharedPointer<TextInputState>::create();
 
     SeatInterface *seat = nullptr;
     QPointer<SurfaceInterface> surface;
     bool enabled = false;
 
-    QString surroundingText;
-    qint32 surroundingTextCursorPosition = 0;
-    qint32 surroundingTextSelectionAnchor = 0;
     TextInputChangeCause surroundingTextChangeCause = TextInputChangeCause::InputMethod;
 
     struct {
@@ -74,14 +75,17 @@ public:
     } pending;
 
     QHash<Resource *, quint32> serialHash;
+    // the resources that have been sent an enter for the current surface
+    QSet<Resource *> enteredResources;
 
     void defaultPending();
 
+    ClientMemoryAccount memoryAccount{ClientMemoryCategory::TextInput};
     TextInputV3Interface *q;
 
 protected:
     void zwp_text_input_v3_bind_resource(Resource *resource) override;
-    void zwp_text_input_v3_destroy(Resource *resource) override;
+    void zwp_text_input_v3_destroy_resource(Resource *resource) override;
     // requests
     void zwp_text_input_v3_enable(Resource *resource) override;
     void zwp_text_input_v3_disable(Resource *resource) override;
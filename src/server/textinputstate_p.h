@@ -0,0 +1,74 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include "clientconnection_p.h"
+#include "textinput.h"
+
+#include <QRect>
+#include <QString>
+
+namespace KWaylandServer
+{
+
+/**
+ * The state of the text input of a seat, shared by TextInputV2Interface and
+ * TextInputV3Interface. Only the focused surface gets text input, so there is one state for
+ * both versions; clients binding both report the same state twice.
+ *
+ * The setters return whether the state changed, so such a repeated update doesn't announce
+ * the change again through the other version.
+ */
+class TextInputState
+{
+public:
+    bool setSurroundingText(const QString &text, qint32 cursorPosition, qint32 selectionAnchor, ClientConnection *client)
+    {
+        if (surroundingText == text && surroundingTextCursorPosition == cursorPosition
+                && surroundingTextSelectionAnchor == selectionAnchor) {
+            return false;
+        }
+        surroundingText = text;
+        surroundingTextCursorPosition = cursorPosition;
+        surroundingTextSelectionAnchor = selectionAnchor;
+        // charged to the last client setting it
+        memoryAccount.setClient(client);
+        memoryAccount.setBytes(surroundingText.size() * qint64(sizeof(QChar)));
+        return true;
+    }
+
+    bool setContentType(TextInputContentHints hints, TextInputContentPurpose purpose)
+    {
+        if (contentHints == hints && contentPurpose == purpose) {
+            return false;
+        }
+        contentHints = hints;
+        contentPurpose = purpose;
+        return true;
+    }
+
+    bool setCursorRectangle(const QRect &rect)
+    {
+        if (cursorRectangle == rect) {
+            return false;
+        }
+        cursorRectangle = rect;
+        return true;
+    }
+
+    QRect cursorRectangle;
+    TextInputContentHints contentHints = TextInputContentHint::None;
+    TextInputContentPurpose contentPurpose = TextInputContentPurpose::Normal;
+    QString surroundingText;
+    qint32 surroundingTextCursorPosition = 0;
+    qint32 surroundingTextSelectionAnchor = 0;
+
+private:
+    ClientMemoryAccount memoryAccount{ClientMemoryCategory::TextInput};
+};
+
+} // namespace KWaylandServer
@@ -0,0 +1,24 @@
+/*
+    SPDX-FileCopyrightText: 2021 KWayland Server contributors
+
+    SPDX-License-Identifier: LGPL-2.1-only OR LGPL-3.0-only OR LicenseRef-KDE-Accepted-LGPL
+*/
+
+#pragma once
+
+#include <config-kwaylandserver.h>
+
+#include "logging_trace.h"
+
+/**
+ * Logs to the kwayland-server.trace category, meant for code paths running at frame rate.
+ *
+ * The arguments are only evaluated if the category is enabled at runtime, for example with
+ * QT_LOGGING_RULES="kwayland-server.trace.debug=true". Configuring with
+ * -DKWAYLANDSERVER_TRACING=OFF compiles the trace points out entirely.
+ */
+#if KWAYLANDSERVER_TRACING
+#define KWS_TRACE() qCDebug(KWAYLAND_SERVER_TRACE)
+#else
+#define KWS_TRACE() QT_NO_QDEBUG_MACRO()
+#endif
@@ -75,9 +75,9 @@ void ViewportInterface::wp_viewport_destroy(Resource *resource)
     if (surface) {
         SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
         surfacePrivate->pending.sourceGeometry = QRectF();
-        surfacePrivate->pending.sourceGeometryIsSet = true;
+        surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::SourceGeometryChanged;
         surfacePrivate->pending.destinationSize = QSize();
-        surfacePrivate->pending.destinationSizeIsSet = true;
+        surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::DestinationSizeChanged;
     }
 
     wl_resource_destroy(resource->handle);
@@ -99,7 +99,7 @@ void ViewportInterface::wp_viewport_set_source(Resource *resource, wl_fixed_t x_
     if (x == -1 && y == -1 && width == -1 && height == -1) {
         SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
         surfacePrivate->pending.sourceGeometry = QRectF();
-        surfacePrivate->pending.sourceGeometryIsSet = true;
+        surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::SourceGeometryChanged;
         return;
     }
 
@@ -110,7 +110,7 @@ void ViewportInterface::wp_viewport_set_source(Resource *resource, wl_fixed_t x_
 
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
     surfacePrivate->pending.sourceGeometry = QRectF(x, y, width, height);
-    surfacePrivate->pending.sourceGeometryIsSet = true;
+    surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::SourceGeometryChanged;
 }
 
 void ViewportInterface::wp_viewport_set_destination(Resource *resource, int32_t width, int32_t height)
@@ -124,7 +124,7 @@ void ViewportInterface::wp_viewport_set_destination(Resource *resource, int32_t
     if (width == -1 && height == -1) {
         SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
         surfacePrivate->pending.destinationSize = QSize();
-        surfacePrivate->pending.destinationSizeIsSet = true;
+        surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::DestinationSizeChanged;
         return;
     }
 
@@ -135,7 +135,7 @@ void ViewportInterface::wp_viewport_set_destination(Resource *resource, int32_t
 
     SurfaceInterfacePrivate *surfacePrivate = SurfaceInterfacePrivate::get(surface);
     surfacePrivate->pending.destinationSize = QSize(width, height);
-    surfacePrivate->pending.destinationSizeIsSet = true;
+    surfacePrivate->pending.changes |= SurfaceInterfacePrivate::State::DestinationSizeChanged;
 }
 
 ViewporterInterface::ViewporterInterface(Display *display, QObject *parent)
@@ -107,13 +107,11 @@ void XdgExporterV2InterfacePrivate::zxdg_exporter_v2_export_toplevel(Resource *r
             });
 
     //if the surface dies before this, this dies too
-    QObject::connect(SurfaceInterface::get(surface), &QObject::destroyed,
-            q, [this, xdgExported, handle]() {
-                if (xdgExported) {
-                    xdgExported->deleteLater();
-                }
+    //the connection is bound to the exported object, so it goes away along with it
+    QObject::connect(s, &QObject::destroyed,
+            xdgExported, [this, xdgExported, handle]() {
                 exportedSurfaces.remove(handle);
-                emit q->surfaceUnexported(handle);
+                xdgExported->deleteLater();
             });
 
     exportedSurfaces[handle] = xdgExported;
@@ -133,8 +131,12 @@ class XdgImporterV2InterfacePrivate : public QtWaylandServer::zxdg_importer_v2
 public:
     XdgImporterV2InterfacePrivate(XdgImporterV2Interface *_q, Display *display, XdgForeignV2Interface *foreignInterface);
 
+    void removeChild(XdgImportedV2Interface *imported);
+
     XdgForeignV2Interface *foreignInterface;
-    QHash<QString, XdgImportedV2Interface *> importedSurfaces;
+
+    //a handle can be imported several times
+    QMultiHash<QString, XdgImportedV2Interface *> importedSurfaces;
 
     //child->parent hash
     QHash<SurfaceInterface *, XdgImportedV2Interface *> parents;
@@ -203,63 +205,78 @@ void XdgImporterV2InterfacePrivate::zxdg_importer_v2_import_toplevel(Resource *r
     XdgImportedV2Interface * XdgImported = new XdgImportedV2Interface(surface, XdgImported_resource);
 
     //surface no longer exported
+    //the connection is bound to the imported object, so it goes away along with it
     QObject::connect(exp, &XdgExportedV2Interface::destroyed,
-            q, [this, XdgImported, handle, XdgImported_resource]() {
-                //imp valid when the exported is deleted before the imported
-                if (XdgImported) {
-                    zxdg_imported_v2_send_destroyed(XdgImported_resource);
-                    XdgImported->deleteLater();
-                }
-                importedSurfaces.remove(handle);
-                emit q->surfaceUnimported(handle);
+            XdgImported, [XdgImported_resource, XdgImported]() {
+                zxdg_imported_v2_send_destroyed(XdgImported_resource);
+                XdgImported->deleteLater();
             });
 
     QObject::connect(XdgImported, &XdgImportedV2Interface::childChanged,
             q, [this, XdgImported](SurfaceInterface *child) {
+                auto it = children.constFind(XdgImported);
+                const bool sameChild = it != children.constEnd() && *it == child;
+
                 //remove any previous association
-                auto it = children.find(XdgImported);
-                if (it != children.end()) {
-                    parents.remove(*it);
-                    children.erase(it);
+                if (!sameChild) {
+                    removeChild(XdgImported);
+
+                    //another imported surface may have been the parent of this child
+                    auto parentIt = parents.find(child);
+                    if (parentIt != parents.end()) {
+                        children.remove(*parentIt);
+                        parents.erase(parentIt);
+                    }
+
+                    parents[child] = XdgImported;
+                    children[XdgImported] = child;
+
+                    //child surface destroyed
+                    QObject::connect(child, &QObject::destroyed,
+                            XdgImported, [this, child, XdgImported]() {
+                                auto it = parents.find(child);
+                                if (it != parents.end() && *it == XdgImported) {
+                                    children.remove(XdgImported);
+                                    parents.erase(it);
+                                    emit q->transientChanged(nullptr, XdgImported->parentResource());
+                                }
+                            });
                 }
 
-                parents[child] = XdgImported;
-                children[XdgImported] = child;
                 SurfaceInterface *parent = XdgImported->parentResource();
                 emit q->transientChanged(child, parent);
-
-                //child surface destroyed
-                QObject::connect(child, &QObject::destroyed,
-                        q, [this, child]() {
-                            auto it = parents.find(child);
-                            if (it != parents.end()) {
-                                KWaylandServer::XdgImportedV2Interface* parent = *it;
-                                children.remove(*it);
-                                parents.erase(it);
-                                emit q->transientChanged(nullptr, parent->parentResource());
-                            }
-                        });
             });
 
     //surface no longer imported
     QObject::connect(XdgImported, &XdgImportedV2Interface::destroyed,
             q, [this, handle, XdgImported]() {
-                importedSurfaces.remove(handle);
+                importedSurfaces.remove(handle, XdgImported);
                 emit q->surfaceUnimported(handle);
 
-                auto it = children.find(XdgImported);
-                if (it != children.end()) {
-                    KWaylandServer::SurfaceInterface* child = *it;
-                    parents.remove(*it);
-                    children.erase(it);
+                SurfaceInterface *child = children.value(XdgImported);
+                if (child) {
+                    removeChild(XdgImported);
                     emit q->transientChanged(child, nullptr);
                 }
             });
 
-    importedSurfaces[handle] = XdgImported;
+    importedSurfaces.insert(handle, XdgImported);
     emit q->surfaceImported(handle, XdgImported);
 }
 
+void XdgImporterV2InterfacePrivate::removeChild(XdgImportedV2Interface *imported)
+{
+    auto it = children.find(imported);
+    if (it == children.end()) {
+        return;
+    }
+    auto parentIt = parents.find(*it);
+    if (parentIt != parents.end() && *parentIt == imported) {
+        parents.erase(parentIt);
+    }
+    children.erase(it);
+}
+
 XdgImporterV2InterfacePrivate::XdgImporterV2InterfacePrivate(XdgImporterV2Interface *_q, Display *display, XdgForeignV2Interface *foreignInterface)
     : QtWaylandServer::zxdg_importer_v2(*display, s_importerVersion)
     , foreignInterface(foreignInterface)
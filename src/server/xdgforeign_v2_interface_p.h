@@ -79,7 +79,7 @@ public:
     SurfaceInterface *parentResource();
 
 private:
-    SurfaceInterface *surface;
+    QPointer<SurfaceInterface> surface;
 
 protected:
     void zxdg_exported_v2_destroy(Resource *resource) override;
@@ -6,17 +6,19 @@
 */
 #include "xdgoutput_v1_interface.h"
 #include "display.h"
+#include "display_p.h"
 #include "output_interface.h"
 
 #include "qwayland-server-xdg-output-unstable-v1.h"
 
 #include <QHash>
 #include <QDebug>
+#include <QPointer>
 
 namespace KWaylandServer
 {
 
-static const quint32 s_version = 2;
+static const quint32 s_version = 3;
 
 class XdgOutputManagerV1InterfacePrivate : public QtWaylandServer::zxdg_output_manager_v1
 {
@@ -25,6 +27,7 @@ public:
     QHash<OutputInterface *, XdgOutputV1Interface *> outputs;
 
     XdgOutputManagerV1Interface *q;
+    Display *display;
 
 protected:
     void zxdg_output_manager_v1_destroy(Resource *resource) override;
@@ -34,19 +37,42 @@ protected:
 class XdgOutputV1InterfacePrivate : public QtWaylandServer::zxdg_output_v1
 {
 public:
+    struct SentGeometry {
+        QPoint pos;
+        QSize size;
+    };
+
+    QSize logicalSize(wl_client *client) const;
+    /**
+     * Sends the logical geometry that differs from what @p resource last got, as recorded
+     * in @p sent.
+     * @returns whether anything was sent
+     */
+    bool sendGeometry(Resource *resource, SentGeometry *sent);
+    void sendDone(Resource *resource);
+
+    QPointer<Display> display;
+    QPointer<OutputInterface> output;
     QPoint pos;
     QSize size;
     QString name;
     QString description;
-    bool dirty = false;
     bool doneOnce = false;
+    int updateDepth = 0;
+    // done() was called during an update, commitUpdate() has to send it
+    bool donePending = false;
 
     // casper_yang for scale
     qreal appDefaultScale = 1.;
     QHash<wl_client*, qreal> clientsScale;
 
+    // the logical geometry as last sent to each resource, so done() only sends what changed;
+    // holds every bound resource, done() walks it instead of copying the resource map
+    QHash<Resource *, SentGeometry> sentGeometry;
+
 protected:
     void zxdg_output_v1_bind_resource(Resource *resource) override;
+    void zxdg_output_v1_destroy_resource(Resource *resource) override;
     void zxdg_output_v1_destroy(Resource *resource) override;
 };
 
@@ -64,7 +90,7 @@ XdgOutputV1Interface * XdgOutputManagerV1Interface::createXdgOutput(OutputInterf
 {
     Q_ASSERT_X(!d->outputs.contains(output), "createXdgOutput", "An XdgOuputInterface already exists for this output");
 
-    auto xdgOutput = new XdgOutputV1Interface(parent);
+    auto xdgOutput = new XdgOutputV1Interface(output, d->display, parent);
     d->outputs[output] = xdgOutput;
 
     //as XdgOutput lifespan is managed by user, delete our mapping when either
@@ -83,6 +109,7 @@ XdgOutputV1Interface * XdgOutputManagerV1Interface::createXdgOutput(OutputInterf
 XdgOutputManagerV1InterfacePrivate::XdgOutputManagerV1InterfacePrivate(XdgOutputManagerV1Interface *qptr, Display *d)
     : QtWaylandServer::zxdg_output_manager_v1(*d, s_version)
     , q(qptr)
+    , display(d)
 {
 }
 
@@ -104,14 +131,25 @@ void XdgOutputManagerV1InterfacePrivate::zxdg_output_manager_v1_destroy(Resource
     wl_resource_destroy(resource->handle);
 }
 
-XdgOutputV1Interface::XdgOutputV1Interface(QObject *parent)
+XdgOutputV1Interface::XdgOutputV1Interface(OutputInterface *output, Display *display, QObject *parent)
     : QObject(parent)
     , d(new XdgOutputV1InterfacePrivate())
 {
+    d->display = display;
+    d->output = output;
+    DisplayPrivate *displayPrivate = DisplayPrivate::get(display);
+    displayPrivate->xdgOutputs.append(this);
+    if (displayPrivate->outputLayoutUpdateDepth > 0) {
+        // created in the middle of a layout update, the changes go out with the others
+        beginUpdate();
+    }
 }
 
 XdgOutputV1Interface::~XdgOutputV1Interface()
 {
+    if (d->display) {
+        DisplayPrivate::get(d->display)->xdgOutputs.removeOne(this);
+    }
 #if QT_VERSION < QT_VERSION_CHECK(5, 15, 2)
     // Starting from 5.15.2, qtwaylandscanner properly handles destruction of inert/orphaned resources.
 
@@ -130,19 +168,7 @@ XdgOutputV1Interface::~XdgOutputV1Interface()
 
 void XdgOutputV1Interface::setLogicalSize(const QSize &size)
 {
-    if (size == d->size) {
-        return;
-    }
     d->size = size;
-    d->dirty = true;
-    for (auto resource : d->resourceMap()) {
-        // casper_yang for scale
-        qreal _scale = d->appDefaultScale;
-        if (d->clientsScale.contains(resource->client())) {
-            _scale = d->clientsScale[resource->client()];
-        }
-        d->send_logical_size(resource->handle, size.width()/_scale, size.height()/_scale);
-    }
 }
 
 QSize XdgOutputV1Interface::logicalSize() const
@@ -152,14 +178,7 @@ QSize XdgOutputV1Interface::logicalSize() const
 
 void XdgOutputV1Interface::setLogicalPosition(const QPoint &pos)
 {
-    if (pos == d->pos) {
-        return;
-    }
     d->pos = pos;
-    d->dirty = true;
-    for (auto resource : d->resourceMap()) {
-        d->send_logical_position(resource->handle, pos.x(), pos.y());
-    }
 }
 
 QPoint XdgOutputV1Interface::logicalPosition() const
@@ -181,13 +200,29 @@ void XdgOutputV1Interface::setDescription(const QString &description)
 
 void XdgOutputV1Interface::done()
 {
-    d->doneOnce = true;
-    if (!d->dirty) {
+    if (d->updateDepth > 0) {
+        d->donePending = true;
         return;
     }
-    d->dirty = false;
-    for (auto resource : d->resourceMap()) {
-        d->send_done(resource->handle);
+    d->donePending = false;
+    d->doneOnce = true;
+    for (auto it = d->sentGeometry.begin(); it != d->sentGeometry.end(); ++it) {
+        if (d->sendGeometry(it.key(), &it.value())) {
+            d->sendDone(it.key());
+        }
+    }
+}
+
+void XdgOutputV1Interface::beginUpdate()
+{
+    d->updateDepth++;
+}
+
+void XdgOutputV1Interface::commitUpdate()
+{
+    Q_ASSERT(d->updateDepth > 0);
+    if (--d->updateDepth == 0 && d->donePending) {
+        done();
     }
 }
 
@@ -195,17 +230,17 @@ void XdgOutputV1Interface::done()
 void XdgOutputV1Interface::setClientScale(wl_client *client, qreal scale)
 {
     d->clientsScale.insert(client, scale);
-    bool dirty = false;
-    for (auto resource : d->resourceMap()) {
-        // casper_yang for scale
-        if (resource->client() == client) {
-            d->send_logical_size(resource->handle, d->size.width()/scale, d->size.height()/scale);
-            d->send_done(resource->handle);
-            dirty = true;
+    if (d->updateDepth > 0) {
+        // sent with the other changes by commitUpdate()
+        d->donePending = true;
+        return;
+    }
+    const auto clientResources = d->resourcesForClient(client);
+    for (auto resource : clientResources) {
+        if (d->sendGeometry(resource, &d->sentGeometry[resource])) {
+            d->sendDone(resource);
         }
     }
-
-    d->dirty = dirty;
 }
 
 // casper_yang for scale
@@ -232,28 +267,63 @@ void XdgOutputV1Interface::setAppDefaultScale(qreal scale)
 //    done();
 }
 
+QSize XdgOutputV1InterfacePrivate::logicalSize(wl_client *client) const
+{
+    // casper_yang for scale
+    const qreal scale = clientsScale.value(client, appDefaultScale);
+    return QSize(size.width() / scale, size.height() / scale);
+}
+
+bool XdgOutputV1InterfacePrivate::sendGeometry(Resource *resource, SentGeometry *sent)
+{
+    bool changed = false;
+    if (sent->pos != pos) {
+        sent->pos = pos;
+        send_logical_position(resource->handle, pos.x(), pos.y());
+        changed = true;
+    }
+    const QSize clientSize = logicalSize(resource->client());
+    if (sent->size != clientSize) {
+        sent->size = clientSize;
+        send_logical_size(resource->handle, clientSize.width(), clientSize.height());
+        changed = true;
+    }
+    return changed;
+}
+
+void XdgOutputV1InterfacePrivate::sendDone(Resource *resource)
+{
+    if (resource->version() >= 3) {
+        // version 3 deprecates the done event in favor of the one of wl_output
+        if (output) {
+            output->done(resource->client());
+        }
+    } else {
+        send_done(resource->handle);
+    }
+}
+
 void XdgOutputV1InterfacePrivate::zxdg_output_v1_destroy(Resource *resource)
 {
     wl_resource_destroy(resource->handle);
 }
 
+void XdgOutputV1InterfacePrivate::zxdg_output_v1_destroy_resource(Resource *resource)
+{
+    sentGeometry.remove(resource);
+}
+
 void XdgOutputV1InterfacePrivate::zxdg_output_v1_bind_resource(Resource *resource)
 {
+    SentGeometry &sent = sentGeometry[resource];
+    sent.pos = pos;
+    sent.size = logicalSize(resource->client());
     send_logical_position(resource->handle, pos.x(), pos.y());
-    // casper_yang for scale
-    qreal _scale = appDefaultScale;
-    if (clientsScale.contains(resource->client())) {
-        _scale = clientsScale[resource->client()];
-    }
-    send_logical_size(resource->handle, size.width()/_scale, size.height()/_scale);
-    if (resource->version() >= ZXDG_OUTPUT_V1_NAME_SINCE_VERSION) {
-        send_name(resource->handle, name);
-    }
-    if (resource->version() >= ZXDG_OUTPUT_V1_DESCRIPTION_SINCE_VERSION) {
-        send_description(resource->handle, description);
-    }
+    send_logical_size(resource->handle, sent.size.width(), sent.size.height());
+    send_name_if_supported(resource->handle, name);
+    send_description_if_supported(resource->handle, description);
     if (doneOnce) {
-        send_done(resource->handle);
+        sendDone(resource);
     }
 }
 
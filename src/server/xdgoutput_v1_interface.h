@@ -109,17 +109,35 @@ public:
     void description() const;
 
     /**
-     * Submit changes to all clients
+     * Submit changes to all clients. Only the logical geometry that changed for a client
+     * is sent. Clients binding version 3 get the wl_output done event instead of the
+     * xdg_output one, so the changes apply together with those of the OutputInterface.
      */
     void done();
 
+    /**
+     * Starts a batch of property changes. done() has no effect until the matching
+     * commitUpdate(), which then calls it once if it was called during the batch. This allows
+     * wrapping the changes of a mode switch together with OutputInterface::beginUpdate().
+     *
+     * Calls can be nested, the done event is sent by the outermost commitUpdate().
+     * @since 5.22
+     */
+    void beginUpdate();
+    /**
+     * Ends the batch started by beginUpdate() and submits the changes to all clients if
+     * done() was called during the batch.
+     * @since 5.22
+     */
+    void commitUpdate();
+
     // casper_yang for scale
     void setClientScale(wl_client* client, qreal scale);
     void unsetClientScale(wl_client* client);
 
     void setAppDefaultScale(qreal scale);
 private:
-    explicit XdgOutputV1Interface(QObject *parent);
+    explicit XdgOutputV1Interface(OutputInterface *output, Display *display, QObject *parent);
     friend class XdgOutputManagerV1Interface;
     friend class XdgOutputManagerV1InterfacePrivate;
 
@@ -7,21 +7,29 @@
 #include "xdgshell_interface.h"
 #include "xdgshell_interface_p.h"
 
+#include "clientconnection.h"
 #include "display.h"
 #include "output_interface.h"
 #include "seat_interface.h"
 #include "utils.h"
 
-#include <QTimer>
+#include <algorithm>
 
 namespace KWaylandServer
 {
 
 static const int s_version = 3;
+static const qint64 s_pingInterval = 1000;
 
-XdgShellInterfacePrivate::XdgShellInterfacePrivate(XdgShellInterface *shell)
+XdgShellInterfacePrivate::XdgShellInterfacePrivate(XdgShellInterface *shell, Display *display)
     : q(shell)
+    , display(display)
+    , pingTimer(display)
 {
+    pingClock.start();
+    pingTimer.setCallback([this]() {
+        processPings();
+    });
 }
 
 static wl_client *clientFromXdgSurface(XdgSurfaceInterface *surface)
@@ -44,25 +52,86 @@ void XdgShellInterfacePrivate::unregisterXdgSurface(XdgSurfaceInterface *surface
     xdgSurfaces.remove(clientFromXdgSurface(surface), surface);
 }
 
+quint32 XdgShellInterfacePrivate::sendPing(Resource *resource)
+{
+    const quint32 serial = display->nextSerial();
+    send_ping(resource->handle, serial);
+    registerPing(serial);
+    return serial;
+}
+
 /**
  * @todo Whether the ping is delayed or has timed out is out of domain of the XdgShellInterface.
  * Such matter must be handled somewhere else, e.g. XdgToplevelClient, not here!
  */
 void XdgShellInterfacePrivate::registerPing(quint32 serial)
 {
-    QTimer *timer = new QTimer(q);
-    timer->setInterval(1000);
-    QObject::connect(timer, &QTimer::timeout, q, [this, serial, attempt = 0]() mutable {
-        ++attempt;
-        if (attempt == 1) {
-            emit q->pingDelayed(serial);
-            return;
+    pings.insert(serial);
+    pingQueue.enqueue(PendingPing{serial, pingClock.elapsed()});
+    if (!pingTimer.isActive()) {
+        schedulePingTimer();
+    }
+}
+
+void XdgShellInterfacePrivate::schedulePingTimer()
+{
+    while (!pingQueue.isEmpty() && !pings.contains(pingQueue.head().serial)) {
+        pingQueue.dequeue();
+    }
+    while (!delayedPingQueue.isEmpty() && !pings.contains(delayedPingQueue.head().serial)) {
+        delayedPingQueue.dequeue();
+    }
+
+    qint64 deadline = -1;
+    if (!pingQueue.isEmpty()) {
+        deadline = pingQueue.head().sent + s_pingInterval;
+    }
+    if (!delayedPingQueue.isEmpty()) {
+        const qint64 timeout = delayedPingQueue.head().sent + 2 * s_pingInterval;
+        if (deadline == -1 || timeout < deadline) {
+            deadline = timeout;
         }
-        emit q->pingTimeout(serial);
-        delete pings.take(serial);
-    });
-    pings.insert(serial, timer);
-    timer->start();
+    }
+
+    if (deadline == -1) {
+        pingTimer.stop();
+    } else {
+        pingTimer.start(deadline - pingClock.elapsed());
+    }
+}
+
+void XdgShellInterfacePrivate::processPings()
+{
+    const qint64 now = pingClock.elapsed();
+
+    // Dequeue before emitting, connected slots may send new pings.
+    while (!pingQueue.isEmpty() && pingQueue.head().sent + s_pingInterval <= now) {
+        const PendingPing ping = pingQueue.dequeue();
+        if (pings.contains(ping.serial)) {
+            delayedPingQueue.enqueue(ping);
+            emit q->pingDelayed(ping.serial);
+        }
+    }
+    while (!delayedPingQueue.isEmpty() && delayedPingQueue.head().sent + 2 * s_pingInterval <= now) {
+        const PendingPing ping = delayedPingQueue.dequeue();
+        if (pings.remove(ping.serial)) {
+            emit q->pingTimeout(ping.serial);
+        }
+    }
+
+    schedulePingTimer();
+}
+
+QHash<ClientConnection *, quint32> XdgShellInterfacePrivate::pingAll()
+{
+    QHash<ClientConnection *, quint32> serials;
+    const QList<wl_client *> clients = xdgSurfaces.uniqueKeys();
+    for (wl_client *client : clients) {
+        if (Resource *resource = resourceMap().value(client)) {
+            serials.insert(display->getConnection(client), sendPing(resource));
+        }
+    }
+    return serials;
 }
 
 XdgShellInterfacePrivate *XdgShellInterfacePrivate::get(XdgShellInterface *shell)
@@ -108,17 +177,15 @@ void XdgShellInterfacePrivate::xdg_wm_base_get_xdg_surface(Resource *resource, u
 void XdgShellInterfacePrivate::xdg_wm_base_pong(Resource *resource, uint32_t serial)
 {
     Q_UNUSED(resource)
-    if (QTimer *timer = pings.take(serial)) {
-        delete timer;
+    if (pings.remove(serial)) {
         emit q->pongReceived(serial);
     }
 }
 
 XdgShellInterface::XdgShellInterface(Display *display, QObject *parent)
     : QObject(parent)
-    , d(new XdgShellInterfacePrivate(this))
+    , d(new XdgShellInterfacePrivate(this, display))
 {
-    d->display = display;
     d->init(*display, s_version);
 }
 
@@ -137,11 +204,12 @@ quint32 XdgShellInterface::ping(XdgSurfaceInterface *surface)
     if (!clientResource)
         return 0;
 
-    quint32 serial = d->display->nextSerial();
-    d->send_ping(clientResource->handle, serial);
-    d->registerPing(serial);
+    return d->sendPing(clientResource);
+}
 
-    return serial;
+QHash<ClientConnection *, quint32> XdgShellInterface::pingAll()
+{
+    return d->pingAll();
 }
 
 XdgSurfaceInterfacePrivate::XdgSurfaceInterfacePrivate(XdgSurfaceInterface *xdgSurface)
@@ -191,7 +259,7 @@ void XdgSurfaceInterfacePrivate::xdg_surface_get_toplevel(Resource *resource, ui
     if (surfaceRole) {
         wl_resource_post_error(resource->handle, error_already_constructed,
                                "the surface already has a role assigned %s",
-                               surfaceRole->name().constData());
+                               surfaceRole->name());
         return;
     }
 
@@ -210,7 +278,7 @@ void XdgSurfaceInterfacePrivate::xdg_surface_get_popup(Resource *resource, uint3
     if (surfaceRole) {
         wl_resource_post_error(resource->handle, error_already_constructed,
                                "the surface already has a role assigned %s",
-                               surfaceRole->name().constData());
+                               surfaceRole->name());
         return;
     }
 
@@ -259,6 +327,9 @@ void XdgSurfaceInterfacePrivate::xdg_surface_ack_configure(Resource *resource, u
 {
     Q_UNUSED(resource)
     emit q->configureAcknowledged(serial);
+    if (toplevel) {
+        XdgToplevelInterfacePrivate::get(toplevel)->handleConfigureAcknowledged(serial);
+    }
 }
 
 XdgSurfaceInterface::XdgSurfaceInterface(XdgShellInterface *shell, SurfaceInterface *surface,
@@ -314,7 +385,7 @@ XdgSurfaceInterface *XdgSurfaceInterface::get(::wl_resource *resource)
 
 XdgToplevelInterfacePrivate::XdgToplevelInterfacePrivate(XdgToplevelInterface *toplevel,
                                                          XdgSurfaceInterface *surface)
-    : SurfaceRole(surface->surface(), QByteArrayLiteral("xdg_toplevel"))
+    : SurfaceRole(surface->surface(), SurfaceRole::Type::XdgToplevel)
     , q(toplevel)
     , xdgSurface(surface)
 {
@@ -355,11 +426,27 @@ void XdgToplevelInterfacePrivate::reset()
 
     windowTitle = QString();
     windowClass = QString();
+    rawWindowTitle = QByteArray();
+    rawWindowClass = QByteArray();
     current = next = State();
+    inFlightConfigure = 0;
+    hasDeferredConfigure = false;
 
     emit q->resetOccurred();
 }
 
+void XdgToplevelInterfacePrivate::handleConfigureAcknowledged(quint32 serial)
+{
+    if (!inFlightConfigure || serial != inFlightConfigure) {
+        return;
+    }
+    inFlightConfigure = 0;
+    if (hasDeferredConfigure) {
+        hasDeferredConfigure = false;
+        sendConfigure(deferredSize, deferredStates);
+    }
+}
+
 void XdgToplevelInterfacePrivate::xdg_toplevel_destroy_resource(Resource *resource)
 {
     Q_UNUSED(resource)
@@ -383,24 +470,27 @@ void XdgToplevelInterfacePrivate::xdg_toplevel_set_parent(Resource *resource,
     emit q->parentXdgToplevelChanged();
 }
 
-void XdgToplevelInterfacePrivate::xdg_toplevel_set_title(Resource *resource, const QString &title)
+void XdgToplevelInterfacePrivate::xdg_toplevel_set_title(Resource *resource, const char *title)
 {
     Q_UNUSED(resource)
-    if (windowTitle == title) {
+    // compare the raw bytes, clients tend to set the same title over and over again
+    if (rawWindowTitle == title) {
         return;
     }
-    windowTitle = title;
-    emit q->windowTitleChanged(title);
+    rawWindowTitle = title;
+    windowTitle = QString::fromUtf8(rawWindowTitle);
+    emit q->windowTitleChanged(windowTitle);
 }
 
-void XdgToplevelInterfacePrivate::xdg_toplevel_set_app_id(Resource *resource, const QString &app_id)
+void XdgToplevelInterfacePrivate::xdg_toplevel_set_app_id(Resource *resource, const char *app_id)
 {
     Q_UNUSED(resource)
-    if (windowClass == app_id) {
+    if (rawWindowClass == app_id) {
         return;
     }
-    windowClass = app_id;
-    emit q->windowClassChanged(app_id);
+    rawWindowClass = app_id;
+    windowClass = QString::fromUtf8(rawWindowClass);
+    emit q->windowClassChanged(windowClass);
 }
 
 void XdgToplevelInterfacePrivate::xdg_toplevel_show_window_menu(Resource *resource, ::wl_resource *seatResource,
@@ -576,54 +666,99 @@ QSize XdgToplevelInterface::maximumSize() const
     return d->current.maximumSize.isEmpty() ? QSize(INT_MAX, INT_MAX) : d->current.maximumSize;
 }
 
-quint32 XdgToplevelInterface::sendConfigure(const QSize &size, const States &states)
+const QByteArray &XdgToplevelInterfacePrivate::encodedStates(const XdgToplevelInterface::States &states)
 {
+    if (hasEncodedStates && states == lastStates) {
+        return lastEncodedStates;
+    }
     // Note that the states listed in the configure event must be an array of uint32_t.
 
     uint32_t statesData[8] = { 0 };
     int i = 0;
 
-    if (states & State::MaximizedHorizontal && states & State::MaximizedVertical) {
+    if (states & XdgToplevelInterface::State::MaximizedHorizontal && states & XdgToplevelInterface::State::MaximizedVertical) {
         statesData[i++] = QtWaylandServer::xdg_toplevel::state_maximized;
     }
-    if (states & State::FullScreen) {
+    if (states & XdgToplevelInterface::State::FullScreen) {
         statesData[i++] = QtWaylandServer::xdg_toplevel::state_fullscreen;
     }
-    if (states & State::Resizing) {
+    if (states & XdgToplevelInterface::State::Resizing) {
         statesData[i++] = QtWaylandServer::xdg_toplevel::state_resizing;
     }
-    if (states & State::Activated) {
+    if (states & XdgToplevelInterface::State::Activated) {
         statesData[i++] = QtWaylandServer::xdg_toplevel::state_activated;
     }
 
-    if (d->resource()->version() >= XDG_TOPLEVEL_STATE_TILED_LEFT_SINCE_VERSION) {
-        if (states & State::TiledLeft) {
+    if (resource()->version() >= XDG_TOPLEVEL_STATE_TILED_LEFT_SINCE_VERSION) {
+        if (states & XdgToplevelInterface::State::TiledLeft) {
             statesData[i++] = QtWaylandServer::xdg_toplevel::state_tiled_left;
         }
-        if (states & State::TiledTop) {
+        if (states & XdgToplevelInterface::State::TiledTop) {
             statesData[i++] = QtWaylandServer::xdg_toplevel::state_tiled_top;
         }
-        if (states & State::TiledRight) {
+        if (states & XdgToplevelInterface::State::TiledRight) {
             statesData[i++] = QtWaylandServer::xdg_toplevel::state_tiled_right;
         }
-        if (states & State::TiledBottom) {
+        if (states & XdgToplevelInterface::State::TiledBottom) {
             statesData[i++] = QtWaylandServer::xdg_toplevel::state_tiled_bottom;
         }
     }
 
-    const QByteArray xdgStates = QByteArray::fromRawData(reinterpret_cast<char *>(statesData),
-                                                         sizeof(uint32_t) * i);
-    const quint32 serial = xdgSurface()->shell()->display()->nextSerial();
+    lastEncodedStates = QByteArray(reinterpret_cast<char *>(statesData), sizeof(uint32_t) * i);
+    lastStates = states;
+    hasEncodedStates = true;
+    return lastEncodedStates;
+}
 
-    d->send_configure(size.width(), size.height(), xdgStates);
+quint32 XdgToplevelInterfacePrivate::sendConfigure(const QSize &size, const XdgToplevelInterface::States &states)
+{
+    const quint32 serial = xdgSurface->shell()->display()->nextSerial();
 
-    auto xdgSurfacePrivate = XdgSurfaceInterfacePrivate::get(xdgSurface());
+    send_configure(size.width(), size.height(), encodedStates(states));
+
+    auto xdgSurfacePrivate = XdgSurfaceInterfacePrivate::get(xdgSurface);
     xdgSurfacePrivate->send_configure(serial);
     xdgSurfacePrivate->isConfigured = true;
 
+    if (configureCoalescing) {
+        inFlightConfigure = serial;
+    }
+    emit q->configureSent(serial, size, states);
+
     return serial;
 }
 
+quint32 XdgToplevelInterface::sendConfigure(const QSize &size, const States &states)
+{
+    if (d->inFlightConfigure) {
+        d->hasDeferredConfigure = true;
+        d->deferredSize = size;
+        d->deferredStates = states;
+        return 0;
+    }
+    return d->sendConfigure(size, states);
+}
+
+bool XdgToplevelInterface::isConfigureCoalescingEnabled() const
+{
+    return d->configureCoalescing;
+}
+
+void XdgToplevelInterface::setConfigureCoalescingEnabled(bool enabled)
+{
+    if (d->configureCoalescing == enabled) {
+        return;
+    }
+    d->configureCoalescing = enabled;
+    if (!enabled) {
+        d->inFlightConfigure = 0;
+        if (d->hasDeferredConfigure) {
+            d->hasDeferredConfigure = false;
+            d->sendConfigure(d->deferredSize, d->deferredStates);
+        }
+    }
+}
+
 void XdgToplevelInterface::sendClose()
 {
     d->send_close();
@@ -644,7 +779,7 @@ XdgPopupInterfacePrivate *XdgPopupInterfacePrivate::get(XdgPopupInterface *popup
 
 XdgPopupInterfacePrivate::XdgPopupInterfacePrivate(XdgPopupInterface *popup,
                                                    XdgSurfaceInterface *surface)
-    : SurfaceRole(surface->surface(), QByteArrayLiteral("xdg_popup"))
+    : SurfaceRole(surface->surface(), SurfaceRole::Type::XdgPopup)
     , q(popup)
     , xdgSurface(surface)
 {
@@ -796,6 +931,12 @@ XdgPositionerPrivate *XdgPositionerPrivate::get(wl_resource *resource)
     return resource_cast<XdgPositionerPrivate *>(resource);
 }
 
+XdgPositionerData *XdgPositionerPrivate::editData()
+{
+    data->placementCached = false;
+    return data.data();
+}
+
 void XdgPositionerPrivate::xdg_positioner_destroy_resource(Resource *resource)
 {
     Q_UNUSED(resource)
@@ -814,7 +955,7 @@ void XdgPositionerPrivate::xdg_positioner_set_size(Resource *resource, int32_t w
                                "width and height must be positive and non-zero");
         return;
     }
-    data->size = QSize(width, height);
+    editData()->size = QSize(width, height);
 }
 
 void XdgPositionerPrivate::xdg_positioner_set_anchor_rect(Resource *resource, int32_t x, int32_t y,
@@ -825,7 +966,7 @@ void XdgPositionerPrivate::xdg_positioner_set_anchor_rect(Resource *resource, in
                                "width and height must be positive and non-zero");
         return;
     }
-    data->anchorRect = QRect(x, y, width, height);
+    editData()->anchorRect = QRect(x, y, width, height);
 }
 
 void XdgPositionerPrivate::xdg_positioner_set_anchor(Resource *resource, uint32_t anchor)
@@ -837,31 +978,31 @@ void XdgPositionerPrivate::xdg_positioner_set_anchor(Resource *resource, uint32_
 
     switch (anchor) {
     case anchor_top:
-        data->anchorEdges = Qt::TopEdge;
+        editData()->anchorEdges = Qt::TopEdge;
         break;
     case anchor_top_right:
-        data->anchorEdges = Qt::TopEdge | Qt::RightEdge;
+        editData()->anchorEdges = Qt::TopEdge | Qt::RightEdge;
         break;
     case anchor_right:
-        data->anchorEdges = Qt::RightEdge;
+        editData()->anchorEdges = Qt::RightEdge;
         break;
     case anchor_bottom_right:
-        data->anchorEdges = Qt::BottomEdge | Qt::RightEdge;
+        editData()->anchorEdges = Qt::BottomEdge | Qt::RightEdge;
         break;
     case anchor_bottom:
-        data->anchorEdges = Qt::BottomEdge;
+        editData()->anchorEdges = Qt::BottomEdge;
         break;
     case anchor_bottom_left:
-        data->anchorEdges = Qt::BottomEdge | Qt::LeftEdge;
+        editData()->anchorEdges = Qt::BottomEdge | Qt::LeftEdge;
         break;
     case anchor_left:
-        data->anchorEdges = Qt::LeftEdge;
+        editData()->anchorEdges = Qt::LeftEdge;
         break;
     case anchor_top_left:
-        data->anchorEdges = Qt::TopEdge | Qt::LeftEdge;
+        editData()->anchorEdges = Qt::TopEdge | Qt::LeftEdge;
         break;
     default:
-        data->anchorEdges = Qt::Edges();
+        editData()->anchorEdges = Qt::Edges();
         break;
     }
 }
@@ -869,19 +1010,19 @@ void XdgPositionerPrivate::xdg_positioner_set_anchor(Resource *resource, uint32_
 void XdgPositionerPrivate::xdg_positioner_set_parent_size(Resource *resource, int32_t width, int32_t height)
 {
     Q_UNUSED(resource)
-    data->parentSize = QSize(width, height);
+    editData()->parentSize = QSize(width, height);
 }
 
 void XdgPositionerPrivate::xdg_positioner_set_reactive(Resource *resource)
 {
     Q_UNUSED(resource)
-    data->isReactive = true;
+    editData()->isReactive = true;
 }
 
 void XdgPositionerPrivate::xdg_positioner_set_parent_configure(Resource *resource, uint32_t serial)
 {
     Q_UNUSED(resource)
-    data->parentConfigure = serial;
+    editData()->parentConfigure = serial;
 }
 
 void XdgPositionerPrivate::xdg_positioner_set_gravity(Resource *resource, uint32_t gravity)
@@ -893,31 +1034,31 @@ void XdgPositionerPrivate::xdg_positioner_set_gravity(Resource *resource, uint32
 
     switch (gravity) {
     case gravity_top:
-        data->gravityEdges = Qt::TopEdge;
+        editData()->gravityEdges = Qt::TopEdge;
         break;
     case gravity_top_right:
-        data->gravityEdges = Qt::TopEdge | Qt::RightEdge;
+        editData()->gravityEdges = Qt::TopEdge | Qt::RightEdge;
         break;
     case gravity_right:
-        data->gravityEdges = Qt::RightEdge;
+        editData()->gravityEdges = Qt::RightEdge;
         break;
     case gravity_bottom_right:
-        data->gravityEdges = Qt::BottomEdge | Qt::RightEdge;
+        editData()->gravityEdges = Qt::BottomEdge | Qt::RightEdge;
         break;
     case gravity_bottom:
-        data->gravityEdges = Qt::BottomEdge;
+        editData()->gravityEdges = Qt::BottomEdge;
         break;
     case gravity_bottom_left:
-        data->gravityEdges = Qt::BottomEdge | Qt::LeftEdge;
+        editData()->gravityEdges = Qt::BottomEdge | Qt::LeftEdge;
         break;
     case gravity_left:
-        data->gravityEdges = Qt::LeftEdge;
+        editData()->gravityEdges = Qt::LeftEdge;
         break;
     case gravity_top_left:
-        data->gravityEdges = Qt::TopEdge | Qt::LeftEdge;
+        editData()->gravityEdges = Qt::TopEdge | Qt::LeftEdge;
         break;
     default:
-        data->gravityEdges = Qt::Edges();
+        editData()->gravityEdges = Qt::Edges();
         break;
     }
 }
@@ -928,46 +1069,46 @@ void XdgPositionerPrivate::xdg_positioner_set_constraint_adjustment(Resource *re
     Q_UNUSED(resource)
 
     if (constraint_adjustment & constraint_adjustment_flip_x) {
-        data->flipConstraintAdjustments |= Qt::Horizontal;
+        editData()->flipConstraintAdjustments |= Qt::Horizontal;
     } else {
-        data->flipConstraintAdjustments &= ~Qt::Horizontal;
+        editData()->flipConstraintAdjustments &= ~Qt::Horizontal;
     }
 
     if (constraint_adjustment & constraint_adjustment_flip_y) {
-        data->flipConstraintAdjustments |= Qt::Vertical;
+        editData()->flipConstraintAdjustments |= Qt::Vertical;
     } else {
-        data->flipConstraintAdjustments &= ~Qt::Vertical;
+        editData()->flipConstraintAdjustments &= ~Qt::Vertical;
     }
 
     if (constraint_adjustment & constraint_adjustment_slide_x) {
-        data->slideConstraintAdjustments |= Qt::Horizontal;
+        editData()->slideConstraintAdjustments |= Qt::Horizontal;
     } else {
-        data->slideConstraintAdjustments &= ~Qt::Horizontal;
+        editData()->slideConstraintAdjustments &= ~Qt::Horizontal;
     }
 
     if (constraint_adjustment & constraint_adjustment_slide_y) {
-        data->slideConstraintAdjustments |= Qt::Vertical;
+        editData()->slideConstraintAdjustments |= Qt::Vertical;
     } else {
-        data->slideConstraintAdjustments &= ~Qt::Vertical;
+        editData()->slideConstraintAdjustments &= ~Qt::Vertical;
     }
 
     if (constraint_adjustment & constraint_adjustment_resize_x) {
-        data->resizeConstraintAdjustments |= Qt::Horizontal;
+        editData()->resizeConstraintAdjustments |= Qt::Horizontal;
     } else {
-        data->resizeConstraintAdjustments &= ~Qt::Horizontal;
+        editData()->resizeConstraintAdjustments &= ~Qt::Horizontal;
     }
 
     if (constraint_adjustment & constraint_adjustment_resize_y) {
-        data->resizeConstraintAdjustments |= Qt::Vertical;
+        editData()->resizeConstraintAdjustments |= Qt::Vertical;
     } else {
-        data->resizeConstraintAdjustments &= ~Qt::Vertical;
+        editData()->resizeConstraintAdjustments &= ~Qt::Vertical;
     }
 }
 
 void XdgPositionerPrivate::xdg_positioner_set_offset(Resource *resource, int32_t x, int32_t y)
 {
     Q_UNUSED(resource)
-    data->offset = QPoint(x, y);
+    editData()->offset = QPoint(x, y);
 }
 
 XdgPositioner::XdgPositioner()
@@ -1050,6 +1191,151 @@ quint32 XdgPositioner::parentConfigure() const
     return d->parentConfigure;
 }
 
+static QPoint popupPosition(const QRect &anchorRect, Qt::Edges anchorEdges, Qt::Edges gravityEdges, const QSize &size)
+{
+    QPoint anchorPoint;
+    switch (anchorEdges & (Qt::LeftEdge | Qt::RightEdge)) {
+    case Qt::LeftEdge:
+        anchorPoint.setX(anchorRect.x());
+        break;
+    case Qt::RightEdge:
+        anchorPoint.setX(anchorRect.x() + anchorRect.width());
+        break;
+    default:
+        anchorPoint.setX(qRound(anchorRect.x() + anchorRect.width() / 2.0));
+        break;
+    }
+    switch (anchorEdges & (Qt::TopEdge | Qt::BottomEdge)) {
+    case Qt::TopEdge:
+        anchorPoint.setY(anchorRect.y());
+        break;
+    case Qt::BottomEdge:
+        anchorPoint.setY(anchorRect.y() + anchorRect.height());
+        break;
+    default:
+        anchorPoint.setY(qRound(anchorRect.y() + anchorRect.height() / 2.0));
+        break;
+    }
+
+    // the gravity is the direction the popup extends to from the anchor point
+    QPoint adjustment;
+    switch (gravityEdges & (Qt::LeftEdge | Qt::RightEdge)) {
+    case Qt::LeftEdge:
+        adjustment.setX(-size.width());
+        break;
+    case Qt::RightEdge:
+        break;
+    default:
+        adjustment.setX(-qRound(size.width() / 2.0));
+        break;
+    }
+    switch (gravityEdges & (Qt::TopEdge | Qt::BottomEdge)) {
+    case Qt::TopEdge:
+        adjustment.setY(-size.height());
+        break;
+    case Qt::BottomEdge:
+        break;
+    default:
+        adjustment.setY(-qRound(size.height() / 2.0));
+        break;
+    }
+    return anchorPoint + adjustment;
+}
+
+static Qt::Edges flippedEdges(Qt::Edges edges, Qt::Orientation orientation)
+{
+    const Qt::Edges first = orientation == Qt::Horizontal ? Qt::LeftEdge : Qt::TopEdge;
+    const Qt::Edges second = orientation == Qt::Horizontal ? Qt::RightEdge : Qt::BottomEdge;
+    Qt::Edges flipped = edges & ~(first | second);
+    if (edges & first) {
+        flipped |= second;
+    }
+    if (edges & second) {
+        flipped |= first;
+    }
+    return flipped;
+}
+
+static bool isInside(const QRect &geometry, const QRect &bounds, Qt::Orientation orientation)
+{
+    if (orientation == Qt::Horizontal) {
+        return geometry.left() >= bounds.left() && geometry.right() <= bounds.right();
+    }
+    return geometry.top() >= bounds.top() && geometry.bottom() <= bounds.bottom();
+}
+
+QRect XdgPositioner::placement(const QRect &parentGeometry, const QRect &bounds) const
+{
+    if (d->placementCached && d->cachedParentGeometry == parentGeometry && d->cachedBounds == bounds) {
+        return d->cachedPlacement;
+    }
+
+    const QPoint origin = parentGeometry.topLeft() + d->offset;
+    QRect geometry(origin + popupPosition(d->anchorRect, d->anchorEdges, d->gravityEdges, d->size), d->size);
+
+    for (Qt::Orientation orientation : {Qt::Horizontal, Qt::Vertical}) {
+        if (isInside(geometry, bounds, orientation)) {
+            continue;
+        }
+        const bool horizontal = orientation == Qt::Horizontal;
+        if (d->flipConstraintAdjustments & orientation) {
+            const Qt::Edges anchorEdges = flippedEdges(d->anchorEdges, orientation);
+            const Qt::Edges gravityEdges = flippedEdges(d->gravityEdges, orientation);
+            const QRect flipped(origin + popupPosition(d->anchorRect, anchorEdges, gravityEdges, d->size), d->size);
+            if (isInside(flipped, bounds, orientation)) {
+                if (horizontal) {
+                    geometry.moveLeft(flipped.left());
+                } else {
+                    geometry.moveTop(flipped.top());
+                }
+                continue;
+            }
+        }
+        if (d->slideConstraintAdjustments & orientation) {
+            // if the popup is larger than the bounds, its top left corner stays visible
+            if (horizontal) {
+                if (geometry.right() > bounds.right()) {
+                    geometry.moveRight(bounds.right());
+                }
+                if (geometry.left() < bounds.left()) {
+                    geometry.moveLeft(bounds.left());
+                }
+            } else {
+                if (geometry.bottom() > bounds.bottom()) {
+                    geometry.moveBottom(bounds.bottom());
+                }
+                if (geometry.top() < bounds.top()) {
+                    geometry.moveTop(bounds.top());
+                }
+            }
+        }
+        if (d->resizeConstraintAdjustments & orientation) {
+            // a popup entirely outside of the bounds can't be resized to fit
+            if (horizontal) {
+                const int left = std::max(geometry.left(), bounds.left());
+                const int right = std::min(geometry.right(), bounds.right());
+                if (left <= right) {
+                    geometry.setLeft(left);
+                    geometry.setRight(right);
+                }
+            } else {
+                const int top = std::max(geometry.top(), bounds.top());
+                const int bottom = std::min(geometry.bottom(), bounds.bottom());
+                if (top <= bottom) {
+                    geometry.setTop(top);
+                    geometry.setBottom(bottom);
+                }
+            }
+        }
+    }
+
+    d->cachedParentGeometry = parentGeometry;
+    d->cachedBounds = bounds;
+    d->cachedPlacement = geometry;
+    d->placementCached = true;
+    return geometry;
+}
+
 XdgPositioner XdgPositioner::get(::wl_resource *resource)
 {
     XdgPositionerPrivate *xdgPositionerPrivate = XdgPositionerPrivate::get(resource);
@@ -8,6 +8,7 @@
 
 #include <KWaylandServer/kwaylandserver_export.h>
 
+#include <QHash>
 #include <QObject>
 #include <QSharedDataPointer>
 
@@ -16,6 +17,7 @@ struct wl_resource;
 namespace KWaylandServer
 {
 
+class ClientConnection;
 class Display;
 class OutputInterface;
 class SeatInterface;
@@ -66,6 +68,14 @@ public:
      */
     quint32 ping(XdgSurfaceInterface *surface);
 
+    /**
+     * Sends a ping event to every client which has an xdg-surface, like ping() does for each
+     * of them. Returns the serials of the pings by client.
+     *
+     * \since 5.22
+     */
+    QHash<ClientConnection *, quint32> pingAll();
+
 Q_SIGNALS:
     /**
      * This signal is emitted when a new XdgToplevelInterface object is created.
@@ -272,9 +282,33 @@ public:
     /**
      * Sends a configure event to the client. \a size specifies the new window geometry size. A size
      * of zero means the client should decide its own window dimensions.
+     *
+     * If configure coalescing is enabled and the client hasn't acknowledged the previous configure
+     * event yet, the configure event is deferred and 0 is returned. A deferred configure event
+     * replaces the previously deferred one and is sent once the client acknowledges the one in
+     * flight, configureSent() provides its serial then.
+     *
+     * \see setConfigureCoalescingEnabled
      */
     quint32 sendConfigure(const QSize &size, const States &states);
 
+    /**
+     * Returns \c true if at most one configure event is sent to the client at a time; otherwise
+     * returns \c false. Coalescing is disabled by default.
+     *
+     * \since 5.22
+     */
+    bool isConfigureCoalescingEnabled() const;
+
+    /**
+     * Sets whether configure events are coalesced while the client hasn't acknowledged the last
+     * one, e.g. during an interactive resize. A slow client then only gets the latest size rather
+     * than every intermediate one. Disabling coalescing sends the deferred configure event, if any.
+     *
+     * \since 5.22
+     */
+    void setConfigureCoalescingEnabled(bool enabled);
+
     /**
      * Sends a close event to the client. The client may choose to ignore this request.
      */
@@ -326,6 +360,8 @@ Q_SIGNALS:
     /**
      * This signal is emitted when the toplevel wants to be interactively moved. The \a seat and
      * the \a serial indicate the user action in response to which this request has been issued.
+     *
+     * \see SeatInterface::hasImplicitGrab()
      */
     void moveRequested(KWaylandServer::SeatInterface *seat, quint32 serial);
 
@@ -333,6 +369,8 @@ Q_SIGNALS:
      * This signal is emitted when the toplevel wants to be interactively resized along the
      * specified window edges \a edges. The \a seat and the \a serial indicate the user action
      * in response to which this request has been issued.
+     *
+     * \see SeatInterface::hasImplicitGrab()
      */
     void resizeRequested(KWaylandServer::SeatInterface *seat, Qt::Edges edges, quint32 serial);
 
@@ -366,6 +404,14 @@ Q_SIGNALS:
      */
     void parentXdgToplevelChanged();
 
+    /**
+     * This signal is emitted when a configure event with the given \a serial, \a size and
+     * \a states has been sent to the client, including deferred ones.
+     *
+     * \since 5.22
+     */
+    void configureSent(quint32 serial, const QSize &size, KWaylandServer::XdgToplevelInterface::States states);
+
 private:
     QScopedPointer<XdgToplevelInterfacePrivate> d;
     friend class XdgToplevelInterfacePrivate;
@@ -468,6 +514,23 @@ public:
      */
     quint32 parentConfigure() const;
 
+    /**
+     * Returns the window geometry of the popup placed according to this positioner.
+     *
+     * \a parentGeometry is the window geometry of the parent surface and \a bounds is the area
+     * the popup has to stay inside of, e.g. the work area of the output, both in the same
+     * coordinate system as the returned geometry. The popup is placed at the anchor point with
+     * the gravity and the offset; if it's not inside \a bounds, it's flipped, slid and resized
+     * along the permitted orientations, in that order, as described by xdg_positioner.
+     *
+     * The last placement is cached with the state of the positioner, which copies of this
+     * XdgPositioner share, so placing a popup again for unchanged geometries, e.g. on every
+     * repaint or for a reactive popup whose parent didn't move, costs a comparison.
+     *
+     * \since 5.22
+     */
+    QRect placement(const QRect &parentGeometry, const QRect &bounds) const;
+
     /**
      * Returns the current state of the xdg positioner object identified by \a resource.
      */
@@ -552,6 +615,12 @@ Q_SIGNALS:
      * be configured. After initializing the popup, you must send a configure event.
      */
     void initializeRequested();
+    /**
+     * This signal is emitted when the xdg-popup wants an explicit grab of the \a seat. The
+     * \a serial belongs to the user action in response to which the grab has been requested.
+     *
+     * \see SeatInterface::isInputSerial()
+     */
     void grabRequested(SeatInterface *seat, quint32 serial);
     void repositionRequested(quint32 token);
 
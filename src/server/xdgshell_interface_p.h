@@ -9,9 +9,14 @@
 #include "xdgshell_interface.h"
 #include "qwayland-server-xdg-shell.h"
 
+#include "eventlooptimer_p.h"
 #include "surface_interface.h"
 #include "surfacerole_p.h"
 
+#include <QElapsedTimer>
+#include <QQueue>
+#include <QSet>
+
 namespace KWaylandServer
 {
 
@@ -20,20 +25,36 @@ class XdgToplevelDecorationV1Interface;
 class XdgShellInterfacePrivate : public QtWaylandServer::xdg_wm_base
 {
 public:
-    XdgShellInterfacePrivate(XdgShellInterface *shell);
+    XdgShellInterfacePrivate(XdgShellInterface *shell, Display *display);
 
     Resource *resourceForXdgSurface(XdgSurfaceInterface *surface) const;
 
     void registerXdgSurface(XdgSurfaceInterface *surface);
     void unregisterXdgSurface(XdgSurfaceInterface *surface);
 
+    quint32 sendPing(Resource *resource);
+    QHash<ClientConnection *, quint32> pingAll();
     void registerPing(quint32 serial);
+    void schedulePingTimer();
+    void processPings();
 
     static XdgShellInterfacePrivate *get(XdgShellInterface *shell);
 
     XdgShellInterface *q;
     Display *display;
-    QMap<quint32, QTimer *> pings;
+
+    struct PendingPing {
+        quint32 serial;
+        qint64 sent;
+    };
+    // Every ping waits for the same interval, so both queues are sorted by their deadline and
+    // only the oldest ping of each has to be checked. Answered pings are removed from pings and
+    // skipped when they reach the front of a queue.
+    QSet<quint32> pings;
+    QQueue<PendingPing> pingQueue;
+    QQueue<PendingPing> delayedPingQueue;
+    QElapsedTimer pingClock;
+    EventLoopTimer pingTimer;
 
 protected:
     void xdg_wm_base_destroy(Resource *resource) override;
@@ -59,6 +80,12 @@ public:
     bool isReactive;
     QSize parentSize;
     quint32 parentConfigure;
+
+    // the last result of XdgPositioner::placement()
+    mutable QRect cachedParentGeometry;
+    mutable QRect cachedBounds;
+    mutable QRect cachedPlacement;
+    mutable bool placementCached = false;
 };
 
 class XdgPositionerPrivate : public QtWaylandServer::xdg_positioner
@@ -69,6 +96,10 @@ public:
     QSharedDataPointer<XdgPositionerData> data;
 
     static XdgPositionerPrivate *get(::wl_resource *resource);
+    /**
+     * Returns the detached state for a request to modify, without the cached placement.
+     */
+    XdgPositionerData *editData();
 
 protected:
     void xdg_positioner_destroy_resource(Resource *resource) override;
@@ -127,6 +158,14 @@ public:
     void commit() override;
     void reset();
 
+    quint32 sendConfigure(const QSize &size, const XdgToplevelInterface::States &states);
+    /**
+     * Returns the states array of the configure event for @p states, it's only rebuilt when
+     * the states differ from the last configure.
+     */
+    const QByteArray &encodedStates(const XdgToplevelInterface::States &states);
+    void handleConfigureAcknowledged(quint32 serial);
+
     static XdgToplevelInterfacePrivate *get(XdgToplevelInterface *toplevel);
     static XdgToplevelInterfacePrivate *get(::wl_resource *resource);
 
@@ -137,6 +176,19 @@ public:
 
     QString windowTitle;
     QString windowClass;
+    QByteArray rawWindowTitle;
+    QByteArray rawWindowClass;
+
+    bool configureCoalescing = false;
+    // the serial of the configure the client hasn't acknowledged yet, if coalescing
+    quint32 inFlightConfigure = 0;
+    bool hasDeferredConfigure = false;
+    QSize deferredSize;
+    XdgToplevelInterface::States deferredStates;
+    // the states of the last configure, which most configures of e.g. a resize repeat
+    XdgToplevelInterface::States lastStates;
+    QByteArray lastEncodedStates;
+    bool hasEncodedStates = false;
 
     struct State
     {
@@ -151,8 +203,8 @@ protected:
     void xdg_toplevel_destroy_resource(Resource *resource) override;
     void xdg_toplevel_destroy(Resource *resource) override;
     void xdg_toplevel_set_parent(Resource *resource, ::wl_resource *parent) override;
-    void xdg_toplevel_set_title(Resource *resource, const QString &title) override;
-    void xdg_toplevel_set_app_id(Resource *resource, const QString &app_id) override;
+    void xdg_toplevel_set_title(Resource *resource, const char *title) override;
+    void xdg_toplevel_set_app_id(Resource *resource, const char *app_id) override;
     void xdg_toplevel_show_window_menu(Resource *resource, ::wl_resource *seat, uint32_t serial, int32_t x, int32_t y) override;
     void xdg_toplevel_move(Resource *resource, ::wl_resource *seat, uint32_t serial) override;
     void xdg_toplevel_resize(Resource *resource, ::wl_resource *seat, uint32_t serial, uint32_t edges) override;
@@ -80,6 +80,11 @@ private:
         QByteArray name;
         QByteArray type;
         std::vector<WaylandArgument> arguments;
+        // pass string arguments of the request handler as const char * instead of QString
+        bool rawStrings;
+        int since;
+        // take string arguments of the event as UTF-8 encoded QByteArray instead of QString
+        bool encodedStrings;
     };
 
     struct WaylandInterface {
@@ -93,6 +98,7 @@ private:
 
     bool isServerSide();
     bool parseOption(const QByteArray &str);
+    bool hasRawStrings(const QByteArray &interface, const QByteArray &request) const;
 
     QByteArray byteArrayValue(const QXmlStreamReader &xml, const char *name);
     int intValue(const QXmlStreamReader &xml, const char *name, int defaultValue = 0);
@@ -103,6 +109,10 @@ private:
     QByteArray waylandToCType(const QByteArray &waylandType, const QByteArray &interface);
     QByteArray waylandToQtType(const QByteArray &waylandType, const QByteArray &interface, bool cStyleArray);
     const Scanner::WaylandArgument *newIdArgument(const std::vector<WaylandArgument> &arguments);
+    bool isBroadcastable(const WaylandEvent &e);
+    bool hasStringArguments(const WaylandEvent &e);
+    WaylandEvent ifSupported(const WaylandEvent &e);
+    WaylandEvent preEncoded(const WaylandEvent &e);
 
     void printEvent(const WaylandEvent &e, bool omitNames = false, bool withResource = false);
     void printEventHandlerSignature(const WaylandEvent &e, const char *interfaceName, bool deepIndent = true);
@@ -124,6 +134,9 @@ private:
     QByteArray m_headerPath;
     QByteArray m_prefix;
     QVector <QByteArray> m_includes;
+    QVector <QByteArray> m_rawStrings;
+    QVector <QByteArray> m_pooledResources;
+    bool m_traceHooks = false;
     QXmlStreamReader *m_xml = nullptr;
 };
 
@@ -141,16 +154,22 @@ bool Scanner::parseArguments(int argc, char **argv)
 
     m_protocolFilePath = args[2];
 
+    int pos = 3;
     if (argc > 3 && !args[3].startsWith('-')) {
-        // legacy positional arguments
+        // legacy positional arguments, optionally followed by options
             m_headerPath = args[3];
-        if (argc == 5)
+        if (argc >= 5)
             m_prefix = args[4];
-    } else {
+        pos = 5;
+    }
+    {
         // --header-path=<path> (14 characters)
         // --prefix=<prefix> (9 characters)
         // --add-include=<include> (14 characters)
-        for (int pos = 3; pos < argc; pos++) {
+        // --raw-strings=<interface[.request],...> (14 characters)
+        // --pooled-resources=<interface,...> (19 characters), provide the ResourcePool with --add-include
+        // --trace-hooks
+        for (; pos < argc; pos++) {
             const QByteArray &option = args[pos];
             if (option.startsWith("--header-path=")) {
                 m_headerPath = option.mid(14);
@@ -160,6 +179,20 @@ bool Scanner::parseArguments(int argc, char **argv)
                 auto include = option.mid(14);
                 if (!include.isEmpty())
                     m_includes << include;
+            } else if (option == "--trace-hooks") {
+                m_traceHooks = true;
+            } else if (option.startsWith("--pooled-resources=")) {
+                const QList<QByteArray> entries = option.mid(19).split(',');
+                for (const QByteArray &entry : entries) {
+                    if (!entry.isEmpty())
+                        m_pooledResources << entry;
+                }
+            } else if (option.startsWith("--raw-strings=")) {
+                const QList<QByteArray> entries = option.mid(14).split(',');
+                for (const QByteArray &entry : entries) {
+                    if (!entry.isEmpty())
+                        m_rawStrings << entry;
+                }
             } else {
                 return false;
             }
@@ -171,7 +204,7 @@ bool Scanner::parseArguments(int argc, char **argv)
 
 void Scanner::printUsage()
 {
-    fprintf(stderr, "Usage: %s [client-header|server-header|client-code|server-code] specfile [--header-path=<path>] [--prefix=<prefix>] [--add-include=<include>]\n", m_scannerName.constData());
+    fprintf(stderr, "Usage: %s [client-header|server-header|client-code|server-code] specfile [--header-path=<path>] [--prefix=<prefix>] [--add-include=<include>] [--raw-strings=<interface[.request],...>] [--pooled-resources=<interface,...>] [--trace-hooks]\n", m_scannerName.constData());
 }
 
 bool Scanner::isServerSide()
@@ -195,6 +228,11 @@ bool Scanner::parseOption(const QByteArray &str)
     return true;
 }
 
+bool Scanner::hasRawStrings(const QByteArray &interface, const QByteArray &request) const
+{
+    return m_rawStrings.contains(interface) || m_rawStrings.contains(interface + '.' + request);
+}
+
 QByteArray Scanner::byteArrayValue(const QXmlStreamReader &xml, const char *name)
 {
     if (xml.attributes().hasAttribute(name))
@@ -221,6 +259,9 @@ Scanner::WaylandEvent Scanner::readEvent(QXmlStreamReader &xml, bool request)
         .name = byteArrayValue(xml, "name"),
         .type = byteArrayValue(xml, "type"),
         .arguments = {},
+        .rawStrings = false,
+        .since = intValue(xml, "since", 1),
+        .encodedStrings = false,
     };
     while (xml.readNextStartElement()) {
         if (xml.name() == "arg") {
@@ -275,8 +316,11 @@ Scanner::WaylandInterface Scanner::readInterface(QXmlStreamReader &xml)
     while (xml.readNextStartElement()) {
         if (xml.name() == "event")
             interface.events.push_back(readEvent(xml, false));
-        else if (xml.name() == "request")
-            interface.requests.push_back(readEvent(xml, true));
+        else if (xml.name() == "request") {
+            WaylandEvent request = readEvent(xml, true);
+            request.rawStrings = isServerSide() && hasRawStrings(interface.name, request.name);
+            interface.requests.push_back(std::move(request));
+        }
         else if (xml.name() == "enum")
             interface.enums.push_back(readEnum(xml));
         else
@@ -329,6 +373,39 @@ const Scanner::WaylandArgument *Scanner::newIdArgument(const std::vector<Wayland
     return nullptr;
 }
 
+bool Scanner::isBroadcastable(const WaylandEvent &e)
+{
+    // objects belong to a single client, they can't be sent to all resources
+    for (const WaylandArgument &a : e.arguments) {
+        if (a.type == "object" || a.type == "new_id")
+            return false;
+    }
+    return true;
+}
+
+bool Scanner::hasStringArguments(const WaylandEvent &e)
+{
+    for (const WaylandArgument &a : e.arguments) {
+        if (a.type == "string")
+            return true;
+    }
+    return false;
+}
+
+Scanner::WaylandEvent Scanner::preEncoded(const WaylandEvent &e)
+{
+    WaylandEvent event = e;
+    event.encodedStrings = true;
+    return event;
+}
+
+Scanner::WaylandEvent Scanner::ifSupported(const WaylandEvent &e)
+{
+    WaylandEvent event = e;
+    event.name += "_if_supported";
+    return event;
+}
+
 void Scanner::printEvent(const WaylandEvent &e, bool omitNames, bool withResource)
 {
     printf("%s(", e.name.constData());
@@ -365,7 +442,10 @@ void Scanner::printEvent(const WaylandEvent &e, bool omitNames, bool withResourc
             }
         }
 
-        QByteArray qtType = waylandToQtType(a.type, a.interface, e.request == isServerSide());
+        QByteArray qtType = e.rawStrings && a.type == "string" ? waylandToCType(a.type, a.interface)
+                                                              : waylandToQtType(a.type, a.interface, e.request == isServerSide());
+        if (e.encodedStrings && a.type == "string")
+            qtType = "const QByteArray &";
         printf("%s%s%s", qtType.constData(), qtType.endsWith("&") || qtType.endsWith("*") ? "" : " ", omitNames ? "" : a.name.constData());
     }
     printf(")");
@@ -486,6 +566,7 @@ bool Scanner::process()
         printf("#include <QByteArray>\n");
         printf("#include <QMultiMap>\n");
         printf("#include <QString>\n");
+        printf("#include <QVector>\n");
 
         printf("\n");
         printf("#ifndef WAYLAND_VERSION_CHECK\n");
@@ -495,6 +576,17 @@ bool Scanner::process()
         printf("    (WAYLAND_VERSION_MAJOR == (major) && WAYLAND_VERSION_MINOR == (minor) && WAYLAND_VERSION_MICRO >= (micro)))\n");
         printf("#endif\n");
 
+        if (m_traceHooks) {
+            printf("\n");
+            printf("// a scope object for the request handler, provide the macros with --add-include\n");
+            printf("#ifndef QTWAYLANDSERVER_TRACE_REQUEST\n");
+            printf("#define QTWAYLANDSERVER_TRACE_REQUEST(interface, request)\n");
+            printf("#endif\n");
+            printf("#ifndef QTWAYLANDSERVER_TRACE_EVENT\n");
+            printf("#define QTWAYLANDSERVER_TRACE_EVENT(interface, event)\n");
+            printf("#endif\n");
+        }
+
         printf("\n");
         printf("QT_BEGIN_NAMESPACE\n");
         printf("QT_WARNING_PUSH\n");
@@ -524,6 +616,7 @@ bool Scanner::process()
             if (needsNewLine)
                 printf("\n");
             needsNewLine = true;
+            const bool pooledResources = m_pooledResources.contains(interface.name);
 
             const char *interfaceName = interface.name.constData();
 
@@ -553,7 +646,18 @@ bool Scanner::process()
             printf("            int version() const { return wl_resource_get_version(handle); }\n");
             printf("\n");
             printf("            static Resource *fromResource(struct ::wl_resource *resource);\n");
+            if (pooledResources) {
+                printf("\n");
+                printf("            static void *operator new(std::size_t size) { return %s::resourceAllocator()->allocate(size); }\n", interfaceName);
+                printf("            static void operator delete(void *pointer, std::size_t size) { %s::resourceAllocator()->deallocate(pointer, size); }\n", interfaceName);
+            }
             printf("        };\n");
+            if (pooledResources) {
+                printf("\n");
+                printf("        // the allocator can only be replaced while there are no resources of this interface\n");
+                printf("        static ResourceAllocator *resourceAllocator();\n");
+                printf("        static void setResourceAllocator(ResourceAllocator *allocator);\n");
+            }
             printf("\n");
             printf("        void init(struct ::wl_client *client, int id, int version);\n");
             printf("        void init(struct ::wl_display *display, int version);\n");
@@ -568,6 +672,24 @@ bool Scanner::process()
             printf("\n");
             printf("        QMultiMap<struct ::wl_client*, Resource*> resourceMap() { return m_resource_map; }\n");
             printf("        const QMultiMap<struct ::wl_client*, Resource*> resourceMap() const { return m_resource_map; }\n");
+            printf("        const QMultiMap<struct ::wl_client*, Resource*> &constResourceMap() const { return m_resource_map; }\n");
+            printf("\n");
+            printf("        const QVector<Resource*> &resources() const { return m_resources; }\n");
+            printf("        QVector<Resource*> resourcesForClient(struct ::wl_client *client) const;\n");
+            printf("        template <typename Function>\n");
+            printf("        void forEachResource(Function function) const\n");
+            printf("        {\n");
+            printf("            const QVector<Resource*> resources = m_resources;\n");
+            printf("            for (Resource *resource : resources)\n");
+            printf("                function(resource);\n");
+            printf("        }\n");
+            printf("        template <typename Function>\n");
+            printf("        void forEachResource(struct ::wl_client *client, Function function) const\n");
+            printf("        {\n");
+            printf("            const QVector<Resource*> resources = resourcesForClient(client);\n");
+            printf("            for (Resource *resource : resources)\n");
+            printf("                function(resource);\n");
+            printf("        }\n");
             printf("\n");
             printf("        bool isGlobal() const { return m_global != nullptr; }\n");
             printf("        bool isResource() const { return m_resource != nullptr; }\n");
@@ -575,6 +697,13 @@ bool Scanner::process()
             printf("        static const struct ::wl_interface *interface();\n");
             printf("        static QByteArray interfaceName() { return interface()->name; }\n");
             printf("        static int interfaceVersion() { return interface()->version; }\n");
+            printf("        static constexpr const char *staticInterfaceName() { return \"%s\"; }\n", interfaceName);
+            printf("        static constexpr int staticInterfaceVersion() { return %d; }\n", interface.version);
+            if (!interface.events.empty()) {
+                printf("\n");
+                for (const WaylandEvent &e : interface.events)
+                    printf("        static constexpr int %s_since_version = %d;\n", e.name.constData(), e.since);
+            }
             printf("\n");
 
             printEnums(interface.enums);
@@ -590,6 +719,26 @@ bool Scanner::process()
                     printf("        void send_");
                     printEvent(e, false, true);
                     printf(";\n");
+                    if (hasStringArguments(e)) {
+                        printf("        void send_");
+                        printEvent(preEncoded(e), false, true);
+                        printf(";\n");
+                    }
+                    if (e.since > 1) {
+                        printf("        bool send_");
+                        printEvent(ifSupported(e), false, true);
+                        printf(";\n");
+                    }
+                    if (isBroadcastable(e)) {
+                        printf("        void broadcast_");
+                        printEvent(e);
+                        printf(";\n");
+                        if (hasStringArguments(e)) {
+                            printf("        void broadcast_");
+                            printEvent(preEncoded(e));
+                            printf(";\n");
+                        }
+                    }
                 }
             }
 
@@ -619,6 +768,8 @@ bool Scanner::process()
             printf("\n");
             printf("        Resource *bind(struct ::wl_client *client, uint32_t id, int version);\n");
             printf("        Resource *bind(struct ::wl_resource *handle);\n");
+            printf("        void insertResource(Resource *resource);\n");
+            printf("        void removeResource(Resource *resource);\n");
 
             if (hasRequests) {
                 printf("\n");
@@ -635,6 +786,7 @@ bool Scanner::process()
 
             printf("\n");
             printf("        QMultiMap<struct ::wl_client*, Resource*> m_resource_map;\n");
+            printf("        QVector<Resource*> m_resources; // sorted by client, in bind order per client\n");
             printf("        Resource *m_resource;\n");
             printf("        struct ::wl_global *m_global;\n");
             printf("        uint32_t m_globalVersion;\n");
@@ -659,11 +811,30 @@ bool Scanner::process()
         else
             printf("#include <%s/qwayland-server-%s.h>\n", m_headerPath.constData(), QByteArray(m_protocolName).replace('_', '-').constData());
         printf("\n");
+        printf("#include <algorithm>\n");
+        printf("#include <functional>\n");
+        printf("\n");
         printf("QT_BEGIN_NAMESPACE\n");
         printf("QT_WARNING_PUSH\n");
         printf("QT_WARNING_DISABLE_GCC(\"-Wmissing-field-initializers\")\n");
         printf("\n");
         printf("namespace QtWaylandServer {\n");
+        printf("\n");
+        printf("namespace {\n");
+        printf("    template <typename Resource>\n");
+        printf("    struct ResourceClientLess\n");
+        printf("    {\n");
+        printf("        bool operator()(Resource *resource, struct ::wl_client *client) const\n");
+        printf("        {\n");
+        printf("            return std::less<struct ::wl_client *>()(resource->client(), client);\n");
+        printf("        }\n");
+        printf("        bool operator()(struct ::wl_client *client, Resource *resource) const\n");
+        printf("        {\n");
+        printf("            return std::less<struct ::wl_client *>()(client, resource->client());\n");
+        printf("        }\n");
+        printf("    };\n");
+        printf("}\n");
+        printf("\n");
 
         bool needsNewLine = false;
         for (const WaylandInterface &interface : interfaces) {
@@ -681,6 +852,25 @@ bool Scanner::process()
             QByteArray stripped = stripInterfaceName(interface.name);
             const char *interfaceNameStripped = stripped.constData();
 
+            if (m_pooledResources.contains(interface.name)) {
+                printf("    static ResourceAllocator *s_%s_resourceAllocator = nullptr;\n", interfaceName);
+                printf("\n");
+                printf("    ResourceAllocator *%s::resourceAllocator()\n", interfaceName);
+                printf("    {\n");
+                printf("        if (Q_UNLIKELY(!s_%s_resourceAllocator)) {\n", interfaceName);
+                printf("            // never destroyed, resources may outlive the static destructors\n");
+                printf("            s_%s_resourceAllocator = new ResourcePool;\n", interfaceName);
+                printf("        }\n");
+                printf("        return s_%s_resourceAllocator;\n", interfaceName);
+                printf("    }\n");
+                printf("\n");
+                printf("    void %s::setResourceAllocator(ResourceAllocator *allocator)\n", interfaceName);
+                printf("    {\n");
+                printf("        s_%s_resourceAllocator = allocator;\n", interfaceName);
+                printf("    }\n");
+                printf("\n");
+            }
+
             printf("    %s::%s(struct ::wl_client *client, int id, int version)\n", interfaceName, interfaceName);
             printf("        : m_resource_map()\n");
             printf("        , m_resource(nullptr)\n");
@@ -747,6 +937,7 @@ bool Scanner::process()
             printf("    {\n");
             printf("        Resource *resource = bind(client, 0, version);\n");
             printf("        m_resource_map.insert(client, resource);\n");
+            printf("        insertResource(resource);\n");
             printf("        return resource;\n");
             printf("    }\n");
             printf("\n");
@@ -755,10 +946,32 @@ bool Scanner::process()
             printf("    {\n");
             printf("        Resource *resource = bind(client, id, version);\n");
             printf("        m_resource_map.insert(client, resource);\n");
+            printf("        insertResource(resource);\n");
             printf("        return resource;\n");
             printf("    }\n");
             printf("\n");
 
+            printf("    void %s::insertResource(Resource *resource)\n", interfaceName);
+            printf("    {\n");
+            printf("        struct ::wl_client *client = resource->client();\n");
+            printf("        auto it = std::upper_bound(m_resources.begin(), m_resources.end(), client, ResourceClientLess<Resource>());\n");
+            printf("        m_resources.insert(it, resource);\n");
+            printf("    }\n");
+            printf("\n");
+
+            printf("    void %s::removeResource(Resource *resource)\n", interfaceName);
+            printf("    {\n");
+            printf("        m_resources.removeOne(resource);\n");
+            printf("    }\n");
+            printf("\n");
+
+            printf("    QVector<%s::Resource *> %s::resourcesForClient(struct ::wl_client *client) const\n", interfaceName, interfaceName);
+            printf("    {\n");
+            printf("        const auto range = std::equal_range(m_resources.constBegin(), m_resources.constEnd(), client, ResourceClientLess<Resource>());\n");
+            printf("        return QVector<Resource *>(range.first, range.second);\n");
+            printf("    }\n");
+            printf("\n");
+
             printf("    void %s::init(struct ::wl_display *display, int version)\n", interfaceName);
             printf("    {\n");
             printf("        m_global = wl_global_create(display, &::%s_interface, version, this, bind_func);\n", interfaceName);
@@ -775,6 +988,12 @@ bool Scanner::process()
             printf("    }\n");
             printf("\n");
 
+            if (!interface.events.empty()) {
+                for (const WaylandEvent &e : interface.events)
+                    printf("    constexpr int %s::%s_since_version;\n", interfaceName, e.name.constData());
+                printf("\n");
+            }
+
             printf("    %s::Resource *%s::%s_allocate()\n", interfaceName, interfaceName, interfaceNameStripped);
             printf("    {\n");
             printf("        return new Resource;\n");
@@ -813,6 +1032,7 @@ bool Scanner::process()
             printf("        %s *that = resource->%s_object;\n", interfaceName, interfaceNameStripped);
             printf("        if (Q_LIKELY(that)) {\n");
             printf("            that->m_resource_map.remove(resource->client(), resource);\n");
+            printf("            that->removeResource(resource);\n");
             printf("            that->%s_destroy_resource(resource);\n", interfaceNameStripped);
             printf("\n");
             printf("            that = resource->%s_object;\n", interfaceNameStripped);
@@ -891,6 +1111,8 @@ bool Scanner::process()
                     printf("\n");
                     printf("    {\n");
                     printf("        Q_UNUSED(client);\n");
+                    if (m_traceHooks)
+                        printf("        QTWAYLANDSERVER_TRACE_REQUEST(\"%s\", \"%s\");\n", interfaceName, e.name.constData());
                     printf("        Resource *r = Resource::fromResource(resource);\n");
                     printf("        if (Q_UNLIKELY(!r->%s_object)) {\n", interfaceNameStripped);
                     if (e.type == "destructor")
@@ -902,7 +1124,7 @@ bool Scanner::process()
                     for (const WaylandArgument &a : e.arguments) {
                         printf(",\n");
                         QByteArray cType = waylandToCType(a.type, a.interface);
-                        QByteArray qtType = waylandToQtType(a.type, a.interface, e.request);
+                        QByteArray qtType = e.rawStrings && a.type == "string" ? cType : waylandToQtType(a.type, a.interface, e.request);
                         const char *argumentName = a.name.constData();
                         if (cType == qtType)
                             printf("            %s", argumentName);
@@ -935,10 +1157,33 @@ bool Scanner::process()
                 printf("    }\n");
                 printf("\n");
 
+                // the QString overloads encode once and forward to the pre-encoded ones
+                const bool stringArguments = hasStringArguments(e);
+                if (stringArguments) {
+                    printf("    void %s::send_", interfaceName);
+                    printEvent(e, false, true);
+                    printf("\n");
+                    printf("    {\n");
+                    printf("        send_%s(\n", e.name.constData());
+                    printf("            resource");
+                    for (const WaylandArgument &a : e.arguments) {
+                        printf(",\n");
+                        if (a.type == "string")
+                            printf("            %s.toUtf8()", a.name.constData());
+                        else
+                            printf("            %s", a.name.constData());
+                    }
+                    printf(");\n");
+                    printf("    }\n");
+                    printf("\n");
+                }
+
                 printf("    void %s::send_", interfaceName);
-                printEvent(e, false, true);
+                printEvent(stringArguments ? preEncoded(e) : e, false, true);
                 printf("\n");
                 printf("    {\n");
+                if (m_traceHooks)
+                    printf("        QTWAYLANDSERVER_TRACE_EVENT(\"%s\", \"%s\");\n", interfaceName, e.name.constData());
 
                 for (const WaylandArgument &a : e.arguments) {
                     if (a.type != "array")
@@ -961,7 +1206,7 @@ bool Scanner::process()
                     QByteArray cType = waylandToCType(a.type, a.interface);
                     QByteArray qtType = waylandToQtType(a.type, a.interface, e.request);
                     if (a.type == "string")
-                        printf("            %s.toUtf8().constData()", a.name.constData());
+                        printf("            %s.constData()", a.name.constData());
                     else if (a.type == "array")
                         printf("            &%s_data", a.name.constData());
                     else if (cType == qtType)
@@ -971,6 +1216,88 @@ bool Scanner::process()
                 printf(");\n");
                 printf("    }\n");
                 printf("\n");
+
+                if (e.since > 1) {
+                    printf("    bool %s::send_", interfaceName);
+                    printEvent(ifSupported(e), false, true);
+                    printf("\n");
+                    printf("    {\n");
+                    printf("        if (wl_resource_get_version(resource) < %s_since_version)\n", e.name.constData());
+                    printf("            return false;\n");
+                    printf("        send_%s(\n", e.name.constData());
+                    printf("            resource");
+                    for (const WaylandArgument &a : e.arguments) {
+                        printf(",\n");
+                        printf("            %s", a.name.constData());
+                    }
+                    printf(");\n");
+                    printf("        return true;\n");
+                    printf("    }\n");
+                    printf("\n");
+                }
+
+                if (!isBroadcastable(e))
+                    continue;
+
+                if (stringArguments) {
+                    printf("    void %s::broadcast_", interfaceName);
+                    printEvent(e);
+                    printf("\n");
+                    printf("    {\n");
+                    printf("        broadcast_%s(", e.name.constData());
+                    bool needsComma = false;
+                    for (const WaylandArgument &a : e.arguments) {
+                        if (needsComma)
+                            printf(",");
+                        needsComma = true;
+                        if (a.type == "string")
+                            printf("\n            %s.toUtf8()", a.name.constData());
+                        else
+                            printf("\n            %s", a.name.constData());
+                    }
+                    printf(");\n");
+                    printf("    }\n");
+                    printf("\n");
+                }
+
+                printf("    void %s::broadcast_", interfaceName);
+                printEvent(stringArguments ? preEncoded(e) : e);
+                printf("\n");
+                printf("    {\n");
+                if (m_traceHooks)
+                    printf("        QTWAYLANDSERVER_TRACE_EVENT(\"%s\", \"%s\");\n", interfaceName, e.name.constData());
+
+                // convert the arguments once for all resources
+                for (const WaylandArgument &a : e.arguments) {
+                    const char *variableName = a.name.constData();
+                    if (a.type == "array") {
+                        printf("        struct wl_array %s_data;\n", variableName);
+                        printf("        %s_data.size = %s.size();\n", variableName, variableName);
+                        printf("        %s_data.data = static_cast<void *>(const_cast<char *>(%s.constData()));\n", variableName, variableName);
+                        printf("        %s_data.alloc = 0;\n", variableName);
+                    }
+                }
+                printf("        const QVector<Resource *> resources = m_resources;\n");
+                printf("        for (Resource *resource : resources) {\n");
+                if (e.since > 1) {
+                    printf("            if (resource->version() < %s_since_version)\n", e.name.constData());
+                    printf("                continue;\n");
+                }
+                printf("            %s_send_%s(\n", interfaceName, e.name.constData());
+                printf("                resource->handle");
+                for (const WaylandArgument &a : e.arguments) {
+                    printf(",\n");
+                    if (a.type == "string")
+                        printf("                %s.constData()", a.name.constData());
+                    else if (a.type == "array")
+                        printf("                &%s_data", a.name.constData());
+                    else
+                        printf("                %s", a.name.constData());
+                }
+                printf(");\n");
+                printf("        }\n");
+                printf("    }\n");
+                printf("\n");
             }
         }
         printf("}\n");